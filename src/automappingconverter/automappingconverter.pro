@@ -34,11 +34,13 @@ INSTALLS += target
 
 
 SOURCES += main.cpp \
+    batchconverter.cpp \
     converterdatamodel.cpp \
     convertercontrol.cpp \
     converterwindow.cpp
 
 HEADERS  += \
+    batchconverter.h \
     converterdatamodel.h \
     convertercontrol.h \
     converterwindow.h
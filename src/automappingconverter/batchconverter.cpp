@@ -0,0 +1,222 @@
+/*
+ * batchconverter.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of the AutomappingConverter, which converts old rulemaps
+ * of Tiled to work with the latest version of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batchconverter.h"
+
+#include "convertercontrol.h"
+
+#include "map.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+namespace {
+
+enum Outcome {
+    Converted,
+    UpToDate,
+    UnknownVersion,
+    Failed
+};
+
+struct Result {
+    Result() : outcome(Failed) {}
+
+    Outcome outcome;
+    QString error;
+};
+
+/**
+ * Reads a rule map, converts it when it is in the old format and writes it
+ * back. The tilesets are shared with the other rule maps through the
+ * TilesetCache, and are only read by the conversion.
+ */
+class ConvertTask : public QRunnable
+{
+public:
+    ConvertTask(const ConverterControl &control,
+                const QString &fileName,
+                Result &result)
+        : mControl(control)
+        , mFileName(fileName)
+        , mResult(result)
+    {}
+
+    void run() override
+    {
+        Tiled::MapReader reader;
+        reader.setTilesetCacheEnabled(true);
+
+        QScopedPointer<Tiled::Map> map(reader.readMap(mFileName));
+        if (!map) {
+            mResult.error = reader.errorString();
+            return;
+        }
+
+        const QString version = mControl.automappingRuleMapVersion(map.data());
+        if (version == mControl.version2()) {
+            mResult.outcome = UpToDate;
+            return;
+        }
+        if (version != mControl.version1()) {
+            mResult.outcome = UnknownVersion;
+            return;
+        }
+
+        mControl.convertV1toV2(map.data(), mFileName);
+
+        Tiled::MapWriter writer;
+        if (!writer.writeMap(map.data(), mFileName)) {
+            mResult.error = writer.errorString();
+            return;
+        }
+
+        mResult.outcome = Converted;
+    }
+
+private:
+    const ConverterControl &mControl;
+    const QString mFileName;
+    Result &mResult;
+};
+
+} // anonymous namespace
+
+static void showHelp()
+{
+    // TODO: Make translatable
+    qWarning() <<
+            "Usage:\n"
+            "  automappingconverter [options] [files or directories...]\n"
+            "\n"
+            "Without arguments, the converter window is shown. Otherwise the given\n"
+            "rule maps are converted, searching directories recursively for tmx files.\n"
+            "\n"
+            "Options:\n"
+            "  -h --help          : Display this help\n"
+            "     --threads COUNT : The number of rule maps converted in parallel\n"
+            "                       (default: one per processor core)\n";
+}
+
+/**
+ * Appends the TMX files found at \a path to \a fileNames. Returns false when
+ * the path doesn't exist.
+ */
+static bool collectFiles(const QString &path, QStringList &fileNames)
+{
+    const QFileInfo fileInfo(path);
+    if (!fileInfo.exists())
+        return false;
+
+    if (!fileInfo.isDir()) {
+        fileNames.append(fileInfo.filePath());
+        return true;
+    }
+
+    QDirIterator it(path, QStringList(QLatin1String("*.tmx")),
+                    QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        fileNames.append(it.next());
+
+    return true;
+}
+
+int runBatchConversion(const QStringList &arguments)
+{
+    QStringList fileNames;
+    int threadCount = QThread::idealThreadCount();
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString &arg = arguments.at(i);
+        if (arg == QLatin1String("--help") || arg == QLatin1String("-h")) {
+            showHelp();
+            return 0;
+        } else if (arg == QLatin1String("--threads")) {
+            bool ok = false;
+            if (++i < arguments.size())
+                threadCount = arguments.at(i).toInt(&ok);
+            if (!ok || threadCount < 1) {
+                qWarning() << "The thread count needs to be a positive number.";
+                return 1;
+            }
+        } else if (!collectFiles(arg, fileNames)) {
+            qWarning() << qPrintable(QString(QLatin1String("%1: no such file or directory")).arg(arg));
+            return 1;
+        }
+    }
+
+    const ConverterControl control;
+    QVector<Result> results(fileNames.size());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(threadCount);
+
+    for (int i = 0; i < fileNames.size(); ++i)
+        threadPool.start(new ConvertTask(control, fileNames.at(i), results[i]));
+
+    threadPool.waitForDone();
+
+    int converted = 0;
+    int failed = 0;
+
+    for (int i = 0; i < fileNames.size(); ++i) {
+        const Result &result = results.at(i);
+
+        switch (result.outcome) {
+        case Converted:
+            qWarning() << qPrintable(QString(QLatin1String("%1: converted")).arg(fileNames.at(i)));
+            ++converted;
+            break;
+        case UpToDate:
+            break;
+        case UnknownVersion:
+            qWarning() << qPrintable(QString(QLatin1String("%1: skipped, not a rule map of a known version"))
+                                     .arg(fileNames.at(i)));
+            break;
+        case Failed:
+            qWarning() << qPrintable(QString(QLatin1String("%1: failed: %2"))
+                                     .arg(fileNames.at(i), result.error));
+            ++failed;
+            break;
+        }
+    }
+
+    qWarning() << qPrintable(QString(QLatin1String("Converted %1 of %2 rule maps in %3 ms, %4 failed"))
+                             .arg(converted)
+                             .arg(fileNames.size())
+                             .arg(timer.elapsed())
+                             .arg(failed));
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * batchconverter.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of the AutomappingConverter, which converts old rulemaps
+ * of Tiled to work with the latest version of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCHCONVERTER_H
+#define BATCHCONVERTER_H
+
+#include <QStringList>
+
+/**
+ * Converts the rule maps given on the command line, without showing the
+ * converter window. Directories are searched recursively for TMX files.
+ *
+ * Returns the exit code, which is 1 when any of the rule maps failed.
+ */
+int runBatchConversion(const QStringList &arguments);
+
+#endif // BATCHCONVERTER_H
@@ -40,11 +40,17 @@ ConverterControl::ConverterControl()
 QString ConverterControl::automappingRuleFileVersion(const QString &fileName)
 {
     Tiled::MapReader reader;
-    Tiled::Map *map = reader.readMap(fileName);
+    reader.setTilesetCacheEnabled(true);
+    QScopedPointer<Tiled::Map> map(reader.readMap(fileName));
 
     if (!map)
         return versionNotAMap();
 
+    return automappingRuleMapVersion(map.data());
+}
+
+QString ConverterControl::automappingRuleMapVersion(const Tiled::Map *map) const
+{
     // version 1 check
     bool hasonlyruleprefix = true;
     foreach (Tiled::Layer *layer, map->layers()) {
@@ -86,6 +92,7 @@ QString ConverterControl::automappingRuleFileVersion(const QString &fileName)
 void ConverterControl::convertV1toV2(const QString &fileName)
 {
     Tiled::MapReader reader;
+    reader.setTilesetCacheEnabled(true);
     QScopedPointer<Tiled::Map> map(reader.readMap(fileName));
 
     if (!map) {
@@ -94,6 +101,18 @@ void ConverterControl::convertV1toV2(const QString &fileName)
         return;
     }
 
+    convertV1toV2(map.data(), fileName);
+
+    Tiled::MapWriter writer;
+    writer.writeMap(map.data(), fileName);
+}
+
+/**
+ * Renames the layers of the given rule \a map, which was read from
+ * \a fileName, from their version 1 to their version 2 names.
+ */
+void ConverterControl::convertV1toV2(Tiled::Map *map, const QString &fileName) const
+{
     foreach (Tiled::Layer *layer, map->layers()) {
         if (layer->name().startsWith("ruleset", Qt::CaseInsensitive)) {
             layer->setName("Input_set");
@@ -109,7 +128,4 @@ void ConverterControl::convertV1toV2(const QString &fileName)
                           QString("unused layers found");
         }
     }
-
-    Tiled::MapWriter writer;
-    writer.writeMap(map.data(), fileName);
 }
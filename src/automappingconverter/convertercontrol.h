@@ -25,6 +25,10 @@
 #include <QString>
 #include <QObject>
 
+namespace Tiled {
+class Map;
+}
+
 class ConverterControl
 {
 public:
@@ -36,7 +40,10 @@ public:
     QString versionNotAMap() const { return QObject::tr("not a map"); }
 
     QString automappingRuleFileVersion(const QString &fileName);
+    QString automappingRuleMapVersion(const Tiled::Map *map) const;
+
     void convertV1toV2(const QString &fileName);
+    void convertV1toV2(Tiled::Map *map, const QString &fileName) const;
 };
 
 #endif // CONVERTERCONTROL_H
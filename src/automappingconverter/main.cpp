@@ -19,12 +19,27 @@
  * this program. If not, see <http://www.gnu.org/licenses/>.
  */
  
+#include "batchconverter.h"
 #include "converterwindow.h"
+#include "tileset.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // The rule maps are only converted, so their images are not needed
+    Tiled::setImageDecodingEnabled(false);
+
+    // When files or directories are given, they are converted without
+    // showing the window, so no display is needed
+    if (argc > 1) {
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+
+        QGuiApplication a(argc, argv);
+        return runBatchConversion(QCoreApplication::arguments().mid(1));
+    }
+
     QApplication a(argc, argv);
     ConverterWindow w;
     w.show();
@@ -0,0 +1,115 @@
+/*
+ * cachedirectory.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cachedirectory.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+namespace {
+
+/**
+ * Returns when the cache file was last used. The access time is not always
+ * updated, so the cache files are also considered used when written.
+ */
+QDateTime lastUsed(const QFileInfo &fileInfo)
+{
+    return qMax(fileInfo.lastRead(), fileInfo.lastModified());
+}
+
+} // anonymous namespace
+
+/**
+ * Returns the path of the cache directory with the given \a name.
+ */
+QString CacheDirectory::path(const QString &name)
+{
+    const QString cacheLocation =
+            QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+
+    return cacheLocation + QLatin1String("/tiled/") + name;
+}
+
+/**
+ * Returns the name of the file in the cache directory with the given
+ * \a name, in which the data derived from \a fileName is cached.
+ */
+QString CacheDirectory::cacheFileName(const QString &name,
+                                      const QString &fileName)
+{
+    const QString absolutePath = QFileInfo(fileName).absoluteFilePath();
+    const QByteArray hash = QCryptographicHash::hash(absolutePath.toUtf8(),
+                                                     QCryptographicHash::Sha1);
+
+    return path(name)
+            + QLatin1Char('/')
+            + QString::fromLatin1(hash.toHex())
+            + QLatin1String(".cache");
+}
+
+/**
+ * Removes the least recently used files from the cache directory with the
+ * given \a name, until the remaining files take at most \a maximumSize
+ * bytes.
+ *
+ * Files that are still in use may fail to be removed on some platforms, in
+ * which case they are skipped.
+ */
+void CacheDirectory::trim(const QString &name, qint64 maximumSize)
+{
+    const QDir dir(path(name));
+    QFileInfoList files = dir.entryInfoList(QStringList(QLatin1String("*.cache")),
+                                            QDir::Files);
+
+    qint64 size = 0;
+    for (const QFileInfo &fileInfo : files)
+        size += fileInfo.size();
+
+    if (size <= maximumSize)
+        return;
+
+    std::sort(files.begin(), files.end(),
+              [] (const QFileInfo &a, const QFileInfo &b) {
+        return lastUsed(a) < lastUsed(b);
+    });
+
+    for (const QFileInfo &fileInfo : files) {
+        if (size <= maximumSize)
+            break;
+        if (QFile::remove(fileInfo.absoluteFilePath()))
+            size -= fileInfo.size();
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * cachedirectory.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_CACHEDIRECTORY_H
+#define TILED_CACHEDIRECTORY_H
+
+#include "tiled_global.h"
+
+#include <QString>
+
+namespace Tiled {
+
+/**
+ * Manages a directory of cache files, like the ones written by the MapCache
+ * and the ImageCache.
+ *
+ * The directories are stored in the generic cache location, where each
+ * cache file is named after a hash of the absolute path of the file it
+ * caches. To keep them from growing without bound, the least recently used
+ * cache files are removed once a directory exceeds its size limit.
+ */
+class TILEDSHARED_EXPORT CacheDirectory
+{
+public:
+    static QString path(const QString &name);
+
+    static QString cacheFileName(const QString &name,
+                                 const QString &fileName);
+
+    static void trim(const QString &name, qint64 maximumSize);
+};
+
+} // namespace Tiled
+
+#endif // TILED_CACHEDIRECTORY_H
@@ -0,0 +1,86 @@
+/*
+ * colorkey.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "colorkey.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Tiled {
+
+/**
+ * Clears the \a count pixels starting at \a pixels that are equal to
+ * \a color.
+ */
+static void clearPixels(quint32 *pixels, int count, quint32 color)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    const __m128i key = _mm_set1_epi32(int(color));
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i *p = reinterpret_cast<__m128i*>(pixels + i);
+        const __m128i values = _mm_loadu_si128(p);
+        const __m128i matches = _mm_cmpeq_epi32(values, key);
+        _mm_storeu_si128(p, _mm_andnot_si128(matches, values));
+    }
+#endif
+
+    for (; i < count; ++i)
+        if (pixels[i] == color)
+            pixels[i] = 0;
+}
+
+/**
+ * Returns \a image converted to premultiplied ARGB, with the pixels of the
+ * \a transparentColor made fully transparent. Only opaque pixels match the
+ * color, like with QImage::createMaskFromColor().
+ *
+ * This replaces masking a pixmap with a bitmap, and takes a single pass over
+ * the converted image. When the color is invalid the image is returned as is.
+ */
+QImage applyColorKey(const QImage &image, const QColor &transparentColor)
+{
+    if (image.isNull() || !transparentColor.isValid())
+        return image;
+
+    QImage keyed = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    // Opaque pixels are the same premultiplied or not
+    const quint32 color = transparentColor.rgb() | 0xff000000;
+    const int width = keyed.width();
+
+    for (int y = 0; y < keyed.height(); ++y)
+        clearPixels(reinterpret_cast<quint32*>(keyed.scanLine(y)), width, color);
+
+    return keyed;
+}
+
+} // namespace Tiled
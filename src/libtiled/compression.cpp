@@ -37,6 +37,14 @@
 #include <QByteArray>
 #include <QDebug>
 
+#ifdef TILED_ZSTD_SUPPORT
+#include <zstd.h>
+#endif
+
+#ifdef TILED_LZ4_SUPPORT
+#include <lz4.h>
+#endif
+
 #ifdef Z_PREFIX
 #undef compress
 #endif
@@ -63,6 +71,76 @@ static void logZlibError(int error)
     }
 }
 
+bool Tiled::compressionSupported(CompressionMethod method)
+{
+    switch (method) {
+    case Gzip:
+    case Zlib:
+        return true;
+    case Zstandard:
+#ifdef TILED_ZSTD_SUPPORT
+        return true;
+#else
+        return false;
+#endif
+    case Lz4:
+#ifdef TILED_LZ4_SUPPORT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+QByteArray Tiled::decompress(const QByteArray &data, int expectedSize,
+                             CompressionMethod method)
+{
+    switch (method) {
+    case Gzip:
+    case Zlib:
+        return decompress(data, expectedSize);
+
+    case Zstandard: {
+#ifdef TILED_ZSTD_SUPPORT
+        QByteArray out(expectedSize, Qt::Uninitialized);
+        const size_t result = ZSTD_decompress(out.data(), out.size(),
+                                              data.constData(), data.size());
+        if (ZSTD_isError(result)) {
+            qDebug() << "Error while decompressing Zstandard data:"
+                     << ZSTD_getErrorName(result);
+            return QByteArray();
+        }
+        out.resize(int(result));
+        return out;
+#else
+        qDebug() << "Zstandard compression not supported";
+        return QByteArray();
+#endif
+    }
+
+    case Lz4: {
+#ifdef TILED_LZ4_SUPPORT
+        QByteArray out(expectedSize, Qt::Uninitialized);
+        const int result = LZ4_decompress_safe(data.constData(), out.data(),
+                                               data.size(), out.size());
+        if (result < 0) {
+            qDebug() << "Incorrect LZ4 compressed data!";
+            return QByteArray();
+        }
+        out.resize(result);
+        return out;
+#else
+        qDebug() << "LZ4 compression not supported";
+        return QByteArray();
+#endif
+    }
+    }
+
+    return QByteArray();
+}
+
 QByteArray Tiled::decompress(const QByteArray &data, int expectedSize)
 {
     QByteArray out;
@@ -122,6 +200,42 @@ QByteArray Tiled::decompress(const QByteArray &data, int expectedSize)
 
 QByteArray Tiled::compress(const QByteArray &data, CompressionMethod method)
 {
+    if (method == Zstandard) {
+#ifdef TILED_ZSTD_SUPPORT
+        QByteArray out(int(ZSTD_compressBound(data.size())), Qt::Uninitialized);
+        const size_t result = ZSTD_compress(out.data(), out.size(),
+                                            data.constData(), data.size(),
+                                            ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(result)) {
+            qDebug() << "Error while compressing Zstandard data:"
+                     << ZSTD_getErrorName(result);
+            return QByteArray();
+        }
+        out.resize(int(result));
+        return out;
+#else
+        qDebug() << "Zstandard compression not supported";
+        return QByteArray();
+#endif
+    }
+
+    if (method == Lz4) {
+#ifdef TILED_LZ4_SUPPORT
+        QByteArray out(LZ4_compressBound(data.size()), Qt::Uninitialized);
+        const int result = LZ4_compress_default(data.constData(), out.data(),
+                                                data.size(), out.size());
+        if (result <= 0) {
+            qDebug() << "Error while compressing LZ4 data!";
+            return QByteArray();
+        }
+        out.resize(result);
+        return out;
+#else
+        qDebug() << "LZ4 compression not supported";
+        return QByteArray();
+#endif
+    }
+
     QByteArray out;
     out.resize(1024);
     int err;
@@ -169,3 +283,198 @@ QByteArray Tiled::compress(const QByteArray &data, CompressionMethod method)
     out.resize(outLength);
     return out;
 }
+
+
+// Size of the output blocks passed to the sink of a streaming (de)compressor
+static const int StreamBlockSize = 16 * 1024;
+
+struct Compressor::Private
+{
+    z_stream strm;
+    CompressionSink sink;
+    QByteArray buffer;
+    bool error;
+
+    bool deflateData(int flush);
+};
+
+bool Compressor::Private::deflateData(int flush)
+{
+    int err;
+
+    do {
+        strm.next_out = (Bytef *) buffer.data();
+        strm.avail_out = buffer.size();
+
+        err = deflate(&strm, flush);
+        Q_ASSERT(err != Z_STREAM_ERROR);
+
+        if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR) {
+            logZlibError(err);
+            error = true;
+            return false;
+        }
+
+        const int length = buffer.size() - strm.avail_out;
+        if (length > 0)
+            sink(buffer.constData(), length);
+
+    } while (strm.avail_out == 0 || (flush == Z_FINISH && err != Z_STREAM_END));
+
+    return true;
+}
+
+Compressor::Compressor(CompressionMethod method, const CompressionSink &sink)
+    : d(new Private)
+{
+    Q_ASSERT(method == Gzip || method == Zlib);
+
+    d->sink = sink;
+    d->buffer.resize(StreamBlockSize);
+    d->error = false;
+
+    d->strm.zalloc = Z_NULL;
+    d->strm.zfree = Z_NULL;
+    d->strm.opaque = Z_NULL;
+    d->strm.next_in = Z_NULL;
+    d->strm.avail_in = 0;
+
+    const int windowBits = (method == Gzip) ? 15 + 16 : 15;
+
+    int err = deflateInit2(&d->strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                           windowBits, 8, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK) {
+        logZlibError(err);
+        d->error = true;
+    }
+}
+
+Compressor::~Compressor()
+{
+    deflateEnd(&d->strm);
+    delete d;
+}
+
+bool Compressor::write(const char *data, int length)
+{
+    if (d->error)
+        return false;
+
+    d->strm.next_in = (Bytef *) data;
+    d->strm.avail_in = length;
+
+    return d->deflateData(Z_NO_FLUSH);
+}
+
+bool Compressor::finish()
+{
+    if (d->error)
+        return false;
+
+    d->strm.next_in = Z_NULL;
+    d->strm.avail_in = 0;
+
+    return d->deflateData(Z_FINISH);
+}
+
+
+struct Decompressor::Private
+{
+    z_stream strm;
+    CompressionSink sink;
+    QByteArray buffer;
+    bool error;
+    bool finished;
+};
+
+Decompressor::Decompressor(const CompressionSink &sink)
+    : d(new Private)
+{
+    d->sink = sink;
+    d->buffer.resize(StreamBlockSize);
+    d->error = false;
+    d->finished = false;
+
+    d->strm.zalloc = Z_NULL;
+    d->strm.zfree = Z_NULL;
+    d->strm.opaque = Z_NULL;
+    d->strm.next_in = Z_NULL;
+    d->strm.avail_in = 0;
+
+    int ret = inflateInit2(&d->strm, 15 + 32);
+    if (ret != Z_OK) {
+        logZlibError(ret);
+        d->error = true;
+    }
+}
+
+Decompressor::~Decompressor()
+{
+    inflateEnd(&d->strm);
+    delete d;
+}
+
+bool Decompressor::write(const char *data, int length)
+{
+    if (d->error)
+        return false;
+
+    if (d->finished) {
+        // Trailing data after the end of the compressed stream
+        if (length > 0) {
+            logZlibError(Z_DATA_ERROR);
+            d->error = true;
+        }
+        return !d->error;
+    }
+
+    d->strm.next_in = (Bytef *) data;
+    d->strm.avail_in = length;
+
+    do {
+        d->strm.next_out = (Bytef *) d->buffer.data();
+        d->strm.avail_out = d->buffer.size();
+
+        int ret = inflate(&d->strm, Z_SYNC_FLUSH);
+
+        switch (ret) {
+            case Z_NEED_DICT:
+            case Z_STREAM_ERROR:
+                ret = Z_DATA_ERROR;
+            case Z_DATA_ERROR:
+            case Z_MEM_ERROR:
+                logZlibError(ret);
+                d->error = true;
+                return false;
+        }
+
+        const int outLength = d->buffer.size() - d->strm.avail_out;
+        if (outLength > 0)
+            d->sink(d->buffer.constData(), outLength);
+
+        if (ret == Z_STREAM_END) {
+            d->finished = true;
+
+            if (d->strm.avail_in != 0) {
+                logZlibError(Z_DATA_ERROR);
+                d->error = true;
+                return false;
+            }
+            break;
+        }
+
+        if (ret == Z_BUF_ERROR)
+            break;
+
+    } while (d->strm.avail_in > 0 || d->strm.avail_out == 0);
+
+    return true;
+}
+
+bool Decompressor::finish()
+{
+    if (!d->error && !d->finished)
+        logZlibError(Z_DATA_ERROR);
+
+    return !d->error && d->finished;
+}
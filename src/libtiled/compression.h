@@ -31,15 +31,25 @@
 
 #include "tiled_global.h"
 
+#include <functional>
+
 class QByteArray;
 
 namespace Tiled {
 
 enum CompressionMethod {
     Gzip,
-    Zlib
+    Zlib,
+    Zstandard,
+    Lz4
 };
 
+/**
+ * Returns whether the given compression \a method is available. Support for
+ * Zstandard and LZ4 is optional and depends on how libtiled was built.
+ */
+bool TILEDSHARED_EXPORT compressionSupported(CompressionMethod method);
+
 /**
  * Decompresses either zlib or gzip compressed memory. Returns a null
  * QByteArray if decompressing failed.
@@ -56,8 +66,19 @@ QByteArray TILEDSHARED_EXPORT decompress(const QByteArray &data,
                                          int expectedSize = 1024);
 
 /**
- * Compresses the give data in either gzip or zlib format. Returns a null
- * QByteArray if compression failed.
+ * Decompresses memory compressed with the given \a method. Zstandard and LZ4
+ * compressed data is decompressed in one go, which requires the exact
+ * \a expectedSize to be known in case of LZ4.
+ *
+ * @return the uncompressed data, or a null QByteArray if decompressing failed
+ */
+QByteArray TILEDSHARED_EXPORT decompress(const QByteArray &data,
+                                         int expectedSize,
+                                         CompressionMethod method);
+
+/**
+ * Compresses the give data in gzip, zlib, Zstandard or LZ4 format. Returns a
+ * null QByteArray if compression failed.
  *
  * Needed because qCompress does not support gzip compression.
  *
@@ -67,6 +88,68 @@ QByteArray TILEDSHARED_EXPORT decompress(const QByteArray &data,
 QByteArray TILEDSHARED_EXPORT compress(const QByteArray &data,
                                        CompressionMethod method = Zlib);
 
+/**
+ * Receives the output of a streaming Compressor or Decompressor.
+ */
+typedef std::function<void (const char *data, int length)> CompressionSink;
+
+/**
+ * Compresses data in either gzip or zlib format as it is written, passing
+ * the compressed data on to a sink in blocks of limited size. This avoids
+ * having both the uncompressed and the compressed data in memory at once.
+ */
+class TILEDSHARED_EXPORT Compressor
+{
+public:
+    Compressor(CompressionMethod method, const CompressionSink &sink);
+    ~Compressor();
+
+    /**
+     * Compresses the given \a data. Returns false when an error occurred.
+     */
+    bool write(const char *data, int length);
+
+    /**
+     * Flushes the remaining compressed data to the sink. Returns false when
+     * an error occurred at any point.
+     */
+    bool finish();
+
+private:
+    Q_DISABLE_COPY(Compressor)
+
+    struct Private;
+    Private *d;
+};
+
+/**
+ * Decompresses either zlib or gzip compressed data as it is written,
+ * passing the decompressed data on to a sink in blocks of limited size.
+ */
+class TILEDSHARED_EXPORT Decompressor
+{
+public:
+    explicit Decompressor(const CompressionSink &sink);
+    ~Decompressor();
+
+    /**
+     * Decompresses the given \a data. Returns false when an error occurred.
+     */
+    bool write(const char *data, int length);
+
+    /**
+     * Returns whether the complete compressed stream was successfully
+     * decompressed.
+     */
+    bool finish();
+
+private:
+    Q_DISABLE_COPY(Decompressor)
+
+    struct Private;
+    Private *d;
+};
+
 } // namespace Tiled
 
 #endif // COMPRESSION_H
@@ -0,0 +1,134 @@
+/*
+ * csvparser.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_CSVPARSER_H
+#define TILED_CSVPARSER_H
+
+#include <QChar>
+
+namespace Tiled {
+
+/**
+ * A single-pass parser for comma separated unsigned numbers, as used by the
+ * CSV layer data format. It works directly on UTF-16 (QChar) or 8-bit (char)
+ * data without allocating memory.
+ *
+ * Whitespace around the values is ignored, like QString::toUInt does.
+ * Values are decimal by default, but any base up to 16 can be given.
+ */
+template<typename Char>
+class CsvParser
+{
+public:
+    CsvParser(const Char *begin, const Char *end, int base = 10)
+        : mPos(begin)
+        , mEnd(end)
+        , mBase(base)
+        , mExpectValue(begin != end)
+    {}
+
+    /**
+     * Reads the next value. Returns false when there are no more values.
+     *
+     * The \a ok parameter is set to false when the value was not a valid
+     * unsigned number, in which case \a value is set to 0.
+     */
+    bool next(unsigned &value, bool &ok)
+    {
+        if (!mExpectValue)
+            return false;
+
+        skipWhitespace();
+
+        quint64 result = 0;
+        const Char *start = mPos;
+
+        while (mPos != mEnd) {
+            const int digit = digitValue(code(*mPos));
+            if (digit < 0 || digit >= mBase)
+                break;
+
+            result = result * mBase + digit;
+            if (result > 0xFFFFFFFFu)
+                break;
+
+            ++mPos;
+        }
+
+        ok = mPos != start && result <= 0xFFFFFFFFu;
+
+        skipWhitespace();
+
+        // Anything other than a comma or the end invalidates the value
+        while (mPos != mEnd && code(*mPos) != ',') {
+            ok = false;
+            ++mPos;
+        }
+
+        if (mPos != mEnd)
+            ++mPos;   // skip the comma, another value follows
+        else
+            mExpectValue = false;
+
+        value = ok ? unsigned(result) : 0;
+        return true;
+    }
+
+private:
+    static ushort code(QChar c) { return c.unicode(); }
+    static ushort code(char c) { return uchar(c); }
+
+    static int digitValue(ushort c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    static bool isSpace(ushort c)
+    { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    void skipWhitespace()
+    {
+        while (mPos != mEnd && isSpace(code(*mPos)))
+            ++mPos;
+    }
+
+    const Char *mPos;
+    const Char *mEnd;
+    int mBase;
+    bool mExpectValue;
+};
+
+} // namespace Tiled
+
+#endif // TILED_CSVPARSER_H
@@ -0,0 +1,261 @@
+/*
+ * deferredformat.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "deferredformat.h"
+
+#include "pluginmanager.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QJsonValue>
+#include <QRegExp>
+
+using namespace Tiled;
+
+/**
+ * Returns the format with the given index among the formats of type Format
+ * added by the plugin, loading the plugin when necessary.
+ */
+template<typename Format>
+static Format *loadFormat(const DeferredFormatInfo &info)
+{
+    PluginManager *pluginManager = PluginManager::instance();
+    if (!pluginManager->loadDeferredPlugin(info.pluginIndex()))
+        return nullptr;
+
+    int index = 0;
+    for (QObject *object : pluginManager->plugins().at(info.pluginIndex()).objects) {
+        if (Format *format = qobject_cast<Format*>(object)) {
+            if (index == info.formatIndex())
+                return format;
+            ++index;
+        }
+    }
+
+    return nullptr;
+}
+
+
+DeferredFormatInfo::DeferredFormatInfo(int pluginIndex, int formatIndex,
+                                       const QJsonObject &description)
+    : mPluginIndex(pluginIndex)
+    , mFormatIndex(formatIndex)
+    , mContext(description.value(QLatin1String("context")).toString().toUtf8())
+    , mNameFilter(description.value(QLatin1String("nameFilter")).toString().toUtf8())
+    , mCapabilities(FileFormat::NoCapability)
+{
+    const QStringList capabilities = description.value(QLatin1String("capabilities")).toString()
+            .split(QLatin1Char(' '), QString::SkipEmptyParts);
+
+    for (const QString &capability : capabilities) {
+        if (capability == QLatin1String("Read"))
+            mCapabilities |= FileFormat::Read;
+        else if (capability == QLatin1String("Write"))
+            mCapabilities |= FileFormat::Write;
+        else if (capability == QLatin1String("ReadWrite"))
+            mCapabilities |= FileFormat::ReadWrite;
+        else if (capability == QLatin1String("StreamRead"))
+            mCapabilities |= FileFormat::StreamRead;
+        else if (capability == QLatin1String("StreamWrite"))
+            mCapabilities |= FileFormat::StreamWrite;
+    }
+}
+
+/**
+ * Returns the name filter translated the same way as the plugin translates
+ * it, so that it matches the name filter of the loaded format.
+ */
+QString DeferredFormatInfo::nameFilter() const
+{
+    return QCoreApplication::translate(mContext.constData(),
+                                       mNameFilter.constData());
+}
+
+/**
+ * Returns whether \a fileName matches one of the wildcard patterns in the
+ * name filter, like "*.json" in "Json map files (*.json)".
+ */
+bool DeferredFormatInfo::matchesNameFilter(const QString &fileName) const
+{
+    const QString nameFilter = QString::fromUtf8(mNameFilter);
+    const int start = nameFilter.lastIndexOf(QLatin1Char('('));
+    const int end = nameFilter.lastIndexOf(QLatin1Char(')'));
+    if (start == -1 || end < start)
+        return false;
+
+    const QString name = QFileInfo(fileName).fileName();
+    const QStringList patterns = nameFilter.mid(start + 1, end - start - 1)
+            .split(QLatin1Char(' '), QString::SkipEmptyParts);
+
+    for (const QString &pattern : patterns) {
+        QRegExp regExp(pattern, Qt::CaseInsensitive, QRegExp::Wildcard);
+        if (regExp.exactMatch(name))
+            return true;
+    }
+
+    return false;
+}
+
+QString DeferredFormatInfo::loadError() const
+{
+    return PluginManager::instance()->plugins().at(mPluginIndex).errorString;
+}
+
+
+DeferredMapFormat::DeferredMapFormat(const DeferredFormatInfo &info,
+                                     QObject *parent)
+    : MapFormat(parent)
+    , mInfo(info)
+{
+}
+
+FileFormat::Capabilities DeferredMapFormat::capabilities() const
+{
+    return mInfo.capabilities();
+}
+
+QStringList DeferredMapFormat::outputFiles(const Map *map,
+                                           const QString &fileName) const
+{
+    if (MapFormat *mapFormat = format())
+        return mapFormat->outputFiles(map, fileName);
+    return MapFormat::outputFiles(map, fileName);
+}
+
+QString DeferredMapFormat::nameFilter() const
+{
+    return mInfo.nameFilter();
+}
+
+bool DeferredMapFormat::supportsFile(const QString &fileName) const
+{
+    // Avoid loading the plugin for files it surely doesn't support
+    if (!(mInfo.capabilities() & Read) || !mInfo.matchesNameFilter(fileName))
+        return false;
+
+    MapFormat *mapFormat = format();
+    return mapFormat && mapFormat->supportsFile(fileName);
+}
+
+QString DeferredMapFormat::errorString() const
+{
+    PluginManager *pluginManager = PluginManager::instance();
+    if (!pluginManager->plugins().at(mInfo.pluginIndex()).instance)
+        return mInfo.loadError();
+
+    MapFormat *mapFormat = format();
+    return mapFormat ? mapFormat->errorString() : QString();
+}
+
+Map *DeferredMapFormat::read(const QString &fileName)
+{
+    MapFormat *mapFormat = format();
+    return mapFormat ? mapFormat->read(fileName) : nullptr;
+}
+
+bool DeferredMapFormat::write(const Map *map, const QString &fileName)
+{
+    MapFormat *mapFormat = format();
+    return mapFormat && mapFormat->write(map, fileName);
+}
+
+Map *DeferredMapFormat::readFromDevice(QIODevice *device,
+                                       const QString &path,
+                                       const MapReadOptions &options)
+{
+    MapFormat *mapFormat = format();
+    return mapFormat ? mapFormat->readFromDevice(device, path, options) : nullptr;
+}
+
+bool DeferredMapFormat::writeToDevice(const Map *map,
+                                      QIODevice *device,
+                                      const QString &path,
+                                      const MapWriteOptions &options)
+{
+    MapFormat *mapFormat = format();
+    return mapFormat && mapFormat->writeToDevice(map, device, path, options);
+}
+
+MapFormat *DeferredMapFormat::format() const
+{
+    return loadFormat<MapFormat>(mInfo);
+}
+
+
+DeferredTilesetFormat::DeferredTilesetFormat(const DeferredFormatInfo &info,
+                                             QObject *parent)
+    : TilesetFormat(parent)
+    , mInfo(info)
+{
+}
+
+FileFormat::Capabilities DeferredTilesetFormat::capabilities() const
+{
+    return mInfo.capabilities();
+}
+
+QString DeferredTilesetFormat::nameFilter() const
+{
+    return mInfo.nameFilter();
+}
+
+bool DeferredTilesetFormat::supportsFile(const QString &fileName) const
+{
+    if (!(mInfo.capabilities() & Read) || !mInfo.matchesNameFilter(fileName))
+        return false;
+
+    TilesetFormat *tilesetFormat = format();
+    return tilesetFormat && tilesetFormat->supportsFile(fileName);
+}
+
+QString DeferredTilesetFormat::errorString() const
+{
+    PluginManager *pluginManager = PluginManager::instance();
+    if (!pluginManager->plugins().at(mInfo.pluginIndex()).instance)
+        return mInfo.loadError();
+
+    TilesetFormat *tilesetFormat = format();
+    return tilesetFormat ? tilesetFormat->errorString() : QString();
+}
+
+SharedTileset DeferredTilesetFormat::read(const QString &fileName)
+{
+    TilesetFormat *tilesetFormat = format();
+    return tilesetFormat ? tilesetFormat->read(fileName) : SharedTileset();
+}
+
+bool DeferredTilesetFormat::write(const Tileset &tileset, const QString &fileName)
+{
+    TilesetFormat *tilesetFormat = format();
+    return tilesetFormat && tilesetFormat->write(tileset, fileName);
+}
+
+TilesetFormat *DeferredTilesetFormat::format() const
+{
+    return loadFormat<TilesetFormat>(mInfo);
+}
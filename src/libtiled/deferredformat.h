@@ -0,0 +1,142 @@
+/*
+ * deferredformat.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DEFERREDFORMAT_H
+#define DEFERREDFORMAT_H
+
+#include "mapformat.h"
+#include "tilesetformat.h"
+
+#include <QJsonObject>
+
+namespace Tiled {
+
+/**
+ * The description of a file format in the metadata of a plugin, which
+ * allows the format to be offered before the plugin is loaded.
+ *
+ * The metadata has a "MapFormats" and/or a "TilesetFormats" array, in the
+ * order in which the plugin adds its formats. Each entry has the untranslated
+ * "nameFilter" along with the translation "context" it is translated in, and
+ * the "capabilities" of the format, separated by spaces ("Read", "Write",
+ * "ReadWrite", "StreamRead" or "StreamWrite").
+ */
+class TILEDSHARED_EXPORT DeferredFormatInfo
+{
+public:
+    DeferredFormatInfo(int pluginIndex, int formatIndex,
+                       const QJsonObject &description);
+
+    int pluginIndex() const { return mPluginIndex; }
+    int formatIndex() const { return mFormatIndex; }
+
+    FileFormat::Capabilities capabilities() const { return mCapabilities; }
+    QString nameFilter() const;
+
+    bool matchesNameFilter(const QString &fileName) const;
+
+    QString loadError() const;
+
+private:
+    int mPluginIndex;
+    int mFormatIndex;
+    QByteArray mContext;
+    QByteArray mNameFilter;
+    FileFormat::Capabilities mCapabilities;
+};
+
+/**
+ * Stands in for a map format of a plugin that hasn't been loaded yet. The
+ * plugin is loaded when the format is used, which doesn't include checking
+ * files that don't match the name filter.
+ *
+ * Once the plugin is loaded, its own formats replace this one in the plugin
+ * manager. Code that held on to this format can keep using it, since the
+ * calls are forwarded.
+ */
+class TILEDSHARED_EXPORT DeferredMapFormat : public MapFormat
+{
+    Q_OBJECT
+    Q_INTERFACES(Tiled::MapFormat)
+
+public:
+    DeferredMapFormat(const DeferredFormatInfo &info, QObject *parent = nullptr);
+
+    Capabilities capabilities() const override;
+    QStringList outputFiles(const Map *map, const QString &fileName) const override;
+    QString nameFilter() const override;
+    bool supportsFile(const QString &fileName) const override;
+    QString errorString() const override;
+
+    Map *read(const QString &fileName) override;
+    bool write(const Map *map, const QString &fileName) override;
+
+    Map *readFromDevice(QIODevice *device,
+                        const QString &path,
+                        const MapReadOptions &options) override;
+    bool writeToDevice(const Map *map,
+                       QIODevice *device,
+                       const QString &path,
+                       const MapWriteOptions &options) override;
+
+private:
+    MapFormat *format() const;
+
+    DeferredFormatInfo mInfo;
+};
+
+/**
+ * Stands in for a tileset format of a plugin that hasn't been loaded yet.
+ *
+ * \sa DeferredMapFormat
+ */
+class TILEDSHARED_EXPORT DeferredTilesetFormat : public TilesetFormat
+{
+    Q_OBJECT
+    Q_INTERFACES(Tiled::TilesetFormat)
+
+public:
+    DeferredTilesetFormat(const DeferredFormatInfo &info, QObject *parent = nullptr);
+
+    Capabilities capabilities() const override;
+    QString nameFilter() const override;
+    bool supportsFile(const QString &fileName) const override;
+    QString errorString() const override;
+
+    SharedTileset read(const QString &fileName) override;
+    bool write(const Tileset &tileset, const QString &fileName) override;
+
+private:
+    TilesetFormat *format() const;
+
+    DeferredFormatInfo mInfo;
+};
+
+} // namespace Tiled
+
+#endif // DEFERREDFORMAT_H
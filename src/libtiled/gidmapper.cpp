@@ -31,6 +31,13 @@
 #include "compression.h"
 #include "tile.h"
 #include "tileset.h"
+#include "tracing.h"
+
+#include <QScopedPointer>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
 
 using namespace Tiled;
 
@@ -39,12 +46,158 @@ const int FlippedHorizontallyFlag   = 0x80000000;
 const int FlippedVerticallyFlag     = 0x40000000;
 const int FlippedAntiDiagonallyFlag = 0x20000000;
 
+// Upper limit on the amount of gids covered by the direct lookup table
+static const unsigned MaxGidTableSize = 1 << 20;
+
+// Amount of bytes encoded to or decoded from base64 at once
+static const int Base64BlockSize = 3 * 4096;
+
+namespace {
+
+/**
+ * Encodes data to base64 as it is written, passing the encoded text on to
+ * a sink in blocks of limited size.
+ */
+class Base64Encoder
+{
+public:
+    explicit Base64Encoder(const CompressionSink &sink)
+        : mSink(sink)
+    {}
+
+    void write(const char *data, int length)
+    {
+        mPending.append(data, length);
+
+        // Only full groups of 3 bytes can be encoded without padding
+        if (mPending.size() >= Base64BlockSize)
+            flush(mPending.size() - mPending.size() % 3);
+    }
+
+    void finish()
+    {
+        flush(mPending.size());
+    }
+
+private:
+    void flush(int length)
+    {
+        if (length == 0)
+            return;
+
+        const QByteArray encoded =
+                QByteArray::fromRawData(mPending.constData(), length).toBase64();
+        mSink(encoded.constData(), encoded.size());
+        mPending.remove(0, length);
+    }
+
+    const CompressionSink &mSink;
+    QByteArray mPending;
+};
+
+inline bool isBase64Character(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+            (c >= '0' && c <= '9') || c == '+' || c == '/' || c == '=';
+}
+
+/**
+ * Decodes the given base64 \a text in blocks of limited size, passing the
+ * decoded data on to the \a sink. Whitespace and other invalid characters
+ * are skipped, like QByteArray::fromBase64 does.
+ */
+void decodeBase64(const QByteArray &text, const CompressionSink &sink)
+{
+    QByteArray block;
+    block.reserve(Base64BlockSize / 3 * 4);
+
+    auto flush = [&] () {
+        const QByteArray decoded = QByteArray::fromBase64(block);
+        sink(decoded.constData(), decoded.size());
+        block.resize(0);
+    };
+
+    for (const char c : text) {
+        if (!isBase64Character(c))
+            continue;
+
+        block.append(c);
+
+        if (block.size() == Base64BlockSize / 3 * 4)
+            flush();
+    }
+
+    if (!block.isEmpty())
+        flush();
+}
+
+/**
+ * Returns whether the given \a format uses compression, storing the method
+ * used in \a method.
+ */
+bool compressionMethod(Map::LayerDataFormat format, CompressionMethod &method)
+{
+    switch (format) {
+    case Map::Base64Gzip:       method = Gzip; return true;
+    case Map::Base64Zlib:       method = Zlib; return true;
+    case Map::Base64Zstandard:  method = Zstandard; return true;
+    case Map::Base64Lz4:        method = Lz4; return true;
+    default:                    return false;
+    }
+}
+
+/**
+ * Decodes and decompresses the given \a layerData, passing the resulting
+ * bytes on to the \a sink. The \a size is the expected number of bytes,
+ * needed by compression methods that decompress in one go.
+ *
+ * Returns false when the data could not be decompressed.
+ */
+bool decodeLayerBytes(const QByteArray &layerData,
+                      Map::LayerDataFormat format,
+                      int size,
+                      const CompressionSink &sink)
+{
+    CompressionMethod method;
+    const bool compressed = compressionMethod(format, method);
+
+    if (compressed && (method == Zstandard || method == Lz4)) {
+        QByteArray compressedData;
+        decodeBase64(layerData, [&] (const char *data, int length) {
+            compressedData.append(data, length);
+        });
+
+        const QByteArray decompressed = decompress(compressedData, size, method);
+        if (decompressed.size() != size)
+            return false;
+
+        sink(decompressed.constData(), decompressed.size());
+    } else if (compressed) {
+        Decompressor decompressor(sink);
+        bool ok = true;
+
+        decodeBase64(layerData, [&] (const char *data, int length) {
+            ok = ok && decompressor.write(data, length);
+        });
+
+        if (!ok || !decompressor.finish())
+            return false;
+    } else {
+        decodeBase64(layerData, sink);
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
 /**
  * Default constructor. Use \l insert to initialize the gid mapper
  * incrementally.
  */
 GidMapper::GidMapper()
-    : mInvalidTile(0)
+    : mGidTableDirty(false)
+    , mInvalidTile(0)
 {
 }
 
@@ -52,7 +205,8 @@ GidMapper::GidMapper()
  * Constructor that initializes the gid mapper using the given \a tilesets.
  */
 GidMapper::GidMapper(const QVector<SharedTileset> &tilesets)
-    : mInvalidTile(0)
+    : mGidTableDirty(false)
+    , mInvalidTile(0)
 {
     unsigned firstGid = 1;
     foreach (const SharedTileset &tileset, tilesets) {
@@ -61,6 +215,130 @@ GidMapper::GidMapper(const QVector<SharedTileset> &tilesets)
     }
 }
 
+/**
+ * Copy constructor. Builds the lookup table of \a other when necessary, so
+ * that it is shared with the copy.
+ */
+GidMapper::GidMapper(const GidMapper &other)
+{
+    *this = other;
+}
+
+GidMapper &GidMapper::operator=(const GidMapper &other)
+{
+    if (other.mGidTableDirty)
+        other.rebuildGidTable();
+
+    mTilesets = other.mTilesets;
+    mTilesetToFirstGid = other.mTilesetToFirstGid;
+    mTilesetColumnCounts = other.mTilesetColumnCounts;
+    mGidTable = other.mGidTable;
+    mGidTableDirty = false;
+    mInvalidTile = other.mInvalidTile;
+    return *this;
+}
+
+/**
+ * Insert the given \a tileset with \a firstGid as its first global ID.
+ *
+ * The lookup table is only built when it is needed, since rebuilding it for
+ * each inserted tileset would be slow for maps with many tilesets.
+ */
+void GidMapper::insert(unsigned firstGid, Tileset *tileset)
+{
+    const TilesetEntry entry = {
+        firstGid,
+        tileset,
+        mTilesetColumnCounts.value(tileset)
+    };
+
+    auto it = std::lower_bound(mTilesets.begin(), mTilesets.end(), firstGid,
+                               [] (const TilesetEntry &e, unsigned gid) {
+        return e.firstGid < gid;
+    });
+
+    if (it != mTilesets.end() && it->firstGid == firstGid)
+        *it = entry;
+    else
+        mTilesets.insert(it, entry);
+
+    // When a tileset is inserted more than once, its lowest first gid is used
+    auto i = mTilesetToFirstGid.find(tileset);
+    if (i == mTilesetToFirstGid.end())
+        mTilesetToFirstGid.insert(tileset, firstGid);
+    else if (firstGid < i.value())
+        i.value() = firstGid;
+
+    mGidTableDirty = true;
+}
+
+/**
+ * Clears the gid mapper, so that it can be reused.
+ */
+void GidMapper::clear()
+{
+    mTilesets.clear();
+    mTilesetToFirstGid.clear();
+    mTilesetColumnCounts.clear();
+    mGidTable.clear();
+    mGidTableDirty = false;
+}
+
+/**
+ * Rebuilds the table used to look up the tileset of a gid in constant time.
+ * Gids beyond the size of the table are looked up using a binary search.
+ */
+void GidMapper::rebuildGidTable() const
+{
+    mGidTable.clear();
+    mGidTableDirty = false;
+
+    if (mTilesets.isEmpty() || mTilesets.size() >= 0xFFFF)
+        return;
+
+    const TilesetEntry &last = mTilesets.last();
+    const unsigned end = qMin(last.firstGid + last.tileset->tileCount(),
+                              MaxGidTableSize);
+
+    mGidTable.fill(0, end);
+
+    quint16 *table = mGidTable.data();
+
+    for (int i = 0; i < mTilesets.size(); ++i) {
+        const unsigned rangeStart = mTilesets.at(i).firstGid;
+        const unsigned rangeEnd = (i + 1 < mTilesets.size()) ? mTilesets.at(i + 1).firstGid
+                                                            : end;
+
+        for (unsigned gid = rangeStart; gid < qMin(rangeEnd, end); ++gid)
+            table[gid] = quint16(i + 1);
+    }
+}
+
+/**
+ * Returns the tileset entry containing the given \a gid (without flags),
+ * or nullptr when the gid lies before the first tileset.
+ */
+const GidMapper::TilesetEntry *GidMapper::findEntry(unsigned gid) const
+{
+    if (mGidTableDirty)
+        rebuildGidTable();
+
+    if (gid < unsigned(mGidTable.size())) {
+        const quint16 index = mGidTable.at(gid);
+        return index ? &mTilesets.at(index - 1) : nullptr;
+    }
+
+    auto it = std::upper_bound(mTilesets.begin(), mTilesets.end(), gid,
+                               [] (unsigned gid, const TilesetEntry &e) {
+        return gid < e.firstGid;
+    });
+
+    if (it == mTilesets.begin())
+        return nullptr;
+
+    return &*(it - 1);  // upper bound finds the next tileset
+}
+
 /**
  * Returns the cell data matched by the given \a gid. The \a ok parameter
  * indicates whether an error occurred.
@@ -85,16 +363,15 @@ Cell GidMapper::gidToCell(unsigned gid, bool &ok) const
         ok = false;
     } else {
         // Find the tileset containing this tile
-        QMap<unsigned, Tileset*>::const_iterator i = mFirstGidToTileset.upperBound(gid);
-        if (i == mFirstGidToTileset.begin()) {
+        const TilesetEntry *entry = findEntry(gid);
+        if (!entry) {
             // Invalid global tile ID, since it lies before the first tileset
             ok = false;
         } else {
-            --i; // Navigate one tileset back since upper bound finds the next
-            int tileId = gid - i.key();
-            const Tileset *tileset = i.value();
+            int tileId = gid - entry->firstGid;
+            const Tileset *tileset = entry->tileset;
 
-            const int columnCount = mTilesetColumnCounts.value(tileset);
+            const int columnCount = entry->columnCount;
             if (columnCount > 0 && columnCount != tileset->columnCount()) {
                 // Correct tile index for changes in image width
                 const int row = tileId / columnCount;
@@ -123,15 +400,11 @@ unsigned GidMapper::cellToGid(const Cell &cell) const
     const Tileset *tileset = cell.tile->tileset();
 
     // Find the first GID for the tileset
-    QMap<unsigned, Tileset*>::const_iterator i = mFirstGidToTileset.begin();
-    QMap<unsigned, Tileset*>::const_iterator i_end = mFirstGidToTileset.end();
-    while (i != i_end && i.value() != tileset)
-        ++i;
-
-    if (i == i_end) // tileset not found
+    auto i = mTilesetToFirstGid.constFind(tileset);
+    if (i == mTilesetToFirstGid.constEnd()) // tileset not found
         return 0;
 
-    unsigned gid = i.key() + cell.tile->id();
+    unsigned gid = i.value() + cell.tile->id();
     if (cell.flippedHorizontally)
         gid |= FlippedHorizontallyFlag;
     if (cell.flippedVertically)
@@ -151,39 +424,155 @@ void GidMapper::setTilesetWidth(const Tileset *tileset, int width)
     if (tileset->tileWidth() == 0)
         return;
 
-    mTilesetColumnCounts.insert(tileset, tileset->columnCountForWidth(width));
+    const int columnCount = tileset->columnCountForWidth(width);
+    mTilesetColumnCounts.insert(tileset, columnCount);
+
+    for (TilesetEntry &entry : mTilesets)
+        if (entry.tileset == tileset)
+            entry.columnCount = columnCount;
+}
+
+/**
+ * Converts the cells on row \a y of the given \a tileLayer to global tile
+ * IDs, which are written to \a gids. The \a gids buffer needs to have room
+ * for one gid for each column of the layer.
+ */
+void GidMapper::cellsToGids(const TileLayer &tileLayer, int y, unsigned *gids) const
+{
+    // Neighboring cells tend to use the same tileset, so the first gid of
+    // the last seen tileset is remembered to avoid most hash lookups.
+    const Tileset *lastTileset = nullptr;
+    unsigned lastFirstGid = 0;
+
+    for (int x = 0, width = tileLayer.width(); x < width; ++x) {
+        const Cell &cell = tileLayer.cellAt(x, y);
+        const Tile *tile = cell.tile;
+
+        if (!tile) {
+            gids[x] = 0;
+            continue;
+        }
+
+        const Tileset *tileset = tile->tileset();
+        if (tileset != lastTileset) {
+            auto i = mTilesetToFirstGid.constFind(tileset);
+            if (i == mTilesetToFirstGid.constEnd()) { // tileset not found
+                gids[x] = 0;
+                continue;
+            }
+
+            lastTileset = tileset;
+            lastFirstGid = i.value();
+        }
+
+        unsigned gid = lastFirstGid + tile->id();
+        gid |= unsigned(cell.flippedHorizontally) << 31;
+        gid |= unsigned(cell.flippedVertically) << 30;
+        gid |= unsigned(cell.flippedAntiDiagonally) << 29;
+        gids[x] = gid;
+    }
 }
 
 /**
  * Encodes the tile layer data of the given \a tileLayer in the given
  * \a format. This function should only be used for base64 encoding, with or
  * without compression.
+ *
+ * When \a ok is given, it is set to false when compression failed.
  */
 QByteArray GidMapper::encodeLayerData(const TileLayer &tileLayer,
-                                      Map::LayerDataFormat format) const
+                                      Map::LayerDataFormat format,
+                                      bool *ok) const
+{
+    QByteArray tileData;
+
+    const bool encoded = encodeLayerData(tileLayer, format, [&] (const char *data, int length) {
+        tileData.append(data, length);
+    });
+
+    if (ok)
+        *ok = encoded;
+
+    return tileData;
+}
+
+/**
+ * Encodes the tile layer data of the given \a tileLayer in the given
+ * \a format, passing the base64 encoded text on to the \a sink as it
+ * becomes available. Only a single row of the layer is kept in memory
+ * before being compressed and encoded.
+ *
+ * Returns false when compression failed.
+ */
+bool GidMapper::encodeLayerData(const TileLayer &tileLayer,
+                                Map::LayerDataFormat format,
+                                const CompressionSink &sink) const
 {
     Q_ASSERT(format != Map::XML);
     Q_ASSERT(format != Map::CSV);
 
-    QByteArray tileData;
-    tileData.reserve(tileLayer.height() * tileLayer.width() * 4);
-
-    for (int y = 0; y < tileLayer.height(); ++y) {
-        for (int x = 0; x < tileLayer.width(); ++x) {
-            const unsigned gid = cellToGid(tileLayer.cellAt(x, y));
-            tileData.append((char) (gid));
-            tileData.append((char) (gid >> 8));
-            tileData.append((char) (gid >> 16));
-            tileData.append((char) (gid >> 24));
+    TraceScope trace("GidMapper::encodeLayerData", tileLayer.name());
+
+    const int width = tileLayer.width();
+    const int height = tileLayer.height();
+
+    Base64Encoder base64(sink);
+    const CompressionSink encodeSink = [&] (const char *data, int length) {
+        base64.write(data, length);
+    };
+
+    CompressionMethod method;
+    const bool compressed = compressionMethod(format, method);
+
+    // Zstandard and LZ4 compress the whole layer at once
+    const bool streaming = !compressed || method == Gzip || method == Zlib;
+    QByteArray layerData;
+
+    QScopedPointer<Compressor> compressor;
+    if (compressed && streaming) {
+        compressor.reset(new Compressor(method, encodeSink));
+    } else if (!streaming) {
+        if (!compressionSupported(method))
+            return false;
+        layerData.reserve(width * height * 4);
+    }
+
+    QByteArray rowData(width * 4, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar*>(rowData.data());
+    QVector<unsigned> gids(width);
+
+    for (int y = 0; y < height; ++y) {
+        cellsToGids(tileLayer, y, gids.data());
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        memcpy(out, gids.constData(), width * 4);
+#else
+        for (int x = 0; x < width; ++x)
+            qToLittleEndian<quint32>(gids.at(x), out + x * 4);
+#endif
+
+        if (compressor) {
+            if (!compressor->write(rowData.constData(), rowData.size()))
+                return false;
+        } else if (!streaming) {
+            layerData.append(rowData);
+        } else {
+            encodeSink(rowData.constData(), rowData.size());
         }
     }
 
-    if (format == Map::Base64Gzip)
-        tileData = compress(tileData, Gzip);
-    else if (format == Map::Base64Zlib)
-        tileData = compress(tileData, Zlib);
+    if (compressor && !compressor->finish())
+        return false;
+
+    if (!streaming) {
+        const QByteArray compressedData = compress(layerData, method);
+        if (compressedData.isNull())
+            return false;
+        encodeSink(compressedData.constData(), compressedData.size());
+    }
 
-    return tileData.toBase64();
+    base64.finish();
+    return true;
 }
 
 GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
@@ -193,38 +582,137 @@ GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
     Q_ASSERT(format != Map::XML);
     Q_ASSERT(format != Map::CSV);
 
-    QByteArray decodedData = QByteArray::fromBase64(layerData);
-    const int size = (tileLayer.width() * tileLayer.height()) * 4;
+    TraceScope trace("GidMapper::decodeLayerData", tileLayer.name());
+    TileLayer::BulkEdit bulkEdit(&tileLayer);
 
-    if (format == Map::Base64Gzip || format == Map::Base64Zlib)
-        decodedData = decompress(decodedData, size);
+    const int width = tileLayer.width();
+    const int size = (width * tileLayer.height()) * 4;
 
-    if (size != decodedData.length())
-        return CorruptLayerData;
-
-    const unsigned char *data = reinterpret_cast<const unsigned char*>(decodedData.constData());
+    DecodeError error = NoError;
+    int received = 0;
     int x = 0;
     int y = 0;
-    bool ok;
-
-    for (int i = 0; i < size - 3; i += 4) {
-        const unsigned gid = data[i] |
-                             data[i + 1] << 8 |
-                             data[i + 2] << 16 |
-                             data[i + 3] << 24;
-
-        const Cell result = gidToCell(gid, ok);
-        if (!ok) {
-            mInvalidTile = gid;
-            return isEmpty() ? TileButNoTilesets : InvalidTile;
-        }
 
-        tileLayer.setCell(x, y, result);
+    // Gids may be split over two blocks of decoded data
+    uchar partial[4];
+    int partialLength = 0;
+
+    auto decodeGid = [&] (const uchar *data) {
+        const unsigned gid = qFromLittleEndian<quint32>(data);
+
+        // Empty cells don't need to be set on a new layer
+        if (gid != 0 || !tileLayer.cellAt(x, y).isEmpty()) {
+            bool ok;
+            const Cell result = gidToCell(gid, ok);
+            if (!ok) {
+                mInvalidTile = gid;
+                error = isEmpty() ? TileButNoTilesets : InvalidTile;
+                return;
+            }
+
+            tileLayer.setCell(x, y, result);
+        }
 
-        x++;
-        if (x == tileLayer.width()) {
+        if (++x == width) {
             x = 0;
-            y++;
+            ++y;
+        }
+    };
+
+    const CompressionSink cellSink = [&] (const char *data, int length) {
+        if (error != NoError)
+            return;
+
+        if (received + length > size) {
+            error = CorruptLayerData;
+            return;
+        }
+
+        received += length;
+
+        const uchar *bytes = reinterpret_cast<const uchar*>(data);
+        const uchar *end = bytes + length;
+
+        while (partialLength > 0 && bytes != end) {
+            partial[partialLength++] = *bytes++;
+            if (partialLength == 4) {
+                partialLength = 0;
+                decodeGid(partial);
+                if (error != NoError)
+                    return;
+            }
+        }
+
+        for (; end - bytes >= 4; bytes += 4) {
+            decodeGid(bytes);
+            if (error != NoError)
+                return;
+        }
+
+        while (bytes != end)
+            partial[partialLength++] = *bytes++;
+    };
+
+    if (!decodeLayerBytes(layerData, format, size, cellSink))
+        return CorruptLayerData;
+
+    if (error == NoError && received != size)
+        return CorruptLayerData;
+
+    return error;
+}
+
+/**
+ * Returns whether the given \a layerData decodes to exactly one gid for each
+ * of the \a cellCount cells of a layer. This is much cheaper than decoding
+ * the data, but gids that don't refer to a tile are only found by
+ * decodeLayerData().
+ */
+bool GidMapper::isLayerDataComplete(const QByteArray &layerData,
+                                    Map::LayerDataFormat format,
+                                    int cellCount)
+{
+    Q_ASSERT(format != Map::XML);
+    Q_ASSERT(format != Map::CSV);
+
+    const int size = cellCount * 4;
+    int received = 0;
+
+    const bool ok = decodeLayerBytes(layerData, format, size,
+                                     [&] (const char *, int length) {
+        received += length;
+    });
+
+    return ok && received == size;
+}
+
+/**
+ * Decodes the uncompressed little-endian \a gids of the given \a tileLayer.
+ * The data is expected to contain one gid for each cell of the layer.
+ */
+GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
+                                                  const uchar *gids) const
+{
+    TraceScope trace("GidMapper::decodeLayerData", tileLayer.name());
+    TileLayer::BulkEdit bulkEdit(&tileLayer);
+
+    const int width = tileLayer.width();
+    const int height = tileLayer.height();
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x, gids += 4) {
+            const unsigned gid = qFromLittleEndian<quint32>(gids);
+            if (gid == 0)
+                continue;
+
+            bool ok;
+            const Cell result = gidToCell(gid, ok);
+            if (!ok) {
+                mInvalidTile = gid;
+                return isEmpty() ? TileButNoTilesets : InvalidTile;
+            }
+
+            tileLayer.setCell(x, y, result);
         }
     }
 
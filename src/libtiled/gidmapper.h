@@ -29,21 +29,32 @@
 #ifndef TILED_GIDMAPPER_H
 #define TILED_GIDMAPPER_H
 
+#include "compression.h"
 #include "map.h"
 #include "tilelayer.h"
 
-#include <QMap>
+#include <QHash>
+#include <QVector>
 
 namespace Tiled {
 
 /**
  * A class that maps cells to global IDs (gids) and back.
+ *
+ * The table used for looking up gids is built on the first lookup after
+ * tilesets have been inserted. Copies of a gid mapper share the table, so it
+ * is built before copying. A gid mapper can only be used from multiple
+ * threads at once after its table has been built, so threads should use
+ * their own copy.
  */
 class TILEDSHARED_EXPORT GidMapper
 {
 public:
     GidMapper();
     GidMapper(const QVector<SharedTileset> &tilesets);
+    GidMapper(const GidMapper &other);
+
+    GidMapper &operator=(const GidMapper &other);
 
     void insert(unsigned firstGid, Tileset *tileset);
     void clear();
@@ -54,8 +65,15 @@ public:
 
     void setTilesetWidth(const Tileset *tileset, int width);
 
+    void cellsToGids(const TileLayer &tileLayer, int y, unsigned *gids) const;
+
     QByteArray encodeLayerData(const TileLayer &tileLayer,
-                               Map::LayerDataFormat format) const;
+                               Map::LayerDataFormat format,
+                               bool *ok = nullptr) const;
+
+    bool encodeLayerData(const TileLayer &tileLayer,
+                         Map::LayerDataFormat format,
+                         const CompressionSink &sink) const;
 
     enum DecodeError {
         NoError = 0,
@@ -68,38 +86,44 @@ public:
                                 const QByteArray &layerData,
                                 Map::LayerDataFormat format) const;
 
+    DecodeError decodeLayerData(TileLayer &tileLayer,
+                                const uchar *gids) const;
+
+    static bool isLayerDataComplete(const QByteArray &layerData,
+                                    Map::LayerDataFormat format,
+                                    int cellCount);
+
     unsigned invalidTile() const;
 
 private:
-    QMap<unsigned, Tileset*> mFirstGidToTileset;
-    QMap<const Tileset*, int> mTilesetColumnCounts;
+    struct TilesetEntry {
+        unsigned firstGid;
+        Tileset *tileset;
+        int columnCount;    // the column count when the map was saved
+    };
 
-    mutable unsigned mInvalidTile;
-};
+    const TilesetEntry *findEntry(unsigned gid) const;
+    void rebuildGidTable() const;
 
+    // Sorted by first gid
+    QVector<TilesetEntry> mTilesets;
+    QHash<const Tileset*, unsigned> mTilesetToFirstGid;
+    QHash<const Tileset*, int> mTilesetColumnCounts;
 
-/**
- * Insert the given \a tileset with \a firstGid as its first global ID.
- */
-inline void GidMapper::insert(unsigned firstGid, Tileset *tileset)
-{
-    mFirstGidToTileset.insert(firstGid, tileset);
-}
+    // Maps each gid directly to the index + 1 of its tileset entry
+    mutable QVector<quint16> mGidTable;
+    mutable bool mGidTableDirty;
+
+    mutable unsigned mInvalidTile;
+};
 
-/**
- * Clears the gid mapper, so that it can be reused.
- */
-inline void GidMapper::clear()
-{
-    mFirstGidToTileset.clear();
-}
 
 /**
  * Returns true when no tilesets are known to this gid mapper.
  */
 inline bool GidMapper::isEmpty() const
 {
-    return mFirstGidToTileset.isEmpty();
+    return mTilesets.isEmpty();
 }
 
 /**
@@ -63,6 +63,49 @@ HexagonalRenderer::RenderParams::RenderParams(const Map *map)
     rowHeight = sideOffsetY + sideLengthY;
 }
 
+/**
+ * Returns the screen position of the top-left corner of the bounding box of
+ * the tile at \a x, \a y.
+ */
+QPoint HexagonalRenderer::RenderParams::tileToScreenCoords(int x, int y) const
+{
+    int pixelX, pixelY;
+
+    if (staggerX) {
+        pixelY = y * (tileHeight + sideLengthY);
+        if (doStaggerX(x))
+            pixelY += rowHeight;
+
+        pixelX = x * columnWidth;
+    } else {
+        pixelX = x * (tileWidth + sideLengthX);
+        if (doStaggerY(y))
+            pixelX += columnWidth;
+
+        pixelY = y * rowHeight;
+    }
+
+    return QPoint(pixelX, pixelY);
+}
+
+/**
+ * Returns the shape of a tile, relative to the top-left corner of its
+ * bounding box.
+ */
+QPolygonF HexagonalRenderer::RenderParams::tilePolygon() const
+{
+    QPolygonF polygon(8);
+    polygon[0] = QPoint(0,                       tileHeight - sideOffsetY);
+    polygon[1] = QPoint(0,                       sideOffsetY);
+    polygon[2] = QPoint(sideOffsetX,             0);
+    polygon[3] = QPoint(tileWidth - sideOffsetX, 0);
+    polygon[4] = QPoint(tileWidth,               sideOffsetY);
+    polygon[5] = QPoint(tileWidth,               tileHeight - sideOffsetY);
+    polygon[6] = QPoint(tileWidth - sideOffsetX, tileHeight);
+    polygon[7] = QPoint(sideOffsetX,             tileHeight);
+    return polygon;
+}
+
 
 QSize HexagonalRenderer::mapSize() const
 {
@@ -118,6 +161,21 @@ QRect HexagonalRenderer::boundingRect(const QRect &rect) const
     return QRect(topLeft.x(), topLeft.y(), width, height);
 }
 
+QPainterPath HexagonalRenderer::tileRegionShape(const QRegion &region) const
+{
+    const RenderParams p(map());
+    const QPolygonF tilePolygon = p.tilePolygon();
+
+    QPainterPath path;
+    foreach (const QRect &r, region.rects()) {
+        for (int y = r.top(); y <= r.bottom(); ++y)
+            for (int x = r.left(); x <= r.right(); ++x)
+                path.addPolygon(tilePolygon.translated(p.tileToScreenCoords(x, y)));
+    }
+
+    return path.simplified();
+}
+
 void HexagonalRenderer::drawGrid(QPainter *painter, const QRectF &exposed,
                                  QColor gridColor) const
 {
@@ -160,8 +218,8 @@ void HexagonalRenderer::drawGrid(QPainter *painter, const QRectF &exposed,
         QPoint(p.sideOffsetX,               p.tileHeight)
     };
 
+    // The lines are drawn one column or row of tiles at a time
     QVector<QLine> lines;
-    lines.reserve(8);
 
     gridColor.setAlpha(128);
 
@@ -200,12 +258,12 @@ void HexagonalRenderer::drawGrid(QPainter *painter, const QRectF &exposed,
                 if (bottomLeft)
                     lines.append(QLine(rowPos + oct[7], rowPos + oct[0]));
 
-                painter->drawLines(lines);
-                lines.resize(0);
-
                 rowPos.ry() += p.tileHeight + p.sideLengthY;
             }
 
+            painter->drawLines(lines);
+            lines.resize(0);
+
             startPos.rx() += p.columnWidth;
         }
     } else {
@@ -238,12 +296,12 @@ void HexagonalRenderer::drawGrid(QPainter *painter, const QRectF &exposed,
                 if (bottomLeft)
                     lines.append(QLine(rowPos + oct[7], rowPos + oct[0]));
 
-                painter->drawLines(lines);
-                lines.resize(0);
-
                 rowPos.rx() += p.tileWidth + p.sideLengthX;
             }
 
+            painter->drawLines(lines);
+            lines.resize(0);
+
             startPos.ry() += p.rowHeight;
         }
     }
@@ -254,11 +312,12 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
                                       const QRectF &exposed) const
 {
     const RenderParams p(map());
+    const QRect bounds = layer->cellBounds();
 
     QRect rect = exposed.toAlignedRect();
 
     if (rect.isNull())
-        rect = boundingRect(layer->bounds());
+        rect = boundingRect(bounds.translated(layer->position()));
 
     QMargins drawMargins = layer->drawMargins();
     drawMargins.setBottom(drawMargins.bottom() + p.tileHeight);
@@ -290,30 +349,39 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
     if (inLeftHalf)
         startTile.rx()--;
 
-    CellRenderer renderer(painter);
+    CellRenderer renderer(painter, flags(), images());
 
     if (p.staggerX) {
-        startTile.setX(qMax(-1, startTile.x()));
-        startTile.setY(qMax(-1, startTile.y()));
+        startTile.setX(qMax(bounds.left() - 1, startTile.x()));
+        startTile.setY(qMax(bounds.top() - 1, startTile.y()));
 
         startPos = tileToScreenCoords(startTile + layer->position()).toPoint();
         startPos.ry() += p.tileHeight;
 
         bool staggeredRow = p.doStaggerX(startTile.x() + layer->x());
 
-        for (; startPos.y() < rect.bottom() && startTile.y() < layer->height();) {
+        for (; startPos.y() < rect.bottom() && startTile.y() <= bounds.bottom();) {
             QPoint rowTile = startTile;
             QPoint rowPos = startPos;
 
-            for (; rowPos.x() < rect.right() && rowTile.x() < layer->width(); rowTile.rx() += 2) {
-                if (layer->contains(rowTile)) {
-                    const Cell &cell = layer->cellAt(rowTile);
+            while (rowPos.x() < rect.right() && rowTile.x() <= bounds.right()) {
+                int steps = 1;
 
-                    if (!cell.isEmpty())
-                        renderer.render(cell, rowPos, QSizeF(0, 0), CellRenderer::BottomLeft);
+                if (bounds.contains(rowTile)) {
+                    if (const Chunk *chunk = layer->findChunk(rowTile.x(), rowTile.y())) {
+                        const Cell &cell = chunk->cellAt(rowTile.x() & CHUNK_MASK,
+                                                         rowTile.y() & CHUNK_MASK);
+
+                        if (!cell.isEmpty())
+                            renderer.render(cell, rowPos, QSizeF(0, 0), CellRenderer::BottomLeft);
+                    } else {
+                        // Skip the remaining columns of this row in the empty chunk
+                        steps = (CHUNK_SIZE - (rowTile.x() & CHUNK_MASK) + 1) / 2;
+                    }
                 }
 
-                rowPos.rx() += p.tileWidth + p.sideLengthX;
+                rowTile.rx() += 2 * steps;
+                rowPos.rx() += (p.tileWidth + p.sideLengthX) * steps;
             }
 
             if (staggeredRow) {
@@ -330,8 +398,8 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
             startPos.ry() += p.rowHeight;
         }
     } else {
-        startTile.setX(qMax(0, startTile.x()));
-        startTile.setY(qMax(0, startTile.y()));
+        startTile.setX(qMax(bounds.left(), startTile.x()));
+        startTile.setY(qMax(bounds.top(), startTile.y()));
 
         startPos = tileToScreenCoords(startTile + layer->position()).toPoint();
         startPos.ry() += p.tileHeight;
@@ -340,20 +408,29 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
         if (p.doStaggerY(startTile.y() + layer->y()))
             startPos.rx() -= p.columnWidth;
 
-        for (; startPos.y() < rect.bottom() && startTile.y() < layer->height(); startTile.ry()++) {
+        for (; startPos.y() < rect.bottom() && startTile.y() <= bounds.bottom(); startTile.ry()++) {
             QPoint rowTile = startTile;
             QPoint rowPos = startPos;
 
             if (p.doStaggerY(startTile.y() + layer->y()))
                 rowPos.rx() += p.columnWidth;
 
-            for (; rowPos.x() < rect.right() && rowTile.x() < layer->width(); rowTile.rx()++) {
-                const Cell &cell = layer->cellAt(rowTile);
+            while (rowPos.x() < rect.right() && rowTile.x() <= bounds.right()) {
+                int steps = 1;
 
-                if (!cell.isEmpty())
-                    renderer.render(cell, rowPos, QSizeF(0, 0), CellRenderer::BottomLeft);
+                if (const Chunk *chunk = layer->findChunk(rowTile.x(), rowTile.y())) {
+                    const Cell &cell = chunk->cellAt(rowTile.x() & CHUNK_MASK,
+                                                     rowTile.y() & CHUNK_MASK);
 
-                rowPos.rx() += p.tileWidth + p.sideLengthX;
+                    if (!cell.isEmpty())
+                        renderer.render(cell, rowPos, QSizeF(0, 0), CellRenderer::BottomLeft);
+                } else {
+                    // Skip the remaining columns of this row in the empty chunk
+                    steps = CHUNK_SIZE - (rowTile.x() & CHUNK_MASK);
+                }
+
+                rowTile.rx() += steps;
+                rowPos.rx() += (p.tileWidth + p.sideLengthX) * steps;
             }
 
             startPos.ry() += p.rowHeight;
@@ -366,18 +443,25 @@ void HexagonalRenderer::drawTileSelection(QPainter *painter,
                                           const QColor &color,
                                           const QRectF &exposed) const
 {
-    painter->setBrush(color);
-    painter->setPen(Qt::NoPen);
+    const RenderParams p(map());
+    const QPolygonF tilePolygon = p.tilePolygon();
+    const QRectF tileBounds = tilePolygon.boundingRect();
+
+    // The tiles don't overlap, so they can be filled as a single path
+    QPainterPath path;
+    path.setFillRule(Qt::WindingFill);
 
     foreach (const QRect &r, region.rects()) {
         for (int y = r.top(); y <= r.bottom(); ++y) {
             for (int x = r.left(); x <= r.right(); ++x) {
-                const QPolygonF polygon = tileToScreenPolygon(x, y);
-                if (QRectF(polygon.boundingRect()).intersects(exposed))
-                    painter->drawConvexPolygon(polygon);
+                const QPoint pos = p.tileToScreenCoords(x, y);
+                if (tileBounds.translated(pos).intersects(exposed))
+                    path.addPolygon(tilePolygon.translated(pos));
             }
         }
     }
+
+    painter->fillPath(path, color);
 }
 
 QPointF HexagonalRenderer::tileToPixelCoords(qreal x, qreal y) const
@@ -417,7 +501,32 @@ QPointF HexagonalRenderer::screenToTileCoords(qreal x, qreal y) const
     if (p.staggerEven)
         ++staggerAxisIndex;
 
-    // Determine the nearest hexagon tile by the distance to the center
+    const int nearest = pickTile(p, rel.x(), rel.y(), pickNearestHexagon);
+
+    static const QPoint offsetsStaggerX[4] = {
+        QPoint( 0,  0),
+        QPoint(+1, -1),
+        QPoint(+1,  0),
+        QPoint(+2,  0),
+    };
+    static const QPoint offsetsStaggerY[4] = {
+        QPoint( 0,  0),
+        QPoint(-1, +1),
+        QPoint( 0, +1),
+        QPoint( 0, +2),
+    };
+
+    const QPoint *offsets = p.staggerX ? offsetsStaggerX : offsetsStaggerY;
+    return referencePoint + offsets[nearest];
+}
+
+/**
+ * Determines the nearest of the four hexagons overlapping the base square of
+ * a grid-aligned tile by the distance to their center.
+ */
+int HexagonalRenderer::pickNearestHexagon(const RenderParams &p, qreal x, qreal y)
+{
+    const QVector2D rel(x, y);
     QVector2D centers[4];
 
     if (p.staggerX) {
@@ -452,49 +561,103 @@ QPointF HexagonalRenderer::screenToTileCoords(qreal x, qreal y) const
         }
     }
 
-    static const QPoint offsetsStaggerX[4] = {
-        QPoint( 0,  0),
-        QPoint(+1, -1),
-        QPoint(+1,  0),
-        QPoint(+2,  0),
-    };
-    static const QPoint offsetsStaggerY[4] = {
-        QPoint( 0,  0),
-        QPoint(-1, +1),
-        QPoint( 0, +1),
-        QPoint( 0, +2),
-    };
+    return nearest;
+}
 
-    const QPoint *offsets = p.staggerX ? offsetsStaggerX : offsetsStaggerY;
-    return referencePoint + offsets[nearest];
+/**
+ * Picks the tile at \a x, \a y relative to the base square of a grid-aligned
+ * tile. Most positions are looked up in a mask that is computed once for the
+ * current tile size, only positions near the edge between two tiles are
+ * passed on to the \a pick function.
+ */
+int HexagonalRenderer::pickTile(const RenderParams &p, qreal x, qreal y,
+                                PickFunction pick) const
+{
+    if (!mPickingMask.matches(p, pick))
+        updatePickingMask(p, pick);
+
+    const int maskX = qFloor(x);
+    const int maskY = qFloor(y);
+
+    if (maskX >= 0 && maskY >= 0 &&
+            maskX < mPickingMask.width && maskY < mPickingMask.height) {
+        const int region = mPickingMask.regions.at(maskY * mPickingMask.width + maskX);
+        if (region != PickingMask::Ambiguous)
+            return region;
+    }
+
+    return pick(p, x, y);
+}
+
+bool HexagonalRenderer::PickingMask::matches(const RenderParams &p,
+                                             PickFunction pickFunction) const
+{
+    return pick == pickFunction &&
+            width == p.tileWidth + p.sideLengthX &&
+            height == p.tileHeight + p.sideLengthY &&
+            sideLengthX == p.sideLengthX &&
+            sideLengthY == p.sideLengthY &&
+            staggerX == p.staggerX &&
+            staggerEven == p.staggerEven;
 }
 
 /**
- * Converts tile to screen coordinates. Sub-tile return values are not
- * supported by this renderer.
+ * Computes the picking mask for the tile size and stagger settings in \a p.
+ *
+ * The tiles are convex, so a pixel belongs entirely to one tile when its
+ * corners and its center are all picked as that tile.
  */
-QPointF HexagonalRenderer::tileToScreenCoords(qreal x, qreal y) const
+void HexagonalRenderer::updatePickingMask(const RenderParams &p,
+                                          PickFunction pick) const
 {
-    const RenderParams p(map());
-    const int tileX = qFloor(x);
-    const int tileY = qFloor(y);
-    int pixelX, pixelY;
+    PickingMask &mask = mPickingMask;
+    mask.width = p.tileWidth + p.sideLengthX;
+    mask.height = p.tileHeight + p.sideLengthY;
+    mask.sideLengthX = p.sideLengthX;
+    mask.sideLengthY = p.sideLengthY;
+    mask.staggerX = p.staggerX;
+    mask.staggerEven = p.staggerEven;
+    mask.pick = pick;
+    mask.regions.clear();
+
+    // Don't bother for degenerate or huge tiles, which are always picked
+    // using the pick function
+    if (mask.width <= 0 || mask.height <= 0 || mask.width * mask.height > 1 << 20) {
+        mask.width = 0;
+        mask.height = 0;
+        return;
+    }
 
-    if (p.staggerX) {
-        pixelY = tileY * (p.tileHeight + p.sideLengthY);
-        if (p.doStaggerX(tileX))
-            pixelY += p.rowHeight;
+    const int cornersWidth = mask.width + 1;
+    QVector<quint8> corners(cornersWidth * (mask.height + 1));
+    for (int y = 0; y <= mask.height; ++y)
+        for (int x = 0; x <= mask.width; ++x)
+            corners[y * cornersWidth + x] = pick(p, x, y);
 
-        pixelX = tileX * p.columnWidth;
-    } else {
-        pixelX = tileX * (p.tileWidth + p.sideLengthX);
-        if (p.doStaggerY(tileY))
-            pixelX += p.columnWidth;
+    mask.regions.resize(mask.width * mask.height);
+    for (int y = 0; y < mask.height; ++y) {
+        for (int x = 0; x < mask.width; ++x) {
+            const quint8 *row = corners.constData() + y * cornersWidth + x;
+            const quint8 region = row[0];
+
+            const bool solid = row[1] == region &&
+                    row[cornersWidth] == region &&
+                    row[cornersWidth + 1] == region &&
+                    pick(p, x + 0.5, y + 0.5) == region;
 
-        pixelY = tileY * p.rowHeight;
+            mask.regions[y * mask.width + x] = solid ? region : quint8(PickingMask::Ambiguous);
+        }
     }
+}
 
-    return QPointF(pixelX, pixelY);
+/**
+ * Converts tile to screen coordinates. Sub-tile return values are not
+ * supported by this renderer.
+ */
+QPointF HexagonalRenderer::tileToScreenCoords(qreal x, qreal y) const
+{
+    const RenderParams p(map());
+    return p.tileToScreenCoords(qFloor(x), qFloor(y));
 }
 
 QPoint HexagonalRenderer::topLeft(int x, int y) const
@@ -560,16 +723,5 @@ QPoint HexagonalRenderer::bottomRight(int x, int y) const
 QPolygonF HexagonalRenderer::tileToScreenPolygon(int x, int y) const
 {
     const RenderParams p(map());
-    const QPointF topRight = tileToScreenCoords(x, y);
-
-    QPolygonF polygon(8);
-    polygon[0] = topRight + QPoint(0,                           p.tileHeight - p.sideOffsetY);
-    polygon[1] = topRight + QPoint(0,                           p.sideOffsetY);
-    polygon[2] = topRight + QPoint(p.sideOffsetX,               0);
-    polygon[3] = topRight + QPoint(p.tileWidth - p.sideOffsetX, 0);
-    polygon[4] = topRight + QPoint(p.tileWidth,                 p.sideOffsetY);
-    polygon[5] = topRight + QPoint(p.tileWidth,                 p.tileHeight - p.sideOffsetY);
-    polygon[6] = topRight + QPoint(p.tileWidth - p.sideOffsetX, p.tileHeight);
-    polygon[7] = topRight + QPoint(p.sideOffsetX,               p.tileHeight);
-    return polygon;
+    return p.tilePolygon().translated(p.tileToScreenCoords(x, y));
 }
@@ -31,6 +31,8 @@
 
 #include "orthogonalrenderer.h"
 
+#include <QVector>
+
 namespace Tiled {
 
 /**
@@ -55,6 +57,9 @@ protected:
         bool doStaggerY(int y) const
         { return !staggerX && (y & 1) ^ staggerEven; }
 
+        QPoint tileToScreenCoords(int x, int y) const;
+        QPolygonF tilePolygon() const;
+
         const int tileWidth;
         const int tileHeight;
         int sideLengthX;
@@ -67,13 +72,25 @@ protected:
         const bool staggerEven;
     };
 
+    /**
+     * Determines which of the tiles overlapping the base square of a
+     * grid-aligned tile is at the position \a x, \a y relative to that square.
+     */
+    typedef int (*PickFunction)(const RenderParams &p, qreal x, qreal y);
+
+    int pickTile(const RenderParams &p, qreal x, qreal y,
+                 PickFunction pick) const;
+
 public:
     HexagonalRenderer(const Map *map) : OrthogonalRenderer(map) {}
 
     QSize mapSize() const override;
 
+    using MapRenderer::boundingRect;
     QRect boundingRect(const QRect &rect) const override;
 
+    QPainterPath tileRegionShape(const QRegion &region) const override;
+
     void drawGrid(QPainter *painter, const QRectF &exposed,
                   QColor gridColor) const override;
 
@@ -104,6 +121,44 @@ public:
     QPoint bottomRight(int x, int y) const;
 
     QPolygonF tileToScreenPolygon(int x, int y) const;
+
+private:
+    static int pickNearestHexagon(const RenderParams &p, qreal x, qreal y);
+
+    /**
+     * Stores for each pixel of the base square of a grid-aligned tile the
+     * result of the pick function, or Ambiguous when the pixel is crossed by
+     * the edge between two tiles.
+     */
+    struct PickingMask
+    {
+        enum { Ambiguous = 0xFF };
+
+        PickingMask()
+            : width(0)
+            , height(0)
+            , sideLengthX(0)
+            , sideLengthY(0)
+            , staggerX(false)
+            , staggerEven(false)
+            , pick(nullptr)
+        {}
+
+        bool matches(const RenderParams &p, PickFunction pickFunction) const;
+
+        int width;
+        int height;
+        int sideLengthX;
+        int sideLengthY;
+        bool staggerX;
+        bool staggerEven;
+        PickFunction pick;
+        QVector<quint8> regions;
+    };
+
+    void updatePickingMask(const RenderParams &p, PickFunction pick) const;
+
+    mutable PickingMask mPickingMask;
 };
 
 } // namespace Tiled
@@ -0,0 +1,245 @@
+/*
+ * imagecache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "imagecache.h"
+
+#include "cachedirectory.h"
+
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QVector>
+#include <QtEndian>
+
+#include <cstring>
+
+using namespace Tiled;
+
+namespace {
+
+const char CacheMagic[4] = { 'T', 'I', 'M', 'C' };
+const quint32 CacheVersion = 1;
+
+// magic, version, file size, modification time, width, height and format
+const int HeaderSize = 4 + 4 + 8 + 8 + 4 + 4 + 4;
+
+const char CacheDirectoryName[] = "images";
+
+QAtomicInt cacheEnabled(0);
+QAtomicInt cacheSizeLimit(512);
+
+template<typename T>
+void append(QByteArray &out, T value)
+{
+    uchar buffer[sizeof(T)];
+    qToLittleEndian<T>(value, buffer);
+    out.append(reinterpret_cast<const char*>(buffer), sizeof(T));
+}
+
+template<typename T>
+T take(const uchar *&data)
+{
+    const T value = qFromLittleEndian<T>(data);
+    data += sizeof(T);
+    return value;
+}
+
+/**
+ * Returns the format in which \a image is cached. Opaque images keep their
+ * alpha channel out of the cache, others are premultiplied since that is
+ * the format pixmaps are created from.
+ */
+QImage::Format cachedFormat(const QImage &image)
+{
+    if (image.format() == QImage::Format_RGB32)
+        return QImage::Format_RGB32;
+    return QImage::Format_ARGB32_Premultiplied;
+}
+
+} // anonymous namespace
+
+/**
+ * Loads the image stored at \a fileName. Returns the cached pixels when the
+ * cache is up to date with the image file. Otherwise the image is decoded,
+ * and cached when it is large enough for the cache to pay off.
+ *
+ * The image may be returned in a different format than the one it was
+ * stored in, but always one that QPixmap::fromImage() handles without
+ * another conversion.
+ */
+QImage ImageCache::loadImage(const QString &fileName)
+{
+    const QFileInfo fileInfo(fileName);
+    if (!isEnabled() || !fileInfo.isFile())
+        return QImage(fileName);
+
+    const qint64 fileSize = fileInfo.size();
+    const qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+    const QString cacheFile = cacheFileName(fileName);
+
+    QImage image = read(cacheFile, fileSize, lastModified);
+    if (!image.isNull())
+        return image;
+
+    image = QImage(fileName);
+    if (image.isNull() ||
+            qint64(image.width()) * image.height() < minimumPixelCount())
+        return image;
+
+    image = image.convertToFormat(cachedFormat(image));
+    write(cacheFile, fileSize, lastModified, image);
+    return image;
+}
+
+void ImageCache::setEnabled(bool enabled)
+{
+    cacheEnabled.storeRelease(enabled);
+}
+
+bool ImageCache::isEnabled()
+{
+    return cacheEnabled.loadAcquire();
+}
+
+void ImageCache::setSizeLimit(int megabytes)
+{
+    cacheSizeLimit.storeRelease(megabytes);
+}
+
+int ImageCache::sizeLimit()
+{
+    return cacheSizeLimit.loadAcquire();
+}
+
+/**
+ * Returns the name of the cache file used for the image at
+ * \a imageFileName.
+ */
+QString ImageCache::cacheFileName(const QString &imageFileName)
+{
+    return CacheDirectory::cacheFileName(QLatin1String(CacheDirectoryName),
+                                         imageFileName);
+}
+
+QImage ImageCache::read(const QString &cacheFileName,
+                        qint64 fileSize, qint64 lastModified)
+{
+    QFile file(cacheFileName);
+    if (!file.open(QFile::ReadOnly))
+        return QImage();
+
+    const qint64 size = file.size();
+    const uchar *data = size >= HeaderSize ? file.map(0, size) : nullptr;
+    if (!data)
+        return QImage();
+
+    const uchar *p = data;
+    bool valid = memcmp(p, CacheMagic, sizeof(CacheMagic)) == 0;
+    p += sizeof(CacheMagic);
+
+    valid = valid && take<quint32>(p) == CacheVersion;
+    valid = valid && take<qint64>(p) == fileSize;
+    valid = valid && take<qint64>(p) == lastModified;
+
+    const quint32 width = take<quint32>(p);
+    const quint32 height = take<quint32>(p);
+    const quint32 format = take<quint32>(p);
+
+    valid = valid && width > 0 && height > 0 && width <= 0x7fff && height <= 0x7fff;
+    valid = valid && (format == QImage::Format_RGB32 ||
+                      format == QImage::Format_ARGB32_Premultiplied);
+    valid = valid && HeaderSize + qint64(width) * height * 4 == size;
+
+    QImage image;
+    if (valid)
+        image = QImage(width, height, static_cast<QImage::Format>(format));
+
+    if (!image.isNull()) {
+        const size_t rowSize = size_t(width) * 4;
+        for (quint32 y = 0; y < height; ++y, p += rowSize) {
+            uchar *row = image.scanLine(y);
+            std::memcpy(row, p, rowSize);
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+            quint32 *pixels = reinterpret_cast<quint32*>(row);
+            for (quint32 x = 0; x < width; ++x)
+                pixels[x] = qFromLittleEndian<quint32>(pixels[x]);
+#endif
+        }
+    }
+
+    file.unmap(const_cast<uchar*>(data));
+    return image;
+}
+
+bool ImageCache::write(const QString &cacheFileName,
+                       qint64 fileSize, qint64 lastModified,
+                       const QImage &image)
+{
+    QByteArray header;
+    header.append(CacheMagic, sizeof(CacheMagic));
+    append<quint32>(header, CacheVersion);
+    append<qint64>(header, fileSize);
+    append<qint64>(header, lastModified);
+    append<quint32>(header, image.width());
+    append<quint32>(header, image.height());
+    append<quint32>(header, image.format());
+
+    if (!QDir().mkpath(QFileInfo(cacheFileName).absolutePath()))
+        return false;
+
+    // Atomic, so that images loaded in parallel don't see partial caches
+    QSaveFile file(cacheFileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(header);
+
+    const int width = image.width();
+
+    for (int y = 0; y < image.height(); ++y) {
+        const char *row = reinterpret_cast<const char*>(image.constScanLine(y));
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+        QVector<quint32> pixels(width);
+        const quint32 *source = reinterpret_cast<const quint32*>(row);
+        for (int x = 0; x < width; ++x)
+            pixels[x] = qToLittleEndian<quint32>(source[x]);
+        row = reinterpret_cast<const char*>(pixels.constData());
+#endif
+        file.write(row, width * 4);
+    }
+
+    if (!file.commit())
+        return false;
+
+    CacheDirectory::trim(QLatin1String(CacheDirectoryName),
+                         qint64(sizeLimit()) * 1024 * 1024);
+    return true;
+}
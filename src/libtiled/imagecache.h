@@ -0,0 +1,93 @@
+/*
+ * imagecache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_IMAGECACHE_H
+#define TILED_IMAGECACHE_H
+
+#include "tiled_global.h"
+
+#include <QImage>
+#include <QString>
+
+namespace Tiled {
+
+/**
+ * A binary cache of decoded images, used to avoid decompressing large
+ * tileset images every time they are loaded.
+ *
+ * Like the MapCache, each image is cached outside of its directory, in a
+ * file derived from its absolute path. The cache is only valid as long as
+ * the size and modification time of the image file match the ones it was
+ * written for.
+ *
+ * The pixels are stored as uncompressed little-endian rows in the 32-bit
+ * format in which they end up being drawn, so that they can be copied
+ * straight from the memory-mapped file.
+ *
+ * The cache is disabled by default, in which case images are simply
+ * decoded. Once the cache files take more than the size limit, the least
+ * recently used ones are removed.
+ */
+class TILEDSHARED_EXPORT ImageCache
+{
+public:
+    static QImage loadImage(const QString &fileName);
+
+    /**
+     * Sets whether images are read from and written to the cache. May be
+     * called from any thread.
+     */
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    /**
+     * Sets the maximum size of the cache files in \a megabytes. Defaults
+     * to 512 megabytes.
+     */
+    static void setSizeLimit(int megabytes);
+    static int sizeLimit();
+
+    /**
+     * Returns the minimum number of pixels for which an image will be
+     * cached. Smaller images decode quickly enough without a cache.
+     */
+    static int minimumPixelCount() { return 512 * 512; }
+
+    static QString cacheFileName(const QString &imageFileName);
+
+private:
+    static QImage read(const QString &cacheFileName,
+                       qint64 fileSize, qint64 lastModified);
+    static bool write(const QString &cacheFileName,
+                      qint64 fileSize, qint64 lastModified,
+                      const QImage &image);
+};
+
+} // namespace Tiled
+
+#endif // TILED_IMAGECACHE_H
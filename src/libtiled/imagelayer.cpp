@@ -28,12 +28,19 @@
  */
 
 #include "imagelayer.h"
+#include "colorkey.h"
 #include "map.h"
+#include "memoryusage.h"
+#include "tileset.h"
 
-#include <QBitmap>
+#include <QImage>
+#include <QImageReader>
 
 using namespace Tiled;
 
+// Mipmaps are created until the image fits within this size
+static const int MinMipmapSize = 512;
+
 ImageLayer::ImageLayer(const QString &name, int x, int y, int width, int height):
     Layer(ImageLayerType, name, x, y, width, height)
 {
@@ -43,9 +50,16 @@ ImageLayer::~ImageLayer()
 {
 }
 
+void ImageLayer::setImage(const QPixmap &image)
+{
+    mImage = image;
+    updateMipmaps();
+}
+
 void ImageLayer::resetImage()
 {
     mImage = QPixmap();
+    mMipmaps.clear();
     mImageSource.clear();
 }
 
@@ -55,19 +69,51 @@ bool ImageLayer::loadFromImage(const QImage &image, const QString &fileName)
 
     if (image.isNull()) {
         mImage = QPixmap();
+        mMipmaps.clear();
         return false;
     }
 
-    mImage = QPixmap::fromImage(image);
-
-    if (mTransparentColor.isValid()) {
-        const QImage mask = image.createMaskFromColor(mTransparentColor.rgb());
-        mImage.setMask(QBitmap::fromImage(mask));
-    }
+    mImage = QPixmap::fromImage(applyColorKey(image, mTransparentColor));
 
+    updateMipmaps();
     return true;
 }
 
+/**
+ * Convenience override that loads the image from the given \a fileName.
+ * When image decoding is disabled, the image is only checked to be readable.
+ */
+bool ImageLayer::loadFromImage(const QString &fileName)
+{
+    if (isImageDecodingEnabled())
+        return loadFromImage(QImage(fileName), fileName);
+
+    resetImage();
+    mImageSource = fileName;
+    return QImageReader(fileName).canRead();
+}
+
+/**
+ * Creates the downscaled versions of the image, for images larger than
+ * MinMipmapSize. Each level is smoothly scaled down from the previous one.
+ */
+void ImageLayer::updateMipmaps()
+{
+    mMipmaps.clear();
+
+    QSize size = mImage.size();
+    if (size.width() <= MinMipmapSize && size.height() <= MinMipmapSize)
+        return;
+
+    QImage level = mImage.toImage();
+
+    while (size.width() > MinMipmapSize || size.height() > MinMipmapSize) {
+        size = QSize(qMax(1, size.width() / 2), qMax(1, size.height() / 2));
+        level = level.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        mMipmaps.append(QPixmap::fromImage(level));
+    }
+}
+
 bool ImageLayer::isEmpty() const
 {
     return mImage.isNull();
@@ -78,6 +124,15 @@ Layer *ImageLayer::clone() const
     return initializeClone(new ImageLayer(mName, mX, mY, mWidth, mHeight));
 }
 
+qint64 ImageLayer::memoryUsage() const
+{
+    qint64 usage = Layer::memoryUsage() + Tiled::memoryUsage(mImageSource) +
+            Tiled::memoryUsage(mImage);
+    for (const QPixmap &mipmap : mMipmaps)
+        usage += Tiled::memoryUsage(mipmap);
+    return usage;
+}
+
 ImageLayer *ImageLayer::initializeClone(ImageLayer *clone) const
 {
     Layer::initializeClone(clone);
@@ -85,6 +140,7 @@ ImageLayer *ImageLayer::initializeClone(ImageLayer *clone) const
     clone->mImageSource = mImageSource;
     clone->mTransparentColor = mTransparentColor;
     clone->mImage = mImage;
+    clone->mMipmaps = mMipmaps;
 
     return clone;
 }
@@ -36,6 +36,7 @@
 
 #include <QColor>
 #include <QPixmap>
+#include <QVector>
 
 class QImage;
 
@@ -94,7 +95,14 @@ public:
     /**
       * Sets the image of this layer.
       */
-    void setImage(const QPixmap &image) { mImage = image; }
+    void setImage(const QPixmap &image);
+
+    /**
+     * Returns the downscaled versions of the layer image, each half the size
+     * of the previous one, starting at half the size of the image. They are
+     * used for drawing the layer when zoomed out. Small images have none.
+     */
+    const QVector<QPixmap> &mipmaps() const { return mMipmaps; }
 
     /**
      * Resets layer image.
@@ -113,6 +121,7 @@ public:
      *         returns <code>false</code>
      */
     bool loadFromImage(const QImage &image, const QString &fileName);
+    bool loadFromImage(const QString &fileName);
 
     /**
      * Returns true if no image source has been set.
@@ -121,13 +130,18 @@ public:
 
     Layer *clone() const override;
 
+    qint64 memoryUsage() const override;
+
 protected:
     ImageLayer *initializeClone(ImageLayer *clone) const;
 
 private:
+    void updateMipmaps();
+
     QString mImageSource;
     QColor mTransparentColor;
     QPixmap mImage;
+    QVector<QPixmap> mMipmaps;
 };
 
 } // namespace Tiled
@@ -63,12 +63,12 @@ QRect IsometricRenderer::boundingRect(const QRect &rect) const
     return QRect(pos, size);
 }
 
-QRectF IsometricRenderer::boundingRect(const MapObject *object) const
+QRectF IsometricRenderer::objectBoundingRect(const MapObject *object) const
 {
     if (!object->cell().isEmpty()) {
         const QPointF bottomCenter = pixelToScreenCoords(object->position());
         const Tile *tile = object->cell().tile;
-        const QSize imgSize = tile->image().size();
+        const QSize imgSize = tile->size();
         const QPoint tileOffset = tile->offset();
         const QSizeF objectSize = object->size();
         const QSizeF scale(objectSize.width() / imgSize.width(), objectSize.height() / imgSize.height());
@@ -102,7 +102,7 @@ QRectF IsometricRenderer::boundingRect(const MapObject *object) const
     }
 }
 
-QPainterPath IsometricRenderer::shape(const MapObject *object) const
+QPainterPath IsometricRenderer::objectShape(const MapObject *object) const
 {
     QPainterPath path;
     if (!object->cell().isEmpty()) {
@@ -115,8 +115,9 @@ QPainterPath IsometricRenderer::shape(const MapObject *object) const
             break;
         case MapObject::Polygon:
         case MapObject::Polyline: {
+            // Picking doesn't need to be precise to the pixel
             const QPointF &pos = object->position();
-            const QPolygonF polygon = object->polygon().translated(pos);
+            const QPolygonF polygon = simplifiedPolygon(object, 1).translated(pos);
             const QPolygonF screenPolygon = pixelToScreenCoords(polygon);
             if (object->shape() == MapObject::Polygon) {
                 path.addPolygon(screenPolygon);
@@ -134,6 +135,14 @@ QPainterPath IsometricRenderer::shape(const MapObject *object) const
     return path;
 }
 
+QPainterPath IsometricRenderer::tileRegionShape(const QRegion &region) const
+{
+    QPainterPath path;
+    foreach (const QRect &r, region.rects())
+        path.addPolygon(tileRectToScreenPolygon(r));
+    return path.simplified();
+}
+
 void IsometricRenderer::drawGrid(QPainter *painter, const QRectF &rect,
                                  QColor gridColor) const
 {
@@ -158,16 +167,21 @@ void IsometricRenderer::drawGrid(QPainter *painter, const QRectF &rect,
     gridPen.setDashPattern(QVector<qreal>() << 2 << 2);
     painter->setPen(gridPen);
 
+    QVector<QLineF> lines;
+    lines.reserve(qMax(0, endY - startY + 1) + qMax(0, endX - startX + 1));
+
     for (int y = startY; y <= endY; ++y) {
         const QPointF start = tileToScreenCoords(startX, y);
         const QPointF end = tileToScreenCoords(endX, y);
-        painter->drawLine(start, end);
+        lines.append(QLineF(start, end));
     }
     for (int x = startX; x <= endX; ++x) {
         const QPointF start = tileToScreenCoords(x, startY);
         const QPointF end = tileToScreenCoords(x, endY);
-        painter->drawLine(start, end);
+        lines.append(QLineF(start, end));
     }
+
+    painter->drawLines(lines);
 }
 
 void IsometricRenderer::drawTileLayer(QPainter *painter,
@@ -180,9 +194,11 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
     if (tileWidth <= 0 || tileHeight <= 1)
         return;
 
+    const QRect bounds = layer->cellBounds();
+
     QRect rect = exposed.toAlignedRect();
     if (rect.isNull())
-        rect = boundingRect(layer->bounds());
+        rect = boundingRect(bounds.translated(layer->position()));
 
     QMargins drawMargins = layer->drawMargins();
     drawMargins.setTop(drawMargins.top() - tileHeight);
@@ -226,25 +242,37 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
     // Determine whether the current row is shifted half a tile to the right
     bool shifted = inUpperHalf ^ inLeftHalf;
 
-    CellRenderer renderer(painter);
+    CellRenderer renderer(painter, flags(), images());
 
     for (int y = startPos.y(); y - tileHeight < rect.bottom();
          y += tileHeight / 2)
     {
         QPoint columnItr = rowItr;
 
-        for (int x = startPos.x(); x < rect.right(); x += tileWidth) {
-            if (layer->contains(columnItr)) {
-                const Cell &cell = layer->cellAt(columnItr);
-                if (!cell.isEmpty()) {
-                    renderer.render(cell, QPointF(x, y), QSizeF(0, 0),
-                                    CellRenderer::BottomLeft);
+        for (int x = startPos.x(); x < rect.right();) {
+            int steps = 1;
+
+            if (bounds.contains(columnItr)) {
+                const int cx = columnItr.x();
+                const int cy = columnItr.y();
+
+                if (const Chunk *chunk = layer->findChunk(cx, cy)) {
+                    const Cell &cell = chunk->cellAt(cx & CHUNK_MASK, cy & CHUNK_MASK);
+                    if (!cell.isEmpty()) {
+                        renderer.render(cell, QPointF(x, y), QSizeF(0, 0),
+                                        CellRenderer::BottomLeft);
+                    }
+                } else {
+                    // Skip the part of this row that crosses the empty chunk
+                    steps = qMin(CHUNK_SIZE - (cx & CHUNK_MASK),
+                                 (cy & CHUNK_MASK) + 1);
                 }
             }
 
             // Advance to the next column
-            ++columnItr.rx();
-            --columnItr.ry();
+            columnItr.rx() += steps;
+            columnItr.ry() -= steps;
+            x += tileWidth * steps;
         }
 
         // Advance to the next row
@@ -391,7 +419,8 @@ void IsometricRenderer::drawMapObject(QPainter *painter,
         }
         case MapObject::Polygon: {
             const QPointF &pos = object->position();
-            const QPolygonF polygon = object->polygon().translated(pos);
+            const qreal tolerance = simplificationTolerance(painter);
+            const QPolygonF polygon = simplifiedPolygon(object, tolerance).translated(pos);
             QPolygonF screenPolygon = pixelToScreenCoords(polygon);
 
             QPen thickPen(pen);
@@ -415,7 +444,8 @@ void IsometricRenderer::drawMapObject(QPainter *painter,
         }
         case MapObject::Polyline: {
             const QPointF &pos = object->position();
-            const QPolygonF polygon = object->polygon().translated(pos);
+            const qreal tolerance = simplificationTolerance(painter);
+            const QPolygonF polygon = simplifiedPolygon(object, tolerance).translated(pos);
             QPolygonF screenPolygon = pixelToScreenCoords(polygon);
 
             QPen thickPen(pen);
@@ -442,6 +472,34 @@ void IsometricRenderer::drawMapObject(QPainter *painter,
     painter->restore();
 }
 
+/**
+ * Draws the objects, batching consecutive tile objects through a single
+ * CellRenderer.
+ */
+void IsometricRenderer::drawMapObjects(QPainter *painter,
+                                       const QList<MapObject*> &objects,
+                                       const QVector<QColor> &colors) const
+{
+    Q_ASSERT(objects.size() == colors.size());
+
+    const bool showTileObjectOutlines = testFlag(ShowTileObjectOutlines);
+    CellRenderer cellRenderer(painter, RenderFlags(), images());
+
+    for (int i = 0; i < objects.size(); ++i) {
+        const MapObject *object = objects.at(i);
+        const Cell &cell = object->cell();
+
+        if (cell.isEmpty() || showTileObjectOutlines || object->rotation() != qreal(0)) {
+            cellRenderer.flush();
+            drawRotatedMapObject(painter, object, colors.at(i));
+            continue;
+        }
+
+        cellRenderer.render(cell, pixelToScreenCoords(object->position()),
+                            object->size(), CellRenderer::BottomCenter);
+    }
+}
+
 QPointF IsometricRenderer::pixelToTileCoords(qreal x, qreal y) const
 {
     const int tileHeight = map()->tileHeight();
@@ -504,6 +562,38 @@ QPointF IsometricRenderer::pixelToScreenCoords(qreal x, qreal y) const
                    (tileX + tileY) * tileHeight / 2);
 }
 
+void IsometricRenderer::screenToPixelCoords(const QPointF *points, QPointF *result,
+                                            int count) const
+{
+    const int tileWidth = map()->tileWidth();
+    const int tileHeight = map()->tileHeight();
+    const int originX = map()->height() * tileWidth / 2;
+
+    for (int i = 0; i < count; ++i) {
+        const qreal tileY = points[i].y() / tileHeight;
+        const qreal tileX = (points[i].x() - originX) / tileWidth;
+
+        result[i] = QPointF((tileY + tileX) * tileHeight,
+                            (tileY - tileX) * tileHeight);
+    }
+}
+
+void IsometricRenderer::pixelToScreenCoords(const QPointF *points, QPointF *result,
+                                            int count) const
+{
+    const int tileWidth = map()->tileWidth();
+    const int tileHeight = map()->tileHeight();
+    const int originX = map()->height() * tileWidth / 2;
+
+    for (int i = 0; i < count; ++i) {
+        const qreal tileY = points[i].y() / tileHeight;
+        const qreal tileX = points[i].x() / tileHeight;
+
+        result[i] = QPointF((tileX - tileY) * tileWidth / 2 + originX,
+                            (tileX + tileY) * tileHeight / 2);
+    }
+}
+
 QPolygonF IsometricRenderer::pixelRectToScreenPolygon(const QRectF &rect) const
 {
     QPolygonF polygon;
@@ -47,10 +47,10 @@ public:
 
     QSize mapSize() const override;
 
+    using MapRenderer::boundingRect;
     QRect boundingRect(const QRect &rect) const override;
 
-    QRectF boundingRect(const MapObject *object) const override;
-    QPainterPath shape(const MapObject *object) const override;
+    QPainterPath tileRegionShape(const QRegion &region) const override;
 
     void drawGrid(QPainter *painter, const QRectF &rect, QColor grid) const override;
 
@@ -66,6 +66,10 @@ public:
                        const MapObject *object,
                        const QColor &color) const override;
 
+    void drawMapObjects(QPainter *painter,
+                        const QList<MapObject*> &objects,
+                        const QVector<QColor> &colors) const override;
+
     using MapRenderer::pixelToTileCoords;
     QPointF pixelToTileCoords(qreal x, qreal y) const override;
 
@@ -80,9 +84,17 @@ public:
     
     using MapRenderer::screenToPixelCoords;
     QPointF screenToPixelCoords(qreal x, qreal y) const override;
+    void screenToPixelCoords(const QPointF *points, QPointF *result,
+                             int count) const override;
 
     using MapRenderer::pixelToScreenCoords;
     QPointF pixelToScreenCoords(qreal x, qreal y) const override;
+    void pixelToScreenCoords(const QPointF *points, QPointF *result,
+                             int count) const override;
+
+protected:
+    QRectF objectBoundingRect(const MapObject *object) const override;
+    QPainterPath objectShape(const MapObject *object) const override;
 
 private:
     QPolygonF pixelRectToScreenPolygon(const QRectF &rect) const;
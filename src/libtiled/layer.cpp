@@ -30,6 +30,8 @@
 #include "layer.h"
 
 #include "imagelayer.h"
+#include "map.h"
+#include "memoryusage.h"
 #include "objectgroup.h"
 #include "tilelayer.h"
 
@@ -51,6 +53,20 @@ Layer::Layer(TypeFlag type, const QString &name, int x, int y,
 {
 }
 
+void Layer::setName(const QString &name)
+{
+    mName = name;
+
+    // The map looks up its layers by name
+    if (mMap)
+        mMap->invalidateLayerNameIndex();
+}
+
+qint64 Layer::memoryUsage() const
+{
+    return Tiled::memoryUsage(mName) + properties().memoryUsage();
+}
+
 /**
  * A helper function for initializing the members of the given instance to
  * those of this layer. Used by subclasses when cloning.
@@ -79,7 +79,7 @@ public:
     /**
      * Sets the name of this layer.
      */
-    void setName(const QString &name) { mName = name; }
+    void setName(const QString &name);
 
     /**
      * Returns the opacity of this layer.
@@ -207,6 +207,13 @@ public:
      */
     virtual Layer *clone() const = 0;
 
+    /**
+     * Returns the approximate number of bytes used by this layer, including
+     * its properties and contents. Tilesets are not included, since they
+     * are shared between layers and maps.
+     */
+    virtual qint64 memoryUsage() const;
+
     // These functions allow checking whether this Layer is an instance of the
     // given subclass without relying on a dynamic_cast.
     bool isTileLayer() const { return mLayerType == TileLayerType; }
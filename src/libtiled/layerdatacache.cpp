@@ -0,0 +1,110 @@
+/*
+ * layerdatacache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "layerdatacache.h"
+
+#include "tilelayer.h"
+
+using namespace Tiled;
+
+/**
+ * Returns the cached data of the given \a tileLayer, or null when it is not
+ * available for the given \a format and \a tilesets.
+ */
+const QByteArray *LayerDataCache::find(const TileLayer *tileLayer,
+                                       Map::LayerDataFormat format,
+                                       const QVector<SharedTileset> &tilesets) const
+{
+    auto it = mEntries.find(tileLayer);
+    if (it == mEntries.end())
+        return nullptr;
+
+    const Entry &entry = it.value();
+    if (entry.format != format || !matches(entry.tilesets, tilesets))
+        return nullptr;
+
+    return &entry.data;
+}
+
+void LayerDataCache::insert(const TileLayer *tileLayer,
+                            Map::LayerDataFormat format,
+                            const QVector<SharedTileset> &tilesets,
+                            const QByteArray &data)
+{
+    Entry entry;
+    entry.format = format;
+    entry.data = data;
+
+    entry.tilesets.reserve(tilesets.size());
+    for (const SharedTileset &tileset : tilesets)
+        entry.tilesets.append(qMakePair(tileset.data(), tileset->tileCount()));
+
+    mEntries.insert(tileLayer, entry);
+}
+
+/**
+ * Makes the entry of \a sourceLayer in the \a source cache, if any, the
+ * entry of \a layer in this cache. Used to share the cache with a copy of a
+ * map.
+ */
+void LayerDataCache::copyEntry(const LayerDataCache &source,
+                               const Layer *sourceLayer,
+                               const Layer *layer)
+{
+    auto it = source.mEntries.find(sourceLayer);
+    if (it != source.mEntries.end())
+        mEntries.insert(layer, it.value());
+}
+
+/**
+ * Makes the entries that were encoded with \a oldTileset refer to
+ * \a newTileset instead. Used when a copy of a map uses copies of some of
+ * its tilesets, which have the same tiles.
+ */
+void LayerDataCache::replaceTileset(const Tileset *oldTileset,
+                                    const Tileset *newTileset)
+{
+    for (Entry &entry : mEntries)
+        for (QPair<const Tileset*, int> &tileset : entry.tilesets)
+            if (tileset.first == oldTileset)
+                tileset.first = newTileset;
+}
+
+bool LayerDataCache::matches(const TilesetsKey &key,
+                             const QVector<SharedTileset> &tilesets)
+{
+    if (key.size() != tilesets.size())
+        return false;
+
+    for (int i = 0; i < key.size(); ++i) {
+        const Tileset *tileset = tilesets.at(i).data();
+        if (key.at(i).first != tileset || key.at(i).second != tileset->tileCount())
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,104 @@
+/*
+ * layerdatacache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef TILED_LAYERDATACACHE_H
+#define TILED_LAYERDATACACHE_H
+
+#include "map.h"
+#include "tiled_global.h"
+#include "tileset.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+
+namespace Tiled {
+
+class Layer;
+class TileLayer;
+
+/**
+ * Keeps the encoded tile layer data written by MapWriter, so that it can be
+ * reused when a map is saved again while some of its tile layers did not
+ * change.
+ *
+ * The owner of the cache is responsible for removing the entries of tile
+ * layers that change. Entries are only used when the layer data format and
+ * the tilesets of the map are the same as when the data was encoded.
+ */
+class TILEDSHARED_EXPORT LayerDataCache
+{
+public:
+    const QByteArray *find(const TileLayer *tileLayer,
+                           Map::LayerDataFormat format,
+                           const QVector<SharedTileset> &tilesets) const;
+
+    void insert(const TileLayer *tileLayer,
+                Map::LayerDataFormat format,
+                const QVector<SharedTileset> &tilesets,
+                const QByteArray &data);
+
+    void copyEntry(const LayerDataCache &source,
+                   const Layer *sourceLayer,
+                   const Layer *layer);
+
+    void replaceTileset(const Tileset *oldTileset,
+                        const Tileset *newTileset);
+
+    void remove(const Layer *layer);
+    void clear();
+
+private:
+    // The tilesets with their tile counts, which determine the gids
+    typedef QVector<QPair<const Tileset*, int>> TilesetsKey;
+
+    struct Entry {
+        Map::LayerDataFormat format;
+        TilesetsKey tilesets;
+        QByteArray data;
+    };
+
+    static bool matches(const TilesetsKey &key,
+                        const QVector<SharedTileset> &tilesets);
+
+    QHash<const Layer*, Entry> mEntries;
+};
+
+inline void LayerDataCache::remove(const Layer *layer)
+{
+    mEntries.remove(layer);
+}
+
+inline void LayerDataCache::clear()
+{
+    mEntries.clear();
+}
+
+} // namespace Tiled
+
+#endif // TILED_LAYERDATACACHE_H
@@ -0,0 +1,156 @@
+/*
+ * layerdataencoder.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "layerdataencoder.h"
+
+#include "gidmapper.h"
+#include "tilelayer.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+
+using namespace Tiled;
+
+namespace {
+
+class EncodeTask : public QRunnable
+{
+public:
+    EncodeTask(const GidMapper &gidMapper,
+               const TileLayer &tileLayer,
+               Map::LayerDataFormat format,
+               QByteArray &data,
+               bool &ok)
+        : mGidMapper(gidMapper)
+        , mTileLayer(tileLayer)
+        , mFormat(format)
+        , mData(data)
+        , mOk(ok)
+    {}
+
+    void run() override
+    {
+        mOk = mGidMapper.encodeLayerData(mTileLayer, mFormat, [this] (const char *data, int length) {
+            mData.append(data, length);
+        });
+    }
+
+private:
+    const GidMapper &mGidMapper;
+    const TileLayer &mTileLayer;
+    const Map::LayerDataFormat mFormat;
+    QByteArray &mData;
+    bool &mOk;
+};
+
+} // anonymous namespace
+
+/**
+ * Returns whether the data of tile layers is encoded ahead in the given
+ * \a format. When not, encode() leaves all layers to be streamed.
+ */
+bool LayerDataEncoder::encodesAhead(Map::LayerDataFormat format)
+{
+    switch (format) {
+    case Map::Base64Gzip:
+    case Map::Base64Zlib:
+    case Map::Base64Zstandard:
+    case Map::Base64Lz4:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Adds the given \a tileLayer to the layers to encode.
+ */
+void LayerDataEncoder::addLayer(const TileLayer *tileLayer)
+{
+    Entry entry;
+    entry.tileLayer = tileLayer;
+    mEntries.append(entry);
+}
+
+/**
+ * Encodes the data of the added layers in the given \a format, using a
+ * thread for each processor core.
+ *
+ * Nothing is encoded when there is only a single layer or the format is not
+ * encoded ahead, in which case the writer can stream the data instead.
+ */
+void LayerDataEncoder::encode(const GidMapper &gidMapper,
+                              Map::LayerDataFormat format)
+{
+    mIndexes.clear();
+
+    if (mEntries.size() < 2 || !encodesAhead(format)) {
+        mEntries.clear();
+        return;
+    }
+
+    // Loading the cells of a layer is not thread-safe
+    for (const Entry &entry : mEntries)
+        entry.tileLayer->load();
+
+    QThreadPool pool;
+    for (int i = 0; i < mEntries.size(); ++i) {
+        Entry &entry = mEntries[i];
+        mIndexes.insert(entry.tileLayer, i);
+        pool.start(new EncodeTask(gidMapper, *entry.tileLayer, format,
+                                  entry.data, entry.ok));
+    }
+    pool.waitForDone();
+}
+
+/**
+ * Moves the encoded data of the given \a tileLayer to \a data. The data is
+ * released by the encoder, so that it only needs to hold the data of the
+ * layers that were not written yet.
+ *
+ * Returns false when compressing the data failed.
+ */
+bool LayerDataEncoder::take(const TileLayer *tileLayer, QByteArray &data)
+{
+    Q_ASSERT(contains(tileLayer));
+
+    const int index = mIndexes.take(tileLayer);
+    Entry &entry = mEntries[index];
+    data.swap(entry.data);
+    entry.data.clear();
+    return entry.ok;
+}
+
+/**
+ * Releases the data of all layers.
+ */
+void LayerDataEncoder::clear()
+{
+    mEntries.clear();
+    mIndexes.clear();
+}
@@ -0,0 +1,89 @@
+/*
+ * layerdataencoder.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_LAYERDATAENCODER_H
+#define TILED_LAYERDATAENCODER_H
+
+#include "map.h"
+#include "tiled_global.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+namespace Tiled {
+
+class GidMapper;
+class TileLayer;
+
+/**
+ * Encodes the data of multiple tile layers in parallel before a map is
+ * written, so that the layers don't need to be compressed one after the
+ * other. The map writers then write the encoded data of each layer in order.
+ *
+ * Only compressed formats are encoded ahead. The other formats are cheap to
+ * encode and are better streamed by the writer, since the encoded data of
+ * all layers would otherwise need to be held in memory at once.
+ */
+class TILEDSHARED_EXPORT LayerDataEncoder
+{
+public:
+    static bool encodesAhead(Map::LayerDataFormat format);
+
+    void addLayer(const TileLayer *tileLayer);
+    void encode(const GidMapper &gidMapper, Map::LayerDataFormat format);
+
+    bool contains(const TileLayer *tileLayer) const;
+    bool take(const TileLayer *tileLayer, QByteArray &data);
+
+    void clear();
+
+private:
+    struct Entry {
+        Entry() : tileLayer(nullptr), ok(false) {}
+
+        const TileLayer *tileLayer;
+        QByteArray data;
+        bool ok;
+    };
+
+    QVector<Entry> mEntries;
+    QHash<const TileLayer*, int> mIndexes;
+};
+
+/**
+ * Returns whether encode() has encoded the data of the given \a tileLayer.
+ */
+inline bool LayerDataEncoder::contains(const TileLayer *tileLayer) const
+{
+    return mIndexes.contains(tileLayer);
+}
+
+} // namespace Tiled
+
+#endif // TILED_LAYERDATAENCODER_H
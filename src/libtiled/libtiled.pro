@@ -19,62 +19,110 @@ win32 {
     LIBS += -lz
 }
 
+# Optional support for Zstandard and LZ4 compressed layer data
+contains(USE_ZSTD, yes) {
+    DEFINES += TILED_ZSTD_SUPPORT
+    LIBS += -lzstd
+}
+contains(USE_LZ4, yes) {
+    DEFINES += TILED_LZ4_SUPPORT
+    LIBS += -llz4
+}
+
 DEFINES += QT_NO_CAST_FROM_ASCII \
     QT_NO_CAST_TO_ASCII
 DEFINES += TILED_LIBRARY
 contains(QT_CONFIG, reduce_exports): CONFIG += hide_symbols
 
-SOURCES += compression.cpp \
+SOURCES += cachedirectory.cpp \
+    colorkey.cpp \
+    compression.cpp \
+    deferredformat.cpp \
     gidmapper.cpp \
     hexagonalrenderer.cpp \
+    imagecache.cpp \
     imagelayer.cpp \
     isometricrenderer.cpp \
     layer.cpp \
+    layerdatacache.cpp \
+    layerdataencoder.cpp \
     map.cpp \
+    mapanalyzer.cpp \
+    mapcache.cpp \
+    mapdiff.cpp \
     mapobject.cpp \
+    mapobjectindex.cpp \
     mapreader.cpp \
     maprenderer.cpp \
+    mapstreamoptions.cpp \
     maptovariantconverter.cpp \
     mapwriter.cpp \
     objectgroup.cpp \
+    openglrasterizer.cpp \
     orthogonalrenderer.cpp \
     plugin.cpp \
     pluginmanager.cpp \
+    pngwriter.cpp \
     properties.cpp \
     staggeredrenderer.cpp \
     tile.cpp \
+    tileatlas.cpp \
     tilelayer.cpp \
+    tilelayerrendercache.cpp \
+    tilemask.cpp \
     tileset.cpp \
+    tilesetcache.cpp \
     tilesetformat.cpp \
+    tracing.cpp \
     varianttomapconverter.cpp
-HEADERS += compression.h \
+HEADERS += cachedirectory.h \
+    colorkey.h \
+    compression.h \
+    csvparser.h \
+    deferredformat.h \
     gidmapper.h \
     hexagonalrenderer.h \
+    imagecache.h \
     imagelayer.h \
     isometricrenderer.h \
     layer.h \
+    layerdatacache.h \
+    layerdataencoder.h \
     logginginterface.h \
     map.h \
+    mapanalyzer.h \
+    mapcache.h \
+    mapdiff.h \
     mapformat.h \
     mapobject.h \
+    mapobjectindex.h \
     mapreader.h \
     maprenderer.h \
+    mapstreamoptions.h \
     maptovariantconverter.h \
     mapwriter.h \
+    memoryusage.h \
     object.h \
     objectgroup.h \
+    openglrasterizer.h \
     orthogonalrenderer.h \
     plugin.h \
     pluginmanager.h \
+    pngwriter.h \
     properties.h \
     staggeredrenderer.h \
     terrain.h \
     tile.h \
+    tileatlas.h \
     tiled.h \
     tiled_global.h \
     tilelayer.h \
+    tilelayerrendercache.h \
+    tilemask.h \
     tileset.h \
+    tilesetcache.h \
     tilesetformat.h \
+    tracing.h \
     varianttomapconverter.h
 
 contains(INSTALL_HEADERS, yes) {
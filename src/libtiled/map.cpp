@@ -47,13 +47,15 @@ Map::Map(Orientation orientation,
     mRenderOrder(RightDown),
     mWidth(width),
     mHeight(height),
+    mInfinite(false),
     mTileWidth(tileWidth),
     mTileHeight(tileHeight),
     mHexSideLength(0),
     mStaggerAxis(StaggerY),
     mStaggerIndex(StaggerOdd),
     mLayerDataFormat(Base64Zlib),
-    mNextObjectId(1)
+    mNextObjectId(1),
+    mLayerNameIndexValid(false)
 {
 }
 
@@ -63,6 +65,7 @@ Map::Map(const Map &map):
     mRenderOrder(map.mRenderOrder),
     mWidth(map.mWidth),
     mHeight(map.mHeight),
+    mInfinite(map.mInfinite),
     mTileWidth(map.mTileWidth),
     mTileHeight(map.mTileHeight),
     mHexSideLength(map.mHexSideLength),
@@ -72,7 +75,8 @@ Map::Map(const Map &map):
     mDrawMargins(map.mDrawMargins),
     mTilesets(map.mTilesets),
     mLayerDataFormat(map.mLayerDataFormat),
-    mNextObjectId(1)
+    mNextObjectId(1),
+    mLayerNameIndexValid(false)
 {
     foreach (const Layer *layer, map.mLayers) {
         Layer *clone = layer->clone();
@@ -182,30 +186,52 @@ void Map::addLayer(Layer *layer)
 {
     adoptLayer(layer);
     mLayers.append(layer);
+
+    if (mLayerNameIndexValid)
+        mLayerNameIndex[layer->name()].append(mLayers.size() - 1);
 }
 
 int Map::indexOfLayer(const QString &layerName, unsigned layertypes) const
 {
-    for (int index = 0; index < mLayers.size(); index++)
-        if (layerAt(index)->name() == layerName
-                && (layertypes & layerAt(index)->layerType()))
+    if (!mLayerNameIndexValid) {
+        mLayerNameIndex.clear();
+        for (int index = 0; index < mLayers.size(); ++index)
+            mLayerNameIndex[mLayers.at(index)->name()].append(index);
+        mLayerNameIndexValid = true;
+    }
+
+    auto it = mLayerNameIndex.constFind(layerName);
+    if (it == mLayerNameIndex.constEnd())
+        return -1;
+
+    for (int index : it.value())
+        if (layertypes & mLayers.at(index)->layerType())
             return index;
 
     return -1;
 }
 
+Layer *Map::findLayer(const QString &layerName, unsigned layerTypes) const
+{
+    const int index = indexOfLayer(layerName, layerTypes);
+    return index == -1 ? nullptr : mLayers.at(index);
+}
+
 void Map::insertLayer(int index, Layer *layer)
 {
     adoptLayer(layer);
     mLayers.insert(index, layer);
+    invalidateLayerNameIndex();
 }
 
 void Map::adoptLayer(Layer *layer)
 {
     layer->setMap(this);
 
+    // Lazily loaded layers adjust the draw margins once their cells are set
     if (TileLayer *tileLayer = layer->asTileLayer())
-        adjustDrawMargins(tileLayer->drawMargins());
+        if (tileLayer->isLoaded())
+            adjustDrawMargins(tileLayer->drawMargins());
 
     if (ObjectGroup *group = layer->asObjectGroup()) {
         foreach (MapObject *o, group->objects()) {
@@ -219,6 +245,7 @@ Layer *Map::takeLayerAt(int index)
 {
     Layer *layer = mLayers.takeAt(index);
     layer->setMap(nullptr);
+    invalidateLayerNameIndex();
     return layer;
 }
 
@@ -270,6 +297,14 @@ bool Map::isTilesetUsed(const Tileset *tileset) const
     return false;
 }
 
+qint64 Map::memoryUsage() const
+{
+    qint64 usage = properties().memoryUsage();
+    for (const Layer *layer : mLayers)
+        usage += layer->memoryUsage();
+    return usage;
+}
+
 
 QString Tiled::staggerAxisToString(Map::StaggerAxis staggerAxis)
 {
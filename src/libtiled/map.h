@@ -36,6 +36,7 @@
 #include "tileset.h"
 
 #include <QColor>
+#include <QHash>
 #include <QList>
 #include <QMargins>
 #include <QSize>
@@ -77,7 +78,9 @@ public:
         Base64     = 1,
         Base64Gzip = 2,
         Base64Zlib = 3,
-        CSV        = 4
+        CSV        = 4,
+        Base64Zstandard = 5,
+        Base64Lz4  = 6
     };
 
     /**
@@ -173,6 +176,19 @@ public:
      */
     QSize size() const { return QSize(mWidth, mHeight); }
 
+    /**
+     * Returns whether this map is infinite. The tile layers of an infinite
+     * map can hold cells outside of the map size, which then only marks the
+     * area the map started out with.
+     */
+    bool infinite() const { return mInfinite; }
+
+    /**
+     * Sets whether this map is infinite. Should be set before any cells are
+     * placed outside of the map size.
+     */
+    void setInfinite(bool infinite) { mInfinite = infinite; }
+
     /**
      * Returns the tile width of this map.
      */
@@ -277,6 +293,16 @@ public:
     int indexOfLayer(const QString &layerName,
                      unsigned layerTypes = Layer::AnyLayerType) const;
 
+    /**
+     * Returns the layer given by \a layerName, or null if no layer with that
+     * name is found. \sa indexOfLayer()
+     *
+     * Layer pointers remain valid while the layer is part of the map, so
+     * code that repeatedly accesses a layer should look it up once.
+     */
+    Layer *findLayer(const QString &layerName,
+                     unsigned layerTypes = Layer::AnyLayerType) const;
+
     /**
      * Adds a layer to this map, inserting it at the given index.
      */
@@ -362,6 +388,13 @@ public:
      */
     bool isTilesetUsed(const Tileset *tileset) const;
 
+    /**
+     * Returns the approximate number of bytes used by the layers and
+     * properties of this map. The tilesets are not included, since they can
+     * be shared with other maps (see Tileset::memoryUsage()).
+     */
+    qint64 memoryUsage() const;
+
     /**
      * Creates a new map that contains the given \a layer. The map size will be
      * determined by the size of the layer.
@@ -396,13 +429,28 @@ public:
      */
     int takeNextObjectId() { return mNextObjectId++; }
 
+    /**
+     * Allocates \a count consecutive object ids for this map and returns
+     * the first one.
+     */
+    int takeNextObjectIds(int count)
+    {
+        const int firstId = mNextObjectId;
+        mNextObjectId += count;
+        return firstId;
+    }
+
 private:
+    friend class Layer;
+
     void adoptLayer(Layer *layer);
+    void invalidateLayerNameIndex() { mLayerNameIndexValid = false; }
 
     Orientation mOrientation;
     RenderOrder mRenderOrder;
     int mWidth;
     int mHeight;
+    bool mInfinite;
     int mTileWidth;
     int mTileHeight;
     int mHexSideLength;
@@ -414,6 +462,10 @@ private:
     QVector<SharedTileset> mTilesets;
     LayerDataFormat mLayerDataFormat;
     int mNextObjectId;
+
+    // The indexes of the layers with each name, built on demand
+    mutable QHash<QString, QVector<int>> mLayerNameIndex;
+    mutable bool mLayerNameIndexValid;
 };
 
 
@@ -0,0 +1,401 @@
+/*
+ * mapanalyzer.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mapanalyzer.h"
+
+#include "hexagonalrenderer.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+namespace {
+
+QString tr(const char *text)
+{
+    return QCoreApplication::translate("MapAnalyzer", text);
+}
+
+/**
+ * Returns the area covered by the map, in the coordinates of its objects.
+ */
+QRectF objectArea(const Map *map)
+{
+    // Objects on isometric maps are placed in a projection where each tile
+    // is a square of the tile height
+    if (map->orientation() == Map::Isometric) {
+        return QRectF(0, 0,
+                      map->width() * map->tileHeight(),
+                      map->height() * map->tileHeight());
+    }
+
+    QScopedPointer<MapRenderer> renderer;
+    switch (map->orientation()) {
+    case Map::Staggered:
+        renderer.reset(new StaggeredRenderer(map));
+        break;
+    case Map::Hexagonal:
+        renderer.reset(new HexagonalRenderer(map));
+        break;
+    default:
+        renderer.reset(new OrthogonalRenderer(map));
+        break;
+    }
+
+    return QRectF(QPointF(), renderer->mapSize());
+}
+
+QRectF objectBounds(const MapObject *object)
+{
+    if (!object->polygon().isEmpty())
+        return object->polygon().boundingRect().translated(object->position());
+    return object->boundsUseTile();
+}
+
+/**
+ * The results of analyzing a single layer.
+ */
+struct LayerResult
+{
+    MapAnalyzer::LayerStatistics statistics;
+    QVector<MapAnalyzer::Issue> issues;
+    QHash<const Tile*, int> tileUsage;
+    QVector<int> objectIds;
+};
+
+class AnalyzeTask : public QRunnable
+{
+public:
+    AnalyzeTask(const Layer &layer,
+                const QSet<const Tileset*> &tilesets,
+                const QRectF &objectArea,
+                LayerResult &result)
+        : mLayer(layer)
+        , mTilesets(tilesets)
+        , mObjectArea(objectArea)
+        , mResult(result)
+    {}
+
+    void run() override
+    {
+        mResult.statistics.layer = &mLayer;
+
+        switch (mLayer.layerType()) {
+        case Layer::TileLayerType:
+            analyzeTileLayer(static_cast<const TileLayer&>(mLayer));
+            break;
+        case Layer::ObjectGroupType:
+            analyzeObjectGroup(static_cast<const ObjectGroup&>(mLayer));
+            break;
+        case Layer::ImageLayerType:
+            if (static_cast<const ImageLayer&>(mLayer).imageSource().isEmpty())
+                addIssue(MapAnalyzer::EmptyLayer, tr("Image layer \"%1\" has no image"));
+            break;
+        }
+    }
+
+private:
+    void analyzeTileLayer(const TileLayer &tileLayer)
+    {
+        MapAnalyzer::LayerStatistics &statistics = mResult.statistics;
+        statistics.area = tileLayer.width() * tileLayer.height();
+
+        int invalidCount = 0;
+        const Tile *lastTile = nullptr;
+        int *lastCount = nullptr;
+
+        for (const Chunk &chunk : tileLayer.chunks()) {
+            statistics.cellCount += chunk.cellCount();
+
+            for (const Cell &cell : chunk) {
+                if (cell.isEmpty())
+                    continue;
+
+                // Neighbouring cells often use the same tile
+                if (cell.tile != lastTile) {
+                    lastTile = cell.tile;
+                    lastCount = mTilesets.contains(lastTile->tileset())
+                            ? &mResult.tileUsage[lastTile] : nullptr;
+                }
+
+                if (lastCount)
+                    ++*lastCount;
+                else
+                    ++invalidCount;
+            }
+        }
+
+        if (statistics.cellCount == 0)
+            addIssue(MapAnalyzer::EmptyLayer, tr("Tile layer \"%1\" is empty"));
+
+        if (invalidCount > 0) {
+            addIssue(MapAnalyzer::InvalidTile,
+                     tr("Tile layer \"%1\" has %2 cells referring to tilesets the map doesn't have")
+                     .arg(mLayer.name()).arg(invalidCount), false);
+        }
+    }
+
+    void analyzeObjectGroup(const ObjectGroup &objectGroup)
+    {
+        const QList<MapObject*> &objects = objectGroup.objects();
+        mResult.statistics.objectCount = objects.size();
+
+        if (objects.isEmpty())
+            addIssue(MapAnalyzer::EmptyLayer, tr("Object layer \"%1\" is empty"));
+
+        for (const MapObject *object : objects) {
+            mResult.objectIds.append(object->id());
+
+            if (const Tile *tile = object->cell().tile) {
+                if (mTilesets.contains(tile->tileset())) {
+                    ++mResult.tileUsage[tile];
+                } else {
+                    addObjectIssue(MapAnalyzer::InvalidTile, object,
+                                   tr("Object %1 in \"%2\" refers to a tileset the map doesn't have"));
+                }
+            }
+
+            const QRectF bounds = objectBounds(object);
+            if (bounds.right() < mObjectArea.left() || bounds.left() > mObjectArea.right() ||
+                    bounds.bottom() < mObjectArea.top() || bounds.top() > mObjectArea.bottom()) {
+                addObjectIssue(MapAnalyzer::ObjectOutOfBounds, object,
+                               tr("Object %1 in \"%2\" is outside of the map"));
+            }
+        }
+    }
+
+    void addIssue(MapAnalyzer::IssueType type, const QString &message,
+                  bool addName = true)
+    {
+        MapAnalyzer::Issue issue;
+        issue.type = type;
+        issue.layer = &mLayer;
+        issue.message = addName ? message.arg(mLayer.name()) : message;
+        mResult.issues.append(issue);
+    }
+
+    void addObjectIssue(MapAnalyzer::IssueType type, const MapObject *object,
+                        const QString &message)
+    {
+        MapAnalyzer::Issue issue;
+        issue.type = type;
+        issue.layer = &mLayer;
+        issue.objectId = object->id();
+        issue.message = message.arg(object->id()).arg(mLayer.name());
+        mResult.issues.append(issue);
+    }
+
+    const Layer &mLayer;
+    const QSet<const Tileset*> &mTilesets;
+    const QRectF mObjectArea;
+    LayerResult &mResult;
+};
+
+} // anonymous namespace
+
+/**
+ * Adds the given \a map to the maps to analyze.
+ */
+void MapAnalyzer::addMap(const Map *map)
+{
+    mMaps.append(map);
+}
+
+/**
+ * Analyzes all added maps. Replaces the reports of any previous analysis.
+ */
+void MapAnalyzer::analyze()
+{
+    struct MapInput
+    {
+        QSet<const Tileset*> tilesets;
+        QRectF objectArea;
+    };
+
+    QVector<MapInput> inputs(mMaps.size());
+    QVector<QVector<LayerResult>> results(mMaps.size());
+
+    for (int i = 0; i < mMaps.size(); ++i) {
+        const Map *map = mMaps.at(i);
+        MapInput &input = inputs[i];
+
+        for (const SharedTileset &tileset : map->tilesets())
+            input.tilesets.insert(tileset.data());
+        input.objectArea = objectArea(map);
+
+        results[i].resize(map->layerCount());
+
+        // Loading the cells of a layer is not thread-safe
+        for (const Layer *layer : map->layers())
+            if (layer->isTileLayer())
+                static_cast<const TileLayer*>(layer)->load();
+    }
+
+    QThreadPool pool;
+    for (int i = 0; i < mMaps.size(); ++i) {
+        const Map *map = mMaps.at(i);
+        for (int l = 0; l < map->layerCount(); ++l) {
+            pool.start(new AnalyzeTask(*map->layerAt(l),
+                                       inputs.at(i).tilesets,
+                                       inputs.at(i).objectArea,
+                                       results[i][l]));
+        }
+    }
+    pool.waitForDone();
+
+    mReports.clear();
+    mReports.reserve(mMaps.size());
+
+    for (int i = 0; i < mMaps.size(); ++i) {
+        const Map *map = mMaps.at(i);
+
+        Report report;
+        report.map = map;
+
+        QHash<int, int> idCounts;
+
+        for (const LayerResult &result : results.at(i)) {
+            report.layers.append(result.statistics);
+            report.issues += result.issues;
+
+            for (auto it = result.tileUsage.begin(); it != result.tileUsage.end(); ++it)
+                report.tileUsage[it.key()] += it.value();
+
+            for (int id : result.objectIds)
+                ++idCounts[id];
+        }
+
+        QSet<const Tileset*> usedTilesets;
+        for (auto it = report.tileUsage.begin(); it != report.tileUsage.end(); ++it)
+            usedTilesets.insert(it.key()->tileset());
+
+        for (const SharedTileset &tileset : map->tilesets()) {
+            if (usedTilesets.contains(tileset.data()))
+                continue;
+
+            Issue issue;
+            issue.type = UnusedTileset;
+            issue.tileset = tileset.data();
+            issue.message = tr("Tileset \"%1\" is not used").arg(tileset->name());
+            report.issues.append(issue);
+        }
+
+        QList<int> ids = idCounts.keys();
+        std::sort(ids.begin(), ids.end());
+
+        for (int id : ids) {
+            if (id == 0)
+                continue;
+
+            if (idCounts.value(id) > 1) {
+                Issue issue;
+                issue.type = DuplicateObjectId;
+                issue.objectId = id;
+                issue.message = tr("Object ID %1 is used by %2 objects")
+                        .arg(id).arg(idCounts.value(id));
+                report.issues.append(issue);
+            }
+
+            if (id >= map->nextObjectId()) {
+                Issue issue;
+                issue.type = InvalidObjectId;
+                issue.objectId = id;
+                issue.message = tr("Object ID %1 is not below the next object ID %2")
+                        .arg(id).arg(map->nextObjectId());
+                report.issues.append(issue);
+            }
+        }
+
+        mReports.append(report);
+    }
+}
+
+/**
+ * Returns a description of the issues and statistics of the analyzed map.
+ */
+QString MapAnalyzer::Report::toString() const
+{
+    QStringList lines;
+
+    for (const Issue &issue : issues)
+        lines.append(tr("Warning: %1").arg(issue.message));
+
+    for (const LayerStatistics &statistics : layers) {
+        const Layer *layer = statistics.layer;
+
+        if (layer->isTileLayer()) {
+            lines.append(tr("Layer \"%1\": %2 of %3 cells used (%4%)")
+                         .arg(layer->name())
+                         .arg(statistics.cellCount)
+                         .arg(statistics.area)
+                         .arg(statistics.fillRatio() * 100, 0, 'f', 1));
+        } else if (layer->isObjectGroup()) {
+            lines.append(tr("Layer \"%1\": %2 objects")
+                         .arg(layer->name())
+                         .arg(statistics.objectCount));
+        }
+    }
+
+    // The most used tiles first
+    QVector<QPair<int, const Tile*>> usage;
+    usage.reserve(tileUsage.size());
+    for (auto it = tileUsage.begin(); it != tileUsage.end(); ++it)
+        usage.append(qMakePair(it.value(), it.key()));
+
+    std::sort(usage.begin(), usage.end(),
+              [] (const QPair<int, const Tile*> &a, const QPair<int, const Tile*> &b) {
+        return a.first > b.first;
+    });
+
+    lines.append(tr("%1 different tiles used").arg(usage.size()));
+
+    for (const auto &entry : usage) {
+        lines.append(tr("  %1 tile %2: %3")
+                     .arg(entry.second->tileset()->name())
+                     .arg(entry.second->id())
+                     .arg(entry.first));
+    }
+
+    return lines.join(QLatin1Char('\n'));
+}
@@ -0,0 +1,125 @@
+/*
+ * mapanalyzer.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_MAPANALYZER_H
+#define TILED_MAPANALYZER_H
+
+#include "tiled_global.h"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace Tiled {
+
+class Layer;
+class Map;
+class Tile;
+class Tileset;
+
+/**
+ * Checks maps for common problems and gathers statistics about them, like
+ * how often each tile is used and how full each tile layer is.
+ *
+ * The layers of all added maps are analyzed in parallel, using a thread for
+ * each processor core. The maps may not be changed while being analyzed.
+ */
+class TILEDSHARED_EXPORT MapAnalyzer
+{
+public:
+    enum IssueType {
+        InvalidTile,            // refers to a tileset the map doesn't have
+        UnusedTileset,
+        EmptyLayer,
+        ObjectOutOfBounds,
+        DuplicateObjectId,
+        InvalidObjectId         // not below the next object ID of the map
+    };
+
+    struct Issue
+    {
+        Issue()
+            : type(InvalidTile)
+            , layer(nullptr)
+            , tileset(nullptr)
+            , objectId(0)
+        {}
+
+        IssueType type;
+        const Layer *layer;
+        const Tileset *tileset;
+        int objectId;
+        QString message;
+    };
+
+    struct LayerStatistics
+    {
+        LayerStatistics()
+            : layer(nullptr)
+            , cellCount(0)
+            , area(0)
+            , objectCount(0)
+        {}
+
+        /**
+         * Returns the part of a tile layer that is covered by tiles, from
+         * 0 to 1.
+         */
+        qreal fillRatio() const { return area > 0 ? qreal(cellCount) / area : 0; }
+
+        const Layer *layer;
+        int cellCount;      // non-empty cells
+        int area;           // cells in total
+        int objectCount;
+    };
+
+    struct Report
+    {
+        Report() : map(nullptr) {}
+
+        const Map *map;
+        QVector<Issue> issues;
+        QVector<LayerStatistics> layers;
+        QHash<const Tile*, int> tileUsage;  // by cells and tile objects
+
+        QString toString() const;
+    };
+
+    void addMap(const Map *map);
+    void analyze();
+
+    const QVector<Report> &reports() const { return mReports; }
+
+private:
+    QVector<const Map*> mMaps;
+    QVector<Report> mReports;
+};
+
+} // namespace Tiled
+
+#endif // TILED_MAPANALYZER_H
@@ -0,0 +1,327 @@
+/*
+ * mapcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mapcache.h"
+
+#include "cachedirectory.h"
+#include "gidmapper.h"
+#include "map.h"
+#include "tilelayer.h"
+
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+using namespace Tiled;
+
+namespace {
+
+const char CacheMagic[4] = { 'T', 'M', 'X', 'C' };
+const quint32 CacheVersion = 1;
+
+// magic, version, file size, modification time, tileset and layer count
+const int HeaderSize = 4 + 4 + 8 + 8 + 4 + 4;
+const int TilesetEntrySize = 4 + 4;
+const int LayerEntrySize = 4 + 4 + 8;
+
+const char CacheDirectoryName[] = "maps";
+
+QAtomicInt cacheSizeLimit(512);
+
+template<typename T>
+void append(QByteArray &out, T value)
+{
+    uchar buffer[sizeof(T)];
+    qToLittleEndian<T>(value, buffer);
+    out.append(reinterpret_cast<const char*>(buffer), sizeof(T));
+}
+
+template<typename T>
+T take(const uchar *&data)
+{
+    const T value = qFromLittleEndian<T>(data);
+    data += sizeof(T);
+    return value;
+}
+
+} // anonymous namespace
+
+/**
+ * Creates the cache for the map stored at \a mapFileName. The size and
+ * modification time of the map file are looked up immediately, so that a
+ * cache written after reading the map refers to the version that was read.
+ */
+MapCache::MapCache(const QString &mapFileName)
+    : mMapFileName(mapFileName)
+    , mMapFileSize(-1)
+    , mMapLastModified(-1)
+    , mFile(cacheFileName(mapFileName))
+    , mData(nullptr)
+{
+    const QFileInfo fileInfo(mapFileName);
+    if (fileInfo.exists()) {
+        mMapFileSize = fileInfo.size();
+        mMapLastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+    }
+}
+
+MapCache::~MapCache()
+{
+    close();
+}
+
+bool MapCache::open()
+{
+    if (mData || mMapFileSize < 0)
+        return mData;
+
+    if (!mFile.open(QFile::ReadOnly))
+        return false;
+
+    const qint64 size = mFile.size();
+    const uchar *data = size >= HeaderSize ? mFile.map(0, size) : nullptr;
+    if (!data) {
+        mFile.close();
+        return false;
+    }
+
+    const uchar *p = data;
+    bool valid = memcmp(p, CacheMagic, sizeof(CacheMagic)) == 0;
+    p += sizeof(CacheMagic);
+
+    valid = valid && take<quint32>(p) == CacheVersion;
+    valid = valid && take<qint64>(p) == mMapFileSize;
+    valid = valid && take<qint64>(p) == mMapLastModified;
+
+    const quint32 tilesetCount = take<quint32>(p);
+    const quint32 layerCount = take<quint32>(p);
+
+    const qint64 tableSize = qint64(tilesetCount) * TilesetEntrySize +
+            qint64(layerCount) * LayerEntrySize;
+
+    valid = valid && HeaderSize + tableSize <= size;
+
+    if (valid) {
+        mTilesets.resize(tilesetCount);
+        for (TilesetEntry &entry : mTilesets) {
+            entry.tileCount = take<quint32>(p);
+            entry.columnCount = take<quint32>(p);
+        }
+
+        mLayers.resize(layerCount);
+        for (LayerEntry &entry : mLayers) {
+            entry.width = take<quint32>(p);
+            entry.height = take<quint32>(p);
+            entry.offset = take<quint64>(p);
+
+            const qint64 layerSize = qint64(entry.width) * entry.height * 4;
+            if (entry.width < 0 || entry.height < 0 || entry.offset < 0 ||
+                    (entry.offset > 0 && entry.offset + layerSize > size)) {
+                valid = false;
+                break;
+            }
+        }
+    }
+
+    if (!valid) {
+        mFile.unmap(const_cast<uchar*>(data));
+        close();
+        return false;
+    }
+
+    mData = data;
+    return true;
+}
+
+/**
+ * Unmaps the cache file. Any data returned by tileLayerData() is no longer
+ * valid afterwards.
+ */
+void MapCache::close()
+{
+    if (mData) {
+        mFile.unmap(const_cast<uchar*>(mData));
+        mData = nullptr;
+    }
+
+    mFile.close();
+    mTilesets.clear();
+    mLayers.clear();
+}
+
+/**
+ * Returns whether the gids in the cache can be mapped to tiles using the
+ * given \a tilesets. This fails when an external tileset changed since the
+ * cache was written.
+ */
+bool MapCache::matchesTilesets(const QVector<SharedTileset> &tilesets) const
+{
+    if (tilesets.size() != mTilesets.size())
+        return false;
+
+    for (int i = 0; i < tilesets.size(); ++i) {
+        const Tileset *tileset = tilesets.at(i).data();
+        if (tileset->tileCount() != mTilesets.at(i).tileCount ||
+                tileset->columnCount() != mTilesets.at(i).columnCount)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Returns the little-endian gids of the tile layer at \a index, counting
+ * only tile layers. Returns nullptr when there is no such layer, when the
+ * layer wasn't cached or when its size doesn't match the given \a width
+ * and \a height.
+ *
+ * The returned data remains valid for as long as this cache exists.
+ */
+const uchar *MapCache::tileLayerData(int index, int width, int height) const
+{
+    if (!mData || index < 0 || index >= mLayers.size())
+        return nullptr;
+
+    const LayerEntry &entry = mLayers.at(index);
+    if (entry.offset == 0 || entry.width != width || entry.height != height)
+        return nullptr;
+
+    return mData + entry.offset;
+}
+
+/**
+ * Writes the tile layer data of the given \a map to the cache file. The
+ * \a map should have been read from the map file this cache was created
+ * for, using the tilesets in the order in which they appear on the map.
+ * Afterwards, the least recently used cache files are removed when the
+ * cache exceeds its size limit.
+ *
+ * Layers whose cells haven't been loaded yet are left out of the cache,
+ * rather than forcing them to be loaded.
+ *
+ * Returns whether the cache file was written successfully.
+ */
+bool MapCache::write(const Map *map) const
+{
+    if (mMapFileSize < 0)
+        return false;
+
+    const QList<TileLayer*> tileLayers = map->tileLayers();
+    const QVector<SharedTileset> &tilesets = map->tilesets();
+
+    QByteArray header;
+    header.append(CacheMagic, sizeof(CacheMagic));
+    append<quint32>(header, CacheVersion);
+    append<qint64>(header, mMapFileSize);
+    append<qint64>(header, mMapLastModified);
+    append<quint32>(header, tilesets.size());
+    append<quint32>(header, tileLayers.size());
+
+    for (const SharedTileset &tileset : tilesets) {
+        append<quint32>(header, tileset->tileCount());
+        append<quint32>(header, tileset->columnCount());
+    }
+
+    qint64 offset = HeaderSize +
+            qint64(tilesets.size()) * TilesetEntrySize +
+            qint64(tileLayers.size()) * LayerEntrySize;
+
+    for (const TileLayer *tileLayer : tileLayers) {
+        if (!tileLayer->isLoaded()) {
+            append<quint32>(header, 0);
+            append<quint32>(header, 0);
+            append<quint64>(header, 0);
+            continue;
+        }
+
+        append<quint32>(header, tileLayer->width());
+        append<quint32>(header, tileLayer->height());
+        append<quint64>(header, offset);
+        offset += qint64(tileLayer->width()) * tileLayer->height() * 4;
+    }
+
+    const QString fileName = mFile.fileName();
+    if (!QDir().mkpath(QFileInfo(fileName).absolutePath()))
+        return false;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(header);
+
+    // The cache stores gids for sequentially numbered tilesets
+    const GidMapper gidMapper(tilesets);
+
+    for (const TileLayer *tileLayer : tileLayers) {
+        if (!tileLayer->isLoaded())
+            continue;
+
+        const int width = tileLayer->width();
+        QVector<unsigned> gids(width);
+
+        for (int y = 0; y < tileLayer->height(); ++y) {
+            gidMapper.cellsToGids(*tileLayer, y, gids.data());
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+            for (unsigned &gid : gids)
+                gid = qToLittleEndian<quint32>(gid);
+#endif
+            file.write(reinterpret_cast<const char*>(gids.constData()),
+                       width * 4);
+        }
+    }
+
+    if (!file.commit())
+        return false;
+
+    CacheDirectory::trim(QLatin1String(CacheDirectoryName),
+                         qint64(sizeLimit()) * 1024 * 1024);
+    return true;
+}
+
+/**
+ * Returns the name of the cache file used for the map at \a mapFileName.
+ */
+QString MapCache::cacheFileName(const QString &mapFileName)
+{
+    return CacheDirectory::cacheFileName(QLatin1String(CacheDirectoryName),
+                                         mapFileName);
+}
+
+void MapCache::setSizeLimit(int megabytes)
+{
+    cacheSizeLimit.storeRelease(megabytes);
+}
+
+int MapCache::sizeLimit()
+{
+    return cacheSizeLimit.loadAcquire();
+}
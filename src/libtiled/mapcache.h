@@ -0,0 +1,119 @@
+/*
+ * mapcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_MAPCACHE_H
+#define TILED_MAPCACHE_H
+
+#include "tiled_global.h"
+#include "tileset.h"
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+namespace Tiled {
+
+class Map;
+
+/**
+ * A binary cache of the decoded tile layer data of a map file.
+ *
+ * The cache is stored outside of the map's directory, in a file derived
+ * from the absolute path of the map. It is only valid as long as the size
+ * and modification time of the map file match the ones it was written for,
+ * and as long as the tilesets of the map have the same number of tiles and
+ * columns.
+ *
+ * The gids of each tile layer are stored as uncompressed little-endian
+ * rows, so that they can be used straight from the memory-mapped file
+ * instead of having to be parsed, base64 decoded and decompressed.
+ *
+ * Once the cache files take more than the size limit, the least recently
+ * used ones are removed.
+ */
+class TILEDSHARED_EXPORT MapCache
+{
+public:
+    explicit MapCache(const QString &mapFileName);
+    ~MapCache();
+
+    /**
+     * Opens and memory-maps the cache file. Returns whether the cache exists
+     * and is up to date with the map file.
+     */
+    bool open();
+    void close();
+
+    bool isValid() const { return mData != nullptr; }
+
+    bool matchesTilesets(const QVector<SharedTileset> &tilesets) const;
+
+    const uchar *tileLayerData(int index, int width, int height) const;
+
+    /**
+     * Returns the minimum number of tile layer cells for which a map will
+     * be cached. Smaller maps load quickly enough without a cache.
+     */
+    static int minimumCellCount() { return 256 * 256; }
+
+    bool write(const Map *map) const;
+
+    static QString cacheFileName(const QString &mapFileName);
+
+    /**
+     * Sets the maximum size of the cache files in \a megabytes. Defaults
+     * to 512 megabytes. May be called from any thread.
+     */
+    static void setSizeLimit(int megabytes);
+    static int sizeLimit();
+
+private:
+    struct LayerEntry {
+        int width;
+        int height;
+        qint64 offset;
+    };
+
+    struct TilesetEntry {
+        int tileCount;
+        int columnCount;
+    };
+
+    QString mMapFileName;
+    qint64 mMapFileSize;
+    qint64 mMapLastModified;
+
+    QFile mFile;
+    const uchar *mData;
+    QVector<TilesetEntry> mTilesets;
+    QVector<LayerEntry> mLayers;
+};
+
+} // namespace Tiled
+
+#endif // TILED_MAPCACHE_H
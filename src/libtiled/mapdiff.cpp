@@ -0,0 +1,1141 @@
+/*
+ * mapdiff.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mapdiff.h"
+
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QHash>
+#include <QSet>
+
+#include <algorithm>
+
+using namespace Tiled;
+
+namespace {
+
+/**
+ * Computes 64-bit FNV-1a hashes. Like in version control systems, content
+ * with equal hashes is considered equal.
+ */
+class Hasher
+{
+public:
+    Hasher() : mHash(Q_UINT64_C(14695981039346656037)) {}
+
+    void add(const void *data, int size)
+    {
+        const uchar *bytes = static_cast<const uchar*>(data);
+        for (int i = 0; i < size; ++i) {
+            mHash ^= bytes[i];
+            mHash *= Q_UINT64_C(1099511628211);
+        }
+    }
+
+    void add(quint64 value) { add(&value, sizeof(value)); }
+    void add(int value) { add(&value, sizeof(value)); }
+    void add(qreal value) { add(&value, sizeof(value)); }
+    void add(const QPointF &point) { add(point.x()); add(point.y()); }
+    void add(const QSizeF &size) { add(size.width()); add(size.height()); }
+    void add(const QColor &color) { add(color.isValid() ? quint64(color.rgba()) : ~quint64(0)); }
+
+    void add(const QString &string)
+    {
+        add(string.size());
+        add(string.constData(), string.size() * int(sizeof(QChar)));
+    }
+
+    void add(const Properties &properties)
+    {
+        add(properties.size());
+        for (auto it = properties.begin(); it != properties.end(); ++it) {
+            add(it.key());
+            add(it.value());
+        }
+    }
+
+    quint64 result() const { return mHash; }
+
+private:
+    quint64 mHash;
+};
+
+/**
+ * Assigns keys to cells, which are equal for the same tiles in different
+ * versions of a map.
+ */
+class TileKeys
+{
+public:
+    TileKeys()
+        : mLastTileset(nullptr)
+        , mLastIndex(0)
+    {}
+
+    void addTilesets(const Map *map)
+    {
+        QHash<QString, int> nameCounts;
+
+        for (const SharedTileset &tileset : map->tilesets()) {
+            if (tileset->isExternal()) {
+                mKeys.insert(tileset.data(), QLatin1String("file:") + tileset->fileName());
+            } else {
+                const int count = nameCounts[tileset->name()]++;
+                mKeys.insert(tileset.data(), QLatin1String("name:") + tileset->name() +
+                             QLatin1Char(':') + QString::number(count));
+            }
+        }
+    }
+
+    QString key(const Tileset *tileset) const
+    {
+        const QString key = mKeys.value(tileset);
+        if (!key.isEmpty())
+            return key;
+
+        // Tilesets that are not part of a map can't have duplicate names
+        if (tileset->isExternal())
+            return QLatin1String("file:") + tileset->fileName();
+        return QLatin1String("name:") + tileset->name() + QLatin1String(":0");
+    }
+
+    quint64 cellKey(const Cell &cell)
+    {
+        if (cell.isEmpty())
+            return 0;
+
+        const quint64 flags = (cell.flippedHorizontally ? 1 : 0) |
+                (cell.flippedVertically ? 2 : 0) |
+                (cell.flippedAntiDiagonally ? 4 : 0);
+
+        return quint64(index(cell.tile->tileset())) << 35 | flags << 32 |
+                quint32(cell.tile->id());
+    }
+
+private:
+    int index(const Tileset *tileset)
+    {
+        // Consecutive cells usually refer to the same tileset
+        if (tileset == mLastTileset)
+            return mLastIndex;
+
+        auto it = mIndices.constFind(tileset);
+        if (it == mIndices.constEnd()) {
+            int &keyIndex = mIndicesByKey[key(tileset)];
+            if (keyIndex == 0)
+                keyIndex = mIndicesByKey.size();
+            it = mIndices.insert(tileset, keyIndex);
+        }
+
+        mLastTileset = tileset;
+        mLastIndex = it.value();
+        return mLastIndex;
+    }
+
+    QHash<const Tileset*, QString> mKeys;
+    QHash<const Tileset*, int> mIndices;
+    QHash<QString, int> mIndicesByKey;
+    const Tileset *mLastTileset;
+    int mLastIndex;
+};
+
+quint64 mapHash(const Map *map)
+{
+    Hasher hasher;
+    hasher.add(int(map->orientation()));
+    hasher.add(int(map->renderOrder()));
+    hasher.add(map->width());
+    hasher.add(map->height());
+    hasher.add(map->tileWidth());
+    hasher.add(map->tileHeight());
+    hasher.add(map->hexSideLength());
+    hasher.add(int(map->infinite()));
+    hasher.add(int(map->staggerAxis()));
+    hasher.add(int(map->staggerIndex()));
+    hasher.add(map->backgroundColor());
+    hasher.add(map->properties());
+    return hasher.result();
+}
+
+/**
+ * Hashes the contents of an embedded tileset. External tilesets are stored
+ * in their own file, so only their file name matters.
+ */
+quint64 tilesetHash(const Tileset *tileset)
+{
+    Hasher hasher;
+    hasher.add(tileset->fileName());
+    if (tileset->isExternal())
+        return hasher.result();
+
+    hasher.add(tileset->name());
+    hasher.add(tileset->tileWidth());
+    hasher.add(tileset->tileHeight());
+    hasher.add(tileset->tileSpacing());
+    hasher.add(tileset->margin());
+    hasher.add(QPointF(tileset->tileOffset()));
+    hasher.add(tileset->imageSource());
+    hasher.add(tileset->transparentColor());
+    hasher.add(tileset->columnCount());
+    hasher.add(tileset->properties());
+
+    hasher.add(tileset->tileCount());
+    for (const Tile *tile : tileset->tiles()) {
+        hasher.add(tile->id());
+        hasher.add(tile->imageSource());
+        hasher.add(qreal(tile->probability()));
+        hasher.add(quint64(tile->terrain()));
+        hasher.add(tile->properties());
+        hasher.add(tile->frames().size());
+        for (const Frame &frame : tile->frames()) {
+            hasher.add(frame.tileId);
+            hasher.add(frame.duration);
+        }
+    }
+
+    return hasher.result();
+}
+
+quint64 tilesetsHash(const Map *map, const TileKeys &keys)
+{
+    Hasher hasher;
+    for (const SharedTileset &tileset : map->tilesets()) {
+        hasher.add(keys.key(tileset.data()));
+        hasher.add(tilesetHash(tileset.data()));
+    }
+    return hasher.result();
+}
+
+/**
+ * Hashes everything about a layer except for its cells and objects.
+ */
+quint64 layerHash(const Layer *layer)
+{
+    Hasher hasher;
+    hasher.add(int(layer->layerType()));
+    hasher.add(layer->name());
+    hasher.add(qreal(layer->opacity()));
+    hasher.add(int(layer->isVisible()));
+    hasher.add(layer->offset());
+    hasher.add(layer->properties());
+
+    if (layer->isTileLayer()) {
+        hasher.add(layer->x());
+        hasher.add(layer->y());
+        hasher.add(layer->width());
+        hasher.add(layer->height());
+    } else if (layer->isObjectGroup()) {
+        const ObjectGroup *objectGroup = static_cast<const ObjectGroup*>(layer);
+        hasher.add(objectGroup->color());
+        hasher.add(int(objectGroup->drawOrder()));
+    } else if (layer->isImageLayer()) {
+        const ImageLayer *imageLayer = static_cast<const ImageLayer*>(layer);
+        hasher.add(imageLayer->imageSource());
+        hasher.add(imageLayer->transparentColor());
+    }
+
+    return hasher.result();
+}
+
+quint64 objectHash(const MapObject *object, TileKeys &keys)
+{
+    Hasher hasher;
+    hasher.add(object->name());
+    hasher.add(object->type());
+    hasher.add(object->position());
+    hasher.add(object->size());
+    hasher.add(object->rotation());
+    hasher.add(int(object->shape()));
+    hasher.add(int(object->isVisible()));
+    hasher.add(keys.cellKey(object->cell()));
+    hasher.add(object->properties());
+
+    const QPolygonF &polygon = object->polygon();
+    hasher.add(polygon.size());
+    for (const QPointF &point : polygon)
+        hasher.add(point);
+
+    return hasher.result();
+}
+
+/**
+ * Identifies layers by their type, their name and the number of layers of
+ * that type and name preceding them.
+ */
+QVector<QString> layerKeys(const Map *map)
+{
+    QVector<QString> keys;
+    QHash<QString, int> counts;
+
+    for (const Layer *layer : map->layers()) {
+        const QString key = QString::number(layer->layerType()) +
+                QLatin1Char(':') + layer->name();
+        keys.append(key + QLatin1Char(':') + QString::number(counts[key]++));
+    }
+
+    return keys;
+}
+
+QString layerDescription(Layer::TypeFlag type, const QString &name)
+{
+    const char *typeName = "tile layer";
+    if (type == Layer::ObjectGroupType)
+        typeName = "object layer";
+    else if (type == Layer::ImageLayerType)
+        typeName = "image layer";
+
+    return QString(QLatin1String("%1 \"%2\"")).arg(QLatin1String(typeName), name);
+}
+
+QString idList(const QList<int> &ids)
+{
+    QStringList strings;
+    for (int id : ids)
+        strings.append(QString::number(id));
+    return strings.join(QLatin1String(", "));
+}
+
+/**
+ * Copies the objects of a layer as they are. Unlike MapObject::clone(), this
+ * includes their ID and visibility.
+ */
+MapObject *copyObjectWithId(const MapObject *object)
+{
+    MapObject *copy = object->clone();
+    copy->setId(object->id());
+    copy->setVisible(object->isVisible());
+    return copy;
+}
+
+Layer *copyLayerWithIds(const Layer *layer)
+{
+    Layer *copy = layer->clone();
+
+    if (layer->isObjectGroup()) {
+        const QList<MapObject*> &objects = static_cast<const ObjectGroup*>(layer)->objects();
+        const QList<MapObject*> &copies = copy->asObjectGroup()->objects();
+        for (int i = 0; i < objects.size(); ++i) {
+            copies.at(i)->setId(objects.at(i)->id());
+            copies.at(i)->setVisible(objects.at(i)->isVisible());
+        }
+    }
+
+    return copy;
+}
+
+} // anonymous namespace
+
+namespace Tiled {
+
+/**
+ * The hashes computed while comparing maps. These are shared when the same
+ * version is compared more than once, like the base version of a merge.
+ */
+struct MapDiff::Hashes
+{
+    const QHash<QPoint, quint64> &chunkHashes(const TileLayer *tileLayer)
+    {
+        auto it = mChunkHashes.find(tileLayer);
+        if (it != mChunkHashes.end())
+            return it.value();
+
+        QHash<QPoint, quint64> hashes;
+        const ChunkHash &chunks = tileLayer->chunks();
+        for (auto chunk = chunks.constBegin(); chunk != chunks.constEnd(); ++chunk) {
+            if (chunk->isEmpty())
+                continue;
+
+            Hasher hasher;
+            for (const Cell &cell : chunk.value())
+                hasher.add(keys.cellKey(cell));
+            hashes.insert(chunk.key(), hasher.result());
+        }
+
+        return mChunkHashes.insert(tileLayer, hashes).value();
+    }
+
+    const QHash<int, quint64> &objectHashes(const ObjectGroup *objectGroup)
+    {
+        auto it = mObjectHashes.find(objectGroup);
+        if (it != mObjectHashes.end())
+            return it.value();
+
+        QHash<int, quint64> hashes;
+        for (const MapObject *object : objectGroup->objects())
+            hashes.insert(object->id(), objectHash(object, keys));
+
+        return mObjectHashes.insert(objectGroup, hashes).value();
+    }
+
+    TileKeys keys;
+
+private:
+    QHash<const TileLayer*, QHash<QPoint, quint64>> mChunkHashes;
+    QHash<const ObjectGroup*, QHash<int, quint64>> mObjectHashes;
+};
+
+} // namespace Tiled
+
+namespace {
+
+/**
+ * Returns the cells that differ between two tile layers, in map coordinates.
+ *
+ * When the layers are positioned at the same offset within their chunks,
+ * their chunks cover the same cells and only chunks with different hashes
+ * are compared cell by cell. Otherwise all non-empty cells are compared.
+ */
+TileMask diffCells(const TileLayer *before, const TileLayer *after,
+                   MapDiff::Hashes &hashes)
+{
+    TileMask cells;
+    TileKeys &keys = hashes.keys;
+
+    const QPoint offset = before->position() - after->position();
+
+    if ((offset.x() & CHUNK_MASK) == 0 && (offset.y() & CHUNK_MASK) == 0) {
+        const QPoint chunkOffset(offset.x() >> CHUNK_BITS, offset.y() >> CHUNK_BITS);
+        const QHash<QPoint, quint64> &beforeHashes = hashes.chunkHashes(before);
+        const QHash<QPoint, quint64> &afterHashes = hashes.chunkHashes(after);
+
+        auto addCells = [&] (const TileLayer *layer, const QPoint &chunkPos,
+                             const TileLayer *other, const QPoint &otherChunkPos) {
+            const QPoint origin = chunkPos * CHUNK_SIZE;
+            const QPoint otherOrigin = otherChunkPos * CHUNK_SIZE;
+            const Chunk *chunk = layer->findChunk(origin.x(), origin.y());
+            const Chunk *otherChunk = other ? other->findChunk(otherOrigin.x(), otherOrigin.y())
+                                            : nullptr;
+
+            for (int index = 0; index < CHUNK_SIZE * CHUNK_SIZE; ++index) {
+                const quint64 key = keys.cellKey(chunk->cellAt(index));
+                const quint64 otherKey = otherChunk ? keys.cellKey(otherChunk->cellAt(index)) : 0;
+                if (key != otherKey) {
+                    cells.setCell(layer->x() + origin.x() + (index & CHUNK_MASK),
+                                  layer->y() + origin.y() + (index >> CHUNK_BITS));
+                }
+            }
+        };
+
+        for (auto it = beforeHashes.constBegin(); it != beforeHashes.constEnd(); ++it) {
+            const QPoint afterChunkPos = it.key() + chunkOffset;
+            auto afterHash = afterHashes.constFind(afterChunkPos);
+            if (afterHash == afterHashes.constEnd())
+                addCells(before, it.key(), nullptr, QPoint());
+            else if (afterHash.value() != it.value())
+                addCells(before, it.key(), after, afterChunkPos);
+        }
+
+        for (auto it = afterHashes.constBegin(); it != afterHashes.constEnd(); ++it)
+            if (!beforeHashes.contains(it.key() - chunkOffset))
+                addCells(after, it.key(), nullptr, QPoint());
+
+        return cells;
+    }
+
+    auto compareCells = [&] (const TileLayer *layer, const TileLayer *other) {
+        const QPoint otherOffset = layer->position() - other->position();
+
+        const QRect bounds = layer->cellBounds();
+        const QRect otherBounds = other->cellBounds();
+
+        for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+            for (int x = bounds.left(); x <= bounds.right(); ++x) {
+                const Cell &cell = layer->cellAt(x, y);
+                if (cell.isEmpty())
+                    continue;
+
+                const QPoint otherPos = QPoint(x, y) + otherOffset;
+                const Cell &otherCell = otherBounds.contains(otherPos) ? other->cellAt(otherPos)
+                                                                  : Cell::empty;
+
+                if (keys.cellKey(cell) != keys.cellKey(otherCell))
+                    cells.setCell(layer->x() + x, layer->y() + y);
+            }
+        }
+    };
+
+    compareCells(before, after);
+    compareCells(after, before);
+
+    return cells;
+}
+
+/**
+ * Returns whether two layers have the same attributes and contents.
+ */
+bool layersEqual(const Layer *a, const Layer *b, MapDiff::Hashes &hashes)
+{
+    if (layerHash(a) != layerHash(b))
+        return false;
+
+    if (a->isTileLayer()) {
+        return diffCells(static_cast<const TileLayer*>(a),
+                         static_cast<const TileLayer*>(b),
+                         hashes).isEmpty();
+    }
+
+    if (a->isObjectGroup()) {
+        return hashes.objectHashes(static_cast<const ObjectGroup*>(a)) ==
+                hashes.objectHashes(static_cast<const ObjectGroup*>(b));
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+MapDiff::MapDiff(const Map *before, const Map *after)
+    : mMapChanged(false)
+    , mTilesetsChanged(false)
+{
+    Hashes hashes;
+    *this = MapDiff(before, after, hashes);
+}
+
+MapDiff::MapDiff(const Map *before, const Map *after, Hashes &hashes)
+    : mMapChanged(mapHash(before) != mapHash(after))
+    , mTilesetsChanged(false)
+{
+    TileKeys &keys = hashes.keys;
+    keys.addTilesets(before);
+    keys.addTilesets(after);
+
+    mTilesetsChanged = tilesetsHash(before, keys) != tilesetsHash(after, keys);
+
+    const QVector<QString> beforeKeys = layerKeys(before);
+    const QVector<QString> afterKeys = layerKeys(after);
+
+    QHash<QString, const Layer*> beforeLayers;
+    for (int i = 0; i < beforeKeys.size(); ++i)
+        beforeLayers.insert(beforeKeys.at(i), before->layerAt(i));
+
+    QSet<const Layer*> matched;
+
+    for (int i = 0; i < afterKeys.size(); ++i) {
+        LayerDiff diff;
+        diff.after = after->layerAt(i);
+        diff.before = beforeLayers.value(afterKeys.at(i));
+        diff.name = diff.after->name();
+        diff.type = diff.after->layerType();
+
+        if (!diff.before) {
+            diff.change = Added;
+            mLayers.append(diff);
+            continue;
+        }
+
+        matched.insert(diff.before);
+        diff.attributesChanged = layerHash(diff.before) != layerHash(diff.after);
+
+        if (diff.type == Layer::TileLayerType) {
+            diff.cells = diffCells(static_cast<const TileLayer*>(diff.before),
+                                   static_cast<const TileLayer*>(diff.after),
+                                   hashes);
+        } else if (diff.type == Layer::ObjectGroupType) {
+            const QHash<int, quint64> &beforeObjects =
+                    hashes.objectHashes(static_cast<const ObjectGroup*>(diff.before));
+            const QHash<int, quint64> &afterObjects =
+                    hashes.objectHashes(static_cast<const ObjectGroup*>(diff.after));
+
+            for (const MapObject *object : static_cast<const ObjectGroup*>(diff.before)->objects()) {
+                auto it = afterObjects.constFind(object->id());
+                if (it == afterObjects.constEnd())
+                    diff.removedObjects.append(object->id());
+                else if (it.value() != beforeObjects.value(object->id()))
+                    diff.changedObjects.append(object->id());
+            }
+            for (const MapObject *object : static_cast<const ObjectGroup*>(diff.after)->objects())
+                if (!beforeObjects.contains(object->id()))
+                    diff.addedObjects.append(object->id());
+        }
+
+        if (diff.attributesChanged || !diff.cells.isEmpty() ||
+                !diff.addedObjects.isEmpty() || !diff.removedObjects.isEmpty() ||
+                !diff.changedObjects.isEmpty()) {
+            diff.change = Modified;
+        }
+
+        mLayers.append(diff);
+    }
+
+    // Removed layers are listed after the layer that preceded them
+    int insertIndex = 0;
+    for (const Layer *layer : before->layers()) {
+        if (matched.contains(layer)) {
+            for (int i = 0; i < mLayers.size(); ++i) {
+                if (mLayers.at(i).before == layer) {
+                    insertIndex = i + 1;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        LayerDiff diff;
+        diff.before = layer;
+        diff.name = layer->name();
+        diff.type = layer->layerType();
+        diff.change = Removed;
+        mLayers.insert(insertIndex++, diff);
+    }
+}
+
+bool MapDiff::isEmpty() const
+{
+    if (mMapChanged || mTilesetsChanged)
+        return false;
+
+    for (const LayerDiff &layer : mLayers)
+        if (layer.change != Unchanged)
+            return false;
+
+    return true;
+}
+
+QString MapDiff::toString() const
+{
+    QStringList lines;
+
+    if (mMapChanged)
+        lines.append(QLatin1String("M map attributes"));
+    if (mTilesetsChanged)
+        lines.append(QLatin1String("M tilesets"));
+
+    for (const LayerDiff &layer : mLayers) {
+        const QString description = layerDescription(layer.type, layer.name);
+
+        switch (layer.change) {
+        case Unchanged:
+            break;
+        case Added:
+            lines.append(QLatin1String("A ") + description);
+            break;
+        case Removed:
+            lines.append(QLatin1String("D ") + description);
+            break;
+        case Modified: {
+            QStringList changes;
+            if (layer.attributesChanged)
+                changes.append(QLatin1String("attributes"));
+
+            if (!layer.cells.isEmpty()) {
+                const QRegion region = layer.cells.toRegion();
+                int count = 0;
+                for (const QRect &rect : region.rects())
+                    count += rect.width() * rect.height();
+
+                const QRect bounds = region.boundingRect();
+                changes.append(QString(QLatin1String("%1 cells within %2,%3 %4x%5"))
+                               .arg(count)
+                               .arg(bounds.x()).arg(bounds.y())
+                               .arg(bounds.width()).arg(bounds.height()));
+            }
+
+            if (!layer.addedObjects.isEmpty())
+                changes.append(QLatin1String("added objects ") + idList(layer.addedObjects));
+            if (!layer.removedObjects.isEmpty())
+                changes.append(QLatin1String("removed objects ") + idList(layer.removedObjects));
+            if (!layer.changedObjects.isEmpty())
+                changes.append(QLatin1String("changed objects ") + idList(layer.changedObjects));
+
+            lines.append(QLatin1String("M ") + description + QLatin1String(": ") +
+                         changes.join(QLatin1String("; ")));
+            break;
+        }
+        }
+    }
+
+    return lines.join(QLatin1Char('\n'));
+}
+
+namespace {
+
+/**
+ * Applies the changes of one version of a map onto another one, which was
+ * copied from a third version.
+ */
+class Merger
+{
+public:
+    Merger(Map *target, MapDiff::Hashes &hashes, QStringList *conflicts)
+        : mTarget(target)
+        , mHashes(hashes)
+        , mConflicts(conflicts)
+    {
+        for (Layer *layer : target->layers())
+            if (ObjectGroup *objectGroup = layer->asObjectGroup())
+                for (const MapObject *object : objectGroup->objects())
+                    mObjectIds.insert(object->id());
+    }
+
+    void conflict(const QString &message)
+    {
+        mConflicts->append(message);
+    }
+
+    /**
+     * Returns the cell referring to the same tile in the tilesets of the
+     * target map. Tilesets the target map doesn't have yet are added.
+     */
+    Cell remap(const Cell &cell)
+    {
+        if (cell.isEmpty())
+            return cell;
+
+        Tileset *tileset = cell.tile->tileset();
+        auto it = mTilesets.constFind(tileset);
+        if (it == mTilesets.constEnd()) {
+            const QString key = mHashes.keys.key(tileset);
+            Tileset *target = nullptr;
+
+            for (const SharedTileset &candidate : mTarget->tilesets()) {
+                if (mHashes.keys.key(candidate.data()) == key) {
+                    target = candidate.data();
+                    break;
+                }
+            }
+
+            if (!target) {
+                mTarget->addTileset(tileset->sharedPointer());
+                target = tileset;
+            }
+
+            it = mTilesets.insert(tileset, target);
+        }
+
+        Cell result(cell);
+        if (Tile *tile = it.value()->tileAt(cell.tile->id())) {
+            result.tile = tile;
+        } else if (!mTarget->tilesets().contains(tileset->sharedPointer())) {
+            // Refer to the original tileset when it lost the tile
+            mTarget->addTileset(tileset->sharedPointer());
+        }
+        return result;
+    }
+
+    MapObject *copyObject(const MapObject *object)
+    {
+        MapObject *copy = copyObjectWithId(object);
+        copy->setCell(remap(copy->cell()));
+
+        // Both versions may have used the same ID for new objects
+        if (mObjectIds.contains(copy->id()))
+            copy->setId(mTarget->takeNextObjectId());
+        mObjectIds.insert(copy->id());
+
+        return copy;
+    }
+
+    Layer *copyLayer(const Layer *layer)
+    {
+        Layer *copy = copyLayerWithIds(layer);
+
+        if (TileLayer *tileLayer = copy->asTileLayer()) {
+            // Allows remapping the cells outside of the layer's size
+            if (mTarget->infinite())
+                tileLayer->setMap(mTarget);
+
+            const QRect bounds = tileLayer->cellBounds();
+            for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+                for (int x = bounds.left(); x <= bounds.right(); ++x) {
+                    const Cell &cell = tileLayer->cellAt(x, y);
+                    if (!cell.isEmpty())
+                        tileLayer->setCell(x, y, remap(cell));
+                }
+            }
+        } else if (ObjectGroup *objectGroup = copy->asObjectGroup()) {
+            for (MapObject *object : objectGroup->objects()) {
+                object->setCell(remap(object->cell()));
+
+                if (mObjectIds.contains(object->id()))
+                    object->setId(mTarget->takeNextObjectId());
+                mObjectIds.insert(object->id());
+            }
+        }
+
+        return copy;
+    }
+
+    Layer *replaceLayer(Layer *layer, const Layer *replacement)
+    {
+        forgetObjectIds(layer);
+
+        const int index = mTarget->layers().indexOf(layer);
+        delete mTarget->takeLayerAt(index);
+
+        Layer *copy = copyLayer(replacement);
+        mTarget->insertLayer(index, copy);
+        return copy;
+    }
+
+    void removeLayer(Layer *layer)
+    {
+        forgetObjectIds(layer);
+        delete mTarget->takeLayerAt(mTarget->layers().indexOf(layer));
+    }
+
+    void mergeLayer(Layer *target,
+                    const MapDiff::LayerDiff &ours,
+                    const MapDiff::LayerDiff &theirs);
+
+private:
+    void forgetObjectIds(Layer *layer)
+    {
+        if (ObjectGroup *objectGroup = layer->asObjectGroup())
+            for (const MapObject *object : objectGroup->objects())
+                mObjectIds.remove(object->id());
+    }
+
+    void mergeCells(TileLayer *target,
+                    const MapDiff::LayerDiff &ours,
+                    const MapDiff::LayerDiff &theirs);
+    void mergeObjects(ObjectGroup *target,
+                      const MapDiff::LayerDiff &ours,
+                      const MapDiff::LayerDiff &theirs);
+
+    Map *mTarget;
+    MapDiff::Hashes &mHashes;
+    QStringList *mConflicts;
+    QHash<const Tileset*, Tileset*> mTilesets;
+    QSet<int> mObjectIds;
+};
+
+void copyLayerAttributes(Layer *target, const Layer *source)
+{
+    target->setOpacity(source->opacity());
+    target->setVisible(source->isVisible());
+    target->setOffset(source->offset());
+    target->setProperties(source->properties());
+
+    if (ObjectGroup *objectGroup = target->asObjectGroup()) {
+        const ObjectGroup *sourceGroup = static_cast<const ObjectGroup*>(source);
+        objectGroup->setColor(sourceGroup->color());
+        objectGroup->setDrawOrder(sourceGroup->drawOrder());
+    } else if (ImageLayer *imageLayer = target->asImageLayer()) {
+        const ImageLayer *sourceLayer = static_cast<const ImageLayer*>(source);
+        imageLayer->setSource(sourceLayer->imageSource());
+        imageLayer->setTransparentColor(sourceLayer->transparentColor());
+    }
+}
+
+void copyMapAttributes(Map *target, const Map *source)
+{
+    target->setOrientation(source->orientation());
+    target->setRenderOrder(source->renderOrder());
+    target->setWidth(source->width());
+    target->setHeight(source->height());
+    target->setTileWidth(source->tileWidth());
+    target->setTileHeight(source->tileHeight());
+    target->setHexSideLength(source->hexSideLength());
+    target->setInfinite(source->infinite());
+    target->setStaggerAxis(source->staggerAxis());
+    target->setStaggerIndex(source->staggerIndex());
+    target->setBackgroundColor(source->backgroundColor());
+    target->setProperties(source->properties());
+}
+
+/**
+ * Merges the changes both versions made to the same layer.
+ */
+void Merger::mergeLayer(Layer *target,
+                        const MapDiff::LayerDiff &ours,
+                        const MapDiff::LayerDiff &theirs)
+{
+    const QString description = layerDescription(theirs.type, theirs.name);
+
+    if (theirs.attributesChanged) {
+        if (!ours.attributesChanged)
+            copyLayerAttributes(target, theirs.after);
+        else if (layerHash(ours.after) != layerHash(theirs.after))
+            conflict(description + QLatin1String(": attributes changed on both sides"));
+    }
+
+    switch (theirs.type) {
+    case Layer::TileLayerType:
+        mergeCells(static_cast<TileLayer*>(target), ours, theirs);
+        break;
+    case Layer::ObjectGroupType:
+        mergeObjects(static_cast<ObjectGroup*>(target), ours, theirs);
+        break;
+    case Layer::ImageLayerType:
+        break;
+    }
+}
+
+void Merger::mergeCells(TileLayer *target,
+                        const MapDiff::LayerDiff &ours,
+                        const MapDiff::LayerDiff &theirs)
+{
+    if (theirs.cells.isEmpty())
+        return;
+
+    const QString description = layerDescription(theirs.type, theirs.name);
+    const TileLayer *base = static_cast<const TileLayer*>(theirs.before);
+    const TileLayer *oursLayer = static_cast<const TileLayer*>(ours.after);
+    const TileLayer *theirsLayer = static_cast<const TileLayer*>(theirs.after);
+
+    // Cells can't be merged when one side moved or resized the layer
+    if (oursLayer->bounds() != base->bounds() || theirsLayer->bounds() != base->bounds()) {
+        conflict(description + QLatin1String(": changed on both sides and resized"));
+        return;
+    }
+
+    TileKeys &keys = mHashes.keys;
+    int conflicting = 0;
+
+    for (const QRect &rect : theirs.cells.toRegion().rects()) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                const QPoint pos = QPoint(x, y) - target->position();
+                const Cell &cell = theirsLayer->cellAt(pos);
+
+                if (ours.cells.contains(x, y)) {
+                    if (keys.cellKey(oursLayer->cellAt(pos)) != keys.cellKey(cell))
+                        ++conflicting;
+                    continue;
+                }
+
+                target->setCell(pos.x(), pos.y(), remap(cell));
+            }
+        }
+    }
+
+    if (conflicting > 0) {
+        conflict(description + QString(QLatin1String(": %1 cells changed on both sides"))
+                 .arg(conflicting));
+    }
+}
+
+void Merger::mergeObjects(ObjectGroup *target,
+                          const MapDiff::LayerDiff &ours,
+                          const MapDiff::LayerDiff &theirs)
+{
+    const QString description = layerDescription(theirs.type, theirs.name);
+    const ObjectGroup *oursGroup = static_cast<const ObjectGroup*>(ours.after);
+    const ObjectGroup *theirsGroup = static_cast<const ObjectGroup*>(theirs.after);
+    const QHash<int, quint64> &oursHashes = mHashes.objectHashes(oursGroup);
+    const QHash<int, quint64> &theirsHashes = mHashes.objectHashes(theirsGroup);
+
+    QHash<int, const MapObject*> theirsObjects;
+    for (const MapObject *object : theirsGroup->objects())
+        theirsObjects.insert(object->id(), object);
+
+    auto findObject = [target] (int id) -> MapObject* {
+        for (MapObject *object : target->objects())
+            if (object->id() == id)
+                return object;
+        return nullptr;
+    };
+
+    QList<int> conflicting;
+
+    for (int id : theirs.changedObjects) {
+        if (ours.removedObjects.contains(id) ||
+                (ours.changedObjects.contains(id) &&
+                 oursHashes.value(id) != theirsHashes.value(id))) {
+            conflicting.append(id);
+            continue;
+        }
+
+        MapObject *object = findObject(id);
+        if (!object || ours.changedObjects.contains(id))
+            continue;
+
+        const int index = target->removeObject(object);
+        mObjectIds.remove(id);
+        delete object;
+        target->insertObject(index, copyObject(theirsObjects.value(id)));
+    }
+
+    for (int id : theirs.removedObjects) {
+        if (ours.changedObjects.contains(id)) {
+            conflicting.append(id);
+            continue;
+        }
+
+        if (MapObject *object = findObject(id)) {
+            target->removeObject(object);
+            mObjectIds.remove(id);
+            delete object;
+        }
+    }
+
+    for (int id : theirs.addedObjects) {
+        // The same object may have been added on both sides
+        if (ours.addedObjects.contains(id) && oursHashes.value(id) == theirsHashes.value(id))
+            continue;
+
+        target->addObject(copyObject(theirsObjects.value(id)));
+    }
+
+    if (!conflicting.isEmpty())
+        conflict(description + QLatin1String(": objects changed on both sides: ") +
+                 idList(conflicting));
+}
+
+} // anonymous namespace
+
+Map *MapDiff::merge(const Map *base,
+                    const Map *ours,
+                    const Map *theirs,
+                    QStringList *conflicts)
+{
+    Hashes hashes;
+    const MapDiff oursDiff(base, ours, hashes);
+    const MapDiff theirsDiff(base, theirs, hashes);
+
+    Map *result = new Map(*ours);
+    result->setNextObjectId(qMax(ours->nextObjectId(), theirs->nextObjectId()));
+    for (int i = 0; i < ours->layerCount(); ++i) {
+        delete result->takeLayerAt(i);
+        result->insertLayer(i, copyLayerWithIds(ours->layerAt(i)));
+    }
+
+    const int conflictCount = conflicts->size();
+    Merger merger(result, hashes, conflicts);
+
+    if (theirsDiff.mapChanged()) {
+        if (!oursDiff.mapChanged())
+            copyMapAttributes(result, theirs);
+        else if (mapHash(ours) != mapHash(theirs))
+            merger.conflict(QLatin1String("map attributes changed on both sides"));
+    }
+
+    // Changes to embedded tilesets can't be merged, since their tiles would
+    // need to be remapped
+    if (theirsDiff.tilesetsChanged()) {
+        for (const SharedTileset &tileset : theirs->tilesets()) {
+            const QString key = hashes.keys.key(tileset.data());
+            const quint64 hash = tilesetHash(tileset.data());
+
+            auto sameKey = [&] (const SharedTileset &other) {
+                return hashes.keys.key(other.data()) == key;
+            };
+
+            auto baseTileset = std::find_if(base->tilesets().begin(), base->tilesets().end(), sameKey);
+            if (baseTileset == base->tilesets().end()) {
+                // New tilesets are kept, even when they are not used yet
+                auto oursTileset = std::find_if(ours->tilesets().begin(), ours->tilesets().end(), sameKey);
+                if (oursTileset == ours->tilesets().end())
+                    result->addTileset(tileset);
+                continue;
+            }
+
+            if (tilesetHash(baseTileset->data()) == hash)
+                continue;
+
+            auto oursTileset = std::find_if(ours->tilesets().begin(), ours->tilesets().end(), sameKey);
+            if (oursTileset == ours->tilesets().end() || tilesetHash(oursTileset->data()) != hash) {
+                merger.conflict(QString(QLatin1String("tileset \"%1\": changes can't be merged"))
+                                .arg(tileset->name()));
+            }
+        }
+    }
+
+    // The layers of our version, by the base layer they correspond to
+    QHash<const Layer*, const LayerDiff*> oursByBase;
+    QHash<const Layer*, Layer*> resultLayers;
+    for (const LayerDiff &diff : oursDiff.layers()) {
+        if (diff.before)
+            oursByBase.insert(diff.before, &diff);
+        if (diff.after)
+            resultLayers.insert(diff.after, result->layerAt(ours->layers().indexOf(diff.after)));
+    }
+
+    QList<Layer*> layersToRemove;
+    Layer *previousLayer = nullptr;    // Where added layers are inserted after
+
+    for (const LayerDiff &diff : theirsDiff.layers()) {
+        const QString description = layerDescription(diff.type, diff.name);
+
+        if (diff.change == Added) {
+            const LayerDiff *oursAdded = nullptr;
+            for (const LayerDiff &other : oursDiff.layers()) {
+                if (other.change == Added && other.type == diff.type && other.name == diff.name) {
+                    oursAdded = &other;
+                    break;
+                }
+            }
+
+            if (oursAdded) {
+                if (!layersEqual(oursAdded->after, diff.after, hashes))
+                    merger.conflict(description + QLatin1String(": added on both sides"));
+                previousLayer = resultLayers.value(oursAdded->after);
+                continue;
+            }
+
+            const int index = previousLayer ? result->layers().indexOf(previousLayer) + 1 : 0;
+            Layer *layer = merger.copyLayer(diff.after);
+            result->insertLayer(index, layer);
+            previousLayer = layer;
+            continue;
+        }
+
+        const LayerDiff *oursLayer = oursByBase.value(diff.before);
+        Layer *target = oursLayer->after ? resultLayers.value(oursLayer->after) : nullptr;
+        if (target)
+            previousLayer = target;
+
+        switch (diff.change) {
+        case Unchanged:
+        case Added:
+            break;
+        case Removed:
+            if (oursLayer->change == Modified)
+                merger.conflict(description + QLatin1String(": removed but changed in our version"));
+            else if (target)
+                layersToRemove.append(target);
+            break;
+        case Modified:
+            if (!target)
+                merger.conflict(description + QLatin1String(": changed but removed in our version"));
+            else if (oursLayer->change == Unchanged)
+                previousLayer = merger.replaceLayer(target, diff.after);
+            else
+                merger.mergeLayer(target, *oursLayer, diff);
+            break;
+        }
+    }
+
+    for (Layer *layer : layersToRemove)
+        merger.removeLayer(layer);
+
+    if (conflicts->size() > conflictCount) {
+        delete result;
+        return nullptr;
+    }
+
+    return result;
+}
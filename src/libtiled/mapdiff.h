@@ -0,0 +1,149 @@
+/*
+ * mapdiff.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef TILED_MAPDIFF_H
+#define TILED_MAPDIFF_H
+
+#include "layer.h"
+#include "tilemask.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Tiled {
+
+class Map;
+
+/**
+ * The differences between two versions of a map, as needed for reviewing
+ * and merging changes to maps kept in version control.
+ *
+ * The versions don't need to share any data. Tiles are identified by the
+ * file name of their external tileset, or by the name of their embedded
+ * tileset, and by their tile ID. Layers are matched by type and name, and
+ * objects by their ID.
+ *
+ * Chunks of tile layers, objects and the remaining attributes of layers and
+ * the map are compared by their hashes. Cells are only compared one by one
+ * in chunks of which the hashes differ, which makes comparing huge maps with
+ * few changes cheap. Layers of different size or position are compared as
+ * well, in map coordinates.
+ */
+class TILEDSHARED_EXPORT MapDiff
+{
+public:
+    enum Change {
+        Unchanged,
+        Added,
+        Removed,
+        Modified
+    };
+
+    struct LayerDiff
+    {
+        LayerDiff()
+            : type(Layer::TileLayerType)
+            , change(Unchanged)
+            , before(nullptr)
+            , after(nullptr)
+            , attributesChanged(false)
+        {}
+
+        QString name;
+        Layer::TypeFlag type;
+        Change change;
+        const Layer *before;        // null when the layer was added
+        const Layer *after;         // null when the layer was removed
+        bool attributesChanged;     // anything besides cells and objects
+        TileMask cells;             // in map coordinates
+        QList<int> addedObjects;
+        QList<int> removedObjects;
+        QList<int> changedObjects;
+    };
+
+    MapDiff(const Map *before, const Map *after);
+
+    bool isEmpty() const;
+
+    /**
+     * Returns whether the attributes or properties of the map itself
+     * changed, like its size or orientation.
+     */
+    bool mapChanged() const { return mMapChanged; }
+
+    /**
+     * Returns whether tilesets were added, removed or reordered, or whether
+     * any of the embedded tilesets changed.
+     */
+    bool tilesetsChanged() const { return mTilesetsChanged; }
+
+    /**
+     * Returns the layers of both versions, in the order of the version
+     * after the change, with the removed layers at the position they had.
+     */
+    const QVector<LayerDiff> &layers() const { return mLayers; }
+
+    /**
+     * Returns a description of the changes, with a line for each changed
+     * layer.
+     */
+    QString toString() const;
+
+    /**
+     * Merges the changes made in \a ours and \a theirs since the common
+     * \a base version. Changes made on only one side are taken over, as are
+     * changes made on both sides that don't touch the same cells, objects or
+     * attributes.
+     *
+     * Returns the merged map, which is based on \a ours, or null when there
+     * were conflicting changes. Those are described in \a conflicts.
+     */
+    static Map *merge(const Map *base,
+                      const Map *ours,
+                      const Map *theirs,
+                      QStringList *conflicts);
+
+    /**
+     * The hashes of the compared versions. Only used internally.
+     */
+    struct Hashes;
+
+private:
+    MapDiff(const Map *before, const Map *after, Hashes &hashes);
+
+    QVector<LayerDiff> mLayers;
+    bool mMapChanged;
+    bool mTilesetsChanged;
+};
+
+} // namespace Tiled
+
+#endif // TILED_MAPDIFF_H
@@ -29,12 +29,15 @@
 #ifndef MAPFORMAT_H
 #define MAPFORMAT_H
 
+#include "mapstreamoptions.h"
 #include "pluginmanager.h"
 
 #include <QObject>
 #include <QStringList>
 #include <QMap>
 
+class QIODevice;
+
 namespace Tiled {
 
 class Map;
@@ -48,7 +51,9 @@ public:
         NoCapability    = 0x0,
         Read            = 0x1,
         Write           = 0x2,
-        ReadWrite       = Read | Write
+        ReadWrite       = Read | Write,
+        StreamRead      = 0x4,
+        StreamWrite     = 0x8
     };
     Q_DECLARE_FLAGS(Capabilities, Capability)
 
@@ -122,6 +127,51 @@ public:
      *         occurred. The error can be retrieved by errorString().
      */
     virtual bool write(const Map *map, const QString &fileName) = 0;
+
+    /**
+     * Reads a map from the given \a device, which is already open. The
+     * \a path is used to resolve relative references to external files.
+     *
+     * Only supported by formats with the StreamRead capability. Formats
+     * that can, skip the data of layers that are not included by the
+     * \a options, keeping memory use bounded.
+     *
+     * Returns 0 when reading failed or was cancelled. The error can be
+     * retrieved by errorString().
+     */
+    virtual Map *readFromDevice(QIODevice *device,
+                                const QString &path,
+                                const MapReadOptions &options)
+    {
+        Q_UNUSED(device)
+        Q_UNUSED(path)
+        Q_UNUSED(options)
+        return nullptr;
+    }
+
+    /**
+     * Writes the given \a map to the given \a device, which is already
+     * open. The \a path is used to create relative references to external
+     * files.
+     *
+     * Only supported by formats with the StreamWrite capability. Unlike
+     * write(), this always writes a single file.
+     *
+     * @return <code>true</code> on success, <code>false</code> when an error
+     *         occurred or writing was cancelled. The error can be retrieved
+     *         by errorString().
+     */
+    virtual bool writeToDevice(const Map *map,
+                               QIODevice *device,
+                               const QString &path,
+                               const MapWriteOptions &options)
+    {
+        Q_UNUSED(map)
+        Q_UNUSED(device)
+        Q_UNUSED(path)
+        Q_UNUSED(options)
+        return false;
+    }
 };
 
 } // namespace Tiled
@@ -30,6 +30,7 @@
 #include "mapobject.h"
 
 #include "map.h"
+#include "memoryusage.h"
 #include "objectgroup.h"
 #include "tile.h"
 
@@ -38,8 +39,8 @@ using namespace Tiled;
 MapObject::MapObject():
     Object(MapObjectType),
     mId(0),
-    mSize(0, 0),
     mShape(Rectangle),
+    mSize(0, 0),
     mObjectGroup(nullptr),
     mRotation(0.0f),
     mVisible(true)
@@ -51,11 +52,11 @@ MapObject::MapObject(const QString &name, const QString &type,
                      const QSizeF &size):
     Object(MapObjectType),
     mId(0),
+    mShape(Rectangle),
     mName(name),
     mType(type),
     mPos(pos),
     mSize(size),
-    mShape(Rectangle),
     mObjectGroup(nullptr),
     mRotation(0.0f),
     mVisible(true)
@@ -132,3 +133,12 @@ MapObject *MapObject::clone() const
     o->setRotation(mRotation);
     return o;
 }
+
+qint64 MapObject::memoryUsage() const
+{
+    return sizeof(MapObject) +
+            Tiled::memoryUsage(mName) +
+            Tiled::memoryUsage(mType) +
+            qint64(mPolygon.capacity()) * sizeof(QPointF) +
+            properties().memoryUsage();
+}
@@ -257,14 +257,22 @@ public:
      */
     MapObject *clone() const;
 
+    /**
+     * Returns the approximate number of bytes used by this object, including
+     * its properties.
+     */
+    qint64 memoryUsage() const;
+
 private:
+    // The members are ordered to avoid padding, since maps can contain a
+    // large number of objects
     int mId;
+    Shape mShape;
     QString mName;
     QString mType;
     QPointF mPos;
     QSizeF mSize;
     QPolygonF mPolygon;
-    Shape mShape;
     Cell mCell;
     ObjectGroup *mObjectGroup;
     qreal mRotation;
@@ -0,0 +1,237 @@
+/*
+ * mapobjectindex.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mapobjectindex.h"
+
+#include "mapobject.h"
+#include "tile.h"
+
+#include <QTransform>
+
+#include <cmath>
+
+using namespace Tiled;
+
+namespace {
+
+// The size of the grid cells, in pixels
+const qreal CellSize = 256;
+
+// Objects covering more cells than this are not put in the grid
+const int MaxCellsPerObject = 64;
+
+// Unlike QRectF::intersects, this also includes rectangles without a size
+inline bool touches(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() &&
+            a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+} // anonymous namespace
+
+MapObjectIndex::MapObjectIndex()
+{
+}
+
+void MapObjectIndex::clear()
+{
+    mCells.clear();
+    mBounds.clear();
+    mLargeObjects.clear();
+    mTileObjectMargin = QSizeF();
+}
+
+void MapObjectIndex::insert(MapObject *object)
+{
+    Q_ASSERT(!mBounds.contains(object));
+
+    const QRectF bounds = objectBounds(object);
+    mBounds.insert(object, bounds);
+
+    if (const Tile *tile = object->cell().tile) {
+        const QSizeF size = object->size();
+        const QPoint offset = tile->offset();
+        mTileObjectMargin = mTileObjectMargin.expandedTo(
+                    QSizeF(size.width() + std::abs(offset.x()),
+                           size.height() + std::abs(offset.y())));
+    }
+
+    const QRect range = cellRange(bounds);
+    if (qint64(range.width()) * range.height() > MaxCellsPerObject) {
+        mLargeObjects.append(object);
+        return;
+    }
+
+    for (int y = range.top(); y <= range.bottom(); ++y)
+        for (int x = range.left(); x <= range.right(); ++x)
+            mCells[QPoint(x, y)].append(object);
+}
+
+void MapObjectIndex::remove(MapObject *object)
+{
+    const auto it = mBounds.find(object);
+    if (it == mBounds.end())
+        return;
+
+    const QRect range = cellRange(it.value());
+    mBounds.erase(it);
+
+    if (qint64(range.width()) * range.height() > MaxCellsPerObject) {
+        mLargeObjects.removeOne(object);
+        return;
+    }
+
+    for (int y = range.top(); y <= range.bottom(); ++y) {
+        for (int x = range.left(); x <= range.right(); ++x) {
+            const auto cell = mCells.find(QPoint(x, y));
+            if (cell == mCells.end())
+                continue;
+
+            cell.value().removeOne(object);
+            if (cell.value().isEmpty())
+                mCells.erase(cell);
+        }
+    }
+}
+
+/**
+ * Updates the index for a change to the geometry of the given \a object.
+ * Does nothing for objects that are not in the index.
+ */
+void MapObjectIndex::update(MapObject *object)
+{
+    const auto it = mBounds.constFind(object);
+    if (it == mBounds.constEnd() || it.value() == objectBounds(object))
+        return;
+
+    remove(object);
+    insert(object);
+}
+
+/**
+ * Returns the objects whose bounds intersect the given \a rect, in no
+ * particular order. Objects without a size are included when they lie
+ * within or on the edge of \a rect.
+ */
+QList<MapObject*> MapObjectIndex::objectsIntersecting(const QRectF &rect) const
+{
+    QList<MapObject*> objects;
+
+    for (MapObject *object : mLargeObjects)
+        if (touches(mBounds.value(object), rect))
+            objects.append(object);
+
+    const QRect range = cellRange(rect);
+
+    auto addObjectsInCell = [&] (const QPoint &cellPos, const QVector<MapObject*> &cellObjects) {
+        for (MapObject *object : cellObjects) {
+            const QRectF &bounds = mBounds.value(object);
+            if (!touches(bounds, rect))
+                continue;
+
+            // Objects covering multiple cells are only reported for the
+            // first cell that is shared with the queried range
+            const QRect objectRange = cellRange(bounds);
+            if (cellPos.x() == qMax(objectRange.left(), range.left()) &&
+                    cellPos.y() == qMax(objectRange.top(), range.top()))
+                objects.append(object);
+        }
+    };
+
+    // Large queries are better served by iterating over the existing cells
+    if (qint64(range.width()) * range.height() > mCells.size()) {
+        for (auto it = mCells.constBegin(), end = mCells.constEnd(); it != end; ++it)
+            if (range.contains(it.key()))
+                addObjectsInCell(it.key(), it.value());
+    } else {
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                const QPoint cellPos(x, y);
+                const auto it = mCells.constFind(cellPos);
+                if (it != mCells.constEnd())
+                    addObjectsInCell(cellPos, it.value());
+            }
+        }
+    }
+
+    return objects;
+}
+
+/**
+ * Returns the bounds by which the given \a object is indexed, in pixel
+ * coordinates. This takes into account the rotation of the object.
+ *
+ * Tile objects are aligned differently depending on the orientation of the
+ * map, so their bounds are grown to cover both bottom-left and
+ * bottom-center alignment.
+ */
+QRectF MapObjectIndex::objectBounds(const MapObject *object)
+{
+    const QPointF &pos = object->position();
+    QRectF bounds;
+
+    if (const Tile *tile = object->cell().tile) {
+        const QSizeF size = object->size();
+        const QSize imageSize = tile->size();
+        QPointF offset = tile->offset();
+        if (!imageSize.isEmpty())
+            offset = QPointF(offset.x() * size.width() / imageSize.width(),
+                             offset.y() * size.height() / imageSize.height());
+
+        bounds = QRectF(pos.x() - size.width() / 2,
+                        pos.y() - size.height(),
+                        size.width() * 3 / 2,
+                        size.height()).translated(offset);
+    } else if (!object->polygon().isEmpty()) {
+        bounds = object->polygon().boundingRect().translated(pos);
+    } else {
+        bounds = object->bounds();
+    }
+
+    if (object->rotation() != 0) {
+        QTransform transform;
+        transform.translate(pos.x(), pos.y());
+        transform.rotate(object->rotation());
+        transform.translate(-pos.x(), -pos.y());
+        bounds = transform.mapRect(bounds);
+    }
+
+    return bounds;
+}
+
+QRect MapObjectIndex::cellRange(const QRectF &bounds) const
+{
+    // Limit the range to avoid overflows for huge query rectangles
+    const qreal limit = 1 << 20;
+    auto cell = [=] (qreal coordinate) {
+        return int(qBound(-limit, std::floor(coordinate / CellSize), limit));
+    };
+
+    return QRect(QPoint(cell(bounds.left()), cell(bounds.top())),
+                 QPoint(cell(bounds.right()), cell(bounds.bottom())));
+}
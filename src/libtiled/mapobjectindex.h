@@ -0,0 +1,90 @@
+/*
+ * mapobjectindex.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_MAPOBJECTINDEX_H
+#define TILED_MAPOBJECTINDEX_H
+
+#include "tiled_global.h"
+#include "tilemask.h"
+
+#include <QHash>
+#include <QList>
+#include <QRectF>
+#include <QSizeF>
+#include <QVector>
+
+namespace Tiled {
+
+class MapObject;
+
+/**
+ * A spatial index of map objects, used to quickly find the objects in a
+ * certain area.
+ *
+ * The objects are stored in a uniform grid of cells, in the pixel
+ * coordinates of the objects. Objects that would cover a large number of
+ * cells are kept in a separate list instead.
+ *
+ * The index doesn't notice changes to the objects by itself. It needs to be
+ * told about any objects that were changed through update().
+ */
+class TILEDSHARED_EXPORT MapObjectIndex
+{
+public:
+    MapObjectIndex();
+
+    bool isEmpty() const { return mBounds.isEmpty(); }
+    void clear();
+
+    void insert(MapObject *object);
+    void remove(MapObject *object);
+    void update(MapObject *object);
+
+    QList<MapObject*> objectsIntersecting(const QRectF &rect) const;
+
+    /**
+     * Returns how far beyond their indexed bounds tile objects may be drawn
+     * by renderers that don't display pixel coordinates one to one, like
+     * the isometric renderer. This can be used to grow a query rectangle.
+     */
+    QSizeF tileObjectMargin() const { return mTileObjectMargin; }
+
+    static QRectF objectBounds(const MapObject *object);
+
+private:
+    QRect cellRange(const QRectF &bounds) const;
+
+    QHash<QPoint, QVector<MapObject*>> mCells;
+    QHash<MapObject*, QRectF> mBounds;
+    QVector<MapObject*> mLargeObjects;
+    QSizeF mTileObjectMargin;
+};
+
+} // namespace Tiled
+
+#endif // TILED_MAPOBJECTINDEX_H
@@ -31,23 +31,36 @@
 #include "mapreader.h"
 
 #include "compression.h"
+#include "csvparser.h"
 #include "gidmapper.h"
+#include "imagecache.h"
 #include "imagelayer.h"
+#include "mapcache.h"
 #include "objectgroup.h"
 #include "map.h"
 #include "mapobject.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tilesetcache.h"
 #include "tilesetformat.h"
 #include "terrain.h"
+#include "tracing.h"
 
+#include <QAtomicInt>
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
+#include <QImageReader>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QVector>
 #include <QXmlStreamReader>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -64,10 +77,136 @@ struct TmxImage {
         if (source.isEmpty())
             return QImage::fromData(data, format);
         else
-            return QImage(source);
+            return ImageCache::loadImage(source);
     }
 };
 
+/**
+ * The encoded data of a tile layer, which is decoded after the XML has been
+ * parsed. This allows the layers to be decoded in parallel.
+ */
+class PendingLayerData : public QRunnable
+{
+public:
+    PendingLayerData(const GidMapper &gidMapper,
+                     TileLayer *tileLayer,
+                     const QByteArray &data,
+                     Map::LayerDataFormat format,
+                     qint64 lineNumber,
+                     qint64 columnNumber)
+        : gidMapper(gidMapper)
+        , tileLayer(tileLayer)
+        , data(data)
+        , cachedData(nullptr)
+        , format(format)
+        , lineNumber(lineNumber)
+        , columnNumber(columnNumber)
+        , error(GidMapper::NoError)
+        , mapped(false)
+        , deferred(false)
+        , canceled(nullptr)
+    {
+        setAutoDelete(false);
+    }
+
+    /**
+     * Constructs pending layer data for gids found in the map cache.
+     */
+    PendingLayerData(const GidMapper &gidMapper,
+                     TileLayer *tileLayer,
+                     const uchar *cachedData,
+                     qint64 lineNumber,
+                     qint64 columnNumber)
+        : gidMapper(gidMapper)
+        , tileLayer(tileLayer)
+        , cachedData(cachedData)
+        , format(Map::Base64)
+        , lineNumber(lineNumber)
+        , columnNumber(columnNumber)
+        , error(GidMapper::NoError)
+        , mapped(false)
+        , deferred(false)
+        , canceled(nullptr)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        if (canceled && canceled->loadAcquire()) {
+            data.clear();
+            return;
+        }
+
+        if (deferred) {
+            // Only check the size of the data, its cells are decoded when needed
+            const int cellCount = tileLayer->width() * tileLayer->height();
+            if (!GidMapper::isLayerDataComplete(data, format, cellCount))
+                error = GidMapper::CorruptLayerData;
+            return;
+        }
+
+        if (cachedData)
+            error = gidMapper.decodeLayerData(*tileLayer, cachedData);
+        else
+            error = gidMapper.decodeLayerData(*tileLayer, data, format);
+        data.clear();
+    }
+
+    GidMapper gidMapper;    // copy, since it tracks the invalid tile
+    TileLayer *tileLayer;
+    QByteArray data;
+    const uchar *cachedData;
+    Map::LayerDataFormat format;
+    qint64 lineNumber;
+    qint64 columnNumber;
+    GidMapper::DecodeError error;
+    bool mapped;            // data refers to the mapped file
+    bool deferred;          // decoding is deferred until the cells are used
+    const QAtomicInt *canceled;
+};
+
+/**
+ * A tileset image that is decoded on a worker thread while the rest of the
+ * file is being read. The tiles of its tileset are already set up based on
+ * the image size stored in the file.
+ */
+class PendingTilesetImage : public QRunnable
+{
+public:
+    PendingTilesetImage(const SharedTileset &tileset,
+                        const TmxImage &tmxImage,
+                        qint64 lineNumber,
+                        qint64 columnNumber)
+        : tileset(tileset)
+        , tmxImage(tmxImage)
+        , lineNumber(lineNumber)
+        , columnNumber(columnNumber)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        image = tmxImage.create();
+    }
+
+    SharedTileset tileset;
+    TmxImage tmxImage;
+    QImage image;
+    qint64 lineNumber;
+    qint64 columnNumber;
+};
+
+/**
+ * A pixmap to create once the map has been read. Pixmaps of image layers
+ * have no tileset.
+ */
+struct DeferredPixmap {
+    const Tileset *tileset;
+    std::function<void()> create;
+};
+
 class MapReaderPrivate
 {
     Q_DECLARE_TR_FUNCTIONS(MapReader)
@@ -78,33 +217,55 @@ public:
     MapReaderPrivate(MapReader *mapReader):
         p(mapReader),
         mMap(nullptr),
-        mReadingExternalTileset(false)
+        mReadingExternalTileset(false),
+        mLazyLoadingEnabled(false),
+        mCacheEnabled(false),
+        mTilesetCacheEnabled(false),
+        mPixmapCreationDeferred(false),
+        mImageLoadingDeferred(false),
+        mCache(nullptr),
+        mCacheChecked(false),
+        mTileLayerIndex(0),
+        mCachedLayerCount(0),
+        mMappedPos(0),
+        mMappedDataBegin(0),
+        mMappedDataEnd(0)
     {}
 
     Map *readMap(QIODevice *device, const QString &path);
     SharedTileset readTileset(QIODevice *device, const QString &path);
 
     bool openFile(QFile *file);
+    void mapFile(QFile *file);
 
     QString errorString() const;
 
 private:
     void readUnknownElement();
+    bool skipExcludedLayer();
+    bool reportProgress();
 
     Map *readMap();
 
     SharedTileset readTileset();
     void readTilesetTile(SharedTileset &tileset);
     void readTilesetImage(SharedTileset &tileset);
+    void loadPendingTilesetImages();
     void readTilesetTerrainTypes(SharedTileset &tileset);
     TmxImage readImage();
 
     TileLayer *readLayer();
     void readLayerData(TileLayer *tileLayer);
-    void decodeBinaryLayerData(TileLayer *tileLayer,
-                               const QByteArray &data,
-                               Map::LayerDataFormat format);
-    void decodeCSVLayerData(TileLayer *tileLayer, const QString &text);
+    void readChunk(TileLayer *tileLayer, Map::LayerDataFormat format);
+    bool readCachedLayerData(TileLayer *tileLayer);
+    void findMappedLayerData();
+    QByteArray mappedLayerData(const QStringRef &text) const;
+    void decodePendingLayerData();
+    void deferHiddenLayerData();
+    static QString layerDataErrorString(const TileLayer *tileLayer,
+                                        GidMapper::DecodeError error,
+                                        unsigned invalidTile);
+    void decodeCSVLayerData(TileLayer *tileLayer, const QStringRef &text);
 
     /**
      * Returns the cell for the given global tile ID. Errors are raised with
@@ -133,7 +294,31 @@ private:
     QString mPath;
     Map *mMap;
     GidMapper mGidMapper;
+    StringTable mStrings;
     bool mReadingExternalTileset;
+    QList<PendingLayerData*> mPendingLayerData;
+    QList<PendingTilesetImage*> mPendingTilesetImages;
+    QThreadPool mImagePool;
+
+    bool mLazyLoadingEnabled;
+    bool mCacheEnabled;
+    bool mTilesetCacheEnabled;
+    bool mPixmapCreationDeferred;
+    QList<DeferredPixmap> mDeferredPixmaps;
+    bool mImageLoadingDeferred;
+    MapReadOptions mReadOptions;
+    QAtomicInt mCanceled;
+    MapCache *mCache;
+    bool mCacheChecked;
+    GidMapper mCacheGidMapper;
+    int mTileLayerIndex;
+    int mCachedLayerCount;
+
+    // The file being read, when it could be mapped into memory
+    QByteArray mMappedFile;
+    int mMappedPos;
+    int mMappedDataBegin;
+    int mMappedDataEnd;
 
     QXmlStreamReader xml;
 };
@@ -145,6 +330,10 @@ Map *MapReaderPrivate::readMap(QIODevice *device, const QString &path)
 {
     mError.clear();
     mPath = path;
+    mCacheChecked = false;
+    mTileLayerIndex = 0;
+    mCachedLayerCount = 0;
+    mCanceled.storeRelease(0);
     Map *map = nullptr;
 
     xml.setDevice(device);
@@ -156,6 +345,9 @@ Map *MapReaderPrivate::readMap(QIODevice *device, const QString &path)
     }
 
     mGidMapper.clear();
+    mCacheGidMapper.clear();
+    mStrings.clear();
+    mMappedFile.clear();
     return map;
 }
 
@@ -173,7 +365,10 @@ SharedTileset MapReaderPrivate::readTileset(QIODevice *device, const QString &pa
     else
         xml.raiseError(tr("Not a tileset file."));
 
+    loadPendingTilesetImages();
+
     mReadingExternalTileset = false;
+    mStrings.clear();
     return tileset;
 }
 
@@ -202,6 +397,26 @@ bool MapReaderPrivate::openFile(QFile *file)
     return true;
 }
 
+/**
+ * Maps the given \a file into memory, so that the base64 encoded layer data
+ * can be decoded from the mapped bytes rather than being copied out of the
+ * XML reader. Reading works the same when the file can't be mapped.
+ */
+void MapReaderPrivate::mapFile(QFile *file)
+{
+    const qint64 size = file->size();
+    if (size <= 0 || size > std::numeric_limits<int>::max())
+        return;
+
+    if (const uchar *data = file->map(0, size)) {
+        mMappedFile = QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                              int(size));
+        mMappedPos = 0;
+        mMappedDataBegin = 0;
+        mMappedDataEnd = 0;
+    }
+}
+
 void MapReaderPrivate::readUnknownElement()
 {
     qDebug().nospace() << "Unknown element (fixme): " << xml.name()
@@ -210,6 +425,38 @@ void MapReaderPrivate::readUnknownElement()
     xml.skipCurrentElement();
 }
 
+/**
+ * Skips the current layer element when the read options don't include it.
+ */
+bool MapReaderPrivate::skipExcludedLayer()
+{
+    const QString name = xml.attributes().value(QLatin1String("name")).toString();
+    if (mReadOptions.includesLayer(name))
+        return false;
+
+    xml.skipCurrentElement();
+    return true;
+}
+
+/**
+ * Reports the number of bytes read so far. Returns false when reading
+ * should be cancelled, in which case any layer data that is still being
+ * decoded is dropped as well.
+ */
+bool MapReaderPrivate::reportProgress()
+{
+    if (!mReadOptions.progress)
+        return true;
+
+    QIODevice *device = xml.device();
+    const qint64 total = device->isSequential() ? -1 : device->size();
+    if (mReadOptions.reportProgress(device->pos(), total))
+        return true;
+
+    mCanceled.storeRelease(1);
+    return false;
+}
+
 Map *MapReaderPrivate::readMap()
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("map"));
@@ -254,7 +501,11 @@ Map *MapReaderPrivate::readMap()
     const int nextObjectId =
             atts.value(QLatin1String("nextobjectid")).toInt();
 
+    const bool infinite =
+            atts.value(QLatin1String("infinite")).toInt() == 1;
+
     mMap = new Map(orientation, mapWidth, mapHeight, tileWidth, tileHeight);
+    mMap->setInfinite(infinite);
     mMap->setHexSideLength(hexSideLength);
     mMap->setStaggerAxis(staggerAxis);
     mMap->setStaggerIndex(staggerIndex);
@@ -266,21 +517,47 @@ Map *MapReaderPrivate::readMap()
     if (!bgColorString.isEmpty())
         mMap->setBackgroundColor(QColor(bgColorString.toString()));
 
+    // Layers are only added to the map once their data has been decoded,
+    // since decoding may happen in parallel.
+    QList<Layer*> layers;
+
     while (xml.readNextStartElement()) {
         if (xml.name() == QLatin1String("properties"))
             mMap->mergeProperties(readProperties());
         else if (xml.name() == QLatin1String("tileset"))
             mMap->addTileset(readTileset());
-        else if (xml.name() == QLatin1String("layer"))
-            mMap->addLayer(readLayer());
-        else if (xml.name() == QLatin1String("objectgroup"))
-            mMap->addLayer(readObjectGroup());
-        else if (xml.name() == QLatin1String("imagelayer"))
-            mMap->addLayer(readImageLayer());
-        else
+        else if (xml.name() == QLatin1String("layer")) {
+            if (skipExcludedLayer())
+                ++mTileLayerIndex;
+            else
+                layers.append(readLayer());
+        } else if (xml.name() == QLatin1String("objectgroup")) {
+            if (!skipExcludedLayer())
+                layers.append(readObjectGroup());
+        } else if (xml.name() == QLatin1String("imagelayer")) {
+            if (!skipExcludedLayer())
+                layers.append(readImageLayer());
+        } else
             readUnknownElement();
+
+        if (!reportProgress()) {
+            xml.raiseError(tr("Reading the map was cancelled."));
+            break;
+        }
     }
 
+    // The tileset images need to be loaded first, since the layer data
+    // depends on the actual column count of the tilesets
+    loadPendingTilesetImages();
+    decodePendingLayerData();
+
+    for (Layer *layer : layers)
+        mMap->addLayer(layer);
+
+    // Drop the tiles outside of the region that was asked for
+    if (!mReadOptions.region.isNull())
+        mReadOptions.applyTo(mMap);
+
     // Clean up in case of error
     if (xml.hasError()) {
         delete mMap;
@@ -419,11 +696,26 @@ void MapReaderPrivate::readTilesetTile(SharedTileset &tileset)
             tile->mergeProperties(readProperties());
         } else if (xml.name() == QLatin1String("image")) {
             TmxImage tmxImage = readImage();
+
+            if (!tmxImage.source.isEmpty() && !isImageDecodingEnabled()) {
+                if (!tileset->loadTileImage(id, tmxImage.source))
+                    xml.raiseError(tr("Error loading image:\n'%1'").arg(tmxImage.source));
+                continue;
+            }
+
             QImage image = tmxImage.create();
             if (image.isNull())
                 xml.raiseError(tr("Error loading image:\n'%1'").arg(tmxImage.source));
-            tileset->setTileImage(id, QPixmap::fromImage(image),
-                                  tmxImage.source);
+
+            if (mPixmapCreationDeferred) {
+                const QString source = tmxImage.source;
+                mDeferredPixmaps.append({ tileset.data(), [tileset, id, image, source] {
+                    tileset->setTileImage(id, QPixmap::fromImage(image), source);
+                }});
+            } else {
+                tileset->setTileImage(id, QPixmap::fromImage(image),
+                                      tmxImage.source);
+            }
         } else if (xml.name() == QLatin1String("objectgroup")) {
             tile->setObjectGroup(readObjectGroup());
         } else if (xml.name() == QLatin1String("animation")) {
@@ -465,13 +757,111 @@ void MapReaderPrivate::readTilesetImage(SharedTileset &tileset)
     const int width = atts.value(QLatin1String("width")).toInt();
     mGidMapper.setTilesetWidth(tileset.data(), width);
 
+    const int height = atts.value(QLatin1String("height")).toInt();
+    const qint64 lineNumber = xml.lineNumber();
+    const qint64 columnNumber = xml.columnNumber();
+
     TmxImage image = readImage();
     tileset->setTransparentColor(image.transparentColor);
 
-    if (!tileset->loadFromImage(image.create(), image.source))
+    // Only the size is needed when the image is loaded on first use, which
+    // is read from the image header when it wasn't stored
+    if (mImageLoadingDeferred && !image.source.isEmpty()) {
+        QSize imageSize(width, height);
+        if (imageSize.isEmpty())
+            imageSize = QImageReader(image.source).size();
+
+        if (imageSize.isValid())
+            tileset->prepareUnloadedImage(imageSize, image.source);
+        else
+            xml.raiseError(tr("Error loading tileset image:\n'%1'").arg(image.source));
+        return;
+    }
+
+    // When the image size is known, the tiles are set up right away and the
+    // image is decoded while reading the rest of the file
+    if (width > 0 && height > 0) {
+        tileset->prepareImage(QSize(width, height), image.source);
+
+        if (!image.source.isEmpty() && !isImageDecodingEnabled())
+            return;
+
+        PendingTilesetImage *pending = new PendingTilesetImage(tileset,
+                                                               image,
+                                                               lineNumber,
+                                                               columnNumber);
+        mPendingTilesetImages.append(pending);
+        mImagePool.start(pending);
+        return;
+    }
+
+    if (!image.source.isEmpty() && !isImageDecodingEnabled()) {
+        if (!tileset->loadFromImage(image.source))
+            xml.raiseError(tr("Error loading tileset image:\n'%1'").arg(image.source));
+        return;
+    }
+
+    const QImage decodedImage = image.create();
+
+    if (mPixmapCreationDeferred && !decodedImage.isNull()) {
+        const QString source = image.source;
+        tileset->prepareImage(decodedImage.size(), source);
+        mDeferredPixmaps.append({ tileset.data(), [tileset, decodedImage, source] {
+            tileset->loadFromImage(decodedImage, source);
+        }});
+        return;
+    }
+
+    if (!tileset->loadFromImage(decodedImage, image.source))
         xml.raiseError(tr("Error loading tileset image:\n'%1'").arg(image.source));
 }
 
+/**
+ * Waits for the tileset images that are being decoded and loads them into
+ * their tilesets. This needs to happen on the main thread, since it creates
+ * pixmaps. When the creation of pixmaps is deferred, the images are only
+ * checked here and loaded by MapReader::createDeferredPixmaps().
+ *
+ * Errors are reported for the first image that failed to load, along with
+ * the position of its image element in the file.
+ */
+void MapReaderPrivate::loadPendingTilesetImages()
+{
+    mImagePool.waitForDone();
+
+    for (PendingTilesetImage *pending : mPendingTilesetImages) {
+        const QString &source = pending->tmxImage.source;
+
+        if (mPixmapCreationDeferred) {
+            if (!pending->image.isNull()) {
+                const SharedTileset tileset = pending->tileset;
+                const QImage image = pending->image;
+                mDeferredPixmaps.append({ tileset.data(), [tileset, image, source] {
+                    tileset->loadFromImage(image, source);
+                }});
+                continue;
+            }
+        } else if (pending->tileset->loadFromImage(pending->image, source)) {
+            continue;
+        }
+
+        if (!xml.hasError()) {
+            const QString message = tr("Error loading tileset image:\n'%1'").arg(source);
+
+            mError = tr("%3\n\nLine %1, column %2")
+                    .arg(pending->lineNumber)
+                    .arg(pending->columnNumber)
+                    .arg(message);
+
+            xml.raiseError(message);
+        }
+        break;
+    }
+
+    qDeleteAll(mPendingTilesetImages);
+    mPendingTilesetImages.clear();
+}
+
 TmxImage MapReaderPrivate::readImage()
 {
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("image"));
@@ -571,6 +961,10 @@ TileLayer *MapReaderPrivate::readLayer()
     TileLayer *tileLayer = new TileLayer(name, x, y, width, height);
     readLayerAttributes(tileLayer, atts);
 
+    // The chunks of infinite maps may lie outside of the layer bounds
+    if (mMap->infinite())
+        tileLayer->setMap(mMap);
+
     while (xml.readNextStartElement()) {
         if (xml.name() == QLatin1String("properties"))
             tileLayer->mergeProperties(readProperties());
@@ -580,6 +974,8 @@ TileLayer *MapReaderPrivate::readLayer()
             readUnknownElement();
     }
 
+    ++mTileLayerIndex;
+
     return tileLayer;
 }
 
@@ -603,6 +999,10 @@ void MapReaderPrivate::readLayerData(TileLayer *tileLayer)
             layerDataFormat = Map::Base64Gzip;
         } else if (compression == QLatin1String("zlib")) {
             layerDataFormat = Map::Base64Zlib;
+        } else if (compression == QLatin1String("zstd") && compressionSupported(Zstandard)) {
+            layerDataFormat = Map::Base64Zstandard;
+        } else if (compression == QLatin1String("lz4") && compressionSupported(Lz4)) {
+            layerDataFormat = Map::Base64Lz4;
         } else {
             xml.raiseError(tr("Compression method '%1' not supported")
                            .arg(compression.toString()));
@@ -614,6 +1014,15 @@ void MapReaderPrivate::readLayerData(TileLayer *tileLayer)
     }
     mMap->setLayerDataFormat(layerDataFormat);
 
+    if (!mMappedFile.isNull())
+        findMappedLayerData();
+
+    if (readCachedLayerData(tileLayer)) {
+        xml.skipCurrentElement();
+        return;
+    }
+
+    TileLayer::BulkEdit bulkEdit(tileLayer);
     int x = 0;
     int y = 0;
 
@@ -638,66 +1047,374 @@ void MapReaderPrivate::readLayerData(TileLayer *tileLayer)
                 }
 
                 xml.skipCurrentElement();
+            } else if (xml.name() == QLatin1String("chunk")) {
+                readChunk(tileLayer, layerDataFormat);
             } else {
                 readUnknownElement();
             }
         } else if (xml.isCharacters() && !xml.isWhitespace()) {
             if (encoding == QLatin1String("base64")) {
-                decodeBinaryLayerData(tileLayer,
-                                      xml.text().toLatin1(),
-                                      layerDataFormat);
+                QByteArray data = mappedLayerData(xml.text());
+                const bool mapped = !data.isNull();
+                if (!mapped)
+                    data = xml.text().toLatin1();
+
+                PendingLayerData *pending = new PendingLayerData(mGidMapper,
+                                                                 tileLayer,
+                                                                 data,
+                                                                 layerDataFormat,
+                                                                 xml.lineNumber(),
+                                                                 xml.columnNumber());
+                pending->mapped = mapped;
+                mPendingLayerData.append(pending);
             } else if (encoding == QLatin1String("csv")) {
-                decodeCSVLayerData(tileLayer, xml.text().toString());
+                decodeCSVLayerData(tileLayer, xml.text());
             }
         }
     }
 }
 
-void MapReaderPrivate::decodeBinaryLayerData(TileLayer *tileLayer,
-                                             const QByteArray &data,
-                                             Map::LayerDataFormat format)
+/**
+ * Reads a chunk of the cells of an infinite tile layer. The chunk is decoded
+ * right away into a layer of its own size, of which the cells are then
+ * placed at the position of the chunk.
+ */
+void MapReaderPrivate::readChunk(TileLayer *tileLayer, Map::LayerDataFormat format)
 {
-    GidMapper::DecodeError error = mGidMapper.decodeLayerData(*tileLayer, data, format);
+    Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("chunk"));
 
-    switch (error) {
-    case GidMapper::CorruptLayerData:
-        xml.raiseError(tr("Corrupt layer data for layer '%1'").arg(tileLayer->name()));
+    const QXmlStreamAttributes atts = xml.attributes();
+    const int x = atts.value(QLatin1String("x")).toInt();
+    const int y = atts.value(QLatin1String("y")).toInt();
+    const int width = atts.value(QLatin1String("width")).toInt();
+    const int height = atts.value(QLatin1String("height")).toInt();
+
+    if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF) {
+        xml.raiseError(tr("Invalid chunk size in layer '%1'").arg(tileLayer->name()));
         return;
-    case GidMapper::TileButNoTilesets:
-        xml.raiseError(tr("Tile used but no tilesets specified"));
+    }
+
+    TileLayer chunk(tileLayer->name(), 0, 0, width, height);
+    int index = 0;
+
+    while (xml.readNext() != QXmlStreamReader::Invalid) {
+        if (xml.isEndElement()) {
+            break;
+        } else if (xml.isStartElement()) {
+            if (xml.name() == QLatin1String("tile")) {
+                if (index >= width * height) {
+                    xml.raiseError(tr("Too many <tile> elements"));
+                    continue;
+                }
+
+                const QXmlStreamAttributes atts = xml.attributes();
+                unsigned gid = atts.value(QLatin1String("gid")).toUInt();
+                chunk.setCell(index % width, index / width, cellForGid(gid));
+                ++index;
+
+                xml.skipCurrentElement();
+            } else {
+                readUnknownElement();
+            }
+        } else if (xml.isCharacters() && !xml.isWhitespace()) {
+            if (format == Map::CSV) {
+                decodeCSVLayerData(&chunk, xml.text());
+            } else if (format != Map::XML) {
+                const GidMapper::DecodeError error =
+                        mGidMapper.decodeLayerData(chunk, xml.text().toLatin1(), format);
+
+                if (error != GidMapper::NoError) {
+                    xml.raiseError(layerDataErrorString(&chunk, error,
+                                                        mGidMapper.invalidTile()));
+                }
+            }
+        }
+    }
+
+    tileLayer->mergeCells(QPoint(x, y), &chunk, QRect(0, 0, width, height));
+}
+
+static bool isXmlSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * Finds the contents of the data element that is being read in the mapped
+ * file. The file is searched from the end of the previous data element.
+ */
+void MapReaderPrivate::findMappedLayerData()
+{
+    const char *file = mMappedFile.constData();
+    const int size = mMappedFile.size();
+
+    mMappedDataBegin = mMappedDataEnd = 0;
+
+    int pos = mMappedPos;
+    while ((pos = mMappedFile.indexOf("<data", pos)) != -1) {
+        pos += 5;
+        if (pos < size && (file[pos] == '>' || isXmlSpace(file[pos])))
+            break;
+    }
+    if (pos == -1)
         return;
-    case GidMapper::InvalidTile:
-        xml.raiseError(tr("Invalid tile: %1").arg(mGidMapper.invalidTile()));
+
+    const int tagEnd = mMappedFile.indexOf('>', pos);
+    if (tagEnd == -1)
         return;
-    case GidMapper::NoError:
-        break;
+
+    mMappedPos = tagEnd + 1;
+    if (file[tagEnd - 1] == '/')   // empty element
+        return;
+
+    const int end = mMappedFile.indexOf('<', tagEnd);
+    if (end == -1)
+        return;
+
+    mMappedDataBegin = tagEnd + 1;
+    mMappedDataEnd = end;
+    mMappedPos = end;
+}
+
+/**
+ * Returns the given base64 encoded \a text as found in the mapped file, or a
+ * null byte array when it was not found as is. This is the case when the
+ * file is not mapped or when the text uses entities, CDATA sections or
+ * different line endings.
+ *
+ * The returned data refers to the mapped file.
+ */
+QByteArray MapReaderPrivate::mappedLayerData(const QStringRef &text) const
+{
+    const char *file = mMappedFile.constData();
+    int begin = mMappedDataBegin;
+    int end = mMappedDataEnd;
+
+    while (begin < end && isXmlSpace(file[begin]))
+        ++begin;
+    while (end > begin && isXmlSpace(file[end - 1]))
+        --end;
+
+    const QStringRef trimmed = text.trimmed();
+    if (trimmed.isEmpty() || trimmed.size() != end - begin)
+        return QByteArray();
+
+    const QChar *chars = trimmed.unicode();
+    for (int i = 0, length = trimmed.size(); i < length; ++i)
+        if (chars[i].unicode() != uchar(file[begin + i]))
+            return QByteArray();
+
+    return QByteArray::fromRawData(file + begin, end - begin);
+}
+
+/**
+ * Looks up the data of the given \a tileLayer in the map cache, scheduling
+ * it to be decoded along with the other layers when found.
+ *
+ * The cache is checked against the tilesets of the map when it is first
+ * used. Since tilesets come before the layers, all of them are known then.
+ */
+bool MapReaderPrivate::readCachedLayerData(TileLayer *tileLayer)
+{
+    // The cache only covers the bounds of the layers
+    if (!mCache || mMap->infinite())
+        return false;
+
+    if (!mCacheChecked) {
+        mCacheChecked = true;
+
+        if (mCache->open() && mCache->matchesTilesets(mMap->tilesets()))
+            mCacheGidMapper = GidMapper(mMap->tilesets());
+        else
+            mCacheGidMapper.clear();
     }
+
+    if (mCacheGidMapper.isEmpty())
+        return false;
+
+    const uchar *data = mCache->tileLayerData(mTileLayerIndex,
+                                              tileLayer->width(),
+                                              tileLayer->height());
+    if (!data)
+        return false;
+
+    mPendingLayerData.append(new PendingLayerData(mCacheGidMapper,
+                                                  tileLayer,
+                                                  data,
+                                                  xml.lineNumber(),
+                                                  xml.columnNumber()));
+    ++mCachedLayerCount;
+    return true;
 }
 
-void MapReaderPrivate::decodeCSVLayerData(TileLayer *tileLayer, const QString &text)
+/**
+ * Decodes the layer data that was collected while reading the map, using
+ * multiple threads when there is more than one layer to decode.
+ *
+ * Errors are reported for the first layer that failed to decode, along with
+ * the position of its data in the file, so that they look the same as when
+ * the data would have been decoded while reading.
+ */
+void MapReaderPrivate::decodePendingLayerData()
 {
-    QString trimText = text.trimmed();
-    QStringList tiles = trimText.split(QLatin1Char(','));
+    for (PendingLayerData *pending : mPendingLayerData) {
+        pending->canceled = &mCanceled;
+
+        // Data read from the map cache is always decoded, since the cache is
+        // only mapped while reading the map
+        if (mLazyLoadingEnabled && !pending->tileLayer->isVisible() && !pending->cachedData) {
+            pending->deferred = true;
+
+            // The mapped file is unmapped once the map has been read
+            if (pending->mapped) {
+                pending->data = QByteArray(pending->data.constData(),
+                                           pending->data.size());
+                pending->mapped = false;
+            }
+        }
+    }
 
-    if (tiles.length() != tileLayer->width() * tileLayer->height()) {
-        xml.raiseError(tr("Corrupt layer data for layer '%1'")
-                       .arg(tileLayer->name()));
+    if (mPendingLayerData.size() == 1) {
+        mPendingLayerData.first()->run();
+    } else if (mPendingLayerData.size() > 1) {
+        QThreadPool pool;
+        for (PendingLayerData *pending : mPendingLayerData)
+            pool.start(pending);
+
+        // Layers that didn't start decoding yet are skipped when reading
+        // gets cancelled in the meantime
+        while (!pool.waitForDone(100))
+            reportProgress();
+    }
+
+    if (mCanceled.loadAcquire()) {
+        if (!xml.hasError())
+            xml.raiseError(tr("Reading the map was cancelled."));
+
+        qDeleteAll(mPendingLayerData);
+        mPendingLayerData.clear();
         return;
     }
 
-    for (int y = 0; y < tileLayer->height(); y++) {
-        for (int x = 0; x < tileLayer->width(); x++) {
-            bool conversionOk;
-            const unsigned gid = tiles.at(y * tileLayer->width() + x)
-                    .toUInt(&conversionOk);
-            if (!conversionOk) {
-                xml.raiseError(
-                        tr("Unable to parse tile at (%1,%2) on layer '%3'")
-                               .arg(x + 1).arg(y + 1).arg(tileLayer->name()));
-                return;
+    bool failed = false;
+
+    for (const PendingLayerData *pending : mPendingLayerData) {
+        if (pending->error == GidMapper::NoError)
+            continue;
+
+        failed = true;
+
+        const QString message = layerDataErrorString(pending->tileLayer,
+                                                     pending->error,
+                                                     pending->gidMapper.invalidTile());
+
+        // Any XML error will have been further down in the file
+        mError = tr("%3\n\nLine %1, column %2")
+                .arg(pending->lineNumber)
+                .arg(pending->columnNumber)
+                .arg(message);
+
+        if (!xml.hasError())
+            xml.raiseError(message);
+        break;
+    }
+
+    if (!failed)
+        deferHiddenLayerData();
+
+    qDeleteAll(mPendingLayerData);
+    mPendingLayerData.clear();
+}
+
+/**
+ * Leaves the decoding of hidden layers until their cells are accessed. Their
+ * data is kept in its encoded form, which is usually much smaller than the
+ * decoded cells.
+ *
+ * The size of the data of these layers has already been checked, so that
+ * truncated or corrupt data fails the read just like for visible layers,
+ * instead of resulting in an empty layer that would be written back when
+ * saving the map. Invalid tiles are only found when the cells are decoded,
+ * in which case a warning is printed and the layer keeps the cells decoded
+ * up to the invalid tile.
+ */
+void MapReaderPrivate::deferHiddenLayerData()
+{
+    for (const PendingLayerData *pending : mPendingLayerData) {
+        if (!pending->deferred)
+            continue;
+
+        const GidMapper gidMapper = pending->gidMapper;
+        const QByteArray data = pending->data;
+        const Map::LayerDataFormat format = pending->format;
+
+        pending->tileLayer->setCellLoader([=] (TileLayer &tileLayer) {
+            // Copy, since it tracks the invalid tile
+            GidMapper mapper = gidMapper;
+
+            const GidMapper::DecodeError error =
+                    mapper.decodeLayerData(tileLayer, data, format);
+
+            if (error != GidMapper::NoError) {
+                const QString message = layerDataErrorString(&tileLayer, error,
+                                                             mapper.invalidTile());
+                qWarning("Failed to load the cells of layer '%s': %s",
+                         qPrintable(tileLayer.name()), qPrintable(message));
             }
-            tileLayer->setCell(x, y, cellForGid(gid));
+        });
+    }
+}
+
+QString MapReaderPrivate::layerDataErrorString(const TileLayer *tileLayer,
+                                               GidMapper::DecodeError error,
+                                               unsigned invalidTile)
+{
+    switch (error) {
+    case GidMapper::CorruptLayerData:
+        return tr("Corrupt layer data for layer '%1'").arg(tileLayer->name());
+    case GidMapper::TileButNoTilesets:
+        return tr("Tile used but no tilesets specified");
+    case GidMapper::InvalidTile:
+        return tr("Invalid tile: %1").arg(invalidTile);
+    case GidMapper::NoError:
+        break;
+    }
+
+    return QString();
+}
+
+void MapReaderPrivate::decodeCSVLayerData(TileLayer *tileLayer, const QStringRef &text)
+{
+    CsvParser<QChar> parser(text.constData(), text.constData() + text.size());
+
+    const int width = tileLayer->width();
+    const int count = width * tileLayer->height();
+    int index = 0;
+    int invalidIndex = -1;
+    unsigned gid;
+    bool conversionOk;
+
+    TileLayer::BulkEdit bulkEdit(tileLayer);
+
+    while (parser.next(gid, conversionOk)) {
+        if (index < count && invalidIndex == -1) {
+            if (conversionOk)
+                tileLayer->setCell(index % width, index / width, cellForGid(gid));
+            else
+                invalidIndex = index;
         }
+        ++index;
+    }
+
+    if (index != count) {
+        xml.raiseError(tr("Corrupt layer data for layer '%1'")
+                       .arg(tileLayer->name()));
+    } else if (invalidIndex != -1) {
+        xml.raiseError(
+                tr("Unable to parse tile at (%1,%2) on layer '%3'")
+                       .arg(invalidIndex % width + 1)
+                       .arg(invalidIndex / width + 1)
+                       .arg(tileLayer->name()));
     }
 }
 
@@ -799,9 +1516,22 @@ void MapReaderPrivate::readImageLayerImage(ImageLayer *imageLayer)
 
     source = p->resolveReference(source, mPath);
 
+    if (!isImageDecodingEnabled()) {
+        if (!imageLayer->loadFromImage(source))
+            xml.raiseError(tr("Error loading image layer image:\n'%1'").arg(source));
+        xml.skipCurrentElement();
+        return;
+    }
+
     const QImage imageLayerImage(source);
-    if (!imageLayer->loadFromImage(imageLayerImage, source))
+
+    if (mPixmapCreationDeferred && !imageLayerImage.isNull()) {
+        mDeferredPixmaps.append({ nullptr, [imageLayer, imageLayerImage, source] {
+            imageLayer->loadFromImage(imageLayerImage, source);
+        }});
+    } else if (!imageLayer->loadFromImage(imageLayerImage, source)) {
         xml.raiseError(tr("Error loading image layer image:\n'%1'").arg(source));
+    }
 
     xml.skipCurrentElement();
 }
@@ -812,19 +1542,21 @@ MapObject *MapReaderPrivate::readObject()
 
     const QXmlStreamAttributes atts = xml.attributes();
     const int id = atts.value(QLatin1String("id")).toInt();
-    const QString name = atts.value(QLatin1String("name")).toString();
+    const QStringRef name = atts.value(QLatin1String("name"));
     const unsigned gid = atts.value(QLatin1String("gid")).toUInt();
     const qreal x = atts.value(QLatin1String("x")).toDouble();
     const qreal y = atts.value(QLatin1String("y")).toDouble();
     const qreal width = atts.value(QLatin1String("width")).toDouble();
     const qreal height = atts.value(QLatin1String("height")).toDouble();
-    const QString type = atts.value(QLatin1String("type")).toString();
+    const QStringRef type = atts.value(QLatin1String("type"));
     const QStringRef visibleRef = atts.value(QLatin1String("visible"));
 
     const QPointF pos(x, y);
     const QSizeF size(width, height);
 
-    MapObject *object = new MapObject(name, type, pos, size);
+    MapObject *object = new MapObject(mStrings.intern(name),
+                                      mStrings.intern(type),
+                                      pos, size);
     object->setId(id);
 
     bool ok;
@@ -874,14 +1606,27 @@ QPolygonF MapReaderPrivate::readPolygon()
                                       xml.name() == QLatin1String("polyline")));
 
     const QXmlStreamAttributes atts = xml.attributes();
-    const QString points = atts.value(QLatin1String("points")).toString();
-    const QStringList pointsList = points.split(QLatin1Char(' '),
-                                                QString::SkipEmptyParts);
+    const QStringRef points = atts.value(QLatin1String("points"));
 
+    // The points are parsed in place, rather than splitting the attribute
+    // into a string for each point and coordinate
     QPolygonF polygon;
+    polygon.reserve(points.count(QLatin1Char(' ')) + 1);
+
     bool ok = true;
+    int start = 0;
+
+    while (ok && start < points.size()) {
+        int end = points.indexOf(QLatin1Char(' '), start);
+        if (end == -1)
+            end = points.size();
+
+        const QStringRef point = points.mid(start, end - start);
+        start = end + 1;
+
+        if (point.isEmpty())
+            continue;
 
-    foreach (const QString &point, pointsList) {
         const int commaPos = point.indexOf(QLatin1Char(','));
         if (commaPos == -1) {
             ok = false;
@@ -950,15 +1695,15 @@ void MapReaderPrivate::readProperty(Properties *properties)
     Q_ASSERT(xml.isStartElement() && xml.name() == QLatin1String("property"));
 
     const QXmlStreamAttributes atts = xml.attributes();
-    QString propertyName = atts.value(QLatin1String("name")).toString();
-    QString propertyValue = atts.value(QLatin1String("value")).toString();
+    const QString propertyName = mStrings.intern(atts.value(QLatin1String("name")));
+    QString propertyValue = mStrings.intern(atts.value(QLatin1String("value")));
 
     while (xml.readNext() != QXmlStreamReader::Invalid) {
         if (xml.isEndElement()) {
             break;
         } else if (xml.isCharacters() && !xml.isWhitespace()) {
             if (propertyValue.isEmpty())
-                propertyValue = xml.text().toString();
+                propertyValue = mStrings.intern(xml.text());
         } else if (xml.isStartElement()) {
             readUnknownElement();
         }
@@ -980,20 +1725,54 @@ MapReader::~MapReader()
 
 Map *MapReader::readMap(QIODevice *device, const QString &path)
 {
+    TraceScope trace("MapReader::readMap");
     return d->readMap(device, path);
 }
 
 Map *MapReader::readMap(const QString &fileName)
 {
+    TraceScope trace("MapReader::readMapFile", fileName);
+
     QFile file(fileName);
     if (!d->openFile(&file))
         return nullptr;
 
-    return readMap(&file, QFileInfo(fileName).absolutePath());
+    d->mapFile(&file);
+
+    if (!d->mCacheEnabled || d->mReadOptions.isPartial())
+        return readMap(&file, QFileInfo(fileName).absolutePath());
+
+    MapCache cache(fileName);
+    d->mCache = &cache;
+    Map *map = readMap(&file, QFileInfo(fileName).absolutePath());
+    d->mCache = nullptr;
+    cache.close();
+
+    if (!map)
+        return nullptr;
+
+    // Write the cache when it was missing or outdated. Layers that are
+    // loaded lazily are not cached.
+    int loadedLayerCount = 0;
+    int cellCount = 0;
+    for (const TileLayer *tileLayer : map->tileLayers()) {
+        if (tileLayer->isLoaded()) {
+            ++loadedLayerCount;
+            cellCount += tileLayer->width() * tileLayer->height();
+        }
+    }
+
+    if (d->mCachedLayerCount != loadedLayerCount && !map->infinite() &&
+            cellCount >= MapCache::minimumCellCount()) {
+        cache.write(map);
+    }
+
+    return map;
 }
 
 SharedTileset MapReader::readTileset(QIODevice *device, const QString &path)
 {
+    TraceScope trace("MapReader::readTileset", path);
     return d->readTileset(device, path);
 }
 
@@ -1015,6 +1794,86 @@ QString MapReader::errorString() const
     return d->errorString();
 }
 
+void MapReader::setLazyLoadingEnabled(bool enabled)
+{
+    d->mLazyLoadingEnabled = enabled;
+}
+
+bool MapReader::isLazyLoadingEnabled() const
+{
+    return d->mLazyLoadingEnabled;
+}
+
+void MapReader::setCacheEnabled(bool enabled)
+{
+    d->mCacheEnabled = enabled;
+}
+
+bool MapReader::isCacheEnabled() const
+{
+    return d->mCacheEnabled;
+}
+
+void MapReader::setTilesetCacheEnabled(bool enabled)
+{
+    d->mTilesetCacheEnabled = enabled;
+}
+
+bool MapReader::isTilesetCacheEnabled() const
+{
+    return d->mTilesetCacheEnabled;
+}
+
+void MapReader::setPixmapCreationDeferred(bool deferred)
+{
+    d->mPixmapCreationDeferred = deferred;
+}
+
+bool MapReader::isPixmapCreationDeferred() const
+{
+    return d->mPixmapCreationDeferred;
+}
+
+void MapReader::createDeferredPixmaps()
+{
+    TraceScope trace("MapReader::createDeferredPixmaps");
+
+    for (const DeferredPixmap &deferredPixmap : d->mDeferredPixmaps)
+        deferredPixmap.create();
+
+    d->mDeferredPixmaps.clear();
+}
+
+void MapReader::discardDeferredPixmaps(const Tileset *tileset)
+{
+    auto it = std::remove_if(d->mDeferredPixmaps.begin(),
+                             d->mDeferredPixmaps.end(),
+                             [tileset] (const DeferredPixmap &deferredPixmap) {
+        return deferredPixmap.tileset == tileset;
+    });
+    d->mDeferredPixmaps.erase(it, d->mDeferredPixmaps.end());
+}
+
+void MapReader::setImageLoadingDeferred(bool deferred)
+{
+    d->mImageLoadingDeferred = deferred;
+}
+
+bool MapReader::isImageLoadingDeferred() const
+{
+    return d->mImageLoadingDeferred;
+}
+
+void MapReader::setReadOptions(const MapReadOptions &options)
+{
+    d->mReadOptions = options;
+}
+
+const MapReadOptions &MapReader::readOptions() const
+{
+    return d->mReadOptions;
+}
+
 QString MapReader::resolveReference(const QString &reference,
                                     const QString &mapPath)
 {
@@ -1027,5 +1886,36 @@ QString MapReader::resolveReference(const QString &reference,
 SharedTileset MapReader::readExternalTileset(const QString &source,
                                              QString *error)
 {
+    // The tileset formats may not be used outside of the main thread, so
+    // only TSX tilesets can be read while pixmap creation is deferred
+    if (d->mPixmapCreationDeferred) {
+        MapReader reader;
+        reader.setPixmapCreationDeferred(true);
+        reader.setImageLoadingDeferred(d->mImageLoadingDeferred);
+
+        SharedTileset tileset = reader.readTileset(source);
+        if (!tileset && error)
+            *error = reader.errorString();
+
+        d->mDeferredPixmaps.append(reader.d->mDeferredPixmaps);
+        reader.d->mDeferredPixmaps.clear();
+        return tileset;
+    }
+
+    if (d->mTilesetCacheEnabled)
+        return TilesetCache::instance()->load(source, error);
+
+    // Other tileset formats don't support deferring the image loading
+    if (d->mImageLoadingDeferred &&
+            source.endsWith(QLatin1String(".tsx"), Qt::CaseInsensitive)) {
+        MapReader reader;
+        reader.setImageLoadingDeferred(true);
+
+        SharedTileset tileset = reader.readTileset(source);
+        if (!tileset && error)
+            *error = reader.errorString();
+        return tileset;
+    }
+
     return Tiled::readTileset(source, error);
 }
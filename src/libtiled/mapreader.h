@@ -29,6 +29,7 @@
 #ifndef MAPREADER_H
 #define MAPREADER_H
 
+#include "mapstreamoptions.h"
 #include "tiled_global.h"
 #include "tileset.h"
 
@@ -95,6 +96,86 @@ public:
      */
     QString errorString() const;
 
+    /**
+     * Sets whether the decoding of the tile data of hidden tile layers is
+     * deferred until their cells are first accessed. This reduces the
+     * memory usage for maps with many hidden layers. The data of those
+     * layers is still validated while reading, so that corrupt data is
+     * reported as an error. Disabled by default.
+     *
+     * Only applies to base64 encoded layer data.
+     *
+     * \sa TileLayer::setCellLoader()
+     */
+    void setLazyLoadingEnabled(bool enabled);
+    bool isLazyLoadingEnabled() const;
+
+    /**
+     * Sets whether maps read from a file use the binary MapCache. When
+     * enabled, the decoded tile layer data of large maps is written to the
+     * cache after reading, and read back from it when the map file didn't
+     * change. Disabled by default.
+     */
+    void setCacheEnabled(bool enabled);
+    bool isCacheEnabled() const;
+
+    /**
+     * Sets whether external tilesets are read through the process-wide
+     * TilesetCache, so that maps referencing the same tilesets share them.
+     * Disabled by default.
+     */
+    void setTilesetCacheEnabled(bool enabled);
+    bool isTilesetCacheEnabled() const;
+
+    /**
+     * Sets whether the creation of pixmaps is deferred until
+     * createDeferredPixmaps() is called. Images are still decoded while
+     * reading, but since pixmaps may only be created on the main thread,
+     * this allows a map to be read on a worker thread. External tilesets
+     * are then always read as TSX files. Disabled by default.
+     */
+    void setPixmapCreationDeferred(bool deferred);
+    bool isPixmapCreationDeferred() const;
+
+    /**
+     * Creates the pixmaps of the tilesets, tiles and image layers read since
+     * the last call. Needs to be called on the main thread, while the read
+     * maps and tilesets are still alive.
+     */
+    void createDeferredPixmaps();
+
+    /**
+     * Drops the deferred pixmaps of the given \a tileset, for example
+     * because the read map will use an already loaded copy of it instead.
+     */
+    void discardDeferredPixmaps(const Tileset *tileset);
+
+    /**
+     * Sets whether the loading of external tileset images is deferred until
+     * they are first used. Only their size is read, from the stored width
+     * and height or from the image header, and the tiles are set up without
+     * pixels. The image is loaded when Tileset::image() is first called,
+     * which allows tools that only need the layer data to skip decoding the
+     * images. Disabled by default.
+     *
+     * \sa Tileset::prepareUnloadedImage()
+     */
+    void setImageLoadingDeferred(bool deferred);
+    bool isImageLoadingDeferred() const;
+
+    /**
+     * Sets the options used when reading maps. Layers not included by the
+     * options are skipped without decoding their data, and the tiles outside
+     * of the region are dropped after each layer is decoded. Progress is
+     * reported in bytes read from the device, after each top-level element
+     * and regularly while the layer data is decoded, so that reading can
+     * also be cancelled then.
+     *
+     * The MapCache is not used for partial reads.
+     */
+    void setReadOptions(const MapReadOptions &options);
+    const MapReadOptions &readOptions() const;
+
 protected:
     /**
      * Called for each \a reference to an external file. Should return the path
@@ -106,7 +187,8 @@ protected:
 
     /**
      * Called when an external tileset is encountered while a map is loaded.
-     * The default implementation just calls readTileset() on a new MapReader.
+     * The default implementation just calls readTileset() on a new MapReader,
+     * or loads it through the TilesetCache when it is enabled.
      *
      * If an error occurred, the \a error parameter should be set to the error
      * message.
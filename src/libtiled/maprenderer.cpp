@@ -29,12 +29,21 @@
 #include "maprenderer.h"
 
 #include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tileset.h"
 
+#include <QAtomicInt>
 #include <QPaintEngine>
 #include <QPainter>
 #include <QVector2D>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
 
 using namespace Tiled;
 
@@ -44,14 +53,325 @@ QRectF MapRenderer::boundingRect(const ImageLayer *imageLayer) const
                   imageLayer->image().size());
 }
 
+QPainterPath MapRenderer::tileRegionShape(const QRegion &region) const
+{
+    QPainterPath path;
+    foreach (const QRect &r, region.rects())
+        path.addRect(boundingRect(r));
+    return path.simplified();
+}
+
 void MapRenderer::drawImageLayer(QPainter *painter,
                                  const ImageLayer *imageLayer,
                                  const QRectF &exposed)
 {
-    Q_UNUSED(exposed)
+    if (mImages) {
+        const QImage &image = mImages->imageLayerImage(imageLayer);
+        const QRectF imageRect(imageLayer->position(), image.size());
+
+        if (exposed.isNull() || exposed.intersects(imageRect))
+            painter->drawImage(imageRect.topLeft(), image);
+        return;
+    }
+
+    const QPixmap &image = imageLayer->image();
+    const QRectF imageRect(imageLayer->position(), image.size());
+
+    const QRectF visible = exposed.isNull() ? imageRect : exposed & imageRect;
+    if (visible.isEmpty())
+        return;
+
+    // Use the smallest mipmap that still has a pixel for each device pixel
+    const QTransform transform = painter->worldTransform();
+    const qreal scale = qMax(qSqrt(transform.m11() * transform.m11() +
+                                   transform.m12() * transform.m12()),
+                             qSqrt(transform.m21() * transform.m21() +
+                                   transform.m22() * transform.m22()))
+            * painter->device()->devicePixelRatio();
+
+    const QVector<QPixmap> &mipmaps = imageLayer->mipmaps();
+    int level = 0;
+    while (level < mipmaps.size() && scale * (1 << (level + 1)) <= 1)
+        ++level;
+
+    const QPixmap &pixmap = level == 0 ? image : mipmaps.at(level - 1);
+
+    if (level == 0 && visible == imageRect) {
+        painter->drawPixmap(imageRect.topLeft(), pixmap);
+        return;
+    }
+
+    // Only draw the visible part, aligned to the pixels of the mipmap
+    const qreal scaleX = qreal(pixmap.width()) / image.width();
+    const qreal scaleY = qreal(pixmap.height()) / image.height();
+    const QRectF local = visible.translated(-imageRect.topLeft());
+
+    const QRectF source = QRectF(QPointF(qFloor(local.left() * scaleX),
+                                         qFloor(local.top() * scaleY)),
+                                 QPointF(qCeil(local.right() * scaleX),
+                                         qCeil(local.bottom() * scaleY)))
+            & QRectF(pixmap.rect());
+
+    const QRectF target(imageRect.left() + source.left() / scaleX,
+                        imageRect.top() + source.top() / scaleY,
+                        source.width() / scaleX,
+                        source.height() / scaleY);
+
+    painter->drawPixmap(target, pixmap, source);
+}
+
+void MapRenderer::drawMapObjects(QPainter *painter,
+                                 const QList<MapObject*> &objects,
+                                 const QVector<QColor> &colors) const
+{
+    Q_ASSERT(objects.size() == colors.size());
+
+    for (int i = 0; i < objects.size(); ++i)
+        drawRotatedMapObject(painter, objects.at(i), colors.at(i));
+}
+
+/**
+ * Returns the visible objects of the given \a objectGroup of which the
+ * drawn area may intersect the given \a rect, in screen coordinates. The
+ * objects are looked up in the spatial index of the object group and are
+ * returned in no particular order.
+ */
+QList<MapObject*> MapRenderer::objectsIntersecting(const ObjectGroup *objectGroup,
+                                                   const QRectF &rect) const
+{
+    // Objects may be drawn beyond the bounds they are indexed by. Tile
+    // objects by their image, other objects by their outline or marker.
+    const QSizeF tileMargin = objectGroup->objectIndex().tileObjectMargin();
+    const qreal outlineMargin = 10 + 5 * qMax(objectLineWidth(), qreal(1)) + 1;
+    const qreal marginX = tileMargin.width() + outlineMargin;
+    const qreal marginY = tileMargin.height() + outlineMargin;
+    const QRectF screenRect = rect.adjusted(-marginX, -marginY, marginX, marginY);
+
+    const QPolygonF pixelPolygon = screenToPixelCoords(QPolygonF(screenRect));
+
+    QList<MapObject*> objects = objectGroup->objectsIntersecting(pixelPolygon.boundingRect());
+    objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                 [] (const MapObject *object) { return !object->isVisible(); }),
+                  objects.end());
+    return objects;
+}
+
+/**
+ * Returns the transformation that rotates the given \a object around its
+ * position, in screen coordinates.
+ */
+QTransform MapRenderer::rotationTransform(const MapObject *object) const
+{
+    const QPointF origin = pixelToScreenCoords(object->position());
+
+    QTransform transform;
+    transform.translate(origin.x(), origin.y());
+    transform.rotate(object->rotation());
+    transform.translate(-origin.x(), -origin.y());
+    return transform;
+}
+
+/**
+ * Draws the \a object like drawMapObject(), taking into account its
+ * rotation.
+ */
+void MapRenderer::drawRotatedMapObject(QPainter *painter,
+                                       const MapObject *object,
+                                       const QColor &color) const
+{
+    if (object->rotation() == qreal(0)) {
+        drawMapObject(painter, object, color);
+        return;
+    }
+
+    painter->save();
+    painter->setTransform(rotationTransform(object), true);
+    drawMapObject(painter, object, color);
+    painter->restore();
+}
+
+/**
+ * Returns the points of \a polygon that are needed to keep its outline
+ * within \a tolerance, using the Douglas-Peucker algorithm. The end points
+ * are always kept.
+ */
+static QPolygonF simplify(const QPolygonF &polygon, qreal tolerance)
+{
+    const int count = polygon.size();
+    QVector<bool> keep(count, false);
+    keep[0] = true;
+    keep[count - 1] = true;
+
+    const qreal toleranceSquared = tolerance * tolerance;
+
+    // An explicit stack, since the polygons can have many thousands of points
+    QVector<QPair<int, int>> ranges;
+    ranges.append(qMakePair(0, count - 1));
+
+    while (!ranges.isEmpty()) {
+        const QPair<int, int> range = ranges.takeLast();
+        const QPointF start = polygon.at(range.first);
+        const QPointF segment = polygon.at(range.second) - start;
+        const qreal lengthSquared = QPointF::dotProduct(segment, segment);
+
+        qreal maxDistanceSquared = 0;
+        int farthest = -1;
+
+        for (int i = range.first + 1; i < range.second; ++i) {
+            const QPointF offset = polygon.at(i) - start;
+            qreal distanceSquared;
+
+            if (lengthSquared > 0) {
+                const qreal cross = segment.x() * offset.y() - segment.y() * offset.x();
+                distanceSquared = cross * cross / lengthSquared;
+            } else {
+                distanceSquared = QPointF::dotProduct(offset, offset);
+            }
+
+            if (distanceSquared > maxDistanceSquared) {
+                maxDistanceSquared = distanceSquared;
+                farthest = i;
+            }
+        }
+
+        if (farthest != -1 && maxDistanceSquared > toleranceSquared) {
+            keep[farthest] = true;
+            ranges.append(qMakePair(range.first, farthest));
+            ranges.append(qMakePair(farthest, range.second));
+        }
+    }
+
+    QPolygonF result;
+    for (int i = 0; i < count; ++i)
+        if (keep.at(i))
+            result.append(polygon.at(i));
+    return result;
+}
+
+/**
+ * Returns the polygon of the given \a object, in pixel coordinates, without
+ * the points that change its outline by less than \a tolerance pixels.
+ *
+ * The tolerance is rounded down to a power of two, so that the simplified
+ * polygons can be cached per zoom level. The polygon itself is returned for
+ * polygons with few points.
+ */
+QPolygonF MapRenderer::simplifiedPolygon(const MapObject *object, qreal tolerance) const
+{
+    const QPolygonF &polygon = object->polygon();
+    if (polygon.size() <= 32 || tolerance <= 0)
+        return polygon;
+
+    const int exponent = qFloor(std::log2(tolerance));
+
+    ObjectGeometry &geometry = objectGeometry(object);
+    auto it = geometry.simplifiedPolygons.find(exponent);
+    if (it == geometry.simplifiedPolygons.end()) {
+        const QPolygonF simplified = simplify(polygon, std::ldexp(qreal(1), exponent));
+        it = geometry.simplifiedPolygons.insert(exponent, simplified);
+    }
+
+    return it.value();
+}
+
+/**
+ * Returns the tolerance in pixels for simplifying polygons drawn with the
+ * given \a painter, which keeps the difference below a quarter of a device
+ * pixel.
+ */
+qreal MapRenderer::simplificationTolerance(const QPainter *painter)
+{
+    const qreal scale = std::sqrt(std::abs(painter->worldTransform().determinant())) *
+            painter->device()->devicePixelRatio();
+
+    return scale > 0 ? 0.25 / scale : 0;
+}
+
+QRectF MapRenderer::boundingRect(const MapObject *object) const
+{
+    ObjectGeometry &geometry = objectGeometry(object);
+    if (!geometry.hasBoundingRect) {
+        geometry.boundingRect = objectBoundingRect(object);
+        geometry.hasBoundingRect = true;
+    }
+    return geometry.boundingRect;
+}
+
+QPainterPath MapRenderer::shape(const MapObject *object) const
+{
+    ObjectGeometry &geometry = objectGeometry(object);
+    if (!geometry.hasShape) {
+        geometry.path = objectShape(object);
+        geometry.hasShape = true;
+    }
+    return geometry.path;
+}
+
+/**
+ * Drops the cached bounding rect and shape of the given \a object.
+ *
+ * The cache also notices changes to the position, size, shape, polygon and
+ * tile of an object by itself, but objects should be invalidated when they
+ * change or are removed so that no outdated geometry is kept around.
+ */
+void MapRenderer::invalidateObjectGeometry(const MapObject *object) const
+{
+    mObjectGeometry.remove(object);
+}
+
+/**
+ * Drops the cached geometry of all objects. Needs to be called when a
+ * property of the map changes that affects the geometry of objects, like
+ * its tile size.
+ */
+void MapRenderer::clearObjectGeometryCache() const
+{
+    mObjectGeometry.clear();
+}
+
+void MapRenderer::setObjectLineWidth(qreal lineWidth)
+{
+    if (mObjectLineWidth == lineWidth)
+        return;
 
-    painter->drawPixmap(imageLayer->position(),
-                        imageLayer->image());
+    mObjectLineWidth = lineWidth;
+    clearObjectGeometryCache();
+}
+
+/**
+ * Returns the cache entry for the given \a object, which is reset when it
+ * was computed for different object properties.
+ */
+MapRenderer::ObjectGeometry &MapRenderer::objectGeometry(const MapObject *object) const
+{
+    ObjectGeometry &geometry = mObjectGeometry[object];
+
+    const Tile *tile = object->cell().tile;
+    const QSize tileSize = tile ? tile->size() : QSize();
+    const QPoint tileOffset = tile ? tile->offset() : QPoint();
+
+    // Comparing the polygons is cheap while they share their data
+    if (geometry.position != object->position() ||
+            geometry.size != object->size() ||
+            geometry.shape != object->shape() ||
+            geometry.tile != tile ||
+            geometry.tileSize != tileSize ||
+            geometry.tileOffset != tileOffset ||
+            geometry.polygon != object->polygon()) {
+        geometry.position = object->position();
+        geometry.size = object->size();
+        geometry.polygon = object->polygon();
+        geometry.shape = object->shape();
+        geometry.tile = tile;
+        geometry.tileSize = tileSize;
+        geometry.tileOffset = tileOffset;
+        geometry.hasBoundingRect = false;
+        geometry.hasShape = false;
+        geometry.path = QPainterPath();
+        geometry.simplifiedPolygons.clear();
+    }
+
+    return geometry;
 }
 
 void MapRenderer::setFlag(RenderFlag flag, bool enabled)
@@ -66,6 +386,20 @@ void MapRenderer::setFlag(RenderFlag flag, bool enabled)
  * Converts a line running from \a start to \a end to a polygon which
  * extends 5 pixels from the line in all directions.
  */
+void MapRenderer::screenToPixelCoords(const QPointF *points, QPointF *result,
+                                      int count) const
+{
+    for (int i = 0; i < count; ++i)
+        result[i] = screenToPixelCoords(points[i]);
+}
+
+void MapRenderer::pixelToScreenCoords(const QPointF *points, QPointF *result,
+                                      int count) const
+{
+    for (int i = 0; i < count; ++i)
+        result[i] = pixelToScreenCoords(points[i]);
+}
+
 QPolygonF MapRenderer::lineToPolygon(const QPointF &start, const QPointF &end)
 {
     QPointF direction = QVector2D(end - start).normalized().toPointF();
@@ -84,6 +418,11 @@ QPolygonF MapRenderer::lineToPolygon(const QPointF &start, const QPointF &end)
 }
 
 
+// Cell renderers may be used from several threads
+static QAtomicInt statisticsEnabled;
+static QAtomicInt statisticsFlushes;
+static QAtomicInt statisticsFragments;
+
 static bool hasOpenGLEngine(const QPainter *painter)
 {
     const QPaintEngine::Type type = painter->paintEngine()->type();
@@ -91,10 +430,102 @@ static bool hasOpenGLEngine(const QPainter *painter)
             type == QPaintEngine::OpenGL2);
 }
 
-CellRenderer::CellRenderer(QPainter *painter)
+/**
+ * Returns whether pixmaps are drawn scaled with smooth filtering, in which
+ * case the filtering may pick up pixels from outside of the source area.
+ */
+static bool isFilteringPixmaps(const QPainter *painter)
+{
+    return painter->testRenderHint(QPainter::SmoothPixmapTransform) &&
+            painter->combinedTransform().type() > QTransform::TxTranslate;
+}
+
+static bool useAverageColors(const QPainter *painter, RenderFlags flags)
+{
+    if (!flags.testFlag(LevelOfDetail))
+        return false;
+
+    const QTransform transform = painter->combinedTransform();
+    const qreal scale = qSqrt(qAbs(transform.determinant()));
+    return scale <= LevelOfDetailScale;
+}
+
+template<typename Key>
+static const QImage &findImage(const QHash<Key, QImage> &images, Key key)
+{
+    static const QImage noImage;
+    const auto it = images.constFind(key);
+    return it == images.constEnd() ? noImage : it.value();
+}
+
+MapImages::MapImages(const Map *map, RenderFlags flags)
+{
+    const bool averageColors = flags.testFlag(LevelOfDetail);
+
+    for (const SharedTileset &tileset : map->tilesets()) {
+        const QImage tilesetImage = tileset->image().toImage();
+        if (!tilesetImage.isNull()) {
+            mTilesetImages.insert(tileset.data(),
+                                  tilesetImage.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+        }
+
+        for (const Tile *tile : tileset->tiles()) {
+            if (tile->imageRect().isNull() && !tile->image().isNull()) {
+                mTileImages.insert(tile, tile->image().toImage()
+                                   .convertToFormat(QImage::Format_ARGB32_Premultiplied));
+            }
+
+            // The average color is otherwise computed when first drawn
+            if (averageColors)
+                tile->averageColor();
+        }
+    }
+
+    for (const Layer *layer : map->layers()) {
+        if (!layer->isImageLayer())
+            continue;
+
+        const ImageLayer *imageLayer = static_cast<const ImageLayer*>(layer);
+        const QImage image = imageLayer->image().toImage();
+        if (!image.isNull()) {
+            mImageLayerImages.insert(imageLayer,
+                                     image.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+        }
+    }
+}
+
+/**
+ * Returns the copy of the image of \a tileset, or a null image when it has
+ * no tileset image.
+ */
+const QImage &MapImages::tilesetImage(const Tileset *tileset) const
+{
+    return findImage(mTilesetImages, tileset);
+}
+
+/**
+ * Returns the copy of the image of \a tile, which is only available for
+ * the tiles of image collections.
+ */
+const QImage &MapImages::tileImage(const Tile *tile) const
+{
+    return findImage(mTileImages, tile);
+}
+
+const QImage &MapImages::imageLayerImage(const ImageLayer *imageLayer) const
+{
+    return findImage(mImageLayerImages, imageLayer);
+}
+
+CellRenderer::CellRenderer(QPainter *painter, RenderFlags flags,
+                           const MapImages *images)
     : mPainter(painter)
-    , mTile(nullptr)
+    , mImages(images)
+    , mImage(nullptr)
+    , mImageData(nullptr)
     , mIsOpenGL(hasOpenGLEngine(painter))
+    , mInsetSourceRects(isFilteringPixmaps(painter))
+    , mUseAverageColors(useAverageColors(painter, flags))
 {
 }
 
@@ -102,18 +533,42 @@ CellRenderer::CellRenderer(QPainter *painter)
  * Renders a \a cell with the given \a origin at \a pos, taking into account
  * the flipping and tile offset.
  *
- * For performance reasons, the actual drawing is delayed until a different
- * kind of tile has to be drawn. For this reason it is necessary to call
+ * For performance reasons, the actual drawing is delayed until a tile from
+ * a different image has to be drawn. For this reason it is necessary to call
  * flush when finished doing drawCell calls. This function is also called by
  * the destructor so usually an explicit call is not needed.
  */
 void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &cellSize, Origin origin)
 {
-    if (mTile != cell.tile)
-        flush();
+    const Tile *tile = cell.tile->currentFrameTile();
+    const QPixmap *image = nullptr;
+    const QImage *imageData = nullptr;
+    QRect sourceRect = tile->imageRect();
+
+    if (mImages) {
+        if (!sourceRect.isNull()) {
+            imageData = &mImages->tilesetImage(tile->tileset());
+        } else {
+            imageData = &mImages->tileImage(tile);
+            sourceRect = imageData->rect();
+        }
+
+        if (imageData->isNull())
+            return;
+    } else if (!sourceRect.isNull()) {
+        image = &tile->tileset()->image();
+    } else {
+        // The tiles of image collections are drawn from their atlas
+        image = &tile->tileset()->atlasImage();
+        sourceRect = tile->atlasRect();
 
-    const QPixmap &image = cell.tile->currentFrameImage();
-    const QSizeF size = image.size();
+        if (image->isNull() || sourceRect.isNull()) {
+            image = &tile->image();
+            sourceRect = QRect(QPoint(), image->size());
+        }
+    }
+
+    const QSizeF size = sourceRect.size();
     const QSizeF objectSize = (cellSize == QSizeF(0,0)) ? size : cellSize;
     const QSizeF scale(objectSize.width() / size.width(), objectSize.height() / size.height());
     const QPoint offset = cell.tile->offset();
@@ -122,12 +577,6 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &ce
     QPainter::PixmapFragment fragment;
     fragment.x = pos.x() + (offset.x() * scale.width()) + sizeHalf.x();
     fragment.y = pos.y() + (offset.y() * scale.height()) + sizeHalf.y() - objectSize.height();
-    fragment.sourceLeft = 0;
-    fragment.sourceTop = 0;
-    fragment.width = size.width();
-    fragment.height = size.height();
-    fragment.scaleX = cell.flippedHorizontally ? -1 : 1;
-    fragment.scaleY = cell.flippedVertically ? -1 : 1;
     fragment.rotation = 0;
     fragment.opacity = 1;
     
@@ -150,33 +599,64 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &ce
             fragment.x += halfDiff;
     }
     
-    fragment.scaleX = scale.width() * (flippedHorizontally ? -1 : 1);
-    fragment.scaleY = scale.height() * (flippedVertically ? -1 : 1);
+    if (mUseAverageColors) {
+        const QColor color = tile->averageColor();
+        if (color.alpha() == 0)
+            return;
+
+        QSizeF drawnSize = objectSize;
+        if (cell.flippedAntiDiagonally)
+            drawnSize.transpose();
 
-    if (mIsOpenGL || (fragment.scaleX > 0 && fragment.scaleY > 0)) {
-        mTile = cell.tile;
-        mFragments.append(fragment);
+        const QPointF topLeft(fragment.x - drawnSize.width() / 2,
+                              fragment.y - drawnSize.height() / 2);
+
+        mPainter->fillRect(QRectF(topLeft, drawnSize), color);
         return;
     }
 
     // The Raster paint engine as of Qt 4.8.4 / 5.0.2 does not support
-    // drawing fragments with a negative scaling factor.
+    // drawing fragments with a negative scaling factor, so mirrored copies of
+    // the images are used instead.
+    if (!mIsOpenGL && !mImages && (flippedHorizontally || flippedVertically)) {
+        if (image == &tile->tileset()->image()) {
+            const Tileset *tileset = tile->tileset();
+            image = &tileset->flippedImage(flippedHorizontally, flippedVertically);
+            sourceRect = tileset->flippedImageRect(sourceRect,
+                                                   flippedHorizontally,
+                                                   flippedVertically);
+        } else {
+            image = &tile->flippedImage(flippedHorizontally, flippedVertically);
+            sourceRect = QRect(QPoint(), image->size());
+        }
 
-    flush(); // make sure we drew all tiles so far
+        flippedHorizontally = false;
+        flippedVertically = false;
+    }
 
-    const QTransform oldTransform = mPainter->transform();
-    QTransform transform = oldTransform;
-    transform.translate(fragment.x, fragment.y);
-    transform.rotate(fragment.rotation);
-    transform.scale(fragment.scaleX, fragment.scaleY);
+    // Keeps the filtering from picking up the pixels of neighboring tiles
+    // in the tileset image, by sampling no further than the centers of the
+    // pixels along the edges
+    qreal inset = 0;
+    if (mInsetSourceRects && sourceRect.width() > 1 && sourceRect.height() > 1)
+        inset = 0.5;
 
-    const QRectF target(fragment.width * -0.5, fragment.height * -0.5,
-                        fragment.width, fragment.height);
-    const QRectF source(0, 0, fragment.width, fragment.height);
+    const QSizeF sourceSize(sourceRect.width() - 2 * inset,
+                            sourceRect.height() - 2 * inset);
 
-    mPainter->setTransform(transform);
-    mPainter->drawPixmap(target, image, source);
-    mPainter->setTransform(oldTransform);
+    fragment.sourceLeft = sourceRect.x() + inset;
+    fragment.sourceTop = sourceRect.y() + inset;
+    fragment.width = sourceSize.width();
+    fragment.height = sourceSize.height();
+    fragment.scaleX = objectSize.width() / sourceSize.width() * (flippedHorizontally ? -1 : 1);
+    fragment.scaleY = objectSize.height() / sourceSize.height() * (flippedVertically ? -1 : 1);
+
+    if (mImage != image || mImageData != imageData)
+        flush();
+
+    mImage = image;
+    mImageData = imageData;
+    mFragments.append(fragment);
 }
 
 /**
@@ -184,13 +664,67 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &ce
  */
 void CellRenderer::flush()
 {
-    if (!mTile)
+    if (!mImage && !mImageData)
         return;
 
-    mPainter->drawPixmapFragments(mFragments.constData(),
-                                  mFragments.size(),
-                                  mTile->currentFrameImage());
+    if (mImageData) {
+        drawImageFragments();
+    } else {
+        mPainter->drawPixmapFragments(mFragments.constData(),
+                                      mFragments.size(),
+                                      *mImage);
+    }
+
+    if (statisticsEnabled.load()) {
+        statisticsFlushes.ref();
+        statisticsFragments.fetchAndAddRelaxed(mFragments.size());
+    }
 
-    mTile = nullptr;
+    mImage = nullptr;
+    mImageData = nullptr;
     mFragments.resize(0);
 }
+
+/**
+ * Draws the collected fragments from the current image, the way
+ * QPainter::drawPixmapFragments() does when the paint engine has no faster
+ * way. The scale is applied to the painter, so mirrored fragments work on
+ * all paint engines.
+ */
+void CellRenderer::drawImageFragments()
+{
+    const QTransform transform = mPainter->transform();
+
+    for (const QPainter::PixmapFragment &fragment : mFragments) {
+        QTransform fragmentTransform = transform;
+        fragmentTransform.translate(fragment.x, fragment.y);
+        fragmentTransform.rotate(fragment.rotation);
+        fragmentTransform.scale(fragment.scaleX, fragment.scaleY);
+        mPainter->setTransform(fragmentTransform);
+
+        const QRectF target(-fragment.width / 2, -fragment.height / 2,
+                            fragment.width, fragment.height);
+        const QRectF source(fragment.sourceLeft, fragment.sourceTop,
+                            fragment.width, fragment.height);
+
+        mPainter->drawImage(target, *mImageData, source);
+    }
+
+    mPainter->setTransform(transform);
+}
+
+void CellRenderer::setStatisticsEnabled(bool enabled)
+{
+    statisticsEnabled.store(enabled);
+}
+
+/**
+ * Returns the statistics counted since the last call and resets them.
+ */
+CellRenderer::Statistics CellRenderer::takeStatistics()
+{
+    Statistics statistics;
+    statistics.flushes = statisticsFlushes.fetchAndStoreRelaxed(0);
+    statistics.fragments = statisticsFragments.fetchAndStoreRelaxed(0);
+    return statistics;
+}
@@ -31,7 +31,11 @@
 
 #include "tiled_global.h"
 
+#include <QHash>
+#include <QImage>
 #include <QPainter>
+#include <QPainterPath>
+#include <QPolygonF>
 
 namespace Tiled {
 
@@ -39,16 +43,44 @@ class Cell;
 class Layer;
 class Map;
 class MapObject;
+class ObjectGroup;
 class Tile;
 class TileLayer;
+class Tileset;
 class ImageLayer;
 
 enum RenderFlag {
-    ShowTileObjectOutlines = 0x1
+    ShowTileObjectOutlines = 0x1,
+    LevelOfDetail = 0x2
 };
 
 Q_DECLARE_FLAGS(RenderFlags, RenderFlag)
 
+/**
+ * Copies of the tileset, tile and image layer images of a map, as QImage.
+ * A renderer that is given these with MapRenderer::setImages() draws from
+ * them instead of from the pixmaps, which allows painting the map on threads
+ * other than the main thread.
+ *
+ * Needs to be created on the main thread, and the images of the map should
+ * not change while the copies are used. When the LevelOfDetail flag is
+ * passed, the average colors of the tiles are computed up front as well.
+ */
+class TILEDSHARED_EXPORT MapImages
+{
+public:
+    explicit MapImages(const Map *map, RenderFlags flags = RenderFlags());
+
+    const QImage &tilesetImage(const Tileset *tileset) const;
+    const QImage &tileImage(const Tile *tile) const;
+    const QImage &imageLayerImage(const ImageLayer *imageLayer) const;
+
+private:
+    QHash<const Tileset*, QImage> mTilesetImages;
+    QHash<const Tile*, QImage> mTileImages;
+    QHash<const ImageLayer*, QImage> mImageLayerImages;
+};
+
 /**
  * This interface is used for rendering tile layers and retrieving associated
  * metrics. The different implementations deal with different map
@@ -62,6 +94,7 @@ public:
         , mFlags(nullptr)
         , mObjectLineWidth(2)
         , mPainterScale(1)
+        , mImages(nullptr)
     {}
 
     virtual ~MapRenderer() {}
@@ -85,11 +118,20 @@ public:
      */
     virtual QRect boundingRect(const QRect &rect) const = 0;
 
+    /**
+     * Returns the shape in pixels of the tiles in the given \a region. The
+     * default implementation unites the bounding rectangles of the rects in
+     * the region, which is correct when tiles are rectangles.
+     */
+    virtual QPainterPath tileRegionShape(const QRegion &region) const;
+
     /**
      * Returns the bounding rectangle in pixels of the given \a object, as it
      * would be drawn by drawMapObject().
+     *
+     * The result is cached per object. \sa invalidateObjectGeometry()
      */
-    virtual QRectF boundingRect(const MapObject *object) const = 0;
+    QRectF boundingRect(const MapObject *object) const;
 
     /**
      * Returns the bounding rectangle in pixels of the given \a imageLayer, as
@@ -101,8 +143,13 @@ public:
      * Returns the shape in pixels of the given \a object. This is used for
      * mouse interaction and should match the rendered object as closely as
      * possible.
+     *
+     * The result is cached per object. \sa invalidateObjectGeometry()
      */
-    virtual QPainterPath shape(const MapObject *object) const = 0;
+    QPainterPath shape(const MapObject *object) const;
+
+    void invalidateObjectGeometry(const MapObject *object) const;
+    void clearObjectGeometryCache() const;
 
     /**
      * Draws the tile grid in the specified \a rect using the given
@@ -138,8 +185,27 @@ public:
                                const MapObject *object,
                                const QColor &color) const = 0;
 
+    /**
+     * Draws the given \a objects in the given order, each in the color at
+     * the same index in \a colors. Unlike drawMapObject(), this also applies
+     * the rotation of each object.
+     *
+     * Renderers may override this function to draw similar objects in
+     * batches.
+     */
+    virtual void drawMapObjects(QPainter *painter,
+                                const QList<MapObject*> &objects,
+                                const QVector<QColor> &colors) const;
+
+    QList<MapObject*> objectsIntersecting(const ObjectGroup *objectGroup,
+                                          const QRectF &rect) const;
+
     /**
      * Draws the given image \a layer using the given \a painter.
+     *
+     * Only the part of the image within the \a exposed rect is drawn, unless
+     * it is null. When zoomed out, a downscaled version of the image is used
+     * (see ImageLayer::mipmaps()).
      */
     void drawImageLayer(QPainter *painter,
                         const ImageLayer *imageLayer,
@@ -153,13 +219,8 @@ public:
     inline QPointF pixelToTileCoords(const QPointF &point) const
     { return pixelToTileCoords(point.x(), point.y()); }
 
-    QPolygonF pixelToScreenCoords(const QPolygonF &polygon) const
-    {
-        QPolygonF screenPolygon(polygon.size());
-        for (int i = polygon.size() - 1; i >= 0; --i)
-            screenPolygon[i] = pixelToScreenCoords(polygon[i]);
-        return screenPolygon;
-    }
+    QPolygonF pixelToScreenCoords(const QPolygonF &polygon) const;
+    QPolygonF screenToPixelCoords(const QPolygonF &polygon) const;
 
     /**
      * Returns the pixel coordinates matching the given tile coordinates.
@@ -199,8 +260,25 @@ public:
     virtual QPointF pixelToScreenCoords(qreal x, qreal y) const = 0;
     inline QPointF pixelToScreenCoords(const QPointF &point) const;
 
+    /**
+     * Converts \a count screen positions to pixel positions. The \a points
+     * and \a result arrays may be the same.
+     *
+     * The default implementation converts each point on its own. Renderers
+     * override these to convert many points without a virtual call for each.
+     */
+    virtual void screenToPixelCoords(const QPointF *points, QPointF *result,
+                                     int count) const;
+
+    /**
+     * Converts \a count pixel positions to screen positions. The \a points
+     * and \a result arrays may be the same.
+     */
+    virtual void pixelToScreenCoords(const QPointF *points, QPointF *result,
+                                     int count) const;
+
     qreal objectLineWidth() const { return mObjectLineWidth; }
-    void setObjectLineWidth(qreal lineWidth) { mObjectLineWidth = lineWidth; }
+    void setObjectLineWidth(qreal lineWidth);
 
     void setFlag(RenderFlag flag, bool enabled = true);
     bool testFlag(RenderFlag flag) const
@@ -212,14 +290,77 @@ public:
     RenderFlags flags() const { return mFlags; }
     void setFlags(RenderFlags flags) { mFlags = flags; }
 
+    /**
+     * Sets the images to draw tiles and image layers from instead of their
+     * pixmaps, or nullptr to draw the pixmaps. The renderer does not take
+     * ownership of the images.
+     */
+    void setImages(const MapImages *images) { mImages = images; }
+    const MapImages *images() const { return mImages; }
+
     static QPolygonF lineToPolygon(const QPointF &start, const QPointF &end);
 
+protected:
+    /**
+     * Computes the bounding rectangle of the given \a object.
+     * \sa boundingRect()
+     */
+    virtual QRectF objectBoundingRect(const MapObject *object) const = 0;
+
+    /**
+     * Computes the shape of the given \a object. \sa shape()
+     */
+    virtual QPainterPath objectShape(const MapObject *object) const = 0;
+
+    QTransform rotationTransform(const MapObject *object) const;
+    void drawRotatedMapObject(QPainter *painter,
+                              const MapObject *object,
+                              const QColor &color) const;
+
+    QPolygonF simplifiedPolygon(const MapObject *object, qreal tolerance) const;
+    static qreal simplificationTolerance(const QPainter *painter);
+
 private:
+    /**
+     * The cached geometry of an object, along with the properties of the
+     * object it was computed from.
+     */
+    struct ObjectGeometry
+    {
+        ObjectGeometry()
+            : shape(-1)
+            , tile(nullptr)
+            , hasBoundingRect(false)
+            , hasShape(false)
+        {}
+
+        QPointF position;
+        QSizeF size;
+        QPolygonF polygon;
+        int shape;
+        const Tile *tile;
+        QSize tileSize;
+        QPoint tileOffset;
+
+        bool hasBoundingRect;
+        bool hasShape;
+        QRectF boundingRect;
+        QPainterPath path;
+
+        // Simplified polygons by the exponent of their tolerance
+        QHash<int, QPolygonF> simplifiedPolygons;
+    };
+
+    ObjectGeometry &objectGeometry(const MapObject *object) const;
+
     const Map *mMap;
 
     RenderFlags mFlags;
     qreal mObjectLineWidth;
     qreal mPainterScale;
+    const MapImages *mImages;
+
+    mutable QHash<const MapObject*, ObjectGeometry> mObjectGeometry;
 };
 
 inline const Map *MapRenderer::map() const
@@ -247,11 +388,46 @@ inline QPointF MapRenderer::pixelToScreenCoords(const QPointF &point) const
     return pixelToScreenCoords(point.x(), point.y());
 }
 
+inline QPolygonF MapRenderer::pixelToScreenCoords(const QPolygonF &polygon) const
+{
+    QPolygonF screenPolygon(polygon);
+    pixelToScreenCoords(screenPolygon.constData(), screenPolygon.data(),
+                        screenPolygon.size());
+    return screenPolygon;
+}
+
+inline QPolygonF MapRenderer::screenToPixelCoords(const QPolygonF &polygon) const
+{
+    QPolygonF pixelPolygon(polygon);
+    screenToPixelCoords(pixelPolygon.constData(), pixelPolygon.data(),
+                        pixelPolygon.size());
+    return pixelPolygon;
+}
+
 
 /**
  * A utility class for rendering cells.
+ *
+ * Consecutive cells using tiles from the same tileset image are drawn with
+ * a single call to QPainter::drawPixmapFragments, using the part of the
+ * tileset image belonging to each tile. The tiles don't need their own
+ * copies of their images for this. When pixmaps are drawn scaled with
+ * smooth filtering, the parts are inset by half a pixel, so that the
+ * filtering doesn't pick up pixels from neighboring tiles.
+ *
+ * On paint engines that can't draw mirrored fragments, flipped cells are
+ * drawn using mirrored copies of the images, so that they can be batched
+ * as well.
+ *
+ * When the LevelOfDetail flag is passed and the cells are drawn at a scale
+ * of LevelOfDetailScale or less, each cell is drawn as a rectangle filled
+ * with the average color of its tile.
+ *
+ * When MapImages are passed, the cells are drawn from those instead of from
+ * the pixmaps, one fragment at a time. Since the painter is transformed for
+ * each fragment, no mirrored copies of the images are needed then.
  */
-class CellRenderer
+class TILEDSHARED_EXPORT CellRenderer
 {
 public:
     enum Origin {
@@ -259,20 +435,45 @@ public:
         BottomCenter
     };
 
-    explicit CellRenderer(QPainter *painter);
+    /**
+     * The number of flushes and drawn fragments of all cell renderers, which
+     * are counted for profiling while enabled by setStatisticsEnabled().
+     */
+    struct Statistics {
+        int flushes;
+        int fragments;
+    };
+
+    explicit CellRenderer(QPainter *painter,
+                          RenderFlags flags = RenderFlags(),
+                          const MapImages *images = nullptr);
 
     ~CellRenderer() { flush(); }
 
     void render(const Cell &cell, const QPointF &pos, const QSizeF &size, Origin origin);
     void flush();
 
+    static void setStatisticsEnabled(bool enabled);
+    static Statistics takeStatistics();
+
 private:
+    void drawImageFragments();
+
     QPainter * const mPainter;
-    Tile *mTile;
+    const MapImages * const mImages;
+    const QPixmap *mImage;
+    const QImage *mImageData;
     QVector<QPainter::PixmapFragment> mFragments;
     const bool mIsOpenGL;
+    const bool mInsetSourceRects;
+    const bool mUseAverageColors;
 };
 
+/**
+ * The scale at or below which the LevelOfDetail render flag takes effect.
+ */
+const qreal LevelOfDetailScale = 0.125;
+
 } // namespace Tiled
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(Tiled::RenderFlags)
@@ -0,0 +1,56 @@
+/*
+ * mapstreamoptions.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "mapstreamoptions.h"
+
+#include "map.h"
+#include "tilelayer.h"
+
+#include <QRegion>
+
+using namespace Tiled;
+
+/**
+ * Removes the layers that should not have been read from the given \a map,
+ * and erases the tiles outside of the region. Used by formats that can only
+ * read the whole map.
+ */
+void MapReadOptions::applyTo(Map *map) const
+{
+    for (int i = map->layerCount() - 1; i >= 0; --i) {
+        if (!includesLayer(map->layerAt(i)->name()))
+            delete map->takeLayerAt(i);
+    }
+
+    if (region.isNull())
+        return;
+
+    for (TileLayer *tileLayer : map->tileLayers()) {
+        const QRegion inside = QRegion(region).translated(-tileLayer->position());
+        tileLayer->erase(QRegion(0, 0, tileLayer->width(), tileLayer->height()) - inside);
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * mapstreamoptions.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef TILED_MAPSTREAMOPTIONS_H
+#define TILED_MAPSTREAMOPTIONS_H
+
+#include "tiled_global.h"
+
+#include <QRect>
+#include <QStringList>
+
+#include <functional>
+
+namespace Tiled {
+
+class Map;
+
+/**
+ * Called while a map is read from or written to a device, with the amount of
+ * work done and the total amount, or -1 when the total is not known. When it
+ * returns false, the operation is cancelled.
+ */
+typedef std::function<bool (qint64 done, qint64 total)> ProgressFunction;
+
+/**
+ * Options for reading a map from a device, see MapFormat::readFromDevice().
+ */
+struct TILEDSHARED_EXPORT MapReadOptions
+{
+    /**
+     * The names of the layers to read. All layers are read when empty.
+     */
+    QStringList layerNames;
+
+    /**
+     * The region of the map, in tiles, of which the tiles are read. Tiles of
+     * the whole map are read when it is null.
+     */
+    QRect region;
+
+    ProgressFunction progress;
+
+    bool isPartial() const
+    { return !layerNames.isEmpty() || !region.isNull(); }
+
+    bool includesLayer(const QString &name) const
+    { return layerNames.isEmpty() || layerNames.contains(name); }
+
+    bool reportProgress(qint64 done, qint64 total) const
+    { return !progress || progress(done, total); }
+
+    void applyTo(Map *map) const;
+};
+
+/**
+ * Options for writing a map to a device, see MapFormat::writeToDevice().
+ */
+struct TILEDSHARED_EXPORT MapWriteOptions
+{
+    ProgressFunction progress;
+
+    bool reportProgress(qint64 done, qint64 total) const
+    { return !progress || progress(done, total); }
+};
+
+} // namespace Tiled
+
+#endif // TILED_MAPSTREAMOPTIONS_H
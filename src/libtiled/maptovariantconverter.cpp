@@ -31,12 +31,15 @@
 #include "tileset.h"
 #include "terrain.h"
 
+#include <QScopedPointer>
+
 using namespace Tiled;
 
 QVariant MapToVariantConverter::toVariant(const Map *map, const QDir &mapDir)
 {
     mMapDir = mapDir;
     mGidMapper.clear();
+    mError.clear();
 
     QVariantMap mapVariant;
 
@@ -50,6 +53,9 @@ QVariant MapToVariantConverter::toVariant(const Map *map, const QDir &mapDir)
     mapVariant[QLatin1String("properties")] = toVariant(map->properties());
     mapVariant[QLatin1String("nextobjectid")] = map->nextObjectId();
 
+    if (map->infinite())
+        mapVariant[QLatin1String("infinite")] = true;
+
     if (map->orientation() == Map::Hexagonal) {
         mapVariant[QLatin1String("hexsidelength")] = map->hexSideLength();
     }
@@ -90,6 +96,9 @@ QVariant MapToVariantConverter::toVariant(const Map *map, const QDir &mapDir)
     }
     mapVariant[QLatin1String("layers")] = layerVariants;
 
+    if (!mError.isEmpty())
+        return QVariant();
+
     return mapVariant;
 }
 
@@ -149,14 +158,18 @@ QVariant MapToVariantConverter::toVariant(const Tileset *tileset,
     }
 
     // Write the properties, terrain, external image, object group and
-    // animation for those tiles that have them.
+    // animation for those tiles that have them. Only the tiles of image
+    // collection tilesets all need to be visited, for their image.
+    const QList<Tile*> tiles = tileset->imageSource().isEmpty() ? tileset->tiles()
+                                                                : tileset->tilesWithMetadata();
+
     QVariantMap tilePropertiesVariant;
     QVariantMap tilesVariant;
-    for (int i = 0; i < tileset->tileCount(); ++i) {
-        const Tile *tile = tileset->tileAt(i);
-        const Properties properties = tile->properties();
+    for (const Tile *tile : tiles) {
+        const QString id = QString::number(tile->id());
+        const Properties &properties = tile->properties();
         if (!properties.isEmpty())
-            tilePropertiesVariant[QString::number(i)] = toVariant(properties);
+            tilePropertiesVariant[id] = toVariant(properties);
         QVariantMap tileVariant;
         if (tile->terrain() != 0xFFFFFFFF) {
             QVariantList terrainIds;
@@ -184,7 +197,7 @@ QVariant MapToVariantConverter::toVariant(const Tileset *tileset,
         }
 
         if (!tileVariant.empty())
-            tilesVariant[QString::number(i)] = tileVariant;
+            tilesVariant[id] = tileVariant;
     }
     if (!tilePropertiesVariant.empty())
         tilesetVariant[QLatin1String("tileproperties")] = tilePropertiesVariant;
@@ -232,34 +245,75 @@ QVariant MapToVariantConverter::toVariant(const TileLayer *tileLayer,
 
     switch (format) {
     case Map::XML:
-    case Map::CSV: {
-        QVariantList tileVariants;
-        for (int y = 0; y < tileLayer->height(); ++y)
-            for (int x = 0; x < tileLayer->width(); ++x)
-                tileVariants << mGidMapper.cellToGid(tileLayer->cellAt(x, y));
-
-        tileLayerVariant[QLatin1String("data")] = tileVariants;
+    case Map::CSV:
         break;
-    }
     case Map::Base64:
     case Map::Base64Zlib:
-    case Map::Base64Gzip: {
+    case Map::Base64Gzip:
+    case Map::Base64Zstandard:
+    case Map::Base64Lz4: {
         tileLayerVariant[QLatin1String("encoding")] = QLatin1String("base64");
 
         if (format == Map::Base64Zlib)
             tileLayerVariant[QLatin1String("compression")] = QLatin1String("zlib");
         else if (format == Map::Base64Gzip)
             tileLayerVariant[QLatin1String("compression")] = QLatin1String("gzip");
-
-        QByteArray layerData = mGidMapper.encodeLayerData(*tileLayer, format);
-        tileLayerVariant[QLatin1String("data")] = layerData;
+        else if (format == Map::Base64Zstandard)
+            tileLayerVariant[QLatin1String("compression")] = QLatin1String("zstd");
+        else if (format == Map::Base64Lz4)
+            tileLayerVariant[QLatin1String("compression")] = QLatin1String("lz4");
         break;
     }
     }
 
+    if (tileLayer->isInfinite()) {
+        // Only the chunks holding cells are stored, each encoded on its own
+        QVariantList chunkVariants;
+
+        for (const QRect &rect : tileLayer->chunkRects()) {
+            const QScopedPointer<TileLayer> chunk(tileLayer->copy(rect));
+
+            QVariantMap chunkVariant;
+            chunkVariant[QLatin1String("x")] = rect.x();
+            chunkVariant[QLatin1String("y")] = rect.y();
+            chunkVariant[QLatin1String("width")] = rect.width();
+            chunkVariant[QLatin1String("height")] = rect.height();
+            chunkVariant[QLatin1String("data")] = layerData(*chunk, format);
+            chunkVariants.append(chunkVariant);
+        }
+
+        tileLayerVariant[QLatin1String("chunks")] = chunkVariants;
+    } else {
+        tileLayerVariant[QLatin1String("data")] = layerData(*tileLayer, format);
+    }
+
     return tileLayerVariant;
 }
 
+/**
+ * Returns the cells of \a tileLayer in the given \a format, as stored in the
+ * "data" of a layer or chunk.
+ */
+QVariant MapToVariantConverter::layerData(const TileLayer &tileLayer,
+                                          Map::LayerDataFormat format) const
+{
+    if (format == Map::XML || format == Map::CSV) {
+        QVariantList tileVariants;
+        for (int y = 0; y < tileLayer.height(); ++y)
+            for (int x = 0; x < tileLayer.width(); ++x)
+                tileVariants << mGidMapper.cellToGid(tileLayer.cellAt(x, y));
+
+        return tileVariants;
+    }
+
+    bool ok;
+    const QByteArray data = mGidMapper.encodeLayerData(tileLayer, format, &ok);
+    if (!ok && mError.isEmpty())
+        mError = tr("Failed to compress the data of layer '%1'.").arg(tileLayer.name());
+
+    return data;
+}
+
 QVariant MapToVariantConverter::toVariant(const ObjectGroup *objectGroup) const
 {
     QVariantMap objectGroupVariant;
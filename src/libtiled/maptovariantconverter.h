@@ -22,6 +22,7 @@
 #ifndef MAPTOVARIANTCONVERTER_H
 #define MAPTOVARIANTCONVERTER_H
 
+#include <QCoreApplication>
 #include <QDir>
 #include <QVariant>
 
@@ -35,12 +36,17 @@ namespace Tiled {
  */
 class TILEDSHARED_EXPORT MapToVariantConverter
 {
+    Q_DECLARE_TR_FUNCTIONS(MapToVariantConverter)
+
 public:
     MapToVariantConverter() {}
 
     /**
      * Converts the given \s map to a QVariant. The \a mapDir is used to
      * construct relative paths to external resources.
+     *
+     * Returns an invalid QVariant in case of an error. The error can be
+     * obtained using errorString().
      */
     QVariant toVariant(const Map *map, const QDir &mapDir);
 
@@ -50,11 +56,18 @@ public:
      */
     QVariant toVariant(const Tileset &tileset, const QDir &directory);
 
+    /**
+     * Returns the last error, if any.
+     */
+    QString errorString() const { return mError; }
+
 private:
     QVariant toVariant(const Tileset *tileset, int firstGid) const;
     QVariant toVariant(const Properties &properties) const;
     QVariant toVariant(const TileLayer *tileLayer,
                        Map::LayerDataFormat format) const;
+    QVariant layerData(const TileLayer &tileLayer,
+                       Map::LayerDataFormat format) const;
     QVariant toVariant(const ObjectGroup *objectGroup) const;
     QVariant toVariant(const ImageLayer *imageLayer) const;
 
@@ -63,6 +76,7 @@ private:
 
     QDir mMapDir;
     GidMapper mGidMapper;
+    mutable QString mError;
 };
 
 } // namespace Tiled
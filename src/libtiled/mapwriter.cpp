@@ -35,18 +35,24 @@
 #include "map.h"
 #include "mapobject.h"
 #include "imagelayer.h"
+#include "layerdatacache.h"
+#include "layerdataencoder.h"
 #include "objectgroup.h"
 #include "tile.h"
 #include "tilelayer.h"
 #include "tileset.h"
 #include "terrain.h"
+#include "tracing.h"
 
 #include <QBuffer>
 #include <QCoreApplication>
 #include <QDir>
 #include <QSaveFile>
+#include <QScopedPointer>
 #include <QXmlStreamWriter>
 
+#include <cstring>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -71,12 +77,17 @@ public:
     QString mError;
     Map::LayerDataFormat mLayerDataFormat;
     bool mDtdEnabled;
+    LayerDataCache *mLayerDataCache;
+    MapWriteOptions mWriteOptions;
 
 private:
     void writeMap(QXmlStreamWriter &w, const Map &map);
     void writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
                       unsigned firstGid);
     void writeTileLayer(QXmlStreamWriter &w, const TileLayer &tileLayer);
+    void writeChunks(QXmlStreamWriter &w, const TileLayer &tileLayer);
+    bool writeTileData(const TileLayer &tileLayer,
+                       const CompressionSink &sink) const;
     void writeLayerAttributes(QXmlStreamWriter &w, const Layer &layer);
     void writeObjectGroup(QXmlStreamWriter &w, const ObjectGroup &objectGroup);
     void writeObject(QXmlStreamWriter &w, const MapObject &mapObject);
@@ -84,9 +95,20 @@ private:
     void writeProperties(QXmlStreamWriter &w,
                          const Properties &properties);
 
+    void beginOutput(QIODevice *device);
+    void flushOutput(bool force = false);
+    void endOutput();
+
     QDir mMapDir;     // The directory in which the map is being saved
     GidMapper mGidMapper;
+    QVector<SharedTileset> mTilesets;
+    LayerDataEncoder mLayerDataEncoder;
     bool mUseAbsolutePaths;
+
+    // The XML is written to a buffer, which is written to the device in
+    // large blocks. Tile data is written to it directly.
+    QIODevice *mDevice;
+    QBuffer mBuffer;
 };
 
 } // namespace Internal
@@ -96,7 +118,9 @@ private:
 MapWriterPrivate::MapWriterPrivate()
     : mLayerDataFormat(Map::Base64Zlib)
     , mDtdEnabled(false)
+    , mLayerDataCache(nullptr)
     , mUseAbsolutePaths(false)
+    , mDevice(nullptr)
 {
 }
 
@@ -110,6 +134,26 @@ bool MapWriterPrivate::openFile(QIODevice *file)
     return true;
 }
 
+static const int OutputBufferSize = 1024 * 1024;
+
+/**
+ * Writes the decimal representation of \a value to \a out, returning the
+ * position after the last digit.
+ */
+static char *writeNumber(char *out, unsigned value)
+{
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (count)
+        *out++ = digits[--count];
+    return out;
+}
+
 static QXmlStreamWriter *createWriter(QIODevice *device)
 {
     QXmlStreamWriter *writer = new QXmlStreamWriter(device);
@@ -124,8 +168,10 @@ void MapWriterPrivate::writeMap(const Map *map, QIODevice *device,
     mMapDir = QDir(path);
     mUseAbsolutePaths = path.isEmpty();
     mLayerDataFormat = map->layerDataFormat();
+    mError.clear();
 
-    QXmlStreamWriter *writer = createWriter(device);
+    beginOutput(device);
+    QXmlStreamWriter *writer = createWriter(&mBuffer);
     writer->writeStartDocument();
 
     if (mDtdEnabled) {
@@ -137,6 +183,7 @@ void MapWriterPrivate::writeMap(const Map *map, QIODevice *device,
     writeMap(*writer, *map);
     writer->writeEndDocument();
     delete writer;
+    endOutput();
 }
 
 void MapWriterPrivate::writeTileset(const Tileset &tileset, QIODevice *device,
@@ -145,7 +192,8 @@ void MapWriterPrivate::writeTileset(const Tileset &tileset, QIODevice *device,
     mMapDir = QDir(path);
     mUseAbsolutePaths = path.isEmpty();
 
-    QXmlStreamWriter *writer = createWriter(device);
+    beginOutput(device);
+    QXmlStreamWriter *writer = createWriter(&mBuffer);
     writer->writeStartDocument();
 
     if (mDtdEnabled) {
@@ -157,6 +205,36 @@ void MapWriterPrivate::writeTileset(const Tileset &tileset, QIODevice *device,
     writeTileset(*writer, tileset, 0);
     writer->writeEndDocument();
     delete writer;
+    endOutput();
+}
+
+void MapWriterPrivate::beginOutput(QIODevice *device)
+{
+    mDevice = device;
+    mBuffer.buffer().reserve(OutputBufferSize + 64 * 1024);
+    mBuffer.open(QIODevice::WriteOnly);
+}
+
+/**
+ * Writes the buffered output to the device once it reaches the buffer
+ * size, or regardless of its size when \a force is true.
+ */
+void MapWriterPrivate::flushOutput(bool force)
+{
+    if (mBuffer.size() == 0 || (!force && mBuffer.size() < OutputBufferSize))
+        return;
+
+    mDevice->write(mBuffer.data());
+    mBuffer.buffer().resize(0);
+    mBuffer.seek(0);
+}
+
+void MapWriterPrivate::endOutput()
+{
+    flushOutput(true);
+    mBuffer.close();
+    mBuffer.buffer().clear();
+    mDevice = nullptr;
 }
 
 void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map &map)
@@ -176,6 +254,9 @@ void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map &map)
     w.writeAttribute(QLatin1String("tileheight"),
                      QString::number(map.tileHeight()));
 
+    if (map.infinite())
+        w.writeAttribute(QLatin1String("infinite"), QLatin1String("1"));
+
     if (map.orientation() == Map::Hexagonal) {
         w.writeAttribute(QLatin1String("hexsidelength"),
                          QString::number(map.hexSideLength()));
@@ -199,6 +280,7 @@ void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map &map)
     writeProperties(w, map.properties());
 
     mGidMapper.clear();
+    mTilesets = map.tilesets();
     unsigned firstGid = 1;
     for (const SharedTileset &tileset : map.tilesets()) {
         writeTileset(w, *tileset, firstGid);
@@ -206,7 +288,32 @@ void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map &map)
         firstGid += tileset->tileCount();
     }
 
-    for (const Layer *layer : map.layers()) {
+    const int layerCount = map.layerCount();
+
+    // Compress the data of the tile layers in parallel, except for the
+    // layers of which the data is cached
+    for (int i = 0; i < layerCount; ++i) {
+        const Layer *layer = map.layerAt(i);
+        if (layer->layerType() != Layer::TileLayerType)
+            continue;
+
+        const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+        if (tileLayer->isInfinite())
+            continue;
+        if (mLayerDataCache && mLayerDataCache->find(tileLayer, mLayerDataFormat, mTilesets))
+            continue;
+
+        mLayerDataEncoder.addLayer(tileLayer);
+    }
+    mLayerDataEncoder.encode(mGidMapper, mLayerDataFormat);
+
+    for (int i = 0; i < layerCount; ++i) {
+        if (!mWriteOptions.reportProgress(i, layerCount)) {
+            mError = tr("Writing the map was cancelled.");
+            break;
+        }
+
+        const Layer *layer = map.layerAt(i);
         const Layer::TypeFlag type = layer->layerType();
         if (type == Layer::TileLayerType)
             writeTileLayer(w, *static_cast<const TileLayer*>(layer));
@@ -214,9 +321,13 @@ void MapWriterPrivate::writeMap(QXmlStreamWriter &w, const Map &map)
             writeObjectGroup(w, *static_cast<const ObjectGroup*>(layer));
         else if (type == Layer::ImageLayerType)
             writeImageLayer(w, *static_cast<const ImageLayer*>(layer));
+
+        flushOutput();
     }
 
     w.writeEndElement();
+    mTilesets.clear();
+    mLayerDataEncoder.clear();
 }
 
 static QString makeTerrainAttribute(const Tile *tile)
@@ -318,17 +429,20 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
         w.writeEndElement();
     }
 
-    // Write the properties for those tiles that have them
-    for (int i = 0; i < tileset.tileCount(); ++i) {
-        const Tile *tile = tileset.tileAt(i);
-        const Properties properties = tile->properties();
+    // Write the properties for those tiles that have them. Only the tiles of
+    // image collection tilesets all need to be written, for their image.
+    const QList<Tile*> tiles = imageSource.isEmpty() ? tileset.tiles()
+                                                     : tileset.tilesWithMetadata();
+
+    for (const Tile *tile : tiles) {
+        const Properties &properties = tile->properties();
         unsigned terrain = tile->terrain();
         float probability = tile->probability();
         ObjectGroup *objectGroup = tile->objectGroup();
 
         if (!properties.isEmpty() || terrain != 0xFFFFFFFF || probability != 1.f || imageSource.isEmpty() || objectGroup || tile->isAnimated()) {
             w.writeStartElement(QLatin1String("tile"));
-            w.writeAttribute(QLatin1String("id"), QString::number(i));
+            w.writeAttribute(QLatin1String("id"), QString::number(tile->id()));
             if (terrain != 0xFFFFFFFF)
                 w.writeAttribute(QLatin1String("terrain"), makeTerrainAttribute(tile));
             if (probability != 1.f)
@@ -401,7 +515,9 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
 
     if (mLayerDataFormat == Map::Base64
             || mLayerDataFormat == Map::Base64Gzip
-            || mLayerDataFormat == Map::Base64Zlib) {
+            || mLayerDataFormat == Map::Base64Zlib
+            || mLayerDataFormat == Map::Base64Zstandard
+            || mLayerDataFormat == Map::Base64Lz4) {
 
         encoding = QLatin1String("base64");
 
@@ -409,6 +525,10 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
             compression = QLatin1String("gzip");
         else if (mLayerDataFormat == Map::Base64Zlib)
             compression = QLatin1String("zlib");
+        else if (mLayerDataFormat == Map::Base64Zstandard)
+            compression = QLatin1String("zstd");
+        else if (mLayerDataFormat == Map::Base64Lz4)
+            compression = QLatin1String("lz4");
 
     } else if (mLayerDataFormat == Map::CSV)
         encoding = QLatin1String("csv");
@@ -419,44 +539,157 @@ void MapWriterPrivate::writeTileLayer(QXmlStreamWriter &w,
     if (!compression.isEmpty())
         w.writeAttribute(QLatin1String("compression"), compression);
 
-    if (mLayerDataFormat == Map::XML) {
-        for (int y = 0; y < tileLayer.height(); ++y) {
-            for (int x = 0; x < tileLayer.width(); ++x) {
-                const unsigned gid = mGidMapper.cellToGid(tileLayer.cellAt(x, y));
-                w.writeStartElement(QLatin1String("tile"));
-                w.writeAttribute(QLatin1String("gid"), QString::number(gid));
-                w.writeEndElement();
-            }
-        }
-    } else if (mLayerDataFormat == Map::CSV) {
-        QString tileData;
-
-        for (int y = 0; y < tileLayer.height(); ++y) {
-            for (int x = 0; x < tileLayer.width(); ++x) {
-                const unsigned gid = mGidMapper.cellToGid(tileLayer.cellAt(x, y));
-                tileData.append(QString::number(gid));
-                if (x != tileLayer.width() - 1
-                    || y != tileLayer.height() - 1)
-                    tileData.append(QLatin1String(","));
-            }
-            tileData.append(QLatin1String("\n"));
+    if (tileLayer.isInfinite()) {
+        writeChunks(w, tileLayer);
+    } else if (mLayerDataFormat == Map::XML && tileLayer.width() * tileLayer.height() == 0) {
+        // Written as an empty element
+    } else {
+        // Finish the start tag, then write the tile data directly to the
+        // buffer. The output is the same as the writer would produce.
+        w.writeCharacters(QString());
+
+        const QByteArray *cachedData = nullptr;
+        if (mLayerDataCache)
+            cachedData = mLayerDataCache->find(&tileLayer, mLayerDataFormat, mTilesets);
+
+        bool ok = true;
+
+        if (cachedData) {
+            mBuffer.write(*cachedData);
+            flushOutput();
+        } else if (mLayerDataEncoder.contains(&tileLayer)) {
+            QByteArray data;
+            ok = mLayerDataEncoder.take(&tileLayer, data);
+            data.prepend("\n   ", 4);
+
+            if (ok && mLayerDataCache)
+                mLayerDataCache->insert(&tileLayer, mLayerDataFormat, mTilesets, data);
+
+            mBuffer.write(data);
+            flushOutput();
+        } else if (mLayerDataCache) {
+            QByteArray data;
+            ok = writeTileData(tileLayer, [&] (const char *bytes, int length) {
+                data.append(bytes, length);
+            });
+
+            if (ok)
+                mLayerDataCache->insert(&tileLayer, mLayerDataFormat, mTilesets, data);
+
+            mBuffer.write(data);
+            flushOutput();
+        } else {
+            // Stream the data into the buffer, to avoid holding it in
+            // memory at once
+            ok = writeTileData(tileLayer, [this] (const char *bytes, int length) {
+                mBuffer.write(bytes, length);
+                flushOutput();
+            });
         }
 
-        w.writeCharacters(QLatin1String("\n"));
-        w.writeCharacters(tileData);
-    } else {
-        QByteArray tileData = mGidMapper.encodeLayerData(tileLayer,
-                                                         mLayerDataFormat);
+        if (!ok && mError.isEmpty())
+            mError = tr("Failed to compress the data of layer '%1'.").arg(tileLayer.name());
 
-        w.writeCharacters(QLatin1String("\n   "));
-        w.writeCharacters(QString::fromLatin1(tileData));
-        w.writeCharacters(QLatin1String("\n  "));
+        if (mLayerDataFormat != Map::CSV)
+            mBuffer.write("\n  ", 3);
     }
 
     w.writeEndElement(); // </data>
     w.writeEndElement(); // </layer>
 }
 
+/**
+ * Writes the cells of an infinite \a tileLayer as a list of chunks, each of
+ * which is encoded on its own in the current layer data format. Areas
+ * without cells are left out.
+ */
+void MapWriterPrivate::writeChunks(QXmlStreamWriter &w,
+                                   const TileLayer &tileLayer)
+{
+    for (const QRect &rect : tileLayer.chunkRects()) {
+        const QScopedPointer<TileLayer> chunk(tileLayer.copy(rect));
+
+        w.writeStartElement(QLatin1String("chunk"));
+        w.writeAttribute(QLatin1String("x"), QString::number(rect.x()));
+        w.writeAttribute(QLatin1String("y"), QString::number(rect.y()));
+        w.writeAttribute(QLatin1String("width"), QString::number(rect.width()));
+        w.writeAttribute(QLatin1String("height"), QString::number(rect.height()));
+        w.writeCharacters(QString());
+
+        QByteArray data;
+        const bool ok = writeTileData(*chunk, [&] (const char *bytes, int length) {
+            data.append(bytes, length);
+        });
+
+        if (!ok && mError.isEmpty())
+            mError = tr("Failed to compress the data of layer '%1'.").arg(tileLayer.name());
+
+        // The chunk contents are one level deeper than the layer data
+        if (mLayerDataFormat != Map::CSV) {
+            data.replace("\n   ", "\n    ");
+            data.append("\n   ", 4);
+        }
+
+        mBuffer.write(data);
+        w.writeEndElement(); // </chunk>
+        flushOutput();
+    }
+}
+
+/**
+ * Writes the data of the given \a tileLayer in the current layer data
+ * format to the \a sink, as it appears between the tags of the data
+ * element. Rows are formatted directly, without QString temporaries.
+ *
+ * Returns false when compressing the data failed.
+ */
+bool MapWriterPrivate::writeTileData(const TileLayer &tileLayer,
+                                     const CompressionSink &sink) const
+{
+    if (mLayerDataFormat != Map::XML && mLayerDataFormat != Map::CSV) {
+        sink("\n   ", 4);
+        return mGidMapper.encodeLayerData(tileLayer, mLayerDataFormat, sink);
+    }
+
+    const bool xml = mLayerDataFormat == Map::XML;
+    const int width = tileLayer.width();
+    const int height = tileLayer.height();
+
+    static const char tileStart[] = "\n   <tile gid=\"";
+    static const char tileEnd[] = "\"/>";
+    const int maxTileLength = xml ? int(sizeof(tileStart) + sizeof(tileEnd)) + 10 : 11;
+
+    QVector<unsigned> gids(width);
+    QByteArray row(width * maxTileLength + 1, Qt::Uninitialized);
+
+    if (!xml)
+        sink("\n", 1);
+
+    for (int y = 0; y < height; ++y) {
+        mGidMapper.cellsToGids(tileLayer, y, gids.data());
+
+        char *out = row.data();
+        for (int x = 0; x < width; ++x) {
+            if (xml) {
+                memcpy(out, tileStart, sizeof(tileStart) - 1);
+                out = writeNumber(out + sizeof(tileStart) - 1, gids.at(x));
+                memcpy(out, tileEnd, sizeof(tileEnd) - 1);
+                out += sizeof(tileEnd) - 1;
+            } else {
+                out = writeNumber(out, gids.at(x));
+                if (x != width - 1 || y != height - 1)
+                    *out++ = ',';
+            }
+        }
+        if (!xml)
+            *out++ = '\n';
+
+        sink(row.constData(), int(out - row.constData()));
+    }
+
+    return true;
+}
+
 void MapWriterPrivate::writeLayerAttributes(QXmlStreamWriter &w,
                                             const Layer &layer)
 {
@@ -642,6 +875,7 @@ MapWriter::~MapWriter()
 void MapWriter::writeMap(const Map *map, QIODevice *device,
                          const QString &path)
 {
+    TraceScope trace("MapWriter::writeMap", path);
     d->writeMap(map, device, path);
 }
 
@@ -653,6 +887,9 @@ bool MapWriter::writeMap(const Map *map, const QString &fileName)
 
     writeMap(map, &file, QFileInfo(fileName).absolutePath());
 
+    if (!d->mError.isEmpty())
+        return false;
+
     if (file.error() != QFile::NoError) {
         d->mError = file.errorString();
         return false;
@@ -669,6 +906,7 @@ bool MapWriter::writeMap(const Map *map, const QString &fileName)
 void MapWriter::writeTileset(const Tileset &tileset, QIODevice *device,
                              const QString &path)
 {
+    TraceScope trace("MapWriter::writeTileset", path);
     d->writeTileset(tileset, device, path);
 }
 
@@ -702,3 +940,13 @@ bool MapWriter::isDtdEnabled() const
 {
     return d->mDtdEnabled;
 }
+
+void MapWriter::setLayerDataCache(LayerDataCache *cache)
+{
+    d->mLayerDataCache = cache;
+}
+
+void MapWriter::setWriteOptions(const MapWriteOptions &options)
+{
+    d->mWriteOptions = options;
+}
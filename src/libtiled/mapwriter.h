@@ -31,6 +31,7 @@
 #define MAPWRITER_H
 
 #include "map.h"
+#include "mapstreamoptions.h"
 #include "tiled_global.h"
 
 #include <QString>
@@ -39,6 +40,7 @@ class QIODevice;
 
 namespace Tiled {
 
+class LayerDataCache;
 class Map;
 class Tileset;
 
@@ -104,6 +106,20 @@ public:
     void setDtdEnabled(bool enabled);
     bool isDtdEnabled() const;
 
+    /**
+     * Sets a cache of encoded tile layer data. When set, the data of tile
+     * layers found in the cache is written from there, and the data of
+     * other tile layers is added to it.
+     */
+    void setLayerDataCache(LayerDataCache *cache);
+
+    /**
+     * Sets the options used when writing maps. Progress is reported in
+     * layers written. When writing is cancelled, errorString() is set and
+     * the output is left incomplete.
+     */
+    void setWriteOptions(const MapWriteOptions &options);
+
 private:
     Internal::MapWriterPrivate *d;
 };
@@ -74,7 +74,7 @@ public:
      * Replaces all existing properties with a new set of properties.
      */
     void setProperties(const Properties &properties)
-    { mProperties = properties; }
+    { mProperties = properties; propertiesChanged(); }
 
     /**
      * Merges \a properties with the existing properties. Properties with the
@@ -83,7 +83,7 @@ public:
      * \sa Properties::merge
      */
     void mergeProperties(const Properties &properties)
-    { mProperties.merge(properties); }
+    { mProperties.merge(properties); propertiesChanged(); }
 
     /**
      * Returns the value of the object's \a name property.
@@ -101,13 +101,19 @@ public:
      * Sets the value of the object's \a name property to \a value.
      */
     void setProperty(const QString &name, const QString &value)
-    { mProperties.insert(name, value); }
+    { mProperties.insert(name, value); propertiesChanged(); }
 
     /**
      * Removes the property with the given \a name.
      */
     void removeProperty(const QString &name)
-    { mProperties.remove(name); }
+    { mProperties.remove(name); propertiesChanged(); }
+
+protected:
+    /**
+     * Called after the properties of this object have changed.
+     */
+    virtual void propertiesChanged() {}
 
 private:
     TypeId mTypeId;
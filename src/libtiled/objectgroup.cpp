@@ -42,6 +42,7 @@ using namespace Tiled;
 ObjectGroup::ObjectGroup()
     : Layer(ObjectGroupType, QString(), 0, 0, 0, 0)
     , mDrawOrder(TopDownOrder)
+    , mObjectIndexBuilt(false)
 {
 }
 
@@ -49,6 +50,7 @@ ObjectGroup::ObjectGroup(const QString &name,
                          int x, int y, int width, int height)
     : Layer(ObjectGroupType, name, x, y, width, height)
     , mDrawOrder(TopDownOrder)
+    , mObjectIndexBuilt(false)
 {
 }
 
@@ -61,6 +63,8 @@ void ObjectGroup::addObject(MapObject *object)
 {
     mObjects.append(object);
     object->setObjectGroup(this);
+    if (mObjectIndexBuilt)
+        mObjectIndex.insert(object);
     if (mMap && object->id() == 0)
         object->setId(mMap->takeNextObjectId());
 }
@@ -69,10 +73,36 @@ void ObjectGroup::insertObject(int index, MapObject *object)
 {
     mObjects.insert(index, object);
     object->setObjectGroup(this);
+    if (mObjectIndexBuilt)
+        mObjectIndex.insert(object);
     if (mMap && object->id() == 0)
         object->setId(mMap->takeNextObjectId());
 }
 
+void ObjectGroup::insertObjects(int index, const QList<MapObject*> &objects)
+{
+    if (index == mObjects.size())
+        mObjects.append(objects);
+    else
+        mObjects = mObjects.mid(0, index) + objects + mObjects.mid(index);
+
+    int newIdCount = 0;
+    for (MapObject *object : objects) {
+        object->setObjectGroup(this);
+        if (mObjectIndexBuilt)
+            mObjectIndex.insert(object);
+        if (object->id() == 0)
+            ++newIdCount;
+    }
+
+    if (mMap && newIdCount > 0) {
+        int id = mMap->takeNextObjectIds(newIdCount);
+        for (MapObject *object : objects)
+            if (object->id() == 0)
+                object->setId(id++);
+    }
+}
+
 int ObjectGroup::removeObject(MapObject *object)
 {
     const int index = mObjects.indexOf(object);
@@ -80,6 +110,7 @@ int ObjectGroup::removeObject(MapObject *object)
 
     mObjects.removeAt(index);
     object->setObjectGroup(nullptr);
+    mObjectIndex.remove(object);
     return index;
 }
 
@@ -87,6 +118,7 @@ void ObjectGroup::removeObjectAt(int index)
 {
     MapObject *object = mObjects.takeAt(index);
     object->setObjectGroup(nullptr);
+    mObjectIndex.remove(object);
 }
 
 void ObjectGroup::moveObjects(int from, int to, int count)
@@ -119,6 +151,23 @@ QRectF ObjectGroup::objectsBoundingRect() const
     return boundingRect;
 }
 
+const MapObjectIndex &ObjectGroup::objectIndex() const
+{
+    if (!mObjectIndexBuilt) {
+        for (MapObject *object : mObjects)
+            mObjectIndex.insert(object);
+        mObjectIndexBuilt = true;
+    }
+
+    return mObjectIndex;
+}
+
+void ObjectGroup::updateObjectIndex(MapObject *object)
+{
+    Q_ASSERT(object->objectGroup() == this);
+    mObjectIndex.update(object);
+}
+
 bool ObjectGroup::isEmpty() const
 {
     return mObjects.isEmpty();
@@ -155,6 +204,7 @@ void ObjectGroup::replaceReferencesToTileset(Tileset *oldTileset,
             Cell cell = object->cell();
             cell.tile = newTileset->tileAt(tile->id());
             object->setCell(cell);
+            mObjectIndex.update(object);
         }
     }
 }
@@ -181,6 +231,7 @@ void ObjectGroup::offsetObjects(const QPointF &offset,
         }
 
         object->setPosition(object->position() + (newCenter - objectCenter));
+        mObjectIndex.update(object);
     }
 }
 
@@ -211,6 +262,14 @@ Layer *ObjectGroup::clone() const
     return initializeClone(new ObjectGroup(mName, mX, mY, mWidth, mHeight));
 }
 
+qint64 ObjectGroup::memoryUsage() const
+{
+    qint64 usage = Layer::memoryUsage() + qint64(mObjects.size()) * sizeof(MapObject*);
+    for (const MapObject *object : mObjects)
+        usage += object->memoryUsage();
+    return usage;
+}
+
 ObjectGroup *ObjectGroup::initializeClone(ObjectGroup *clone) const
 {
     Layer::initializeClone(clone);
@@ -34,6 +34,7 @@
 #include "tiled_global.h"
 
 #include "layer.h"
+#include "mapobjectindex.h"
 
 #include <QColor>
 #include <QList>
@@ -103,6 +104,12 @@ public:
      */
     void insertObject(int index, MapObject *object);
 
+    /**
+     * Inserts the given \a objects at the specified index. Objects without
+     * an id are given consecutive ids allocated in one step.
+     */
+    void insertObjects(int index, const QList<MapObject*> &objects);
+
     /**
      * Removes an object from this object group. Ownership of the object is
      * transferred to the caller.
@@ -134,6 +141,26 @@ public:
      */
     QRectF objectsBoundingRect() const;
 
+    /**
+     * Returns the spatial index of the objects in this group. The index is
+     * built on first use.
+     */
+    const MapObjectIndex &objectIndex() const;
+
+    /**
+     * Returns the objects in this group whose bounds intersect the given
+     * \a rect in pixel coordinates, in no particular order.
+     */
+    QList<MapObject*> objectsIntersecting(const QRectF &rect) const
+    { return objectIndex().objectsIntersecting(rect); }
+
+    /**
+     * Updates the spatial index after the geometry of the given \a object
+     * was changed. Needs to be called by anybody changing the position,
+     * size, shape, rotation or tile of an object in this group.
+     */
+    void updateObjectIndex(MapObject *object);
+
     /**
      * Returns whether this object group contains any objects.
      */
@@ -179,6 +206,8 @@ public:
 
     Layer *clone() const override;
 
+    qint64 memoryUsage() const override;
+
 protected:
     ObjectGroup *initializeClone(ObjectGroup *clone) const;
 
@@ -186,6 +215,8 @@ private:
     QList<MapObject*> mObjects;
     QColor mColor;
     DrawOrder mDrawOrder;
+    mutable MapObjectIndex mObjectIndex;
+    mutable bool mObjectIndexBuilt;
 };
 
 
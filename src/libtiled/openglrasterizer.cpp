@@ -0,0 +1,140 @@
+/*
+ * openglrasterizer.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "openglrasterizer.h"
+
+#ifndef QT_NO_OPENGL
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QOpenGLPaintDevice>
+#include <QPainter>
+#include <QThread>
+
+using namespace Tiled;
+
+// Larger tiles mean fewer read backs, but may exceed the limits of the driver
+static const int MaxTileSize = 4096;
+
+OpenGLRasterizer::OpenGLRasterizer()
+    : mSurface(new QOffscreenSurface)
+{
+    mSurface->create();
+}
+
+OpenGLRasterizer::~OpenGLRasterizer()
+{
+}
+
+/**
+ * Returns whether rendering with OpenGL is possible on the current thread.
+ * Even when it is, render() may still fail, for example when no context can
+ * be created.
+ */
+bool OpenGLRasterizer::isAvailable() const
+{
+    if (!mSurface->isValid())
+        return false;
+
+    if (QThread::currentThread() != mSurface->thread())
+        return QOpenGLContext::supportsThreadedOpenGL();
+
+    return true;
+}
+
+/**
+ * Draws the whole \a image using the \a draw function. The result is drawn
+ * on top of the existing content of the image.
+ *
+ * Returns false without changing the image when OpenGL can't be used, in
+ * which case the image needs to be drawn in software instead.
+ */
+bool OpenGLRasterizer::render(QImage &image, const DrawFunction &draw) const
+{
+    if (!isAvailable())
+        return false;
+    if (image.isNull())
+        return true;
+
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(mSurface.data()))
+        return false;
+
+    GLint maxTextureSize = 0;
+    context.functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    const int tileSize = qMin(MaxTileSize, int(maxTextureSize));
+    if (tileSize <= 0) {
+        context.doneCurrent();
+        return false;
+    }
+
+    const QSize fboSize(qMin(tileSize, image.width()),
+                        qMin(tileSize, image.height()));
+
+    // The stencil buffer is used by the paint engine for clipping
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+
+    QOpenGLFramebufferObject fbo(fboSize, format);
+    if (!fbo.isValid() || !fbo.bind()) {
+        context.doneCurrent();
+        return false;
+    }
+
+    QOpenGLPaintDevice device(fboSize);
+    QPainter imagePainter(&image);
+
+    for (int y = 0; y < image.height(); y += fboSize.height()) {
+        for (int x = 0; x < image.width(); x += fboSize.width()) {
+            const QRect rect = QRect(QPoint(x, y), fboSize) & image.rect();
+
+            QPainter painter(&device);
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            painter.fillRect(QRect(QPoint(), fboSize), Qt::transparent);
+            painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+            painter.translate(-rect.topLeft());
+
+            draw(painter, rect);
+            painter.end();
+
+            imagePainter.drawImage(rect.topLeft(), fbo.toImage(),
+                                   QRect(QPoint(), rect.size()));
+        }
+    }
+
+    imagePainter.end();
+    fbo.release();
+    context.doneCurrent();
+
+    return true;
+}
+
+#endif // QT_NO_OPENGL
@@ -0,0 +1,81 @@
+/*
+ * openglrasterizer.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_OPENGLRASTERIZER_H
+#define TILED_OPENGLRASTERIZER_H
+
+#ifndef QT_NO_OPENGL
+
+#include "tiled_global.h"
+
+#include <QImage>
+#include <QRect>
+#include <QScopedPointer>
+
+#include <functional>
+
+class QOffscreenSurface;
+class QPainter;
+
+namespace Tiled {
+
+/**
+ * Rasterizes into images with the OpenGL paint engine, using a framebuffer
+ * object on an offscreen surface. The image is drawn in large tiles, each of
+ * which is read back and composited onto the image.
+ *
+ * The rasterizer needs to be created on the GUI thread. Rendering may happen
+ * on another thread when the platform supports threaded OpenGL, in which case
+ * isAvailable() returns true.
+ */
+class TILEDSHARED_EXPORT OpenGLRasterizer
+{
+public:
+    /**
+     * Draws the \a rect of the image with the given \a painter. The painter
+     * is translated to draw in image coordinates, so any further transform
+     * should be combined with the existing one.
+     */
+    typedef std::function<void (QPainter &painter, const QRect &rect)> DrawFunction;
+
+    OpenGLRasterizer();
+    ~OpenGLRasterizer();
+
+    bool isAvailable() const;
+
+    bool render(QImage &image, const DrawFunction &draw) const;
+
+private:
+    QScopedPointer<QOffscreenSurface> mSurface;
+};
+
+} // namespace Tiled
+
+#endif // QT_NO_OPENGL
+
+#endif // TILED_OPENGLRASTERIZER_H
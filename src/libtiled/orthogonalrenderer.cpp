@@ -36,6 +36,8 @@
 
 #include <QtCore/qmath.h>
 
+#include <algorithm>
+
 using namespace Tiled;
 
 QSize OrthogonalRenderer::mapSize() const
@@ -55,7 +57,7 @@ QRect OrthogonalRenderer::boundingRect(const QRect &rect) const
                  rect.height() * tileHeight);
 }
 
-QRectF OrthogonalRenderer::boundingRect(const MapObject *object) const
+QRectF OrthogonalRenderer::objectBoundingRect(const MapObject *object) const
 {
     const QRectF bounds = object->bounds();
 
@@ -64,7 +66,7 @@ QRectF OrthogonalRenderer::boundingRect(const MapObject *object) const
     if (!object->cell().isEmpty()) {
         const QPointF bottomLeft = bounds.topLeft();
         const Tile *tile = object->cell().tile;
-        const QSize imgSize = tile->image().size();
+        const QSize imgSize = tile->size();
         const QPoint tileOffset = tile->offset();
         const QSizeF objectSize = object->size();
         const QSizeF scale(objectSize.width() / imgSize.width(), objectSize.height() / imgSize.height());
@@ -112,7 +114,7 @@ QRectF OrthogonalRenderer::boundingRect(const MapObject *object) const
     return boundingRect;
 }
 
-QPainterPath OrthogonalRenderer::shape(const MapObject *object) const
+QPainterPath OrthogonalRenderer::objectShape(const MapObject *object) const
 {
     QPainterPath path;
 
@@ -132,8 +134,9 @@ QPainterPath OrthogonalRenderer::shape(const MapObject *object) const
         }
         case MapObject::Polygon:
         case MapObject::Polyline: {
+            // Picking doesn't need to be precise to the pixel
             const QPointF &pos = object->position();
-            const QPolygonF polygon = object->polygon().translated(pos);
+            const QPolygonF polygon = simplifiedPolygon(object, 1).translated(pos);
             const QPolygonF screenPolygon = pixelToScreenCoords(polygon);
             if (object->shape() == MapObject::Polygon) {
                 path.addPolygon(screenPolygon);
@@ -184,18 +187,29 @@ void OrthogonalRenderer::drawGrid(QPainter *painter, const QRectF &rect,
     gridPen.setCosmetic(true);
     gridPen.setDashPattern(QVector<qreal>() << 2 << 2);
 
+    // The lines of each direction are drawn in one call, since they share
+    // the dash offset
+    QVector<QLine> lines;
+
     if (startY < endY) {
+        lines.reserve((endX - startX) / tileWidth + 1);
+        for (int x = startX; x < endX; x += tileWidth)
+            lines.append(QLine(x, startY, x, endY - 1));
+
         gridPen.setDashOffset(startY);
         painter->setPen(gridPen);
-        for (int x = startX; x < endX; x += tileWidth)
-            painter->drawLine(x, startY, x, endY - 1);
+        painter->drawLines(lines);
+        lines.resize(0);
     }
 
     if (startX < endX) {
+        lines.reserve((endY - startY) / tileHeight + 1);
+        for (int y = startY; y < endY; y += tileHeight)
+            lines.append(QLine(startX, y, endX - 1, y));
+
         gridPen.setDashOffset(startX);
         painter->setPen(gridPen);
-        for (int y = startY; y < endY; y += tileHeight)
-            painter->drawLine(startX, y, endX - 1, y);
+        painter->drawLines(lines);
     }
 }
 
@@ -212,10 +226,12 @@ void OrthogonalRenderer::drawTileLayer(QPainter *painter,
 
     painter->translate(layerPos);
 
-    int startX = 0;
-    int startY = 0;
-    int endX = layer->width() - 1;
-    int endY = layer->height() - 1;
+    const QRect bounds = layer->cellBounds();
+
+    int startX = bounds.left();
+    int startY = bounds.top();
+    int endX = bounds.right();
+    int endY = bounds.bottom();
 
     if (!exposed.isNull()) {
         QMargins drawMargins = layer->drawMargins();
@@ -229,8 +245,8 @@ void OrthogonalRenderer::drawTileLayer(QPainter *painter,
 
         rect.translate(-layerPos);
 
-        startX = qMax(qFloor(rect.x() / tileWidth), 0);
-        startY = qMax(qFloor(rect.y() / tileHeight), 0);
+        startX = qMax(qFloor(rect.x() / tileWidth), startX);
+        startY = qMax(qFloor(rect.y() / tileHeight), startY);
         endX = qMin(qCeil(rect.right()) / tileWidth, endX);
         endY = qMin(qCeil(rect.bottom()) / tileHeight, endY);
     }
@@ -239,7 +255,7 @@ void OrthogonalRenderer::drawTileLayer(QPainter *painter,
     if (startX > endX || startY > endY)
         return;
 
-    CellRenderer renderer(painter);
+    CellRenderer renderer(painter, flags(), images());
 
     Map::RenderOrder renderOrder = map()->renderOrder();
 
@@ -375,7 +391,8 @@ void OrthogonalRenderer::drawMapObject(QPainter *painter,
         }
 
         case MapObject::Polyline: {
-            QPolygonF screenPolygon = pixelToScreenCoords(object->polygon());
+            const qreal tolerance = simplificationTolerance(painter);
+            QPolygonF screenPolygon = pixelToScreenCoords(simplifiedPolygon(object, tolerance));
 
             QPen thickShadowPen(shadowPen);
             QPen thickLinePen(linePen);
@@ -396,7 +413,8 @@ void OrthogonalRenderer::drawMapObject(QPainter *painter,
         }
 
         case MapObject::Polygon: {
-            QPolygonF screenPolygon = pixelToScreenCoords(object->polygon());
+            const qreal tolerance = simplificationTolerance(painter);
+            QPolygonF screenPolygon = pixelToScreenCoords(simplifiedPolygon(object, tolerance));
 
             QPen thickShadowPen(shadowPen);
             QPen thickLinePen(linePen);
@@ -435,6 +453,101 @@ void OrthogonalRenderer::drawMapObject(QPainter *painter,
     painter->restore();
 }
 
+/**
+ * Draws the objects in batches. Consecutive tile objects are drawn through
+ * a single CellRenderer, and consecutive rectangle and ellipse objects of
+ * the same color are combined into one path. Other objects are drawn one
+ * by one.
+ */
+void OrthogonalRenderer::drawMapObjects(QPainter *painter,
+                                        const QList<MapObject*> &objects,
+                                        const QVector<QColor> &colors) const
+{
+    Q_ASSERT(objects.size() == colors.size());
+
+    const qreal lineWidth = objectLineWidth();
+    const qreal shadowDist = (lineWidth == 0 ? 1 : lineWidth) / painterScale();
+    const QPointF shadowOffset = QPointF(shadowDist * 0.5, shadowDist * 0.5);
+    const bool showTileObjectOutlines = testFlag(ShowTileObjectOutlines);
+
+    CellRenderer cellRenderer(painter, RenderFlags(), images());
+    QPainterPath path;
+    QColor pathColor;
+
+    auto flushPath = [&] {
+        if (path.isEmpty())
+            return;
+
+        QPen linePen(pathColor, lineWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+        linePen.setCosmetic(true);
+        QPen shadowPen(linePen);
+        shadowPen.setColor(Qt::black);
+
+        QColor brushColor = pathColor;
+        brushColor.setAlpha(50);
+
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setPen(shadowPen);
+        painter->drawPath(path.translated(shadowOffset));
+        painter->setPen(linePen);
+        painter->setBrush(brushColor);
+        painter->drawPath(path);
+        painter->restore();
+
+        path = QPainterPath();
+        path.setFillRule(Qt::WindingFill);
+    };
+
+    path.setFillRule(Qt::WindingFill);
+
+    for (int i = 0; i < objects.size(); ++i) {
+        const MapObject *object = objects.at(i);
+        const QColor &color = colors.at(i);
+        const Cell &cell = object->cell();
+        const MapObject::Shape shape = object->shape();
+
+        const bool batchable = object->rotation() == qreal(0) &&
+                (cell.isEmpty() ? (shape == MapObject::Rectangle ||
+                                   shape == MapObject::Ellipse)
+                                : !showTileObjectOutlines);
+
+        if (!batchable) {
+            cellRenderer.flush();
+            flushPath();
+            drawRotatedMapObject(painter, object, color);
+            continue;
+        }
+
+        if (!cell.isEmpty()) {
+            flushPath();
+            cellRenderer.render(cell, object->position(), object->size(),
+                                CellRenderer::BottomLeft);
+            continue;
+        }
+
+        cellRenderer.flush();
+        if (pathColor != color) {
+            flushPath();
+            pathColor = color;
+        }
+
+        QRectF rect = object->bounds();
+        if (rect.isNull())
+            rect = QRectF(rect.topLeft() - QPointF(10, 10), QSizeF(20, 20));
+
+        // See drawMapObject about drawing some ellipses as rectangles
+        if (shape == MapObject::Ellipse &&
+                !((rect.width() == qreal(0)) ^ (rect.height() == qreal(0))))
+            path.addEllipse(rect);
+        else
+            path.addRect(rect);
+    }
+
+    cellRenderer.flush();
+    flushPath();
+}
+
 QPointF OrthogonalRenderer::pixelToTileCoords(qreal x, qreal y) const
 {
     return QPointF(x / map()->tileWidth(),
@@ -468,3 +581,17 @@ QPointF OrthogonalRenderer::pixelToScreenCoords(qreal x, qreal y) const
 {
     return QPointF(x, y);
 }
+
+void OrthogonalRenderer::screenToPixelCoords(const QPointF *points, QPointF *result,
+                                             int count) const
+{
+    if (points != result)
+        std::copy(points, points + count, result);
+}
+
+void OrthogonalRenderer::pixelToScreenCoords(const QPointF *points, QPointF *result,
+                                             int count) const
+{
+    if (points != result)
+        std::copy(points, points + count, result);
+}
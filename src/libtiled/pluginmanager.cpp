@@ -28,18 +28,23 @@
 
 #include "pluginmanager.h"
 
+#include "deferredformat.h"
 #include "mapformat.h"
 #include "plugin.h"
+#include "tracing.h"
 
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
 #include <QDirIterator>
+#include <QJsonArray>
+#include <QMutexLocker>
 #include <QPluginLoader>
 
 namespace Tiled {
 
 PluginManager *PluginManager::mInstance;
+QMutex PluginManager::mMutex(QMutex::Recursive);
 
 PluginManager::PluginManager()
 {
@@ -51,6 +56,8 @@ PluginManager::~PluginManager()
 
 PluginManager *PluginManager::instance()
 {
+    QMutexLocker locker(&mMutex);
+
     if (!mInstance)
         mInstance = new PluginManager;
 
@@ -59,6 +66,8 @@ PluginManager *PluginManager::instance()
 
 void PluginManager::deleteInstance()
 {
+    QMutexLocker locker(&mMutex);
+
     delete mInstance;
     mInstance = nullptr;
 }
@@ -69,7 +78,11 @@ void PluginManager::addObject(QObject *object)
     Q_ASSERT(mInstance);
     Q_ASSERT(!mInstance->mObjects.contains(object));
 
-    mInstance->mObjects.append(object);
+    {
+        QMutexLocker locker(&mMutex);
+        mInstance->mObjects.append(object);
+    }
+
     emit mInstance->objectAdded(object);
 }
 
@@ -80,19 +93,19 @@ void PluginManager::removeObject(QObject *object)
     Q_ASSERT(mInstance->mObjects.contains(object));
 
     emit mInstance->objectAboutToBeRemoved(object);
+
+    QMutexLocker locker(&mMutex);
     mInstance->mObjects.removeOne(object);
 }
 
 void PluginManager::loadPlugins()
 {
+    TraceScope trace("PluginManager::loadPlugins");
+
     // Load static plugins
     foreach (QObject *instance, QPluginLoader::staticInstances()) {
         mPlugins.append(LoadedPlugin(QLatin1String("<static>"), instance));
-
-        if (Plugin *plugin = qobject_cast<Plugin*>(instance))
-            plugin->initialize();
-        else
-            addObject(instance);
+        initializePlugin(mPlugins.size() - 1);
     }
 
     // Determine the plugin path based on the application location
@@ -118,20 +131,116 @@ void PluginManager::loadPlugins()
             continue;
 
         QPluginLoader loader(pluginFile);
+
+        // Plugins that describe their formats are only loaded once one of
+        // their formats is actually used
+        const QJsonObject metaData = loader.metaData().value(QLatin1String("MetaData")).toObject();
+        mPlugins.append(LoadedPlugin(pluginFile, nullptr));
+        if (addDeferredFormats(mPlugins.size() - 1, metaData))
+            continue;
+
         QObject *instance = loader.instance();
 
         if (!instance) {
             qWarning() << "Error:" << qPrintable(loader.errorString());
+            mPlugins.removeLast();
             continue;
         }
 
-        mPlugins.append(LoadedPlugin(pluginFile, instance));
+        mPlugins.last().instance = instance;
+        initializePlugin(mPlugins.size() - 1);
+    }
+}
+
+/**
+ * Loads the plugin at the given \a index, in case its loading was deferred.
+ * The deferred formats standing in for the plugin's formats are replaced by
+ * the formats of the plugin, but they stay valid and forward to them.
+ *
+ * Can be called from any thread, since deferred formats may be used by
+ * threads reading or writing files.
+ *
+ * Returns whether the plugin is loaded.
+ */
+bool PluginManager::loadDeferredPlugin(int index)
+{
+    QMutexLocker locker(&mMutex);
+
+    LoadedPlugin &loadedPlugin = mPlugins[index];
+    if (loadedPlugin.instance)
+        return true;
+    if (!loadedPlugin.errorString.isEmpty())
+        return false;
+
+    TraceScope trace("PluginManager::loadDeferredPlugin", loadedPlugin.fileName);
 
-        if (Plugin *plugin = qobject_cast<Plugin*>(instance))
-            plugin->initialize();
-        else
-            addObject(instance);
+    QPluginLoader loader(loadedPlugin.fileName);
+    QObject *instance = loader.instance();
+
+    if (!instance) {
+        loadedPlugin.errorString = loader.errorString();
+        qWarning() << "Error:" << qPrintable(loadedPlugin.errorString);
+        return false;
     }
+
+    for (QObject *object : loadedPlugin.deferredObjects)
+        removeObject(object);
+
+    loadedPlugin.instance = instance;
+    initializePlugin(index);
+
+    // Keep the plugin and the objects it created with the plugin manager
+    if (instance->thread() != thread())
+        instance->moveToThread(thread());
+
+    return true;
+}
+
+/**
+ * Creates deferred formats for the formats listed in the given plugin
+ * \a metaData. Returns false when the plugin doesn't list its formats, in
+ * which case it needs to be loaded right away.
+ */
+bool PluginManager::addDeferredFormats(int index, const QJsonObject &metaData)
+{
+    const QJsonArray mapFormats = metaData.value(QLatin1String("MapFormats")).toArray();
+    const QJsonArray tilesetFormats = metaData.value(QLatin1String("TilesetFormats")).toArray();
+
+    if (mapFormats.isEmpty() && tilesetFormats.isEmpty())
+        return false;
+
+    LoadedPlugin &loadedPlugin = mPlugins[index];
+
+    for (int i = 0; i < mapFormats.size(); ++i) {
+        const DeferredFormatInfo info(index, i, mapFormats.at(i).toObject());
+        loadedPlugin.deferredObjects.append(new DeferredMapFormat(info, this));
+    }
+    for (int i = 0; i < tilesetFormats.size(); ++i) {
+        const DeferredFormatInfo info(index, i, tilesetFormats.at(i).toObject());
+        loadedPlugin.deferredObjects.append(new DeferredTilesetFormat(info, this));
+    }
+
+    for (QObject *object : loadedPlugin.deferredObjects)
+        addObject(object);
+
+    return true;
+}
+
+/**
+ * Initializes the plugin at the given \a index, remembering the objects it
+ * adds.
+ */
+void PluginManager::initializePlugin(int index)
+{
+    const int first = mObjects.size();
+    QObject *instance = mPlugins.at(index).instance;
+
+    if (Plugin *plugin = qobject_cast<Plugin*>(instance))
+        plugin->initialize();
+    else
+        addObject(instance);
+
+    mPlugins[index].objects = mObjects.mid(first);
 }
 
 const LoadedPlugin *PluginManager::pluginByFileName(const QString &pluginFileName) const
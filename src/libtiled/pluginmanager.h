@@ -31,7 +31,9 @@
 
 #include "tiled_global.h"
 
+#include <QJsonObject>
 #include <QList>
+#include <QMutex>
 #include <QObject>
 #include <QString>
 
@@ -45,11 +47,17 @@ struct LoadedPlugin
     {}
 
     QString fileName;
-    QObject *instance;
+    QObject *instance;      // null while the plugin is deferred
+    QString errorString;    // set when loading a deferred plugin failed
+    QObjectList deferredObjects;
+    QObjectList objects;    // the objects added by the plugin
 };
 
 /**
  * The plugin manager loads the plugins and provides ways to access them.
+ *
+ * Creating the instance and looking up objects is thread-safe. Loading the
+ * plugins, including deferred ones, should be done on the main thread.
  */
 class TILEDSHARED_EXPORT PluginManager : public QObject
 {
@@ -91,6 +99,9 @@ public:
     static QList<T*> objects()
     {
         QList<T*> results;
+        QMutexLocker locker(&mMutex);
+        if (!mInstance)
+            return results;
         for (QObject *object : mInstance->mObjects)
             if (T *result = qobject_cast<T*>(object))
                 results.append(result);
@@ -99,6 +110,8 @@ public:
 
     const LoadedPlugin *pluginByFileName(const QString &pluginFileName) const;
 
+    bool loadDeferredPlugin(int index);
+
 signals:
     void objectAdded(QObject *object);
     void objectAboutToBeRemoved(QObject *object);
@@ -109,7 +122,11 @@ private:
     PluginManager();
     ~PluginManager();
 
+    bool addDeferredFormats(int index, const QJsonObject &metaData);
+    void initializePlugin(int index);
+
     static PluginManager *mInstance;
+    static QMutex mMutex;
 
     QList<LoadedPlugin> mPlugins;
     QObjectList mObjects;
@@ -0,0 +1,226 @@
+/*
+ * pngwriter.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "pngwriter.h"
+
+#include "compression.h"
+
+#ifdef Q_OS_WIN
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+#include <QCoreApplication>
+#include <QIODevice>
+#include <QImage>
+#include <QtEndian>
+
+using namespace Tiled;
+
+namespace {
+
+const char PngSignature[8] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+
+// PNG filter type that stores the difference with the pixel to the left
+const char SubFilter = 1;
+
+const int BytesPerPixel = 4;
+
+} // anonymous namespace
+
+PngWriter::PngWriter(QIODevice *device)
+    : mDevice(device)
+    , mCompressor(nullptr)
+    , mRowsWritten(0)
+{
+}
+
+PngWriter::~PngWriter()
+{
+    delete mCompressor;
+}
+
+/**
+ * Writes the PNG header for an image of the given \a size. Returns false
+ * when an error occurred.
+ */
+bool PngWriter::begin(const QSize &size)
+{
+    Q_ASSERT(!mCompressor);
+
+    if (size.isEmpty()) {
+        setError(QCoreApplication::translate("PngWriter", "Invalid image size"));
+        return false;
+    }
+
+    mSize = size;
+    mRowsWritten = 0;
+
+    if (mDevice->write(PngSignature, sizeof(PngSignature)) != sizeof(PngSignature)) {
+        setError(mDevice->errorString());
+        return false;
+    }
+
+    // Width, height, bit depth, color type (RGBA), compression, filter and
+    // interlace method
+    char header[13];
+    qToBigEndian<quint32>(size.width(), reinterpret_cast<uchar*>(header));
+    qToBigEndian<quint32>(size.height(), reinterpret_cast<uchar*>(header + 4));
+    header[8] = 8;
+    header[9] = 6;
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+
+    if (!writeChunk("IHDR", header, sizeof(header)))
+        return false;
+
+    // The compressed image data is split into IDAT chunks as it comes out
+    mCompressor = new Compressor(Zlib, [this] (const char *data, int length) {
+        writeChunk("IDAT", data, length);
+    });
+
+    return true;
+}
+
+/**
+ * Appends the rows of the given image, which needs to have the width of the
+ * image passed to begin(). Returns false when an error occurred.
+ */
+bool PngWriter::writeRows(const QImage &rows)
+{
+    if (!mCompressor || !mError.isEmpty())
+        return false;
+
+    if (rows.width() != mSize.width() ||
+            mRowsWritten + rows.height() > mSize.height()) {
+        setError(QCoreApplication::translate("PngWriter", "Rows don't fit the image"));
+        return false;
+    }
+
+    const QImage image = rows.convertToFormat(QImage::Format_ARGB32);
+    const int width = image.width();
+
+    QByteArray line(1 + width * BytesPerPixel, Qt::Uninitialized);
+
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *pixels = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        uchar *out = reinterpret_cast<uchar*>(line.data());
+
+        *out++ = SubFilter;
+
+        uchar previous[BytesPerPixel] = { 0, 0, 0, 0 };
+
+        for (int x = 0; x < width; ++x) {
+            const QRgb pixel = pixels[x];
+            const uchar rgba[BytesPerPixel] = {
+                uchar(qRed(pixel)),
+                uchar(qGreen(pixel)),
+                uchar(qBlue(pixel)),
+                uchar(qAlpha(pixel))
+            };
+
+            for (int i = 0; i < BytesPerPixel; ++i) {
+                *out++ = uchar(rgba[i] - previous[i]);
+                previous[i] = rgba[i];
+            }
+        }
+
+        if (!mCompressor->write(line.constData(), line.size())) {
+            setError(QCoreApplication::translate("PngWriter", "Compression failed"));
+            return false;
+        }
+    }
+
+    mRowsWritten += image.height();
+    return mError.isEmpty();
+}
+
+/**
+ * Flushes the compressed image data and ends the PNG file. All rows need to
+ * have been written. Returns false when an error occurred at any point.
+ */
+bool PngWriter::finish()
+{
+    if (!mCompressor || !mError.isEmpty())
+        return false;
+
+    if (mRowsWritten != mSize.height()) {
+        setError(QCoreApplication::translate("PngWriter", "Not all rows were written"));
+        return false;
+    }
+
+    if (!mCompressor->finish()) {
+        setError(QCoreApplication::translate("PngWriter", "Compression failed"));
+        return false;
+    }
+
+    delete mCompressor;
+    mCompressor = nullptr;
+
+    return writeChunk("IEND", nullptr, 0);
+}
+
+bool PngWriter::writeChunk(const char type[4], const char *data, int length)
+{
+    if (!mError.isEmpty())
+        return false;
+
+    uchar lengthBytes[4];
+    qToBigEndian<quint32>(length, lengthBytes);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(type), 4);
+    if (length > 0)
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(data), length);
+
+    uchar crcBytes[4];
+    qToBigEndian<quint32>(quint32(crc), crcBytes);
+
+    const bool ok =
+            mDevice->write(reinterpret_cast<const char*>(lengthBytes), 4) == 4 &&
+            mDevice->write(type, 4) == 4 &&
+            (length == 0 || mDevice->write(data, length) == length) &&
+            mDevice->write(reinterpret_cast<const char*>(crcBytes), 4) == 4;
+
+    if (!ok)
+        setError(mDevice->errorString());
+
+    return ok;
+}
+
+void PngWriter::setError(const QString &error)
+{
+    if (!mError.isEmpty())
+        return;
+
+    mError = error;
+    if (mError.isEmpty())
+        mError = QCoreApplication::translate("PngWriter", "Unknown error");
+}
@@ -0,0 +1,81 @@
+/*
+ * pngwriter.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_PNGWRITER_H
+#define TILED_PNGWRITER_H
+
+#include "tiled_global.h"
+
+#include <QSize>
+#include <QString>
+
+class QImage;
+class QIODevice;
+
+namespace Tiled {
+
+class Compressor;
+
+/**
+ * Writes a PNG image one band of rows at a time, so that images can be
+ * written without having the complete image in memory.
+ *
+ * Call begin() with the size of the image, then writeRows() until all rows
+ * have been written, and finally finish(). The image is stored as 8-bit
+ * RGBA with non-premultiplied alpha.
+ */
+class TILEDSHARED_EXPORT PngWriter
+{
+public:
+    explicit PngWriter(QIODevice *device);
+    ~PngWriter();
+
+    bool begin(const QSize &size);
+    bool writeRows(const QImage &rows);
+    bool finish();
+
+    int rowsWritten() const { return mRowsWritten; }
+
+    QString errorString() const { return mError; }
+
+private:
+    Q_DISABLE_COPY(PngWriter)
+
+    bool writeChunk(const char type[4], const char *data, int length);
+    void setError(const QString &error);
+
+    QIODevice *mDevice;
+    Compressor *mCompressor;
+    QSize mSize;
+    int mRowsWritten;
+    QString mError;
+};
+
+} // namespace Tiled
+
+#endif // TILED_PNGWRITER_H
@@ -28,6 +28,8 @@
 
 #include "properties.h"
 
+#include "memoryusage.h"
+
 using namespace Tiled;
 
 void Properties::merge(const Properties &other)
@@ -40,3 +42,49 @@ void Properties::merge(const Properties &other)
         insert(it.key(), it.value());
     }
 }
+
+/**
+ * Returns the approximate number of bytes used by these properties. Strings
+ * shared through a StringTable are counted for each use.
+ */
+qint64 Properties::memoryUsage() const
+{
+    // Each entry is a map node holding the name and the value
+    qint64 usage = qint64(size()) * sizeof(QMapNode<QString, QString>);
+
+    for (const_iterator it = constBegin(), it_end = constEnd(); it != it_end; ++it)
+        usage += Tiled::memoryUsage(it.key()) + Tiled::memoryUsage(it.value());
+
+    return usage;
+}
+
+/**
+ * Returns a string equal to \a string, sharing its data with the strings
+ * previously returned for equal strings.
+ */
+QString StringTable::intern(const QString &string)
+{
+    const uint hash = qHash(string);
+    for (auto it = mStrings.constFind(hash); it != mStrings.constEnd() && it.key() == hash; ++it)
+        if (*it == string)
+            return *it;
+
+    mStrings.insert(hash, string);
+    return string;
+}
+
+/**
+ * Returns a string equal to the referenced \a string. Only allocates a new
+ * string when no equal string was interned before.
+ */
+QString StringTable::intern(const QStringRef &string)
+{
+    const uint hash = qHash(string);
+    for (auto it = mStrings.constFind(hash); it != mStrings.constEnd() && it.key() == hash; ++it)
+        if (*it == string)
+            return *it;
+
+    const QString copy = string.toString();
+    mStrings.insert(hash, copy);
+    return copy;
+}
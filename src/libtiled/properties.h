@@ -32,7 +32,9 @@
 #include "tiled_global.h"
 
 #include <QMap>
+#include <QMultiHash>
 #include <QString>
+#include <QStringRef>
 
 namespace Tiled {
 
@@ -40,6 +42,28 @@ class TILEDSHARED_EXPORT Properties : public QMap<QString,QString>
 {
 public:
     void merge(const Properties &other);
+
+    qint64 memoryUsage() const;
+};
+
+/**
+ * Makes equal strings share their data. The readers use this for property
+ * names and values as well as object names and types, since these tend to
+ * be repeated for many objects.
+ *
+ * Strings can also be interned from references into a parser's buffer, in
+ * which case a string is only allocated the first time it is encountered.
+ */
+class TILEDSHARED_EXPORT StringTable
+{
+public:
+    QString intern(const QString &string);
+    QString intern(const QStringRef &string);
+
+    void clear() { mStrings.clear(); }
+
+private:
+    QMultiHash<uint, QString> mStrings;     // indexed by qHash of the string
 };
 
 } // namespace Tiled
@@ -62,17 +62,34 @@ QPointF StaggeredRenderer::screenToTileCoords(qreal x, qreal y) const
     if (p.staggerEven)
         ++staggerAxisIndex;
 
-    const qreal y_pos = rel.x() * ((qreal) p.tileHeight / p.tileWidth);
-
     // Check whether the cursor is in any of the corners (neighboring tiles)
-    if (p.sideOffsetY - y_pos > rel.y())
-        return topLeft(referencePoint.x(), referencePoint.y());
-    if (-p.sideOffsetY + y_pos > rel.y())
-        return topRight(referencePoint.x(), referencePoint.y());
-    if (p.sideOffsetY + y_pos < rel.y())
-        return bottomLeft(referencePoint.x(), referencePoint.y());
-    if (p.sideOffsetY * 3 - y_pos < rel.y())
-        return bottomRight(referencePoint.x(), referencePoint.y());
+    switch (pickTile(p, rel.x(), rel.y(), pickCorner)) {
+    case 1: return topLeft(referencePoint.x(), referencePoint.y());
+    case 2: return topRight(referencePoint.x(), referencePoint.y());
+    case 3: return bottomLeft(referencePoint.x(), referencePoint.y());
+    case 4: return bottomRight(referencePoint.x(), referencePoint.y());
+    }
 
     return referencePoint;
 }
+
+/**
+ * Returns 0 when \a x, \a y is on the grid-aligned tile itself, or 1 to 4
+ * when it is on its top-left, top-right, bottom-left or bottom-right
+ * neighbor respectively.
+ */
+int StaggeredRenderer::pickCorner(const RenderParams &p, qreal x, qreal y)
+{
+    const qreal y_pos = x * ((qreal) p.tileHeight / p.tileWidth);
+
+    if (p.sideOffsetY - y_pos > y)
+        return 1;
+    if (-p.sideOffsetY + y_pos > y)
+        return 2;
+    if (p.sideOffsetY + y_pos < y)
+        return 3;
+    if (p.sideOffsetY * 3 - y_pos < y)
+        return 4;
+
+    return 0;
+}
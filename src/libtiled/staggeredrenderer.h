@@ -80,6 +80,9 @@ public:
 
     using HexagonalRenderer::screenToTileCoords;
     QPointF screenToTileCoords(qreal x, qreal y) const override;
+
+private:
+    static int pickCorner(const RenderParams &p, qreal x, qreal y);
 };
 
 } // namespace Tiled
@@ -28,6 +28,7 @@
 
 #include "tile.h"
 
+#include "memoryusage.h"
 #include "objectgroup.h"
 #include "tileset.h"
 
@@ -40,6 +41,7 @@ Tile::Tile(const QPixmap &image,
     mId(id),
     mTileset(tileset),
     mImage(image),
+    mAlphaMaskScale(0),
     mTerrain(-1),
     mProbability(1.f),
     mObjectGroup(nullptr),
@@ -55,6 +57,7 @@ Tile::Tile(const QPixmap &image,
     mId(id),
     mTileset(tileset),
     mImage(image),
+    mAlphaMaskScale(0),
     mImageSource(imageSource),
     mTerrain(-1),
     mProbability(1.f),
@@ -68,6 +71,25 @@ Tile::~Tile()
     delete mObjectGroup;
 }
 
+/**
+ * Sets the image of this tile.
+ */
+void Tile::setImage(const QPixmap &image)
+{
+    mImage = image;
+    mImageRect = QRect();
+
+    for (QPixmap &flippedImage : mFlippedImages)
+        flippedImage = QPixmap();
+
+    mAverageColor = QColor();
+    mAlphaMask = QBitArray();
+    mAlphaMaskSize = QSize();
+    mAlphaMaskScale = 0;
+
+    mTileset->tileImageChanged(this);
+}
+
 /**
  * Returns the tileset that this tile is part of as a shared pointer.
  */
@@ -76,6 +98,21 @@ QSharedPointer<Tileset> Tile::sharedTileset() const
     return mTileset->sharedPointer();
 }
 
+/**
+ * Returns the image of this tile.
+ *
+ * Tiles taken from a tileset image only reference an area of that image.
+ * For these tiles, the standalone image is created when it is first needed.
+ * Renderers should prefer drawing the imageRect() of Tileset::image().
+ */
+const QPixmap &Tile::image() const
+{
+    if (mImage.isNull() && !mImageRect.isNull())
+        mImage = mTileset->image().copy(mImageRect);
+
+    return mImage;
+}
+
 /**
  * Returns the image for rendering this tile, taking into account tile
  * animations.
@@ -86,8 +123,142 @@ const QPixmap &Tile::currentFrameImage() const
         const Frame &frame = mFrames.at(mCurrentFrameIndex);
         return mTileset->tileAt(frame.tileId)->image();
     } else {
-        return mImage;
+        return image();
+    }
+}
+
+/**
+ * Returns the tile that is currently displayed for this tile, taking into
+ * account tile animations.
+ */
+const Tile *Tile::currentFrameTile() const
+{
+    if (isAnimated()) {
+        const Frame &frame = mFrames.at(mCurrentFrameIndex);
+        return mTileset->tileAt(frame.tileId);
+    } else {
+        return this;
+    }
+}
+
+/**
+ * Returns the image of this tile mirrored in the given directions. The
+ * mirrored images are created when they are first needed.
+ *
+ * This allows drawing flipped tiles without a mirroring transformation,
+ * which is not supported by all paint engines when drawing many pixmaps at
+ * once.
+ */
+const QPixmap &Tile::flippedImage(bool horizontally, bool vertically) const
+{
+    const QPixmap &image = this->image();
+    if (!horizontally && !vertically)
+        return image;
+
+    QPixmap &flippedImage = mFlippedImages[(horizontally ? 1 : 0) + (vertically ? 2 : 0) - 1];
+    if (flippedImage.isNull() && !image.isNull())
+        flippedImage = QPixmap::fromImage(image.toImage().mirrored(horizontally, vertically));
+
+    return flippedImage;
+}
+
+/**
+ * Returns the average color of the image of this tile, including its
+ * average opacity. It is computed when first needed.
+ *
+ * Used to draw tiles when they are displayed too small to see any detail.
+ */
+QColor Tile::averageColor() const
+{
+    if (mAverageColor.isValid())
+        return mAverageColor;
+
+    // Avoid creating the standalone image of tiles from the tileset image
+    const QPixmap source = (mImage.isNull() && !mImageRect.isNull())
+            ? mTileset->image().copy(mImageRect)
+            : mImage;
+
+    // The tileset image may still be loading
+    if (source.isNull() && !mImageRect.isNull())
+        return QColor(0, 0, 0, 0);
+
+    const QImage image = source.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const qint64 pixelCount = qint64(image.width()) * image.height();
+
+    qint64 red = 0, green = 0, blue = 0, alpha = 0;
+
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            red += qRed(line[x]);
+            green += qGreen(line[x]);
+            blue += qBlue(line[x]);
+            alpha += qAlpha(line[x]);
+        }
+    }
+
+    if (alpha == 0) {
+        mAverageColor = QColor(0, 0, 0, 0);
+    } else {
+        // Undo the premultiplication of the averaged color
+        mAverageColor = QColor(int(red * 255 / alpha),
+                               int(green * 255 / alpha),
+                               int(blue * 255 / alpha),
+                               int(alpha / pixelCount));
+    }
+
+    return mAverageColor;
+}
+
+/**
+ * Returns whether the image of this tile is not fully transparent at the
+ * given \a pos, in pixels of the image.
+ *
+ * Used for picking tile objects. The test uses a mask that is built when
+ * first needed. For large images, each bit of the mask covers a square
+ * block of pixels, which counts as opaque when any of its pixels is.
+ */
+bool Tile::isOpaqueAt(const QPointF &pos) const
+{
+    // The largest width and height of the mask, in blocks
+    static const int maxMaskSize = 64;
+
+    if (mAlphaMaskScale == 0) {
+        const QPixmap source = (mImage.isNull() && !mImageRect.isNull())
+                ? mTileset->image().copy(mImageRect)
+                : mImage;
+
+        // Without an image, which may still be loading, the whole tile counts
+        if (source.isNull())
+            return true;
+
+        const QImage image = source.toImage().convertToFormat(QImage::Format_ARGB32);
+        const int scale = qMax(1, (qMax(image.width(), image.height()) + maxMaskSize - 1) / maxMaskSize);
+        const QSize maskSize((image.width() + scale - 1) / scale,
+                             (image.height() + scale - 1) / scale);
+
+        QBitArray mask(maskSize.width() * maskSize.height());
+
+        for (int y = 0; y < image.height(); ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+            const int maskRow = (y / scale) * maskSize.width();
+            for (int x = 0; x < image.width(); ++x)
+                if (qAlpha(line[x]) > 0)
+                    mask.setBit(maskRow + x / scale);
+        }
+
+        mAlphaMask = mask;
+        mAlphaMaskSize = maskSize;
+        mAlphaMaskScale = scale;
     }
+
+    const int x = int(pos.x()) / mAlphaMaskScale;
+    const int y = int(pos.y()) / mAlphaMaskScale;
+
+    if (pos.x() < 0 || pos.y() < 0 || x >= mAlphaMaskSize.width() || y >= mAlphaMaskSize.height())
+        return false;
+
+    return mAlphaMask.testBit(y * mAlphaMaskSize.width() + x);
 }
 
 /**
@@ -114,8 +285,19 @@ void Tile::setTerrain(unsigned terrain)
     if (mTerrain == terrain)
         return;
 
+    const unsigned oldTerrain = mTerrain;
     mTerrain = terrain;
-    mTileset->markTerrainDistancesDirty();
+    mTileset->tileTerrainChanged(oldTerrain, terrain);
+    mTileset->tileMetadataChanged(this);
+}
+
+/**
+ * Set the relative probability of this tile appearing while painting.
+ */
+void Tile::setProbability(float probability)
+{
+    mProbability = probability;
+    mTileset->tileMetadataChanged(this);
 }
 
 /**
@@ -132,6 +314,7 @@ void Tile::setObjectGroup(ObjectGroup *objectGroup)
 
     delete mObjectGroup;
     mObjectGroup = objectGroup;
+    mTileset->tileMetadataChanged(this);
 }
 
 /**
@@ -145,6 +328,7 @@ ObjectGroup *Tile::swapObjectGroup(ObjectGroup *objectGroup)
 {
     ObjectGroup *previousObjectGroup = mObjectGroup;
     mObjectGroup = objectGroup;
+    mTileset->tileMetadataChanged(this);
     return previousObjectGroup;
 }
 
@@ -157,6 +341,9 @@ void Tile::setFrames(const QVector<Frame> &frames)
     mFrames = frames;
     mCurrentFrameIndex = 0;
     mUnusedTime = 0;
+
+    mTileset->tileAnimationChanged(this);
+    mTileset->tileMetadataChanged(this);
 }
 
 /**
@@ -182,3 +369,46 @@ bool Tile::advanceAnimation(int ms)
 
     return previousTileId != frame.tileId;
 }
+
+/**
+ * Returns whether this tile has any properties, terrain, probability,
+ * collision objects or animation that need to be saved. The image of the
+ * tile is not considered.
+ */
+bool Tile::hasMetadata() const
+{
+    return !properties().isEmpty() ||
+            mTerrain != 0xFFFFFFFF ||
+            mProbability != 1.f ||
+            mObjectGroup ||
+            isAnimated();
+}
+
+void Tile::propertiesChanged()
+{
+    mTileset->tileMetadataChanged(this);
+}
+
+/**
+ * Returns the approximate number of bytes used by this tile, including its
+ * own images, properties and collision objects. For tiles taken from a
+ * tileset image, only the images created from that image are counted.
+ */
+qint64 Tile::memoryUsage() const
+{
+    qint64 usage = sizeof(Tile) +
+            Tiled::memoryUsage(mImage) +
+            Tiled::memoryUsage(mImageSource) +
+            qint64(mFrames.capacity()) * sizeof(Frame) +
+            properties().memoryUsage();
+
+    for (const QPixmap &flippedImage : mFlippedImages)
+        usage += Tiled::memoryUsage(flippedImage);
+
+    usage += mAlphaMask.size() / 8;
+
+    if (mObjectGroup)
+        usage += mObjectGroup->memoryUsage();
+
+    return usage;
+}
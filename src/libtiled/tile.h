@@ -32,7 +32,10 @@
 
 #include "object.h"
 
+#include <QBitArray>
+#include <QColor>
 #include <QPixmap>
+#include <QRect>
 #include <QSharedPointer>
 
 namespace Tiled {
@@ -83,6 +86,14 @@ public:
     void setImage(const QPixmap &image);
 
     const QPixmap &currentFrameImage() const;
+    const Tile *currentFrameTile() const;
+
+    const QRect &imageRect() const;
+    const QRect &atlasRect() const;
+
+    const QPixmap &flippedImage(bool horizontally, bool vertically) const;
+    QColor averageColor() const;
+    bool isOpaqueAt(const QPointF &pos) const;
 
     const QString &imageSource() const;
     void setImageSource(const QString &imageSource);
@@ -114,10 +125,24 @@ public:
     int currentFrameIndex() const;
     bool advanceAnimation(int ms);
 
+    bool hasMetadata() const;
+
+    qint64 memoryUsage() const;
+
+protected:
+    void propertiesChanged() override;
+
 private:
     int mId;
     Tileset *mTileset;
-    QPixmap mImage;
+    mutable QPixmap mImage;
+    QRect mImageRect;
+    QRect mAtlasRect;
+    mutable QPixmap mFlippedImages[3];
+    mutable QColor mAverageColor;
+    mutable QBitArray mAlphaMask;
+    mutable QSize mAlphaMaskSize;
+    mutable int mAlphaMaskScale;
     QString mImageSource;
     unsigned mTerrain;
     float mProbability;
@@ -128,6 +153,7 @@ private:
     int mUnusedTime;
 
     friend class Tileset; // To allow changing the tile id
+    friend class TileAtlas;
 };
 
 /**
@@ -147,19 +173,27 @@ inline Tileset *Tile::tileset() const
 }
 
 /**
- * Returns the image of this tile.
+ * Returns the area of the tileset image that this tile was taken from, or a
+ * null rectangle when the image of this tile doesn't come from the tileset
+ * image.
+ *
+ * \sa Tileset::image()
  */
-inline const QPixmap &Tile::image() const
+inline const QRect &Tile::imageRect() const
 {
-    return mImage;
+    return mImageRect;
 }
 
 /**
- * Sets the image of this tile.
+ * Returns the area of the atlas of its image collection tileset that this
+ * tile is drawn from, or a null rectangle when the tile is drawn on its own.
+ * Only valid after calling Tileset::atlasImage().
+ *
+ * \sa TileAtlas
  */
-inline void Tile::setImage(const QPixmap &image)
+inline const QRect &Tile::atlasRect() const
 {
-    mImage = image;
+    return mAtlasRect;
 }
 
 /**
@@ -182,7 +216,7 @@ inline void Tile::setImageSource(const QString &imageSource)
  */
 inline int Tile::width() const
 {
-    return mImage.width();
+    return size().width();
 }
 
 /**
@@ -190,7 +224,7 @@ inline int Tile::width() const
  */
 inline int Tile::height() const
 {
-    return mImage.height();
+    return size().height();
 }
 
 /**
@@ -198,7 +232,7 @@ inline int Tile::height() const
  */
 inline QSize Tile::size() const
 {
-    return mImage.size();
+    return mImageRect.isNull() ? mImage.size() : mImageRect.size();
 }
 
 /**
@@ -233,14 +267,6 @@ inline float Tile::probability() const
     return mProbability;
 }
 
-/**
- * Set the relative probability of this tile appearing while painting.
- */
-inline void Tile::setProbability(float probability)
-{
-    mProbability = probability;
-}
-
 /**
  * @return The group of objects associated with this tile. This is generally
  *         expected to be used for editing collision shapes.
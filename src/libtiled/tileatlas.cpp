@@ -0,0 +1,250 @@
+/*
+ * tileatlas.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tileatlas.h"
+
+#include "memoryusage.h"
+#include "tile.h"
+#include "tileset.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Tiled;
+
+// Within the texture size supported by any OpenGL implementation
+static const int MaxAtlasSize = 2048;
+
+// Larger tiles are few, so drawing them on their own doesn't cost much
+static const int MaxPackedTileSize = 512;
+
+static int nextPowerOfTwo(int value)
+{
+    int power = 1;
+    while (power < value)
+        power <<= 1;
+    return power;
+}
+
+static bool isPackable(const Tile *tile)
+{
+    if (!tile->imageRect().isNull())
+        return false;
+
+    const QSize size = tile->image().size();
+    return !size.isEmpty() &&
+            size.width() <= MaxPackedTileSize &&
+            size.height() <= MaxPackedTileSize;
+}
+
+static qint64 area(const QSize &size)
+{
+    return qint64(size.width()) * size.height();
+}
+
+
+TileAtlas::TileAtlas()
+    : mShelfHeight(0)
+    , mUsedArea(0)
+    , mUnusedArea(0)
+    , mPacked(false)
+{
+}
+
+void TileAtlas::tileChanged(Tile *tile)
+{
+    if (mPacked && !mChangedTiles.contains(tile))
+        mChangedTiles.insert(tile, tile->mAtlasRect);
+
+    tile->mAtlasRect = QRect();
+}
+
+void TileAtlas::tileRemoved(Tile *tile)
+{
+    const QRect previous = mChangedTiles.take(tile);
+    if (!previous.isNull())
+        mUnusedArea += area(previous.size());
+
+    if (!tile->mAtlasRect.isNull()) {
+        mUnusedArea += area(tile->mAtlasRect.size());
+        tile->mAtlasRect = QRect();
+    }
+}
+
+const QPixmap &TileAtlas::image(const QList<Tile*> &tiles)
+{
+    if (!canCreatePixmaps())
+        return mImage;
+
+    if (!mPacked) {
+        repack(tiles);
+        return mImage;
+    }
+
+    if (mChangedTiles.isEmpty())
+        return mImage;
+
+    QVector<Tile*> changedTiles;
+
+    for (auto it = mChangedTiles.constBegin(); it != mChangedTiles.constEnd(); ++it) {
+        Tile *tile = it.key();
+        const QRect &previous = it.value();
+
+        if (!isPackable(tile)) {
+            if (!previous.isNull())
+                mUnusedArea += area(previous.size());
+            continue;
+        }
+
+        // An image of the same size is drawn in place
+        if (!previous.isNull()) {
+            if (previous.size() == tile->size()) {
+                tile->mAtlasRect = previous;
+                changedTiles.append(tile);
+                continue;
+            }
+            mUnusedArea += area(previous.size());
+        }
+
+        if (!place(tile)) {
+            repack(tiles);
+            return mImage;
+        }
+
+        changedTiles.append(tile);
+    }
+
+    mChangedTiles.clear();
+
+    if (mUnusedArea > mUsedArea / 2) {
+        repack(tiles);
+        return mImage;
+    }
+
+    QPainter painter(&mImage);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (const Tile *tile : changedTiles) {
+        painter.fillRect(tile->mAtlasRect, Qt::transparent);
+        painter.drawPixmap(tile->mAtlasRect.topLeft(), tile->image());
+    }
+
+    return mImage;
+}
+
+qint64 TileAtlas::memoryUsage() const
+{
+    return Tiled::memoryUsage(mImage);
+}
+
+/**
+ * Places the \a tile on the current shelf, or on a new shelf when it is
+ * full. Returns false when the atlas has no room left for it.
+ */
+bool TileAtlas::place(Tile *tile)
+{
+    const QSize size = tile->size();
+
+    if (mShelf.x() + size.width() > mSize.width()) {
+        mShelf = QPoint(0, mShelf.y() + mShelfHeight);
+        mShelfHeight = 0;
+    }
+
+    if (size.width() > mSize.width() || mShelf.y() + size.height() > mSize.height())
+        return false;
+
+    tile->mAtlasRect = QRect(mShelf, size);
+    mShelf.rx() += size.width();
+    mShelfHeight = qMax(mShelfHeight, size.height());
+    mUsedArea += area(size);
+    return true;
+}
+
+/**
+ * Packs all \a tiles into a new atlas image. The tallest tiles are placed
+ * first, which leaves less space unused on the shelves.
+ */
+void TileAtlas::repack(const QList<Tile*> &tiles)
+{
+    mChangedTiles.clear();
+    mShelf = QPoint();
+    mShelfHeight = 0;
+    mUsedArea = 0;
+    mUnusedArea = 0;
+    mPacked = true;
+
+    QVector<Tile*> packedTiles;
+    qint64 totalArea = 0;
+    int maxWidth = 0;
+
+    for (Tile *tile : tiles) {
+        tile->mAtlasRect = QRect();
+        if (!isPackable(tile))
+            continue;
+
+        packedTiles.append(tile);
+        totalArea += area(tile->size());
+        maxWidth = qMax(maxWidth, tile->width());
+    }
+
+    if (packedTiles.isEmpty()) {
+        mImage = QPixmap();
+        mSize = QSize();
+        return;
+    }
+
+    std::stable_sort(packedTiles.begin(), packedTiles.end(),
+                     [] (const Tile *a, const Tile *b) { return a->height() > b->height(); });
+
+    // Leaves room for adding about a quarter more tiles without repacking
+    const int width = qMin(MaxAtlasSize,
+                           qMax(nextPowerOfTwo(maxWidth),
+                                nextPowerOfTwo(int(std::sqrt(totalArea * 1.25)))));
+
+    mSize = QSize(width, MaxAtlasSize);
+    for (Tile *tile : packedTiles)
+        place(tile);
+
+    // Tiles that didn't fit are drawn on their own
+    const int usedHeight = mShelf.y() + mShelfHeight;
+    mSize.setHeight(qMin(MaxAtlasSize, nextPowerOfTwo(usedHeight + usedHeight / 4)));
+
+    QImage image(mSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    for (const Tile *tile : packedTiles)
+        if (!tile->mAtlasRect.isNull())
+            painter.drawPixmap(tile->mAtlasRect.topLeft(), tile->image());
+    painter.end();
+
+    mImage = QPixmap::fromImage(image);
+}
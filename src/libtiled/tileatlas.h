@@ -0,0 +1,97 @@
+/*
+ * tileatlas.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_TILEATLAS_H
+#define TILED_TILEATLAS_H
+
+#include <QHash>
+#include <QList>
+#include <QPixmap>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+
+namespace Tiled {
+
+class Tile;
+
+/**
+ * Packs the images of the tiles of an image collection tileset into a
+ * single pixmap, so that the CellRenderer can draw the tiles of the whole
+ * collection in one batch, like it does for tilesets based on an image.
+ *
+ * The atlas is only built when it is first needed for rendering. Tiles that
+ * are added or change their image afterwards are packed incrementally, in
+ * the space left on the last shelf. The tiles are only repacked when they
+ * no longer fit or when too much of the atlas is taken by replaced images.
+ *
+ * Tiles that are too large to be worth packing keep being drawn on their
+ * own, as do tiles whose image comes from a tileset image.
+ */
+class TileAtlas
+{
+public:
+    TileAtlas();
+
+    /**
+     * Marks the given \a tile for being packed again, because it was added
+     * or its image changed.
+     */
+    void tileChanged(Tile *tile);
+
+    /**
+     * Releases the space of a \a tile that was removed from its tileset.
+     */
+    void tileRemoved(Tile *tile);
+
+    /**
+     * Returns the atlas image, after packing the given \a tiles or the tiles
+     * that changed since the last call. Returns the image as it is when no
+     * pixmaps can be created on the current thread.
+     */
+    const QPixmap &image(const QList<Tile*> &tiles);
+
+    qint64 memoryUsage() const;
+
+private:
+    bool place(Tile *tile);
+    void repack(const QList<Tile*> &tiles);
+
+    QPixmap mImage;
+    QSize mSize;
+    QHash<Tile*, QRect> mChangedTiles;  // previous area of the changed tiles
+    QPoint mShelf;                      // position of the next tile
+    int mShelfHeight;
+    qint64 mUsedArea;
+    qint64 mUnusedArea;                 // area of replaced images
+    bool mPacked;
+};
+
+} // namespace Tiled
+
+#endif // TILED_TILEATLAS_H
@@ -29,20 +29,283 @@
 
 #include "tilelayer.h"
 
+#include "compression.h"
 #include "map.h"
 #include "tile.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace Tiled;
 
+const Cell Cell::empty;
+
+/**
+ * Packs the given \a cell into \a word, adding its tileset to the palette of
+ * this chunk when necessary. Returns false when the cell can't be packed.
+ */
+bool Chunk::pack(const Cell &cell, quint32 &word)
+{
+    if (!cell.tile) {
+        word = 0;
+        return !cell.flippedHorizontally &&
+                !cell.flippedVertically &&
+                !cell.flippedAntiDiagonally;
+    }
+
+    // The tile IDs of image collections change when tiles are removed
+    Tileset *tileset = cell.tile->tileset();
+    const int id = cell.tile->id();
+    if (tileset->imageSource().isEmpty() || id < 0 || id > TileIdMask)
+        return false;
+
+    int index = mTilesets.indexOf(tileset);
+    if (index == -1) {
+        if (mTilesets.size() == MaxTilesets)
+            return false;
+
+        index = mTilesets.size();
+        mTilesets.append(tileset);
+    }
+
+    word = quint32(id) | quint32(index + 1) << TilesetShift;
+    if (cell.flippedHorizontally)
+        word |= FlippedHorizontallyBit;
+    if (cell.flippedVertically)
+        word |= FlippedVerticallyBit;
+    if (cell.flippedAntiDiagonally)
+        word |= FlippedAntiDiagonallyBit;
+
+    return true;
+}
+
+/**
+ * Switches this chunk to storing full cells.
+ */
+void Chunk::unpack()
+{
+    Q_ASSERT(isPacked());
+
+    QVector<Cell> cells(CHUNK_SIZE * CHUNK_SIZE);
+    for (int index = 0; index < cells.size(); ++index)
+        cells[index] = cellAt(index);
+
+    mCells.swap(cells);
+    mWords = QVector<quint32>();
+    mTilesets = QVector<Tileset*>();
+}
+
+qint64 Chunk::memoryUsage() const
+{
+    if (isPacked())
+        return mWords.capacity() * qint64(sizeof(quint32)) +
+                mTilesets.capacity() * qint64(sizeof(Tileset*));
+
+    return mCells.capacity() * qint64(sizeof(Cell));
+}
+
+// The largest size of the data returned by Chunk::toByteArray()
+static const int MaxChunkDataSize = int(sizeof(qint32)) +
+        qMax(Chunk::MaxTilesets * int(sizeof(Tileset*)) + CHUNK_SIZE * CHUNK_SIZE * int(sizeof(quint32)),
+             CHUNK_SIZE * CHUNK_SIZE * int(sizeof(Cell)));
+
+/**
+ * Returns the cells of this chunk in the form they are stored in memory,
+ * for compressing them. The data starts with the number of tilesets for
+ * packed chunks, or -1 otherwise.
+ */
+QByteArray Chunk::toByteArray() const
+{
+    QByteArray data;
+
+    const qint32 tilesetCount = isPacked() ? mTilesets.size() : -1;
+    data.append(reinterpret_cast<const char*>(&tilesetCount), sizeof(tilesetCount));
+
+    if (isPacked()) {
+        data.append(reinterpret_cast<const char*>(mTilesets.constData()),
+                    mTilesets.size() * int(sizeof(Tileset*)));
+        data.append(reinterpret_cast<const char*>(mWords.constData()),
+                    mWords.size() * int(sizeof(quint32)));
+    } else {
+        data.append(reinterpret_cast<const char*>(mCells.constData()),
+                    mCells.size() * int(sizeof(Cell)));
+    }
+
+    return data;
+}
+
+/**
+ * Restores the cells of this chunk from \a data returned by toByteArray().
+ * Returns false when the data has the wrong size.
+ */
+bool Chunk::fromByteArray(const QByteArray &data)
+{
+    const int cellCount = CHUNK_SIZE * CHUNK_SIZE;
+
+    qint32 tilesetCount;
+    if (data.size() < int(sizeof(tilesetCount)))
+        return false;
+
+    memcpy(&tilesetCount, data.constData(), sizeof(tilesetCount));
+    const char *cells = data.constData() + sizeof(tilesetCount);
+
+    mCellCount = 0;
+
+    if (tilesetCount < 0) {
+        if (data.size() != int(sizeof(tilesetCount)) + cellCount * int(sizeof(Cell)))
+            return false;
+
+        mWords = QVector<quint32>();
+        mTilesets = QVector<Tileset*>();
+        mCells.resize(cellCount);
+        memcpy(mCells.data(), cells, cellCount * sizeof(Cell));
+
+        for (const Cell &cell : mCells)
+            if (!cell.isEmpty())
+                ++mCellCount;
+    } else {
+        const int tilesetsSize = tilesetCount * int(sizeof(Tileset*));
+        if (tilesetCount > MaxTilesets ||
+                data.size() != int(sizeof(tilesetCount)) + tilesetsSize + cellCount * int(sizeof(quint32)))
+            return false;
+
+        mCells = QVector<Cell>();
+        mTilesets.resize(tilesetCount);
+        memcpy(mTilesets.data(), cells, tilesetsSize);
+        mWords.resize(cellCount);
+        memcpy(mWords.data(), cells + tilesetsSize, cellCount * sizeof(quint32));
+
+        for (quint32 word : mWords)
+            if (word != 0)
+                ++mCellCount;
+    }
+
+    return true;
+}
+
 TileLayer::TileLayer(const QString &name, int x, int y, int width, int height):
     Layer(TileLayerType, name, x, y, width, height),
     mMaxTileSize(0, 0),
-    mGrid(width * height)
+    mBulkEditDepth(0),
+    mDrawMarginsChanged(false),
+    mLastTile(nullptr),
+    mLastFlippedAntiDiagonally(false),
+    mGeneration(0),
+    mStructureGeneration(0),
+    mHasLastChangedChunk(false),
+    mCompressed(false),
+    mCompressedSize(0),
+    mTileIndexValid(false)
 {
     Q_ASSERT(width >= 0);
     Q_ASSERT(height >= 0);
 }
 
+/**
+ * Calls the cell loader. The loader is released first, so that it can set
+ * the cells of this layer without being called again.
+ */
+void TileLayer::loadCells() const
+{
+    CellLoader loader;
+    loader.swap(mCellLoader);
+    loader(*const_cast<TileLayer*>(this));
+}
+
+/**
+ * Returns the compression method used for keeping chunks in memory. LZ4 is
+ * fast enough that decompressing a layer is hardly noticed.
+ */
+static CompressionMethod chunkCompressionMethod()
+{
+    return compressionSupported(Lz4) ? Lz4 : Zlib;
+}
+
+TileLayer::CompressedChunks TileLayer::compressChunks(const ChunkHash &chunks)
+{
+    const CompressionMethod method = chunkCompressionMethod();
+
+    CompressedChunks compressed;
+    compressed.reserve(chunks.size());
+
+    for (auto it = chunks.constBegin(), it_end = chunks.constEnd(); it != it_end; ++it) {
+        const QByteArray cells = it.value().toByteArray();
+
+        const QByteArray data = compress(cells, method);
+        if (data.isNull())
+            return CompressedChunks();
+
+        compressed.insert(it.key(), data);
+    }
+
+    return compressed;
+}
+
+bool TileLayer::setCompressedChunks(const CompressedChunks &compressed,
+                                    unsigned generation)
+{
+    if (!isLoaded() || mBulkEditDepth > 0 || mGeneration != generation)
+        return false;
+    if (compressed.size() != mChunks.size())
+        return false;
+
+    qint64 size = 0;
+    for (const QByteArray &data : compressed)
+        size += data.size();
+
+    mChunks.clear();
+    mTileIndex.clear();
+    mTileIndexValid = false;
+    mCompressed = true;
+    mCompressedSize = size;
+
+    // Clones share the compressed data, since it is never modified
+    setCellLoader([compressed] (TileLayer &tileLayer) {
+        tileLayer.decompressChunks(compressed);
+    });
+
+    return true;
+}
+
+/**
+ * Restores the chunks from their \a compressed form. The tileset use counts
+ * and the draw margins were kept while the cells were compressed.
+ *
+ * When any of the chunks fails to decompress, which can only happen when
+ * memory is short, no chunk is restored and the layer keeps its compressed
+ * cells. Decompressing is tried again when the cells are next accessed.
+ */
+void TileLayer::decompressChunks(const CompressedChunks &compressed)
+{
+    const CompressionMethod method = chunkCompressionMethod();
+
+    ChunkHash chunks;
+    chunks.reserve(compressed.size());
+
+    for (auto it = compressed.constBegin(), it_end = compressed.constEnd(); it != it_end; ++it) {
+        const QByteArray data = decompress(it.value(), MaxChunkDataSize, method);
+
+        Chunk chunk;
+        if (!chunk.fromByteArray(data)) {
+            Q_ASSERT_X(data.isNull(), "TileLayer::decompressChunks",
+                       "decompressed chunk has the wrong size");
+            qWarning("Failed to decompress the cells of layer '%s'",
+                     qPrintable(name()));
+
+            setCellLoader([compressed] (TileLayer &tileLayer) {
+                tileLayer.decompressChunks(compressed);
+            });
+            return;
+        }
+
+        chunks.insert(it.key(), chunk);
+    }
+
+    mChunks.swap(chunks);
+    mCompressed = false;
+    mCompressedSize = 0;
+}
+
 static QSize maxSize(const QSize &a,
                      const QSize &b)
 {
@@ -67,10 +330,19 @@ static QMargins maxMargins(const QMargins &a,
  */
 void TileLayer::recomputeDrawMargins()
 {
+    // The margins of compressed cells need to be computed from the cells
+    if (mCompressed)
+        load();
+
+    // The margins are computed while loading the cells
+    if (!isLoaded())
+        return;
+
     QSize maxTileSize(0, 0);
     QMargins offsetMargins;
 
-    for (Cell &cell : mGrid) {
+    for (auto it = constBegin(), it_end = constEnd(); it != it_end; ++it) {
+        const Cell &cell = *it;
         if (const Tile *tile = cell.tile) {
             QSize size = tile->size();
 
@@ -95,11 +367,72 @@ void TileLayer::recomputeDrawMargins()
         mMap->adjustDrawMargins(drawMargins());
 }
 
+bool TileLayer::isInfinite() const
+{
+    return mMap && mMap->infinite();
+}
+
+QRect TileLayer::cellArea() const
+{
+    if (isInfinite()) {
+        // Leaves room for computing with the coordinates
+        const int limit = 1 << 24;
+        return QRect(-limit, -limit, 2 * limit, 2 * limit);
+    }
+
+    return QRect(0, 0, mWidth, mHeight);
+}
+
+QRect TileLayer::cellBounds() const
+{
+    QRect bounds(0, 0, mWidth, mHeight);
+    if (!isInfinite())
+        return bounds;
+
+    load();
+
+    for (auto it = mChunks.constBegin(), it_end = mChunks.constEnd(); it != it_end; ++it)
+        bounds |= QRect(it.key() * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE));
+
+    return bounds;
+}
+
+QVector<QRect> TileLayer::chunkRects() const
+{
+    load();
+
+    QVector<QPoint> positions;
+    positions.reserve(mChunks.size());
+
+    for (auto it = mChunks.constBegin(), it_end = mChunks.constEnd(); it != it_end; ++it)
+        if (!it.value().isEmpty())
+            positions.append(it.key());
+
+    std::sort(positions.begin(), positions.end(), [] (const QPoint &a, const QPoint &b) {
+        return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+    });
+
+    QVector<QRect> rects;
+    rects.reserve(positions.size());
+    for (const QPoint &pos : positions)
+        rects.append(QRect(pos * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE)));
+
+    return rects;
+}
+
 void TileLayer::setCell(int x, int y, const Cell &cell)
 {
-    Q_ASSERT(contains(x, y));
+    Q_ASSERT(contains(x, y) || isInfinite());
+
+    load();
+
+    // During a bulk edit, a tile only needs to be looked at once in a row
+    if (cell.tile && (mBulkEditDepth == 0 ||
+                      cell.tile != mLastTile ||
+                      cell.flippedAntiDiagonally != mLastFlippedAntiDiagonally)) {
+        mLastTile = cell.tile;
+        mLastFlippedAntiDiagonally = cell.flippedAntiDiagonally;
 
-    if (cell.tile) {
         QSize size = cell.tile->size();
 
         if (cell.flippedAntiDiagonally)
@@ -107,23 +440,384 @@ void TileLayer::setCell(int x, int y, const Cell &cell)
 
         const QPoint offset = cell.tile->offset();
 
-        mMaxTileSize = maxSize(size, mMaxTileSize);
-        mOffsetMargins = maxMargins(QMargins(-offset.x(),
-                                             -offset.y(),
-                                             offset.x(),
-                                             offset.y()),
-                                    mOffsetMargins);
+        const QSize maxTileSize = maxSize(size, mMaxTileSize);
+        const QMargins offsetMargins = maxMargins(QMargins(-offset.x(),
+                                                           -offset.y(),
+                                                           offset.x(),
+                                                           offset.y()),
+                                                  mOffsetMargins);
+
+        if (maxTileSize != mMaxTileSize || offsetMargins != mOffsetMargins) {
+            mMaxTileSize = maxTileSize;
+            mOffsetMargins = offsetMargins;
+
+            if (mBulkEditDepth > 0)
+                mDrawMarginsChanged = true;
+            else if (mMap)
+                mMap->adjustDrawMargins(drawMargins());
+        }
+    }
+
+    const QPoint chunkPos(x >> CHUNK_BITS, y >> CHUNK_BITS);
 
-        if (mMap)
-            mMap->adjustDrawMargins(drawMargins());
+    if (cell.isEmpty()) {
+        auto it = mChunks.find(chunkPos);
+        if (it != mChunks.end()) {
+            Chunk &chunk = it.value();
+            const Cell &oldCell = chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+            if (oldCell == cell)
+                return;
+
+            markChunkChanged(chunkPos);
+            updateTilesetUseCounts(oldCell, cell);
+            updateTileIndex(chunkPos, oldCell, cell);
+            chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
+
+            // See setCell(ChunkHash&, ...)
+            if (chunk.isEmpty())
+                mChunks.erase(it);
+        }
+    } else {
+        Chunk &chunk = mChunks[chunkPos];
+        const Cell &oldCell = chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+        if (oldCell == cell)
+            return;
+
+        markChunkChanged(chunkPos);
+        updateTilesetUseCounts(oldCell, cell);
+        updateTileIndex(chunkPos, oldCell, cell);
+        chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
+    }
+}
+
+/**
+ * Records that the chunk at \a chunkPos changed. Outside of a bulk edit
+ * each change starts a new generation, while within a bulk edit all changes
+ * share the generation started by beginBulkEdit().
+ */
+inline void TileLayer::markChunkChanged(const QPoint &chunkPos)
+{
+    if (mBulkEditDepth == 0) {
+        ++mGeneration;
+    } else if (mHasLastChangedChunk && mLastChangedChunk == chunkPos) {
+        return;
+    } else {
+        mLastChangedChunk = chunkPos;
+        mHasLastChangedChunk = true;
+    }
+
+    mChunkGenerations.insert(chunkPos, mGeneration);
+}
+
+/**
+ * Records that the whole layer changed. The generations of the individual
+ * chunks are no longer needed after this, and the tile index is rebuilt
+ * when it is needed again.
+ */
+void TileLayer::markAllChanged()
+{
+    if (mBulkEditDepth == 0)
+        ++mGeneration;
+
+    mStructureGeneration = mGeneration;
+    mChunkGenerations.clear();
+    mHasLastChangedChunk = false;
+
+    mTileIndex.clear();
+    mTileIndexValid = false;
+}
+
+TileMask TileLayer::changesSince(unsigned generation) const
+{
+    load();
+
+    TileMask mask;
+    const QRect layerRect = cellArea();
+
+    if (mStructureGeneration > generation) {
+        mask.addRect(cellBounds().translated(mX, mY));
+        return mask;
+    }
+
+    for (auto it = mChunkGenerations.constBegin(), it_end = mChunkGenerations.constEnd(); it != it_end; ++it) {
+        if (it.value() <= generation)
+            continue;
+
+        const QRect chunkRect(it.key() * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE));
+        mask.addRect((chunkRect & layerRect).translated(mX, mY));
+    }
+
+    return mask;
+}
+
+/**
+ * Updates the number of cells using each tileset for replacing \a oldCell
+ * with \a newCell.
+ */
+inline void TileLayer::updateTilesetUseCounts(const Cell &oldCell,
+                                              const Cell &newCell)
+{
+    Tileset *oldTileset = oldCell.tile ? oldCell.tile->tileset() : nullptr;
+    Tileset *newTileset = newCell.tile ? newCell.tile->tileset() : nullptr;
+
+    if (oldTileset == newTileset)
+        return;
+
+    if (oldTileset) {
+        auto it = mTilesetUseCounts.find(oldTileset);
+        Q_ASSERT(it != mTilesetUseCounts.end());
+        if (--it.value() == 0)
+            mTilesetUseCounts.erase(it);
+    }
+
+    if (newTileset)
+        ++mTilesetUseCounts[newTileset];
+}
+
+/**
+ * Counts the cells using each tileset again. Used after operations that
+ * drop cells in bulk.
+ */
+void TileLayer::recomputeTilesetUseCounts()
+{
+    mTilesetUseCounts.clear();
+
+    for (auto it = mChunks.constBegin(), it_end = mChunks.constEnd(); it != it_end; ++it) {
+        Tileset *lastTileset = nullptr;
+        int count = 0;
+
+        for (const Cell &cell : it.value()) {
+            if (!cell.tile)
+                continue;
+
+            Tileset *tileset = cell.tile->tileset();
+            if (tileset != lastTileset) {
+                if (lastTileset)
+                    mTilesetUseCounts[lastTileset] += count;
+                lastTileset = tileset;
+                count = 0;
+            }
+            ++count;
+        }
+
+        if (lastTileset)
+            mTilesetUseCounts[lastTileset] += count;
+    }
+}
+
+/**
+ * Counts the cells using each tile in each chunk.
+ */
+void TileLayer::buildTileIndex() const
+{
+    mTileIndex.clear();
+
+    for (auto it = mChunks.constBegin(), it_end = mChunks.constEnd(); it != it_end; ++it) {
+        const Tile *lastTile = nullptr;
+        int count = 0;
+
+        for (const Cell &cell : it.value()) {
+            if (cell.tile != lastTile) {
+                if (lastTile)
+                    mTileIndex[lastTile][it.key()] += count;
+                lastTile = cell.tile;
+                count = 0;
+            }
+            ++count;
+        }
+
+        if (lastTile)
+            mTileIndex[lastTile][it.key()] += count;
+    }
+
+    mTileIndexValid = true;
+}
+
+/**
+ * Updates the tile index for replacing \a oldCell with \a newCell in the
+ * chunk at \a chunkPos, when the index is in use.
+ */
+inline void TileLayer::updateTileIndex(const QPoint &chunkPos,
+                                       const Cell &oldCell,
+                                       const Cell &newCell)
+{
+    if (!mTileIndexValid || oldCell.tile == newCell.tile)
+        return;
+
+    if (oldCell.tile) {
+        auto it = mTileIndex.find(oldCell.tile);
+        Q_ASSERT(it != mTileIndex.end());
+
+        auto chunkIt = it.value().find(chunkPos);
+        Q_ASSERT(chunkIt != it.value().end());
+
+        if (--chunkIt.value() == 0) {
+            it.value().erase(chunkIt);
+            if (it.value().isEmpty())
+                mTileIndex.erase(it);
+        }
+    }
+
+    if (newCell.tile)
+        ++mTileIndex[newCell.tile][chunkPos];
+}
+
+QList<QPoint> TileLayer::chunksWithTile(const Tile *tile) const
+{
+    load();
+
+    if (!mTileIndexValid)
+        buildTileIndex();
+
+    return mTileIndex.value(tile).keys();
+}
+
+/**
+ * Returns the positions of the chunks that contain tiles from the given
+ * \a tileset.
+ */
+QSet<QPoint> TileLayer::chunksWithTileset(const Tileset *tileset) const
+{
+    if (!mTileIndexValid)
+        buildTileIndex();
+
+    QSet<QPoint> chunks;
+
+    for (auto it = mTileIndex.constBegin(), it_end = mTileIndex.constEnd(); it != it_end; ++it) {
+        if (it.key()->tileset() != tileset)
+            continue;
+
+        const QHash<QPoint, int> &tileChunks = it.value();
+        for (auto chunkIt = tileChunks.constBegin(), chunkEnd = tileChunks.constEnd(); chunkIt != chunkEnd; ++chunkIt)
+            chunks.insert(chunkIt.key());
+    }
+
+    return chunks;
+}
+
+TileMask TileLayer::cellMask(const Cell &cell) const
+{
+    if (cell.isEmpty())
+        return mask([&] (const Cell &other) { return other == cell; });
+
+    TileMask mask;
+    const QRect layerRect = cellArea();
+
+    for (const QPoint &chunkPos : chunksWithTile(cell.tile)) {
+        const auto it = mChunks.constFind(chunkPos);
+        Q_ASSERT(it != mChunks.constEnd());
+
+        const Chunk &chunk = it.value();
+        const QRect area = QRect(chunkPos * CHUNK_SIZE,
+                                 QSize(CHUNK_SIZE, CHUNK_SIZE)) & layerRect;
+
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            int runStart = -1;
+
+            for (int x = area.left(); x <= area.right() + 1; ++x) {
+                const bool matches = x <= area.right() &&
+                        chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK) == cell;
+
+                if (matches) {
+                    if (runStart == -1)
+                        runStart = x;
+                } else if (runStart != -1) {
+                    mask.setSpan(runStart + mX, y + mY, x - runStart);
+                    runStart = -1;
+                }
+            }
+        }
     }
 
-    mGrid[x + y * mWidth] = cell;
+    return mask;
+}
+
+void TileLayer::beginBulkEdit()
+{
+    if (mBulkEditDepth++ == 0) {
+        mLastTile = nullptr;
+        mDrawMarginsChanged = false;
+        mHasLastChangedChunk = false;
+        ++mGeneration;
+    }
+}
+
+void TileLayer::endBulkEdit()
+{
+    Q_ASSERT(mBulkEditDepth > 0);
+
+    if (--mBulkEditDepth > 0)
+        return;
+
+    // The tile may be deleted after the bulk edit
+    mLastTile = nullptr;
+
+    if (mDrawMarginsChanged && mMap)
+        mMap->adjustDrawMargins(drawMargins());
+
+    mDrawMarginsChanged = false;
+}
+
+/**
+ * Sets the cell at the given coordinates in \a chunks. No chunk is
+ * allocated when an empty cell is placed in an area without a chunk.
+ */
+void TileLayer::setCell(ChunkHash &chunks, int x, int y, const Cell &cell)
+{
+    const QPoint chunkPos(x >> CHUNK_BITS, y >> CHUNK_BITS);
+
+    if (cell.isEmpty()) {
+        auto it = chunks.find(chunkPos);
+        if (it != chunks.end()) {
+            it.value().setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
+
+            // Release chunks that became empty, so that only areas with
+            // cells have a chunk and renderers can skip the others
+            if (it.value().isEmpty())
+                chunks.erase(it);
+        }
+    } else {
+        chunks[chunkPos].setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
+    }
+}
+
+/**
+ * Clears any cells that are stored outside of the layer bounds and
+ * releases the chunks that no longer overlap with the layer.
+ */
+void TileLayer::clearOutsideBounds()
+{
+    const QRect layerRect(0, 0, mWidth, mHeight);
+
+    auto it = mChunks.begin();
+    while (it != mChunks.end()) {
+        const QRect chunkRect(it.key() * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE));
+
+        if (!chunkRect.intersects(layerRect)) {
+            it = mChunks.erase(it);
+            continue;
+        }
+
+        if (!layerRect.contains(chunkRect)) {
+            Chunk &chunk = it.value();
+            for (int y = 0; y < CHUNK_SIZE; ++y)
+                for (int x = 0; x < CHUNK_SIZE; ++x)
+                    if (!layerRect.contains(chunkRect.x() + x, chunkRect.y() + y))
+                        chunk.setCell(x, y, Cell::empty);
+
+            if (chunk.isEmpty()) {
+                it = mChunks.erase(it);
+                continue;
+            }
+        }
+
+        ++it;
+    }
 }
 
 TileLayer *TileLayer::copy(const QRegion &region) const
 {
-    const QRegion area = region.intersected(QRect(0, 0, width(), height()));
+    const QRegion area = region.intersected(cellArea());
     const QRect bounds = region.boundingRect();
     const QRect areaBounds = area.boundingRect();
     const int offsetX = qMax(0, areaBounds.x() - bounds.x());
@@ -133,30 +827,159 @@ TileLayer *TileLayer::copy(const QRegion &region) const
                                       0, 0,
                                       bounds.width(), bounds.height());
 
-    for (const QRect &rect : area.rects())
-        for (int x = rect.left(); x <= rect.right(); ++x)
-            for (int y = rect.top(); y <= rect.bottom(); ++y)
-                copied->setCell(x - areaBounds.x() + offsetX,
-                                y - areaBounds.y() + offsetY,
-                                cellAt(x, y));
+    const QPoint delta(offsetX - areaBounds.x(), offsetY - areaBounds.y());
+
+    if ((delta.x() & CHUNK_MASK) != 0 || (delta.y() & CHUNK_MASK) != 0) {
+        for (const QRect &rect : area.rects())
+            copied->mergeCells(rect.topLeft() + delta, this, rect);
+        return copied;
+    }
+
+    // When the chunks line up, chunks that are copied entirely are shared
+    // with this layer until either layer modifies them
+    const QPoint chunkDelta(delta.x() >> CHUNK_BITS, delta.y() >> CHUNK_BITS);
+    bool sharedChunks = false;
+
+    load();
+
+    for (auto it = mChunks.constBegin(), it_end = mChunks.constEnd(); it != it_end; ++it) {
+        const QRect chunkRect(it.key() * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE));
+        const QRegion part = area & chunkRect;
+        if (part.isEmpty())
+            continue;
+
+        if (part == QRegion(chunkRect)) {
+            copied->mChunks.insert(it.key() + chunkDelta, it.value());
+            sharedChunks = true;
+        } else {
+            for (const QRect &rect : part.rects())
+                copied->mergeCells(rect.topLeft() + delta, this, rect);
+        }
+    }
+
+    if (sharedChunks) {
+        copied->recomputeDrawMargins();
+        copied->recomputeTilesetUseCounts();
+        copied->markAllChanged();
+    }
 
     return copied;
 }
 
 void TileLayer::merge(const QPoint &pos, const TileLayer *layer)
 {
+    BulkEdit bulkEdit(this);
+
     // Determine the overlapping area
     QRect area = QRect(pos, QSize(layer->width(), layer->height()));
-    area &= QRect(0, 0, width(), height());
+    area &= cellArea();
 
-    for (int y = area.top(); y <= area.bottom(); ++y) {
-        for (int x = area.left(); x <= area.right(); ++x) {
-            const Cell &cell = layer->cellAt(x - pos.x(),
-                                             y - pos.y());
-            if (!cell.isEmpty())
-                setCell(x, y, cell);
+    // Only the chunks of the merged layer can contain non-empty cells
+    for (auto it = layer->begin(), it_end = layer->end(); it != it_end; ++it) {
+        const Cell &cell = *it;
+        if (cell.isEmpty())
+            continue;
+
+        const QPoint target = it.pos() + pos;
+        if (area.contains(target))
+            setCell(target.x(), target.y(), cell);
+    }
+}
+
+/**
+ * The cells are copied in spans that lie within a single chunk of both
+ * layers, so that the chunks are looked up once per span rather than once
+ * per cell. The draw margins are adjusted once at the end.
+ */
+int TileLayer::mergeCells(const QPoint &pos, const TileLayer *source,
+                          const QRect &area)
+{
+    Q_ASSERT(source != this);
+
+    const QPoint offset = pos - area.topLeft();
+    QRect target = area.intersected(source->cellArea());
+    target.translate(offset);
+    target &= cellArea();
+
+    if (target.isEmpty())
+        return 0;
+
+    BulkEdit bulkEdit(this);
+
+    QSize maxTileSize = mMaxTileSize;
+    QMargins offsetMargins = mOffsetMargins;
+    const Tile *lastTile = nullptr;
+    bool lastFlippedAntiDiagonally = false;
+    int count = 0;
+
+    for (int y = target.top(); y <= target.bottom(); ++y) {
+        const int sourceY = y - offset.y();
+        int x = target.left();
+
+        while (x <= target.right()) {
+            const int sourceX = x - offset.x();
+
+            // The span ends at the end of the target area or of either chunk
+            const int chunkEnd = (x | CHUNK_MASK) + 1;
+            const int sourceChunkEnd = (sourceX | CHUNK_MASK) + 1 + offset.x();
+            const int end = qMin(target.right() + 1, qMin(chunkEnd, sourceChunkEnd));
+
+            if (const Chunk *sourceChunk = source->findChunk(sourceX, sourceY)) {
+                Chunk *targetChunk = nullptr;
+
+                for (int i = x; i < end; ++i) {
+                    const Cell &cell = sourceChunk->cellAt((i - offset.x()) & CHUNK_MASK,
+                                                           sourceY & CHUNK_MASK);
+                    if (cell.isEmpty())
+                        continue;
+
+                    const QPoint chunkPos(x >> CHUNK_BITS, y >> CHUNK_BITS);
+
+                    if (!targetChunk) {
+                        targetChunk = &chunk(x, y);
+                        markChunkChanged(chunkPos);
+                    }
+
+                    const Cell &oldCell = targetChunk->cellAt(i & CHUNK_MASK, y & CHUNK_MASK);
+                    updateTilesetUseCounts(oldCell, cell);
+                    updateTileIndex(chunkPos, oldCell, cell);
+                    targetChunk->setCell(i & CHUNK_MASK, y & CHUNK_MASK, cell);
+                    ++count;
+
+                    if (cell.tile && (cell.tile != lastTile ||
+                                      cell.flippedAntiDiagonally != lastFlippedAntiDiagonally)) {
+                        lastTile = cell.tile;
+                        lastFlippedAntiDiagonally = cell.flippedAntiDiagonally;
+
+                        QSize size = cell.tile->size();
+                        if (cell.flippedAntiDiagonally)
+                            size.transpose();
+
+                        const QPoint tileOffset = cell.tile->offset();
+
+                        maxTileSize = maxSize(size, maxTileSize);
+                        offsetMargins = maxMargins(QMargins(-tileOffset.x(),
+                                                            -tileOffset.y(),
+                                                            tileOffset.x(),
+                                                            tileOffset.y()),
+                                                   offsetMargins);
+                    }
+                }
+            }
+
+            x = end;
         }
     }
+
+    if (maxTileSize != mMaxTileSize || offsetMargins != mOffsetMargins) {
+        mMaxTileSize = maxTileSize;
+        mOffsetMargins = offsetMargins;
+
+        if (mMap)
+            mMap->adjustDrawMargins(drawMargins());
+    }
+
+    return count;
 }
 
 void TileLayer::setCells(int x, int y, TileLayer *layer,
@@ -164,48 +987,184 @@ void TileLayer::setCells(int x, int y, TileLayer *layer,
 {
     // Determine the overlapping area
     QRegion area = QRect(x, y, layer->width(), layer->height());
-    area &= QRect(0, 0, width(), height());
+    area &= cellArea();
 
     if (!mask.isEmpty())
         area &= mask;
 
+    BulkEdit bulkEdit(this);
+
     for (const QRect &rect : area.rects())
         for (int _x = rect.left(); _x <= rect.right(); ++_x)
             for (int _y = rect.top(); _y <= rect.bottom(); ++_y)
                 setCell(_x, _y, layer->cellAt(_x - x, _y - y));
 }
 
+/**
+ * Only the chunks overlapping with \a area are visited, and their cells are
+ * cleared one span at a time. Areas without a chunk are already empty, so
+ * the cost depends on the number of cells actually cleared.
+ */
 void TileLayer::erase(const QRegion &area)
 {
+    load();
+
+    BulkEdit bulkEdit(this);
+
     const Cell emptyCell;
-    for (const QRect &rect : area.rects())
-        for (int x = rect.left(); x <= rect.right(); ++x)
-            for (int y = rect.top(); y <= rect.bottom(); ++y)
-                setCell(x, y, emptyCell);
+    const QRect layerRect = cellArea();
+
+    for (const QRect &areaRect : area.rects()) {
+        const QRect rect = areaRect & layerRect;
+        if (rect.isEmpty())
+            continue;
+
+        for (int chunkY = rect.top() >> CHUNK_BITS; chunkY <= rect.bottom() >> CHUNK_BITS; ++chunkY) {
+            for (int chunkX = rect.left() >> CHUNK_BITS; chunkX <= rect.right() >> CHUNK_BITS; ++chunkX) {
+                const QPoint chunkPos(chunkX, chunkY);
+                auto it = mChunks.find(chunkPos);
+                if (it == mChunks.end())
+                    continue;
+
+                Chunk &chunk = it.value();
+                const QRect chunkRect(chunkPos * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE));
+                const QRect span = rect & chunkRect;
+
+                for (int y = span.top(); y <= span.bottom() && !chunk.isEmpty(); ++y) {
+                    for (int x = span.left(); x <= span.right(); ++x) {
+                        const Cell &oldCell = chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+                        if (oldCell.isEmpty())
+                            continue;
+
+                        markChunkChanged(chunkPos);
+                        updateTilesetUseCounts(oldCell, emptyCell);
+                        updateTileIndex(chunkPos, oldCell, emptyCell);
+                        chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, emptyCell);
+                    }
+                }
+
+                // See setCell(ChunkHash&, ...)
+                if (chunk.isEmpty())
+                    mChunks.erase(it);
+            }
+        }
+    }
 }
 
-void TileLayer::flip(FlipDirection direction)
+namespace {
+
+/**
+ * An integer transformation of cell coordinates that maps rectangles to
+ * rectangles, like flipping, rotating by 90 degrees and translating.
+ */
+struct CellTransform
 {
-    QVector<Cell> newGrid(mWidth * mHeight);
+    CellTransform(int xx, int xy, int yx, int yy, int dx, int dy)
+        : xx(xx), xy(xy), yx(yx), yy(yy), dx(dx), dy(dy)
+    {}
+
+    static CellTransform translation(int dx, int dy)
+    { return CellTransform(1, 0, 0, 1, dx, dy); }
+
+    QPoint map(int x, int y) const
+    { return QPoint(xx * x + xy * y + dx, yx * x + yy * y + dy); }
+
+    // The matrix only swaps and negates axes, so its inverse is its transpose
+    QPoint inverted(int x, int y) const
+    {
+        x -= dx;
+        y -= dy;
+        return QPoint(xx * x + yx * y, xy * x + yy * y);
+    }
 
-    Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
+    QRect mapRect(const QRect &rect) const
+    {
+        const QPoint a = map(rect.left(), rect.top());
+        const QPoint b = map(rect.right(), rect.bottom());
+        return QRect(QPoint(qMin(a.x(), b.x()), qMin(a.y(), b.y())),
+                     QPoint(qMax(a.x(), b.x()), qMax(a.y(), b.y())));
+    }
 
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            Cell &dest = newGrid[x + y * mWidth];
-            if (direction == FlipHorizontally) {
-                const Cell &source = cellAt(mWidth - x - 1, y);
-                dest = source;
-                dest.flippedHorizontally = !source.flippedHorizontally;
-            } else if (direction == FlipVertically) {
-                const Cell &source = cellAt(x, mHeight - y - 1);
-                dest = source;
-                dest.flippedVertically = !source.flippedVertically;
+    int xx, xy, yx, yy, dx, dy;
+};
+
+/**
+ * Moves the cells within \a sourceArea of the \a source chunks to
+ * \a target, placing them according to \a transform and adjusting each
+ * cell with \a adjust. Cells that end up outside of \a targetArea are
+ * dropped.
+ *
+ * The work is done per pair of source and target chunk, so that each chunk
+ * is looked up once rather than once per cell.
+ */
+template<typename Adjust>
+void transformCells(const ChunkHash &source, const QRect &sourceArea,
+                    const CellTransform &transform, const QRect &targetArea,
+                    ChunkHash &target, Adjust adjust)
+{
+    for (auto it = source.constBegin(), it_end = source.constEnd(); it != it_end; ++it) {
+        const Chunk &sourceChunk = it.value();
+        const QRect sourceRect = QRect(it.key() * CHUNK_SIZE,
+                                       QSize(CHUNK_SIZE, CHUNK_SIZE)) & sourceArea;
+        const QRect targetRect = sourceRect.isEmpty() ? QRect()
+                                                      : transform.mapRect(sourceRect) & targetArea;
+        if (targetRect.isEmpty())
+            continue;
+
+        for (int chunkY = targetRect.top() >> CHUNK_BITS; chunkY <= targetRect.bottom() >> CHUNK_BITS; ++chunkY) {
+            for (int chunkX = targetRect.left() >> CHUNK_BITS; chunkX <= targetRect.right() >> CHUNK_BITS; ++chunkX) {
+                const QPoint chunkPos(chunkX, chunkY);
+                const QRect part = QRect(chunkPos * CHUNK_SIZE,
+                                         QSize(CHUNK_SIZE, CHUNK_SIZE)) & targetRect;
+                Chunk *targetChunk = nullptr;
+
+                for (int y = part.top(); y <= part.bottom(); ++y) {
+                    for (int x = part.left(); x <= part.right(); ++x) {
+                        const QPoint s = transform.inverted(x, y);
+                        const Cell &cell = sourceChunk.cellAt(s.x() & CHUNK_MASK,
+                                                              s.y() & CHUNK_MASK);
+                        if (cell.isEmpty())
+                            continue;
+
+                        if (!targetChunk)
+                            targetChunk = &target[chunkPos];
+
+                        Cell dest = cell;
+                        adjust(dest);
+                        targetChunk->setCell(x & CHUNK_MASK, y & CHUNK_MASK, dest);
+                    }
+                }
             }
         }
     }
+}
+
+} // anonymous namespace
 
-    mGrid = newGrid;
+void TileLayer::flip(FlipDirection direction)
+{
+    Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
+
+    load();
+
+    // The cells of infinite layers outside of the layer size are flipped
+    // along with it
+    const QRect area = cellBounds();
+    ChunkHash newChunks;
+    newChunks.reserve(mChunks.size() * 2);
+
+    if (direction == FlipHorizontally) {
+        const CellTransform transform(-1, 0, 0, 1, mWidth - 1, 0);
+        transformCells(mChunks, area, transform, transform.mapRect(area), newChunks,
+                       [] (Cell &cell) { cell.flippedHorizontally = !cell.flippedHorizontally; });
+    } else {
+        const CellTransform transform(1, 0, 0, -1, 0, mHeight - 1);
+        transformCells(mChunks, area, transform, transform.mapRect(area), newChunks,
+                       [] (Cell &cell) { cell.flippedVertically = !cell.flippedVertically; });
+    }
+
+    mChunks = newChunks;
+    markAllChanged();
 }
 
 void TileLayer::rotate(RotateDirection direction)
@@ -216,79 +1175,133 @@ void TileLayer::rotate(RotateDirection direction)
     const char (&rotateMask)[8] =
             (direction == RotateRight) ? rotateRightMask : rotateLeftMask;
 
+    load();
+
     int newWidth = mHeight;
     int newHeight = mWidth;
-    QVector<Cell> newGrid(newWidth * newHeight);
+    ChunkHash newChunks;
+    newChunks.reserve(mChunks.size() * 4);
 
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            const Cell &source = cellAt(x, y);
-            Cell dest = source;
+    const CellTransform transform = (direction == RotateRight)
+            ? CellTransform(0, -1, 1, 0, mHeight - 1, 0)
+            : CellTransform(0, 1, -1, 0, 0, mWidth - 1);
 
-            unsigned char mask =
-                    (dest.flippedHorizontally << 2) |
-                    (dest.flippedVertically << 1) |
-                    (dest.flippedAntiDiagonally << 0);
+    // The cells of infinite layers outside of the layer size are rotated
+    // along with it
+    const QRect area = cellBounds();
 
-            mask = rotateMask[mask];
+    transformCells(mChunks, area, transform, transform.mapRect(area), newChunks,
+                   [&] (Cell &cell) {
+        unsigned char mask =
+                (cell.flippedHorizontally << 2) |
+                (cell.flippedVertically << 1) |
+                (cell.flippedAntiDiagonally << 0);
 
-            dest.flippedHorizontally = (mask & 4) != 0;
-            dest.flippedVertically = (mask & 2) != 0;
-            dest.flippedAntiDiagonally = (mask & 1) != 0;
+        mask = rotateMask[mask];
 
-            if (direction == RotateRight)
-                newGrid[x * newWidth + (mHeight - y - 1)] = dest;
-            else
-                newGrid[(mWidth - x - 1) * newWidth + y] = dest;
-        }
-    }
+        cell.flippedHorizontally = (mask & 4) != 0;
+        cell.flippedVertically = (mask & 2) != 0;
+        cell.flippedAntiDiagonally = (mask & 1) != 0;
+    });
 
     std::swap(mMaxTileSize.rwidth(),
               mMaxTileSize.rheight());
 
     mWidth = newWidth;
     mHeight = newHeight;
-    mGrid = newGrid;
+    mChunks = newChunks;
+    markAllChanged();
 }
 
 
 QSet<SharedTileset> TileLayer::usedTilesets() const
 {
+    loadUnlessCompressed();
+
     QSet<SharedTileset> tilesets;
+    tilesets.reserve(mTilesetUseCounts.size());
 
-    for (const Cell &cell : mGrid)
-        if (const Tile *tile = cell.tile)
-            tilesets.insert(tile->sharedTileset());
+    for (auto it = mTilesetUseCounts.constBegin(), it_end = mTilesetUseCounts.constEnd(); it != it_end; ++it)
+        tilesets.insert(it.key()->sharedPointer());
 
     return tilesets;
 }
 
 bool TileLayer::referencesTileset(const Tileset *tileset) const
 {
-    for (const Cell &cell : mGrid) {
-        const Tile *tile = cell.tile;
-        if (tile && tile->tileset() == tileset)
-            return true;
-    }
-    return false;
+    loadUnlessCompressed();
+    return mTilesetUseCounts.contains(const_cast<Tileset*>(tileset));
 }
 
+/**
+ * Only the chunks that contain tiles from the tileset are looked at.
+ */
 void TileLayer::removeReferencesToTileset(Tileset *tileset)
 {
-    for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
-        const Tile *tile = mGrid.at(i).tile;
-        if (tile && tile->tileset() == tileset)
-            mGrid.replace(i, Cell());
+    if (!referencesTileset(tileset))
+        return;
+
+    load();
+
+    BulkEdit bulkEdit(this);
+
+    for (const QPoint &chunkPos : chunksWithTileset(tileset)) {
+        auto it = mChunks.find(chunkPos);
+        Chunk &chunk = it.value();
+        markChunkChanged(chunkPos);
+
+        for (int index = 0; index < CHUNK_SIZE * CHUNK_SIZE; ++index) {
+            const Cell &cell = chunk.cellAt(index);
+            if (cell.tile && cell.tile->tileset() == tileset) {
+                updateTileIndex(chunkPos, cell, Cell::empty);
+                chunk.setCell(index & CHUNK_MASK, index >> CHUNK_BITS, Cell::empty);
+            }
+        }
+
+        if (chunk.isEmpty())
+            mChunks.erase(it);
     }
+
+    mTilesetUseCounts.remove(tileset);
 }
 
+/**
+ * Only the chunks that contain tiles from the old tileset are looked at.
+ */
 void TileLayer::replaceReferencesToTileset(Tileset *oldTileset,
                                            Tileset *newTileset)
 {
-    for (Cell &cell : mGrid) {
-        const Tile *tile = cell.tile;
-        if (tile && tile->tileset() == oldTileset)
-            cell.tile = newTileset->tileAt(tile->id());
+    if (!referencesTileset(oldTileset))
+        return;
+
+    load();
+
+    BulkEdit bulkEdit(this);
+
+    for (const QPoint &chunkPos : chunksWithTileset(oldTileset)) {
+        auto it = mChunks.find(chunkPos);
+        Chunk &chunk = it.value();
+        markChunkChanged(chunkPos);
+
+        for (int index = 0; index < CHUNK_SIZE * CHUNK_SIZE; ++index) {
+            const Cell &cell = chunk.cellAt(index);
+            const Tile *tile = cell.tile;
+            if (!tile || tile->tileset() != oldTileset)
+                continue;
+
+            // Tiles missing from the new tileset are removed
+            Cell newCell = cell;
+            newCell.tile = newTileset->tileAt(tile->id());
+            if (!newCell.tile)
+                newCell = Cell::empty;
+
+            updateTilesetUseCounts(cell, newCell);
+            updateTileIndex(chunkPos, cell, newCell);
+            chunk.setCell(index & CHUNK_MASK, index >> CHUNK_BITS, newCell);
+        }
+
+        if (chunk.isEmpty())
+            mChunks.erase(it);
     }
 }
 
@@ -297,68 +1310,133 @@ void TileLayer::resize(const QSize &size, const QPoint &offset)
     if (this->size() == size && offset.isNull())
         return;
 
-    QVector<Cell> newGrid(size.width() * size.height());
+    load();
+
+    if ((offset.x() & CHUNK_MASK) == 0 && (offset.y() & CHUNK_MASK) == 0) {
+        // Chunk-aligned offsets only require moving the chunks around
+        const QPoint chunkOffset(offset.x() >> CHUNK_BITS,
+                                 offset.y() >> CHUNK_BITS);
+
+        if (!chunkOffset.isNull()) {
+            ChunkHash newChunks;
+            newChunks.reserve(mChunks.size());
+
+            for (auto it = mChunks.constBegin(), it_end = mChunks.constEnd(); it != it_end; ++it)
+                newChunks.insert(it.key() + chunkOffset, it.value());
+
+            mChunks = newChunks;
+        }
+    } else {
+        const QRect newArea = isInfinite() ? cellArea() : QRect(QPoint(), size);
+        ChunkHash newChunks;
 
-    // Copy over the preserved part
-    const int startX = qMax(0, -offset.x());
-    const int startY = qMax(0, -offset.y());
-    const int endX = qMin(mWidth, size.width() - offset.x());
-    const int endY = qMin(mHeight, size.height() - offset.y());
+        for (auto it = constBegin(), it_end = constEnd(); it != it_end; ++it) {
+            const Cell &cell = *it;
+            if (cell.isEmpty())
+                continue;
 
-    for (int y = startY; y < endY; ++y) {
-        for (int x = startX; x < endX; ++x) {
-            const int index = x + offset.x() + (y + offset.y()) * size.width();
-            newGrid[index] = cellAt(x, y);
+            const QPoint pos = it.pos() + offset;
+            if (newArea.contains(pos))
+                setCell(newChunks, pos.x(), pos.y(), cell);
         }
+
+        mChunks = newChunks;
     }
 
-    mGrid = newGrid;
     setSize(size);
+
+    // Infinite layers keep all of their cells, so growing them only costs
+    // moving the chunks
+    if (!isInfinite()) {
+        clearOutsideBounds();
+        recomputeTilesetUseCounts();
+    }
+
+    markAllChanged();
 }
 
 void TileLayer::offsetTiles(const QPoint &offset,
                             const QRect &bounds,
                             bool wrapX, bool wrapY)
 {
-    QVector<Cell> newGrid(mWidth * mHeight);
+    load();
 
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            // Skip out of bounds tiles
-            if (!bounds.contains(x, y)) {
-                newGrid[x + y * mWidth] = cellAt(x, y);
-                continue;
-            }
+    ChunkHash newChunks;
+    newChunks.reserve(mChunks.size());
 
-            // Get position to pull tile value from
-            int oldX = x - offset.x();
-            int oldY = y - offset.y();
+    // Tiles outside of the bounds stay where they are
+    for (auto it = mChunks.constBegin(), it_end = mChunks.constEnd(); it != it_end; ++it) {
+        const QRect chunkRect(it.key() * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE));
 
-            // Wrap x value that will be pulled from
-            if (wrapX && bounds.width() > 0) {
-                while (oldX < bounds.left())
-                    oldX += bounds.width();
-                while (oldX > bounds.right())
-                    oldX -= bounds.width();
-            }
+        if (!chunkRect.intersects(bounds)) {
+            newChunks.insert(it.key(), it.value());
+            continue;
+        }
 
-            // Wrap y value that will be pulled from
-            if (wrapY && bounds.height() > 0) {
-                while (oldY < bounds.top())
-                    oldY += bounds.height();
-                while (oldY > bounds.bottom())
-                    oldY -= bounds.height();
+        if (bounds.contains(chunkRect))
+            continue;
+
+        const Chunk &chunk = it.value();
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                const Cell &cell = chunk.cellAt(x, y);
+                if (!cell.isEmpty() && !bounds.contains(chunkRect.x() + x, chunkRect.y() + y))
+                    newChunks[it.key()].setCell(x, y, cell);
             }
+        }
+    }
 
-            // Set the new tile
-            if (contains(oldX, oldY) && bounds.contains(oldX, oldY))
-                newGrid[x + y * mWidth] = cellAt(oldX, oldY);
-            else
-                newGrid[x + y * mWidth] = Cell();
+    // The tiles within the bounds are moved in up to two spans per axis,
+    // split where they wrap around
+    struct Span {
+        int first;
+        int last;
+        int shift;
+    };
+
+    auto spans = [] (int offset, int first, int size, bool wrap, Span *out) {
+        int shift = offset;
+        if (wrap && size > 0) {
+            shift = offset % size;
+            if (shift < 0)
+                shift += size;
+        }
+
+        if (!wrap || shift == 0) {
+            out[0] = { first, first + size - 1, shift };
+            return 1;
+        }
+
+        out[0] = { first, first + size - shift - 1, shift };
+        out[1] = { first + size - shift, first + size - 1, shift - size };
+        return 2;
+    };
+
+    Span spansX[2];
+    Span spansY[2];
+    const int countX = spans(offset.x(), bounds.left(), bounds.width(), wrapX, spansX);
+    const int countY = spans(offset.y(), bounds.top(), bounds.height(), wrapY, spansY);
+
+    // Tiles moved out of the bounds are dropped
+    const QRect targetArea = bounds & cellArea();
+
+    for (int i = 0; i < countY; ++i) {
+        for (int j = 0; j < countX; ++j) {
+            const QRect sourceArea(QPoint(spansX[j].first, spansY[i].first),
+                                   QPoint(spansX[j].last, spansY[i].last));
+
+            transformCells(mChunks, sourceArea,
+                           CellTransform::translation(spansX[j].shift, spansY[i].shift),
+                           targetArea, newChunks,
+                           [] (Cell &) {});
         }
     }
 
-    mGrid = newGrid;
+    mChunks = newChunks;
+
+    // Tiles moved out of the bounds were dropped
+    recomputeTilesetUseCounts();
+    markAllChanged();
 }
 
 bool TileLayer::canMergeWith(Layer *other) const
@@ -382,34 +1460,97 @@ Layer *TileLayer::mergedWith(Layer *other) const
 
 QRegion TileLayer::computeDiffRegion(const TileLayer *other) const
 {
-    QRegion ret;
+    return computeDiffMask(other).toRegion();
+}
+
+/**
+ * The layers are compared in spans that lie within a single chunk of both
+ * layers. Spans where neither layer has a chunk, and spans of chunks that
+ * are shared between the layers, are skipped without looking at the cells.
+ */
+TileMask TileLayer::computeDiffMask(const TileLayer *other) const
+{
+    TileMask mask;
 
     const int dx = other->x() - mX;
     const int dy = other->y() - mY;
-    QRect r = QRect(0, 0, width(), height());
-    r &= QRect(dx, dy, other->width(), other->height());
+    QRect r = cellBounds();
+    r &= other->cellBounds().translated(dx, dy);
 
     for (int y = r.top(); y <= r.bottom(); ++y) {
-        for (int x = r.left(); x <= r.right(); ++x) {
-            if (cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
-                const int rangeStart = x;
-                while (x <= r.right() &&
-                       cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
-                    ++x;
+        int rangeStart = -1;
+
+        auto endRange = [&] (int x) {
+            if (rangeStart != -1) {
+                mask.setSpan(rangeStart, y, x - rangeStart);
+                rangeStart = -1;
+            }
+        };
+
+        for (int x = r.left(); x <= r.right();) {
+            const int chunkEnd = (x | CHUNK_MASK) + 1;
+            const int otherChunkEnd = ((x - dx) | CHUNK_MASK) + 1 + dx;
+            const int end = qMin(r.right() + 1, qMin(chunkEnd, otherChunkEnd));
+
+            const Chunk *chunk = findChunk(x, y);
+            const Chunk *otherChunk = other->findChunk(x - dx, y - dy);
+
+            // Equal when neither layer has a chunk, or when the layers share
+            // the chunk at the same position
+            if (chunk == otherChunk || (chunk && otherChunk &&
+                                        chunk->isSharedWith(*otherChunk) &&
+                                        (dx & CHUNK_MASK) == 0 &&
+                                        (dy & CHUNK_MASK) == 0)) {
+                endRange(x);
+                x = end;
+                continue;
+            }
+
+            // Chunks packed with the same tilesets are compared without
+            // resolving their tiles
+            if (chunk && otherChunk && chunk->hasSamePacking(*otherChunk)) {
+                for (; x < end; ++x) {
+                    const int index = (x & CHUNK_MASK) + (y & CHUNK_MASK) * CHUNK_SIZE;
+                    const int otherIndex = ((x - dx) & CHUNK_MASK) + ((y - dy) & CHUNK_MASK) * CHUNK_SIZE;
+
+                    if (chunk->packedCellAt(index) != otherChunk->packedCellAt(otherIndex)) {
+                        if (rangeStart == -1)
+                            rangeStart = x;
+                    } else {
+                        endRange(x);
+                    }
+                }
+                continue;
+            }
+
+            for (; x < end; ++x) {
+                const Cell &cell = chunk ? chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK)
+                                         : Cell::empty;
+                const Cell &otherCell = otherChunk ? otherChunk->cellAt((x - dx) & CHUNK_MASK,
+                                                                        (y - dy) & CHUNK_MASK)
+                                                   : Cell::empty;
+
+                if (cell != otherCell) {
+                    if (rangeStart == -1)
+                        rangeStart = x;
+                } else {
+                    endRange(x);
                 }
-                const int rangeEnd = x;
-                ret += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
             }
         }
+
+        endRange(r.right() + 1);
     }
 
-    return ret;
+    return mask;
 }
 
 bool TileLayer::isEmpty() const
 {
-    for (const Cell &cell : mGrid)
-        if (!cell.isEmpty())
+    load();
+
+    for (const Chunk &chunk : mChunks)
+        if (!chunk.isEmpty())
             return false;
 
     return true;
@@ -425,11 +1566,45 @@ Layer *TileLayer::clone() const
     return initializeClone(new TileLayer(mName, mX, mY, mWidth, mHeight));
 }
 
+qint64 TileLayer::memoryUsage() const
+{
+    return Layer::memoryUsage() + cellMemoryUsage();
+}
+
+qint64 TileLayer::cellMemoryUsage() const
+{
+    if (mCompressed)
+        return mCompressedSize;
+    if (!isLoaded())
+        return 0;
+
+    qint64 size = qint64(mChunks.size()) * sizeof(QHashNode<QPoint, Chunk>);
+    for (const Chunk &chunk : mChunks)
+        size += chunk.memoryUsage();
+
+    return size;
+}
+
 TileLayer *TileLayer::initializeClone(TileLayer *clone) const
 {
     Layer::initializeClone(clone);
-    clone->mGrid = mGrid;
+
+    clone->mGeneration = mGeneration;
+    clone->mStructureGeneration = mStructureGeneration;
+    clone->mChunkGenerations = mChunkGenerations;
+    clone->mTilesetUseCounts = mTilesetUseCounts;
     clone->mMaxTileSize = mMaxTileSize;
     clone->mOffsetMargins = mOffsetMargins;
+
+    // A layer that was not loaded yet stays that way, since its loader can
+    // load the cells of the clone just as well
+    if (!isLoaded()) {
+        clone->mCellLoader = mCellLoader;
+        clone->mCompressed = mCompressed;
+        clone->mCompressedSize = mCompressedSize;
+        return clone;
+    }
+
+    clone->mChunks = mChunks;
     return clone;
 }
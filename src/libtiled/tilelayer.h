@@ -34,12 +34,17 @@
 
 #include "layer.h"
 #include "tiled.h"
+#include "tilemask.h"
 
+#include <QHash>
 #include <QMargins>
+#include <QPoint>
 #include <QString>
 #include <QVector>
 #include <QSharedPointer>
 
+#include <functional>
+
 namespace Tiled {
 
 class Tile;
@@ -47,9 +52,11 @@ class Tile;
 /**
  * A cell on a tile layer grid.
  */
-class Cell
+class TILEDSHARED_EXPORT Cell
 {
 public:
+    static const Cell empty;
+
     Cell() :
         tile(nullptr),
         flippedHorizontally(false),
@@ -88,25 +95,318 @@ public:
     bool flippedAntiDiagonally;
 };
 
+static const int CHUNK_BITS = 4;
+static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+static const int CHUNK_MASK = CHUNK_SIZE - 1;
+
+/**
+ * A square block of CHUNK_SIZE x CHUNK_SIZE cells. Tile layers store their
+ * cells in chunks that are only allocated once a non-empty cell is placed
+ * in them, and released again once all their cells are empty.
+ *
+ * The cells are stored packed into a 32-bit word each, holding the flip
+ * flags, an index into a palette of the tilesets used by the chunk and the
+ * tile ID. This takes a quarter of the memory of a Cell. A chunk switches to
+ * storing full cells when it is given a cell that can't be packed: a tile of
+ * an image collection tileset, whose tile IDs change when tiles are removed,
+ * a tile ID that doesn't fit, a tileset beyond the size of the palette or an
+ * empty cell with flip flags.
+ *
+ * The cells of a chunk are implicitly shared, so clones and copies of a tile
+ * layer share their chunks until one of them modifies a chunk.
+ */
+class TILEDSHARED_EXPORT Chunk
+{
+public:
+    enum {
+        FlippedHorizontallyBit      = 0x80000000,
+        FlippedVerticallyBit        = 0x40000000,
+        FlippedAntiDiagonallyBit    = 0x20000000,
+
+        TilesetShift                = 21,
+        TilesetMask                 = 0xFF,
+        TileIdMask                  = (1 << TilesetShift) - 1,
+
+        MaxTilesets                 = TilesetMask
+    };
+
+    /**
+     * Iterates over all the cells of a chunk, row by row.
+     */
+    class const_iterator
+    {
+    public:
+        const_iterator(const Chunk *chunk, int index) :
+            mChunk(chunk),
+            mIndex(index)
+        {}
+
+        Cell operator*() const { return mChunk->cellAt(mIndex); }
+        const_iterator &operator++() { ++mIndex; return *this; }
+
+        bool operator==(const const_iterator &other) const
+        { return mIndex == other.mIndex; }
+        bool operator!=(const const_iterator &other) const
+        { return mIndex != other.mIndex; }
+
+    private:
+        const Chunk *mChunk;
+        int mIndex;
+    };
+
+    Chunk() :
+        mWords(CHUNK_SIZE * CHUNK_SIZE),
+        mCellCount(0)
+    {}
+
+    Cell cellAt(int x, int y) const
+    { return cellAt(x + y * CHUNK_SIZE); }
+
+    inline Cell cellAt(int index) const;
+
+    inline void setCell(int x, int y, const Cell &cell);
+
+    /**
+     * Returns the number of non-empty cells in this chunk.
+     */
+    int cellCount() const { return mCellCount; }
+
+    bool isEmpty() const { return mCellCount == 0; }
+
+    /**
+     * Returns whether the cells of this chunk are stored packed.
+     */
+    bool isPacked() const { return mCells.isEmpty(); }
+
+    /**
+     * Returns whether this chunk shares its cells with \a other, in which
+     * case they are known to be equal.
+     */
+    bool isSharedWith(const Chunk &other) const
+    {
+        return isPacked() ? mWords.constData() == other.mWords.constData()
+                          : mCells.constData() == other.mCells.constData();
+    }
+
+    /**
+     * Returns whether the packed cells of this chunk and \a other can be
+     * compared word by word, which is the case when both are packed with
+     * the same tilesets.
+     */
+    bool hasSamePacking(const Chunk &other) const
+    { return isPacked() && other.isPacked() && mTilesets == other.mTilesets; }
+
+    /**
+     * Returns the packed cell at \a index. Only valid for packed chunks.
+     */
+    quint32 packedCellAt(int index) const { return mWords.at(index); }
+
+    /**
+     * Returns the approximate number of bytes used by this chunk.
+     */
+    qint64 memoryUsage() const;
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, CHUNK_SIZE * CHUNK_SIZE); }
+
+private:
+    friend class TileLayer;
+
+    bool pack(const Cell &cell, quint32 &word);
+    void unpack();
+
+    QByteArray toByteArray() const;
+    bool fromByteArray(const QByteArray &data);
+
+    QVector<quint32> mWords;        // packed cells, empty when not packed
+    QVector<Tileset*> mTilesets;    // palette of the packed cells
+    QVector<Cell> mCells;           // cells, empty when packed
+    int mCellCount;
+};
+
+inline Cell Chunk::cellAt(int index) const
+{
+    if (!isPacked())
+        return mCells.at(index);
+
+    const quint32 word = mWords.at(index);
+    const int tileset = int((word >> TilesetShift) & TilesetMask);
+    if (tileset == 0)
+        return Cell();
+
+    Cell cell(mTilesets.at(tileset - 1)->tileAt(int(word & TileIdMask)));
+    cell.flippedHorizontally = word & FlippedHorizontallyBit;
+    cell.flippedVertically = word & FlippedVerticallyBit;
+    cell.flippedAntiDiagonally = word & FlippedAntiDiagonallyBit;
+    return cell;
+}
+
+inline void Chunk::setCell(int x, int y, const Cell &cell)
+{
+    const int index = x + y * CHUNK_SIZE;
+
+    if (isPacked()) {
+        quint32 word;
+        if (pack(cell, word)) {
+            quint32 &target = mWords[index];
+            mCellCount += int(word != 0) - int(target != 0);
+            target = word;
+            return;
+        }
+
+        unpack();
+    }
+
+    Cell &target = mCells[index];
+    mCellCount += int(!cell.isEmpty()) - int(!target.isEmpty());
+    target = cell;
+}
+
+typedef QHash<QPoint, Chunk> ChunkHash;
+
+/**
+ * Iterates over all the cells stored in the chunks of a tile layer. Cells
+ * in areas where no chunk has been allocated are not visited, since they
+ * are known to be empty.
+ */
+class ChunkCellIterator
+{
+public:
+    explicit ChunkCellIterator(ChunkHash::const_iterator chunk) :
+        mChunk(chunk),
+        mIndex(0)
+    {}
+
+    Cell operator*() const
+    { return mChunk.value().cellAt(mIndex); }
+
+    ChunkCellIterator &operator++()
+    {
+        if (++mIndex == CHUNK_SIZE * CHUNK_SIZE) {
+            mIndex = 0;
+            ++mChunk;
+        }
+        return *this;
+    }
+
+    bool operator==(const ChunkCellIterator &other) const
+    { return mChunk == other.mChunk && mIndex == other.mIndex; }
+
+    bool operator!=(const ChunkCellIterator &other) const
+    { return !(*this == other); }
+
+    /**
+     * Returns the position of the current cell in layer coordinates.
+     */
+    QPoint pos() const
+    {
+        return QPoint(mChunk.key().x() * CHUNK_SIZE + (mIndex & CHUNK_MASK),
+                      mChunk.key().y() * CHUNK_SIZE + (mIndex >> CHUNK_BITS));
+    }
+
+private:
+    ChunkHash::const_iterator mChunk;
+    int mIndex;
+};
+
 /**
  * A tile layer is a grid of cells. Each cell refers to a specific tile, and
  * stores how the tile is flipped.
  *
  * Coordinates and regions passed to function parameters are in local
  * coordinates and do not take into account the position of the layer.
+ *
+ * The cells are stored in chunks, which are allocated on demand. Large
+ * layers that are mostly empty therefore only use memory for the areas
+ * that actually contain tiles.
+ *
+ * The cells of a tile layer can be loaded lazily, by setting a cell loader
+ * that is called on first access to the cells.
  */
 class TILEDSHARED_EXPORT TileLayer : public Layer
 {
 public:
+    typedef std::function<void(TileLayer &)> CellLoader;
+    typedef QHash<QPoint, QByteArray> CompressedChunks;
+
+    /**
+     * Groups many calls to setCell() on a tile layer. For the duration of its
+     * scope, the size and offset of a tile are only looked at when it differs
+     * from the tile of the previously set cell, and the draw margins of the
+     * map are adjusted once at the end. The whole bulk edit counts as a
+     * single change generation (see changesSince()).
+     *
+     * The tiles may not change in size or offset during the bulk edit.
+     */
+    class BulkEdit
+    {
+    public:
+        explicit BulkEdit(TileLayer *layer) : mLayer(layer)
+        { mLayer->beginBulkEdit(); }
+
+        ~BulkEdit()
+        { mLayer->endBulkEdit(); }
+
+    private:
+        Q_DISABLE_COPY(BulkEdit)
+
+        TileLayer *mLayer;
+    };
+
     /**
      * Constructor.
      */
     TileLayer(const QString &name, int x, int y, int width, int height);
 
+    /**
+     * Sets the function that loads the cells of this layer. It is called
+     * just once, when the cells are first accessed.
+     *
+     * Clones of the layer made before that get a copy of the function, so it
+     * needs to be able to load the cells of a clone as well.
+     */
+    void setCellLoader(const CellLoader &loader) { mCellLoader = loader; }
+
+    /**
+     * Returns whether the cells of this layer have been loaded.
+     */
+    bool isLoaded() const { return !mCellLoader; }
+
+    /**
+     * Makes sure the cells of this layer are loaded.
+     */
+    void load() const { if (mCellLoader) loadCells(); }
+
+    /**
+     * Compresses the cells of the given \a chunks, each chunk on its own.
+     * The chunks are only read, so this can be done on a worker thread with
+     * a copy of chunks().
+     */
+    static CompressedChunks compressChunks(const ChunkHash &chunks);
+
+    /**
+     * Replaces the cells of this layer by their \a compressed form, which is
+     * decompressed again when the cells are next accessed. This is only done
+     * when the cells didn't change since \a generation, the change generation
+     * at which the chunks were compressed.
+     *
+     * The draw margins, the change generation and the used tilesets remain
+     * available without decompressing the cells.
+     *
+     * Returns whether the cells were replaced.
+     */
+    bool setCompressedChunks(const CompressedChunks &compressed,
+                             unsigned generation);
+
+    /**
+     * Returns whether the cells of this layer are currently compressed.
+     */
+    bool isCompressed() const { return mCompressed; }
+
     /**
      * Returns the maximum tile size of this layer.
      */
-    QSize maxTileSize() const { return mMaxTileSize; }
+    QSize maxTileSize() const { loadUnlessCompressed(); return mMaxTileSize; }
 
     /**
      * Returns the margins that have to be taken into account while drawing
@@ -115,6 +415,7 @@ public:
      */
     QMargins drawMargins() const
     {
+        loadUnlessCompressed();
         return QMargins(mOffsetMargins.left(),
                         mOffsetMargins.top() + mMaxTileSize.height(),
                         mOffsetMargins.right() + mMaxTileSize.width(),
@@ -132,6 +433,33 @@ public:
     bool contains(const QPoint &point) const
     { return contains(point.x(), point.y()); }
 
+    /**
+     * Returns whether this layer is part of an infinite map. Its cells are
+     * then not limited to its bounds, and setting a cell outside of them
+     * just allocates the chunk holding it.
+     */
+    bool isInfinite() const;
+
+    /**
+     * Returns the area in which this layer can hold cells, in its own
+     * coordinates. This is the rectangle at (0, 0) with the size of the
+     * layer, unless the layer is infinite.
+     */
+    QRect cellArea() const;
+
+    /**
+     * Returns the rectangle covering all cells of this layer, in its own
+     * coordinates. For infinite layers, this is the rectangle at (0, 0) with
+     * the size of the layer extended to cover all of its chunks.
+     */
+    QRect cellBounds() const;
+
+    /**
+     * Returns the rectangles of the chunks that hold cells, ordered by rows
+     * from top to bottom. Used for storing infinite layers.
+     */
+    QVector<QRect> chunkRects() const;
+
     /**
      * Calculates the region of cells in this tile layer for which the given
      * \a condition returns true.
@@ -139,6 +467,30 @@ public:
     template<typename Condition>
     QRegion region(Condition condition) const;
 
+    /**
+     * Calculates the mask of cells in this tile layer for which the given
+     * \a condition returns true. Unlike a QRegion, the mask stays cheap to
+     * combine with other masks no matter how fragmented it is.
+     */
+    template<typename Condition>
+    TileMask mask(Condition condition) const;
+
+    /**
+     * Returns the cells that are equal to the given \a cell. Unlike mask()
+     * with a condition, only the chunks containing the tile of the cell are
+     * looked at (see chunksWithTile()).
+     */
+    TileMask cellMask(const Cell &cell) const;
+
+    /**
+     * Returns the positions of the chunks that contain the given \a tile.
+     *
+     * The tiles in each chunk are indexed when this is first needed. From
+     * then on setCell() keeps the index up to date, until the cells are
+     * moved around in bulk, like by resize() or flip().
+     */
+    QList<QPoint> chunksWithTile(const Tile *tile) const;
+
     /**
      * Calculates the region occupied by the tiles of this layer. Similar to
      * Layer::bounds(), but leaves out the regions without tiles.
@@ -146,12 +498,18 @@ public:
     QRegion region() const;
 
     /**
-     * Returns a read-only reference to the cell at the given coordinates. The
-     * coordinates have to be within this layer.
+     * Calculates the mask of the cells that have a tile. This is the same as
+     * region(), but doesn't need to build a QRegion.
+     */
+    TileMask mask() const;
+
+    /**
+     * Returns the cell at the given coordinates. The coordinates have to be
+     * within this layer, unless it is infinite.
      */
-    const Cell &cellAt(int x, int y) const;
+    Cell cellAt(int x, int y) const;
 
-    const Cell &cellAt(const QPoint &point) const;
+    Cell cellAt(const QPoint &point) const;
 
     /**
      * Sets the cell at the given coordinates.
@@ -169,11 +527,21 @@ public:
 
     /**
      * Merges the given \a layer onto this layer at position \a pos. Parts that
-     * fall outside of this layer will be lost and empty tiles in the given
+     * fall outside of the cellArea() of this layer will be lost and empty tiles in the given
      * layer will have no effect.
      */
     void merge(const QPoint &pos, const TileLayer *layer);
 
+    /**
+     * Copies the non-empty cells within \a area of the \a source layer to
+     * this layer, placing the top-left of \a area at \a pos. Parts that fall
+     * outside of this layer are ignored and empty cells have no effect.
+     *
+     * Returns the number of cells that were copied.
+     */
+    int mergeCells(const QPoint &pos, const TileLayer *source,
+                   const QRect &area);
+
     /**
      * Removes all cells in the specified region.
      */
@@ -204,7 +572,9 @@ public:
     void rotate(RotateDirection direction);
 
     /**
-     * Computes and returns the set of tilesets used by this tile layer.
+     * Returns the set of tilesets used by this tile layer. The number of
+     * cells using each tileset is kept up to date while editing, so this
+     * doesn't need to look at the cells.
      */
     QSet<SharedTileset> usedTilesets() const override;
 
@@ -258,6 +628,30 @@ public:
      */
     QRegion computeDiffRegion(const TileLayer *other) const;
 
+    /**
+     * Returns the cells where this tile layer and the given tile layer are
+     * different, like computeDiffRegion(). Cheaper to build than a region
+     * when the difference is fragmented.
+     */
+    TileMask computeDiffMask(const TileLayer *other) const;
+
+    /**
+     * Returns the current change generation of this layer. It moves forward
+     * with each change to the cells, so that consumers can remember it and
+     * later ask for what changed since with changesSince().
+     */
+    unsigned changeGeneration() const { loadUnlessCompressed(); return mGeneration; }
+
+    /**
+     * Returns the cells that may have changed since the given change
+     * \a generation, at chunk granularity. When the layer was resized,
+     * flipped, rotated or offset since then, the whole layer is returned.
+     * Like mask(), the result is in map coordinates.
+     *
+     * Changes made through the non-const iterators are not tracked.
+     */
+    TileMask changesSince(unsigned generation) const;
+
     /**
      * Returns true if all tiles in the layer are empty.
      */
@@ -265,72 +659,211 @@ public:
 
     virtual Layer *clone() const override;
 
-    // Enable easy iteration over cells with range-based for
-    QVector<Cell>::iterator begin() { return mGrid.begin(); }
-    QVector<Cell>::iterator end() { return mGrid.end(); }
-    QVector<Cell>::const_iterator begin() const { return mGrid.begin(); }
-    QVector<Cell>::const_iterator end() const { return mGrid.end(); }
+    qint64 memoryUsage() const override;
+
+    /**
+     * Returns the approximate number of bytes used by the cells of this
+     * layer. Cells that haven't been loaded yet are not counted, and chunks
+     * shared with copies of this layer are counted for each copy. Compressed
+     * cells are counted at their compressed size.
+     */
+    qint64 cellMemoryUsage() const;
+
+    /**
+     * Returns the chunks of this layer, indexed by chunk coordinates.
+     */
+    const ChunkHash &chunks() const { load(); return mChunks; }
+
+    /**
+     * Returns the chunk containing the cell at the given coordinates, or
+     * nullptr when that area of the layer only contains empty cells.
+     *
+     * Allows renderers to skip over empty areas of sparse layers.
+     */
+    const Chunk *findChunk(int x, int y) const;
+
+    typedef ChunkCellIterator const_iterator;
+
+    // Enable easy iteration over cells with range-based for. The cells are
+    // returned by value, since packed chunks don't store Cell instances. Use
+    // setCell() to change them.
+    const_iterator begin() const { load(); return const_iterator(mChunks.constBegin()); }
+    const_iterator end() const { load(); return const_iterator(mChunks.constEnd()); }
+    const_iterator constBegin() const { return begin(); }
+    const_iterator constEnd() const { return end(); }
 
 protected:
     TileLayer *initializeClone(TileLayer *clone) const;
 
 private:
+    void loadCells() const;
+    void loadUnlessCompressed() const { if (!mCompressed) load(); }
+    void decompressChunks(const CompressedChunks &compressed);
+
+    Chunk &chunk(int x, int y);
+
+    static void setCell(ChunkHash &chunks, int x, int y, const Cell &cell);
+
+    void clearOutsideBounds();
+
+    void beginBulkEdit();
+    void endBulkEdit();
+
+    void updateTilesetUseCounts(const Cell &oldCell, const Cell &newCell);
+    void recomputeTilesetUseCounts();
+
+    void buildTileIndex() const;
+    void updateTileIndex(const QPoint &chunkPos,
+                         const Cell &oldCell, const Cell &newCell);
+    QSet<QPoint> chunksWithTileset(const Tileset *tileset) const;
+
+    void markChunkChanged(const QPoint &chunkPos);
+    void markAllChanged();
+
     QSize mMaxTileSize;
     QMargins mOffsetMargins;
-    QVector<Cell> mGrid;
+
+    // State of a bulk edit, see BulkEdit
+    int mBulkEditDepth;
+    bool mDrawMarginsChanged;
+    const Tile *mLastTile;
+    bool mLastFlippedAntiDiagonally;
+
+    // Change tracking, see changesSince()
+    unsigned mGeneration;
+    unsigned mStructureGeneration;
+    QPoint mLastChangedChunk;
+    bool mHasLastChangedChunk;
+
+    ChunkHash mChunks;
+    bool mCompressed;
+    qint64 mCompressedSize;
+    QHash<Tileset*, int> mTilesetUseCounts;
+    QHash<QPoint, unsigned> mChunkGenerations;
+
+    // The number of cells using each tile per chunk, see chunksWithTile()
+    mutable QHash<const Tile*, QHash<QPoint, int>> mTileIndex;
+    mutable bool mTileIndexValid;
+    mutable CellLoader mCellLoader;
 };
 
 
 template<typename Condition>
 QRegion TileLayer::region(Condition condition) const
 {
-    QRegion region;
-
-    for (int y = 0; y < mHeight; ++y) {
-        for (int x = 0; x < mWidth; ++x) {
-            if (condition(cellAt(x, y))) {
-                const int rangeStart = x;
-                for (++x; x <= mWidth; ++x) {
-                    if (x == mWidth || !condition(cellAt(x, y))) {
-                        const int rangeEnd = x;
-                        region += QRect(rangeStart + mX, y + mY,
-                                        rangeEnd - rangeStart, 1);
-                        break;
-                    }
+    return mask(condition).toRegion();
+}
+
+template<typename Condition>
+TileMask TileLayer::mask(Condition condition) const
+{
+    load();
+
+    TileMask mask;
+
+    // Areas without a chunk are empty, so after starting from the result
+    // for empty cells, only the chunks need to be checked for cells that
+    // differ from it
+    const QRect bounds = cellBounds();
+    const bool emptyMatches = condition(Cell::empty);
+    if (emptyMatches)
+        mask.addRect(bounds.translated(mX, mY));
+
+    for (auto it = mChunks.begin(), it_end = mChunks.end(); it != it_end; ++it) {
+        const Chunk &chunk = it.value();
+        const int chunkX = it.key().x() * CHUNK_SIZE;
+        const int chunkY = it.key().y() * CHUNK_SIZE;
+        const int startX = qMax(bounds.left(), chunkX);
+        const int endX = qMin(bounds.right() + 1, chunkX + CHUNK_SIZE);
+        const int endY = qMin(bounds.bottom() + 1, chunkY + CHUNK_SIZE);
+
+        for (int y = qMax(bounds.top(), chunkY); y < endY; ++y) {
+            int runStart = -1;
+
+            for (int x = startX; x <= endX; ++x) {
+                const bool differs = x < endX &&
+                        condition(chunk.cellAt(x & CHUNK_MASK,
+                                               y & CHUNK_MASK)) != emptyMatches;
+
+                if (differs) {
+                    if (runStart == -1)
+                        runStart = x;
+                } else if (runStart != -1) {
+                    mask.setSpan(runStart + mX, y + mY, x - runStart, !emptyMatches);
+                    runStart = -1;
                 }
             }
         }
     }
 
-    return region;
+    return mask;
 }
 
 template<typename Condition>
 bool TileLayer::hasCell(Condition condition) const
 {
-    for (const Cell &cell : mGrid)
-        if (condition(cell))
-            return true;
+    load();
+
+    const int chunksX = (mWidth + CHUNK_MASK) >> CHUNK_BITS;
+    const int chunksY = (mHeight + CHUNK_MASK) >> CHUNK_BITS;
+
+    // Any area not covered by a chunk holds empty cells
+    if ((isInfinite() || mChunks.size() < chunksX * chunksY) && condition(Cell::empty))
+        return true;
+
+    const QRect bounds = cellArea();
+
+    for (auto it = mChunks.begin(), it_end = mChunks.end(); it != it_end; ++it) {
+        const QRect chunkRect(it.key() * CHUNK_SIZE, QSize(CHUNK_SIZE, CHUNK_SIZE));
+        const QRect area = chunkRect & bounds;
+
+        for (int y = area.top(); y <= area.bottom(); ++y)
+            for (int x = area.left(); x <= area.right(); ++x)
+                if (condition(it.value().cellAt(x & CHUNK_MASK, y & CHUNK_MASK)))
+                    return true;
+    }
 
     return false;
 }
 
 inline QRegion TileLayer::region() const
 {
-    return region([] (const Cell &cell) { return !cell.isEmpty(); });
+    return mask().toRegion();
+}
+
+inline TileMask TileLayer::mask() const
+{
+    return mask([] (const Cell &cell) { return !cell.isEmpty(); });
 }
 
-inline const Cell &TileLayer::cellAt(int x, int y) const
+inline Cell TileLayer::cellAt(int x, int y) const
 {
-    Q_ASSERT(contains(x, y));
-    return mGrid.at(x + y * mWidth);
+    Q_ASSERT(contains(x, y) || isInfinite());
+
+    if (const Chunk *chunk = findChunk(x, y))
+        return chunk->cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+
+    return Cell::empty;
 }
 
-inline const Cell &TileLayer::cellAt(const QPoint &point) const
+inline Cell TileLayer::cellAt(const QPoint &point) const
 {
     return cellAt(point.x(), point.y());
 }
 
+inline const Chunk *TileLayer::findChunk(int x, int y) const
+{
+    load();
+    auto it = mChunks.constFind(QPoint(x >> CHUNK_BITS, y >> CHUNK_BITS));
+    return it != mChunks.constEnd() ? &it.value() : nullptr;
+}
+
+inline Chunk &TileLayer::chunk(int x, int y)
+{
+    load();
+    return mChunks[QPoint(x >> CHUNK_BITS, y >> CHUNK_BITS)];
+}
+
 typedef QSharedPointer<TileLayer> SharedTileLayer;
 
 } // namespace Tiled
@@ -0,0 +1,464 @@
+/*
+ * tilelayerrendercache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tilelayerrendercache.h"
+
+#include "maprenderer.h"
+#include "tilemask.h"
+
+#include <QCache>
+#include <QPainter>
+
+#include <climits>
+#include <cmath>
+
+using namespace Tiled;
+
+// The size of the cached chunks, in device pixels
+static const int ChunkPixels = 256;
+
+namespace {
+
+struct SharedChunkKey
+{
+    const TileLayerRenderCache *cache;
+    QPoint chunk;
+
+    bool operator==(const SharedChunkKey &other) const
+    { return cache == other.cache && chunk == other.chunk; }
+};
+
+inline uint qHash(const SharedChunkKey &key, uint seed = 0) Q_DECL_NOTHROW
+{
+    return ::qHash(quintptr(key.cache), seed) ^ ::qHash(key.chunk, seed);
+}
+
+/**
+ * The chunks of all render caches, with their cost in kilobytes. The default
+ * limit of 256 MB fits 1024 chunks with 32-bit pixels.
+ */
+QCache<SharedChunkKey, QPixmap> &sharedChunks()
+{
+    static QCache<SharedChunkKey, QPixmap> chunks(256 * 1024);
+    return chunks;
+}
+
+int chunkCost(const QPixmap &pixmap)
+{
+    return int(qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8 / 1024);
+}
+
+} // anonymous namespace
+
+TileLayerRenderCache::TileLayerRenderCache()
+    : mScale(0)
+    , mPixelRatio(0)
+    , mNextTicket(1)
+    , mPreviousScale(0)
+{
+}
+
+TileLayerRenderCache::~TileLayerRenderCache()
+{
+    clearChunks();
+}
+
+/**
+ * Returns whether there are no chunks cached for the current scale.
+ */
+bool TileLayerRenderCache::isEmpty() const
+{
+    for (const QPoint &key : mChunkKeys)
+        if (chunk(key))
+            return false;
+    return true;
+}
+
+static void chunkRange(const QRectF &rect, qreal chunkSize,
+                       int &startX, int &startY, int &endX, int &endY)
+{
+    startX = int(std::floor(rect.left() / chunkSize));
+    startY = int(std::floor(rect.top() / chunkSize));
+    endX = int(std::floor(rect.right() / chunkSize));
+    endY = int(std::floor(rect.bottom() / chunkSize));
+}
+
+/**
+ * Drops the cached chunks overlapping with \a rect, which is given in the
+ * coordinates of the layer.
+ */
+void TileLayerRenderCache::invalidate(const QRectF &rect)
+{
+    int startX, startY, endX, endY;
+
+    // The previous chunks would show outdated content as well
+    if (!mPreviousChunks.isEmpty()) {
+        chunkRange(rect, ChunkPixels / mPreviousScale, startX, startY, endX, endY);
+        for (int y = startY; y <= endY; ++y)
+            for (int x = startX; x <= endX; ++x)
+                mPreviousChunks.remove(QPoint(x, y));
+    }
+
+    if (mScale <= 0)
+        return;
+
+    // Chunks that are being rendered are outdated and requested again
+    chunkRange(rect, ChunkPixels / mScale, startX, startY, endX, endY);
+    for (int y = startY; y <= endY; ++y) {
+        for (int x = startX; x <= endX; ++x) {
+            removeChunk(QPoint(x, y));
+            mPendingChunks.remove(QPoint(x, y));
+        }
+    }
+}
+
+/**
+ * Drops all cached chunks.
+ */
+void TileLayerRenderCache::clear()
+{
+    clearChunks();
+    mPendingChunks.clear();
+    mPreviousChunks.clear();
+}
+
+/**
+ * Draws the \a exposed part of the \a layer with the given \a painter,
+ * rendering the chunks that are not cached yet using \a renderer.
+ *
+ * The chunks are only used when the layer is drawn with uniform scaling.
+ * Otherwise, the layer is drawn directly.
+ */
+void TileLayerRenderCache::draw(QPainter *painter,
+                                const MapRenderer *renderer,
+                                const TileLayer *layer,
+                                const QRectF &exposed)
+{
+    draw(painter, [=] (QPainter *painter, const QRectF &rect) {
+        renderer->drawTileLayer(painter, layer, rect);
+    }, exposed);
+}
+
+/**
+ * Draws the \a exposed area with the given \a painter, rendering the chunks
+ * that are not cached yet using \a render.
+ */
+void TileLayerRenderCache::draw(QPainter *painter,
+                                const RenderFunction &render,
+                                const QRectF &exposed)
+{
+    if (!setScale(painter)) {
+        render(painter, exposed);
+        return;
+    }
+
+    // Only needed while drawing progressively
+    mPreviousChunks.clear();
+
+    const qreal scale = mScale;
+    const qreal pixelRatio = mPixelRatio;
+    const qreal chunkSize = ChunkPixels / scale;
+
+    const int startX = int(std::floor(exposed.left() / chunkSize));
+    const int startY = int(std::floor(exposed.top() / chunkSize));
+    const int endX = int(std::ceil(exposed.right() / chunkSize));
+    const int endY = int(std::ceil(exposed.bottom() / chunkSize));
+
+    for (int y = startY; y < endY; ++y) {
+        for (int x = startX; x < endX; ++x) {
+            const QPoint key(x, y);
+            const QRectF chunkRect(x * chunkSize, y * chunkSize,
+                                   chunkSize, chunkSize);
+
+            QPixmap pixmap;
+            if (const QPixmap *cached = chunk(key)) {
+                pixmap = *cached;
+            } else {
+                pixmap = renderChunk(render, chunkRect, scale, pixelRatio);
+                insertChunk(key, pixmap);
+            }
+
+            painter->drawPixmap(chunkRect, pixmap, QRectF(pixmap.rect()));
+        }
+    }
+}
+
+/**
+ * Draws the \a exposed area with the given \a painter, like draw(). Chunks
+ * that are not cached yet are passed to \a request instead of being
+ * rendered, unless they were already requested. Until they are inserted,
+ * the chunks cached at the previous scale are drawn in their place.
+ *
+ * Returns false without drawing anything when the painter doesn't use
+ * uniform scaling, in which case the area needs to be drawn directly.
+ */
+bool TileLayerRenderCache::drawProgressive(QPainter *painter,
+                                           const QRectF &exposed,
+                                           const RequestFunction &request)
+{
+    if (!setScale(painter))
+        return false;
+
+    const qreal scale = mScale;
+    const qreal pixelRatio = mPixelRatio;
+    const qreal chunkSize = ChunkPixels / scale;
+
+    const int startX = int(std::floor(exposed.left() / chunkSize));
+    const int startY = int(std::floor(exposed.top() / chunkSize));
+    const int endX = int(std::ceil(exposed.right() / chunkSize));
+    const int endY = int(std::ceil(exposed.bottom() / chunkSize));
+
+    for (int y = startY; y < endY; ++y) {
+        for (int x = startX; x < endX; ++x) {
+            const QPoint key(x, y);
+            const QRectF chunkRect(x * chunkSize, y * chunkSize,
+                                   chunkSize, chunkSize);
+
+            if (const QPixmap *pixmap = chunk(key)) {
+                painter->drawPixmap(chunkRect, *pixmap, QRectF(pixmap->rect()));
+                continue;
+            }
+
+            if (!mPendingChunks.contains(key)) {
+                const ChunkRequest chunkRequest {
+                    key, mNextTicket++, chunkRect, scale, pixelRatio
+                };
+                mPendingChunks.insert(key, chunkRequest.ticket);
+                request(chunkRequest);
+            }
+
+            drawPreviousChunks(painter, chunkRect & exposed);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Inserts the \a image rendered for the given \a request. Returns false
+ * when the chunk is no longer needed, because it was invalidated or the
+ * scale or device pixel ratio changed in the meantime.
+ */
+bool TileLayerRenderCache::insertChunk(const ChunkRequest &request,
+                                       const QImage &image)
+{
+    if (request.scale != mScale || request.pixelRatio != mPixelRatio)
+        return false;
+
+    auto it = mPendingChunks.find(request.key);
+    if (it == mPendingChunks.end() || it.value() != request.ticket)
+        return false;
+
+    mPendingChunks.erase(it);
+    insertChunk(request.key, QPixmap::fromImage(image));
+
+    // The previous chunks are no longer needed once all chunks are done
+    if (mPendingChunks.isEmpty())
+        mPreviousChunks.clear();
+
+    return true;
+}
+
+/**
+ * Forgets about the given \a request, so that the chunk is requested again
+ * when it is exposed.
+ */
+void TileLayerRenderCache::cancelRequest(const ChunkRequest &request)
+{
+    auto it = mPendingChunks.find(request.key);
+    if (it != mPendingChunks.end() && it.value() == request.ticket)
+        mPendingChunks.erase(it);
+}
+
+/**
+ * Renders the chunk of the given \a request into an image. Can be called
+ * on any thread, as long as \a render can.
+ */
+QImage TileLayerRenderCache::renderChunkImage(const RenderFunction &render,
+                                              const ChunkRequest &request)
+{
+    const int size = int(std::ceil(ChunkPixels * request.pixelRatio));
+
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.scale(request.scale * request.pixelRatio,
+                  request.scale * request.pixelRatio);
+    painter.translate(-request.rect.topLeft());
+
+    render(&painter, request.rect);
+
+    return image;
+}
+
+/**
+ * Takes over the scale at which \a painter draws, along with the device
+ * pixel ratio of its device, which changes when a window moves to a screen
+ * with a different resolution. When either changed, the chunks are dropped
+ * or, while there are requests, kept for drawing in place of the chunks at
+ * the new scale.
+ *
+ * Returns false when the painter doesn't use uniform scaling.
+ */
+bool TileLayerRenderCache::setScale(QPainter *painter)
+{
+    const QTransform transform = painter->worldTransform();
+
+    if (transform.type() > QTransform::TxScale ||
+            transform.m11() <= 0 || transform.m11() != transform.m22())
+        return false;
+
+    const qreal scale = transform.m11();
+    const qreal pixelRatio = painter->device()->devicePixelRatio();
+    if (scale == mScale && pixelRatio == mPixelRatio)
+        return true;
+
+    // Keeps the chunks that are complete, when there is no better choice
+    // from an earlier scale change already
+    if (!mPendingChunks.isEmpty() || mPreviousChunks.isEmpty()) {
+        mPreviousChunks.clear();
+        mPreviousScale = mScale;
+        for (const QPoint &key : mChunkKeys)
+            if (const QPixmap *pixmap = chunk(key))
+                mPreviousChunks.insert(key, *pixmap);
+    }
+
+    clearChunks();
+    mPendingChunks.clear();
+    mScale = scale;
+    mPixelRatio = pixelRatio;
+    return true;
+}
+
+/**
+ * Draws the part of the chunks cached at the previous scale that overlaps
+ * with \a rect.
+ */
+void TileLayerRenderCache::drawPreviousChunks(QPainter *painter,
+                                              const QRectF &rect) const
+{
+    if (mPreviousChunks.isEmpty() || rect.isEmpty())
+        return;
+
+    const qreal chunkSize = ChunkPixels / mPreviousScale;
+
+    auto drawChunk = [&] (const QPoint &key, const QPixmap &pixmap) {
+        const QRectF chunkRect(key.x() * chunkSize, key.y() * chunkSize,
+                               chunkSize, chunkSize);
+        const QRectF target = chunkRect & rect;
+        if (target.isEmpty())
+            return;
+
+        const qreal pixelsPerUnit = pixmap.width() / chunkSize;
+        const QRectF source((target.topLeft() - chunkRect.topLeft()) * pixelsPerUnit,
+                            target.size() * pixelsPerUnit);
+
+        painter->drawPixmap(target, pixmap, source);
+    };
+
+    int startX, startY, endX, endY;
+    chunkRange(rect, chunkSize, startX, startY, endX, endY);
+
+    // When zoomed out far, there may be fewer previous chunks than chunks
+    // in range
+    const qint64 chunksInRange = qint64(endX - startX + 1) * (endY - startY + 1);
+    if (chunksInRange > mPreviousChunks.size()) {
+        for (auto it = mPreviousChunks.constBegin(); it != mPreviousChunks.constEnd(); ++it)
+            drawChunk(it.key(), it.value());
+        return;
+    }
+
+    for (int y = startY; y <= endY; ++y) {
+        for (int x = startX; x <= endX; ++x) {
+            auto it = mPreviousChunks.constFind(QPoint(x, y));
+            if (it != mPreviousChunks.constEnd())
+                drawChunk(it.key(), it.value());
+        }
+    }
+}
+
+QPixmap TileLayerRenderCache::renderChunk(const RenderFunction &render,
+                                          const QRectF &rect,
+                                          qreal scale,
+                                          qreal pixelRatio) const
+{
+    const int size = int(std::ceil(ChunkPixels * pixelRatio));
+
+    QPixmap pixmap(size, size);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.scale(scale * pixelRatio, scale * pixelRatio);
+    painter.translate(-rect.topLeft());
+
+    render(&painter, rect);
+
+    return pixmap;
+}
+
+/**
+ * Sets the amount of memory all render caches together may use for their
+ * chunks. When it is exceeded, the least recently drawn chunks are dropped.
+ */
+void TileLayerRenderCache::setMemoryLimit(qint64 bytes)
+{
+    sharedChunks().setMaxCost(int(qBound<qint64>(0, bytes / 1024, INT_MAX)));
+}
+
+qint64 TileLayerRenderCache::memoryLimit()
+{
+    return qint64(sharedChunks().maxCost()) * 1024;
+}
+
+QPixmap *TileLayerRenderCache::chunk(const QPoint &key) const
+{
+    return sharedChunks().object(SharedChunkKey { this, key });
+}
+
+void TileLayerRenderCache::insertChunk(const QPoint &key, const QPixmap &pixmap)
+{
+    // A chunk larger than the limit is not inserted at all
+    if (sharedChunks().insert(SharedChunkKey { this, key },
+                              new QPixmap(pixmap), chunkCost(pixmap)))
+        mChunkKeys.insert(key);
+}
+
+void TileLayerRenderCache::removeChunk(const QPoint &key)
+{
+    if (mChunkKeys.remove(key))
+        sharedChunks().remove(SharedChunkKey { this, key });
+}
+
+void TileLayerRenderCache::clearChunks()
+{
+    QCache<SharedChunkKey, QPixmap> &chunks = sharedChunks();
+    for (const QPoint &key : mChunkKeys)
+        chunks.remove(SharedChunkKey { this, key });
+    mChunkKeys.clear();
+}
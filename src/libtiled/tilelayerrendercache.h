@@ -0,0 +1,156 @@
+/*
+ * tilelayerrendercache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_TILELAYERRENDERCACHE_H
+#define TILED_TILELAYERRENDERCACHE_H
+
+#include "tiled_global.h"
+
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QPoint>
+#include <QRectF>
+#include <QSet>
+
+#include <functional>
+
+class QPainter;
+
+namespace Tiled {
+
+class MapRenderer;
+class TileLayer;
+
+/**
+ * Caches a rendered tile layer in square chunks of device pixels, for the
+ * scale and device pixel ratio at which it was last drawn. Repaints that
+ * don't change the layer, like scrolling, only need to draw the cached
+ * chunks.
+ *
+ * The cache doesn't notice changes to the layer by itself. The changed
+ * areas need to be invalidated.
+ *
+ * Instead of a single layer, the cache can also be used for anything drawn
+ * by a RenderFunction, like several layers composited together.
+ *
+ * When drawing progressively, missing chunks are not rendered right away.
+ * Instead, they are requested, so that they can be rendered on another
+ * thread and inserted once they are done. Until then, the chunks cached for
+ * the previous scale are drawn in their place.
+ *
+ * The chunks of all caches share a single memory budget, so that the least
+ * recently drawn chunks are dropped first, regardless of the view or map
+ * they belong to. See setMemoryLimit().
+ */
+class TILEDSHARED_EXPORT TileLayerRenderCache
+{
+public:
+    /**
+     * Draws the given \a rect using \a painter.
+     */
+    typedef std::function<void (QPainter *painter, const QRectF &rect)> RenderFunction;
+
+    /**
+     * A chunk that was missing when drawing progressively. The ticket tells
+     * it apart from earlier requests for the same chunk.
+     */
+    struct ChunkRequest
+    {
+        QPoint key;
+        unsigned ticket;
+        QRectF rect;        // in the coordinates of the layer
+        qreal scale;
+        qreal pixelRatio;
+    };
+
+    typedef std::function<void (const ChunkRequest &request)> RequestFunction;
+
+    TileLayerRenderCache();
+    ~TileLayerRenderCache();
+
+    bool isEmpty() const;
+
+    void invalidate(const QRectF &rect);
+    void clear();
+
+    void draw(QPainter *painter,
+              const MapRenderer *renderer,
+              const TileLayer *layer,
+              const QRectF &exposed);
+
+    void draw(QPainter *painter,
+              const RenderFunction &render,
+              const QRectF &exposed);
+
+    bool drawProgressive(QPainter *painter,
+                         const QRectF &exposed,
+                         const RequestFunction &request);
+
+    bool insertChunk(const ChunkRequest &request, const QImage &image);
+    void cancelRequest(const ChunkRequest &request);
+
+    static QImage renderChunkImage(const RenderFunction &render,
+                                   const ChunkRequest &request);
+
+    static void setMemoryLimit(qint64 bytes);
+    static qint64 memoryLimit();
+
+private:
+    Q_DISABLE_COPY(TileLayerRenderCache)
+
+    QPixmap *chunk(const QPoint &key) const;
+    void insertChunk(const QPoint &key, const QPixmap &pixmap);
+    void removeChunk(const QPoint &key);
+    void clearChunks();
+
+    bool setScale(QPainter *painter);
+    void drawPreviousChunks(QPainter *painter, const QRectF &rect) const;
+
+    QPixmap renderChunk(const RenderFunction &render,
+                        const QRectF &rect,
+                        qreal scale,
+                        qreal pixelRatio) const;
+
+    // The keys of the chunks in the shared cache, some of which may have
+    // been dropped to stay within the memory limit
+    QSet<QPoint> mChunkKeys;
+    qreal mScale;
+    qreal mPixelRatio;
+
+    QHash<QPoint, unsigned> mPendingChunks;     // tickets of the requests
+    unsigned mNextTicket;
+
+    // The chunks at the previous scale, while drawing progressively
+    QHash<QPoint, QPixmap> mPreviousChunks;
+    qreal mPreviousScale;
+};
+
+} // namespace Tiled
+
+#endif // TILED_TILELAYERRENDERCACHE_H
@@ -0,0 +1,389 @@
+/*
+ * tilemask.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tilemask.h"
+
+#include <QMap>
+#include <QVector>
+
+#include <algorithm>
+#include <climits>
+
+using namespace Tiled;
+
+TileMask::TileMask(const QRect &rect)
+{
+    addRect(rect);
+}
+
+TileMask::TileMask(const QRegion &region)
+{
+    addRegion(region);
+}
+
+bool TileMask::Block::isEmpty() const
+{
+    for (Row row : rows)
+        if (row)
+            return false;
+
+    return true;
+}
+
+bool TileMask::contains(int x, int y) const
+{
+    auto it = mBlocks.constFind(QPoint(x >> BLOCK_BITS, y >> BLOCK_BITS));
+    if (it == mBlocks.constEnd())
+        return false;
+
+    return it.value().rows[y & BLOCK_MASK] & (1 << (x & BLOCK_MASK));
+}
+
+/**
+ * Returns whether any of the positions within \a rect are set.
+ */
+bool TileMask::intersects(const QRect &rect) const
+{
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        const int blockY = y >> BLOCK_BITS;
+        const int rowIndex = y & BLOCK_MASK;
+
+        int x = rect.x();
+        int width = rect.width();
+
+        while (width > 0) {
+            const int offset = x & BLOCK_MASK;
+            const int count = qMin(width, BLOCK_SIZE - offset);
+            const Row bits = Row(((1 << count) - 1) << offset);
+
+            auto it = mBlocks.constFind(QPoint(x >> BLOCK_BITS, blockY));
+            if (it != mBlocks.constEnd() && (it.value().rows[rowIndex] & bits))
+                return true;
+
+            x += count;
+            width -= count;
+        }
+    }
+
+    return false;
+}
+
+QRect TileMask::boundingRect() const
+{
+    int left = INT_MAX;
+    int top = INT_MAX;
+    int right = INT_MIN;
+    int bottom = INT_MIN;
+
+    for (auto it = mBlocks.begin(), it_end = mBlocks.end(); it != it_end; ++it) {
+        const int blockX = it.key().x() * BLOCK_SIZE;
+        const int blockY = it.key().y() * BLOCK_SIZE;
+        const Block &block = it.value();
+
+        for (int y = 0; y < BLOCK_SIZE; ++y) {
+            const Row row = block.rows[y];
+            if (!row)
+                continue;
+
+            int first = 0;
+            while (!(row & (1 << first)))
+                ++first;
+
+            int last = BLOCK_MASK;
+            while (!(row & (1 << last)))
+                --last;
+
+            left = qMin(left, blockX + first);
+            right = qMax(right, blockX + last);
+            top = qMin(top, blockY + y);
+            bottom = qMax(bottom, blockY + y);
+        }
+    }
+
+    if (left > right)
+        return QRect();
+
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+void TileMask::setCell(int x, int y, bool set)
+{
+    setSpan(x, y, 1, set);
+}
+
+/**
+ * Sets or clears the \a width positions starting at \a x on row \a y.
+ */
+void TileMask::setSpan(int x, int y, int width, bool set)
+{
+    const int blockY = y >> BLOCK_BITS;
+    const int rowIndex = y & BLOCK_MASK;
+
+    while (width > 0) {
+        const int offset = x & BLOCK_MASK;
+        const int count = qMin(width, BLOCK_SIZE - offset);
+        const Row bits = Row(((1 << count) - 1) << offset);
+        const QPoint blockPos(x >> BLOCK_BITS, blockY);
+
+        if (set) {
+            mBlocks[blockPos].rows[rowIndex] |= bits;
+        } else {
+            auto it = mBlocks.find(blockPos);
+            if (it != mBlocks.end()) {
+                it.value().rows[rowIndex] &= ~bits;
+                if (it.value().isEmpty())
+                    mBlocks.erase(it);
+            }
+        }
+
+        x += count;
+        width -= count;
+    }
+}
+
+void TileMask::addRect(const QRect &rect)
+{
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        setSpan(rect.x(), y, rect.width());
+}
+
+void TileMask::addRegion(const QRegion &region)
+{
+    for (const QRect &rect : region.rects())
+        addRect(rect);
+}
+
+TileMask &TileMask::operator+=(const TileMask &other)
+{
+    for (auto it = other.mBlocks.begin(), it_end = other.mBlocks.end(); it != it_end; ++it) {
+        Block &block = mBlocks[it.key()];
+        for (int y = 0; y < BLOCK_SIZE; ++y)
+            block.rows[y] |= it.value().rows[y];
+    }
+
+    return *this;
+}
+
+TileMask &TileMask::operator-=(const TileMask &other)
+{
+    for (auto it = other.mBlocks.begin(), it_end = other.mBlocks.end(); it != it_end; ++it) {
+        auto own = mBlocks.find(it.key());
+        if (own == mBlocks.end())
+            continue;
+
+        Block &block = own.value();
+        for (int y = 0; y < BLOCK_SIZE; ++y)
+            block.rows[y] &= ~it.value().rows[y];
+
+        if (block.isEmpty())
+            mBlocks.erase(own);
+    }
+
+    return *this;
+}
+
+TileMask &TileMask::operator&=(const TileMask &other)
+{
+    auto it = mBlocks.begin();
+    while (it != mBlocks.end()) {
+        auto otherIt = other.mBlocks.constFind(it.key());
+        if (otherIt == other.mBlocks.constEnd()) {
+            it = mBlocks.erase(it);
+            continue;
+        }
+
+        Block &block = it.value();
+        for (int y = 0; y < BLOCK_SIZE; ++y)
+            block.rows[y] &= otherIt.value().rows[y];
+
+        if (block.isEmpty())
+            it = mBlocks.erase(it);
+        else
+            ++it;
+    }
+
+    return *this;
+}
+
+/**
+ * Toggles the positions set in \a other. Applying the same mask twice
+ * restores the original mask.
+ */
+TileMask &TileMask::operator^=(const TileMask &other)
+{
+    for (auto it = other.mBlocks.begin(), it_end = other.mBlocks.end(); it != it_end; ++it) {
+        auto own = mBlocks.find(it.key());
+        if (own == mBlocks.end()) {
+            mBlocks.insert(it.key(), it.value());
+            continue;
+        }
+
+        Block &block = own.value();
+        for (int y = 0; y < BLOCK_SIZE; ++y)
+            block.rows[y] ^= it.value().rows[y];
+
+        if (block.isEmpty())
+            mBlocks.erase(own);
+    }
+
+    return *this;
+}
+
+bool TileMask::operator==(const TileMask &other) const
+{
+    return mBlocks == other.mBlocks;
+}
+
+TileMask TileMask::translated(const QPoint &offset) const
+{
+    TileMask result;
+
+    // Block-aligned offsets only require moving the blocks around
+    if ((offset.x() & BLOCK_MASK) == 0 && (offset.y() & BLOCK_MASK) == 0) {
+        const QPoint blockOffset(offset.x() >> BLOCK_BITS,
+                                 offset.y() >> BLOCK_BITS);
+
+        for (auto it = mBlocks.begin(), it_end = mBlocks.end(); it != it_end; ++it)
+            result.mBlocks.insert(it.key() + blockOffset, it.value());
+
+        return result;
+    }
+
+    for (auto it = mBlocks.begin(), it_end = mBlocks.end(); it != it_end; ++it) {
+        const int blockX = it.key().x() * BLOCK_SIZE + offset.x();
+        const int blockY = it.key().y() * BLOCK_SIZE + offset.y();
+        const Block &block = it.value();
+
+        for (int y = 0; y < BLOCK_SIZE; ++y) {
+            const Row row = block.rows[y];
+            int x = 0;
+
+            while (x < BLOCK_SIZE) {
+                if (!(row & (1 << x))) {
+                    ++x;
+                    continue;
+                }
+
+                const int start = x;
+                while (x < BLOCK_SIZE && (row & (1 << x)))
+                    ++x;
+
+                result.setSpan(blockX + start, blockY + y, x - start);
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Returns the mask as a region. The region is set up at once from its
+ * sorted rectangles, with rows that have identical spans merged into bands.
+ */
+QRegion TileMask::toRegion() const
+{
+    // Group the block columns by block row, so that the spans can be
+    // produced in sorted order
+    QMap<int, QVector<int>> columnsPerRow;
+    for (auto it = mBlocks.begin(), it_end = mBlocks.end(); it != it_end; ++it)
+        columnsPerRow[it.key().y()].append(it.key().x());
+
+    QVector<QRect> rects;
+    QVector<QRect> spans;
+    int bandStart = 0;
+
+    for (auto blockRow = columnsPerRow.begin(); blockRow != columnsPerRow.end(); ++blockRow) {
+        QVector<int> &columns = blockRow.value();
+        std::sort(columns.begin(), columns.end());
+
+        QVector<const Block*> blocks;
+        blocks.reserve(columns.size());
+        for (int blockX : columns)
+            blocks.append(&mBlocks.constFind(QPoint(blockX, blockRow.key())).value());
+
+        for (int rowIndex = 0; rowIndex < BLOCK_SIZE; ++rowIndex) {
+            const int y = blockRow.key() * BLOCK_SIZE + rowIndex;
+
+            spans.clear();
+            int runStart = 0;
+            int runEnd = 0;
+            bool inRun = false;
+
+            for (int i = 0; i < columns.size(); ++i) {
+                const Row row = blocks.at(i)->rows[rowIndex];
+                const int blockX = columns.at(i) * BLOCK_SIZE;
+
+                // A run only continues into directly adjacent blocks
+                if (inRun && runEnd != blockX) {
+                    spans.append(QRect(runStart, y, runEnd - runStart, 1));
+                    inRun = false;
+                }
+
+                for (int x = 0; x < BLOCK_SIZE; ++x) {
+                    if (row & (1 << x)) {
+                        if (!inRun) {
+                            runStart = blockX + x;
+                            inRun = true;
+                        }
+                        runEnd = blockX + x + 1;
+                    } else if (inRun) {
+                        spans.append(QRect(runStart, y, runEnd - runStart, 1));
+                        inRun = false;
+                    }
+                }
+            }
+
+            if (inRun)
+                spans.append(QRect(runStart, y, runEnd - runStart, 1));
+
+            if (spans.isEmpty())
+                continue;
+
+            bool extendsBand = rects.size() - bandStart == spans.size() &&
+                    rects.at(bandStart).bottom() == y - 1;
+
+            for (int k = 0; extendsBand && k < spans.size(); ++k) {
+                const QRect &bandRect = rects.at(bandStart + k);
+                extendsBand = bandRect.x() == spans.at(k).x() &&
+                        bandRect.width() == spans.at(k).width();
+            }
+
+            if (extendsBand) {
+                for (int k = 0; k < spans.size(); ++k)
+                    rects[bandStart + k].setBottom(y);
+            } else {
+                bandStart = rects.size();
+                rects += spans;
+            }
+        }
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
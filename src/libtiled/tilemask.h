@@ -0,0 +1,134 @@
+/*
+ * tilemask.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_TILEMASK_H
+#define TILED_TILEMASK_H
+
+#include "tiled_global.h"
+
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+
+#include <cstring>
+
+inline uint qHash(const QPoint &key, uint seed = 0) Q_DECL_NOTHROW
+{
+    uint h1 = qHash(key.x(), seed);
+    uint h2 = qHash(key.y(), seed);
+    return ((h1 << 16) | (h1 >> 16)) ^ h2 ^ seed;
+}
+
+namespace Tiled {
+
+/**
+ * A set of tile positions, stored as a bit mask.
+ *
+ * The mask is divided into blocks of 16x16 bits, which are only allocated
+ * for areas that contain set positions. Compared to QRegion, the cost of
+ * combining masks doesn't depend on how fragmented they are, which makes
+ * this class suitable for selections with many holes.
+ *
+ * Use toRegion() to get a QRegion, for example for display.
+ */
+class TILEDSHARED_EXPORT TileMask
+{
+public:
+    TileMask() {}
+    explicit TileMask(const QRect &rect);
+    explicit TileMask(const QRegion &region);
+
+    bool isEmpty() const { return mBlocks.isEmpty(); }
+    void clear() { mBlocks.clear(); }
+
+    bool contains(int x, int y) const;
+    bool contains(const QPoint &pos) const { return contains(pos.x(), pos.y()); }
+
+    bool intersects(const QRect &rect) const;
+
+    QRect boundingRect() const;
+
+    void setCell(int x, int y, bool set = true);
+    void setSpan(int x, int y, int width, bool set = true);
+    void addRect(const QRect &rect);
+    void addRegion(const QRegion &region);
+
+    TileMask &operator+=(const TileMask &other);
+    TileMask &operator-=(const TileMask &other);
+    TileMask &operator&=(const TileMask &other);
+    TileMask &operator^=(const TileMask &other);
+
+    TileMask operator+(const TileMask &other) const
+    { TileMask result(*this); result += other; return result; }
+    TileMask operator-(const TileMask &other) const
+    { TileMask result(*this); result -= other; return result; }
+    TileMask operator&(const TileMask &other) const
+    { TileMask result(*this); result &= other; return result; }
+    TileMask operator^(const TileMask &other) const
+    { TileMask result(*this); result ^= other; return result; }
+
+    bool operator==(const TileMask &other) const;
+    bool operator!=(const TileMask &other) const { return !(*this == other); }
+
+    TileMask translated(const QPoint &offset) const;
+
+    QRegion toRegion() const;
+
+    /**
+     * Returns the approximate number of bytes used by the blocks of this
+     * mask.
+     */
+    qint64 memoryUsage() const
+    { return qint64(mBlocks.size()) * (sizeof(QPoint) + sizeof(Block) + 2 * sizeof(void*)); }
+
+private:
+    static const int BLOCK_BITS = 4;
+    static const int BLOCK_SIZE = 1 << BLOCK_BITS;
+    static const int BLOCK_MASK = BLOCK_SIZE - 1;
+
+    typedef quint16 Row;
+
+    struct Block {
+        Block() { memset(rows, 0, sizeof(rows)); }
+
+        bool isEmpty() const;
+        bool operator==(const Block &other) const
+        { return memcmp(rows, other.rows, sizeof(rows)) == 0; }
+
+        Row rows[BLOCK_SIZE];
+    };
+
+    // Blocks are removed once none of their bits are set, so that equal
+    // masks have equal hashes
+    QHash<QPoint, Block> mBlocks;
+};
+
+} // namespace Tiled
+
+#endif // TILED_TILEMASK_H
@@ -28,24 +28,166 @@
  */
 
 #include "tileset.h"
+#include "colorkey.h"
+#include "imagecache.h"
+#include "memoryusage.h"
+#include "objectgroup.h"
 #include "tile.h"
 #include "terrain.h"
+#include "tracing.h"
 
-#include <QBitmap>
+#include <QGuiApplication>
+#include <QHash>
+#include <QImageReader>
+#include <QThread>
+
+#include <algorithm>
+#include <cstring>
 
 using namespace Tiled;
 
+/**
+ * Returns whether pixmaps can be created on the current thread, which is only
+ * the case on the main thread of a QGuiApplication.
+ */
+bool Tiled::canCreatePixmaps()
+{
+    const QCoreApplication *app = QCoreApplication::instance();
+    return qobject_cast<const QGuiApplication*>(app) &&
+            QThread::currentThread() == app->thread();
+}
+
+static bool imageDecodingEnabled = true;
+
+/**
+ * Sets whether images are decoded when loading tilesets and image layers.
+ *
+ * Tools that only convert the data of maps and tilesets can disable this,
+ * in which case only the size of tileset images is read from their file and
+ * tiles and image layers only remember their image source. Embedded images
+ * are still decoded, since they can't be referred to otherwise.
+ *
+ * Should be set before any files are loaded.
+ */
+void Tiled::setImageDecodingEnabled(bool enabled)
+{
+    imageDecodingEnabled = enabled;
+}
+
+bool Tiled::isImageDecodingEnabled()
+{
+    return imageDecodingEnabled;
+}
+
+/**
+ * Converts the tileset \a image to a pixmap, with the \a transparentColor
+ * masked out when it is valid.
+ */
+static QPixmap tilesetPixmap(const QImage &image, const QColor &transparentColor)
+{
+    return QPixmap::fromImage(applyColorKey(image, transparentColor));
+}
+
+/**
+ * Returns whether the images \a a and \a b, which are in the same 32-bit
+ * format, have the same pixels in the given \a rect.
+ */
+static bool samePixels(const QImage &a, const QImage &b, const QRect &rect)
+{
+    const int offset = rect.left() * 4;
+    const size_t bytes = size_t(rect.width()) * 4;
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+        if (std::memcmp(a.constScanLine(y) + offset, b.constScanLine(y) + offset, bytes) != 0)
+            return false;
+
+    return true;
+}
+
 Tileset::~Tileset()
 {
     qDeleteAll(mTiles);
     qDeleteAll(mTerrainTypes);
 }
 
+/**
+ * Returns a copy of this tileset, which can be used on another thread while
+ * this tileset is being changed. The copy has no file name and shares the
+ * images of this tileset. It never requests its image to be loaded.
+ */
+SharedTileset Tileset::clone() const
+{
+    SharedTileset c = create(mName, mTileWidth, mTileHeight,
+                             mTileSpacing, mMargin);
+    c->setProperties(properties());
+
+    c->mImageSource = mImageSource;
+    c->mImage = mImage;
+    c->mPendingImage = mPendingImage;
+    c->mTransparentColor = mTransparentColor;
+    c->mTileOffset = mTileOffset;
+    c->mImageWidth = mImageWidth;
+    c->mImageHeight = mImageHeight;
+    c->mColumnCount = mColumnCount;
+    c->mImageUnloaded = mImageUnloaded;
+    c->mImageRequested = true;
+
+    for (const Tile *tile : mTiles) {
+        Tile *tileClone = new Tile(tile->mImage, tile->mImageSource,
+                                   tile->mId, c.data());
+        tileClone->mImageRect = tile->mImageRect;
+        tileClone->mTerrain = tile->mTerrain;
+        tileClone->mProbability = tile->mProbability;
+        tileClone->mFrames = tile->mFrames;
+        tileClone->mCurrentFrameIndex = tile->mCurrentFrameIndex;
+        if (tile->mObjectGroup)
+            tileClone->mObjectGroup = static_cast<ObjectGroup*>(tile->mObjectGroup->clone());
+        tileClone->setProperties(tile->properties());
+
+        c->mTiles.append(tileClone);
+        if (tileClone->isAnimated())
+            c->mAnimatedTiles.insert(tileClone);
+        if (tileClone->hasMetadata())
+            c->mTilesWithMetadata.insert(tileClone);
+    }
+
+    for (const Terrain *terrain : mTerrainTypes) {
+        Terrain *terrainClone = new Terrain(terrain->mId, c.data(),
+                                            terrain->mName,
+                                            terrain->mImageTileId);
+        terrainClone->mTransitionDistance = terrain->mTransitionDistance;
+        terrainClone->setProperties(terrain->properties());
+        c->mTerrainTypes.append(terrainClone);
+    }
+
+    c->mTerrainConnectionCounts = mTerrainConnectionCounts;
+    c->mTerrainDistances = mTerrainDistances;
+    c->mTerrainDistancesDirty = mTerrainDistancesDirty;
+
+    return c;
+}
+
 Tile *Tileset::tileAt(int id) const
 {
     return (id < mTiles.size()) ? mTiles.at(id) : nullptr;
 }
 
+/**
+ * Returns the tiles that have properties, terrain, a probability, collision
+ * objects or animation frames, sorted by their ID. Writers use this to avoid
+ * visiting every tile of large tilesets with sparse metadata.
+ *
+ * \sa Tile::hasMetadata()
+ */
+QList<Tile*> Tileset::tilesWithMetadata() const
+{
+    QList<Tile*> tiles = mTilesWithMetadata.toList();
+    std::sort(tiles.begin(), tiles.end(), [] (const Tile *a, const Tile *b) {
+        return a->id() < b->id();
+    });
+    return tiles;
+}
+
 /**
  * Load this tileset from the given tileset \a image. This will replace
  * existing tile images in this tileset with new ones. If the new image
@@ -62,6 +204,103 @@ Tile *Tileset::tileAt(int id) const
  */
 bool Tileset::loadFromImage(const QImage &image,
                             const QString &fileName)
+{
+    TraceScope trace("Tileset::loadFromImage", fileName);
+
+    Q_ASSERT(tileWidth() > 0 && tileHeight() > 0);
+
+    if (image.isNull())
+        return false;
+
+    setImage(image);
+    for (QPixmap &flippedImage : mFlippedImages)
+        flippedImage = QPixmap();
+
+    mImageUnloaded = false;
+    mImageRequested = false;
+
+    prepareImage(image.size(), fileName);
+    return true;
+}
+
+/**
+ * Convenience override that loads the image from the given \a fileName.
+ *
+ * When image decoding is disabled, only the size of the image is read and
+ * the tiles are set up like prepareImage() does.
+ */
+bool Tileset::loadFromImage(const QString &fileName)
+{
+    if (imageDecodingEnabled)
+        return loadFromImage(ImageCache::loadImage(fileName), fileName);
+
+    const QSize imageSize = QImageReader(fileName).size();
+    if (!imageSize.isValid())
+        return false;
+
+    prepareImage(imageSize, fileName);
+    return true;
+}
+
+/**
+ * Replaces the tileset image with a changed version of the same image, for
+ * example when it was modified on disk.
+ *
+ * When the image still has the same size, only the tiles with changed
+ * pixels are updated. Otherwise, this does the same as loadFromImage().
+ *
+ * @param image        the changed image
+ * @param changedTiles the tiles whose image has changed are appended here
+ * @return <code>true</code> if loading was successful, otherwise
+ *         returns <code>false</code>
+ */
+bool Tileset::reloadFromImage(const QImage &image, QList<Tile*> *changedTiles)
+{
+    if (image.isNull())
+        return false;
+
+    if (mImage.isNull() || image.size() != QSize(mImageWidth, mImageHeight)) {
+        if (!loadFromImage(image, mImageSource))
+            return false;
+
+        changedTiles->append(mTiles);
+        return true;
+    }
+
+    // Compare the images with the transparent color applied
+    const QImage newPixels = applyColorKey(image, mTransparentColor)
+            .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QImage oldPixels = mImage.toImage()
+            .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QPixmap pixmap = QPixmap::fromImage(newPixels);
+
+    for (Tile *tile : mTiles) {
+        const QRect imageRect = tile->imageRect();
+        if (imageRect.isNull() || samePixels(oldPixels, newPixels, imageRect))
+            continue;
+
+        // Drops the images cached by the tile
+        tile->setImage(QPixmap());
+        tile->mImageRect = imageRect;
+
+        changedTiles->append(tile);
+    }
+
+    mImage = pixmap;
+    for (QPixmap &flippedImage : mFlippedImages)
+        flippedImage = QPixmap();
+
+    return true;
+}
+
+/**
+ * Sets up the tiles for a tileset image of the given \a imageSize, like
+ * loadFromImage() does, without needing the image itself. This allows the
+ * tiles to be referred to while the image is still being loaded.
+ *
+ * The tiles have no image until loadFromImage() is called.
+ */
+void Tileset::prepareImage(const QSize &imageSize, const QString &fileName)
 {
     const QSize tileSize = this->tileSize();
     const int margin = this->margin();
@@ -69,31 +308,22 @@ bool Tileset::loadFromImage(const QImage &image,
 
     Q_ASSERT(tileSize.width() > 0 && tileSize.height() > 0);
 
-    if (image.isNull())
-        return false;
-
-    const int stopWidth = image.width() - tileSize.width();
-    const int stopHeight = image.height() - tileSize.height();
+    const int stopWidth = imageSize.width() - tileSize.width();
+    const int stopHeight = imageSize.height() - tileSize.height();
 
     int oldTilesetSize = tileCount();
     int tileNum = 0;
 
+    // The tiles only reference their area of the tileset image. Their
+    // standalone images are created by Tile::image() when needed.
     for (int y = margin; y <= stopHeight; y += tileSize.height() + spacing) {
         for (int x = margin; x <= stopWidth; x += tileSize.width() + spacing) {
-            const QImage tileImage = image.copy(x, y, tileSize.width(), tileSize.height());
-            QPixmap tilePixmap = QPixmap::fromImage(tileImage);
-
-            if (mTransparentColor.isValid()) {
-                const QImage mask =
-                        tileImage.createMaskFromColor(mTransparentColor.rgb());
-                tilePixmap.setMask(QBitmap::fromImage(mask));
-            }
-
             if (tileNum < oldTilesetSize) {
-                mTiles.at(tileNum)->setImage(tilePixmap);
+                mTiles.at(tileNum)->setImage(QPixmap());
             } else {
-                mTiles.append(new Tile(tilePixmap, tileNum, this));
+                mTiles.append(new Tile(QPixmap(), tileNum, this));
             }
+            mTiles.at(tileNum)->mImageRect = QRect(QPoint(x, y), tileSize);
             ++tileNum;
         }
     }
@@ -106,28 +336,292 @@ bool Tileset::loadFromImage(const QImage &image,
         ++tileNum;
     }
 
-    mImageWidth = image.width();
-    mImageHeight = image.height();
+    mImageWidth = imageSize.width();
+    mImageHeight = imageSize.height();
     mColumnCount = columnCountForWidth(mImageWidth);
     mImageSource = fileName;
+    mFingerprintDirty = true;
+}
+
+/**
+ * Sets up the tiles like prepareImage(), but leaves the image unloaded, as
+ * if unloadImage() was called. The image is loaded from \a fileName when it
+ * is first needed.
+ */
+void Tileset::prepareUnloadedImage(const QSize &imageSize, const QString &fileName)
+{
+    prepareImage(imageSize, fileName);
+
+    mImage = QPixmap();
+    mPendingImage = QImage();
+    for (QPixmap &flippedImage : mFlippedImages)
+        flippedImage = QPixmap();
+
+    mImageUnloaded = true;
+    mImageRequested = false;
+}
+
+const QPixmap &Tileset::image() const
+{
+    mImageUsed.storeRelease(1);
+
+    if (!mPendingImage.isNull() && canCreatePixmaps()) {
+        mImage = tilesetPixmap(mPendingImage, mTransparentColor);
+        mPendingImage = QImage();
+    }
+
+    if (mImageUnloaded && !mImageRequested) {
+        mImageRequested = true;
+
+        if (mImageRequestHandler)
+            mImageRequestHandler(*this);
+        else
+            const_cast<Tileset*>(this)->restoreImage(ImageCache::loadImage(mImageSource));
+    }
+
+    return mImage;
+}
+
+const QPixmap &Tileset::atlasImage() const
+{
+    static const QPixmap noAtlas;
+    if (!mImageSource.isEmpty())
+        return noAtlas;
+
+    return mAtlas.image(mTiles);
+}
+
+/**
+ * Drops the tileset image and the images cached by the tiles, to free up
+ * memory. The image is loaded again from its source when it is needed.
+ *
+ * Does nothing when this tileset has no external tileset image.
+ *
+ * \sa setImageRequestHandler()
+ */
+void Tileset::unloadImage()
+{
+    if (mImageSource.isEmpty() || (mImage.isNull() && mPendingImage.isNull()))
+        return;
+
+    mImage = QPixmap();
+    mPendingImage = QImage();
+    for (QPixmap &flippedImage : mFlippedImages)
+        flippedImage = QPixmap();
+
+    for (Tile *tile : mTiles) {
+        const QRect imageRect = tile->imageRect();
+        if (imageRect.isNull())
+            continue;
+
+        // Drops the images cached by the tile
+        tile->setImage(QPixmap());
+        tile->mImageRect = imageRect;
+    }
+
+    mImageUnloaded = true;
+    mImageRequested = false;
+}
+
+/**
+ * Restores the tileset image after unloadImage(), using the given \a image
+ * that was loaded from the image source.
+ *
+ * When the image no longer has the same size, this does the same as
+ * loadFromImage().
+ *
+ * @return <code>true</code> if the image was restored, otherwise
+ *         returns <code>false</code>
+ */
+bool Tileset::restoreImage(const QImage &image)
+{
+    if (!mImageUnloaded)
+        return false;
+
+    if (image.size() != QSize(mImageWidth, mImageHeight))
+        return loadFromImage(image, mImageSource);
+
+    setImage(image);
+    mImageUnloaded = false;
+    mImageRequested = false;
     return true;
 }
 
+/**
+ * Returns the approximate number of bytes used by the tileset image.
+ */
+qint64 Tileset::imageMemory() const
+{
+    return Tiled::memoryUsage(mImage) + Tiled::memoryUsage(mPendingImage);
+}
+
+/**
+ * Returns the tileset image as a QImage, with the transparent color masked
+ * out. Unlike image(), this can be used on any thread.
+ */
+QImage Tileset::imageData() const
+{
+    if (!mPendingImage.isNull())
+        return applyColorKey(mPendingImage, mTransparentColor);
+
+    return mImage.toImage();
+}
+
+/**
+ * Stores the tileset \a image, as a pixmap when possible. Otherwise the image
+ * is kept until the pixmap can be created by image().
+ */
+void Tileset::setImage(const QImage &image)
+{
+    if (canCreatePixmaps()) {
+        mImage = tilesetPixmap(image, mTransparentColor);
+        mPendingImage = QImage();
+    } else {
+        mImage = QPixmap();
+        mPendingImage = image;
+    }
+}
+
+/**
+ * Returns the approximate number of bytes used by this tileset, including
+ * its image, the mirrored copies of the image, its tiles and its
+ * properties.
+ */
+qint64 Tileset::memoryUsage() const
+{
+    qint64 usage = imageMemory() +
+            mAtlas.memoryUsage() +
+            Tiled::memoryUsage(mName) +
+            Tiled::memoryUsage(mFileName) +
+            Tiled::memoryUsage(mImageSource) +
+            properties().memoryUsage();
+
+    for (const QPixmap &flippedImage : mFlippedImages)
+        usage += Tiled::memoryUsage(flippedImage);
+
+    for (const Tile *tile : mTiles)
+        usage += tile->memoryUsage();
+
+    return usage;
+}
+
+/**
+ * Returns whether the tileset image was requested since the last call to
+ * this function.
+ */
+bool Tileset::takeImageUsed() const
+{
+    return mImageUsed.fetchAndStoreAcquire(0) != 0;
+}
+
+/**
+ * Returns the tileset image mirrored in the given directions. The mirrored
+ * images are created when they are first needed.
+ *
+ * \sa flippedImageRect()
+ */
+const QPixmap &Tileset::flippedImage(bool horizontally, bool vertically) const
+{
+    const QPixmap &image = this->image();
+    if (!horizontally && !vertically)
+        return image;
+
+    QPixmap &flippedImage = mFlippedImages[(horizontally ? 1 : 0) + (vertically ? 2 : 0) - 1];
+    if (flippedImage.isNull() && !image.isNull())
+        flippedImage = QPixmap::fromImage(image.toImage().mirrored(horizontally, vertically));
+
+    return flippedImage;
+}
+
+/**
+ * Returns the area of the mirrored tileset image that corresponds to the
+ * given \a rect of the tileset image.
+ *
+ * \sa flippedImage()
+ */
+QRect Tileset::flippedImageRect(const QRect &rect,
+                                bool horizontally, bool vertically) const
+{
+    QRect flipped = rect;
+    if (horizontally)
+        flipped.moveLeft(mImageWidth - rect.x() - rect.width());
+    if (vertically)
+        flipped.moveTop(mImageHeight - rect.y() - rect.height());
+    return flipped;
+}
+
 SharedTileset Tileset::findSimilarTileset(const QVector<SharedTileset> &tilesets) const
 {
+    const uint fingerprint = this->fingerprint();
+
     foreach (const SharedTileset &candidate, tilesets) {
         if (candidate != this
-            && candidate->imageSource() == imageSource()
-            && candidate->tileWidth() == tileWidth()
-            && candidate->tileHeight() == tileHeight()
-            && candidate->tileSpacing() == tileSpacing()
-            && candidate->margin() == margin()) {
+            && candidate->fingerprint() == fingerprint
+            && isSimilarTo(*candidate)) {
                 return candidate;
         }
     }
     return SharedTileset();
 }
 
+/**
+ * Looks up a similar tileset in the given \a tilesets, which were indexed
+ * using byFingerprint(). This avoids comparing this tileset to each of them.
+ */
+SharedTileset Tileset::findSimilarTileset(const TilesetsByFingerprint &tilesets) const
+{
+    const uint fingerprint = this->fingerprint();
+
+    // Prefer the earliest indexed tileset, which values() returns last
+    const QList<SharedTileset> candidates = tilesets.values(fingerprint);
+    for (int i = candidates.size() - 1; i >= 0; --i) {
+        const SharedTileset &candidate = candidates.at(i);
+        if (candidate != this && isSimilarTo(*candidate))
+            return candidate;
+    }
+    return SharedTileset();
+}
+
+/**
+ * Returns a hash of the properties that determine whether tilesets are
+ * similar: the image source, the tile size, the tile spacing and the margin.
+ * It is only computed again after any of these have changed.
+ */
+uint Tileset::fingerprint() const
+{
+    if (mFingerprintDirty) {
+        mFingerprint = qHash(mImageSource)
+                ^ qHash(mTileWidth) * 31
+                ^ qHash(mTileHeight) * 37
+                ^ qHash(mTileSpacing) * 41
+                ^ qHash(mMargin) * 43;
+        mFingerprintDirty = false;
+    }
+    return mFingerprint;
+}
+
+/**
+ * Indexes the given \a tilesets by their fingerprint, for looking up
+ * similar tilesets.
+ */
+TilesetsByFingerprint Tileset::byFingerprint(const QVector<SharedTileset> &tilesets)
+{
+    TilesetsByFingerprint index;
+    index.reserve(tilesets.size());
+    for (const SharedTileset &tileset : tilesets)
+        index.insert(tileset->fingerprint(), tileset);
+    return index;
+}
+
+bool Tileset::isSimilarTo(const Tileset &other) const
+{
+    return other.imageSource() == imageSource()
+            && other.tileWidth() == tileWidth()
+            && other.tileHeight() == tileHeight()
+            && other.tileSpacing() == tileSpacing()
+            && other.margin() == margin();
+}
+
 int Tileset::columnCountForWidth(int width) const
 {
     Q_ASSERT(mTileWidth > 0);
@@ -154,6 +648,7 @@ void Tileset::insertTerrain(int index, Terrain *terrain)
     Q_ASSERT(terrain->tileset() == this);
 
     mTerrainTypes.insert(index, terrain);
+    markTerrainDistancesDirty();
 
     // Reassign terrain IDs
     for (int terrainId = index; terrainId < mTerrainTypes.size(); ++terrainId)
@@ -167,13 +662,12 @@ void Tileset::insertTerrain(int index, Terrain *terrain)
                 tile->setCornerTerrainId(corner, terrainId + 1);
         }
     }
-
-    mTerrainDistancesDirty = true;
 }
 
 Terrain *Tileset::takeTerrainAt(int index)
 {
     Terrain *terrain = mTerrainTypes.takeAt(index);
+    markTerrainDistancesDirty();
 
     // Reassign terrain IDs
     for (int terrainId = index; terrainId < mTerrainTypes.size(); ++terrainId)
@@ -190,8 +684,6 @@ Terrain *Tileset::takeTerrainAt(int index)
         }
     }
 
-    mTerrainDistancesDirty = true;
-
     return terrain;
 }
 
@@ -202,100 +694,265 @@ int Tileset::terrainTransitionPenalty(int terrainType0, int terrainType1) const
         const_cast<Tileset*>(this)->mTerrainDistancesDirty = false;
     }
 
-    terrainType0 = terrainType0 == 255 ? -1 : terrainType0;
-    terrainType1 = terrainType1 == 255 ? -1 : terrainType1;
+    // The first row and column of the matrix are used for no-terrain
+    terrainType0 = terrainType0 == 255 ? 0 : terrainType0 + 1;
+    terrainType1 = terrainType1 == 255 ? 0 : terrainType1 + 1;
 
-    // Do some magic, since we don't have a transition array for no-terrain
-    if (terrainType0 == -1 && terrainType1 == -1)
+    if (terrainType0 == 0 && terrainType1 == 0)
         return 0;
-    if (terrainType0 == -1)
-        return mTerrainTypes.at(terrainType1)->transitionDistance(terrainType0);
-    return mTerrainTypes.at(terrainType0)->transitionDistance(terrainType1);
+
+    return mTerrainDistances.at(terrainType0 * (terrainCount() + 1) + terrainType1);
 }
 
-void Tileset::recalculateTerrainDistances()
+/**
+ * Returns the distinct terrain values used by the tiles in this tileset,
+ * each along with the tiles that use it.
+ *
+ * This allows looking for a tile with certain terrain without considering
+ * each tile separately. The table is rebuilt on demand after the terrain
+ * information of the tileset changed.
+ */
+const QVector<Tileset::TerrainTransition> &Tileset::terrainTransitions() const
 {
-    // some fancy macros which can search for a value in each byte of a word simultaneously
-    #define hasZeroByte(dword) (((dword) - 0x01010101UL) & ~(dword) & 0x80808080UL)
-    #define hasByteEqualTo(dword, value) (hasZeroByte((dword) ^ (~0UL/255 * (value))))
+    if (!mTerrainTransitionsDirty)
+        return mTerrainTransitions;
 
-    // Terrain distances are the number of transitions required before one terrain may meet another
-    // Terrains that have no transition path have a distance of -1
+    mTerrainTransitions.clear();
+    QHash<unsigned, int> indexes;
 
-    for (int i = 0; i < terrainCount(); ++i) {
-        Terrain *type = terrain(i);
-        QVector<int> distance(terrainCount() + 1, -1);
+    for (Tile *tile : mTiles) {
+        const unsigned terrain = tile->terrain();
+        auto it = indexes.find(terrain);
+        if (it == indexes.end()) {
+            it = indexes.insert(terrain, mTerrainTransitions.size());
+            mTerrainTransitions.append(TerrainTransition { terrain, QList<Tile*>() });
+        }
 
-        // Check all tiles for transitions to other terrain types
-        for (int j = 0; j < tileCount(); ++j) {
-            Tile *t = tileAt(j);
+        mTerrainTransitions[it.value()].tiles.append(tile);
+    }
 
-            if (!hasByteEqualTo(t->terrain(), i))
-                continue;
+    mTerrainTransitionsDirty = false;
+    return mTerrainTransitions;
+}
 
-            // This tile has transitions, add the transitions as neightbours (distance 1)
-            int tl = t->cornerTerrainId(0);
-            int tr = t->cornerTerrainId(1);
-            int bl = t->cornerTerrainId(2);
-            int br = t->cornerTerrainId(3);
+namespace {
 
-            // Terrain on diagonally opposite corners are not actually a neighbour
-            if (tl == i || br == i) {
-                distance[tr + 1] = 1;
-                distance[bl + 1] = 1;
-            }
-            if (tr == i || bl == i) {
-                distance[tl + 1] = 1;
-                distance[br + 1] = 1;
-            }
+// A tile connects at most 4 terrains to at most 4 corners each
+const int MaxTerrainConnections = 4 * 5;
+
+/**
+ * Stores the offsets in the distance matrix of the terrain pairs that are
+ * directly connected by a tile with the given \a terrain. Each terrain is
+ * also connected to itself. Returns the number of offsets stored.
+ */
+int terrainConnections(unsigned terrain, int stride, int *offsets)
+{
+    int corners[4];
+    for (int corner = 0; corner < 4; ++corner) {
+        const unsigned id = (terrain >> (3 - corner) * 8) & 0xFF;
+        corners[corner] = id == 0xFF ? 0 : id + 1;
+    }
+
+    const int tl = corners[0];
+    const int tr = corners[1];
+    const int bl = corners[2];
+    const int br = corners[3];
+
+    int count = 0;
+    auto connect = [&] (int terrain0, int terrain1) {
+        if (terrain0 >= stride || terrain1 >= stride)
+            return;
+        const int offset = terrain0 * stride + terrain1;
+        for (int i = 0; i < count; ++i)
+            if (offsets[i] == offset)
+                return;
+        offsets[count++] = offset;
+    };
 
-            // terrain has at least one tile of its own type
-            distance[i + 1] = 0;
+    for (int i : corners) {
+        if (i == 0)
+            continue;
+
+        // Terrain on diagonally opposite corners are not actually a neighbour
+        if (tl == i || br == i) {
+            connect(i, tr);
+            connect(i, bl);
+        }
+        if (tr == i || bl == i) {
+            connect(i, tl);
+            connect(i, br);
         }
 
-        type->setTransitionDistances(distance);
+        connect(i, i);
+    }
+
+    return count;
+}
+
+} // anonymous namespace
+
+/**
+ * Counts the direct terrain connections made by all tiles and derives the
+ * transition distances from them.
+ *
+ * Terrain distances are the number of transitions required before one
+ * terrain may meet another. Terrains that have no transition path have a
+ * distance of -1.
+ */
+void Tileset::recalculateTerrainDistances()
+{
+    const int stride = terrainCount() + 1;
+    mTerrainConnectionCounts.fill(0, stride * stride);
+
+    int offsets[MaxTerrainConnections];
+    for (const Tile *tile : mTiles) {
+        const int count = terrainConnections(tile->terrain(), stride, offsets);
+        for (int i = 0; i < count; ++i)
+            ++mTerrainConnectionCounts[offsets[i]];
     }
 
-    // Calculate indirect transition distances
-    bool bNewConnections;
-    do {
-        bNewConnections = false;
+    updateTerrainDistances();
+}
+
+/**
+ * Computes the shortest transition paths between all terrains from the
+ * direct connections, using the Floyd-Warshall algorithm.
+ *
+ * Paths may pass through no-terrain, but the distance to no-terrain itself
+ * only counts direct transitions.
+ */
+void Tileset::updateTerrainDistances()
+{
+    const int stride = terrainCount() + 1;
+    mTerrainDistances.resize(stride * stride);
+
+    int *d = mTerrainDistances.data();
+    const int *counts = mTerrainConnectionCounts.constData();
+
+    for (int i = 0; i < stride; ++i) {
+        for (int j = 0; j < stride; ++j) {
+            const int offset = i * stride + j;
+            if (i == 0)     // the connections with no-terrain are symmetric
+                d[offset] = j == 0 ? 0 : (counts[j * stride] > 0 ? 1 : -1);
+            else if (counts[offset] > 0)
+                d[offset] = i == j ? 0 : 1;
+            else
+                d[offset] = -1;
+        }
+    }
 
-        // For each combination of terrain types
-        for (int i = 0; i < terrainCount(); ++i) {
-            Terrain *t0 = terrain(i);
-            for (int j = 0; j < terrainCount(); ++j) {
-                if (i == j)
+    for (int k = 0; k < stride; ++k) {
+        for (int i = 1; i < stride; ++i) {
+            const int dik = d[i * stride + k];
+            if (dik == -1)
+                continue;
+
+            for (int j = 1; j < stride; ++j) {
+                const int dkj = d[k * stride + j];
+                if (i == j || dkj == -1)
                     continue;
-                Terrain *t1 = terrain(j);
-
-                // Scan through each terrain type, and see if we have any in common
-                for (int t = -1; t < terrainCount(); ++t) {
-                    int d0 = t0->transitionDistance(t);
-                    int d1 = t1->transitionDistance(t);
-                    if (d0 == -1 || d1 == -1)
-                        continue;
-
-                    // We have cound a common connection
-                    int d = t0->transitionDistance(j);
-                    Q_ASSERT(t1->transitionDistance(i) == d);
-
-                    // If the new path is shorter, record the new distance
-                    if (d == -1 || d0 + d1 < d) {
-                        d = d0 + d1;
-                        t0->setTransitionDistance(j, d);
-                        t1->setTransitionDistance(i, d);
-
-                        // We're making progress, flag for another iteration...
-                        bNewConnections = true;
-                    }
-                }
+
+                int &dij = d[i * stride + j];
+                if (dij == -1 || dik + dkj < dij)
+                    dij = dik + dkj;
             }
         }
+    }
+
+    storeTransitionDistances();
+}
 
-        // Repeat while we are still making new connections (could take a
-        // number of iterations for distant terrain types to connect)
-    } while (bNewConnections);
+/**
+ * Copies the rows of the distance matrix to the terrain types.
+ */
+void Tileset::storeTransitionDistances()
+{
+    const int stride = terrainCount() + 1;
+    for (int i = 1; i < stride; ++i)
+        mTerrainTypes.at(i - 1)->setTransitionDistances(mTerrainDistances.mid(i * stride, stride));
+}
+
+/**
+ * Updates the terrain distances for a new direct connection between two
+ * different terrains, neither of which is no-terrain.
+ */
+void Tileset::addTerrainConnection(int terrain0, int terrain1)
+{
+    const int stride = terrainCount() + 1;
+    int *d = mTerrainDistances.data();
+
+    d[terrain0 * stride + terrain0] = 0;
+    d[terrain1 * stride + terrain1] = 0;
+
+    for (int i = 1; i < stride; ++i) {
+        const int di0 = d[i * stride + terrain0];
+        const int di1 = d[i * stride + terrain1];
+
+        for (int j = 1; j < stride; ++j) {
+            if (i == j)
+                continue;
+
+            const int d1j = d[terrain1 * stride + j];
+            const int d0j = d[terrain0 * stride + j];
+
+            int &dij = d[i * stride + j];
+            if (di0 != -1 && d1j != -1 && (dij == -1 || di0 + 1 + d1j < dij))
+                dij = di0 + 1 + d1j;
+            if (di1 != -1 && d0j != -1 && (dij == -1 || di1 + 1 + d0j < dij))
+                dij = di1 + 1 + d0j;
+        }
+    }
+}
+
+/**
+ * Updates the terrain distances for a single tile changing its terrain.
+ *
+ * Connections that were added can be applied directly to the distance
+ * matrix. Only when a connection is lost, or one involving no-terrain is
+ * added, all distances are derived again from the connection counts.
+ */
+void Tileset::tileTerrainChanged(unsigned oldTerrain, unsigned newTerrain)
+{
+    mTerrainTransitionsDirty = true;
+
+    const int stride = terrainCount() + 1;
+    if (mTerrainDistancesDirty || mTerrainConnectionCounts.size() != stride * stride) {
+        mTerrainDistancesDirty = true;
+        return;
+    }
+
+    int offsets[MaxTerrainConnections];
+    int added[MaxTerrainConnections];
+    int addedCount = 0;
+    bool recompute = false;
+
+    // Add the new connections first, so that connections made by both the
+    // old and the new terrain don't appear to be lost
+    int count = terrainConnections(newTerrain, stride, offsets);
+    for (int i = 0; i < count; ++i)
+        if (mTerrainConnectionCounts[offsets[i]]++ == 0)
+            added[addedCount++] = offsets[i];
+
+    count = terrainConnections(oldTerrain, stride, offsets);
+    for (int i = 0; i < count; ++i)
+        if (--mTerrainConnectionCounts[offsets[i]] == 0)
+            recompute = true;
+
+    for (int i = 0; i < addedCount && !recompute; ++i) {
+        const int terrain0 = added[i] / stride;
+        const int terrain1 = added[i] % stride;
+        if (terrain1 == 0)
+            recompute = true;
+        else if (terrain0 != terrain1)
+            addTerrainConnection(terrain0, terrain1);
+        else
+            mTerrainDistances[added[i]] = 0;
+    }
+
+    if (recompute)
+        updateTerrainDistances();
+    else
+        storeTransitionDistances();
 }
 
 /**
@@ -305,23 +962,34 @@ Tile *Tileset::addTile(const QPixmap &image, const QString &source)
 {
     Tile *newTile = new Tile(image, source, tileCount(), this);
     mTiles.append(newTile);
+    mAtlas.tileChanged(newTile);
+    markTerrainDistancesDirty();
     if (mTileHeight < image.height())
         mTileHeight = image.height();
     if (mTileWidth < image.width())
         mTileWidth = image.width();
+    mFingerprintDirty = true;
     return newTile;
 }
 
 void Tileset::insertTiles(int index, const QList<Tile *> &tiles)
 {
     const int count = tiles.count();
-    for (int i = 0; i < count; ++i)
-        mTiles.insert(index + i, tiles.at(i));
+    for (int i = 0; i < count; ++i) {
+        Tile *tile = tiles.at(i);
+        mTiles.insert(index + i, tile);
+        if (tile->isAnimated())
+            mAnimatedTiles.insert(tile);
+        if (tile->hasMetadata())
+            mTilesWithMetadata.insert(tile);
+        mAtlas.tileChanged(tile);
+    }
 
     // Adjust the tile IDs of the remaining tiles
     for (int i = index + count; i < mTiles.size(); ++i)
         mTiles.at(i)->mId += count;
 
+    markTerrainDistancesDirty();
     updateTileSize();
 }
 
@@ -330,15 +998,56 @@ void Tileset::removeTiles(int index, int count)
     const QList<Tile*>::iterator first = mTiles.begin() + index;
 
     QList<Tile*>::iterator last = first + count;
+    for (auto it = first; it != last; ++it) {
+        mAnimatedTiles.remove(*it);
+        mTilesWithMetadata.remove(*it);
+        mAtlas.tileRemoved(*it);
+    }
     last = mTiles.erase(first, last);
 
     // Adjust the tile IDs of the remaining tiles
     for (; last != mTiles.end(); ++last)
         (*last)->mId -= count;
 
+    markTerrainDistancesDirty();
     updateTileSize();
 }
 
+/**
+ * Used by the Tile class when its image has changed, to pack it into the
+ * atlas again.
+ */
+void Tileset::tileImageChanged(Tile *tile)
+{
+    if (mImageSource.isEmpty())
+        mAtlas.tileChanged(tile);
+}
+
+/**
+ * Used by the Tile class when its animation frames have changed, to keep
+ * track of the animated tiles.
+ */
+void Tileset::tileAnimationChanged(Tile *tile)
+{
+    if (tile->isAnimated())
+        mAnimatedTiles.insert(tile);
+    else
+        mAnimatedTiles.remove(tile);
+}
+
+/**
+ * Used by the Tile class when its properties, terrain, probability, object
+ * group or animation have changed, to keep track of the tiles that have
+ * anything to save besides their image.
+ */
+void Tileset::tileMetadataChanged(Tile *tile)
+{
+    if (tile->hasMetadata())
+        mTilesWithMetadata.insert(tile);
+    else
+        mTilesWithMetadata.remove(tile);
+}
+
 void Tileset::setTileImage(int id, const QPixmap &image,
                            const QString &source)
 {
@@ -350,7 +1059,7 @@ void Tileset::setTileImage(int id, const QPixmap &image,
     if (!tile)
         return;
 
-    const QSize previousImageSize = tile->image().size();
+    const QSize previousImageSize = tile->size();
     const QSize newImageSize = image.size();
 
     tile->setImage(image);
@@ -368,10 +1077,35 @@ void Tileset::setTileImage(int id, const QPixmap &image,
                 mTileHeight = newImageSize.height();
             if (mTileWidth < newImageSize.width())
                 mTileWidth = newImageSize.width();
+            mFingerprintDirty = true;
         }
     }
 }
 
+/**
+ * Sets the image of the tile with the given \a id to the image loaded from
+ * \a fileName. When image decoding is disabled, the tile only remembers its
+ * image source.
+ *
+ * @return <code>true</code> if the image could be read, otherwise
+ *         returns <code>false</code>
+ */
+bool Tileset::loadTileImage(int id, const QString &fileName)
+{
+    if (imageDecodingEnabled) {
+        const QPixmap image(fileName);
+        setTileImage(id, image, fileName);
+        return !image.isNull();
+    }
+
+    Tile *tile = tileAt(id);
+    if (!tile)
+        return false;
+
+    tile->setImageSource(fileName);
+    return QImageReader(fileName).canRead();
+}
+
 void Tileset::updateTileSize()
 {
     int maxWidth = 0;
@@ -385,4 +1119,5 @@ void Tileset::updateTileSize()
     }
     mTileWidth = maxWidth;
     mTileHeight = maxHeight;
+    mFingerprintDirty = true;
 }
@@ -31,16 +31,21 @@
 #define TILESET_H
 
 #include "object.h"
+#include "tileatlas.h"
 
+#include <QAtomicInt>
 #include <QColor>
+#include <QImage>
 #include <QList>
+#include <QMultiHash>
 #include <QVector>
 #include <QPoint>
+#include <QSet>
 #include <QSharedPointer>
 #include <QString>
 #include <QPixmap>
 
-class QImage;
+#include <functional>
 
 namespace Tiled {
 
@@ -49,6 +54,12 @@ class Tileset;
 class Terrain;
 
 typedef QSharedPointer<Tileset> SharedTileset;
+typedef QMultiHash<uint, SharedTileset> TilesetsByFingerprint;
+
+TILEDSHARED_EXPORT bool canCreatePixmaps();
+
+TILEDSHARED_EXPORT void setImageDecodingEnabled(bool enabled);
+TILEDSHARED_EXPORT bool isImageDecodingEnabled();
 
 /**
  * A tileset, representing a set of tiles.
@@ -57,6 +68,12 @@ typedef QSharedPointer<Tileset> SharedTileset;
  * (using loadFromImage) or by adding/removing individual tiles (using
  * addTile, insertTiles and removeTiles). These two use-cases are not meant to
  * be mixed.
+ *
+ * Tilesets are reentrant: different tilesets can be used on different
+ * threads, but a single tileset should only be used by one thread at a time.
+ * SharedTileset references can be copied and released on any thread. When
+ * a tileset image is loaded on a thread that can't create pixmaps, it is kept
+ * as a QImage (see imageData()) until image() is called on the main thread.
  */
 class TILEDSHARED_EXPORT Tileset : public Object
 {
@@ -99,7 +116,13 @@ private:
         mImageWidth(0),
         mImageHeight(0),
         mColumnCount(0),
-        mTerrainDistancesDirty(false)
+        mImageUnloaded(false),
+        mImageRequested(false),
+        mImageUsed(0),
+        mFingerprint(0),
+        mFingerprintDirty(true),
+        mTerrainDistancesDirty(true),
+        mTerrainTransitionsDirty(true)
     {
         Q_ASSERT(tileSpacing >= 0);
         Q_ASSERT(margin >= 0);
@@ -190,6 +213,13 @@ public:
      */
     int tileCount() const { return mTiles.size(); }
 
+    /**
+     * Returns the tiles in this tileset that have animation frames.
+     */
+    const QSet<Tile*> &animatedTiles() const { return mAnimatedTiles; }
+
+    QList<Tile*> tilesWithMetadata() const;
+
     /**
      * Returns the number of tile columns in the tileset image.
      */
@@ -205,6 +235,33 @@ public:
      */
     int imageHeight() const { return mImageHeight; }
 
+    /**
+     * Returns the tileset image, with the transparent color masked out. Is a
+     * null pixmap when this tileset doesn't have a tileset image.
+     *
+     * The tiles only refer to their part of this image, which allows drawing
+     * many different tiles at once.
+     *
+     * After unloadImage(), the image is requested again through the image
+     * request handler, and this returns a null pixmap until it is restored.
+     *
+     * When the image was loaded on a thread that can't create pixmaps, the
+     * pixmap is created once this is called on the main thread. Until then,
+     * this returns a null pixmap and imageData() provides the image.
+     */
+    const QPixmap &image() const;
+    QImage imageData() const;
+
+    /**
+     * Returns the atlas that the tiles of this image collection are drawn
+     * from, which is packed when needed. See Tile::atlasRect().
+     */
+    const QPixmap &atlasImage() const;
+
+    const QPixmap &flippedImage(bool horizontally, bool vertically) const;
+    QRect flippedImageRect(const QRect &rect,
+                           bool horizontally, bool vertically) const;
+
     /**
      * Returns the transparent color, or an invalid color if no transparent
      * color is used.
@@ -219,12 +276,45 @@ public:
 
     bool loadFromImage(const QImage &image, const QString &fileName);
     bool loadFromImage(const QString &fileName);
+    bool loadTileImage(int id, const QString &fileName);
+    void prepareImage(const QSize &imageSize, const QString &fileName);
+    void prepareUnloadedImage(const QSize &imageSize, const QString &fileName);
+    bool reloadFromImage(const QImage &image, QList<Tile*> *changedTiles);
+
+    /**
+     * Returns whether the tileset image is currently in memory. Is only
+     * <code>false</code> after unloadImage() was called, until the image is
+     * restored.
+     */
+    bool isImageLoaded() const { return !mImageUnloaded; }
+
+    void unloadImage();
+    bool restoreImage(const QImage &image);
+    qint64 imageMemory() const;
+    qint64 memoryUsage() const;
+    bool takeImageUsed() const;
+
+    typedef std::function<void (const Tileset &)> ImageRequestHandler;
+
+    /**
+     * Sets the function that is called when the image of this tileset is
+     * needed after it was unloaded. The handler is expected to call
+     * restoreImage() once the image is available.
+     *
+     * Without a handler, the image is loaded right away.
+     */
+    void setImageRequestHandler(ImageRequestHandler handler)
+    { mImageRequestHandler = std::move(handler); }
 
     /**
      * This checks if there is a similar tileset in the given list.
      * It is needed for replacing this tileset by its similar copy.
      */
     SharedTileset findSimilarTileset(const QVector<SharedTileset> &tilesets) const;
+    SharedTileset findSimilarTileset(const TilesetsByFingerprint &tilesets) const;
+
+    uint fingerprint() const;
+    static TilesetsByFingerprint byFingerprint(const QVector<SharedTileset> &tilesets);
 
     /**
      * Returns the file name of the external image that contains the tiles in
@@ -292,26 +382,63 @@ public:
                       const QString &source = QString());
 
     /**
-     * Used by the Tile class when its terrain information changes.
+     * Marks the terrain distances for recalculation, for when the terrain
+     * information of this tileset changes.
+     */
+    void markTerrainDistancesDirty()
+    {
+        mTerrainDistancesDirty = true;
+        mTerrainTransitionsDirty = true;
+    }
+
+    /**
+     * Used by the Tile class when its terrain changes from \a oldTerrain to
+     * \a newTerrain.
+     */
+    void tileTerrainChanged(unsigned oldTerrain, unsigned newTerrain);
+
+    void tileAnimationChanged(Tile *tile);
+    void tileImageChanged(Tile *tile);
+    void tileMetadataChanged(Tile *tile);
+
+    /**
+     * A terrain value used by the tiles of this tileset, with the tiles that
+     * use it.
      */
-    void markTerrainDistancesDirty() { mTerrainDistancesDirty = true; }
+    struct TerrainTransition {
+        unsigned terrain;
+        QList<Tile*> tiles;
+    };
+
+    const QVector<TerrainTransition> &terrainTransitions() const;
 
     SharedTileset sharedPointer() const;
 
+    SharedTileset clone() const;
+
 private:
     /**
      * Sets tile size to the maximum size.
      */
     void updateTileSize();
 
+    bool isSimilarTo(const Tileset &other) const;
+    void setImage(const QImage &image);
+
     /**
      * Calculates the transition distance matrix for all terrain types.
      */
     void recalculateTerrainDistances();
+    void updateTerrainDistances();
+    void addTerrainConnection(int terrain0, int terrain1);
+    void storeTransitionDistances();
 
     QString mName;
     QString mFileName;
     QString mImageSource;
+    mutable QPixmap mImage;
+    mutable QImage mPendingImage;   // image waiting to become a pixmap
+    mutable QPixmap mFlippedImages[3];
     QColor mTransparentColor;
     int mTileWidth;
     int mTileHeight;
@@ -321,22 +448,27 @@ private:
     int mImageWidth;
     int mImageHeight;
     int mColumnCount;
+    bool mImageUnloaded;
+    mutable bool mImageRequested;
+    mutable QAtomicInt mImageUsed;  // also set by threads drawing the image
+    ImageRequestHandler mImageRequestHandler;
+    mutable uint mFingerprint;
+    mutable bool mFingerprintDirty;
     QList<Tile*> mTiles;
+    QSet<Tile*> mAnimatedTiles;
+    QSet<Tile*> mTilesWithMetadata;
+    mutable TileAtlas mAtlas;
     QList<Terrain*> mTerrainTypes;
+    QVector<int> mTerrainConnectionCounts;
+    QVector<int> mTerrainDistances;
     bool mTerrainDistancesDirty;
+    mutable QVector<TerrainTransition> mTerrainTransitions;
+    mutable bool mTerrainTransitionsDirty;
 
     QWeakPointer<Tileset> mWeakPointer;
 };
 
 
-/**
- * Convenience override that loads the image using the QImage constructor.
- */
-inline bool Tileset::loadFromImage(const QString &fileName)
-{
-    return loadFromImage(QImage(fileName), fileName);
-}
-
 inline SharedTileset Tileset::sharedPointer() const
 {
     return SharedTileset(mWeakPointer);
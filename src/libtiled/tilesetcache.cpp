@@ -0,0 +1,133 @@
+/*
+ * tilesetcache.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tilesetcache.h"
+
+#include "tilesetformat.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+
+using namespace Tiled;
+
+TilesetCache *TilesetCache::instance()
+{
+    // Never deleted, since the tilesets it may still hold can't be destroyed
+    // after the application
+    static TilesetCache *cache = new TilesetCache;
+    return cache;
+}
+
+/**
+ * Returns the cached tileset loaded from \a fileName, or loads it and adds it
+ * to the cache. Returns null and sets \a error when the tileset could not be
+ * loaded.
+ */
+SharedTileset TilesetCache::load(const QString &fileName, QString *error)
+{
+    if (SharedTileset tileset = find(fileName))
+        return tileset;
+
+    const QFileInfo fileInfo(fileName);
+    const QString canonicalPath = fileInfo.canonicalFilePath();
+
+    // Remember the time of the file that is read, so a change while reading
+    // is picked up next time
+    const QDateTime lastModified = fileInfo.lastModified();
+
+    SharedTileset tileset = readTileset(fileName, error);
+    if (!tileset || canonicalPath.isEmpty())
+        return tileset;
+
+    // Another thread may have loaded the same tileset meanwhile
+    return insert(canonicalPath, lastModified, tileset);
+}
+
+/**
+ * Returns the cached tileset loaded from \a fileName, or null when it is not
+ * cached or its file was modified since it was loaded.
+ */
+SharedTileset TilesetCache::find(const QString &fileName) const
+{
+    const QFileInfo fileInfo(fileName);
+    const QString canonicalPath = fileInfo.canonicalFilePath();
+    if (canonicalPath.isEmpty())
+        return SharedTileset();
+
+    const QDateTime lastModified = fileInfo.lastModified();
+
+    QMutexLocker locker(&mMutex);
+
+    auto it = mEntries.constFind(canonicalPath);
+    if (it == mEntries.constEnd() || it.value().lastModified != lastModified)
+        return SharedTileset();
+
+    return it.value().tileset;
+}
+
+/**
+ * Adds the given external \a tileset to the cache, replacing any tileset
+ * cached for the same file.
+ */
+void TilesetCache::insert(const SharedTileset &tileset)
+{
+    const QFileInfo fileInfo(tileset->fileName());
+    const QString canonicalPath = fileInfo.canonicalFilePath();
+    if (canonicalPath.isEmpty())
+        return;
+
+    QMutexLocker locker(&mMutex);
+    mEntries.insert(canonicalPath, Entry { tileset, fileInfo.lastModified() });
+}
+
+void TilesetCache::clear()
+{
+    // The tilesets are released after the lock, when leaving this function
+    QHash<QString, Entry> entries;
+    QMutexLocker locker(&mMutex);
+    entries.swap(mEntries);
+}
+
+/**
+ * Adds \a tileset unless an up to date tileset was already cached for the
+ * same file, in which case that one is returned instead.
+ */
+SharedTileset TilesetCache::insert(const QString &canonicalPath,
+                                   const QDateTime &lastModified,
+                                   const SharedTileset &tileset)
+{
+    QMutexLocker locker(&mMutex);
+
+    Entry &entry = mEntries[canonicalPath];
+    if (entry.tileset && entry.lastModified == lastModified)
+        return entry.tileset;
+
+    entry.tileset = tileset;
+    entry.lastModified = lastModified;
+    return tileset;
+}
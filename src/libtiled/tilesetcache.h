@@ -0,0 +1,84 @@
+/*
+ * tilesetcache.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TILED_TILESETCACHE_H
+#define TILED_TILESETCACHE_H
+
+#include "tiled_global.h"
+#include "tileset.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+namespace Tiled {
+
+/**
+ * A process-wide cache of external tilesets, keyed by the canonical path of
+ * their file. Tilesets are handed out again for as long as their file isn't
+ * modified, so that maps referencing the same tilesets share the same
+ * Tileset instances and the files are only parsed once.
+ *
+ * The cache is thread-safe. Tilesets loaded on other threads keep their
+ * image as a QImage until it is first used on the main thread, but the
+ * returned tilesets themselves should only be used by one thread at a time.
+ *
+ * Cached tilesets are kept alive by the cache until clear() is called.
+ */
+class TILEDSHARED_EXPORT TilesetCache
+{
+public:
+    static TilesetCache *instance();
+
+    SharedTileset load(const QString &fileName, QString *error = nullptr);
+    SharedTileset find(const QString &fileName) const;
+
+    void insert(const SharedTileset &tileset);
+    void clear();
+
+private:
+    TilesetCache() {}
+    Q_DISABLE_COPY(TilesetCache)
+
+    SharedTileset insert(const QString &canonicalPath,
+                         const QDateTime &lastModified,
+                         const SharedTileset &tileset);
+
+    struct Entry {
+        SharedTileset tileset;
+        QDateTime lastModified;
+    };
+
+    mutable QMutex mMutex;
+    QHash<QString, Entry> mEntries;
+};
+
+} // namespace Tiled
+
+#endif // TILED_TILESETCACHE_H
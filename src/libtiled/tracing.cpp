@@ -0,0 +1,164 @@
+/*
+ * tracing.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tracing.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+
+using namespace Tiled;
+
+namespace {
+
+struct TraceEvent
+{
+    const char *name;
+    QString detail;
+    qint64 start;       // in nanoseconds
+    qint64 duration;
+    int thread;
+};
+
+struct TraceState
+{
+    QMutex mutex;
+    QElapsedTimer timer;
+    QString fileName;
+    QVector<TraceEvent> events;
+    QHash<Qt::HANDLE, int> threads;     // numbered in order of appearance
+};
+
+} // anonymous namespace
+
+Q_GLOBAL_STATIC(TraceState, traceState)
+
+bool Tracing::mEnabled;
+
+/**
+ * Starts recording trace events, which are written to \a fileName by
+ * finish().
+ */
+void Tracing::start(const QString &fileName)
+{
+    TraceState *state = traceState();
+    QMutexLocker locker(&state->mutex);
+
+    state->fileName = fileName;
+    state->events.clear();
+    state->threads.clear();
+    state->timer.start();
+
+    mEnabled = true;
+}
+
+/**
+ * Stops recording and writes the recorded events to the file passed to
+ * start(). Returns whether writing the file succeeded, or true when tracing
+ * was not enabled.
+ */
+bool Tracing::finish()
+{
+    if (!mEnabled)
+        return true;
+
+    mEnabled = false;
+
+    TraceState *state = traceState();
+    QMutexLocker locker(&state->mutex);
+
+    const double pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    for (const TraceEvent &event : state->events) {
+        QJsonObject object;
+        object.insert(QLatin1String("name"), QLatin1String(event.name));
+        object.insert(QLatin1String("cat"), QLatin1String("tiled"));
+        object.insert(QLatin1String("ph"), QLatin1String("X"));
+        object.insert(QLatin1String("ts"), event.start / 1000.0);
+        object.insert(QLatin1String("dur"), event.duration / 1000.0);
+        object.insert(QLatin1String("pid"), pid);
+        object.insert(QLatin1String("tid"), event.thread);
+
+        if (!event.detail.isEmpty()) {
+            QJsonObject args;
+            args.insert(QLatin1String("detail"), event.detail);
+            object.insert(QLatin1String("args"), args);
+        }
+
+        events.append(object);
+    }
+    state->events.clear();
+
+    QJsonObject trace;
+    trace.insert(QLatin1String("traceEvents"), events);
+    trace.insert(QLatin1String("displayTimeUnit"), QLatin1String("ms"));
+
+    QSaveFile file(state->fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+qint64 Tracing::now()
+{
+    return traceState()->timer.nsecsElapsed();
+}
+
+void Tracing::addEvent(const char *name, const QString &detail,
+                       qint64 start, qint64 duration)
+{
+    TraceEvent event;
+    event.name = name;
+    event.detail = detail;
+    event.start = start;
+    event.duration = duration;
+
+    TraceState *state = traceState();
+    QMutexLocker locker(&state->mutex);
+
+    // Events that end after finish() was called are dropped
+    if (!mEnabled)
+        return;
+
+    const Qt::HANDLE thread = QThread::currentThreadId();
+    auto it = state->threads.find(thread);
+    if (it == state->threads.end())
+        it = state->threads.insert(thread, state->threads.size() + 1);
+
+    event.thread = it.value();
+    state->events.append(event);
+}
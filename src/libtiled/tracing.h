@@ -0,0 +1,101 @@
+/*
+ * tracing.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef TILED_TRACING_H
+#define TILED_TRACING_H
+
+#include "tiled_global.h"
+
+#include <QString>
+
+namespace Tiled {
+
+/**
+ * Records how long the phases of loading, saving and automapping take, in
+ * the Chrome trace event format. The resulting file can be opened in the
+ * trace viewer of Chrome (chrome://tracing).
+ *
+ * Tracing is off by default, in which case a TraceScope only costs a check
+ * of a flag.
+ */
+class TILEDSHARED_EXPORT Tracing
+{
+public:
+    static bool isEnabled() { return mEnabled; }
+
+    static void start(const QString &fileName);
+    static bool finish();
+
+private:
+    friend class TraceScope;
+
+    static qint64 now();
+    static void addEvent(const char *name, const QString &detail,
+                         qint64 start, qint64 duration);
+
+    static bool mEnabled;
+};
+
+/**
+ * Records a trace event covering the lifetime of this object, when tracing
+ * is enabled. The \a name needs to stay valid until the trace is finished,
+ * so usually it is a string literal. The optional \a detail, like the name
+ * of the file being read, is shown with the event.
+ */
+class TILEDSHARED_EXPORT TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : mName(name)
+        , mStart(Tracing::isEnabled() ? Tracing::now() : -1)
+    {}
+
+    TraceScope(const char *name, const QString &detail)
+        : mName(name)
+        , mStart(Tracing::isEnabled() ? Tracing::now() : -1)
+    {
+        if (mStart != -1)
+            mDetail = detail;
+    }
+
+    ~TraceScope()
+    {
+        if (mStart != -1)
+            Tracing::addEvent(mName, mDetail, mStart, Tracing::now() - mStart);
+    }
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char * const mName;
+    QString mDetail;
+    const qint64 mStart;
+};
+
+} // namespace Tiled
+
+#endif // TILED_TRACING_H
@@ -21,6 +21,7 @@
 
 #include "varianttomapconverter.h"
 
+#include "csvparser.h"
 #include "imagelayer.h"
 #include "map.h"
 #include "mapobject.h"
@@ -76,6 +77,7 @@ Map *VariantToMapConverter::toMap(const QVariant &variant,
                             variantMap[QLatin1String("height")].toInt(),
                             variantMap[QLatin1String("tilewidth")].toInt(),
                             variantMap[QLatin1String("tileheight")].toInt()));
+    map->setInfinite(variantMap[QLatin1String("infinite")].toBool());
     map->setHexSideLength(variantMap[QLatin1String("hexsidelength")].toInt());
     map->setStaggerAxis(staggerAxis);
     map->setStaggerIndex(staggerIndex);
@@ -128,7 +130,8 @@ Properties VariantToMapConverter::toProperties(const QVariant &variant)
     QVariantMap::const_iterator it = variantMap.constBegin();
     QVariantMap::const_iterator it_end = variantMap.constEnd();
     for (; it != it_end; ++it)
-        properties[it.key()] = it.value().toString();
+        properties.insert(mStrings.intern(it.key()),
+                          mStrings.intern(it.value().toString()));
 
     return properties;
 }
@@ -240,7 +243,7 @@ SharedTileset VariantToMapConverter::toTileset(const QVariant &variant)
             imageVariant = tileVar[QLatin1String("image")];
             if (!imageVariant.isNull()) {
                 QString imagePath = resolvePath(mMapDir, imageVariant);
-                tileset->setTileImage(tileIndex, QPixmap(imagePath), imagePath);
+                tileset->loadTileImage(tileIndex, imagePath);
             }
             QVariantMap objectGroupVariant = tileVar[QLatin1String("objectgroup")].toMap();
             if (!objectGroupVariant.isEmpty())
@@ -332,6 +335,10 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
             layerDataFormat = Map::Base64Gzip;
         } else if (compression == QLatin1String("zlib")) {
             layerDataFormat = Map::Base64Zlib;
+        } else if (compression == QLatin1String("zstd") && compressionSupported(Zstandard)) {
+            layerDataFormat = Map::Base64Zstandard;
+        } else if (compression == QLatin1String("lz4") && compressionSupported(Lz4)) {
+            layerDataFormat = Map::Base64Lz4;
         } else {
             mError = tr("Compression method '%1' not supported").arg(compression);
             return nullptr;
@@ -342,16 +349,71 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
     }
     mMap->setLayerDataFormat(layerDataFormat);
 
-    switch (layerDataFormat) {
+    if (mMap->infinite()) {
+        // The chunks of infinite maps may lie outside of the layer bounds
+        tileLayer->setMap(mMap);
+
+        foreach (const QVariant &chunkVariant, variantMap[QLatin1String("chunks")].toList()) {
+            const QVariantMap chunkMap = chunkVariant.toMap();
+            const int chunkWidth = chunkMap[QLatin1String("width")].toInt();
+            const int chunkHeight = chunkMap[QLatin1String("height")].toInt();
+
+            if (chunkWidth <= 0 || chunkHeight <= 0 ||
+                    chunkWidth > 0xFFFF || chunkHeight > 0xFFFF) {
+                mError = tr("Invalid chunk size in layer '%1'").arg(name);
+                return nullptr;
+            }
+
+            TileLayer chunk(name, 0, 0, chunkWidth, chunkHeight);
+            if (!readTileLayerData(chunk, chunkMap[QLatin1String("data")], layerDataFormat))
+                return nullptr;
+
+            const QPoint pos(chunkMap[QLatin1String("x")].toInt(),
+                             chunkMap[QLatin1String("y")].toInt());
+            tileLayer->mergeCells(pos, &chunk, QRect(0, 0, chunkWidth, chunkHeight));
+        }
+    } else if (!readTileLayerData(*tileLayer, dataVariant, layerDataFormat)) {
+        return nullptr;
+    }
+
+    return tileLayer.take();
+}
+
+/**
+ * Reads the cells of \a tileLayer from \a dataVariant, which is stored in
+ * the given \a format. Returns false and sets the error string when the data
+ * is corrupt.
+ */
+bool VariantToMapConverter::readTileLayerData(TileLayer &tileLayer,
+                                              const QVariant &dataVariant,
+                                              Map::LayerDataFormat format)
+{
+    const QString &name = tileLayer.name();
+
+    switch (format) {
     case Map::XML:
     case Map::CSV: {
+        if (dataVariant.type() == QVariant::String ||
+                dataVariant.type() == QVariant::ByteArray) {
+            if (!readCsvLayerData(tileLayer, dataVariant.toString()))
+                return false;
+            break;
+        }
+
+        if (dataVariant.userType() == qMetaTypeId<QVector<unsigned> >()) {
+            if (!readLayerData(tileLayer, dataVariant.value<QVector<unsigned> >()))
+                return false;
+            break;
+        }
+
         const QVariantList dataVariantList = dataVariant.toList();
 
-        if (dataVariantList.size() != width * height) {
+        if (dataVariantList.size() != tileLayer.width() * tileLayer.height()) {
             mError = tr("Corrupt layer data for layer '%1'").arg(name);
-            return nullptr;
+            return false;
         }
 
+        TileLayer::BulkEdit bulkEdit(&tileLayer);
         int x = 0;
         int y = 0;
         bool ok;
@@ -360,16 +422,16 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
             const unsigned gid = gidVariant.toUInt(&ok);
             if (!ok) {
                 mError = tr("Unable to parse tile at (%1,%2) on layer '%3'")
-                        .arg(x).arg(y).arg(tileLayer->name());
-                return nullptr;
+                        .arg(x).arg(y).arg(tileLayer.name());
+                return false;
             }
 
             const Cell cell = mGidMapper.gidToCell(gid, ok);
 
-            tileLayer->setCell(x, y, cell);
+            tileLayer.setCell(x, y, cell);
 
             x++;
-            if (x >= tileLayer->width()) {
+            if (x >= tileLayer.width()) {
                 x = 0;
                 y++;
             }
@@ -379,22 +441,24 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
 
     case Map::Base64:
     case Map::Base64Zlib:
-    case Map::Base64Gzip: {
+    case Map::Base64Gzip:
+    case Map::Base64Zstandard:
+    case Map::Base64Lz4: {
         const QByteArray data = dataVariant.toByteArray();
-        GidMapper::DecodeError error = mGidMapper.decodeLayerData(*tileLayer,
+        GidMapper::DecodeError error = mGidMapper.decodeLayerData(tileLayer,
                                                                   data,
-                                                                  layerDataFormat);
+                                                                  format);
 
         switch (error) {
         case GidMapper::CorruptLayerData:
             mError = tr("Corrupt layer data for layer '%1'").arg(name);
-            return nullptr;
+            return false;
         case GidMapper::TileButNoTilesets:
             mError = tr("Tile used but no tilesets specified");
-            return nullptr;
+            return false;
         case GidMapper::InvalidTile:
             mError = tr("Invalid tile: %1").arg(mGidMapper.invalidTile());
-            return nullptr;
+            return false;
         case GidMapper::NoError:
             break;
         }
@@ -403,7 +467,71 @@ TileLayer *VariantToMapConverter::toTileLayer(const QVariantMap &variantMap)
     }
     }
 
-    return tileLayer.take();
+    return true;
+}
+
+/**
+ * Reads tile layer data stored as a comma separated string of gids. Returns
+ * false and sets the error string when the data is corrupt.
+ */
+bool VariantToMapConverter::readCsvLayerData(TileLayer &tileLayer,
+                                             const QString &text)
+{
+    CsvParser<QChar> parser(text.constData(), text.constData() + text.size());
+
+    const int width = tileLayer.width();
+    const int count = width * tileLayer.height();
+    int index = 0;
+    unsigned gid;
+    bool ok;
+
+    TileLayer::BulkEdit bulkEdit(&tileLayer);
+
+    while (parser.next(gid, ok)) {
+        if (index == count) {
+            ++index;    // too many tiles
+            break;
+        }
+
+        if (!ok) {
+            mError = tr("Unable to parse tile at (%1,%2) on layer '%3'")
+                    .arg(index % width).arg(index / width).arg(tileLayer.name());
+            return false;
+        }
+
+        tileLayer.setCell(index % width, index / width, mGidMapper.gidToCell(gid, ok));
+        ++index;
+    }
+
+    if (index != count) {
+        mError = tr("Corrupt layer data for layer '%1'").arg(tileLayer.name());
+        return false;
+    }
+
+    return true;
+}
+
+bool VariantToMapConverter::readLayerData(TileLayer &tileLayer,
+                                          const QVector<unsigned> &gids)
+{
+    const int width = tileLayer.width();
+    const int height = tileLayer.height();
+
+    if (gids.size() != width * height) {
+        mError = tr("Corrupt layer data for layer '%1'").arg(tileLayer.name());
+        return false;
+    }
+
+    const unsigned *gid = gids.constData();
+    bool ok;
+
+    TileLayer::BulkEdit bulkEdit(&tileLayer);
+
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            tileLayer.setCell(x, y, mGidMapper.gidToCell(*gid++, ok));
+
+    return true;
 }
 
 ObjectGroup *VariantToMapConverter::toObjectGroup(const QVariantMap &variantMap)
@@ -448,7 +576,9 @@ ObjectGroup *VariantToMapConverter::toObjectGroup(const QVariantMap &variantMap)
         const QPointF pos(x, y);
         const QSizeF size(width, height);
 
-        MapObject *object = new MapObject(name, type, pos, size);
+        MapObject *object = new MapObject(mStrings.intern(name),
+                                          mStrings.intern(type),
+                                          pos, size);
         object->setId(id);
         object->setRotation(rotation);
 
@@ -512,7 +642,7 @@ ImageLayer *VariantToMapConverter::toImageLayer(const QVariantMap &variantMap)
 
     if (!imageVariant.isNull()) {
         QString imagePath = resolvePath(mMapDir, imageVariant);
-        if (!imageLayer->loadFromImage(QImage(imagePath), imagePath)) {
+        if (!imageLayer->loadFromImage(imagePath)) {
             mError = tr("Error loading image:\n'%1'").arg(imagePath);
             return nullptr;
         }
@@ -23,10 +23,12 @@
 #define VARIANTTOMAPCONVERTER_H
 
 #include "gidmapper.h"
+#include "properties.h"
 
 #include <QCoreApplication>
 #include <QDir>
 #include <QVariant>
+#include <QVector>
 
 namespace Tiled {
 
@@ -55,6 +57,10 @@ public:
      * Tries to convert the given \a variant to a Map instance. The \a mapDir
      * is necessary to resolve any relative references to external images.
      *
+     * The data of CSV tile layers may be given as a list, a string or as a
+     * QVector<unsigned> of global tile IDs. Encoded data may be given as a
+     * string or a byte array.
+     *
      * Returns 0 in case of an error. The error can be obstained using
      * errorString().
      */
@@ -80,6 +86,10 @@ private:
     SharedTileset toTileset(const QVariant &variant);
     Layer *toLayer(const QVariant &variant);
     TileLayer *toTileLayer(const QVariantMap &variantMap);
+    bool readTileLayerData(TileLayer &tileLayer, const QVariant &dataVariant,
+                           Map::LayerDataFormat format);
+    bool readCsvLayerData(TileLayer &tileLayer, const QString &text);
+    bool readLayerData(TileLayer &tileLayer, const QVector<unsigned> &gids);
     ObjectGroup *toObjectGroup(const QVariantMap &variantMap);
     ImageLayer *toImageLayer(const QVariantMap &variantMap);
 
@@ -89,6 +99,7 @@ private:
     QDir mMapDir;
     bool mReadingExternalTileset;
     GidMapper mGidMapper;
+    StringTable mStrings;
     QString mError;
 };
 
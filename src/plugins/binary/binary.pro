@@ -0,0 +1,11 @@
+include(../plugin.pri)
+
+DEFINES += BINARY_LIBRARY
+
+SOURCES += binaryplugin.cpp \
+    binarystream.cpp
+HEADERS += binaryplugin.h \
+    binary_global.h \
+    binarystream.h
+
+OTHER_FILES = plugin.json
@@ -0,0 +1,967 @@
+/*
+ * Binary Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binaryplugin.h"
+
+#include "binarystream.h"
+#include "compression.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "terrain.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetformat.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QScopedPointer>
+
+#include <climits>
+
+using namespace Tiled;
+
+namespace Binary {
+
+namespace {
+
+constexpr quint32 fourCC(const char (&name)[5])
+{
+    return quint32(uchar(name[0])) |
+            quint32(uchar(name[1])) << 8 |
+            quint32(uchar(name[2])) << 16 |
+            quint32(uchar(name[3])) << 24;
+}
+
+const quint32 Magic = fourCC("TMBF");
+const quint32 Version = 1;
+
+// magic, version, chunk count, reserved
+const int HeaderSize = 4 + 4 + 4 + 4;
+// type, compression, offset, size, uncompressed size
+const int ChunkEntrySize = 4 + 4 + 8 + 8 + 8;
+const quint64 ChunkAlignment = 16;
+
+const quint32 MapChunk = fourCC("MAP ");
+const quint32 TilesetChunk = fourCC("TSET");
+const quint32 LayerChunk = fourCC("LAYR");
+const quint32 CellsChunk = fourCC("CELL");
+
+const quint32 NoCompression = 0;
+
+struct Chunk
+{
+    quint32 type;
+    quint32 compression;
+    QByteArray data;
+    quint64 uncompressedSize;
+};
+
+Chunk makeChunk(quint32 type, const QByteArray &data)
+{
+    const Chunk chunk = { type, NoCompression, data, quint64(data.size()) };
+    return chunk;
+}
+
+struct LayerAttributes
+{
+    QString name;
+    int x;
+    int y;
+    int width;
+    int height;
+    double opacity;
+    bool visible;
+    QPointF offset;
+    Properties properties;
+};
+
+LayerAttributes readLayerAttributes(ChunkReader &reader)
+{
+    LayerAttributes attributes;
+    attributes.name = reader.readString();
+    attributes.x = reader.read<qint32>();
+    attributes.y = reader.read<qint32>();
+    attributes.width = reader.read<qint32>();
+    attributes.height = reader.read<qint32>();
+    attributes.opacity = reader.readReal();
+    attributes.visible = reader.readBool();
+    const double offsetX = reader.readReal();
+    const double offsetY = reader.readReal();
+    attributes.offset = QPointF(offsetX, offsetY);
+    attributes.properties = reader.readProperties();
+    return attributes;
+}
+
+void applyLayerAttributes(Layer *layer, const LayerAttributes &attributes)
+{
+    layer->setOpacity(attributes.opacity);
+    layer->setVisible(attributes.visible);
+    layer->setOffset(attributes.offset);
+    layer->setProperties(attributes.properties);
+}
+
+bool compressionMethod(Map::LayerDataFormat format, CompressionMethod &method)
+{
+    switch (format) {
+    case Map::Base64Gzip:       method = Gzip; return true;
+    case Map::Base64Zlib:       method = Zlib; return true;
+    case Map::Base64Zstandard:  method = Zstandard; return true;
+    case Map::Base64Lz4:        method = Lz4; return true;
+    default:                    return false;
+    }
+}
+
+/**
+ * Returns the data of the chunk described by \a entry, decompressing it
+ * when necessary. The data of uncompressed chunks is not copied.
+ */
+bool chunkData(const char *data, const ChunkEntry &entry, QByteArray &out)
+{
+    const QByteArray stored = QByteArray::fromRawData(data + entry.offset,
+                                                      int(entry.size));
+
+    if (entry.compression == NoCompression) {
+        out = stored;
+        return true;
+    }
+
+    const quint32 method = entry.compression - 1;
+    if (method > Lz4 || !compressionSupported(CompressionMethod(method)))
+        return false;
+    if (entry.uncompressedSize > INT_MAX)
+        return false;
+
+    out = decompress(stored, int(entry.uncompressedSize),
+                     CompressionMethod(method));
+    return quint64(out.size()) == entry.uncompressedSize;
+}
+
+QString resolvePath(const QDir &dir, const QString &fileName)
+{
+    if (fileName.isEmpty() || !QDir::isRelativePath(fileName))
+        return fileName;
+    return QDir::cleanPath(dir.absoluteFilePath(fileName));
+}
+
+bool hasTileData(const Tile *tile)
+{
+    return !tile->properties().isEmpty()
+            || tile->terrain() != 0xFFFFFFFF
+            || tile->probability() != 1.f
+            || !tile->imageSource().isEmpty()
+            || tile->objectGroup()
+            || tile->isAnimated();
+}
+
+} // anonymous namespace
+
+
+BinaryPlugin::BinaryPlugin()
+{
+}
+
+Map *BinaryPlugin::read(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        mError = tr("Could not open file for reading.");
+        return nullptr;
+    }
+
+    mMapDir = QFileInfo(fileName).dir();
+    mGidMapper.clear();
+
+    // Map the file to avoid copying it, falling back to reading it
+    qint64 size = file.size();
+    QByteArray contents;
+    const char *data = reinterpret_cast<const char*>(file.map(0, size));
+    if (!data) {
+        contents = file.readAll();
+        data = contents.constData();
+        size = contents.size();
+    }
+
+    return readMap(data, size);
+}
+
+bool BinaryPlugin::supportsFile(const QString &fileName) const
+{
+    if (QFileInfo(fileName).suffix() != QLatin1String("tmb"))
+        return false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray header = file.read(4);
+    return header.size() == 4 &&
+            qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(header.constData())) == Magic;
+}
+
+QString BinaryPlugin::nameFilter() const
+{
+    return tr("Tiled binary map files (*.tmb)");
+}
+
+QString BinaryPlugin::errorString() const
+{
+    return mError;
+}
+
+Map *BinaryPlugin::readMap(const char *data, qint64 size)
+{
+    ChunkReader header(data, size);
+    const quint32 magic = header.read<quint32>();
+    const quint32 version = header.read<quint32>();
+    const quint32 chunkCount = header.read<quint32>();
+    header.read<quint32>();     // reserved
+
+    if (!header.isOk() || magic != Magic) {
+        mError = tr("Not a Tiled binary map file.");
+        return nullptr;
+    }
+
+    if (version != Version) {
+        mError = tr("Unsupported file version: %1").arg(version);
+        return nullptr;
+    }
+
+    if (chunkCount == 0 || qint64(chunkCount) * ChunkEntrySize > size - HeaderSize) {
+        mError = tr("Corrupt chunk directory.");
+        return nullptr;
+    }
+
+    QVector<ChunkEntry> entries(chunkCount);
+    for (ChunkEntry &entry : entries) {
+        entry.type = header.read<quint32>();
+        entry.compression = header.read<quint32>();
+        entry.offset = header.read<quint64>();
+        entry.size = header.read<quint64>();
+        entry.uncompressedSize = header.read<quint64>();
+
+        if (entry.offset > quint64(size) ||
+                entry.size > quint64(size) - entry.offset ||
+                entry.size > INT_MAX) {
+            mError = tr("Corrupt chunk directory.");
+            return nullptr;
+        }
+    }
+
+    QByteArray chunk;
+    if (entries.first().type != MapChunk || !readChunk(data, entries.first(), chunk))
+        return nullptr;
+
+    ChunkReader reader(chunk.constData(), chunk.size());
+    const quint32 orientation = reader.read<quint32>();
+    const quint32 renderOrder = reader.read<quint32>();
+    const int width = reader.read<qint32>();
+    const int height = reader.read<qint32>();
+    const int tileWidth = reader.read<qint32>();
+    const int tileHeight = reader.read<qint32>();
+    const int hexSideLength = reader.read<qint32>();
+    const quint32 staggerAxis = reader.read<quint32>();
+    const quint32 staggerIndex = reader.read<quint32>();
+    const int nextObjectId = reader.read<qint32>();
+    const quint32 layerDataFormat = reader.read<quint32>();
+    const QColor backgroundColor = reader.readColor();
+    const Properties properties = reader.readProperties();
+
+    if (!reader.isOk()) {
+        mError = tr("Corrupt map attributes.");
+        return nullptr;
+    }
+
+    if (orientation < Map::Orthogonal || orientation > Map::Hexagonal) {
+        mError = tr("Unsupported map orientation: \"%1\"").arg(orientation);
+        return nullptr;
+    }
+
+    QScopedPointer<Map> map(new Map(Map::Orientation(orientation),
+                                    width, height, tileWidth, tileHeight));
+    map->setHexSideLength(hexSideLength);
+    map->setStaggerAxis(staggerAxis == Map::StaggerY ? Map::StaggerY : Map::StaggerX);
+    map->setStaggerIndex(staggerIndex == Map::StaggerEven ? Map::StaggerEven : Map::StaggerOdd);
+    if (renderOrder <= Map::LeftUp)
+        map->setRenderOrder(Map::RenderOrder(renderOrder));
+    if (layerDataFormat <= Map::Base64Lz4)
+        map->setLayerDataFormat(Map::LayerDataFormat(layerDataFormat));
+    if (nextObjectId)
+        map->setNextObjectId(nextObjectId);
+    map->setBackgroundColor(backgroundColor);
+    map->setProperties(properties);
+
+    // The cells are read along with their layer and unknown chunks are
+    // skipped, to allow for additions to the format
+    for (int i = 1; i < entries.size(); ++i) {
+        const ChunkEntry &entry = entries.at(i);
+        if (entry.type != TilesetChunk && entry.type != LayerChunk)
+            continue;
+
+        if (!readChunk(data, entry, chunk))
+            return nullptr;
+
+        ChunkReader chunkReader(chunk.constData(), chunk.size());
+
+        if (entry.type == TilesetChunk) {
+            SharedTileset tileset = readTileset(chunkReader);
+            if (!tileset)
+                return nullptr;
+
+            map->addTileset(tileset);
+        } else {
+            Layer *layer = readLayer(chunkReader, data, entries);
+            if (!layer)
+                return nullptr;
+
+            map->addLayer(layer);
+        }
+    }
+
+    return map.take();
+}
+
+bool BinaryPlugin::readChunk(const char *data, const ChunkEntry &entry,
+                             QByteArray &out)
+{
+    if (!chunkData(data, entry, out)) {
+        mError = tr("Corrupt or unsupported compressed chunk at offset %1.")
+                .arg(entry.offset);
+        return false;
+    }
+    return true;
+}
+
+SharedTileset BinaryPlugin::readTileset(ChunkReader &reader)
+{
+    const unsigned firstGid = reader.read<quint32>();
+    const QString source = reader.readString();
+
+    // Handle external tilesets
+    if (!source.isEmpty()) {
+        const QString fileName = resolvePath(mMapDir, source);
+        QString error;
+        SharedTileset tileset = Tiled::readTileset(fileName, &error);
+        if (!tileset) {
+            mError = tr("Error while loading tileset '%1': %2")
+                    .arg(fileName, error);
+        } else {
+            mGidMapper.insert(firstGid, tileset.data());
+        }
+        return tileset;
+    }
+
+    const QString name = reader.readString();
+    const int tileWidth = reader.read<qint32>();
+    const int tileHeight = reader.read<qint32>();
+    const int spacing = reader.read<qint32>();
+    const int margin = reader.read<qint32>();
+    const int tileOffsetX = reader.read<qint32>();
+    const int tileOffsetY = reader.read<qint32>();
+    const QColor transparentColor = reader.readColor();
+    const QString image = reader.readString();
+    const int imageWidth = reader.read<qint32>();
+    reader.read<qint32>();      // image height
+    const Properties properties = reader.readProperties();
+
+    if (!reader.isOk() || tileWidth <= 0 || tileHeight <= 0 || firstGid == 0) {
+        mError = tr("Invalid tileset parameters for tileset '%1'").arg(name);
+        return SharedTileset();
+    }
+
+    SharedTileset tileset(Tileset::create(name,
+                                          tileWidth, tileHeight,
+                                          spacing, margin));
+
+    tileset->setTileOffset(QPoint(tileOffsetX, tileOffsetY));
+    tileset->setTransparentColor(transparentColor);
+    tileset->setProperties(properties);
+
+    if (!image.isEmpty()) {
+        const QString imagePath = resolvePath(mMapDir, image);
+        if (!tileset->loadFromImage(imagePath)) {
+            mError = tr("Error loading tileset image:\n'%1'").arg(imagePath);
+            return SharedTileset();
+        }
+    }
+
+    mGidMapper.insert(firstGid, tileset.data());
+    if (!image.isEmpty())
+        mGidMapper.setTilesetWidth(tileset.data(), imageWidth);
+
+    const quint32 terrainCount = reader.read<quint32>();
+    for (quint32 i = 0; i < terrainCount && reader.isOk(); ++i) {
+        const QString terrainName = reader.readString();
+        const int imageTileId = reader.read<qint32>();
+        const Properties terrainProperties = reader.readProperties();
+
+        Terrain *terrain = tileset->addTerrain(terrainName, imageTileId);
+        terrain->setProperties(terrainProperties);
+    }
+
+    // Image collection tilesets store every tile, other tilesets only the
+    // tiles that carry additional information
+    const quint32 tileCount = reader.read<quint32>();
+    for (quint32 i = 0; i < tileCount && reader.isOk(); ++i) {
+        const int id = reader.read<qint32>();
+        const unsigned terrain = reader.read<quint32>();
+        const double probability = reader.readReal();
+        const QString tileImage = reader.readString();
+        const Properties tileProperties = reader.readProperties();
+
+        QScopedPointer<ObjectGroup> objectGroup;
+        if (reader.readBool()) {
+            objectGroup.reset(readObjectGroup(reader));
+            if (!objectGroup)
+                return SharedTileset();
+        }
+
+        const quint32 frameCount = reader.read<quint32>();
+        QVector<Frame> frames;
+        for (quint32 j = 0; j < frameCount && reader.isOk(); ++j) {
+            Frame frame;
+            frame.tileId = reader.read<qint32>();
+            frame.duration = reader.read<qint32>();
+            frames.append(frame);
+        }
+
+        if (!reader.isOk())
+            break;
+
+        Tile *tile;
+        if (image.isEmpty()) {
+            if (id != tileset->tileCount()) {
+                mError = tr("Invalid tile ID %1 in tileset '%2'").arg(id).arg(name);
+                return SharedTileset();
+            }
+
+            const QString imagePath = resolvePath(mMapDir, tileImage);
+            tile = tileset->addTile(QPixmap(imagePath), imagePath);
+        } else {
+            tile = tileset->tileAt(id);
+            if (!tile)
+                continue;
+        }
+
+        tile->setTerrain(terrain);
+        tile->setProbability(float(probability));
+        tile->setProperties(tileProperties);
+        if (objectGroup)
+            tile->setObjectGroup(objectGroup.take());
+        if (!frames.isEmpty())
+            tile->setFrames(frames);
+    }
+
+    if (!reader.isOk()) {
+        mError = tr("Corrupt tileset '%1'").arg(name);
+        return SharedTileset();
+    }
+
+    return tileset;
+}
+
+Layer *BinaryPlugin::readLayer(ChunkReader &reader, const char *data,
+                               const QVector<ChunkEntry> &entries)
+{
+    const quint32 type = reader.read<quint32>();
+
+    switch (type) {
+    case Layer::TileLayerType:
+        break;
+    case Layer::ObjectGroupType:
+        return readObjectGroup(reader);
+    case Layer::ImageLayerType:
+        return readImageLayer(reader);
+    default:
+        mError = tr("Unknown layer type: %1").arg(type);
+        return nullptr;
+    }
+
+    const LayerAttributes attributes = readLayerAttributes(reader);
+    const quint32 cellsIndex = reader.read<quint32>();
+
+    if (!reader.isOk() || attributes.width < 0 || attributes.height < 0 ||
+            cellsIndex >= quint32(entries.size()) ||
+            entries.at(cellsIndex).type != CellsChunk) {
+        mError = tr("Corrupt layer '%1'").arg(attributes.name);
+        return nullptr;
+    }
+
+    QScopedPointer<TileLayer> tileLayer(new TileLayer(attributes.name,
+                                                      attributes.x,
+                                                      attributes.y,
+                                                      attributes.width,
+                                                      attributes.height));
+    applyLayerAttributes(tileLayer.data(), attributes);
+
+    const ChunkEntry &entry = entries.at(cellsIndex);
+
+    if (tileLayer->isVisible()) {
+        QByteArray cells;
+        if (!readChunk(data, entry, cells))
+            return nullptr;
+        if (!readTileLayerData(tileLayer.data(), cells))
+            return nullptr;
+    } else {
+        // Hidden layers are decoded when their cells are first accessed.
+        // Their stored data is copied since the file is unmapped after
+        // reading.
+        const QByteArray stored(data + entry.offset, int(entry.size));
+        ChunkEntry storedEntry = entry;
+        storedEntry.offset = 0;
+        const GidMapper gidMapper = mGidMapper;
+
+        tileLayer->setCellLoader([=] (TileLayer &layer) {
+            QByteArray cells;
+            GidMapper::DecodeError error = GidMapper::CorruptLayerData;
+
+            if (chunkData(stored.constData(), storedEntry, cells) &&
+                    cells.size() == qint64(layer.width()) * layer.height() * 4) {
+                error = gidMapper.decodeLayerData(layer,
+                                                  reinterpret_cast<const uchar*>(cells.constData()));
+            }
+
+            if (error != GidMapper::NoError) {
+                qWarning().nospace() << "Failed to load layer "
+                                     << layer.name()
+                                     << " (error " << error << ")";
+            }
+        });
+    }
+
+    return tileLayer.take();
+}
+
+bool BinaryPlugin::readTileLayerData(TileLayer *tileLayer,
+                                     const QByteArray &data)
+{
+    if (data.size() != qint64(tileLayer->width()) * tileLayer->height() * 4) {
+        mError = tr("Corrupt layer data for layer '%1'").arg(tileLayer->name());
+        return false;
+    }
+
+    const GidMapper::DecodeError error =
+            mGidMapper.decodeLayerData(*tileLayer,
+                                       reinterpret_cast<const uchar*>(data.constData()));
+
+    switch (error) {
+    case GidMapper::CorruptLayerData:
+        mError = tr("Corrupt layer data for layer '%1'").arg(tileLayer->name());
+        return false;
+    case GidMapper::TileButNoTilesets:
+        mError = tr("Tile used but no tilesets specified");
+        return false;
+    case GidMapper::InvalidTile:
+        mError = tr("Invalid tile: %1").arg(mGidMapper.invalidTile());
+        return false;
+    case GidMapper::NoError:
+        break;
+    }
+
+    return true;
+}
+
+ObjectGroup *BinaryPlugin::readObjectGroup(ChunkReader &reader)
+{
+    const LayerAttributes attributes = readLayerAttributes(reader);
+
+    QScopedPointer<ObjectGroup> objectGroup(new ObjectGroup(attributes.name,
+                                                            attributes.x,
+                                                            attributes.y,
+                                                            attributes.width,
+                                                            attributes.height));
+    applyLayerAttributes(objectGroup.data(), attributes);
+
+    objectGroup->setColor(reader.readColor());
+    if (reader.read<qint32>() == ObjectGroup::IndexOrder)
+        objectGroup->setDrawOrder(ObjectGroup::IndexOrder);
+
+    const quint32 objectCount = reader.read<quint32>();
+    for (quint32 i = 0; i < objectCount && reader.isOk(); ++i) {
+        const int id = reader.read<qint32>();
+        const QString name = reader.readString();
+        const QString type = reader.readString();
+        const double x = reader.readReal();
+        const double y = reader.readReal();
+        const double width = reader.readReal();
+        const double height = reader.readReal();
+        const double rotation = reader.readReal();
+        const bool visible = reader.readBool();
+        const quint32 shape = reader.read<quint32>();
+        const unsigned gid = reader.read<quint32>();
+
+        QPolygonF polygon;
+        const quint32 pointCount = reader.read<quint32>();
+        for (quint32 j = 0; j < pointCount && reader.isOk(); ++j) {
+            const double pointX = reader.readReal();
+            const double pointY = reader.readReal();
+            polygon.append(QPointF(pointX, pointY));
+        }
+
+        const Properties properties = reader.readProperties();
+
+        if (!reader.isOk())
+            break;
+
+        MapObject *object = new MapObject(name, type, QPointF(x, y),
+                                          QSizeF(width, height));
+        object->setId(id);
+        object->setRotation(rotation);
+        object->setVisible(visible);
+        if (shape <= MapObject::Ellipse)
+            object->setShape(MapObject::Shape(shape));
+        object->setPolygon(polygon);
+        object->setProperties(properties);
+
+        if (gid) {
+            bool ok;
+            const Cell cell = mGidMapper.gidToCell(gid, ok);
+            if (ok)
+                object->setCell(cell);
+        }
+
+        objectGroup->addObject(object);
+    }
+
+    if (!reader.isOk()) {
+        mError = tr("Corrupt object layer '%1'").arg(attributes.name);
+        return nullptr;
+    }
+
+    return objectGroup.take();
+}
+
+ImageLayer *BinaryPlugin::readImageLayer(ChunkReader &reader)
+{
+    const LayerAttributes attributes = readLayerAttributes(reader);
+    const QString image = reader.readString();
+    const QColor transparentColor = reader.readColor();
+
+    if (!reader.isOk()) {
+        mError = tr("Corrupt image layer '%1'").arg(attributes.name);
+        return nullptr;
+    }
+
+    QScopedPointer<ImageLayer> imageLayer(new ImageLayer(attributes.name,
+                                                         attributes.x,
+                                                         attributes.y,
+                                                         attributes.width,
+                                                         attributes.height));
+    applyLayerAttributes(imageLayer.data(), attributes);
+    imageLayer->setTransparentColor(transparentColor);
+
+    if (!image.isEmpty()) {
+        const QString imagePath = resolvePath(mMapDir, image);
+        if (!imageLayer->loadFromImage(QImage(imagePath), imagePath)) {
+            mError = tr("Error loading image:\n'%1'").arg(imagePath);
+            return nullptr;
+        }
+    }
+
+    return imageLayer.take();
+}
+
+bool BinaryPlugin::write(const Map *map, const QString &fileName)
+{
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
+    mMapDir = QFileInfo(fileName).dir();
+    mGidMapper.clear();
+
+    QVector<Chunk> chunks;
+
+    ChunkWriter mapWriter;
+    mapWriter.write<quint32>(map->orientation());
+    mapWriter.write<quint32>(map->renderOrder());
+    mapWriter.write<qint32>(map->width());
+    mapWriter.write<qint32>(map->height());
+    mapWriter.write<qint32>(map->tileWidth());
+    mapWriter.write<qint32>(map->tileHeight());
+    mapWriter.write<qint32>(map->hexSideLength());
+    mapWriter.write<quint32>(map->staggerAxis());
+    mapWriter.write<quint32>(map->staggerIndex());
+    mapWriter.write<qint32>(map->nextObjectId());
+    mapWriter.write<quint32>(map->layerDataFormat());
+    mapWriter.writeColor(map->backgroundColor());
+    mapWriter.writeProperties(map->properties());
+    chunks.append(makeChunk(MapChunk, mapWriter.data()));
+
+    // All tilesets are known before writing any, since tile collision
+    // objects may refer to tiles from other tilesets
+    unsigned firstGid = 1;
+    for (const SharedTileset &tileset : map->tilesets()) {
+        mGidMapper.insert(firstGid, tileset.data());
+        firstGid += tileset->tileCount();
+    }
+
+    firstGid = 1;
+    for (const SharedTileset &tileset : map->tilesets()) {
+        ChunkWriter writer;
+        writeTileset(writer, tileset.data(), firstGid);
+        chunks.append(makeChunk(TilesetChunk, writer.data()));
+        firstGid += tileset->tileCount();
+    }
+
+    CompressionMethod method;
+    const bool compressed = compressionMethod(map->layerDataFormat(), method) &&
+            compressionSupported(method);
+
+    for (const Layer *layer : map->layers()) {
+        ChunkWriter writer;
+        writer.write<quint32>(layer->layerType());
+
+        switch (layer->layerType()) {
+        case Layer::TileLayerType: {
+            const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+            writeLayerAttributes(writer, tileLayer);
+
+            // Refers to the chunk holding the cells, which follows this one
+            writer.write<quint32>(chunks.size() + 1);
+            chunks.append(makeChunk(LayerChunk, writer.data()));
+
+            Chunk cells = makeChunk(CellsChunk, tileLayerData(tileLayer));
+            if (compressed) {
+                const QByteArray compressedCells = compress(cells.data, method);
+                if (!compressedCells.isNull()) {
+                    cells.compression = method + 1;
+                    cells.data = compressedCells;
+                }
+            }
+            chunks.append(cells);
+            continue;
+        }
+        case Layer::ObjectGroupType:
+            writeObjectGroup(writer, static_cast<const ObjectGroup*>(layer));
+            break;
+        case Layer::ImageLayerType:
+            writeImageLayer(writer, static_cast<const ImageLayer*>(layer));
+            break;
+        }
+
+        chunks.append(makeChunk(LayerChunk, writer.data()));
+    }
+
+    // Lay out the chunks at aligned offsets after the directory
+    ChunkWriter header;
+    header.write<quint32>(Magic);
+    header.write<quint32>(Version);
+    header.write<quint32>(chunks.size());
+    header.write<quint32>(0);   // reserved
+
+    QVector<quint64> offsets;
+    quint64 offset = HeaderSize + quint64(chunks.size()) * ChunkEntrySize;
+    for (const Chunk &chunk : chunks) {
+        offset = (offset + ChunkAlignment - 1) & ~(ChunkAlignment - 1);
+        offsets.append(offset);
+
+        header.write<quint32>(chunk.type);
+        header.write<quint32>(chunk.compression);
+        header.write<quint64>(offset);
+        header.write<quint64>(chunk.data.size());
+        header.write<quint64>(chunk.uncompressedSize);
+
+        offset += chunk.data.size();
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        mError = tr("Could not open file for writing.");
+        return false;
+    }
+
+    file.write(header.data());
+
+    quint64 position = header.data().size();
+    for (int i = 0; i < chunks.size(); ++i) {
+        const Chunk &chunk = chunks.at(i);
+        file.write(QByteArray(int(offsets.at(i) - position), '\0'));
+        file.write(chunk.data);
+        position = offsets.at(i) + chunk.data.size();
+    }
+
+    if (file.error() != QFile::NoError) {
+        mError = tr("Error while writing file:\n%1").arg(file.errorString());
+        return false;
+    }
+
+    if (!file.commit()) {
+        mError = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void BinaryPlugin::writeTileset(ChunkWriter &writer, const Tileset *tileset,
+                                unsigned firstGid)
+{
+    writer.write<quint32>(firstGid);
+
+    // External tilesets are only referenced
+    const QString &fileName = tileset->fileName();
+    if (!fileName.isEmpty()) {
+        writer.writeString(mMapDir.relativeFilePath(fileName));
+        return;
+    }
+    writer.writeString(QString());
+
+    const QString &imageSource = tileset->imageSource();
+    const bool hasImage = !imageSource.isEmpty();
+
+    writer.writeString(tileset->name());
+    writer.write<qint32>(tileset->tileWidth());
+    writer.write<qint32>(tileset->tileHeight());
+    writer.write<qint32>(tileset->tileSpacing());
+    writer.write<qint32>(tileset->margin());
+    writer.write<qint32>(tileset->tileOffset().x());
+    writer.write<qint32>(tileset->tileOffset().y());
+    writer.writeColor(tileset->transparentColor());
+    writer.writeString(hasImage ? mMapDir.relativeFilePath(imageSource) : QString());
+    writer.write<qint32>(tileset->imageWidth());
+    writer.write<qint32>(tileset->imageHeight());
+    writer.writeProperties(tileset->properties());
+
+    writer.write<quint32>(tileset->terrainCount());
+    for (int i = 0; i < tileset->terrainCount(); ++i) {
+        const Terrain *terrain = tileset->terrain(i);
+        writer.writeString(terrain->name());
+        writer.write<qint32>(terrain->imageTileId());
+        writer.writeProperties(terrain->properties());
+    }
+
+    const QList<Tile*> candidates = hasImage ? tileset->tilesWithMetadata()
+                                             : tileset->tiles();
+
+    QVector<const Tile*> tiles;
+    for (const Tile *tile : candidates) {
+        if (!hasImage || hasTileData(tile))
+            tiles.append(tile);
+    }
+
+    writer.write<quint32>(tiles.size());
+    for (const Tile *tile : tiles) {
+        const QString &tileImage = tile->imageSource();
+
+        writer.write<qint32>(tile->id());
+        writer.write<quint32>(tile->terrain());
+        writer.writeReal(tile->probability());
+        writer.writeString(tileImage.isEmpty() ? QString() : mMapDir.relativeFilePath(tileImage));
+        writer.writeProperties(tile->properties());
+
+        writer.writeBool(tile->objectGroup());
+        if (tile->objectGroup())
+            writeObjectGroup(writer, tile->objectGroup());
+
+        writer.write<quint32>(tile->frames().size());
+        for (const Frame &frame : tile->frames()) {
+            writer.write<qint32>(frame.tileId);
+            writer.write<qint32>(frame.duration);
+        }
+    }
+}
+
+void BinaryPlugin::writeLayerAttributes(ChunkWriter &writer, const Layer *layer)
+{
+    writer.writeString(layer->name());
+    writer.write<qint32>(layer->x());
+    writer.write<qint32>(layer->y());
+    writer.write<qint32>(layer->width());
+    writer.write<qint32>(layer->height());
+    writer.writeReal(layer->opacity());
+    writer.writeBool(layer->isVisible());
+    writer.writeReal(layer->offset().x());
+    writer.writeReal(layer->offset().y());
+    writer.writeProperties(layer->properties());
+}
+
+void BinaryPlugin::writeObjectGroup(ChunkWriter &writer,
+                                    const ObjectGroup *objectGroup)
+{
+    writeLayerAttributes(writer, objectGroup);
+    writer.writeColor(objectGroup->color());
+    writer.write<qint32>(objectGroup->drawOrder());
+
+    writer.write<quint32>(objectGroup->objectCount());
+    for (const MapObject *object : objectGroup->objects()) {
+        writer.write<qint32>(object->id());
+        writer.writeString(object->name());
+        writer.writeString(object->type());
+        writer.writeReal(object->x());
+        writer.writeReal(object->y());
+        writer.writeReal(object->width());
+        writer.writeReal(object->height());
+        writer.writeReal(object->rotation());
+        writer.writeBool(object->isVisible());
+        writer.write<quint32>(object->shape());
+        writer.write<quint32>(object->cell().isEmpty() ? 0 : mGidMapper.cellToGid(object->cell()));
+
+        const QPolygonF &polygon = object->polygon();
+        writer.write<quint32>(polygon.size());
+        for (const QPointF &point : polygon) {
+            writer.writeReal(point.x());
+            writer.writeReal(point.y());
+        }
+
+        writer.writeProperties(object->properties());
+    }
+}
+
+void BinaryPlugin::writeImageLayer(ChunkWriter &writer,
+                                   const ImageLayer *imageLayer)
+{
+    const QString &imageSource = imageLayer->imageSource();
+
+    writeLayerAttributes(writer, imageLayer);
+    writer.writeString(imageSource.isEmpty() ? QString() : mMapDir.relativeFilePath(imageSource));
+    writer.writeColor(imageLayer->transparentColor());
+}
+
+/**
+ * Returns the global tile IDs of the given \a tileLayer as little-endian
+ * 32-bit integers, row by row.
+ */
+QByteArray BinaryPlugin::tileLayerData(const TileLayer *tileLayer) const
+{
+    const int width = tileLayer->width();
+    const int height = tileLayer->height();
+
+    QByteArray data(width * height * 4, Qt::Uninitialized);
+    unsigned *gids = reinterpret_cast<unsigned*>(data.data());
+
+    for (int y = 0; y < height; ++y) {
+        mGidMapper.cellsToGids(*tileLayer, y, gids);
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+        for (int x = 0; x < width; ++x)
+            gids[x] = qToLittleEndian<quint32>(gids[x]);
+#endif
+        gids += width;
+    }
+
+    return data;
+}
+
+} // namespace Binary
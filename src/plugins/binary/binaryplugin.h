@@ -0,0 +1,103 @@
+/*
+ * Binary Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINARYPLUGIN_H
+#define BINARYPLUGIN_H
+
+#include "binary_global.h"
+
+#include "gidmapper.h"
+#include "mapformat.h"
+
+#include <QDir>
+#include <QObject>
+#include <QVector>
+
+namespace Tiled {
+class ImageLayer;
+class Layer;
+class ObjectGroup;
+class TileLayer;
+}
+
+namespace Binary {
+
+class ChunkReader;
+class ChunkWriter;
+struct ChunkEntry;
+
+/**
+ * A compact binary map format, meant for fast saving and loading.
+ *
+ * The file starts with a header and a directory of chunks, followed by the
+ * chunks themselves. Each directory entry stores the type, compression,
+ * offset and size of a chunk. Chunks start at 16-byte aligned offsets, so
+ * that uncompressed tile layer data can be used directly from a memory
+ * mapped file, and any layer can be read without parsing the others.
+ *
+ * The map attributes are stored in the first chunk, followed by a chunk for
+ * each tileset and for each layer. The global tile IDs of a tile layer are
+ * stored in a separate chunk, as little-endian 32-bit integers, compressed
+ * according to the layer data format of the map.
+ */
+class BINARYSHARED_EXPORT BinaryPlugin : public Tiled::MapFormat
+{
+    Q_OBJECT
+    Q_INTERFACES(Tiled::MapFormat)
+    Q_PLUGIN_METADATA(IID "org.mapeditor.MapFormat" FILE "plugin.json")
+
+public:
+    BinaryPlugin();
+
+    Tiled::Map *read(const QString &fileName) override;
+    bool supportsFile(const QString &fileName) const override;
+
+    bool write(const Tiled::Map *map, const QString &fileName) override;
+    QString nameFilter() const override;
+    QString errorString() const override;
+
+private:
+    Tiled::Map *readMap(const char *data, qint64 size);
+    bool readChunk(const char *data, const ChunkEntry &entry, QByteArray &out);
+    Tiled::SharedTileset readTileset(ChunkReader &reader);
+    Tiled::Layer *readLayer(ChunkReader &reader, const char *data,
+                            const QVector<ChunkEntry> &entries);
+    Tiled::ObjectGroup *readObjectGroup(ChunkReader &reader);
+    Tiled::ImageLayer *readImageLayer(ChunkReader &reader);
+    bool readTileLayerData(Tiled::TileLayer *tileLayer,
+                           const QByteArray &data);
+
+    void writeTileset(ChunkWriter &writer,
+                      const Tiled::Tileset *tileset, unsigned firstGid);
+    void writeLayerAttributes(ChunkWriter &writer, const Tiled::Layer *layer);
+    void writeObjectGroup(ChunkWriter &writer,
+                          const Tiled::ObjectGroup *objectGroup);
+    void writeImageLayer(ChunkWriter &writer,
+                         const Tiled::ImageLayer *imageLayer);
+    QByteArray tileLayerData(const Tiled::TileLayer *tileLayer) const;
+
+    QString mError;
+    QDir mMapDir;     // The directory in which the map is being read or saved
+    Tiled::GidMapper mGidMapper;
+};
+
+} // namespace Binary
+
+#endif // BINARYPLUGIN_H
@@ -0,0 +1,101 @@
+/*
+ * Binary Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binarystream.h"
+
+#include <cstring>
+
+using namespace Tiled;
+
+namespace Binary {
+
+void ChunkWriter::writeReal(double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write<quint64>(bits);
+}
+
+void ChunkWriter::writeString(const QString &string)
+{
+    const QByteArray utf8 = string.toUtf8();
+    write<quint32>(utf8.size());
+    mData.append(utf8);
+}
+
+void ChunkWriter::writeColor(const QColor &color)
+{
+    writeBool(color.isValid());
+    write<quint32>(color.isValid() ? color.rgba() : 0);
+}
+
+void ChunkWriter::writeProperties(const Properties &properties)
+{
+    write<quint32>(properties.size());
+
+    Properties::const_iterator it = properties.constBegin();
+    Properties::const_iterator it_end = properties.constEnd();
+    for (; it != it_end; ++it) {
+        writeString(it.key());
+        writeString(it.value());
+    }
+}
+
+
+double ChunkReader::readReal()
+{
+    const quint64 bits = read<quint64>();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+QString ChunkReader::readString()
+{
+    const quint32 size = read<quint32>();
+    if (!ensure(size))
+        return QString();
+
+    const QString string = QString::fromUtf8(mPos, int(size));
+    mPos += size;
+    return string;
+}
+
+QColor ChunkReader::readColor()
+{
+    const bool valid = readBool();
+    const QRgb rgba = read<quint32>();
+    return valid ? QColor::fromRgba(rgba) : QColor();
+}
+
+Properties ChunkReader::readProperties()
+{
+    Properties properties;
+
+    const quint32 count = read<quint32>();
+    for (quint32 i = 0; i < count && mOk; ++i) {
+        const QString name = readString();
+        properties.insert(name, readString());
+    }
+
+    return properties;
+}
+
+} // namespace Binary
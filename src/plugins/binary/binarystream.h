@@ -0,0 +1,127 @@
+/*
+ * Binary Tiled Plugin
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINARYSTREAM_H
+#define BINARYSTREAM_H
+
+#include "properties.h"
+
+#include <QByteArray>
+#include <QColor>
+#include <QString>
+#include <QtEndian>
+
+namespace Binary {
+
+/**
+ * An entry in the chunk directory of a binary map file. The compression is
+ * either 0, for uncompressed data, or the Tiled::CompressionMethod + 1.
+ */
+struct ChunkEntry
+{
+    quint32 type;
+    quint32 compression;
+    quint64 offset;
+    quint64 size;
+    quint64 uncompressedSize;
+};
+
+/**
+ * Appends little-endian encoded values to the data of a chunk.
+ *
+ * Strings are stored as their UTF-8 encoded length followed by the UTF-8
+ * data, reals as IEEE 754 doubles and colors as a validity flag followed
+ * by their ARGB value.
+ */
+class ChunkWriter
+{
+public:
+    template<typename T>
+    void write(T value)
+    {
+        uchar buffer[sizeof(T)];
+        qToLittleEndian<T>(value, buffer);
+        mData.append(reinterpret_cast<const char*>(buffer), sizeof(T));
+    }
+
+    void writeBool(bool value) { write<quint8>(value); }
+    void writeReal(double value);
+    void writeString(const QString &string);
+    void writeColor(const QColor &color);
+    void writeProperties(const Tiled::Properties &properties);
+
+    const QByteArray &data() const { return mData; }
+
+private:
+    QByteArray mData;
+};
+
+/**
+ * Reads values written by ChunkWriter from the data of a chunk.
+ *
+ * Reading past the end of the data returns default values and marks the
+ * reader as failed, so a sequence of reads only needs to be checked once,
+ * using isOk().
+ */
+class ChunkReader
+{
+public:
+    ChunkReader(const char *data, qint64 size)
+        : mPos(data)
+        , mEnd(data + size)
+        , mOk(true)
+    {}
+
+    template<typename T>
+    T read()
+    {
+        if (!ensure(sizeof(T)))
+            return T();
+
+        const T value = qFromLittleEndian<T>(reinterpret_cast<const uchar*>(mPos));
+        mPos += sizeof(T);
+        return value;
+    }
+
+    bool readBool() { return read<quint8>() != 0; }
+    double readReal();
+    QString readString();
+    QColor readColor();
+    Tiled::Properties readProperties();
+
+    bool isOk() const { return mOk; }
+
+private:
+    bool ensure(qint64 size)
+    {
+        if (mOk && mEnd - mPos >= size)
+            return true;
+        mOk = false;
+        return false;
+    }
+
+    const char *mPos;
+    const char *mEnd;
+    bool mOk;
+};
+
+} // namespace Binary
+
+#endif // BINARYSTREAM_H
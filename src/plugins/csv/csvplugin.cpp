@@ -23,11 +23,16 @@
 #include "map.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tileset.h"
 
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QRunnable>
 #include <QSaveFile>
+#include <QSet>
+#include <QThreadPool>
 
 using namespace Tiled;
 using namespace Csv;
@@ -36,58 +41,173 @@ CsvPlugin::CsvPlugin()
 {
 }
 
-bool CsvPlugin::write(const Map *map, const QString &fileName)
+/**
+ * Appends the decimal representation of \a value to \a out, without the
+ * temporary allocation done by QByteArray::number.
+ */
+static void appendNumber(QByteArray &out, int value)
 {
-    // Get file paths for each layer
-    QStringList layerPaths = outputFiles(map, fileName);
+    char buffer[12];
+    char *end = buffer + sizeof(buffer);
+    char *p = end;
 
-    // Traverse all tile layers
-    uint currentLayer = 0u;
-    foreach (const Layer *layer, map->layers()) {
-        if (layer->layerType() != Layer::TileLayerType)
-            continue;
-            
-        const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+    const bool negative = value < 0;
+    unsigned u = negative ? 0u - unsigned(value) : unsigned(value);
 
-        QSaveFile file(layerPaths.at(currentLayer));
+    do {
+        *--p = char('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
 
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            mError = tr("Could not open file for writing.");
-            return false;
-        }
+    if (negative)
+        *--p = '-';
+
+    out.append(p, int(end - p));
+}
+
+namespace {
+
+/**
+ * Writes one tile layer to its own file. Independent layers are written in
+ * parallel, so the writer only reads the layer and the shared tile names.
+ */
+class LayerWriter : public QRunnable
+{
+public:
+    LayerWriter(const TileLayer *tileLayer,
+                const QHash<const Tile*, QByteArray> &tileNames,
+                const QString &fileName)
+        : mTileLayer(tileLayer)
+        , mTileNames(tileNames)
+        , mFileName(fileName)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override;
+
+    const QString &errorString() const { return mError; }
+
+private:
+    const TileLayer *mTileLayer;
+    const QHash<const Tile*, QByteArray> &mTileNames;
+    QString mFileName;
+    QString mError;
+};
+
+void LayerWriter::run()
+{
+    QSaveFile file(mFileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        mError = CsvPlugin::tr("Could not open file for writing.");
+        return;
+    }
+
+    // Rows are gathered in a buffer that is written out in large chunks
+    const int chunkSize = 64 * 1024;
+    const int width = mTileLayer->width();
+    const int height = mTileLayer->height();
+
+    QByteArray buffer;
+    buffer.reserve(chunkSize + width * 12);
 
-        // Write out tiles either by ID or their name, if given. -1 is "empty"
-        for (int y = 0; y < tileLayer->height(); ++y) {
-            for (int x = 0; x < tileLayer->width(); ++x) {
-                if (x > 0)
-                    file.write(",", 1);
-    
-                const Cell &cell = tileLayer->cellAt(x, y);
-                const Tile *tile = cell.tile;
-                if (tile && tile->hasProperty(QLatin1String("name"))) {
-                    file.write(tile->property(QLatin1String("name")).toUtf8());
-                } else {
-                    const int id = tile ? tile->id() : -1;
-                    file.write(QByteArray::number(id));
+    // Write out tiles either by ID or their name, if given. -1 is "empty"
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (x > 0)
+                buffer.append(',');
+
+            const Tile *tile = mTileLayer->cellAt(x, y).tile;
+            if (!tile) {
+                buffer.append("-1", 2);
+                continue;
+            }
+
+            if (!mTileNames.isEmpty()) {
+                auto it = mTileNames.constFind(tile);
+                if (it != mTileNames.constEnd()) {
+                    buffer.append(it.value());
+                    continue;
                 }
             }
-    
-            file.write("\n", 1);
+
+            appendNumber(buffer, tile->id());
         }
-    
-        if (file.error() != QFile::NoError) {
-            mError = file.errorString();
-            return false;
+
+        buffer.append('\n');
+
+        if (buffer.size() >= chunkSize) {
+            file.write(buffer);
+            buffer.resize(0);
         }
+    }
+
+    file.write(buffer);
+
+    if (file.error() != QFile::NoError) {
+        mError = file.errorString();
+        return;
+    }
+
+    if (!file.commit())
+        mError = file.errorString();
+}
 
-        if (!file.commit()) {
-            mError = file.errorString();
-            return false;
+} // anonymous namespace
+
+bool CsvPlugin::write(const Map *map, const QString &fileName)
+{
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
+    // Get file paths for each layer
+    const QStringList layerPaths = outputFiles(map, fileName);
+
+    // Look up the tile names once, rather than for each cell
+    QHash<const Tile*, QByteArray> tileNames;
+    const QString nameProperty = QLatin1String("name");
+    for (const SharedTileset &tileset : map->tilesets()) {
+        for (const Tile *tile : tileset->tiles()) {
+            if (tile->hasProperty(nameProperty))
+                tileNames.insert(tile, tile->property(nameProperty).toUtf8());
         }
+    }
 
-        ++currentLayer;
+    const QList<TileLayer*> tileLayers = map->tileLayers();
+
+    QVector<LayerWriter*> writers;
+    writers.reserve(tileLayers.size());
+    for (int i = 0; i < tileLayers.size(); ++i)
+        writers.append(new LayerWriter(tileLayers.at(i), tileNames, layerPaths.at(i)));
+
+    // Layers with the same name share a file, so they can't be written at once
+    const bool parallel = writers.size() > 1 &&
+            layerPaths.toSet().size() == layerPaths.size();
+
+    if (!parallel) {
+        for (LayerWriter *writer : writers)
+            writer->run();
+    } else {
+        QThreadPool pool;
+        for (LayerWriter *writer : writers)
+            pool.start(writer);
+        pool.waitForDone();
     }
-    return true;
+
+    // Report the error of the first layer that failed
+    bool succeeded = true;
+    for (LayerWriter *writer : writers) {
+        if (succeeded && !writer->errorString().isEmpty()) {
+            mError = writer->errorString();
+            succeeded = false;
+        }
+    }
+
+    qDeleteAll(writers);
+    return succeeded;
 }
 
 QString CsvPlugin::errorString() const
@@ -96,6 +96,11 @@ bool DroidcraftPlugin::write(const Tiled::Map *map, const QString &fileName)
 {
     using namespace Tiled;
 
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
     // Check layer count and type
     if (map->layerCount() != 1 || !map->layerAt(0)->isTileLayer()) {
         mError = tr("The map needs to have exactly one tile layer!");
@@ -22,6 +22,7 @@
 
 #include "flareplugin.h"
 
+#include "csvparser.h"
 #include "gidmapper.h"
 #include "map.h"
 #include "mapobject.h"
@@ -36,6 +37,7 @@
 #include <QSettings>
 #include <QStringList>
 #include <QTextStream>
+#include <QtEndian>
 
 using namespace Flare;
 using namespace Tiled;
@@ -44,6 +46,31 @@ FlarePlugin::FlarePlugin()
 {
 }
 
+/**
+ * Finds the next line between \a pos and \a end, which is returned through
+ * \a lineBegin and \a lineEnd without its line ending. Returns false at the
+ * end of the data.
+ */
+static bool nextLine(const char *&pos, const char *end,
+                     const char *&lineBegin, const char *&lineEnd)
+{
+    if (pos == end)
+        return false;
+
+    lineBegin = pos;
+    while (pos != end && *pos != '\n')
+        ++pos;
+
+    lineEnd = pos;
+    if (lineEnd != lineBegin && lineEnd[-1] == '\r')
+        --lineEnd;
+
+    if (pos != end)
+        ++pos;
+
+    return true;
+}
+
 Tiled::Map *FlarePlugin::read(const QString &fileName)
 {
     QFile file(fileName);
@@ -56,7 +83,13 @@ Tiled::Map *FlarePlugin::read(const QString &fileName)
     // default to values of the original flare alpha game.
     QScopedPointer<Map> map(new Map(Map::Isometric, 256, 256, 64, 32));
 
-    QTextStream stream (&file);
+    // The layer data is parsed straight from the bytes of the file
+    const QByteArray contents = file.readAll();
+    const char *pos = contents.constData();
+    const char *end = pos + contents.size();
+    const char *lineBegin;
+    const char *lineEnd;
+
     QString line;
     QString sectionName;
     bool newsection = false;
@@ -71,8 +104,8 @@ Tiled::Map *FlarePlugin::read(const QString &fileName)
     bool headerSectionFound = false;
     bool tilelayerSectionFound = false; // tile layer or objects
 
-    while (!stream.atEnd()) {
-        line = stream.readLine();
+    while (nextLine(pos, end, lineBegin, lineEnd)) {
+        line = QString::fromUtf8(lineBegin, int(lineEnd - lineBegin));
 
         if (!line.length())
             continue;
@@ -166,19 +199,26 @@ Tiled::Map *FlarePlugin::read(const QString &fileName)
                         base = 16;
                     }
                 } else if (key == QLatin1String("data")) {
-                    for (int y=0; y < map->height(); y++) {
-                        line = stream.readLine();
-                        QStringList l = line.split(QChar(','));
-                        for (int x=0; x < qMin(map->width(), l.size()); x++) {
-                            bool ok;
-                            int tileid = l[x].toInt(nullptr, base);
-                            Cell c = gidMapper.gidToCell(tileid, ok);
-                            if (!ok) {
-                                mError += tr("Error mapping tile id %1.").arg(tileid);
-                                return nullptr;
-                            }
-                            tilelayer->setCell(x, y, c);
-                        }
+                    const int width = tilelayer->width();
+                    const int height = tilelayer->height();
+
+                    // Collect the tile ids of each row, then decode them at once
+                    QByteArray gids(width * height * 4, '\0');
+                    uchar *data = reinterpret_cast<uchar*>(gids.data());
+
+                    for (int y = 0; y < height && nextLine(pos, end, lineBegin, lineEnd); ++y) {
+                        CsvParser<char> parser(lineBegin, lineEnd, base);
+                        uchar *row = data + y * width * 4;
+                        unsigned tileId;
+                        bool ok;
+
+                        for (int x = 0; x < width && parser.next(tileId, ok); ++x)
+                            qToLittleEndian<quint32>(tileId, row + x * 4);
+                    }
+
+                    if (gidMapper.decodeLayerData(*tilelayer, data) != GidMapper::NoError) {
+                        mError += tr("Error mapping tile id %1.").arg(gidMapper.invalidTile());
+                        return nullptr;
                     }
                 } else {
                     tilelayer->setProperty(key, value);
@@ -270,6 +310,11 @@ QString FlarePlugin::errorString() const
 
 bool FlarePlugin::write(const Tiled::Map *map, const QString &fileName)
 {
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
     QSaveFile file(fileName);
 
     if (!file.open(QFile::WriteOnly | QFile::Text)) {
@@ -2,9 +2,13 @@ include(../plugin.pri)
 
 DEFINES += JSON_LIBRARY
 
-SOURCES += jsonplugin.cpp \
+SOURCES += jsonmapreader.cpp \
+    jsonmapwriter.cpp \
+    jsonplugin.cpp \
     qjsonparser/json.cpp
 
-HEADERS += jsonplugin.h \
+HEADERS += jsonmapreader.h \
+    jsonmapwriter.h \
+    jsonplugin.h \
     json_global.h \
     qjsonparser/json.h
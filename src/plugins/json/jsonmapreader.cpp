@@ -0,0 +1,452 @@
+/*
+ * JSON Tiled Plugin
+ * Copyright 2011, Porfírio José Pereira Ribeiro <porfirioribeiro@gmail.com>
+ * Copyright 2011, Thorbjørn Lindeijer <thorbjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jsonmapreader.h"
+
+#include <QVector>
+
+#include <algorithm>
+
+namespace Json {
+
+// Limits the recursion, to avoid overflowing the stack on malicious input
+static const int MaxDepth = 512;
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+JsonMapReader::JsonMapReader()
+    : mBegin(nullptr)
+    , mPos(nullptr)
+    , mEnd(nullptr)
+    , mDepth(0)
+{
+}
+
+/**
+ * Parses the UTF-8 encoded JSON between \a begin and \a end. Returns whether
+ * parsing succeeded, in which case the value is available as result().
+ * Otherwise, errorString() describes the problem.
+ */
+bool JsonMapReader::parse(const char *begin, const char *end)
+{
+    mBegin = begin;
+    mPos = begin;
+    mEnd = end;
+    mDepth = 0;
+    mResult.clear();
+    mError.clear();
+
+    // Skip the UTF-8 byte order mark
+    if (mEnd - mPos >= 3 && qstrncmp(mPos, "\xEF\xBB\xBF", 3) == 0)
+        mPos += 3;
+
+    QVariant value;
+    skipWhitespace();
+    if (!parseValue(value))
+        return false;
+
+    skipWhitespace();
+    if (mPos != mEnd)
+        return error(tr("Unexpected data after the end of the document"));
+
+    mResult = value;
+    return true;
+}
+
+bool JsonMapReader::parseValue(QVariant &value)
+{
+    if (mPos == mEnd)
+        return error(tr("Unexpected end of file"));
+
+    switch (*mPos) {
+    case '{':
+        return parseObject(value);
+    case '[':
+        return parseArray(value);
+    case '"': {
+        QString string;
+        if (!parseString(string))
+            return false;
+        value = string;
+        return true;
+    }
+    case 't':
+        return parseLiteral("true", QVariant(true), value);
+    case 'f':
+        return parseLiteral("false", QVariant(false), value);
+    case 'n':
+        return parseLiteral("null", QVariant(), value);
+    default:
+        if (*mPos == '-' || isDigit(*mPos))
+            return parseNumber(value);
+        return error(tr("Unexpected character '%1'").arg(QLatin1Char(*mPos)));
+    }
+}
+
+bool JsonMapReader::parseObject(QVariant &value)
+{
+    if (++mDepth > MaxDepth)
+        return error(tr("Too deeply nested"));
+
+    ++mPos; // '{'
+    QVariantMap map;
+
+    skipWhitespace();
+    if (mPos != mEnd && *mPos == '}') {
+        ++mPos;
+    } else {
+        for (;;) {
+            if (mPos == mEnd || *mPos != '"')
+                return error(tr("Expected a string"));
+
+            QString key;
+            if (!parseString(key))
+                return false;
+
+            skipWhitespace();
+            if (mPos == mEnd || *mPos != ':')
+                return error(tr("Expected ':'"));
+            ++mPos;
+            skipWhitespace();
+
+            QVariant member;
+            if (mPos != mEnd && key == QLatin1String("data")) {
+                if (!parseLayerData(member))
+                    return false;
+            } else if (!parseValue(member)) {
+                return false;
+            }
+            map.insert(key, member);
+
+            skipWhitespace();
+            if (mPos == mEnd)
+                return error(tr("Unexpected end of file"));
+            if (*mPos == '}') {
+                ++mPos;
+                break;
+            }
+            if (*mPos != ',')
+                return error(tr("Expected ',' or '}'"));
+            ++mPos;
+            skipWhitespace();
+        }
+    }
+
+    --mDepth;
+    value = map;
+    return true;
+}
+
+bool JsonMapReader::parseArray(QVariant &value)
+{
+    if (++mDepth > MaxDepth)
+        return error(tr("Too deeply nested"));
+
+    ++mPos; // '['
+    QVariantList list;
+
+    skipWhitespace();
+    if (mPos != mEnd && *mPos == ']') {
+        ++mPos;
+    } else {
+        for (;;) {
+            QVariant element;
+            if (!parseValue(element))
+                return false;
+            list.append(element);
+
+            skipWhitespace();
+            if (mPos == mEnd)
+                return error(tr("Unexpected end of file"));
+            if (*mPos == ']') {
+                ++mPos;
+                break;
+            }
+            if (*mPos != ',')
+                return error(tr("Expected ',' or ']'"));
+            ++mPos;
+            skipWhitespace();
+        }
+    }
+
+    --mDepth;
+    value = list;
+    return true;
+}
+
+/**
+ * Reads the value of a "data" member, which holds tile layer data as either
+ * an array of gids or as a base64 or CSV encoded string.
+ */
+bool JsonMapReader::parseLayerData(QVariant &value)
+{
+    if (*mPos == '[')
+        return parseGids(value);
+    if (*mPos == '"')
+        return parseBytes(value);
+    return parseValue(value);
+}
+
+/**
+ * Reads a plain ASCII string directly into a QByteArray, which avoids
+ * converting encoded layer data to UTF-16 and back. Strings containing
+ * other escape sequences than "\/" are read as regular strings.
+ */
+bool JsonMapReader::parseBytes(QVariant &value)
+{
+    const char *start = mPos;
+    QByteArray bytes;
+
+    ++mPos; // '"'
+    const char *run = mPos;
+
+    while (mPos != mEnd) {
+        const char c = *mPos;
+
+        if (c == '"') {
+            bytes.append(run, int(mPos - run));
+            ++mPos;
+            value = bytes;
+            return true;
+        }
+
+        if (c == '\\') {
+            if (mEnd - mPos < 2 || mPos[1] != '/')
+                break;
+            bytes.append(run, int(mPos - run));
+            mPos += 2;
+            run = mPos - 1;     // keep the slash
+            continue;
+        }
+
+        if (uchar(c) > 127)
+            break;
+
+        ++mPos;
+    }
+
+    mPos = start;
+    QString string;
+    if (!parseString(string))
+        return false;
+    value = string;
+    return true;
+}
+
+/**
+ * Reads an array of unsigned integers directly into a QVector<unsigned>.
+ * When the array turns out to contain anything else, it is read again as
+ * a regular array.
+ */
+bool JsonMapReader::parseGids(QVariant &value)
+{
+    const char *start = mPos;
+    QVector<unsigned> gids;
+
+    ++mPos; // '['
+    skipWhitespace();
+
+    if (mPos != mEnd && *mPos == ']') {
+        mPos = start;
+        return parseArray(value);
+    }
+
+    for (;;) {
+        const char *digits = mPos;
+        quint64 gid = 0;
+
+        while (mPos != mEnd && isDigit(*mPos) && gid <= 0xFFFFFFFFu) {
+            gid = gid * 10 + unsigned(*mPos - '0');
+            ++mPos;
+        }
+
+        if (mPos == digits || gid > 0xFFFFFFFFu)
+            break;
+
+        gids.append(unsigned(gid));
+
+        skipWhitespace();
+        if (mPos == mEnd)
+            break;
+        if (*mPos == ']') {
+            ++mPos;
+            value = QVariant::fromValue(gids);
+            return true;
+        }
+        if (*mPos != ',')
+            break;
+        ++mPos;
+        skipWhitespace();
+    }
+
+    mPos = start;
+    return parseArray(value);
+}
+
+bool JsonMapReader::parseString(QString &string)
+{
+    ++mPos; // '"'
+    const char *run = mPos;
+
+    for (;;) {
+        while (mPos != mEnd && *mPos != '"' && *mPos != '\\')
+            ++mPos;
+
+        if (mPos == mEnd)
+            return error(tr("Unterminated string"));
+
+        if (run != mPos)
+            string.append(QString::fromUtf8(run, int(mPos - run)));
+
+        if (*mPos == '"') {
+            ++mPos;
+            return true;
+        }
+
+        // Escape sequence
+        if (++mPos == mEnd)
+            return error(tr("Unterminated string"));
+
+        switch (*mPos) {
+        case '"':  string.append(QLatin1Char('"')); break;
+        case '\\': string.append(QLatin1Char('\\')); break;
+        case '/':  string.append(QLatin1Char('/')); break;
+        case 'b':  string.append(QLatin1Char('\b')); break;
+        case 'f':  string.append(QLatin1Char('\f')); break;
+        case 'n':  string.append(QLatin1Char('\n')); break;
+        case 'r':  string.append(QLatin1Char('\r')); break;
+        case 't':  string.append(QLatin1Char('\t')); break;
+        case 'u': {
+            if (mEnd - mPos < 5)
+                return error(tr("Invalid escape sequence"));
+
+            ushort code = 0;
+            for (int i = 1; i <= 4; ++i) {
+                const int digit = hexValue(mPos[i]);
+                if (digit < 0)
+                    return error(tr("Invalid escape sequence"));
+                code = ushort(code * 16 + digit);
+            }
+
+            // Surrogate pairs combine by themselves in the UTF-16 string
+            string.append(QChar(code));
+            mPos += 4;
+            break;
+        }
+        default:
+            return error(tr("Invalid escape sequence"));
+        }
+
+        run = ++mPos;
+    }
+}
+
+/**
+ * Numbers that contain a fraction or an exponent become doubles, others
+ * become long longs, matching JsonReader.
+ */
+bool JsonMapReader::parseNumber(QVariant &value)
+{
+    const char *start = mPos;
+    bool isInteger = true;
+
+    if (*mPos == '-')
+        ++mPos;
+
+    while (mPos != mEnd) {
+        const char c = *mPos;
+        if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+            isInteger = false;
+        else if (!isDigit(c))
+            break;
+        ++mPos;
+    }
+
+    const QByteArray number = QByteArray::fromRawData(start, int(mPos - start));
+    bool ok;
+
+    if (isInteger) {
+        const qlonglong integer = number.toLongLong(&ok);
+        if (ok) {
+            value = integer;
+            return true;
+        }
+    }
+
+    const double real = number.toDouble(&ok);
+    if (!ok)
+        return error(tr("Invalid number"));
+
+    value = real;
+    return true;
+}
+
+bool JsonMapReader::parseLiteral(const char *literal,
+                                 const QVariant &literalValue,
+                                 QVariant &value)
+{
+    const int length = int(qstrlen(literal));
+    if (mEnd - mPos < length || qstrncmp(mPos, literal, uint(length)) != 0)
+        return error(tr("Unexpected character '%1'").arg(QLatin1Char(*mPos)));
+
+    mPos += length;
+    value = literalValue;
+    return true;
+}
+
+void JsonMapReader::skipWhitespace()
+{
+    while (mPos != mEnd) {
+        switch (*mPos) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            ++mPos;
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+bool JsonMapReader::error(const QString &message)
+{
+    const int line = int(std::count(mBegin, mPos, '\n')) + 1;
+    mError = tr("%1 on line %2").arg(message).arg(line);
+    return false;
+}
+
+} // namespace Json
@@ -0,0 +1,82 @@
+/*
+ * JSON Tiled Plugin
+ * Copyright 2011, Porfírio José Pereira Ribeiro <porfirioribeiro@gmail.com>
+ * Copyright 2011, Thorbjørn Lindeijer <thorbjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSONMAPREADER_H
+#define JSONMAPREADER_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVariant>
+
+namespace Json {
+
+/**
+ * A single-pass reader for UTF-8 encoded JSON maps. Like JsonReader it
+ * converts JSON objects into QVariantMap and arrays into QVariantList, but
+ * it reads the tokens straight from the given memory without decoding the
+ * whole file to a QString first.
+ *
+ * Arrays stored under a "data" key that only contain unsigned integers,
+ * which is how CSV tile layer data is stored, are read directly into a
+ * QVariant holding a QVector<unsigned>, avoiding one QVariant per tile.
+ * Plain ASCII strings under such a key, like base64 encoded layer data, are
+ * read into a QByteArray. VariantToMapConverter accepts these
+ * representations.
+ */
+class JsonMapReader
+{
+    Q_DECLARE_TR_FUNCTIONS(JsonMapReader)
+
+public:
+    JsonMapReader();
+
+    bool parse(const char *begin, const char *end);
+
+    QVariant result() const { return mResult; }
+    QString errorString() const { return mError; }
+
+private:
+    bool parseValue(QVariant &value);
+    bool parseObject(QVariant &value);
+    bool parseArray(QVariant &value);
+    bool parseLayerData(QVariant &value);
+    bool parseBytes(QVariant &value);
+    bool parseGids(QVariant &value);
+    bool parseString(QString &string);
+    bool parseNumber(QVariant &value);
+    bool parseLiteral(const char *literal, const QVariant &literalValue,
+                      QVariant &value);
+
+    void skipWhitespace();
+    bool error(const QString &message);
+
+    const char *mBegin;
+    const char *mPos;
+    const char *mEnd;
+    int mDepth;
+
+    QVariant mResult;
+    QString mError;
+};
+
+} // namespace Json
+
+#endif // JSONMAPREADER_H
@@ -0,0 +1,798 @@
+/*
+ * JSON Tiled Plugin
+ * Copyright 2011, Porfírio José Pereira Ribeiro <porfirioribeiro@gmail.com>
+ * Copyright 2011, Thorbjørn Lindeijer <thorbjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jsonmapwriter.h"
+
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "properties.h"
+#include "terrain.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QIODevice>
+#include <QMap>
+#include <QScopedPointer>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Tiled;
+
+namespace Json {
+
+// The amount of output collected before it is written to the device
+static const int BUFFER_SIZE = 64 * 1024;
+
+// Matches the default indentation of JsonWriter
+static const int INDENT_SIZE = 4;
+
+JsonMapWriter::JsonMapWriter(QIODevice *device)
+    : mDevice(device)
+    , mCancelled(false)
+{
+    mBuffer.reserve(BUFFER_SIZE + 1024);
+}
+
+void JsonMapWriter::writeMap(const Map *map, const QDir &mapDir)
+{
+    mMapDir = mapDir;
+    mGidMapper.clear();
+    mCancelled = false;
+    mError.clear();
+
+    // The layers are written before the tilesets, but need their gids
+    QVector<unsigned> firstGids;
+    unsigned firstGid = 1;
+    for (const SharedTileset &tileset : map->tilesets()) {
+        firstGids.append(firstGid);
+        mGidMapper.insert(firstGid, tileset.data());
+        firstGid += tileset->tileCount();
+    }
+
+    // Compress the data of the tile layers in parallel. The chunks of
+    // infinite layers are compressed while writing them.
+    for (const TileLayer *tileLayer : map->tileLayers())
+        if (!tileLayer->isInfinite())
+            mLayerDataEncoder.addLayer(tileLayer);
+    mLayerDataEncoder.encode(mGidMapper, map->layerDataFormat());
+
+    const bool hexagonal = map->orientation() == Map::Hexagonal;
+    const bool staggered = hexagonal || map->orientation() == Map::Staggered;
+
+    beginObject();
+
+    const QColor bgColor = map->backgroundColor();
+    if (bgColor.isValid()) {
+        writeKey("backgroundcolor");
+        writeValue(bgColor.name());
+    }
+
+    writeKey("height");
+    writeValue(map->height());
+
+    if (hexagonal) {
+        writeKey("hexsidelength");
+        writeValue(map->hexSideLength());
+    }
+
+    if (map->infinite()) {
+        writeKey("infinite");
+        writeValue(true);
+    }
+
+    writeKey("layers");
+    beginArray();
+    const int layerCount = map->layerCount();
+    for (int i = 0; i < layerCount; ++i) {
+        if (!mWriteOptions.reportProgress(i, layerCount)) {
+            mCancelled = true;
+            break;
+        }
+
+        const Layer *layer = map->layerAt(i);
+        switch (layer->layerType()) {
+        case Layer::TileLayerType:
+            writeTileLayer(static_cast<const TileLayer*>(layer),
+                           map->layerDataFormat());
+            break;
+        case Layer::ObjectGroupType:
+            writeObjectGroup(static_cast<const ObjectGroup*>(layer));
+            break;
+        case Layer::ImageLayerType:
+            writeImageLayer(static_cast<const ImageLayer*>(layer));
+            break;
+        }
+    }
+    endArray();
+    mLayerDataEncoder.clear();
+
+    writeKey("nextobjectid");
+    writeValue(map->nextObjectId());
+    writeKey("orientation");
+    writeValue(orientationToString(map->orientation()));
+    writeKey("properties");
+    writeProperties(map->properties());
+    writeKey("renderorder");
+    writeValue(renderOrderToString(map->renderOrder()));
+
+    if (staggered) {
+        writeKey("staggeraxis");
+        writeValue(staggerAxisToString(map->staggerAxis()));
+        writeKey("staggerindex");
+        writeValue(staggerIndexToString(map->staggerIndex()));
+    }
+
+    writeKey("tileheight");
+    writeValue(map->tileHeight());
+
+    writeKey("tilesets");
+    beginArray();
+    for (int i = 0; i < map->tilesetCount(); ++i)
+        writeTileset(map->tilesetAt(i).data(), firstGids.at(i));
+    endArray();
+
+    writeKey("tilewidth");
+    writeValue(map->tileWidth());
+    writeKey("version");
+    writeValue(1.0);
+    writeKey("width");
+    writeValue(map->width());
+
+    endObject();
+}
+
+/**
+ * Writes the given \a data as is, for example to wrap the map in code.
+ */
+void JsonMapWriter::writeRaw(const QByteArray &data)
+{
+    mBuffer.append(data);
+}
+
+/**
+ * Writes all buffered output to the device.
+ */
+void JsonMapWriter::flush()
+{
+    mDevice->write(mBuffer);
+    mBuffer.resize(0);
+}
+
+static bool hasTileData(const Tile *tile)
+{
+    return tile->terrain() != 0xFFFFFFFF
+            || tile->probability() != 1.f
+            || !tile->imageSource().isEmpty()
+            || tile->objectGroup()
+            || tile->isAnimated();
+}
+
+void JsonMapWriter::writeTileset(const Tileset *tileset, unsigned firstGid)
+{
+    beginObject();
+
+    writeKey("firstgid");
+    writeValue(firstGid);
+
+    const QString &fileName = tileset->fileName();
+    if (!fileName.isEmpty()) {
+        writeKey("source");
+        writeValue(mMapDir.relativeFilePath(fileName));
+
+        // Tileset is external, so no need to write any of the stuff below
+        endObject();
+        return;
+    }
+
+    // The tiles are listed by their id as string. Only the tiles of image
+    // collection tilesets all need to be visited, for their image.
+    const QList<Tile*> tiles = tileset->imageSource().isEmpty() ? tileset->tiles()
+                                                                : tileset->tilesWithMetadata();
+
+    QMap<QString, const Tile*> tilesWithProperties;
+    QMap<QString, const Tile*> tilesWithData;
+    for (const Tile *tile : tiles) {
+        const QString id = QString::number(tile->id());
+        if (!tile->properties().isEmpty())
+            tilesWithProperties.insert(id, tile);
+        if (hasTileData(tile))
+            tilesWithData.insert(id, tile);
+    }
+
+    const QString &imageSource = tileset->imageSource();
+    if (!imageSource.isEmpty()) {
+        writeKey("image");
+        writeValue(mMapDir.relativeFilePath(imageSource));
+        writeKey("imageheight");
+        writeValue(tileset->imageHeight());
+        writeKey("imagewidth");
+        writeValue(tileset->imageWidth());
+    }
+
+    writeKey("margin");
+    writeValue(tileset->margin());
+    writeKey("name");
+    writeValue(tileset->name());
+    writeKey("properties");
+    writeProperties(tileset->properties());
+    writeKey("spacing");
+    writeValue(tileset->tileSpacing());
+
+    if (tileset->terrainCount() > 0) {
+        writeKey("terrains");
+        beginArray();
+        for (int i = 0; i < tileset->terrainCount(); ++i) {
+            const Terrain *terrain = tileset->terrain(i);
+            const Properties &properties = terrain->properties();
+
+            beginObject();
+            writeKey("name");
+            writeValue(terrain->name());
+            if (!properties.isEmpty()) {
+                writeKey("properties");
+                writeProperties(properties);
+            }
+            writeKey("tile");
+            writeValue(terrain->imageTileId());
+            endObject();
+        }
+        endArray();
+    }
+
+    writeKey("tilecount");
+    writeValue(tileset->tileCount());
+    writeKey("tileheight");
+    writeValue(tileset->tileHeight());
+
+    const QPoint offset = tileset->tileOffset();
+    if (!offset.isNull()) {
+        writeKey("tileoffset");
+        beginObject();
+        writeKey("x");
+        writeValue(offset.x());
+        writeKey("y");
+        writeValue(offset.y());
+        endObject();
+    }
+
+    if (!tilesWithProperties.isEmpty()) {
+        writeKey("tileproperties");
+        beginObject();
+        for (auto it = tilesWithProperties.constBegin(); it != tilesWithProperties.constEnd(); ++it) {
+            writeKey(it.key());
+            writeProperties(it.value()->properties());
+        }
+        endObject();
+    }
+
+    if (!tilesWithData.isEmpty()) {
+        writeKey("tiles");
+        beginObject();
+        for (auto it = tilesWithData.constBegin(); it != tilesWithData.constEnd(); ++it) {
+            const Tile *tile = it.value();
+
+            writeKey(it.key());
+            beginObject();
+
+            if (tile->isAnimated()) {
+                writeKey("animation");
+                beginArray();
+                for (const Frame &frame : tile->frames()) {
+                    beginObject();
+                    writeKey("duration");
+                    writeValue(frame.duration);
+                    writeKey("tileid");
+                    writeValue(frame.tileId);
+                    endObject();
+                }
+                endArray();
+            }
+            if (!tile->imageSource().isEmpty()) {
+                writeKey("image");
+                writeValue(mMapDir.relativeFilePath(tile->imageSource()));
+            }
+            if (tile->objectGroup()) {
+                writeKey("objectgroup");
+                writeObjectGroup(tile->objectGroup());
+            }
+            if (tile->probability() != 1.f) {
+                writeKey("probability");
+                writeValue(double(tile->probability()));
+            }
+            if (tile->terrain() != 0xFFFFFFFF) {
+                writeKey("terrain");
+                beginArray();
+                for (int j = 0; j < 4; ++j)
+                    writeValue(tile->cornerTerrainId(j));
+                endArray();
+            }
+
+            endObject();
+        }
+        endObject();
+    }
+
+    writeKey("tilewidth");
+    writeValue(tileset->tileWidth());
+
+    const QColor transColor = tileset->transparentColor();
+    if (!imageSource.isEmpty() && transColor.isValid()) {
+        writeKey("transparentcolor");
+        writeValue(transColor.name());
+    }
+
+    endObject();
+}
+
+void JsonMapWriter::writeProperties(const Properties &properties)
+{
+    beginObject();
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        writeKey(it.key());
+        writeValue(it.value());
+    }
+    endObject();
+}
+
+void JsonMapWriter::writeTileLayer(const TileLayer *tileLayer,
+                                   Map::LayerDataFormat format)
+{
+    beginObject();
+
+    if (tileLayer->isInfinite()) {
+        // Only the chunks holding cells are stored, each encoded on its own
+        writeKey("chunks");
+        beginArray();
+        for (const QRect &rect : tileLayer->chunkRects()) {
+            const QScopedPointer<TileLayer> chunk(tileLayer->copy(rect));
+
+            beginObject();
+            writeKey("data");
+            writeLayerData(*chunk, format);
+            writeKey("height");
+            writeValue(rect.height());
+            writeKey("width");
+            writeValue(rect.width());
+            writeKey("x");
+            writeValue(rect.x());
+            writeKey("y");
+            writeValue(rect.y());
+            endObject();
+        }
+        endArray();
+    }
+
+    const bool base64 = format != Map::XML && format != Map::CSV;
+
+    const char *compression = nullptr;
+    if (format == Map::Base64Zlib)
+        compression = "zlib";
+    else if (format == Map::Base64Gzip)
+        compression = "gzip";
+    else if (format == Map::Base64Zstandard)
+        compression = "zstd";
+    else if (format == Map::Base64Lz4)
+        compression = "lz4";
+
+    if (compression) {
+        writeKey("compression");
+        writeValue(QLatin1String(compression));
+    }
+
+    if (!tileLayer->isInfinite()) {
+        writeKey("data");
+        writeLayerData(*tileLayer, format);
+    }
+
+    if (base64) {
+        writeKey("encoding");
+        writeValue(QLatin1String("base64"));
+    }
+
+    writeKey("height");
+    writeValue(tileLayer->height());
+    writeKey("name");
+    writeValue(tileLayer->name());
+    writeLayerAttributes(tileLayer);
+    writeKey("type");
+    writeValue(QLatin1String("tilelayer"));
+    writeLayerPosition(tileLayer);
+
+    endObject();
+}
+
+/**
+ * Writes the cells of \a tileLayer as the value of a "data" member, in the
+ * given \a format.
+ */
+void JsonMapWriter::writeLayerData(const TileLayer &tileLayer,
+                                   Map::LayerDataFormat format)
+{
+    if (format == Map::XML || format == Map::CSV) {
+        beginArray();
+
+        // Write the gids directly instead of creating a list of them
+        QVector<unsigned> gids(tileLayer.width());
+        for (int y = 0; y < tileLayer.height(); ++y) {
+            mGidMapper.cellsToGids(tileLayer, y, gids.data());
+            for (unsigned gid : gids)
+                writeValue(gid);
+
+            if (mBuffer.size() >= BUFFER_SIZE)
+                flush();
+        }
+
+        endArray();
+        return;
+    }
+
+    // Stream the encoded data into the buffer, escaping like writeEscaped
+    beginValue();
+    mBuffer.append('"');
+    const auto sink = [this] (const char *data, int length) {
+        const char *end = data + length;
+        const char *slash;
+        while ((slash = std::find(data, end, '/')) != end) {
+            mBuffer.append(data, int(slash - data));
+            mBuffer.append("\\/");
+            data = slash + 1;
+        }
+        mBuffer.append(data, int(end - data));
+
+        if (mBuffer.size() >= BUFFER_SIZE)
+            flush();
+    };
+
+    bool ok;
+    if (mLayerDataEncoder.contains(&tileLayer)) {
+        QByteArray data;
+        ok = mLayerDataEncoder.take(&tileLayer, data);
+        sink(data.constData(), data.size());
+    } else {
+        ok = mGidMapper.encodeLayerData(tileLayer, format, sink);
+    }
+    mBuffer.append('"');
+
+    if (!ok && mError.isEmpty())
+        mError = tr("Failed to compress the data of layer '%1'.").arg(tileLayer.name());
+}
+
+void JsonMapWriter::writeObjectGroup(const ObjectGroup *objectGroup)
+{
+    beginObject();
+
+    if (objectGroup->color().isValid()) {
+        writeKey("color");
+        writeValue(objectGroup->color().name());
+    }
+
+    writeKey("draworder");
+    writeValue(drawOrderToString(objectGroup->drawOrder()));
+    writeKey("height");
+    writeValue(objectGroup->height());
+    writeKey("name");
+    writeValue(objectGroup->name());
+
+    writeKey("objects");
+    beginArray();
+    for (const MapObject *object : objectGroup->objects()) {
+        beginObject();
+
+        if (object->shape() == MapObject::Ellipse) {
+            writeKey("ellipse");
+            writeValue(true);
+        }
+        if (!object->cell().isEmpty()) {
+            writeKey("gid");
+            writeValue(mGidMapper.cellToGid(object->cell()));
+        }
+
+        writeKey("height");
+        writeValue(object->height());
+        writeKey("id");
+        writeValue(object->id());
+        writeKey("name");
+        writeValue(object->name());
+
+        /* Polygons are stored in this format:
+         *
+         *   "polygon/polyline": [
+         *       { "x": 0, "y": 0 },
+         *       { "x": 1, "y": 1 },
+         *       ...
+         *   ]
+         */
+        const QPolygonF &polygon = object->polygon();
+        if (!polygon.isEmpty()) {
+            if (object->shape() == MapObject::Polygon)
+                writeKey("polygon");
+            else
+                writeKey("polyline");
+
+            beginArray();
+            for (const QPointF &point : polygon) {
+                beginObject();
+                writeKey("x");
+                writeValue(point.x());
+                writeKey("y");
+                writeValue(point.y());
+                endObject();
+            }
+            endArray();
+        }
+
+        writeKey("properties");
+        writeProperties(object->properties());
+        writeKey("rotation");
+        writeValue(object->rotation());
+        writeKey("type");
+        writeValue(object->type());
+        writeKey("visible");
+        writeValue(object->isVisible());
+        writeKey("width");
+        writeValue(object->width());
+        writeKey("x");
+        writeValue(object->x());
+        writeKey("y");
+        writeValue(object->y());
+
+        endObject();
+    }
+    endArray();
+
+    writeLayerAttributes(objectGroup);
+    writeKey("type");
+    writeValue(QLatin1String("objectgroup"));
+    writeLayerPosition(objectGroup);
+
+    endObject();
+}
+
+void JsonMapWriter::writeImageLayer(const ImageLayer *imageLayer)
+{
+    beginObject();
+
+    writeKey("height");
+    writeValue(imageLayer->height());
+    writeKey("image");
+    writeValue(mMapDir.relativeFilePath(imageLayer->imageSource()));
+    writeKey("name");
+    writeValue(imageLayer->name());
+    writeLayerAttributes(imageLayer);
+
+    const QColor transColor = imageLayer->transparentColor();
+    if (transColor.isValid()) {
+        writeKey("transparentcolor");
+        writeValue(transColor.name());
+    }
+
+    writeKey("type");
+    writeValue(QLatin1String("imagelayer"));
+    writeLayerPosition(imageLayer);
+
+    endObject();
+}
+
+/**
+ * Writes the offset, opacity and properties of the \a layer, which are
+ * sorted between its name and its type.
+ */
+void JsonMapWriter::writeLayerAttributes(const Layer *layer)
+{
+    const QPointF offset = layer->offset();
+    if (!offset.isNull()) {
+        writeKey("offsetx");
+        writeValue(offset.x());
+        writeKey("offsety");
+        writeValue(offset.y());
+    }
+
+    writeKey("opacity");
+    writeValue(layer->opacity());
+
+    const Properties &properties = layer->properties();
+    if (!properties.isEmpty()) {
+        writeKey("properties");
+        writeProperties(properties);
+    }
+}
+
+/**
+ * Writes the visibility, width and position of the \a layer, which are
+ * sorted after its type.
+ */
+void JsonMapWriter::writeLayerPosition(const Layer *layer)
+{
+    writeKey("visible");
+    writeValue(layer->isVisible());
+    writeKey("width");
+    writeValue(layer->width());
+    writeKey("x");
+    writeValue(layer->x());
+    writeKey("y");
+    writeValue(layer->y());
+}
+
+/*
+ * The functions below produce the same formatting as JsonWriter does with
+ * auto formatting enabled.
+ */
+
+void JsonMapWriter::beginObject()
+{
+    beginValue();
+
+    const int depth = mContainers.size();
+    if (depth != 0) {
+        mBuffer.append('\n');
+        writeIndent(depth);
+        mBuffer.append("{\n");
+    } else {
+        mBuffer.append('{');
+    }
+
+    const Container container = { true, true };
+    mContainers.append(container);
+}
+
+void JsonMapWriter::endObject()
+{
+    Q_ASSERT(!mContainers.isEmpty() && mContainers.last().isObject);
+    mContainers.removeLast();
+
+    mBuffer.append('\n');
+    writeIndent(mContainers.size());
+    mBuffer.append('}');
+
+    if (mBuffer.size() >= BUFFER_SIZE)
+        flush();
+}
+
+void JsonMapWriter::beginArray()
+{
+    beginValue();
+    mBuffer.append('[');
+
+    const Container container = { false, true };
+    mContainers.append(container);
+}
+
+void JsonMapWriter::endArray()
+{
+    Q_ASSERT(!mContainers.isEmpty() && !mContainers.last().isObject);
+    mContainers.removeLast();
+
+    mBuffer.append(']');
+}
+
+void JsonMapWriter::writeKey(const char *key)
+{
+    writeKey(QLatin1String(key));
+}
+
+void JsonMapWriter::writeKey(const QString &key)
+{
+    Q_ASSERT(!mContainers.isEmpty() && mContainers.last().isObject);
+
+    Container &container = mContainers.last();
+    if (!container.isEmpty)
+        mBuffer.append(",\n");
+    container.isEmpty = false;
+
+    writeIndent(mContainers.size() - 1);
+    mBuffer.append(" \"");
+    writeEscaped(key);
+    mBuffer.append("\":");
+}
+
+void JsonMapWriter::writeValue(int value)
+{
+    beginValue();
+    mBuffer.append(QByteArray::number(value));
+}
+
+void JsonMapWriter::writeValue(unsigned value)
+{
+    beginValue();
+    mBuffer.append(QByteArray::number(value));
+}
+
+void JsonMapWriter::writeValue(double value)
+{
+    beginValue();
+    if (std::isfinite(value))
+        mBuffer.append(QByteArray::number(value, 'g', 15));
+    else
+        mBuffer.append("null");
+}
+
+void JsonMapWriter::writeValue(bool value)
+{
+    beginValue();
+    mBuffer.append(value ? "true" : "false");
+}
+
+void JsonMapWriter::writeValue(const QString &value)
+{
+    beginValue();
+    mBuffer.append('"');
+    writeEscaped(value);
+    mBuffer.append('"');
+}
+
+/**
+ * Separates the values in an array. Values in an object are separated when
+ * writing their key.
+ */
+void JsonMapWriter::beginValue()
+{
+    if (mContainers.isEmpty())
+        return;
+
+    Container &container = mContainers.last();
+    if (container.isObject)
+        return;
+
+    if (!container.isEmpty)
+        mBuffer.append(", ");
+    container.isEmpty = false;
+}
+
+void JsonMapWriter::writeIndent(int depth)
+{
+    mBuffer.append(QByteArray(depth * INDENT_SIZE, ' '));
+}
+
+/**
+ * Escapes the \a string like JsonWriter, which means the output only
+ * contains ASCII characters.
+ */
+void JsonMapWriter::writeEscaped(const QString &string)
+{
+    for (const QChar c : string) {
+        const ushort unicode = c.unicode();
+
+        switch (unicode) {
+        case '\b': mBuffer.append("\\b"); break;
+        case '\f': mBuffer.append("\\f"); break;
+        case '\n': mBuffer.append("\\n"); break;
+        case '\r': mBuffer.append("\\r"); break;
+        case '\t': mBuffer.append("\\t"); break;
+        case '"':  mBuffer.append("\\\""); break;
+        case '\\': mBuffer.append("\\\\"); break;
+        case '/':  mBuffer.append("\\/"); break;
+        default:
+            if (unicode > 127) {
+                mBuffer.append("\\u");
+                mBuffer.append(QByteArray::number(unicode, 16).rightJustified(4, '0'));
+            } else {
+                mBuffer.append(char(unicode));
+            }
+            break;
+        }
+    }
+}
+
+} // namespace Json
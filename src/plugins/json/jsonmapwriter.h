@@ -0,0 +1,130 @@
+/*
+ * JSON Tiled Plugin
+ * Copyright 2011, Porfírio José Pereira Ribeiro <porfirioribeiro@gmail.com>
+ * Copyright 2011, Thorbjørn Lindeijer <thorbjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSONMAPWRITER_H
+#define JSONMAPWRITER_H
+
+#include "gidmapper.h"
+#include "layerdataencoder.h"
+#include "mapstreamoptions.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QVector>
+
+class QIODevice;
+
+namespace Tiled {
+class ImageLayer;
+class Layer;
+class ObjectGroup;
+class Properties;
+class TileLayer;
+class Tileset;
+}
+
+namespace Json {
+
+/**
+ * Writes a map in the JSON format directly to a device, without converting
+ * it to a QVariant first. The output is the same as that of converting the
+ * map with MapToVariantConverter and writing it with an auto-formatting
+ * JsonWriter, which means the members of each object are written in
+ * alphabetical order.
+ *
+ * The output is written in chunks, so that large tile layers don't need to
+ * be held in memory as text.
+ */
+class JsonMapWriter
+{
+    Q_DECLARE_TR_FUNCTIONS(JsonMapWriter)
+
+public:
+    explicit JsonMapWriter(QIODevice *device);
+
+    void writeMap(const Tiled::Map *map, const QDir &mapDir);
+
+    /**
+     * Sets the options used by writeMap(). Progress is reported in layers
+     * written. When cancelled, the remaining layers are left out.
+     */
+    void setWriteOptions(const Tiled::MapWriteOptions &options)
+    { mWriteOptions = options; }
+
+    bool isCancelled() const { return mCancelled; }
+
+    /**
+     * Returns the error that occurred while writing the map, if any.
+     */
+    const QString &errorString() const { return mError; }
+
+    void writeRaw(const QByteArray &data);
+    void flush();
+
+private:
+    void writeTileset(const Tiled::Tileset *tileset, unsigned firstGid);
+    void writeProperties(const Tiled::Properties &properties);
+    void writeTileLayer(const Tiled::TileLayer *tileLayer,
+                        Tiled::Map::LayerDataFormat format);
+    void writeLayerData(const Tiled::TileLayer &tileLayer,
+                        Tiled::Map::LayerDataFormat format);
+    void writeObjectGroup(const Tiled::ObjectGroup *objectGroup);
+    void writeImageLayer(const Tiled::ImageLayer *imageLayer);
+    void writeLayerAttributes(const Tiled::Layer *layer);
+    void writeLayerPosition(const Tiled::Layer *layer);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void writeKey(const char *key);
+    void writeKey(const QString &key);
+
+    void writeValue(int value);
+    void writeValue(unsigned value);
+    void writeValue(double value);
+    void writeValue(bool value);
+    void writeValue(const QString &value);
+
+    void beginValue();
+    void writeIndent(int depth);
+    void writeEscaped(const QString &string);
+
+    struct Container {
+        bool isObject;
+        bool isEmpty;
+    };
+
+    QIODevice *mDevice;
+    QByteArray mBuffer;
+    QVector<Container> mContainers;
+    QDir mMapDir;
+    Tiled::GidMapper mGidMapper;
+    Tiled::LayerDataEncoder mLayerDataEncoder;
+    Tiled::MapWriteOptions mWriteOptions;
+    bool mCancelled;
+    QString mError;
+};
+
+} // namespace Json
+
+#endif // JSONMAPWRITER_H
@@ -21,18 +21,42 @@
 
 #include "jsonplugin.h"
 
+#include "jsonmapreader.h"
+#include "jsonmapwriter.h"
 #include "maptovariantconverter.h"
 #include "varianttomapconverter.h"
 
 #include "qjsonparser/json.h"
 
 #include <QFile>
+#include <QFileDevice>
 #include <QFileInfo>
 #include <QSaveFile>
 #include <QTextStream>
 
+#include <algorithm>
+#include <cctype>
+
 namespace Json {
 
+/**
+ * JsonReader detects UTF-16 and UTF-32 from the pattern of nulls in the
+ * first octets. Anything else is UTF-8, which JsonMapReader can read.
+ */
+static bool isUtf8(const char *begin, const char *end)
+{
+    const qint64 size = end - begin;
+    if (size >= 2 && ((uchar(begin[0]) == 0xFE && uchar(begin[1]) == 0xFF) ||
+                      (uchar(begin[0]) == 0xFF && uchar(begin[1]) == 0xFE)))
+        return false;
+
+    for (qint64 i = 0; i < qMin<qint64>(size, 4); ++i)
+        if (begin[i] == 0)
+            return false;
+
+    return true;
+}
+
 void JsonPlugin::initialize()
 {
     addObject(new JsonMapFormat(JsonMapFormat::Json, this));
@@ -46,6 +70,15 @@ JsonMapFormat::JsonMapFormat(SubFormat subFormat, QObject *parent)
     , mSubFormat(subFormat)
 {}
 
+Tiled::MapFormat::Capabilities JsonMapFormat::capabilities() const
+{
+    // Writing JavaScript to a device is not supported, since it needs a name
+    if (mSubFormat == JavaScript)
+        return ReadWrite | StreamRead;
+
+    return ReadWrite | StreamRead | StreamWrite;
+}
+
 Tiled::Map *JsonMapFormat::read(const QString &fileName)
 {
     QFile file(fileName);
@@ -54,21 +87,81 @@ Tiled::Map *JsonMapFormat::read(const QString &fileName)
         return nullptr;
     }
 
-    JsonReader reader;
-    QByteArray contents = file.readAll();
-    if (mSubFormat == JavaScript && contents.size() > 0 && contents[0] != '{') {
+    // Map the file to avoid copying it, falling back to reading it
+    qint64 size = file.size();
+    QByteArray contents;
+    const char *begin = reinterpret_cast<const char*>(file.map(0, size));
+    if (!begin) {
+        contents = file.readAll();
+        begin = contents.constData();
+        size = contents.size();
+    }
+
+    return readMap(begin, begin + size, QFileInfo(fileName).dir());
+}
+
+Tiled::Map *JsonMapFormat::readFromDevice(QIODevice *device,
+                                          const QString &path,
+                                          const Tiled::MapReadOptions &options)
+{
+    // The parser needs all of the data, which is read in blocks so that
+    // progress can be reported
+    const qint64 total = device->isSequential() ? -1 : device->size();
+    QByteArray contents;
+    if (total > 0)
+        contents.reserve(int(total));
+
+    while (!device->atEnd()) {
+        const QByteArray block = device->read(64 * 1024);
+        if (block.isEmpty())
+            break;
+
+        contents.append(block);
+
+        if (!options.reportProgress(contents.size(), total)) {
+            mError = tr("Reading the map was cancelled.");
+            return nullptr;
+        }
+    }
+
+    const char *begin = contents.constData();
+    Tiled::Map *map = readMap(begin, begin + contents.size(), QDir(path));
+    if (map)
+        options.applyTo(map);
+
+    return map;
+}
+
+Tiled::Map *JsonMapFormat::readMap(const char *begin, const char *end,
+                                   const QDir &mapDir)
+{
+    if (mSubFormat == JavaScript && begin != end && *begin != '{') {
         // Scan past JSONP prefix; look for an open curly at the start of the line
-        int i = contents.indexOf(QLatin1String("\n{"));
-        if (i > 0) {
-            contents.remove(0, i);
-            contents = contents.trimmed(); // potential trailing whitespace
-            if (contents.endsWith(';')) contents.chop(1);
-            if (contents.endsWith(')')) contents.chop(1);
+        static const char prefixEnd[] = "\n{";
+        const char *i = std::search(begin, end, prefixEnd, prefixEnd + 2);
+        if (i != end && i != begin) {
+            begin = i + 1;
+            while (end != begin && isspace(uchar(end[-1])))     // potential trailing whitespace
+                --end;
+            if (end != begin && end[-1] == ';') --end;
+            if (end != begin && end[-1] == ')') --end;
         }
     }
-    reader.parse(contents);
 
-    const QVariant variant = reader.result();
+    QVariant variant;
+
+    if (isUtf8(begin, end)) {
+        JsonMapReader reader;
+        if (!reader.parse(begin, end)) {
+            mError = tr("Error parsing file: %1").arg(reader.errorString());
+            return nullptr;
+        }
+        variant = reader.result();
+    } else {
+        JsonReader reader;
+        reader.parse(QByteArray::fromRawData(begin, int(end - begin)));
+        variant = reader.result();
+    }
 
     if (!variant.isValid()) {
         mError = tr("Error parsing file.");
@@ -76,7 +169,7 @@ Tiled::Map *JsonMapFormat::read(const QString &fileName)
     }
 
     Tiled::VariantToMapConverter converter;
-    Tiled::Map *map = converter.toMap(variant, QFileInfo(fileName).dir());
+    Tiled::Map *map = converter.toMap(variant, mapDir);
 
     if (!map)
         mError = converter.errorString();
@@ -93,44 +186,82 @@ bool JsonMapFormat::write(const Tiled::Map *map, const QString &fileName)
         return false;
     }
 
-    Tiled::MapToVariantConverter converter;
-    QVariant variant = converter.toVariant(map, QFileInfo(fileName).dir());
+    const QFileInfo fileInfo(fileName);
+    if (!writeMap(map, &file, fileInfo.dir(), fileInfo.baseName(),
+                  Tiled::MapWriteOptions()))
+        return false;
 
-    JsonWriter writer;
-    writer.setAutoFormatting(true);
+    if (file.error() != QFile::NoError) {
+        mError = tr("Error while writing file:\n%1").arg(file.errorString());
+        return false;
+    }
 
-    if (!writer.stringify(variant)) {
-        // This can only happen due to coding error
-        mError = writer.errorString();
+    if (!file.commit()) {
+        mError = file.errorString();
         return false;
     }
 
-    QTextStream out(&file);
+    return true;
+}
+
+bool JsonMapFormat::writeToDevice(const Tiled::Map *map,
+                                  QIODevice *device,
+                                  const QString &path,
+                                  const Tiled::MapWriteOptions &options)
+{
+    // The JavaScript format needs a file name, to name the map
+    if (mSubFormat == JavaScript) {
+        mError = tr("Writing to a device is not supported by this format.");
+        return false;
+    }
+
+    if (!writeMap(map, device, QDir(path), QString(), options))
+        return false;
+
+    QFileDevice *file = qobject_cast<QFileDevice*>(device);
+    if (file && file->error() != QFileDevice::NoError) {
+        mError = tr("Error while writing file:\n%1").arg(file->errorString());
+        return false;
+    }
+
+    return true;
+}
+
+bool JsonMapFormat::writeMap(const Tiled::Map *map,
+                             QIODevice *device,
+                             const QDir &mapDir,
+                             const QString &name,
+                             const Tiled::MapWriteOptions &options)
+{
+    mError.clear();
+
+    JsonMapWriter writer(device);
+    writer.setWriteOptions(options);
+
     if (mSubFormat == JavaScript) {
         // Trim and escape name
         JsonWriter nameWriter;
-        QString baseName = QFileInfo(fileName).baseName();
-        nameWriter.stringify(baseName);
-        out << "(function(name,data){\n if(typeof onTileMapLoaded === 'undefined') {\n";
-        out << "  if(typeof TileMaps === 'undefined') TileMaps = {};\n";
-        out << "  TileMaps[name] = data;\n";
-        out << " } else {\n";
-        out << "  onTileMapLoaded(name,data);\n";
-        out << " }})(" << nameWriter.result() << ",\n";
+        nameWriter.stringify(name);
+        writer.writeRaw("(function(name,data){\n if(typeof onTileMapLoaded === 'undefined') {\n");
+        writer.writeRaw("  if(typeof TileMaps === 'undefined') TileMaps = {};\n");
+        writer.writeRaw("  TileMaps[name] = data;\n");
+        writer.writeRaw(" } else {\n");
+        writer.writeRaw("  onTileMapLoaded(name,data);\n");
+        writer.writeRaw(" }})(" + nameWriter.result().toUtf8() + ",\n");
     }
-    out << writer.result();
+    writer.writeMap(map, mapDir);
     if (mSubFormat == JavaScript) {
-        out << ");";
+        writer.writeRaw(");");
     }
-    out.flush();
+    writer.flush();
 
-    if (file.error() != QFile::NoError) {
-        mError = tr("Error while writing file:\n%1").arg(file.errorString());
+    if (writer.isCancelled()) {
+        mError = tr("Writing the map was cancelled.");
         return false;
     }
 
-    if (!file.commit()) {
-        mError = file.errorString();
+    if (!writer.errorString().isEmpty()) {
+        mError = writer.errorString();
         return false;
     }
 
@@ -28,6 +28,7 @@
 #include "plugin.h"
 #include "tilesetformat.h"
 
+#include <QDir>
 #include <QObject>
 
 namespace Tiled {
@@ -60,17 +61,37 @@ public:
 
     JsonMapFormat(SubFormat subFormat, QObject *parent = nullptr);
 
+    Capabilities capabilities() const override;
+
     Tiled::Map *read(const QString &fileName) override;
     bool supportsFile(const QString &fileName) const override;
 
     bool write(const Tiled::Map *map, const QString &fileName) override;
 
+    Tiled::Map *readFromDevice(QIODevice *device,
+                               const QString &path,
+                               const Tiled::MapReadOptions &options) override;
+
+    bool writeToDevice(const Tiled::Map *map,
+                       QIODevice *device,
+                       const QString &path,
+                       const Tiled::MapWriteOptions &options) override;
+
     QString nameFilter() const override;
     QString errorString() const override;
 
 protected:
     QString mError;
     SubFormat mSubFormat;
+
+private:
+    Tiled::Map *readMap(const char *begin, const char *end,
+                        const QDir &mapDir);
+    bool writeMap(const Tiled::Map *map,
+                  QIODevice *device,
+                  const QDir &mapDir,
+                  const QString &name,
+                  const Tiled::MapWriteOptions &options);
 };
 
 
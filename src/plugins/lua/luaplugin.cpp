@@ -32,8 +32,10 @@
 #include "tileset.h"
 
 #include <QFile>
+#include <QFileDevice>
 #include <QCoreApplication>
 #include <QSaveFile>
+#include <QVector>
 
 /**
  * See below for an explanation of the different formats. One of these needs
@@ -59,20 +61,51 @@ bool LuaPlugin::write(const Map *map, const QString &fileName)
         return false;
     }
 
-    mMapDir = QFileInfo(fileName).path();
+    if (!writeToDevice(map, &file, QFileInfo(fileName).path(), MapWriteOptions()))
+        return false;
+
+    if (!file.commit()) {
+        mError = file.errorString();
+        return false;
+    }
+
+    return true;
+}
 
-    LuaTableWriter writer(&file);
+bool LuaPlugin::writeToDevice(const Map *map,
+                              QIODevice *device,
+                              const QString &path,
+                              const MapWriteOptions &options)
+{
+    mError.clear();
+
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
+    mMapDir = path;
+    mWriteOptions = options;
+
+    LuaTableWriter writer(device);
     writer.writeStartDocument();
-    writeMap(writer, map);
+    const bool completed = writeMap(writer, map);
     writer.writeEndDocument();
 
-    if (file.error() != QFile::NoError) {
-        mError = file.errorString();
+    mWriteOptions = MapWriteOptions();
+
+    if (!completed) {
+        mError = tr("Writing the map was cancelled.");
         return false;
     }
 
-    if (!file.commit()) {
-        mError = file.errorString();
+    // Compression errors are set while writing the layers
+    if (!mError.isEmpty())
+        return false;
+
+    QFileDevice *file = qobject_cast<QFileDevice*>(device);
+    if (file && file->error() != QFileDevice::NoError) {
+        mError = file->errorString();
         return false;
     }
 
@@ -89,7 +122,11 @@ QString LuaPlugin::errorString() const
     return mError;
 }
 
-void LuaPlugin::writeMap(LuaTableWriter &writer, const Map *map)
+/**
+ * Writes the map, reporting progress after each layer. Returns false when
+ * writing was cancelled.
+ */
+bool LuaPlugin::writeMap(LuaTableWriter &writer, const Map *map)
 {
     writer.writeStartReturnTable();
 
@@ -145,8 +182,22 @@ void LuaPlugin::writeMap(LuaTableWriter &writer, const Map *map)
     }
     writer.writeEndTable();
 
+    // Compress the data of the tile layers in parallel
+    foreach (const TileLayer *tileLayer, map->tileLayers())
+        mLayerDataEncoder.addLayer(tileLayer);
+    mLayerDataEncoder.encode(mGidMapper, map->layerDataFormat());
+
+    bool completed = true;
+
     writer.writeStartTable("layers");
-    foreach (const Layer *layer, map->layers()) {
+    const int layerCount = map->layerCount();
+    for (int i = 0; i < layerCount; ++i) {
+        if (!mWriteOptions.reportProgress(i, layerCount)) {
+            completed = false;
+            break;
+        }
+
+        const Layer *layer = map->layerAt(i);
         switch (layer->layerType()) {
         case Layer::TileLayerType:
             writeTileLayer(writer,
@@ -162,8 +213,11 @@ void LuaPlugin::writeMap(LuaTableWriter &writer, const Map *map)
         }
     }
     writer.writeEndTable();
+    mLayerDataEncoder.clear();
 
     writer.writeEndTable();
+
+    return completed;
 }
 
 void LuaPlugin::writeProperties(LuaTableWriter &writer,
@@ -254,15 +308,17 @@ void LuaPlugin::writeTileset(LuaTableWriter &writer, const Tileset *tileset,
 
     writer.writeKeyAndValue("tilecount", tileset->tileCount());
     writer.writeStartTable("tiles");
-    for (int i = 0; i < tileset->tileCount(); ++i) {
-        const Tile *tile = tileset->tileAt(i);
 
+    const QList<Tile*> tiles = tileset->imageSource().isEmpty() ? tileset->tiles()
+                                                                : tileset->tilesWithMetadata();
+
+    for (const Tile *tile : tiles) {
         // For brevity only write tiles with interesting properties
         if (!includeTile(tile))
             continue;
 
         writer.writeStartTable();
-        writer.writeKeyAndValue("id", i);
+        writer.writeKeyAndValue("id", tile->id());
 
         if (!tile->properties().isEmpty())
             writeProperties(writer, tile->properties());
@@ -334,27 +390,45 @@ void LuaPlugin::writeTileLayer(LuaTableWriter &writer,
     case Map::CSV:
         writer.writeKeyAndValue("encoding", "lua");
         writer.writeStartTable("data");
-        for (int y = 0; y < tileLayer->height(); ++y) {
-            if (y > 0)
-                writer.prepareNewLine();
-
-            for (int x = 0; x < tileLayer->width(); ++x)
-                writer.writeValue(mGidMapper.cellToGid(tileLayer->cellAt(x, y)));
+        {
+            QVector<unsigned> gids(tileLayer->width());
+            for (int y = 0; y < tileLayer->height(); ++y) {
+                if (y > 0)
+                    writer.prepareNewLine();
+
+                mGidMapper.cellsToGids(*tileLayer, y, gids.data());
+                writer.writeValues(gids.constData(), gids.size());
+            }
         }
         writer.writeEndTable();
         break;
 
     case Map::Base64:
     case Map::Base64Zlib:
-    case Map::Base64Gzip: {
+    case Map::Base64Gzip:
+    case Map::Base64Zstandard:
+    case Map::Base64Lz4: {
         writer.writeKeyAndValue("encoding", "base64");
 
         if (format == Map::Base64Zlib)
             writer.writeKeyAndValue("compression", "zlib");
         else if (format == Map::Base64Gzip)
             writer.writeKeyAndValue("compression", "gzip");
+        else if (format == Map::Base64Zstandard)
+            writer.writeKeyAndValue("compression", "zstd");
+        else if (format == Map::Base64Lz4)
+            writer.writeKeyAndValue("compression", "lz4");
+
+        QByteArray layerData;
+        bool ok;
+        if (mLayerDataEncoder.contains(tileLayer))
+            ok = mLayerDataEncoder.take(tileLayer, layerData);
+        else
+            layerData = mGidMapper.encodeLayerData(*tileLayer, format, &ok);
+
+        if (!ok && mError.isEmpty())
+            mError = tr("Failed to compress the data of layer '%1'.").arg(tileLayer->name());
 
-        QByteArray layerData = mGidMapper.encodeLayerData(*tileLayer, format);
         writer.writeKeyAndValue("data", layerData);
         break;
     }
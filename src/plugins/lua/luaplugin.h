@@ -24,6 +24,7 @@
 #include "lua_global.h"
 
 #include "gidmapper.h"
+#include "layerdataencoder.h"
 #include "map.h"
 #include "mapformat.h"
 
@@ -53,12 +54,18 @@ class LUASHARED_EXPORT LuaPlugin : public Tiled::WritableMapFormat
 public:
     LuaPlugin();
 
+    Capabilities capabilities() const override { return Write | StreamWrite; }
+
     bool write(const Tiled::Map *map, const QString &fileName) override;
+    bool writeToDevice(const Tiled::Map *map,
+                       QIODevice *device,
+                       const QString &path,
+                       const Tiled::MapWriteOptions &options) override;
     QString nameFilter() const override;
     QString errorString() const override;
 
 private:
-    void writeMap(LuaTableWriter &, const Tiled::Map *);
+    bool writeMap(LuaTableWriter &, const Tiled::Map *);
     void writeProperties(LuaTableWriter &, const Tiled::Properties &);
     void writeTileset(LuaTableWriter &, const Tiled::Tileset *, unsigned firstGid);
     void writeTileLayer(LuaTableWriter &, const Tiled::TileLayer *,
@@ -71,6 +78,8 @@ private:
     QString mError;
     QDir mMapDir;     // The directory in which the map is being saved
     Tiled::GidMapper mGidMapper;
+    Tiled::LayerDataEncoder mLayerDataEncoder;
+    Tiled::MapWriteOptions mWriteOptions;
 };
 
 } // namespace Lua
@@ -24,6 +24,22 @@
 
 namespace Lua {
 
+static const int BufferSize = 64 * 1024;
+
+static char *writeNumber(char *out, unsigned value)
+{
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (count)
+        *out++ = digits[--count];
+    return out;
+}
+
 LuaTableWriter::LuaTableWriter(QIODevice *device)
     : m_device(device)
     , m_indent(0)
@@ -33,6 +49,7 @@ LuaTableWriter::LuaTableWriter(QIODevice *device)
     , m_valueWritten(false)
     , m_error(false)
 {
+    m_buffer.reserve(BufferSize);
 }
 
 void LuaTableWriter::writeStartDocument()
@@ -44,6 +61,7 @@ void LuaTableWriter::writeEndDocument()
 {
     Q_ASSERT(m_indent == 0);
     write('\n');
+    flush();
 }
 
 void LuaTableWriter::writeStartTable()
@@ -93,6 +111,14 @@ void LuaTableWriter::writeValue(const QByteArray &value)
     m_valueWritten = true;
 }
 
+void LuaTableWriter::writeValue(const QString &value)
+{
+    prepareNewValue();
+    writeQuoted(value);
+    m_newLine = false;
+    m_valueWritten = true;
+}
+
 void LuaTableWriter::writeUnquotedValue(const QByteArray &value)
 {
     prepareNewValue();
@@ -101,6 +127,37 @@ void LuaTableWriter::writeUnquotedValue(const QByteArray &value)
     m_valueWritten = true;
 }
 
+/**
+ * Writes \a count numbers, with the same result as calling writeValue() for
+ * each of them.
+ */
+void LuaTableWriter::writeValues(const unsigned *values, int count)
+{
+    if (count == 0)
+        return;
+
+    prepareNewValue();
+
+    // Each value takes at most 10 digits, a separator and a space
+    const int size = m_buffer.size();
+    m_buffer.resize(size + count * 12);
+
+    char *out = m_buffer.data() + size;
+    out = writeNumber(out, values[0]);
+    for (int i = 1; i < count; ++i) {
+        *out++ = m_valueSeparator;
+        *out++ = ' ';
+        out = writeNumber(out, values[i]);
+    }
+
+    m_buffer.resize(out - m_buffer.constData());
+    m_newLine = false;
+    m_valueWritten = true;
+
+    if (m_buffer.size() >= BufferSize)
+        flush();
+}
+
 void LuaTableWriter::writeKeyAndValue(const QByteArray &key,
                                       const char *value)
 {
@@ -125,14 +182,25 @@ void LuaTableWriter::writeKeyAndValue(const QByteArray &key,
     m_valueWritten = true;
 }
 
+void LuaTableWriter::writeKeyAndValue(const QByteArray &key,
+                                      const QString &value)
+{
+    prepareNewLine();
+    write(key);
+    write(" = ");
+    writeQuoted(value);
+    m_newLine = false;
+    m_valueWritten = true;
+}
+
 void LuaTableWriter::writeQuotedKeyAndValue(const QString &key,
                                             const QString &value)
 {
     prepareNewLine();
     write('[');
-    write(quote(key).toUtf8());
+    writeQuoted(key);
     write("] = ");
-    write(quote(value).toUtf8());
+    writeQuoted(value);
     m_newLine = false;
     m_valueWritten = true;
 }
@@ -168,6 +236,37 @@ QString LuaTableWriter::quote(const QString &str)
     return quoted;
 }
 
+/**
+ * Writes the given string quoted and encoded as UTF-8, like quote() but
+ * without creating a new string.
+ */
+void LuaTableWriter::writeQuoted(const QString &str)
+{
+    // The escaped characters are ASCII, so they can be escaped in the UTF-8
+    // encoded string, where they can't be part of a multibyte sequence.
+    const QByteArray utf8 = str.toUtf8();
+
+    write('"');
+
+    const char *begin = utf8.constData();
+    const char *end = begin + utf8.size();
+    for (const char *c = begin; c != end; ++c) {
+        const char *escaped;
+        switch (*c) {
+        case '\\':  escaped = "\\\\";  break;
+        case '"':   escaped = "\\\"";  break;
+        case '\n':  escaped = "\\n";   break;
+        default:    continue;
+        }
+        write(begin, c - begin);
+        write(escaped, 2);
+        begin = c + 1;
+    }
+    write(begin, end - begin);
+
+    write('"');
+}
+
 void LuaTableWriter::prepareNewLine()
 {
     if (m_valueWritten) {
@@ -208,8 +307,23 @@ void LuaTableWriter::writeNewline()
 
 void LuaTableWriter::write(const char *bytes, unsigned length)
 {
-    if (m_device->write(bytes, length) != length)
+    m_buffer.append(bytes, length);
+    if (m_buffer.size() >= BufferSize)
+        flush();
+}
+
+/**
+ * Writes the buffered output to the device.
+ */
+void LuaTableWriter::flush()
+{
+    if (m_buffer.isEmpty())
+        return;
+
+    if (m_device->write(m_buffer) != m_buffer.size())
         m_error = true;
+
+    m_buffer.resize(0);
 }
 
 } // namespace Lua
@@ -30,6 +30,9 @@ namespace Lua {
 
 /**
  * Makes it easy to produce a well formatted Lua table.
+ *
+ * The output is buffered and written to the device in large chunks. It is
+ * flushed by writeEndDocument(), or explicitly by calling flush().
  */
 class LuaTableWriter
 {
@@ -51,6 +54,8 @@ public:
 
     void writeUnquotedValue(const QByteArray &value);
 
+    void writeValues(const unsigned *values, int count);
+
     void writeKeyAndValue(const QByteArray &key, int value);
     void writeKeyAndValue(const QByteArray &key, unsigned value);
     void writeKeyAndValue(const QByteArray &key, double value);
@@ -68,6 +73,8 @@ public:
 
     void prepareNewLine();
 
+    void flush();
+
     bool hasError() const { return m_error; }
 
     static QString quote(const QString &str);
@@ -81,8 +88,10 @@ private:
     void write(const char *bytes);
     void write(const QByteArray &bytes);
     void write(char c);
+    void writeQuoted(const QString &str);
 
     QIODevice *m_device;
+    QByteArray m_buffer;
     int m_indent;
     char m_valueSeparator;
     bool m_suppressNewlines;
@@ -97,8 +106,6 @@ inline void LuaTableWriter::writeValue(int value)
 inline void LuaTableWriter::writeValue(unsigned value)
 { writeUnquotedValue(QByteArray::number(value)); }
 
-inline void LuaTableWriter::writeValue(const QString &value)
-{ writeUnquotedValue(quote(value).toUtf8()); }
 
 inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, int value)
 { writeKeyAndUnquotedValue(key, QByteArray::number(value)); }
@@ -112,9 +119,6 @@ inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, double value
 inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, bool value)
 { writeKeyAndUnquotedValue(key, value ? "true" : "false"); }
 
-inline void LuaTableWriter::writeKeyAndValue(const QByteArray &key, const QString &value)
-{ writeKeyAndUnquotedValue(key, quote(value).toUtf8()); }
-
 inline void LuaTableWriter::write(const char *bytes)
 { write(bytes, qstrlen(bytes)); }
 
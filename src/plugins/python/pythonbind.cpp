@@ -89,6 +89,8 @@ typedef enum _PyBindGenWrapperFlags {
 #include "tilelayer.h"
 #include "objectgroup.h"
 #include "tileset.h"
+#include "gidmapper.h"
+#include <QtEndian>
 #include <QImage>
 #include <QFileDialog>
 #include <QWidget>
@@ -2422,6 +2424,80 @@ bool loadTilesetFromFile(Tiled::Tileset *ts, QString file)
     return ts->loadFromImage(img, file);
 }
 
+/*
+ * Returns the global tile IDs of all cells of the given layer, row by row,
+ * as a bytearray of little-endian 32-bit integers. The gids are based on the
+ * tilesets of the given map, in the same way as when the map is saved. Can be
+ * wrapped without copying by numpy.frombuffer(gids, dtype='<u4').
+ */
+PyObject *layerGids(Tiled::TileLayer *layer, Tiled::Map *map)
+{
+    const int width = layer->width();
+    const int height = layer->height();
+
+    PyObject *gids = PyByteArray_FromStringAndSize(NULL, Py_ssize_t(width) * height * 4);
+    if (!gids)
+        return NULL;
+
+    const Tiled::GidMapper gidMapper(map->tilesets());
+    QVector<unsigned> row(width);
+    uchar *data = reinterpret_cast<uchar*>(PyByteArray_AS_STRING(gids));
+
+    // Other threads may run Python while the gids are gathered
+    Py_BEGIN_ALLOW_THREADS
+    for (int y = 0; y < height; ++y) {
+        gidMapper.cellsToGids(*layer, y, row.data());
+        for (int x = 0; x < width; ++x, data += 4)
+            qToLittleEndian<quint32>(row.at(x), data);
+    }
+    Py_END_ALLOW_THREADS
+
+    return gids;
+}
+
+/*
+ * Sets all cells of the given layer from gids in the format returned by
+ * layerGids, given as any object supporting the buffer protocol, like a
+ * bytearray or a contiguous numpy array of dtype '<u4'. Raises a ValueError
+ * and leaves the layer unchanged when the size is wrong or a gid is invalid.
+ */
+PyObject *setLayerGids(Tiled::TileLayer *layer, Tiled::Map *map, PyObject *gids)
+{
+    Py_buffer view;
+    if (PyObject_GetBuffer(gids, &view, PyBUF_SIMPLE) != 0)
+        return NULL;
+
+    const int width = layer->width();
+    const int height = layer->height();
+
+    if (view.len != Py_ssize_t(width) * height * 4) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "expected %d gids", width * height);
+        return NULL;
+    }
+
+    const Tiled::GidMapper gidMapper(map->tilesets());
+    Tiled::TileLayer decoded(QString(), 0, 0, width, height);
+    Tiled::GidMapper::DecodeError error;
+
+    // The buffer stays valid while other threads run Python
+    Py_BEGIN_ALLOW_THREADS
+    error = gidMapper.decodeLayerData(decoded, static_cast<const uchar*>(view.buf));
+    if (error == Tiled::GidMapper::NoError)
+        layer->setCells(0, 0, &decoded);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&view);
+
+    if (error != Tiled::GidMapper::NoError) {
+        PyErr_Format(PyExc_ValueError, "invalid tile: %u", gidMapper.invalidTile());
+        return NULL;
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 #if PY_VERSION_HEX >= 0x03000000
 static struct PyModuleDef qt_moduledef = {
     PyModuleDef_HEAD_INIT,
@@ -6354,12 +6430,81 @@ _wrap_tiled_tileLayerAt(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyOb
 }
 PyObject * _wrap_tiled_tileLayerAt(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs);
 
+
+PyObject *
+_wrap_tiled_layerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs)
+{
+    PyObject *py_retval;
+    PyObject *retval;
+    PyTiledTileLayer *layer;
+    Tiled::TileLayer *layer_ptr;
+    PyTiledMap *map;
+    Tiled::Map *map_ptr;
+    const char *keywords[] = {"layer", "map", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O!O!", (char **) keywords, &PyTiledTileLayer_Type, &layer, &PyTiledMap_Type, &map)) {
+        return NULL;
+    }
+    layer_ptr = (layer ? layer->obj : NULL);
+    map_ptr = (map ? map->obj : NULL);
+    retval = layerGids(layer_ptr, map_ptr);
+    py_retval = Py_BuildValue((char *) "N", retval);
+    return py_retval;
+}
+PyObject * _wrap_tiled_layerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs);
+
+
+PyObject *
+_wrap_tiled_setLayerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs)
+{
+    PyObject *py_retval;
+    PyObject *retval;
+    PyTiledTileLayer *layer;
+    Tiled::TileLayer *layer_ptr;
+    PyTiledMap *map;
+    Tiled::Map *map_ptr;
+    PyObject *gids;
+    const char *keywords[] = {"layer", "map", "gids", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "O!O!O", (char **) keywords, &PyTiledTileLayer_Type, &layer, &PyTiledMap_Type, &map, &gids)) {
+        return NULL;
+    }
+    layer_ptr = (layer ? layer->obj : NULL);
+    map_ptr = (map ? map->obj : NULL);
+    retval = setLayerGids(layer_ptr, map_ptr, gids);
+    py_retval = Py_BuildValue((char *) "N", retval);
+    return py_retval;
+}
+PyObject * _wrap_tiled_setLayerGids(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs);
+
+
+PyObject *
+_wrap_tiled_reportProgress(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs)
+{
+    PyObject *py_retval;
+    int done;
+    int total;
+    const char *keywords[] = {"done", "total", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "ii", (char **) keywords, &done, &total)) {
+        return NULL;
+    }
+    Python::reportProgress(done, total);
+    Py_INCREF(Py_None);
+    py_retval = Py_None;
+    return py_retval;
+}
+PyObject * _wrap_tiled_reportProgress(PyObject * PYBINDGEN_UNUSED(dummy), PyObject *args, PyObject *kwargs);
+
 static PyMethodDef tiled_functions[] = {
     {(char *) "isTileLayerAt", (PyCFunction) _wrap_tiled_isTileLayerAt, METH_KEYWORDS|METH_VARARGS, NULL },
     {(char *) "loadTilesetFromFile", (PyCFunction) _wrap_tiled_loadTilesetFromFile, METH_KEYWORDS|METH_VARARGS, NULL },
     {(char *) "objectGroupAt", (PyCFunction) _wrap_tiled_objectGroupAt, METH_KEYWORDS|METH_VARARGS, NULL },
     {(char *) "isObjectGroupAt", (PyCFunction) _wrap_tiled_isObjectGroupAt, METH_KEYWORDS|METH_VARARGS, NULL },
     {(char *) "tileLayerAt", (PyCFunction) _wrap_tiled_tileLayerAt, METH_KEYWORDS|METH_VARARGS, NULL },
+    {(char *) "layerGids", (PyCFunction) _wrap_tiled_layerGids, METH_KEYWORDS|METH_VARARGS, NULL },
+    {(char *) "setLayerGids", (PyCFunction) _wrap_tiled_setLayerGids, METH_KEYWORDS|METH_VARARGS, NULL },
+    {(char *) "reportProgress", (PyCFunction) _wrap_tiled_reportProgress, METH_KEYWORDS|METH_VARARGS, NULL },
     {NULL, NULL, 0, NULL}
 };
 /* --- classes --- */
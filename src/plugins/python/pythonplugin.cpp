@@ -25,6 +25,7 @@
 #include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
+#include <QThreadStorage>
 
 namespace Python {
 
@@ -39,9 +40,84 @@ static void handleError()
         PyErr_Print();
 }
 
+/**
+ * Holds the global interpreter lock for as long as it exists. Map formats
+ * may be used from any thread, so each entry into Python needs this.
+ */
+class GilLock
+{
+public:
+    GilLock() : mState(PyGILState_Ensure()) {}
+    ~GilLock() { PyGILState_Release(mState); }
+
+private:
+    Q_DISABLE_COPY(GilLock)
+
+    PyGILState_STATE mState;
+};
+
+/**
+ * The map being read or written by a script on the current thread, used to
+ * attribute the progress reported by the script.
+ */
+struct ScriptProgress
+{
+    ScriptProgress()
+        : plugin(nullptr)
+        , percentage(-1)
+    {}
+
+    PythonPlugin *plugin;
+    QString fileName;
+    int percentage;
+};
+
+static QThreadStorage<ScriptProgress> currentProgress;
+
+class ProgressScope
+{
+public:
+    ProgressScope(PythonPlugin *plugin, const QString &fileName)
+    {
+        ScriptProgress progress;
+        progress.plugin = plugin;
+        progress.fileName = fileName;
+        currentProgress.setLocalData(progress);
+    }
+
+    ~ProgressScope()
+    {
+        currentProgress.setLocalData(ScriptProgress());
+    }
+};
+
+/**
+ * Called by scripts through tiled.reportProgress(done, total). Each change
+ * in percentage is logged, which reaches the console also when the script
+ * runs on a worker thread.
+ */
+void reportProgress(int done, int total)
+{
+    if (!currentProgress.hasLocalData() || total <= 0)
+        return;
+
+    ScriptProgress &progress = currentProgress.localData();
+    if (!progress.plugin)
+        return;
+
+    const int percentage = qBound(0, int(qint64(done) * 100 / total), 100);
+    if (percentage == progress.percentage)
+        return;
+
+    progress.percentage = percentage;
+    progress.plugin->log(PythonPlugin::tr("-- %1: %2%")
+                         .arg(progress.fileName).arg(percentage));
+}
+
 PythonPlugin::PythonPlugin()
     : mScriptDir(QDir::homePath() + "/.tiled")
     , mPluginClass(nullptr)
+    , mMainThreadState(nullptr)
 {
     mReloadTimer.setSingleShot(true);
     mReloadTimer.setInterval(1000);
@@ -52,6 +128,12 @@ PythonPlugin::PythonPlugin()
 
 PythonPlugin::~PythonPlugin()
 {
+    if (!Py_IsInitialized())
+        return;
+
+    // Take back the interpreter lock released after initialization
+    PyEval_RestoreThread(mMainThreadState);
+
     for (const ScriptEntry &script : mScripts) {
         Py_DECREF(script.module);
         Py_DECREF(script.mapFormat->pythonClass());
@@ -66,60 +148,7 @@ void PythonPlugin::initialize()
 {
     addObject(&mLogger);
 
-    if (!Py_IsInitialized()) {
-        // PEP370
-        Py_NoSiteFlag = 1;
-        Py_NoUserSiteDirectory = 1;
-
-        Py_Initialize();
-        inittiled();
-
-        // Get reference to base class to find its extensions later on
-        PyObject *pmod = PyImport_ImportModule("tiled");
-        if (pmod) {
-            PyObject *tiledPlugin = PyObject_GetAttrString(pmod, "Plugin");
-            Py_DECREF(pmod);
-
-            if (tiledPlugin) {
-                if (PyCallable_Check(tiledPlugin)) {
-                    mPluginClass = tiledPlugin;
-                } else {
-                    Py_DECREF(tiledPlugin);
-                }
-            }
-        }
-
-        if (!mPluginClass) {
-            log(Tiled::LoggingInterface::ERROR, "Can't find tiled.Plugin baseclass\n");
-            handleError();
-            return;
-        }
-
-        // w/o differentiating error messages could just rename "log"
-        // to "write" in the binding and assign plugin directly to stdout/stderr
-        PySys_SetObject((char *)"_tiledplugin",
-                        _wrap_convert_c2py__Tiled__LoggingInterface(&mLogger));
-
-        PyRun_SimpleString("import sys\n"
-                           "#from tiled.Tiled.LoggingInterface import INFO,ERROR\n"
-                           "class _Catcher:\n"
-                           "   def __init__(self, type):\n"
-                           "      self.buffer = ''\n"
-                           "      self.type = type\n"
-                           "   def write(self, msg):\n"
-                           "      self.buffer += msg\n"
-                           "      if self.buffer.endswith('\\n'):\n"
-                           "         sys._tiledplugin.log(self.type, self.buffer)\n"
-                           "         self.buffer = ''\n"
-                           "sys.stdout = _Catcher(0)\n"
-                           "sys.stderr = _Catcher(1)\n");
-
-        PyRun_SimpleString(QString("import sys; sys.path.insert(0, \"%1\")")
-                           .arg(mScriptDir).toUtf8().constData());
-
-        log(QString("-- Added %1 to path\n").arg(mScriptDir));
-    }
-
+    // Python is only initialized once there are scripts to load
     reloadModules();
 
     if (QFile::exists(mScriptDir)) {
@@ -130,6 +159,62 @@ void PythonPlugin::initialize()
     }
 }
 
+void PythonPlugin::initializePython()
+{
+    // PEP370
+    Py_NoSiteFlag = 1;
+    Py_NoUserSiteDirectory = 1;
+
+    Py_Initialize();
+    PyEval_InitThreads();
+    inittiled();
+
+    // Get reference to base class to find its extensions later on
+    PyObject *pmod = PyImport_ImportModule("tiled");
+    if (pmod) {
+        PyObject *tiledPlugin = PyObject_GetAttrString(pmod, "Plugin");
+        Py_DECREF(pmod);
+
+        if (tiledPlugin) {
+            if (PyCallable_Check(tiledPlugin)) {
+                mPluginClass = tiledPlugin;
+            } else {
+                Py_DECREF(tiledPlugin);
+            }
+        }
+    }
+
+    if (!mPluginClass) {
+        log(Tiled::LoggingInterface::ERROR, "Can't find tiled.Plugin baseclass\n");
+        handleError();
+        return;
+    }
+
+    // w/o differentiating error messages could just rename "log"
+    // to "write" in the binding and assign plugin directly to stdout/stderr
+    PySys_SetObject((char *)"_tiledplugin",
+                    _wrap_convert_c2py__Tiled__LoggingInterface(&mLogger));
+
+    PyRun_SimpleString("import sys\n"
+                       "#from tiled.Tiled.LoggingInterface import INFO,ERROR\n"
+                       "class _Catcher:\n"
+                       "   def __init__(self, type):\n"
+                       "      self.buffer = ''\n"
+                       "      self.type = type\n"
+                       "   def write(self, msg):\n"
+                       "      self.buffer += msg\n"
+                       "      if self.buffer.endswith('\\n'):\n"
+                       "         sys._tiledplugin.log(self.type, self.buffer)\n"
+                       "         self.buffer = ''\n"
+                       "sys.stdout = _Catcher(0)\n"
+                       "sys.stderr = _Catcher(1)\n");
+
+    PyRun_SimpleString(QString("import sys; sys.path.insert(0, \"%1\")")
+                       .arg(mScriptDir).toUtf8().constData());
+
+    log(QString("-- Added %1 to path\n").arg(mScriptDir));
+}
+
 void PythonPlugin::log(Tiled::LoggingInterface::OutputType type,
                        const QString &msg)
 {
@@ -146,11 +231,25 @@ void PythonPlugin::log(const QString &msg)
  */
 void PythonPlugin::reloadModules()
 {
-    log(tr("Reloading Python scripts"));
-
     const QStringList pyfilter("*.py");
     QDirIterator iter(mScriptDir, pyfilter, QDir::Files | QDir::Readable);
 
+    if (!iter.hasNext())
+        return;
+    if (!Py_IsInitialized()) {
+        initializePython();
+
+        // Release the interpreter lock, which is taken whenever Python is
+        // entered, possibly from the thread saving a map in the background
+        mMainThreadState = PyEval_SaveThread();
+    }
+    if (!mPluginClass)
+        return;
+
+    GilLock lock;
+
+    log(tr("Reloading Python scripts"));
+
     while (iter.hasNext()) {
         iter.next();
 
@@ -265,6 +364,9 @@ Tiled::Map *PythonMapFormat::read(const QString &fileName)
 {
     mError = QString();
 
+    GilLock lock;
+    ProgressScope progressScope(&mPlugin, fileName);
+
     mPlugin.log(tr("-- Using script %1 to read %2").arg(mScriptFile, fileName));
 
     if (!PyObject_HasAttrString(mClass, "read")) {
@@ -293,6 +395,14 @@ bool PythonMapFormat::write(const Tiled::Map *map, const QString &fileName)
 {
     mError = QString();
 
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
+    GilLock lock;
+    ProgressScope progressScope(&mPlugin, fileName);
+
     mPlugin.log(tr("-- Using script %1 to write %2").arg(mScriptFile, fileName));
 
     PyObject *pmap = _wrap_convert_c2py__Tiled__Map_const(map);
@@ -320,6 +430,8 @@ bool PythonMapFormat::write(const Tiled::Map *map, const QString &fileName)
 
 bool PythonMapFormat::supportsFile(const QString &fileName) const
 {
+    GilLock lock;
+
     if (!PyObject_HasAttrString(mClass, "supportsFile"))
         return false;
 
@@ -339,6 +451,8 @@ bool PythonMapFormat::supportsFile(const QString &fileName) const
 
 QString PythonMapFormat::nameFilter() const
 {
+    GilLock lock;
+
     QString ret;
 
     // find fun
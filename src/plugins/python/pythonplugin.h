@@ -44,6 +44,8 @@ namespace Python {
 
 class PythonMapFormat;
 
+void reportProgress(int done, int total);
+
 struct ScriptEntry
 {
     ScriptEntry()
@@ -75,12 +77,14 @@ private slots:
     void reloadModules();
 
 private:
+    void initializePython();
     bool loadOrReloadModule(ScriptEntry &script);
     PyObject *findPluginSubclass(PyObject *module);
 
     QString mScriptDir;
     QMap<QString,ScriptEntry> mScripts;
     PyObject *mPluginClass;
+    PyThreadState *mMainThreadState;
 
     QFileSystemWatcher mFileSystemWatcher;
     QTimer mReloadTimer;
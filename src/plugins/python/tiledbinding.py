@@ -30,6 +30,8 @@ mod.add_include('"imagelayer.h"')
 mod.add_include('"tilelayer.h"')
 mod.add_include('"objectgroup.h"')
 mod.add_include('"tileset.h"')
+mod.add_include('"gidmapper.h"')
+mod.add_include('<QtEndian>')
 
 mod.header.writeln('#pragma GCC diagnostic ignored "-Wmissing-field-initializers"')
 
@@ -288,6 +290,95 @@ bool loadTilesetFromFile(Tiled::Tileset *ts, QString file)
 }
 """)
 
+mod.body.writeln("""
+/*
+ * Returns the global tile IDs of all cells of the given layer, row by row,
+ * as a bytearray of little-endian 32-bit integers. The gids are based on the
+ * tilesets of the given map, in the same way as when the map is saved. Can be
+ * wrapped without copying by numpy.frombuffer(gids, dtype='<u4').
+ */
+PyObject *layerGids(Tiled::TileLayer *layer, Tiled::Map *map)
+{
+    const int width = layer->width();
+    const int height = layer->height();
+
+    PyObject *gids = PyByteArray_FromStringAndSize(NULL, Py_ssize_t(width) * height * 4);
+    if (!gids)
+        return NULL;
+
+    const Tiled::GidMapper gidMapper(map->tilesets());
+    QVector<unsigned> row(width);
+    uchar *data = reinterpret_cast<uchar*>(PyByteArray_AS_STRING(gids));
+
+    // Other threads may run Python while the gids are gathered
+    Py_BEGIN_ALLOW_THREADS
+    for (int y = 0; y < height; ++y) {
+        gidMapper.cellsToGids(*layer, y, row.data());
+        for (int x = 0; x < width; ++x, data += 4)
+            qToLittleEndian<quint32>(row.at(x), data);
+    }
+    Py_END_ALLOW_THREADS
+
+    return gids;
+}
+
+/*
+ * Sets all cells of the given layer from gids in the format returned by
+ * layerGids, given as any object supporting the buffer protocol, like a
+ * bytearray or a contiguous numpy array of dtype '<u4'. Raises a ValueError
+ * and leaves the layer unchanged when the size is wrong or a gid is invalid.
+ */
+PyObject *setLayerGids(Tiled::TileLayer *layer, Tiled::Map *map, PyObject *gids)
+{
+    Py_buffer view;
+    if (PyObject_GetBuffer(gids, &view, PyBUF_SIMPLE) != 0)
+        return NULL;
+
+    const int width = layer->width();
+    const int height = layer->height();
+
+    if (view.len != Py_ssize_t(width) * height * 4) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "expected %d gids", width * height);
+        return NULL;
+    }
+
+    const Tiled::GidMapper gidMapper(map->tilesets());
+    Tiled::TileLayer decoded(QString(), 0, 0, width, height);
+    Tiled::GidMapper::DecodeError error;
+
+    // The buffer stays valid while other threads run Python
+    Py_BEGIN_ALLOW_THREADS
+    error = gidMapper.decodeLayerData(decoded, static_cast<const uchar*>(view.buf));
+    if (error == Tiled::GidMapper::NoError)
+        layer->setCells(0, 0, &decoded);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&view);
+
+    if (error != Tiled::GidMapper::NoError) {
+        PyErr_Format(PyExc_ValueError, "invalid tile: %u", gidMapper.invalidTile());
+        return NULL;
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+""")
+
+mod.add_function('layerGids',
+    retval('PyObject*',caller_owns_return=True),
+    [param('Tiled::TileLayer*','layer',transfer_ownership=False),
+     param('Tiled::Map*','map',transfer_ownership=False)])
+mod.add_function('setLayerGids',
+    retval('PyObject*',caller_owns_return=True),
+    [param('Tiled::TileLayer*','layer',transfer_ownership=False),
+     param('Tiled::Map*','map',transfer_ownership=False),
+     param('PyObject*','gids',transfer_ownership=False)])
+mod.add_function('reportProgress', None,
+    [('int','done'),('int','total')],
+    foreign_cpp_namespace='Python')
+
 """
  C++ class PythonScript is seen as Tiled.Plugin from Python script
  (naming describes the opposite side from either perspective)
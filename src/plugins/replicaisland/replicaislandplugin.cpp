@@ -234,6 +234,11 @@ bool ReplicaIslandPlugin::write(const Tiled::Map *map, const QString &fileName)
 {
     using namespace Tiled;
 
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
     // Open up a temporary file for saving the level.
     QSaveFile file(fileName);
     if (!file.open(QIODevice::WriteOnly)) {
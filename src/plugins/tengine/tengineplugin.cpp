@@ -31,6 +31,7 @@
 #include <QTextStream>
 #include <QHash>
 #include <QList>
+#include <QVector>
 
 #include <math.h>
 
@@ -44,6 +45,11 @@ bool TenginePlugin::write(const Tiled::Map *map, const QString &fileName)
 {
     using namespace Tiled;
 
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
     QSaveFile file(fileName);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         mError = tr("Could not open file for writing.");
@@ -60,7 +66,6 @@ bool TenginePlugin::write(const Tiled::Map *map, const QString &fileName)
     const int width = map->width();
     const int height = map->height();
 
-    QList<QString> asciiMap;
     QHash<QString, Tiled::Properties> cachedTiles;
     QList<QString> propertyOrder;
     propertyOrder.append("terrain");
@@ -79,54 +84,134 @@ bool TenginePlugin::write(const Tiled::Map *map, const QString &fileName)
     Properties emptyTile;
     emptyTile["display"] = "?";
     cachedTiles["?"] = emptyTile;
-    // Process the map, collecting used display strings as we go
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            Properties currentTile = cachedTiles["?"];
-            foreach (Layer *layer, map->layers()) {
-                // If the layer name does not start with one of the tile properties, skip it
-                QString layerKey;
-                QListIterator<QString> propertyIterator = propertyOrder;
-                while (propertyIterator.hasNext()) {
-                    QString currentProperty = propertyIterator.next();
-                    if (layer->name().startsWith(currentProperty, Qt::CaseInsensitive)) {
-                        layerKey = currentProperty;
-                        break;
+
+    // Each cell starts out as the empty tile, and every tile or object
+    // covering it changes its properties. Cells that are covered by the same
+    // sequence of tiles and objects end up with the same properties, so the
+    // distinct results are computed only once, as states that are looked up
+    // by the previous state and the tile or object applied to it.
+    QVector<Properties> stateProperties;
+    stateProperties.append(emptyTile);
+    QHash<quint64, int> transitions;
+    QVector<int> cellStates(width * height, 0);
+
+    auto applySource = [&] (int &state, int source,
+                            const QString &layerKey,
+                            const QString *display,
+                            const QString *value) {
+        const quint64 key = (quint64(state) << 32) | unsigned(source);
+        auto it = transitions.constFind(key);
+        if (it != transitions.constEnd()) {
+            state = it.value();
+            return;
+        }
+
+        Properties properties = stateProperties.at(state);
+        if (display)
+            properties["display"] = *display;
+        if (value)
+            properties[layerKey] = *value;
+
+        const int newState = stateProperties.size();
+        stateProperties.append(properties);
+        transitions.insert(key, newState);
+        state = newState;
+    };
+
+    int sourceCount = 0;
+
+    foreach (Layer *layer, map->layers()) {
+        // If the layer name does not start with one of the tile properties, skip it
+        QString layerKey;
+        for (const QString &currentProperty : propertyOrder) {
+            if (layer->name().startsWith(currentProperty, Qt::CaseInsensitive)) {
+                layerKey = currentProperty;
+                break;
+            }
+        }
+        if (layerKey.isEmpty()) {
+            continue;
+        }
+        TileLayer *tileLayer = layer->asTileLayer();
+        ObjectGroup *objectLayer = layer->asObjectGroup();
+        // Process the Tile Layer, row by row
+        if (tileLayer) {
+            struct TileSource {
+                int id;
+                QString display;
+                QString value;
+            };
+            QHash<const Tile*, TileSource> tileSources;
+
+            const int layerWidth = qMin(width, tileLayer->width());
+            const int layerHeight = qMin(height, tileLayer->height());
+
+            for (int y = 0; y < layerHeight; ++y) {
+                int *row = cellStates.data() + y * width;
+
+                for (int x = 0; x < layerWidth; ++x) {
+                    const Tile *tile = tileLayer->cellAt(x, y).tile;
+                    if (!tile)
+                        continue;
+
+                    auto it = tileSources.find(tile);
+                    if (it == tileSources.end()) {
+                        TileSource source;
+                        source.id = sourceCount++;
+                        source.display = tile->property("display");
+                        source.value = tile->property("value");
+                        it = tileSources.insert(tile, source);
                     }
+
+                    applySource(row[x], it->id, layerKey, &it->display, &it->value);
                 }
-                if (layerKey.isEmpty()) {
-                    continue;
-                }
-                TileLayer *tileLayer = layer->asTileLayer();
-                ObjectGroup *objectLayer = layer->asObjectGroup();
-                // Process the Tile Layer
-                if (tileLayer) {
-                    Tile *tile = tileLayer->cellAt(x, y).tile;
-                    if (tile) {
-                        currentTile["display"] = tile->property("display");
-                        currentTile[layerKey] = tile->property("value");
-                    }
-                // Process the Object Layer
-                } else if (objectLayer) {
-                    foreach (const MapObject *obj, objectLayer->objects()) {
-                        if (floor(obj->y()) <= y && y <= floor(obj->y() + obj->height())) {
-                            if (floor(obj->x()) <= x && x <= floor(obj->x() + obj->width())) {
-                                // Check the Object Layer properties if either display or value was missing
-                                if (!obj->property("display").isEmpty()) {
-                                    currentTile["display"] = obj->property("display");
-                                } else if (!objectLayer->property("display").isEmpty()) {
-                                    currentTile["display"] = objectLayer->property("display");
-                                }
-                                if (!obj->property("value").isEmpty()) {
-                                    currentTile[layerKey] = obj->property("value");
-                                } else if (!objectLayer->property("value").isEmpty()) {
-                                    currentTile[layerKey] = objectLayer->property("value");
-                                }
-                            }
-                        }
+            }
+        // Process the Object Layer, only visiting the cells each object covers
+        } else if (objectLayer) {
+            const QString layerDisplay = objectLayer->property("display");
+            const QString layerValue = objectLayer->property("value");
+
+            foreach (const MapObject *obj, objectLayer->objects()) {
+                // Check the Object Layer properties if either display or value was missing
+                QString display = obj->property("display");
+                if (display.isEmpty())
+                    display = layerDisplay;
+                QString value = obj->property("value");
+                if (value.isEmpty())
+                    value = layerValue;
+
+                const int source = sourceCount++;
+                const int startX = qMax(0, int(floor(obj->x())));
+                const int startY = qMax(0, int(floor(obj->y())));
+                const int endX = qMin(width - 1, int(floor(obj->x() + obj->width())));
+                const int endY = qMin(height - 1, int(floor(obj->y() + obj->height())));
+
+                for (int y = startY; y <= endY; ++y) {
+                    int *row = cellStates.data() + y * width;
+                    for (int x = startX; x <= endX; ++x) {
+                        applySource(row[x], source, layerKey,
+                                    display.isEmpty() ? nullptr : &display,
+                                    value.isEmpty() ? nullptr : &value);
                     }
                 }
             }
+        }
+    }
+
+    // Resolves the display string of each state, the first time a cell in
+    // that state is found, collecting used display strings as we go
+    QVector<int> stateDisplays(stateProperties.size(), -1);
+    QVector<bool> stateIsEmpty(stateProperties.size(), false);
+    QStringList displayStrings;
+    QVector<int> asciiMap(width * height);
+
+    for (int index = 0; index < width * height; ++index) {
+        const int state = cellStates.at(index);
+        int &display = stateDisplays[state];
+
+        if (display == -1) {
+            Properties currentTile = stateProperties.at(state);
+
             // If the currentTile does not exist in the cache, add it
             if (!cachedTiles.contains(currentTile["display"])) {
                 cachedTiles[currentTile["display"]] = currentTile;
@@ -171,14 +256,20 @@ bool TenginePlugin::write(const Tiled::Map *map, const QString &fileName)
             if (currentTile["display"].length() > 1) {
                 outputLists = true;
             }
-            // Check if we are still the emptyTile
-            if (currentTile == emptyTile) {
-                numEmptyTiles++;
-            }
-            // Finally add the character to the asciiMap
-            asciiMap.append(currentTile["display"]);
+
+            display = displayStrings.size();
+            displayStrings.append(currentTile["display"]);
+            stateIsEmpty[state] = currentTile == emptyTile;
+        }
+
+        // Check if we are still the emptyTile
+        if (stateIsEmpty.at(state)) {
+            numEmptyTiles++;
         }
+        // Finally add the character to the asciiMap
+        asciiMap[index] = display;
     }
+
     // Write the definitions to the file
     out << "-- defineTile section" << endl;
     for (i = cachedTiles.constBegin(); i != cachedTiles.constEnd(); ++i) {
@@ -270,15 +361,24 @@ bool TenginePlugin::write(const Tiled::Map *map, const QString &fileName)
     }
     out << endl << "-- ASCII map section" << endl;
     out << "return " << returnStart << endl;
+
+    // Each row is built in a single buffer before it is written
+    QString line;
     for (int y = 0; y < height; ++y) {
-        out << lineStart;
+        line.resize(0);
+        line += lineStart;
+        const int *row = asciiMap.constData() + y * width;
         for (int x = 0; x < width; ++x) {
-            out << itemStart << asciiMap[x + (y * width)] << itemStop << seperator;
+            line += itemStart;
+            line += displayStrings.at(row[x]);
+            line += itemStop;
+            line += seperator;
         }
+        line += lineStop;
         if (y == height - 1) {
-            out << lineStop << returnStop;
+            out << line << returnStop;
         } else {
-            out << lineStop << endl;
+            out << line << endl;
         }
     }
 
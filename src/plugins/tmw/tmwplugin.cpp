@@ -37,6 +37,11 @@ bool TmwPlugin::write(const Tiled::Map *map, const QString &fileName)
 {
     using namespace Tiled;
 
+    if (map->infinite()) {
+        mError = tr("Infinite maps are not supported by this format.");
+        return false;
+    }
+
     TileLayer *collisionLayer = nullptr;
 
     foreach (Layer *layer, map->layers()) {
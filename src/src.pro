@@ -4,4 +4,5 @@ CONFIG   += ordered
 SUBDIRS = libtiled tiled plugins \
     tmxviewer \
     tmxrasterizer \
+    tmxdiff \
     automappingconverter
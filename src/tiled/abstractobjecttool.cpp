@@ -112,11 +112,7 @@ ObjectGroup *AbstractObjectTool::currentObjectGroup() const
 
 MapObjectItem *AbstractObjectTool::topMostObjectItemAt(QPointF pos) const
 {
-    foreach (QGraphicsItem *item, mMapScene->items(pos)) {
-        if (MapObjectItem *objectItem = qgraphicsitem_cast<MapObjectItem*>(item))
-            return objectItem;
-    }
-    return nullptr;
+    return mMapScene->topMostObjectItemAt(pos);
 }
 
 void AbstractObjectTool::duplicateObjects()
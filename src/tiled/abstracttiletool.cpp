@@ -117,7 +117,7 @@ void AbstractTileTool::updateStatusInfo()
 
         if (const TileLayer *tileLayer = currentTileLayer()) {
             const QPoint pos = tilePosition() - tileLayer->position();
-            if (tileLayer->contains(pos))
+            if (tileLayer->isInfinite() || tileLayer->contains(pos))
                 tile = tileLayer->cellAt(pos).tile;
         }
 
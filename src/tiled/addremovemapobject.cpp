@@ -23,7 +23,6 @@
 #include "mapdocument.h"
 #include "mapobject.h"
 #include "objectgroup.h"
-#include "mapobjectmodel.h"
 
 #include <QCoreApplication>
 
@@ -88,3 +87,74 @@ RemoveMapObject::RemoveMapObject(MapDocument *mapDocument,
 {
     setText(QCoreApplication::translate("Undo Commands", "Remove Object"));
 }
+
+
+AddRemoveMapObjects::AddRemoveMapObjects(MapDocument *mapDocument,
+                                         const QVector<MapObjectModel::ObjectEntry> &entries,
+                                         bool ownObjects,
+                                         QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , mMapDocument(mapDocument)
+    , mEntries(entries)
+    , mOwnsObjects(ownObjects)
+{
+}
+
+AddRemoveMapObjects::~AddRemoveMapObjects()
+{
+    if (mOwnsObjects)
+        for (const MapObjectModel::ObjectEntry &entry : mEntries)
+            delete entry.mapObject;
+}
+
+void AddRemoveMapObjects::addObjects()
+{
+    mMapDocument->mapObjectModel()->insertObjects(mEntries);
+    mOwnsObjects = false;
+}
+
+void AddRemoveMapObjects::removeObjects()
+{
+    QList<MapObject*> objects;
+    objects.reserve(mEntries.size());
+    for (const MapObjectModel::ObjectEntry &entry : mEntries)
+        objects.append(entry.mapObject);
+
+    mEntries = mMapDocument->mapObjectModel()->removeObjects(objects);
+    mOwnsObjects = true;
+}
+
+
+AddMapObjects::AddMapObjects(MapDocument *mapDocument,
+                             const QVector<MapObjectModel::ObjectEntry> &entries,
+                             QUndoCommand *parent)
+    : AddRemoveMapObjects(mapDocument,
+                          entries,
+                          true,
+                          parent)
+{
+    setText(QCoreApplication::translate("Undo Commands", "Add %n Object(s)",
+                                        nullptr, entries.size()));
+}
+
+
+static QVector<MapObjectModel::ObjectEntry> toEntries(const QList<MapObject*> &mapObjects)
+{
+    QVector<MapObjectModel::ObjectEntry> entries;
+    entries.reserve(mapObjects.size());
+    for (MapObject *mapObject : mapObjects)
+        entries.append(MapObjectModel::ObjectEntry(mapObject, mapObject->objectGroup()));
+    return entries;
+}
+
+RemoveMapObjects::RemoveMapObjects(MapDocument *mapDocument,
+                                   const QList<MapObject*> &mapObjects,
+                                   QUndoCommand *parent)
+    : AddRemoveMapObjects(mapDocument,
+                          toEntries(mapObjects),
+                          false,
+                          parent)
+{
+    setText(QCoreApplication::translate("Undo Commands", "Remove %n Object(s)",
+                                        nullptr, mapObjects.size()));
+}
@@ -21,6 +21,8 @@
 #ifndef ADDREMOVEMAPOBJECT_H
 #define ADDREMOVEMAPOBJECT_H
 
+#include "mapobjectmodel.h"
+
 #include <QUndoCommand>
 
 namespace Tiled {
@@ -89,6 +91,63 @@ public:
     { removeObject(); }
 };
 
+/**
+ * Abstract base class for AddMapObjects and RemoveMapObjects, which add or
+ * remove any number of objects in one go.
+ */
+class AddRemoveMapObjects : public QUndoCommand
+{
+public:
+    AddRemoveMapObjects(MapDocument *mapDocument,
+                        const QVector<MapObjectModel::ObjectEntry> &entries,
+                        bool ownObjects,
+                        QUndoCommand *parent = nullptr);
+    ~AddRemoveMapObjects();
+
+protected:
+    void addObjects();
+    void removeObjects();
+
+private:
+    MapDocument *mMapDocument;
+    QVector<MapObjectModel::ObjectEntry> mEntries;
+    bool mOwnsObjects;
+};
+
+/**
+ * Undo command that adds a number of objects to a map.
+ */
+class AddMapObjects : public AddRemoveMapObjects
+{
+public:
+    AddMapObjects(MapDocument *mapDocument,
+                  const QVector<MapObjectModel::ObjectEntry> &entries,
+                  QUndoCommand *parent = nullptr);
+
+    void undo() override
+    { removeObjects(); }
+
+    void redo() override
+    { addObjects(); }
+};
+
+/**
+ * Undo command that removes a number of objects from a map.
+ */
+class RemoveMapObjects : public AddRemoveMapObjects
+{
+public:
+    RemoveMapObjects(MapDocument *mapDocument,
+                     const QList<MapObject*> &mapObjects,
+                     QUndoCommand *parent = nullptr);
+
+    void undo() override
+    { addObjects(); }
+
+    void redo() override
+    { removeObjects(); }
+};
+
 } // namespace Internal
 } // namespace Tiled
 
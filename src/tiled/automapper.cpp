@@ -26,6 +26,8 @@
 #include "automappingutils.h"
 #include "changeproperties.h"
 #include "geometry.h"
+#include "hexagonalrenderer.h"
+#include "isometricrenderer.h"
 #include "layermodel.h"
 #include "map.h"
 #include "mapdocument.h"
@@ -33,11 +35,22 @@
 #include "maprenderer.h"
 #include "object.h"
 #include "objectgroup.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tilemask.h"
 #include "tilesetmanager.h"
+#include "tracing.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -52,8 +65,15 @@ using namespace Tiled::Internal;
 
 AutoMapper::AutoMapper(MapDocument *workingDocument, Map *rules,
                        const QString &rulePath)
-    : mMapDocument(workingDocument)
-    , mMapWork(workingDocument ? workingDocument->map() : nullptr)
+    : AutoMapper(workingDocument ? workingDocument->map() : nullptr,
+                 rules, rulePath)
+{
+    mMapDocument = workingDocument;
+}
+
+AutoMapper::AutoMapper(Map *workingMap, Map *rules, const QString &rulePath)
+    : mMapDocument(nullptr)
+    , mMapWork(workingMap)
     , mMapRules(rules)
     , mLayerInputRegions(nullptr)
     , mLayerOutputRegions(nullptr)
@@ -61,6 +81,7 @@ AutoMapper::AutoMapper(MapDocument *workingDocument, Map *rules,
     , mDeleteTiles(false)
     , mAutoMappingRadius(0)
     , mNoOverlappingRules(false)
+    , mStaticInput(false)
 {
     Q_ASSERT(mMapRules);
 
@@ -319,6 +340,8 @@ bool AutoMapper::setupRuleList()
         Q_ASSERT(coherentRegions(checkCoherent).length() == 1);
     }
 
+    compileRules();
+
     return true;
 }
 
@@ -350,8 +373,7 @@ bool AutoMapper::setupMissingLayers()
         TileLayer *tilelayer = new TileLayer(name, 0, 0,
                                              mMapWork->width(),
                                              mMapWork->height());
-        mMapDocument->undoStack()->push(
-                    new AddLayer(mMapDocument, index, tilelayer));
+        addLayer(index, tilelayer);
         mAddedTileLayers.append(name);
     }
 
@@ -363,8 +385,7 @@ bool AutoMapper::setupMissingLayers()
         ObjectGroup *objectGroup = new ObjectGroup(name, 0, 0,
                                                    mMapWork->width(),
                                                    mMapWork->height());
-        mMapDocument->undoStack()->push(
-                    new AddLayer(mMapDocument, index, objectGroup));
+        addLayer(index, objectGroup);
         mAddedTileLayers.append(name);
     }
 
@@ -399,19 +420,20 @@ bool AutoMapper::setupCorrectIndexes()
 bool AutoMapper::setupTilesets(Map *src, Map *dst)
 {
     const QVector<SharedTileset> &existingTilesets = dst->tilesets();
+    TilesetsByFingerprint similarTilesets = Tileset::byFingerprint(existingTilesets);
     TilesetManager *tilesetManager = TilesetManager::instance();
+    bool replacedTilesets = false;
 
     // Add tilesets that are not yet part of dst map
     foreach (const SharedTileset &tileset, src->tilesets()) {
         if (existingTilesets.contains(tileset))
             continue;
 
-        QUndoStack *undoStack = mMapDocument->undoStack();
-
-        SharedTileset replacement = tileset->findSimilarTileset(existingTilesets);
+        SharedTileset replacement = tileset->findSimilarTileset(similarTilesets);
         if (!replacement) {
             mAddedTilesets.append(tileset);
-            undoStack->push(new AddTileset(mMapDocument, tileset));
+            addTileset(tileset);
+            similarTilesets.insert(tileset->fingerprint(), tileset);
             continue;
         }
 
@@ -423,22 +445,31 @@ bool AutoMapper::setupTilesets(Map *src, Map *dst)
             Properties properties = replacementTile->properties();
             properties.merge(tileset->tileAt(i)->properties());
 
-            undoStack->push(new ChangeProperties(mMapDocument,
-                                                 tr("Tile"),
-                                                 replacementTile,
-                                                 properties));
+            setTileProperties(replacementTile, properties);
         }
         src->replaceTileset(tileset, replacement);
+        replacedTilesets = true;
 
         tilesetManager->addReference(replacement);
         tilesetManager->removeReference(tileset);
     }
+
+    // The compiled rules refer to the tiles of the replaced tilesets
+    if (replacedTilesets && src == mMapRules)
+        compileRules();
+
     return true;
 }
 
 void AutoMapper::autoMap(QRegion *where)
 {
+    TraceScope trace("AutoMapper::autoMap", mRulePath);
+
     Q_ASSERT(mRulesInput.size() == mRulesOutput.size());
+    Q_ASSERT(mRulesInput.size() == mCompiledRules.size());
+
+    resolveInputLayers();
+
     // first resize the active area
     if (mAutoMappingRadius) {
         QRegion region;
@@ -463,9 +494,7 @@ void AutoMapper::autoMap(QRegion *where)
                 if (dstTileLayer)
                     dstTileLayer->erase(region);
                 else
-                    eraseRegionObjectGroup(mMapDocument,
-                                           dstLayer->asObjectGroup(),
-                                           region);
+                    eraseObjects(dstLayer->asObjectGroup(), region);
             }
         }
     }
@@ -473,110 +502,190 @@ void AutoMapper::autoMap(QRegion *where)
     // Increase the given region where the next automapper should work.
     // This needs to be done, so you can rely on the order of the rules at all
     // locations
-    QRegion ret;
-    foreach (const QRect &rect, where->rects())
-        for (int i = 0; i < mRulesInput.size(); ++i) {
-            // at the moment the parallel execution does not work yet
-            // TODO: make multithreading available!
-            // either by dividing the rules or the region to multiple threads
-            ret = ret.united(applyRule(i, rect));
-        }
-    *where = where->united(ret);
+    //
+    // The changed area is tracked as a mask, which is only converted to a
+    // region once all rules have been applied.
+    TileMask changed;
+    if (mStaticInput)
+        buildTileIndex(*where);
+
+    // The rules are applied one after the other, since each rule may depend
+    // on the output of the rules before it. The matches of a single rule
+    // are searched for in parallel when possible, see applyRule().
+    for (int i = 0; i < mRulesInput.size(); ++i)
+        applyRule(i, *where, changed);
+    *where = where->united(changed.toRegion());
+
+    addPendingObjects();
 }
 
 const QRegion AutoMapper::getSetLayersRegion()
 {
-    QRegion result;
+    // The layers are combined as masks, since uniting fragmented regions
+    // gets slow
+    TileMask result;
     foreach (const QString &name, mInputRules.names) {
-        const int index = mMapWork->indexOfLayer(name, Layer::TileLayerType);
-        if (index == -1)
-            continue;
-        TileLayer *setLayer = mMapWork->layerAt(index)->asTileLayer();
-        result |= setLayer->region();
+        if (Layer *setLayer = mMapWork->findLayer(name, Layer::TileLayerType))
+            result += setLayer->asTileLayer()->mask();
     }
-    return result;
+    return result.toRegion();
 }
 
-static bool compareLayerTo(const TileLayer *setLayer,
-                           const QVector<TileLayer*> &listYes,
-                           const QVector<TileLayer*> &listNo,
-                           const QRegion &ruleRegion, const QPoint &offset);
+static bool matchesRule(const CompiledRule &rule,
+                        const QVector<const TileLayer*> &inputLayers,
+                        const QPoint &offset);
 
-QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
+/**
+ * Calls \a function with the x and y coordinates of each position in the
+ * given \a region, in row order.
+ */
+template<typename Function>
+static void forEachPosition(const QRegion &region, Function function)
 {
-    QRect ret;
+    const QVector<QRect> rects = region.rects();
+
+    // The rects of a region are sorted into bands of equal height
+    int bandStart = 0;
+    while (bandStart < rects.size()) {
+        const QRect &first = rects.at(bandStart);
+
+        int bandEnd = bandStart + 1;
+        while (bandEnd < rects.size() && rects.at(bandEnd).top() == first.top())
+            ++bandEnd;
+
+        for (int y = first.top(); y <= first.bottom(); ++y)
+            for (int i = bandStart; i < bandEnd; ++i)
+                for (int x = rects.at(i).left(); x <= rects.at(i).right(); ++x)
+                    function(x, y);
+
+        bandStart = bandEnd;
+    }
+}
+
+static qint64 positionCount(const QRegion &region)
+{
+    qint64 count = 0;
+    foreach (const QRect &rect, region.rects())
+        count += qint64(rect.width()) * rect.height();
+    return count;
+}
+
+/**
+ * Returns the union of the given \a rects, merging them pairwise to avoid
+ * the cost of adding them one by one.
+ */
+static QRegion unitedRects(const QVector<QRect> &rects, int begin, int end)
+{
+    if (end - begin == 0)
+        return QRegion();
+    if (end - begin == 1)
+        return QRegion(rects.at(begin));
+
+    const int middle = begin + (end - begin) / 2;
+    return unitedRects(rects, begin, middle) | unitedRects(rects, middle, end);
+}
 
+namespace {
+
+// The minimum number of positions for which to search matches in parallel
+const qint64 MinParallelPositions = 64 * 64;
+
+/**
+ * Searches for the matches of a rule within a band of rows.
+ */
+class RuleMatcher : public QRunnable
+{
+public:
+    RuleMatcher(const CompiledRule &rule,
+                const QVector<const TileLayer*> &inputLayers,
+                const QRegion &offsets,
+                QVector<QPoint> &matches)
+        : mRule(rule)
+        , mInputLayers(inputLayers)
+        , mOffsets(offsets)
+        , mMatches(matches)
+    {}
+
+    void run() override
+    {
+        forEachPosition(mOffsets, [this] (int x, int y) {
+            if (matchesRule(mRule, mInputLayers, QPoint(x, y)))
+                mMatches.append(QPoint(x, y));
+        });
+    }
+
+private:
+    const CompiledRule &mRule;
+    const QVector<const TileLayer*> &mInputLayers;
+    const QRegion mOffsets;
+    QVector<QPoint> &mMatches;
+};
+
+} // anonymous namespace
+
+QRegion AutoMapper::matchOffsets(int ruleIndex, const QRegion &where) const
+{
+    const QRegion &ruleInput = mRulesInput.at(ruleIndex);
+
+    // A match at a given offset depends on the cells covered by the input
+    // region translated by that offset. The offsets at which it covers any
+    // of the cells in the given region are found by sweeping each rect of
+    // the input region over each rect of the given region.
+    QVector<QRect> rects;
+    foreach (const QRect &r, where.rects()) {
+        foreach (const QRect &input, ruleInput.rects()) {
+            rects.append(QRect(QPoint(r.left() - input.right(),
+                                      r.top() - input.bottom()),
+                               QPoint(r.right() - input.left(),
+                                      r.bottom() - input.top())));
+        }
+    }
+
+    return unitedRects(rects, 0, rects.size());
+}
+
+void AutoMapper::applyRule(const int ruleIndex, const QRegion &where,
+                           TileMask &changed)
+{
     if (mLayerList.isEmpty())
-        return ret;
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    RuleStats &stats = mRuleStats[ruleIndex];
 
     const QRegion ruleInput = mRulesInput.at(ruleIndex);
     const QRegion ruleOutput = mRulesOutput.at(ruleIndex);
-    QRect rbr = ruleInput.boundingRect();
+    const CompiledRule &compiledRule = mCompiledRules.at(ruleIndex);
+    const QRect rbr = ruleInput.boundingRect();
 
-    // Since the rule itself is translated, we need to adjust the borders of the
-    // loops. Decrease the size at all sides by one: There must be at least one
-    // tile overlap to the rule.
-    const int minX = where.left() - rbr.left() - rbr.width() + 1;
-    const int minY = where.top() - rbr.top() - rbr.height() + 1;
+    // The area that may change when the rule matches at a given offset
+    const QRect affected = rbr | ruleOutput.boundingRect();
 
-    const int maxX = where.right() - rbr.left() + rbr.width() - 1;
-    const int maxY = where.bottom() - rbr.top() + rbr.height() - 1;
+    // Only the matches that depend on the cells in the given region need to
+    // be evaluated again
+    const QRegion offsets = matchOffsets(ruleIndex, where);
+    const QRect offsetBounds = offsets.boundingRect();
 
-    // In this list of regions it is stored which parts or the map have already
+    // In this list of masks it is stored which parts or the map have already
     // been altered by exactly this rule. We store all the altered parts to
     // make sure there are no overlaps of the same rule applied to
     // (neighbouring) places
-    QVector<QRegion> appliedRegions;
-    if (mNoOverlappingRules)
-        appliedRegions.resize(mMapWork->layerCount());
-
-    for (int y = minY; y <= maxY; ++y)
-    for (int x = minX; x <= maxX; ++x) {
-        bool anymatch = false;
-        foreach (const QString &index, mInputRules.indexes) {
-            const InputIndex &ii = mInputRules[index];
-
-            bool allLayerNamesMatch = true;
-            foreach (const QString &name, ii.names) {
-                const int i = mMapWork->indexOfLayer(name, Layer::TileLayerType);
-                if (i == -1) {
-                    allLayerNamesMatch = false;
-                } else {
-                    const TileLayer *setLayer = mMapWork->layerAt(i)->asTileLayer();
-                    allLayerNamesMatch &= compareLayerTo(setLayer,
-                                                         ii[name].listYes,
-                                                         ii[name].listNo,
-                                                         ruleInput,
-                                                         QPoint(x, y));
-                }
-            }
-            if (allLayerNamesMatch) {
-                anymatch = true;
-                break;
-            }
-        }
+    QVector<TileMask> appliedMasks;
 
-        if (anymatch) {
-            int r = 0;
-            // choose by chance which group of rule_layers should be used:
-            if (mLayerList.size() > 1)
-                r = qrand() % mLayerList.size();
+    // The parts of the rule output that are written to each layer, for
+    // each translation table. These only depend on the rules map.
+    QVector<QVector<QRegion>> outputInLayers;
 
-            if (!mNoOverlappingRules) {
-                copyMapRegion(ruleOutput, QPoint(x, y), mLayerList.at(r));
-                ret = ret.united(rbr.translated(QPoint(x, y)));
-                continue;
-            }
+    if (mNoOverlappingRules) {
+        appliedMasks.resize(mMapWork->layerCount());
+        outputInLayers.reserve(mLayerList.size());
 
-            bool missmatch = false;
-            RuleOutput *translationTable = mLayerList.at(r);
-            QList<Layer*> layers = translationTable->keys();
-
-            // check if there are no overlaps within this rule.
-            QVector<QRegion> ruleRegionInLayer;
-            for (int i = 0; i < layers.size(); ++i) {
-                Layer *layer = layers.at(i);
+        for (const RuleOutput *translationTable : mLayerList) {
+            QVector<QRegion> outputInLayer;
 
+            foreach (Layer *layer, translationTable->keys()) {
                 QRegion appliedPlace;
                 TileLayer *tileLayer = layer->asTileLayer();
                 if (tileLayer)
@@ -584,26 +693,107 @@ QRect AutoMapper::applyRule(const int ruleIndex, const QRect &where)
                 else
                     appliedPlace = tileRegionOfObjectGroup(layer->asObjectGroup());
 
-                ruleRegionInLayer.append(appliedPlace.intersected(ruleOutput));
-                if (appliedRegions.at(i).intersects(
-                            ruleRegionInLayer[i].translated(x, y))) {
-                    missmatch = true;
-                    break;
-                }
+                outputInLayer.append(appliedPlace.intersected(ruleOutput));
             }
-            if (missmatch)
-                continue;
 
-            copyMapRegion(ruleOutput, QPoint(x, y), mLayerList.at(r));
-            ret = ret.united(rbr.translated(QPoint(x, y)));
-            for (int i = 0; i < translationTable->size(); ++i) {
-                appliedRegions[i] +=
-                        ruleRegionInLayer[i].translated(x, y);
-            }
+            outputInLayers.append(outputInLayer);
         }
     }
 
-    return ret;
+    // Search for the matches on multiple threads when the rule is applied
+    // to a large enough area. Since the rules don't write to their input
+    // in this case, the matches don't depend on the ones applied before.
+    //
+    // When each input group of the rule has an anchor, only the positions
+    // where the anchor cells occur need to be considered.
+    const bool indexed = mStaticInput && !mRuleAnchors.at(ruleIndex).isEmpty();
+    const int threadCount = QThread::idealThreadCount();
+    const qint64 positions = positionCount(offsets);
+    const bool parallel = mStaticInput && !indexed && threadCount > 1 &&
+            positions >= MinParallelPositions;
+
+    QVector<QVector<QPoint>> bandMatches;
+    if (parallel) {
+        const int rowCount = offsetBounds.height();
+        const int bandCount = qMin(threadCount * 4, rowCount);
+        const int bandHeight = (rowCount + bandCount - 1) / bandCount;
+
+        bandMatches.resize((rowCount + bandHeight - 1) / bandHeight);
+
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(threadCount);
+
+        for (int i = 0; i < bandMatches.size(); ++i) {
+            const QRect band(offsetBounds.left(),
+                             offsetBounds.top() + i * bandHeight,
+                             offsetBounds.width(),
+                             bandHeight);
+            threadPool.start(new RuleMatcher(compiledRule, mInputLayers,
+                                             offsets.intersected(band),
+                                             bandMatches[i]));
+        }
+
+        threadPool.waitForDone();
+    }
+
+    auto applyMatch = [&] (int x, int y) {
+        int r = 0;
+        // choose by chance which group of rule_layers should be used:
+        if (mLayerList.size() > 1)
+            r = mMapDocument->randomGenerator().bounded(mLayerList.size());
+
+        if (!mNoOverlappingRules) {
+            stats.cellsWritten += copyMapRegion(ruleOutput, QPoint(x, y),
+                                                mLayerList.at(r));
+            ++stats.matches;
+            changed.addRect(affected.translated(x, y));
+            return;
+        }
+
+        const QVector<QRegion> &outputInLayer = outputInLayers.at(r);
+
+        // check if there are no overlaps within this rule.
+        for (int i = 0; i < outputInLayer.size(); ++i) {
+            foreach (const QRect &rect, outputInLayer.at(i).rects())
+                if (appliedMasks.at(i).intersects(rect.translated(x, y)))
+                    return;
+        }
+
+        stats.cellsWritten += copyMapRegion(ruleOutput, QPoint(x, y),
+                                            mLayerList.at(r));
+        ++stats.matches;
+        changed.addRect(affected.translated(x, y));
+        for (int i = 0; i < outputInLayer.size(); ++i) {
+            foreach (const QRect &rect, outputInLayer.at(i).rects())
+                appliedMasks[i].addRect(rect.translated(x, y));
+        }
+    };
+
+    if (indexed) {
+        const QVector<QPoint> candidates = candidatePositions(ruleIndex, offsets);
+        stats.positionsTested += candidates.size();
+
+        for (const QPoint &offset : candidates)
+            if (matchesRule(compiledRule, mInputLayers, offset))
+                applyMatch(offset.x(), offset.y());
+    } else if (parallel) {
+        stats.positionsTested += positions;
+
+        // The matches of each band are in row order, so applying them band
+        // by band gives the same result as matching sequentially
+        for (const QVector<QPoint> &matches : bandMatches)
+            for (const QPoint &match : matches)
+                applyMatch(match.x(), match.y());
+    } else {
+        stats.positionsTested += positions;
+
+        forEachPosition(offsets, [&] (int x, int y) {
+            if (matchesRule(compiledRule, mInputLayers, QPoint(x, y)))
+                applyMatch(x, y);
+        });
+    }
+
+    stats.nanoseconds += timer.nsecsElapsed();
 }
 
 /**
@@ -631,158 +821,394 @@ static QVector<Cell> cellsInRegion(const QVector<TileLayer*> &list,
 /**
  * This function is one of the core functions for understanding the
  * automapping.
- * In this function a certain region (of the set layer) is compared to
- * several other layers (ruleSet and ruleNotSet).
- * This comparison will determine if a rule of automapping matches,
- * so if this rule is applied at this region given
- * by a QRegion and Offset given by a QPoint.
  *
- * This compares the tile layer setLayer to several others given
- * in the QList listYes (ruleSet) and OList listNo (ruleNotSet).
- * The tile layer setLayer is examined at QRegion ruleRegion + offset
- * The tile layers within listYes and listNo are examined at QRegion ruleRegion.
+ * The input of a rule is compared to the tile layers of the working map
+ * (the set layers). For each set layer, the rule region is compared to
+ * several other layers (ruleSet and ruleNotSet), the input and inputnot
+ * layers with the same name and index. The compiled conditions allow this
+ * comparison to be done without looking at the rules map again.
  *
- * Basically all matches between setLayer and a layer of listYes are considered
- * good, while all matches between setLayer and listNo are considered bad and
- * lead to canceling the comparison, returning false.
+ * The set layer is examined at the rule region + offset, while the layers
+ * of listYes (input) and listNo (inputnot) are examined at the rule region.
  *
- * The comparison is done for each position within the QRegion ruleRegion.
- * If all positions of the region are considered "good" return true.
+ * Basically all matches between the set layer and a layer of listYes are
+ * considered good, while all matches between the set layer and listNo are
+ * considered bad and lead to canceling the comparison.
+ *
+ * The comparison is done for each position within the rule region.
+ * If all positions of the region are considered "good" the layer matches.
  *
  * Now there are several cases to distinguish:
  *  - both listYes and listNo are empty:
  *      This should not happen, because with that configuration, absolutely
  *      no condition is given.
- *      return false, assuming this is an errornous rule being applied
+ *      Never matches, assuming this is an errornous rule being applied
  *
  *  - both listYes and listNo are not empty:
- *      When comparing a tile at a certain position of tile layer setLayer
+ *      When comparing a tile at a certain position of the set layer
  *      to all available tiles in listYes, there must be at least
- *      one layer, in which there is a match of tiles of setLayer and
+ *      one layer, in which there is a match of tiles of the set layer and
  *      listYes to consider this position good.
  *      In listNo there must not be a match to consider this position
  *      good.
  *      If there are no tiles within all available tiles within all layers
- *      of one list, all tiles in setLayer are considered good,
+ *      of one list, all tiles in the set layer are considered good,
  *      while inspecting this list.
- *      All available tiles are all tiles within the whole rule region in
- *      all tile layers of the list.
  *
  *  - either of both lists are not empty
- *      When comparing a certain position of tile layer setLayer
+ *      When comparing a certain position of the set layer
  *      to all Tiles at the corresponding position this can happen:
- *      A tile of setLayer matches a tile of a layer in the list. Then this
- *      is considered as good, if the layer is from the listYes.
+ *      A tile of the set layer matches a tile of a layer in the list. Then
+ *      this is considered as good, if the layer is from the listYes.
  *      Otherwise it is considered bad.
  *
  *      Exception, when having only the listYes:
  *      if at the examined position there are no tiles within all Layers
  *      of the listYes, all tiles except all used tiles within
  *      the layers of that list are considered good.
+ *      All used tiles are all tiles within the whole rule region in
+ *      all tile layers of the list.
  *
  *      This exception was added to have a better functionality
  *      (need of less layers.)
  *      It was not added to the case, when having only listNo layers to
  *      avoid total symmetry between those lists.
  *
- * If all positions are considered good, return true.
- * return false otherwise.
- *
- * @return bool, if the tile layer matches the given list of layers.
+ * When the rule region isn't fully covered by the layers of either list,
+ * the layer never matches.
  */
-static bool compareLayerTo(const TileLayer *setLayer,
-                           const QVector<TileLayer*> &listYes,
-                           const QVector<TileLayer*> &listNo,
-                           const QRegion &ruleRegion, const QPoint &offset)
+static InputLayerConditions compileConditions(const QVector<TileLayer*> &listYes,
+                                              const QVector<TileLayer*> &listNo,
+                                              const QRegion &ruleRegion)
 {
-    if (listYes.isEmpty() && listNo.isEmpty())
-        return false;
+    InputLayerConditions conditions;
+    conditions.hasListYes = !listYes.isEmpty();
+    conditions.hasListNo = !listNo.isEmpty();
 
-    QVector<Cell> cells;
-    if (listYes.isEmpty())
-        cells = cellsInRegion(listNo, ruleRegion);
-    if (listNo.isEmpty())
-        cells = cellsInRegion(listYes, ruleRegion);
+    if (!conditions.hasListYes && !conditions.hasListNo) {
+        conditions.matchesNever = true;
+        return conditions;
+    }
+
+    // Needed for the exception when there are only layers in the listYes
+    if (!conditions.hasListNo)
+        conditions.usedCells = cellsInRegion(listYes, ruleRegion);
 
     foreach (const QRect &rect, ruleRegion.rects()) {
-        for (int x = rect.left(); x <= rect.right(); ++x) {
-            for (int y = rect.top(); y <= rect.bottom(); ++y) {
-                // this is only used in the case where only one list has layers
-                // it is needed for the exception mentioned above
-                bool ruleDefinedListYes = false;
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                InputCellCondition cell;
+                cell.pos = QPoint(x, y);
+
+                for (const TileLayer *tileLayer : listYes) {
+                    if (!tileLayer->contains(x, y)) {
+                        conditions.matchesNever = true;
+                        return conditions;
+                    }
+
+                    const Cell &c = tileLayer->cellAt(x, y);
+                    if (!c.isEmpty() && !cell.allowed.contains(c))
+                        cell.allowed.append(c);
+                }
 
-                bool matchListYes = false;
-                bool matchListNo  = false;
+                for (const TileLayer *tileLayer : listNo) {
+                    if (!tileLayer->contains(x, y)) {
+                        conditions.matchesNever = true;
+                        return conditions;
+                    }
 
-                if (!setLayer->contains(x + offset.x(), y + offset.y()))
-                    return false;
+                    const Cell &c = tileLayer->cellAt(x, y);
+                    if (!c.isEmpty() && !cell.forbidden.contains(c))
+                        cell.forbidden.append(c);
+                }
+
+                conditions.cells.append(cell);
+            }
+        }
+    }
 
-                const Cell &c1 = setLayer->cellAt(x + offset.x(),
-                                                  y + offset.y());
+    return conditions;
+}
 
-                // ruleDefined will be set when there is a tile in at least
-                // one layer. if there is a tile in at least one layer, only
-                // the given tiles in the different listYes layers are valid.
-                // if there is given no tile at all in the listYes layers,
-                // consider all tiles valid.
+static CellKey cellKey(const Cell &cell)
+{
+    return CellKey(cell.tile, (cell.flippedHorizontally ? 1 : 0) |
+                              (cell.flippedVertically ? 2 : 0) |
+                              (cell.flippedAntiDiagonally ? 4 : 0));
+}
 
-                foreach (const TileLayer *comparedTileLayer, listYes) {
+/**
+ * Finds an anchor for each input group of the given \a rule. A group that
+ * can never match gets an anchor without cells.
+ *
+ * Any cell condition that allows only specific cells can serve as an
+ * anchor. The one allowing the fewest cells is chosen, since it is likely
+ * to occur least often.
+ *
+ * Returns an empty list when any group lacks an anchor, for example when it
+ * only has inputnot layers.
+ */
+static QVector<RuleAnchor> findAnchors(const CompiledRule &rule)
+{
+    QVector<RuleAnchor> anchors;
+
+    for (const QVector<InputLayerConditions> &group : rule) {
+        RuleAnchor anchor;
+        anchor.layer = -1;
+        bool matchesNever = false;
+
+        for (const InputLayerConditions &conditions : group) {
+            if (conditions.matchesNever) {
+                matchesNever = true;
+                anchor.layer = conditions.layer;
+                anchor.cells.clear();
+                break;
+            }
 
-                    if (!comparedTileLayer->contains(x, y))
-                        return false;
+            if (!conditions.hasListYes)
+                continue;
 
-                    const Cell &c2 = comparedTileLayer->cellAt(x, y);
-                    if (!c2.isEmpty())
-                        ruleDefinedListYes = true;
+            for (const InputCellCondition &cell : conditions.cells) {
+                if (cell.allowed.isEmpty())
+                    continue;
 
-                    if (!c2.isEmpty() && c1 == c2)
-                        matchListYes = true;
+                if (anchor.layer == -1 || cell.allowed.size() < anchor.cells.size()) {
+                    anchor.layer = conditions.layer;
+                    anchor.pos = cell.pos;
+                    anchor.cells = cell.allowed;
                 }
-                foreach (const TileLayer *comparedTileLayer, listNo) {
+            }
+        }
 
-                    if (!comparedTileLayer->contains(x, y))
-                        return false;
+        if (anchor.layer == -1 && !matchesNever)
+            return QVector<RuleAnchor>();
 
-                    const Cell &c2 = comparedTileLayer->cellAt(x, y);
+        anchors.append(anchor);
+    }
 
-                    if (!c2.isEmpty() && c1 == c2)
-                        matchListNo = true;
-                }
+    return anchors;
+}
 
-                // when there are only layers in the listNo
-                // check only if these layers are unmatched
-                // no need to check explicitly the exception in this case.
-                if (listYes.isEmpty()) {
-                    if (matchListNo)
-                        return false;
-                    else
-                        continue;
-                }
-                // when there are only layers in the listYes
-                // check if these layers are matched, or if the exception works
-                if (listNo.isEmpty()) {
-                    if (matchListYes)
-                        continue;
-                    if (!ruleDefinedListYes && !cells.contains(c1))
+void AutoMapper::compileRules()
+{
+    mInputLayerNames = mInputRules.names.toList();
+
+    mStaticInput = true;
+    for (const QString &name : mInputLayerNames)
+        if (mTouchedTileLayers.contains(name))
+            mStaticInput = false;
+    mCompiledRules.clear();
+    mCompiledRules.reserve(mRulesInput.size());
+    mRuleAnchors.clear();
+    mRuleAnchors.reserve(mRulesInput.size());
+    mRuleStats.resize(mRulesInput.size());
+
+    for (const QRegion &ruleInput : mRulesInput) {
+        CompiledRule rule;
+
+        foreach (const QString &index, mInputRules.indexes) {
+            const InputIndex &ii = mInputRules[index];
+            QVector<InputLayerConditions> group;
+
+            foreach (const QString &name, ii.names) {
+                InputLayerConditions conditions =
+                        compileConditions(ii[name].listYes,
+                                          ii[name].listNo,
+                                          ruleInput);
+                conditions.layer = mInputLayerNames.indexOf(name);
+                group.append(conditions);
+            }
+
+            rule.append(group);
+        }
+
+        mCompiledRules.append(rule);
+        mRuleAnchors.append(findAnchors(rule));
+    }
+}
+
+void AutoMapper::resolveInputLayers()
+{
+    mInputLayers.resize(mInputLayerNames.size());
+
+    for (int i = 0; i < mInputLayerNames.size(); ++i) {
+        Layer *layer = mMapWork->findLayer(mInputLayerNames.at(i),
+                                           Layer::TileLayerType);
+        const TileLayer *tileLayer = layer ? layer->asTileLayer() : nullptr;
+
+        // Make sure the cells won't be loaded while matching on other threads
+        if (tileLayer)
+            tileLayer->load();
+
+        mInputLayers[i] = tileLayer;
+    }
+}
+
+void AutoMapper::buildTileIndex(const QRegion &where)
+{
+    mTileIndex.clear();
+    mTileIndex.resize(mInputLayers.size());
+
+    // Collect the anchor cells for each layer, and determine how far from
+    // the automapped region the anchors of a match may be
+    QVector<QSet<CellKey>> anchorCells(mInputLayers.size());
+    int margin = 0;
+
+    for (int i = 0; i < mRuleAnchors.size(); ++i) {
+        const QVector<RuleAnchor> &anchors = mRuleAnchors.at(i);
+        if (anchors.isEmpty())
+            continue;
+
+        const QRect ruleBounds = mRulesInput.at(i).boundingRect();
+        margin = qMax(margin, 2 * qMax(ruleBounds.width(), ruleBounds.height()));
+
+        for (const RuleAnchor &anchor : anchors)
+            for (const Cell &cell : anchor.cells)
+                anchorCells[anchor.layer].insert(cellKey(cell));
+    }
+
+    QRegion area;
+    foreach (const QRect &rect, where.rects())
+        area += rect.adjusted(-margin, -margin, margin, margin);
+
+    for (int i = 0; i < mInputLayers.size(); ++i) {
+        const TileLayer *tileLayer = mInputLayers.at(i);
+        const QSet<CellKey> &cells = anchorCells.at(i);
+        if (!tileLayer || cells.isEmpty())
+            continue;
+
+        const QRect layerRect(0, 0, tileLayer->width(), tileLayer->height());
+        CellPositions &positions = mTileIndex[i];
+
+        foreach (const QRect &rect, area.intersected(layerRect).rects()) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                for (int x = rect.left(); x <= rect.right(); ++x) {
+                    const Cell &cell = tileLayer->cellAt(x, y);
+                    if (cell.isEmpty())
                         continue;
-                    return false;
+
+                    const CellKey key = cellKey(cell);
+                    if (cells.contains(key))
+                        positions[key].append(QPoint(x, y));
                 }
+            }
+        }
+    }
+}
 
-                // there are layers in both lists:
-                // no need to consider ruleDefinedListXXX
-                if ((matchListYes || !ruleDefinedListYes) && !matchListNo)
-                    continue;
-                else
-                    return false;
+static bool rowOrderLessThan(const QPoint &a, const QPoint &b)
+{
+    return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+}
+
+QVector<QPoint> AutoMapper::candidatePositions(int ruleIndex,
+                                               const QRegion &offsets) const
+{
+    const QRect area = offsets.boundingRect();
+
+    QVector<QPoint> candidates;
+
+    for (const RuleAnchor &anchor : mRuleAnchors.at(ruleIndex)) {
+        const CellPositions &positions = mTileIndex.at(anchor.layer);
+
+        for (const Cell &cell : anchor.cells) {
+            const auto it = positions.find(cellKey(cell));
+            if (it == positions.end())
+                continue;
+
+            for (const QPoint &pos : it.value()) {
+                const QPoint offset = pos - anchor.pos;
+                if (area.contains(offset) && offsets.contains(offset))
+                    candidates.append(offset);
             }
         }
     }
-    return true;
+
+    // Matches are applied in row order. Different anchors of a rule may
+    // lead to the same position.
+    std::sort(candidates.begin(), candidates.end(), rowOrderLessThan);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+
+    return candidates;
 }
 
-void AutoMapper::copyMapRegion(const QRegion &region, QPoint offset,
-                               const RuleOutput *layerTranslation)
+/**
+ * Returns whether the cell \a c1 of a set layer meets the given condition.
+ * See compileConditions() for the meaning of the different cases.
+ */
+static bool cellMatches(const InputLayerConditions &conditions,
+                        const InputCellCondition &cell,
+                        const Cell &c1)
+{
+    const bool matchListNo = cell.forbidden.contains(c1);
+
+    // when there are only layers in the listNo
+    // check only if these layers are unmatched
+    if (!conditions.hasListYes)
+        return !matchListNo;
+
+    const bool ruleDefinedListYes = !cell.allowed.isEmpty();
+    const bool matchListYes = ruleDefinedListYes && cell.allowed.contains(c1);
+
+    // when there are only layers in the listYes
+    // check if these layers are matched, or if the exception works
+    if (!conditions.hasListNo)
+        return matchListYes ||
+                (!ruleDefinedListYes && !conditions.usedCells.contains(c1));
+
+    // there are layers in both lists
+    return (matchListYes || !ruleDefinedListYes) && !matchListNo;
+}
+
+/**
+ * Returns whether the given compiled \a rule matches at the given
+ * \a offset, comparing against the resolved \a inputLayers.
+ *
+ * This function only reads from the layers and may be called from multiple
+ * threads at once.
+ */
+static bool matchesRule(const CompiledRule &rule,
+                        const QVector<const TileLayer*> &inputLayers,
+                        const QPoint &offset)
 {
+    for (const QVector<InputLayerConditions> &group : rule) {
+        bool allLayersMatch = true;
+
+        for (const InputLayerConditions &conditions : group) {
+            const TileLayer *setLayer = inputLayers.at(conditions.layer);
+            if (!setLayer || conditions.matchesNever) {
+                allLayersMatch = false;
+                break;
+            }
+
+            for (const InputCellCondition &cell : conditions.cells) {
+                const int x = cell.pos.x() + offset.x();
+                const int y = cell.pos.y() + offset.y();
+
+                if (!setLayer->contains(x, y) ||
+                        !cellMatches(conditions, cell, setLayer->cellAt(x, y))) {
+                    allLayersMatch = false;
+                    break;
+                }
+            }
+
+            if (!allLayersMatch)
+                break;
+        }
+
+        if (allLayersMatch)
+            return true;
+    }
+
+    return false;
+}
+
+int AutoMapper::copyMapRegion(const QRegion &region, QPoint offset,
+                              const RuleOutput *layerTranslation)
+{
+    int cellsWritten = 0;
+
     for (int i = 0; i < layerTranslation->keys().size(); ++i) {
         Layer *from = layerTranslation->keys().at(i);
         Layer *to = mMapWork->layerAt(layerTranslation->value(from));
@@ -792,10 +1218,11 @@ void AutoMapper::copyMapRegion(const QRegion &region, QPoint offset,
             if (fromTileLayer) {
                 TileLayer *toTileLayer = to->asTileLayer();
                 Q_ASSERT(toTileLayer); //TODO check this before in prepareAutomap or such!
-                copyTileRegion(fromTileLayer, rect.x(), rect.y(),
-                               rect.width(), rect.height(),
-                               toTileLayer,
-                               rect.x() + offset.x(), rect.y() + offset.y());
+                cellsWritten += copyTileRegion(fromTileLayer, rect.x(), rect.y(),
+                                               rect.width(), rect.height(),
+                                               toTileLayer,
+                                               rect.x() + offset.x(),
+                                               rect.y() + offset.y());
 
             } else if (fromObjectGroup) {
                 ObjectGroup *toObjectGroup = to->asObjectGroup();
@@ -808,51 +1235,37 @@ void AutoMapper::copyMapRegion(const QRegion &region, QPoint offset,
             }
         }
     }
+
+    return cellsWritten;
 }
 
-void AutoMapper::copyTileRegion(TileLayer *srcLayer, int srcX, int srcY,
-                                int width, int height,
-                                TileLayer *dstLayer, int dstX, int dstY)
+int AutoMapper::copyTileRegion(TileLayer *srcLayer, int srcX, int srcY,
+                               int width, int height,
+                               TileLayer *dstLayer, int dstX, int dstY)
 {
-    const int startX = qMax(dstX, 0);
-    const int startY = qMax(dstY, 0);
-
-    const int endX = qMin(dstX + width, dstLayer->width());
-    const int endY = qMin(dstY + height, dstLayer->height());
-
-    const int offsetX = srcX - dstX;
-    const int offsetY = srcY - dstY;
-
-    for (int x = startX; x < endX; ++x) {
-        for (int y = startY; y < endY; ++y) {
-            const Cell &cell = srcLayer->cellAt(x + offsetX, y + offsetY);
-            if (!cell.isEmpty()) {
-                // this is without graphics update, it's done afterwards for all
-                dstLayer->setCell(x, y, cell);
-            }
-        }
-    }
+    // this is without graphics update, it's done afterwards for all
+    return dstLayer->mergeCells(QPoint(dstX, dstY), srcLayer,
+                                QRect(srcX, srcY, width, height));
 }
 
 void AutoMapper::copyObjectRegion(ObjectGroup *srcLayer, int srcX, int srcY,
                                  int width, int height,
                                  ObjectGroup *dstLayer, int dstX, int dstY)
 {
-    QUndoStack *undo = mMapDocument->undoStack();
     const QRectF rect = QRectF(srcX, srcY, width, height);
-    const QRectF pixelRect = mMapDocument->renderer()->tileToPixelCoords(rect);
+    const QRectF pixelRect = renderer()->tileToPixelCoords(rect);
     QList<MapObject*> objects = objectsInRegion(srcLayer, pixelRect.toAlignedRect());
 
-    QPointF pixelOffset = mMapDocument->renderer()->tileToPixelCoords(dstX, dstY);
+    QPointF pixelOffset = renderer()->tileToPixelCoords(dstX, dstY);
     pixelOffset -= pixelRect.topLeft();
 
-    QList<MapObject*> clones;
+    mPendingObjects.reserve(mPendingObjects.size() + objects.size());
+
     foreach (MapObject *obj, objects) {
         MapObject *clone = obj->clone();
-        clones.append(clone);
         clone->setX(clone->x() + pixelOffset.x());
         clone->setY(clone->y() + pixelOffset.y());
-        undo->push(new AddMapObject(mMapDocument, dstLayer, clone));
+        mPendingObjects.append(PendingObject(dstLayer, clone));
     }
 }
 
@@ -872,8 +1285,7 @@ void AutoMapper::cleanTilesets()
         if (index == -1)
             continue;
 
-        QUndoStack *undo = mMapDocument->undoStack();
-        undo->push(new RemoveTileset(mMapDocument, index));
+        removeTileset(index);
     }
     mAddedTilesets.clear();
 }
@@ -890,12 +1302,111 @@ void AutoMapper::cleanTileLayers()
         if (!layer->isEmpty())
             continue;
 
-        QUndoStack *undo = mMapDocument->undoStack();
-        undo->push(new RemoveLayer(mMapDocument, layerIndex));
+        removeLayer(layerIndex);
     }
     mAddedTileLayers.clear();
 }
 
+void AutoMapper::addLayer(int index, Layer *layer)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new AddLayer(mMapDocument, index, layer));
+    else
+        mMapWork->insertLayer(index, layer);
+}
+
+void AutoMapper::removeLayer(int index)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new RemoveLayer(mMapDocument, index));
+    else
+        delete mMapWork->takeLayerAt(index);
+}
+
+void AutoMapper::addTileset(const SharedTileset &tileset)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new AddTileset(mMapDocument, tileset));
+    else
+        mMapWork->addTileset(tileset);
+}
+
+void AutoMapper::removeTileset(int index)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new RemoveTileset(mMapDocument, index));
+    else
+        mMapWork->removeTilesetAt(index);
+}
+
+void AutoMapper::setTileProperties(Tile *tile, const Properties &properties)
+{
+    if (mMapDocument)
+        mMapDocument->undoStack()->push(new ChangeProperties(mMapDocument,
+                                                             tr("Tile"),
+                                                             tile,
+                                                             properties));
+    else
+        tile->setProperties(properties);
+}
+
+/**
+ * Adds the objects copied by copyObjectRegion() to the working map, using
+ * a single undo command.
+ */
+void AutoMapper::addPendingObjects()
+{
+    if (mPendingObjects.isEmpty())
+        return;
+
+    if (mMapDocument) {
+        QVector<MapObjectModel::ObjectEntry> entries;
+        entries.reserve(mPendingObjects.size());
+        for (const PendingObject &pending : mPendingObjects)
+            entries.append(MapObjectModel::ObjectEntry(pending.second, pending.first));
+
+        mMapDocument->undoStack()->push(new AddMapObjects(mMapDocument, entries));
+    } else {
+        for (const PendingObject &pending : mPendingObjects)
+            pending.first->addObject(pending.second);
+    }
+
+    mPendingObjects.clear();
+}
+
+void AutoMapper::eraseObjects(ObjectGroup *objectGroup, const QRegion &where)
+{
+    if (mMapDocument)
+        eraseRegionObjectGroup(mMapDocument, objectGroup, where);
+    else
+        eraseRegionObjectGroup(renderer(), objectGroup, where);
+}
+
+const MapRenderer *AutoMapper::renderer()
+{
+    if (mMapDocument)
+        return mMapDocument->renderer();
+
+    if (!mRenderer) {
+        switch (mMapWork->orientation()) {
+        case Map::Isometric:
+            mRenderer.reset(new IsometricRenderer(mMapWork));
+            break;
+        case Map::Staggered:
+            mRenderer.reset(new StaggeredRenderer(mMapWork));
+            break;
+        case Map::Hexagonal:
+            mRenderer.reset(new HexagonalRenderer(mMapWork));
+            break;
+        default:
+            mRenderer.reset(new OrthogonalRenderer(mMapWork));
+            break;
+        }
+    }
+
+    return mRenderer.data();
+}
+
 void AutoMapper::cleanUpRulesMap()
 {
     cleanTilesets();
@@ -913,6 +1424,12 @@ void AutoMapper::cleanUpRulesMap()
     cleanUpRuleMapLayers();
     mRulesInput.clear();
     mRulesOutput.clear();
+    mCompiledRules.clear();
+    mRuleAnchors.clear();
+    mRuleStats.clear();
+    mInputLayerNames.clear();
+    mInputLayers.clear();
+    mTileIndex.clear();
 }
 
 void AutoMapper::cleanUpRuleMapLayers()
@@ -21,13 +21,18 @@
 #ifndef AUTOMAPPER_H
 #define AUTOMAPPER_H
 
+#include "tilelayer.h"
 #include "tileset.h"
 
+#include <QHash>
 #include <QList>
+#include <QPair>
 #include <QMap>
 #include <QRegion>
+#include <QScopedPointer>
 #include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 
 namespace Tiled {
@@ -35,8 +40,10 @@ namespace Tiled {
 class Layer;
 class Map;
 class MapObject;
+class MapRenderer;
 class ObjectGroup;
 class TileLayer;
+class TileMask;
 
 namespace Internal {
 
@@ -68,6 +75,98 @@ public:
     QString index;
 };
 
+/**
+ * The condition a rule places on a single cell of an input layer, as
+ * defined by the input and inputnot layers at that position of the rule.
+ */
+class InputCellCondition
+{
+public:
+    QPoint pos;
+    QVector<Cell> allowed;      // non-empty cells of the input layers
+    QVector<Cell> forbidden;    // non-empty cells of the inputnot layers
+};
+
+/**
+ * The conditions a rule places on one of the tile layers of the working
+ * map, compiled from the input and inputnot layers with the same name and
+ * index.
+ */
+class InputLayerConditions
+{
+public:
+    InputLayerConditions()
+        : layer(-1)
+        , hasListYes(false)
+        , hasListNo(false)
+        , matchesNever(false)
+    {}
+
+    int layer;              // index into AutoMapper::mInputLayerNames
+    bool hasListYes;
+    bool hasListNo;
+    bool matchesNever;      // an input layer doesn't cover the rule
+    QVector<Cell> usedCells;
+    QVector<InputCellCondition> cells;
+};
+
+/**
+ * The compiled input of a rule. A rule matches when all conditions of any
+ * of its groups are met, each group corresponding to an input index.
+ */
+typedef QVector<QVector<InputLayerConditions>> CompiledRule;
+
+/**
+ * A cell of the rule input that requires one of the given cells to be
+ * present in the input layer. Only the positions at which these cells occur
+ * need to be considered when looking for matches.
+ */
+class RuleAnchor
+{
+public:
+    int layer;              // index into AutoMapper::mInputLayerNames
+    QPoint pos;
+    QVector<Cell> cells;
+};
+
+/**
+ * Statistics about applying a rule, collected for finding slow rules.
+ */
+class RuleStats
+{
+public:
+    RuleStats()
+        : positionsTested(0)
+        , matches(0)
+        , cellsWritten(0)
+        , nanoseconds(0)
+    {}
+
+    RuleStats &operator+=(const RuleStats &other)
+    {
+        positionsTested += other.positionsTested;
+        matches += other.matches;
+        cellsWritten += other.cellsWritten;
+        nanoseconds += other.nanoseconds;
+        return *this;
+    }
+
+    qint64 positionsTested;
+    qint64 matches;
+    qint64 cellsWritten;
+    qint64 nanoseconds;
+};
+
+/**
+ * Identifies a cell by its tile and flags.
+ */
+typedef QPair<Tile*, int> CellKey;
+
+/**
+ * Maps cells to the positions at which they occur in a layer.
+ */
+typedef QHash<CellKey, QVector<QPoint>> CellPositions;
+
 
 /**
  * This class does all the work for the automapping feature.
@@ -93,6 +192,18 @@ public:
      */
     AutoMapper(MapDocument *workingDocument, Map *rules, 
                const QString &rulePath);
+
+    /**
+     * Constructs an AutoMapper that works on a map which isn't open in the
+     * editor. The changes are applied directly, rather than through the
+     * undo stack.
+     *
+     * @param workingMap: the map to work on.
+     * @param rules: The rule map which should be used for automapping
+     * @param rulePath: The filepath to the rule map.
+     */
+    AutoMapper(Map *workingMap, Map *rules, const QString &rulePath);
+
     ~AutoMapper();
 
     /**
@@ -140,6 +251,18 @@ public:
      */
     QString warningString() const { return mWarning; }
 
+    /**
+     * Returns the path of the rule map used by this AutoMapper.
+     */
+    QString rulePath() const { return mRulePath; }
+
+    /**
+     * The statistics of each rule, by rule index, accumulated since they
+     * were last reset.
+     */
+    const QVector<RuleStats> &ruleStats() const { return mRuleStats; }
+    void resetRuleStats() { mRuleStats.fill(RuleStats()); }
+
 private:
     /**
      * Reads the map properties of the rulesmap.
@@ -155,6 +278,41 @@ private:
      */
     bool setupRuleList();
 
+    /**
+     * Compiles the input of each rule into a list of conditions per cell,
+     * which is what is used to match the rules. Needs to be called again
+     * when the cells of the rules map changed.
+     */
+    void compileRules();
+
+    /**
+     * Resolves the tile layers of the working map that are compared against
+     * the input of the rules.
+     */
+    void resolveInputLayers();
+
+    /**
+     * Indexes the positions of the anchor cells in the input layers, for the
+     * area relevant when automapping the given region.
+     */
+    void buildTileIndex(const QRegion &where);
+
+    /**
+     * Returns the positions at which the given rule could match, based on
+     * the positions of its anchor cells, sorted by row. Only positions within
+     * \a offsets are returned.
+     */
+    QVector<QPoint> candidatePositions(int ruleIndex,
+                                       const QRegion &offsets) const;
+
+    /**
+     * Returns the offsets at which a match of the given rule depends on any
+     * of the cells in \a where. These are the offsets at which the input
+     * region of the rule covers any of those cells, so only the matches at
+     * these offsets can have changed when the cells in \a where changed.
+     */
+    QRegion matchOffsets(int ruleIndex, const QRegion &where) const;
+
     /**
      * Sets up the layers in the rules map, which are used for automapping.
      * The layers are detected and put in the internal data structures
@@ -198,10 +356,11 @@ private:
      * if there is no tile in src TileLayer, there will nothing be copied,
      * so the maybe existing tile in dst will not be overwritten.
      *
+     * Returns the number of cells that were written.
      */
-    void copyTileRegion(TileLayer *src_lr, int src_x, int src_y,
-                        int width, int height, TileLayer *dst_lr,
-                        int dst_x, int dst_y);
+    int copyTileRegion(TileLayer *src_lr, int src_x, int src_y,
+                       int width, int height, TileLayer *dst_lr,
+                       int dst_x, int dst_y);
 
     /**
      * This copies all objects from the \a src_lr ObjectGroup to the \a dst_lr
@@ -210,6 +369,9 @@ private:
      * The rectangle is described by the upper left corner \a src_x \a src_y
      * and its \a width and \a height. The parameter \a dst_x and \a dst_y
      * offset the copied objects in the destination object group.
+     *
+     * The copies are only added to the destination object group by
+     * addPendingObjects(), so that they can be added in one go.
      */
     void copyObjectRegion(ObjectGroup *src_lr, int src_x, int src_y,
                           int width, int height, ObjectGroup *dst_lr,
@@ -222,19 +384,27 @@ private:
      * In the destination it will come to the region translated by Offset.
      * The parameter \a LayerTranslation is a map of which layers of the rulesmap
      * should get copied into which layers of the working map.
+     *
+     * Returns the number of tile layer cells that were written.
      */
-    void copyMapRegion(const QRegion &region, QPoint Offset,
-                       const RuleOutput *LayerTranslation);
+    int copyMapRegion(const QRegion &region, QPoint Offset,
+                      const RuleOutput *LayerTranslation);
 
     /**
-     * This goes through all the positions of the mMapWork and checks if
-     * there fits the rule given by the region in mMapRuleSet.
+     * This goes through the positions of the mMapWork at which the input of
+     * the rule overlaps \a where, and checks if the rule given by the region
+     * in mMapRuleSet fits there.
      * if there is a match all Layers are copied to mMapWork.
+     *
+     * When possible, the matches are searched for on multiple threads, each
+     * handling a band of rows. The matches are still applied in order.
      * @param ruleIndex: the region which should be compared to all positions
      *              of mMapWork will be looked up in mRulesInput and mRulesOutput
-     * @return where: an rectangle where the rule actually got applied
+     * @param changed: the area where the rule actually got applied is added
+     *              to this mask
      */
-    QRect applyRule(const int ruleIndex, const QRect &where);
+    void applyRule(const int ruleIndex, const QRegion &where,
+                   TileMask &changed);
 
     /**
      * Cleans up the data structures filled by setupRuleMapLayers(),
@@ -255,7 +425,25 @@ private:
     void cleanTileLayers();
 
     /**
-     * where to work in
+     * The changes to the working map go through these functions, which use
+     * the undo stack when working on a map document.
+     */
+    void addLayer(int index, Layer *layer);
+    void removeLayer(int index);
+    void addTileset(const SharedTileset &tileset);
+    void removeTileset(int index);
+    void setTileProperties(Tile *tile, const Properties &properties);
+    void addPendingObjects();
+    void eraseObjects(ObjectGroup *objectGroup, const QRegion &where);
+
+    /**
+     * Returns the renderer of the working map, used for converting between
+     * tile and pixel coordinates.
+     */
+    const MapRenderer *renderer();
+
+    /**
+     * where to work in, or nullptr when working on a plain map
      */
     MapDocument *mMapDocument;
 
@@ -264,6 +452,11 @@ private:
      */
     Map *mMapWork;
 
+    /**
+     * The renderer of mMapWork when there is no map document.
+     */
+    QScopedPointer<MapRenderer> mRenderer;
+
     /**
      * map containing the rules, usually different than mMapWork
      */
@@ -313,6 +506,50 @@ private:
      */
     QVector<QRegion> mRulesOutput;
 
+    /**
+     * The compiled input of each rule, matching the indexes of mRulesInput.
+     */
+    QVector<CompiledRule> mCompiledRules;
+
+    /**
+     * The names of the tile layers in the working map that are compared
+     * against the input of the rules, and the layers resolved for the
+     * current automapping operation.
+     */
+    QStringList mInputLayerNames;
+    QVector<const TileLayer*> mInputLayers;
+
+    /**
+     * Whether the rules do not write to any of their input layers. In this
+     * case the matches of a rule don't depend on the matches applied before,
+     * so they can be searched for in parallel or by using mTileIndex.
+     */
+    bool mStaticInput;
+
+    /**
+     * The anchors of each rule, one for each input group. Empty for rules
+     * that have a group without an anchor.
+     */
+    QVector<QVector<RuleAnchor>> mRuleAnchors;
+
+    /**
+     * For each input layer, the positions at which the anchor cells occur
+     * within the area that is being automapped.
+     */
+    QVector<CellPositions> mTileIndex;
+
+    /**
+     * The objects copied while applying the rules, which are added to their
+     * object group at the end of autoMap().
+     */
+    typedef QPair<ObjectGroup*, MapObject*> PendingObject;
+    QVector<PendingObject> mPendingObjects;
+
+    /**
+     * The statistics of each rule, matching the indexes of mRulesInput.
+     */
+    QVector<RuleStats> mRuleStats;
+
     /**
      * The inner set with layers to indexes is needed for translating
      * tile layers from mMapRules to mMapWork.
@@ -25,6 +25,8 @@
 #include "tile.h"
 #include "tilelayer.h"
 
+#include <QScopedPointer>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -62,11 +64,24 @@ AutoMapperWrapper::AutoMapperWrapper(MapDocument *mapDocument,
         mLayersAfter << static_cast<TileLayer*>(map->layerAt(layerindex)->clone());
     }
     // reduce memory usage by saving only diffs
+    //
+    // The automappers only change the cells within the region they report,
+    // so only that region needs to be compared. This avoids comparing the
+    // whole layers when automapping while drawing.
     Q_ASSERT(mLayersAfter.size() == mLayersBefore.size());
     for (int i = 0; i < mLayersAfter.size(); ++i) {
         TileLayer *before = mLayersBefore.at(i);
         TileLayer *after = mLayersAfter.at(i);
-        QRect diffRegion = before->computeDiffRegion(after).boundingRect();
+
+        QRect diffRegion;
+        foreach (const QRect &rect, where->intersected(before->bounds()).rects()) {
+            const QRect area = rect.translated(-before->position());
+            QScopedPointer<TileLayer> beforeArea(before->copy(area));
+            QScopedPointer<TileLayer> afterArea(after->copy(area));
+
+            const QRegion diff = beforeArea->computeDiffRegion(afterArea.data());
+            diffRegion |= diff.boundingRect().translated(area.topLeft());
+        }
 
         TileLayer *before1 = before->copy(diffRegion);
         TileLayer *after1 = after->copy(diffRegion);
@@ -21,8 +21,10 @@
 #include "automappingmanager.h"
 
 #include "automapperwrapper.h"
+#include "filesystemwatcher.h"
 #include "map.h"
 #include "mapdocument.h"
+#include "pluginmanager.h"
 #include "tilelayer.h"
 #include "tilesetmanager.h"
 #include "tmxmapformat.h"
@@ -31,19 +33,32 @@
 #include <QFileInfo>
 #include <QTextStream>
 
+#include <algorithm>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
 AutomappingManager::AutomappingManager(QObject *parent)
     : QObject(parent)
     , mMapDocument(nullptr)
+    , mMap(nullptr)
     , mLoaded(false)
+    , mWatcher(new FileSystemWatcher(this))
 {
+    connect(mWatcher, SIGNAL(fileChanged(QString)),
+            this, SLOT(fileChanged(QString)));
+
+    PluginManager::addObject(&mLogger);
 }
 
 AutomappingManager::~AutomappingManager()
 {
+    PluginManager::removeObject(&mLogger);
+
     cleanUp();
+
+    foreach (const QString &filePath, mRuleMapCache.keys())
+        removeCachedRuleMap(filePath);
 }
 
 void AutomappingManager::autoMap()
@@ -110,6 +125,17 @@ void AutomappingManager::autoMapInternal(const QRegion &where,
         mError += automapper->errorString();
     }
 
+    // Report the statistics in the console when automapping the whole map,
+    // but not for every change while drawing
+    if (!automatic)
+        clearRuleStats();
+    collectRuleStats();
+    if (!automatic) {
+        const QString report = ruleStatsReport();
+        if (!report.isEmpty())
+            mLogger.log(LoggingInterface::INFO, report);
+    }
+
     if (!mWarning.isEmpty())
         emit warningsOccurred(automatic);
 
@@ -134,6 +160,18 @@ bool AutomappingManager::loadFile(const QString &filePath)
         return false;
     }
 
+    mRuleFiles.insert(filePath);
+    watchFile(filePath);
+
+    // Guard against rules files that end up including themselves
+    const QString canonicalPath = QFileInfo(filePath).canonicalFilePath();
+    if (mLoadingRulesFiles.contains(canonicalPath)) {
+        mError += tr("Rules file includes itself:\n%1").arg(filePath)
+                  + QLatin1Char('\n');
+        return false;
+    }
+    mLoadingRulesFiles.insert(canonicalPath);
+
     QTextStream in(&rulesFile);
     QString line = in.readLine();
 
@@ -153,13 +191,9 @@ bool AutomappingManager::loadFile(const QString &filePath)
             continue;
         }
         if (rulePath.endsWith(QLatin1String(".tmx"), Qt::CaseInsensitive)) {
-            TmxMapFormat tmxFormat;
-
-            Map *rules = tmxFormat.read(rulePath);
+            Map *rules = ruleMap(rulePath);
 
             if (!rules) {
-                mError += tr("Opening rules map failed:\n%1").arg(
-                        tmxFormat.errorString()) + QLatin1Char('\n');
                 ret = false;
                 continue;
             }
@@ -168,7 +202,10 @@ bool AutomappingManager::loadFile(const QString &filePath)
             tilesetManager->addReferences(rules->tilesets());
 
             AutoMapper *autoMapper;
-            autoMapper = new AutoMapper(mMapDocument, rules, rulePath);
+            if (mMapDocument)
+                autoMapper = new AutoMapper(mMapDocument, rules, rulePath);
+            else
+                autoMapper = new AutoMapper(mMap, rules, rulePath);
 
             mWarning += autoMapper->warningString();
             const QString error = autoMapper->errorString(); 
@@ -184,9 +221,78 @@ bool AutomappingManager::loadFile(const QString &filePath)
                 ret = false;
         }
     }
+
+    mLoadingRulesFiles.remove(canonicalPath);
     return ret;
 }
 
+Map *AutomappingManager::ruleMap(const QString &filePath)
+{
+    mRuleFiles.insert(filePath);
+    watchFile(filePath);
+
+    const QDateTime lastModified = QFileInfo(filePath).lastModified();
+
+    auto it = mRuleMapCache.find(filePath);
+    if (it != mRuleMapCache.end() && it.value().lastModified != lastModified) {
+        removeCachedRuleMap(filePath);
+        it = mRuleMapCache.end();
+    }
+
+    if (it == mRuleMapCache.end()) {
+        TmxMapFormat tmxFormat;
+        Map *map = tmxFormat.read(filePath);
+
+        if (!map) {
+            mError += tr("Opening rules map failed:\n%1").arg(
+                    tmxFormat.errorString()) + QLatin1Char('\n');
+            return nullptr;
+        }
+
+        TilesetManager::instance()->addReferences(map->tilesets());
+
+        const CachedRuleMap cached = { map, lastModified };
+        it = mRuleMapCache.insert(filePath, cached);
+    }
+
+    // The copy shares its tilesets and tile data with the cached map
+    return new Map(*it.value().map);
+}
+
+void AutomappingManager::removeCachedRuleMap(const QString &filePath)
+{
+    const CachedRuleMap cached = mRuleMapCache.take(filePath);
+    if (!cached.map)
+        return;
+
+    TilesetManager::instance()->removeReferences(cached.map->tilesets());
+    delete cached.map;
+}
+
+void AutomappingManager::watchFile(const QString &filePath)
+{
+    if (mWatchedFiles.contains(filePath))
+        return;
+
+    mWatchedFiles.insert(filePath);
+    mWatcher->addPath(filePath);
+}
+
+/**
+ * Drops the cached rule map for the changed file. When the file is used
+ * by the current map document, the rules are reloaded when they are used
+ * next. Only the changed rule maps are read again.
+ */
+void AutomappingManager::fileChanged(const QString &path)
+{
+    removeCachedRuleMap(path);
+
+    if (mRuleFiles.contains(path)) {
+        cleanUp();
+        mLoaded = false;
+    }
+}
+
 void AutomappingManager::setMapDocument(MapDocument *mapDocument)
 {
     cleanUp();
@@ -203,8 +309,89 @@ void AutomappingManager::setMapDocument(MapDocument *mapDocument)
     mLoaded = false;
 }
 
+bool AutomappingManager::autoMap(Map *map, const QString &mapFileName)
+{
+    setMapDocument(nullptr);
+
+    mError.clear();
+    mWarning.clear();
+    mMap = map;
+
+    const QString mapPath = QFileInfo(mapFileName).path();
+    const QString rulesFileName = mapPath + QLatin1String("/rules.txt");
+
+    if (loadFile(rulesFileName)) {
+        // Same order as in AutoMapperWrapper
+        QVector<AutoMapper*> autoMappers;
+        for (AutoMapper *autoMapper : mAutoMappers)
+            if (autoMapper->prepareAutoMap())
+                autoMappers.append(autoMapper);
+
+        QRegion where(0, 0, map->width(), map->height());
+        for (AutoMapper *autoMapper : autoMappers)
+            autoMapper->autoMap(&where);
+
+        for (AutoMapper *autoMapper : autoMappers)
+            autoMapper->cleanAll();
+
+        for (AutoMapper *autoMapper : mAutoMappers) {
+            mWarning += autoMapper->warningString();
+            mError += autoMapper->errorString();
+        }
+
+        collectRuleStats();
+    }
+
+    cleanUp();
+    mMap = nullptr;
+
+    return mError.isEmpty();
+}
+
+void AutomappingManager::collectRuleStats()
+{
+    for (AutoMapper *autoMapper : mAutoMappers) {
+        const QVector<RuleStats> &stats = autoMapper->ruleStats();
+        for (int i = 0; i < stats.size(); ++i)
+            mRuleStats[RuleKey(autoMapper->rulePath(), i)] += stats.at(i);
+
+        autoMapper->resetRuleStats();
+    }
+}
+
+QString AutomappingManager::ruleStatsReport() const
+{
+    if (mRuleStats.isEmpty())
+        return QString();
+
+    QVector<RuleKey> keys = mRuleStats.keys().toVector();
+    std::stable_sort(keys.begin(), keys.end(),
+                     [this] (const RuleKey &a, const RuleKey &b) {
+        return mRuleStats.value(a).nanoseconds > mRuleStats.value(b).nanoseconds;
+    });
+
+    QString report = tr("Automapping rule statistics, slowest first:");
+    report += QLatin1Char('\n');
+    report += tr("time (ms)\tpositions\tmatches\tcells\trule");
+    report += QLatin1Char('\n');
+
+    for (const RuleKey &key : keys) {
+        const RuleStats stats = mRuleStats.value(key);
+        report += QString(QLatin1String("%1\t%2\t%3\t%4\t%5 #%6\n"))
+                .arg(stats.nanoseconds / 1000000.0, 0, 'f', 2)
+                .arg(stats.positionsTested)
+                .arg(stats.matches)
+                .arg(stats.cellsWritten)
+                .arg(key.first)
+                .arg(key.second);
+    }
+
+    return report;
+}
+
 void AutomappingManager::cleanUp()
 {
     qDeleteAll(mAutoMappers);
     mAutoMappers.clear();
+    mRuleFiles.clear();
 }
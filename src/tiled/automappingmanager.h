@@ -21,23 +21,37 @@
 #ifndef AUTOMAPPINGMANAGER_H
 #define AUTOMAPPINGMANAGER_H
 
+#include "automapper.h"
+#include "logginginterface.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
 #include <QObject>
+#include <QPair>
 #include <QRegion>
+#include <QSet>
 #include <QString>
 #include <QVector>
 
 namespace Tiled {
 
 class Layer;
+class Map;
 
 namespace Internal {
 
-class AutoMapper;
+class FileSystemWatcher;
 class MapDocument;
 
 /**
  * This class is a superior class to the AutoMapper and AutoMapperWrapper class.
  * It uses these classes to do the whole automapping process.
+ *
+ * The rule maps are cached by file name, so that they don't need to be read
+ * again when switching between maps using the same rules. The rules files
+ * are watched for changes, which invalidates the cached rule maps and
+ * causes the rules to be reloaded when they are used next.
  */
 class AutomappingManager : public QObject
 {
@@ -53,10 +67,31 @@ public:
 
     void setMapDocument(MapDocument *mapDocument);
 
+    /**
+     * Applies the rules to the whole of the given \a map, which isn't open
+     * in the editor. The rules are looked up next to \a mapFileName, like
+     * for a map document. The changes are applied without undo.
+     *
+     * Any current map document is unset.
+     *
+     * @return whether the rules were applied without errors.
+     */
+    bool autoMap(Map *map, const QString &mapFileName);
+
     QString errorString() const { return mError; }
 
     QString warningString() const { return mWarning; }
 
+    /**
+     * Returns a report of the statistics of each rule, collected since they
+     * were last cleared, with the slowest rules first. The columns are
+     * separated by tabs, so that the report can be sorted by other columns.
+     *
+     * Returns an empty string when no rules were applied.
+     */
+    QString ruleStatsReport() const;
+    void clearRuleStats() { mRuleStats.clear(); }
+
 signals:
     /**
      * This signal is emitted after automapping was done and an error occurred.
@@ -76,6 +111,7 @@ public slots:
 
 private slots:
     void autoMap(const QRegion &where, Layer *touchedLayer);
+    void fileChanged(const QString &path);
 
 private:
     Q_DISABLE_COPY(AutomappingManager)
@@ -92,6 +128,23 @@ private:
      */
     bool loadFile(const QString &filePath);
 
+    /**
+     * Returns a copy of the rule map at \a filePath, reading it only when it
+     * isn't cached yet or when it changed since it was cached. Returns
+     * nullptr when reading the map failed.
+     */
+    Map *ruleMap(const QString &filePath);
+
+    void removeCachedRuleMap(const QString &filePath);
+
+    void watchFile(const QString &filePath);
+
+    /**
+     * Adds the statistics of the rules of each AutoMapper to the collected
+     * ones, and resets those of the AutoMappers.
+     */
+    void collectRuleStats();
+
     /**
      * Applies automapping to the Region \a where, considering only layer
      * \a touchedLayer has changed.
@@ -111,6 +164,12 @@ private:
      */
     MapDocument *mMapDocument;
 
+    /**
+     * The map being automapped by autoMap(Map*, QString), when there is no
+     * map document.
+     */
+    Map *mMap;
+
     /**
      * For each new file of rules a new AutoMapper is setup. In this vector we
      * can store all of the AutoMappers in order.
@@ -123,6 +182,43 @@ private:
      */
     bool mLoaded;
 
+    struct CachedRuleMap
+    {
+        Map *map;
+        QDateTime lastModified;
+    };
+
+    /**
+     * The rule maps that were read, by file name. These maps are never
+     * used directly, since the AutoMapper modifies its copy.
+     */
+    QHash<QString, CachedRuleMap> mRuleMapCache;
+
+    /**
+     * The rules files and rule maps used for the current map document.
+     */
+    QSet<QString> mRuleFiles;
+
+    /**
+     * The rules files that are currently being loaded, which may not be
+     * included again.
+     */
+    QSet<QString> mLoadingRulesFiles;
+
+    FileSystemWatcher *mWatcher;
+    QSet<QString> mWatchedFiles;
+
+    /**
+     * The statistics of each rule, by rule map path and rule index.
+     */
+    typedef QPair<QString, int> RuleKey;
+    QMap<RuleKey, RuleStats> mRuleStats;
+
+    /**
+     * Used for reporting the rule statistics in the console.
+     */
+    LoggingInterface mLogger;
+
     /**
      * Contains all errors which occurred until canceling.
      * If mError is not empty, no serious result can be expected.
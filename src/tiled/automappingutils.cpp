@@ -32,6 +32,32 @@
 namespace Tiled {
 namespace Internal {
 
+static bool intersectsTileRegion(const MapRenderer *renderer,
+                                 const MapObject *obj,
+                                 const QRegion &where)
+{
+    // TODO: we are checking bounds, which is only correct for rectangles and
+    // tile objects. polygons and polylines are not covered correctly by this
+    // erase method (we are in fact deleting too many objects)
+    // TODO2: toAlignedRect may even break rects.
+
+    // Convert the boundary of the object into tile space
+    const QRectF objBounds = obj->boundsUseTile();
+    QPointF tl = renderer->pixelToTileCoords(objBounds.topLeft());
+    QPointF tr = renderer->pixelToTileCoords(objBounds.topRight());
+    QPointF br = renderer->pixelToTileCoords(objBounds.bottomRight());
+    QPointF bl = renderer->pixelToTileCoords(objBounds.bottomLeft());
+
+    QRectF objInTileSpace;
+    objInTileSpace.setTopLeft(tl);
+    objInTileSpace.setTopRight(tr);
+    objInTileSpace.setBottomRight(br);
+    objInTileSpace.setBottomLeft(bl);
+
+    const QRect objAlignedRect = objInTileSpace.toAlignedRect();
+    return where.intersects(objAlignedRect);
+}
+
 void eraseRegionObjectGroup(MapDocument *mapDocument,
                                         ObjectGroup *layer,
                                         const QRegion &where)
@@ -39,30 +65,23 @@ void eraseRegionObjectGroup(MapDocument *mapDocument,
     QUndoStack *undo = mapDocument->undoStack();
 
     foreach (MapObject *obj, layer->objects()) {
-        // TODO: we are checking bounds, which is only correct for rectangles and
-        // tile objects. polygons and polylines are not covered correctly by this
-        // erase method (we are in fact deleting too many objects)
-        // TODO2: toAlignedRect may even break rects.
-
-        // Convert the boundary of the object into tile space
-        const QRectF objBounds = obj->boundsUseTile();
-        QPointF tl = mapDocument->renderer()->pixelToTileCoords(objBounds.topLeft());
-        QPointF tr = mapDocument->renderer()->pixelToTileCoords(objBounds.topRight());
-        QPointF br = mapDocument->renderer()->pixelToTileCoords(objBounds.bottomRight());
-        QPointF bl = mapDocument->renderer()->pixelToTileCoords(objBounds.bottomLeft());
-
-        QRectF objInTileSpace;
-        objInTileSpace.setTopLeft(tl);
-        objInTileSpace.setTopRight(tr);
-        objInTileSpace.setBottomRight(br);
-        objInTileSpace.setBottomLeft(bl);
-
-        const QRect objAlignedRect = objInTileSpace.toAlignedRect();
-        if (where.intersects(objAlignedRect))
+        if (intersectsTileRegion(mapDocument->renderer(), obj, where))
             undo->push(new RemoveMapObject(mapDocument, obj));
     }
 }
 
+void eraseRegionObjectGroup(const MapRenderer *renderer,
+                            ObjectGroup *layer,
+                            const QRegion &where)
+{
+    foreach (MapObject *obj, layer->objects()) {
+        if (intersectsTileRegion(renderer, obj, where)) {
+            layer->removeObject(obj);
+            delete obj;
+        }
+    }
+}
+
 QRegion tileRegionOfObjectGroup(ObjectGroup *layer)
 {
     QRegion ret;
@@ -26,6 +26,7 @@
 namespace Tiled {
 
 class MapObject;
+class MapRenderer;
 class ObjectGroup;
 
 namespace Internal {
@@ -39,6 +40,14 @@ void eraseRegionObjectGroup(MapDocument *mapDocument,
                             ObjectGroup *layer,
                             const QRegion &where);
 
+/**
+ * Erases the objects in the given region directly, without undo. Used when
+ * automapping a map that isn't open in the editor.
+ */
+void eraseRegionObjectGroup(const MapRenderer *renderer,
+                            ObjectGroup *layer,
+                            const QRegion &where);
+
 QRegion tileRegionOfObjectGroup(ObjectGroup *layer);
 
 } // namespace Internal
@@ -30,12 +30,70 @@
 #include "mapscene.h"
 #include "mapdocument.h"
 #include "painttilelayer.h"
+#include "randompicker.h"
 
 #include <QApplication>
+#include <QRunnable>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+namespace Tiled {
+namespace Internal {
+
+/**
+ * The state shared between the bucket fill tool and the worker computing
+ * its fill region. The layer is a copy, so that it can be read while the
+ * map is being edited.
+ */
+struct FillRequest
+{
+    FillRequest() : finished(0), canceled(0) {}
+
+    QScopedPointer<TileLayer> layer;
+    QPoint origin;
+    TileMask selection;
+    TileMask mask;
+    QAtomicInt finished;
+    QAtomicInt canceled;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+namespace {
+
+class FillTask : public QRunnable
+{
+public:
+    FillTask(QObject *receiver, const QSharedPointer<FillRequest> &request)
+        : mReceiver(receiver)
+        , mRequest(request)
+    {}
+
+    void run() override
+    {
+        TileMask mask = TilePainter::computeFillMask(mRequest->layer.data(),
+                                                     mRequest->origin,
+                                                     &mRequest->canceled);
+        if (!mRequest->selection.isEmpty())
+            mask &= mRequest->selection;
+
+        mRequest->mask = mask;
+        mRequest->finished.storeRelease(1);
+
+        // The receiver outlives the thread pool, which runs this task
+        if (!mRequest->canceled.loadAcquire())
+            QMetaObject::invokeMethod(mReceiver, "fillMaskComputed", Qt::QueuedConnection);
+    }
+
+private:
+    QObject *mReceiver;
+    QSharedPointer<FillRequest> mRequest;
+};
+
+} // anonymous namespace
+
 BucketFillTool::BucketFillTool(QObject *parent)
     : AbstractTileTool(tr("Bucket Fill Tool"),
                        QIcon(QLatin1String(
@@ -47,10 +105,13 @@ BucketFillTool::BucketFillTool(QObject *parent)
     , mIsRandom(false)
     , mLastRandomStatus(false)
 {
+    mThreadPool.setMaxThreadCount(1);
 }
 
 BucketFillTool::~BucketFillTool()
 {
+    cancelFillRequest();
+    mThreadPool.waitForDone();
 }
 
 void BucketFillTool::activate(MapScene *scene)
@@ -65,20 +126,22 @@ void BucketFillTool::deactivate(MapScene *scene)
 {
     AbstractTileTool::deactivate(scene);
 
+    cancelFillRequest();
     mFillRegion = QRegion();
     mIsActive = false;
 }
 
 static void fillWithStamp(TileLayer &layer,
                           const TileStamp &stamp,
-                          const QRegion &mask)
+                          const QRegion &mask,
+                          RandomGenerator &generator)
 {
     const QSize size = stamp.maxSize();
 
     // Fill the entire layer with random variations of the stamp
     for (int y = 0; y < layer.height(); y += size.height()) {
         for (int x = 0; x < layer.width(); x += size.width()) {
-            const TileStampVariation variation = stamp.randomVariation();
+            const TileStampVariation variation = stamp.randomVariation(generator);
             layer.setCells(x, y, variation.tileLayer());
         }
     }
@@ -129,8 +192,12 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
 
         // Get the new fill region
         if (!shiftPressed) {
-            // If not holding shift, a region is generated from the current pos
-            mFillRegion = regionComputer.computePaintableFillRegion(tilePos);
+            // If not holding shift, a region is generated from the current
+            // pos. This happens in the background and the preview is
+            // updated once it is done.
+            startFillRequest(tileLayer, tilePos);
+            makeConnections();
+            return;
         } else {
             // If holding shift, the region is the selection bounds
             mFillRegion = mapDocument()->selectedArea();
@@ -146,6 +213,54 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
         fillRegionChanged = true;
     }
 
+    updatePreview(fillRegionChanged);
+}
+
+void BucketFillTool::startFillRequest(TileLayer *tileLayer, const QPoint &tilePos)
+{
+    cancelFillRequest();
+
+    QSharedPointer<FillRequest> request(new FillRequest);
+    request->layer.reset(static_cast<TileLayer*>(tileLayer->clone()));
+    request->origin = tilePos;
+
+    const QRegion &selection = mapDocument()->selectedArea();
+    if (!selection.isEmpty())
+        request->selection = TileMask(selection);
+
+    mFillRequest = request;
+    mThreadPool.start(new FillTask(this, request));
+}
+
+/**
+ * Makes sure the result of any pending fill request is ignored, and asks
+ * the worker to stop as soon as possible.
+ */
+void BucketFillTool::cancelFillRequest()
+{
+    if (!mFillRequest)
+        return;
+
+    mFillRequest->canceled.storeRelease(1);
+    mFillRequest.clear();
+}
+
+void BucketFillTool::fillMaskComputed()
+{
+    if (!mFillRequest || !mFillRequest->finished.loadAcquire())
+        return;
+
+    const QSharedPointer<FillRequest> request = mFillRequest;
+    mFillRequest.clear();
+
+    clearConnections(mapDocument());
+
+    mFillRegion = request->mask.toRegion();
+    updatePreview(true);
+}
+
+void BucketFillTool::updatePreview(bool fillRegionChanged)
+{
     // Ensure that a fill region was created before making an overlay layer
     if (mFillRegion.isEmpty())
         return;
@@ -169,7 +284,8 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
     if (!mIsRandom) {
         if (fillRegionChanged || mStamp.variations().size() > 1) {
             fillWithStamp(*mFillOverlay, mStamp,
-                          mFillRegion.translated(-mFillOverlay->position()));
+                          mFillRegion.translated(-mFillOverlay->position()),
+                          mapDocument()->randomGenerator());
             fillRegionChanged = true;
         }
     } else {
@@ -187,7 +303,16 @@ void BucketFillTool::tilePositionChanged(const QPoint &tilePos)
 
 void BucketFillTool::mousePressed(QGraphicsSceneMouseEvent *event)
 {
-    if (event->button() != Qt::LeftButton || mFillRegion.isEmpty())
+    if (event->button() != Qt::LeftButton)
+        return;
+
+    // Finish computing the fill region when clicking before it was done
+    if (mFillRequest) {
+        mThreadPool.waitForDone();
+        fillMaskComputed();
+    }
+
+    if (mFillRegion.isEmpty())
         return;
     if (!brushItem()->isVisible())
         return;
@@ -243,7 +368,7 @@ void BucketFillTool::mapDocumentChanged(MapDocument *oldDocument,
     clearConnections(oldDocument);
 
     if (newDocument)
-        updateRandomListAndMissingTilesets();
+        updateMissingTilesets();
 
     clearOverlay();
 }
@@ -255,7 +380,7 @@ void BucketFillTool::setStamp(const TileStamp &stamp)
 
     mStamp = stamp;
 
-    updateRandomListAndMissingTilesets();
+    updateMissingTilesets();
 
     if (mIsActive && brushItem()->isVisible())
         tilePositionChanged(tilePosition());
@@ -267,6 +392,8 @@ void BucketFillTool::clearOverlay()
     // risk of getting a callback and causing an infinite loop
     clearConnections(mapDocument());
 
+    cancelFillRequest();
+
     brushItem()->clear();
     mFillOverlay.clear();
     mFillRegion = QRegion();
@@ -312,7 +439,6 @@ void BucketFillTool::setRandom(bool value)
         return;
 
     mIsRandom = value;
-    updateRandomListAndMissingTilesets();
 
     // Don't need to recalculate fill region if there was no fill region
     if (!mFillOverlay)
@@ -323,32 +449,29 @@ void BucketFillTool::setRandom(bool value)
 
 void BucketFillTool::randomFill(TileLayer &tileLayer, const QRegion &region) const
 {
-    if (region.isEmpty() || mRandomCellPicker.isEmpty())
+    if (region.isEmpty() || mStamp.isEmpty())
+        return;
+
+    const RandomPicker<Cell> &picker = mStamp.randomCellPicker();
+    if (picker.isEmpty())
         return;
 
+    RandomGenerator &generator = mapDocument()->randomGenerator();
+
     for (const QRect &rect : region.translated(-tileLayer.position()).rects()) {
-        for (int _x = rect.left(); _x <= rect.right(); ++_x) {
-            for (int _y = rect.top(); _y <= rect.bottom(); ++_y) {
-                tileLayer.setCell(_x, _y,
-                                  mRandomCellPicker.pick());
-            }
-        }
+        const QVector<Cell> cells = picker.pickN(rect.width() * rect.height(), generator);
+        const Cell *cell = cells.constData();
+
+        for (int _y = rect.top(); _y <= rect.bottom(); ++_y)
+            for (int _x = rect.left(); _x <= rect.right(); ++_x)
+                tileLayer.setCell(_x, _y, *cell++);
     }
 }
 
-void BucketFillTool::updateRandomListAndMissingTilesets()
+void BucketFillTool::updateMissingTilesets()
 {
-    mRandomCellPicker.clear();
     mMissingTilesets.clear();
 
-    for (const TileStampVariation &variation : mStamp.variations()) {
+    for (const TileStampVariation &variation : mStamp.variations())
         mapDocument()->unifyTilesets(variation.map, mMissingTilesets);
-
-        if (mIsRandom) {
-            for (const Cell &cell : *variation.tileLayer()) {
-                if (!cell.isEmpty())
-                    mRandomCellPicker.add(cell, cell.tile->probability());
-            }
-        }
-    }
 }
@@ -24,14 +24,17 @@
 #define BUCKETFILLTOOL_H
 
 #include "abstracttiletool.h"
-#include "randompicker.h"
 #include "tilelayer.h"
 #include "tilestamp.h"
 
+#include <QSharedPointer>
+#include <QThreadPool>
+
 namespace Tiled {
 namespace Internal {
 
 class MapDocument;
+struct FillRequest;
 
 /**
  * Implements a tool that bucket fills (flood fills) a region with a repeatable
@@ -76,8 +79,13 @@ protected:
 
 private slots:
     void clearOverlay();
+    void fillMaskComputed();
 
 private:
+    void startFillRequest(TileLayer *tileLayer, const QPoint &tilePos);
+    void cancelFillRequest();
+    void updatePreview(bool fillRegionChanged);
+
     void makeConnections();
     void clearConnections(MapDocument *mapDocument);
 
@@ -86,6 +94,13 @@ private:
     QRegion mFillRegion;
     QVector<SharedTileset> mMissingTilesets;
 
+    /**
+     * The fill region is computed on a worker thread, so that hovering
+     * doesn't block the editor on large maps.
+     */
+    QThreadPool mThreadPool;
+    QSharedPointer<FillRequest> mFillRequest;
+
     bool mIsActive;
     bool mLastShiftStatus;
 
@@ -102,13 +117,11 @@ private:
      */
     bool mLastRandomStatus;
 
-    RandomPicker<Cell> mRandomCellPicker;
-
     /**
-     * Updates the list of random cells.
-     * This is done by taking all non-null tiles from the original stamp mStamp.
+     * Updates the list of tilesets used by the stamp that are not part of
+     * the map yet. The random cells are picked from the stamp itself.
      */
-    void updateRandomListAndMissingTilesets();
+    void updateMissingTilesets();
 
     /**
      * Fills the given \a region in the given \a tileLayer with random tiles.
@@ -54,6 +54,27 @@ void SetLayerVisible::swap()
 }
 
 
+SetLayersVisible::SetLayersVisible(MapDocument *mapDocument,
+                                   const QVector<int> &layerIndexes,
+                                   bool visible)
+    : mMapDocument(mapDocument)
+    , mLayerIndexes(layerIndexes)
+    , mVisible(visible)
+{
+    if (visible)
+        setText(QCoreApplication::translate("Undo Commands",
+                                            "Show Layers"));
+    else
+        setText(QCoreApplication::translate("Undo Commands",
+                                            "Hide Layers"));
+}
+
+void SetLayersVisible::setVisible(bool visible)
+{
+    mMapDocument->layerModel()->setLayersVisible(mLayerIndexes, visible);
+}
+
+
 SetLayerOpacity::SetLayerOpacity(MapDocument *mapDocument,
                                  int layerIndex,
                                  float opacity)
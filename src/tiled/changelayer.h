@@ -25,6 +25,7 @@
 
 #include <QPointF>
 #include <QUndoCommand>
+#include <QVector>
 
 namespace Tiled {
 namespace Internal {
@@ -52,6 +53,28 @@ private:
     bool mVisible;
 };
 
+/**
+ * Used for changing the visibility of several layers at once. All layers are
+ * expected to currently have the opposite visibility.
+ */
+class SetLayersVisible : public QUndoCommand
+{
+public:
+    SetLayersVisible(MapDocument *mapDocument,
+                     const QVector<int> &layerIndexes,
+                     bool visible);
+
+    void undo() override { setVisible(!mVisible); }
+    void redo() override { setVisible(mVisible); }
+
+private:
+    void setVisible(bool visible);
+
+    MapDocument *mMapDocument;
+    QVector<int> mLayerIndexes;
+    bool mVisible;
+};
+
 /**
  * Used for changing layer opacity.
  */
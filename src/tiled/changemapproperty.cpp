@@ -186,5 +186,14 @@ void ChangeMapProperty::swap()
     }
     }
 
-    mMapDocument->emitMapChanged();
+    switch (mProperty) {
+    case RenderOrder:
+    case BackgroundColor:
+    case LayerDataFormat:
+        mMapDocument->emitMapPropertyChanged();
+        break;
+    default:
+        mMapDocument->emitMapChanged();
+        break;
+    }
 }
@@ -0,0 +1,152 @@
+/*
+ * changenotifier.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "changenotifier.h"
+
+#include "map.h"
+#include "mapdocument.h"
+#include "objectgroup.h"
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+// Roughly the duration of a frame at 60 Hz
+static const int NotifyInterval = 16;
+
+ChangeNotifier::ChangeNotifier(MapDocument *mapDocument)
+    : QObject(mapDocument)
+    , mMapDocument(mapDocument)
+    , mSelectedAreaChanged(false)
+    , mSelectedObjectsChanged(false)
+{
+    mTimer.setSingleShot(true);
+    connect(&mTimer, SIGNAL(timeout()), SLOT(emitChanges()));
+
+    connect(mapDocument, SIGNAL(objectsChanged(QList<MapObject*>)),
+            SLOT(onObjectsChanged(QList<MapObject*>)));
+    connect(mapDocument, SIGNAL(objectsRemoved(QList<MapObject*>)),
+            SLOT(onObjectsRemoved(QList<MapObject*>)));
+    connect(mapDocument, SIGNAL(regionChanged(QRegion,Layer*)),
+            SLOT(onRegionChanged(QRegion,Layer*)));
+    connect(mapDocument, SIGNAL(layerChanged(int)),
+            SLOT(onLayerChanged(int)));
+    connect(mapDocument, SIGNAL(layerAboutToBeRemoved(int)),
+            SLOT(onLayerAboutToBeRemoved(int)));
+    connect(mapDocument, SIGNAL(selectedAreaChanged(QRegion,QRegion)),
+            SLOT(onSelectedAreaChanged()));
+    connect(mapDocument, SIGNAL(selectedObjectsChanged()),
+            SLOT(onSelectedObjectsChanged()));
+}
+
+void ChangeNotifier::onObjectsChanged(const QList<MapObject *> &objects)
+{
+    for (MapObject *object : objects)
+        if (!mChangedObjects.contains(object))
+            mChangedObjects.append(object);
+
+    scheduleEmit();
+}
+
+void ChangeNotifier::onObjectsRemoved(const QList<MapObject *> &objects)
+{
+    for (MapObject *object : objects)
+        mChangedObjects.removeOne(object);
+}
+
+void ChangeNotifier::onRegionChanged(const QRegion &region, Layer *layer)
+{
+    mChangedRegions[layer] |= region;
+    scheduleEmit();
+}
+
+void ChangeNotifier::onLayerChanged(int index)
+{
+    Layer *layer = mMapDocument->map()->layerAt(index);
+    if (!mChangedLayers.contains(layer))
+        mChangedLayers.append(layer);
+
+    scheduleEmit();
+}
+
+void ChangeNotifier::onLayerAboutToBeRemoved(int index)
+{
+    Layer *layer = mMapDocument->map()->layerAt(index);
+    mChangedRegions.remove(layer);
+    mChangedLayers.removeOne(layer);
+
+    if (ObjectGroup *objectGroup = layer->asObjectGroup())
+        onObjectsRemoved(objectGroup->objects());
+}
+
+void ChangeNotifier::onSelectedAreaChanged()
+{
+    mSelectedAreaChanged = true;
+    scheduleEmit();
+}
+
+void ChangeNotifier::onSelectedObjectsChanged()
+{
+    mSelectedObjectsChanged = true;
+    scheduleEmit();
+}
+
+/**
+ * Starts the timer unless it is already running, so that the changes keep
+ * being emitted during continuous changes.
+ */
+void ChangeNotifier::scheduleEmit()
+{
+    if (!mTimer.isActive())
+        mTimer.start(NotifyInterval);
+}
+
+void ChangeNotifier::emitChanges()
+{
+    // Take the pending changes first, since listeners may cause new changes
+    const QList<MapObject*> changedObjects = mChangedObjects;
+    const QHash<Layer*, QRegion> changedRegions = mChangedRegions;
+    const QList<Layer*> changedLayers = mChangedLayers;
+    const bool areaChanged = mSelectedAreaChanged;
+    const bool selectionChanged = mSelectedObjectsChanged;
+
+    mChangedObjects.clear();
+    mChangedRegions.clear();
+    mChangedLayers.clear();
+    mSelectedAreaChanged = false;
+    mSelectedObjectsChanged = false;
+
+    if (!changedObjects.isEmpty())
+        emit objectsChanged(changedObjects);
+
+    for (auto it = changedRegions.constBegin(); it != changedRegions.constEnd(); ++it)
+        emit regionChanged(it.value(), it.key());
+
+    const Map *map = mMapDocument->map();
+    for (Layer *layer : changedLayers) {
+        const int index = map->layers().indexOf(layer);
+        if (index != -1)
+            emit layerChanged(index);
+    }
+
+    if (areaChanged)
+        emit selectedAreaChanged();
+    if (selectionChanged)
+        emit selectedObjectsChanged();
+}
@@ -0,0 +1,100 @@
+/*
+ * changenotifier.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHANGENOTIFIER_H
+#define CHANGENOTIFIER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QRegion>
+#include <QTimer>
+
+namespace Tiled {
+
+class Layer;
+class MapObject;
+
+namespace Internal {
+
+class MapDocument;
+
+/**
+ * Combines the change signals of a map document that are emitted in quick
+ * succession, for example while dragging objects or painting, and emits them
+ * at most once per frame.
+ *
+ * Meant for the views that don't need to be updated synchronously, like the
+ * docks. The map scene should keep using the signals of the MapDocument.
+ */
+class ChangeNotifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChangeNotifier(MapDocument *mapDocument);
+
+signals:
+    /**
+     * Emitted with all map objects that changed since the last emission.
+     */
+    void objectsChanged(const QList<MapObject*> &objects);
+
+    /**
+     * Emitted for each tile layer with the combined region that changed.
+     */
+    void regionChanged(const QRegion &region, Layer *layer);
+
+    /**
+     * Emitted once for each layer whose properties changed.
+     */
+    void layerChanged(int index);
+
+    void selectedAreaChanged();
+    void selectedObjectsChanged();
+
+private slots:
+    void onObjectsChanged(const QList<MapObject*> &objects);
+    void onObjectsRemoved(const QList<MapObject*> &objects);
+    void onRegionChanged(const QRegion &region, Layer *layer);
+    void onLayerChanged(int index);
+    void onLayerAboutToBeRemoved(int index);
+    void onSelectedAreaChanged();
+    void onSelectedObjectsChanged();
+
+    void emitChanges();
+
+private:
+    void scheduleEmit();
+
+    MapDocument *mMapDocument;
+    QTimer mTimer;
+
+    QList<MapObject*> mChangedObjects;
+    QHash<Layer*, QRegion> mChangedRegions;
+    QList<Layer*> mChangedLayers;
+    bool mSelectedAreaChanged;
+    bool mSelectedObjectsChanged;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // CHANGENOTIFIER_H
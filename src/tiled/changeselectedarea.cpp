@@ -24,6 +24,7 @@
 
 #include <QCoreApplication>
 
+using namespace Tiled;
 using namespace Tiled::Internal;
 
 ChangeSelectedArea::ChangeSelectedArea(MapDocument *mapDocument,
@@ -31,23 +32,51 @@ ChangeSelectedArea::ChangeSelectedArea(MapDocument *mapDocument,
     : QUndoCommand(QCoreApplication::translate("Undo Commands",
                                                "Change Selection"))
     , mMapDocument(mapDocument)
-    , mSelection(newSelection)
+    , mChanges(TileMask(mapDocument->selectedArea()) ^ TileMask(newSelection))
+    , mMergeable(false)
 {
 }
 
 void ChangeSelectedArea::undo()
 {
-    swapSelection();
+    toggleChanges();
 }
 
 void ChangeSelectedArea::redo()
 {
-    swapSelection();
+    toggleChanges();
 }
 
-void ChangeSelectedArea::swapSelection()
+bool ChangeSelectedArea::mergeWith(const QUndoCommand *other)
 {
-    const QRegion oldSelection = mMapDocument->selectedArea();
-    mMapDocument->setSelectedArea(mSelection);
-    mSelection = oldSelection;
+    const ChangeSelectedArea *o = static_cast<const ChangeSelectedArea*>(other);
+    if (!(mMapDocument == o->mMapDocument &&
+          o->mMergeable))
+        return false;
+
+    // Positions changed by both commands end up unchanged
+    mCompressedChanges.decompress(mChanges);
+    mChanges ^= o->mChanges;
+    return true;
+}
+
+qint64 ChangeSelectedArea::memoryUsage() const
+{
+    return mChanges.memoryUsage() + mCompressedChanges.memoryUsage();
+}
+
+void ChangeSelectedArea::compress()
+{
+    mCompressedChanges.compress(mChanges);
+}
+
+void ChangeSelectedArea::toggleChanges()
+{
+    mCompressedChanges.decompress(mChanges);
+    if (mChanges.isEmpty())
+        return;
+
+    TileMask selection(mMapDocument->selectedArea());
+    selection ^= mChanges;
+    mMapDocument->setSelectedArea(selection.toRegion());
 }
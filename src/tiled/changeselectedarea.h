@@ -21,6 +21,10 @@
 #ifndef CHANGESELECTEDAREA_H
 #define CHANGESELECTEDAREA_H
 
+#include "tilemask.h"
+#include "undocommands.h"
+#include "undomemory.h"
+
 #include <QRegion>
 #include <QUndoCommand>
 
@@ -29,7 +33,13 @@ namespace Internal {
 
 class MapDocument;
 
-class ChangeSelectedArea: public QUndoCommand
+/**
+ * Changes the selected area of a map document. Only the positions that
+ * change are stored, which are toggled on undo and redo. Selection changes
+ * that continue the same interaction can be marked as mergeable, to merge
+ * them with the previous selection change.
+ */
+class ChangeSelectedArea: public QUndoCommand, public UndoCommandMemory
 {
 public:
     /**
@@ -39,14 +49,30 @@ public:
     ChangeSelectedArea(MapDocument *mapDocument,
                         const QRegion &selection);
 
+    /**
+     * Sets whether this undo command can be merged with an existing command.
+     * Only set this for changes that continue the same interaction, like a
+     * drag or a single tool stroke.
+     */
+    void setMergeable(bool mergeable)
+    { mMergeable = mergeable; }
+
     void undo() override;
     void redo() override;
 
+    int id() const override { return Cmd_ChangeSelectedArea; }
+    bool mergeWith(const QUndoCommand *other) override;
+
+    qint64 memoryUsage() const override;
+    void compress() override;
+
 private:
-    void swapSelection();
+    void toggleChanges();
 
     MapDocument *mMapDocument;
-    QRegion mSelection;
+    TileMask mChanges;      // the positions that differ between selections
+    CompressedMask mCompressedChanges;
+    bool mMergeable;
 };
 
 } // namespace Internal
@@ -20,25 +20,175 @@
 
 #include "clipboardmanager.h"
 
-#include "addremovemapobject.h"
 #include "map.h"
 #include "mapdocument.h"
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "mapview.h"
 #include "objectgroup.h"
+#include "gidmapper.h"
+#include "mapreader.h"
 #include "snaphelper.h"
 #include "tmxmapformat.h"
 #include "tile.h"
 #include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
 
 #include <QApplication>
 #include <QClipboard>
+#include <QDataStream>
 #include <QMimeData>
+#include <QScopedPointer>
 #include <QSet>
-#include <QUndoStack>
+#include <QtEndian>
+
+#include <limits>
 
 static const char * const TMX_MIMETYPE = "text/tmx";
+static const char * const TILES_MIMETYPE = "application/x-tiled-tiles";
+static const char * const TOKEN_MIMETYPE = "application/x-tiled-clipboard-token";
+
+static const quint32 TILES_MAGIC = 0x544c5354; // "TSLT"
+static const quint32 TILES_VERSION = 1;
+
+namespace {
+
+/**
+ * Encodes a map with a single tile layer, which only uses external
+ * tilesets, in a compact binary format. The tilesets are referred to by
+ * their file names and the gids are stored compressed.
+ *
+ * Returns an empty byte array when the map can't be stored this way.
+ */
+QByteArray writeTiles(const Map *map)
+{
+    if (map->layerCount() != 1)
+        return QByteArray();
+
+    const TileLayer *tileLayer = dynamic_cast<const TileLayer*>(map->layerAt(0));
+    if (!tileLayer)
+        return QByteArray();
+
+    for (const SharedTileset &tileset : map->tilesets())
+        if (!tileset->isExternal())
+            return QByteArray();
+
+    // QByteArray is limited to an int size
+    const int width = tileLayer->width();
+    const qint64 size = qint64(width) * tileLayer->height() * 4;
+    if (size > std::numeric_limits<int>::max())
+        return QByteArray();
+
+    const GidMapper gidMapper(map->tilesets());
+
+    QByteArray gidData(int(size), Qt::Uninitialized);
+    unsigned *gids = reinterpret_cast<unsigned*>(gidData.data());
+
+    for (int y = 0; y < tileLayer->height(); ++y, gids += width) {
+        gidMapper.cellsToGids(*tileLayer, y, gids);
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+        for (int x = 0; x < width; ++x)
+            gids[x] = qToLittleEndian<quint32>(gids[x]);
+#endif
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+
+    stream << TILES_MAGIC << TILES_VERSION
+           << qint32(map->orientation()) << qint32(map->renderOrder())
+           << qint32(map->tileWidth()) << qint32(map->tileHeight());
+
+    stream << qint32(map->tilesetCount());
+    for (const SharedTileset &tileset : map->tilesets()) {
+        stream << tileset->fileName()
+               << qint32(tileset->tileCount())
+               << qint32(tileset->columnCount());
+    }
+
+    stream << tileLayer->name()
+           << qint32(width) << qint32(tileLayer->height())
+           << qCompress(gidData);
+
+    return data;
+}
+
+/**
+ * Decodes a map written by writeTiles(). Returns nullptr when the data is
+ * invalid or when any of the tilesets can't be found or has changed.
+ */
+Map *readTiles(const QByteArray &data)
+{
+    QDataStream stream(data);
+
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (magic != TILES_MAGIC || version != TILES_VERSION)
+        return nullptr;
+
+    qint32 orientation, renderOrder, tileWidth, tileHeight, tilesetCount;
+    stream >> orientation >> renderOrder >> tileWidth >> tileHeight
+           >> tilesetCount;
+
+    if (stream.status() != QDataStream::Ok || tilesetCount < 0)
+        return nullptr;
+
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    QVector<SharedTileset> tilesets;
+
+    for (int i = 0; i < tilesetCount; ++i) {
+        QString fileName;
+        qint32 tileCount, columnCount;
+        stream >> fileName >> tileCount >> columnCount;
+
+        if (stream.status() != QDataStream::Ok)
+            return nullptr;
+
+        SharedTileset tileset = tilesetManager->findTileset(fileName);
+        if (!tileset)
+            tileset = MapReader().readTileset(fileName);
+
+        // The gids would no longer map to the right tiles
+        if (!tileset || tileset->tileCount() != tileCount ||
+                tileset->columnCount() != columnCount)
+            return nullptr;
+
+        tilesets.append(tileset);
+    }
+
+    QString layerName;
+    qint32 width, height;
+    QByteArray compressedGids;
+    stream >> layerName >> width >> height >> compressedGids;
+
+    if (stream.status() != QDataStream::Ok || width < 0 || height < 0)
+        return nullptr;
+
+    const QByteArray gids = qUncompress(compressedGids);
+    if (gids.size() != qint64(width) * height * 4)
+        return nullptr;
+
+    QScopedPointer<TileLayer> tileLayer(new TileLayer(layerName, 0, 0,
+                                                      width, height));
+
+    const GidMapper gidMapper(tilesets);
+    if (gidMapper.decodeLayerData(*tileLayer,
+                                  reinterpret_cast<const uchar*>(gids.constData()))
+            != GidMapper::NoError)
+        return nullptr;
+
+    Map *map = new Map(static_cast<Map::Orientation>(orientation),
+                       width, height, tileWidth, tileHeight);
+    map->setRenderOrder(static_cast<Map::RenderOrder>(renderOrder));
+    for (const SharedTileset &tileset : tilesets)
+        map->addTileset(tileset);
+    map->addLayer(tileLayer.take());
+
+    return map;
+}
+
+} // anonymous namespace
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -70,6 +220,18 @@ void ClipboardManager::deleteInstance()
 Map *ClipboardManager::map() const
 {
     const QMimeData *mimeData = mClipboard->mimeData();
+    if (!mimeData)
+        return nullptr;
+
+    // Avoid decoding a map that was copied by this process
+    if (ownsMap(mimeData))
+        return new Map(*mMap);
+
+    const QByteArray tiles = mimeData->data(QLatin1String(TILES_MIMETYPE));
+    if (!tiles.isEmpty())
+        if (Map *map = readTiles(tiles))
+            return map;
+
     const QByteArray data = mimeData->data(QLatin1String(TMX_MIMETYPE));
     if (data.isEmpty())
         return nullptr;
@@ -78,16 +240,46 @@ Map *ClipboardManager::map() const
     return format.fromByteArray(data);
 }
 
+/**
+ * Keeps a copy of the given \a map for pasting within this process. Since
+ * the tile data of the copy is shared, this is cheap.
+ *
+ * For other processes the map is stored in a compact binary format when
+ * possible, along with the TMX format. The binary format is only used for
+ * tile layers that refer exclusively to external tilesets. The TMX format is
+ * always included, for older versions of Tiled and for when the tilesets
+ * referred to by the binary format can't be found.
+ */
 void ClipboardManager::setMap(const Map *map)
 {
-    TmxMapFormat format;
+    static quint64 tokenCounter;
+
+    mMap = QSharedPointer<const Map>(new Map(*map));
+    mMapToken = QByteArray::number(QCoreApplication::applicationPid()) + ':' +
+            QByteArray::number(++tokenCounter);
 
     QMimeData *mimeData = new QMimeData;
+    mimeData->setData(QLatin1String(TOKEN_MIMETYPE), mMapToken);
+
+    const QByteArray tiles = writeTiles(map);
+    if (!tiles.isEmpty())
+        mimeData->setData(QLatin1String(TILES_MIMETYPE), tiles);
+
+    TmxMapFormat format;
     mimeData->setData(QLatin1String(TMX_MIMETYPE), format.toByteArray(map));
 
     mClipboard->setMimeData(mimeData);
 }
 
+/**
+ * Returns whether the given \a mimeData refers to the map that was last
+ * copied by this process.
+ */
+bool ClipboardManager::ownsMap(const QMimeData *mimeData) const
+{
+    return mMap && mimeData->data(QLatin1String(TOKEN_MIMETYPE)) == mMapToken;
+}
+
 void ClipboardManager::copySelection(const MapDocument *mapDocument)
 {
     const Layer *currentLayer = mapDocument->currentLayer();
@@ -159,32 +351,35 @@ void ClipboardManager::pasteObjectGroup(const ObjectGroup *objectGroup,
     QPointF insertPos = renderer->screenToPixelCoords(scenePos) - center;
     SnapHelper(renderer).snap(insertPos);
 
-    QUndoStack *undoStack = mapDocument->undoStack();
     QList<MapObject*> pastedObjects;
     pastedObjects.reserve(objectGroup->objectCount());
 
-    undoStack->beginMacro(tr("Paste Objects"));
-    foreach (const MapObject *mapObject, objectGroup->objects()) {
+    for (const MapObject *mapObject : objectGroup->objects()) {
         if (mode == NoTileObjects && !mapObject->cell().isEmpty())
             continue;
 
         MapObject *objectClone = mapObject->clone();
         objectClone->setPosition(objectClone->position() + insertPos);
         pastedObjects.append(objectClone);
-        undoStack->push(new AddMapObject(mapDocument,
-                                         currentObjectGroup,
-                                         objectClone));
     }
-    undoStack->endMacro();
 
-    mapDocument->setSelectedObjects(pastedObjects);
+    mapDocument->addObjects(currentObjectGroup, pastedObjects,
+                            tr("Paste Objects"));
 }
 
 void ClipboardManager::updateHasMap()
 {
     const QMimeData *data = mClipboard->mimeData();
+
+    // Release the copied map once something else was put on the clipboard
+    if (mMap && !(data && ownsMap(data))) {
+        mMap.clear();
+        mMapToken.clear();
+    }
+
     const bool mapInClipboard =
-            data && data->hasFormat(QLatin1String(TMX_MIMETYPE));
+            data && (data->hasFormat(QLatin1String(TMX_MIMETYPE)) ||
+                     data->hasFormat(QLatin1String(TILES_MIMETYPE)));
 
     if (mapInClipboard != mHasMap) {
         mHasMap = mapInClipboard;
@@ -21,9 +21,12 @@
 #ifndef CLIPBOARDMANAGER_H
 #define CLIPBOARDMANAGER_H
 
+#include <QByteArray>
 #include <QObject>
+#include <QSharedPointer>
 
 class QClipboard;
+class QMimeData;
 
 namespace Tiled {
 
@@ -62,6 +65,9 @@ public:
     /**
      * Retrieves the map from the clipboard. Returns 0 when there was no map or
      * loading failed.
+     *
+     * When the map was copied by this process, a copy of the map is returned
+     * which shares its tile data with the copied map.
      */
     Map *map() const;
 
@@ -104,9 +110,16 @@ private:
 
     Q_DISABLE_COPY(ClipboardManager)
 
+    bool ownsMap(const QMimeData *mimeData) const;
+
     QClipboard *mClipboard;
     bool mHasMap;
 
+    // The last map copied by this process, along with the token identifying
+    // it on the clipboard
+    QSharedPointer<const Map> mMap;
+    QByteArray mMapToken;
+
     static ClipboardManager *mInstance;
 };
 
@@ -250,11 +250,20 @@ void DocumentManager::switchToRightDocument()
 }
 
 void DocumentManager::addDocument(MapDocument *mapDocument)
+{
+    insertDocument(mDocuments.size(), mapDocument);
+
+    switchToDocument(mDocuments.size() - 1);
+    centerViewOn(0, 0);
+}
+
+void DocumentManager::insertDocument(int index, MapDocument *mapDocument)
 {
     Q_ASSERT(mapDocument);
     Q_ASSERT(!mDocuments.contains(mapDocument));
+    Q_ASSERT(index >= 0 && index <= mDocuments.size());
 
-    mDocuments.append(mapDocument);
+    mDocuments.insert(index, mapDocument);
     mUndoGroup->addStack(mapDocument->undoStack());
 
     if (!mapDocument->fileName().isEmpty())
@@ -267,19 +276,15 @@ void DocumentManager::addDocument(MapDocument *mapDocument)
     scene->setMapDocument(mapDocument);
     view->setScene(scene);
 
-    const int documentIndex = mDocuments.size() - 1;
-
-    mTabWidget->addTab(container, mapDocument->displayName());
-    mTabWidget->setTabToolTip(documentIndex, mapDocument->fileName());
+    mTabWidget->insertTab(index, container, mapDocument->displayName());
+    mTabWidget->setTabToolTip(index, mapDocument->fileName());
     connect(mapDocument, SIGNAL(fileNameChanged(QString,QString)),
             SLOT(fileNameChanged(QString,QString)));
     connect(mapDocument, SIGNAL(modifiedChanged()), SLOT(updateDocumentTab()));
-    connect(mapDocument, SIGNAL(saved()), SLOT(documentSaved()));
+    connect(mapDocument, SIGNAL(saved()), SLOT(onDocumentSaved()));
+    connect(mapDocument, SIGNAL(saveFailed(QString)), SLOT(documentSaveFailed(QString)));
 
     connect(container, SIGNAL(reload()), SLOT(reloadRequested()));
-
-    switchToDocument(documentIndex);
-    centerViewOn(0, 0);
 }
 
 void DocumentManager::closeCurrentDocument()
@@ -360,6 +365,10 @@ void DocumentManager::closeAllDocuments()
 
 void DocumentManager::currentIndexChanged()
 {
+    // Inserting or removing a tab before the current one only changes its index
+    if (mViewWithTool && mViewWithTool == currentMapView())
+        return;
+
     if (mViewWithTool) {
         MapScene *mapScene = mViewWithTool->mapScene();
         mapScene->disableSelectedTool();
@@ -442,7 +451,7 @@ void DocumentManager::updateDocumentTab()
     mTabWidget->setTabToolTip(index, mapDocument->fileName());
 }
 
-void DocumentManager::documentSaved()
+void DocumentManager::onDocumentSaved()
 {
     MapDocument *document = static_cast<MapDocument*>(sender());
     const int index = mDocuments.indexOf(document);
@@ -451,6 +460,16 @@ void DocumentManager::documentSaved()
     QWidget *widget = mTabWidget->widget(index);
     MapViewContainer *container = static_cast<MapViewContainer*>(widget);
     container->setFileChangedWarningVisible(false);
+
+    emit documentSaved(document);
+}
+
+void DocumentManager::documentSaveFailed(const QString &error)
+{
+    MapDocument *document = static_cast<MapDocument*>(sender());
+    switchToDocument(document);
+
+    emit saveError(tr("%1:\n\n%2").arg(document->fileName(), error));
 }
 
 void DocumentManager::documentTabMoved(int from, int to)
@@ -469,6 +488,8 @@ void DocumentManager::fileChanged(const QString &fileName)
     MapDocument *document = mDocuments.at(index);
 
     // Ignore change event when it seems to be our own save
+    if (document->isSaving())
+        return;
     if (QFileInfo(fileName).lastModified() == document->lastSaved())
         return;
 
@@ -110,6 +110,12 @@ public:
      */
     void addDocument(MapDocument *mapDocument);
 
+    /**
+     * Inserts the opened \a mapDocument at the given tab \a index, without
+     * switching to it.
+     */
+    void insertDocument(int index, MapDocument *mapDocument);
+
     /**
      * Closes the current map document. Will not ask the user whether to save
      * any changes!
@@ -177,6 +183,18 @@ signals:
      */
     void reloadError(const QString &error);
 
+    /**
+     * Emitted when an error occurred while saving a map in the background.
+     * The document that failed to save is made the current document.
+     */
+    void saveError(const QString &error);
+
+    /**
+     * Emitted when the given \a mapDocument has been saved, including when
+     * saving in the background has finished.
+     */
+    void documentSaved(MapDocument *mapDocument);
+
 public slots:
     void switchToLeftDocument();
     void switchToRightDocument();
@@ -188,7 +206,8 @@ private slots:
     void fileNameChanged(const QString &fileName,
                          const QString &oldFileName);
     void updateDocumentTab();
-    void documentSaved();
+    void onDocumentSaved();
+    void documentSaveFailed(const QString &error);
     void documentTabMoved(int from, int to);
 
     void fileChanged(const QString &fileName);
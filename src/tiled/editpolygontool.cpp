@@ -30,18 +30,21 @@
 #include "mapobjectmodel.h"
 #include "maprenderer.h"
 #include "mapscene.h"
+#include "mapview.h"
 #include "rangeset.h"
 #include "selectionrectangle.h"
 #include "snaphelper.h"
 #include "utils.h"
+#include "zoomable.h"
 
 #include <QApplication>
 #include <QGraphicsItem>
-#include <QGraphicsView>
 #include <QMenu>
 #include <QPainter>
 #include <QPalette>
+#include <QStyleOptionGraphicsItem>
 #include <QUndoStack>
+#include <QtMath>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -50,36 +53,43 @@ namespace Tiled {
 namespace Internal {
 
 /**
- * A handle that allows moving around a point of a polygon.
+ * Displays the handles for the points of the polygons of the selected map
+ * objects.
+ *
+ * A single item is used for all handles, since polygons and polylines can
+ * easily have tens of thousands of points. The handles are kept in a grid
+ * in scene coordinates so that the handles at a certain location can be
+ * looked up quickly, and changing a handle only repaints that handle.
+ *
+ * Handles are drawn at a fixed size on screen, regardless of the zoom
+ * level. The current scale of the view is therefore needed to know which
+ * area of the scene a handle covers.
  */
-class PointHandle : public QGraphicsItem
+class PointHandles : public QGraphicsItem
 {
 public:
-    PointHandle(MapObjectItem *mapObjectItem, int pointIndex)
-        : QGraphicsItem()
-        , mMapObjectItem(mapObjectItem)
-        , mPointIndex(pointIndex)
-        , mSelected(false)
-    {
-        setFlags(QGraphicsItem::ItemIgnoresTransformations |
-                 QGraphicsItem::ItemIgnoresParentOpacity);
-        setZValue(10000);
-        setCursor(Qt::SizeAllCursor);
-    }
+    PointHandles();
 
     enum { Type = UserType + 2 };
     int type() const override { return Type; }
 
-    MapObjectItem *mapObjectItem() const { return mMapObjectItem; }
-    MapObject *mapObject() const { return mMapObjectItem->mapObject(); }
+    void setViewScale(qreal scale);
 
-    int pointIndex() const { return mPointIndex; }
+    QList<MapObject*> mapObjects() const { return mObjects.keys(); }
+    bool contains(MapObject *mapObject) const { return mObjects.contains(mapObject); }
+    MapObjectItem *mapObjectItem(MapObject *mapObject) const;
+    int handleCount(MapObject *mapObject) const;
 
-    void setPointPosition(const QPointF &pos);
+    void setHandles(MapObjectItem *item, const QVector<QPointF> &positions);
+    void removeHandles(MapObject *mapObject);
+    void clear();
 
-    // These hide the QGraphicsItem members
-    void setSelected(bool selected) { mSelected = selected; update(); }
-    bool isSelected() const { return mSelected; }
+    QPointF handlePosition(const PointHandle &handle) const;
+    void setHandlePosition(const PointHandle &handle, const QPointF &pos);
+    void setHandleSelected(const PointHandle &handle, bool selected);
+
+    PointHandle handleAt(const QPointF &scenePos) const;
+    QList<PointHandle> handlesIn(const QRectF &sceneRect) const;
 
     QRectF boundingRect() const override;
     void paint(QPainter *painter,
@@ -87,41 +97,375 @@ public:
                QWidget *widget = nullptr) override;
 
 private:
-    MapObjectItem *mMapObjectItem;
-    int mPointIndex;
-    bool mSelected;
+    struct ObjectHandles
+    {
+        MapObjectItem *item;
+        QVector<QPointF> positions;
+        QVector<bool> selected;
+    };
+
+    static const int CellSize = 64;
+
+    qreal margin() const { return 6 / mScale; }
+    QRectF handleRect(const QPointF &pos) const;
+
+    static quint64 cellKey(const QPointF &pos);
+    void insertIntoGrid(const PointHandle &handle, const QPointF &pos);
+    void removeFromGrid(const PointHandle &handle, const QPointF &pos);
+
+    template<typename Callback>
+    void forEachHandleIn(const QRectF &sceneRect, Callback callback) const;
+
+    void includeInBounds(const QPointF &pos);
+    void expandBounds(const QPointF &pos);
+    void recomputeBounds();
+
+    QHash<MapObject*, ObjectHandles> mObjects;
+    QHash<quint64, QVector<PointHandle> > mGrid;
+    int mHandleCount;
+    QRectF mBounds;
+    bool mHasBounds;
+    qreal mScale;
 };
 
 } // namespace Internal
 } // namespace Tiled
 
-void PointHandle::setPointPosition(const QPointF &pos)
+PointHandles::PointHandles()
+    : mHandleCount(0)
+    , mHasBounds(false)
+    , mScale(1)
 {
-    // TODO: It could be faster to update the polygon only once when changing
-    // multiple points of the same polygon.
-    MapObject *mapObject = mMapObjectItem->mapObject();
-    QPolygonF polygon = mapObject->polygon();
-    polygon[mPointIndex] = pos - mapObject->position();
-    mMapObjectItem->setPolygon(polygon);
+    setFlags(QGraphicsItem::ItemIgnoresParentOpacity |
+             QGraphicsItem::ItemUsesExtendedStyleOption);
+    setZValue(10000);
+}
+
+void PointHandles::setViewScale(qreal scale)
+{
+    if (mScale == scale)
+        return;
+
+    prepareGeometryChange();
+    mScale = scale;
+}
+
+MapObjectItem *PointHandles::mapObjectItem(MapObject *mapObject) const
+{
+    const auto it = mObjects.find(mapObject);
+    return it != mObjects.end() ? it->item : nullptr;
+}
+
+int PointHandles::handleCount(MapObject *mapObject) const
+{
+    const auto it = mObjects.find(mapObject);
+    return it != mObjects.end() ? it->positions.size() : 0;
+}
+
+/**
+ * Sets the scene \a positions of the handles of the object displayed by the
+ * given \a item. Only the handles that actually moved are repainted and
+ * the selection state of existing handles is kept.
+ */
+void PointHandles::setHandles(MapObjectItem *item, const QVector<QPointF> &positions)
+{
+    MapObject *mapObject = item->mapObject();
+    ObjectHandles &handles = mObjects[mapObject];
+    handles.item = item;
+
+    // Remove superfluous handles
+    for (int i = handles.positions.size() - 1; i >= positions.size(); --i) {
+        const QPointF &pos = handles.positions.at(i);
+        removeFromGrid(PointHandle(mapObject, i), pos);
+        update(handleRect(pos));
+        --mHandleCount;
+    }
+
+    const int oldCount = qMin(handles.positions.size(), positions.size());
+    handles.positions.resize(positions.size());
+    handles.selected.resize(positions.size());
+
+    for (int i = 0; i < positions.size(); ++i) {
+        const QPointF &pos = positions.at(i);
+
+        if (i < oldCount) {
+            const QPointF oldPos = handles.positions.at(i);
+            if (oldPos == pos)
+                continue;
+
+            removeFromGrid(PointHandle(mapObject, i), oldPos);
+            update(handleRect(oldPos));
+        } else {
+            handles.selected[i] = false;
+            ++mHandleCount;
+        }
+
+        handles.positions[i] = pos;
+        insertIntoGrid(PointHandle(mapObject, i), pos);
+        includeInBounds(pos);
+        update(handleRect(pos));
+    }
+}
+
+void PointHandles::removeHandles(MapObject *mapObject)
+{
+    const auto it = mObjects.find(mapObject);
+    if (it == mObjects.end())
+        return;
+
+    const QVector<QPointF> &positions = it->positions;
+    for (int i = 0; i < positions.size(); ++i)
+        removeFromGrid(PointHandle(mapObject, i), positions.at(i));
+
+    mHandleCount -= positions.size();
+    mObjects.erase(it);
+
+    update();
+    recomputeBounds();
+}
+
+void PointHandles::clear()
+{
+    prepareGeometryChange();
+    mObjects.clear();
+    mGrid.clear();
+    mHandleCount = 0;
+    mBounds = QRectF();
+    mHasBounds = false;
+}
+
+QPointF PointHandles::handlePosition(const PointHandle &handle) const
+{
+    return mObjects.find(handle.mapObject)->positions.at(handle.pointIndex);
+}
+
+void PointHandles::setHandlePosition(const PointHandle &handle, const QPointF &pos)
+{
+    auto it = mObjects.find(handle.mapObject);
+    Q_ASSERT(it != mObjects.end());
+
+    QPointF &handlePos = it->positions[handle.pointIndex];
+    if (handlePos == pos)
+        return;
+
+    update(handleRect(handlePos));
+    removeFromGrid(handle, handlePos);
+
+    handlePos = pos;
+
+    insertIntoGrid(handle, pos);
+    includeInBounds(pos);
+    update(handleRect(pos));
+}
+
+void PointHandles::setHandleSelected(const PointHandle &handle, bool selected)
+{
+    auto it = mObjects.find(handle.mapObject);
+    if (it == mObjects.end() || handle.pointIndex >= it->selected.size())
+        return;
+
+    it->selected[handle.pointIndex] = selected;
+    update(handleRect(it->positions.at(handle.pointIndex)));
+}
+
+/**
+ * Returns the handle at the given scene position, preferring the one
+ * closest to it when handles overlap. Returns an invalid handle when there
+ * is no handle at this position.
+ */
+PointHandle PointHandles::handleAt(const QPointF &scenePos) const
+{
+    const qreal m = margin();
+    const QRectF area(scenePos.x() - m, scenePos.y() - m, m * 2, m * 2);
+
+    PointHandle closest;
+    qreal closestDistance = 0;
+
+    forEachHandleIn(area, [&] (const PointHandle &handle, const QPointF &pos, bool) {
+        if (!handleRect(pos).contains(scenePos))
+            return;
+
+        const qreal distance = (pos - scenePos).manhattanLength();
+        if (!closest.isValid() || distance < closestDistance) {
+            closest = handle;
+            closestDistance = distance;
+        }
+    });
+
+    return closest;
+}
+
+/**
+ * Returns the handles intersecting with the given scene rectangle.
+ */
+QList<PointHandle> PointHandles::handlesIn(const QRectF &sceneRect) const
+{
+    QList<PointHandle> handles;
+
+    forEachHandleIn(sceneRect, [&] (const PointHandle &handle, const QPointF &pos, bool) {
+        if (handleRect(pos).intersects(sceneRect))
+            handles.append(handle);
+    });
+
+    return handles;
 }
 
-QRectF PointHandle::boundingRect() const
+QRectF PointHandles::boundingRect() const
 {
-    return QRectF(-5, -5, 10 + 1, 10 + 1);
+    if (!mHasBounds)
+        return QRectF();
+
+    const qreal m = margin();
+    return mBounds.adjusted(-m, -m, m, m);
 }
 
-void PointHandle::paint(QPainter *painter,
-                        const QStyleOptionGraphicsItem *,
-                        QWidget *)
+void PointHandles::paint(QPainter *painter,
+                         const QStyleOptionGraphicsItem *option,
+                         QWidget *)
 {
+    QVector<QRectF> handleRects;
+    QVector<QRectF> selectedHandleRects;
+
+    const QTransform transform = painter->worldTransform();
+
+    forEachHandleIn(option->exposedRect, [&] (const PointHandle &, const QPointF &pos, bool selected) {
+        const QPointF screenPos = transform.map(pos);
+        if (selected)
+            selectedHandleRects.append(QRectF(screenPos.x() - 4, screenPos.y() - 4, 8, 8));
+        else
+            handleRects.append(QRectF(screenPos.x() - 3, screenPos.y() - 3, 6, 6));
+    });
+
+    // Draw the handles in screen coordinates, so they have a fixed size
+    painter->save();
+    painter->setWorldTransform(QTransform());
     painter->setPen(Qt::black);
-    if (mSelected) {
-        painter->setBrush(QApplication::palette().highlight());
-        painter->drawRect(QRectF(-4, -4, 8, 8));
-    } else {
-        painter->setBrush(Qt::lightGray);
-        painter->drawRect(QRectF(-3, -3, 6, 6));
+
+    painter->setBrush(Qt::lightGray);
+    painter->drawRects(handleRects);
+
+    painter->setBrush(QApplication::palette().highlight());
+    painter->drawRects(selectedHandleRects);
+
+    painter->restore();
+}
+
+QRectF PointHandles::handleRect(const QPointF &pos) const
+{
+    const qreal m = margin();
+    return QRectF(pos.x() - m, pos.y() - m, m * 2, m * 2);
+}
+
+quint64 PointHandles::cellKey(const QPointF &pos)
+{
+    const int x = qFloor(pos.x() / CellSize);
+    const int y = qFloor(pos.y() / CellSize);
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+void PointHandles::insertIntoGrid(const PointHandle &handle, const QPointF &pos)
+{
+    mGrid[cellKey(pos)].append(handle);
+}
+
+void PointHandles::removeFromGrid(const PointHandle &handle, const QPointF &pos)
+{
+    auto it = mGrid.find(cellKey(pos));
+    if (it == mGrid.end())
+        return;
+
+    QVector<PointHandle> &handles = *it;
+    const int index = handles.indexOf(handle);
+    if (index != -1) {
+        handles[index] = handles.last();
+        handles.removeLast();
+    }
+
+    if (handles.isEmpty())
+        mGrid.erase(it);
+}
+
+/**
+ * Calls \a callback with the position and selection state of each handle
+ * whose position lies close enough to \a sceneRect for the handle to
+ * intersect it. When the rectangle covers
+ * more cells than there are handles, all handles are visited instead.
+ */
+template<typename Callback>
+void PointHandles::forEachHandleIn(const QRectF &sceneRect, Callback callback) const
+{
+    const QRectF area = sceneRect.adjusted(-margin(), -margin(), margin(), margin());
+
+    const int left = qFloor(area.left() / CellSize);
+    const int top = qFloor(area.top() / CellSize);
+    const int right = qFloor(area.right() / CellSize);
+    const int bottom = qFloor(area.bottom() / CellSize);
+
+    const qreal cellCount = qreal(right - left + 1) * (bottom - top + 1);
+
+    if (cellCount > mHandleCount) {
+        for (auto it = mObjects.begin(); it != mObjects.end(); ++it) {
+            const QVector<QPointF> &positions = it->positions;
+            for (int i = 0; i < positions.size(); ++i)
+                if (area.contains(positions.at(i)))
+                    callback(PointHandle(it.key(), i), positions.at(i),
+                             it->selected.at(i));
+        }
+        return;
+    }
+
+    for (int y = top; y <= bottom; ++y) {
+        for (int x = left; x <= right; ++x) {
+            const quint64 key = (quint64(quint32(x)) << 32) | quint32(y);
+            const auto cell = mGrid.find(key);
+            if (cell == mGrid.end())
+                continue;
+
+            for (const PointHandle &handle : *cell) {
+                const ObjectHandles &handles = *mObjects.find(handle.mapObject);
+                const QPointF &pos = handles.positions.at(handle.pointIndex);
+                if (area.contains(pos))
+                    callback(handle, pos, handles.selected.at(handle.pointIndex));
+            }
+        }
+    }
+}
+
+void PointHandles::includeInBounds(const QPointF &pos)
+{
+    if (mHasBounds &&
+            pos.x() >= mBounds.left() && pos.x() <= mBounds.right() &&
+            pos.y() >= mBounds.top() && pos.y() <= mBounds.bottom())
+        return;
+
+    prepareGeometryChange();
+    expandBounds(pos);
+}
+
+void PointHandles::expandBounds(const QPointF &pos)
+{
+    if (!mHasBounds) {
+        mBounds = QRectF(pos, QSizeF(0, 0));
+        mHasBounds = true;
+        return;
     }
+
+    mBounds.setLeft(qMin(mBounds.left(), pos.x()));
+    mBounds.setTop(qMin(mBounds.top(), pos.y()));
+    mBounds.setRight(qMax(mBounds.right(), pos.x()));
+    mBounds.setBottom(qMax(mBounds.bottom(), pos.y()));
+}
+
+void PointHandles::recomputeBounds()
+{
+    prepareGeometryChange();
+
+    mBounds = QRectF();
+    mHasBounds = false;
+
+    for (const ObjectHandles &handles : mObjects)
+        for (const QPointF &pos : handles.positions)
+            expandBounds(pos);
 }
 
 
@@ -132,28 +476,35 @@ EditPolygonTool::EditPolygonTool(QObject *parent)
           parent)
     , mSelectionRectangle(new SelectionRectangle)
     , mMousePressed(false)
-    , mClickedHandle(nullptr)
     , mClickedObjectItem(nullptr)
     , mMode(NoMode)
+    , mHandles(new PointHandles)
 {
 }
 
 EditPolygonTool::~EditPolygonTool()
 {
     delete mSelectionRectangle;
+    delete mHandles;
 }
 
 void EditPolygonTool::activate(MapScene *scene)
 {
     AbstractObjectTool::activate(scene);
 
+    for (QGraphicsView *view : scene->views()) {
+        if (MapView *mapView = qobject_cast<MapView*>(view)) {
+            mHandles->setViewScale(mapView->zoomable()->scale());
+            connect(mapView->zoomable(), &Zoomable::scaleChanged,
+                    this, &EditPolygonTool::viewScaleChanged);
+        }
+    }
+
+    scene->addItem(mHandles);
     updateHandles();
 
-    // TODO: Could be more optimal by separating the updating of handles from
-    // the creation and removal of handles depending on changes in the
-    // selection, and by only updating the handles of the objects that changed.
     connect(mapDocument(), SIGNAL(objectsChanged(QList<MapObject*>)),
-            this, SLOT(updateHandles()));
+            this, SLOT(objectsChanged(QList<MapObject*>)));
     connect(scene, SIGNAL(selectedObjectItemsChanged()),
             this, SLOT(updateHandles()));
 
@@ -164,18 +515,19 @@ void EditPolygonTool::activate(MapScene *scene)
 void EditPolygonTool::deactivate(MapScene *scene)
 {
     disconnect(mapDocument(), SIGNAL(objectsChanged(QList<MapObject*>)),
-               this, SLOT(updateHandles()));
+               this, SLOT(objectsChanged(QList<MapObject*>)));
     disconnect(scene, SIGNAL(selectedObjectItemsChanged()),
                this, SLOT(updateHandles()));
 
-    // Delete all handles
-    QMapIterator<MapObjectItem*, QList<PointHandle*> > i(mHandles);
-    while (i.hasNext())
-        qDeleteAll(i.next().value());
+    for (QGraphicsView *view : scene->views())
+        if (MapView *mapView = qobject_cast<MapView*>(view))
+            mapView->zoomable()->disconnect(this);
 
-    mHandles.clear();
+    // Delete all handles
+    scene->removeItem(mHandles);
+    mHandles->clear();
     mSelectedHandles.clear();
-    mClickedHandle = nullptr;
+    mClickedHandle = PointHandle();
 
     AbstractObjectTool::deactivate(scene);
 }
@@ -193,7 +545,7 @@ void EditPolygonTool::mouseMoved(const QPointF &pos,
         QPoint screenPos = QCursor::pos();
         const int dragDistance = (mScreenStart - screenPos).manhattanLength();
         if (dragDistance >= QApplication::startDragDistance()) {
-            if (mClickedHandle)
+            if (mClickedHandle.isValid())
                 startMoving();
             else
                 startSelecting();
@@ -210,24 +562,13 @@ void EditPolygonTool::mouseMoved(const QPointF &pos,
     case NoMode:
         break;
     }
-}
-
-template <class T>
-static T *first(const QList<QGraphicsItem *> &items)
-{
-    foreach (QGraphicsItem *item, items) {
-        if (T *t = qgraphicsitem_cast<T*>(item))
-            return t;
-    }
-    return nullptr;
-}
 
-static QTransform viewTransform(QGraphicsSceneMouseEvent *event)
-{
-    if (QWidget *widget = event->widget())
-        if (QGraphicsView *view = static_cast<QGraphicsView*>(widget->parent()))
-            return view->transform();
-    return QTransform();
+    const bool overHandle = mMode == Moving ||
+            (mMode == NoMode && mHandles->handleAt(pos).isValid());
+    const Qt::CursorShape cursorShape = overHandle ? Qt::SizeAllCursor
+                                                   : Qt::ArrowCursor;
+    if (cursor().shape() != cursorShape)
+        setCursor(cursorShape);
 }
 
 void EditPolygonTool::mousePressed(QGraphicsSceneMouseEvent *event)
@@ -241,23 +582,13 @@ void EditPolygonTool::mousePressed(QGraphicsSceneMouseEvent *event)
         mStart = event->scenePos();
         mScreenStart = event->screenPos();
 
-        const QList<QGraphicsItem *> items = mapScene()->items(mStart,
-                                                               Qt::IntersectsItemShape,
-                                                               Qt::DescendingOrder,
-                                                               viewTransform(event));
-
-        mClickedObjectItem = first<MapObjectItem>(items);
-        mClickedHandle = first<PointHandle>(items);
+        mClickedObjectItem = mapScene()->topMostObjectItemAt(mStart);
+        mClickedHandle = mHandles->handleAt(mStart);
         break;
     }
     case Qt::RightButton: {
-        const QList<QGraphicsItem *> items = mapScene()->items(event->scenePos(),
-                                                               Qt::IntersectsItemShape,
-                                                               Qt::DescendingOrder,
-                                                               viewTransform(event));
-
-        PointHandle *clickedHandle = first<PointHandle>(items);
-        if (clickedHandle || !mSelectedHandles.isEmpty()) {
+        const PointHandle clickedHandle = mHandles->handleAt(event->scenePos());
+        if (clickedHandle.isValid() || !mSelectedHandles.isEmpty()) {
             showHandleContextMenu(clickedHandle,
                                   event->screenPos());
         } else {
@@ -278,8 +609,8 @@ void EditPolygonTool::mouseReleased(QGraphicsSceneMouseEvent *event)
 
     switch (mMode) {
     case NoMode:
-        if (mClickedHandle) {
-            QSet<PointHandle*> selection = mSelectedHandles;
+        if (mClickedHandle.isValid()) {
+            QSet<PointHandle> selection = mSelectedHandles;
             const Qt::KeyboardModifiers modifiers = event->modifiers();
             if (modifiers & (Qt::ShiftModifier | Qt::ControlModifier)) {
                 if (selection.contains(mClickedHandle))
@@ -307,7 +638,7 @@ void EditPolygonTool::mouseReleased(QGraphicsSceneMouseEvent *event)
             updateHandles();
         } else if (!mSelectedHandles.isEmpty()) {
             // First clear the handle selection
-            setSelectedHandles(QSet<PointHandle*>());
+            setSelectedHandles(QSet<PointHandle>());
         } else {
             // If there is no handle selection, clear the object selection
             mapScene()->setSelectedObjectItems(QSet<MapObjectItem*>());
@@ -325,7 +656,7 @@ void EditPolygonTool::mouseReleased(QGraphicsSceneMouseEvent *event)
     }
 
     mMousePressed = false;
-    mClickedHandle = nullptr;
+    mClickedHandle = PointHandle();
 }
 
 void EditPolygonTool::modifiersChanged(Qt::KeyboardModifiers modifiers)
@@ -339,83 +670,117 @@ void EditPolygonTool::languageChanged()
     setShortcut(QKeySequence(tr("E")));
 }
 
-void EditPolygonTool::setSelectedHandles(const QSet<PointHandle *> &handles)
+void EditPolygonTool::setSelectedHandles(const QSet<PointHandle> &handles)
 {
-    foreach (PointHandle *handle, mSelectedHandles)
+    for (const PointHandle &handle : mSelectedHandles)
         if (!handles.contains(handle))
-            handle->setSelected(false);
+            mHandles->setHandleSelected(handle, false);
 
-    foreach (PointHandle *handle, handles)
+    for (const PointHandle &handle : handles)
         if (!mSelectedHandles.contains(handle))
-            handle->setSelected(true);
+            mHandles->setHandleSelected(handle, true);
 
     mSelectedHandles = handles;
 }
 
 /**
- * Creates and removes handle instances as necessary to adapt to a new object
- * selection.
+ * Adds and removes handles as necessary to adapt to a new object selection.
+ * The handles of objects that remain selected are left alone.
  */
 void EditPolygonTool::updateHandles()
 {
     const QSet<MapObjectItem*> &selection = mapScene()->selectedObjectItems();
 
+    QSet<MapObject*> selectedObjects;
+    for (MapObjectItem *item : selection)
+        if (item->mapObject()->cell().isEmpty())
+            selectedObjects.insert(item->mapObject());
+
     // First destroy the handles for objects that are no longer selected
-    QMutableMapIterator<MapObjectItem*, QList<PointHandle*> > i(mHandles);
-    while (i.hasNext()) {
-        i.next();
-        if (!selection.contains(i.key())) {
-            foreach (PointHandle *handle, i.value()) {
-                if (handle->isSelected())
-                    mSelectedHandles.remove(handle);
-                delete handle;
-            }
+    for (MapObject *mapObject : mHandles->mapObjects())
+        if (!selectedObjects.contains(mapObject))
+            removeObjectHandles(mapObject);
 
-            i.remove();
-        }
+    for (MapObjectItem *item : selection) {
+        MapObject *mapObject = item->mapObject();
+        if (selectedObjects.contains(mapObject) && !mHandles->contains(mapObject))
+            updateObjectHandles(item);
     }
+}
+
+/**
+ * Updates the handles of the objects that changed. While moving points,
+ * the handles of the objects being changed are already up to date.
+ */
+void EditPolygonTool::objectsChanged(const QList<MapObject *> &objects)
+{
+    for (MapObject *mapObject : objects) {
+        if (mMode == Moving && mOldPolygons.contains(mapObject))
+            continue;
+
+        if (MapObjectItem *item = mHandles->mapObjectItem(mapObject))
+            updateObjectHandles(item);
+    }
+}
 
+/**
+ * Sets the handles of the object displayed by the given \a item to the
+ * points of its polygon.
+ */
+void EditPolygonTool::updateObjectHandles(MapObjectItem *item)
+{
+    MapObject *mapObject = item->mapObject();
     MapRenderer *renderer = mapDocument()->renderer();
 
-    foreach (MapObjectItem *item, selection) {
-        const MapObject *object = item->mapObject();
-        if (!object->cell().isEmpty())
-            continue;
+    QPolygonF polygon = mapObject->polygon();
+    polygon.translate(mapObject->position());
+
+    // Deselect handles of points that no longer exist
+    if (polygon.size() < mHandles->handleCount(mapObject)) {
+        QSet<PointHandle> selection = mSelectedHandles;
+        for (const PointHandle &handle : mSelectedHandles)
+            if (handle.mapObject == mapObject && handle.pointIndex >= polygon.size())
+                selection.remove(handle);
+        mSelectedHandles = selection;
+    }
 
-        QPolygonF polygon = object->polygon();
-        polygon.translate(object->position());
+    const QPointF itemPos = item->pos();
+    const QTransform sceneTransform = item->sceneTransform();
 
-        QList<PointHandle*> pointHandles = mHandles.value(item);
+    const QPolygonF screenPolygon = renderer->pixelToScreenCoords(polygon);
 
-        // Create missing handles
-        while (pointHandles.size() < polygon.size()) {
-            PointHandle *handle = new PointHandle(item, pointHandles.size());
-            pointHandles.append(handle);
-            mapScene()->addItem(handle);
-        }
+    QVector<QPointF> positions(screenPolygon.size());
+    for (int i = 0; i < screenPolygon.size(); ++i)
+        positions[i] = sceneTransform.map(screenPolygon.at(i) - itemPos);
 
-        // Remove superfluous handles
-        while (pointHandles.size() > polygon.size()) {
-            PointHandle *handle = pointHandles.takeLast();
-            if (handle->isSelected())
-                mSelectedHandles.remove(handle);
-            delete handle;
-        }
+    mHandles->setHandles(item, positions);
+}
 
-        // Update the position of all handles
-        for (int i = 0; i < pointHandles.size(); ++i) {
-            const QPointF &point = polygon.at(i);
-            const QPointF handlePos = renderer->pixelToScreenCoords(point);
-            const QPointF internalHandlePos = handlePos - item->pos();
-            pointHandles.at(i)->setPos(item->mapToScene(internalHandlePos));
-        }
+void EditPolygonTool::removeObjectHandles(MapObject *mapObject)
+{
+    QSet<PointHandle> selection = mSelectedHandles;
+    for (const PointHandle &handle : mSelectedHandles)
+        if (handle.mapObject == mapObject)
+            selection.remove(handle);
+    mSelectedHandles = selection;
 
-        mHandles.insert(item, pointHandles);
-    }
+    mHandles->removeHandles(mapObject);
 }
 
 void EditPolygonTool::objectsRemoved(const QList<MapObject *> &objects)
 {
+    const QSet<MapObject*> removedObjects = objects.toSet();
+
+    QSet<PointHandle> selection;
+    for (const PointHandle &handle : mSelectedHandles)
+        if (!removedObjects.contains(handle.mapObject))
+            selection.insert(handle);
+    mSelectedHandles = selection;
+
+    // The items of these objects have been or are about to be deleted
+    for (MapObject *object : objects)
+        mHandles->removeHandles(object);
+
     if (mMode == Moving) {
         // Make sure we're not going to try to still change these objects when
         // finishing the move operation.
@@ -423,9 +788,21 @@ void EditPolygonTool::objectsRemoved(const QList<MapObject *> &objects)
         // disallow other actions while moving.
         foreach (MapObject *object, objects)
             mOldPolygons.remove(object);
+
+        for (int i = mMovingHandles.size() - 1; i >= 0; --i) {
+            if (removedObjects.contains(mMovingHandles.at(i).mapObject)) {
+                mMovingHandles.remove(i);
+                mOldHandlePositions.remove(i);
+            }
+        }
     }
 }
 
+void EditPolygonTool::viewScaleChanged(qreal scale)
+{
+    mHandles->setViewScale(scale);
+}
+
 void EditPolygonTool::updateSelection(QGraphicsSceneMouseEvent *event)
 {
     QRectF rect = QRectF(mStart, event->scenePos()).normalized();
@@ -440,14 +817,11 @@ void EditPolygonTool::updateSelection(QGraphicsSceneMouseEvent *event)
         // Allow selecting some map objects only when there aren't any selected
         QSet<MapObjectItem*> selectedItems;
 
-        foreach (QGraphicsItem *item, mapScene()->items(rect,
-                                                        Qt::IntersectsItemShape,
-                                                        Qt::DescendingOrder,
-                                                        viewTransform(event))) {
-            MapObjectItem *mapObjectItem = dynamic_cast<MapObjectItem*>(item);
-            if (mapObjectItem)
-                selectedItems.insert(mapObjectItem);
-        }
+        QPainterPath path;
+        path.addRect(rect);
+
+        for (MapObjectItem *mapObjectItem : mapScene()->objectItemsIntersecting(path))
+            selectedItems.insert(mapObjectItem);
 
 
         QSet<MapObjectItem*> newSelection;
@@ -462,15 +836,10 @@ void EditPolygonTool::updateSelection(QGraphicsSceneMouseEvent *event)
         updateHandles();
     } else {
         // Update the selected handles
-        QSet<PointHandle*> selectedHandles;
-
-        foreach (QGraphicsItem *item, mapScene()->items(rect,
-                                                        Qt::IntersectsItemShape,
-                                                        Qt::DescendingOrder,
-                                                        viewTransform(event))) {
-            if (PointHandle *handle = dynamic_cast<PointHandle*>(item))
-                selectedHandles.insert(handle);
-        }
+        QSet<PointHandle> selectedHandles;
+
+        for (const PointHandle &handle : mHandles->handlesIn(rect))
+            selectedHandles.insert(handle);
 
         if (event->modifiers() & (Qt::ControlModifier | Qt::ShiftModifier))
             setSelectedHandles(mSelectedHandles | selectedHandles);
@@ -496,19 +865,33 @@ void EditPolygonTool::startMoving()
     MapRenderer *renderer = mapDocument()->renderer();
 
     // Remember the current object positions
+    mMovingHandles.clear();
     mOldHandlePositions.clear();
     mOldPolygons.clear();
-    mAlignPosition = renderer->screenToPixelCoords((*mSelectedHandles.begin())->pos());
+    mMovingHandles.reserve(mSelectedHandles.size());
+    mOldHandlePositions.reserve(mSelectedHandles.size());
+
+    for (const PointHandle &handle : mSelectedHandles) {
+        mMovingHandles.append(handle);
+        mOldHandlePositions.append(mHandles->handlePosition(handle));
+    }
 
-    foreach (PointHandle *handle, mSelectedHandles) {
-        const QPointF pos = renderer->screenToPixelCoords(handle->pos());
-        mOldHandlePositions.append(handle->pos());
+    QVector<QPointF> pixelPositions(mOldHandlePositions.size());
+    renderer->screenToPixelCoords(mOldHandlePositions.constData(),
+                                  pixelPositions.data(),
+                                  pixelPositions.size());
+
+    mAlignPosition = pixelPositions.first();
+
+    for (int i = 0; i < mMovingHandles.size(); ++i) {
+        const PointHandle &handle = mMovingHandles.at(i);
+        const QPointF &pos = pixelPositions.at(i);
         if (pos.x() < mAlignPosition.x())
             mAlignPosition.setX(pos.x());
         if (pos.y() < mAlignPosition.y())
             mAlignPosition.setY(pos.y());
 
-        MapObject *mapObject = handle->mapObject();
+        MapObject *mapObject = handle.mapObject;
         if (!mOldPolygons.contains(mapObject))
             mOldPolygons.insert(mapObject, mapObject->polygon());
     }
@@ -518,40 +901,46 @@ void EditPolygonTool::updateMovingItems(const QPointF &pos,
                                         Qt::KeyboardModifiers modifiers)
 {
     MapRenderer *renderer = mapDocument()->renderer();
-    QPointF diff = pos - mStart;
-
-    SnapHelper snapHelper(renderer, modifiers);
+    const SnapHelper snapHelper(renderer, modifiers);
+    const QPointF diff = snapHelper.snapScreenOffset(mAlignPosition, pos - mStart);
 
-    if (snapHelper.snaps()) {
-        const QPointF alignScreenPos = renderer->pixelToScreenCoords(mAlignPosition);
-        const QPointF newAlignScreenPos = alignScreenPos + diff;
+    // Change each polygon only once, no matter how many of its points move
+    QHash<MapObject*, QPolygonF> newPolygons;
 
-        QPointF newAlignPixelPos = renderer->screenToPixelCoords(newAlignScreenPos);
-        snapHelper.snap(newAlignPixelPos);
+    QVector<QPointF> newPixelPositions(mMovingHandles.size());
 
-        diff = renderer->pixelToScreenCoords(newAlignPixelPos) - alignScreenPos;
-    }
+    for (int i = 0; i < mMovingHandles.size(); ++i) {
+        const PointHandle &handle = mMovingHandles.at(i);
 
-    int i = 0;
-    foreach (PointHandle *handle, mSelectedHandles) {
         // update handle position
         const QPointF newScreenPos = mOldHandlePositions.at(i) + diff;
-        handle->setPos(newScreenPos);
+        mHandles->setHandlePosition(handle, newScreenPos);
 
-        // calculate new pixel position of polygon node
-        const MapObjectItem *item = handle->mapObjectItem();
+        const MapObjectItem *item = mHandles->mapObjectItem(handle.mapObject);
         const QPointF newInternalPos = item->mapFromScene(newScreenPos);
-        const QPointF newScenePos = item->pos() + newInternalPos;
-        const QPointF newPixelPos = renderer->screenToPixelCoords(newScenePos);
+        newPixelPositions[i] = item->pos() + newInternalPos;
+    }
 
-        // update the polygon
-        MapObject *mapObject = item->mapObject();
-        QPolygonF polygon = mapObject->polygon();
-        polygon[handle->pointIndex()] = newPixelPos - mapObject->position();
-        mapDocument()->mapObjectModel()->setObjectPolygon(mapObject, polygon);
+    // calculate new pixel positions of the polygon nodes
+    renderer->screenToPixelCoords(newPixelPositions.constData(),
+                                  newPixelPositions.data(),
+                                  newPixelPositions.size());
 
-        ++i;
+    for (int i = 0; i < mMovingHandles.size(); ++i) {
+        const PointHandle &handle = mMovingHandles.at(i);
+        const QPointF &newPixelPos = newPixelPositions.at(i);
+
+        MapObject *mapObject = handle.mapObject;
+        auto it = newPolygons.find(mapObject);
+        if (it == newPolygons.end())
+            it = newPolygons.insert(mapObject, mapObject->polygon());
+
+        (*it)[handle.pointIndex] = newPixelPos - mapObject->position();
     }
+
+    // update the polygons
+    for (auto it = newPolygons.begin(); it != newPolygons.end(); ++it)
+        mapDocument()->mapObjectModel()->setObjectPolygon(it.key(), it.value());
 }
 
 void EditPolygonTool::finishMoving(const QPointF &pos)
@@ -575,14 +964,15 @@ void EditPolygonTool::finishMoving(const QPointF &pos)
 
     undoStack->endMacro();
 
+    mMovingHandles.clear();
     mOldHandlePositions.clear();
     mOldPolygons.clear();
 }
 
-void EditPolygonTool::showHandleContextMenu(PointHandle *clickedHandle,
+void EditPolygonTool::showHandleContextMenu(const PointHandle &clickedHandle,
                                             QPoint screenPos)
 {
-    if (clickedHandle && !mSelectedHandles.contains(clickedHandle))
+    if (clickedHandle.isValid() && !mSelectedHandles.contains(clickedHandle))
         setSelectedHandle(clickedHandle);
 
     const int n = mSelectedHandles.size();
@@ -611,14 +1001,14 @@ void EditPolygonTool::showHandleContextMenu(PointHandle *clickedHandle,
 
 typedef QMap<MapObject*, RangeSet<int> > PointIndexesByObject;
 static PointIndexesByObject
-groupIndexesByObject(const QSet<PointHandle*> &handles)
+groupIndexesByObject(const QSet<PointHandle> &handles)
 {
     PointIndexesByObject result;
 
     // Build the list of point indexes for each map object
-    foreach (PointHandle *handle, handles) {
-        RangeSet<int> &pointIndexes = result[handle->mapObject()];
-        pointIndexes.insert(handle->pointIndex());
+    for (const PointHandle &handle : handles) {
+        RangeSet<int> &pointIndexes = result[handle.mapObject];
+        pointIndexes.insert(handle.pointIndex);
     }
 
     return result;
@@ -23,8 +23,10 @@
 
 #include "abstractobjecttool.h"
 
+#include <QHash>
 #include <QMap>
 #include <QSet>
+#include <QVector>
 
 class QGraphicsItem;
 
@@ -32,9 +34,38 @@ namespace Tiled {
 namespace Internal {
 
 class MapObjectItem;
-class PointHandle;
+class PointHandles;
 class SelectionRectangle;
 
+/**
+ * Identifies a point of the polygon of a map object.
+ */
+struct PointHandle
+{
+    PointHandle()
+        : mapObject(nullptr)
+        , pointIndex(-1)
+    {}
+
+    PointHandle(MapObject *mapObject, int pointIndex)
+        : mapObject(mapObject)
+        , pointIndex(pointIndex)
+    {}
+
+    bool isValid() const { return mapObject != nullptr; }
+
+    bool operator==(const PointHandle &other) const
+    { return mapObject == other.mapObject && pointIndex == other.pointIndex; }
+
+    MapObject *mapObject;
+    int pointIndex;
+};
+
+inline uint qHash(const PointHandle &handle, uint seed = 0)
+{
+    return qHash(handle.mapObject, seed) ^ qHash(handle.pointIndex, seed);
+}
+
 /**
  * A tool that allows dragging around the points of a polygon.
  */
@@ -60,7 +91,9 @@ public:
 
 private slots:
     void updateHandles();
+    void objectsChanged(const QList<MapObject *> &objects);
     void objectsRemoved(const QList<MapObject *> &objects);
+    void viewScaleChanged(qreal scale);
 
     void deleteNodes();
     void joinNodes();
@@ -73,9 +106,12 @@ private:
         Moving
     };
 
-    void setSelectedHandles(const QSet<PointHandle*> &handles);
-    void setSelectedHandle(PointHandle *handle)
-    { setSelectedHandles(QSet<PointHandle*>() << handle); }
+    void setSelectedHandles(const QSet<PointHandle> &handles);
+    void setSelectedHandle(const PointHandle &handle)
+    { setSelectedHandles(QSet<PointHandle>() << handle); }
+
+    void updateObjectHandles(MapObjectItem *item);
+    void removeObjectHandles(MapObject *mapObject);
 
     void updateSelection(QGraphicsSceneMouseEvent *event);
 
@@ -86,12 +122,14 @@ private:
                            Qt::KeyboardModifiers modifiers);
     void finishMoving(const QPointF &pos);
 
-    void showHandleContextMenu(PointHandle *clickedHandle, QPoint screenPos);
+    void showHandleContextMenu(const PointHandle &clickedHandle,
+                               QPoint screenPos);
 
     SelectionRectangle *mSelectionRectangle;
     bool mMousePressed;
-    PointHandle *mClickedHandle;
+    PointHandle mClickedHandle;
     MapObjectItem *mClickedObjectItem;
+    QVector<PointHandle> mMovingHandles;
     QVector<QPointF> mOldHandlePositions;
     QMap<MapObject*, QPolygonF> mOldPolygons;
     QPointF mAlignPosition;
@@ -100,9 +138,9 @@ private:
     QPoint mScreenStart;
     Qt::KeyboardModifiers mModifiers;
 
-    /// The list of handles associated with each selected map object
-    QMap<MapObjectItem*, QList<PointHandle*> > mHandles;
-    QSet<PointHandle*> mSelectedHandles;
+    /// Displays the handles of the points of all selected map objects
+    PointHandles *mHandles;
+    QSet<PointHandle> mSelectedHandles;
 };
 
 } // namespace Internal
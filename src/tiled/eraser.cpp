@@ -84,7 +84,8 @@ void Eraser::doErase(bool continuation)
     }
     mLastTilePos = tilePosition();
 
-    if (!tileLayer->bounds().intersects(eraseRegion.boundingRect()))
+    if (!tileLayer->isInfinite() &&
+            !tileLayer->bounds().intersects(eraseRegion.boundingRect()))
         return;
 
     EraseTiles *erase = new EraseTiles(mapDocument(), tileLayer, eraseRegion);
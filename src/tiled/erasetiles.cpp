@@ -38,9 +38,12 @@ EraseTiles::EraseTiles(MapDocument *mapDocument,
 {
     setText(QCoreApplication::translate("Undo Commands", "Erase"));
 
-    // Store the tiles that are to be erased
+    // Store the tiles that are to be erased. The copy only allocates chunks
+    // where there are cells, and only the cells that are actually erased
+    // need to be touched when undoing and redoing.
     const QRegion r = mRegion.translated(-mTileLayer->x(), -mTileLayer->y());
     mErasedCells = mTileLayer->copy(r);
+    mErasedRegion = mErasedCells->region().translated(mRegion.boundingRect().topLeft());
 }
 
 EraseTiles::~EraseTiles()
@@ -50,15 +53,20 @@ EraseTiles::~EraseTiles()
 
 void EraseTiles::undo()
 {
+    if (mErasedRegion.isEmpty())
+        return;
+
+    mCompressedCells.decompress(mErasedCells);
+
     const QRect bounds = mRegion.boundingRect();
     TilePainter painter(mMapDocument, mTileLayer);
-    painter.drawCells(bounds.x(), bounds.y(), mErasedCells);
+    painter.setCells(bounds.x(), bounds.y(), mErasedCells, mErasedRegion);
 }
 
 void EraseTiles::redo()
 {
     TilePainter painter(mMapDocument, mTileLayer);
-    painter.erase(mRegion);
+    painter.erase(mErasedRegion);
 }
 
 bool EraseTiles::mergeWith(const QUndoCommand *other)
@@ -69,6 +77,8 @@ bool EraseTiles::mergeWith(const QUndoCommand *other)
           o->mMergeable))
         return false;
 
+    mCompressedCells.decompress(mErasedCells);
+
     const QRegion combinedRegion = mRegion.united(o->mRegion);
     if (mRegion != combinedRegion) {
         const QRect bounds = mRegion.boundingRect();
@@ -86,7 +96,18 @@ bool EraseTiles::mergeWith(const QUndoCommand *other)
         mErasedCells->merge(pos, o->mErasedCells);
 
         mRegion = combinedRegion;
+        mErasedRegion |= o->mErasedRegion;
     }
 
     return true;
 }
+
+qint64 EraseTiles::memoryUsage() const
+{
+    return Internal::memoryUsage(mErasedCells) + mCompressedCells.memoryUsage();
+}
+
+void EraseTiles::compress()
+{
+    mCompressedCells.compress(mErasedCells);
+}
@@ -22,6 +22,7 @@
 #define ERASETILES_H
 
 #include "undocommands.h"
+#include "undomemory.h"
 
 #include <QRegion>
 #include <QUndoCommand>
@@ -35,7 +36,7 @@ namespace Internal {
 
 class MapDocument;
 
-class EraseTiles : public QUndoCommand
+class EraseTiles : public QUndoCommand, public UndoCommandMemory
 {
 public:
     EraseTiles(MapDocument *mapDocument,
@@ -55,11 +56,16 @@ public:
     int id() const override { return Cmd_EraseTiles; }
     bool mergeWith(const QUndoCommand *other) override;
 
+    qint64 memoryUsage() const override;
+    void compress() override;
+
 private:
     MapDocument *mMapDocument;
     TileLayer *mTileLayer;
     TileLayer *mErasedCells;
+    CompressedCells mCompressedCells;
     QRegion mRegion;
+    QRegion mErasedRegion;  // the cells that were not empty
     bool mMergeable;
 };
 
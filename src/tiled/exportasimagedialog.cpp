@@ -23,18 +23,18 @@
 
 #include "map.h"
 #include "mapdocument.h"
-#include "mapobject.h"
-#include "mapobjectitem.h"
+#include "mapimageexporter.h"
 #include "maprenderer.h"
-#include "imagelayer.h"
-#include "objectgroup.h"
+#include "openglrasterizer.h"
 #include "preferences.h"
-#include "tilelayer.h"
+#include "tilesetmanager.h"
 #include "utils.h"
 
+#include <QDir>
+#include <QEventLoop>
 #include <QFileDialog>
 #include <QMessageBox>
-#include <QImageWriter>
+#include <QProgressDialog>
 #include <QSettings>
 
 static const char * const VISIBLE_ONLY_KEY = "SaveAsImage/VisibleLayersOnly";
@@ -114,11 +114,6 @@ ExportAsImageDialog::~ExportAsImageDialog()
     delete mUi;
 }
 
-static bool objectLessThan(const MapObject *a, const MapObject *b)
-{
-    return a->y() < b->y();
-}
-
 static bool smoothTransform(qreal scale)
 {
     return scale != qreal(1) && scale < qreal(2);
@@ -151,10 +146,11 @@ void ExportAsImageDialog::accept()
 
     MapRenderer *renderer = mMapDocument->renderer();
 
-    // Remember the current render flags
-    const Tiled::RenderFlags renderFlags = renderer->flags();
+    const Tiled::RenderFlags renderFlags =
+            renderer->flags() & ~Tiled::RenderFlags(ShowTileObjectOutlines | LevelOfDetail);
 
-    renderer->setFlag(ShowTileObjectOutlines, false);
+    // Tileset images unloaded to save memory would otherwise be missing
+    TilesetManager::instance()->loadTilesetImages(mMapDocument->map()->tilesets());
 
     QSize mapSize = renderer->mapSize();
 
@@ -165,120 +161,163 @@ void ExportAsImageDialog::accept()
     if (useCurrentScale)
         mapSize *= mCurrentScale;
 
+    QTransform transform;
+    QPainter::RenderHints renderHints;
+    qreal painterScale = 1;
+
+    if (useCurrentScale) {
+        if (smoothTransform(mCurrentScale))
+            renderHints = QPainter::SmoothPixmapTransform;
+
+        transform.scale(mCurrentScale, mCurrentScale);
+        painterScale = mCurrentScale;
+    }
+
+    transform.translate(margins.left(), margins.top());
+
+    QColor backgroundColor = Qt::transparent;
+    if (includeBackgroundColor) {
+        if (mMapDocument->map()->backgroundColor().isValid())
+            backgroundColor = mMapDocument->map()->backgroundColor();
+        else
+            backgroundColor = Qt::gray;
+    }
+
+    const bool isPng = QFileInfo(fileName).suffix().compare(QLatin1String("png"),
+                                                            Qt::CaseInsensitive) == 0;
+
+    MapImageExporter exporter(mMapDocument->map(), fileName);
+    exporter.setImageSize(mapSize);
+    exporter.setTransform(transform);
+    exporter.setRenderHints(renderHints);
+    exporter.setRenderFlags(renderFlags);
+    exporter.setPainterScale(painterScale);
+    exporter.setBackgroundColor(backgroundColor);
+    exporter.setVisibleLayersOnly(visibleLayersOnly);
+    if (drawTileGrid)
+        exporter.setGridColor(Preferences::instance()->gridColor());
+
+#ifndef QT_NO_OPENGL
+    // Render on the GPU when it is also used for the map view. The surface
+    // needs to be created here, since the export runs on another thread.
+    QScopedPointer<OpenGLRasterizer> openGLRasterizer;
+    if (Preferences::instance()->useOpenGL()) {
+        openGLRasterizer.reset(new OpenGLRasterizer);
+        exporter.setOpenGLRasterizer(openGLRasterizer.data());
+    }
+#endif
+
+    // PNG images are written while they are rendered, so the complete image
+    // doesn't need to fit in memory
+    if (!isPng) {
+        const QImage image = allocateImage(mapSize);
+        if (image.isNull())
+            return;
+
+        exporter.setImage(image);
+    }
+
+    if (!runExport(exporter))
+        return;
+
+    mPath = QFileInfo(fileName).path();
+
+    // Store settings for next time
+    QSettings *s = Preferences::instance()->settings();
+    s->setValue(QLatin1String(VISIBLE_ONLY_KEY), visibleLayersOnly);
+    s->setValue(QLatin1String(CURRENT_SCALE_KEY), useCurrentScale);
+    s->setValue(QLatin1String(DRAW_GRID_KEY), drawTileGrid);
+    s->setValue(QLatin1String(INCLUDE_BACKGROUND_COLOR), includeBackgroundColor);
+
+    QDialog::accept();
+}
+
+/**
+ * Allocates an image of the given \a size. Returns a null image and shows
+ * an error when that is not possible.
+ */
+QImage ExportAsImageDialog::allocateImage(const QSize &size)
+{
     QImage image;
 
     try {
-        image = QImage(mapSize, QImage::Format_ARGB32_Premultiplied);
-
-        if (includeBackgroundColor) {
-            if (mMapDocument->map()->backgroundColor().isValid())
-                image.fill(mMapDocument->map()->backgroundColor());
-            else
-                image.fill(Qt::gray);
-        } else {
-            image.fill(Qt::transparent);
-        }
+        image = QImage(size, QImage::Format_ARGB32_Premultiplied);
     } catch (const std::bad_alloc &) {
         QMessageBox::critical(this,
                               tr("Out of Memory"),
                               tr("Could not allocate sufficient memory for the image. "
                                  "Try reducing the zoom level or using a 64-bit version of Tiled."));
-        return;
+        return QImage();
     }
 
     if (image.isNull()) {
         const size_t gigabyte = 1073741824;
-        const size_t memory = size_t(mapSize.width()) * size_t(mapSize.height()) * 4;
+        const size_t memory = size_t(size.width()) * size_t(size.height()) * 4;
         const double gigabytes = (double) memory / gigabyte;
 
         QMessageBox::critical(this,
                               tr("Image too Big"),
                               tr("The resulting image would be %1 x %2 pixels and take %3 GB of memory. "
                                  "Tiled is unable to create such an image. Try reducing the zoom level.")
-                              .arg(mapSize.width())
-                              .arg(mapSize.height())
+                              .arg(size.width())
+                              .arg(size.height())
                               .arg(gigabytes, 0, 'f', 2));
-        return;
     }
 
-    QPainter painter(&image);
+    return image;
+}
 
-    if (useCurrentScale) {
-        if (smoothTransform(mCurrentScale))
-            painter.setRenderHints(QPainter::SmoothPixmapTransform);
+/**
+ * Runs the \a exporter while showing its progress. The tileset images are
+ * kept from changing while they are drawn on other threads. Returns whether
+ * the image was exported.
+ */
+bool ExportAsImageDialog::runExport(MapImageExporter &exporter)
+{
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    tilesetManager->setReloadTilesetsOnChange(false);
+    tilesetManager->setAnimateTiles(false);
+    tilesetManager->setImageCacheLimit(0);
 
-        painter.setTransform(QTransform::fromScale(mCurrentScale,
-                                                   mCurrentScale));
-        renderer->setPainterScale(mCurrentScale);
-    } else {
-        renderer->setPainterScale(1);
-    }
+    exporter.prepareImages();
 
-    painter.translate(margins.left(), margins.top());
-
-    foreach (const Layer *layer, mMapDocument->map()->layers()) {
-        if (visibleLayersOnly && !layer->isVisible())
-            continue;
-
-        painter.setOpacity(layer->opacity());
-        painter.translate(layer->offset());
-
-        const TileLayer *tileLayer = dynamic_cast<const TileLayer*>(layer);
-        const ObjectGroup *objGroup = dynamic_cast<const ObjectGroup*>(layer);
-        const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
-
-        if (tileLayer) {
-            renderer->drawTileLayer(&painter, tileLayer);
-        } else if (objGroup) {
-            QList<MapObject*> objects = objGroup->objects();
-
-            if (objGroup->drawOrder() == ObjectGroup::TopDownOrder)
-                qStableSort(objects.begin(), objects.end(), objectLessThan);
-
-            foreach (const MapObject *object, objects) {
-                if (object->isVisible()) {
-                    if (object->rotation() != qreal(0)) {
-                        QPointF origin = renderer->pixelToScreenCoords(object->position());
-                        painter.save();
-                        painter.translate(origin);
-                        painter.rotate(object->rotation());
-                        painter.translate(-origin);
-                    }
-
-                    const QColor color = MapObjectItem::objectColor(object);
-                    renderer->drawMapObject(&painter, object, color);
-
-                    if (object->rotation() != qreal(0))
-                        painter.restore();
-                }
-            }
-        } else if (imageLayer) {
-            renderer->drawImageLayer(&painter, imageLayer);
-        }
-
-        painter.translate(-layer->offset());
-    }
+    QProgressDialog progress(tr("Exporting map as image..."), tr("Cancel"),
+                             0, exporter.imageSize().height(), this);
+    progress.setWindowTitle(tr("Export as Image"));
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
 
-    if (drawTileGrid) {
-        Preferences *prefs = Preferences::instance();
-        renderer->drawGrid(&painter, QRectF(QPointF(), renderer->mapSize()),
-                           prefs->gridColor());
-    }
+    connect(&exporter, &MapImageExporter::progressChanged,
+            &progress, &QProgressDialog::setValue);
+    connect(&progress, &QProgressDialog::canceled,
+            &exporter, &MapImageExporter::cancel, Qt::DirectConnection);
 
-    // Restore the previous render flags
-    renderer->setFlags(renderFlags);
+    QEventLoop loop;
+    connect(&exporter, &QThread::finished, &loop, &QEventLoop::quit);
 
-    image.save(fileName);
-    mPath = QFileInfo(fileName).path();
+    exporter.start();
+    loop.exec();
 
-    // Store settings for next time
-    QSettings *s = Preferences::instance()->settings();
-    s->setValue(QLatin1String(VISIBLE_ONLY_KEY), visibleLayersOnly);
-    s->setValue(QLatin1String(CURRENT_SCALE_KEY), useCurrentScale);
-    s->setValue(QLatin1String(DRAW_GRID_KEY), drawTileGrid);
-    s->setValue(QLatin1String(INCLUDE_BACKGROUND_COLOR), includeBackgroundColor);
+    progress.reset();
 
-    QDialog::accept();
+    Preferences *prefs = Preferences::instance();
+    tilesetManager->setReloadTilesetsOnChange(prefs->reloadTilesetsOnChange());
+    tilesetManager->setAnimateTiles(prefs->showTileAnimations());
+    tilesetManager->setImageCacheLimit(qint64(prefs->tileImageCacheLimit()) * 1024 * 1024);
+
+    if (exporter.wasCanceled())
+        return false;
+
+    if (!exporter.succeeded()) {
+        QMessageBox::critical(this,
+                              tr("Error Exporting Image"),
+                              tr("Error while writing %1:\n%2")
+                              .arg(QDir::toNativeSeparators(exporter.fileName()),
+                                   exporter.errorString()));
+        return false;
+    }
+
+    return true;
 }
 
 void ExportAsImageDialog::browse()
@@ -22,6 +22,7 @@
 #define SAVEASIMAGEDIALOG_H
 
 #include <QDialog>
+#include <QPainter>
 
 namespace Ui {
 class ExportAsImageDialog;
@@ -31,6 +32,7 @@ namespace Tiled {
 namespace Internal {
 
 class MapDocument;
+class MapImageExporter;
 
 /**
  * The dialog for exporting a map as an image.
@@ -59,6 +61,9 @@ private slots:
     void updateAcceptEnabled();
 
 private:
+    QImage allocateImage(const QSize &size);
+    bool runExport(MapImageExporter &exporter);
+
     Ui::ExportAsImageDialog *mUi;
     MapDocument *mMapDocument;
     qreal mCurrentScale;
@@ -20,21 +20,44 @@
 
 #include "filesystemwatcher.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QFileSystemWatcher>
-#include <QStringList>
 
 using namespace Tiled::Internal;
 
+static QByteArray contentHash(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(&file);
+    return hash.result();
+}
+
 FileSystemWatcher::FileSystemWatcher(QObject *parent) :
     QObject(parent),
-    mWatcher(new QFileSystemWatcher(this))
+    mWatcher(new QFileSystemWatcher(this)),
+    mCompareContents(false)
 {
-    connect(mWatcher, SIGNAL(fileChanged(QString)),
-            SLOT(onFileChanged(QString)));
     connect(mWatcher, SIGNAL(directoryChanged(QString)),
             SLOT(onDirectoryChanged(QString)));
+
+    /*
+     * Use a one-shot timer since GIMP (for example) seems to generate many
+     * file changes during a save, and applications regenerating many files
+     * change them one after the other.
+     */
+    mChangedFilesTimer.setInterval(500);
+    mChangedFilesTimer.setSingleShot(true);
+
+    connect(&mChangedFilesTimer, SIGNAL(timeout()),
+            SLOT(changedFilesTimeout()));
 }
 
 void FileSystemWatcher::addPath(const QString &path)
@@ -43,47 +66,123 @@ void FileSystemWatcher::addPath(const QString &path)
     if (!QFile::exists(path))
         return;
 
-    QMap<QString, int>::iterator entry = mWatchCount.find(path);
-    if (entry == mWatchCount.end()) {
-        mWatcher->addPath(path);
-        mWatchCount.insert(path, 1);
-    } else {
+    QHash<QString, WatchedFile>::iterator entry = mWatchedFiles.find(path);
+    if (entry != mWatchedFiles.end()) {
         // Path is already being watched, increment watch count
-        ++entry.value();
+        ++entry.value().watchCount;
+        return;
     }
+
+    const QFileInfo info(path);
+
+    WatchedFile file;
+    file.watchCount = 1;
+    file.isDirectory = info.isDir();
+    file.directory = file.isDirectory ? path : info.absolutePath();
+    file.lastModified = info.lastModified();
+    file.size = info.size();
+    if (mCompareContents && !file.isDirectory)
+        file.contentHash = contentHash(path);
+
+    mWatchedFiles.insert(path, file);
+    if (!file.isDirectory)
+        mFilesByDirectory.insert(file.directory, path);
+
+    watchDirectory(file.directory);
 }
 
 void FileSystemWatcher::removePath(const QString &path)
 {
-    QMap<QString, int>::iterator entry = mWatchCount.find(path);
-    if (entry == mWatchCount.end()) {
+    QHash<QString, WatchedFile>::iterator entry = mWatchedFiles.find(path);
+    if (entry == mWatchedFiles.end()) {
         if (QFile::exists(path))
             qWarning() << "FileSystemWatcher: Path was never added:" << path;
         return;
     }
 
     // Decrement watch count
-    --entry.value();
+    --entry.value().watchCount;
+
+    if (entry.value().watchCount == 0) {
+        const QString directory = entry.value().directory;
+
+        mWatchedFiles.erase(entry);
+        mFilesByDirectory.remove(directory, path);
+        mChangedFiles.remove(path);
 
-    if (entry.value() == 0) {
-        mWatchCount.erase(entry);
-        mWatcher->removePath(path);
+        unwatchDirectory(directory);
     }
 }
 
-void FileSystemWatcher::onFileChanged(const QString &path)
+void FileSystemWatcher::watchDirectory(const QString &directory)
 {
-    // If the file was replaced, the watcher is automatically removed and needs
-    // to be re-added to keep watching it for changes. This happens commonly
-    // with applications that do atomic saving.
-    if (!mWatcher->files().contains(path))
-        if (QFile::exists(path))
+    int &count = mDirectoryWatchCount[directory];
+    if (count++ == 0)
+        mWatcher->addPath(directory);
+}
+
+void FileSystemWatcher::unwatchDirectory(const QString &directory)
+{
+    QHash<QString, int>::iterator entry = mDirectoryWatchCount.find(directory);
+    Q_ASSERT(entry != mDirectoryWatchCount.end());
+
+    if (--entry.value() == 0) {
+        mDirectoryWatchCount.erase(entry);
+        mWatcher->removePath(directory);
+    }
+}
+
+void FileSystemWatcher::onDirectoryChanged(const QString &path)
+{
+    // If the directory was replaced, the watcher is automatically removed
+    // and needs to be re-added to keep watching it for changes.
+    if (!mWatcher->directories().contains(path))
+        if (QDir(path).exists())
             mWatcher->addPath(path);
 
+    const QHash<QString, WatchedFile>::const_iterator entry = mWatchedFiles.constFind(path);
+    if (entry != mWatchedFiles.constEnd() && entry.value().isDirectory)
+        emit directoryChanged(path);
+
+    for (const QString &fileName : mFilesByDirectory.values(path))
+        checkFile(fileName);
+}
+
+/**
+ * Reports the file at \a path as changed when its modification time, size
+ * or contents have changed since it was last checked.
+ */
+void FileSystemWatcher::checkFile(const QString &path)
+{
+    WatchedFile &file = mWatchedFiles[path];
+    const QFileInfo info(path);
+
+    const QDateTime lastModified = info.lastModified();
+    const qint64 size = info.size();
+    if (lastModified == file.lastModified && size == file.size)
+        return;
+
+    file.lastModified = lastModified;
+    file.size = size;
+
+    if (mCompareContents && info.exists()) {
+        const QByteArray hash = contentHash(path);
+        if (hash == file.contentHash)
+            return;
+
+        file.contentHash = hash;
+    }
+
     emit fileChanged(path);
+
+    mChangedFiles.insert(path);
+    mChangedFilesTimer.start();
 }
 
-void FileSystemWatcher::onDirectoryChanged(const QString &path)
+void FileSystemWatcher::changedFilesTimeout()
 {
-    emit directoryChanged(path);
+    const QStringList paths = mChangedFiles.toList();
+    mChangedFiles.clear();
+
+    emit filesChanged(paths);
 }
@@ -21,8 +21,13 @@
 #ifndef FILESYSTEMWATCHER_H
 #define FILESYSTEMWATCHER_H
 
-#include <QMap>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
 #include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
 
 class QFileSystemWatcher;
 
@@ -34,6 +39,11 @@ namespace Internal {
  * watched multiple times. It also doesn't start complaining when a file
  * doesn't exist.
  *
+ * Files are watched through their directory, so that watching many files in
+ * the same directory only takes a single watch. Changes are detected by
+ * comparing the modification time and size of the watched files, and
+ * optionally the hash of their contents.
+ *
  * It's meant to be used as drop-in replacement for QFileSystemWatcher.
  */
 class FileSystemWatcher : public QObject
@@ -46,17 +56,49 @@ public:
     void addPath(const QString &path);
     void removePath(const QString &path);
 
+    /**
+     * Sets whether the contents of changed files are compared to their
+     * previous contents, so that files rewritten without changes are not
+     * reported. Only applies to files added afterwards.
+     */
+    void setCompareContents(bool enabled) { mCompareContents = enabled; }
+
 signals:
     void fileChanged(const QString &path);
     void directoryChanged(const QString &path);
 
+    /**
+     * Emitted once no more files have changed for a while, with all the
+     * files that changed since the last time it was emitted.
+     */
+    void filesChanged(const QStringList &paths);
+
 private slots:
-    void onFileChanged(const QString &path);
     void onDirectoryChanged(const QString &path);
+    void changedFilesTimeout();
 
 private:
+    struct WatchedFile {
+        int watchCount;
+        bool isDirectory;
+        QString directory;
+        QDateTime lastModified;
+        qint64 size;
+        QByteArray contentHash;
+    };
+
+    void watchDirectory(const QString &directory);
+    void unwatchDirectory(const QString &directory);
+    void checkFile(const QString &path);
+
     QFileSystemWatcher *mWatcher;
-    QMap<QString, int> mWatchCount;
+    QHash<QString, WatchedFile> mWatchedFiles;
+    QMultiHash<QString, QString> mFilesByDirectory;
+    QHash<QString, int> mDirectoryWatchCount;
+    bool mCompareContents;
+
+    QSet<QString> mChangedFiles;
+    QTimer mChangedFilesTimer;
 };
 
 } // namespace Internal
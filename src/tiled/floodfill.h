@@ -0,0 +1,114 @@
+/*
+ * floodfill.h
+ * Copyright 2009-2011, Thorbjørn Lindeijer <thorbjorn@lindeijer.nl>
+ * Copyright 2009, Jeff Bland <jksb@member.fsf.org>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILED_INTERNAL_FLOODFILL_H
+#define TILED_INTERNAL_FLOODFILL_H
+
+#include "tilemask.h"
+
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * Returns the mask of the positions within \a bounds that are connected to
+ * \a origin through positions for which \a matches returns true. Returns
+ * an empty mask early when \a canceled gets set.
+ */
+template<typename Matches>
+TileMask floodFill(const QRect &bounds, const QPoint &origin, Matches matches,
+                   const QAtomicInt *canceled = nullptr)
+{
+    const int left = bounds.left();
+    const int top = bounds.top();
+    const int width = bounds.width();
+
+    // Marks the cells that have been filled. This is faster than checking
+    // whether a given cell is in the list of spans.
+    QBitArray filledCells(width * bounds.height());
+
+    auto fillable = [&] (int x, int y) {
+        return !filledCells.testBit((y - top) * width + (x - left)) &&
+                matches(x, y);
+    };
+
+    TileMask mask;
+
+    // Stack of positions from which to start filling a span
+    QVector<QPoint> fillPositions;
+    fillPositions.append(origin);
+
+    while (!fillPositions.isEmpty()) {
+        if (canceled && canceled->load())
+            return TileMask();
+
+        const QPoint currentPoint = fillPositions.last();
+        fillPositions.removeLast();
+
+        const int y = currentPoint.y();
+
+        // Positions may have been filled since they were pushed
+        if (!fillable(currentPoint.x(), y))
+            continue;
+
+        // Seek as far left and right as we can
+        int spanLeft = currentPoint.x();
+        while (spanLeft > left && fillable(spanLeft - 1, y))
+            --spanLeft;
+
+        int spanRight = currentPoint.x();
+        while (spanRight < bounds.right() && fillable(spanRight + 1, y))
+            ++spanRight;
+
+        const int rowStart = (y - top) * width - left;
+        filledCells.fill(true, rowStart + spanLeft, rowStart + spanRight + 1);
+        mask.setSpan(spanLeft, y, spanRight - spanLeft + 1);
+
+        // Push one position for each run of matching cells in the rows
+        // directly above and below the span
+        auto pushRow = [&] (int row) {
+            bool inRun = false;
+            for (int x = spanLeft; x <= spanRight; ++x) {
+                const bool match = fillable(x, row);
+                if (match && !inRun)
+                    fillPositions.append(QPoint(x, row));
+                inRun = match;
+            }
+        };
+
+        if (y > top)
+            pushRow(y - 1);
+        if (y < bounds.bottom())
+            pushRow(y + 1);
+    }
+
+    return mask;
+}
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // TILED_INTERNAL_FLOODFILL_H
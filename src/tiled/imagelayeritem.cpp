@@ -24,6 +24,7 @@
 #include "imagelayer.h"
 #include "mapdocument.h"
 #include "maprenderer.h"
+#include "renderprofiler.h"
 
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
@@ -56,6 +57,8 @@ void ImageLayerItem::paint(QPainter *painter,
                            const QStyleOptionGraphicsItem *option,
                            QWidget *)
 {
+    RenderProfiler::ItemTimer timer(mLayer);
+
     // TODO: Display a border around the layer when selected
     MapRenderer *renderer = mMapDocument->renderer();
     renderer->drawImageLayer(painter, mLayer, option->exposedRect);
@@ -0,0 +1,91 @@
+/*
+ * layercompositeitem.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "layercompositeitem.h"
+
+#include "mapdocument.h"
+#include "maprenderer.h"
+#include "tilelayer.h"
+#include "tilelayeritem.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+LayerCompositeItem::LayerCompositeItem(const QVector<TileLayerItem*> &layerItems,
+                                       MapDocument *mapDocument)
+    : mLayerItems(layerItems)
+    , mMapDocument(mapDocument)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+
+    for (TileLayerItem *item : mLayerItems) {
+        item->setFlag(QGraphicsItem::ItemHasNoContents, true);
+        mBoundingRect |= item->mapRectToScene(item->boundingRect());
+    }
+
+    // Drawn in place of the top-most layer
+    setZValue(mLayerItems.last()->zValue());
+}
+
+LayerCompositeItem::~LayerCompositeItem()
+{
+    for (TileLayerItem *item : mLayerItems)
+        item->setFlag(QGraphicsItem::ItemHasNoContents, false);
+}
+
+QRectF LayerCompositeItem::boundingRect() const
+{
+    return mBoundingRect;
+}
+
+void LayerCompositeItem::paint(QPainter *painter,
+                               const QStyleOptionGraphicsItem *option,
+                               QWidget *)
+{
+    mRenderCache.draw(painter,
+                      [this] (QPainter *painter, const QRectF &rect) {
+                          render(painter, rect);
+                      },
+                      option->exposedRect & mBoundingRect);
+}
+
+/**
+ * Draws the visible layers within \a rect, with the opacity and offset of
+ * their items.
+ */
+void LayerCompositeItem::render(QPainter *painter, const QRectF &rect) const
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+
+    for (const TileLayerItem *item : mLayerItems) {
+        if (!item->isVisible())
+            continue;
+
+        painter->save();
+        painter->setOpacity(painter->opacity() * item->opacity());
+        painter->translate(item->pos());
+        renderer->drawTileLayer(painter, item->tileLayer(),
+                                rect.translated(-item->pos()));
+        painter->restore();
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * layercompositeitem.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAYERCOMPOSITEITEM_H
+#define LAYERCOMPOSITEITEM_H
+
+#include "tilelayerrendercache.h"
+
+#include <QGraphicsItem>
+#include <QVector>
+
+namespace Tiled {
+namespace Internal {
+
+class MapDocument;
+class TileLayerItem;
+
+/**
+ * A graphics item drawing a consecutive range of tile layer items, which
+ * are composited into cached chunks.
+ *
+ * This is used for the layers that are not being edited while the current
+ * layer is highlighted. Repaints caused by changes to the current layer then
+ * only need to draw a single cached pixmap for each such range, instead of
+ * each of its layers.
+ *
+ * While composited, the tile layer items are marked as having no contents.
+ * The cache is not invalidated by itself, so this item is expected to be
+ * recreated when any of its layers changes.
+ */
+class LayerCompositeItem : public QGraphicsItem
+{
+public:
+    LayerCompositeItem(const QVector<TileLayerItem*> &layerItems,
+                       MapDocument *mapDocument);
+    ~LayerCompositeItem();
+
+    const QVector<TileLayerItem*> &layerItems() const;
+
+    // QGraphicsItem
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private:
+    void render(QPainter *painter, const QRectF &rect) const;
+
+    QVector<TileLayerItem*> mLayerItems;
+    MapDocument *mMapDocument;
+    QRectF mBoundingRect;
+    TileLayerRenderCache mRenderCache;
+};
+
+inline const QVector<TileLayerItem*> &LayerCompositeItem::layerItems() const
+{
+    return mLayerItems;
+}
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // LAYERCOMPOSITEITEM_H
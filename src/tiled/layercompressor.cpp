@@ -0,0 +1,237 @@
+/*
+ * layercompressor.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "layercompressor.h"
+
+#include "map.h"
+#include "mapdocument.h"
+#include "preferences.h"
+#include "tilelayer.h"
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QThread>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * The state shared between the layer compressor and the worker compressing
+ * the cells of a layer. The chunks are a copy, so they can be read while the
+ * layer is being edited.
+ */
+struct CompressRequest
+{
+    CompressRequest()
+        : tileLayer(nullptr)
+        , generation(0)
+        , finished(0)
+        , canceled(0)
+    {}
+
+    TileLayer *tileLayer;
+    ChunkHash chunks;
+    unsigned generation;
+    TileLayer::CompressedChunks compressed;
+    QAtomicInt finished;
+    QAtomicInt canceled;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+namespace {
+
+class CompressTask : public QRunnable
+{
+public:
+    CompressTask(QObject *receiver, const QSharedPointer<CompressRequest> &request)
+        : mReceiver(receiver)
+        , mRequest(request)
+    {}
+
+    void run() override
+    {
+        QThread::currentThread()->setPriority(QThread::IdlePriority);
+
+        if (mRequest->canceled.loadAcquire())
+            return;
+
+        mRequest->compressed = TileLayer::compressChunks(mRequest->chunks);
+        mRequest->chunks = ChunkHash();
+        mRequest->finished.storeRelease(1);
+
+        // The receiver outlives the thread pool, which runs this task
+        if (!mRequest->canceled.loadAcquire())
+            QMetaObject::invokeMethod(mReceiver, "chunksCompressed", Qt::QueuedConnection);
+    }
+
+private:
+    QObject *mReceiver;
+    QSharedPointer<CompressRequest> mRequest;
+};
+
+} // anonymous namespace
+
+LayerCompressor::LayerCompressor(MapDocument *mapDocument)
+    : QObject(mapDocument)
+    , mMapDocument(mapDocument)
+{
+    mIdleTimer.setSingleShot(true);
+    mIdleTimer.setInterval(2000);
+
+    connect(&mIdleTimer, &QTimer::timeout,
+            this, &LayerCompressor::compressHiddenLayers);
+
+    // Any change postpones the compression until the map is idle again
+    connect(mapDocument, &MapDocument::mapChanged,
+            this, &LayerCompressor::scheduleCompression);
+    connect(mapDocument, &MapDocument::regionChanged,
+            this, &LayerCompressor::scheduleCompression);
+    connect(mapDocument, &MapDocument::layerAdded,
+            this, &LayerCompressor::scheduleCompression);
+    connect(mapDocument, &MapDocument::layerChanged,
+            this, &LayerCompressor::scheduleCompression);
+    connect(mapDocument, &MapDocument::currentLayerIndexChanged,
+            this, &LayerCompressor::scheduleCompression);
+    connect(mapDocument, &MapDocument::saved,
+            this, &LayerCompressor::scheduleCompression);
+    connect(mapDocument, &MapDocument::layerAboutToBeRemoved,
+            this, &LayerCompressor::layerAboutToBeRemoved);
+
+    connect(Preferences::instance(), &Preferences::compressHiddenLayersChanged,
+            this, &LayerCompressor::enabledChanged);
+
+    scheduleCompression();
+}
+
+LayerCompressor::~LayerCompressor()
+{
+    cancelRequests();
+    mThreadPool.waitForDone();
+}
+
+void LayerCompressor::scheduleCompression()
+{
+    if (Preferences::instance()->compressHiddenLayers())
+        mIdleTimer.start();
+}
+
+void LayerCompressor::compressHiddenLayers()
+{
+    if (!Preferences::instance()->compressHiddenLayers())
+        return;
+
+    const Layer *currentLayer = mMapDocument->currentLayer();
+
+    for (Layer *layer : mMapDocument->map()->layers()) {
+        TileLayer *tileLayer = layer->asTileLayer();
+        if (!tileLayer || tileLayer == currentLayer || tileLayer->isVisible())
+            continue;
+
+        // Layers that are not loaded are already compact
+        if (!tileLayer->isLoaded() || tileLayer->chunks().isEmpty())
+            continue;
+
+        if (isPending(tileLayer))
+            continue;
+
+        QSharedPointer<CompressRequest> request(new CompressRequest);
+        request->tileLayer = tileLayer;
+        request->chunks = tileLayer->chunks();
+        request->generation = tileLayer->changeGeneration();
+
+        mRequests.append(request);
+        mThreadPool.start(new CompressTask(this, request));
+    }
+}
+
+/**
+ * Replaces the cells of the layers that were compressed. A layer that was
+ * shown, made current or changed in the meantime keeps its cells.
+ */
+void LayerCompressor::chunksCompressed()
+{
+    const Layer *currentLayer = mMapDocument->currentLayer();
+
+    auto it = mRequests.begin();
+    while (it != mRequests.end()) {
+        const CompressRequest &request = **it;
+        if (!request.finished.loadAcquire()) {
+            ++it;
+            continue;
+        }
+
+        TileLayer *tileLayer = request.tileLayer;
+        if (!tileLayer->isVisible() && tileLayer != currentLayer)
+            tileLayer->setCompressedChunks(request.compressed, request.generation);
+
+        it = mRequests.erase(it);
+    }
+}
+
+void LayerCompressor::enabledChanged(bool enabled)
+{
+    if (enabled) {
+        scheduleCompression();
+    } else {
+        mIdleTimer.stop();
+        cancelRequests();
+    }
+}
+
+/**
+ * Forgets about the layer at \a index, since it may be deleted once it has
+ * been removed from the map.
+ */
+void LayerCompressor::layerAboutToBeRemoved(int index)
+{
+    const Layer *layer = mMapDocument->map()->layerAt(index);
+
+    auto it = mRequests.begin();
+    while (it != mRequests.end()) {
+        if ((*it)->tileLayer == layer) {
+            (*it)->canceled.storeRelease(1);
+            it = mRequests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool LayerCompressor::isPending(const TileLayer *tileLayer) const
+{
+    for (const QSharedPointer<CompressRequest> &request : mRequests)
+        if (request->tileLayer == tileLayer)
+            return true;
+
+    return false;
+}
+
+void LayerCompressor::cancelRequests()
+{
+    for (const QSharedPointer<CompressRequest> &request : mRequests)
+        request->canceled.storeRelease(1);
+
+    mRequests.clear();
+}
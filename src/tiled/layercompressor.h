@@ -0,0 +1,75 @@
+/*
+ * layercompressor.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAYERCOMPRESSOR_H
+#define LAYERCOMPRESSOR_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+namespace Tiled {
+
+class TileLayer;
+
+namespace Internal {
+
+class MapDocument;
+struct CompressRequest;
+
+/**
+ * Keeps the cells of the hidden tile layers of a map compressed in memory,
+ * when enabled in the preferences. The current layer is never compressed.
+ *
+ * Layers are compressed once the map hasn't been edited for a moment, on
+ * threads running at idle priority. A layer decompresses its cells again
+ * when they are accessed, for example when it is shown or edited.
+ */
+class LayerCompressor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LayerCompressor(MapDocument *mapDocument);
+    ~LayerCompressor();
+
+private slots:
+    void scheduleCompression();
+    void compressHiddenLayers();
+    void chunksCompressed();
+    void enabledChanged(bool enabled);
+    void layerAboutToBeRemoved(int index);
+
+private:
+    bool isPending(const TileLayer *tileLayer) const;
+    void cancelRequests();
+
+    MapDocument *mMapDocument;
+    QTimer mIdleTimer;
+    QVector<QSharedPointer<CompressRequest>> mRequests;
+    QThreadPool mThreadPool;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // LAYERCOMPRESSOR_H
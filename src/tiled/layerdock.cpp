@@ -23,6 +23,7 @@
 
 #include "layerdock.h"
 
+#include "changenotifier.h"
 #include "layer.h"
 #include "layermodel.h"
 #include "map.h"
@@ -113,15 +114,17 @@ void LayerDock::setMapDocument(MapDocument *mapDocument)
     if (mMapDocument == mapDocument)
         return;
 
-    if (mMapDocument)
+    if (mMapDocument) {
         mMapDocument->disconnect(this);
+        mMapDocument->changeNotifier()->disconnect(this);
+    }
 
     mMapDocument = mapDocument;
 
     if (mMapDocument) {
         connect(mMapDocument, &MapDocument::currentLayerIndexChanged,
                 this, &LayerDock::updateOpacitySlider);
-        connect(mMapDocument, &MapDocument::layerChanged,
+        connect(mMapDocument->changeNotifier(), &ChangeNotifier::layerChanged,
                 this, &LayerDock::layerChanged);
         connect(mMapDocument, &MapDocument::editLayerNameRequested,
                 this, &LayerDock::editLayerName);
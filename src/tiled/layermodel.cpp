@@ -233,6 +233,41 @@ void LayerModel::setLayerVisible(int layerIndex, bool visible)
     emit layerChanged(layerIndex);
 }
 
+/**
+ * Sets whether the layers at the given indexes are visible.
+ *
+ * The rows of all affected layers are reported as a single changed range,
+ * rather than one by one.
+ */
+void LayerModel::setLayersVisible(const QVector<int> &layerIndexes, bool visible)
+{
+    QVector<int> changedIndexes;
+    int firstRow = rowCount();
+    int lastRow = -1;
+
+    for (int layerIndex : layerIndexes) {
+        Layer *layer = mMap->layerAt(layerIndex);
+        if (layer->isVisible() == visible)
+            continue;
+
+        layer->setVisible(visible);
+        changedIndexes.append(layerIndex);
+
+        const int row = layerIndexToRow(layerIndex);
+        firstRow = qMin(firstRow, row);
+        lastRow = qMax(lastRow, row);
+    }
+
+    if (changedIndexes.isEmpty())
+        return;
+
+    emit dataChanged(index(firstRow, 0), index(lastRow, 0),
+                     QVector<int>() << Qt::CheckStateRole);
+
+    for (int layerIndex : changedIndexes)
+        emit layerChanged(layerIndex);
+}
+
 /**
  * Sets the opacity of the layer at the given index.
  */
@@ -298,19 +333,24 @@ void LayerModel::toggleOtherLayers(int layerIndex)
         }
     }
 
-    QUndoStack *undoStack = mMapDocument->undoStack();
-    if (visibility)
-        undoStack->beginMacro(tr("Show Other Layers"));
-    else
-        undoStack->beginMacro(tr("Hide Other Layers"));
-
+    QVector<int> layerIndexes;
     for (int i = 0; i < mMap->layerCount(); i++) {
         if (i == layerIndex)
             continue;
 
         if (visibility != mMap->layerAt(i)->isVisible())
-            undoStack->push(new SetLayerVisible(mMapDocument, i, visibility));
+            layerIndexes.append(i);
     }
 
-    undoStack->endMacro();
+    // Changing all layers with a single command avoids updating the views
+    // for each layer separately
+    QUndoCommand *command = new SetLayersVisible(mMapDocument,
+                                                 layerIndexes,
+                                                 visibility);
+    if (visibility)
+        command->setText(tr("Show Other Layers"));
+    else
+        command->setText(tr("Hide Other Layers"));
+
+    mMapDocument->undoStack()->push(command);
 }
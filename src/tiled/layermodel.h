@@ -23,6 +23,7 @@
 
 #include <QAbstractListModel>
 #include <QIcon>
+#include <QVector>
 
 namespace Tiled {
 
@@ -76,6 +77,7 @@ public:
     Layer *takeLayerAt(int index);
 
     void setLayerVisible(int layerIndex, bool visible);
+    void setLayersVisible(const QVector<int> &layerIndexes, bool visible);
     void setLayerOpacity(int layerIndex, float opacity);
     void setLayerOffset(int layerIndex, const QPointF &offset);
 
@@ -27,6 +27,7 @@
 #include "tilepainter.h"
 #include "tile.h"
 #include "mapscene.h"
+#include "map.h"
 #include "mapdocument.h"
 #include "changeselectedarea.h"
 
@@ -41,6 +42,7 @@ MagicWandTool::MagicWandTool(QObject *parent)
                                ":images/22x22/stock-tool-fuzzy-select-22.png")),
                        QKeySequence(tr("W")),
                        parent)
+    , mAllLayers(false)
 {
 }
 
@@ -51,9 +53,13 @@ void MagicWandTool::tilePositionChanged(const QPoint &tilePos)
     if (!tileLayer)
         return;
 
-    TilePainter regionComputer(mapDocument(), tileLayer);
-    mSelectedRegion = regionComputer.computeFillRegion(tilePos);
-    brushItem()->setTileRegion(mSelectedRegion);
+    if (mAllLayers) {
+        mSelectedMask = TilePainter::computeFillMask(matchLayers(), tilePos);
+    } else {
+        TilePainter regionComputer(mapDocument(), tileLayer);
+        mSelectedMask = regionComputer.computeFillMask(tilePos);
+    }
+    brushItem()->setTileRegion(mSelectedMask.toRegion());
 }
 
 void MagicWandTool::mousePressed(QGraphicsSceneMouseEvent *event)
@@ -65,16 +71,20 @@ void MagicWandTool::mousePressed(QGraphicsSceneMouseEvent *event)
 
     MapDocument *document = mapDocument();
 
-    QRegion selection = document->selectedArea();
+    // Combine the selections as masks, since QRegion operations get slow
+    // on fragmented regions
+    TileMask selectionMask(document->selectedArea());
 
     if (modifiers == Qt::ShiftModifier)
-        selection += mSelectedRegion;
+        selectionMask += mSelectedMask;
     else if (modifiers == Qt::ControlModifier)
-        selection -= mSelectedRegion;
+        selectionMask -= mSelectedMask;
     else if (modifiers == (Qt::ControlModifier | Qt::ShiftModifier))
-        selection &= mSelectedRegion;
+        selectionMask &= mSelectedMask;
     else
-        selection = mSelectedRegion;
+        selectionMask = mSelectedMask;
+
+    const QRegion selection = selectionMask.toRegion();
 
     if (selection != document->selectedArea()) {
         QUndoCommand *cmd = new ChangeSelectedArea(document, selection);
@@ -91,3 +101,27 @@ void MagicWandTool::languageChanged()
     setName(tr("Magic Wand"));
     setShortcut(QKeySequence(tr("W")));
 }
+
+/**
+ * Sets whether positions are matched by the cells of all visible tile
+ * layers, instead of only by those of the current layer.
+ */
+void MagicWandTool::setAllLayers(bool value)
+{
+    if (mAllLayers == value)
+        return;
+
+    mAllLayers = value;
+
+    if (mapDocument() && currentTileLayer())
+        tilePositionChanged(tilePosition());
+}
+
+QList<TileLayer*> MagicWandTool::matchLayers() const
+{
+    QList<TileLayer*> layers;
+    for (TileLayer *layer : mapDocument()->map()->tileLayers())
+        if (layer->isVisible())
+            layers.append(layer);
+    return layers;
+}
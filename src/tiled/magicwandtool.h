@@ -36,6 +36,8 @@ class MapDocument;
 
 /**
  * Implements a tool that selects a region of connected similar tiles on the layer.
+ * When matching all layers, the tiles need to be similar on each visible tile
+ * layer.
  */
 class MagicWandTool : public AbstractTileTool
 {
@@ -49,12 +51,17 @@ public:
 
     void languageChanged() override;
 
+public slots:
+    void setAllLayers(bool value);
+
 protected:
     void tilePositionChanged(const QPoint &tilePos) override;
 
 private:
+    QList<TileLayer*> matchLayers() const;
 
-    QRegion mSelectedRegion;
+    TileMask mSelectedMask;
+    bool mAllLayers;
 };
 
 } // namespace Internal
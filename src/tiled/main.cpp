@@ -20,19 +20,35 @@
  * this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "automappingmanager.h"
 #include "commandlineparser.h"
+#include "imagecache.h"
 #include "mainwindow.h"
 #include "languagemanager.h"
+#include "mapanalyzer.h"
+#include "mapbenchmark.h"
+#include "mapcache.h"
 #include "pluginmanager.h"
 #include "mapdocument.h"
 #include "mapreader.h"
 #include "mapformat.h"
+#include "memoryreport.h"
 #include "preferences.h"
 #include "tiledapplication.h"
+#include "tilelayer.h"
 #include "tileset.h"
+#include "tilesetmanager.h"
+#include "tilesetrepacker.h"
+#include "tmxmapformat.h"
+#include "tracing.h"
 
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTimer>
 #include <QtPlugin>
 #include <QStyle>
 #include <QStyleFactory>
@@ -56,12 +72,28 @@ public:
     bool showedVersion;
     bool disableOpenGL;
     bool exportMap;
+    bool repackTilesets;
+    bool autoMap;
+    bool trace;
+    bool memoryUsage;
+    bool check;
+    bool benchmark;
+    bool startupTimings;
+    bool noImages;
 
 private:
     void showVersion();
     void justQuit();
     void setDisableOpenGL();
     void setExportMap();
+    void setRepackTilesets();
+    void setAutoMap();
+    void setTrace();
+    void setMemoryUsage();
+    void setCheck();
+    void setBenchmark();
+    void setStartupTimings();
+    void setNoImages();
     void showExportFormats();
 
     // Convenience wrapper around registerOption
@@ -85,6 +117,14 @@ CommandLineHandler::CommandLineHandler()
     , showedVersion(false)
     , disableOpenGL(false)
     , exportMap(false)
+    , repackTilesets(false)
+    , autoMap(false)
+    , trace(false)
+    , memoryUsage(false)
+    , check(false)
+    , benchmark(false)
+    , startupTimings(false)
+    , noImages(false)
 {
     option<&CommandLineHandler::showVersion>(
                 QLatin1Char('v'),
@@ -104,7 +144,47 @@ CommandLineHandler::CommandLineHandler()
     option<&CommandLineHandler::setExportMap>(
                 QChar(),
                 QLatin1String("--export-map"),
-                tr("Export the specified tmx file to target"));
+                tr("Export the specified tmx files or directories to targets"));
+
+    option<&CommandLineHandler::setRepackTilesets>(
+                QChar(),
+                QLatin1String("--repack-tilesets"),
+                tr("Export only the used tiles, repacked into power-of-two atlases"));
+
+    option<&CommandLineHandler::setAutoMap>(
+                QChar(),
+                QLatin1String("--automap"),
+                tr("Apply the automapping rules to the specified tmx files"));
+
+    option<&CommandLineHandler::setTrace>(
+                QChar(),
+                QLatin1String("--trace"),
+                tr("Write a trace of loading, saving and automapping to the file in TILED_TRACE, or tiled-trace.json"));
+
+    option<&CommandLineHandler::setMemoryUsage>(
+                QChar(),
+                QLatin1String("--memory-usage"),
+                tr("Print the memory used by the layers and tilesets of the specified tmx files"));
+
+    option<&CommandLineHandler::setCheck>(
+                QChar(),
+                QLatin1String("--check"),
+                tr("Check the specified tmx files for problems and print their statistics"));
+
+    option<&CommandLineHandler::setBenchmark>(
+                QChar(),
+                QLatin1String("--benchmark"),
+                tr("Time rendering, filling, painting, automapping and undo on the specified maps"));
+
+    option<&CommandLineHandler::setStartupTimings>(
+                QChar(),
+                QLatin1String("--startup-timings"),
+                tr("Print how long each phase of the startup takes"));
+
+    option<&CommandLineHandler::setNoImages>(
+                QChar(),
+                QLatin1String("--no-images"),
+                tr("Don't decode images, for converting maps without a display"));
 
     option<&CommandLineHandler::showExportFormats>(
                 QChar(),
@@ -137,6 +217,46 @@ void CommandLineHandler::setExportMap()
     exportMap = true;
 }
 
+void CommandLineHandler::setRepackTilesets()
+{
+    repackTilesets = true;
+}
+
+void CommandLineHandler::setAutoMap()
+{
+    autoMap = true;
+}
+
+void CommandLineHandler::setTrace()
+{
+    trace = true;
+}
+
+void CommandLineHandler::setMemoryUsage()
+{
+    memoryUsage = true;
+}
+
+void CommandLineHandler::setCheck()
+{
+    check = true;
+}
+
+void CommandLineHandler::setBenchmark()
+{
+    benchmark = true;
+}
+
+void CommandLineHandler::setStartupTimings()
+{
+    startupTimings = true;
+}
+
+void CommandLineHandler::setNoImages()
+{
+    noImages = true;
+}
+
 void CommandLineHandler::showExportFormats()
 {
     PluginManager::instance()->loadPlugins();
@@ -151,8 +271,511 @@ void CommandLineHandler::showExportFormats()
     quit = true;
 }
 
+/**
+ * Applies the automapping rules to each of the given maps and saves them,
+ * reporting the time taken for each map and the statistics of each rule.
+ *
+ * The rules are looked up next to each map, like in the editor. Rule maps
+ * that are shared between the maps are only read once.
+ *
+ * Returns the exit code, which is 1 when any of the maps failed.
+ */
+static int autoMapFiles(const QStringList &fileNames)
+{
+    AutomappingManager automappingManager;
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    TmxMapFormat tmxFormat;
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    int failed = 0;
+
+    for (const QString &fileName : fileNames) {
+        QElapsedTimer timer;
+        timer.start();
+
+        QScopedPointer<Map> map(tmxFormat.read(fileName));
+        if (!map) {
+            qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                 "Failed to load %1: %2")
+                                     .arg(fileName, tmxFormat.errorString()));
+            ++failed;
+            continue;
+        }
+
+        // Reference the tilesets like for an open map document
+        const QVector<SharedTileset> tilesets = map->tilesets();
+        tilesetManager->addReferences(tilesets);
+        const qint64 readTime = timer.restart();
+
+        const bool success = automappingManager.autoMap(map.data(), fileName);
+        const qint64 autoMapTime = timer.restart();
+
+        const QString warnings = automappingManager.warningString().trimmed();
+        if (!warnings.isEmpty())
+            qWarning() << qPrintable(warnings);
+
+        bool saved = false;
+        if (success) {
+            saved = tmxFormat.write(map.data(), fileName);
+            if (!saved) {
+                qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                     "Failed to save %1: %2")
+                                         .arg(fileName, tmxFormat.errorString()));
+            }
+        } else {
+            qWarning() << qPrintable(automappingManager.errorString().trimmed());
+        }
+        const qint64 writeTime = timer.elapsed();
+
+        map.reset();
+        tilesetManager->removeReferences(tilesets);
+
+        if (!saved)
+            ++failed;
+
+        qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                             "%1: %2 (read %3 ms, automap %4 ms, write %5 ms)")
+                                 .arg(fileName)
+                                 .arg(saved ? QCoreApplication::translate("Command line", "done")
+                                            : QCoreApplication::translate("Command line", "failed"))
+                                 .arg(readTime)
+                                 .arg(autoMapTime)
+                                 .arg(writeTime));
+    }
+
+    qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                         "Automapped %1 of %2 maps in %3 ms")
+                             .arg(fileNames.size() - failed)
+                             .arg(fileNames.size())
+                             .arg(totalTimer.elapsed()));
+
+    const QString report = automappingManager.ruleStatsReport();
+    if (!report.isEmpty())
+        qWarning() << qPrintable(report.trimmed());
+
+    return failed > 0 ? 1 : 0;
+}
+
+/**
+ * Prints the memory used by each of the given maps, broken down by layer,
+ * followed by the memory used by all their tilesets together.
+ *
+ * Returns the exit code, which is 1 when any of the maps failed to load.
+ */
+static int printMemoryUsage(const QStringList &fileNames)
+{
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    TmxMapFormat tmxFormat;
+
+    QList<Map*> maps;
+    int failed = 0;
+
+    for (const QString &fileName : fileNames) {
+        Map *map = tmxFormat.read(fileName);
+        if (!map) {
+            qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                 "Failed to load %1: %2")
+                                     .arg(fileName, tmxFormat.errorString()));
+            ++failed;
+            continue;
+        }
+
+        // Cells of lazily loaded layers only take memory once they are used
+        for (TileLayer *tileLayer : map->tileLayers())
+            tileLayer->load();
+
+        tilesetManager->addReferences(map->tilesets());
+        maps.append(map);
+
+        qWarning() << qPrintable(memoryUsageReport(mapMemoryUsage(map, fileName)).trimmed());
+    }
+
+    qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                         "All tilesets: %1")
+                             .arg(formatMemoryUsage(tilesetManager->memoryUsage())));
+
+    for (Map *map : maps) {
+        tilesetManager->removeReferences(map->tilesets());
+        delete map;
+    }
+
+    return failed > 0 ? 1 : 0;
+}
+
+/**
+ * Checks the given maps for problems, like invalid tiles or duplicate object
+ * IDs, and prints them along with the statistics of each map. The maps are
+ * analyzed in parallel.
+ *
+ * Returns the exit code, which is 1 when any of the maps failed to load or
+ * has problems.
+ */
+static int checkMaps(const QStringList &fileNames)
+{
+    TmxMapFormat tmxFormat;
+    MapAnalyzer analyzer;
+
+    QList<Map*> maps;
+    QStringList mapFileNames;
+    int failed = 0;
+
+    for (const QString &fileName : fileNames) {
+        Map *map = tmxFormat.read(fileName);
+        if (!map) {
+            qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                 "Failed to load %1: %2")
+                                     .arg(fileName, tmxFormat.errorString()));
+            ++failed;
+            continue;
+        }
+
+        analyzer.addMap(map);
+        maps.append(map);
+        mapFileNames.append(fileName);
+    }
+
+    analyzer.analyze();
+
+    for (int i = 0; i < analyzer.reports().size(); ++i) {
+        const MapAnalyzer::Report &report = analyzer.reports().at(i);
+        if (!report.issues.isEmpty())
+            ++failed;
+
+        qWarning() << qPrintable(mapFileNames.at(i));
+        qWarning() << qPrintable(report.toString());
+    }
+
+    qDeleteAll(maps);
+
+    return failed > 0 ? 1 : 0;
+}
+
+/**
+ * Returns the map format with the given name filter that can write maps,
+ * or null when there is no such format.
+ */
+static MapFormat *formatByNameFilter(const QString &filter)
+{
+    for (MapFormat *format : PluginManager::objects<MapFormat>()) {
+        if (!format->hasCapabilities(MapFormat::Write))
+            continue;
+        if (format->nameFilter().compare(filter, Qt::CaseInsensitive) == 0)
+            return format;
+    }
+    return nullptr;
+}
+
+/**
+ * Returns the map format that writes files with the suffix of the given
+ * \a targetFile. Sets \a error and returns null when there is no such format
+ * or when the suffix is not unique.
+ */
+static MapFormat *formatForTarget(const QString &targetFile, QString *error)
+{
+    const QString suffix = QFileInfo(targetFile).completeSuffix();
+    MapFormat *chosenFormat = nullptr;
+
+    for (MapFormat *format : PluginManager::objects<MapFormat>()) {
+        if (!format->hasCapabilities(MapFormat::Write))
+            continue;
+        if (format->nameFilter().contains(suffix, Qt::CaseInsensitive)) {
+            if (chosenFormat) {
+                *error = QCoreApplication::translate("Command line",
+                                                     "Non-unique file extension. Can't determine correct export format.");
+                return nullptr;
+            }
+            chosenFormat = format;
+        }
+    }
+
+    if (!chosenFormat)
+        *error = QCoreApplication::translate("Command line",
+                                             "No exporter found for target file.");
+
+    return chosenFormat;
+}
+
+/**
+ * Returns the first file extension in the name filter of \a format, like
+ * "lua" for "Lua files (*.lua)".
+ */
+static QString formatSuffix(const MapFormat *format)
+{
+    const QString filter = format->nameFilter();
+    const int start = filter.indexOf(QLatin1String("*."));
+    if (start == -1)
+        return QString();
+
+    int end = start + 2;
+    while (end < filter.size() && (filter.at(end).isLetterOrNumber() ||
+                                   filter.at(end) == QLatin1Char('.')))
+        ++end;
+
+    return filter.mid(start + 2, end - start - 2);
+}
+
+namespace {
+
+struct ExportJob
+{
+    QString sourceFile;
+    QString targetFile;
+    MapFormat *format;
+};
+
+/**
+ * Writes a map on a thread pool thread, so that the next map can be read
+ * in the meantime.
+ */
+class ExportTask : public QRunnable
+{
+public:
+    ExportTask(const ExportJob &job, Map *map, qint64 readTime)
+        : job(job)
+        , map(map)
+        , readTime(readTime)
+        , writeTime(0)
+        , success(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        TraceScope trace("MapFormat::write", job.targetFile);
+        success = job.format->write(map.data(), job.targetFile);
+        error = job.format->errorString();
+        writeTime = timer.elapsed();
+    }
+
+    const ExportJob job;
+    const QScopedPointer<Map> map;
+    const qint64 readTime;
+    qint64 writeTime;
+    bool success;
+    QString error;
+};
+
+} // anonymous namespace
+
+/**
+ * Turns the arguments of --export-map into a list of export jobs. The
+ * arguments are an optional format followed by pairs of a source and a
+ * target. A source can be a directory or a wildcard pattern, in which case
+ * the target is the directory to export the matching maps to.
+ *
+ * Returns false after printing a message when the arguments are invalid.
+ */
+static bool collectExportJobs(const QStringList &arguments,
+                              QVector<ExportJob> &jobs)
+{
+    if (arguments.size() < 2) {
+        qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                             "Export syntax is --export-map [format] <tmx file> <target file> [<tmx file> <target file>...]"));
+        return false;
+    }
+
+    // With an odd number of arguments, the first one is the format
+    int index = 0;
+    MapFormat *chosenFormat = nullptr;
+    if (arguments.size() % 2 == 1) {
+        chosenFormat = formatByNameFilter(arguments.at(index++));
+        if (!chosenFormat) {
+            qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                 "Format not recognized (see --export-formats)"));
+            return false;
+        }
+    }
+
+    for (; index + 1 < arguments.size(); index += 2) {
+        const QString &source = arguments.at(index);
+        const QString &target = arguments.at(index + 1);
+
+        const QFileInfo sourceInfo(source);
+        const bool isPattern = source.contains(QLatin1Char('*')) ||
+                source.contains(QLatin1Char('?'));
+
+        if (!isPattern && !sourceInfo.isDir()) {
+            ExportJob job { source, target, chosenFormat };
+            if (!job.format) {
+                QString error;
+                job.format = formatForTarget(target, &error);
+                if (!job.format) {
+                    qWarning() << qPrintable(error);
+                    return false;
+                }
+            }
+            jobs.append(job);
+            continue;
+        }
+
+        if (!chosenFormat) {
+            qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                 "A format is needed to export the maps in %1 (see --export-formats)")
+                                     .arg(source));
+            return false;
+        }
+
+        if (!QDir().mkpath(target)) {
+            qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                 "Could not create directory %1").arg(target));
+            return false;
+        }
+
+        const QDir sourceDir(isPattern ? sourceInfo.path() : source);
+        const QString pattern = isPattern ? sourceInfo.fileName()
+                                          : QLatin1String("*.tmx");
+        const QDir targetDir(target);
+        const QString suffix = formatSuffix(chosenFormat);
+
+        const QStringList fileNames = sourceDir.entryList(QStringList(pattern),
+                                                          QDir::Files, QDir::Name);
+        for (const QString &fileName : fileNames) {
+            const QString baseName = QFileInfo(fileName).completeBaseName();
+            jobs.append(ExportJob { sourceDir.filePath(fileName),
+                                    targetDir.filePath(baseName + QLatin1Char('.') + suffix),
+                                    chosenFormat });
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Exports the maps given as arguments to --export-map, reporting the time
+ * taken for each map and in total.
+ *
+ * The maps are read on the main thread, since it creates the tileset
+ * pixmaps, while the previous map is written on another thread. Tilesets
+ * stay referenced until all maps are exported, so that tilesets shared
+ * between the maps are only loaded once.
+ *
+ * With \a repackTilesets, the used tiles are repacked into atlases that are
+ * written next to each target (see TilesetRepacker).
+ *
+ * Returns the exit code, which is 1 when any of the maps failed.
+ */
+static int exportMapFiles(const QStringList &arguments, bool repackTilesets)
+{
+    QVector<ExportJob> jobs;
+    if (!collectExportJobs(arguments, jobs))
+        return 1;
+
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    TmxMapFormat tmxFormat;
+    TilesetRepacker repacker;
+
+    // Map formats are not thread-safe, so only one map is written at a time
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(1);
+
+    QVector<SharedTileset> referencedTilesets;
+    QScopedPointer<ExportTask> pendingTask;
+    int failed = 0;
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    auto finishPendingTask = [&] {
+        if (!pendingTask)
+            return;
+
+        threadPool.waitForDone();
+
+        const ExportTask &task = *pendingTask;
+        if (!task.success) {
+            qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                 "Failed to export %1 to %2: %3")
+                                     .arg(task.job.sourceFile, task.job.targetFile, task.error));
+            ++failed;
+        }
+
+        qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                             "%1 -> %2: %3 (read %4 ms, write %5 ms)")
+                                 .arg(task.job.sourceFile, task.job.targetFile)
+                                 .arg(task.success ? QCoreApplication::translate("Command line", "done")
+                                                   : QCoreApplication::translate("Command line", "failed"))
+                                 .arg(task.readTime)
+                                 .arg(task.writeTime));
+
+        pendingTask.reset();
+    };
+
+    for (const ExportJob &job : jobs) {
+        QElapsedTimer timer;
+        timer.start();
+
+        Map *map = tmxFormat.read(job.sourceFile);
+        if (!map) {
+            qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                 "Failed to load %1: %2")
+                                     .arg(job.sourceFile, tmxFormat.errorString()));
+            ++failed;
+            continue;
+        }
+
+        // Referenced tilesets are found by the reader when loading the next map
+        tilesetManager->addReferences(map->tilesets());
+        referencedTilesets += map->tilesets();
+
+        const qint64 readTime = timer.elapsed();
+
+        if (repackTilesets) {
+            Map *repacked = repacker.repack(map, job.targetFile);
+            delete map;
+
+            if (!repacked) {
+                qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                                     "Failed to repack the tilesets of %1: %2")
+                                         .arg(job.sourceFile, repacker.errorString()));
+                ++failed;
+                continue;
+            }
+
+            map = repacked;
+        }
+
+        // Makes sure a format plugin that is loaded on first use gets
+        // loaded on the main thread
+        job.format->outputFiles(map, job.targetFile);
+
+        finishPendingTask();
+        pendingTask.reset(new ExportTask(job, map, readTime));
+        threadPool.start(pendingTask.data());
+    }
+
+    finishPendingTask();
+    tilesetManager->removeReferences(referencedTilesets);
+
+    qWarning() << qPrintable(QCoreApplication::translate("Command line",
+                                                         "Exported %1 of %2 maps in %3 ms")
+                             .arg(jobs.size() - failed)
+                             .arg(jobs.size())
+                             .arg(totalTimer.elapsed()));
+
+    return failed > 0 ? 1 : 0;
+}
+
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    // Without images, no display is needed, so the platform plugin doesn't
+    // need to connect to one
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--no-images") == 0) {
+            if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+                qputenv("QT_QPA_PLATFORM", "offscreen");
+            break;
+        }
+    }
+
     TiledApplication a(argc, argv);
 
     a.setOrganizationDomain(QLatin1String("mapeditor.org"));
@@ -205,93 +828,108 @@ int main(int argc, char *argv[])
         return 0;
     if (commandLine.disableOpenGL)
         Preferences::instance()->setUseOpenGL(false);
+    if (commandLine.noImages)
+        setImageDecodingEnabled(false);
+
+    // Tracing is enabled by either --trace or the TILED_TRACE variable, which
+    // names the file to write the trace to
+    const QString traceFile = QString::fromLocal8Bit(qgetenv("TILED_TRACE"));
+    if (commandLine.trace || !traceFile.isEmpty()) {
+        Tracing::start(traceFile.isEmpty() ? QLatin1String("tiled-trace.json")
+                                           : traceFile);
+    }
+
+    // Writes the trace when returning from main
+    struct TraceFinisher {
+        ~TraceFinisher() {
+            if (!Tracing::finish())
+                qWarning() << "Failed to write the trace";
+        }
+    } traceFinisher;
+
+    // Reports the time since the previous phase, for --startup-timings
+    qint64 phaseStart = 0;
+    auto reportStartupPhase = [&] (const char *phase) {
+        if (!commandLine.startupTimings)
+            return;
+
+        const qint64 now = startupTimer.elapsed();
+        qWarning() << qPrintable(QString(QLatin1String("startup\t%1\t%2 ms"))
+                                 .arg(QLatin1String(phase))
+                                 .arg(now - phaseStart));
+        phaseStart = now;
+    };
+
+    reportStartupPhase("application");
 
     PluginManager::instance()->loadPlugins();
 
-    if (commandLine.exportMap) {
-        // Get the path to the source file and target file
-        if (commandLine.filesToOpen().length() < 2) {
-            qWarning() << qPrintable(QCoreApplication::translate("Command line",
-                                                                 "Export syntax is --export-map [format] <tmx file> <target file>"));
-            return 1;
-        }
-        int index = 0;
-        const QString *filter = commandLine.filesToOpen().length() > 2 ? &commandLine.filesToOpen().at(index++) : nullptr;
-        const QString &sourceFile = commandLine.filesToOpen().at(index++);
-        const QString &targetFile = commandLine.filesToOpen().at(index++);
-
-        MapFormat *chosenFormat = nullptr;
-        auto formats = PluginManager::objects<MapFormat>();
-
-        if (filter) {
-            // Find the map format supporting the given filter
-            for (MapFormat *format : formats) {
-                if (!format->hasCapabilities(MapFormat::Write))
-                    continue;
-                if (format->nameFilter().compare(*filter, Qt::CaseInsensitive) == 0) {
-                    chosenFormat = format;
-                    break;
-                }
-            }
-            if (!chosenFormat) {
-                qWarning() << qPrintable(QCoreApplication::translate("Command line",
-                                                                     "Format not recognized (see --export-formats)"));
-                return 1;
-            }
-        } else {
-            // Find the map format based on target file extension
-            QString suffix = QFileInfo(targetFile).completeSuffix();
-            for (MapFormat *format : formats) {
-                if (!format->hasCapabilities(MapFormat::Write))
-                    continue;
-                if (format->nameFilter().contains(suffix, Qt::CaseInsensitive)) {
-                    if (chosenFormat) {
-                        qWarning() << qPrintable(QCoreApplication::translate("Command line",
-                                                                             "Non-unique file extension. Can't determine correct export format."));
-                        return 1;
-                    }
-                    chosenFormat = format;
-                }
-            }
-            if (!chosenFormat) {
-                qWarning() << qPrintable(QCoreApplication::translate("Command line",
-                                                                     "No exporter found for target file."));
-                return 1;
-            }
-        }
+    reportStartupPhase("plugins");
 
-        // Load the source file
-        MapReader reader;
-        QScopedPointer<Map> map(reader.readMap(sourceFile));
-        if (!map) {
+    if (commandLine.exportMap)
+        return exportMapFiles(commandLine.filesToOpen(),
+                              commandLine.repackTilesets);
+
+    if (commandLine.benchmark) {
+        if (commandLine.filesToOpen().isEmpty()) {
             qWarning() << qPrintable(QCoreApplication::translate("Command line",
-                                                                 "Failed to load source map."));
+                                                                 "Benchmark syntax is --benchmark <map file>..."));
             return 1;
         }
 
-        // Write out the file
-        bool success = chosenFormat->write(map.data(), targetFile);
+        return benchmarkMaps(commandLine.filesToOpen());
+    }
+
+    if (commandLine.memoryUsage)
+        return printMemoryUsage(commandLine.filesToOpen());
 
-        if (!success) {
+    if (commandLine.check)
+        return checkMaps(commandLine.filesToOpen());
+
+    if (commandLine.autoMap) {
+        if (commandLine.filesToOpen().isEmpty()) {
             qWarning() << qPrintable(QCoreApplication::translate("Command line",
-                                                                 "Failed to export map to target file."));
+                                                                 "Automap syntax is --automap <tmx file>..."));
             return 1;
         }
-        return 0;
+
+        return autoMapFiles(commandLine.filesToOpen());
     }
 
+    // Only the editor caches decoded images on disk, since it is likely to
+    // load the same tilesets again in later sessions
+    const int diskCacheLimit = Preferences::instance()->diskCacheLimit();
+    ImageCache::setSizeLimit(diskCacheLimit);
+    ImageCache::setEnabled(diskCacheLimit > 0);
+    MapCache::setSizeLimit(diskCacheLimit);
+
     MainWindow w;
     w.show();
 
+    reportStartupPhase("main window");
+
     QObject::connect(&a, SIGNAL(fileOpenRequest(QString)),
                      &w, SLOT(openFile(QString)));
 
-    if (!commandLine.filesToOpen().isEmpty()) {
-        foreach (const QString &fileName, commandLine.filesToOpen())
-            w.openFile(fileName);
-    } else if (Preferences::instance()->openLastFilesOnStartup()) {
-        w.openLastFiles();
+    {
+        TraceScope trace("openFiles");
+
+        if (!commandLine.filesToOpen().isEmpty()) {
+            w.openFiles(commandLine.filesToOpen());
+        } else if (Preferences::instance()->openLastFilesOnStartup()) {
+            w.openLastFiles();
+        }
     }
 
+    reportStartupPhase("open files");
+
+    // The window is only painted once the event loop is running
+    QTimer::singleShot(0, [&] {
+        reportStartupPhase("first event");
+        if (commandLine.startupTimings)
+            qWarning() << qPrintable(QString(QLatin1String("startup\ttotal\t%1 ms"))
+                                     .arg(startupTimer.elapsed()));
+    });
+
     return a.exec();
 }
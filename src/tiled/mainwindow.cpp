@@ -51,12 +51,16 @@
 #include "map.h"
 #include "mapdocument.h"
 #include "mapdocumentactionhandler.h"
+#include "maploader.h"
 #include "mapformat.h"
 #include "mapobject.h"
 #include "maprenderer.h"
 #include "mapsdock.h"
+#include "mapsaver.h"
 #include "mapscene.h"
 #include "mapview.h"
+#include "mapanalysisdock.h"
+#include "memoryusagedock.h"
 #include "newmapdialog.h"
 #include "newtilesetdialog.h"
 #include "pluginmanager.h"
@@ -68,6 +72,7 @@
 #include "preferences.h"
 #include "preferencesdialog.h"
 #include "propertiesdock.h"
+#include "renderprofiler.h"
 #include "stampbrush.h"
 #include "terrainbrush.h"
 #include "tile.h"
@@ -89,7 +94,10 @@
 #include "consoledock.h"
 #include "tileanimationeditor.h"
 #include "tilecollisioneditor.h"
+#include "tilesetrepacker.h"
 #include "tmxmapformat.h"
+#include "tracing.h"
+#include "worldmanager.h"
 #include "imagemovementtool.h"
 #include "magicwandtool.h"
 #include "selectsametiletool.h"
@@ -104,6 +112,8 @@
 #include <QDesktopServices>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QPointer>
+#include <QProgressDialog>
 #include <QScrollBar>
 #include <QSessionManager>
 #include <QTextStream>
@@ -115,6 +125,8 @@
 #include <QSignalMapper>
 #include <QShortcut>
 #include <QToolButton>
+#include <QTimer>
+#include <QDebug>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -132,6 +144,7 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     , mTerrainDock(new TerrainDock(this))
     , mMiniMapDock(new MiniMapDock(this))
     , mConsoleDock(new ConsoleDock(this))
+    , mMapAnalysisDock(new MapAnalysisDock(this))
     , mTileAnimationEditor(new TileAnimationEditor(this))
     , mTileCollisionEditor(new TileCollisionEditor(this))
     , mCurrentLayerLabel(new QLabel)
@@ -142,10 +155,23 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     , mDocumentManager(DocumentManager::instance())
     , mToolManager(new ToolManager(this))
     , mTileStampManager(new TileStampManager(*mToolManager, this))
+    , mMapLoader(new MapLoader(this))
+    , mMapLoadDialog(nullptr)
 {
+    TraceScope trace("MainWindow::MainWindow");
+
     mUi->setupUi(this);
     setCentralWidget(mDocumentManager->widget());
 
+    connect(mMapLoader, SIGNAL(loaded(MapDocument*)),
+            SLOT(mapLoaded(MapDocument*)));
+    connect(mMapLoader, SIGNAL(loadFailed(QString,QString)),
+            SLOT(mapLoadFailed(QString,QString)));
+    connect(mMapLoader, SIGNAL(progress(int,int,QString)),
+            SLOT(mapLoadProgress(int,int,QString)));
+    connect(mMapLoader, &MapLoader::readProgress,
+            this, &MainWindow::mapReadProgress);
+
 #ifdef Q_OS_MAC
     MacSupport::addFullscreen(this);
 #endif
@@ -192,6 +218,7 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     UndoDock *undoDock = new UndoDock(undoGroup, this);
     PropertiesDock *propertiesDock = new PropertiesDock(this);
     TileStampsDock *tileStampsDock = new TileStampsDock(mTileStampManager, this);
+    MemoryUsageDock *memoryUsageDock = new MemoryUsageDock(this);
 
     addDockWidget(Qt::RightDockWidgetArea, mLayerDock);
     addDockWidget(Qt::LeftDockWidgetArea, propertiesDock);
@@ -203,12 +230,16 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     addDockWidget(Qt::RightDockWidgetArea, mTilesetDock);
     addDockWidget(Qt::BottomDockWidgetArea, mConsoleDock);
     addDockWidget(Qt::LeftDockWidgetArea, tileStampsDock);
+    addDockWidget(Qt::BottomDockWidgetArea, memoryUsageDock);
+    addDockWidget(Qt::BottomDockWidgetArea, mMapAnalysisDock);
 
     tabifyDockWidget(mMiniMapDock, mObjectsDock);
     tabifyDockWidget(mObjectsDock, mLayerDock);
     tabifyDockWidget(mTerrainDock, mTilesetDock);
     tabifyDockWidget(undoDock, mMapsDock);
     tabifyDockWidget(tileStampsDock, undoDock);
+    tabifyDockWidget(mConsoleDock, memoryUsageDock);
+    tabifyDockWidget(memoryUsageDock, mMapAnalysisDock);
 
     // These dock widgets may not be immediately useful to many people, so
     // they are hidden by default.
@@ -216,6 +247,8 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     mMapsDock->setVisible(false);
     mConsoleDock->setVisible(false);
     tileStampsDock->setVisible(false);
+    memoryUsageDock->setVisible(false);
+    mMapAnalysisDock->setVisible(false);
 
     statusBar()->addPermanentWidget(mZoomComboBox);
 
@@ -306,6 +339,12 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     mRandomButton->setShortcut(QKeySequence(tr("D")));
     mUi->mainToolBar->addWidget(mRandomButton);
 
+    mAllLayersButton = new QToolButton(this);
+    mAllLayersButton->setToolTip(tr("Match All Layers"));
+    mAllLayersButton->setIcon(QIcon(QLatin1String(":images/16x16/layer-tile.png")));
+    mAllLayersButton->setCheckable(true);
+    mUi->mainToolBar->addWidget(mAllLayersButton);
+
     mLayerMenu = new QMenu(tr("&Layer"), this);
     mLayerMenu->addAction(mActionHandler->actionAddTileLayer());
     mLayerMenu->addAction(mActionHandler->actionAddObjectGroup());
@@ -329,7 +368,7 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     connect(mUi->actionOpen, SIGNAL(triggered()), SLOT(openFile()));
     connect(mUi->actionClearRecentFiles, SIGNAL(triggered()),
             SLOT(clearRecentFiles()));
-    connect(mUi->actionSave, SIGNAL(triggered()), SLOT(saveFile()));
+    connect(mUi->actionSave, SIGNAL(triggered()), SLOT(saveFileInBackground()));
     connect(mUi->actionSaveAs, SIGNAL(triggered()), SLOT(saveFileAs()));
     connect(mUi->actionSaveAll, SIGNAL(triggered()), SLOT(saveAll()));
     connect(mUi->actionExportAsImage, SIGNAL(triggered()), SLOT(exportAsImage()));
@@ -362,6 +401,10 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     connect(mUi->actionZoomIn, SIGNAL(triggered()), SLOT(zoomIn()));
     connect(mUi->actionZoomOut, SIGNAL(triggered()), SLOT(zoomOut()));
     connect(mUi->actionZoomNormal, SIGNAL(triggered()), SLOT(zoomNormal()));
+    connect(mUi->actionShowPerformanceOverlay, SIGNAL(toggled(bool)),
+            RenderProfiler::instance(), SLOT(setEnabled(bool)));
+    connect(mUi->actionSavePerformanceCapture, SIGNAL(triggered()),
+            SLOT(savePerformanceCapture()));
 
     connect(mUi->actionNewTileset, SIGNAL(triggered()), SLOT(newTileset()));
     connect(mUi->actionAddExternalTileset, SIGNAL(triggered()),
@@ -448,14 +491,22 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
     connect(mRandomButton, SIGNAL(toggled(bool)),
             mBucketFillTool, SLOT(setRandom(bool)));
 
+    MagicWandTool *magicWandTool = new MagicWandTool(this);
+    SelectSameTileTool *selectSameTileTool = new SelectSameTileTool(this);
+
+    connect(mAllLayersButton, &QToolButton::toggled,
+            magicWandTool, &MagicWandTool::setAllLayers);
+    connect(mAllLayersButton, &QToolButton::toggled,
+            selectSameTileTool, &SelectSameTileTool::setAllLayers);
+
     QToolBar *toolBar = mUi->toolsToolBar;
     toolBar->addAction(mToolManager->registerTool(mStampBrush));
     toolBar->addAction(mToolManager->registerTool(mTerrainBrush));
     toolBar->addAction(mToolManager->registerTool(mBucketFillTool));
     toolBar->addAction(mToolManager->registerTool(new Eraser(this)));
     toolBar->addAction(mToolManager->registerTool(new TileSelectionTool(this)));
-    toolBar->addAction(mToolManager->registerTool(new MagicWandTool(this)));
-    toolBar->addAction(mToolManager->registerTool(new SelectSameTileTool(this)));
+    toolBar->addAction(mToolManager->registerTool(magicWandTool));
+    toolBar->addAction(mToolManager->registerTool(selectSameTileTool));
     toolBar->addSeparator();
     toolBar->addAction(mToolManager->registerTool(new ObjectSelectionTool(this)));
     toolBar->addAction(mToolManager->registerTool(new EditPolygonTool(this)));
@@ -509,6 +560,12 @@ MainWindow::MainWindow(QWidget *parent, Qt::WindowFlags flags)
             this, SLOT(closeMapDocument(int)));
     connect(mDocumentManager, SIGNAL(reloadError(QString)),
             this, SLOT(reloadError(QString)));
+    connect(mDocumentManager, SIGNAL(saveError(QString)),
+            this, SLOT(saveError(QString)));
+    connect(mDocumentManager, &DocumentManager::documentSaved,
+            this, [this] (MapDocument *mapDocument) {
+        setRecentFile(mapDocument->fileName());
+    });
 
     QShortcut *switchToLeftDocument = new QShortcut(tr("Alt+Left"), this);
     connect(switchToLeftDocument, SIGNAL(activated()),
@@ -566,6 +623,8 @@ MainWindow::~MainWindow()
 
     TilesetManager::deleteInstance();
     DocumentManager::deleteInstance();
+    WorldManager::deleteInstance();
+    RenderProfiler::deleteInstance();
     Preferences::deleteInstance();
     LanguageManager::deleteInstance();
     PluginManager::deleteInstance();
@@ -629,8 +688,11 @@ void MainWindow::dragEnterEvent(QDragEnterEvent *e)
 
 void MainWindow::dropEvent(QDropEvent *e)
 {
+    QStringList fileNames;
     foreach (const QUrl &url, e->mimeData()->urls())
-        openFile(url.toLocalFile());
+        fileNames.append(url.toLocalFile());
+
+    openFiles(fileNames);
 }
 
 void MainWindow::newMap()
@@ -650,6 +712,9 @@ bool MainWindow::openFile(const QString &fileName,
     if (fileName.isEmpty())
         return false;
 
+    if (fileName.endsWith(QLatin1String(".world"), Qt::CaseInsensitive))
+        return openWorld(fileName);
+
     // Select existing document if this file is already open
     int documentIndex = mDocumentManager->findDocument(fileName);
     if (documentIndex != -1) {
@@ -674,6 +739,106 @@ bool MainWindow::openFile(const QString &fileName)
     return openFile(fileName, nullptr);
 }
 
+bool MainWindow::openWorld(const QString &fileName)
+{
+    QString error;
+    const World *world = WorldManager::instance()->loadWorld(fileName, &error);
+    if (!world) {
+        QMessageBox::critical(this, tr("Error Loading World"), error);
+        return false;
+    }
+
+    setRecentFile(fileName);
+
+    if (world->maps.isEmpty())
+        return true;
+
+    return openFile(world->maps.first().fileName, nullptr);
+}
+
+void MainWindow::openFiles(const QStringList &fileNames)
+{
+    if (fileNames.size() == 1) {
+        openFile(fileNames.first());
+        return;
+    }
+
+    for (const QString &fileName : fileNames) {
+        if (fileName.isEmpty())
+            continue;
+
+        if (fileName.endsWith(QLatin1String(".world"), Qt::CaseInsensitive)) {
+            openWorld(fileName);
+            continue;
+        }
+
+        // Files that are already open are only switched to
+        int documentIndex = mDocumentManager->findDocument(fileName);
+        if (documentIndex != -1) {
+            mDocumentManager->switchToDocument(documentIndex);
+            continue;
+        }
+
+        mMapLoader->load(fileName);
+    }
+}
+
+void MainWindow::mapLoaded(MapDocument *mapDocument)
+{
+    // The file may have been opened while it was being loaded
+    const QString &fileName = mapDocument->fileName();
+    int documentIndex = mDocumentManager->findDocument(fileName);
+    if (documentIndex != -1) {
+        delete mapDocument;
+        return;
+    }
+
+    mDocumentManager->addDocument(mapDocument);
+    setRecentFile(fileName);
+}
+
+void MainWindow::mapLoadFailed(const QString &fileName, const QString &error)
+{
+    Q_UNUSED(fileName)
+    QMessageBox::critical(this, tr("Error Opening Map"), error);
+}
+
+void MainWindow::mapLoadProgress(int finished, int total,
+                                 const QString &fileName)
+{
+    if (finished < total) {
+        statusBar()->showMessage(tr("Loaded %1 (%2 of %3 maps)")
+                                 .arg(QFileInfo(fileName).fileName())
+                                 .arg(finished)
+                                 .arg(total));
+    } else {
+        statusBar()->showMessage(tr("Loaded %n map(s)", "", total), 3000);
+
+        delete mMapLoadDialog;
+        mMapLoadDialog = nullptr;
+    }
+}
+
+void MainWindow::mapReadProgress(int permille)
+{
+    // The dialog only shows up when loading takes longer than its minimum
+    // duration, so that it doesn't flash by for small maps
+    if (!mMapLoadDialog) {
+        mMapLoadDialog = new QProgressDialog(tr("Loading maps..."),
+                                             tr("Cancel"), 0, 1000, this);
+        mMapLoadDialog->setWindowTitle(tr("Opening Maps"));
+        mMapLoadDialog->setAutoClose(false);
+        mMapLoadDialog->setAutoReset(false);
+        mMapLoadDialog->setMinimumDuration(1000);
+
+        connect(mMapLoadDialog, &QProgressDialog::canceled,
+                mMapLoader, &MapLoader::cancel);
+    }
+
+    if (!mMapLoadDialog->wasCanceled())
+        mMapLoadDialog->setValue(permille);
+}
+
 void MainWindow::openLastFiles()
 {
     mSettings.beginGroup(QLatin1String("recentFiles"));
@@ -702,6 +867,7 @@ void MainWindow::openLastFiles()
     QStringList selectedLayer = mSettings.value(
                 QLatin1String("selectedLayer")).toStringList();
 
+    QList<SessionFile> sessionFiles;
     for (int i = 0; i < lastOpenFiles.size(); i++) {
         if (!(i < mapScales.size()))
             continue;
@@ -712,31 +878,114 @@ void MainWindow::openLastFiles()
         if (!(i < selectedLayer.size()))
             continue;
 
-        if (openFile(lastOpenFiles.at(i))) {
-            MapView *mapView = mDocumentManager->currentMapView();
+        SessionFile file;
+        file.fileName = lastOpenFiles.at(i);
+        file.scale = mapScales.at(i).toDouble();
+        file.scrollX = scrollX.at(i).toInt();
+        file.scrollY = scrollY.at(i).toInt();
+        file.selectedLayer = selectedLayer.at(i).toInt();
+        sessionFiles.append(file);
+    }
 
-            // Restore camera to the previous position
-            qreal scale = mapScales.at(i).toDouble();
-            if (scale > 0)
-                mapView->zoomable()->setScale(scale);
+    const QString lastActiveDocument =
+            mSettings.value(QLatin1String("lastActive")).toString();
 
-            const int hor = scrollX.at(i).toInt();
-            const int ver = scrollY.at(i).toInt();
-            mapView->horizontalScrollBar()->setSliderPosition(hor);
-            mapView->verticalScrollBar()->setSliderPosition(ver);
+    mSettings.endGroup();
 
-            int layer = selectedLayer.at(i).toInt();
-            if (layer > 0 && layer < mMapDocument->map()->layerCount())
-                mMapDocument->setCurrentLayerIndex(layer);
+    if (sessionFiles.isEmpty())
+        return;
+
+    int activeIndex = 0;
+    for (int i = 0; i < sessionFiles.size(); i++) {
+        if (sessionFiles.at(i).fileName == lastActiveDocument) {
+            activeIndex = i;
+            break;
         }
     }
-    QString lastActiveDocument =
-            mSettings.value(QLatin1String("lastActive")).toString();
-    int documentIndex = mDocumentManager->findDocument(lastActiveDocument);
-    if (documentIndex != -1)
-        mDocumentManager->switchToDocument(documentIndex);
 
-    mSettings.endGroup();
+    mSessionFileNames.clear();
+    for (const SessionFile &file : sessionFiles)
+        mSessionFileNames.append(file.fileName);
+
+    // Only the active map is loaded right away. The others are loaded one
+    // at a time while the application is idle, nearest tabs first.
+    const SessionFile &activeFile = sessionFiles.at(activeIndex);
+    if (openFile(activeFile.fileName))
+        restoreViewState(mMapDocument, activeFile);
+
+    mPendingSessionFiles.clear();
+    for (int distance = 1; distance < sessionFiles.size(); distance++) {
+        if (activeIndex + distance < sessionFiles.size())
+            mPendingSessionFiles.append(sessionFiles.at(activeIndex + distance));
+        if (activeIndex - distance >= 0)
+            mPendingSessionFiles.append(sessionFiles.at(activeIndex - distance));
+    }
+
+    if (!mPendingSessionFiles.isEmpty())
+        QTimer::singleShot(0, this, SLOT(restoreNextSessionFile()));
+}
+
+/**
+ * Loads the next pending file of the previous session into a tab in the
+ * background, without switching to it. Tilesets that are already loaded
+ * are shared through the tileset manager, so they are not read again.
+ */
+void MainWindow::restoreNextSessionFile()
+{
+    if (mPendingSessionFiles.isEmpty())
+        return;
+
+    const SessionFile file = mPendingSessionFiles.takeFirst();
+
+    // The user may have opened the file in the meantime
+    if (mDocumentManager->findDocument(file.fileName) == -1) {
+        TraceScope trace("MainWindow::restoreNextSessionFile", file.fileName);
+
+        QString error;
+        if (MapDocument *mapDocument = MapDocument::load(file.fileName, nullptr, &error)) {
+            mDocumentManager->insertDocument(sessionTabIndex(file.fileName),
+                                             mapDocument);
+            restoreViewState(mapDocument, file);
+        } else {
+            qWarning() << qPrintable(error);
+        }
+    }
+
+    if (!mPendingSessionFiles.isEmpty())
+        QTimer::singleShot(0, this, SLOT(restoreNextSessionFile()));
+}
+
+void MainWindow::restoreViewState(MapDocument *mapDocument,
+                                  const SessionFile &file)
+{
+    MapView *mapView = mDocumentManager->viewForDocument(mapDocument);
+
+    // Restore camera to the previous position
+    if (file.scale > 0)
+        mapView->zoomable()->setScale(file.scale);
+
+    mapView->horizontalScrollBar()->setSliderPosition(file.scrollX);
+    mapView->verticalScrollBar()->setSliderPosition(file.scrollY);
+
+    const int layer = file.selectedLayer;
+    if (layer > 0 && layer < mapDocument->map()->layerCount())
+        mapDocument->setCurrentLayerIndex(layer);
+}
+
+/**
+ * Returns the tab index for restoring the given session file, which is
+ * right after the closest preceding session file that is open. This way
+ * the tabs end up in the order they had in the previous session.
+ */
+int MainWindow::sessionTabIndex(const QString &fileName) const
+{
+    for (int i = mSessionFileNames.indexOf(fileName) - 1; i >= 0; --i) {
+        const int index = mDocumentManager->findDocument(mSessionFileNames.at(i));
+        if (index != -1)
+            return index + 1;
+    }
+
+    return 0;
 }
 
 void MainWindow::openFile()
@@ -746,6 +995,8 @@ void MainWindow::openFile()
 
     QString selectedFilter = TmxMapFormat().nameFilter();
     filter += selectedFilter;
+    filter += QLatin1String(";;");
+    filter += tr("World files (*.world)");
 
     FormatHelper<MapFormat> helper(MapFormat::Read, filter);
 
@@ -763,8 +1014,13 @@ void MainWindow::openFile()
     MapFormat *mapFormat = helper.formatByNameFilter(selectedFilter);
 
     mSettings.setValue(QLatin1String("lastUsedOpenFilter"), selectedFilter);
-    foreach (const QString &fileName, fileNames)
-        openFile(fileName, mapFormat);
+
+    if (mapFormat) {
+        foreach (const QString &fileName, fileNames)
+            openFile(fileName, mapFormat);
+    } else {
+        openFiles(fileNames);
+    }
 }
 
 bool MainWindow::saveFile(const QString &fileName)
@@ -781,7 +1037,6 @@ bool MainWindow::saveFile(const QString &fileName)
         return false;
     }
 
-    setRecentFile(fileName);
     return true;
 }
 
@@ -798,6 +1053,26 @@ bool MainWindow::saveFile()
         return saveFile(currentFileName);
 }
 
+/**
+ * Saves the current map to its file name without blocking the user
+ * interface. Errors are reported through DocumentManager::saveError.
+ */
+void MainWindow::saveFileInBackground()
+{
+    if (!mMapDocument)
+        return;
+
+    const QString currentFileName = mMapDocument->fileName();
+
+    if (currentFileName.isEmpty()) {
+        saveFileAs();
+        return;
+    }
+
+    // The file is added to the recent files once it has been saved
+    mMapDocument->saveInBackground(currentFileName);
+}
+
 bool MainWindow::saveFileAs()
 {
     const QString tmxFilter = TmxMapFormat().nameFilter();
@@ -853,8 +1128,6 @@ void MainWindow::saveAll()
             QMessageBox::critical(this, tr("Error Saving Map"), error);
             return;
         }
-
-        setRecentFile(fileName);
     }
 }
 
@@ -897,23 +1170,12 @@ void MainWindow::export_()
     QString exportFileName = mMapDocument->lastExportFileName();
 
     if (!exportFileName.isEmpty()) {
-        MapFormat *exportFormat = mMapDocument->exportFormat();
-        TmxMapFormat tmxFormat;
-
-        if (!exportFormat)
-            exportFormat = &tmxFormat;
-
-        if (exportFormat->write(mMapDocument->map(), exportFileName)) {
-            statusBar()->showMessage(tr("Exported to %1").arg(exportFileName),
-                                     3000);
-            return;
-        }
-
-        QMessageBox::critical(this, tr("Error Exporting Map"),
-                              exportFormat->errorString());
+        // A null format exports to TMX
+        exportInBackground(mMapDocument->exportFormat(), exportFileName);
+        return;
     }
 
-    // fall back when no successful export happened
+    // fall back when there is nothing to export to yet
     exportAs();
 }
 
@@ -1025,15 +1287,63 @@ void MainWindow::exportAs()
     pref->setLastPath(Preferences::ExportedFile, QFileInfo(fileName).path());
     mSettings.setValue(QLatin1String("lastUsedExportFilter"), selectedFilter);
 
-    if (!chosenFormat->write(mMapDocument->map(), fileName)) {
-        QMessageBox::critical(this, tr("Error Exporting Map"),
-                              chosenFormat->errorString());
+    exportInBackground(chosenFormat != &tmxMapFormat ? chosenFormat : nullptr,
+                       fileName);
+}
+
+/**
+ * Exports a snapshot of the current map on a separate thread, so that slow
+ * formats, like those implemented by scripts, don't block the user
+ * interface. A null \a format exports to TMX.
+ *
+ * When enabled in the preferences, the snapshot uses tilesets repacked into
+ * atlases of only the used tiles.
+ */
+void MainWindow::exportInBackground(MapFormat *format, const QString &fileName)
+{
+    Map *snapshot = nullptr;
+
+    // Repacking happens on the main thread, since the tilesets of the
+    // atlases create their pixmaps
+    if (Preferences::instance()->repackTilesetsOnExport()) {
+        TilesetRepacker repacker;
+        snapshot = repacker.repack(mMapDocument->map(), fileName);
+        if (!snapshot) {
+            QMessageBox::critical(this, tr("Error Exporting Map"),
+                                  repacker.errorString());
+            return;
+        }
     } else {
-        // Remember export parameters, so subsequent exports can be done faster
-        mMapDocument->setLastExportFileName(fileName);
-        if (chosenFormat != &tmxMapFormat)
-            mMapDocument->setExportFormat(chosenFormat);
+        snapshot = new Map(*mMapDocument->map());
+        snapshot->setNextObjectId(mMapDocument->map()->nextObjectId());
     }
+
+    MapSaver *saver = new MapSaver(snapshot, format, fileName, this);
+    QPointer<MapDocument> mapDocument(mMapDocument);
+    QPointer<MapFormat> exportFormat(format);
+
+    connect(saver, &QThread::finished, this, [=] {
+        saver->deleteLater();
+
+        if (!saver->succeeded()) {
+            statusBar()->clearMessage();
+            QMessageBox::critical(this, tr("Error Exporting Map"),
+                                  saver->errorString());
+            return;
+        }
+
+        // Remember export parameters, so subsequent exports can be done faster
+        if (mapDocument) {
+            mapDocument->setLastExportFileName(fileName);
+            if (exportFormat)
+                mapDocument->setExportFormat(exportFormat);
+        }
+
+        statusBar()->showMessage(tr("Exported to %1").arg(fileName), 3000);
+    });
+
+    statusBar()->showMessage(tr("Exporting to %1...").arg(fileName));
+    saver->start();
 }
 
 void MainWindow::exportAsImage()
@@ -1208,6 +1518,25 @@ void MainWindow::zoomNormal()
         mapView->zoomable()->resetZoom();
 }
 
+/**
+ * Saves the frames captured by the render profiler since the performance
+ * overlay was enabled.
+ */
+void MainWindow::savePerformanceCapture()
+{
+    const QString fileName =
+            QFileDialog::getSaveFileName(this, tr("Save Performance Capture"),
+                                         QString(),
+                                         tr("JSON files (*.json)"));
+    if (fileName.isEmpty())
+        return;
+
+    if (!RenderProfiler::instance()->saveCapture(fileName)) {
+        QMessageBox::critical(this, tr("Error Saving Performance Capture"),
+                              tr("Could not write to %1.").arg(fileName));
+    }
+}
+
 bool MainWindow::newTileset(const QString &path)
 {
     if (!mMapDocument)
@@ -1615,6 +1944,19 @@ void MainWindow::writeSettings()
                        mapView->verticalScrollBar()->sliderPosition()));
         selectedLayer.append(QString::number(currentLayerIndex));
     }
+
+    // Files of the previous session that were not restored yet stay open
+    for (const SessionFile &file : mPendingSessionFiles) {
+        if (fileList.contains(file.fileName))
+            continue;
+
+        fileList.append(file.fileName);
+        mapScales.append(QString::number(file.scale));
+        scrollX.append(QString::number(file.scrollX));
+        scrollY.append(QString::number(file.scrollY));
+        selectedLayer.append(QString::number(file.selectedLayer));
+    }
+
     mSettings.setValue(QLatin1String("lastOpenFiles"), fileList);
     mSettings.setValue(QLatin1String("mapScale"), mapScales);
     mSettings.setValue(QLatin1String("scrollX"), scrollX);
@@ -1667,6 +2009,7 @@ void MainWindow::retranslateUi()
     updateWindowTitle();
 
     mRandomButton->setToolTip(tr("Random Mode"));
+    mAllLayersButton->setToolTip(tr("Match All Layers"));
     mLayerMenu->setTitle(tr("&Layer"));
     mViewsAndToolbarsMenu->setText(tr("Views and Toolbars"));
     mShowTileAnimationEditor->setText(tr("Tile Animation Editor"));
@@ -1696,6 +2039,7 @@ void MainWindow::mapDocumentChanged(MapDocument *mapDocument)
     mTilesetDock->setMapDocument(mapDocument);
     mTerrainDock->setMapDocument(mapDocument);
     mMiniMapDock->setMapDocument(mapDocument);
+    mMapAnalysisDock->setMapDocument(mapDocument);
     mTileAnimationEditor->setMapDocument(mapDocument);
     mTileCollisionEditor->setMapDocument(mapDocument);
     mToolManager->setMapDocument(mapDocument);
@@ -1772,3 +2116,8 @@ void MainWindow::reloadError(const QString &error)
 {
     QMessageBox::critical(this, tr("Error Reloading Map"), error);
 }
+
+void MainWindow::saveError(const QString &error)
+{
+    QMessageBox::critical(this, tr("Error Saving Map"), error);
+}
@@ -33,6 +33,7 @@
 
 class QComboBox;
 class QLabel;
+class QProgressDialog;
 class QToolButton;
 
 namespace Ui {
@@ -51,7 +52,9 @@ class BucketFillTool;
 class CommandButton;
 class DocumentManager;
 class LayerDock;
+class MapAnalysisDock;
 class MapDocumentActionHandler;
+class MapLoader;
 class MapScene;
 class MapsDock;
 class MapView;
@@ -97,7 +100,21 @@ public:
     bool openFile(const QString &fileName, MapFormat *format);
 
     /**
-     * Attempt to open the previously opened file.
+     * Opens the given files. When there are several of them, they are
+     * loaded concurrently and added as they finish loading.
+     */
+    void openFiles(const QStringList &fileNames);
+
+    /**
+     * Loads the world stored in \a fileName and opens its first map. The
+     * other maps of the world are shown around the maps that are part of it.
+     */
+    bool openWorld(const QString &fileName);
+
+    /**
+     * Attempt to open the previously opened files. Only the previously
+     * active file is opened right away, the others are restored in the
+     * background.
      */
     void openLastFiles();
 
@@ -118,6 +135,7 @@ private slots:
     void newMap();
     void openFile();
     bool saveFile();
+    void saveFileInBackground();
     bool saveFileAs();
     void saveAll();
     void export_(); // 'export' is a reserved word
@@ -137,6 +155,7 @@ private slots:
     void zoomIn();
     void zoomOut();
     void zoomNormal();
+    void savePerformanceCapture();
 
     bool newTileset(const QString &path = QString());
     void newTilesets(const QStringList &paths);
@@ -171,12 +190,20 @@ private slots:
     void closeMapDocument(int index);
 
     void reloadError(const QString &error);
+    void saveError(const QString &error);
     void autoMappingError(bool automatic);
     void autoMappingWarning(bool automatic);
 
     void onAnimationEditorClosed();
     void onCollisionEditorClosed();
 
+    void restoreNextSessionFile();
+
+    void mapLoaded(MapDocument *mapDocument);
+    void mapLoadFailed(const QString &fileName, const QString &error);
+    void mapLoadProgress(int finished, int total, const QString &fileName);
+    void mapReadProgress(int permille);
+
 private:
     /**
       * Asks the user whether the given \a mapDocument should be saved, when
@@ -205,6 +232,8 @@ private:
      */
     bool saveFile(const QString &fileName);
 
+    void exportInBackground(MapFormat *format, const QString &fileName);
+
     void writeSettings();
     void readSettings();
 
@@ -226,6 +255,7 @@ private:
     TerrainDock *mTerrainDock;
     MiniMapDock* mMiniMapDock;
     ConsoleDock *mConsoleDock;
+    MapAnalysisDock *mMapAnalysisDock;
     TileAnimationEditor *mTileAnimationEditor;
     TileCollisionEditor *mTileCollisionEditor;
     QLabel *mCurrentLayerLabel;
@@ -234,6 +264,7 @@ private:
     QLabel *mStatusInfoLabel;
     QSettings mSettings;
     QToolButton *mRandomButton;
+    QToolButton *mAllLayersButton;
     CommandButton *mCommandButton;
 
     StampBrush *mStampBrush;
@@ -250,10 +281,31 @@ private:
 
     void setupQuickStamps();
 
+    /**
+     * A file that was open in the previous session, along with the state
+     * of its view.
+     */
+    struct SessionFile
+    {
+        QString fileName;
+        qreal scale;
+        int scrollX;
+        int scrollY;
+        int selectedLayer;
+    };
+
+    void restoreViewState(MapDocument *mapDocument, const SessionFile &file);
+    int sessionTabIndex(const QString &fileName) const;
+
+    QStringList mSessionFileNames;
+    QList<SessionFile> mPendingSessionFiles;
+
     AutomappingManager *mAutomappingManager;
     DocumentManager *mDocumentManager;
     ToolManager *mToolManager;
     TileStampManager *mTileStampManager;
+    MapLoader *mMapLoader;
+    QProgressDialog *mMapLoadDialog;
 };
 
 } // namespace Internal
@@ -0,0 +1,225 @@
+/*
+ * mapanalysisdock.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapanalysisdock.h"
+
+#include "layer.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tileset.h"
+
+#include <QEvent>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+enum {
+    IssueIndexRole = Qt::UserRole
+};
+
+} // anonymous namespace
+
+MapAnalysisDock::MapAnalysisDock(QWidget *parent)
+    : QDockWidget(parent)
+    , mOutdated(false)
+    , mTreeWidget(new QTreeWidget)
+    , mAnalyzeButton(new QPushButton)
+{
+    setObjectName(QLatin1String("MapAnalysisDock"));
+
+    QWidget *widget = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(widget);
+    layout->setMargin(5);
+
+    mTreeWidget->setColumnCount(2);
+    mTreeWidget->setUniformRowHeights(true);
+    mTreeWidget->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    mTreeWidget->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    mTreeWidget->header()->setStretchLastSection(false);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout;
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(mAnalyzeButton);
+
+    layout->addWidget(mTreeWidget);
+    layout->addLayout(buttonLayout);
+
+    setWidget(widget);
+
+    connect(mAnalyzeButton, &QPushButton::clicked,
+            this, &MapAnalysisDock::analyze);
+    connect(mTreeWidget, &QTreeWidget::itemActivated,
+            this, &MapAnalysisDock::itemActivated);
+
+    retranslateUi();
+}
+
+void MapAnalysisDock::setMapDocument(MapDocument *mapDocument)
+{
+    if (mMapDocument == mapDocument)
+        return;
+
+    mMapDocument = mapDocument;
+    mOutdated = true;
+
+    if (isVisible())
+        analyze();
+}
+
+void MapAnalysisDock::changeEvent(QEvent *e)
+{
+    QDockWidget::changeEvent(e);
+    switch (e->type()) {
+    case QEvent::LanguageChange:
+        retranslateUi();
+        break;
+    default:
+        break;
+    }
+}
+
+void MapAnalysisDock::showEvent(QShowEvent *e)
+{
+    QDockWidget::showEvent(e);
+    if (mOutdated)
+        analyze();
+}
+
+void MapAnalysisDock::analyze()
+{
+    mOutdated = false;
+    mTreeWidget->clear();
+    mReport = MapAnalyzer::Report();
+
+    if (!mMapDocument)
+        return;
+
+    MapAnalyzer analyzer;
+    analyzer.addMap(mMapDocument->map());
+    analyzer.analyze();
+    mReport = analyzer.reports().first();
+
+    QTreeWidgetItem *issuesItem = new QTreeWidgetItem(mTreeWidget);
+    issuesItem->setText(0, tr("Problems"));
+    issuesItem->setText(1, QString::number(mReport.issues.size()));
+
+    for (int i = 0; i < mReport.issues.size(); ++i) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(issuesItem);
+        item->setText(0, mReport.issues.at(i).message);
+        item->setData(0, IssueIndexRole, i);
+    }
+
+    QTreeWidgetItem *layersItem = new QTreeWidgetItem(mTreeWidget);
+    layersItem->setText(0, tr("Layers"));
+    layersItem->setText(1, QString::number(mReport.layers.size()));
+
+    for (const MapAnalyzer::LayerStatistics &statistics : mReport.layers) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(layersItem);
+        item->setText(0, statistics.layer->name());
+
+        if (statistics.layer->isTileLayer()) {
+            item->setText(1, tr("%1% filled")
+                          .arg(statistics.fillRatio() * 100, 0, 'f', 1));
+        } else if (statistics.layer->isObjectGroup()) {
+            item->setText(1, tr("%n object(s)", "", statistics.objectCount));
+        }
+        item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    // The most used tiles first
+    QVector<QPair<int, const Tile*>> usage;
+    usage.reserve(mReport.tileUsage.size());
+    for (auto it = mReport.tileUsage.begin(); it != mReport.tileUsage.end(); ++it)
+        usage.append(qMakePair(it.value(), it.key()));
+
+    std::sort(usage.begin(), usage.end(),
+              [] (const QPair<int, const Tile*> &a, const QPair<int, const Tile*> &b) {
+        return a.first > b.first;
+    });
+
+    QTreeWidgetItem *tilesItem = new QTreeWidgetItem(mTreeWidget);
+    tilesItem->setText(0, tr("Tile usage"));
+    tilesItem->setText(1, QString::number(usage.size()));
+
+    for (const auto &entry : usage) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(tilesItem);
+        item->setText(0, tr("%1, tile %2")
+                      .arg(entry.second->tileset()->name())
+                      .arg(entry.second->id()));
+        item->setText(1, QString::number(entry.first));
+        item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    for (int i = 0; i < mTreeWidget->topLevelItemCount(); ++i)
+        mTreeWidget->topLevelItem(i)->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+
+    issuesItem->setExpanded(true);
+}
+
+void MapAnalysisDock::itemActivated(QTreeWidgetItem *item)
+{
+    const QVariant index = item->data(0, IssueIndexRole);
+    if (!index.isValid() || !mMapDocument)
+        return;
+
+    const MapAnalyzer::Issue &issue = mReport.issues.at(index.toInt());
+    Map *map = mMapDocument->map();
+
+    // The map may have changed since it was analyzed
+    const int layerIndex = map->layers().indexOf(const_cast<Layer*>(issue.layer));
+    if (layerIndex == -1)
+        return;
+
+    mMapDocument->setCurrentLayerIndex(layerIndex);
+
+    if (issue.objectId == 0)
+        return;
+
+    if (ObjectGroup *objectGroup = map->layerAt(layerIndex)->asObjectGroup()) {
+        for (MapObject *object : objectGroup->objects()) {
+            if (object->id() == issue.objectId) {
+                mMapDocument->setSelectedObjects(QList<MapObject*>() << object);
+                break;
+            }
+        }
+    }
+}
+
+void MapAnalysisDock::retranslateUi()
+{
+    setWindowTitle(tr("Map Analysis"));
+    mTreeWidget->setHeaderLabels(QStringList() << tr("Name") << tr("Value"));
+    mAnalyzeButton->setText(tr("Analyze"));
+
+    if (isVisible())
+        analyze();
+}
@@ -0,0 +1,77 @@
+/*
+ * mapanalysisdock.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPANALYSISDOCK_H
+#define MAPANALYSISDOCK_H
+
+#include "mapanalyzer.h"
+
+#include <QDockWidget>
+#include <QPointer>
+
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace Tiled {
+namespace Internal {
+
+class MapDocument;
+
+/**
+ * Shows the problems found in the current map and its statistics, like the
+ * fill ratio of each tile layer and how often each tile is used.
+ *
+ * The map is analyzed when it becomes the current map and when requested,
+ * since there is no need to keep the results up to date while editing.
+ * Activating a problem selects the layer or object it is about.
+ */
+class MapAnalysisDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MapAnalysisDock(QWidget *parent = nullptr);
+
+    void setMapDocument(MapDocument *mapDocument);
+
+protected:
+    void changeEvent(QEvent *e) override;
+    void showEvent(QShowEvent *e) override;
+
+private slots:
+    void analyze();
+    void itemActivated(QTreeWidgetItem *item);
+
+private:
+    void retranslateUi();
+
+    QPointer<MapDocument> mMapDocument;
+    MapAnalyzer::Report mReport;
+    bool mOutdated;
+
+    QTreeWidget *mTreeWidget;
+    QPushButton *mAnalyzeButton;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MAPANALYSISDOCK_H
@@ -0,0 +1,307 @@
+/*
+ * mapbenchmark.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapbenchmark.h"
+
+#include "automappingmanager.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "mapimageexporter.h"
+#include "maprenderer.h"
+#include "painttilelayer.h"
+#include "tilelayer.h"
+#include "tilepainter.h"
+#include "tileset.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <QScopedPointer>
+#include <QUndoStack>
+
+#include <cmath>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+// The scene is rendered in tiles of this size, so that large maps can be
+// rendered at any zoom without running out of memory
+const int RenderTileSize = 2048;
+
+// The number of times the stamp is painted for the stamp paint step
+const int StampCount = 1000;
+
+const qreal zoomLevels[] = { 0.25, 0.5, 1.0, 2.0 };
+
+QString tr(const char *text)
+{
+    return QCoreApplication::translate("Command line", text);
+}
+
+void report(const QString &fileName, const QString &step, qint64 ms)
+{
+    qWarning() << qPrintable(QString(QLatin1String("%1\t%2\t%3 ms"))
+                             .arg(fileName, step).arg(ms));
+}
+
+void reportSkipped(const QString &fileName, const QString &step,
+                   const QString &reason)
+{
+    qWarning() << qPrintable(QString(QLatin1String("%1\t%2\t%3"))
+                             .arg(fileName, step, reason));
+}
+
+/**
+ * Renders all visible layers of the map at the given \a zoom, the same way
+ * the map is exported as an image, but without keeping the image.
+ */
+void renderScene(const MapDocument *mapDocument, qreal zoom)
+{
+    MapRenderer *renderer = mapDocument->renderer();
+    const qreal previousScale = renderer->painterScale();
+    renderer->setPainterScale(zoom);
+
+    MapImageExporter sceneDrawer(mapDocument->map(), QString());
+
+    const QSize mapSize = renderer->mapSize();
+    const int width = int(std::ceil(mapSize.width() * zoom));
+    const int height = int(std::ceil(mapSize.height() * zoom));
+
+    QImage image(qMin(width, RenderTileSize),
+                 qMin(height, RenderTileSize),
+                 QImage::Format_ARGB32_Premultiplied);
+
+    for (int y = 0; y < height; y += image.height()) {
+        for (int x = 0; x < width; x += image.width()) {
+            image.fill(Qt::transparent);
+
+            QPainter painter(&image);
+            painter.translate(-x, -y);
+            painter.scale(zoom, zoom);
+
+            const QRectF exposed = painter.transform().inverted()
+                    .mapRect(QRectF(image.rect()));
+
+            sceneDrawer.drawMap(painter, renderer, exposed);
+        }
+    }
+
+    renderer->setPainterScale(previousScale);
+}
+
+/**
+ * Returns the first tile layer of the map that has cells, or the first tile
+ * layer when all of them are empty.
+ */
+TileLayer *benchmarkLayer(Map *map)
+{
+    const QList<TileLayer*> tileLayers = map->tileLayers();
+    for (TileLayer *tileLayer : tileLayers)
+        if (!tileLayer->isEmpty())
+            return tileLayer;
+
+    return tileLayers.isEmpty() ? nullptr : tileLayers.first();
+}
+
+/**
+ * Returns a cell of the first tileset of the map that differs from
+ * \a other, so that filling with it changes something.
+ */
+Cell benchmarkCell(const Map *map, const Cell &other)
+{
+    if (map->tilesets().isEmpty())
+        return Cell();
+
+    const Tileset *tileset = map->tilesets().first().data();
+    for (int i = 0; i < tileset->tileCount(); ++i) {
+        const Cell cell(tileset->tileAt(i));
+        if (cell != other)
+            return cell;
+    }
+
+    return Cell();
+}
+
+/**
+ * Returns the position of the cell at the center of \a tileLayer, in layer
+ * coordinates.
+ */
+QPoint centerOf(const TileLayer *tileLayer)
+{
+    return QPoint(tileLayer->width() / 2, tileLayer->height() / 2);
+}
+
+/**
+ * Flood-fills the area around the center of \a tileLayer with \a cell, like
+ * the bucket fill tool.
+ */
+void floodFill(MapDocument *mapDocument, TileLayer *tileLayer,
+               const Cell &cell)
+{
+    const QPoint origin = tileLayer->position() + centerOf(tileLayer);
+    const QRegion fillRegion = TilePainter::computeFillMask(tileLayer, origin).toRegion();
+
+    TileLayer fill(QString(), tileLayer->x(), tileLayer->y(),
+                   tileLayer->width(), tileLayer->height());
+    {
+        TileLayer::BulkEdit bulkEdit(&fill);
+        for (const QRect &rect : fillRegion.rects())
+            for (int y = rect.top(); y <= rect.bottom(); ++y)
+                for (int x = rect.left(); x <= rect.right(); ++x)
+                    fill.setCell(x - fill.x(), y - fill.y(), cell);
+    }
+
+    PaintTileLayer *paint = new PaintTileLayer(mapDocument, tileLayer,
+                                               fill.x(), fill.y(), &fill);
+    paint->setText(tr("Fill Area"));
+    mapDocument->undoStack()->push(paint);
+}
+
+/**
+ * Paints a 3x3 stamp of \a cell many times along a diagonal stroke over
+ * \a tileLayer, merging the paint commands like the stamp brush does.
+ */
+void stampPaint(MapDocument *mapDocument, TileLayer *tileLayer,
+                const Cell &cell)
+{
+    TileLayer stamp(QString(), 0, 0, 3, 3);
+    for (int y = 0; y < stamp.height(); ++y)
+        for (int x = 0; x < stamp.width(); ++x)
+            stamp.setCell(x, y, cell);
+
+    const int width = qMax(1, tileLayer->width() - stamp.width());
+    const int height = qMax(1, tileLayer->height() - stamp.height());
+
+    for (int i = 0; i < StampCount; ++i) {
+        const int x = tileLayer->x() + (i * 2) % width;
+        const int y = tileLayer->y() + (i * 3) % height;
+
+        PaintTileLayer *paint = new PaintTileLayer(mapDocument, tileLayer,
+                                                   x, y, &stamp);
+        paint->setText(tr("Paint"));
+        paint->setMergeable(i > 0);
+        mapDocument->undoStack()->push(paint);
+    }
+}
+
+/**
+ * Runs the benchmark steps on the map in \a fileName. Returns whether the
+ * map could be loaded.
+ */
+bool benchmarkMap(const QString &fileName,
+                  AutomappingManager &automappingManager)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    QScopedPointer<MapDocument> mapDocument(MapDocument::load(fileName, nullptr, &error));
+    if (!mapDocument) {
+        qWarning() << qPrintable(tr("Failed to load %1: %2").arg(fileName, error));
+        return false;
+    }
+
+    // Include the decoding of lazily loaded layers
+    for (TileLayer *tileLayer : mapDocument->map()->tileLayers())
+        tileLayer->load();
+
+    report(fileName, QLatin1String("open"), timer.elapsed());
+
+    for (qreal zoom : zoomLevels) {
+        timer.restart();
+        renderScene(mapDocument.data(), zoom);
+        report(fileName, QString(QLatin1String("render %1x")).arg(zoom), timer.elapsed());
+    }
+
+    TileLayer *tileLayer = benchmarkLayer(mapDocument->map());
+    const Cell cell = tileLayer
+            ? benchmarkCell(mapDocument->map(), tileLayer->cellAt(centerOf(tileLayer)))
+            : Cell();
+
+    if (cell.isEmpty()) {
+        const QString reason = tr("skipped (no tile layer or tileset)");
+        reportSkipped(fileName, QLatin1String("flood fill"), reason);
+        reportSkipped(fileName, QLatin1String("stamp paint"), reason);
+    } else {
+        timer.restart();
+        floodFill(mapDocument.data(), tileLayer, cell);
+        report(fileName, QLatin1String("flood fill"), timer.elapsed());
+
+        timer.restart();
+        stampPaint(mapDocument.data(), tileLayer, cell);
+        report(fileName, QLatin1String("stamp paint"), timer.elapsed());
+    }
+
+    timer.restart();
+    automappingManager.setMapDocument(mapDocument.data());
+    automappingManager.autoMap();
+    automappingManager.setMapDocument(nullptr);
+    report(fileName, QLatin1String("automap"), timer.elapsed());
+
+    QUndoStack *undoStack = mapDocument->undoStack();
+    const int commandCount = undoStack->count();
+
+    timer.restart();
+    undoStack->setIndex(0);
+    report(fileName, QString(QLatin1String("undo %1")).arg(commandCount), timer.elapsed());
+
+    timer.restart();
+    undoStack->setIndex(commandCount);
+    report(fileName, QString(QLatin1String("redo %1")).arg(commandCount), timer.elapsed());
+
+    return true;
+}
+
+} // anonymous namespace
+
+/**
+ * Runs a fixed script on each of the given maps and prints how long each
+ * step took: opening the map, rendering the whole scene offscreen at several
+ * zoom levels, a flood fill, a stroke of stamp painting, automapping on the
+ * whole map and undoing and redoing all of it. The maps are not saved.
+ *
+ * Each line has the file name, the step and the time, separated by tabs, so
+ * that the results of different runs can be compared easily.
+ *
+ * Returns the exit code, which is 1 when any of the maps failed to load.
+ */
+int Tiled::Internal::benchmarkMaps(const QStringList &fileNames)
+{
+    AutomappingManager automappingManager;
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    int failed = 0;
+
+    for (const QString &fileName : fileNames)
+        if (!benchmarkMap(fileName, automappingManager))
+            ++failed;
+
+    report(tr("total"), tr("%1 of %2 maps").arg(fileNames.size() - failed)
+                                            .arg(fileNames.size()),
+           totalTimer.elapsed());
+
+    return failed > 0 ? 1 : 0;
+}
@@ -24,6 +24,7 @@
 #include "addremovelayer.h"
 #include "addremovemapobject.h"
 #include "addremovetileset.h"
+#include "changenotifier.h"
 #include "changeproperties.h"
 #include "changeselectedarea.h"
 #include "containerhelpers.h"
@@ -31,10 +32,12 @@
 #include "hexagonalrenderer.h"
 #include "imagelayer.h"
 #include "isometricrenderer.h"
+#include "layercompressor.h"
 #include "layermodel.h"
 #include "mapobjectmodel.h"
 #include "map.h"
 #include "mapobject.h"
+#include "mapsaver.h"
 #include "movelayer.h"
 #include "movemapobject.h"
 #include "movemapobjecttogroup.h"
@@ -43,8 +46,8 @@
 #include "orthogonalrenderer.h"
 #include "painttilelayer.h"
 #include "pluginmanager.h"
+#include "preferences.h"
 #include "resizemap.h"
-#include "resizetilelayer.h"
 #include "rotatemapobject.h"
 #include "staggeredrenderer.h"
 #include "terrain.h"
@@ -53,11 +56,18 @@
 #include "tilelayer.h"
 #include "tilesetmanager.h"
 #include "tmxmapformat.h"
+#include "tracing.h"
+#include "transformtilelayers.h"
+#include "undomemory.h"
 
 #include <QFileInfo>
+#include <QMutexLocker>
 #include <QRect>
+#include <QSet>
 #include <QUndoStack>
 
+#include <algorithm>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -69,7 +79,14 @@ MapDocument::MapDocument(Map *map, const QString &fileName):
     mRenderer(nullptr),
     mMapObjectModel(new MapObjectModel(this)),
     mTerrainModel(new TerrainModel(this, this)),
-    mUndoStack(new QUndoStack(this))
+    mUndoStack(new QUndoStack(this)),
+    mChangeNotifier(new ChangeNotifier(this)),
+    mRegionChangeBatchDepth(0),
+    mRandomSeed(RandomGenerator::defaultSeed()),
+    mRandomGenerator(mRandomSeed),
+    mSaver(nullptr),
+    mMapChangedDuringSave(false),
+    mCleanStateLost(false)
 {
     createRenderer();
 
@@ -86,6 +103,18 @@ MapDocument::MapDocument(Map *map, const QString &fileName):
     connect(mLayerModel, &LayerModel::layerChanged,
             this, &MapDocument::layerChanged);
 
+    // Forget the encoded data of tile layers that changed
+    connect(this, &MapDocument::regionChanged,
+            this, [this] (const QRegion &, Layer *layer) {
+        mLayerDataCache.remove(layer);
+        if (mSaver)
+            mLayersChangedDuringSave.insert(layer);
+    });
+    connect(this, &MapDocument::mapChanged, this, [this] {
+        mLayerDataCache.clear();
+        mMapChangedDuringSave = true;
+    });
+
     // Forward signals emitted from the map object model
     mMapObjectModel->setMapDocument(this);
     connect(mMapObjectModel, SIGNAL(objectsAdded(QList<MapObject*>)),
@@ -95,18 +124,25 @@ MapDocument::MapDocument(Map *map, const QString &fileName):
     connect(mMapObjectModel, SIGNAL(objectsRemoved(QList<MapObject*>)),
             SLOT(onObjectsRemoved(QList<MapObject*>)));
 
-    connect(mMapObjectModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
-            SLOT(onMapObjectModelRowsInserted(QModelIndex,int,int)));
-    connect(mMapObjectModel, SIGNAL(rowsRemoved(QModelIndex,int,int)),
-            SLOT(onMapObjectModelRowsInsertedOrRemoved(QModelIndex,int,int)));
-    connect(mMapObjectModel, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
-            SLOT(onObjectsMoved(QModelIndex,int,int,QModelIndex,int)));
+    connect(mMapObjectModel, SIGNAL(objectsInserted(ObjectGroup*,int,int)),
+            SIGNAL(objectsInserted(ObjectGroup*,int,int)));
+    connect(mMapObjectModel, SIGNAL(objectsIndexChanged(ObjectGroup*,int,int)),
+            SIGNAL(objectsIndexChanged(ObjectGroup*,int,int)));
 
     connect(mTerrainModel, SIGNAL(terrainRemoved(Terrain*)),
             SLOT(onTerrainRemoved(Terrain*)));
 
     connect(mUndoStack, SIGNAL(cleanChanged(bool)), SIGNAL(modifiedChanged()));
 
+    // Keep the cells of hidden layers compressed while the map is idle
+    new LayerCompressor(this);
+
+    // Keep the memory used by the undo history within the configured limit
+    connect(mUndoStack, &QUndoStack::indexChanged, this, [this] {
+        const qint64 megabytes = Preferences::instance()->undoMemoryLimit();
+        enforceUndoMemoryLimit(mUndoStack, megabytes * 1024 * 1024);
+    });
+
     // Register tileset references
     TilesetManager *tilesetManager = TilesetManager::instance();
     tilesetManager->addReferences(mMap->tilesets());
@@ -114,6 +150,9 @@ MapDocument::MapDocument(Map *map, const QString &fileName):
 
 MapDocument::~MapDocument()
 {
+    // Wait for a save in progress, since it shares the tilesets
+    delete mSaver;
+
     // Unregister tileset references
     TilesetManager *tilesetManager = TilesetManager::instance();
     tilesetManager->removeReferences(mMap->tilesets());
@@ -129,19 +168,41 @@ bool MapDocument::save(QString *error)
 
 bool MapDocument::save(const QString &fileName, QString *error)
 {
+    waitForSave();
+
     MapFormat *mapFormat = mWriterFormat;
 
     TmxMapFormat tmxMapFormat;
     if (!mapFormat)
         mapFormat = &tmxMapFormat;
 
-    if (!mapFormat->write(map(), fileName)) {
+    // Only the tile layers that changed since the last save are encoded again
+    TmxMapFormat *tmxFormat = qobject_cast<TmxMapFormat*>(mapFormat);
+    if (tmxFormat)
+        tmxFormat->setLayerDataCache(&mLayerDataCache);
+
+    bool written;
+    {
+        QMutexLocker locker(MapSaver::writeMutex());
+        TraceScope trace("MapFormat::write", fileName);
+        written = mapFormat->write(map(), fileName);
+    }
+
+    if (tmxFormat)
+        tmxFormat->setLayerDataCache(nullptr);
+
+    if (!written) {
         if (error)
             *error = mapFormat->errorString();
         return false;
     }
 
     undoStack()->setClean();
+    if (mCleanStateLost) {
+        mCleanStateLost = false;
+        emit modifiedChanged();
+    }
+
     setFileName(fileName);
     mLastSaved = QFileInfo(fileName).lastModified();
 
@@ -149,6 +210,107 @@ bool MapDocument::save(const QString &fileName, QString *error)
     return true;
 }
 
+void MapDocument::saveInBackground(const QString &fileName)
+{
+    waitForSave();
+
+    // Copying the map is cheap, since the tile layer data is shared until
+    // either copy is changed
+    Map *snapshot = new Map(*mMap);
+    snapshot->setNextObjectId(mMap->nextObjectId());
+
+    mSaver = new MapSaver(snapshot, mWriterFormat, fileName);
+
+    LayerDataCache &layerDataCache = mSaver->layerDataCache();
+    for (int i = 0; i < mMap->layerCount(); ++i)
+        layerDataCache.copyEntry(mLayerDataCache, mMap->layerAt(i), snapshot->layerAt(i));
+
+    // Embedded tilesets are written along with the map, so the snapshot
+    // gets copies of them that can't be changed while it is being saved
+    mClonedTilesets.clear();
+    for (const SharedTileset &tileset : mMap->tilesets()) {
+        if (!tileset->fileName().isEmpty())
+            continue;
+
+        const SharedTileset clone = tileset->clone();
+        snapshot->replaceTileset(tileset, clone);
+        layerDataCache.replaceTileset(tileset.data(), clone.data());
+        mClonedTilesets.append(qMakePair<const Tileset*, const Tileset*>(tileset.data(), clone.data()));
+    }
+
+    // The clean index of the undo stack is invalidated by QUndoStack when
+    // the commands up to this point get replaced while saving
+    mUndoStack->setClean();
+
+    mSavedLayers = mMap->layers();
+    mLayersChangedDuringSave.clear();
+    mMapChangedDuringSave = false;
+
+    connect(mSaver, &QThread::finished, this, &MapDocument::onSaverFinished);
+    mSaver->start();
+}
+
+void MapDocument::waitForSave()
+{
+    if (!mSaver)
+        return;
+
+    mSaver->wait();
+    finishSave();
+}
+
+void MapDocument::onSaverFinished()
+{
+    // Ignore the signal of a save that was already finished by waitForSave()
+    if (sender() == mSaver)
+        finishSave();
+}
+
+void MapDocument::finishSave()
+{
+    MapSaver *saver = mSaver;
+    mSaver = nullptr;
+
+    // Keep the encoded data of the tile layers that didn't change meanwhile
+    if (!mMapChangedDuringSave) {
+        for (const auto &cloned : mClonedTilesets)
+            saver->layerDataCache().replaceTileset(cloned.second, cloned.first);
+
+        const Map *snapshot = saver->map();
+        for (int i = 0; i < mSavedLayers.size(); ++i) {
+            const Layer *layer = mSavedLayers.at(i);
+            if (!mLayersChangedDuringSave.contains(layer))
+                mLayerDataCache.copyEntry(saver->layerDataCache(), snapshot->layerAt(i), layer);
+        }
+    }
+
+    mSavedLayers.clear();
+    mClonedTilesets.clear();
+    mLayersChangedDuringSave.clear();
+
+    // Deleted later, since its finished signal may still be pending
+    saver->deleteLater();
+
+    if (!saver->succeeded()) {
+        // The undo stack was marked clean when the save started
+        mCleanStateLost = true;
+        emit modifiedChanged();
+        emit saveFailed(saver->errorString());
+        return;
+    }
+
+    // The map is only in its saved state when it wasn't edited meanwhile,
+    // which is tracked by the clean index of the undo stack
+    mCleanStateLost = false;
+    emit modifiedChanged();
+
+    const QString fileName = saver->fileName();
+    setFileName(fileName);
+    mLastSaved = QFileInfo(fileName).lastModified();
+
+    emit saved();
+}
+
 MapDocument *MapDocument::load(const QString &fileName,
                                MapFormat *mapFormat,
                                QString *error)
@@ -169,6 +331,7 @@ MapDocument *MapDocument::load(const QString &fileName,
     Map *map = nullptr;
     QString errorString;
     if (mapFormat) {
+        TraceScope trace("MapFormat::read", fileName);
         map = mapFormat->read(fileName);
         errorString = mapFormat->errorString();
     } else {
@@ -249,7 +412,9 @@ QString MapDocument::displayName() const
  */
 bool MapDocument::isModified() const
 {
-    return !mUndoStack->isClean();
+    // The undo stack is marked clean when a save starts, which is only the
+    // saved state once the save succeeded
+    return mSaver || mCleanStateLost || !mUndoStack->isClean();
 }
 
 void MapDocument::setCurrentLayerIndex(int index)
@@ -328,17 +493,23 @@ void MapDocument::resizeMap(const QSize &size, const QPoint &offset)
     const QPointF newOrigin = mRenderer->tileToPixelCoords(-offset);
     const QPointF pixelOffset = origin - newOrigin;
 
-    // Resize the map and each layer
+    // Resize the map and each layer, with the tile layers resized at once
     mUndoStack->beginMacro(tr("Resize Map"));
+
+    QList<int> tileLayerIndexes;
+    for (int i = 0; i < mMap->layerCount(); ++i)
+        if (mMap->layerAt(i)->isTileLayer())
+            tileLayerIndexes.append(i);
+
+    if (!tileLayerIndexes.isEmpty())
+        mUndoStack->push(new ResizeTileLayers(this, tileLayerIndexes, size, offset));
+
     for (int i = 0; i < mMap->layerCount(); ++i) {
         Layer *layer = mMap->layerAt(i);
 
         switch (layer->layerType()) {
-        case Layer::TileLayerType: {
-            TileLayer *tileLayer = static_cast<TileLayer*>(layer);
-            mUndoStack->push(new ResizeTileLayer(this, tileLayer, size, offset));
+        case Layer::TileLayerType:
             break;
-        }
         case Layer::ObjectGroupType: {
             ObjectGroup *objectGroup = static_cast<ObjectGroup*>(layer);
 
@@ -375,17 +546,32 @@ void MapDocument::offsetMap(const QList<int> &layerIndexes,
     if (layerIndexes.empty())
         return;
 
-    if (layerIndexes.size() == 1) {
-        mUndoStack->push(new OffsetLayer(this, layerIndexes.first(), offset,
-                                         bounds, wrapX, wrapY));
-    } else {
+    // The tile layers are offset at once, the other layers one by one
+    QList<int> tileLayerIndexes;
+    QList<int> otherLayerIndexes;
+    for (int layerIndex : layerIndexes) {
+        if (mMap->layerAt(layerIndex)->isTileLayer())
+            tileLayerIndexes.append(layerIndex);
+        else
+            otherLayerIndexes.append(layerIndex);
+    }
+
+    const bool macro = otherLayerIndexes.size() + (tileLayerIndexes.isEmpty() ? 0 : 1) > 1;
+    if (macro)
         mUndoStack->beginMacro(tr("Offset Map"));
-        foreach (const int layerIndex, layerIndexes) {
-            mUndoStack->push(new OffsetLayer(this, layerIndex, offset,
-                                             bounds, wrapX, wrapY));
-        }
-        mUndoStack->endMacro();
+
+    if (!tileLayerIndexes.isEmpty()) {
+        mUndoStack->push(new OffsetTileLayers(this, tileLayerIndexes, offset,
+                                              bounds, wrapX, wrapY));
     }
+
+    for (int layerIndex : otherLayerIndexes) {
+        mUndoStack->push(new OffsetLayer(this, layerIndex, offset,
+                                         bounds, wrapX, wrapY));
+    }
+
+    if (macro)
+        mUndoStack->endMacro();
 }
 
 /**
@@ -498,6 +684,29 @@ void MapDocument::mergeLayerDown()
     if (!lowerLayer->canMergeWith(upperLayer))
         return;
 
+    TileLayer *lowerTileLayer = lowerLayer->asTileLayer();
+    TileLayer *upperTileLayer = upperLayer->asTileLayer();
+
+    // When the lower tile layer can hold all cells of the upper one, these
+    // are painted onto it directly. The painting only remembers the cells
+    // it replaced, rather than keeping a merged copy of the whole layer.
+    if (lowerTileLayer &&
+            (lowerTileLayer->isInfinite() ||
+             lowerTileLayer->bounds().contains(upperTileLayer->bounds()))) {
+        const int lowerIndex = mCurrentLayerIndex - 1;
+
+        mUndoStack->beginMacro(tr("Merge Layer Down"));
+        mUndoStack->push(new PaintTileLayer(this, lowerTileLayer,
+                                            upperTileLayer->x(),
+                                            upperTileLayer->y(),
+                                            upperTileLayer));
+        mUndoStack->push(new RemoveLayer(this, mCurrentLayerIndex));
+        mUndoStack->endMacro();
+
+        setCurrentLayerIndex(lowerIndex);
+        return;
+    }
+
     Layer *merged = lowerLayer->mergedWith(upperLayer);
 
     mUndoStack->beginMacro(tr("Merge Layer Down"));
@@ -615,6 +824,15 @@ void MapDocument::moveTileset(int from, int to)
     emit tilesetMoved(from, to);
 }
 
+/**
+ * Restarts the random painting on this map from the given \a seed.
+ */
+void MapDocument::setRandomSeed(quint64 seed)
+{
+    mRandomSeed = seed;
+    mRandomGenerator.setSeed(seed);
+}
+
 void MapDocument::setSelectedArea(const QRegion &selection)
 {
     if (mSelectedArea != selection) {
@@ -682,6 +900,7 @@ void MapDocument::unifyTilesets(Map *map)
 {
     QList<QUndoCommand*> undoCommands;
     const QVector<SharedTileset> &existingTilesets = mMap->tilesets();
+    const TilesetsByFingerprint similarTilesets = Tileset::byFingerprint(existingTilesets);
     TilesetManager *tilesetManager = TilesetManager::instance();
 
     // Add tilesets that are not yet part of this map
@@ -689,7 +908,7 @@ void MapDocument::unifyTilesets(Map *map)
         if (existingTilesets.contains(tileset))
             continue;
 
-        SharedTileset replacement = tileset->findSimilarTileset(existingTilesets);
+        SharedTileset replacement = tileset->findSimilarTileset(similarTilesets);
         if (!replacement) {
             undoCommands.append(new AddTileset(this, tileset));
             continue;
@@ -731,6 +950,7 @@ void MapDocument::unifyTilesets(Map *map)
 void MapDocument::unifyTilesets(Map *map, QVector<SharedTileset> &missingTilesets)
 {
     const QVector<SharedTileset> &existingTilesets = mMap->tilesets();
+    const TilesetsByFingerprint similarTilesets = Tileset::byFingerprint(existingTilesets);
     TilesetManager *tilesetManager = TilesetManager::instance();
 
     foreach (const SharedTileset &tileset, map->tilesets()) {
@@ -738,7 +958,7 @@ void MapDocument::unifyTilesets(Map *map, QVector<SharedTileset> &missingTileset
         if (existingTilesets.contains(tileset))
             continue;
 
-        SharedTileset replacement = tileset->findSimilarTileset(existingTilesets);
+        SharedTileset replacement = tileset->findSimilarTileset(similarTilesets);
 
         // tileset not present and no replacement tileset found
         if (!replacement) {
@@ -755,6 +975,19 @@ void MapDocument::unifyTilesets(Map *map, QVector<SharedTileset> &missingTileset
     }
 }
 
+/**
+ * Emits the map changed signal. This signal should be emitted after changing
+ * the map size or its tile size.
+ *
+ * Since such changes affect the geometry of all objects, the object geometry
+ * cached by the renderer is cleared.
+ */
+void MapDocument::emitMapChanged()
+{
+    mRenderer->clearObjectGeometryCache();
+    emit mapChanged();
+}
+
 /**
  * Emits the tileset changed signal. This signal is currently used when adding
  * or removing tiles from a tileset.
@@ -778,45 +1011,46 @@ void MapDocument::onObjectsRemoved(const QList<MapObject*> &objects)
     emit objectsRemoved(objects);
 }
 
-void MapDocument::onMapObjectModelRowsInserted(const QModelIndex &parent,
-                                               int first, int last)
+/**
+ * Emits the region changed signal for the specified region. The region
+ * should be in tile coordinates. This method is used by the TilePainter.
+ *
+ * While a RegionChangeBatch exists, the region is remembered instead, and
+ * the signal is emitted once per layer when the batch ends.
+ */
+void MapDocument::emitRegionChanged(const QRegion &region, Layer *layer)
 {
-    ObjectGroup *objectGroup = mMapObjectModel->toObjectGroup(parent);
-    if (!objectGroup) // we're not dealing with insertion of objects
+    if (mRegionChangeBatchDepth == 0) {
+        emit regionChanged(region, layer);
         return;
+    }
 
-    emit objectsInserted(objectGroup, first, last);
-    onMapObjectModelRowsInsertedOrRemoved(parent, first, last);
+    for (QPair<Layer*, TileMask> &pending : mPendingRegionChanges) {
+        if (pending.first == layer) {
+            pending.second.addRegion(region);
+            return;
+        }
+    }
+
+    mPendingRegionChanges.append(qMakePair(layer, TileMask(region)));
 }
 
-void MapDocument::onMapObjectModelRowsInsertedOrRemoved(const QModelIndex &parent,
-                                                        int first, int last)
+void MapDocument::beginRegionChangeBatch()
 {
-    Q_UNUSED(first)
-
-    ObjectGroup *objectGroup = mMapObjectModel->toObjectGroup(parent);
-    if (!objectGroup)
-        return;
-
-    // Inserting or removing objects changes the index of any that come after
-    const int lastIndex = objectGroup->objectCount() - 1;
-    if (last < lastIndex)
-        emit objectsIndexChanged(objectGroup, last + 1, lastIndex);
+    ++mRegionChangeBatchDepth;
 }
 
-void MapDocument::onObjectsMoved(const QModelIndex &parent, int start, int end,
-                                 const QModelIndex &destination, int row)
+void MapDocument::endRegionChangeBatch()
 {
-    if (parent != destination)
+    Q_ASSERT(mRegionChangeBatchDepth > 0);
+    if (--mRegionChangeBatchDepth > 0)
         return;
 
-    ObjectGroup *objectGroup = mMapObjectModel->toObjectGroup(parent);
-
-    // Determine the full range over which object indexes changed
-    const int first = qMin(start, row);
-    const int last = qMax(end, row - 1);
+    const QVector<QPair<Layer*, TileMask>> pending = mPendingRegionChanges;
+    mPendingRegionChanges.clear();
 
-    emit objectsIndexChanged(objectGroup, first, last);
+    for (const QPair<Layer*, TileMask> &change : pending)
+        emit regionChanged(change.second.toRegion(), change.first);
 }
 
 void MapDocument::onLayerAdded(int index)
@@ -831,6 +1065,15 @@ void MapDocument::onLayerAdded(int index)
 void MapDocument::onLayerAboutToBeRemoved(int index)
 {
     Layer *layer = mMap->layerAt(index);
+    mLayerDataCache.remove(layer);
+    if (mSaver)
+        mLayersChangedDuringSave.insert(layer);
+
+    // Changes to the removed layer no longer need to be reported
+    for (int i = mPendingRegionChanges.size() - 1; i >= 0; --i)
+        if (mPendingRegionChanges.at(i).first == layer)
+            mPendingRegionChanges.remove(i);
+
     if (layer == mCurrentObject)
         setCurrentObject(nullptr);
 
@@ -868,11 +1111,18 @@ void MapDocument::deselectObjects(const QList<MapObject *> &objects)
         if (objects.contains(static_cast<MapObject*>(mCurrentObject)))
             setCurrentObject(nullptr);
 
-    int removedCount = 0;
-    foreach (MapObject *object, objects)
-        removedCount += mSelectedObjects.removeAll(object);
+    if (mSelectedObjects.isEmpty())
+        return;
+
+    const QSet<MapObject*> removed = objects.toSet();
+    const int oldCount = mSelectedObjects.size();
+
+    mSelectedObjects.erase(std::remove_if(mSelectedObjects.begin(),
+                                          mSelectedObjects.end(),
+                                          [&] (MapObject *object) { return removed.contains(object); }),
+                           mSelectedObjects.end());
 
-    if (removedCount > 0)
+    if (mSelectedObjects.size() != oldCount)
         emit selectedObjectsChanged();
 }
 
@@ -880,6 +1130,7 @@ void MapDocument::setTilesetFileName(Tileset *tileset,
                                      const QString &fileName)
 {
     tileset->setFileName(fileName);
+    TilesetManager::instance()->tilesetFileNameChanged(tileset);
     emit tilesetFileNameChanged(tileset);
 }
 
@@ -897,23 +1148,49 @@ void MapDocument::setTilesetTileOffset(Tileset *tileset,
     emit tilesetTileOffsetChanged(tileset);
 }
 
-void MapDocument::duplicateObjects(const QList<MapObject *> &objects)
+/**
+ * Adds the given \a objects to the end of the given \a objectGroup and
+ * selects them. This happens through a single undo command, inserting
+ * the objects as one range.
+ */
+void MapDocument::addObjects(ObjectGroup *objectGroup,
+                             const QList<MapObject *> &objects,
+                             const QString &undoText)
 {
     if (objects.isEmpty())
         return;
 
-    mUndoStack->beginMacro(tr("Duplicate %n Object(s)", "", objects.size()));
+    QVector<MapObjectModel::ObjectEntry> entries;
+    entries.reserve(objects.size());
+    for (MapObject *mapObject : objects)
+        entries.append(MapObjectModel::ObjectEntry(mapObject, objectGroup));
 
+    AddMapObjects *command = new AddMapObjects(this, entries);
+    if (!undoText.isEmpty())
+        command->setText(undoText);
+    mUndoStack->push(command);
+    setSelectedObjects(objects);
+}
+
+void MapDocument::duplicateObjects(const QList<MapObject *> &objects)
+{
+    if (objects.isEmpty())
+        return;
+
+    QVector<MapObjectModel::ObjectEntry> entries;
     QList<MapObject*> clones;
-    foreach (const MapObject *mapObject, objects) {
+    entries.reserve(objects.size());
+    clones.reserve(objects.size());
+
+    for (const MapObject *mapObject : objects) {
         MapObject *clone = mapObject->clone();
         clones.append(clone);
-        mUndoStack->push(new AddMapObject(this,
-                                          mapObject->objectGroup(),
-                                          clone));
+        entries.append(MapObjectModel::ObjectEntry(clone, mapObject->objectGroup()));
     }
 
-    mUndoStack->endMacro();
+    AddMapObjects *command = new AddMapObjects(this, entries);
+    command->setText(tr("Duplicate %n Object(s)", "", objects.size()));
+    mUndoStack->push(command);
     setSelectedObjects(clones);
 }
 
@@ -922,30 +1199,21 @@ void MapDocument::removeObjects(const QList<MapObject *> &objects)
     if (objects.isEmpty())
         return;
 
-    mUndoStack->beginMacro(tr("Remove %n Object(s)", "", objects.size()));
-    foreach (MapObject *mapObject, objects)
-        mUndoStack->push(new RemoveMapObject(this, mapObject));
-    mUndoStack->endMacro();
+    mUndoStack->push(new RemoveMapObjects(this, objects));
 }
 
 void MapDocument::moveObjectsToGroup(const QList<MapObject *> &objects,
                                      ObjectGroup *objectGroup)
 {
-    if (objects.isEmpty())
-        return;
-
-    mUndoStack->beginMacro(tr("Move %n Object(s) to Layer", "",
-                              objects.size()));
+    QList<MapObject*> movingObjects;
+    for (MapObject *mapObject : objects)
+        if (mapObject->objectGroup() != objectGroup)
+            movingObjects.append(mapObject);
 
-    foreach (MapObject *mapObject, objects) {
-        if (mapObject->objectGroup() == objectGroup)
-            continue;
+    if (movingObjects.isEmpty())
+        return;
 
-        mUndoStack->push(new MoveMapObjectToGroup(this,
-                                                  mapObject,
-                                                  objectGroup));
-    }
-    mUndoStack->endMacro();
+    mUndoStack->push(new MoveMapObjectToGroup(this, movingObjects, objectGroup));
 }
 
 void MapDocument::setProperty(Object *object,
@@ -992,4 +1260,7 @@ void MapDocument::createRenderer()
         mRenderer = new OrthogonalRenderer(mMap);
         break;
     }
+
+    // Draw tiles as their average color when zoomed out far
+    mRenderer->setFlag(LevelOfDetail);
 }
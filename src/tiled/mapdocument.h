@@ -24,7 +24,10 @@
 #define MAPDOCUMENT_H
 
 #include "layer.h"
+#include "layerdatacache.h"
+#include "randompicker.h"
 #include "tiled.h"
+#include "tilemask.h"
 #include "tileset.h"
 
 #include <QDateTime>
@@ -32,12 +35,14 @@
 #include <QObject>
 #include <QPointer>
 #include <QRegion>
+#include <QSet>
 #include <QString>
+#include <QVector>
 
-class QModelIndex;
 class QPoint;
 class QRect;
 class QSize;
+class QUndoCommand;
 class QUndoStack;
 
 namespace Tiled {
@@ -51,8 +56,10 @@ class Tile;
 
 namespace Internal {
 
+class ChangeNotifier;
 class LayerModel;
 class MapObjectModel;
+class MapSaver;
 class TerrainModel;
 class TileSelectionModel;
 
@@ -100,6 +107,25 @@ public:
      */
     bool save(const QString &fileName, QString *error = nullptr);
 
+    /**
+     * Saves the map to the file at \a fileName on another thread. A copy of
+     * the map is written, so the map can be edited while it is being saved.
+     * Emits saved() or saveFailed() when done.
+     *
+     * When a save is still in progress, this waits until it is done.
+     */
+    void saveInBackground(const QString &fileName);
+
+    /**
+     * Returns whether a save started with saveInBackground() is in progress.
+     */
+    bool isSaving() const { return mSaver != nullptr; }
+
+    /**
+     * Waits until the save in progress, if any, is done.
+     */
+    void waitForSave();
+
     /**
      * Loads a map and returns a MapDocument instance on success. Returns null
      * on error and sets the \a error message.
@@ -184,6 +210,9 @@ public:
     void setTilesetName(Tileset *tileset, const QString &name);
     void setTilesetTileOffset(Tileset *tileset, const QPoint &tileOffset);
 
+    void addObjects(ObjectGroup *objectGroup,
+                    const QList<MapObject*> &objects,
+                    const QString &undoText);
     void duplicateObjects(const QList<MapObject*> &objects);
     void removeObjects(const QList<MapObject*> &objects);
     void moveObjectsToGroup(const QList<MapObject*> &objects,
@@ -203,6 +232,13 @@ public:
 
     TerrainModel *terrainModel() const { return mTerrainModel; }
 
+    /**
+     * Returns the change notifier, which emits the change signals of this
+     * document at most once per frame. Should be used by views that don't
+     * need to update synchronously.
+     */
+    ChangeNotifier *changeNotifier() const { return mChangeNotifier; }
+
     /**
      * Returns the map renderer.
      */
@@ -220,6 +256,15 @@ public:
      */
     QUndoStack *undoStack() const { return mUndoStack; }
 
+    /**
+     * Returns the generator the tools use for random painting on this map.
+     * Starting from the same seed, the same random picks are made.
+     */
+    RandomGenerator &randomGenerator() { return mRandomGenerator; }
+
+    quint64 randomSeed() const { return mRandomSeed; }
+    void setRandomSeed(quint64 seed);
+
     /**
      * Returns the selected area of tiles.
      */
@@ -259,10 +304,14 @@ public:
     void unifyTilesets(Map *map, QVector<SharedTileset> &missingTilesets);
 
     void emitMapChanged();
+    void emitMapPropertyChanged();
 
     void emitRegionChanged(const QRegion &region, Layer *layer);
     void emitRegionEdited(const QRegion &region, Layer *layer);
 
+    void beginRegionChangeBatch();
+    void endRegionChangeBatch();
+
     void emitTileLayerDrawMarginsChanged(TileLayer *layer);
     void emitTilesetChanged(Tileset *tileset);
 
@@ -283,6 +332,7 @@ signals:
     void modifiedChanged();
 
     void saved();
+    void saveFailed(const QString &error);
 
     /**
      * Emitted when the selected tile region changes. Sends the currently
@@ -308,6 +358,12 @@ signals:
      */
     void mapChanged();
 
+    /**
+     * Emitted when a property of the map changes that doesn't affect the
+     * geometry of the map, like its background color or render order.
+     */
+    void mapPropertyChanged();
+
     void layerAdded(int index);
     void layerAboutToBeRemoved(int index);
     void layerRenamed(int index);
@@ -375,18 +431,16 @@ signals:
 private slots:
     void onObjectsRemoved(const QList<MapObject*> &objects);
 
-    void onMapObjectModelRowsInserted(const QModelIndex &parent, int first, int last);
-    void onMapObjectModelRowsInsertedOrRemoved(const QModelIndex &parent, int first, int last);
-    void onObjectsMoved(const QModelIndex &parent, int start, int end,
-                        const QModelIndex &destination, int row);
-
     void onLayerAdded(int index);
     void onLayerAboutToBeRemoved(int index);
     void onLayerRemoved(int index);
 
     void onTerrainRemoved(Terrain *terrain);
 
+    void onSaverFinished();
+
 private:
+    void finishSave();
     void setFileName(const QString &fileName);
     void deselectObjects(const QList<MapObject*> &objects);
 
@@ -411,7 +465,44 @@ private:
     MapObjectModel *mMapObjectModel;
     TerrainModel *mTerrainModel;
     QUndoStack *mUndoStack;
+    ChangeNotifier *mChangeNotifier;
     QDateTime mLastSaved;
+
+    int mRegionChangeBatchDepth;
+    QVector<QPair<Layer*, TileMask>> mPendingRegionChanges;
+
+    quint64 mRandomSeed;
+    RandomGenerator mRandomGenerator;
+
+    LayerDataCache mLayerDataCache;
+
+    MapSaver *mSaver;
+    QList<Layer*> mSavedLayers;
+    QVector<QPair<const Tileset*, const Tileset*>> mClonedTilesets;
+    QSet<const Layer*> mLayersChangedDuringSave;
+    bool mMapChangedDuringSave;
+    bool mCleanStateLost;   // a failed save moved the clean state
+};
+
+/**
+ * Combines the regionChanged signals of a map document while it exists. For
+ * each changed layer, the signal is emitted once with the combined region
+ * when the outermost batch ends.
+ */
+class RegionChangeBatch
+{
+public:
+    explicit RegionChangeBatch(MapDocument *mapDocument)
+        : mMapDocument(mapDocument)
+    { mMapDocument->beginRegionChangeBatch(); }
+
+    ~RegionChangeBatch()
+    { mMapDocument->endRegionChangeBatch(); }
+
+private:
+    Q_DISABLE_COPY(RegionChangeBatch)
+
+    MapDocument *mMapDocument;
 };
 
 inline QString MapDocument::lastExportFileName() const
@@ -424,24 +515,6 @@ inline void MapDocument::setLastExportFileName(const QString &fileName)
     mLastExportFileName = fileName;
 }
 
-/**
- * Emits the map changed signal. This signal should be emitted after changing
- * the map size or its tile size.
- */
-inline void MapDocument::emitMapChanged()
-{
-    emit mapChanged();
-}
-
-/**
- * Emits the region changed signal for the specified region. The region
- * should be in tile coordinates. This method is used by the TilePainter.
- */
-inline void MapDocument::emitRegionChanged(const QRegion &region, Layer *layer)
-{
-    emit regionChanged(region, layer);
-}
-
 /**
  * Emits the region edited signal for the specified region and tile layer.
  * The region should be in tile coordinates. This should be called from
@@ -452,6 +525,15 @@ inline void MapDocument::emitRegionEdited(const QRegion &region, Layer *layer)
     emit regionEdited(region, layer);
 }
 
+/**
+ * Emits the map property changed signal. Unlike emitMapChanged(), this
+ * doesn't require the geometry of the map and its objects to be updated.
+ */
+inline void MapDocument::emitMapPropertyChanged()
+{
+    emit mapPropertyChanged();
+}
+
 inline void MapDocument::emitTileLayerDrawMarginsChanged(TileLayer *layer)
 {
     emit tileLayerDrawMarginsChanged(layer);
@@ -21,6 +21,7 @@
 
 #include "mapdocumentactionhandler.h"
 
+#include "changenotifier.h"
 #include "changeselectedarea.h"
 #include "documentmanager.h"
 #include "tilelayer.h"
@@ -168,8 +169,10 @@ void MapDocumentActionHandler::setMapDocument(MapDocument *mapDocument)
     if (mMapDocument == mapDocument)
         return;
 
-    if (mMapDocument)
+    if (mMapDocument) {
         mMapDocument->disconnect(this);
+        mMapDocument->changeNotifier()->disconnect(this);
+    }
 
     mMapDocument = mapDocument;
     updateActions();
@@ -179,9 +182,9 @@ void MapDocumentActionHandler::setMapDocument(MapDocument *mapDocument)
                 SLOT(updateActions()));
         connect(mapDocument, SIGNAL(currentLayerIndexChanged(int)),
                 SLOT(updateActions()));
-        connect(mapDocument, SIGNAL(selectedAreaChanged(QRegion,QRegion)),
+        connect(mapDocument->changeNotifier(), SIGNAL(selectedAreaChanged()),
                 SLOT(updateActions()));
-        connect(mapDocument, SIGNAL(selectedObjectsChanged()),
+        connect(mapDocument->changeNotifier(), SIGNAL(selectedObjectsChanged()),
                 SLOT(updateActions()));
     }
 
@@ -0,0 +1,379 @@
+/*
+ * mapimageexporter.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapimageexporter.h"
+
+#include "hexagonalrenderer.h"
+#include "imagelayer.h"
+#include "isometricrenderer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "mapobjectitem.h"
+#include "objectgroup.h"
+#include "openglrasterizer.h"
+#include "orthogonalrenderer.h"
+#include "pngwriter.h"
+#include "staggeredrenderer.h"
+#include "tilelayer.h"
+
+#include <QDir>
+#include <QImageWriter>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QThreadPool>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+// The maximum number of pixels rendered at once (64 MB)
+static const int MaxBandPixels = 16 * 1024 * 1024;
+
+static bool objectLessThan(const MapObject *a, const MapObject *b)
+{
+    return a->y() < b->y();
+}
+
+namespace {
+
+MapRenderer *createRenderer(const Map *map)
+{
+    switch (map->orientation()) {
+    case Map::Isometric:
+        return new IsometricRenderer(map);
+    case Map::Staggered:
+        return new StaggeredRenderer(map);
+    case Map::Hexagonal:
+        return new HexagonalRenderer(map);
+    case Map::Orthogonal:
+    default:
+        return new OrthogonalRenderer(map);
+    }
+}
+
+/**
+ * Renders a part of a band of the output image, using its own painter and
+ * map renderer, since the renderer caches the geometry of map objects.
+ */
+class BandRenderer : public QRunnable
+{
+public:
+    BandRenderer(const MapImageExporter *exporter,
+                 const Map *map,
+                 QImage &band,
+                 int top, int height,
+                 const QTransform &transform,
+                 QPainter::RenderHints renderHints,
+                 RenderFlags renderFlags,
+                 qreal painterScale,
+                 const MapImages *images)
+        : mExporter(exporter)
+        , mMap(map)
+        // Shares the memory of the band, so no compositing is needed
+        , mImage(band.scanLine(top), band.width(), height,
+                 band.bytesPerLine(), band.format())
+        , mTop(top)
+        , mTransform(transform)
+        , mRenderHints(renderHints)
+        , mRenderFlags(renderFlags)
+        , mPainterScale(painterScale)
+        , mImages(images)
+    {}
+
+    void run() override
+    {
+        QScopedPointer<MapRenderer> renderer(createRenderer(mMap));
+        renderer->setFlags(mRenderFlags);
+        renderer->setPainterScale(mPainterScale);
+        renderer->setImages(mImages);
+
+        QPainter painter(&mImage);
+        painter.setRenderHints(mRenderHints);
+        painter.setTransform(mTransform * QTransform::fromTranslate(0, -mTop));
+
+        const QRectF rect(0, mTop, mImage.width(), mImage.height());
+        const QRectF exposed = mTransform.inverted().mapRect(rect);
+
+        mExporter->drawMap(painter, renderer.data(), exposed);
+    }
+
+private:
+    const MapImageExporter *mExporter;
+    const Map *mMap;
+    QImage mImage;
+    int mTop;
+    QTransform mTransform;
+    QPainter::RenderHints mRenderHints;
+    RenderFlags mRenderFlags;
+    qreal mPainterScale;
+    const MapImages *mImages;
+};
+
+} // anonymous namespace
+
+MapImageExporter::MapImageExporter(const Map *map,
+                                   const QString &fileName,
+                                   QObject *parent)
+    : QThread(parent)
+    , mMap(map)
+    , mFileName(fileName)
+    , mRenderFlags(0)
+    , mPainterScale(1)
+    , mBackgroundColor(Qt::transparent)
+    , mVisibleLayersOnly(true)
+    , mOpenGLRasterizer(nullptr)
+    , mSucceeded(false)
+    , mCanceled(0)
+{
+}
+
+MapImageExporter::~MapImageExporter()
+{
+    cancel();
+    wait();
+}
+
+void MapImageExporter::setImage(const QImage &image)
+{
+    mImage = image;
+    mImageSize = image.size();
+}
+
+/**
+ * Creates the copies of the images of the map that are drawn from while
+ * exporting, since pixmaps can only be used on the main thread. Needs to be
+ * called on the main thread, after the render flags have been set.
+ */
+void MapImageExporter::prepareImages()
+{
+    mImages.reset(new MapImages(mMap, mRenderFlags));
+}
+
+void MapImageExporter::run()
+{
+    mSucceeded = mImage.isNull() ? exportPng() : exportImage();
+}
+
+/**
+ * Renders the map in horizontal bands, which are written to the PNG file as
+ * they are completed.
+ */
+bool MapImageExporter::exportPng()
+{
+    const int bandHeight = qBound(1, MaxBandPixels / qMax(1, mImageSize.width()),
+                                  qMax(1, mImageSize.height()));
+
+    QSaveFile file(mFileName);
+    PngWriter writer(&file);
+
+    bool ok = file.open(QIODevice::WriteOnly) && writer.begin(mImageSize);
+
+    for (int top = 0; ok && top < mImageSize.height(); top += bandHeight) {
+        if (wasCanceled())
+            return false;
+
+        QImage band(mImageSize.width(), qMin(bandHeight, mImageSize.height() - top),
+                    QImage::Format_ARGB32_Premultiplied);
+        band.fill(mBackgroundColor);
+
+        renderBand(band, top);
+
+        ok = writer.writeRows(band);
+        emit progressChanged(top + band.height());
+    }
+
+    ok = ok && writer.finish() && file.commit();
+
+    if (!ok) {
+        mError = writer.errorString();
+        if (mError.isEmpty())
+            mError = file.errorString();
+    }
+
+    return ok;
+}
+
+/**
+ * Renders the map into the image given to setImage() and saves it. The
+ * image is rendered in bands as well, to be able to report progress.
+ */
+bool MapImageExporter::exportImage()
+{
+    mImage.fill(mBackgroundColor);
+
+    const int bandHeight = qBound(1, MaxBandPixels / qMax(1, mImage.width()),
+                                  qMax(1, mImage.height()));
+
+    for (int top = 0; top < mImage.height(); top += bandHeight) {
+        if (wasCanceled())
+            return false;
+
+        const int height = qMin(bandHeight, mImage.height() - top);
+        QImage band(mImage.scanLine(top), mImage.width(), height,
+                    mImage.bytesPerLine(), mImage.format());
+
+        renderBand(band, top);
+        emit progressChanged(top + height);
+    }
+
+    QImageWriter writer(mFileName);
+    if (!writer.write(mImage)) {
+        mError = writer.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Renders the rows of the output image starting at \a top into \a band,
+ * splitting the work between one thread per processor core.
+ */
+void MapImageExporter::renderBand(QImage &band, int top) const
+{
+    const QTransform bandTransform = mTransform * QTransform::fromTranslate(0, -top);
+
+    if (mOpenGLRasterizer) {
+        if (renderBandWithOpenGL(band, bandTransform))
+            return;
+
+        // Don't try again for the remaining bands
+        mOpenGLRasterizer = nullptr;
+    }
+
+    const int threadCount = qBound(1, QThread::idealThreadCount(), band.height());
+
+    if (threadCount == 1) {
+        BandRenderer(this, mMap, band, 0, band.height(), bandTransform,
+                     mRenderHints, mRenderFlags, mPainterScale,
+                     mImages.data()).run();
+        return;
+    }
+
+    // Use several parts per thread, since their cost varies
+    const int partCount = qMin(threadCount * 4, band.height());
+    const int partHeight = (band.height() + partCount - 1) / partCount;
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(threadCount);
+
+    for (int partTop = 0; partTop < band.height(); partTop += partHeight) {
+        const int height = qMin(partHeight, band.height() - partTop);
+        threadPool.start(new BandRenderer(this, mMap, band, partTop, height,
+                                          bandTransform, mRenderHints,
+                                          mRenderFlags, mPainterScale,
+                                          mImages.data()));
+    }
+
+    threadPool.waitForDone();
+}
+
+/**
+ * Renders the \a band with the OpenGL rasterizer. Returns false when that is
+ * not possible, without having changed the band.
+ */
+bool MapImageExporter::renderBandWithOpenGL(QImage &band,
+                                            const QTransform &transform) const
+{
+#ifndef QT_NO_OPENGL
+    QScopedPointer<MapRenderer> renderer(createRenderer(mMap));
+    renderer->setFlags(mRenderFlags);
+    renderer->setPainterScale(mPainterScale);
+    renderer->setImages(mImages.data());
+
+    return mOpenGLRasterizer->render(band, [&] (QPainter &painter, const QRect &rect) {
+        painter.setRenderHints(mRenderHints);
+        painter.setTransform(transform, true);
+        drawMap(painter, renderer.data(), transform.inverted().mapRect(QRectF(rect)));
+    });
+#else
+    Q_UNUSED(band)
+    Q_UNUSED(transform)
+    return false;
+#endif
+}
+
+bool MapImageExporter::shouldDrawLayer(const Layer *layer) const
+{
+    return !mVisibleLayersOnly || layer->isVisible();
+}
+
+/**
+ * Draws the layers of the map using the given \a painter and \a renderer.
+ * Only the tiles overlapping with the \a exposed rectangle are drawn, unless
+ * it is null.
+ */
+void MapImageExporter::drawMap(QPainter &painter,
+                               MapRenderer *renderer,
+                               const QRectF &exposed) const
+{
+    foreach (const Layer *layer, mMap->layers()) {
+        if (!shouldDrawLayer(layer))
+            continue;
+
+        painter.setOpacity(layer->opacity());
+        painter.translate(layer->offset());
+
+        const TileLayer *tileLayer = dynamic_cast<const TileLayer*>(layer);
+        const ObjectGroup *objGroup = dynamic_cast<const ObjectGroup*>(layer);
+        const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
+
+        const QRectF layerExposed = exposed.isNull()
+                ? exposed : exposed.translated(-layer->offset());
+
+        if (tileLayer) {
+            renderer->drawTileLayer(&painter, tileLayer, layerExposed);
+        } else if (objGroup) {
+            QList<MapObject*> objects = objGroup->objects();
+
+            if (objGroup->drawOrder() == ObjectGroup::TopDownOrder)
+                qStableSort(objects.begin(), objects.end(), objectLessThan);
+
+            foreach (const MapObject *object, objects) {
+                if (object->isVisible()) {
+                    if (object->rotation() != qreal(0)) {
+                        QPointF origin = renderer->pixelToScreenCoords(object->position());
+                        painter.save();
+                        painter.translate(origin);
+                        painter.rotate(object->rotation());
+                        painter.translate(-origin);
+                    }
+
+                    const QColor color = MapObjectItem::objectColor(object);
+                    renderer->drawMapObject(&painter, object, color);
+
+                    if (object->rotation() != qreal(0))
+                        painter.restore();
+                }
+            }
+        } else if (imageLayer) {
+            renderer->drawImageLayer(&painter, imageLayer, layerExposed);
+        }
+
+        painter.translate(-layer->offset());
+    }
+
+    if (mGridColor.isValid()) {
+        QRectF gridRect(QPointF(), renderer->mapSize());
+        if (!exposed.isNull())
+            gridRect &= exposed;
+        renderer->drawGrid(&painter, gridRect, mGridColor);
+    }
+}
@@ -0,0 +1,154 @@
+/*
+ * mapimageexporter.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPIMAGEEXPORTER_H
+#define MAPIMAGEEXPORTER_H
+
+#include "maprenderer.h"
+
+#include <QAtomicInt>
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QScopedPointer>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <QTransform>
+
+namespace Tiled {
+
+class Map;
+class OpenGLRasterizer;
+
+namespace Internal {
+
+/**
+ * Renders a map to an image file on a separate thread. The image is
+ * rendered in horizontal bands, each of which is split between several
+ * threads. PNG images are written while they are rendered, so that the
+ * complete image does not need to fit in memory. Other formats are rendered
+ * into the image passed to setImage() and saved when it is complete.
+ *
+ * The map must not change while it is being exported, and prepareImages()
+ * needs to be called on the main thread before the export is started.
+ */
+class MapImageExporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    MapImageExporter(const Map *map,
+                     const QString &fileName,
+                     QObject *parent = nullptr);
+
+    ~MapImageExporter();
+
+    const QString &fileName() const { return mFileName; }
+
+    void setImageSize(const QSize &size) { mImageSize = size; }
+    const QSize &imageSize() const { return mImageSize; }
+
+    /**
+     * Sets the image to render into, for formats that are not written while
+     * rendering. Its size overrides the image size.
+     */
+    void setImage(const QImage &image);
+
+    void setTransform(const QTransform &transform) { mTransform = transform; }
+    void setRenderHints(QPainter::RenderHints hints) { mRenderHints = hints; }
+    void setRenderFlags(RenderFlags flags) { mRenderFlags = flags; }
+    void setPainterScale(qreal scale) { mPainterScale = scale; }
+    void setBackgroundColor(const QColor &color) { mBackgroundColor = color; }
+    void setVisibleLayersOnly(bool visibleLayersOnly) { mVisibleLayersOnly = visibleLayersOnly; }
+
+    /**
+     * Sets the color of the tile grid. No grid is drawn when the color is
+     * invalid, which is the default.
+     */
+    void setGridColor(const QColor &color) { mGridColor = color; }
+
+    /**
+     * Sets the rasterizer used to render the bands of the image with OpenGL.
+     * When it fails, the export falls back to rendering in software.
+     */
+    void setOpenGLRasterizer(const OpenGLRasterizer *rasterizer) { mOpenGLRasterizer = rasterizer; }
+
+    void prepareImages();
+
+    void drawMap(QPainter &painter,
+                 MapRenderer *renderer,
+                 const QRectF &exposed) const;
+
+    /**
+     * Returns whether the image was written. Only valid after the thread has
+     * finished.
+     */
+    bool succeeded() const { return mSucceeded; }
+    bool wasCanceled() const { return mCanceled.load() != 0; }
+    const QString &errorString() const { return mError; }
+
+public slots:
+    /**
+     * Stops the export after the band that is being rendered. Can be called
+     * from any thread.
+     */
+    void cancel() { mCanceled.store(1); }
+
+signals:
+    /**
+     * Reports the number of rows of the image that have been rendered.
+     */
+    void progressChanged(int rows);
+
+protected:
+    void run() override;
+
+private:
+    bool exportPng();
+    bool exportImage();
+
+    void renderBand(QImage &band, int top) const;
+    bool renderBandWithOpenGL(QImage &band, const QTransform &transform) const;
+    bool shouldDrawLayer(const Layer *layer) const;
+
+    const Map *mMap;
+    const QString mFileName;
+    QSize mImageSize;
+    QImage mImage;
+    QTransform mTransform;
+    QPainter::RenderHints mRenderHints;
+    RenderFlags mRenderFlags;
+    qreal mPainterScale;
+    QColor mBackgroundColor;
+    QColor mGridColor;
+    bool mVisibleLayersOnly;
+    mutable const OpenGLRasterizer *mOpenGLRasterizer;
+    QScopedPointer<MapImages> mImages;
+
+    bool mSucceeded;
+    QAtomicInt mCanceled;
+    QString mError;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MAPIMAGEEXPORTER_H
@@ -0,0 +1,136 @@
+/*
+ * maploader.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "maploader.h"
+
+#include "map.h"
+#include "mapdocument.h"
+#include "maploadtask.h"
+#include "tmxmapformat.h"
+
+#include <QScopedPointer>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+MapLoader::MapLoader(QObject *parent)
+    : QObject(parent)
+    , mNextTaskId(0)
+    , mStartedCount(0)
+    , mFinishedCount(0)
+{
+    mProgressTimer.setInterval(100);
+    connect(&mProgressTimer, &QTimer::timeout,
+            this, &MapLoader::updateReadProgress);
+}
+
+MapLoader::~MapLoader()
+{
+    mThreadPool.waitForDone();
+    qDeleteAll(mTasks);
+}
+
+void MapLoader::load(const QString &fileName)
+{
+    if (!isLoading()) {
+        mStartedCount = 0;
+        mFinishedCount = 0;
+    }
+
+    ++mStartedCount;
+
+    if (!TmxMapFormat().supportsFile(fileName)) {
+        loadOnMainThread(fileName);
+        return;
+    }
+
+    const int id = mNextTaskId++;
+    MapLoadTask *task = new MapLoadTask(this, id, fileName);
+    mTasks.insert(id, task);
+    mThreadPool.start(task);
+
+    if (!mProgressTimer.isActive())
+        mProgressTimer.start();
+}
+
+int MapLoader::progress() const
+{
+    if (mStartedCount == 0)
+        return 1000;
+
+    qint64 done = qint64(mFinishedCount) * 1000;
+    for (const MapLoadTask *task : mTasks)
+        done += task->progress();
+
+    return int(done / mStartedCount);
+}
+
+void MapLoader::cancel()
+{
+    for (MapLoadTask *task : mTasks)
+        task->cancel();
+}
+
+void MapLoader::taskFinished(int id)
+{
+    QScopedPointer<MapLoadTask> task(mTasks.take(id));
+
+    if (mTasks.isEmpty())
+        mProgressTimer.stop();
+
+    // The map is dropped along with the task, even when it was read before
+    // the cancel was noticed
+    if (task->isCanceled()) {
+        finished(task->fileName);
+        return;
+    }
+
+    // Tilesets in other formats can only be read on the main thread, and
+    // this also reports the error in case the map is broken
+    if (!task->hasMap()) {
+        loadOnMainThread(task->fileName);
+        return;
+    }
+
+    emit loaded(new MapDocument(task->takeMap(), task->fileName));
+    finished(task->fileName);
+}
+
+void MapLoader::loadOnMainThread(const QString &fileName)
+{
+    QString error;
+    if (MapDocument *mapDocument = MapDocument::load(fileName, nullptr, &error))
+        emit loaded(mapDocument);
+    else
+        emit loadFailed(fileName, error);
+
+    finished(fileName);
+}
+
+void MapLoader::updateReadProgress()
+{
+    emit readProgress(progress());
+}
+
+void MapLoader::finished(const QString &fileName)
+{
+    ++mFinishedCount;
+    emit progress(mFinishedCount, mStartedCount, fileName);
+}
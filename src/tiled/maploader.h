@@ -0,0 +1,118 @@
+/*
+ * maploader.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPLOADER_H
+#define MAPLOADER_H
+
+#include <QHash>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+
+namespace Tiled {
+namespace Internal {
+
+class MapDocument;
+class MapLoadTask;
+
+/**
+ * Loads several TMX maps at once on worker threads, without blocking the
+ * user interface.
+ *
+ * Since pixmaps may only be created on the main thread, the maps are read
+ * with pixmap creation deferred. When a map arrives, its external tilesets
+ * are replaced by the ones the TilesetManager already has, after which its
+ * pixmaps are created and a map document is made for it.
+ *
+ * Maps in other formats, and maps that could not be read on a worker
+ * thread, are loaded on the main thread.
+ */
+class MapLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MapLoader(QObject *parent = nullptr);
+    ~MapLoader();
+
+    /**
+     * Starts loading the map with the given \a fileName. Emits loaded()
+     * or loadFailed() once it is done.
+     */
+    void load(const QString &fileName);
+
+    /**
+     * Returns whether any of the maps are still being loaded.
+     */
+    bool isLoading() const { return !mTasks.isEmpty(); }
+
+    /**
+     * Returns how far along loading the maps started since the loader was
+     * idle is, in permille.
+     */
+    int progress() const;
+
+    /**
+     * Cancels loading the maps that are still being read. They are dropped
+     * without reporting an error.
+     */
+    void cancel();
+
+signals:
+    /**
+     * Emitted when a map has been loaded, or failed to load. The \a total
+     * is the number of maps that were started since the loader was idle.
+     */
+    void progress(int finished, int total, const QString &fileName);
+
+    /**
+     * Emitted regularly while maps are being read, with the current
+     * progress() in \a permille.
+     */
+    void readProgress(int permille);
+
+    /**
+     * Emitted for each loaded map. The receiver takes ownership of the
+     * \a mapDocument.
+     */
+    void loaded(MapDocument *mapDocument);
+
+    void loadFailed(const QString &fileName, const QString &error);
+
+private slots:
+    void taskFinished(int id);
+    void updateReadProgress();
+
+private:
+    void loadOnMainThread(const QString &fileName);
+    void finished(const QString &fileName);
+
+    QThreadPool mThreadPool;
+    QHash<int, MapLoadTask*> mTasks;
+    QTimer mProgressTimer;
+    int mNextTaskId;
+    int mStartedCount;
+    int mFinishedCount;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MAPLOADER_H
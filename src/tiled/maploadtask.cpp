@@ -0,0 +1,108 @@
+/*
+ * maploadtask.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "maploadtask.h"
+
+#include "map.h"
+#include "mapcache.h"
+#include "tilesetmanager.h"
+#include "tracing.h"
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+MapLoadTask::MapLoadTask(QObject *receiver, int id, const QString &fileName)
+    : fileName(fileName)
+    , mReceiver(receiver)
+    , mId(id)
+{
+    setAutoDelete(false);
+    setLazyLoadingEnabled(true);
+    setCacheEnabled(MapCache::sizeLimit() > 0);
+    setPixmapCreationDeferred(true);
+
+    MapReadOptions options;
+    options.progress = [this] (qint64 done, qint64 total) {
+        if (total > 0)
+            mProgress.storeRelease(int(done * 1000 / total));
+        return !isCanceled();
+    };
+    setReadOptions(options);
+
+    // The tileset manager may only be used on the main thread
+    for (const SharedTileset &tileset : TilesetManager::instance()->tilesets())
+        if (!tileset->fileName().isEmpty())
+            mLoadedTilesets.insert(tileset->fileName(), tileset);
+}
+
+void MapLoadTask::run()
+{
+    TraceScope trace("MapLoadTask::run", fileName);
+
+    mMap.reset(readMap(fileName));
+
+    QMetaObject::invokeMethod(mReceiver, "taskFinished",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, mId));
+}
+
+/**
+ * Returns the map that was read, after replacing its external tilesets by
+ * the ones the TilesetManager already has and creating its pixmaps. May
+ * only be called on the main thread.
+ *
+ * Maps read at the same time each read their own copy of a tileset that
+ * wasn't loaded yet. Once the first of them has been added, its copy is
+ * shared with the others, which skip creating the pixmaps of theirs.
+ *
+ * The caller takes ownership of the map.
+ */
+Map *MapLoadTask::takeMap()
+{
+    if (!mMap)
+        return nullptr;
+
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    const QVector<SharedTileset> tilesets = mMap->tilesets();
+    for (const SharedTileset &tileset : tilesets) {
+        if (tileset->fileName().isEmpty())
+            continue;
+
+        SharedTileset loadedTileset = tilesetManager->findTileset(tileset->fileName());
+        if (!loadedTileset || mMap->indexOfTileset(loadedTileset) != -1)
+            continue;
+
+        discardDeferredPixmaps(tileset.data());
+        mMap->replaceTileset(tileset, loadedTileset);
+    }
+
+    createDeferredPixmaps();
+
+    return mMap.take();
+}
+
+SharedTileset MapLoadTask::readExternalTileset(const QString &source,
+                                               QString *error)
+{
+    SharedTileset tileset = mLoadedTilesets.value(source);
+    if (!tileset)
+        tileset = MapReader::readExternalTileset(source, error);
+    return tileset;
+}
@@ -0,0 +1,88 @@
+/*
+ * maploadtask.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPLOADTASK_H
+#define MAPLOADTASK_H
+
+#include "mapreader.h"
+#include "tileset.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QRunnable>
+#include <QScopedPointer>
+
+namespace Tiled {
+
+class Map;
+
+namespace Internal {
+
+/**
+ * Reads a map on a worker thread. External tilesets that were already
+ * loaded when the task was created are shared instead of read again.
+ *
+ * Once done, the task calls the "taskFinished" slot of the receiver with
+ * the given ID, after which the map can be taken on the main thread.
+ *
+ * The progress and cancellation of the task may be accessed from any
+ * thread.
+ */
+class MapLoadTask : public QRunnable, private MapReader
+{
+public:
+    MapLoadTask(QObject *receiver, int id, const QString &fileName);
+
+    void run() override;
+
+    /**
+     * Returns whether the map was read successfully.
+     */
+    bool hasMap() const { return !mMap.isNull(); }
+
+    Map *takeMap();
+
+    /**
+     * Returns how much of the map file has been read, in permille.
+     */
+    int progress() const { return mProgress.loadAcquire(); }
+
+    void cancel() { mCanceled.storeRelease(1); }
+    bool isCanceled() const { return mCanceled.loadAcquire(); }
+
+    const QString fileName;
+
+protected:
+    SharedTileset readExternalTileset(const QString &source,
+                                      QString *error) override;
+
+private:
+    QObject *mReceiver;
+    const int mId;
+    QAtomicInt mProgress;
+    QAtomicInt mCanceled;
+    QHash<QString, SharedTileset> mLoadedTilesets;
+    QScopedPointer<Map> mMap;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MAPLOADTASK_H
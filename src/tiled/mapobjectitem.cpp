@@ -31,6 +31,7 @@
 #include "objectgroup.h"
 #include "objectgroupitem.h"
 #include "preferences.h"
+#include "renderprofiler.h"
 #include "resizemapobject.h"
 #include "tile.h"
 #include "zoomable.h"
@@ -83,10 +84,6 @@ void MapObjectItem::syncWithMapObject()
     setPos(pixelPos);
     setRotation(mObject->rotation());
 
-    if (ObjectGroup *objectGroup = mObject->objectGroup())
-        if (objectGroup->drawOrder() == ObjectGroup::TopDownOrder)
-            setZValue(pixelPos.y());
-
     if (mBoundingRect != bounds) {
         // Notify the graphics scene about the geometry change in advance
         prepareGeometryChange();
@@ -112,6 +109,13 @@ void MapObjectItem::paint(QPainter *painter,
                           const QStyleOptionGraphicsItem *,
                           QWidget *widget)
 {
+    // Objects that are part of the map are drawn by their object group item
+    if (ObjectGroupItem *objectGroupItem = static_cast<ObjectGroupItem*>(parentItem()))
+        if (objectGroupItem->drawsObjects())
+            return;
+
+    RenderProfiler::ItemTimer timer(mObject->objectGroup());
+
     qreal scale = static_cast<MapView*>(widget->parent())->zoomable()->scale();
     painter->translate(-pos());
     mMapDocument->renderer()->setPainterScale(scale);
@@ -123,6 +127,8 @@ void MapObjectItem::resizeObject(const QSizeF &size)
     // Not using the MapObjectModel because it is also used during object
     // creation, when the object is not actually part of the map yet.
     mObject->setSize(size);
+    if (ObjectGroup *objectGroup = mObject->objectGroup())
+        objectGroup->updateObjectIndex(mObject);
     syncWithMapObject();
 }
 
@@ -131,16 +137,17 @@ void MapObjectItem::setPolygon(const QPolygonF &polygon)
     // Not using the MapObjectModel because it is used during object creation,
     // when the object is not actually part of the map yet.
     mObject->setPolygon(polygon);
+    if (ObjectGroup *objectGroup = mObject->objectGroup())
+        objectGroup->updateObjectIndex(mObject);
     syncWithMapObject();
 }
 
 QColor MapObjectItem::objectColor(const MapObject *object)
 {
     // See if this object type has a color associated with it
-    for (const ObjectType &type : Preferences::instance()->objectTypes()) {
-        if (type.name.compare(object->type(), Qt::CaseInsensitive) == 0)
-            return type.color;
-    }
+    const QColor typeColor = Preferences::instance()->objectTypeColor(object->type());
+    if (typeColor.isValid())
+        return typeColor;
 
     // If not, get color from object group
     const ObjectGroup *objectGroup = object->objectGroup();
@@ -34,7 +34,6 @@ namespace Internal {
 class Handle;
 class MapDocument;
 class ObjectGroupItem;
-class PointHandle;
 class ResizeHandle;
 
 /**
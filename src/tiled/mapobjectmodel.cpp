@@ -25,13 +25,20 @@
 #include "layermodel.h"
 #include "mapdocument.h"
 #include "mapobject.h"
+#include "maprenderer.h"
 #include "objectgroup.h"
 #include "renamelayer.h"
 
 #include <QCoreApplication>
 
+#include <algorithm>
+#include <functional>
+
 #define GROUPS_IN_DISPLAY_ORDER 1
 
+// The number of object rows made available at a time
+static const int FetchBatchSize = 1000;
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -43,6 +50,42 @@ MapObjectModel::MapObjectModel(QObject *parent):
 {
 }
 
+/**
+ * Updates the spatial index and drops the cached geometry of an object
+ * whose geometry changed.
+ */
+void MapObjectModel::updateObjectIndex(MapObject *o)
+{
+    if (ObjectGroup *objectGroup = o->objectGroup())
+        objectGroup->updateObjectIndex(o);
+
+    mMapDocument->renderer()->invalidateObjectGeometry(o);
+}
+
+/**
+ * Returns the row of the given object within its object group.
+ *
+ * The row is remembered for each object, and all rows of the object group
+ * are recomputed only when the remembered row turns out to be outdated. This
+ * keeps looking up many objects after a change linear in the number of
+ * objects.
+ */
+int MapObjectModel::objectRow(MapObject *o) const
+{
+    const QList<MapObject*> &objects = o->objectGroup()->objects();
+    const ObjectOrGroup *oog = mObjects.value(o);
+    if (!oog)
+        return objects.indexOf(o);
+
+    if (oog->mRow < 0 || oog->mRow >= objects.size() || objects.at(oog->mRow) != o) {
+        for (int row = 0; row < objects.size(); ++row)
+            if (const ObjectOrGroup *other = mObjects.value(objects.at(row)))
+                other->mRow = row;
+    }
+
+    return oog->mRow;
+}
+
 QModelIndex MapObjectModel::index(int row, int column,
                                   const QModelIndex &parent) const
 {
@@ -55,14 +98,16 @@ QModelIndex MapObjectModel::index(int row, int column,
     ObjectGroup *og = toObjectGroup(parent);
 
     // happens when deleting the last item in a parent
-    if (row >= og->objectCount())
+    if (row >= mGroups.value(og)->mFetchedCount)
         return QModelIndex();
 
     // Paranoia: sometimes "fake" objects are in use (see createobjecttool)
-    if (!mObjects.contains(og->objects().at(row)))
+    ObjectOrGroup *oog = mObjects.value(og->objects().at(row));
+    if (!oog)
         return QModelIndex();
 
-    return createIndex(row, column, mObjects[og->objects()[row]]);
+    oog->mRow = row;
+    return createIndex(row, column, oog);
 }
 
 QModelIndex MapObjectModel::parent(const QModelIndex &index) const
@@ -80,7 +125,7 @@ int MapObjectModel::rowCount(const QModelIndex &parent) const
     if (!parent.isValid())
         return mObjectGroups.size();
     if (ObjectGroup *og = toObjectGroup(parent))
-        return og->objectCount();
+        return mGroups.value(og)->mFetchedCount;
     return 0;
 }
 
@@ -90,6 +135,66 @@ int MapObjectModel::columnCount(const QModelIndex &parent) const
     return 2; // MapObject name|type
 }
 
+bool MapObjectModel::hasChildren(const QModelIndex &parent) const
+{
+    if (!mMapDocument)
+        return false;
+    if (!parent.isValid())
+        return !mObjectGroups.isEmpty();
+    if (ObjectGroup *og = toObjectGroup(parent))
+        return og->objectCount() > 0;
+    return false;
+}
+
+bool MapObjectModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (ObjectGroup *og = toObjectGroup(parent))
+        return mGroups.value(og)->mFetchedCount < og->objectCount();
+    return false;
+}
+
+void MapObjectModel::fetchMore(const QModelIndex &parent)
+{
+    if (ObjectGroup *og = toObjectGroup(parent))
+        fetchRows(og, mGroups.value(og)->mFetchedCount + FetchBatchSize);
+}
+
+/**
+ * Makes the rows of the object group available up to the given \a count.
+ */
+void MapObjectModel::fetchRows(ObjectGroup *og, int count)
+{
+    ObjectOrGroup *groupEntry = mGroups.value(og);
+    count = qMin(count, og->objectCount());
+    if (count <= groupEntry->mFetchedCount)
+        return;
+
+    beginInsertRows(index(og), groupEntry->mFetchedCount, count - 1);
+    groupEntry->mFetchedCount = count;
+    endInsertRows();
+}
+
+/**
+ * Makes sure the rows of the given \a objects are available, so that they
+ * have a valid index. Fetches the rows of each object group at once.
+ */
+void MapObjectModel::fetchObjects(const QList<MapObject *> &objects)
+{
+    QHash<ObjectGroup*, int> counts;
+
+    for (MapObject *o : objects) {
+        ObjectGroup *og = o->objectGroup();
+        if (!og || !mGroups.contains(og))
+            continue;
+
+        int &count = counts[og];
+        count = qMax(count, objectRow(o) + 1);
+    }
+
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+        fetchRows(it.key(), it.value());
+}
+
 QVariant MapObjectModel::data(const QModelIndex &index, int role) const
 {
     if (MapObject *mapObject = toMapObject(index)) {
@@ -220,10 +325,17 @@ QModelIndex MapObjectModel::index(ObjectGroup *og) const
     return createIndex(row, 0, mGroups[og]);
 }
 
+/**
+ * Returns the index of the given object, which is invalid when its row has
+ * not been fetched yet.
+ */
 QModelIndex MapObjectModel::index(MapObject *o, int column) const
 {
-    const int row = o->objectGroup()->objects().indexOf(o);
+    const int row = objectRow(o);
     Q_ASSERT(mObjects[o]);
+    const ObjectOrGroup *groupEntry = mGroups.value(o->objectGroup());
+    if (!groupEntry || row >= groupEntry->mFetchedCount)
+        return QModelIndex();
     return createIndex(row, column, mObjects[o]);
 }
 
@@ -341,8 +453,10 @@ void MapObjectModel::layerAboutToBeRemoved(int index)
         beginRemoveRows(QModelIndex(), row, row);
         mObjectGroups.removeAt(row);
         delete mGroups.take(og);
-        foreach (MapObject *o, og->objects())
+        foreach (MapObject *o, og->objects()) {
             delete mObjects.take(o);
+            mMapDocument->renderer()->invalidateObjectGeometry(o);
+        }
 
         endRemoveRows();
     }
@@ -351,10 +465,22 @@ void MapObjectModel::layerAboutToBeRemoved(int index)
 void MapObjectModel::insertObject(ObjectGroup *og, int index, MapObject *o)
 {
     const int row = (index >= 0) ? index : og->objectCount();
-    beginInsertRows(this->index(og), row, row);
+
+    // Objects inserted after the fetched rows don't need to be reported
+    ObjectOrGroup *groupEntry = mGroups.value(og);
+    const bool fetched = row <= groupEntry->mFetchedCount;
+
+    if (fetched)
+        beginInsertRows(this->index(og), row, row);
     og->insertObject(row, o);
-    mObjects.insert(o, new ObjectOrGroup(o));
-    endInsertRows();
+    ObjectOrGroup *oog = new ObjectOrGroup(o);
+    oog->mRow = row;
+    mObjects.insert(o, oog);
+    if (fetched) {
+        ++groupEntry->mFetchedCount;
+        endInsertRows();
+    }
+    emitObjectsInserted(og, row, row);
     emit objectsAdded(QList<MapObject*>() << o);
 }
 
@@ -363,17 +489,164 @@ int MapObjectModel::removeObject(ObjectGroup *og, MapObject *o)
     QList<MapObject*> objects;
     objects << o;
 
-    const int row = og->objects().indexOf(o);
-    beginRemoveRows(index(og), row, row);
+    const int row = objectRow(o);
+    Q_ASSERT(og->objectAt(row) == o);
+
+    ObjectOrGroup *groupEntry = mGroups.value(og);
+    const bool fetched = row < groupEntry->mFetchedCount;
+
+    if (fetched)
+        beginRemoveRows(index(og), row, row);
     og->removeObjectAt(row);
     delete mObjects.take(o);
-    endRemoveRows();
+    mMapDocument->renderer()->invalidateObjectGeometry(o);
+    if (fetched) {
+        --groupEntry->mFetchedCount;
+        endRemoveRows();
+    }
+    emitObjectsRemoved(og, row, row);
     emit objectsRemoved(objects);
     return row;
 }
 
+/**
+ * Inserts the objects described by the given \a entries, in order.
+ *
+ * Consecutive entries that insert into consecutive rows of the same object
+ * group are inserted as a single range of rows. The objectsAdded signal is
+ * emitted once for all objects.
+ */
+void MapObjectModel::insertObjects(const QVector<ObjectEntry> &entries)
+{
+    if (entries.isEmpty())
+        return;
+
+    QList<MapObject*> objects;
+    objects.reserve(entries.size());
+
+    int i = 0;
+    while (i < entries.size()) {
+        const ObjectEntry &entry = entries.at(i);
+        ObjectGroup *og = entry.objectGroup;
+        const int objectCount = og->objectCount();
+        const int first = (entry.index >= 0) ? entry.index : objectCount;
+
+        int count = 1;
+        for (; i + count < entries.size(); ++count) {
+            const ObjectEntry &next = entries.at(i + count);
+            const int nextRow = (next.index >= 0) ? next.index
+                                                  : objectCount + count;
+            if (next.objectGroup != og || nextRow != first + count)
+                break;
+        }
+
+        QList<MapObject*> range;
+        range.reserve(count);
+        for (int j = 0; j < count; ++j)
+            range.append(entries.at(i + j).mapObject);
+
+        ObjectOrGroup *groupEntry = mGroups.value(og);
+        const bool fetched = first <= groupEntry->mFetchedCount;
+
+        if (fetched)
+            beginInsertRows(index(og), first, first + count - 1);
+        og->insertObjects(first, range);
+        for (int j = 0; j < count; ++j) {
+            MapObject *o = range.at(j);
+            ObjectOrGroup *oog = new ObjectOrGroup(o);
+            oog->mRow = first + j;
+            mObjects.insert(o, oog);
+        }
+        if (fetched) {
+            groupEntry->mFetchedCount += count;
+            endInsertRows();
+        }
+        emitObjectsInserted(og, first, first + count - 1);
+
+        objects.append(range);
+
+        i += count;
+    }
+
+    emit objectsAdded(objects);
+}
+
+static bool entryLessThan(const MapObjectModel::ObjectEntry &a,
+                          const MapObjectModel::ObjectEntry &b)
+{
+    if (a.objectGroup != b.objectGroup)
+        return std::less<ObjectGroup*>()(a.objectGroup, b.objectGroup);
+    return a.index < b.index;
+}
+
+/**
+ * Removes the given \a objects from their object groups.
+ *
+ * Objects in consecutive rows are removed as a single range of rows. The
+ * objectsRemoved signal is emitted once for all objects.
+ *
+ * Returns the entries describing where the objects were removed from,
+ * ordered such that passing them to insertObjects() restores the objects.
+ */
+QVector<MapObjectModel::ObjectEntry> MapObjectModel::removeObjects(const QList<MapObject*> &objects)
+{
+    QVector<ObjectEntry> entries;
+    if (objects.isEmpty())
+        return entries;
+
+    entries.reserve(objects.size());
+    for (MapObject *o : objects)
+        entries.append(ObjectEntry(o, o->objectGroup(), objectRow(o)));
+
+    std::sort(entries.begin(), entries.end(), entryLessThan);
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+
+    // Remove from the back, so that the rows of the remaining entries stay valid
+    int last = entries.size() - 1;
+    while (last >= 0) {
+        ObjectGroup *og = entries.at(last).objectGroup;
+
+        int first = last;
+        while (first > 0 &&
+               entries.at(first - 1).objectGroup == og &&
+               entries.at(first - 1).index == entries.at(first).index - 1)
+            --first;
+
+        const int firstRow = entries.at(first).index;
+        const int lastRow = entries.at(last).index;
+
+        // Only the part of the range within the fetched rows is reported
+        ObjectOrGroup *groupEntry = mGroups.value(og);
+        const int lastFetchedRow = qMin(lastRow, groupEntry->mFetchedCount - 1);
+        const bool fetched = firstRow <= lastFetchedRow;
+
+        if (fetched)
+            beginRemoveRows(index(og), firstRow, lastFetchedRow);
+        for (int row = lastRow; row >= firstRow; --row) {
+            MapObject *o = og->objectAt(row);
+            delete mObjects.take(o);
+            renderer->invalidateObjectGeometry(o);
+            og->removeObjectAt(row);
+        }
+        if (fetched) {
+            groupEntry->mFetchedCount -= lastFetchedRow - firstRow + 1;
+            endRemoveRows();
+        }
+        emitObjectsRemoved(og, firstRow, lastRow);
+
+        last = first - 1;
+    }
+
+    emit objectsRemoved(objects);
+    return entries;
+}
+
 void MapObjectModel::moveObjects(ObjectGroup *og, int from, int to, int count)
 {
+    // The moved rows and the destination need to be available
+    fetchRows(og, qMax(from + count, to));
+
     const QModelIndex parent = index(og);
     if (!beginMoveRows(parent, from, from + count - 1, parent, to)) {
         Q_ASSERT(false); // The code should never attempt this
@@ -382,6 +655,36 @@ void MapObjectModel::moveObjects(ObjectGroup *og, int from, int to, int count)
 
     og->moveObjects(from, to, count);
     endMoveRows();
+
+    // Determine the full range over which object indexes changed
+    emit objectsIndexChanged(og, qMin(from, to), qMax(from + count - 1, to - 1));
+}
+
+/**
+ * Reports the insertion of the objects at \a first to \a last, along with
+ * the change of index of any objects that come after. These are reported
+ * independently of the rows, which are only inserted once fetched.
+ */
+void MapObjectModel::emitObjectsInserted(ObjectGroup *og, int first, int last)
+{
+    emit objectsInserted(og, first, last);
+
+    const int lastIndex = og->objectCount() - 1;
+    if (last < lastIndex)
+        emit objectsIndexChanged(og, last + 1, lastIndex);
+}
+
+/**
+ * Reports the change of index of the objects that came after the removed
+ * objects at \a first to \a last.
+ */
+void MapObjectModel::emitObjectsRemoved(ObjectGroup *og, int first, int last)
+{
+    Q_UNUSED(first)
+
+    const int lastIndex = og->objectCount() - 1;
+    if (last < lastIndex)
+        emit objectsIndexChanged(og, last + 1, lastIndex);
 }
 
 // ObjectGroup color changed
@@ -391,6 +694,10 @@ void MapObjectModel::emitObjectsChanged(const QList<MapObject *> &objects)
     if (objects.isEmpty())
         return;
 
+    // The objects may have been moved or resized
+    for (MapObject *object : objects)
+        updateObjectIndex(object);
+
     emit objectsChanged(objects);
 }
 
@@ -401,7 +708,8 @@ void MapObjectModel::setObjectName(MapObject *o, const QString &name)
 
     o->setName(name);
     QModelIndex index = this->index(o);
-    emit dataChanged(index, index);
+    if (index.isValid())
+        emit dataChanged(index, index);
     emit objectsChanged(QList<MapObject*>() << o);
 }
 
@@ -412,7 +720,8 @@ void MapObjectModel::setObjectType(MapObject *o, const QString &type)
 
     o->setType(type);
     QModelIndex index = this->index(o, 1);
-    emit dataChanged(index, index);
+    if (index.isValid())
+        emit dataChanged(index, index);
     emit objectsChanged(QList<MapObject*>() << o);
 }
 
@@ -422,6 +731,7 @@ void MapObjectModel::setObjectPolygon(MapObject *o, const QPolygonF &polygon)
         return;
 
     o->setPolygon(polygon);
+    updateObjectIndex(o);
     emit objectsChanged(QList<MapObject*>() << o);
 }
 
@@ -431,6 +741,7 @@ void MapObjectModel::setObjectPosition(MapObject *o, const QPointF &pos)
         return;
 
     o->setPosition(pos);
+    updateObjectIndex(o);
     emit objectsChanged(QList<MapObject*>() << o);
 }
 
@@ -440,6 +751,7 @@ void MapObjectModel::setObjectSize(MapObject *o, const QSizeF &size)
         return;
 
     o->setSize(size);
+    updateObjectIndex(o);
     emit objectsChanged(QList<MapObject*>() << o);
 }
 
@@ -449,6 +761,7 @@ void MapObjectModel::setObjectRotation(MapObject *o, qreal rotation)
         return;
 
     o->setRotation(rotation);
+    updateObjectIndex(o);
     emit objectsChanged(QList<MapObject*>() << o);
 }
 
@@ -459,6 +772,7 @@ void MapObjectModel::setObjectVisible(MapObject *o, bool visible)
 
     o->setVisible(visible);
     QModelIndex index = this->index(o);
-    emit dataChanged(index, index);
+    if (index.isValid())
+        emit dataChanged(index, index);
     emit objectsChanged(QList<MapObject*>() << o);
 }
@@ -22,7 +22,9 @@
 #define MAPOBJECTMODEL_H
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QIcon>
+#include <QVector>
 
 namespace Tiled {
 
@@ -38,6 +40,10 @@ class MapDocument;
  * Provides a tree view on the objects present on a map. Also has member
  * functions to modify objects that emit the appropriate signals to allow
  * the UI to update.
+ *
+ * The objects of each object group are made available in batches, when the
+ * view asks for more rows through fetchMore(). This keeps expanding a group
+ * with many objects fast.
  */
 class MapObjectModel : public QAbstractItemModel
 {
@@ -53,15 +59,40 @@ public:
         ObjectOrGroup(ObjectGroup *g)
             : mGroup(g)
             , mObject(nullptr)
+            , mRow(-1)
+            , mFetchedCount(0)
         {
         }
         ObjectOrGroup(MapObject *o)
             : mGroup(nullptr)
             , mObject(o)
+            , mRow(-1)
+            , mFetchedCount(0)
         {
         }
         ObjectGroup *mGroup;
         MapObject *mObject;
+        mutable int mRow;   // last known row of mObject, may be outdated
+        int mFetchedCount;  // number of object rows available for mGroup
+    };
+
+    /**
+     * Describes where an object is inserted or where it was removed from.
+     * An index of -1 means the object is appended to its object group.
+     */
+    struct ObjectEntry
+    {
+        ObjectEntry(MapObject *o = nullptr,
+                    ObjectGroup *og = nullptr,
+                    int index = -1)
+            : mapObject(o)
+            , objectGroup(og)
+            , index(index)
+        {
+        }
+        MapObject *mapObject;
+        ObjectGroup *objectGroup;
+        int index;
     };
 
     MapObjectModel(QObject *parent = nullptr);
@@ -72,6 +103,10 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
     bool setData(const QModelIndex &index, const QVariant &value, int role) override;
@@ -82,6 +117,8 @@ public:
     QModelIndex index(ObjectGroup *og) const;
     QModelIndex index(MapObject *o, int column = 0) const;
 
+    void fetchObjects(const QList<MapObject*> &objects);
+
     ObjectGroup *toObjectGroup(const QModelIndex &index) const;
     MapObject *toMapObject(const QModelIndex &index) const;
     ObjectGroup *toLayer(const QModelIndex &index) const;
@@ -91,6 +128,8 @@ public:
 
     void insertObject(ObjectGroup *og, int index, MapObject *o);
     int removeObject(ObjectGroup *og, MapObject *o);
+    void insertObjects(const QVector<ObjectEntry> &entries);
+    QVector<ObjectEntry> removeObjects(const QList<MapObject*> &objects);
     void moveObjects(ObjectGroup *og, int from, int to, int count);
     void emitObjectsChanged(const QList<MapObject *> &objects);
 
@@ -106,6 +145,8 @@ signals:
     void objectsAdded(const QList<MapObject *> &objects);
     void objectsChanged(const QList<MapObject *> &objects);
     void objectsRemoved(const QList<MapObject *> &objects);
+    void objectsInserted(ObjectGroup *objectGroup, int first, int last);
+    void objectsIndexChanged(ObjectGroup *objectGroup, int first, int last);
 
 private slots:
     void layerAdded(int index);
@@ -113,11 +154,17 @@ private slots:
     void layerAboutToBeRemoved(int index);
 
 private:
+    void updateObjectIndex(MapObject *o);
+    int objectRow(MapObject *o) const;
+    void fetchRows(ObjectGroup *og, int count);
+    void emitObjectsInserted(ObjectGroup *og, int first, int last);
+    void emitObjectsRemoved(ObjectGroup *og, int first, int last);
+
     MapDocument *mMapDocument;
     Map *mMap;
     QList<ObjectGroup*> mObjectGroups;
-    QMap<MapObject*, ObjectOrGroup*> mObjects;
-    QMap<ObjectGroup*, ObjectOrGroup*> mGroups;
+    QHash<MapObject*, ObjectOrGroup*> mObjects;
+    QHash<ObjectGroup*, ObjectOrGroup*> mGroups;
 
     QIcon mObjectGroupIcon;
 };
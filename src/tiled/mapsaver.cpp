@@ -0,0 +1,90 @@
+/*
+ * mapsaver.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapsaver.h"
+
+#include "map.h"
+#include "tmxmapformat.h"
+#include "tracing.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+MapSaver::MapSaver(Map *map,
+                   MapFormat *format,
+                   const QString &fileName,
+                   QObject *parent)
+    : QThread(parent)
+    , mMap(map)
+    , mFormat(format)
+    , mUseTmxFormat(format == nullptr)
+    , mFileName(fileName)
+    , mSucceeded(false)
+{
+}
+
+MapSaver::~MapSaver()
+{
+    wait();
+    delete mMap;
+}
+
+QMutex *MapSaver::writeMutex()
+{
+    static QMutex mutex;
+    return &mutex;
+}
+
+void MapSaver::run()
+{
+    QMutexLocker locker(writeMutex());
+
+    if (mUseTmxFormat) {
+        TmxMapFormat tmxMapFormat;
+        tmxMapFormat.setLayerDataCache(&mLayerDataCache);
+
+        mSucceeded = tmxMapFormat.write(mMap, mFileName);
+        mError = tmxMapFormat.errorString();
+        return;
+    }
+
+    MapFormat *format = mFormat.data();
+    if (!format) {
+        mSucceeded = false;
+        mError = tr("The map format was removed before the map was saved.");
+        return;
+    }
+
+    TmxMapFormat *tmxFormat = qobject_cast<TmxMapFormat*>(format);
+    if (tmxFormat)
+        tmxFormat->setLayerDataCache(&mLayerDataCache);
+
+    {
+        TraceScope trace("MapFormat::write", mFileName);
+        mSucceeded = format->write(mMap, mFileName);
+    }
+    mError = format->errorString();
+
+    if (tmxFormat)
+        tmxFormat->setLayerDataCache(nullptr);
+}
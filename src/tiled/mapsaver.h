@@ -0,0 +1,102 @@
+/*
+ * mapsaver.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPSAVER_H
+#define MAPSAVER_H
+
+#include "layerdatacache.h"
+
+#include <QPointer>
+#include <QString>
+#include <QThread>
+
+class QMutex;
+
+namespace Tiled {
+
+class Map;
+class MapFormat;
+
+namespace Internal {
+
+/**
+ * Writes a map on a separate thread, so that the map it was copied from can
+ * be edited while it is being saved.
+ *
+ * The saver takes ownership of the map it is given, which should be a copy
+ * that is not modified anymore. Its embedded tilesets should be copies as
+ * well, since these are written along with the map. External tilesets are
+ * shared with the original map and are only read.
+ */
+class MapSaver : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructs a saver that writes \a map to \a fileName using \a format,
+     * or the TMX format when \a format is null.
+     */
+    MapSaver(Map *map,
+             MapFormat *format,
+             const QString &fileName,
+             QObject *parent = nullptr);
+
+    ~MapSaver();
+
+    const Map *map() const { return mMap; }
+    const QString &fileName() const { return mFileName; }
+
+    /**
+     * The cache of encoded tile layer data used when writing the map in the
+     * TMX format. Should only be accessed while the saver is not running.
+     */
+    LayerDataCache &layerDataCache() { return mLayerDataCache; }
+
+    /**
+     * Returns whether the map was written. Only valid after the thread has
+     * finished.
+     */
+    bool succeeded() const { return mSucceeded; }
+    const QString &errorString() const { return mError; }
+
+    /**
+     * Map formats are not thread-safe. This mutex is locked while a map is
+     * being written, so that a format is never used by two saves at once.
+     */
+    static QMutex *writeMutex();
+
+protected:
+    void run() override;
+
+private:
+    Map *mMap;
+    QPointer<MapFormat> mFormat;
+    bool mUseTmxFormat;
+    QString mFileName;
+    LayerDataCache mLayerDataCache;
+    bool mSucceeded;
+    QString mError;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MAPSAVER_H
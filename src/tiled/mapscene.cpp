@@ -25,6 +25,7 @@
 
 #include "abstracttool.h"
 #include "containerhelpers.h"
+#include "layercompositeitem.h"
 #include "map.h"
 #include "mapdocument.h"
 #include "mapobject.h"
@@ -42,8 +43,11 @@
 #include "imagelayeritem.h"
 #include "toolmanager.h"
 #include "tilesetmanager.h"
+#include "worlditem.h"
+#include "worldmanager.h"
 
 #include <QGraphicsSceneMouseEvent>
+#include <QHash>
 #include <QPainter>
 #include <QKeyEvent>
 #include <QApplication>
@@ -64,16 +68,23 @@ MapScene::MapScene(QObject *parent):
     mUnderMouse(false),
     mCurrentModifiers(Qt::NoModifier),
     mDarkRectangle(new QGraphicsRectItem),
+    mLayerCompositesScheduled(false),
     mDefaultBackgroundColor(Qt::darkGray),
-    mObjectSelectionItem(nullptr)
+    mObjectSelectionItem(nullptr),
+    mWorldItem(nullptr)
 {
     setBackgroundBrush(mDefaultBackgroundColor);
 
     TilesetManager *tilesetManager = TilesetManager::instance();
     connect(tilesetManager, SIGNAL(tilesetChanged(Tileset*)),
             this, SLOT(tilesetChanged(Tileset*)));
-    connect(tilesetManager, SIGNAL(repaintTileset(Tileset*)),
-            this, SLOT(tilesetChanged(Tileset*)));
+    connect(tilesetManager, &TilesetManager::repaintTiles,
+            this, &MapScene::repaintTiles);
+    connect(tilesetManager, &TilesetManager::tileImagesChanged,
+            this, &MapScene::tileImagesChanged);
+
+    connect(WorldManager::instance(), &WorldManager::worldsChanged,
+            this, &MapScene::refreshScene);
 
     Preferences *prefs = Preferences::instance();
     connect(prefs, SIGNAL(showGridChanged(bool)), SLOT(setGridVisible(bool)));
@@ -104,6 +115,9 @@ MapScene::MapScene(QObject *parent):
 MapScene::~MapScene()
 {
     qApp->removeEventFilter(this);
+
+    // The composites refer to the layer items
+    clearLayerComposites();
 }
 
 void MapScene::setMapDocument(MapDocument *mapDocument)
@@ -126,6 +140,8 @@ void MapScene::setMapDocument(MapDocument *mapDocument)
 
         connect(mMapDocument, SIGNAL(mapChanged()),
                 this, SLOT(mapChanged()));
+        connect(mMapDocument, SIGNAL(mapPropertyChanged()),
+                this, SLOT(mapPropertyChanged()));
         connect(mMapDocument, &MapDocument::regionChanged,
                 this, &MapScene::repaintRegion);
         connect(mMapDocument, SIGNAL(tileLayerDrawMarginsChanged(TileLayer*)),
@@ -144,6 +160,8 @@ void MapScene::setMapDocument(MapDocument *mapDocument)
                 this, SLOT(currentLayerIndexChanged()));
         connect(mMapDocument, SIGNAL(tilesetTileOffsetChanged(Tileset*)),
                 this, SLOT(tilesetTileOffsetChanged(Tileset*)));
+        connect(mMapDocument, SIGNAL(tilesetChanged(Tileset*)),
+                this, SLOT(tilesetChanged(Tileset*)));
         connect(mMapDocument, SIGNAL(objectsInserted(ObjectGroup*,int,int)),
                 this, SLOT(objectsInserted(ObjectGroup*,int,int)));
         connect(mMapDocument, SIGNAL(objectsRemoved(QList<MapObject*>)),
@@ -171,6 +189,125 @@ void MapScene::setSelectedObjectItems(const QSet<MapObjectItem *> &items)
     mMapDocument->setSelectedObjects(selectedObjects);
 }
 
+/**
+ * Returns the MapObjectItem associated with the given \a object, creating
+ * it when it doesn't exist yet.
+ *
+ * Items are created on demand, for objects that are selected, hovered or
+ * otherwise interacted with. Once created, an item remains until its object
+ * is removed or the scene is refreshed.
+ */
+MapObjectItem *MapScene::ensureItemForObject(MapObject *object)
+{
+    if (MapObjectItem *item = mObjectItems.value(object))
+        return item;
+
+    ObjectGroup *objectGroup = object->objectGroup();
+    ObjectGroupItem *ogItem = objectGroupItem(objectGroup);
+    Q_ASSERT(ogItem);
+
+    MapObjectItem *item = new MapObjectItem(object, mMapDocument, ogItem);
+    mObjectItems.insert(object, item);
+    return item;
+}
+
+/**
+ * Returns the objects on visible object groups that may intersect the given
+ * \a rect in scene coordinates, looked up using the spatial index of each
+ * object group. The returned objects still need to be checked against
+ * their actual shape.
+ */
+QList<MapObject*> MapScene::objectsIntersecting(const QRectF &rect) const
+{
+    QList<MapObject*> objects;
+
+    for (QGraphicsItem *item : mLayerItems) {
+        ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(item);
+        if (ogItem && ogItem->isVisible())
+            objects.append(ogItem->objectsIntersecting(rect.translated(-ogItem->pos())));
+    }
+
+    return objects;
+}
+
+/**
+ * Returns the items of the objects on visible object groups that intersect
+ * the given \a path in scene coordinates. The items are returned in the
+ * order in which they are drawn, creating them where necessary.
+ */
+QList<MapObjectItem*> MapScene::objectItemsIntersecting(const QPainterPath &path)
+{
+    QList<MapObjectItem*> items;
+    const QRectF rect = path.boundingRect();
+
+    for (QGraphicsItem *item : mLayerItems) {
+        ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(item);
+        if (!ogItem || !ogItem->isVisible())
+            continue;
+
+        const QPointF offset = ogItem->pos();
+        const QPainterPath localPath = path.translated(-offset);
+
+        QList<MapObject*> objects = ogItem->objectsIntersecting(rect.translated(-offset));
+        ogItem->sortByDrawOrder(objects);
+
+        for (MapObject *object : objects)
+            if (ogItem->objectShape(object).intersects(localPath))
+                items.append(ensureItemForObject(object));
+    }
+
+    return items;
+}
+
+/**
+ * Returns the item of the top-most object at the given \a pos in scene
+ * coordinates, creating it when necessary. Returns nullptr when there is no
+ * object at this position.
+ */
+MapObjectItem *MapScene::topMostObjectItemAt(const QPointF &pos)
+{
+    for (int i = mLayerItems.size() - 1; i >= 0; --i) {
+        ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(mLayerItems.at(i));
+        if (!ogItem || !ogItem->isVisible())
+            continue;
+
+        const QPointF localPos = pos - ogItem->pos();
+
+        QList<MapObject*> objects = ogItem->objectsIntersecting(QRectF(localPos, QSizeF(0, 0)));
+        ogItem->sortByDrawOrder(objects);
+
+        for (int j = objects.size() - 1; j >= 0; --j) {
+            MapObject *object = objects.at(j);
+            if (ogItem->objectContains(object, localPos))
+                return ensureItemForObject(object);
+        }
+    }
+
+    return nullptr;
+}
+
+ObjectGroupItem *MapScene::objectGroupItem(ObjectGroup *objectGroup) const
+{
+    const int index = mMapDocument->map()->layers().indexOf(objectGroup);
+    if (index == -1)
+        return nullptr;
+    return static_cast<ObjectGroupItem*>(mLayerItems.at(index));
+}
+
+/**
+ * Synchronizes the object group items and the created object items, for
+ * when the way objects are rendered may have changed.
+ */
+void MapScene::syncObjectGroupItems()
+{
+    for (QGraphicsItem *item : mLayerItems)
+        if (ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(item))
+            ogItem->syncWithObjectGroup();
+
+    for (MapObjectItem *item : mObjectItems)
+        item->syncWithMapObject();
+}
+
 void MapScene::setSelectedTool(AbstractTool *tool)
 {
     mSelectedTool = tool;
@@ -178,27 +315,34 @@ void MapScene::setSelectedTool(AbstractTool *tool)
 
 void MapScene::refreshScene()
 {
+    clearLayerComposites();
     mLayerItems.clear();
     mObjectItems.clear();
 
     removeItem(mDarkRectangle);
     clear();
     addItem(mDarkRectangle);
+    mWorldItem = nullptr;
 
     if (!mMapDocument) {
         setSceneRect(QRectF());
         return;
     }
 
+    // Show the maps around this one when it is part of a world
+    const QString &fileName = mMapDocument->fileName();
+    if (const World *world = WorldManager::instance()->worldForMap(fileName)) {
+        mWorldItem = new WorldItem(world, world->mapIndex(fileName));
+        mWorldItem->setZValue(-1);
+        addItem(mWorldItem);
+    }
+
     updateSceneRect();
 
     const Map *map = mMapDocument->map();
     mLayerItems.resize(map->layerCount());
 
-    if (map->backgroundColor().isValid())
-        setBackgroundBrush(map->backgroundColor());
-    else
-        setBackgroundBrush(mDefaultBackgroundColor);
+    updateBackgroundBrush();
 
     int layerIndex = 0;
     for (Layer *layer : map->layers()) {
@@ -227,21 +371,8 @@ QGraphicsItem *MapScene::createLayerItem(Layer *layer)
     if (TileLayer *tl = layer->asTileLayer()) {
         layerItem = new TileLayerItem(tl, mMapDocument);
     } else if (ObjectGroup *og = layer->asObjectGroup()) {
-        const ObjectGroup::DrawOrder drawOrder = og->drawOrder();
-        ObjectGroupItem *ogItem = new ObjectGroupItem(og);
-        int objectIndex = 0;
-        for (MapObject *object : og->objects()) {
-            MapObjectItem *item = new MapObjectItem(object, mMapDocument,
-                                                    ogItem);
-            if (drawOrder == ObjectGroup::TopDownOrder)
-                item->setZValue(item->y());
-            else
-                item->setZValue(objectIndex);
-
-            mObjectItems.insert(object, item);
-            ++objectIndex;
-        }
-        layerItem = ogItem;
+        // Items for the objects are only created when needed
+        layerItem = new ObjectGroupItem(og, mMapDocument);
     } else if (ImageLayer *il = layer->asImageLayer()) {
         layerItem = new ImageLayerItem(il, mMapDocument);
     }
@@ -263,6 +394,23 @@ void MapScene::updateSceneRect()
                      margins.right(),
                      margins.bottom());
 
+    const Map *map = mMapDocument->map();
+    if (map->infinite()) {
+        // Include the cells outside of the map size and leave some room
+        // around them to paint further
+        const MapRenderer *renderer = mMapDocument->renderer();
+        for (const TileLayer *tileLayer : map->tileLayers()) {
+            const QRect cells = tileLayer->cellBounds().translated(tileLayer->position());
+            sceneRect |= renderer->boundingRect(cells).translated(tileLayer->offset());
+        }
+
+        const qreal extra = qMax<qreal>(1024, qMax(mapSize.width(), mapSize.height()));
+        sceneRect.adjust(-extra, -extra, extra, extra);
+    }
+
+    if (mWorldItem)
+        sceneRect |= mWorldItem->boundingRect();
+
     setSceneRect(sceneRect);
     mDarkRectangle->setRect(sceneRect);
 }
@@ -272,6 +420,9 @@ void MapScene::updateCurrentLayerHighlight()
     if (!mMapDocument)
         return;
 
+    // The composited layers are drawn with their previous opacity
+    invalidateLayerComposites();
+
     const int currentLayerIndex = mMapDocument->currentLayerIndex();
 
     if (!mHighlightCurrentLayer || currentLayerIndex == -1) {
@@ -298,12 +449,139 @@ void MapScene::updateCurrentLayerHighlight()
     }
 }
 
+/**
+ * Composites the consecutive tile layers that are not being edited while the
+ * current layer is highlighted, so that repaints caused by editing the
+ * current layer don't need to draw each of these layers.
+ *
+ * Layers with animated tiles are left out, since they change all the time.
+ */
+void MapScene::updateLayerComposites()
+{
+    mLayerCompositesScheduled = false;
+    clearLayerComposites();
+
+    if (!mMapDocument || !mHighlightCurrentLayer)
+        return;
+
+    const int currentLayerIndex = mMapDocument->currentLayerIndex();
+    if (currentLayerIndex == -1)
+        return;
+
+    QVector<TileLayerItem*> layerItems;
+
+    auto addComposite = [&] {
+        if (layerItems.size() > 1) {
+            LayerCompositeItem *composite = new LayerCompositeItem(layerItems,
+                                                                   mMapDocument);
+            addItem(composite);
+            mLayerComposites.append(composite);
+        }
+        layerItems.clear();
+    };
+
+    for (int i = 0; i < mLayerItems.size(); ++i) {
+        TileLayerItem *tli = dynamic_cast<TileLayerItem*>(mLayerItems.at(i));
+
+        // Hidden tile layers draw nothing, so they don't have to end a range
+        if (tli && !tli->isVisible())
+            continue;
+
+        if (i == currentLayerIndex || !tli || tli->hasAnimatedTiles()) {
+            addComposite();
+            continue;
+        }
+
+        layerItems.append(tli);
+    }
+
+    addComposite();
+}
+
+void MapScene::clearLayerComposites()
+{
+    qDeleteAll(mLayerComposites);
+    mLayerComposites.clear();
+}
+
+/**
+ * Removes the layer composites, because any of their layers may have
+ * changed, and schedules them to be created again.
+ *
+ * The composites are released right away, so that the layers are drawn by
+ * themselves until then.
+ */
+void MapScene::invalidateLayerComposites()
+{
+    clearLayerComposites();
+
+    if (!mHighlightCurrentLayer || mLayerCompositesScheduled)
+        return;
+
+    mLayerCompositesScheduled = true;
+    QMetaObject::invokeMethod(this, "updateLayerComposites",
+                              Qt::QueuedConnection);
+}
+
+bool MapScene::isComposited(int layerIndex) const
+{
+    return mLayerItems.at(layerIndex)->flags() & QGraphicsItem::ItemHasNoContents;
+}
+
+/**
+ * Returns the rectangles of \a region to repaint. Regions made up of many
+ * rectangles, like those changed by a random fill, are coalesced into one
+ * rectangle for each chunk of cells that they touch. This keeps the number
+ * of rectangles proportional to the number of chunks.
+ */
+static QVector<QRect> coalescedRects(const QRegion &region)
+{
+    const QVector<QRect> rects = region.rects();
+    if (rects.size() <= 16)
+        return rects;
+
+    QHash<QPoint, QRect> chunks;
+
+    for (const QRect &rect : rects) {
+        const int startX = rect.left() >> CHUNK_BITS;
+        const int startY = rect.top() >> CHUNK_BITS;
+        const int endX = rect.right() >> CHUNK_BITS;
+        const int endY = rect.bottom() >> CHUNK_BITS;
+
+        for (int y = startY; y <= endY; ++y) {
+            for (int x = startX; x <= endX; ++x) {
+                const QRect chunkRect(x * CHUNK_SIZE, y * CHUNK_SIZE,
+                                      CHUNK_SIZE, CHUNK_SIZE);
+                QRect &bounds = chunks[QPoint(x, y)];
+                bounds |= rect & chunkRect;
+            }
+        }
+    }
+
+    return chunks.values().toVector();
+}
+
 void MapScene::repaintRegion(const QRegion &region, Layer *layer)
 {
     const MapRenderer *renderer = mMapDocument->renderer();
     const QMargins margins = mMapDocument->map()->drawMargins();
 
-    for (const QRect &r : region.rects()) {
+    const int index = mMapDocument->map()->layers().indexOf(layer);
+    TileLayerItem *tileLayerItem = nullptr;
+    if (index != -1)
+        tileLayerItem = dynamic_cast<TileLayerItem*>(mLayerItems.at(index));
+
+    if (tileLayerItem) {
+        if (tileLayerItem->coverCells(region.boundingRect()))
+            updateSceneRect();
+
+        tileLayerItem->invalidateAnimatedCells(region);
+
+        if (isComposited(index))
+            invalidateLayerComposites();
+    }
+
+    for (const QRect &r : coalescedRects(region)) {
         QRectF boundingRect = renderer->boundingRect(r);
 
         boundingRect.adjust(-margins.left(),
@@ -311,6 +589,9 @@ void MapScene::repaintRegion(const QRegion &region, Layer *layer)
                             margins.right(),
                             margins.bottom());
 
+        if (tileLayerItem)
+            tileLayerItem->invalidateCache(boundingRect);
+
         boundingRect.translate(layer->offset());
 
         update(boundingRect);
@@ -361,6 +642,7 @@ void MapScene::currentLayerIndexChanged()
  */
 void MapScene::mapChanged()
 {
+    invalidateLayerComposites();
     updateSceneRect();
 
     for (QGraphicsItem *item : mLayerItems) {
@@ -368,9 +650,22 @@ void MapScene::mapChanged()
             tli->syncWithTileLayer();
     }
 
-    for (MapObjectItem *item : mObjectItems)
-        item->syncWithMapObject();
+    syncObjectGroupItems();
+    updateBackgroundBrush();
+}
+
+/**
+ * Only repaints the scene, since the changed property doesn't affect the
+ * geometry of any of the items.
+ */
+void MapScene::mapPropertyChanged()
+{
+    updateBackgroundBrush();
+    update();
+}
 
+void MapScene::updateBackgroundBrush()
+{
     const Map *map = mMapDocument->map();
     if (map->backgroundColor().isValid())
         setBackgroundBrush(map->backgroundColor());
@@ -383,8 +678,84 @@ void MapScene::tilesetChanged(Tileset *tileset)
     if (!mMapDocument)
         return;
 
-    if (contains(mMapDocument->map()->tilesets(), tileset))
+    if (contains(mMapDocument->map()->tilesets(), tileset)) {
+        invalidateLayerComposites();
+
+        for (QGraphicsItem *item : mLayerItems)
+            if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
+                tli->tilesetChanged(tileset);
+
         update();
+    }
+}
+
+/**
+ * Repaints the tile layers and tile objects showing any of the given
+ * animated \a tiles, which have changed to a different frame.
+ */
+void MapScene::repaintTiles(const QSet<Tile*> &tiles)
+{
+    if (!mMapDocument)
+        return;
+
+    QSet<const Tile*> constTiles;
+    for (const Tile *tile : tiles)
+        constTiles.insert(tile);
+
+    for (QGraphicsItem *item : mLayerItems) {
+        if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
+            tli->repaintTiles(tiles);
+        else if (ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(item))
+            repaintTileObjects(ogItem, constTiles);
+    }
+}
+
+/**
+ * Repaints the tile layers and tile objects showing any of the given
+ * \a tiles, of which the image has changed.
+ */
+void MapScene::tileImagesChanged(Tileset *tileset, const QList<Tile*> &tiles)
+{
+    if (!mMapDocument || !contains(mMapDocument->map()->tilesets(), tileset))
+        return;
+
+    invalidateLayerComposites();
+
+    QSet<const Tile*> changedTiles;
+    for (const Tile *tile : tiles)
+        changedTiles.insert(tile);
+
+    for (QGraphicsItem *item : mLayerItems) {
+        if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
+            tli->tileImagesChanged(tileset, changedTiles);
+        else if (ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(item))
+            repaintTileObjects(ogItem, changedTiles);
+    }
+}
+
+/**
+ * Repaints the objects in the group of \a ogItem that show any of the given
+ * \a tiles.
+ */
+void MapScene::repaintTileObjects(ObjectGroupItem *ogItem,
+                                  const QSet<const Tile*> &tiles)
+{
+    QList<MapObject*> changedObjects;
+
+    for (MapObject *object : ogItem->objectGroup()->objects()) {
+        const Tile *tile = object->cell().tile;
+        if (!tile)
+            continue;
+
+        if (tiles.contains(tile) || tiles.contains(tile->currentFrameTile())) {
+            changedObjects.append(object);
+            if (MapObjectItem *objectItem = mObjectItems.value(object))
+                objectItem->update();
+        }
+    }
+
+    if (!changedObjects.isEmpty())
+        ogItem->objectsChanged(changedObjects);
 }
 
 void MapScene::tileLayerDrawMarginsChanged(TileLayer *tileLayer)
@@ -392,6 +763,9 @@ void MapScene::tileLayerDrawMarginsChanged(TileLayer *tileLayer)
     const int index = mMapDocument->map()->layers().indexOf(tileLayer);
     TileLayerItem *item = static_cast<TileLayerItem*>(mLayerItems.at(index));
     item->syncWithTileLayer();
+
+    if (isComposited(index))
+        invalidateLayerComposites();
 }
 
 void MapScene::layerAdded(int index)
@@ -404,10 +778,14 @@ void MapScene::layerAdded(int index)
     int z = 0;
     for (QGraphicsItem *item : mLayerItems)
         item->setZValue(z++);
+
+    invalidateLayerComposites();
 }
 
 void MapScene::layerRemoved(int index)
 {
+    invalidateLayerComposites();
+
     delete mLayerItems.at(index);
     mLayerItems.remove(index);
 }
@@ -421,19 +799,30 @@ void MapScene::layerChanged(int index)
     const Layer *layer = mMapDocument->map()->layerAt(index);
     QGraphicsItem *layerItem = mLayerItems.at(index);
 
-    layerItem->setVisible(layer->isVisible());
+    // Any layer may affect which tile layers can be composited
+    if (mHighlightCurrentLayer)
+        invalidateLayerComposites();
+
+    // A tile layer that is shown again keeps its cached rendering, while
+    // one that is shown for the first time may still need loading
+    if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(layerItem))
+        tli->syncVisibility();
+    else
+        layerItem->setVisible(layer->isVisible());
 
     qreal multiplier = 1;
     if (mHighlightCurrentLayer && mMapDocument->currentLayerIndex() < index)
         multiplier = opacityFactor;
 
     layerItem->setOpacity(layer->opacity() * multiplier);
-    layerItem->setPos(layer->offset());
 
-    // Layer offset may have changed, affecting the scene rect and grid
-    updateSceneRect();
-    if (mGridVisible)
-        update();
+    // Only a change of layer offset affects the scene rect and grid
+    if (layerItem->pos() != layer->offset()) {
+        layerItem->setPos(layer->offset());
+        updateSceneRect();
+        if (mGridVisible)
+            update();
+    }
 }
 
 /**
@@ -442,8 +831,8 @@ void MapScene::layerChanged(int index)
  */
 void MapScene::objectGroupChanged(ObjectGroup *objectGroup)
 {
-    objectsChanged(objectGroup->objects());
     objectsIndexChanged(objectGroup, 0, objectGroup->objectCount() - 1);
+    objectsChanged(objectGroup->objects());
 }
 
 /**
@@ -465,12 +854,17 @@ void MapScene::imageLayerChanged(ImageLayer *imageLayer)
  */
 void MapScene::tilesetTileOffsetChanged(Tileset *tileset)
 {
+    invalidateLayerComposites();
     update();
 
     for (QGraphicsItem *item : mLayerItems)
         if (TileLayerItem *tli = dynamic_cast<TileLayerItem*>(item))
             tli->syncWithTileLayer();
 
+    for (QGraphicsItem *item : mLayerItems)
+        if (ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(item))
+            ogItem->syncWithObjectGroup();
+
     for (MapObjectItem *item : mObjectItems) {
         const Cell &cell = item->mapObject()->cell();
         if (!cell.isEmpty() && cell.tile->tileset() == tileset)
@@ -479,37 +873,16 @@ void MapScene::tilesetTileOffsetChanged(Tileset *tileset)
 }
 
 /**
- * Inserts map object items for the given objects.
+ * Repaints the given inserted objects. Their items are only created when
+ * needed.
  */
 void MapScene::objectsInserted(ObjectGroup *objectGroup, int first, int last)
 {
-    ObjectGroupItem *ogItem = nullptr;
-
-    // Find the object group item for the object group
-    for (QGraphicsItem *item : mLayerItems) {
-        if (ObjectGroupItem *ogi = dynamic_cast<ObjectGroupItem*>(item)) {
-            if (ogi->objectGroup() == objectGroup) {
-                ogItem = ogi;
-                break;
-            }
-        }
-    }
-
+    ObjectGroupItem *ogItem = objectGroupItem(objectGroup);
     Q_ASSERT(ogItem);
 
-    const ObjectGroup::DrawOrder drawOrder = objectGroup->drawOrder();
-
-    for (int i = first; i <= last; ++i) {
-        MapObject *object = objectGroup->objectAt(i);
-
-        MapObjectItem *item = new MapObjectItem(object, mMapDocument, ogItem);
-        if (drawOrder == ObjectGroup::TopDownOrder)
-            item->setZValue(item->y());
-        else
-            item->setZValue(i);
-
-        mObjectItems.insert(object, item);
-    }
+    ogItem->invalidateDrawOrder();
+    ogItem->objectsChanged(objectGroup->objects().mid(first, last - first + 1));
 }
 
 /**
@@ -519,12 +892,18 @@ void MapScene::objectsRemoved(const QList<MapObject*> &objects)
 {
     for (MapObject *o : objects) {
         ObjectItems::iterator i = mObjectItems.find(o);
-        Q_ASSERT(i != mObjectItems.end());
+        if (i == mObjectItems.end())
+            continue;
 
         mSelectedObjectItems.remove(i.value());
         delete i.value();
         mObjectItems.erase(i);
     }
+
+    // The objects are no longer part of any group, so repaint all groups
+    for (QGraphicsItem *item : mLayerItems)
+        if (ObjectGroupItem *ogItem = dynamic_cast<ObjectGroupItem*>(item))
+            ogItem->invalidateDrawOrder();
 }
 
 /**
@@ -532,29 +911,44 @@ void MapScene::objectsRemoved(const QList<MapObject*> &objects)
  */
 void MapScene::objectsChanged(const QList<MapObject*> &objects)
 {
+    QHash<ObjectGroup*, QList<MapObject*>> objectsByGroup;
+    QSet<ObjectGroup*> groupsToRepaint;
+
     for (MapObject *object : objects) {
-        MapObjectItem *item = itemForObject(object);
-        Q_ASSERT(item);
+        ObjectGroup *objectGroup = object->objectGroup();
 
-        item->syncWithMapObject();
+        // An object item takes care of repainting the previous area of its
+        // object. Without an item, this area is not known.
+        if (MapObjectItem *item = itemForObject(object))
+            item->syncWithMapObject();
+        else if (objectGroup)
+            groupsToRepaint.insert(objectGroup);
+
+        if (objectGroup)
+            objectsByGroup[objectGroup].append(object);
+    }
+
+    for (auto it = objectsByGroup.constBegin(); it != objectsByGroup.constEnd(); ++it) {
+        if (ObjectGroupItem *ogItem = objectGroupItem(it.key())) {
+            ogItem->objectsChanged(it.value());
+            if (groupsToRepaint.contains(it.key()))
+                ogItem->update();
+        }
     }
 }
 
 /**
- * Updates the Z value of the objects when appropriate.
+ * Updates the draw order of the object group. The index of objects is also
+ * used by the top-down draw order, for objects on the same height.
  */
 void MapScene::objectsIndexChanged(ObjectGroup *objectGroup,
                                    int first, int last)
 {
-    if (objectGroup->drawOrder() != ObjectGroup::IndexOrder)
-        return;
-
-    for (int i = first; i <= last; ++i) {
-        MapObjectItem *item = itemForObject(objectGroup->objectAt(i));
-        Q_ASSERT(item);
+    Q_UNUSED(first)
+    Q_UNUSED(last)
 
-        item->setZValue(i);
-    }
+    if (ObjectGroupItem *ogItem = objectGroupItem(objectGroup))
+        ogItem->invalidateDrawOrder();
 }
 
 void MapScene::updateSelectedObjectItems()
@@ -562,12 +956,8 @@ void MapScene::updateSelectedObjectItems()
     const QList<MapObject *> &objects = mMapDocument->selectedObjects();
 
     QSet<MapObjectItem*> items;
-    for (MapObject *object : objects) {
-        MapObjectItem *item = itemForObject(object);
-        Q_ASSERT(item);
-
-        items.insert(item);
-    }
+    for (MapObject *object : objects)
+        items.insert(ensureItemForObject(object));
 
     mSelectedObjectItems = items;
     emit selectedObjectItemsChanged();
@@ -575,8 +965,7 @@ void MapScene::updateSelectedObjectItems()
 
 void MapScene::syncAllObjectItems()
 {
-    for (MapObjectItem *item : mObjectItems)
-        item->syncWithMapObject();
+    syncObjectGroupItems();
 }
 
 /**
@@ -602,12 +991,8 @@ void MapScene::setObjectLineWidth(qreal lineWidth)
         mMapDocument->renderer()->setObjectLineWidth(lineWidth);
 
         // Changing the line width can change the size of the object items
-        if (!mObjectItems.isEmpty()) {
-            for (MapObjectItem *item : mObjectItems)
-                item->syncWithMapObject();
-
-            update();
-        }
+        syncObjectGroupItems();
+        update();
     }
 }
 
@@ -620,8 +1005,7 @@ void MapScene::setShowTileObjectOutlines(bool enabled)
 
     if (mMapDocument) {
         mMapDocument->renderer()->setFlag(ShowTileObjectOutlines, enabled);
-        if (!mObjectItems.isEmpty())
-            update();
+        update();
     }
 }
 
@@ -689,6 +1073,10 @@ void MapScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
     if (!mMapDocument)
         return;
 
+    // Make sure the hovered object has an item, for showing its tool tip
+    if (mouseEvent->buttons() == Qt::NoButton)
+        topMostObjectItemAt(mLastMousePos);
+
     QGraphicsScene::mouseMoveEvent(mouseEvent);
     if (mouseEvent->isAccepted())
         return;
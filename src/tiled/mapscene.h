@@ -35,17 +35,20 @@ class ImageLayer;
 class Layer;
 class MapObject;
 class ObjectGroup;
+class Tile;
 class TileLayer;
 class Tileset;
 
 namespace Internal {
 
 class AbstractTool;
+class LayerCompositeItem;
 class MapDocument;
 class MapObjectItem;
 class MapScene;
 class ObjectGroupItem;
 class ObjectSelectionItem;
+class WorldItem;
 
 /**
  * A graphics scene that represents the contents of a map.
@@ -93,11 +96,20 @@ public:
     void setSelectedObjectItems(const QSet<MapObjectItem*> &items);
 
     /**
-     * Returns the MapObjectItem associated with the given \a mapObject.
+     * Returns the MapObjectItem associated with the given \a mapObject, if
+     * it has been created.
+     *
+     * \sa ensureItemForObject()
      */
     MapObjectItem *itemForObject(MapObject *object) const
     { return mObjectItems.value(object); }
 
+    MapObjectItem *ensureItemForObject(MapObject *object);
+
+    QList<MapObject*> objectsIntersecting(const QRectF &rect) const;
+    QList<MapObjectItem*> objectItemsIntersecting(const QPainterPath &path);
+    MapObjectItem *topMostObjectItemAt(const QPointF &pos);
+
     /**
      * Enables the selected tool at this map scene.
      * Therefore it tells that tool, that this is the active map scene.
@@ -154,7 +166,10 @@ private slots:
     void currentLayerIndexChanged();
 
     void mapChanged();
+    void mapPropertyChanged();
     void tilesetChanged(Tileset *tileset);
+    void repaintTiles(const QSet<Tile*> &tiles);
+    void tileImagesChanged(Tileset *tileset, const QList<Tile*> &tiles);
     void tileLayerDrawMarginsChanged(TileLayer *tileLayer);
 
     void layerAdded(int index);
@@ -174,12 +189,23 @@ private slots:
     void updateSelectedObjectItems();
     void syncAllObjectItems();
 
+    void updateLayerComposites();
+
 private:
     QGraphicsItem *createLayerItem(Layer *layer);
+    void repaintTileObjects(ObjectGroupItem *ogItem,
+                            const QSet<const Tile*> &tiles);
+    ObjectGroupItem *objectGroupItem(ObjectGroup *objectGroup) const;
+    void syncObjectGroupItems();
 
     void updateSceneRect();
+    void updateBackgroundBrush();
     void updateCurrentLayerHighlight();
 
+    void clearLayerComposites();
+    void invalidateLayerComposites();
+    bool isComposited(int layerIndex) const;
+
     bool eventFilter(QObject *object, QEvent *event) override;
 
     MapDocument *mMapDocument;
@@ -194,8 +220,11 @@ private:
     QPointF mLastMousePos;
     QVector<QGraphicsItem*> mLayerItems;
     QGraphicsRectItem *mDarkRectangle;
+    QVector<LayerCompositeItem*> mLayerComposites;
+    bool mLayerCompositesScheduled;
     QColor mDefaultBackgroundColor;
     ObjectSelectionItem *mObjectSelectionItem;
+    WorldItem *mWorldItem;
 
     typedef QMap<MapObject*, MapObjectItem*> ObjectItems;
     ObjectItems mObjectItems;
@@ -22,6 +22,7 @@
 
 #include "mainwindow.h"
 #include "mapformat.h"
+#include "mapthumbnailprovider.h"
 #include "pluginmanager.h"
 #include "preferences.h"
 #include "utils.h"
@@ -41,15 +42,37 @@
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+static const int ThumbnailSize = 32;
+
 /**
  * Class represents the file system model with disabled dragging of directories.
+ * Map files are decorated with a thumbnail once it is available.
  */
 class FileSystemModel : public QFileSystemModel
 {
 public:
     explicit FileSystemModel(QObject *parent = nullptr):
-        QFileSystemModel(parent)
+        QFileSystemModel(parent),
+        mThumbnails(new MapThumbnailProvider(QSize(ThumbnailSize, ThumbnailSize), this))
     {
+        connect(mThumbnails, &MapThumbnailProvider::thumbnailReady,
+                this, [this] (const QString &fileName) {
+            const QModelIndex index = this->index(fileName);
+            if (index.isValid())
+                emit dataChanged(index, index, QVector<int>() << Qt::DecorationRole);
+        });
+    }
+
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        if (role == Qt::DecorationRole && index.column() == 0 && !isDir(index)) {
+            // Until the thumbnail is ready, the file icon serves as placeholder
+            const QPixmap thumbnail = mThumbnails->thumbnail(filePath(index),
+                                                             lastModified(index));
+            if (!thumbnail.isNull())
+                return thumbnail;
+        }
+        return QFileSystemModel::data(index, role);
     }
 
     Qt::ItemFlags flags(const QModelIndex &i) const override
@@ -59,6 +82,9 @@ public:
             flags &= ~Qt::ItemIsDragEnabled;
         return flags;
     }
+
+private:
+    MapThumbnailProvider *mThumbnails;
 };
 
 MapsDock::MapsDock(MainWindow *mainWindow, QWidget *parent)
@@ -150,6 +176,7 @@ MapsView::MapsView(MainWindow *mainWindow, QWidget *parent)
     setUniformRowHeights(true);
     setDragEnabled(true);
     setDefaultDropAction(Qt::MoveAction);
+    setIconSize(QSize(ThumbnailSize, ThumbnailSize));
 
     Preferences *prefs = Preferences::instance();
     connect(prefs, SIGNAL(mapsDirectoryChanged()),
@@ -0,0 +1,265 @@
+/*
+ * mapthumbnailprovider.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapthumbnailprovider.h"
+
+#include "map.h"
+#include "mapformat.h"
+#include "pluginmanager.h"
+#include "thumbnailrenderer.h"
+#include "tmxmapformat.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QTimer>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+static const char SourceKey[] = "Tiled-Source";
+static const char ModifiedKey[] = "Tiled-Modified";
+
+static QString modifiedText(const QDateTime &lastModified)
+{
+    return QString::number(lastModified.toMSecsSinceEpoch());
+}
+
+namespace {
+
+/**
+ * Looks up the thumbnail of a map in the disk cache. Reports a null image
+ * when there is no thumbnail or when it is outdated.
+ */
+class LoadThumbnailTask : public QRunnable
+{
+public:
+    LoadThumbnailTask(MapThumbnailProvider *provider,
+                      const QString &fileName,
+                      const QDateTime &lastModified,
+                      const QString &cacheFileName,
+                      const QSize &size)
+        : mProvider(provider)
+        , mFileName(fileName)
+        , mLastModified(lastModified)
+        , mCacheFileName(cacheFileName)
+        , mSize(size)
+    {}
+
+    void run() override
+    {
+        QImage image;
+
+        QImageReader reader(mCacheFileName, "png");
+        if (reader.canRead() &&
+                reader.text(QLatin1String(SourceKey)) == mFileName &&
+                reader.text(QLatin1String(ModifiedKey)) == modifiedText(mLastModified)) {
+            image = reader.read();
+            if (image.size() != mSize)
+                image = QImage();
+        }
+
+        QMetaObject::invokeMethod(mProvider, "cachedThumbnailLoaded",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QString, mFileName),
+                                  Q_ARG(QDateTime, mLastModified),
+                                  Q_ARG(QImage, image));
+    }
+
+private:
+    MapThumbnailProvider *mProvider;
+    const QString mFileName;
+    const QDateTime mLastModified;
+    const QString mCacheFileName;
+    const QSize mSize;
+};
+
+/**
+ * Writes a rendered thumbnail to the disk cache.
+ */
+class SaveThumbnailTask : public QRunnable
+{
+public:
+    SaveThumbnailTask(const QImage &image, const QString &cacheFileName)
+        : mImage(image)
+        , mCacheFileName(cacheFileName)
+    {}
+
+    void run() override
+    {
+        QDir().mkpath(QFileInfo(mCacheFileName).path());
+        mImage.save(mCacheFileName, "png");
+    }
+
+private:
+    const QImage mImage;
+    const QString mCacheFileName;
+};
+
+} // anonymous namespace
+
+/**
+ * Reads the map at \a fileName with the first format that supports it.
+ * Returns null when the map could not be read.
+ */
+static Map *readMap(const QString &fileName)
+{
+    TmxMapFormat tmxMapFormat;
+    if (tmxMapFormat.supportsFile(fileName))
+        return tmxMapFormat.read(fileName);
+
+    for (MapFormat *format : PluginManager::objects<MapFormat>()) {
+        if ((format->capabilities() & MapFormat::Read) && format->supportsFile(fileName))
+            return format->read(fileName);
+    }
+
+    return nullptr;
+}
+
+MapThumbnailProvider::MapThumbnailProvider(const QSize &size, QObject *parent)
+    : QObject(parent)
+    , mSize(size)
+    , mThumbnails(4 * 1024)     // in KiB
+    , mRenderScheduled(false)
+{
+    const QString cacheLocation =
+            QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    if (!cacheLocation.isEmpty())
+        mCacheDirectory = cacheLocation + QLatin1String("/thumbnails");
+}
+
+MapThumbnailProvider::~MapThumbnailProvider()
+{
+    mThreadPool.clear();
+    mThreadPool.waitForDone();
+}
+
+/**
+ * Returns the thumbnail of the map at \a fileName, which was last modified
+ * at \a lastModified. Returns a null pixmap when the thumbnail is not
+ * available yet, in which case thumbnailReady() is emitted once it is.
+ */
+QPixmap MapThumbnailProvider::thumbnail(const QString &fileName,
+                                        const QDateTime &lastModified)
+{
+    if (const Thumbnail *thumbnail = mThumbnails.object(fileName))
+        if (thumbnail->lastModified == lastModified)
+            return thumbnail->pixmap;
+
+    if (mPending.contains(fileName))
+        return QPixmap();
+
+    mPending.insert(fileName);
+
+    if (mCacheDirectory.isEmpty()) {
+        mRenderQueue.append(PendingThumbnail { fileName, lastModified });
+        scheduleRender();
+    } else {
+        mThreadPool.start(new LoadThumbnailTask(this, fileName, lastModified,
+                                                cacheFileName(fileName),
+                                                mSize));
+    }
+
+    return QPixmap();
+}
+
+void MapThumbnailProvider::cachedThumbnailLoaded(const QString &fileName,
+                                                 const QDateTime &lastModified,
+                                                 const QImage &image)
+{
+    if (image.isNull()) {
+        mRenderQueue.append(PendingThumbnail { fileName, lastModified });
+        scheduleRender();
+        return;
+    }
+
+    insert(fileName, lastModified, image);
+}
+
+/**
+ * Renders the first queued thumbnail, leaving the others for the next
+ * iterations of the event loop.
+ */
+void MapThumbnailProvider::renderNext()
+{
+    mRenderScheduled = false;
+
+    if (mRenderQueue.isEmpty())
+        return;
+
+    const PendingThumbnail pending = mRenderQueue.takeFirst();
+
+    QImage image;
+    QScopedPointer<Map> map(readMap(pending.fileName));
+    if (map) {
+        ThumbnailRenderer renderer(map.data());
+        image = renderer.render(mSize);
+
+        if (!mCacheDirectory.isEmpty()) {
+            image.setText(QLatin1String(SourceKey), pending.fileName);
+            image.setText(QLatin1String(ModifiedKey), modifiedText(pending.lastModified));
+            mThreadPool.start(new SaveThumbnailTask(image, cacheFileName(pending.fileName)));
+        }
+    }
+
+    // Maps that can't be read keep a null thumbnail, so they are not read
+    // again until they change
+    insert(pending.fileName, pending.lastModified, image);
+
+    scheduleRender();
+}
+
+QString MapThumbnailProvider::cacheFileName(const QString &fileName) const
+{
+    const QByteArray hash = QCryptographicHash::hash(fileName.toUtf8(),
+                                                     QCryptographicHash::Sha1);
+    return mCacheDirectory + QLatin1Char('/') +
+            QString::fromLatin1(hash.toHex()) + QLatin1String(".png");
+}
+
+void MapThumbnailProvider::insert(const QString &fileName,
+                                  const QDateTime &lastModified,
+                                  const QImage &image)
+{
+    mPending.remove(fileName);
+
+    Thumbnail *thumbnail = new Thumbnail;
+    thumbnail->pixmap = QPixmap::fromImage(image);
+    thumbnail->lastModified = lastModified;
+
+    const int cost = qMax(1, image.byteCount() / 1024);
+    mThumbnails.insert(fileName, thumbnail, cost);
+
+    emit thumbnailReady(fileName);
+}
+
+void MapThumbnailProvider::scheduleRender()
+{
+    if (mRenderScheduled || mRenderQueue.isEmpty())
+        return;
+
+    mRenderScheduled = true;
+    QTimer::singleShot(0, this, SLOT(renderNext()));
+}
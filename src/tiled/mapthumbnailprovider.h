@@ -0,0 +1,99 @@
+/*
+ * mapthumbnailprovider.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPTHUMBNAILPROVIDER_H
+#define MAPTHUMBNAILPROVIDER_H
+
+#include <QCache>
+#include <QDateTime>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * Provides thumbnails of map files, without blocking while they are read.
+ *
+ * Thumbnails are stored in an on-disk cache, keyed by the path and the
+ * modification time of the map. Looking up and decoding the cached images
+ * happens on a thread pool. Maps without a cached thumbnail are read and
+ * rendered one at a time from the event loop, since reading a map creates
+ * the tileset pixmaps, which is only allowed on the main thread. The new
+ * thumbnails are written to the disk cache on the thread pool.
+ */
+class MapThumbnailProvider : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MapThumbnailProvider(const QSize &size, QObject *parent = nullptr);
+    ~MapThumbnailProvider();
+
+    QPixmap thumbnail(const QString &fileName, const QDateTime &lastModified);
+
+signals:
+    /**
+     * Emitted when the thumbnail of the given file became available.
+     */
+    void thumbnailReady(const QString &fileName);
+
+private slots:
+    void cachedThumbnailLoaded(const QString &fileName,
+                               const QDateTime &lastModified,
+                               const QImage &image);
+    void renderNext();
+
+private:
+    struct Thumbnail {
+        QPixmap pixmap;             // null when the map could not be read
+        QDateTime lastModified;
+    };
+
+    struct PendingThumbnail {
+        QString fileName;
+        QDateTime lastModified;
+    };
+
+    QString cacheFileName(const QString &fileName) const;
+    void insert(const QString &fileName,
+                const QDateTime &lastModified,
+                const QImage &image);
+    void scheduleRender();
+
+    const QSize mSize;
+    QString mCacheDirectory;
+    QCache<QString, Thumbnail> mThumbnails;
+    QSet<QString> mPending;
+    QVector<PendingThumbnail> mRenderQueue;
+    bool mRenderScheduled;
+    QThreadPool mThreadPool;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MAPTHUMBNAILPROVIDER_H
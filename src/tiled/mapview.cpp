@@ -22,15 +22,18 @@
 
 #include "mapscene.h"
 #include "preferences.h"
+#include "renderprofiler.h"
 #include "zoomable.h"
 
 #include <QApplication>
 #include <QCursor>
 #include <QGesture>
 #include <QGestureEvent>
+#include <QLabel>
 #include <QPinchGesture>
 #include <QWheelEvent>
 #include <QScrollBar>
+#include <QTimer>
 
 #ifndef QT_NO_OPENGL
 #include <QGLWidget>
@@ -43,6 +46,8 @@ MapView::MapView(QWidget *parent, Mode mode)
     , mHandScrolling(false)
     , mMode(mode)
     , mZoomable(new Zoomable(this))
+    , mProfilerOverlay(nullptr)
+    , mProfilerOverlayTimer(nullptr)
 {
     setTransformationAnchor(QGraphicsView::AnchorViewCenter);
 #ifdef Q_OS_MAC
@@ -75,6 +80,11 @@ MapView::MapView(QWidget *parent, Mode mode)
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
 
     connect(mZoomable, SIGNAL(scaleChanged(qreal)), SLOT(adjustScale(qreal)));
+
+    RenderProfiler *profiler = RenderProfiler::instance();
+    setProfilerOverlayVisible(profiler->isEnabled());
+    connect(profiler, SIGNAL(enabledChanged(bool)),
+            SLOT(setProfilerOverlayVisible(bool)));
 }
 
 MapView::~MapView()
@@ -156,6 +166,92 @@ bool MapView::event(QEvent *e)
     return QGraphicsView::event(e);
 }
 
+/**
+ * Reports each paint event to the RenderProfiler as a frame, while it is
+ * enabled.
+ */
+void MapView::paintEvent(QPaintEvent *event)
+{
+    RenderProfiler *profiler = RenderProfiler::instance();
+    if (!profiler->isEnabled()) {
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+
+    profiler->beginFrame(event->region());
+    QGraphicsView::paintEvent(event);
+    profiler->endFrame();
+}
+
+/**
+ * The overlay is a separate widget on top of the viewport, so that updating
+ * it does not cause the map to be repainted.
+ */
+void MapView::setProfilerOverlayVisible(bool visible)
+{
+    if (!visible) {
+        delete mProfilerOverlay;
+        delete mProfilerOverlayTimer;
+        mProfilerOverlay = nullptr;
+        mProfilerOverlayTimer = nullptr;
+        return;
+    }
+
+    if (mProfilerOverlay)
+        return;
+
+    mProfilerOverlay = new QLabel(this);
+    mProfilerOverlay->setAutoFillBackground(true);
+    mProfilerOverlay->setMargin(4);
+    mProfilerOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+
+    mProfilerOverlayTimer = new QTimer(this);
+    mProfilerOverlayTimer->setInterval(250);
+    connect(mProfilerOverlayTimer, SIGNAL(timeout()),
+            SLOT(updateProfilerOverlay()));
+    mProfilerOverlayTimer->start();
+
+    updateProfilerOverlay();
+    mProfilerOverlay->show();
+}
+
+void MapView::updateProfilerOverlay()
+{
+    const RenderProfiler *profiler = RenderProfiler::instance();
+
+    QString text;
+    if (profiler->frameCount() == 0) {
+        text = tr("No frames captured");
+    } else {
+        const RenderProfiler::Frame &frame = profiler->lastFrame();
+
+        text = tr("Frame time: %1 ms").arg(frame.nsecs / 1000000.0, 0, 'f', 2);
+        text += QLatin1Char('\n');
+        text += tr("Items painted: %1").arg(frame.itemsPainted);
+        text += QLatin1Char('\n');
+        text += tr("Cell renderer: %1 flushes, %2 fragments")
+                .arg(frame.cellRendererFlushes)
+                .arg(frame.cellRendererFragments);
+        text += QLatin1Char('\n');
+        text += tr("Repainted: %1 rects, %2 pixels")
+                .arg(frame.repaintedRects)
+                .arg(frame.repaintedArea);
+
+        for (const RenderProfiler::LayerTime &layerTime : frame.layerTimes) {
+            text += QLatin1Char('\n');
+            text += tr("%1: %2 ms (%3 items)")
+                    .arg(layerTime.name)
+                    .arg(layerTime.nsecs / 1000000.0, 0, 'f', 2)
+                    .arg(layerTime.paintCount);
+        }
+    }
+
+    mProfilerOverlay->setText(text);
+    mProfilerOverlay->adjustSize();
+    mProfilerOverlay->move(viewport()->geometry().topLeft() + QPoint(8, 8));
+    mProfilerOverlay->raise();
+}
+
 void MapView::hideEvent(QHideEvent *event)
 {
     // Disable hand scrolling when the view gets hidden in any way
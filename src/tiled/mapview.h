@@ -24,6 +24,9 @@
 #include <QGraphicsView>
 #include <QPinchGesture>
 
+class QLabel;
+class QTimer;
+
 namespace Tiled {
 namespace Internal {
 
@@ -68,6 +71,7 @@ public:
 protected:
     bool event(QEvent *event) override;
 
+    void paintEvent(QPaintEvent *event) override;
     void hideEvent(QHideEvent *) override;
 
     void wheelEvent(QWheelEvent *event) override;
@@ -84,12 +88,17 @@ private slots:
     void adjustScale(qreal scale);
     void setUseOpenGL(bool useOpenGL);
 
+    void setProfilerOverlayVisible(bool visible);
+    void updateProfilerOverlay();
+
 private:
     QPoint mLastMousePos;
     QPointF mLastMouseScenePos;
     bool mHandScrolling;
     Mode mMode;
     Zoomable *mZoomable;
+    QLabel *mProfilerOverlay;
+    QTimer *mProfilerOverlayTimer;
 };
 
 } // namespace Internal
@@ -0,0 +1,155 @@
+/*
+ * memoryreport.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memoryreport.h"
+
+#include "map.h"
+#include "objectgroup.h"
+#include "tileset.h"
+#include "undomemory.h"
+
+#include <QCoreApplication>
+#include <QUndoStack>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+static QString tr(const char *text)
+{
+    return QCoreApplication::translate("MemoryReport", text);
+}
+
+/**
+ * Returns the entry of \a layer, with its contents and properties as
+ * children.
+ */
+static MemoryUsageEntry layerMemoryUsage(const Layer *layer)
+{
+    MemoryUsageEntry entry(layer->name(), layer->memoryUsage());
+
+    // The base implementation covers the name and the properties
+    const qint64 contents = entry.bytes - layer->Layer::memoryUsage();
+
+    switch (layer->layerType()) {
+    case Layer::TileLayerType:
+        entry.children.append(MemoryUsageEntry(tr("Cells"), contents));
+        break;
+    case Layer::ObjectGroupType:
+        entry.children.append(MemoryUsageEntry(tr("Objects (%1)")
+                                               .arg(static_cast<const ObjectGroup*>(layer)->objectCount()),
+                                               contents));
+        break;
+    case Layer::ImageLayerType:
+        entry.children.append(MemoryUsageEntry(tr("Image"), contents));
+        break;
+    }
+
+    entry.children.append(MemoryUsageEntry(tr("Properties"),
+                                           layer->properties().memoryUsage()));
+    return entry;
+}
+
+/**
+ * Returns the memory used by \a map, with an entry for each of its layers
+ * and tilesets. Since tilesets can be shared between maps, they are listed
+ * separately and not counted in the total of the map.
+ */
+MemoryUsageEntry Tiled::Internal::mapMemoryUsage(const Map *map,
+                                                 const QString &name)
+{
+    MemoryUsageEntry entry(name, map->memoryUsage());
+
+    MemoryUsageEntry layers(tr("Layers"));
+    for (const Layer *layer : map->layers()) {
+        layers.children.append(layerMemoryUsage(layer));
+        layers.bytes += layers.children.last().bytes;
+    }
+
+    entry.children.append(layers);
+    entry.children.append(MemoryUsageEntry(tr("Properties"),
+                                           map->properties().memoryUsage()));
+
+    for (const SharedTileset &tileset : map->tilesets()) {
+        MemoryUsageEntry tilesetEntry(tr("Tileset %1").arg(tileset->name()),
+                                      tileset->memoryUsage());
+        tilesetEntry.children.append(MemoryUsageEntry(tr("Image"),
+                                                      tileset->imageMemory()));
+        entry.children.append(tilesetEntry);
+    }
+
+    return entry;
+}
+
+/**
+ * Returns the memory used by the commands on \a undoStack, with an entry for
+ * each command that reports its memory usage.
+ */
+MemoryUsageEntry Tiled::Internal::undoMemoryUsage(const QUndoStack *undoStack)
+{
+    MemoryUsageEntry entry(tr("Undo history (%1 commands)").arg(undoStack->count()),
+                           undoStackMemoryUsage(undoStack));
+
+    for (int i = 0; i < undoStack->count(); ++i) {
+        const QUndoCommand *command = undoStack->command(i);
+        auto memory = dynamic_cast<const UndoCommandMemory*>(command);
+        if (memory && memory->memoryUsage() > 0)
+            entry.children.append(MemoryUsageEntry(command->text(),
+                                                   memory->memoryUsage()));
+    }
+
+    return entry;
+}
+
+/**
+ * Returns \a bytes in a human readable form, like "12.3 MiB".
+ */
+QString Tiled::Internal::formatMemoryUsage(qint64 bytes)
+{
+    if (bytes < 1024)
+        return tr("%1 bytes").arg(bytes);
+    if (bytes < 1024 * 1024)
+        return tr("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+    if (bytes < 1024 * 1024 * 1024)
+        return tr("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    return tr("%1 GiB").arg(bytes / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+}
+
+static void appendReport(QString &report, const MemoryUsageEntry &entry,
+                         int depth)
+{
+    report += QString(depth * 2, QLatin1Char(' '));
+    report += entry.name;
+    report += QLatin1String(": ");
+    report += formatMemoryUsage(entry.bytes);
+    report += QLatin1Char('\n');
+
+    for (const MemoryUsageEntry &child : entry.children)
+        appendReport(report, child, depth + 1);
+}
+
+/**
+ * Returns \a entry and its children as indented text, one entry per line.
+ */
+QString Tiled::Internal::memoryUsageReport(const MemoryUsageEntry &entry)
+{
+    QString report;
+    appendReport(report, entry, 0);
+    return report;
+}
@@ -0,0 +1,62 @@
+/*
+ * memoryreport.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <QString>
+#include <QVector>
+
+class QUndoStack;
+
+namespace Tiled {
+
+class Map;
+
+namespace Internal {
+
+/**
+ * An entry in a report of the memory used by maps, tilesets and undo
+ * history. The children break the number of bytes of an entry down, except
+ * for the tilesets of a map, which are shared with other maps and therefore
+ * not counted in the total of the map.
+ */
+struct MemoryUsageEntry
+{
+    MemoryUsageEntry(const QString &name = QString(), qint64 bytes = 0)
+        : name(name)
+        , bytes(bytes)
+    {}
+
+    QString name;
+    qint64 bytes;
+    QVector<MemoryUsageEntry> children;
+};
+
+MemoryUsageEntry mapMemoryUsage(const Map *map, const QString &name);
+MemoryUsageEntry undoMemoryUsage(const QUndoStack *undoStack);
+
+QString formatMemoryUsage(qint64 bytes);
+QString memoryUsageReport(const MemoryUsageEntry &entry);
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MEMORYREPORT_H
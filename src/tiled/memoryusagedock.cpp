@@ -0,0 +1,154 @@
+/*
+ * memoryusagedock.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memoryusagedock.h"
+
+#include "documentmanager.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "memoryreport.h"
+#include "tilesetmanager.h"
+
+#include <QEvent>
+#include <QHeaderView>
+#include <QLabel>
+#include <QSet>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+MemoryUsageDock::MemoryUsageDock(QWidget *parent)
+    : QDockWidget(parent)
+    , mTreeWidget(new QTreeWidget)
+    , mTotalLabel(new QLabel)
+{
+    setObjectName(QLatin1String("MemoryUsageDock"));
+
+    QWidget *widget = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(widget);
+    layout->setMargin(5);
+
+    mTreeWidget->setColumnCount(2);
+    mTreeWidget->setUniformRowHeights(true);
+    mTreeWidget->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    mTreeWidget->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    mTreeWidget->header()->setStretchLastSection(false);
+
+    layout->addWidget(mTreeWidget);
+    layout->addWidget(mTotalLabel);
+
+    setWidget(widget);
+
+    mRefreshTimer.setInterval(2000);
+    connect(&mRefreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
+    retranslateUi();
+}
+
+void MemoryUsageDock::changeEvent(QEvent *e)
+{
+    QDockWidget::changeEvent(e);
+    switch (e->type()) {
+    case QEvent::LanguageChange:
+        retranslateUi();
+        break;
+    default:
+        break;
+    }
+}
+
+void MemoryUsageDock::showEvent(QShowEvent *e)
+{
+    QDockWidget::showEvent(e);
+    refresh();
+    mRefreshTimer.start();
+}
+
+void MemoryUsageDock::hideEvent(QHideEvent *e)
+{
+    QDockWidget::hideEvent(e);
+    mRefreshTimer.stop();
+}
+
+/**
+ * Rebuilds the tree from the current memory usage, keeping the expanded
+ * state of the top-level items.
+ */
+void MemoryUsageDock::refresh()
+{
+    QSet<QString> expanded;
+    for (int i = 0; i < mTreeWidget->topLevelItemCount(); ++i) {
+        const QTreeWidgetItem *item = mTreeWidget->topLevelItem(i);
+        if (item->isExpanded())
+            expanded.insert(item->text(0));
+    }
+
+    mTreeWidget->clear();
+
+    qint64 total = 0;
+
+    for (const MapDocument *mapDocument : DocumentManager::instance()->documents()) {
+        MemoryUsageEntry entry = mapMemoryUsage(mapDocument->map(),
+                                                mapDocument->displayName());
+
+        const MemoryUsageEntry undo = undoMemoryUsage(mapDocument->undoStack());
+        entry.children.append(undo);
+        entry.bytes += undo.bytes;
+
+        addEntry(nullptr, entry);
+        total += entry.bytes;
+    }
+
+    const qint64 tilesets = TilesetManager::instance()->memoryUsage();
+    addEntry(nullptr, MemoryUsageEntry(tr("All tilesets"), tilesets));
+    total += tilesets;
+
+    for (int i = 0; i < mTreeWidget->topLevelItemCount(); ++i) {
+        QTreeWidgetItem *item = mTreeWidget->topLevelItem(i);
+        item->setExpanded(expanded.contains(item->text(0)));
+    }
+
+    mTotalLabel->setText(tr("Total: %1").arg(formatMemoryUsage(total)));
+}
+
+void MemoryUsageDock::retranslateUi()
+{
+    setWindowTitle(tr("Memory Usage"));
+    mTreeWidget->setHeaderLabels(QStringList() << tr("Name") << tr("Size"));
+
+    if (isVisible())
+        refresh();
+}
+
+void MemoryUsageDock::addEntry(QTreeWidgetItem *parent,
+                               const MemoryUsageEntry &entry)
+{
+    QTreeWidgetItem *item = parent ? new QTreeWidgetItem(parent)
+                                   : new QTreeWidgetItem(mTreeWidget);
+
+    item->setText(0, entry.name);
+    item->setText(1, formatMemoryUsage(entry.bytes));
+    item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+
+    for (const MemoryUsageEntry &child : entry.children)
+        addEntry(item, child);
+}
@@ -0,0 +1,68 @@
+/*
+ * memoryusagedock.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMORYUSAGEDOCK_H
+#define MEMORYUSAGEDOCK_H
+
+#include <QDockWidget>
+#include <QTimer>
+
+class QLabel;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace Tiled {
+namespace Internal {
+
+struct MemoryUsageEntry;
+
+/**
+ * Shows how much memory is used by each open map, its layers and tilesets
+ * and its undo history. The numbers are refreshed periodically while the
+ * dock is visible.
+ */
+class MemoryUsageDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryUsageDock(QWidget *parent = nullptr);
+
+protected:
+    void changeEvent(QEvent *e) override;
+    void showEvent(QShowEvent *e) override;
+    void hideEvent(QHideEvent *e) override;
+
+private slots:
+    void refresh();
+
+private:
+    void retranslateUi();
+    void addEntry(QTreeWidgetItem *parent, const MemoryUsageEntry &entry);
+
+    QTreeWidget *mTreeWidget;
+    QLabel *mTotalLabel;
+    QTimer mRefreshTimer;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // MEMORYUSAGEDOCK_H
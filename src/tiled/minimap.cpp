@@ -21,6 +21,7 @@
 
 #include "minimap.h"
 
+#include "changenotifier.h"
 #include "documentmanager.h"
 #include "imagelayer.h"
 #include "map.h"
@@ -38,7 +39,8 @@
 #include <QPainter>
 #include <QResizeEvent>
 #include <QScrollBar>
-#include <QUndoStack>
+
+#include <algorithm>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -49,6 +51,7 @@ MiniMap::MiniMap(QWidget *parent)
     , mDragging(false)
     , mMouseMoveCursorState(false)
     , mRedrawMapImage(false)
+    , mFullUpdateScheduled(false)
     , mRenderFlags(DrawTiles | DrawObjects | DrawImages | IgnoreInvisibleLayer)
 {
     setFrameStyle(QFrame::StyledPanel | QFrame::Sunken);
@@ -68,6 +71,7 @@ void MiniMap::setMapDocument(MapDocument *map)
 
     if (mMapDocument) {
         mMapDocument->disconnect(this);
+        mMapDocument->changeNotifier()->disconnect(this);
 
         if (MapView *mapView = dm->viewForDocument(mMapDocument)) {
             mapView->zoomable()->disconnect(this);
@@ -79,8 +83,31 @@ void MiniMap::setMapDocument(MapDocument *map)
     mMapDocument = map;
 
     if (mMapDocument) {
-        connect(mMapDocument->undoStack(), SIGNAL(indexChanged(int)),
-                this, SLOT(scheduleMapImageUpdate()));
+        // The frequent changes while painting or dragging objects are
+        // received at most once per frame
+        ChangeNotifier *notifier = mMapDocument->changeNotifier();
+
+        // Changes to tile layer contents only update the affected area,
+        // any other change redraws the whole image
+        connect(notifier, &ChangeNotifier::regionChanged,
+                this, &MiniMap::regionChanged);
+        connect(notifier, SIGNAL(layerChanged(int)), SLOT(scheduleMapImageUpdate()));
+        connect(notifier, SIGNAL(objectsChanged(QList<MapObject*>)), SLOT(scheduleMapImageUpdate()));
+
+        connect(mMapDocument, SIGNAL(mapChanged()), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(mapPropertyChanged()), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(layerAdded(int)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(layerRemoved(int)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tileLayerDrawMarginsChanged(TileLayer*)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectGroupChanged(ObjectGroup*)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(imageLayerChanged(ImageLayer*)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tilesetAdded(int,Tileset*)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tilesetRemoved(Tileset*)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tilesetTileOffsetChanged(Tileset*)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(tilesetChanged(Tileset*)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectsInserted(ObjectGroup*,int,int)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectsRemoved(QList<MapObject*>)), SLOT(scheduleMapImageUpdate()));
+        connect(mMapDocument, SIGNAL(objectsIndexChanged(ObjectGroup*,int,int)), SLOT(scheduleMapImageUpdate()));
 
         if (MapView *mapView = dm->viewForDocument(mMapDocument)) {
             connect(mapView->horizontalScrollBar(), SIGNAL(valueChanged(int)), SLOT(update()));
@@ -99,9 +126,45 @@ QSize MiniMap::sizeHint() const
 
 void MiniMap::scheduleMapImageUpdate()
 {
+    mFullUpdateScheduled = true;
     mMapImageUpdateTimer.start(100);
 }
 
+/**
+ * Marks the part of the minimap image covering the changed \a region of the
+ * given \a layer for redrawing.
+ */
+void MiniMap::regionChanged(const QRegion &region, Layer *layer)
+{
+    if (mFullUpdateScheduled || mRedrawMapImage || mMapImage.isNull())
+        return;
+
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QMargins margins = mMapDocument->map()->drawMargins();
+
+    for (const QRect &r : region.rects()) {
+        QRectF boundingRect = renderer->boundingRect(r);
+
+        boundingRect.adjust(-margins.left(),
+                            -margins.top(),
+                            margins.right(),
+                            margins.bottom());
+
+        boundingRect.translate(layer->offset());
+
+        // Include a pixel around the area to account for smooth scaling
+        const QRect imageRect = mImageTransform.mapRect(boundingRect)
+                .toAlignedRect().adjusted(-1, -1, 1, 1);
+
+        mDirtyRegion |= imageRect & mMapImage.rect();
+    }
+
+    // Don't restart the timer, so that the image keeps getting updated
+    // while painting
+    if (!mMapImageUpdateTimer.isActive())
+        mMapImageUpdateTimer.start(100);
+}
+
 void MiniMap::paintEvent(QPaintEvent *pe)
 {
     QFrame::paintEvent(pe);
@@ -109,6 +172,10 @@ void MiniMap::paintEvent(QPaintEvent *pe)
     if (mRedrawMapImage) {
         renderMapToImage();
         mRedrawMapImage = false;
+        mDirtyRegion = QRegion();
+    } else if (!mDirtyRegion.isEmpty()) {
+        renderMapToImage(mDirtyRegion);
+        mDirtyRegion = QRegion();
     }
 
     if (mMapImage.isNull() || mImageRect.isEmpty())
@@ -168,7 +235,11 @@ static bool objectLessThan(const MapObject *a, const MapObject *b)
     return a->y() < b->y();
 }
 
-void MiniMap::renderMapToImage()
+/**
+ * Renders the map to the minimap image. When a \a region of the image is
+ * given, only that part is redrawn, unless the size of the image changed.
+ */
+void MiniMap::renderMapToImage(const QRegion &region)
 {
     if (!mMapDocument) {
         mMapImage = QImage();
@@ -193,15 +264,25 @@ void MiniMap::renderMapToImage()
                        (qreal) r.height() / mapSize.height());
 
     // Allocate a new image when the size changed
+    QRegion dirtyRegion = region;
     const QSize imageSize = mapSize * scale;
     if (mMapImage.size() != imageSize) {
         mMapImage = QImage(imageSize, QImage::Format_ARGB32_Premultiplied);
         updateImageRect();
+        dirtyRegion = QRegion();
     }
 
     if (imageSize.isEmpty())
         return;
 
+    mImageTransform = QTransform::fromScale(scale, scale);
+    mImageTransform.translate(margins.left(), margins.top());
+
+    // The exposed area in map coordinates, or null when redrawing everything
+    QRectF exposed;
+    if (!dirtyRegion.isEmpty())
+        exposed = mImageTransform.inverted().mapRect(QRectF(dirtyRegion.boundingRect()));
+
     bool drawObjects = mRenderFlags.testFlag(DrawObjects);
     bool drawTiles = mRenderFlags.testFlag(DrawTiles);
     bool drawImages = mRenderFlags.testFlag(DrawImages);
@@ -212,11 +293,19 @@ void MiniMap::renderMapToImage()
     const Tiled::RenderFlags renderFlags = renderer->flags();
     renderer->setFlag(ShowTileObjectOutlines, false);
 
-    mMapImage.fill(Qt::transparent);
     QPainter painter(&mMapImage);
+
+    if (exposed.isNull()) {
+        mMapImage.fill(Qt::transparent);
+    } else {
+        painter.setClipRegion(dirtyRegion);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(mMapImage.rect(), Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
+
     painter.setRenderHints(QPainter::SmoothPixmapTransform);
-    painter.setTransform(QTransform::fromScale(scale, scale));
-    painter.translate(margins.left(), margins.top());
+    painter.setTransform(mImageTransform);
     renderer->setPainterScale(scale);
 
     foreach (const Layer *layer, mMapDocument->map()->layers()) {
@@ -231,30 +320,25 @@ void MiniMap::renderMapToImage()
         const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
 
         if (tileLayer && drawTiles) {
-            renderer->drawTileLayer(&painter, tileLayer);
+            const QRectF layerExposed = exposed.isNull()
+                    ? exposed : exposed.translated(-layer->offset());
+            renderer->drawTileLayer(&painter, tileLayer, layerExposed);
         } else if (objGroup && drawObjects) {
             QList<MapObject*> objects = objGroup->objects();
 
             if (objGroup->drawOrder() == ObjectGroup::TopDownOrder)
                 qStableSort(objects.begin(), objects.end(), objectLessThan);
 
-            foreach (const MapObject *object, objects) {
-                if (object->isVisible()) {
-                    if (object->rotation() != qreal(0)) {
-                        QPointF origin = renderer->pixelToScreenCoords(object->position());
-                        painter.save();
-                        painter.translate(origin);
-                        painter.rotate(object->rotation());
-                        painter.translate(-origin);
-                    }
-
-                    const QColor color = MapObjectItem::objectColor(object);
-                    renderer->drawMapObject(&painter, object, color);
-
-                    if (object->rotation() != qreal(0))
-                        painter.restore();
-                }
-            }
+            objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                         [] (const MapObject *object) { return !object->isVisible(); }),
+                          objects.end());
+
+            QVector<QColor> colors;
+            colors.reserve(objects.size());
+            for (const MapObject *object : objects)
+                colors.append(MapObjectItem::objectColor(object));
+
+            renderer->drawMapObjects(&painter, objects, colors);
         } else if (imageLayer && drawImages) {
             renderer->drawImageLayer(&painter, imageLayer);
         }
@@ -264,8 +348,10 @@ void MiniMap::renderMapToImage()
 
     if (drawTileGrid) {
         Preferences *prefs = Preferences::instance();
-        renderer->drawGrid(&painter, QRectF(QPointF(), renderer->mapSize()),
-                           prefs->gridColor());
+        QRectF gridRect(QPointF(), renderer->mapSize());
+        if (!exposed.isNull())
+            gridRect &= exposed;
+        renderer->drawGrid(&painter, gridRect, prefs->gridColor());
     }
 
     renderer->setFlags(renderFlags);
@@ -285,7 +371,10 @@ void MiniMap::centerViewOnLocalPixel(QPoint centerPos, int delta)
 
 void MiniMap::redrawTimeout()
 {
-    mRedrawMapImage = true;
+    if (mFullUpdateScheduled) {
+        mRedrawMapImage = true;
+        mFullUpdateScheduled = false;
+    }
     update();
 }
 
@@ -24,9 +24,14 @@
 
 #include <QFrame>
 #include <QImage>
+#include <QRegion>
 #include <QTimer>
+#include <QTransform>
 
 namespace Tiled {
+
+class Layer;
+
 namespace Internal {
 
 class MapDocument;
@@ -68,6 +73,7 @@ protected:
 
 private slots:
     void redrawTimeout();
+    void regionChanged(const QRegion &region, Layer *layer);
 
 private:
     MapDocument *mMapDocument;
@@ -78,12 +84,15 @@ private:
     QPoint mDragOffset;
     bool mMouseMoveCursorState;
     bool mRedrawMapImage;
+    bool mFullUpdateScheduled;
+    QRegion mDirtyRegion;
+    QTransform mImageTransform;
     MiniMapRenderFlags mRenderFlags;
 
     QRect viewportRect() const;
     QPointF mapToScene(QPoint p) const;
     void updateImageRect();
-    void renderMapToImage();
+    void renderMapToImage(const QRegion &region = QRegion());
     void centerViewOnLocalPixel(QPoint centerPos, int delta = 0);
 };
 
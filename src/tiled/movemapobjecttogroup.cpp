@@ -23,7 +23,6 @@
 #include "mapdocument.h"
 #include "mapobject.h"
 #include "objectgroup.h"
-#include "mapobjectmodel.h"
 
 #include <QCoreApplication>
 
@@ -31,25 +30,33 @@ using namespace Tiled;
 using namespace Tiled::Internal;
 
 MoveMapObjectToGroup::MoveMapObjectToGroup(MapDocument *mapDocument,
-                                           MapObject *mapObject,
+                                           const QList<MapObject*> &mapObjects,
                                            ObjectGroup *objectGroup)
     : mMapDocument(mapDocument)
-    , mMapObject(mapObject)
-    , mOldObjectGroup(mapObject->objectGroup())
-    , mNewObjectGroup(objectGroup)
+    , mMapObjects(mapObjects)
+    , mObjectGroup(objectGroup)
 {
     setText(QCoreApplication::translate("Undo Commands",
-                                        "Move Object to Layer"));
+                                        "Move %n Object(s) to Layer",
+                                        nullptr, mapObjects.size()));
 }
 
 void MoveMapObjectToGroup::undo()
 {
-    mMapDocument->mapObjectModel()->removeObject(mNewObjectGroup, mMapObject);
-    mMapDocument->mapObjectModel()->insertObject(mOldObjectGroup, -1, mMapObject);
+    MapObjectModel *mapObjectModel = mMapDocument->mapObjectModel();
+    mapObjectModel->removeObjects(mMapObjects);
+    mapObjectModel->insertObjects(mOldEntries);
 }
 
 void MoveMapObjectToGroup::redo()
 {
-    mMapDocument->mapObjectModel()->removeObject(mOldObjectGroup, mMapObject);
-    mMapDocument->mapObjectModel()->insertObject(mNewObjectGroup, -1, mMapObject);
+    MapObjectModel *mapObjectModel = mMapDocument->mapObjectModel();
+    mOldEntries = mapObjectModel->removeObjects(mMapObjects);
+
+    QVector<MapObjectModel::ObjectEntry> newEntries;
+    newEntries.reserve(mMapObjects.size());
+    for (MapObject *mapObject : mMapObjects)
+        newEntries.append(MapObjectModel::ObjectEntry(mapObject, mObjectGroup));
+
+    mapObjectModel->insertObjects(newEntries);
 }
@@ -21,6 +21,8 @@
 #ifndef MOVEMAPOBJECTTOGROUP_H
 #define MOVEMAPOBJECTTOGROUP_H
 
+#include "mapobjectmodel.h"
+
 #include <QUndoCommand>
 
 namespace Tiled {
@@ -32,11 +34,15 @@ namespace Internal {
 
 class MapDocument;
 
+/**
+ * Undo command that moves a number of objects to another object group.
+ * Undoing it restores the objects at their original positions.
+ */
 class MoveMapObjectToGroup : public QUndoCommand
 {
 public:
     MoveMapObjectToGroup(MapDocument *mapDocument,
-                         MapObject *mapObject,
+                         const QList<MapObject*> &mapObjects,
                          ObjectGroup *objectGroup);
 
     void undo() override;
@@ -44,9 +50,9 @@ public:
 
 private:
     MapDocument *mMapDocument;
-    MapObject *mMapObject;
-    ObjectGroup *mOldObjectGroup;
-    ObjectGroup *mNewObjectGroup;
+    QList<MapObject*> mMapObjects;
+    ObjectGroup *mObjectGroup;
+    QVector<MapObjectModel::ObjectEntry> mOldEntries;
 };
 
 } // namespace Internal
@@ -21,6 +21,7 @@
 #include "newmapdialog.h"
 #include "ui_newmapdialog.h"
 
+#include "compression.h"
 #include "isometricrenderer.h"
 #include "hexagonalrenderer.h"
 #include "map.h"
@@ -36,6 +37,7 @@
 static const char * const ORIENTATION_KEY = "Map/Orientation";
 static const char * const MAP_WIDTH_KEY = "Map/Width";
 static const char * const MAP_HEIGHT_KEY = "Map/Height";
+static const char * const MAP_INFINITE_KEY = "Map/Infinite";
 static const char * const TILE_WIDTH_KEY = "Map/TileWidth";
 static const char * const TILE_HEIGHT_KEY = "Map/TileHeight";
 
@@ -78,12 +80,17 @@ NewMapDialog::NewMapDialog(QWidget *parent) :
     const auto orientation = static_cast<Map::Orientation>(s->value(QLatin1String(ORIENTATION_KEY)).toInt());
     const int mapWidth = s->value(QLatin1String(MAP_WIDTH_KEY), 100).toInt();
     const int mapHeight = s->value(QLatin1String(MAP_HEIGHT_KEY), 100).toInt();
+    const bool infinite = s->value(QLatin1String(MAP_INFINITE_KEY), false).toBool();
     const int tileWidth = s->value(QLatin1String(TILE_WIDTH_KEY), 32).toInt();
     const int tileHeight = s->value(QLatin1String(TILE_HEIGHT_KEY), 32).toInt();
 
     mUi->layerFormat->addItem(QCoreApplication::translate("PreferencesDialog", "CSV"), QVariant::fromValue(Map::CSV));
     mUi->layerFormat->addItem(QCoreApplication::translate("PreferencesDialog", "Base64 (uncompressed)"), QVariant::fromValue(Map::Base64));
     mUi->layerFormat->addItem(QCoreApplication::translate("PreferencesDialog", "Base64 (zlib compressed)"), QVariant::fromValue(Map::Base64Zlib));
+    if (compressionSupported(Zstandard))
+        mUi->layerFormat->addItem(QCoreApplication::translate("PreferencesDialog", "Base64 (Zstandard compressed)"), QVariant::fromValue(Map::Base64Zstandard));
+    if (compressionSupported(Lz4))
+        mUi->layerFormat->addItem(QCoreApplication::translate("PreferencesDialog", "Base64 (LZ4 compressed)"), QVariant::fromValue(Map::Base64Lz4));
 
     mUi->renderOrder->addItem(QCoreApplication::translate("PreferencesDialog", "Right Down"), QVariant::fromValue(Map::RightDown));
     mUi->renderOrder->addItem(QCoreApplication::translate("PreferencesDialog", "Right Up"), QVariant::fromValue(Map::RightUp));
@@ -105,6 +112,7 @@ NewMapDialog::NewMapDialog(QWidget *parent) :
 
     mUi->mapWidth->setValue(mapWidth);
     mUi->mapHeight->setValue(mapHeight);
+    mUi->infinite->setChecked(infinite);
     mUi->tileWidth->setValue(tileWidth);
     mUi->tileHeight->setValue(tileHeight);
 
@@ -134,6 +142,7 @@ MapDocument *NewMapDialog::createMap()
 
     const int mapWidth = mUi->mapWidth->value();
     const int mapHeight = mUi->mapHeight->value();
+    const bool infinite = mUi->infinite->isChecked();
     const int tileWidth = mUi->tileWidth->value();
     const int tileHeight = mUi->tileHeight->value();
 
@@ -145,11 +154,13 @@ MapDocument *NewMapDialog::createMap()
                        mapWidth, mapHeight,
                        tileWidth, tileHeight);
 
+    map->setInfinite(infinite);
     map->setLayerDataFormat(layerFormat);
     map->setRenderOrder(renderOrder);
 
     const size_t gigabyte = 1073741824;
-    const size_t memory = size_t(mapWidth) * size_t(mapHeight) * sizeof(Cell);
+    // Cells of tiles from tileset images are packed into 32 bits
+    const size_t memory = size_t(mapWidth) * size_t(mapHeight) * sizeof(quint32);
 
     // Add a tile layer to new maps of reasonable size
     if (memory < gigabyte) {
@@ -171,6 +182,7 @@ MapDocument *NewMapDialog::createMap()
     s->setValue(QLatin1String(ORIENTATION_KEY), orientation);
     s->setValue(QLatin1String(MAP_WIDTH_KEY), mapWidth);
     s->setValue(QLatin1String(MAP_HEIGHT_KEY), mapHeight);
+    s->setValue(QLatin1String(MAP_INFINITE_KEY), infinite);
     s->setValue(QLatin1String(TILE_WIDTH_KEY), tileWidth);
     s->setValue(QLatin1String(TILE_HEIGHT_KEY), tileHeight);
 
@@ -21,17 +21,38 @@
 #include "objectgroupitem.h"
 
 #include "map.h"
+#include "mapdocument.h"
+#include "mapobject.h"
 #include "mapobjectitem.h"
+#include "maprenderer.h"
+#include "mapview.h"
 #include "objectgroup.h"
+#include "renderprofiler.h"
+#include "tile.h"
+#include "zoomable.h"
+
+#include <QHash>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
-ObjectGroupItem::ObjectGroupItem(ObjectGroup *objectGroup):
-    mObjectGroup(objectGroup)
+ObjectGroupItem::ObjectGroupItem(ObjectGroup *objectGroup,
+                                 MapDocument *mapDocument):
+    mObjectGroup(objectGroup),
+    mMapDocument(mapDocument),
+    mDrawListDirty(true)
 {
-    // Since we don't do any painting, we can spare us the call to paint()
-    setFlag(QGraphicsItem::ItemHasNoContents);
+    if (mMapDocument) {
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+        syncWithObjectGroup();
+    } else {
+        // Since we don't do any painting, we can spare us the call to paint()
+        setFlag(QGraphicsItem::ItemHasNoContents);
+    }
 
     setOpacity(objectGroup->opacity());
     setPos(objectGroup->offset());
@@ -47,17 +68,299 @@ void ObjectGroupItem::setObjectGroup(ObjectGroup *objectGroup)
         return;
 
     mObjectGroup = objectGroup;
+    mDrawListDirty = true;
     setOpacity(mObjectGroup->opacity());
     setPos(mObjectGroup->offset());
+
+    if (mMapDocument)
+        syncWithObjectGroup();
+}
+
+/**
+ * Recalculates the bounding rect from all objects and repaints the item.
+ * Needs to be called when the way objects are rendered changed.
+ */
+void ObjectGroupItem::syncWithObjectGroup()
+{
+    if (!mMapDocument)
+        return;
+
+    QRectF boundingRect;
+    for (const MapObject *object : mObjectGroup->objects())
+        boundingRect |= objectBoundingRect(object);
+
+    if (mBoundingRect != boundingRect) {
+        prepareGeometryChange();
+        mBoundingRect = boundingRect;
+    }
+
+    invalidateDrawOrder();
+}
+
+/**
+ * Repaints the given \a objects, which were changed or added.
+ *
+ * Only the current area of the objects is known. When objects may have
+ * moved, their previous area needs to be repainted separately.
+ */
+void ObjectGroupItem::objectsChanged(const QList<MapObject*> &objects)
+{
+    if (!mMapDocument)
+        return;
+
+    const bool topDown = mObjectGroup->drawOrder() == ObjectGroup::TopDownOrder;
+
+    QRectF changedRect;
+    for (const MapObject *object : objects) {
+        changedRect |= objectBoundingRect(object);
+
+        if (topDown && !mDrawListDirty)
+            updateDrawPosition(object);
+    }
+
+    // Grow the bounding rect when necessary, it never shrinks until the
+    // item is synchronized with its object group again
+    if (!mBoundingRect.contains(changedRect)) {
+        prepareGeometryChange();
+        mBoundingRect |= changedRect;
+    }
+
+    update(changedRect);
+}
+
+/**
+ * Marks the draw order as changed and repaints the item. Needs to be called
+ * when objects were added to or removed from the object group, when their
+ * index changed or when the draw order of the object group changed.
+ */
+void ObjectGroupItem::invalidateDrawOrder()
+{
+    mDrawListDirty = true;
+    update();
+}
+
+/**
+ * Returns the visible objects of which the bounding rect may intersect
+ * the given \a rect in item coordinates, in no particular order.
+ */
+QList<MapObject*> ObjectGroupItem::objectsIntersecting(const QRectF &rect) const
+{
+    return mMapDocument->renderer()->objectsIntersecting(mObjectGroup, rect);
+}
+
+/**
+ * Sorts the given \a objects, which need to be part of this object group,
+ * in the order in which they are drawn.
+ */
+void ObjectGroupItem::sortByDrawOrder(QList<MapObject*> &objects) const
+{
+    if (objects.size() < 2)
+        return;
+
+    updateDrawList();
+
+    std::sort(objects.begin(), objects.end(),
+              [this] (const MapObject *a, const MapObject *b) {
+        return mDrawKeys.value(a) < mDrawKeys.value(b);
+    });
+}
+
+/**
+ * Returns the area in which the given \a object is drawn, in item
+ * coordinates.
+ */
+QRectF ObjectGroupItem::objectBoundingRect(const MapObject *object) const
+{
+    const QRectF bounds = mMapDocument->renderer()->boundingRect(object);
+    if (object->rotation() == 0)
+        return bounds;
+    return objectTransform(object).mapRect(bounds);
+}
+
+/**
+ * Returns the shape of the given \a object, in item coordinates.
+ */
+QPainterPath ObjectGroupItem::objectShape(const MapObject *object) const
+{
+    const QPainterPath shape = mMapDocument->renderer()->shape(object);
+    if (object->rotation() == 0)
+        return shape;
+    return objectTransform(object).map(shape);
+}
+
+/**
+ * Returns whether the given \a object covers \a pos, in item coordinates.
+ * The transparent parts of the tile of a tile object are not considered to
+ * be covered, so that the objects behind them can be picked.
+ */
+bool ObjectGroupItem::objectContains(const MapObject *object, const QPointF &pos) const
+{
+    if (!objectShape(object).contains(pos))
+        return false;
+
+    const Cell &cell = object->cell();
+    if (cell.isEmpty())
+        return true;
+
+    // Look up the position in the unrotated image of the tile, which fills
+    // the bounding rect apart from its margin
+    const QPointF imagePos = object->rotation() == 0
+            ? pos : objectTransform(object).inverted().map(pos);
+    const QRectF imageRect = mMapDocument->renderer()->boundingRect(object).adjusted(1, 1, -1, -1);
+    if (imageRect.isEmpty())
+        return true;
+
+    const Tile *tile = cell.tile->currentFrameTile();
+
+    qreal u = (imagePos.x() - imageRect.left()) / imageRect.width();
+    qreal v = (imagePos.y() - imageRect.top()) / imageRect.height();
+    if (cell.flippedHorizontally)
+        u = 1 - u;
+    if (cell.flippedVertically)
+        v = 1 - v;
+
+    return tile->isOpaqueAt(QPointF(u * tile->width(), v * tile->height()));
 }
 
 QRectF ObjectGroupItem::boundingRect() const
 {
-    return QRectF();
+    return mBoundingRect;
+}
+
+void ObjectGroupItem::paint(QPainter *painter,
+                            const QStyleOptionGraphicsItem *option,
+                            QWidget *widget)
+{
+    if (!mMapDocument)
+        return;
+
+    RenderProfiler::ItemTimer timer(mObjectGroup);
+
+    QList<MapObject*> objects = objectsIntersecting(option->exposedRect);
+
+    // When a large part of the objects is exposed, going over the draw list
+    // is cheaper than sorting the exposed objects
+    updateDrawList();
+    if (objects.size() * 4 > mDrawList.size()) {
+        objects.clear();
+        for (const DrawEntry &entry : mDrawList)
+            if (entry.object->isVisible())
+                objects.append(entry.object);
+    } else {
+        sortByDrawOrder(objects);
+    }
+
+    MapRenderer *renderer = mMapDocument->renderer();
+    const qreal scale = static_cast<MapView*>(widget->parent())->zoomable()->scale();
+    renderer->setPainterScale(scale);
+
+    QList<MapObject*> exposedObjects;
+    QVector<QColor> colors;
+    exposedObjects.reserve(objects.size());
+    colors.reserve(objects.size());
+
+    for (MapObject *object : objects) {
+        if (!objectBoundingRect(object).intersects(option->exposedRect))
+            continue;
+
+        exposedObjects.append(object);
+        colors.append(MapObjectItem::objectColor(object));
+    }
+
+    renderer->drawMapObjects(painter, exposedObjects, colors);
+}
+
+/**
+ * Returns the rotation of the given \a object around its position, in
+ * item coordinates.
+ */
+QTransform ObjectGroupItem::objectTransform(const MapObject *object) const
+{
+    const QPointF pos = mMapDocument->renderer()->pixelToScreenCoords(object->position());
+
+    QTransform transform;
+    transform.translate(pos.x(), pos.y());
+    transform.rotate(object->rotation());
+    transform.translate(-pos.x(), -pos.y());
+    return transform;
 }
 
-void ObjectGroupItem::paint(QPainter *,
-                            const QStyleOptionGraphicsItem *,
-                            QWidget *)
+/**
+ * Returns the value by which the given \a object is sorted when using the
+ * top-down draw order.
+ */
+qreal ObjectGroupItem::drawY(const MapObject *object) const
 {
+    if (mObjectGroup->drawOrder() != ObjectGroup::TopDownOrder)
+        return 0;
+    return mMapDocument->renderer()->pixelToScreenCoords(object->position()).y();
+}
+
+/**
+ * Rebuilds the draw list when it was invalidated.
+ */
+void ObjectGroupItem::updateDrawList() const
+{
+    if (!mDrawListDirty)
+        return;
+
+    const QList<MapObject*> &objects = mObjectGroup->objects();
+
+    mDrawList.resize(objects.size());
+    mDrawKeys.clear();
+    mDrawKeys.reserve(objects.size());
+
+    for (int i = 0; i < objects.size(); ++i) {
+        MapObject *object = objects.at(i);
+        const DrawKey key = { drawY(object), i };
+        mDrawList[i] = { key, object };
+        mDrawKeys.insert(object, key);
+    }
+
+    if (mObjectGroup->drawOrder() == ObjectGroup::TopDownOrder)
+        std::sort(mDrawList.begin(), mDrawList.end());
+
+    mDrawListDirty = false;
+}
+
+/**
+ * Moves the given \a object to its new place in the draw list, for when
+ * its position may have changed.
+ */
+void ObjectGroupItem::updateDrawPosition(const MapObject *object)
+{
+    const auto keyIt = mDrawKeys.find(object);
+    if (keyIt == mDrawKeys.end()) {
+        mDrawListDirty = true;
+        return;
+    }
+
+    const DrawKey oldKey = keyIt.value();
+    const DrawKey newKey = { drawY(object), oldKey.index };
+    if (newKey.y == oldKey.y)
+        return;
+
+    const DrawEntry oldEntry = { oldKey, nullptr };
+    const DrawEntry newEntry = { newKey, nullptr };
+
+    const auto begin = mDrawList.begin();
+    const auto end = mDrawList.end();
+    const auto from = std::lower_bound(begin, end, oldEntry);
+    if (from == end || from->object != object) {
+        mDrawListDirty = true;
+        return;
+    }
+
+    const auto to = std::lower_bound(begin, end, newEntry);
+
+    // Shift the entries in between, rather than sorting the whole list
+    if (to > from) {
+        std::rotate(from, from + 1, to);
+        (to - 1)->key = newKey;
+    } else {
+        std::rotate(to, from, from + 1);
+        to->key = newKey;
+    }
+
+    keyIt.value() = newKey;
 }
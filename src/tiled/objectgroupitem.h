@@ -22,27 +22,60 @@
 #define OBJECTGROUPITEM_H
 
 #include <QGraphicsItem>
+#include <QHash>
+#include <QList>
+#include <QVector>
 
 namespace Tiled {
 
+class MapObject;
 class ObjectGroup;
 
 namespace Internal {
 
+class MapDocument;
+
 /**
- * A graphics item representing an object group in a QGraphicsView. It only
- * serves to group together the objects belonging to the same object group.
+ * A graphics item representing an object group in a QGraphicsView.
+ *
+ * When given a map document, this item paints the objects of the group
+ * itself, looking up the objects in the exposed area through the spatial
+ * index of the object group. MapObjectItem instances only need to exist for
+ * objects that are being interacted with, and they don't paint anything
+ * themselves when they are part of such an object group item.
+ *
+ * The objects are kept in a list sorted by their draw order. For object
+ * groups using the top-down draw order, this list is updated incrementally
+ * as objects move, so that the order doesn't need to be determined again
+ * for each paint.
+ *
+ * Without a map document, it only serves to group together MapObjectItem
+ * instances, like the ones used while creating new objects.
  *
  * @see MapObjectItem
  */
 class ObjectGroupItem : public QGraphicsItem
 {
 public:
-    ObjectGroupItem(ObjectGroup *objectGroup);
+    ObjectGroupItem(ObjectGroup *objectGroup,
+                    MapDocument *mapDocument = nullptr);
 
     void setObjectGroup(ObjectGroup *objectGroup);
     ObjectGroup *objectGroup() const;
 
+    bool drawsObjects() const;
+
+    void syncWithObjectGroup();
+    void objectsChanged(const QList<MapObject*> &objects);
+    void invalidateDrawOrder();
+
+    QList<MapObject*> objectsIntersecting(const QRectF &rect) const;
+    void sortByDrawOrder(QList<MapObject*> &objects) const;
+
+    QRectF objectBoundingRect(const MapObject *object) const;
+    QPainterPath objectShape(const MapObject *object) const;
+    bool objectContains(const MapObject *object, const QPointF &pos) const;
+
     // QGraphicsItem
     QRectF boundingRect() const override;
     void paint(QPainter *painter,
@@ -50,7 +83,46 @@ public:
                QWidget *widget = nullptr) override;
 
 private:
+    /**
+     * The position of an object in the draw order. The y value is only used
+     * by the top-down draw order, where objects on the same height are
+     * drawn in the order of their index.
+     */
+    struct DrawKey
+    {
+        qreal y;
+        int index;
+
+        bool operator<(const DrawKey &other) const
+        {
+            if (y != other.y)
+                return y < other.y;
+            return index < other.index;
+        }
+    };
+
+    struct DrawEntry
+    {
+        DrawKey key;
+        MapObject *object;
+
+        bool operator<(const DrawEntry &other) const
+        { return key < other.key; }
+    };
+
+    QTransform objectTransform(const MapObject *object) const;
+
+    qreal drawY(const MapObject *object) const;
+    void updateDrawList() const;
+    void updateDrawPosition(const MapObject *object);
+
     ObjectGroup *mObjectGroup;
+    MapDocument *mMapDocument;
+    QRectF mBoundingRect;
+
+    mutable QVector<DrawEntry> mDrawList;
+    mutable QHash<const MapObject*, DrawKey> mDrawKeys;
+    mutable bool mDrawListDirty;
 };
 
 inline ObjectGroup *ObjectGroupItem::objectGroup() const
@@ -58,6 +130,14 @@ inline ObjectGroup *ObjectGroupItem::objectGroup() const
     return mObjectGroup;
 }
 
+/**
+ * Returns whether this item paints the objects of its object group.
+ */
+inline bool ObjectGroupItem::drawsObjects() const
+{
+    return mMapDocument != nullptr;
+}
+
 } // namespace Internal
 } // namespace Tiled
 
@@ -20,6 +20,7 @@
 
 #include "objectsdock.h"
 
+#include "changenotifier.h"
 #include "documentmanager.h"
 #include "map.h"
 #include "mapobject.h"
@@ -27,6 +28,7 @@
 #include "mapdocumentactionhandler.h"
 #include "mapobjectmodel.h"
 #include "objectgroup.h"
+#include "objectsfiltermodel.h"
 #include "preferences.h"
 #include "utils.h"
 
@@ -35,12 +37,16 @@
 #include <QContextMenuEvent>
 #include <QHeaderView>
 #include <QLabel>
+#include <QLineEdit>
 #include <QMenu>
+#include <QSet>
 #include <QSettings>
 #include <QToolBar>
 #include <QToolButton>
 #include <QUrl>
 
+#include <algorithm>
+
 static const char FIRST_SECTION_SIZE_KEY[] = "ObjectsDock/FirstSectionSize";
 
 using namespace Tiled;
@@ -48,6 +54,7 @@ using namespace Tiled::Internal;
 
 ObjectsDock::ObjectsDock(QWidget *parent)
     : QDockWidget(parent)
+    , mFilterEdit(new QLineEdit)
     , mObjectsView(new ObjectsView)
     , mMapDocument(nullptr)
 {
@@ -66,8 +73,16 @@ ObjectsDock::ObjectsDock(QWidget *parent)
     QVBoxLayout *layout = new QVBoxLayout(widget);
     layout->setMargin(5);
     layout->setSpacing(0);
+    layout->addWidget(mFilterEdit);
     layout->addWidget(mObjectsView);
 
+#if QT_VERSION >= 0x050200
+    mFilterEdit->setClearButtonEnabled(true);
+#endif
+
+    connect(mFilterEdit, &QLineEdit::textChanged,
+            mObjectsView, &ObjectsView::setFilter);
+
     mActionNewLayer = new QAction(this);
     mActionNewLayer->setIcon(QIcon(QLatin1String(":/images/16x16/document-new.png")));
     connect(mActionNewLayer, SIGNAL(triggered()),
@@ -110,6 +125,7 @@ void ObjectsDock::setMapDocument(MapDocument *mapDoc)
     if (mMapDocument) {
         saveExpandedGroups(mMapDocument);
         mMapDocument->disconnect(this);
+        mMapDocument->changeNotifier()->disconnect(this);
     }
 
     mMapDocument = mapDoc;
@@ -118,7 +134,7 @@ void ObjectsDock::setMapDocument(MapDocument *mapDoc)
 
     if (mMapDocument) {
         restoreExpandedGroups(mMapDocument);
-        connect(mMapDocument, SIGNAL(selectedObjectsChanged()),
+        connect(mMapDocument->changeNotifier(), SIGNAL(selectedObjectsChanged()),
                 this, SLOT(updateActions()));
     }
 
@@ -141,6 +157,7 @@ void ObjectsDock::retranslateUi()
 {
     setWindowTitle(tr("Objects"));
 
+    mFilterEdit->setPlaceholderText(tr("Filter"));
     mActionNewLayer->setToolTip(tr("Add Object Layer"));
     mActionObjectProperties->setToolTip(tr("Object Properties"));
 
@@ -189,7 +206,7 @@ void ObjectsDock::saveExpandedGroups(MapDocument *mapDoc)
 {
     mExpandedGroups[mapDoc].clear();
     foreach (ObjectGroup *og, mapDoc->map()->objectGroups()) {
-        if (mObjectsView->isExpanded(mObjectsView->model()->index(og)))
+        if (mObjectsView->isExpanded(mObjectsView->viewIndex(og)))
             mExpandedGroups[mapDoc].append(og);
     }
 }
@@ -197,16 +214,8 @@ void ObjectsDock::saveExpandedGroups(MapDocument *mapDoc)
 void ObjectsDock::restoreExpandedGroups(MapDocument *mapDoc)
 {
     foreach (ObjectGroup *og, mExpandedGroups[mapDoc])
-        mObjectsView->setExpanded(mObjectsView->model()->index(og), true);
+        mObjectsView->setExpanded(mObjectsView->viewIndex(og), true);
     mExpandedGroups[mapDoc].clear();
-
-    // Also restore the selection
-    foreach (MapObject *o, mapDoc->selectedObjects()) {
-        QModelIndex index = mObjectsView->model()->index(o);
-        mObjectsView->selectionModel()->select(index,
-                                               QItemSelectionModel::Select |
-                                               QItemSelectionModel::Rows);
-    }
 }
 
 void ObjectsDock::documentAboutToClose(MapDocument *mapDocument)
@@ -219,9 +228,11 @@ void ObjectsDock::documentAboutToClose(MapDocument *mapDocument)
 ObjectsView::ObjectsView(QWidget *parent)
     : QTreeView(parent)
     , mMapDocument(nullptr)
+    , mProxyModel(new ObjectsFilterModel(this))
     , mSynching(false)
 {
     setUniformRowHeights(true);
+    setModel(mProxyModel);
 
     setSelectionBehavior(QAbstractItemView::SelectRows);
     setSelectionMode(QAbstractItemView::ExtendedSelection);
@@ -243,42 +254,79 @@ void ObjectsView::setMapDocument(MapDocument *mapDoc)
     if (mapDoc == mMapDocument)
         return;
 
-    if (mMapDocument)
+    if (mMapDocument) {
         mMapDocument->disconnect(this);
+        mMapDocument->changeNotifier()->disconnect(this);
+    }
 
     mMapDocument = mapDoc;
 
-    if (mMapDocument) {
-        setModel(mMapDocument->mapObjectModel());
+    mProxyModel->setMapObjectModel(mMapDocument ? mMapDocument->mapObjectModel()
+                                                : nullptr);
 
+    if (mMapDocument) {
         const QSettings *settings = Preferences::instance()->settings();
         const int firstSectionSize =
                 settings->value(QLatin1String(FIRST_SECTION_SIZE_KEY), 200).toInt();
         header()->resizeSection(0, firstSectionSize);
 
-        connect(mMapDocument, SIGNAL(selectedObjectsChanged()),
+        // Selecting many objects is slow, so this is done at most once per
+        // frame while the selection is changing
+        connect(mMapDocument->changeNotifier(), SIGNAL(selectedObjectsChanged()),
                 this, SLOT(selectedObjectsChanged()));
-    } else {
-        setModel(nullptr);
+
+        selectedObjectsChanged();
     }
 }
 
-MapObjectModel *ObjectsView::model() const
+MapObjectModel *ObjectsView::mapObjectModel() const
+{
+    return mProxyModel->mapObjectModel();
+}
+
+/**
+ * Returns the index of the given object group in this view.
+ */
+QModelIndex ObjectsView::viewIndex(ObjectGroup *og) const
+{
+    return mProxyModel->mapFromSource(mapObjectModel()->index(og));
+}
+
+/**
+ * Returns the index of the given object in this view, which is invalid when
+ * the object is filtered out or its row has not been fetched.
+ */
+QModelIndex ObjectsView::viewIndex(MapObject *o) const
+{
+    return mProxyModel->mapFromSource(mapObjectModel()->index(o));
+}
+
+/**
+ * Only shows the objects whose name or type contains the given text.
+ */
+void ObjectsView::setFilter(const QString &filter)
 {
-    return static_cast<MapObjectModel*>(QTreeView::model());
+    mProxyModel->setFilter(filter);
+
+    // The selection of rows that were filtered out has been lost
+    selectedObjectsChanged();
 }
 
 void ObjectsView::onPressed(const QModelIndex &index)
 {
-    if (MapObject *mapObject = model()->toMapObject(index))
+    const QModelIndex sourceIndex = mProxyModel->mapToSource(index);
+
+    if (MapObject *mapObject = mapObjectModel()->toMapObject(sourceIndex))
         mMapDocument->setCurrentObject(mapObject);
-    else if (ObjectGroup *objectGroup = model()->toObjectGroup(index))
+    else if (ObjectGroup *objectGroup = mapObjectModel()->toObjectGroup(sourceIndex))
         mMapDocument->setCurrentObject(objectGroup);
 }
 
 void ObjectsView::onActivated(const QModelIndex &index)
 {
-    if (MapObject *mapObject = model()->toMapObject(index)) {
+    const QModelIndex sourceIndex = mProxyModel->mapToSource(index);
+
+    if (MapObject *mapObject = mapObjectModel()->toMapObject(sourceIndex)) {
         mMapDocument->setCurrentObject(mapObject);
         mMapDocument->emitEditCurrentObject();
     }
@@ -307,14 +355,15 @@ void ObjectsView::selectionChanged(const QItemSelection &selected,
 
     QList<MapObject*> selectedObjects;
     foreach (const QModelIndex &index, selectedRows) {
-        if (ObjectGroup *og = model()->toLayer(index)) {
+        const QModelIndex sourceIndex = mProxyModel->mapToSource(index);
+        if (ObjectGroup *og = mapObjectModel()->toLayer(sourceIndex)) {
             int index = mMapDocument->map()->layers().indexOf(og);
             if (currentLayerIndex == -1)
                 currentLayerIndex = index;
             else if (currentLayerIndex != index)
                 currentLayerIndex = -2;
         }
-        if (MapObject *o = model()->toMapObject(index))
+        if (MapObject *o = mapObjectModel()->toMapObject(sourceIndex))
             selectedObjects.append(o);
     }
 
@@ -344,17 +393,53 @@ void ObjectsView::selectedObjectsChanged()
         return;
 
     const QList<MapObject *> &selectedObjects = mMapDocument->selectedObjects();
+    MapObjectModel *mapObjectModel = this->mapObjectModel();
+
+    // Nothing to do when the selection was made in this view
+    QSet<MapObject*> viewSelection;
+    for (const QModelIndex &index : selectionModel()->selectedRows())
+        if (MapObject *o = mapObjectModel->toMapObject(mProxyModel->mapToSource(index)))
+            viewSelection.insert(o);
+    if (viewSelection == selectedObjects.toSet())
+        return;
 
-    mSynching = true;
-    clearSelection();
-    foreach (MapObject *o, selectedObjects) {
-        QModelIndex index = model()->index(o);
-        selectionModel()->select(index, QItemSelectionModel::Select |  QItemSelectionModel::Rows);
+    // The selected objects need to have a row in order to be selected
+    mapObjectModel->fetchObjects(selectedObjects);
+
+    QHash<ObjectGroup*, QVector<int>> rowsPerGroup;
+    for (MapObject *o : selectedObjects) {
+        const QModelIndex index = viewIndex(o);
+        if (index.isValid())
+            rowsPerGroup[o->objectGroup()].append(index.row());
     }
+
+    // Select each range of consecutive rows at once, rather than each object
+    QItemSelection selection;
+    const int lastColumn = mProxyModel->columnCount() - 1;
+
+    for (auto it = rowsPerGroup.begin(); it != rowsPerGroup.end(); ++it) {
+        const QModelIndex parent = viewIndex(it.key());
+        QVector<int> &rows = it.value();
+        std::sort(rows.begin(), rows.end());
+
+        int first = 0;
+        while (first < rows.size()) {
+            int last = first;
+            while (last + 1 < rows.size() && rows.at(last + 1) <= rows.at(last) + 1)
+                ++last;
+
+            selection.append(QItemSelectionRange(mProxyModel->index(rows.at(first), 0, parent),
+                                                 mProxyModel->index(rows.at(last), lastColumn, parent)));
+            first = last + 1;
+        }
+    }
+
+    mSynching = true;
+    selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect);
     mSynching = false;
 
     if (selectedObjects.count() == 1) {
         MapObject *o = selectedObjects.first();
-        scrollTo(model()->index(o));
+        scrollTo(viewIndex(o));
     }
 }
@@ -24,16 +24,19 @@
 #include <QDockWidget>
 #include <QTreeView>
 
+class QLineEdit;
 class QTreeView;
 
 namespace Tiled {
 
+class MapObject;
 class ObjectGroup;
 
 namespace Internal {
 
 class MapDocument;
 class MapObjectModel;
+class ObjectsFilterModel;
 class ObjectsView;
 
 class ObjectsDock : public QDockWidget
@@ -65,6 +68,7 @@ private:
     QAction *mActionObjectProperties;
     QAction *mActionMoveToGroup;
 
+    QLineEdit *mFilterEdit;
     ObjectsView *mObjectsView;
     MapDocument *mMapDocument;
     QMap<MapDocument*, QList<ObjectGroup*> > mExpandedGroups;
@@ -82,7 +86,12 @@ public:
 
     void setMapDocument(MapDocument *mapDoc);
 
-    MapObjectModel *model() const;
+    MapObjectModel *mapObjectModel() const;
+
+    QModelIndex viewIndex(ObjectGroup *og) const;
+    QModelIndex viewIndex(MapObject *o) const;
+
+    void setFilter(const QString &filter);
 
 protected:
     void selectionChanged(const QItemSelection &selected,
@@ -96,6 +105,7 @@ private slots:
 
 private:
     MapDocument *mMapDocument;
+    ObjectsFilterModel *mProxyModel;
     bool mSynching;
 };
 
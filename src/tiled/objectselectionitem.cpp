@@ -29,7 +29,9 @@
 #include "preferences.h"
 #include "tile.h"
 
+#include <QGraphicsView>
 #include <QGuiApplication>
+#include <QStaticText>
 
 namespace Tiled {
 namespace Internal {
@@ -37,6 +39,9 @@ namespace Internal {
 static const qreal labelMargin = 3;
 static const qreal labelDistance = 12;
 
+// Below this zoom level, the labels would mostly cover each other
+static const qreal labelMinimumScale = 0.25;
+
 // TODO: Unduplicate the following helper functions between this and
 // ObjectSelectionTool
 
@@ -72,7 +77,7 @@ static QRectF objectBounds(const MapObject *object,
     if (!object->cell().isEmpty()) {
         // Tile objects can have a tile offset, which is scaled along with the image
         const Tile *tile = object->cell().tile;
-        const QSize imgSize = tile->image().size();
+        const QSize imgSize = tile->size();
         const QPointF position = renderer->pixelToScreenCoords(object->position());
 
         const QPoint tileOffset = tile->tileset()->tileOffset();
@@ -190,6 +195,9 @@ public:
     {
         setFlags(QGraphicsItem::ItemIgnoresTransformations |
                  QGraphicsItem::ItemIgnoresParentOpacity);
+
+        mText.setTextFormat(Qt::PlainText);
+        mText.setPerformanceHint(QStaticText::AggressiveCaching);
     }
 
     void syncWithMapObject(MapRenderer *renderer);
@@ -202,6 +210,10 @@ public:
 private:
     QRectF mBoundingRect;
     MapObject *mObject;
+
+    // The name is only laid out again when it changes
+    QStaticText mText;
+    QPointF mTextPos;
 };
 
 void MapObjectLabel::syncWithMapObject(MapRenderer *renderer)
@@ -212,11 +224,21 @@ void MapObjectLabel::syncWithMapObject(MapRenderer *renderer)
     if (!nameVisible)
         return;
 
-    const QFontMetricsF metrics(QGuiApplication::font());
+    const QFont font = QGuiApplication::font();
+    if (mText.text() != mObject->name()) {
+        mText.setText(mObject->name());
+        mText.prepare(QTransform(), font);
+    }
+
+    const QFontMetricsF metrics(font);
     QRectF boundingRect = metrics.boundingRect(mObject->name());
     boundingRect.translate(-boundingRect.width() / 2, -labelDistance);
     boundingRect.adjust(-labelMargin*2, -labelMargin, labelMargin*2, labelMargin);
 
+    // Static text is positioned by its top-left instead of its baseline
+    mTextPos = QPointF(-(boundingRect.width() - labelMargin*4) / 2,
+                       -labelDistance - metrics.ascent());
+
     QPointF pixelPos = renderer->pixelToScreenCoords(mObject->position());
     QRectF bounds = objectBounds(mObject, renderer);
 
@@ -245,8 +267,15 @@ QRectF MapObjectLabel::boundingRect() const
 
 void MapObjectLabel::paint(QPainter *painter,
                            const QStyleOptionGraphicsItem *,
-                           QWidget *)
+                           QWidget *widget)
 {
+    // The label itself ignores the zoom level of the view
+    if (widget) {
+        if (auto view = qobject_cast<QGraphicsView*>(widget->parentWidget()))
+            if (view->transform().m11() < labelMinimumScale)
+                return;
+    }
+
     QColor color = MapObjectItem::objectColor(mObject);
 
     painter->setRenderHint(QPainter::Antialiasing);
@@ -256,13 +285,11 @@ void MapObjectLabel::paint(QPainter *painter,
     painter->setBrush(color);
     painter->drawRoundedRect(mBoundingRect, 4, 4);
 
-    QPointF textPos(-(mBoundingRect.width() - labelMargin*4) / 2, -labelDistance);
-
-    painter->drawRoundedRect(mBoundingRect, 4, 4);
+    painter->setFont(QGuiApplication::font());
     painter->setPen(Qt::black);
-    painter->drawText(textPos + QPointF(1,1), mObject->name());
+    painter->drawStaticText(mTextPos + QPointF(1,1), mText);
     painter->setPen(Qt::white);
-    painter->drawText(textPos, mObject->name());
+    painter->drawStaticText(mTextPos, mText);
 }
 
 
@@ -20,7 +20,6 @@
 
 #include "objectselectiontool.h"
 
-#include "changepolygon.h"
 #include "layer.h"
 #include "map.h"
 #include "mapdocument.h"
@@ -29,16 +28,14 @@
 #include "mapobjectmodel.h"
 #include "maprenderer.h"
 #include "mapscene.h"
-#include "movemapobject.h"
 #include "objectgroup.h"
 #include "preferences.h"
 #include "raiselowerhelper.h"
-#include "resizemapobject.h"
-#include "rotatemapobject.h"
 #include "selectionrectangle.h"
 #include "snaphelper.h"
 #include "tile.h"
 #include "tileset.h"
+#include "transformmapobjects.h"
 
 #include <QApplication>
 #include <QGraphicsItem>
@@ -425,17 +422,23 @@ void ObjectSelectionTool::keyPressed(QKeyEvent *event)
             moveBy /= Preferences::instance()->gridFine();
     }
 
-    QUndoStack *undoStack = mapDocument()->undoStack();
-    undoStack->beginMacro(tr("Move %n Object(s)", "", items.size()));
-    int i = 0;
-    foreach (MapObjectItem *objectItem, items) {
+    QList<MapObject*> objects;
+    QVector<QPointF> oldPositions;
+    objects.reserve(items.size());
+    oldPositions.reserve(items.size());
+
+    for (MapObjectItem *objectItem : items) {
         MapObject *object = objectItem->mapObject();
-        const QPointF oldPos = object->position();
-        const QPointF newPos = oldPos + moveBy;
-        undoStack->push(new MoveMapObject(mapDocument(), object, newPos, oldPos));
-        ++i;
+        objects.append(object);
+        oldPositions.append(object->position());
+        object->setPosition(object->position() + moveBy);
     }
-    undoStack->endMacro();
+
+    auto command = new TransformMapObjects(mapDocument(), objects, oldPositions,
+                                           QVector<QSizeF>(), QVector<qreal>(),
+                                           QVector<QPolygonF>());
+    command->setText(tr("Move %n Object(s)", "", items.size()));
+    mapDocument()->undoStack()->push(command);
 }
 
 void ObjectSelectionTool::mouseEntered()
@@ -688,7 +691,7 @@ static QRectF objectBounds(const MapObject *object,
     if (!object->cell().isEmpty()) {
         // Tile objects can have a tile offset, which is scaled along with the image
         const Tile *tile = object->cell().tile;
-        const QSize imgSize = tile->image().size();
+        const QSize imgSize = tile->size();
         const QPointF position = renderer->pixelToScreenCoords(object->position());
 
         const QPoint tileOffset = tile->tileset()->tileOffset();
@@ -903,11 +906,11 @@ void ObjectSelectionTool::updateSelection(const QPointF &pos,
 
     QSet<MapObjectItem*> selectedItems;
 
-    foreach (QGraphicsItem *item, mapScene()->items(rect)) {
-        MapObjectItem *mapObjectItem = dynamic_cast<MapObjectItem*>(item);
-        if (mapObjectItem)
-            selectedItems.insert(mapObjectItem);
-    }
+    QPainterPath path;
+    path.addRect(rect);
+
+    for (MapObjectItem *mapObjectItem : mapScene()->objectItemsIntersecting(path))
+        selectedItems.insert(mapObjectItem);
 
     if (modifiers & (Qt::ControlModifier | Qt::ShiftModifier))
         selectedItems |= mapScene()->selectedObjectItems();
@@ -950,16 +953,18 @@ void ObjectSelectionTool::startMoving(Qt::KeyboardModifiers modifiers)
 void ObjectSelectionTool::updateMovingItems(const QPointF &pos,
                                             Qt::KeyboardModifiers modifiers)
 {
-    const MapRenderer *renderer = mapDocument()->renderer();
-    const QPointF diff = snapToGrid(pos - mStart, modifiers);
+    const SnapHelper snapHelper(mapDocument()->renderer(), modifiers);
 
-    foreach (const MovingObject &object, mMovingObjects) {
-        const QPointF newPixelPos = object.oldItemPosition + diff;
-        const QPointF newPos = renderer->screenToPixelCoords(newPixelPos);
+    QVector<QPointF> oldPositions;
+    oldPositions.reserve(mMovingObjects.size());
+    for (const MovingObject &object : mMovingObjects)
+        oldPositions.append(object.oldPosition);
 
-        MapObject *mapObject = object.item->mapObject();
-        mapObject->setPosition(newPos);
-    }
+    const QVector<QPointF> newPositions =
+            snapHelper.movePositions(oldPositions, mAlignPosition, pos - mStart);
+
+    for (int i = 0; i < mMovingObjects.size(); ++i)
+        mMovingObjects.at(i).item->mapObject()->setPosition(newPositions.at(i));
 
     mapDocument()->mapObjectModel()->emitObjectsChanged(changingObjects());
 }
@@ -973,14 +978,21 @@ void ObjectSelectionTool::finishMoving(const QPointF &pos)
     if (mStart == pos) // Move is a no-op
         return;
 
-    QUndoStack *undoStack = mapDocument()->undoStack();
-    undoStack->beginMacro(tr("Move %n Object(s)", "", mMovingObjects.size()));
-    foreach (const MovingObject &object, mMovingObjects) {
-        undoStack->push(new MoveMapObject(mapDocument(),
-                                          object.item->mapObject(),
-                                          object.oldPosition));
+    QList<MapObject*> objects;
+    QVector<QPointF> oldPositions;
+    objects.reserve(mMovingObjects.size());
+    oldPositions.reserve(mMovingObjects.size());
+
+    for (const MovingObject &object : mMovingObjects) {
+        objects.append(object.item->mapObject());
+        oldPositions.append(object.oldPosition);
     }
-    undoStack->endMacro();
+
+    auto command = new TransformMapObjects(mapDocument(), objects, oldPositions,
+                                           QVector<QSizeF>(), QVector<qreal>(),
+                                           QVector<QPolygonF>());
+    command->setText(tr("Move %n Object(s)", "", mMovingObjects.size()));
+    mapDocument()->undoStack()->push(command);
 
     mMovingObjects.clear();
 }
@@ -1040,14 +1052,24 @@ void ObjectSelectionTool::finishRotating(const QPointF &pos)
     if (mStart == pos) // No rotation at all
         return;
 
-    QUndoStack *undoStack = mapDocument()->undoStack();
-    undoStack->beginMacro(tr("Rotate %n Object(s)", "", mMovingObjects.size()));
-    foreach (const MovingObject &object, mMovingObjects) {
-        MapObject *mapObject = object.item->mapObject();
-        undoStack->push(new MoveMapObject(mapDocument(), mapObject, object.oldPosition));
-        undoStack->push(new RotateMapObject(mapDocument(), mapObject, object.oldRotation));
+    QList<MapObject*> objects;
+    QVector<QPointF> oldPositions;
+    QVector<qreal> oldRotations;
+    objects.reserve(mMovingObjects.size());
+    oldPositions.reserve(mMovingObjects.size());
+    oldRotations.reserve(mMovingObjects.size());
+
+    for (const MovingObject &object : mMovingObjects) {
+        objects.append(object.item->mapObject());
+        oldPositions.append(object.oldPosition);
+        oldRotations.append(object.oldRotation);
     }
-    undoStack->endMacro();
+
+    auto command = new TransformMapObjects(mapDocument(), objects, oldPositions,
+                                           QVector<QSizeF>(), oldRotations,
+                                           QVector<QPolygonF>());
+    command->setText(tr("Rotate %n Object(s)", "", mMovingObjects.size()));
+    mapDocument()->undoStack()->push(command);
 
     mMovingObjects.clear();
 }
@@ -1306,17 +1328,27 @@ void ObjectSelectionTool::finishResizing(const QPointF &pos)
     if (mStart == pos) // No scaling at all
         return;
 
-    QUndoStack *undoStack = mapDocument()->undoStack();
-    undoStack->beginMacro(tr("Resize %n Object(s)", "", mMovingObjects.size()));
-    foreach (const MovingObject &object, mMovingObjects) {
-        MapObject *mapObject = object.item->mapObject();
-        undoStack->push(new MoveMapObject(mapDocument(), mapObject, object.oldPosition));
-        undoStack->push(new ResizeMapObject(mapDocument(), mapObject, object.oldSize));
-        
-        if (!object.oldPolygon.isEmpty())
-            undoStack->push(new ChangePolygon(mapDocument(), mapObject, object.oldPolygon));
+    QList<MapObject*> objects;
+    QVector<QPointF> oldPositions;
+    QVector<QSizeF> oldSizes;
+    QVector<QPolygonF> oldPolygons;
+    objects.reserve(mMovingObjects.size());
+    oldPositions.reserve(mMovingObjects.size());
+    oldSizes.reserve(mMovingObjects.size());
+    oldPolygons.reserve(mMovingObjects.size());
+
+    for (const MovingObject &object : mMovingObjects) {
+        objects.append(object.item->mapObject());
+        oldPositions.append(object.oldPosition);
+        oldSizes.append(object.oldSize);
+        oldPolygons.append(object.oldPolygon);
     }
-    undoStack->endMacro();
+
+    auto command = new TransformMapObjects(mapDocument(), objects, oldPositions,
+                                           oldSizes, QVector<qreal>(),
+                                           oldPolygons);
+    command->setText(tr("Resize %n Object(s)", "", mMovingObjects.size()));
+    mapDocument()->undoStack()->push(command);
 
     mMovingObjects.clear();
 }
@@ -1374,25 +1406,6 @@ void ObjectSelectionTool::refreshCursor()
         setCursor(cursorShape);
 }
 
-QPointF ObjectSelectionTool::snapToGrid(const QPointF &diff,
-                                        Qt::KeyboardModifiers modifiers)
-{
-    MapRenderer *renderer = mapDocument()->renderer();
-    SnapHelper snapHelper(renderer, modifiers);
-
-    if (snapHelper.snaps()) {
-        const QPointF alignScreenPos = renderer->pixelToScreenCoords(mAlignPosition);
-        const QPointF newAlignScreenPos = alignScreenPos + diff;
-
-        QPointF newAlignPixelPos = renderer->screenToPixelCoords(newAlignScreenPos);
-        snapHelper.snap(newAlignPixelPos);
-
-        return renderer->pixelToScreenCoords(newAlignPixelPos) - alignScreenPos;
-    }
-
-    return diff;
-}
-
 QList<MapObject *> ObjectSelectionTool::changingObjects() const
 {
     QList<MapObject*> changingObjects;
@@ -106,9 +106,6 @@ private:
 
     void refreshCursor();
 
-    QPointF snapToGrid(const QPointF &pos,
-                       Qt::KeyboardModifiers modifiers);
-
     QList<MapObject*> changingObjects() const;
 
     struct MovingObject
@@ -0,0 +1,265 @@
+/*
+ * objectsfiltermodel.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "objectsfiltermodel.h"
+
+#include "map.h"
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "mapobjectmodel.h"
+#include "objectgroup.h"
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+ObjectsFilterModel::ObjectsFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , mMapObjectModel(nullptr)
+    , mInvalidateScheduled(false)
+{
+}
+
+void ObjectsFilterModel::setMapObjectModel(MapObjectModel *mapObjectModel)
+{
+    if (mMapObjectModel == mapObjectModel)
+        return;
+
+    if (mMapObjectModel)
+        mMapObjectModel->disconnect(this);
+
+    mMapObjectModel = mapObjectModel;
+    rebuildIndex();
+
+    setSourceModel(mapObjectModel);
+
+    if (mapObjectModel) {
+        connect(mapObjectModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                SLOT(sourceRowsInserted(QModelIndex,int,int)));
+        connect(mapObjectModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                SLOT(sourceRowsAboutToBeRemoved(QModelIndex,int,int)));
+        connect(mapObjectModel, SIGNAL(modelReset()),
+                SLOT(rebuildIndex()));
+        connect(mapObjectModel, SIGNAL(objectsAdded(QList<MapObject*>)),
+                SLOT(objectsAdded(QList<MapObject*>)));
+        connect(mapObjectModel, SIGNAL(objectsChanged(QList<MapObject*>)),
+                SLOT(objectsChanged(QList<MapObject*>)));
+        connect(mapObjectModel, SIGNAL(objectsRemoved(QList<MapObject*>)),
+                SLOT(objectsRemoved(QList<MapObject*>)));
+    }
+}
+
+/**
+ * Sets the text to look for in the names and types of the objects. An empty
+ * filter shows all objects.
+ */
+void ObjectsFilterModel::setFilter(const QString &filter)
+{
+    if (mFilter == filter)
+        return;
+
+    const bool refined = !mFilter.isEmpty() && filter.contains(mFilter, Qt::CaseInsensitive);
+    mFilter = filter;
+
+    if (refined) {
+        // Only the objects that matched before can still match
+        const QList<MapObject*> candidates = mMatchingObjects.keys();
+        for (MapObject *mapObject : candidates)
+            updateMatch(mapObject);
+    } else {
+        rebuildIndex();
+    }
+
+    mInvalidateScheduled = false;
+    if (mMapObjectModel && !mFilter.isEmpty())
+        mMapObjectModel->fetchObjects(mMatchingObjects.keys());
+
+    invalidateFilter();
+}
+
+bool ObjectsFilterModel::filterAcceptsRow(int sourceRow,
+                                          const QModelIndex &sourceParent) const
+{
+    if (mFilter.isEmpty())
+        return true;
+
+    const QModelIndex index = mMapObjectModel->index(sourceRow, 0, sourceParent);
+
+    if (MapObject *mapObject = mMapObjectModel->toMapObject(index))
+        return matches(mapObject);
+    if (ObjectGroup *objectGroup = mMapObjectModel->toObjectGroup(index))
+        return mMatchCounts.value(objectGroup) > 0;
+
+    return false;
+}
+
+void ObjectsFilterModel::sourceRowsInserted(const QModelIndex &parent,
+                                            int first, int last)
+{
+    // Object groups were added
+    if (parent.isValid() || mFilter.isEmpty())
+        return;
+
+    for (int row = first; row <= last; ++row) {
+        const QModelIndex index = mMapObjectModel->index(row, 0);
+        if (ObjectGroup *objectGroup = mMapObjectModel->toObjectGroup(index))
+            for (MapObject *mapObject : objectGroup->objects())
+                updateMatch(mapObject);
+    }
+}
+
+void ObjectsFilterModel::sourceRowsAboutToBeRemoved(const QModelIndex &parent,
+                                                    int first, int last)
+{
+    // Object groups are about to be removed
+    if (parent.isValid() || mFilter.isEmpty())
+        return;
+
+    for (int row = first; row <= last; ++row) {
+        const QModelIndex index = mMapObjectModel->index(row, 0);
+        if (ObjectGroup *objectGroup = mMapObjectModel->toObjectGroup(index)) {
+            for (MapObject *mapObject : objectGroup->objects())
+                mMatchingObjects.remove(mapObject);
+            mMatchCounts.remove(objectGroup);
+        }
+    }
+}
+
+void ObjectsFilterModel::objectsAdded(const QList<MapObject *> &objects)
+{
+    if (mFilter.isEmpty())
+        return;
+
+    for (MapObject *mapObject : objects)
+        updateMatch(mapObject);
+}
+
+void ObjectsFilterModel::objectsChanged(const QList<MapObject *> &objects)
+{
+    if (mFilter.isEmpty())
+        return;
+
+    for (MapObject *mapObject : objects)
+        updateMatch(mapObject);
+}
+
+void ObjectsFilterModel::objectsRemoved(const QList<MapObject *> &objects)
+{
+    for (MapObject *mapObject : objects)
+        removeMatch(mapObject);
+}
+
+void ObjectsFilterModel::delayedInvalidateFilter()
+{
+    if (!mInvalidateScheduled)
+        return;
+
+    mInvalidateScheduled = false;
+    if (mMapObjectModel)
+        mMapObjectModel->fetchObjects(mMatchingObjects.keys());
+
+    invalidateFilter();
+}
+
+bool ObjectsFilterModel::matches(const MapObject *mapObject) const
+{
+    return mapObject->name().contains(mFilter, Qt::CaseInsensitive) ||
+            mapObject->type().contains(mFilter, Qt::CaseInsensitive);
+}
+
+/**
+ * Looks up the objects matching the filter in all object groups.
+ */
+void ObjectsFilterModel::rebuildIndex()
+{
+    mMatchingObjects.clear();
+    mMatchCounts.clear();
+
+    if (!mMapObjectModel || mFilter.isEmpty())
+        return;
+
+    const MapDocument *mapDocument = mMapObjectModel->mapDocument();
+    if (!mapDocument)
+        return;
+
+    for (ObjectGroup *objectGroup : mapDocument->map()->objectGroups()) {
+        int count = 0;
+        for (MapObject *mapObject : objectGroup->objects()) {
+            if (matches(mapObject)) {
+                mMatchingObjects.insert(mapObject, objectGroup);
+                ++count;
+            }
+        }
+        if (count > 0)
+            mMatchCounts.insert(objectGroup, count);
+    }
+}
+
+/**
+ * Updates whether the given object is among the matching objects. When this
+ * changes whether its object group is shown, the filter is updated.
+ */
+void ObjectsFilterModel::updateMatch(MapObject *mapObject)
+{
+    const bool wasMatching = mMatchingObjects.contains(mapObject);
+    const bool isMatching = matches(mapObject);
+
+    if (wasMatching == isMatching)
+        return;
+
+    if (!isMatching) {
+        removeMatch(mapObject);
+        return;
+    }
+
+    ObjectGroup *objectGroup = mapObject->objectGroup();
+    mMatchingObjects.insert(mapObject, objectGroup);
+    if (++mMatchCounts[objectGroup] == 1)
+        scheduleInvalidateFilter();
+}
+
+void ObjectsFilterModel::removeMatch(MapObject *mapObject)
+{
+    // The object may no longer be part of the group it was counted for
+    auto it = mMatchingObjects.find(mapObject);
+    if (it == mMatchingObjects.end())
+        return;
+
+    ObjectGroup *objectGroup = it.value();
+    mMatchingObjects.erase(it);
+
+    auto countIt = mMatchCounts.find(objectGroup);
+    if (countIt != mMatchCounts.end() && --countIt.value() == 0) {
+        mMatchCounts.erase(countIt);
+        scheduleInvalidateFilter();
+    }
+}
+
+/**
+ * Updates the filter once control returns to the event loop, since this is
+ * called while the source model is changing.
+ */
+void ObjectsFilterModel::scheduleInvalidateFilter()
+{
+    if (mInvalidateScheduled)
+        return;
+
+    mInvalidateScheduled = true;
+    QMetaObject::invokeMethod(this, "delayedInvalidateFilter", Qt::QueuedConnection);
+}
@@ -0,0 +1,87 @@
+/*
+ * objectsfiltermodel.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECTSFILTERMODEL_H
+#define OBJECTSFILTERMODEL_H
+
+#include <QHash>
+#include <QSortFilterProxyModel>
+
+namespace Tiled {
+
+class MapObject;
+class ObjectGroup;
+
+namespace Internal {
+
+class MapObjectModel;
+
+/**
+ * Filters the objects of a MapObjectModel by their name and type. Object
+ * groups are shown when any of their objects matches.
+ *
+ * The matching objects are kept in an index, which is updated as objects
+ * change, so that deciding whether a row is shown doesn't need to look at
+ * the objects of a group. When the filter is refined, only the objects that
+ * matched the previous filter are checked again.
+ */
+class ObjectsFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit ObjectsFilterModel(QObject *parent = nullptr);
+
+    void setMapObjectModel(MapObjectModel *mapObjectModel);
+    MapObjectModel *mapObjectModel() const { return mMapObjectModel; }
+
+    void setFilter(const QString &filter);
+    const QString &filter() const { return mFilter; }
+
+protected:
+    bool filterAcceptsRow(int sourceRow,
+                          const QModelIndex &sourceParent) const override;
+
+private slots:
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void objectsAdded(const QList<MapObject*> &objects);
+    void objectsChanged(const QList<MapObject*> &objects);
+    void objectsRemoved(const QList<MapObject*> &objects);
+    void rebuildIndex();
+    void delayedInvalidateFilter();
+
+private:
+    bool matches(const MapObject *mapObject) const;
+    void updateMatch(MapObject *mapObject);
+    void removeMatch(MapObject *mapObject);
+    void scheduleInvalidateFilter();
+
+    MapObjectModel *mMapObjectModel;
+    QString mFilter;
+    QHash<MapObject*, ObjectGroup*> mMatchingObjects;  // and their group
+    QHash<ObjectGroup*, int> mMatchCounts;
+    bool mInvalidateScheduled;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // OBJECTSFILTERMODEL_H
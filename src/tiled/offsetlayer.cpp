@@ -77,6 +77,7 @@ OffsetLayer::~OffsetLayer()
 void OffsetLayer::undo()
 {
     Q_ASSERT(!mOffsetLayer);
+    mCompressedCells.decompress(inactiveTileLayer());
     mOffsetLayer = swapLayer(mOriginalLayer);
     mOriginalLayer = nullptr;
 }
@@ -84,10 +85,32 @@ void OffsetLayer::undo()
 void OffsetLayer::redo()
 {
     Q_ASSERT(!mOriginalLayer);
+    mCompressedCells.decompress(inactiveTileLayer());
     mOriginalLayer = swapLayer(mOffsetLayer);
     mOffsetLayer = nullptr;
 }
 
+qint64 OffsetLayer::memoryUsage() const
+{
+    return Internal::memoryUsage(inactiveTileLayer()) + mCompressedCells.memoryUsage();
+}
+
+void OffsetLayer::compress()
+{
+    if (TileLayer *tileLayer = inactiveTileLayer())
+        mCompressedCells.compress(tileLayer);
+}
+
+/**
+ * Returns the layer that is currently not part of the map, when it is a
+ * tile layer.
+ */
+TileLayer *OffsetLayer::inactiveTileLayer() const
+{
+    Layer *layer = mOriginalLayer ? mOriginalLayer : mOffsetLayer;
+    return layer ? layer->asTileLayer() : nullptr;
+}
+
 Layer *OffsetLayer::swapLayer(Layer *layer)
 {
     const int currentIndex = mMapDocument->currentLayerIndex();
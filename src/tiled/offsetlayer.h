@@ -22,6 +22,8 @@
 #ifndef OFFSETLAYER_H
 #define OFFSETLAYER_H
 
+#include "undomemory.h"
+
 #include <QRect>
 #include <QPoint>
 #include <QUndoCommand>
@@ -29,6 +31,7 @@
 namespace Tiled {
 
 class Layer;
+class TileLayer;
 
 namespace Internal {
 
@@ -37,7 +40,7 @@ class MapDocument;
 /**
  * Undo command that offsets a map layer.
  */
-class OffsetLayer : public QUndoCommand
+class OffsetLayer : public QUndoCommand, public UndoCommandMemory
 {
 public:
     /**
@@ -56,13 +59,20 @@ public:
     void undo() override;
     void redo() override;
 
+    qint64 memoryUsage() const override;
+    void compress() override;
+
 private:
     Layer *swapLayer(Layer *layer);
+    TileLayer *inactiveTileLayer() const;
 
     MapDocument *mMapDocument;
     int mIndex;
     Layer *mOriginalLayer;
     Layer *mOffsetLayer;
+
+    // The cells of the layer that is currently not part of the map
+    CompressedCells mCompressedCells;
 };
 
 } // namespace Internal
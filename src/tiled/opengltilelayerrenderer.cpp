@@ -0,0 +1,484 @@
+/*
+ * opengltilelayerrenderer.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "opengltilelayerrenderer.h"
+
+#ifndef QT_NO_OPENGL
+
+#include "map.h"
+#include "mapdocument.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QGLContext>
+#include <QMatrix4x4>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QPaintEngine>
+#include <QPainter>
+
+#include <QtMath>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+const char vertexShaderSource[] =
+        "attribute highp vec2 vertex;\n"
+        "attribute highp vec2 texCoord;\n"
+        "uniform highp mat4 matrix;\n"
+        "varying highp vec2 coord;\n"
+        "void main() {\n"
+        "    coord = texCoord;\n"
+        "    gl_Position = matrix * vec4(vertex, 0.0, 1.0);\n"
+        "}\n";
+
+const char fragmentShaderSource[] =
+        "uniform sampler2D tileset;\n"
+        "uniform lowp float opacity;\n"
+        "varying highp vec2 coord;\n"
+        "void main() {\n"
+        "    gl_FragColor = texture2D(tileset, coord) * opacity;\n"
+        "}\n";
+
+// Cells are drawn as two triangles of vertices with x, y, u and v
+const int FloatsPerVertex = 4;
+
+/**
+ * The shader program and unused buffers of an OpenGL context, which are
+ * shared by the renderers of all tile layers drawn in that context.
+ */
+struct ContextResources
+{
+    ContextResources()
+        : valid(false)
+        , vertexLocation(-1)
+        , texCoordLocation(-1)
+        , matrixLocation(-1)
+        , opacityLocation(-1)
+        , textureLocation(-1)
+    {}
+
+    QOpenGLShaderProgram program;
+    bool valid;
+    int vertexLocation;
+    int texCoordLocation;
+    int matrixLocation;
+    int opacityLocation;
+    int textureLocation;
+
+    // Buffers released while the context wasn't current
+    QVector<GLuint> unusedBuffers;
+};
+
+QHash<QOpenGLContext*, ContextResources*> contextResources;
+
+ContextResources *resourcesForContext(QOpenGLContext *context)
+{
+    ContextResources *&resources = contextResources[context];
+    if (resources)
+        return resources;
+
+    resources = new ContextResources;
+
+    QOpenGLShaderProgram &program = resources->program;
+    resources->valid =
+            program.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource) &&
+            program.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShaderSource) &&
+            program.link();
+
+    if (resources->valid) {
+        resources->vertexLocation = program.attributeLocation("vertex");
+        resources->texCoordLocation = program.attributeLocation("texCoord");
+        resources->matrixLocation = program.uniformLocation("matrix");
+        resources->opacityLocation = program.uniformLocation("opacity");
+        resources->textureLocation = program.uniformLocation("tileset");
+    }
+
+    // The context is current while it is being destroyed
+    QObject::connect(context, &QOpenGLContext::aboutToBeDestroyed, [context] {
+        delete contextResources.take(context);
+    });
+
+    return resources;
+}
+
+void appendVertex(QVector<GLfloat> &vertices,
+                  qreal x, qreal y, qreal u, qreal v)
+{
+    vertices.append(GLfloat(x));
+    vertices.append(GLfloat(y));
+    vertices.append(GLfloat(u));
+    vertices.append(GLfloat(v));
+}
+
+} // anonymous namespace
+
+OpenGLTileLayerRenderer::OpenGLTileLayerRenderer(TileLayer *layer,
+                                                 MapDocument *mapDocument)
+    : mLayer(layer)
+    , mMapDocument(mapDocument)
+    , mContext(nullptr)
+{
+}
+
+OpenGLTileLayerRenderer::~OpenGLTileLayerRenderer()
+{
+    releaseBuffers();
+}
+
+/**
+ * Returns whether the given \a layer can be rendered with OpenGL using the
+ * given \a painter.
+ *
+ * This is only supported for orthogonal maps and for tiles that fit within
+ * their cell. Larger or offset tiles would need to be drawn in the order
+ * defined by the map, which is not done when drawing per chunk.
+ */
+bool OpenGLTileLayerRenderer::canRender(const QPainter *painter,
+                                        const TileLayer *layer,
+                                        const MapDocument *mapDocument)
+{
+    const QPaintEngine *engine = painter->paintEngine();
+    if (!engine || engine->type() != QPaintEngine::OpenGL2)
+        return false;
+
+    if (!QOpenGLContext::currentContext() || !QGLContext::currentContext())
+        return false;
+
+    const Map *map = mapDocument->map();
+    if (map->orientation() != Map::Orthogonal)
+        return false;
+
+    const QMargins margins = layer->drawMargins();
+    return margins.left() <= 0 &&
+            margins.bottom() <= 0 &&
+            margins.top() <= map->tileHeight() &&
+            margins.right() <= map->tileWidth();
+}
+
+/**
+ * Renders the chunks of the layer that overlap with the \a exposedRect,
+ * given in item coordinates.
+ *
+ * Returns false without drawing anything when the exposed part of the layer
+ * contains tiles that are not part of a tileset image, or when the shaders
+ * are not supported. In that case the layer should be drawn using the
+ * painter instead.
+ */
+bool OpenGLTileLayerRenderer::render(QPainter *painter, const QRectF &exposedRect)
+{
+    painter->beginNativePainting();
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (context != mContext) {
+        releaseBuffers();
+        mContext = context;
+    }
+
+    ContextResources *resources = resourcesForContext(context);
+    if (!resources->valid) {
+        painter->endNativePainting();
+        return false;
+    }
+
+    QOpenGLFunctions *gl = context->functions();
+
+    if (!resources->unusedBuffers.isEmpty()) {
+        gl->glDeleteBuffers(resources->unusedBuffers.size(),
+                            resources->unusedBuffers.constData());
+        resources->unusedBuffers.clear();
+    }
+
+    const Map *map = mMapDocument->map();
+    const int tileWidth = map->tileWidth();
+    const int tileHeight = map->tileHeight();
+
+    // Determine the range of visible chunks
+    const QRectF rect = exposedRect.translated(-mLayer->x() * tileWidth,
+                                               -mLayer->y() * tileHeight);
+    const QRect tileRect = QRect(QPoint(qFloor(rect.left() / tileWidth),
+                                        qFloor(rect.top() / tileHeight)),
+                                 QPoint(qFloor(rect.right() / tileWidth),
+                                        qFloor(rect.bottom() / tileHeight)))
+            & QRect(0, 0, mLayer->width(), mLayer->height());
+
+    if (tileRect.isEmpty()) {
+        painter->endNativePainting();
+        return true;
+    }
+
+    const bool smooth = painter->testRenderHint(QPainter::SmoothPixmapTransform);
+    const ChunkHash &chunks = mLayer->chunks();
+    QVector<ChunkGeometry*> visibleChunks;
+
+    for (int y = tileRect.top() >> CHUNK_BITS; y <= tileRect.bottom() >> CHUNK_BITS; ++y) {
+        for (int x = tileRect.left() >> CHUNK_BITS; x <= tileRect.right() >> CHUNK_BITS; ++x) {
+            const QPoint chunkPos(x, y);
+            if (!chunks.contains(chunkPos))
+                continue;
+
+            ChunkGeometry &geometry = mChunks[chunkPos];
+            if (geometry.dirty || geometry.smooth != smooth)
+                updateChunk(chunkPos, geometry, smooth);
+
+            if (!geometry.supported) {
+                painter->endNativePainting();
+                return false;
+            }
+
+            if (!geometry.batches.isEmpty())
+                visibleChunks.append(&geometry);
+        }
+    }
+
+    const QTransform transform = painter->combinedTransform();
+    const QPaintDevice *device = painter->device();
+
+    QMatrix4x4 matrix;
+    matrix.ortho(0, device->width(), device->height(), 0, -1, 1);
+    matrix *= QMatrix4x4(transform);
+    matrix.translate(mLayer->x() * tileWidth, mLayer->y() * tileHeight);
+
+    const GLint filter = smooth ? GL_LINEAR : GL_NEAREST;
+
+    QOpenGLShaderProgram &program = resources->program;
+    program.bind();
+    program.setUniformValue(resources->matrixLocation, matrix);
+    program.setUniformValue(resources->opacityLocation, GLfloat(painter->opacity()));
+    program.setUniformValue(resources->textureLocation, 0);
+    program.enableAttributeArray(resources->vertexLocation);
+    program.enableAttributeArray(resources->texCoordLocation);
+
+    gl->glEnable(GL_BLEND);
+    gl->glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    gl->glActiveTexture(GL_TEXTURE0);
+
+    QGLContext *glContext = const_cast<QGLContext*>(QGLContext::currentContext());
+    const int stride = FloatsPerVertex * sizeof(GLfloat);
+
+    for (const ChunkGeometry *geometry : visibleChunks) {
+        gl->glBindBuffer(GL_ARRAY_BUFFER, geometry->buffer);
+        program.setAttributeBuffer(resources->vertexLocation, GL_FLOAT,
+                                   0, 2, stride);
+        program.setAttributeBuffer(resources->texCoordLocation, GL_FLOAT,
+                                   2 * sizeof(GLfloat), 2, stride);
+
+        for (const Batch &batch : geometry->batches) {
+            const GLuint texture =
+                    glContext->bindTexture(batch.image, GL_TEXTURE_2D, GL_RGBA,
+                                           QGLContext::PremultipliedAlphaBindOption);
+
+            gl->glBindTexture(GL_TEXTURE_2D, texture);
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+            gl->glDrawArrays(GL_TRIANGLES, batch.first, batch.count);
+        }
+    }
+
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    program.disableAttributeArray(resources->vertexLocation);
+    program.disableAttributeArray(resources->texCoordLocation);
+    program.release();
+
+    painter->endNativePainting();
+    return true;
+}
+
+/**
+ * Marks the chunks overlapping with \a rect, given in item coordinates, for
+ * updating. They are updated when they are drawn next.
+ */
+void OpenGLTileLayerRenderer::invalidate(const QRectF &rect)
+{
+    const Map *map = mMapDocument->map();
+    const int tileWidth = map->tileWidth();
+    const int tileHeight = map->tileHeight();
+
+    const QRectF layerRect = rect.translated(-mLayer->x() * tileWidth,
+                                             -mLayer->y() * tileHeight);
+
+    const int startX = qFloor(layerRect.left() / tileWidth) >> CHUNK_BITS;
+    const int startY = qFloor(layerRect.top() / tileHeight) >> CHUNK_BITS;
+    const int endX = qFloor(layerRect.right() / tileWidth) >> CHUNK_BITS;
+    const int endY = qFloor(layerRect.bottom() / tileHeight) >> CHUNK_BITS;
+
+    for (auto it = mChunks.begin(), it_end = mChunks.end(); it != it_end; ++it) {
+        const QPoint &pos = it.key();
+        if (pos.x() >= startX && pos.x() <= endX &&
+                pos.y() >= startY && pos.y() <= endY)
+            it.value().dirty = true;
+    }
+}
+
+/**
+ * Marks all chunks for updating.
+ */
+void OpenGLTileLayerRenderer::invalidate()
+{
+    for (ChunkGeometry &geometry : mChunks)
+        geometry.dirty = true;
+}
+
+/**
+ * Fills the vertex buffer of the given chunk with a quad for each cell,
+ * grouped by tileset image. Needs the OpenGL context to be current.
+ *
+ * When \a smooth is set, the texture coordinates are prepared for linear
+ * filtering.
+ */
+void OpenGLTileLayerRenderer::updateChunk(const QPoint &chunkPos,
+                                          ChunkGeometry &geometry,
+                                          bool smooth)
+{
+    QOpenGLFunctions *gl = mContext->functions();
+
+    geometry.batches.clear();
+    geometry.dirty = false;
+    geometry.supported = true;
+    geometry.smooth = smooth;
+
+    const Map *map = mMapDocument->map();
+    const int tileWidth = map->tileWidth();
+    const int tileHeight = map->tileHeight();
+
+    const Chunk &chunk = mLayer->chunks().value(chunkPos);
+    const QRect layerRect(0, 0, mLayer->width(), mLayer->height());
+
+    // Vertices per tileset image, keyed by the cache key of the image
+    QVector<qint64> imageKeys;
+    QVector<QPixmap> images;
+    QVector<QVector<GLfloat>> vertices;
+
+    for (int cy = 0; cy < CHUNK_SIZE; ++cy) {
+        for (int cx = 0; cx < CHUNK_SIZE; ++cx) {
+            const int x = chunkPos.x() * CHUNK_SIZE + cx;
+            const int y = chunkPos.y() * CHUNK_SIZE + cy;
+            if (!layerRect.contains(x, y))
+                continue;
+
+            const Cell &cell = chunk.cellAt(cx, cy);
+            if (cell.isEmpty())
+                continue;
+
+            const Tile *tile = cell.tile->currentFrameTile();
+            const QRect &imageRect = tile->imageRect();
+            if (imageRect.isNull()) {
+                // Only tiles from tileset images are supported
+                geometry.supported = false;
+                return;
+            }
+
+            const QPixmap &image = tile->tileset()->image();
+            int index = imageKeys.indexOf(image.cacheKey());
+            if (index == -1) {
+                index = imageKeys.size();
+                imageKeys.append(image.cacheKey());
+                images.append(image);
+                vertices.append(QVector<GLfloat>());
+            }
+
+            // Texture coordinates are at the edges of the tile, which covers
+            // all of its texels. With linear filtering they are inset by half
+            // a texel, to avoid picking up neighboring tiles.
+            const qreal inset = smooth ? 0.5 : 0.0;
+            const qreal imageWidth = image.width();
+            const qreal imageHeight = image.height();
+            const qreal u0 = (imageRect.left() + inset) / imageWidth;
+            const qreal u1 = (imageRect.left() + imageRect.width() - inset) / imageWidth;
+            const qreal v0 = (imageRect.top() + inset) / imageHeight;
+            const qreal v1 = (imageRect.top() + imageRect.height() - inset) / imageHeight;
+
+            QSizeF size = imageRect.size();
+            if (cell.flippedAntiDiagonally)
+                size.transpose();
+
+            const QPoint offset = tile->offset();
+            const qreal left = x * tileWidth + offset.x();
+            const qreal bottom = (y + 1) * tileHeight + offset.y();
+            const qreal right = left + size.width();
+            const qreal top = bottom - size.height();
+
+            // Maps a corner of the cell to a corner of the tile image. The
+            // anti-diagonal flip is applied before the horizontal and
+            // vertical flips.
+            auto texCoord = [&] (int cornerX, int cornerY, qreal &u, qreal &v) {
+                if (cell.flippedVertically)
+                    cornerY = 1 - cornerY;
+                if (cell.flippedHorizontally)
+                    cornerX = 1 - cornerX;
+                if (cell.flippedAntiDiagonally)
+                    std::swap(cornerX, cornerY);
+
+                u = cornerX ? u1 : u0;
+                v = cornerY ? v1 : v0;
+            };
+
+            qreal u, v;
+            QVector<GLfloat> &out = vertices[index];
+
+            texCoord(0, 0, u, v); appendVertex(out, left, top, u, v);
+            texCoord(1, 0, u, v); appendVertex(out, right, top, u, v);
+            texCoord(0, 1, u, v); appendVertex(out, left, bottom, u, v);
+            texCoord(1, 0, u, v); appendVertex(out, right, top, u, v);
+            texCoord(1, 1, u, v); appendVertex(out, right, bottom, u, v);
+            texCoord(0, 1, u, v); appendVertex(out, left, bottom, u, v);
+        }
+    }
+
+    QVector<GLfloat> data;
+    for (int i = 0; i < vertices.size(); ++i) {
+        const Batch batch = {
+            images.at(i),
+            data.size() / FloatsPerVertex,
+            vertices.at(i).size() / FloatsPerVertex
+        };
+        geometry.batches.append(batch);
+        data += vertices.at(i);
+    }
+
+    if (!geometry.buffer)
+        gl->glGenBuffers(1, &geometry.buffer);
+
+    gl->glBindBuffer(GL_ARRAY_BUFFER, geometry.buffer);
+    gl->glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(GLfloat),
+                     data.constData(), GL_STATIC_DRAW);
+}
+
+/**
+ * Releases the vertex buffers. Since this is not necessarily called while
+ * the context is current, the buffers are deleted the next time any layer
+ * is drawn in that context.
+ */
+void OpenGLTileLayerRenderer::releaseBuffers()
+{
+    if (ContextResources *resources = contextResources.value(mContext)) {
+        for (const ChunkGeometry &geometry : mChunks)
+            if (geometry.buffer)
+                resources->unusedBuffers.append(geometry.buffer);
+    }
+
+    mChunks.clear();
+    mContext = nullptr;
+}
+
+#endif // QT_NO_OPENGL
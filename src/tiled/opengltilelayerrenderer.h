@@ -0,0 +1,99 @@
+/*
+ * opengltilelayerrenderer.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENGLTILELAYERRENDERER_H
+#define OPENGLTILELAYERRENDERER_H
+
+#ifndef QT_NO_OPENGL
+
+#include <QHash>
+#include <QOpenGLFunctions>
+#include <QPixmap>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+class QOpenGLContext;
+class QPainter;
+
+namespace Tiled {
+
+class TileLayer;
+
+namespace Internal {
+
+class MapDocument;
+
+/**
+ * Renders an orthogonal tile layer directly with OpenGL, for use when the
+ * map view has an OpenGL viewport.
+ *
+ * The tileset images are used as textures. The cells of each chunk of the
+ * layer are stored as quads in a vertex buffer, which is only updated when
+ * the chunk changes. Drawing a chunk takes one draw call for each tileset
+ * used in the chunk.
+ */
+class OpenGLTileLayerRenderer
+{
+public:
+    OpenGLTileLayerRenderer(TileLayer *layer, MapDocument *mapDocument);
+    ~OpenGLTileLayerRenderer();
+
+    static bool canRender(const QPainter *painter,
+                          const TileLayer *layer,
+                          const MapDocument *mapDocument);
+
+    bool render(QPainter *painter, const QRectF &exposedRect);
+
+    void invalidate(const QRectF &rect);
+    void invalidate();
+
+private:
+    struct Batch {
+        QPixmap image;
+        int first;
+        int count;
+    };
+
+    struct ChunkGeometry {
+        ChunkGeometry() : buffer(0), dirty(true), supported(true), smooth(false) {}
+
+        GLuint buffer;
+        QVector<Batch> batches;
+        bool dirty;
+        bool supported;
+        bool smooth;    // texture coordinates are inset for linear filtering
+    };
+
+    void updateChunk(const QPoint &chunkPos, ChunkGeometry &geometry, bool smooth);
+    void releaseBuffers();
+
+    TileLayer *mLayer;
+    MapDocument *mMapDocument;
+    QOpenGLContext *mContext;
+    QHash<QPoint, ChunkGeometry> mChunks;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // QT_NO_OPENGL
+
+#endif // OPENGLTILELAYERRENDERER_H
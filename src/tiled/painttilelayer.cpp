@@ -37,28 +37,56 @@ PaintTileLayer::PaintTileLayer(MapDocument *mapDocument,
                                const TileLayer *source):
     mMapDocument(mapDocument),
     mTarget(target),
-    mSource(static_cast<TileLayer*>(source->clone())),
-    mX(x),
-    mY(y),
-    mPaintedRegion(x, y, source->width(), source->height()),
+    mErased(new TileLayer(QString(), 0, 0, target->width(), target->height())),
+    mPainted(new TileLayer(QString(), 0, 0, target->width(), target->height())),
     mMergeable(false)
 {
-    mErased = mTarget->copy(mX - mTarget->x(),
-                            mY - mTarget->y(),
-                            mSource->width(), mSource->height());
+    const QPoint offset = QPoint(x, y) - mTarget->position();
+
+    // The cells of infinite layers may lie outside of their bounds, which
+    // the layers holding the changes need to be able to store as well
+    if (mTarget->isInfinite()) {
+        mErased->setMap(mTarget->map());
+        mPainted->setMap(mTarget->map());
+    }
+
+    // Empty cells of the source are not painted, so only its chunks need to
+    // be looked at
+    for (auto it = source->begin(), it_end = source->end(); it != it_end; ++it) {
+        const Cell &cell = *it;
+        if (cell.isEmpty())
+            continue;
+
+        const QPoint pos = it.pos() + offset;
+        if (!mTarget->isInfinite() && !mTarget->contains(pos))
+            continue;
+
+        const Cell &previous = mTarget->cellAt(pos);
+        if (previous == cell)
+            continue;
+
+        mErased->setCell(pos.x(), pos.y(), previous);
+        mPainted->setCell(pos.x(), pos.y(), cell);
+        mChangedCells.setCell(pos.x(), pos.y());
+    }
+
     setText(QCoreApplication::translate("Undo Commands", "Paint"));
 }
 
 PaintTileLayer::~PaintTileLayer()
 {
-    delete mSource;
     delete mErased;
+    delete mPainted;
 }
 
 void PaintTileLayer::undo()
 {
-    TilePainter painter(mMapDocument, mTarget);
-    painter.setCells(mX, mY, mErased, mPaintedRegion);
+    decompress();
+
+    if (!mChangedCells.isEmpty()) {
+        TilePainter painter(mMapDocument, mTarget);
+        painter.setCells(mTarget->x(), mTarget->y(), mErased, changedRegion());
+    }
 
     QUndoCommand::undo(); // undo child commands
 }
@@ -67,8 +95,12 @@ void PaintTileLayer::redo()
 {
     QUndoCommand::redo(); // redo child commands
 
-    TilePainter painter(mMapDocument, mTarget);
-    painter.drawCells(mX, mY, mSource);
+    decompress();
+
+    if (!mChangedCells.isEmpty()) {
+        TilePainter painter(mMapDocument, mTarget);
+        painter.setCells(mTarget->x(), mTarget->y(), mPainted, changedRegion());
+    }
 }
 
 bool PaintTileLayer::mergeWith(const QUndoCommand *other)
@@ -79,33 +111,50 @@ bool PaintTileLayer::mergeWith(const QUndoCommand *other)
           o->mMergeable))
         return false;
 
-    const QRegion newRegion = o->mPaintedRegion.subtracted(mPaintedRegion);
-    const QRegion combinedRegion = mPaintedRegion.united(o->mPaintedRegion);
-    const QRect bounds = QRect(mX, mY, mSource->width(), mSource->height());
-    const QRect combinedBounds = combinedRegion.boundingRect();
+    if (o->mPainted->size() != mPainted->size())
+        return false;
 
-    // Resize the erased tiles and source layers when necessary
-    if (bounds != combinedBounds) {
-        const QPoint shift = bounds.topLeft() - combinedBounds.topLeft();
-        mErased->resize(combinedBounds.size(), shift);
-        mSource->resize(combinedBounds.size(), shift);
-    }
+    decompress();
 
-    mX = combinedBounds.left();
-    mY = combinedBounds.top();
-    mPaintedRegion = combinedRegion;
+    // Keep the erased cells of this command where both commands changed
+    // cells, since those were the cells from before either command
+    for (const QRect &rect : o->mChangedCells.toRegion().rects()) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                if (!mChangedCells.contains(x, y))
+                    mErased->setCell(x, y, o->mErased->cellAt(x, y));
 
-    // Copy the painted tiles from the other command over
-    const QPoint pos = QPoint(o->mX, o->mY) - combinedBounds.topLeft();
-    mSource->merge(pos, o->mSource);
+                mPainted->setCell(x, y, o->mPainted->cellAt(x, y));
+            }
+        }
+    }
 
-    // Copy the newly erased tiles from the other command over
-    foreach (const QRect &rect, newRegion.rects())
-        for (int y = rect.top(); y <= rect.bottom(); ++y)
-            for (int x = rect.left(); x <= rect.right(); ++x)
-                mErased->setCell(x - mX,
-                                 y - mY,
-                                 o->mErased->cellAt(x - o->mX, y - o->mY));
+    mChangedCells += o->mChangedCells;
 
     return true;
 }
+
+QRegion PaintTileLayer::changedRegion() const
+{
+    return mChangedCells.toRegion().translated(mTarget->position());
+}
+
+qint64 PaintTileLayer::memoryUsage() const
+{
+    return Internal::memoryUsage(mErased) +
+            Internal::memoryUsage(mPainted) +
+            mCompressedErased.memoryUsage() +
+            mCompressedPainted.memoryUsage();
+}
+
+void PaintTileLayer::compress()
+{
+    mCompressedErased.compress(mErased);
+    mCompressedPainted.compress(mPainted);
+}
+
+void PaintTileLayer::decompress()
+{
+    mCompressedErased.decompress(mErased);
+    mCompressedPainted.decompress(mPainted);
+}
@@ -21,9 +21,10 @@
 #ifndef PAINTTILELAYER_H
 #define PAINTTILELAYER_H
 
+#include "tilemask.h"
 #include "undocommands.h"
+#include "undomemory.h"
 
-#include <QRegion>
 #include <QUndoCommand>
 
 namespace Tiled {
@@ -36,8 +37,11 @@ class MapDocument;
 
 /**
  * A command that paints one tile layer on top of another tile layer.
+ *
+ * Only the cells that are actually changed are remembered, so the memory
+ * used by the command doesn't depend on the area covered by the painting.
  */
-class PaintTileLayer : public QUndoCommand
+class PaintTileLayer : public QUndoCommand, public UndoCommandMemory
 {
 public:
     /**
@@ -67,13 +71,26 @@ public:
     int id() const override { return Cmd_PaintTileLayer; }
     bool mergeWith(const QUndoCommand *other) override;
 
+    qint64 memoryUsage() const override;
+    void compress() override;
+
 private:
+    QRegion changedRegion() const;
+    void decompress();
+
     MapDocument *mMapDocument;
     TileLayer *mTarget;
-    TileLayer *mSource;
+
+    /*
+     * The previous and the painted cells, stored in sparse layers matching
+     * the target layer, so that merging never needs to resize them.
+     */
     TileLayer *mErased;
-    int mX, mY;
-    QRegion mPaintedRegion;
+    TileLayer *mPainted;
+    CompressedCells mCompressedErased;
+    CompressedCells mCompressedPainted;
+
+    TileMask mChangedCells;     // relative to the target layer
     bool mMergeable;
 };
 
@@ -21,7 +21,9 @@
 #include "preferences.h"
 
 #include "documentmanager.h"
+#include "imagecache.h"
 #include "languagemanager.h"
+#include "mapcache.h"
 #include "mapdocument.h"
 #include "tilesetmanager.h"
 
@@ -58,8 +60,13 @@ Preferences::Preferences()
     mMapRenderOrder = static_cast<Map::RenderOrder>
             (intValue("MapRenderOrder", Map::RightDown));
     mDtdEnabled = boolValue("DtdEnabled");
+    mRepackTilesetsOnExport = boolValue("RepackTilesetsOnExport");
     mReloadTilesetsOnChange = boolValue("ReloadTilesets", true);
     mStampsDirectory = stringValue("StampsDirectory");
+    mUndoMemoryLimit = intValue("UndoMemoryLimit", 256);
+    mTileImageCacheLimit = intValue("TileImageCacheLimit", 1024);
+    mDiskCacheLimit = intValue("DiskCacheLimit", 512);
+    mCompressHiddenLayers = boolValue("CompressHiddenLayers");
     mSettings->endGroup();
 
     // Retrieve interface settings
@@ -76,6 +83,7 @@ Preferences::Preferences()
     mShowTilesetGrid = boolValue("ShowTilesetGrid", true);
     mLanguage = stringValue("Language");
     mUseOpenGL = boolValue("OpenGL");
+    mProgressiveRendering = boolValue("ProgressiveRendering");
     mObjectLabelVisibility = static_cast<ObjectLabelVisiblity>
             (intValue("ObjectLabelVisibility", AllObjectLabels));
     mSettings->endGroup();
@@ -91,6 +99,7 @@ Preferences::Preferences()
     const int count = qMin(names.size(), colors.size());
     for (int i = 0; i < count; ++i)
         mObjectTypes.append(ObjectType(names.at(i), QColor(colors.at(i))));
+    updateObjectTypeLookup();
 
     mSettings->beginGroup(QLatin1String("Automapping"));
     mAutoMapDrawing = boolValue("WhileDrawing");
@@ -103,6 +112,7 @@ Preferences::Preferences()
     TilesetManager *tilesetManager = TilesetManager::instance();
     tilesetManager->setReloadTilesetsOnChange(mReloadTilesetsOnChange);
     tilesetManager->setAnimateTiles(mShowTileAnimations);
+    tilesetManager->setImageCacheLimit(qint64(mTileImageCacheLimit) * 1024 * 1024);
 
     // Keeping track of some usage information
     mSettings->beginGroup(QLatin1String("Install"));
@@ -279,12 +289,64 @@ bool Preferences::dtdEnabled() const
     return mDtdEnabled;
 }
 
+void Preferences::setUndoMemoryLimit(int megabytes)
+{
+    if (mUndoMemoryLimit == megabytes)
+        return;
+
+    mUndoMemoryLimit = megabytes;
+    mSettings->setValue(QLatin1String("Storage/UndoMemoryLimit"), megabytes);
+    emit undoMemoryLimitChanged(megabytes);
+}
+
+void Preferences::setTileImageCacheLimit(int megabytes)
+{
+    if (mTileImageCacheLimit == megabytes)
+        return;
+
+    mTileImageCacheLimit = megabytes;
+    mSettings->setValue(QLatin1String("Storage/TileImageCacheLimit"), megabytes);
+
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    tilesetManager->setImageCacheLimit(qint64(megabytes) * 1024 * 1024);
+}
+
+void Preferences::setDiskCacheLimit(int megabytes)
+{
+    if (mDiskCacheLimit == megabytes)
+        return;
+
+    mDiskCacheLimit = megabytes;
+    mSettings->setValue(QLatin1String("Storage/DiskCacheLimit"), megabytes);
+
+    ImageCache::setSizeLimit(megabytes);
+    if (megabytes == 0)
+        ImageCache::setEnabled(false);
+    MapCache::setSizeLimit(megabytes);
+}
+
+void Preferences::setCompressHiddenLayers(bool enabled)
+{
+    if (mCompressHiddenLayers == enabled)
+        return;
+
+    mCompressHiddenLayers = enabled;
+    mSettings->setValue(QLatin1String("Storage/CompressHiddenLayers"), enabled);
+    emit compressHiddenLayersChanged(enabled);
+}
+
 void Preferences::setDtdEnabled(bool enabled)
 {
     mDtdEnabled = enabled;
     mSettings->setValue(QLatin1String("Storage/DtdEnabled"), enabled);
 }
 
+void Preferences::setRepackTilesetsOnExport(bool enabled)
+{
+    mRepackTilesetsOnExport = enabled;
+    mSettings->setValue(QLatin1String("Storage/RepackTilesetsOnExport"), enabled);
+}
+
 QString Preferences::language() const
 {
     return mLanguage;
@@ -331,9 +393,17 @@ void Preferences::setUseOpenGL(bool useOpenGL)
     emit useOpenGLChanged(mUseOpenGL);
 }
 
+void Preferences::setProgressiveRendering(bool enabled)
+{
+    mProgressiveRendering = enabled;
+    mSettings->setValue(QLatin1String("Interface/ProgressiveRendering"),
+                        mProgressiveRendering);
+}
+
 void Preferences::setObjectTypes(const ObjectTypes &objectTypes)
 {
     mObjectTypes = objectTypes;
+    updateObjectTypeLookup();
 
     QStringList names;
     QStringList colors;
@@ -350,6 +420,45 @@ void Preferences::setObjectTypes(const ObjectTypes &objectTypes)
     emit objectTypesChanged();
 }
 
+/**
+ * Returns the color of the object type with the given name, compared case
+ * insensitively. Returns an invalid color when there is no such type.
+ *
+ * This is called for each object that is drawn, so it avoids going over
+ * all object types.
+ */
+QColor Preferences::objectTypeColor(const QString &type) const
+{
+    auto it = mObjectTypeColors.constFind(type);
+    if (it == mObjectTypeColors.constEnd())
+        it = mObjectTypeColors.constFind(type.toCaseFolded());
+    if (it == mObjectTypeColors.constEnd())
+        return QColor();
+    return it.value();
+}
+
+void Preferences::updateObjectTypeLookup()
+{
+    mObjectTypeColors.clear();
+    mObjectTypeNames.clear();
+
+    // The first type matching a name case insensitively takes precedence,
+    // also when looking up the exact name of a later type
+    for (const ObjectType &type : mObjectTypes) {
+        const QString folded = type.name.toCaseFolded();
+
+        auto it = mObjectTypeColors.constFind(folded);
+        if (it == mObjectTypeColors.constEnd())
+            it = mObjectTypeColors.insert(folded, type.color);
+
+        const QColor color = it.value();
+        if (!mObjectTypeColors.contains(type.name))
+            mObjectTypeColors.insert(type.name, color);
+
+        mObjectTypeNames.append(type.name);
+    }
+}
+
 static QString lastPathKey(Preferences::FileType fileType)
 {
     QString key = QLatin1String("LastPaths/");
@@ -23,7 +23,9 @@
 
 #include <QColor>
 #include <QDate>
+#include <QHash>
 #include <QObject>
+#include <QStringList>
 
 #include "map.h"
 #include "objecttypes.h"
@@ -75,6 +77,9 @@ public:
     bool dtdEnabled() const;
     void setDtdEnabled(bool enabled);
 
+    bool repackTilesetsOnExport() const { return mRepackTilesetsOnExport; }
+    void setRepackTilesetsOnExport(bool enabled);
+
     QString language() const;
     void setLanguage(const QString &language);
 
@@ -84,9 +89,19 @@ public:
     bool useOpenGL() const { return mUseOpenGL; }
     void setUseOpenGL(bool useOpenGL);
 
+    /**
+     * Whether the chunks of tile layers that are not cached yet are rendered
+     * in the background, while the map view stays responsive.
+     */
+    bool progressiveRendering() const { return mProgressiveRendering; }
+    void setProgressiveRendering(bool enabled);
+
     const ObjectTypes &objectTypes() const { return mObjectTypes; }
     void setObjectTypes(const ObjectTypes &objectTypes);
 
+    QColor objectTypeColor(const QString &type) const;
+    const QStringList &objectTypeNames() const { return mObjectTypeNames; }
+
     enum FileType {
         ObjectTypesFile,
         ImageFile,
@@ -115,6 +130,35 @@ public:
     bool openLastFilesOnStartup() const;
     void setOpenLastFilesOnStartup(bool load);
 
+    /**
+     * The amount of memory in megabytes the undo history of each map may
+     * use before its older commands get compressed. 0 means no limit.
+     */
+    int undoMemoryLimit() const { return mUndoMemoryLimit; }
+    void setUndoMemoryLimit(int megabytes);
+
+    /**
+     * The amount of memory in megabytes the loaded tileset images may use
+     * before the least recently drawn ones are unloaded. 0 means no limit.
+     */
+    int tileImageCacheLimit() const { return mTileImageCacheLimit; }
+    void setTileImageCacheLimit(int megabytes);
+
+    /**
+     * The amount of disk space in megabytes the editor may use for caching
+     * decoded images and maps each, after which the least recently used
+     * cache files are removed. 0 disables the caches.
+     */
+    int diskCacheLimit() const { return mDiskCacheLimit; }
+    void setDiskCacheLimit(int megabytes);
+
+    /**
+     * Whether the cells of hidden tile layers are kept compressed in memory
+     * while they are not the current layer.
+     */
+    bool compressHiddenLayers() const { return mCompressHiddenLayers; }
+    void setCompressHiddenLayers(bool enabled);
+
     /**
      * Provides access to the QSettings instance to allow storing/retrieving
      * arbitrary values. The naming style for groups and keys is CamelCase.
@@ -155,6 +199,9 @@ signals:
 
     void isPatronChanged();
 
+    void undoMemoryLimitChanged(int megabytes);
+    void compressHiddenLayersChanged(bool enabled);
+
 private:
     Preferences();
     ~Preferences();
@@ -165,6 +212,8 @@ private:
     int intValue(const char *key, int defaultValue) const;
     qreal realValue(const char *key, qreal defaultValue) const;
 
+    void updateObjectTypeLookup();
+
     QSettings *mSettings;
 
     bool mShowGrid;
@@ -183,12 +232,22 @@ private:
     Map::LayerDataFormat mLayerDataFormat;
     Map::RenderOrder mMapRenderOrder;
     bool mDtdEnabled;
+    bool mRepackTilesetsOnExport;
     QString mLanguage;
     bool mReloadTilesetsOnChange;
     bool mUseOpenGL;
+    bool mProgressiveRendering;
     ObjectTypes mObjectTypes;
 
+    // Looked up by exact and by case folded name, see objectTypeColor()
+    QHash<QString, QColor> mObjectTypeColors;
+    QStringList mObjectTypeNames;
+
     bool mAutoMapDrawing;
+    int mUndoMemoryLimit;
+    int mTileImageCacheLimit;
+    int mDiskCacheLimit;
+    bool mCompressHiddenLayers;
 
     QString mMapsDirectory;
     QString mStampsDirectory;
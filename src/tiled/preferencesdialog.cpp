@@ -135,6 +135,8 @@ PreferencesDialog::PreferencesDialog(QWidget *parent) :
     connect(mUi->languageCombo, SIGNAL(currentIndexChanged(int)),
             SLOT(languageSelected(int)));
     connect(mUi->openGL, SIGNAL(toggled(bool)), SLOT(useOpenGLToggled(bool)));
+    connect(mUi->progressiveRendering, SIGNAL(toggled(bool)),
+            SLOT(progressiveRenderingToggled(bool)));
     connect(mUi->gridColor, SIGNAL(colorChanged(QColor)),
             Preferences::instance(), SLOT(setGridColor(QColor)));
     connect(mUi->gridFine, SIGNAL(valueChanged(int)),
@@ -203,6 +205,11 @@ void PreferencesDialog::useOpenGLToggled(bool useOpenGL)
     Preferences::instance()->setUseOpenGL(useOpenGL);
 }
 
+void PreferencesDialog::progressiveRenderingToggled(bool enabled)
+{
+    Preferences::instance()->setProgressiveRendering(enabled);
+}
+
 void PreferencesDialog::addObjectType()
 {
     const int newRow = mObjectTypesModel->objectTypes().size();
@@ -301,9 +308,11 @@ void PreferencesDialog::fromPreferences()
     const Preferences *prefs = Preferences::instance();
     mUi->reloadTilesetImages->setChecked(prefs->reloadTilesetsOnChange());
     mUi->enableDtd->setChecked(prefs->dtdEnabled());
+    mUi->repackTilesets->setChecked(prefs->repackTilesetsOnExport());
     mUi->openLastFiles->setChecked(prefs->openLastFilesOnStartup());
     if (mUi->openGL->isEnabled())
         mUi->openGL->setChecked(prefs->useOpenGL());
+    mUi->progressiveRendering->setChecked(prefs->progressiveRendering());
 
     // Not found (-1) ends up at index 0, system default
     int languageIndex = mUi->languageCombo->findData(prefs->language());
@@ -323,6 +332,7 @@ void PreferencesDialog::toPreferences()
 
     prefs->setReloadTilesetsOnChanged(mUi->reloadTilesetImages->isChecked());
     prefs->setDtdEnabled(mUi->enableDtd->isChecked());
+    prefs->setRepackTilesetsOnExport(mUi->repackTilesets->isChecked());
     prefs->setAutomappingDrawing(mUi->autoMapWhileDrawing->isChecked());
     prefs->setOpenLastFilesOnStartup(mUi->openLastFiles->isChecked());
 }
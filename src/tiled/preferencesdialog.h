@@ -53,6 +53,7 @@ private slots:
     void languageSelected(int index);
     void objectLineWidthChanged(double lineWidth);
     void useOpenGLToggled(bool useOpenGL);
+    void progressiveRenderingToggled(bool enabled);
     void useAutomappingDrawingToggled(bool enabled);
     void openLastFilesToggled(bool enabled);
 
@@ -0,0 +1,282 @@
+/*
+ * progressiverenderer.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "progressiverenderer.h"
+
+#include "hexagonalrenderer.h"
+#include "isometricrenderer.h"
+#include "map.h"
+#include "mapdocument.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "tilesetmanager.h"
+
+#include <QAtomicInt>
+#include <QPainter>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+
+#include <algorithm>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * The state shared between the progressive renderer and the worker
+ * rendering a chunk.
+ */
+struct RenderRequest
+{
+    RenderRequest()
+        : finished(0)
+        , canceled(0)
+    {}
+
+    TileLayerRenderCache::ChunkRequest chunk;
+    TileLayerRenderCache::RenderFunction render;
+    QImage image;
+    QAtomicInt finished;
+    QAtomicInt canceled;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+namespace {
+
+/**
+ * A copy of a tile layer along with a map and renderer of its own, so that
+ * it can be rendered while the layer is being edited.
+ */
+class LayerSnapshot
+{
+public:
+    LayerSnapshot(const TileLayer *layer, const MapRenderer *renderer)
+    {
+        const Map *map = layer->map();
+
+        mMap.reset(new Map(map->orientation(),
+                           map->width(), map->height(),
+                           map->tileWidth(), map->tileHeight()));
+        mMap->setHexSideLength(map->hexSideLength());
+        mMap->setInfinite(map->infinite());
+        mMap->setStaggerAxis(map->staggerAxis());
+        mMap->setStaggerIndex(map->staggerIndex());
+        mMap->setRenderOrder(map->renderOrder());
+
+        const QSet<SharedTileset> tilesets = layer->usedTilesets();
+        mMap->addTilesets(tilesets);
+
+        // Pixmaps can only be used on the main thread, so the layer is drawn
+        // from copies of the tileset images
+        mImages.reset(new MapImages(mMap.data(), renderer->flags()));
+
+        mLayer = static_cast<TileLayer*>(layer->clone());
+        mMap->addLayer(mLayer);
+
+        mRenderer.reset(createRenderer());
+        mRenderer->setFlags(renderer->flags());
+        mRenderer->setImages(mImages.data());
+    }
+
+    void render(QPainter *painter, const QRectF &rect) const
+    {
+        mRenderer->drawTileLayer(painter, mLayer, rect);
+    }
+
+private:
+    MapRenderer *createRenderer() const
+    {
+        switch (mMap->orientation()) {
+        case Map::Isometric:
+            return new IsometricRenderer(mMap.data());
+        case Map::Staggered:
+            return new StaggeredRenderer(mMap.data());
+        case Map::Hexagonal:
+            return new HexagonalRenderer(mMap.data());
+        case Map::Orthogonal:
+        default:
+            return new OrthogonalRenderer(mMap.data());
+        }
+    }
+
+    QScopedPointer<Map> mMap;
+    QScopedPointer<MapImages> mImages;
+    TileLayer *mLayer;
+    QScopedPointer<MapRenderer> mRenderer;
+};
+
+class RenderTask : public QRunnable
+{
+public:
+    RenderTask(QObject *receiver, const QSharedPointer<RenderRequest> &request)
+        : mReceiver(receiver)
+        , mRequest(request)
+    {}
+
+    void run() override
+    {
+        if (!mRequest->canceled.loadAcquire()) {
+            mRequest->image = TileLayerRenderCache::renderChunkImage(mRequest->render,
+                                                                     mRequest->chunk);
+            mRequest->finished.storeRelease(1);
+        }
+
+        mRequest->render = TileLayerRenderCache::RenderFunction();
+
+        // The receiver outlives the thread pool, which runs this task. It
+        // is notified of canceled tasks too, since these also use tilesets.
+        QMetaObject::invokeMethod(mReceiver, "taskFinished", Qt::QueuedConnection);
+    }
+
+private:
+    QObject *mReceiver;
+    QSharedPointer<RenderRequest> mRequest;
+};
+
+} // anonymous namespace
+
+ProgressiveRenderer::ProgressiveRenderer(TileLayer *layer,
+                                         MapDocument *mapDocument,
+                                         TileLayerRenderCache *cache,
+                                         const ReadyFunction &ready)
+    : mLayer(layer)
+    , mMapDocument(mapDocument)
+    , mCache(cache)
+    , mReady(ready)
+    , mActiveTasks(0)
+{
+    // Leave a core for the user interface
+    mThreadPool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+ProgressiveRenderer::~ProgressiveRenderer()
+{
+    for (const QSharedPointer<RenderRequest> &request : mRequests)
+        request->canceled.storeRelease(1);
+
+    mThreadPool.waitForDone();
+
+    if (mActiveTasks > 0)
+        TilesetManager::instance()->resumeChanges();
+}
+
+/**
+ * Draws the \a exposed area progressively from the cache. Pending chunks
+ * that are no longer \a visible, or were requested for a different zoom
+ * level, are canceled first.
+ *
+ * Returns false when the area could not be drawn progressively.
+ */
+bool ProgressiveRenderer::draw(QPainter *painter,
+                               const QRectF &exposed,
+                               const QRectF &visible)
+{
+    cancelStale(painter->worldTransform().m11(), visible);
+
+    return mCache->drawProgressive(painter, exposed,
+                                   [this] (const TileLayerRenderCache::ChunkRequest &chunk) {
+        request(chunk);
+    });
+}
+
+/**
+ * Makes sure the next requests render the current state of the layer.
+ * Requests that are in progress are outdated as well, but these have
+ * already been dropped by invalidating the cache.
+ */
+void ProgressiveRenderer::invalidateSnapshot()
+{
+    mSnapshot = TileLayerRenderCache::RenderFunction();
+}
+
+void ProgressiveRenderer::taskFinished()
+{
+    chunksRendered();
+
+    if (--mActiveTasks == 0)
+        TilesetManager::instance()->resumeChanges();
+}
+
+void ProgressiveRenderer::chunksRendered()
+{
+    auto it = mRequests.begin();
+    while (it != mRequests.end()) {
+        const RenderRequest &request = **it;
+        if (!request.finished.loadAcquire()) {
+            ++it;
+            continue;
+        }
+
+        if (mCache->insertChunk(request.chunk, request.image))
+            mReady(request.chunk.rect);
+
+        it = mRequests.erase(it);
+    }
+}
+
+void ProgressiveRenderer::request(const TileLayerRenderCache::ChunkRequest &chunk)
+{
+    if (!mSnapshot)
+        mSnapshot = createSnapshot();
+
+    QSharedPointer<RenderRequest> request(new RenderRequest);
+    request->chunk = chunk;
+    request->render = mSnapshot;
+
+    if (mActiveTasks++ == 0)
+        TilesetManager::instance()->suspendChanges();
+
+    mRequests.append(request);
+    mThreadPool.start(new RenderTask(this, request));
+}
+
+void ProgressiveRenderer::cancelStale(qreal scale, const QRectF &visible)
+{
+    auto it = mRequests.begin();
+    while (it != mRequests.end()) {
+        RenderRequest &request = **it;
+        if (request.chunk.scale == scale && request.chunk.rect.intersects(visible)) {
+            ++it;
+            continue;
+        }
+
+        // The chunk is requested again when it gets exposed
+        request.canceled.storeRelease(1);
+        mCache->cancelRequest(request.chunk);
+        it = mRequests.erase(it);
+    }
+}
+
+TileLayerRenderCache::RenderFunction ProgressiveRenderer::createSnapshot() const
+{
+    QSharedPointer<const LayerSnapshot> snapshot(
+                new LayerSnapshot(mLayer, mMapDocument->renderer()));
+
+    return [snapshot] (QPainter *painter, const QRectF &rect) {
+        snapshot->render(painter, rect);
+    };
+}
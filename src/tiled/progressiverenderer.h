@@ -0,0 +1,96 @@
+/*
+ * progressiverenderer.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROGRESSIVERENDERER_H
+#define PROGRESSIVERENDERER_H
+
+#include "tilelayerrendercache.h"
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+
+#include <functional>
+
+namespace Tiled {
+
+class TileLayer;
+
+namespace Internal {
+
+class MapDocument;
+struct RenderRequest;
+
+/**
+ * Renders the chunks of a tile layer on background threads, for drawing the
+ * layer progressively from its render cache.
+ *
+ * The chunks are rendered from a snapshot of the layer, which is taken on
+ * the first request after the layer changed. Rendered chunks are inserted
+ * into the cache, after which the area they cover is passed to the ready
+ * function so that it can be repainted.
+ *
+ * The snapshot still shares its tilesets with the map. Their images are
+ * prepared when taking the snapshot, and changes to the tilesets by the
+ * TilesetManager are suspended while chunks are being rendered.
+ */
+class ProgressiveRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void (const QRectF &rect)> ReadyFunction;
+
+    ProgressiveRenderer(TileLayer *layer,
+                        MapDocument *mapDocument,
+                        TileLayerRenderCache *cache,
+                        const ReadyFunction &ready);
+    ~ProgressiveRenderer();
+
+    bool draw(QPainter *painter, const QRectF &exposed, const QRectF &visible);
+
+    void invalidateSnapshot();
+
+private slots:
+    void taskFinished();
+
+private:
+    void chunksRendered();
+    void request(const TileLayerRenderCache::ChunkRequest &chunk);
+    void cancelStale(qreal scale, const QRectF &visible);
+
+    TileLayerRenderCache::RenderFunction createSnapshot() const;
+
+    TileLayer *mLayer;
+    MapDocument *mMapDocument;
+    TileLayerRenderCache *mCache;
+    ReadyFunction mReady;
+
+    TileLayerRenderCache::RenderFunction mSnapshot;
+    QVector<QSharedPointer<RenderRequest>> mRequests;
+    int mActiveTasks;
+    QThreadPool mThreadPool;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // PROGRESSIVERENDERER_H
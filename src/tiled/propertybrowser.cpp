@@ -25,9 +25,11 @@
 #include "changeimagelayerproperties.h"
 #include "changemapobject.h"
 #include "changemapproperty.h"
+#include "changenotifier.h"
 #include "changeobjectgroupproperties.h"
 #include "changeproperties.h"
 #include "changetileprobability.h"
+#include "compression.h"
 #include "flipmapobjects.h"
 #include "imagelayer.h"
 #include "map.h"
@@ -53,9 +55,16 @@
 
 #include <QCoreApplication>
 
+#include <algorithm>
+
 namespace Tiled {
 namespace Internal {
 
+static const QStringList &objectTypeNames()
+{
+    return Preferences::instance()->objectTypeNames();
+}
+
 PropertyBrowser::PropertyBrowser(QWidget *parent)
     : QtTreePropertyBrowser(parent)
     , mUpdating(false)
@@ -64,6 +73,7 @@ PropertyBrowser::PropertyBrowser(QWidget *parent)
     , mVariantManager(new VariantPropertyManager(this))
     , mGroupManager(new QtGroupPropertyManager(this))
     , mCustomPropertiesGroup(nullptr)
+    , mPropertiesKind(-1)
 {
     setFactoryForManager(mVariantManager, new VariantEditorFactory(this));
     setResizeMode(ResizeToContents);
@@ -81,11 +91,20 @@ PropertyBrowser::PropertyBrowser(QWidget *parent)
     mOrientationNames.append(QCoreApplication::translate("Tiled::Internal::NewMapDialog", "Isometric (Staggered)"));
     mOrientationNames.append(QCoreApplication::translate("Tiled::Internal::NewMapDialog", "Hexagonal (Staggered)"));
 
-    mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "XML"));
-    mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "Base64 (uncompressed)"));
-    mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "Base64 (gzip compressed)"));
-    mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "Base64 (zlib compressed)"));
-    mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", "CSV"));
+    auto addLayerFormat = [this] (Map::LayerDataFormat format, const char *name) {
+        mLayerFormatNames.append(QCoreApplication::translate("PreferencesDialog", name));
+        mLayerFormatValues.append(format);
+    };
+
+    addLayerFormat(Map::XML, QT_TRANSLATE_NOOP("PreferencesDialog", "XML"));
+    addLayerFormat(Map::Base64, QT_TRANSLATE_NOOP("PreferencesDialog", "Base64 (uncompressed)"));
+    addLayerFormat(Map::Base64Gzip, QT_TRANSLATE_NOOP("PreferencesDialog", "Base64 (gzip compressed)"));
+    addLayerFormat(Map::Base64Zlib, QT_TRANSLATE_NOOP("PreferencesDialog", "Base64 (zlib compressed)"));
+    addLayerFormat(Map::CSV, QT_TRANSLATE_NOOP("PreferencesDialog", "CSV"));
+    if (compressionSupported(Zstandard))
+        addLayerFormat(Map::Base64Zstandard, QT_TRANSLATE_NOOP("PreferencesDialog", "Base64 (Zstandard compressed)"));
+    if (compressionSupported(Lz4))
+        addLayerFormat(Map::Base64Lz4, QT_TRANSLATE_NOOP("PreferencesDialog", "Base64 (LZ4 compressed)"));
 
     mRenderOrderNames.append(QCoreApplication::translate("PreferencesDialog", "Right Down"));
     mRenderOrderNames.append(QCoreApplication::translate("PreferencesDialog", "Right Up"));
@@ -100,6 +119,35 @@ PropertyBrowser::PropertyBrowser(QWidget *parent)
 
     connect(mVariantManager, SIGNAL(valueChanged(QtProperty*,QVariant)),
             SLOT(valueChanged(QtProperty*,QVariant)));
+
+    mUpdateTimer.setSingleShot(true);
+    connect(&mUpdateTimer, SIGNAL(timeout()),
+            SLOT(delayedUpdateProperties()));
+}
+
+/**
+ * Returns a number identifying the set of built-in properties displayed for
+ * the given \a object. Objects of the same kind share their properties.
+ */
+static int propertiesKind(const Object *object)
+{
+    int variant = 0;
+
+    switch (object->typeId()) {
+    case Object::MapObjectType:
+        variant = static_cast<const MapObject*>(object)->cell().isEmpty() ? 0 : 1;
+        break;
+    case Object::LayerType:
+        variant = static_cast<const Layer*>(object)->layerType();
+        break;
+    case Object::TilesetType:
+        variant = static_cast<const Tileset*>(object)->imageSource().isEmpty() ? 0 : 1;
+        break;
+    default:
+        break;
+    }
+
+    return object->typeId() * 16 + variant;
 }
 
 void PropertyBrowser::setObject(Object *object)
@@ -107,6 +155,22 @@ void PropertyBrowser::setObject(Object *object)
     if (mObject == object)
         return;
 
+    mUpdateTimer.stop();
+
+    // Only update the values when the same properties are displayed, since
+    // recreating the properties and their widgets is expensive
+    if (mObject && object && propertiesKind(object) == mPropertiesKind) {
+        mObject = object;
+
+        if (QtVariantProperty *typeProperty = mIdToProperty.value(TypeProperty))
+            if (object->typeId() == Object::MapObjectType)
+                typeProperty->setAttribute(QLatin1String("suggestions"), objectTypeNames());
+
+        updateProperties();
+        updateCustomProperties();
+        return;
+    }
+
     removeProperties();
     mObject = object;
 
@@ -121,6 +185,7 @@ void PropertyBrowser::setMapDocument(MapDocument *mapDocument)
     if (mMapDocument) {
         mMapDocument->disconnect(this);
         mMapDocument->terrainModel()->disconnect(this);
+        mMapDocument->changeNotifier()->disconnect(this);
     }
 
     mMapDocument = mapDocument;
@@ -128,6 +193,8 @@ void PropertyBrowser::setMapDocument(MapDocument *mapDocument)
     if (mapDocument) {
         connect(mapDocument, SIGNAL(mapChanged()),
                 SLOT(mapChanged()));
+        connect(mapDocument, SIGNAL(mapPropertyChanged()),
+                SLOT(mapChanged()));
         connect(mapDocument, SIGNAL(objectsChanged(QList<MapObject*>)),
                 SLOT(objectsChanged(QList<MapObject*>)));
         connect(mapDocument, SIGNAL(layerChanged(int)),
@@ -158,7 +225,7 @@ void PropertyBrowser::setMapDocument(MapDocument *mapDocument)
                 SLOT(propertyChanged(Object*,QString)));
         connect(mapDocument, SIGNAL(propertiesChanged(Object*)),
                 SLOT(propertiesChanged(Object*)));
-        connect(mapDocument, SIGNAL(selectedObjectsChanged()),
+        connect(mapDocument->changeNotifier(), SIGNAL(selectedObjectsChanged()),
                 SLOT(selectedObjectsChanged()));
         connect(mapDocument, SIGNAL(selectedTilesChanged()),
                 SLOT(selectedTilesChanged()));
@@ -199,13 +266,13 @@ void PropertyBrowser::objectsChanged(const QList<MapObject *> &objects)
 {
     if (mObject && mObject->typeId() == Object::MapObjectType)
         if (objects.contains(static_cast<MapObject*>(mObject)))
-            updateProperties();
+            scheduleUpdateProperties();
 }
 
 void PropertyBrowser::layerChanged(int index)
 {
     if (mObject == mMapDocument->map()->layerAt(index))
-        updateProperties();
+        scheduleUpdateProperties();
 }
 
 void PropertyBrowser::objectGroupChanged(ObjectGroup *objectGroup)
@@ -217,7 +284,7 @@ void PropertyBrowser::objectGroupChanged(ObjectGroup *objectGroup)
 void PropertyBrowser::imageLayerChanged(ImageLayer *imageLayer)
 {
     if (mObject == imageLayer)
-        updateProperties();
+        scheduleUpdateProperties();
 }
 
 void PropertyBrowser::tilesetChanged(Tileset *tileset)
@@ -317,6 +384,12 @@ void PropertyBrowser::selectedTilesChanged()
     updateCustomProperties();
 }
 
+void PropertyBrowser::delayedUpdateProperties()
+{
+    if (mObject)
+        updateProperties();
+}
+
 void PropertyBrowser::valueChanged(QtProperty *property, const QVariant &val)
 {
     if (mUpdating)
@@ -361,6 +434,7 @@ void PropertyBrowser::addMapProperties()
 
     createProperty(WidthProperty, QVariant::Int, tr("Width"), groupProperty)->setEnabled(false);
     createProperty(HeightProperty, QVariant::Int, tr("Height"), groupProperty)->setEnabled(false);
+    createProperty(InfiniteProperty, QVariant::Bool, tr("Infinite"), groupProperty)->setEnabled(false);
     createProperty(TileWidthProperty, QVariant::Int, tr("Tile Width"), groupProperty);
     createProperty(TileHeightProperty, QVariant::Int, tr("Tile Height"), groupProperty);
 
@@ -402,14 +476,6 @@ void PropertyBrowser::addMapProperties()
     addProperty(groupProperty);
 }
 
-static QStringList objectTypeNames()
-{
-    QStringList names;
-    for (const ObjectType &type : Preferences::instance()->objectTypes())
-        names.append(type.name);
-    return names;
-}
-
 void PropertyBrowser::addMapObjectProperties()
 {
     QtProperty *groupProperty = mGroupManager->addProperty(tr("Object"));
@@ -579,7 +645,7 @@ void PropertyBrowser::applyMapValue(PropertyId id, const QVariant &val)
         break;
     }
     case LayerFormatProperty: {
-        Map::LayerDataFormat format = static_cast<Map::LayerDataFormat>(val.toInt());
+        Map::LayerDataFormat format = mLayerFormatValues.value(val.toInt());
         command = new ChangeMapProperty(mMapDocument, format);
         break;
     }
@@ -911,6 +977,7 @@ void PropertyBrowser::addProperties()
     mCustomPropertiesGroup = mGroupManager->addProperty(tr("Custom Properties"));
     addProperty(mCustomPropertiesGroup);
 
+    mPropertiesKind = propertiesKind(mObject);
     mUpdating = false;
 
     updateProperties();
@@ -919,12 +986,24 @@ void PropertyBrowser::addProperties()
 
 void PropertyBrowser::removeProperties()
 {
+    mUpdateTimer.stop();
     mVariantManager->clear();
     mGroupManager->clear();
     mPropertyToId.clear();
     mIdToProperty.clear();
     mNameToProperty.clear();
     mCustomPropertiesGroup = nullptr;
+    mPropertiesKind = -1;
+}
+
+/**
+ * Updates the values of the built-in properties at most once per frame, since
+ * the object may be changing continuously, for example while it is dragged.
+ */
+void PropertyBrowser::scheduleUpdateProperties()
+{
+    if (!mUpdateTimer.isActive())
+        mUpdateTimer.start(16);
 }
 
 void PropertyBrowser::updateProperties()
@@ -936,13 +1015,14 @@ void PropertyBrowser::updateProperties()
         const Map *map = static_cast<const Map*>(mObject);
         mIdToProperty[WidthProperty]->setValue(map->width());
         mIdToProperty[HeightProperty]->setValue(map->height());
+        mIdToProperty[InfiniteProperty]->setValue(map->infinite());
         mIdToProperty[TileWidthProperty]->setValue(map->tileWidth());
         mIdToProperty[TileHeightProperty]->setValue(map->tileHeight());
         mIdToProperty[OrientationProperty]->setValue(map->orientation() - 1);
         mIdToProperty[HexSideLengthProperty]->setValue(map->hexSideLength());
         mIdToProperty[StaggerAxisProperty]->setValue(map->staggerAxis());
         mIdToProperty[StaggerIndexProperty]->setValue(map->staggerIndex());
-        mIdToProperty[LayerFormatProperty]->setValue(map->layerDataFormat());
+        mIdToProperty[LayerFormatProperty]->setValue(mLayerFormatValues.indexOf(map->layerDataFormat()));
         mIdToProperty[RenderOrderProperty]->setValue(map->renderOrder());
         QColor backgroundColor = map->backgroundColor();
         if (!backgroundColor.isValid())
@@ -1041,9 +1121,6 @@ void PropertyBrowser::updateCustomProperties()
 
     mUpdating = true;
 
-    qDeleteAll(mNameToProperty);
-    mNameToProperty.clear();
-
     mCombinedProperties = mObject->properties();
     // Add properties from selected objects which mObject does not contain to mCombinedProperties.
     for (Object *obj : mMapDocument->currentObjects()) {
@@ -1061,6 +1138,29 @@ void PropertyBrowser::updateCustomProperties()
 
     QMapIterator<QString,QString> it(mCombinedProperties);
 
+    // When the same custom properties are displayed, only update their values
+    QStringList names = mNameToProperty.keys();
+    std::sort(names.begin(), names.end());
+
+    if (names == mCombinedProperties.keys()) {
+        while (it.hasNext()) {
+            it.next();
+            QtVariantProperty *property = mNameToProperty.value(it.key());
+            property->setValue(it.value());
+            property->setNameColor(Qt::black);
+            property->setValueColor(Qt::black);
+            updatePropertyColor(it.key());
+        }
+
+        mUpdating = false;
+        return;
+    }
+
+    for (QtVariantProperty *property : mNameToProperty)
+        mPropertyToId.remove(property);
+    qDeleteAll(mNameToProperty);
+    mNameToProperty.clear();
+
     while (it.hasNext()) {
         it.next();
         QtVariantProperty *property = createProperty(CustomProperty,
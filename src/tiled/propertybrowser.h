@@ -22,9 +22,11 @@
 #define PROPERTYBROWSER_H
 
 #include <QHash>
+#include <QTimer>
 #include <QUndoCommand>
 
 #include <QtTreePropertyBrowser>
+#include "map.h"
 #include "properties.h"
 
 class QtGroupPropertyManager;
@@ -100,6 +102,7 @@ private slots:
     void selectedObjectsChanged();
     void selectedTilesChanged();
 
+    void delayedUpdateProperties();
     void valueChanged(QtProperty *property, const QVariant &val);
 
 private:
@@ -118,6 +121,7 @@ private:
         ColorProperty,
         TileWidthProperty,
         TileHeightProperty,
+        InfiniteProperty,
         OrientationProperty,
         HexSideLengthProperty,
         StaggerAxisProperty,
@@ -164,6 +168,7 @@ private:
 
     void addProperties();
     void removeProperties();
+    void scheduleUpdateProperties();
     void updateProperties();
     void updateCustomProperties();
     void retranslateUi();
@@ -177,6 +182,8 @@ private:
     QtVariantPropertyManager *mVariantManager;
     QtGroupPropertyManager *mGroupManager;
     QtProperty *mCustomPropertiesGroup;
+    int mPropertiesKind;
+    QTimer mUpdateTimer;
 
     QHash<QtProperty *, PropertyId> mPropertyToId;
     QHash<PropertyId, QtVariantProperty *> mIdToProperty;
@@ -188,6 +195,7 @@ private:
     QStringList mStaggerIndexNames;
     QStringList mOrientationNames;
     QStringList mLayerFormatNames;
+    QList<Map::LayerDataFormat> mLayerFormatValues;
     QStringList mRenderOrderNames;
     QStringList mFlippingFlagNames;
     QStringList mDrawOrderNames;
@@ -21,14 +21,71 @@
 #ifndef TILED_INTERNAL_RANDOMPICKER_H
 #define TILED_INTERNAL_RANDOMPICKER_H
 
-#include <QMap>
+#include <QVector>
+
+#include <cstdlib>
 
 namespace Tiled {
 namespace Internal {
 
+/**
+ * A small and fast pseudo random number generator (xorshift64*). The same
+ * seed always produces the same sequence of numbers.
+ */
+class RandomGenerator
+{
+public:
+    explicit RandomGenerator(quint64 seed = defaultSeed())
+    {
+        setSeed(seed);
+    }
+
+    void setSeed(quint64 seed)
+    {
+        // A zero state would only ever produce zeroes
+        mState = seed ? seed : Q_UINT64_C(0x9E3779B97F4A7C15);
+    }
+
+    quint64 next()
+    {
+        mState ^= mState >> 12;
+        mState ^= mState << 25;
+        mState ^= mState >> 27;
+        return mState * Q_UINT64_C(0x2545F4914F6CDD1D);
+    }
+
+    /**
+     * Returns a random number in the range [0, \a bound).
+     */
+    int bounded(int bound)
+    {
+        return int(((next() >> 32) * quint64(bound)) >> 32);
+    }
+
+    /**
+     * Returns a seed derived from rand(), so that unseeded generators still
+     * follow qsrand().
+     */
+    static quint64 defaultSeed()
+    {
+        return (quint64(rand()) << 32) ^ (quint64(rand()) << 16) ^ quint64(rand());
+    }
+
+private:
+    quint64 mState;
+};
+
 /**
  * A class that helps pick random things that each have a probability
  * assigned.
+ *
+ * Picking uses an alias table (Vose's method), which is built on the first
+ * pick after values were added. Each pick then takes constant time,
+ * regardless of the number of values.
+ *
+ * The picker has a generator of its own, but can also pick using a given
+ * generator. This allows sharing a picker between several users, which
+ * each keep their own sequence of picks.
  */
 template<typename T>
 class RandomPicker
@@ -36,42 +93,143 @@ class RandomPicker
 public:
     RandomPicker()
         : mSum(0.0)
+        , mTableDirty(false)
     {}
 
     void add(const T &value, qreal probability = 1.0)
     {
         if (probability > 0) {
             mSum += probability;
-            mThresholds.insert(mSum, value);
+            mValues.append(value);
+            mProbabilities.append(probability);
+            mTableDirty = true;
         }
     }
 
     bool isEmpty() const
     {
-        return mThresholds.isEmpty();
+        return mValues.isEmpty();
+    }
+
+    /**
+     * Sets the seed used for picking, which makes the picks reproducible.
+     */
+    void setSeed(quint64 seed)
+    {
+        mGenerator.setSeed(seed);
     }
 
     const T &pick() const
+    {
+        return pick(mGenerator);
+    }
+
+    const T &pick(RandomGenerator &generator) const
     {
         Q_ASSERT(!isEmpty());
 
-        const qreal random = ((qreal)rand() / RAND_MAX) * mSum;
-        const auto it = mThresholds.lowerBound(random);
-        if (it != mThresholds.end())
-            return it.value();
-        else
-            return (mThresholds.end() - 1).value();
+        if (mTableDirty)
+            buildTable();
+
+        return mValues.at(pickIndex(generator));
+    }
+
+    /**
+     * Picks \a count values at once, for filling many cells.
+     */
+    QVector<T> pickN(int count) const
+    {
+        return pickN(count, mGenerator);
+    }
+
+    QVector<T> pickN(int count, RandomGenerator &generator) const
+    {
+        Q_ASSERT(!isEmpty());
+
+        if (mTableDirty)
+            buildTable();
+
+        QVector<T> values;
+        values.reserve(count);
+        for (int i = 0; i < count; ++i)
+            values.append(mValues.at(pickIndex(generator)));
+        return values;
     }
 
     void clear()
     {
         mSum = 0.0;
+        mValues.clear();
+        mProbabilities.clear();
         mThresholds.clear();
+        mAliases.clear();
+        mTableDirty = false;
     }
 
 private:
+    int pickIndex(RandomGenerator &generator) const
+    {
+        // The high bits choose a column and the low bits whether to use the
+        // column's own value or its alias
+        const quint64 random = generator.next();
+        const int index = int(((random >> 32) * quint64(mValues.size())) >> 32);
+        if (quint32(random) < mThresholds.at(index))
+            return index;
+        return mAliases.at(index);
+    }
+
+    void buildTable() const
+    {
+        const int count = mValues.size();
+        const qreal scale = count / mSum;
+
+        mThresholds.fill(0, count);
+        mAliases.resize(count);
+
+        QVector<qreal> scaled(count);
+        QVector<int> small;
+        QVector<int> large;
+
+        for (int i = 0; i < count; ++i) {
+            scaled[i] = mProbabilities.at(i) * scale;
+            mAliases[i] = i;
+            if (scaled.at(i) < 1.0)
+                small.append(i);
+            else
+                large.append(i);
+        }
+
+        while (!small.isEmpty() && !large.isEmpty()) {
+            const int s = small.takeLast();
+            const int l = large.last();
+
+            mThresholds[s] = quint32(scaled.at(s) * 4294967296.0);
+            mAliases[s] = l;
+
+            scaled[l] -= 1.0 - scaled.at(s);
+            if (scaled.at(l) < 1.0) {
+                large.removeLast();
+                small.append(l);
+            }
+        }
+
+        // Whatever remains has a probability of one, up to rounding errors
+        for (int i : large)
+            mThresholds[i] = 0xFFFFFFFF;
+        for (int i : small)
+            mThresholds[i] = 0xFFFFFFFF;
+
+        mTableDirty = false;
+    }
+
     qreal mSum;
-    QMap<qreal, T> mThresholds;
+    QVector<T> mValues;
+    QVector<qreal> mProbabilities;
+
+    mutable QVector<quint32> mThresholds;
+    mutable QVector<int> mAliases;
+    mutable bool mTableDirty;
+    mutable RandomGenerator mGenerator;
 };
 
 } // namespace Internal
@@ -0,0 +1,195 @@
+/*
+ * renderprofiler.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderprofiler.h"
+
+#include "layer.h"
+#include "maprenderer.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegion>
+#include <QSaveFile>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+// The oldest frames are dropped beyond this, to limit memory use
+static const int MaxCapturedFrames = 10000;
+
+RenderProfiler *RenderProfiler::mInstance;
+
+RenderProfiler *RenderProfiler::instance()
+{
+    if (!mInstance)
+        mInstance = new RenderProfiler;
+    return mInstance;
+}
+
+void RenderProfiler::deleteInstance()
+{
+    delete mInstance;
+    mInstance = nullptr;
+}
+
+RenderProfiler::RenderProfiler()
+    : mEnabled(false)
+    , mInFrame(false)
+{
+}
+
+/**
+ * Enabling the profiler starts a new capture.
+ */
+void RenderProfiler::setEnabled(bool enabled)
+{
+    if (mEnabled == enabled)
+        return;
+
+    mEnabled = enabled;
+    mInFrame = false;
+
+    if (enabled) {
+        mFrames.clear();
+        mCaptureTimer.start();
+        CellRenderer::takeStatistics();
+    }
+
+    CellRenderer::setStatisticsEnabled(enabled);
+
+    emit enabledChanged(enabled);
+}
+
+void RenderProfiler::beginFrame(const QRegion &repainted)
+{
+    if (!mEnabled)
+        return;
+
+    mInFrame = true;
+
+    mCurrentFrame = Frame();
+    mCurrentFrame.timestamp = mCaptureTimer.elapsed();
+    mCurrentFrame.itemsPainted = 0;
+    mCurrentFrame.repaintedRects = repainted.rectCount();
+    mCurrentFrame.repaintedArea = 0;
+    for (const QRect &rect : repainted.rects())
+        mCurrentFrame.repaintedArea += qint64(rect.width()) * rect.height();
+
+    // Drop anything that was drawn outside of a frame
+    CellRenderer::takeStatistics();
+
+    mFrameTimer.start();
+}
+
+void RenderProfiler::endFrame()
+{
+    if (!mInFrame)
+        return;
+
+    mInFrame = false;
+    mCurrentFrame.nsecs = mFrameTimer.nsecsElapsed();
+
+    const CellRenderer::Statistics statistics = CellRenderer::takeStatistics();
+    mCurrentFrame.cellRendererFlushes = statistics.flushes;
+    mCurrentFrame.cellRendererFragments = statistics.fragments;
+
+    if (mFrames.size() == MaxCapturedFrames)
+        mFrames.removeFirst();
+    mFrames.append(mCurrentFrame);
+}
+
+void RenderProfiler::addItemTime(const Layer *layer, qint64 nsecs)
+{
+    if (!mInFrame)
+        return;
+
+    ++mCurrentFrame.itemsPainted;
+
+    for (LayerTime &layerTime : mCurrentFrame.layerTimes) {
+        if (layerTime.layer == layer) {
+            ++layerTime.paintCount;
+            layerTime.nsecs += nsecs;
+            return;
+        }
+    }
+
+    LayerTime layerTime;
+    layerTime.layer = layer;
+    layerTime.name = layer ? layer->name() : QString();
+    layerTime.paintCount = 1;
+    layerTime.nsecs = nsecs;
+    mCurrentFrame.layerTimes.append(layerTime);
+}
+
+/**
+ * Saves the frames captured since the profiler was enabled to the given
+ * file, in JSON format. Times are in milliseconds.
+ */
+bool RenderProfiler::saveCapture(const QString &fileName) const
+{
+    QJsonArray frames;
+
+    for (const Frame &frame : mFrames) {
+        QJsonArray layers;
+        for (const LayerTime &layerTime : frame.layerTimes) {
+            QJsonObject layer;
+            layer.insert(QLatin1String("name"), layerTime.name);
+            layer.insert(QLatin1String("paintCount"), layerTime.paintCount);
+            layer.insert(QLatin1String("time"), layerTime.nsecs / 1000000.0);
+            layers.append(layer);
+        }
+
+        QJsonObject object;
+        object.insert(QLatin1String("timestamp"), double(frame.timestamp));
+        object.insert(QLatin1String("frameTime"), frame.nsecs / 1000000.0);
+        object.insert(QLatin1String("itemsPainted"), frame.itemsPainted);
+        object.insert(QLatin1String("cellRendererFlushes"), frame.cellRendererFlushes);
+        object.insert(QLatin1String("cellRendererFragments"), frame.cellRendererFragments);
+        object.insert(QLatin1String("repaintedRects"), frame.repaintedRects);
+        object.insert(QLatin1String("repaintedArea"), double(frame.repaintedArea));
+        object.insert(QLatin1String("layers"), layers);
+        frames.append(object);
+    }
+
+    QJsonObject capture;
+    capture.insert(QLatin1String("frames"), frames);
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(capture).toJson());
+    return file.commit();
+}
+
+
+RenderProfiler::ItemTimer::ItemTimer(const Layer *layer)
+    : mLayer(layer)
+{
+    if (RenderProfiler::instance()->isEnabled())
+        mTimer.start();
+}
+
+RenderProfiler::ItemTimer::~ItemTimer()
+{
+    if (mTimer.isValid())
+        RenderProfiler::instance()->addItemTime(mLayer, mTimer.nsecsElapsed());
+}
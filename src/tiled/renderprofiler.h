@@ -0,0 +1,125 @@
+/*
+ * renderprofiler.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RENDERPROFILER_H
+#define RENDERPROFILER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QVector>
+
+class QRegion;
+
+namespace Tiled {
+
+class Layer;
+
+namespace Internal {
+
+/**
+ * Collects statistics about the painting of the map views, which can be
+ * shown in an overlay on the map view and saved to a file.
+ *
+ * A frame is a single paint event of a map view. While the profiler is
+ * enabled, the layer items report the time they spend painting with an
+ * ItemTimer.
+ */
+class RenderProfiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct LayerTime {
+        const Layer *layer;     // only used to match up items of a frame
+        QString name;
+        int paintCount;
+        qint64 nsecs;
+    };
+
+    struct Frame {
+        qint64 timestamp;       // milliseconds since the capture started
+        qint64 nsecs;
+        int itemsPainted;
+        int cellRendererFlushes;
+        int cellRendererFragments;
+        int repaintedRects;
+        qint64 repaintedArea;   // in pixels of the viewport
+        QVector<LayerTime> layerTimes;
+    };
+
+    /**
+     * Measures the time spent painting an item of the given layer, for as
+     * long as it exists. Does nothing while the profiler is disabled.
+     */
+    class ItemTimer
+    {
+    public:
+        explicit ItemTimer(const Layer *layer);
+        ~ItemTimer();
+
+    private:
+        Q_DISABLE_COPY(ItemTimer)
+
+        const Layer *mLayer;
+        QElapsedTimer mTimer;
+    };
+
+    static RenderProfiler *instance();
+    static void deleteInstance();
+
+    bool isEnabled() const { return mEnabled; }
+
+    void beginFrame(const QRegion &repainted);
+    void endFrame();
+
+    /**
+     * Returns the last frame that was captured. Only valid when
+     * frameCount() is larger than 0.
+     */
+    const Frame &lastFrame() const { return mFrames.last(); }
+    int frameCount() const { return mFrames.size(); }
+
+    bool saveCapture(const QString &fileName) const;
+
+public slots:
+    void setEnabled(bool enabled);
+
+signals:
+    void enabledChanged(bool enabled);
+
+private:
+    RenderProfiler();
+
+    void addItemTime(const Layer *layer, qint64 nsecs);
+
+    static RenderProfiler *mInstance;
+
+    bool mEnabled;
+    bool mInFrame;
+    QElapsedTimer mCaptureTimer;
+    QElapsedTimer mFrameTimer;
+    Frame mCurrentFrame;
+    QVector<Frame> mFrames;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // RENDERPROFILER_H
@@ -56,6 +56,7 @@ ResizeTileLayer::~ResizeTileLayer()
 void ResizeTileLayer::undo()
 {
     Q_ASSERT(!mResizedLayer);
+    mCompressedCells.decompress(mOriginalLayer);
     mResizedLayer = static_cast<TileLayer*>(swapLayer(mOriginalLayer));
     mOriginalLayer = nullptr;
 }
@@ -63,10 +64,22 @@ void ResizeTileLayer::undo()
 void ResizeTileLayer::redo()
 {
     Q_ASSERT(!mOriginalLayer);
+    mCompressedCells.decompress(mResizedLayer);
     mOriginalLayer = static_cast<TileLayer*>(swapLayer(mResizedLayer));
     mResizedLayer = nullptr;
 }
 
+qint64 ResizeTileLayer::memoryUsage() const
+{
+    const TileLayer *layer = mOriginalLayer ? mOriginalLayer : mResizedLayer;
+    return Internal::memoryUsage(layer) + mCompressedCells.memoryUsage();
+}
+
+void ResizeTileLayer::compress()
+{
+    mCompressedCells.compress(mOriginalLayer ? mOriginalLayer : mResizedLayer);
+}
+
 Layer *ResizeTileLayer::swapLayer(Layer *layer)
 {
     const int currentIndex = mMapDocument->currentLayerIndex();
@@ -21,6 +21,8 @@
 #ifndef RESIZELAYER_H
 #define RESIZELAYER_H
 
+#include "undomemory.h"
+
 #include <QPoint>
 #include <QSize>
 #include <QUndoCommand>
@@ -37,7 +39,7 @@ class MapDocument;
 /**
  * Undo command that resizes a map layer.
  */
-class ResizeTileLayer : public QUndoCommand
+class ResizeTileLayer : public QUndoCommand, public UndoCommandMemory
 {
 public:
     /**
@@ -54,6 +56,9 @@ public:
     void undo() override;
     void redo() override;
 
+    qint64 memoryUsage() const override;
+    void compress() override;
+
 private:
     Layer *swapLayer(Layer *layer);
 
@@ -61,6 +66,9 @@ private:
     int mIndex;
     TileLayer *mOriginalLayer;
     TileLayer *mResizedLayer;
+
+    // The cells of the layer that is currently not part of the map
+    CompressedCells mCompressedCells;
 };
 
 } // namespace Internal
@@ -21,8 +21,10 @@
 #include "selectsametiletool.h"
 
 #include "brushitem.h"
+#include "map.h"
 #include "mapdocument.h"
 #include "changeselectedarea.h"
+#include "tilepainter.h"
 
 #include <QApplication>
 
@@ -35,6 +37,7 @@ SelectSameTileTool::SelectSameTileTool(QObject *parent)
                                ":images/22x22/stock-tool-by-color-select.png")),
                        QKeySequence(tr("S")),
                        parent)
+    , mAllLayers(false)
 {
 }
 
@@ -45,13 +48,15 @@ void SelectSameTileTool::tilePositionChanged(const QPoint &tilePos)
     if (!tileLayer)
         return;
 
-    QRegion resultRegion;
-    if (tileLayer->contains(tilePos)) {
+    TileMask resultMask;
+    if (mAllLayers) {
+        resultMask = TilePainter::computeMatchMask(matchLayers(), tilePos);
+    } else if (tileLayer->contains(tilePos)) {
         const Cell &matchCell = tileLayer->cellAt(tilePos);
-        resultRegion = tileLayer->region([&] (const Cell &cell) { return cell == matchCell; });
+        resultMask = tileLayer->cellMask(matchCell);
     }
-    mSelectedRegion = resultRegion;
-    brushItem()->setTileRegion(mSelectedRegion);
+    mSelectedMask = resultMask;
+    brushItem()->setTileRegion(mSelectedMask.toRegion());
 }
 
 void SelectSameTileTool::mousePressed(QGraphicsSceneMouseEvent *event)
@@ -63,16 +68,20 @@ void SelectSameTileTool::mousePressed(QGraphicsSceneMouseEvent *event)
 
     MapDocument *document = mapDocument();
 
-    QRegion selection = document->selectedArea();
+    // Combine the selections as masks, since QRegion operations get slow
+    // on fragmented regions
+    TileMask selectionMask(document->selectedArea());
 
     if (modifiers == Qt::ShiftModifier)
-        selection += mSelectedRegion;
+        selectionMask += mSelectedMask;
     else if (modifiers == Qt::ControlModifier)
-        selection -= mSelectedRegion;
+        selectionMask -= mSelectedMask;
     else if (modifiers == (Qt::ControlModifier | Qt::ShiftModifier))
-        selection &= mSelectedRegion;
+        selectionMask &= mSelectedMask;
     else
-        selection = mSelectedRegion;
+        selectionMask = mSelectedMask;
+
+    const QRegion selection = selectionMask.toRegion();
 
     if (selection != document->selectedArea()) {
         QUndoCommand *cmd = new ChangeSelectedArea(document, selection);
@@ -89,3 +98,27 @@ void SelectSameTileTool::languageChanged()
     setName(tr("Select Same Tile"));
     setShortcut(QKeySequence(tr("S")));
 }
+
+/**
+ * Sets whether positions are matched by the cells of all visible tile
+ * layers, instead of only by those of the current layer.
+ */
+void SelectSameTileTool::setAllLayers(bool value)
+{
+    if (mAllLayers == value)
+        return;
+
+    mAllLayers = value;
+
+    if (mapDocument() && currentTileLayer())
+        tilePositionChanged(tilePosition());
+}
+
+QList<TileLayer*> SelectSameTileTool::matchLayers() const
+{
+    QList<TileLayer*> layers;
+    for (TileLayer *layer : mapDocument()->map()->tileLayers())
+        if (layer->isVisible())
+            layers.append(layer);
+    return layers;
+}
@@ -34,6 +34,8 @@ class MapDocument;
 
 /**
  * Implements a tool that selects a region with all similar tiles on the layer.
+ * When matching all layers, the tiles need to be similar on each visible tile
+ * layer.
  */
 class SelectSameTileTool : public AbstractTileTool
 {
@@ -47,12 +49,17 @@ public:
 
     void languageChanged() override;
 
+public slots:
+    void setAllLayers(bool value);
+
 protected:
     void tilePositionChanged(const QPoint &tilePos) override;
 
 private:
+    QList<TileLayer*> matchLayers() const;
 
-    QRegion mSelectedRegion;
+    TileMask mSelectedMask;
+    bool mAllLayers;
 };
 
 } // namespace Internal
@@ -58,5 +58,49 @@ void SnapHelper::snap(QPointF &pixelPos) const
     }
 }
 
+/**
+ * Returns the given \a screenOffset adjusted such that the position
+ * \a alignPixelPos, when moved by the offset, snaps to the grid.
+ */
+QPointF SnapHelper::snapScreenOffset(const QPointF &alignPixelPos,
+                                     const QPointF &screenOffset) const
+{
+    if (!snaps())
+        return screenOffset;
+
+    const QPointF alignScreenPos = mRenderer->pixelToScreenCoords(alignPixelPos);
+
+    QPointF newAlignPixelPos = mRenderer->screenToPixelCoords(alignScreenPos + screenOffset);
+    snap(newAlignPixelPos);
+
+    return mRenderer->pixelToScreenCoords(newAlignPixelPos) - alignScreenPos;
+}
+
+/**
+ * Moves all \a pixelPositions by the given \a screenOffset, snapping the
+ * offset such that \a alignPixelPos ends up on the grid.
+ *
+ * Since screen and pixel coordinates are related by an affine
+ * transformation for all renderers, the positions all move by the same
+ * pixel offset. This way the offset only needs to be snapped and converted
+ * once, rather than for each position.
+ */
+QVector<QPointF> SnapHelper::movePositions(const QVector<QPointF> &pixelPositions,
+                                           const QPointF &alignPixelPos,
+                                           const QPointF &screenOffset) const
+{
+    const QPointF alignScreenPos = mRenderer->pixelToScreenCoords(alignPixelPos);
+    const QPointF newAlignScreenPos = alignScreenPos +
+            snapScreenOffset(alignPixelPos, screenOffset);
+    const QPointF pixelOffset =
+            mRenderer->screenToPixelCoords(newAlignScreenPos) - alignPixelPos;
+
+    QVector<QPointF> newPositions(pixelPositions.size());
+    for (int i = 0; i < pixelPositions.size(); ++i)
+        newPositions[i] = pixelPositions.at(i) + pixelOffset;
+
+    return newPositions;
+}
+
 } // namespace Internal
 } // namespace Tiled
@@ -23,6 +23,8 @@
 
 #include "maprenderer.h"
 
+#include <QVector>
+
 namespace Tiled {
 namespace Internal {
 
@@ -37,6 +39,13 @@ public:
 
     void snap(QPointF &pixelPos) const;
 
+    QPointF snapScreenOffset(const QPointF &alignPixelPos,
+                             const QPointF &screenOffset) const;
+
+    QVector<QPointF> movePositions(const QVector<QPointF> &pixelPositions,
+                                   const QPointF &alignPixelPos,
+                                   const QPointF &screenOffset) const;
+
 private:
     const MapRenderer *mRenderer;
     bool mSnapToGrid;
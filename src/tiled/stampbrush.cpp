@@ -28,10 +28,14 @@
 #include "mapdocument.h"
 #include "mapscene.h"
 #include "painttilelayer.h"
+#include "randompicker.h"
 #include "tile.h"
 #include "tilestamp.h"
 
 #include <math.h>
+#include <QBitArray>
+#include <QHash>
+#include <QPair>
 #include <QVector>
 
 using namespace Tiled;
@@ -43,6 +47,7 @@ StampBrush::StampBrush(QObject *parent)
                                ":images/22x22/stock-tool-clone.png")),
                        QKeySequence(tr("B")),
                        parent)
+    , mPreviewStamp(nullptr)
     , mBrushBehavior(Free)
     , mIsRandom(false)
 {
@@ -61,12 +66,15 @@ void StampBrush::tilePositionChanged(const QPoint &pos)
         QVector<QPoint> points = pointsOnLine(mPrevTilePosition, pos);
         QRegion editedRegion;
 
+        // Repaint once for the whole line rather than for each piece
+        RegionChangeBatch batch(mapDocument());
+
         for (int i = 1; i < points.size(); ++i) {
             drawPreviewLayer(QVector<QPoint>() << points.at(i));
 
             // Only update the brush item for the last drawn piece
             if (i == points.size() - 1)
-                brushItem()->setTileLayer(mPreviewLayer);
+                updateBrushItem();
 
             editedRegion |= doPaint(Mergeable | SuppressRegionEdited);
         }
@@ -175,36 +183,28 @@ void StampBrush::mapDocumentChanged(MapDocument *oldDocument,
 {
     AbstractTileTool::mapDocumentChanged(oldDocument, newDocument);
 
+    mPreviewPoints.clear();
+    mPreviewVariations.clear();
+
     if (newDocument) {
-        updateRandomList();
+        updateMissingTilesets();
         updatePreview();
     }
 }
 
 /**
- * Updates the list used random stamps.
- * This is done by taking all non-null tiles from the original stamp mStamp.
+ * Updates the list of tilesets used by a random stamp that are not part of
+ * the map yet. Otherwise this is done while updating the preview.
  */
-void StampBrush::updateRandomList()
+void StampBrush::updateMissingTilesets()
 {
-    mRandomCellPicker.clear();
-
     if (!mIsRandom)
         return;
 
     mMissingTilesets.clear();
 
-    for (const TileStampVariation &variation : mStamp.variations()) {
+    for (const TileStampVariation &variation : mStamp.variations())
         mapDocument()->unifyTilesets(variation.map, mMissingTilesets);
-        TileLayer *tileLayer = variation.tileLayer();
-        for (int x = 0; x < tileLayer->width(); x++) {
-            for (int y = 0; y < tileLayer->height(); y++) {
-                const Cell &cell = tileLayer->cellAt(x, y);
-                if (!cell.isEmpty())
-                    mRandomCellPicker.add(cell, cell.tile->probability());
-            }
-        }
-    }
 }
 
 void StampBrush::setStamp(const TileStamp &stamp)
@@ -213,8 +213,10 @@ void StampBrush::setStamp(const TileStamp &stamp)
         return;
 
     mStamp = stamp;
+    mPreviewPoints.clear();
+    mPreviewVariations.clear();
 
-    updateRandomList();
+    updateMissingTilesets();
     updatePreview();
 }
 
@@ -306,10 +308,11 @@ QRegion StampBrush::doPaint(int flags)
     TileLayer *tileLayer = currentTileLayer();
     Q_ASSERT(tileLayer);
 
-    if (!tileLayer->bounds().intersects(QRect(preview->x(),
-                                              preview->y(),
-                                              preview->width(),
-                                              preview->height())))
+    if (!tileLayer->isInfinite() &&
+            !tileLayer->bounds().intersects(QRect(preview->x(),
+                                                  preview->y(),
+                                                  preview->width(),
+                                                  preview->height())))
         return QRegion();
 
     PaintTileLayer *paint = new PaintTileLayer(mapDocument(),
@@ -334,11 +337,6 @@ QRegion StampBrush::doPaint(int flags)
     return editedRegion;
 }
 
-struct PaintOperation {
-    QPoint pos;
-    TileLayer *stamp;
-};
-
 /**
  * Draws the preview layer.
  * It tries to put at all given points a stamp of the current stamp at the
@@ -349,13 +347,32 @@ struct PaintOperation {
  */
 void StampBrush::drawPreviewLayer(const QVector<QPoint> &list)
 {
-    mPreviewLayer.clear();
-
-    if (mStamp.isEmpty())
+    if (mStamp.isEmpty()) {
+        mPreviewLayer.clear();
         return;
+    }
+
+    // The variation picked for a single stamp, which is also used when the
+    // preview layer can't be reused
+    TileStampVariation picked;
+
+    if (!mIsRandom && list.size() == 1) {
+        picked = mStamp.randomVariation(mapDocument()->randomGenerator());
+        const QVector<SharedTileset> tilesets = picked.map->tilesets();
+
+        mMissingTilesets.clear();
+        mapDocument()->unifyTilesets(picked.map, mMissingTilesets);
+
+        if (movePreviewLayer(picked, tilesets, list.first()))
+            return;
+    }
+
+    mPreviewLayer.clear();
+    mPreviewStamp = nullptr;
 
     if (mIsRandom) {
-        if (mRandomCellPicker.isEmpty())
+        const RandomPicker<Cell> &picker = mStamp.randomCellPicker();
+        if (picker.isEmpty())
             return;
 
         QRegion paintedRegion;
@@ -367,60 +384,169 @@ void StampBrush::drawPreviewLayer(const QVector<QPoint> &list)
                                               bounds.x(), bounds.y(),
                                               bounds.width(), bounds.height()));
 
-        for (const QPoint &p : list) {
-            const Cell &cell = mRandomCellPicker.pick();
+        const QVector<Cell> cells = picker.pickN(list.size(),
+                                                 mapDocument()->randomGenerator());
+        for (int i = 0; i < list.size(); ++i) {
+            const QPoint &p = list.at(i);
             preview->setCell(p.x() - bounds.left(),
                              p.y() - bounds.top(),
-                             cell);
+                             cells.at(i));
         }
 
         mPreviewLayer = preview;
     } else {
         mMissingTilesets.clear();
 
-        QRegion paintedRegion;
-        QVector<PaintOperation> operations;
-        QHash<TileLayer *, QRegion> regionCache;
+        // Whether a stamp is placed at a point only depends on the stamps
+        // placed at the points before it. So the placements for the points
+        // the previous shape started with remain valid.
+        const bool reusable = list.size() > 1;
+        int reused = 0;
+        if (reusable) {
+            const int common = qMin(list.size(), mPreviewPoints.size());
+            while (reused < common && list.at(reused) == mPreviewPoints.at(reused))
+                ++reused;
+        }
+
+        mPreviewVariations.resize(reused);
+        mPreviewVariations.reserve(list.size());
+
+        // Pick the stamp for each new point, to know the bounds in which
+        // stamps may be placed
+        QRect bounds;
+        for (int i = 0; i < list.size(); ++i) {
+            TileStampVariation variation;
+            if (i < reused) {
+                variation = mPreviewVariations.at(i);
+                if (!variation.map)
+                    continue;
+            } else {
+                variation = picked.map ? picked
+                                       : mStamp.randomVariation(mapDocument()->randomGenerator());
+                mPreviewVariations.append(variation);
+            }
 
-        for (const QPoint &p : list) {
-            const TileStampVariation variation = mStamp.randomVariation();
             mapDocument()->unifyTilesets(variation.map, mMissingTilesets);
 
-            TileLayer *stamp = variation.tileLayer();
+            const TileLayer *stamp = variation.tileLayer();
+            bounds |= QRect(list.at(i) - QPoint(stamp->width() / 2,
+                                                stamp->height() / 2),
+                            stamp->size());
+        }
 
-            QRegion stampRegion;
-            if (regionCache.contains(stamp)) {
-                stampRegion = regionCache.value(stamp);
-            } else {
-                stampRegion = stamp->region();
-                regionCache.insert(stamp, stampRegion);
+        // Place the stamps that don't overlap with the ones placed before,
+        // keeping track of the occupied cells
+        QBitArray occupied(bounds.width() * bounds.height());
+        QHash<const TileLayer *, QVector<QRect>> rectsCache;
+        QRect paintedBounds;
+
+        auto stampRects = [&] (const TileLayer *stamp) -> const QVector<QRect> & {
+            auto it = rectsCache.find(stamp);
+            if (it == rectsCache.end())
+                it = rectsCache.insert(stamp, stamp->region().rects());
+            return it.value();
+        };
+
+        auto overlaps = [&] (const QVector<QRect> &rects, const QPoint &offset) {
+            for (const QRect &rect : rects) {
+                const QRect r = rect.translated(offset);
+                for (int y = r.top(); y <= r.bottom(); ++y)
+                    for (int x = r.left(); x <= r.right(); ++x)
+                        if (occupied.testBit(y * bounds.width() + x))
+                            return true;
             }
+            return false;
+        };
+
+        auto occupy = [&] (const QVector<QRect> &rects, const QPoint &offset) {
+            for (const QRect &rect : rects) {
+                const QRect r = rect.translated(offset);
+                for (int y = r.top(); y <= r.bottom(); ++y)
+                    occupied.fill(true, y * bounds.width() + r.left(),
+                                  y * bounds.width() + r.right() + 1);
+            }
+        };
+
+        QVector<QPair<QPoint, const TileLayer *>> operations;
 
-            QPoint centered(p.x() - stamp->width() / 2,
-                            p.y() - stamp->height() / 2);
+        for (int i = 0; i < list.size(); ++i) {
+            const TileStampVariation &variation = mPreviewVariations.at(i);
+            if (!variation.map)
+                continue;
 
-            const QRegion region = stampRegion.translated(centered.x(),
-                                                          centered.y());
-            if (!paintedRegion.intersects(region)) {
-                paintedRegion += region;
+            const TileLayer *stamp = variation.tileLayer();
+            const QPoint centered(list.at(i).x() - stamp->width() / 2,
+                                  list.at(i).y() - stamp->height() / 2);
 
-                PaintOperation op = { centered, stamp };
-                operations.append(op);
+            const QVector<QRect> &rects = stampRects(stamp);
+            const QPoint offset = centered - bounds.topLeft();
+
+            if (i >= reused && overlaps(rects, offset)) {
+                mPreviewVariations[i] = TileStampVariation();
+                continue;
             }
+
+            occupy(rects, offset);
+
+            for (const QRect &rect : rects)
+                paintedBounds |= rect.translated(centered);
+
+            operations.append(qMakePair(centered, stamp));
+        }
+
+        if (reusable) {
+            mPreviewPoints = list;
+        } else {
+            mPreviewPoints.clear();
+            mPreviewVariations.clear();
         }
 
-        QRect bounds = paintedRegion.boundingRect();
         SharedTileLayer preview(new TileLayer(QString(),
-                                              bounds.x(), bounds.y(),
-                                              bounds.width(), bounds.height()));
+                                              paintedBounds.x(), paintedBounds.y(),
+                                              paintedBounds.width(), paintedBounds.height()));
 
-        for (const PaintOperation &op : operations)
-            preview->merge(op.pos - bounds.topLeft(), op.stamp);
+        for (const auto &op : operations)
+            preview->merge(op.first - paintedBounds.topLeft(), op.second);
 
         mPreviewLayer = preview;
+
+        if (operations.size() == 1) {
+            mPreviewStamp = operations.first().second;
+            mPreviewStampOffset = paintedBounds.topLeft() - operations.first().first;
+        }
     }
 }
 
+/**
+ * Reuses the preview layer when it shows the stamp of the given
+ * \a variation, by moving it so that the stamp is centered at \a pos.
+ * Returns false when the preview layer needs to be drawn again, including
+ * when unifying the tilesets changed the stamp away from \a tilesets.
+ */
+bool StampBrush::movePreviewLayer(const TileStampVariation &variation,
+                                  const QVector<SharedTileset> &tilesets,
+                                  const QPoint &pos)
+{
+    const TileLayer *stamp = variation.tileLayer();
+    if (!mPreviewLayer || stamp != mPreviewStamp ||
+            variation.map->tilesets() != tilesets)
+        return false;
+
+    const QPoint centered(pos.x() - stamp->width() / 2,
+                          pos.y() - stamp->height() / 2);
+    const QPoint previewPos = centered + mPreviewStampOffset;
+
+    // Move the brush item along when it is showing the preview layer
+    if (brushItem()->tileLayer() == mPreviewLayer) {
+        brushItem()->setTileLayerPosition(previewPos);
+    } else {
+        mPreviewLayer->setX(previewPos.x());
+        mPreviewLayer->setY(previewPos.y());
+    }
+
+    return true;
+}
+
 /**
  * Updates the position of the brush item based on the mouse position.
  */
@@ -467,18 +593,30 @@ void StampBrush::updatePreview(QPoint tilePos)
         }
     }
 
-    brushItem()->setTileLayer(mPreviewLayer);
+    updateBrushItem();
     if (!tileRegion.isEmpty())
         brushItem()->setTileRegion(tileRegion);
 }
 
+/**
+ * Sets the preview layer on the brush item, unless the brush item already
+ * shows it, in which case it was only moved.
+ */
+void StampBrush::updateBrushItem()
+{
+    if (!mPreviewLayer || brushItem()->tileLayer() != mPreviewLayer)
+        brushItem()->setTileLayer(mPreviewLayer);
+}
+
 void StampBrush::setRandom(bool value)
 {
     if (mIsRandom == value)
         return;
 
     mIsRandom = value;
+    mPreviewPoints.clear();
+    mPreviewVariations.clear();
 
-    updateRandomList();
+    updateMissingTilesets();
     updatePreview();
 }
@@ -23,7 +23,6 @@
 #define STAMPBRUSH_H
 
 #include "abstracttiletool.h"
-#include "randompicker.h"
 #include "tilelayer.h"
 #include "tilestamp.h"
 
@@ -102,10 +101,24 @@ private:
     SharedTileLayer mPreviewLayer;
     QVector<SharedTileset> mMissingTilesets;
 
+    // The stamp shown by the preview layer when it shows a single one, and
+    // the offset of the preview layer relative to where the stamp was put
+    const TileLayer *mPreviewStamp;
+    QPoint mPreviewStampOffset;
+
+    // The points of the last line or circle preview and the variation
+    // placed at each of them, with a null map where none was placed
+    QVector<QPoint> mPreviewPoints;
+    QVector<TileStampVariation> mPreviewVariations;
+
     QPoint mCaptureStart;
     QPoint mPrevTilePosition;
 
     void drawPreviewLayer(const QVector<QPoint> &list);
+    bool movePreviewLayer(const TileStampVariation &variation,
+                          const QVector<SharedTileset> &tilesets,
+                          const QPoint &pos);
+    void updateBrushItem();
 
     /**
      * There are several options how the stamp utility can be used.
@@ -136,9 +149,8 @@ private:
     QPoint mStampReference;
 
     bool mIsRandom;
-    RandomPicker<Cell> mRandomCellPicker;
 
-    void updateRandomList();
+    void updateMissingTilesets();
 };
 
 } // namespace Internal
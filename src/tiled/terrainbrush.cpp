@@ -54,6 +54,7 @@ TerrainBrush::TerrainBrush(QObject *parent)
     , mBrushBehavior(Free)
     , mLineReferenceX(0)
     , mLineReferenceY(0)
+    , mCheckMark(0)
 {
     setBrushMode(PaintTile);
 }
@@ -72,6 +73,7 @@ void TerrainBrush::deactivate(MapScene *scene)
 {
     AbstractTileTool::deactivate(scene);
     mIsActive = false;
+    releaseBuffers();
 }
 
 void TerrainBrush::tilePositionChanged(const QPoint &pos)
@@ -80,6 +82,10 @@ void TerrainBrush::tilePositionChanged(const QPoint &pos)
     case Paint: {
         int x = mPaintX;
         int y = mPaintY;
+
+        // Repaint once for the whole line rather than for each piece
+        RegionChangeBatch batch(mapDocument());
+
         foreach (const QPoint &p, pointsOnLine(x, y, pos.x(), pos.y())) {
             updateBrush(p);
             doPaint(true, p.x(), p.y());
@@ -180,11 +186,24 @@ void TerrainBrush::mapDocumentChanged(MapDocument *oldDocument,
 
     // Reset the brush, since it probably became invalid
     brushItem()->clear();
+    releaseBuffers();
 
     // Don't use setTerrain since we do not want to update the brush right now
     mTerrain = firstTerrain(newDocument);
 }
 
+/**
+ * Frees the buffers used for propagating terrain transitions, which are
+ * sized for the whole layer.
+ */
+void TerrainBrush::releaseBuffers()
+{
+    mNewTerrain = QVector<Tile*>();
+    mChecked = QVector<unsigned>();
+    mCheckMark = 0;
+    mTransitionQueue = QVector<QPoint>();
+}
+
 void TerrainBrush::setTerrain(const Terrain *terrain)
 {
     if (mTerrain == terrain)
@@ -254,7 +273,8 @@ static inline unsigned makeTerrain(int t)
     return t << 24 | t << 16 | t << 8 | t;
 }
 
-static Tile *findBestTile(const Tileset &tileset, unsigned terrain, unsigned considerationMask)
+static Tile *findBestTile(const Tileset &tileset, unsigned terrain, unsigned considerationMask,
+                          RandomGenerator &generator)
 {
     // we should have hooked 0xFFFFFFFF terrains outside this function
     Q_ASSERT(terrain != 0xFFFFFFFF);
@@ -266,35 +286,38 @@ static Tile *findBestTile(const Tileset &tileset, unsigned terrain, unsigned con
     RandomPicker<Tile*> matches;
     int penalty = INT_MAX;
 
-    // TODO: this is a slow linear search, perhaps we could use a better find algorithm...
-    foreach (Tile *t, tileset.tiles()) {
-        if ((t->terrain() & considerationMask) != (terrain & considerationMask))
+    // Tiles sharing the same terrain have the same penalty, so only each
+    // distinct terrain used in the tileset needs to be considered
+    for (const Tileset::TerrainTransition &transition : tileset.terrainTransitions()) {
+        const unsigned tileTerrain = transition.terrain;
+        if ((tileTerrain & considerationMask) != (terrain & considerationMask))
             continue;
 
         // calculate the tile transition penalty based on shortest distance to target terrain type
-        int tr = tileset.terrainTransitionPenalty(t->terrain() >> 24, terrain >> 24);
-        int tl = tileset.terrainTransitionPenalty((t->terrain() >> 16) & 0xFF, (terrain >> 16) & 0xFF);
-        int br = tileset.terrainTransitionPenalty((t->terrain() >> 8) & 0xFF, (terrain >> 8) & 0xFF);
-        int bl = tileset.terrainTransitionPenalty(t->terrain() & 0xFF, terrain & 0xFF);
+        int tr = tileset.terrainTransitionPenalty(tileTerrain >> 24, terrain >> 24);
+        int tl = tileset.terrainTransitionPenalty((tileTerrain >> 16) & 0xFF, (terrain >> 16) & 0xFF);
+        int br = tileset.terrainTransitionPenalty((tileTerrain >> 8) & 0xFF, (terrain >> 8) & 0xFF);
+        int bl = tileset.terrainTransitionPenalty(tileTerrain & 0xFF, terrain & 0xFF);
 
         // if there is no path to the destination terrain, this isn't a useful transition
         if (tr < 0 || tl < 0 || br < 0 || bl < 0)
             continue;
 
-        // add tile to the candidate list
+        // add the tiles to the candidate list
         int transitionPenalty = tr + tl + br + bl;
         if (transitionPenalty <= penalty) {
             if (transitionPenalty < penalty)
                 matches.clear();
             penalty = transitionPenalty;
 
-            matches.add(t, t->probability());
+            for (Tile *t : transition.tiles)
+                matches.add(t, t->probability());
         }
     }
 
     // choose a candidate at random, with consideration for probability
     if (!matches.isEmpty())
-        return matches.pick();
+        return matches.pick(generator);
 
     // TODO: conveniently, the null tile doesn't currently work, but when it does, we need to signal a failure to find any matches some other way
     return nullptr;
@@ -361,40 +384,49 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
         terrainId = mTerrain->id();
     }
 
-    // allocate a buffer to build the terrain tilemap (TODO: this could be retained per layer to save regular allocation)
-    Tile **newTerrain = new Tile*[numTiles];
+    // the buffer to build the terrain tilemap and the check marks for each
+    // tile that may be considered, which only grow with the layer
+    if (mChecked.size() < numTiles) {
+        mNewTerrain.resize(numTiles);
+        mChecked.resize(numTiles);
+    }
+
+    // a new mark unchecks all tiles, unless it wrapped around
+    if (++mCheckMark == 0) {
+        mChecked.fill(0);
+        mCheckMark = 1;
+    }
 
-    // allocate a buffer of flags for each tile that may be considered (TODO: this could be retained per layer to save regular allocation)
-    char *checked = new char[numTiles];
-    memset(checked, 0, numTiles);
+    Tile **newTerrain = mNewTerrain.data();
+    unsigned *checked = mChecked.data();
+    const unsigned mark = mCheckMark;
 
-    // create a consideration list, and push the start points
-    QList<QPoint> transitionList;
+    // create a consideration queue, and push the start points
+    QVector<QPoint> &transitionQueue = mTransitionQueue;
+    transitionQueue.clear();
     int initialTiles = 0;
 
     if (list) {
         // if we were supplied a list of start points
-        foreach (const QPoint &p, *list) {
-            transitionList.append(p);
-            ++initialTiles;
-        }
+        transitionQueue += *list;
+        initialTiles = list->size();
     } else {
-        transitionList.append(cursorPos);
+        transitionQueue.append(cursorPos);
         initialTiles = 1;
     }
 
     QRect brushRect(cursorPos, cursorPos);
 
     // produce terrain with transitions using a simple, relative naive approach (considers each tile once, and doesn't allow re-consideration if selection was bad)
-    while (!transitionList.isEmpty()) {
-        // get the next point in the consideration list
-        QPoint p = transitionList.takeFirst();
+    for (int head = 0; head < transitionQueue.size(); ++head) {
+        // get the next point in the consideration queue
+        const QPoint p = transitionQueue.at(head);
         int x = p.x(), y = p.y();
         int i = y*layerWidth + x;
 
         // if we have already considered this point, skip to the next
         // TODO: we might want to allow re-consideration if prior tiles... but not for now, this would risk infinite loops
-        if (checked[i])
+        if (checked[i] == mark)
             continue;
 
         const Tile *tile = currentLayer->cellAt(p).tile;
@@ -450,19 +482,19 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
             mask = 0;
 
             // depending which connections have been set, we update the preferred terrain of the tile accordingly
-            if (y > 0 && checked[i - layerWidth]) {
+            if (y > 0 && checked[i - layerWidth] == mark) {
                 preferredTerrain = (::terrain(newTerrain[i - layerWidth]) << 16) | (preferredTerrain & 0x0000FFFF);
                 mask |= 0xFFFF0000;
             }
-            if (y < layerHeight - 1 && checked[i + layerWidth]) {
+            if (y < layerHeight - 1 && checked[i + layerWidth] == mark) {
                 preferredTerrain = (::terrain(newTerrain[i + layerWidth]) >> 16) | (preferredTerrain & 0xFFFF0000);
                 mask |= 0x0000FFFF;
             }
-            if (x > 0 && checked[i - 1]) {
+            if (x > 0 && checked[i - 1] == mark) {
                 preferredTerrain = ((::terrain(newTerrain[i - 1]) << 8) & 0xFF00FF00) | (preferredTerrain & 0x00FF00FF);
                 mask |= 0xFF00FF00;
             }
-            if (x < layerWidth - 1 && checked[i + 1]) {
+            if (x < layerWidth - 1 && checked[i + 1] == mark) {
                 preferredTerrain = ((::terrain(newTerrain[i + 1]) >> 8) & 0x00FF00FF) | (preferredTerrain & 0xFF00FF00);
                 mask |= 0x00FF00FF;
             }
@@ -471,38 +503,39 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
         // find the most appropriate tile in the tileset
         Tile *paste = nullptr;
         if (preferredTerrain != 0xFFFFFFFF) {
-            paste = findBestTile(*tileset, preferredTerrain, mask);
+            paste = findBestTile(*tileset, preferredTerrain, mask,
+                                 mapDocument()->randomGenerator());
             if (!paste)
                 continue;
         }
 
         // add tile to the brush
         newTerrain[i] = paste;
-        checked[i] = true;
+        checked[i] = mark;
 
         // expand the brush rect to fit the edit set
         brushRect |= QRect(p, p);
 
         // consider surrounding tiles if terrain constraints were not satisfied
-        if (y > 0 && !checked[i - layerWidth]) {
+        if (y > 0 && checked[i - layerWidth] != mark) {
             const Tile *above = currentLayer->cellAt(x, y - 1).tile;
             if (topEdge(paste) != bottomEdge(above))
-                transitionList.append(QPoint(x, y - 1));
+                transitionQueue.append(QPoint(x, y - 1));
         }
-        if (y < layerHeight - 1 && !checked[i + layerWidth]) {
+        if (y < layerHeight - 1 && checked[i + layerWidth] != mark) {
             const Tile *below = currentLayer->cellAt(x, y + 1).tile;
             if (bottomEdge(paste) != topEdge(below))
-                transitionList.append(QPoint(x, y + 1));
+                transitionQueue.append(QPoint(x, y + 1));
         }
-        if (x > 0 && !checked[i - 1]) {
+        if (x > 0 && checked[i - 1] != mark) {
             const Tile *left = currentLayer->cellAt(x - 1, y).tile;
             if (leftEdge(paste) != rightEdge(left))
-                transitionList.append(QPoint(x - 1, y));
+                transitionQueue.append(QPoint(x - 1, y));
         }
-        if (x < layerWidth - 1 && !checked[i + 1]) {
+        if (x < layerWidth - 1 && checked[i + 1] != mark) {
             const Tile *right = currentLayer->cellAt(x + 1, y).tile;
             if (rightEdge(paste) != leftEdge(right))
-                transitionList.append(QPoint(x + 1, y));
+                transitionQueue.append(QPoint(x + 1, y));
         }
     }
 
@@ -516,7 +549,7 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
     for (int y = brushRect.top(); y <= brushRect.bottom(); ++y) {
         for (int x = brushRect.left(); x <= brushRect.right(); ++x) {
             int i = y * layerWidth + x;
-            if (!checked[i])
+            if (checked[i] != mark)
                 continue;
 
             Tile *tile = newTerrain[i];
@@ -534,9 +567,6 @@ void TerrainBrush::updateBrush(QPoint cursorPos, const QVector<QPoint> *list)
     // set the new tile layer as the brush
     brushItem()->setTileLayer(stamp);
 
-    delete[] checked;
-    delete[] newTerrain;
-
     mPaintX = cursorPos.x();
     mPaintY = cursorPos.y();
     mOffsetX = cursorPos.x() - brushRect.left();
@@ -105,6 +105,7 @@ private:
      * updates the brush given new coordinates.
      */
     void updateBrush(QPoint cursorPos, const QVector<QPoint> *list = nullptr);
+    void releaseBuffers();
 
     /**
      * The terrain we are currently painting.
@@ -140,6 +141,17 @@ private:
      * When drawing circles this will be the midpoint.
      */
     int mLineReferenceX, mLineReferenceY;
+
+    /**
+     * The buffers used for propagating the terrain transitions, which are
+     * kept between updates of the brush. A tile has been checked during the
+     * current update when its entry in mChecked equals mCheckMark, so that
+     * the buffers never need to be cleared.
+     */
+    QVector<Tile*> mNewTerrain;
+    QVector<unsigned> mChecked;
+    unsigned mCheckMark;
+    QVector<QPoint> mTransitionQueue;
 };
 
 } // namespace Internal
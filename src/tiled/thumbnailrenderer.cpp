@@ -31,6 +31,8 @@
 #include "staggeredrenderer.h"
 #include "tilelayer.h"
 
+#include <algorithm>
+
 namespace Tiled {
 namespace Internal {
 
@@ -129,23 +131,16 @@ QImage ThumbnailRenderer::render(const QSize &size) const
             if (objGroup->drawOrder() == ObjectGroup::TopDownOrder)
                 qStableSort(objects.begin(), objects.end(), objectLessThan);
 
-            foreach (const MapObject *object, objects) {
-                if (object->isVisible()) {
-                    if (object->rotation() != qreal(0)) {
-                        QPointF origin = mRenderer->pixelToScreenCoords(object->position());
-                        painter.save();
-                        painter.translate(origin);
-                        painter.rotate(object->rotation());
-                        painter.translate(-origin);
-                    }
-
-                    const QColor color = MapObjectItem::objectColor(object);
-                    mRenderer->drawMapObject(&painter, object, color);
-
-                    if (object->rotation() != qreal(0))
-                        painter.restore();
-                }
-            }
+            objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                         [] (const MapObject *object) { return !object->isVisible(); }),
+                          objects.end());
+
+            QVector<QColor> colors;
+            colors.reserve(objects.size());
+            for (const MapObject *object : objects)
+                colors.append(MapObjectItem::objectColor(object));
+
+            mRenderer->drawMapObjects(&painter, objects, colors);
         } else if (imageLayer) {
             mRenderer->drawImageLayer(&painter, imageLayer);
         }
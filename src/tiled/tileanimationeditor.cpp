@@ -29,6 +29,7 @@
 #include "tileanimationdriver.h"
 #include "tiled.h"
 #include "tileset.h"
+#include "tilesetmanager.h"
 #include "utils.h"
 #include "zoomable.h"
 
@@ -291,6 +292,13 @@ TileAnimationEditor::TileAnimationEditor(QWidget *parent)
     connect(mPreviewAnimationDriver, SIGNAL(update(int)),
             SLOT(advancePreviewAnimation(int)));
 
+    // When tile animations are running, the preview follows them
+    TilesetManager *tilesetManager = TilesetManager::instance();
+    connect(tilesetManager, &TilesetManager::repaintTiles,
+            this, &TileAnimationEditor::tilesAnimated);
+    connect(tilesetManager, &TilesetManager::animateTilesChanged,
+            this, &TileAnimationEditor::updatePreviewAnimationDriver);
+
     QShortcut *undoShortcut = new QShortcut(QKeySequence::Undo, this);
     QShortcut *redoShortcut = new QShortcut(QKeySequence::Redo, this);
     QShortcut *deleteShortcut = new QShortcut(QKeySequence::Delete, this);
@@ -332,15 +340,26 @@ void TileAnimationEditor::setMapDocument(MapDocument *mapDocument)
 
 void TileAnimationEditor::setTile(Tile *tile)
 {
+    if (mTile == tile)
+        return;
+
     mTile = tile;
-    delete mUi->tilesetView->model();
+
+    // The tileset model is kept while selecting tiles from the same tileset
+    Tileset *tileset = tile ? tile->tileset() : nullptr;
+    TilesetModel *tilesetModel = mUi->tilesetView->tilesetModel();
+
+    if (!tilesetModel || tilesetModel->tileset() != tileset) {
+        delete tilesetModel;
+
+        if (tileset) {
+            tilesetModel = new TilesetModel(tileset, mUi->tilesetView);
+            mUi->tilesetView->setModel(tilesetModel);
+        }
+    }
 
     if (tile) {
         mFrameListModel->setFrames(tile->tileset(), tile->frames());
-
-        TilesetModel *tilesetModel = new TilesetModel(tile->tileset(),
-                                                      mUi->tilesetView);
-        mUi->tilesetView->setModel(tilesetModel);
     } else {
         mFrameListModel->setFrames(nullptr, QVector<Frame>());
     }
@@ -376,12 +395,13 @@ void TileAnimationEditor::changeEvent(QEvent *e)
 
 void TileAnimationEditor::showEvent(QShowEvent *)
 {
-    mPreviewAnimationDriver->start();
+    updatePreviewAnimationDriver();
+    resetPreview();
 }
 
 void TileAnimationEditor::hideEvent(QHideEvent *)
 {
-    mPreviewAnimationDriver->stop();
+    updatePreviewAnimationDriver();
 }
 
 void TileAnimationEditor::framesEdited()
@@ -499,10 +519,8 @@ void TileAnimationEditor::advancePreviewAnimation(int ms)
         frame = frames.at(mPreviewFrameIndex);
     }
 
-    if (previousTileId != frame.tileId) {
-        if (const Tile *tile = mTile->tileset()->tileAt(frame.tileId))
-            mUi->preview->setPixmap(tile->image());
-    }
+    if (previousTileId != frame.tileId)
+        setPreviewTile(mTile->tileset()->tileAt(frame.tileId));
 }
 
 void TileAnimationEditor::resetPreview()
@@ -511,15 +529,56 @@ void TileAnimationEditor::resetPreview()
     mPreviewUnusedTime = 0;
 
     if (mTile && mTile->isAnimated()) {
-        const int tileId = mTile->frames().first().tileId;
-        if (const Tile *tile = mTile->tileset()->tileAt(tileId)) {
-            mUi->preview->setPixmap(tile->image());
-            return;
+        // Running tile animations are shown at their current frame
+        if (TilesetManager::instance()->animateTiles()) {
+            setPreviewTile(mTile->currentFrameTile());
+        } else {
+            const int tileId = mTile->frames().first().tileId;
+            setPreviewTile(mTile->tileset()->tileAt(tileId));
         }
+    } else {
+        setPreviewTile(nullptr);
     }
+}
 
-    mUi->preview->setText(QApplication::translate("TileAnimationEditor",
-                                                  "Preview"));
+/**
+ * Updates the preview when the tile animations, which are shared with the
+ * map views, have moved the edited tile to a different frame.
+ */
+void TileAnimationEditor::tilesAnimated(const QSet<Tile*> &tiles)
+{
+    if (mTile && isVisible() && tiles.contains(mTile))
+        setPreviewTile(mTile->currentFrameTile());
+}
+
+/**
+ * The preview only uses its own animation driver while the shown editor
+ * can't rely on the tile animations.
+ */
+void TileAnimationEditor::updatePreviewAnimationDriver()
+{
+    const bool run = isVisible() && !TilesetManager::instance()->animateTiles();
+    const bool running = mPreviewAnimationDriver->state() == QAbstractAnimation::Running;
+
+    if (run == running)
+        return;
+
+    if (run)
+        mPreviewAnimationDriver->start();
+    else
+        mPreviewAnimationDriver->stop();
+
+    resetPreview();
+}
+
+void TileAnimationEditor::setPreviewTile(const Tile *tile)
+{
+    if (tile) {
+        mUi->preview->setPixmap(tile->image());
+    } else {
+        mUi->preview->setText(QApplication::translate("TileAnimationEditor",
+                                                      "Preview"));
+    }
 }
 
 } // namespace Internal
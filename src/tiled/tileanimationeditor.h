@@ -23,6 +23,7 @@
 
 #include <QWidget>
 #include <QModelIndex>
+#include <QSet>
 
 namespace Ui {
 class TileAnimationEditor;
@@ -79,8 +80,12 @@ private slots:
 
     void advancePreviewAnimation(int ms);
     void resetPreview();
+    void tilesAnimated(const QSet<Tile*> &tiles);
+    void updatePreviewAnimationDriver();
 
 private:
+    void setPreviewTile(const Tile *tile);
+
     Ui::TileAnimationEditor *mUi;
 
     MapDocument *mMapDocument;
@@ -165,9 +165,18 @@ void TileCollisionEditor::setTile(Tile *tile)
 
     mTile = tile;
 
-    mMapScene->disableSelectedTool();
     MapDocument *previousDocument = mMapScene->mapDocument();
 
+    // The map of the previous tile is reused for tiles of the same tileset
+    if (tile && previousDocument &&
+            previousDocument->map()->tilesets().first() == tile->sharedTileset()) {
+        mMapView->setEnabled(!mTile->tileset()->isExternal());
+        showTile(tile);
+        return;
+    }
+
+    mMapScene->disableSelectedTool();
+
     if (tile) {
         mMapView->setEnabled(!mTile->tileset()->isExternal());
 
@@ -248,8 +257,48 @@ void TileCollisionEditor::tileObjectGroupChanged(Tile *tile)
     mSynchronizing = true;
 
     MapDocument *dummyDocument = mMapScene->mapDocument();
-    LayerModel *layerModel = dummyDocument->layerModel();
     dummyDocument->undoStack()->clear();
+    replaceObjectGroup(tile);
+
+    mSynchronizing = false;
+}
+
+/**
+ * Shows the given \a tile in the current map, which has its tileset. Only
+ * the tile size, the cell and the object group are changed.
+ */
+void TileCollisionEditor::showTile(Tile *tile)
+{
+    mSynchronizing = true;
+
+    MapDocument *dummyDocument = mMapScene->mapDocument();
+    dummyDocument->undoStack()->clear();
+    dummyDocument->setSelectedObjects(QList<MapObject*>());
+
+    Map *map = dummyDocument->map();
+    if (map->tileWidth() != tile->width() || map->tileHeight() != tile->height()) {
+        map->setTileWidth(tile->width());
+        map->setTileHeight(tile->height());
+        dummyDocument->emitMapChanged();
+    }
+
+    TileLayer *tileLayer = map->layerAt(0)->asTileLayer();
+    tileLayer->setCell(0, 0, Cell(tile));
+    dummyDocument->emitRegionChanged(QRegion(0, 0, 1, 1), tileLayer);
+
+    replaceObjectGroup(tile);
+
+    mSynchronizing = false;
+}
+
+/**
+ * Replaces the object group of the current map with a copy of the object
+ * group of the given \a tile.
+ */
+void TileCollisionEditor::replaceObjectGroup(Tile *tile)
+{
+    MapDocument *dummyDocument = mMapScene->mapDocument();
+    LayerModel *layerModel = dummyDocument->layerModel();
 
     delete layerModel->takeLayerAt(1);
 
@@ -263,8 +312,6 @@ void TileCollisionEditor::tileObjectGroupChanged(Tile *tile)
 
     layerModel->insertLayer(1, objectGroup);
     dummyDocument->setCurrentLayerIndex(1);
-
-    mSynchronizing = false;
 }
 
 void TileCollisionEditor::tilesetFileNameChanged(Tileset *tileset)
@@ -79,6 +79,9 @@ private slots:
     void delete_(Operation operation = Delete);
 
 private:
+    void showTile(Tile *tile);
+    void replaceObjectGroup(Tile *tile);
+
     void retranslateUi();
 
     Tile *mTile;
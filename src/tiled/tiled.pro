@@ -60,6 +60,7 @@ SOURCES += aboutdialog.cpp \
     changemapobject.cpp \
     changemapobjectsorder.cpp \
     changemapproperty.cpp \
+    changenotifier.cpp \
     changeobjectgroupproperties.cpp \
     changepolygon.cpp \
     changeproperties.cpp \
@@ -97,17 +98,28 @@ SOURCES += aboutdialog.cpp \
     imagelayeritem.cpp \
     imagemovementtool.cpp \
     languagemanager.cpp \
+    layercompositeitem.cpp \
+    layercompressor.cpp \
     layerdock.cpp \
     layermodel.cpp \
     main.cpp \
     mainwindow.cpp \
+    mapanalysisdock.cpp \
+    mapbenchmark.cpp \
     mapdocumentactionhandler.cpp \
     mapdocument.cpp \
+    mapimageexporter.cpp \
+    maploader.cpp \
+    maploadtask.cpp \
     mapobjectitem.cpp \
     mapobjectmodel.cpp \
+    mapsaver.cpp \
     mapscene.cpp \
     mapsdock.cpp \
+    mapthumbnailprovider.cpp \
     mapview.cpp \
+    memoryreport.cpp \
+    memoryusagedock.cpp \
     minimap.cpp \
     minimapdock.cpp \
     movabletabwidget.cpp \
@@ -121,19 +133,23 @@ SOURCES += aboutdialog.cpp \
     objectsdock.cpp \
     objectselectionitem.cpp \
     objectselectiontool.cpp \
+    objectsfiltermodel.cpp \
     objecttypes.cpp \
     objecttypesmodel.cpp \
     offsetlayer.cpp \
     offsetmapdialog.cpp \
+    opengltilelayerrenderer.cpp \
     painttilelayer.cpp \
     patreondialog.cpp \
     preferences.cpp \
     preferencesdialog.cpp \
+    progressiverenderer.cpp \
     propertiesdock.cpp \
     propertybrowser.cpp \
     raiselowerhelper.cpp \
     renamelayer.cpp \
     renameterrain.cpp \
+    renderprofiler.cpp \
     resizedialog.cpp \
     resizehelper.cpp \
     resizemap.cpp \
@@ -161,6 +177,7 @@ SOURCES += aboutdialog.cpp \
     tilesetdock.cpp \
     tilesetmanager.cpp \
     tilesetmodel.cpp \
+    tilesetrepacker.cpp \
     tilesetview.cpp \
     tilestamp.cpp \
     tilestampmanager.cpp \
@@ -168,10 +185,16 @@ SOURCES += aboutdialog.cpp \
     tilestampsdock.cpp \
     tmxmapformat.cpp \
     toolmanager.cpp \
+    transformmapobjects.cpp \
+    transformtilelayers.cpp \
     undodock.cpp \
+    undomemory.cpp \
     utils.cpp \
     varianteditorfactory.cpp \
     variantpropertymanager.cpp \
+    worlditem.cpp \
+    worldmanager.cpp \
+    worldstreamer.cpp \
     zoomable.cpp \
     magicwandtool.cpp
 
@@ -197,6 +220,7 @@ HEADERS += aboutdialog.h \
     changemapobject.h \
     changemapobjectsorder.h \
     changemapproperty.h \
+    changenotifier.h \
     changeobjectgroupproperties.h \
     changepolygon.h \
     changeproperties.h \
@@ -230,22 +254,34 @@ HEADERS += aboutdialog.h \
     exportasimagedialog.h \
     fileedit.h \
     filesystemwatcher.h \
+    floodfill.h \
     flipmapobjects.h \
     geometry.h \
     imagelayeritem.h \
     imagemovementtool.h \
     languagemanager.h \
+    layercompositeitem.h \
+    layercompressor.h \
     layerdock.h \
     layermodel.h \
     macsupport.h \
     mainwindow.h \
+    mapanalysisdock.h \
+    mapbenchmark.h \
     mapdocumentactionhandler.h \
     mapdocument.h \
+    mapimageexporter.h \
+    maploader.h \
+    maploadtask.h \
     mapobjectitem.h \
     mapobjectmodel.h \
+    mapsaver.h \
     mapscene.h \
     mapsdock.h \
+    mapthumbnailprovider.h \
     mapview.h \
+    memoryreport.h \
+    memoryusagedock.h \
     minimap.h \
     minimapdock.h \
     movabletabwidget.h \
@@ -259,14 +295,17 @@ HEADERS += aboutdialog.h \
     objectsdock.h \
     objectselectionitem.h \
     objectselectiontool.h \
+    objectsfiltermodel.h \
     objecttypes.h \
     objecttypesmodel.h \
     offsetlayer.h \
     offsetmapdialog.h \
+    opengltilelayerrenderer.h \
     painttilelayer.h \
     patreondialog.h \
     preferencesdialog.h \
     preferences.h \
+    progressiverenderer.h \
     propertiesdock.h \
     propertybrowser.h \
     raiselowerhelper.h \
@@ -274,6 +313,7 @@ HEADERS += aboutdialog.h \
     rangeset.h \
     renamelayer.h \
     renameterrain.h \
+    renderprofiler.h \
     resizedialog.h \
     resizehelper.h \
     resizemap.h \
@@ -301,6 +341,7 @@ HEADERS += aboutdialog.h \
     tilesetdock.h \
     tilesetmanager.h \
     tilesetmodel.h \
+    tilesetrepacker.h \
     tilesetview.h \
     tilestamp.h \
     tilestampmanager.h \
@@ -308,11 +349,17 @@ HEADERS += aboutdialog.h \
     tilestampsdock.h \
     tmxmapformat.h \
     toolmanager.h \
+    transformmapobjects.h \
+    transformtilelayers.h \
     undocommands.h \
     undodock.h \
+    undomemory.h \
     utils.h \
     varianteditorfactory.h \
     variantpropertymanager.h \
+    worlditem.h \
+    worldmanager.h \
+    worldstreamer.h \
     zoomable.h \
     magicwandtool.h
 
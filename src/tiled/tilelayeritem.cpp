@@ -25,7 +25,13 @@
 #include "map.h"
 #include "mapdocument.h"
 #include "maprenderer.h"
+#include "opengltilelayerrenderer.h"
+#include "preferences.h"
+#include "progressiverenderer.h"
+#include "renderprofiler.h"
 
+#include <QGraphicsScene>
+#include <QGraphicsView>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
 
@@ -35,6 +41,15 @@ using namespace Tiled::Internal;
 TileLayerItem::TileLayerItem(TileLayer *layer, MapDocument *mapDocument)
     : mLayer(layer)
     , mMapDocument(mapDocument)
+    , mDrawMarginsIncluded(false)
+    , mProgressiveRenderer(nullptr)
+    , mUsedTilesetsDirty(true)
+    , mAnimatedCellsDirty(true)
+    , mOutdatedOutsideView(false)
+    , mAnimationsOutdatedOutsideView(false)
+#ifndef QT_NO_OPENGL
+    , mOpenGLRenderer(nullptr)
+#endif
 {
     setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
 
@@ -43,14 +58,31 @@ TileLayerItem::TileLayerItem(TileLayer *layer, MapDocument *mapDocument)
     setPos(mLayer->offset());
 }
 
+TileLayerItem::~TileLayerItem()
+{
+    delete mProgressiveRenderer;
+#ifndef QT_NO_OPENGL
+    delete mOpenGLRenderer;
+#endif
+}
+
 void TileLayerItem::syncWithTileLayer()
 {
     prepareGeometryChange();
+    invalidateCache();
+
+    mCellBounds = mLayer->cellBounds().translated(mLayer->position());
 
     MapRenderer *renderer = mMapDocument->renderer();
-    QRectF boundingRect = renderer->boundingRect(mLayer->bounds());
+    QRectF boundingRect = renderer->boundingRect(mCellBounds);
+
+    // The cells of hidden layers may not have been loaded yet. Their draw
+    // margins are taken into account once they are shown.
+    QMargins margins;
+    mDrawMarginsIncluded = mLayer->isLoaded() || mLayer->isVisible();
+    if (mDrawMarginsIncluded)
+        margins = mLayer->drawMargins();
 
-    QMargins margins = mLayer->drawMargins();
     if (const Map *map = mLayer->map()) {
         margins.setTop(margins.top() - map->tileHeight());
         margins.setRight(margins.right() - map->tileWidth());
@@ -62,16 +94,549 @@ void TileLayerItem::syncWithTileLayer()
                                           margins.bottom());
 }
 
+/**
+ * Makes sure this item covers the given \a cells, in map coordinates, which
+ * may have been painted outside of the area covered by an infinite layer.
+ *
+ * Returns whether the item had to grow.
+ */
+bool TileLayerItem::coverCells(const QRect &cells)
+{
+    if (!mLayer->isInfinite() || mCellBounds.contains(cells))
+        return false;
+
+    syncWithTileLayer();
+    return true;
+}
+
+/**
+ * Updates the visibility of this item.
+ *
+ * The cached chunks are kept while the layer is hidden, so that showing it
+ * again doesn't require rendering it anew. Only a layer that still needs to
+ * be loaded is synchronized, and when the layer shows animated tiles, which
+ * are not repainted while hidden, the chunks showing them are refreshed as
+ * they are exposed.
+ */
+void TileLayerItem::syncVisibility()
+{
+    const bool visible = mLayer->isVisible();
+    if (isVisible() == visible)
+        return;
+
+    setVisible(visible);
+    if (!visible)
+        return;
+
+    if (!mDrawMarginsIncluded) {
+        syncWithTileLayer();
+        return;
+    }
+
+    if (hasAnimatedTiles())
+        setAnimationsUpToDateRect(QRectF());
+}
+
 QRectF TileLayerItem::boundingRect() const
 {
     return mBoundingRect;
 }
 
+/**
+ * Drops the cached chunks overlapping with \a rect, which is given in item
+ * coordinates.
+ */
+void TileLayerItem::invalidateCache(const QRectF &rect)
+{
+    mUsedTilesetsDirty = true;
+
+#ifndef QT_NO_OPENGL
+    if (mOpenGLRenderer)
+        mOpenGLRenderer->invalidate(rect);
+#endif
+
+    if (mProgressiveRenderer)
+        mProgressiveRenderer->invalidateSnapshot();
+
+    mRenderCache.invalidate(rect);
+}
+
+/**
+ * Drops all cached chunks.
+ */
+void TileLayerItem::invalidateCache()
+{
+    mRenderCache.clear();
+    if (mProgressiveRenderer)
+        mProgressiveRenderer->invalidateSnapshot();
+    mUsedTilesetsDirty = true;
+    mAnimatedCellsDirty = true;
+
+#ifndef QT_NO_OPENGL
+    if (mOpenGLRenderer)
+        mOpenGLRenderer->invalidate();
+#endif
+}
+
+/**
+ * Drops the cache when the layer uses the given \a tileset, which was
+ * changed.
+ */
+void TileLayerItem::tilesetChanged(Tileset *tileset)
+{
+    bool cached = !mRenderCache.isEmpty();
+#ifndef QT_NO_OPENGL
+    cached |= mOpenGLRenderer != nullptr;
+#endif
+    if (!cached)
+        return;
+
+    if (usesTileset(tileset)) {
+        mRenderCache.clear();
+        if (mProgressiveRenderer)
+            mProgressiveRenderer->invalidateSnapshot();
+#ifndef QT_NO_OPENGL
+        if (mOpenGLRenderer)
+            mOpenGLRenderer->invalidate();
+#endif
+    }
+}
+
+bool TileLayerItem::usesTileset(Tileset *tileset)
+{
+    if (mUsedTilesetsDirty) {
+        mUsedTilesets.clear();
+        for (const SharedTileset &used : mLayer->usedTilesets())
+            mUsedTilesets.insert(used.data());
+        mUsedTilesetsDirty = false;
+    }
+
+    return mUsedTilesets.contains(tileset);
+}
+
+/**
+ * Marks the animated cells in the given \a region, in tile coordinates, for
+ * being looked up again. Should be called when cells in that region change.
+ */
+void TileLayerItem::invalidateAnimatedCells(const QRegion &region)
+{
+    if (mAnimatedCellsDirty)
+        return;
+
+    const QPoint layerPos = mLayer->position();
+
+    for (const QRect &rect : region.rects()) {
+        const QRect r = rect.translated(-layerPos);
+        const int startX = r.left() >> CHUNK_BITS;
+        const int startY = r.top() >> CHUNK_BITS;
+        const int endX = r.right() >> CHUNK_BITS;
+        const int endY = r.bottom() >> CHUNK_BITS;
+
+        for (int y = startY; y <= endY; ++y)
+            for (int x = startX; x <= endX; ++x)
+                mDirtyAnimatedChunks.insert(QPoint(x, y));
+    }
+}
+
+/**
+ * Returns whether any of the cells of this layer show an animated tile.
+ */
+bool TileLayerItem::hasAnimatedTiles()
+{
+    updateAnimatedCells();
+    return !mAnimatedTileChunkCounts.isEmpty();
+}
+
+/**
+ * Repaints the cells showing any of the given animated \a tiles, which have
+ * changed to a different frame.
+ *
+ * Only the cells within the view are repainted. The animated cells outside
+ * of the view are invalidated once they get exposed (see
+ * invalidateOutdatedArea()).
+ */
+void TileLayerItem::repaintTiles(const QSet<Tile*> &tiles)
+{
+    // Hidden layers may not be loaded, and will be repainted when shown
+    if (!mLayer->isVisible() || !mLayer->isLoaded())
+        return;
+
+    updateAnimatedCells();
+
+    bool usesChangedTiles = false;
+    for (Tile *tile : tiles) {
+        if (mAnimatedTileChunkCounts.contains(tile)) {
+            usesChangedTiles = true;
+            break;
+        }
+    }
+
+    if (!usesChangedTiles)
+        return;
+
+    const QRectF visibleRect = this->visibleRect();
+    setAnimationsUpToDateRect(visibleRect);
+
+    if (visibleRect.isEmpty())
+        return;
+
+    const QPoint layerPos = mLayer->position();
+    const QRect visibleTiles = visibleTileRect(visibleRect).translated(-layerPos);
+
+    const int startX = visibleTiles.left() >> CHUNK_BITS;
+    const int startY = visibleTiles.top() >> CHUNK_BITS;
+    const int endX = visibleTiles.right() >> CHUNK_BITS;
+    const int endY = visibleTiles.bottom() >> CHUNK_BITS;
+
+    auto repaintChunk = [&] (const QPoint &chunkPos, const QVector<AnimatedCell> &cells) {
+        const QPoint origin = chunkPos * CHUNK_SIZE + layerPos;
+
+        QRect changed;
+        for (const AnimatedCell &cell : cells) {
+            if (tiles.contains(cell.tile)) {
+                changed |= QRect(origin.x() + (cell.index & CHUNK_MASK),
+                                 origin.y() + (cell.index >> CHUNK_BITS),
+                                 1, 1);
+            }
+        }
+
+        repaintCells(changed);
+    };
+
+    // Look up either the visible chunks or the animated ones, whichever are
+    // fewer
+    const qint64 visibleChunks = qint64(endX - startX + 1) * (endY - startY + 1);
+
+    if (visibleChunks > mAnimatedCells.size()) {
+        for (auto it = mAnimatedCells.constBegin(); it != mAnimatedCells.constEnd(); ++it) {
+            const QPoint &chunkPos = it.key();
+            if (chunkPos.x() >= startX && chunkPos.x() <= endX &&
+                    chunkPos.y() >= startY && chunkPos.y() <= endY)
+                repaintChunk(chunkPos, it.value());
+        }
+    } else {
+        for (int y = startY; y <= endY; ++y) {
+            for (int x = startX; x <= endX; ++x) {
+                const QPoint chunkPos(x, y);
+                auto it = mAnimatedCells.constFind(chunkPos);
+                if (it != mAnimatedCells.constEnd())
+                    repaintChunk(chunkPos, it.value());
+            }
+        }
+    }
+}
+
+/**
+ * Repaints the cells showing any of the given \a tiles, of which the image
+ * has changed. Like with animations, only the cells within the view are
+ * repainted right away.
+ */
+void TileLayerItem::tileImagesChanged(Tileset *tileset, const QSet<const Tile*> &tiles)
+{
+    if (!usesTileset(tileset))
+        return;
+
+    // Hidden layers may not be loaded, and the cache is no longer valid
+    if (!mLayer->isVisible() || !mLayer->isLoaded()) {
+        invalidateCache();
+        return;
+    }
+
+#ifndef QT_NO_OPENGL
+    // The vertex buffers refer to the previous tileset image
+    if (mOpenGLRenderer)
+        mOpenGLRenderer->invalidate();
+#endif
+
+    const QRectF visibleRect = this->visibleRect();
+    setUpToDateRect(visibleRect);
+
+    if (visibleRect.isEmpty())
+        return;
+
+    const QPoint layerPos = mLayer->position();
+    const QRect visibleTiles = visibleTileRect(visibleRect).translated(-layerPos)
+            & mLayer->cellBounds();
+
+    if (visibleTiles.isEmpty())
+        return;
+
+    const int startX = visibleTiles.left() >> CHUNK_BITS;
+    const int startY = visibleTiles.top() >> CHUNK_BITS;
+    const int endX = visibleTiles.right() >> CHUNK_BITS;
+    const int endY = visibleTiles.bottom() >> CHUNK_BITS;
+
+    for (int chunkY = startY; chunkY <= endY; ++chunkY) {
+        for (int chunkX = startX; chunkX <= endX; ++chunkX) {
+            const QPoint origin(chunkX * CHUNK_SIZE, chunkY * CHUNK_SIZE);
+            const Chunk *chunk = mLayer->findChunk(origin.x(), origin.y());
+            if (!chunk || chunk->isEmpty())
+                continue;
+
+            QRect changed;
+            for (int index = 0; index < CHUNK_SIZE * CHUNK_SIZE; ++index) {
+                const Tile *tile = chunk->cellAt(index).tile;
+                if (!tile)
+                    continue;
+
+                if (tiles.contains(tile) || tiles.contains(tile->currentFrameTile())) {
+                    changed |= QRect(origin.x() + (index & CHUNK_MASK),
+                                     origin.y() + (index >> CHUNK_BITS),
+                                     1, 1);
+                }
+            }
+
+            repaintCells(changed.translated(layerPos));
+        }
+    }
+}
+
+/**
+ * Returns the area in which the given \a cells, in tile coordinates, may be
+ * drawn. Takes into account the draw margins of the map.
+ */
+QRectF TileLayerItem::cellsBoundingRect(const QRect &cells) const
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QMargins margins = mMapDocument->map()->drawMargins();
+
+    return renderer->boundingRect(cells).adjusted(-margins.left(),
+                                                  -margins.top(),
+                                                  margins.right(),
+                                                  margins.bottom());
+}
+
+/**
+ * Invalidates and repaints the given \a cells, in tile coordinates.
+ */
+void TileLayerItem::repaintCells(const QRect &cells)
+{
+    if (cells.isEmpty())
+        return;
+
+    const QRectF boundingRect = cellsBoundingRect(cells);
+
+    invalidateCache(boundingRect);
+    update(boundingRect);
+}
+
+/**
+ * Remembers that only the given \a rect is up to date, because the rest of
+ * the layer is not repainted while it is outside of the view.
+ */
+void TileLayerItem::setUpToDateRect(const QRectF &rect)
+{
+    mUpToDateRegion = QRegion(rect.toAlignedRect());
+    mOutdatedOutsideView = true;
+}
+
+/**
+ * Remembers that the animated cells are only up to date within the given
+ * \a rect, because they are not repainted while outside of the view.
+ */
+void TileLayerItem::setAnimationsUpToDateRect(const QRectF &rect)
+{
+    mAnimationsUpToDateRegion = QRegion(rect.toAlignedRect());
+    mAnimationsOutdatedOutsideView = true;
+}
+
+/**
+ * Returns the area of this item that is visible in any of the views, in
+ * item coordinates.
+ */
+QRectF TileLayerItem::visibleRect() const
+{
+    QRectF rect;
+
+    if (const QGraphicsScene *scene = this->scene()) {
+        for (const QGraphicsView *view : scene->views()) {
+            const QRect viewportRect = view->viewport()->rect();
+            rect |= mapRectFromScene(view->mapToScene(viewportRect).boundingRect());
+        }
+    }
+
+    return rect & mBoundingRect;
+}
+
+/**
+ * Returns the tiles that may be drawn within the given \a rect, in item
+ * coordinates. Takes into account the draw margins of the map.
+ */
+QRect TileLayerItem::visibleTileRect(const QRectF &rect) const
+{
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QMargins margins = mMapDocument->map()->drawMargins();
+
+    // A cell is drawn inside rect when its own area intersects with rect
+    // grown by the margins in the opposite directions
+    const QRectF area = rect.adjusted(-margins.right(),
+                                      -margins.bottom(),
+                                      margins.left(),
+                                      margins.top());
+
+    QPolygonF polygon;
+    polygon << renderer->screenToTileCoords(area.topLeft())
+            << renderer->screenToTileCoords(area.topRight())
+            << renderer->screenToTileCoords(area.bottomRight())
+            << renderer->screenToTileCoords(area.bottomLeft());
+
+    return polygon.boundingRect().toAlignedRect().adjusted(-1, -1, 1, 1);
+}
+
+/**
+ * Invalidates the parts of the \a exposed area that may be outdated, because
+ * they were outside of the view when tile images changed. When only
+ * animation frames changed, only the chunks showing animated tiles are
+ * invalidated.
+ */
+void TileLayerItem::invalidateOutdatedArea(const QRectF &exposed)
+{
+    const QRect exposedRect = exposed.toAlignedRect();
+
+    if (mOutdatedOutsideView) {
+        const QRegion outdated = QRegion(exposedRect) - mUpToDateRegion;
+        if (!outdated.isEmpty()) {
+            invalidateCache(outdated.boundingRect());
+            mUpToDateRegion += exposedRect;
+        }
+    }
+
+    if (mAnimationsOutdatedOutsideView) {
+        const QRegion outdated = QRegion(exposedRect) - mAnimationsUpToDateRegion;
+        if (!outdated.isEmpty()) {
+            invalidateAnimatedChunks(outdated.boundingRect());
+            mAnimationsUpToDateRegion += exposedRect;
+        }
+    }
+}
+
+/**
+ * Invalidates the animated cells of each chunk that may be drawn within
+ * \a rect, in item coordinates.
+ */
+void TileLayerItem::invalidateAnimatedChunks(const QRectF &rect)
+{
+    updateAnimatedCells();
+
+    const QPoint layerPos = mLayer->position();
+
+    for (auto it = mAnimatedCells.constBegin(); it != mAnimatedCells.constEnd(); ++it) {
+        const QPoint origin = it.key() * CHUNK_SIZE + layerPos;
+
+        QRect cells;
+        for (const AnimatedCell &cell : it.value()) {
+            cells |= QRect(origin.x() + (cell.index & CHUNK_MASK),
+                           origin.y() + (cell.index >> CHUNK_BITS),
+                           1, 1);
+        }
+
+        const QRectF boundingRect = cellsBoundingRect(cells);
+        if (boundingRect.intersects(rect))
+            invalidateCache(boundingRect & rect);
+    }
+}
+
+void TileLayerItem::updateAnimatedCells()
+{
+    if (mAnimatedCellsDirty) {
+        mAnimatedCells.clear();
+        mAnimatedTileChunkCounts.clear();
+        mDirtyAnimatedChunks.clear();
+
+        const ChunkHash &chunks = mLayer->chunks();
+        for (auto it = chunks.constBegin(); it != chunks.constEnd(); ++it)
+            addAnimatedCells(it.key(), it.value());
+
+        mAnimatedCellsDirty = false;
+        return;
+    }
+
+    for (const QPoint &chunkPos : mDirtyAnimatedChunks) {
+        removeAnimatedCells(chunkPos);
+
+        const Chunk *chunk = mLayer->findChunk(chunkPos.x() * CHUNK_SIZE,
+                                               chunkPos.y() * CHUNK_SIZE);
+        if (chunk)
+            addAnimatedCells(chunkPos, *chunk);
+    }
+
+    mDirtyAnimatedChunks.clear();
+}
+
+void TileLayerItem::addAnimatedCells(const QPoint &chunkPos, const Chunk &chunk)
+{
+    if (chunk.isEmpty())
+        return;
+
+    QVector<AnimatedCell> cells;
+    QVector<Tile*> tiles;
+
+    for (int index = 0; index < CHUNK_SIZE * CHUNK_SIZE; ++index) {
+        Tile *tile = chunk.cellAt(index).tile;
+        if (!tile || !tile->isAnimated())
+            continue;
+
+        cells.append(AnimatedCell { tile, index });
+        if (!tiles.contains(tile))
+            tiles.append(tile);
+    }
+
+    if (cells.isEmpty())
+        return;
+
+    mAnimatedCells.insert(chunkPos, cells);
+    for (Tile *tile : tiles)
+        ++mAnimatedTileChunkCounts[tile];
+}
+
+void TileLayerItem::removeAnimatedCells(const QPoint &chunkPos)
+{
+    const QVector<AnimatedCell> cells = mAnimatedCells.take(chunkPos);
+
+    QVector<Tile*> tiles;
+    for (const AnimatedCell &cell : cells)
+        if (!tiles.contains(cell.tile))
+            tiles.append(cell.tile);
+
+    for (Tile *tile : tiles) {
+        auto it = mAnimatedTileChunkCounts.find(tile);
+        if (--it.value() == 0)
+            mAnimatedTileChunkCounts.erase(it);
+    }
+}
+
 void TileLayerItem::paint(QPainter *painter,
                           const QStyleOptionGraphicsItem *option,
                           QWidget *)
 {
+    RenderProfiler::ItemTimer timer(mLayer);
     MapRenderer *renderer = mMapDocument->renderer();
+
+    if (mOutdatedOutsideView || mAnimationsOutdatedOutsideView)
+        invalidateOutdatedArea(option->exposedRect);
+
+#ifndef QT_NO_OPENGL
+    if (OpenGLTileLayerRenderer::canRender(painter, mLayer, mMapDocument)) {
+        if (!mOpenGLRenderer)
+            mOpenGLRenderer = new OpenGLTileLayerRenderer(mLayer, mMapDocument);
+        if (mOpenGLRenderer->render(painter, option->exposedRect))
+            return;
+    }
+#endif
+
+    const QRectF exposed = option->exposedRect & mBoundingRect;
+
+    if (Preferences::instance()->progressiveRendering()) {
+        if (!mProgressiveRenderer) {
+            mProgressiveRenderer = new ProgressiveRenderer(mLayer, mMapDocument, &mRenderCache,
+                                                           [this] (const QRectF &rect) {
+                update(rect);
+            });
+        }
+        if (mProgressiveRenderer->draw(painter, exposed, visibleRect()))
+            return;
+    }
+
     // TODO: Display a border around the layer when selected
-    renderer->drawTileLayer(painter, mLayer, option->exposedRect);
+    mRenderCache.draw(painter, renderer, mLayer, exposed);
 }
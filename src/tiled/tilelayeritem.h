@@ -21,18 +21,39 @@
 #ifndef TILELAYERITEM_H
 #define TILELAYERITEM_H
 
+#include "tilelayerrendercache.h"
+
 #include <QGraphicsItem>
+#include <QHash>
+#include <QPoint>
+#include <QRegion>
+#include <QSet>
+#include <QVector>
 
 namespace Tiled {
 
+class Chunk;
+class Tile;
 class TileLayer;
+class Tileset;
 
 namespace Internal {
 
 class MapDocument;
+class OpenGLTileLayerRenderer;
+class ProgressiveRenderer;
 
 /**
  * A graphics item displaying a tile layer in a QGraphicsView.
+ *
+ * The layer is rendered in square chunks of device pixels, which are cached
+ * for the current zoom level and device pixel ratio. Repaints that don't change the layer, like
+ * scrolling, only need to draw the cached chunks.
+ *
+ * When the view uses an OpenGL viewport, the layer is drawn directly using
+ * OpenGL where possible, instead of using the cache. Otherwise, when enabled
+ * in the preferences, the chunks are rendered in the background and the
+ * layer is drawn progressively (see ProgressiveRenderer).
  */
 class TileLayerItem : public QGraphicsItem
 {
@@ -44,6 +65,9 @@ public:
      * @param mapDocument the map document owning the map of this layer
      */
     TileLayerItem(TileLayer *layer, MapDocument *mapDocument);
+    ~TileLayerItem();
+
+    TileLayer *tileLayer() const { return mLayer; }
 
     /**
      * Updates the size and position of this item. Should be called when the
@@ -54,6 +78,18 @@ public:
      * (when using the IsometricRenderer for example).
      */
     void syncWithTileLayer();
+    void syncVisibility();
+
+    bool coverCells(const QRect &cells);
+
+    void invalidateCache(const QRectF &rect);
+    void invalidateCache();
+    void tilesetChanged(Tileset *tileset);
+
+    void invalidateAnimatedCells(const QRegion &region);
+    bool hasAnimatedTiles();
+    void repaintTiles(const QSet<Tile*> &tiles);
+    void tileImagesChanged(Tileset *tileset, const QSet<const Tile*> &tiles);
 
     // QGraphicsItem
     QRectF boundingRect() const override;
@@ -62,9 +98,57 @@ public:
                QWidget *widget = nullptr) override;
 
 private:
+    bool usesTileset(Tileset *tileset);
+    QRectF cellsBoundingRect(const QRect &cells) const;
+    void repaintCells(const QRect &cells);
+    void setUpToDateRect(const QRectF &rect);
+    void setAnimationsUpToDateRect(const QRectF &rect);
+
+    QRectF visibleRect() const;
+    QRect visibleTileRect(const QRectF &rect) const;
+    void invalidateOutdatedArea(const QRectF &exposed);
+    void invalidateAnimatedChunks(const QRectF &rect);
+
+    void updateAnimatedCells();
+    void addAnimatedCells(const QPoint &chunkPos, const Chunk &chunk);
+    void removeAnimatedCells(const QPoint &chunkPos);
+
+    struct AnimatedCell {
+        Tile *tile;
+        int index;      // The index of the cell within its chunk
+    };
+
     TileLayer *mLayer;
     MapDocument *mMapDocument;
     QRectF mBoundingRect;
+    QRect mCellBounds;
+    bool mDrawMarginsIncluded;
+
+    TileLayerRenderCache mRenderCache;
+    ProgressiveRenderer *mProgressiveRenderer;
+    QSet<Tileset*> mUsedTilesets;
+    bool mUsedTilesetsDirty;
+
+    // The cells showing animated tiles in each chunk of the layer, and the
+    // number of chunks using each animated tile
+    QHash<QPoint, QVector<AnimatedCell>> mAnimatedCells;
+    QHash<Tile*, int> mAnimatedTileChunkCounts;
+    QSet<QPoint> mDirtyAnimatedChunks;
+    bool mAnimatedCellsDirty;
+
+    // The area that is up to date, when tile images have changed while
+    // parts of the layer were outside of the view
+    QRegion mUpToDateRegion;
+    bool mOutdatedOutsideView;
+
+    // The area in which the animated cells are up to date, when animation
+    // frames have changed while parts of the layer were outside of the view
+    QRegion mAnimationsUpToDateRegion;
+    bool mAnimationsOutdatedOutsideView;
+
+#ifndef QT_NO_OPENGL
+    OpenGLTileLayerRenderer *mOpenGLRenderer;
+#endif
 };
 
 } // namespace Internal
@@ -21,9 +21,15 @@
 
 #include "tilepainter.h"
 
+#include "floodfill.h"
 #include "mapdocument.h"
 #include "map.h"
 
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <functional>
+
 using namespace Tiled;
 using namespace Tiled::Internal;
 
@@ -52,6 +58,36 @@ private:
     const QMargins mDrawMargins;
 };
 
+class LayerTask : public QRunnable
+{
+public:
+    LayerTask(const std::function<void()> &function)
+        : mFunction(function)
+    {}
+
+    void run() override { mFunction(); }
+
+private:
+    std::function<void()> mFunction;
+};
+
+/**
+ * Calls \a function for each index up to \a count, in parallel. Returns once
+ * all calls have finished.
+ */
+void forEachInParallel(int count, const std::function<void(int)> &function)
+{
+    if (count == 1) {
+        function(0);
+        return;
+    }
+
+    QThreadPool threadPool;
+    for (int i = 0; i < count; ++i)
+        threadPool.start(new LayerTask([=] { function(i); }));
+    threadPool.waitForDone();
+}
+
 } // anonymous namespace
 
 
@@ -66,7 +102,7 @@ Cell TilePainter::cellAt(int x, int y) const
     const int layerX = x - mTileLayer->x();
     const int layerY = y - mTileLayer->y();
 
-    if (!mTileLayer->contains(layerX, layerY))
+    if (!mTileLayer->isInfinite() && !mTileLayer->contains(layerX, layerY))
         return Cell();
 
     return mTileLayer->cellAt(layerX, layerY);
@@ -81,7 +117,7 @@ void TilePainter::setCell(int x, int y, const Cell &cell)
     const int layerX = x - mTileLayer->x();
     const int layerY = y - mTileLayer->y();
 
-    if (!mTileLayer->contains(layerX, layerY))
+    if (!mTileLayer->isInfinite() && !mTileLayer->contains(layerX, layerY))
         return;
 
     DrawMarginsWatcher watcher(mMapDocument, mTileLayer);
@@ -119,6 +155,7 @@ void TilePainter::drawCells(int x, int y, TileLayer *tileLayer)
         return;
 
     DrawMarginsWatcher watcher(mMapDocument, mTileLayer);
+    TileLayer::BulkEdit bulkEdit(mTileLayer);
 
     for (const QRect &rect : region.rects()) {
         for (int _y = rect.top(); _y <= rect.bottom(); ++_y) {
@@ -149,6 +186,7 @@ void TilePainter::drawStamp(const TileLayer *stamp,
         return;
 
     DrawMarginsWatcher watcher(mMapDocument, mTileLayer);
+    TileLayer::BulkEdit bulkEdit(mTileLayer);
 
     const int w = stamp->width();
     const int h = stamp->height();
@@ -183,126 +221,92 @@ void TilePainter::erase(const QRegion &region)
     mMapDocument->emitRegionChanged(paintable, mTileLayer);
 }
 
-static QRegion fillRegion(const TileLayer *layer, QPoint fillOrigin)
+TileMask TilePainter::computeFillMask(const TileLayer *layer,
+                                      const QPoint &mapFillOrigin,
+                                      const QAtomicInt *canceled)
 {
-    // Create that region that will hold the fill
-    QRegion fillRegion;
+    const QPoint fillOrigin = mapFillOrigin - layer->position();
 
     // Silently quit if parameters are unsatisfactory
     if (!layer->contains(fillOrigin))
-        return fillRegion;
+        return TileMask();
 
     // Cache cell that we will match other cells against
     const Cell matchCell = layer->cellAt(fillOrigin);
+    const int layerX = layer->x();
+    const int layerY = layer->y();
 
-    // Grab map dimensions for later use.
-    const int layerWidth = layer->width();
-    const int layerHeight = layer->height();
-    const int layerSize = layerWidth * layerHeight;
-
-    // Create a queue to hold cells that need filling
-    QList<QPoint> fillPositions;
-    fillPositions.append(fillOrigin);
-
-    // Create an array that will store which cells have been processed
-    // This is faster than checking if a given cell is in the region/list
-    QVector<quint8> processedCellsVec(layerSize);
-    quint8 *processedCells = processedCellsVec.data();
-
-    // Loop through queued positions and fill them, while at the same time
-    // checking adjacent positions to see if they should be added
-    while (!fillPositions.empty()) {
-        const QPoint currentPoint = fillPositions.takeFirst();
-        const int startOfLine = currentPoint.y() * layerWidth;
-
-        // Seek as far left as we can
-        int left = currentPoint.x();
-        while (left > 0 && layer->cellAt(left - 1, currentPoint.y()) == matchCell)
-            --left;
-
-        // Seek as far right as we can
-        int right = currentPoint.x();
-        while (right + 1 < layerWidth && layer->cellAt(right + 1, currentPoint.y()) == matchCell)
-            ++right;
-
-        // Add cells between left and right to the region
-        fillRegion += QRegion(left, currentPoint.y(), right - left + 1, 1);
-
-        // Add cell strip to processed cells
-        memset(&processedCells[startOfLine + left],
-               1,
-               right - left);
-
-        // These variables cache whether the last cell was added to the queue
-        // or not as an optimization, since adjacent cells on the x axis
-        // do not need to be added to the queue.
-        bool lastAboveCell = false;
-        bool lastBelowCell = false;
-
-        // Loop between left and right and check if cells above or
-        // below need to be added to the queue
-        for (int x = left; x <= right; ++x) {
-            const QPoint fillPoint(x, currentPoint.y());
-
-            // Check cell above
-            if (fillPoint.y() > 0) {
-                QPoint aboveCell(fillPoint.x(), fillPoint.y() - 1);
-                if (!processedCells[aboveCell.y() * layerWidth + aboveCell.x()] &&
-                    layer->cellAt(aboveCell) == matchCell)
-                {
-                    // Do not add the above cell to the queue if its
-                    // x-adjacent cell was added.
-                    if (!lastAboveCell)
-                        fillPositions.append(aboveCell);
-
-                    lastAboveCell = true;
-                } else {
-                    lastAboveCell = false;
-                }
-
-                processedCells[aboveCell.y() * layerWidth + aboveCell.x()] = 1;
-            }
+    return floodFill(QRect(layer->position(), layer->size()), mapFillOrigin,
+                     [&] (int x, int y) {
+        return layer->cellAt(x - layerX, y - layerY) == matchCell;
+    }, canceled);
+}
 
-            // Check cell below
-            if (fillPoint.y() + 1 < layerHeight) {
-                QPoint belowCell(fillPoint.x(), fillPoint.y() + 1);
-                if (!processedCells[belowCell.y() * layerWidth + belowCell.x()] &&
-                    layer->cellAt(belowCell) == matchCell)
-                {
-                    // Do not add the below cell to the queue if its
-                    // x-adjacent cell was added.
-                    if (!lastBelowCell)
-                        fillPositions.append(belowCell);
-
-                    lastBelowCell = true;
-                } else {
-                    lastBelowCell = false;
-                }
-
-                processedCells[belowCell.y() * layerWidth + belowCell.x()] = 1;
-            }
-        }
+TileMask TilePainter::computeMatchMask(const QList<TileLayer*> &layers,
+                                       const QPoint &origin)
+{
+    QVector<const TileLayer*> matchLayers;
+    QVector<Cell> matchCells;
+
+    for (const TileLayer *layer : layers) {
+        const QPoint pos = origin - layer->position();
+        if (!layer->contains(pos))
+            continue;
+
+        // The cells of the layers are loaded on the main thread
+        layer->load();
+
+        matchLayers.append(layer);
+        matchCells.append(layer->cellAt(pos));
     }
 
-    return fillRegion;
+    if (matchLayers.isEmpty())
+        return TileMask();
+
+    QVector<TileMask> masks(matchLayers.size());
+    TileMask *layerMasks = masks.data();
+
+    forEachInParallel(matchLayers.size(), [&] (int i) {
+        layerMasks[i] = matchLayers.at(i)->cellMask(matchCells.at(i));
+    });
+
+    TileMask mask = masks.first();
+    for (int i = 1; i < masks.size() && !mask.isEmpty(); ++i)
+        mask &= masks.at(i);
+
+    return mask;
+}
+
+TileMask TilePainter::computeFillMask(const QList<TileLayer*> &layers,
+                                      const QPoint &fillOrigin)
+{
+    const TileMask matches = computeMatchMask(layers, fillOrigin);
+    if (!matches.contains(fillOrigin))
+        return TileMask();
+
+    return floodFill(matches.boundingRect(), fillOrigin,
+                     [&] (int x, int y) { return matches.contains(x, y); });
 }
 
 QRegion TilePainter::computePaintableFillRegion(const QPoint &fillOrigin) const
 {
-    QRegion region = fillRegion(mTileLayer, fillOrigin - mTileLayer->position());
-    region.translate(mTileLayer->position());
+    TileMask mask = computeFillMask(fillOrigin);
 
     const QRegion &selection = mMapDocument->selectedArea();
     if (!selection.isEmpty())
-        region &= selection;
+        mask &= TileMask(selection);
 
-    return region;
+    return mask.toRegion();
 }
 
 QRegion TilePainter::computeFillRegion(const QPoint &fillOrigin) const
 {
-    QRegion region = fillRegion(mTileLayer, fillOrigin - mTileLayer->position());
-    return region.translated(mTileLayer->position());
+    return computeFillMask(fillOrigin).toRegion();
+}
+
+TileMask TilePainter::computeFillMask(const QPoint &fillOrigin) const
+{
+    return computeFillMask(mTileLayer, fillOrigin);
 }
 
 bool TilePainter::isDrawable(int x, int y) const
@@ -314,7 +318,7 @@ bool TilePainter::isDrawable(int x, int y) const
     const int layerX = x - mTileLayer->x();
     const int layerY = y - mTileLayer->y();
 
-    if (!mTileLayer->contains(layerX, layerY))
+    if (!mTileLayer->isInfinite() && !mTileLayer->contains(layerX, layerY))
         return false;
 
     return true;
@@ -322,8 +326,10 @@ bool TilePainter::isDrawable(int x, int y) const
 
 QRegion TilePainter::paintableRegion(const QRegion &region) const
 {
-    const QRegion bounds = QRegion(mTileLayer->bounds());
-    QRegion intersection = bounds.intersected(region);
+    // Infinite layers can be painted anywhere
+    QRegion intersection = region;
+    if (!mTileLayer->isInfinite())
+        intersection &= mTileLayer->bounds();
 
     const QRegion &selection = mMapDocument->selectedArea();
     if (!selection.isEmpty())
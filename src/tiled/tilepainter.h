@@ -24,6 +24,7 @@
 
 #include "tilelayer.h"
 
+#include <QAtomicInt>
 #include <QRegion>
 
 namespace Tiled {
@@ -106,6 +107,42 @@ public:
      */
     QRegion computeFillRegion(const QPoint &fillOrigin) const;
 
+    /**
+     * Same as computeFillRegion(), but returns the result as a mask, which
+     * can be combined with other masks cheaply.
+     */
+    TileMask computeFillMask(const QPoint &fillOrigin) const;
+
+    /**
+     * Computes the fill mask for the given \a layer, made up of all cells
+     * of the same type as that at \a fillOrigin that are connected. The
+     * origin and the returned mask are in map coordinates.
+     *
+     * Only reads from the layer, so it may be called from a worker thread
+     * on a copy of the layer. Returns an empty mask early when \a canceled
+     * gets set.
+     */
+    static TileMask computeFillMask(const TileLayer *layer,
+                                    const QPoint &fillOrigin,
+                                    const QAtomicInt *canceled = nullptr);
+
+    /**
+     * Computes the mask of all positions where each of the given \a layers
+     * has the same cell as at \a origin, in map coordinates. Layers that
+     * don't contain the origin are ignored.
+     *
+     * The layers are scanned in parallel.
+     */
+    static TileMask computeMatchMask(const QList<TileLayer*> &layers,
+                                     const QPoint &origin);
+
+    /**
+     * Same as computeMatchMask(), but only includes the positions connected
+     * to \a fillOrigin.
+     */
+    static TileMask computeFillMask(const QList<TileLayer*> &layers,
+                                    const QPoint &fillOrigin);
+
     /**
      * Returns true if the given cell is drawable.
      */
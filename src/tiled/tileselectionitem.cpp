@@ -32,6 +32,20 @@
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+static const int ChunkSize = 64;
+
+static QRect chunkRect(const QPoint &chunk)
+{
+    return QRect(chunk.x() * ChunkSize, chunk.y() * ChunkSize,
+                 ChunkSize, ChunkSize);
+}
+
+static int chunkIndex(int tile)
+{
+    // Rounds towards negative infinity, unlike plain division
+    return tile >= 0 ? tile / ChunkSize : (tile + 1) / ChunkSize - 1;
+}
+
 TileSelectionItem::TileSelectionItem(MapDocument *mapDocument)
     : mMapDocument(mapDocument)
 {
@@ -41,6 +55,8 @@ TileSelectionItem::TileSelectionItem(MapDocument *mapDocument)
             this, &TileSelectionItem::selectionChanged);
     connect(mMapDocument, &MapDocument::currentLayerIndexChanged,
             this, &TileSelectionItem::currentLayerIndexChanged);
+    connect(mMapDocument, &MapDocument::mapChanged,
+            this, &TileSelectionItem::mapChanged);
 
     updateBoundingRect();
 }
@@ -54,13 +70,33 @@ void TileSelectionItem::paint(QPainter *painter,
                               const QStyleOptionGraphicsItem *option,
                               QWidget *)
 {
-    const QRegion &selection = mMapDocument->selectedArea();
+    const QRect bounds = mMapDocument->selectedArea().boundingRect();
+    if (bounds.isEmpty())
+        return;
+
     QColor highlight = QApplication::palette().highlight().color();
     highlight.setAlpha(128);
 
-    MapRenderer *renderer = mMapDocument->renderer();
-    renderer->drawTileSelection(painter, selection, highlight,
-                                option->exposedRect);
+    const MapRenderer *renderer = mMapDocument->renderer();
+    const QRectF &exposed = option->exposedRect;
+
+    const int startX = chunkIndex(bounds.left());
+    const int startY = chunkIndex(bounds.top());
+    const int endX = chunkIndex(bounds.right());
+    const int endY = chunkIndex(bounds.bottom());
+
+    for (int y = startY; y <= endY; ++y) {
+        for (int x = startX; x <= endX; ++x) {
+            const QPoint chunk(x, y);
+            const QRect rect = chunkRect(chunk) & bounds;
+            if (!QRectF(renderer->boundingRect(rect)).intersects(exposed))
+                continue;
+
+            const QPainterPath &shape = chunkShape(chunk);
+            if (!shape.isEmpty())
+                painter->fillPath(shape, highlight);
+        }
+    }
 }
 
 void TileSelectionItem::selectionChanged(const QRegion &newSelection,
@@ -69,9 +105,16 @@ void TileSelectionItem::selectionChanged(const QRegion &newSelection,
     prepareGeometryChange();
     updateBoundingRect();
 
+    // Only the chunks touched by the change need their shape recomputed
+    const QRegion changed = newSelection.xored(oldSelection);
+    foreach (const QRect &r, changed.rects()) {
+        for (int y = chunkIndex(r.top()); y <= chunkIndex(r.bottom()); ++y)
+            for (int x = chunkIndex(r.left()); x <= chunkIndex(r.right()); ++x)
+                mChunkShapes.remove(QPoint(x, y));
+    }
+
     // Make sure changes within the bounding rect are updated
-    const QRect changedArea = newSelection.xored(oldSelection).boundingRect();
-    update(mMapDocument->renderer()->boundingRect(changedArea));
+    update(mMapDocument->renderer()->boundingRect(changed.boundingRect()));
 }
 
 void TileSelectionItem::currentLayerIndexChanged()
@@ -80,8 +123,31 @@ void TileSelectionItem::currentLayerIndexChanged()
         setPos(layer->offset());
 }
 
+void TileSelectionItem::mapChanged()
+{
+    // The tile size or orientation may have changed
+    mChunkShapes.clear();
+
+    prepareGeometryChange();
+    updateBoundingRect();
+}
+
 void TileSelectionItem::updateBoundingRect()
 {
     const QRect b = mMapDocument->selectedArea().boundingRect();
     mBoundingRect = mMapDocument->renderer()->boundingRect(b);
 }
+
+/**
+ * Returns the shape of the selected tiles within the given \a chunk,
+ * computing it when it is not cached.
+ */
+const QPainterPath &TileSelectionItem::chunkShape(const QPoint &chunk)
+{
+    auto it = mChunkShapes.find(chunk);
+    if (it == mChunkShapes.end()) {
+        const QRegion region = mMapDocument->selectedArea() & chunkRect(chunk);
+        it = mChunkShapes.insert(chunk, mMapDocument->renderer()->tileRegionShape(region));
+    }
+    return it.value();
+}
@@ -21,7 +21,11 @@
 #ifndef TILESELECTIONITEM_H
 #define TILESELECTIONITEM_H
 
+#include "tilemask.h"
+
 #include <QGraphicsObject>
+#include <QHash>
+#include <QPainterPath>
 
 namespace Tiled {
 namespace Internal {
@@ -30,6 +34,10 @@ class MapDocument;
 
 /**
  * A graphics item displaying a tile selection.
+ *
+ * The shape of the selection is cached in chunks of tiles, so that it only
+ * needs to be computed again for the chunks touched by a selection change.
+ * Since the shape is in scene coordinates, it remains valid when zooming.
  */
 class TileSelectionItem : public QGraphicsObject
 {
@@ -50,12 +58,15 @@ private slots:
                           const QRegion &oldSelection);
 
     void currentLayerIndexChanged();
+    void mapChanged();
 
 private:
     void updateBoundingRect();
+    const QPainterPath &chunkShape(const QPoint &chunk);
 
     MapDocument *mMapDocument;
     QRectF mBoundingRect;
+    QHash<QPoint, QPainterPath> mChunkShapes;
 };
 
 } // namespace Internal
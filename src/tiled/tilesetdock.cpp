@@ -70,6 +70,12 @@ using namespace Tiled::Internal;
 
 namespace {
 
+/**
+ * The number of tileset views kept around after they have been shown. Views
+ * of other tilesets are created again when their tab is selected.
+ */
+const int MaxCachedTilesetViews = 8;
+
 /**
  * Used for exporting/importing tilesets.
  *
@@ -288,6 +294,8 @@ TilesetDock::TilesetDock(QWidget *parent):
 
     connect(TilesetManager::instance(), SIGNAL(tilesetChanged(Tileset*)),
             this, SLOT(tilesetChanged(Tileset*)));
+    connect(TilesetManager::instance(), &TilesetManager::tileImagesChanged,
+            this, &TilesetDock::tileImagesChanged);
 
     connect(DocumentManager::instance(), SIGNAL(documentAboutToClose(MapDocument*)),
             SLOT(documentAboutToClose(MapDocument*)));
@@ -327,12 +335,13 @@ void TilesetDock::setMapDocument(MapDocument *mapDocument)
     }
 
     // Clear previous content
+    qDeleteAll(mTilesetViews);
+    mTilesetViews.clear();
+    mRecentViews.clear();
+    mTilesets.clear();
+
     while (mTabBar->count())
         mTabBar->removeTab(0);
-    while (mViewStack->count())
-        delete mViewStack->widget(0);
-
-    mTilesets.clear();
 
     // Clear all connections to the previous document
     if (mMapDocument)
@@ -343,14 +352,11 @@ void TilesetDock::setMapDocument(MapDocument *mapDocument)
     if (mMapDocument) {
         mTilesets = mMapDocument->map()->tilesets();
 
-        foreach (const SharedTileset &tileset, mTilesets) {
-            TilesetView *view = new TilesetView;
-            view->setMapDocument(mMapDocument);
-            view->setZoomable(mZoomable);
+        // The views are only created once their tab is shown
+        mTilesetViews.fill(nullptr, mTilesets.size());
 
+        foreach (const SharedTileset &tileset, mTilesets)
             mTabBar->addTab(tileset->name());
-            mViewStack->addWidget(view);
-        }
 
         connect(mMapDocument, SIGNAL(tilesetAdded(int,Tileset*)),
                 SLOT(tilesetAdded(int,Tileset*)));
@@ -411,10 +417,7 @@ void TilesetDock::selectTilesInStamp(const TileStamp &stamp)
                 Tileset *tileset = tile->tileset();
                 int tilesetIndex = mTilesets.indexOf(tileset->sharedPointer());
                 if (tilesetIndex != -1) {
-                    TilesetView *view = tilesetViewAt(tilesetIndex);
-                    if (!view->model()) // Lazily set up the model
-                        setupTilesetModel(view, tileset);
-
+                    TilesetView *view = ensureTilesetView(tilesetIndex);
                     const TilesetModel *model = view->tilesetModel();
                     const QModelIndex modelIndex = model->tileIndex(tile);
                     QItemSelectionModel *selectionModel = view->selectionModel();
@@ -516,19 +519,16 @@ void TilesetDock::updateActions()
     TilesetView *view = nullptr;
     const int index = mTabBar->currentIndex();
 
-    if (index > -1) {
-        view = tilesetViewAt(index);
-        if (view) {
-            Tileset *tileset = mTilesets.at(index).data();
+    if (index > -1 && index < mTilesets.size()) {
+        view = ensureTilesetView(index);
+        Tileset *tileset = mTilesets.at(index).data();
 
-            if (!view->model()) // Lazily set up the model
-                setupTilesetModel(view, tileset);
+        mViewStack->setCurrentWidget(view);
+        releaseUnusedViews();
 
-            mViewStack->setCurrentIndex(index);
-            external = tileset->isExternal();
-            hasImageSource = !tileset->imageSource().isEmpty();
-            hasSelection = view->selectionModel()->hasSelection();
-        }
+        external = tileset->isExternal();
+        hasImageSource = !tileset->imageSource().isEmpty();
+        hasSelection = view->selectionModel()->hasSelection();
     }
 
     const bool tilesetIsDisplayed = view != nullptr;
@@ -596,13 +596,9 @@ void TilesetDock::indexPressed(const QModelIndex &index)
 
 void TilesetDock::tilesetAdded(int index, Tileset *tileset)
 {
-    TilesetView *view = new TilesetView;
-    view->setMapDocument(mMapDocument);
-    view->setZoomable(mZoomable);
-
     mTilesets.insert(index, tileset->sharedPointer());
+    mTilesetViews.insert(index, nullptr);
     mTabBar->insertTab(index, tileset->name());
-    mViewStack->insertWidget(index, view);
 
     updateActions();
 }
@@ -614,8 +610,18 @@ void TilesetDock::tilesetChanged(Tileset *tileset)
     if (index < 0)
         return;
 
-    if (TilesetModel *model = tilesetViewAt(index)->tilesetModel())
-        model->tilesetChanged();
+    if (TilesetView *view = tilesetViewAt(index))
+        view->tilesetModel()->tilesetChanged();
+}
+
+void TilesetDock::tileImagesChanged(Tileset *tileset, const QList<Tile*> &tiles)
+{
+    const int index = indexOf(mTilesets, tileset);
+    if (index < 0)
+        return;
+
+    if (TilesetView *view = tilesetViewAt(index))
+        view->tilesetModel()->tilesChanged(tiles);
 }
 
 void TilesetDock::tilesetRemoved(Tileset *tileset)
@@ -624,9 +630,11 @@ void TilesetDock::tilesetRemoved(Tileset *tileset)
     const int index = indexOf(mTilesets, tileset);
     Q_ASSERT(index != -1);
 
+    TilesetView *view = mTilesetViews.takeAt(index);
+    mRecentViews.removeOne(view);
     mTilesets.remove(index);
     mTabBar->removeTab(index);
-    delete tilesetViewAt(index);
+    delete view;
 
     // Make sure we don't reference this tileset anymore
     if (mCurrentTiles) {
@@ -646,17 +654,19 @@ void TilesetDock::tilesetMoved(int from, int to)
 {
 #if QT_VERSION >= 0x050200
     mTilesets.insert(to, mTilesets.takeAt(from));
+    mTilesetViews.insert(to, mTilesetViews.takeAt(from));
 #else
     SharedTileset tileset = mTilesets.at(from);
     mTilesets.remove(from);
     mTilesets.insert(to, tileset);
+
+    TilesetView *view = mTilesetViews.at(from);
+    mTilesetViews.remove(from);
+    mTilesetViews.insert(to, view);
 #endif
 
-    // Move the related tileset views
-    QWidget *widget = mViewStack->widget(from);
-    mViewStack->removeWidget(widget);
-    mViewStack->insertWidget(to, widget);
-    mViewStack->setCurrentIndex(mTabBar->currentIndex());
+    // Show the view of the tileset that is now at the current tab
+    updateActions();
 
     // Update the titles of the affected tabs
     const int start = qMin(from, to);
@@ -673,9 +683,9 @@ void TilesetDock::tilesetMoved(int from, int to)
  */
 void TilesetDock::removeTileset()
 {
-    const int currentIndex = mViewStack->currentIndex();
+    const int currentIndex = mTabBar->currentIndex();
     if (currentIndex != -1)
-        removeTileset(mViewStack->currentIndex());
+        removeTileset(currentIndex);
 }
 
 /**
@@ -802,9 +812,64 @@ TilesetView *TilesetDock::currentTilesetView() const
     return static_cast<TilesetView *>(mViewStack->currentWidget());
 }
 
+/**
+ * Returns the view of the tileset at the given index, or null when it has not
+ * been created yet or has been released.
+ */
 TilesetView *TilesetDock::tilesetViewAt(int index) const
 {
-    return static_cast<TilesetView *>(mViewStack->widget(index));
+    return mTilesetViews.at(index);
+}
+
+/**
+ * Returns the view of the tileset at the given index, creating it when
+ * necessary. The view is marked as the most recently used one.
+ */
+TilesetView *TilesetDock::ensureTilesetView(int index)
+{
+    TilesetView *view = mTilesetViews.at(index);
+
+    if (view) {
+        mRecentViews.removeOne(view);
+    } else {
+        view = new TilesetView;
+        view->setMapDocument(mMapDocument);
+        view->setZoomable(mZoomable);
+        setupTilesetModel(view, mTilesets.at(index).data());
+
+        mViewStack->addWidget(view);
+        mTilesetViews[index] = view;
+    }
+
+    mRecentViews.prepend(view);
+    return view;
+}
+
+/**
+ * Deletes the views that have not been shown recently, to avoid keeping the
+ * laid out tiles of all the tilesets in memory. The shown view is never
+ * released.
+ *
+ * Does nothing while synchronizing the selection, since the views are still
+ * being referenced in that case.
+ */
+void TilesetDock::releaseUnusedViews()
+{
+    if (mSynchronizingSelection)
+        return;
+
+    const QWidget *current = mViewStack->currentWidget();
+
+    for (int i = mRecentViews.size() - 1;
+         i >= 0 && mRecentViews.size() > MaxCachedTilesetViews; --i) {
+        TilesetView *view = mRecentViews.at(i);
+        if (view == current)
+            continue;
+
+        mRecentViews.removeAt(i);
+        mTilesetViews[mTilesetViews.indexOf(view)] = nullptr;
+        delete view;
+    }
 }
 
 void TilesetDock::setupTilesetModel(TilesetView *view, Tileset *tileset)
@@ -117,6 +117,7 @@ private slots:
 
     void tilesetAdded(int index, Tileset *tileset);
     void tilesetChanged(Tileset *tileset);
+    void tileImagesChanged(Tileset *tileset, const QList<Tile*> &tiles);
     void tilesetRemoved(Tileset *tileset);
     void tilesetMoved(int from, int to);
     void tilesetNameChanged(Tileset *tileset);
@@ -146,6 +147,8 @@ private:
     Tileset *currentTileset() const;
     TilesetView *currentTilesetView() const;
     TilesetView *tilesetViewAt(int index) const;
+    TilesetView *ensureTilesetView(int index);
+    void releaseUnusedViews();
 
     void setupTilesetModel(TilesetView *view, Tileset *tileset);
 
@@ -154,6 +157,10 @@ private:
     // Shared tileset references because the dock wants to add new tiles
     QVector<SharedTileset> mTilesets;
 
+    // The views of the tilesets, null when not created or released
+    QVector<TilesetView*> mTilesetViews;
+    QList<TilesetView*> mRecentViews;    // most recently shown first
+
     QTabBar *mTabBar;
     QStackedWidget *mViewStack;
     QToolBar *mToolBar;
@@ -24,34 +24,77 @@
 #include "filesystemwatcher.h"
 #include "tileanimationdriver.h"
 #include "tile.h"
+#include "tracing.h"
 
 #include <QImage>
+#include <QRunnable>
+
+#include <algorithm>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+namespace {
+
+/**
+ * Loads a tileset image that was unloaded to save memory, in a worker
+ * thread. The image is passed back to the tileset manager on the GUI thread.
+ */
+class TilesetImageLoader : public QRunnable
+{
+public:
+    TilesetImageLoader(QObject *receiver, const QString &fileName)
+        : mReceiver(receiver)
+        , mFileName(fileName)
+    {}
+
+    void run() override
+    {
+        const QImage image(mFileName);
+        QMetaObject::invokeMethod(mReceiver, "tilesetImageLoaded",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QString, mFileName),
+                                  Q_ARG(QImage, image));
+    }
+
+private:
+    QObject *mReceiver;
+    const QString mFileName;
+};
+
+} // anonymous namespace
+
 TilesetManager *TilesetManager::mInstance;
 
 TilesetManager::TilesetManager():
     mWatcher(new FileSystemWatcher(this)),
     mAnimationDriver(new TileAnimationDriver(this)),
-    mReloadTilesetsOnChange(false)
+    mReloadTilesetsOnChange(false),
+    mAnimateTiles(false),
+    mImageCacheSweep(0),
+    mImageCacheLimit(0),
+    mSuspendCount(0),
+    mSuspendedAnimationTime(0)
 {
-    connect(mWatcher, SIGNAL(fileChanged(QString)),
-            this, SLOT(fileChanged(QString)));
+    // Image files are often rewritten by export pipelines without changes
+    mWatcher->setCompareContents(true);
 
-    mChangedFilesTimer.setInterval(500);
-    mChangedFilesTimer.setSingleShot(true);
-
-    connect(&mChangedFilesTimer, SIGNAL(timeout()),
-            this, SLOT(fileChangedTimeout()));
+    connect(mWatcher, SIGNAL(filesChanged(QStringList)),
+            this, SLOT(filesChanged(QStringList)));
 
     connect(mAnimationDriver, SIGNAL(update(int)),
             this, SLOT(advanceTileAnimations(int)));
+
+    mImageCacheTimer.setInterval(1000);
+
+    connect(&mImageCacheTimer, SIGNAL(timeout()),
+            this, SLOT(sweepImageCache()));
 }
 
 TilesetManager::~TilesetManager()
 {
+    mImageThreadPool.waitForDone();
+
     // Since all MapDocuments should be deleted first, we assert that there are
     // no remaining tileset references.
     Q_ASSERT(mTilesets.size() == 0);
@@ -73,23 +116,23 @@ void TilesetManager::deleteInstance()
 
 SharedTileset TilesetManager::findTileset(const QString &fileName) const
 {
-    foreach (const SharedTileset &tileset, tilesets())
+    for (Tileset *tileset : mTilesetsByFileName.values(fileName))
         if (tileset->fileName() == fileName)
-            return tileset;
+            return tileset->sharedPointer();
 
     return SharedTileset();
 }
 
 SharedTileset TilesetManager::findTileset(const TilesetSpec &spec) const
 {
-    foreach (const SharedTileset &tileset, tilesets()) {
+    for (Tileset *tileset : mTilesetsByImageSource.values(spec.imageSource)) {
         if (tileset->imageSource() == spec.imageSource
             && tileset->tileWidth() == spec.tileWidth
             && tileset->tileHeight() == spec.tileHeight
             && tileset->tileSpacing() == spec.tileSpacing
             && tileset->margin() == spec.margin)
         {
-            return tileset;
+            return tileset->sharedPointer();
         }
     }
 
@@ -102,8 +145,15 @@ void TilesetManager::addReference(const SharedTileset &tileset)
         mTilesets[tileset]++;
     } else {
         mTilesets.insert(tileset, 1);
+        addToIndex(tileset.data());
+        mImageLastUsed.insert(tileset.data(), mImageCacheSweep);
+        tileset->setImageRequestHandler([this] (const Tileset &unloaded) {
+            requestTilesetImage(unloaded);
+        });
         if (!tileset->imageSource().isEmpty())
             mWatcher->addPath(tileset->imageSource());
+        if (!tileset->animatedTiles().isEmpty())
+            updateAnimationDriver();
     }
 }
 
@@ -114,8 +164,13 @@ void TilesetManager::removeReference(const SharedTileset &tileset)
 
     if (mTilesets.value(tileset) == 0) {
         mTilesets.remove(tileset);
+        removeFromIndex(tileset.data());
+        mImageLastUsed.remove(tileset.data());
+        tileset->setImageRequestHandler(nullptr);
         if (!tileset->imageSource().isEmpty())
             mWatcher->removePath(tileset->imageSource());
+        if (!tileset->animatedTiles().isEmpty())
+            updateAnimationDriver();
     }
 }
 
@@ -142,10 +197,21 @@ void TilesetManager::forceTilesetReload(SharedTileset &tileset)
         return;
 
     QString fileName = tileset->imageSource();
+    TraceScope trace("TilesetManager::forceTilesetReload", fileName);
+
     if (tileset->loadFromImage(fileName))
         emit tilesetChanged(tileset.data());
 }
 
+void TilesetManager::tilesetFileNameChanged(Tileset *tileset)
+{
+    if (!mIndexedNames.contains(tileset))
+        return;
+
+    removeFromIndex(tileset);
+    addToIndex(tileset);
+}
+
 void TilesetManager::setReloadTilesetsOnChange(bool enabled)
 {
     mReloadTilesetsOnChange = enabled;
@@ -154,55 +220,288 @@ void TilesetManager::setReloadTilesetsOnChange(bool enabled)
 
 void TilesetManager::setAnimateTiles(bool enabled)
 {
-    // TODO: Avoid running the driver when there are no animated tiles
-    if (enabled)
-        mAnimationDriver->start();
+    if (mAnimateTiles == enabled)
+        return;
+
+    mAnimateTiles = enabled;
+    updateAnimationDriver();
+
+    emit animateTilesChanged(enabled);
+}
+
+void TilesetManager::tileAnimationChanged(Tile *tile)
+{
+    if (mTilesets.contains(tile->sharedTileset()))
+        updateAnimationDriver();
+}
+
+void TilesetManager::setImageCacheLimit(qint64 bytes)
+{
+    mImageCacheLimit = bytes;
+
+    if (bytes > 0)
+        mImageCacheTimer.start();
     else
-        mAnimationDriver->stop();
+        mImageCacheTimer.stop();
+}
+
+qint64 TilesetManager::memoryUsage() const
+{
+    qint64 usage = 0;
+    for (auto it = mTilesets.constBegin(); it != mTilesets.constEnd(); ++it)
+        usage += it.key()->memoryUsage();
+    return usage;
 }
 
-bool TilesetManager::animateTiles() const
+bool TilesetManager::hasAnimatedTiles() const
 {
-    return mAnimationDriver->state() == QAbstractAnimation::Running;
+    for (auto it = mTilesets.constBegin(); it != mTilesets.constEnd(); ++it)
+        if (!it.key()->animatedTiles().isEmpty())
+            return true;
+
+    return false;
 }
 
-void TilesetManager::fileChanged(const QString &path)
+/**
+ * Only runs the animation driver when tile animations are enabled and any
+ * of the tilesets has animated tiles.
+ */
+void TilesetManager::updateAnimationDriver()
+{
+    const bool run = mAnimateTiles && hasAnimatedTiles();
+    const bool running = mAnimationDriver->state() == QAbstractAnimation::Running;
+
+    if (run && !running)
+        mAnimationDriver->start();
+    else if (!run && running)
+        mAnimationDriver->stop();
+}
+
+/**
+ * Reloads the tilesets using the changed images. The watcher only reports
+ * the changes once they have settled, since GIMP (for example) seems to
+ * generate many file changes during a save, and some of the intermediate
+ * attempts to reload the tileset images actually fail (at least for .png
+ * files).
+ */
+void TilesetManager::filesChanged(const QStringList &fileNames)
 {
     if (!mReloadTilesetsOnChange)
         return;
 
-    /*
-     * Use a one-shot timer since GIMP (for example) seems to generate many
-     * file changes during a save, and some of the intermediate attempts to
-     * reload the tileset images actually fail (at least for .png files).
-     */
-    mChangedFiles.insert(path);
-    mChangedFilesTimer.start();
+    if (mSuspendCount > 0) {
+        for (const QString &fileName : fileNames)
+            if (!mSuspendedFileChanges.contains(fileName))
+                mSuspendedFileChanges.append(fileName);
+        return;
+    }
+
+    for (const QString &fileName : fileNames) {
+        const QList<Tileset*> tilesets = mTilesetsByImageSource.values(fileName);
+        if (tilesets.isEmpty())
+            continue;
+
+        TraceScope trace("TilesetManager::reloadTilesetImage", fileName);
+
+        const QImage image(fileName);
+
+        for (Tileset *tileset : tilesets)
+            if (tileset->imageSource() == fileName)
+                reloadTilesetImage(tileset, image);
+    }
+}
+
+/**
+ * Updates the \a tileset with the changed version of its \a image. When
+ * the image size is still the same, only the changed tiles are reported.
+ */
+void TilesetManager::reloadTilesetImage(Tileset *tileset, const QImage &image)
+{
+    const QSize previousSize(tileset->imageWidth(), tileset->imageHeight());
+
+    QList<Tile*> changedTiles;
+    if (!tileset->reloadFromImage(image, &changedTiles))
+        return;
+
+    if (image.size() != previousSize)
+        emit tilesetChanged(tileset);
+    else if (!changedTiles.isEmpty())
+        emit tileImagesChanged(tileset, changedTiles);
+}
+
+/**
+ * Loads the image of the given unloaded \a tileset in the background.
+ * Tilesets sharing the same image source share the request.
+ */
+void TilesetManager::requestTilesetImage(const Tileset &tileset)
+{
+    const QString &fileName = tileset.imageSource();
+    if (mRequestedImages.contains(fileName))
+        return;
+
+    mRequestedImages.insert(fileName);
+    mImageThreadPool.start(new TilesetImageLoader(this, fileName));
+}
+
+void TilesetManager::loadTilesetImages(const QVector<SharedTileset> &tilesets)
+{
+    for (const SharedTileset &tileset : tilesets) {
+        if (!tileset->isImageLoaded())
+            tilesetImageLoaded(tileset->imageSource(), QImage(tileset->imageSource()));
+    }
 }
 
-void TilesetManager::fileChangedTimeout()
+void TilesetManager::suspendChanges()
+{
+    ++mSuspendCount;
+}
+
+void TilesetManager::resumeChanges()
+{
+    Q_ASSERT(mSuspendCount > 0);
+    if (--mSuspendCount > 0)
+        return;
+
+    const QStringList fileNames = mSuspendedFileChanges;
+    mSuspendedFileChanges.clear();
+    if (!fileNames.isEmpty())
+        filesChanged(fileNames);
+
+    const QList<QPair<QString, QImage>> images = mSuspendedImages;
+    mSuspendedImages.clear();
+    for (const auto &image : images)
+        tilesetImageLoaded(image.first, image.second);
+
+    const int ms = mSuspendedAnimationTime;
+    mSuspendedAnimationTime = 0;
+    if (ms > 0)
+        advanceTileAnimations(ms);
+}
+
+void TilesetManager::tilesetImageLoaded(const QString &fileName,
+                                        const QImage &image)
+{
+    if (mSuspendCount > 0) {
+        mSuspendedImages.append(qMakePair(fileName, image));
+        return;
+    }
+
+    mRequestedImages.remove(fileName);
+
+    for (Tileset *tileset : mTilesetsByImageSource.values(fileName)) {
+        if (tileset->imageSource() != fileName || tileset->isImageLoaded())
+            continue;
+
+        const QSize previousSize(tileset->imageWidth(), tileset->imageHeight());
+        if (!tileset->restoreImage(image))
+            continue;
+
+        if (image.size() != previousSize)
+            emit tilesetChanged(tileset);
+        else
+            emit tileImagesChanged(tileset, tileset->tiles());
+    }
+}
+
+/**
+ * Keeps track of which tileset images have been drawn since the last sweep,
+ * and unloads the least recently drawn ones while the loaded images use more
+ * memory than allowed.
+ *
+ * Images drawn since the last sweep are never unloaded, since they are
+ * likely still on screen.
+ */
+void TilesetManager::sweepImageCache()
 {
-    for (SharedTileset &tileset : tilesets()) {
-        QString fileName = tileset->imageSource();
-        if (mChangedFiles.contains(fileName))
-            if (tileset->loadFromImage(fileName))
-                emit tilesetChanged(tileset.data());
+    if (mSuspendCount > 0)
+        return;
+
+    ++mImageCacheSweep;
+
+    QVector<Tileset*> loaded;
+    qint64 memory = 0;
+
+    for (auto it = mTilesets.constBegin(); it != mTilesets.constEnd(); ++it) {
+        Tileset *tileset = it.key().data();
+        if (tileset->takeImageUsed())
+            mImageLastUsed.insert(tileset, mImageCacheSweep);
+
+        if (tileset->imageSource().isEmpty() || !tileset->isImageLoaded())
+            continue;
+
+        const qint64 imageMemory = tileset->imageMemory();
+        if (imageMemory == 0)
+            continue;
+
+        memory += imageMemory;
+        loaded.append(tileset);
     }
 
-    mChangedFiles.clear();
+    if (memory <= mImageCacheLimit)
+        return;
+
+    std::sort(loaded.begin(), loaded.end(), [this] (Tileset *a, Tileset *b) {
+        return mImageLastUsed.value(a) < mImageLastUsed.value(b);
+    });
+
+    for (Tileset *tileset : loaded) {
+        if (memory <= mImageCacheLimit)
+            break;
+        if (mImageLastUsed.value(tileset) == mImageCacheSweep)
+            break;
+
+        memory -= tileset->imageMemory();
+        tileset->unloadImage();
+    }
+}
+
+/**
+ * Indexes the given \a tileset by its file name and image source. The
+ * indexed names are remembered, so that the tileset can be removed from the
+ * index after they have changed.
+ */
+void TilesetManager::addToIndex(Tileset *tileset)
+{
+    const IndexedNames names = { tileset->fileName(), tileset->imageSource() };
+
+    if (!names.fileName.isEmpty())
+        mTilesetsByFileName.insert(names.fileName, tileset);
+    if (!names.imageSource.isEmpty())
+        mTilesetsByImageSource.insert(names.imageSource, tileset);
+
+    mIndexedNames.insert(tileset, names);
+}
+
+void TilesetManager::removeFromIndex(Tileset *tileset)
+{
+    const IndexedNames names = mIndexedNames.take(tileset);
+
+    mTilesetsByFileName.remove(names.fileName, tileset);
+    mTilesetsByImageSource.remove(names.imageSource, tileset);
 }
 
 void TilesetManager::advanceTileAnimations(int ms)
 {
-    // TODO: This could be more optimal by keeping track of the list of
-    // actually animated tiles
-    foreach (const SharedTileset &tileset, tilesets()) {
-        bool imageChanged = false;
+    if (mSuspendCount > 0) {
+        mSuspendedAnimationTime += ms;
+        return;
+    }
 
-        foreach (Tile *tile, tileset->tiles())
-            imageChanged |= tile->advanceAnimation(ms);
+    QSet<Tile*> changedTiles;
+    bool animatedTiles = false;
 
-        if (imageChanged)
-            emit repaintTileset(tileset.data());
+    for (auto it = mTilesets.constBegin(); it != mTilesets.constEnd(); ++it) {
+        for (Tile *tile : it.key()->animatedTiles()) {
+            if (tile->advanceAnimation(ms))
+                changedTiles.insert(tile);
+            animatedTiles = true;
+        }
     }
+
+    // Animated tiles may have been removed from their tileset
+    if (!animatedTiles)
+        mAnimationDriver->stop();
+
+    if (!changedTiles.isEmpty())
+        emit repaintTiles(changedTiles);
 }
@@ -25,10 +25,14 @@
 #include "tileset.h"
 
 #include <QObject>
+#include <QHash>
 #include <QList>
 #include <QMap>
+#include <QPair>
 #include <QString>
+#include <QStringList>
 #include <QSet>
+#include <QThreadPool>
 #include <QTimer>
 
 namespace Tiled {
@@ -117,6 +121,12 @@ public:
      */
     void forceTilesetReload(SharedTileset &tileset);
 
+    /**
+     * Should be called when the file name of the given \a tileset has
+     * changed, so that it can be found by its new file name.
+     */
+    void tilesetFileNameChanged(Tileset *tileset);
+
     /**
      * Sets whether tilesets are automatically reloaded when their tileset
      * image changes.
@@ -130,6 +140,44 @@ public:
     void setAnimateTiles(bool enabled);
     bool animateTiles() const;
 
+    /**
+     * Should be called when the animation frames of the given \a tile have
+     * changed, so that the animations are only running when there are
+     * animated tiles.
+     */
+    void tileAnimationChanged(Tile *tile);
+
+    /**
+     * Sets the number of bytes the loaded tileset images may use. When they
+     * use more, the images of the least recently drawn tilesets are
+     * unloaded. They are loaded again in the background when they are
+     * needed. A limit of 0 disables unloading.
+     */
+    void setImageCacheLimit(qint64 bytes);
+    qint64 imageCacheLimit() const;
+
+    /**
+     * Returns the approximate number of bytes used by all tilesets that are
+     * currently referenced, including their images and tiles.
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * Loads the images of the given \a tilesets that were unloaded, without
+     * waiting for them to be loaded in the background. Used before
+     * rendering the tilesets outside of the map view.
+     */
+    void loadTilesetImages(const QVector<SharedTileset> &tilesets);
+
+    /**
+     * Holds back reloading tileset images, advancing tile animations and
+     * unloading or restoring images of the image cache, while tilesets are
+     * being drawn on other threads. The held back changes are applied once
+     * every call has been balanced by a call to resumeChanges().
+     */
+    void suspendChanges();
+    void resumeChanges();
+
 signals:
     /**
      * Emitted when a tileset's images have changed and views need updating.
@@ -137,18 +185,31 @@ signals:
     void tilesetChanged(Tileset *tileset);
 
     /**
-     * Emitted when any images of the tiles in the given \a tileset have
-     * changed. This is used to trigger repaints for displaying tile
+     * Emitted when the images of the given \a tiles have changed, while the
+     * rest of their \a tileset stayed the same.
+     */
+    void tileImagesChanged(Tileset *tileset, const QList<Tile*> &tiles);
+
+    /**
+     * Emitted when the given animated \a tiles have changed to a different
+     * frame. This is used to trigger repaints for displaying tile
      * animations.
      */
-    void repaintTileset(Tileset *tileset);
+    void repaintTiles(const QSet<Tile*> &tiles);
+
+    /**
+     * Emitted when tile animations have been enabled or disabled.
+     */
+    void animateTilesChanged(bool enabled);
 
 private slots:
-    void fileChanged(const QString &path);
-    void fileChangedTimeout();
+    void filesChanged(const QStringList &fileNames);
 
     void advanceTileAnimations(int ms);
 
+    void sweepImageCache();
+    void tilesetImageLoaded(const QString &fileName, const QImage &image);
+
 private:
     Q_DISABLE_COPY(TilesetManager)
 
@@ -157,6 +218,15 @@ private:
      */
     TilesetManager();
 
+    bool hasAnimatedTiles() const;
+    void updateAnimationDriver();
+
+    void reloadTilesetImage(Tileset *tileset, const QImage &image);
+    void requestTilesetImage(const Tileset &tileset);
+
+    void addToIndex(Tileset *tileset);
+    void removeFromIndex(Tileset *tileset);
+
     /**
      * Destructor.
      */
@@ -168,16 +238,51 @@ private:
      * Stores the tilesets and maps them to the number of references.
      */
     QMap<SharedTileset, int> mTilesets;
+
+    struct IndexedNames {
+        QString fileName;
+        QString imageSource;
+    };
+
+    /**
+     * Indexes of the referenced tilesets, for finding them without having
+     * to check all tilesets.
+     */
+    QMultiHash<QString, Tileset*> mTilesetsByFileName;
+    QMultiHash<QString, Tileset*> mTilesetsByImageSource;
+    QHash<Tileset*, IndexedNames> mIndexedNames;
+
     FileSystemWatcher *mWatcher;
     TileAnimationDriver *mAnimationDriver;
-    QSet<QString> mChangedFiles;
-    QTimer mChangedFilesTimer;
     bool mReloadTilesetsOnChange;
+    bool mAnimateTiles;
+
+    /**
+     * The sweep in which each tileset image was last drawn, for unloading
+     * the least recently drawn images first.
+     */
+    QHash<Tileset*, quint64> mImageLastUsed;
+    quint64 mImageCacheSweep;
+    qint64 mImageCacheLimit;
+    QTimer mImageCacheTimer;
+    QSet<QString> mRequestedImages;
+    QThreadPool mImageThreadPool;
+
+    int mSuspendCount;
+    QStringList mSuspendedFileChanges;
+    QList<QPair<QString, QImage>> mSuspendedImages;
+    int mSuspendedAnimationTime;
 };
 
 inline bool TilesetManager::reloadTilesetsOnChange() const
 { return mReloadTilesetsOnChange; }
 
+inline bool TilesetManager::animateTiles() const
+{ return mAnimateTiles; }
+
+inline qint64 TilesetManager::imageCacheLimit() const
+{ return mImageCacheLimit; }
+
 } // namespace Internal
 } // namespace Tiled
 
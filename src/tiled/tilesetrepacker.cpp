@@ -0,0 +1,410 @@
+/*
+ * tilesetrepacker.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tilesetrepacker.h"
+
+#include "colorkey.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSet>
+#include <QVector>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+struct TilesetRepacker::Atlas
+{
+    QSize tileSize;
+    QPoint tileOffset;
+    QVector<Tile*> tiles;
+    SharedTileset tileset;
+};
+
+namespace {
+
+/**
+ * The used tiles of one size and drawing offset. They are kept in units of
+ * an animated tile and its frames, which are not split over atlases.
+ */
+struct TileGroup
+{
+    QSize tileSize;
+    QPoint tileOffset;
+    QVector<QVector<Tile*>> units;
+};
+
+} // anonymous namespace
+
+static int nextPowerOfTwo(int value)
+{
+    int power = 1;
+    while (power < value)
+        power <<= 1;
+    return power;
+}
+
+/**
+ * Returns the size of the smallest power-of-two image that fits \a count
+ * tiles of the given size in a grid, preferring sizes that stay within
+ * \a maxSize and, among those of the same area, the most square one.
+ */
+static QSize atlasSize(const QSize &tileSize, int count, int maxSize)
+{
+    const int maxHeight = qMax(maxSize, nextPowerOfTwo(tileSize.height()));
+
+    QSize best;
+    bool bestFits = false;
+
+    for (int width = nextPowerOfTwo(tileSize.width()); ; width <<= 1) {
+        const int columns = width / tileSize.width();
+        const int rows = (count + columns - 1) / columns;
+        const int height = nextPowerOfTwo(rows * tileSize.height());
+        const bool fits = height <= maxHeight;
+
+        const qint64 area = qint64(width) * height;
+        const qint64 bestArea = qint64(best.width()) * best.height();
+
+        bool better = best.isEmpty() || (fits && !bestFits);
+        if (!better && fits == bestFits) {
+            better = area < bestArea ||
+                    (area == bestArea && qMax(width, height) < qMax(best.width(),
+                                                                     best.height()));
+        }
+
+        if (better) {
+            best = QSize(width, height);
+            bestFits = fits;
+        }
+
+        if (columns >= count || width >= maxSize)
+            break;
+    }
+
+    return best;
+}
+
+/**
+ * Reads an image, masking out the \a transparentColor when it is valid.
+ */
+static QImage readImage(const QString &fileName, const QColor &transparentColor)
+{
+    return applyColorKey(QImage(fileName), transparentColor);
+}
+
+
+TilesetRepacker::TilesetRepacker(int maxAtlasSize)
+    : mMaxAtlasSize(nextPowerOfTwo(maxAtlasSize))
+{
+}
+
+Map *TilesetRepacker::repack(const Map *map, const QString &targetFile)
+{
+    mRepackedTiles.clear();
+    mAtlasFiles.clear();
+    mError.clear();
+
+    QSet<Tile*> usedTiles;
+
+    for (const Layer *layer : map->layers()) {
+        if (layer->isTileLayer()) {
+            const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+            for (const Cell &cell : *tileLayer)
+                if (cell.tile)
+                    usedTiles.insert(cell.tile);
+        } else if (layer->isObjectGroup()) {
+            const ObjectGroup *objectGroup = static_cast<const ObjectGroup*>(layer);
+            for (const MapObject *object : objectGroup->objects())
+                if (Tile *tile = object->cell().tile)
+                    usedTiles.insert(tile);
+        }
+    }
+
+    // The frames of the used animations are needed as well
+    const QSet<Tile*> placedTiles = usedTiles;
+    for (Tile *tile : placedTiles) {
+        for (const Frame &frame : tile->frames())
+            if (Tile *frameTile = tile->tileset()->tileAt(frame.tileId))
+                usedTiles.insert(frameTile);
+    }
+
+    // Group the tiles by size, taking the animated tiles first, so that
+    // their frames end up in the same atlas
+    QVector<TileGroup> groups;
+    QSet<Tile*> grouped;
+
+    auto groupFor = [&] (const Tile *tile) -> TileGroup & {
+        for (TileGroup &group : groups)
+            if (group.tileSize == tile->size() && group.tileOffset == tile->offset())
+                return group;
+
+        groups.append(TileGroup { tile->size(), tile->offset(), {} });
+        return groups.last();
+    };
+
+    for (const bool animated : { true, false }) {
+        for (const SharedTileset &tileset : map->tilesets()) {
+            for (Tile *tile : tileset->tiles()) {
+                if (tile->isAnimated() != animated ||
+                        !usedTiles.contains(tile) || grouped.contains(tile))
+                    continue;
+
+                QVector<Tile*> unit(1, tile);
+                grouped.insert(tile);
+
+                for (const Frame &frame : tile->frames()) {
+                    Tile *frameTile = tileset->tileAt(frame.tileId);
+                    if (frameTile && frameTile->size() == tile->size() &&
+                            !grouped.contains(frameTile)) {
+                        unit.append(frameTile);
+                        grouped.insert(frameTile);
+                    }
+                }
+
+                groupFor(tile).units.append(unit);
+            }
+        }
+    }
+
+    // Split the groups into atlases that stay within the maximum size
+    QVector<Atlas> atlases;
+
+    for (const TileGroup &group : groups) {
+        const int columns = qMax(1, mMaxAtlasSize / group.tileSize.width());
+        const int rows = qMax(1, mMaxAtlasSize / group.tileSize.height());
+        const int capacity = columns * rows;
+
+        Atlas atlas;
+        atlas.tileSize = group.tileSize;
+        atlas.tileOffset = group.tileOffset;
+
+        for (const QVector<Tile*> &unit : group.units) {
+            if (!atlas.tiles.isEmpty() && atlas.tiles.size() + unit.size() > capacity) {
+                atlases.append(atlas);
+                atlas.tiles.clear();
+            }
+            atlas.tiles += unit;
+        }
+
+        atlases.append(atlas);
+    }
+
+    const QFileInfo targetInfo(targetFile);
+    const QDir targetDir = targetInfo.dir();
+
+    for (int i = 0; i < atlases.size(); ++i) {
+        const QString fileName = targetDir.filePath(QString(QLatin1String("%1-atlas%2.png"))
+                                                    .arg(targetInfo.completeBaseName())
+                                                    .arg(i));
+
+        if (!writeAtlas(atlases[i], fileName)) {
+            mTilesetImages.clear();
+            return nullptr;
+        }
+    }
+
+    mTilesetImages.clear();
+    copyTileData();
+
+    Map *repacked = new Map(*map);
+    repacked->setNextObjectId(map->nextObjectId());
+
+    remapLayers(repacked);
+
+    while (repacked->tilesetCount() > 0)
+        repacked->removeTilesetAt(repacked->tilesetCount() - 1);
+    for (const Atlas &atlas : atlases)
+        repacked->addTileset(atlas.tileset);
+
+    repacked->recomputeDrawMargins();
+
+    return repacked;
+}
+
+/**
+ * Returns the image of the given \a tile. The images of the tilesets are
+ * read from disk when they are not loaded, for example when image decoding
+ * is disabled.
+ */
+QImage TilesetRepacker::tileImage(const Tile *tile)
+{
+    const Tileset *tileset = tile->tileset();
+
+    if (!tile->imageRect().isNull()) {
+        auto it = mTilesetImages.find(tileset);
+        if (it == mTilesetImages.end()) {
+            QImage image = tileset->imageData();
+            if (image.isNull())
+                image = readImage(tileset->imageSource(), tileset->transparentColor());
+            it = mTilesetImages.insert(tileset, image);
+        }
+
+        if (it->isNull())
+            return QImage();
+
+        return it->copy(tile->imageRect());
+    }
+
+    if (!tile->image().isNull())
+        return tile->image().toImage();
+
+    return readImage(tile->imageSource(), QColor());
+}
+
+bool TilesetRepacker::writeAtlas(Atlas &atlas, const QString &fileName)
+{
+    const QSize &tileSize = atlas.tileSize;
+    const QSize size = atlasSize(tileSize, atlas.tiles.size(), mMaxAtlasSize);
+    const int columns = size.width() / tileSize.width();
+
+    QImage image(size, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+    QSet<Tileset*> sources;
+
+    for (int i = 0; i < atlas.tiles.size(); ++i) {
+        const Tile *tile = atlas.tiles.at(i);
+        const QImage source = tileImage(tile);
+        if (source.isNull()) {
+            mError = tr("Could not read the image of tile %1 of tileset '%2'.")
+                    .arg(tile->id())
+                    .arg(tile->tileset()->name());
+            return false;
+        }
+
+        painter.drawImage(QPoint(i % columns * tileSize.width(),
+                                 i / columns * tileSize.height()),
+                          source);
+        sources.insert(tile->tileset());
+    }
+
+    painter.end();
+
+    if (!image.save(fileName, "PNG")) {
+        mError = tr("Could not write the tileset image %1.").arg(fileName);
+        return false;
+    }
+
+    // An atlas with the tiles of a single tileset takes over its name and
+    // properties
+    Tileset *source = sources.size() == 1 ? *sources.begin() : nullptr;
+    const QString name = source ? source->name()
+                                : QFileInfo(fileName).completeBaseName();
+
+    SharedTileset tileset = Tileset::create(name,
+                                            tileSize.width(),
+                                            tileSize.height());
+    tileset->setTileOffset(atlas.tileOffset);
+    if (source)
+        tileset->setProperties(source->properties());
+
+    tileset->loadFromImage(image, fileName);
+
+    for (int i = 0; i < atlas.tiles.size(); ++i)
+        mRepackedTiles.insert(atlas.tiles.at(i), tileset->tileAt(i));
+
+    atlas.tileset = tileset;
+    mAtlasFiles.append(fileName);
+    return true;
+}
+
+/**
+ * Copies the data of the original tiles to the tiles in the atlases. Frames
+ * that ended up in another atlas, which can only happen for tiles of a
+ * different size, are left out of the animations.
+ */
+void TilesetRepacker::copyTileData()
+{
+    for (auto it = mRepackedTiles.constBegin(); it != mRepackedTiles.constEnd(); ++it) {
+        const Tile *source = it.key();
+        Tile *target = it.value();
+
+        target->setProperties(source->properties());
+        target->setProbability(source->probability());
+
+        if (const ObjectGroup *objectGroup = source->objectGroup())
+            target->setObjectGroup(static_cast<ObjectGroup*>(objectGroup->clone()));
+
+        if (!source->isAnimated())
+            continue;
+
+        QVector<Frame> frames;
+        for (const Frame &frame : source->frames()) {
+            const Tile *frameTile = mRepackedTiles.value(source->tileset()->tileAt(frame.tileId));
+            if (frameTile && frameTile->tileset() == target->tileset())
+                frames.append(Frame { frameTile->id(), frame.duration });
+        }
+
+        if (!frames.isEmpty())
+            target->setFrames(frames);
+    }
+}
+
+/**
+ * Changes the tile layers and tile objects of \a map to refer to the tiles
+ * in the atlases. Flipping of the cells is preserved.
+ */
+void TilesetRepacker::remapLayers(Map *map) const
+{
+    for (Layer *layer : map->layers()) {
+        if (TileLayer *tileLayer = layer->asTileLayer()) {
+            // The tiles in the atlases have the same size and offset
+            TileLayer::BulkEdit bulkEdit(tileLayer);
+
+            const QList<QPoint> chunks = tileLayer->chunks().keys();
+            for (const QPoint &chunk : chunks) {
+                const int startX = chunk.x() * CHUNK_SIZE;
+                const int startY = chunk.y() * CHUNK_SIZE;
+                const int endX = qMin(tileLayer->width(), startX + CHUNK_SIZE);
+                const int endY = qMin(tileLayer->height(), startY + CHUNK_SIZE);
+
+                for (int y = startY; y < endY; ++y) {
+                    for (int x = startX; x < endX; ++x) {
+                        Cell cell = tileLayer->cellAt(x, y);
+                        if (!cell.tile)
+                            continue;
+
+                        cell.tile = mRepackedTiles.value(cell.tile);
+                        tileLayer->setCell(x, y, cell);
+                    }
+                }
+            }
+        } else if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+            for (MapObject *object : objectGroup->objects()) {
+                Cell cell = object->cell();
+                if (!cell.tile)
+                    continue;
+
+                cell.tile = mRepackedTiles.value(cell.tile);
+                object->setCell(cell);
+            }
+        }
+    }
+}
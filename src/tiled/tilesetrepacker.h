@@ -0,0 +1,94 @@
+/*
+ * tilesetrepacker.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILESETREPACKER_H
+#define TILESETREPACKER_H
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+namespace Tiled {
+
+class Map;
+class Tile;
+class Tileset;
+
+namespace Internal {
+
+/**
+ * Prepares a map for being loaded by a game, as a step of exporting it.
+ *
+ * Only the tiles used by the map are kept. They are repacked from all
+ * tilesets into power-of-two atlas images, which are written next to the
+ * exported file, and the layers are changed to refer to the tiles in the
+ * atlases. Tiles of the same size and drawing offset share an atlas, so
+ * that a map typically needs a single image.
+ *
+ * The properties, probability, collision shapes and animations of the tiles
+ * are kept. Terrain information only matters while editing, so it is left
+ * out.
+ */
+class TilesetRepacker
+{
+    Q_DECLARE_TR_FUNCTIONS(TilesetRepacker)
+
+public:
+    /**
+     * Constructs a repacker creating atlases of at most \a maxAtlasSize
+     * pixels wide and high, unless a single tile is larger than that.
+     */
+    explicit TilesetRepacker(int maxAtlasSize = 4096);
+
+    /**
+     * Returns a copy of \a map that uses the repacked tilesets, writing
+     * their images next to \a targetFile. Returns null when an image of a
+     * used tile could not be read or an atlas could not be written.
+     */
+    Map *repack(const Map *map, const QString &targetFile);
+
+    /**
+     * Returns the image files written by the last call to repack().
+     */
+    const QStringList &atlasFiles() const { return mAtlasFiles; }
+
+    const QString &errorString() const { return mError; }
+
+private:
+    struct Atlas;
+
+    QImage tileImage(const Tile *tile);
+    bool writeAtlas(Atlas &atlas, const QString &fileName);
+    void copyTileData();
+    void remapLayers(Map *map) const;
+
+    int mMaxAtlasSize;
+    QHash<Tile*, Tile*> mRepackedTiles;
+    QHash<const Tileset*, QImage> mTilesetImages;
+    QStringList mAtlasFiles;
+    QString mError;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // TILESETREPACKER_H
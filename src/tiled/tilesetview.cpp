@@ -38,6 +38,7 @@
 #include <QMenu>
 #include <QPainter>
 #include <QPinchGesture>
+#include <QRunnable>
 #include <QUndoCommand>
 #include <QWheelEvent>
 #include <QtCore/qmath.h>
@@ -47,6 +48,46 @@ using namespace Tiled::Internal;
 
 namespace {
 
+/**
+ * Smoothly scales a tile image in a worker thread, passing the result back
+ * to the tileset view.
+ */
+class ThumbnailTask : public QRunnable
+{
+public:
+    ThumbnailTask(TilesetView *view, const QImage &image, const QSize &size,
+                  int tileId, double scale, int generation)
+        : mView(view)
+        , mImage(image)
+        , mSize(size)
+        , mTileId(tileId)
+        , mScale(scale)
+        , mGeneration(generation)
+    {}
+
+    void run() override
+    {
+        const QImage thumbnail = mImage.scaled(mSize,
+                                               Qt::IgnoreAspectRatio,
+                                               Qt::SmoothTransformation);
+
+        QMetaObject::invokeMethod(mView, "thumbnailReady",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, mTileId),
+                                  Q_ARG(double, mScale),
+                                  Q_ARG(QImage, thumbnail),
+                                  Q_ARG(int, mGeneration));
+    }
+
+private:
+    TilesetView *mView;
+    const QImage mImage;
+    const QSize mSize;
+    const int mTileId;
+    const double mScale;
+    const int mGeneration;
+};
+
 /**
  * The delegate for drawing tile items in the tileset view.
  */
@@ -225,11 +266,22 @@ void TileDelegate::paint(QPainter *painter,
     targetRect.setRight(targetRect.left() + tileSize.width() - 1);
 
     // Draw the tile image
+    bool smoothTransform = false;
     if (Zoomable *zoomable = mTilesetView->zoomable())
-        if (zoomable->smoothTransform())
-            painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        smoothTransform = zoomable->smoothTransform();
 
-    painter->drawPixmap(targetRect, tileImage);
+    // Smoothly scaled down images are drawn from a cached thumbnail. Until
+    // it is available, the image is drawn without smoothing.
+    QPixmap thumbnail;
+    if (smoothTransform && zoom < 1)
+        thumbnail = mTilesetView->tileThumbnail(tile, tileSize);
+    else if (smoothTransform)
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+
+    if (!thumbnail.isNull())
+        painter->drawPixmap(targetRect.topLeft(), thumbnail);
+    else
+        painter->drawPixmap(targetRect, tileImage);
 
     // Overlay with film strip when animated
     if (mTilesetView->markAnimatedTiles() && tile->isAnimated()) {
@@ -332,6 +384,8 @@ TilesetView::TilesetView(QWidget *parent)
     , mTerrainId(-1)
     , mHoveredCorner(0)
     , mTerrainChanged(false)
+    , mThumbnails(64 * 1024)    // in KB
+    , mThumbnailGeneration(0)
 {
     setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
     setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
@@ -360,6 +414,12 @@ TilesetView::TilesetView(QWidget *parent)
             SLOT(setDrawGrid(bool)));
 }
 
+TilesetView::~TilesetView()
+{
+    cancelPendingThumbnails();
+    mThumbnailPool.waitForDone();
+}
+
 void TilesetView::setMapDocument(MapDocument *mapDocument)
 {
     mMapDocument = mapDocument;
@@ -400,6 +460,29 @@ int TilesetView::sizeHintForRow(int row) const
     return qRound(tileHeight * scale()) + (mDrawGrid ? 1 : 0);
 }
 
+void TilesetView::setModel(QAbstractItemModel *model)
+{
+    if (QAbstractItemModel *previousModel = this->model()) {
+        disconnect(previousModel, SIGNAL(modelReset()),
+                   this, SLOT(clearThumbnails()));
+        disconnect(previousModel, SIGNAL(modelReset()),
+                   this, SLOT(updateSectionSizes()));
+        disconnect(previousModel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                   this, SLOT(tilesChanged(QModelIndex,QModelIndex)));
+    }
+
+    QTableView::setModel(model);
+    clearThumbnails();
+    updateSectionSizes();
+
+    if (model) {
+        connect(model, SIGNAL(modelReset()), SLOT(clearThumbnails()));
+        connect(model, SIGNAL(modelReset()), SLOT(updateSectionSizes()));
+        connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                SLOT(tilesChanged(QModelIndex,QModelIndex)));
+    }
+}
+
 void TilesetView::setZoomable(Zoomable *zoomable)
 {
     if (mZoomable)
@@ -623,14 +706,152 @@ void TilesetView::editTileProperties()
 void TilesetView::setDrawGrid(bool drawGrid)
 {
     mDrawGrid = drawGrid;
-    if (TilesetModel *model = tilesetModel())
+
+    if (mUniformTileSize.isValid()) {
+        updateSectionSizes();
+        viewport()->update();
+    } else if (TilesetModel *model = tilesetModel()) {
         model->tilesetChanged();
+    }
 }
 
 void TilesetView::adjustScale()
 {
-    if (TilesetModel *model = tilesetModel())
+    // Thumbnails for the previous scale are no longer needed soon
+    cancelPendingThumbnails();
+
+    if (mUniformTileSize.isValid()) {
+        updateSectionSizes();
+        viewport()->update();
+    } else if (TilesetModel *model = tilesetModel()) {
         model->tilesetChanged();
+    }
+}
+
+/**
+ * When all tiles have the same size, the sections get a fixed size, which
+ * avoids asking the delegate for the size of every tile when laying out the
+ * view. Otherwise, the sections are resized to their contents.
+ */
+void TilesetView::updateSectionSizes()
+{
+    mUniformTileSize = QSize();
+
+    if (const TilesetModel *model = tilesetModel()) {
+        for (const Tile *tile : model->tileset()->tiles()) {
+            if (!mUniformTileSize.isValid()) {
+                mUniformTileSize = tile->size();
+            } else if (tile->size() != mUniformTileSize) {
+                mUniformTileSize = QSize();
+                break;
+            }
+        }
+    }
+
+    QHeaderView *hHeader = horizontalHeader();
+    QHeaderView *vHeader = verticalHeader();
+
+    if (mUniformTileSize.isValid()) {
+        const QSize tileSize = mUniformTileSize * scale();
+        const int extra = mDrawGrid ? 1 : 0;
+
+        hHeader->setSectionResizeMode(QHeaderView::Fixed);
+        vHeader->setSectionResizeMode(QHeaderView::Fixed);
+        hHeader->setDefaultSectionSize(tileSize.width() + extra);
+        vHeader->setDefaultSectionSize(tileSize.height() + extra);
+    } else {
+        hHeader->setSectionResizeMode(QHeaderView::ResizeToContents);
+        vHeader->setSectionResizeMode(QHeaderView::ResizeToContents);
+    }
+}
+
+/**
+ * Drops the thumbnails of the changed tiles.
+ */
+void TilesetView::tilesChanged(const QModelIndex &topLeft,
+                               const QModelIndex &bottomRight)
+{
+    const TilesetModel *model = tilesetModel();
+    QSet<int> changedIds;
+
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row)
+        for (int column = topLeft.column(); column <= bottomRight.column(); ++column)
+            if (const Tile *tile = model->tileAt(model->index(row, column)))
+                changedIds.insert(tile->id());
+
+    for (const ThumbnailKey &key : mThumbnails.keys())
+        if (changedIds.contains(key.first))
+            mThumbnails.remove(key);
+
+    cancelPendingThumbnails();
+
+    // The size of the changed tiles may be different
+    updateSectionSizes();
+}
+
+void TilesetView::clearThumbnails()
+{
+    cancelPendingThumbnails();
+    mThumbnails.clear();
+}
+
+/**
+ * Returns the image of the \a tile smoothly scaled to the given \a size, or
+ * a null pixmap when it is not available yet. Missing thumbnails are scaled
+ * in the background, and the tile is repainted once it is available.
+ */
+QPixmap TilesetView::tileThumbnail(const Tile *tile, const QSize &size)
+{
+    const ThumbnailKey key(tile->id(), scale());
+
+    if (const QPixmap *thumbnail = mThumbnails.object(key))
+        return *thumbnail;
+
+    if (mPendingThumbnails.contains(key))
+        return QPixmap();
+
+    const QPixmap &image = tile->image();
+    if (image.isNull() || size.isEmpty())
+        return QPixmap();
+
+    mPendingThumbnails.insert(key);
+    mThumbnailPool.start(new ThumbnailTask(this, image.toImage(), size,
+                                           key.first, key.second,
+                                           mThumbnailGeneration));
+
+    return QPixmap();
+}
+
+void TilesetView::thumbnailReady(int tileId, double scale,
+                                 const QImage &thumbnail, int generation)
+{
+    // Ignore thumbnails of tiles that changed in the meantime
+    if (generation != mThumbnailGeneration)
+        return;
+
+    const ThumbnailKey key(tileId, scale);
+    mPendingThumbnails.remove(key);
+
+    const int cost = qMax(1, thumbnail.byteCount() / 1024);
+    mThumbnails.insert(key, new QPixmap(QPixmap::fromImage(thumbnail)), cost);
+
+    const TilesetModel *model = tilesetModel();
+    if (!model || scale != this->scale())
+        return;
+
+    if (const Tile *tile = model->tileset()->tileAt(tileId))
+        update(model->tileIndex(tile));
+}
+
+/**
+ * Cancels the thumbnails that are still waiting to be scaled, and makes
+ * sure the ones being scaled right now are ignored.
+ */
+void TilesetView::cancelPendingThumbnails()
+{
+    mThumbnailPool.clear();
+    mPendingThumbnails.clear();
+    ++mThumbnailGeneration;
 }
 
 void TilesetView::applyTerrain()
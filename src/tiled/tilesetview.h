@@ -23,7 +23,11 @@
 
 #include "tilesetmodel.h"
 
+#include <QCache>
+#include <QPair>
+#include <QSet>
 #include <QTableView>
+#include <QThreadPool>
 
 namespace Tiled {
 namespace Internal {
@@ -40,6 +44,7 @@ class TilesetView : public QTableView
 
 public:
     TilesetView(QWidget *parent = nullptr);
+    ~TilesetView();
 
     /**
      * Sets the map document associated with the tileset to be displayed, which
@@ -52,6 +57,8 @@ public:
     int sizeHintForColumn(int column) const override;
     int sizeHintForRow(int row) const override;
 
+    void setModel(QAbstractItemModel *model) override;
+
     void setZoomable(Zoomable *zoomable);
     Zoomable *zoomable() const { return mZoomable; }
 
@@ -109,6 +116,8 @@ public:
     QModelIndex hoveredIndex() const { return mHoveredIndex; }
     int hoveredCorner() const { return mHoveredCorner; }
 
+    QPixmap tileThumbnail(const Tile *tile, const QSize &size);
+
 signals:
     void createNewTerrain(Tile *tile);
     void terrainImageSelected(Tile *tile);
@@ -130,10 +139,17 @@ private slots:
 
     void adjustScale();
 
+    void updateSectionSizes();
+    void tilesChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void clearThumbnails();
+    void thumbnailReady(int tileId, double scale,
+                        const QImage &thumbnail, int generation);
+
 private:
     void applyTerrain();
     void finishTerrainChange();
     Tile *currentTile() const;
+    void cancelPendingThumbnails();
 
     Zoomable *mZoomable;
     MapDocument *mMapDocument;
@@ -146,6 +162,23 @@ private:
     QModelIndex mHoveredIndex;
     int mHoveredCorner;
     bool mTerrainChanged;
+
+    /**
+     * The size of all tiles, when they have the same size. Allows laying
+     * out the view without asking the delegate for the size of each tile.
+     */
+    QSize mUniformTileSize;
+
+    /**
+     * The scaled tile images, by tile id and scale. They are scaled in the
+     * background, since smoothly scaling large images while painting makes
+     * scrolling and zooming slow.
+     */
+    typedef QPair<int, double> ThumbnailKey;
+    QCache<ThumbnailKey, QPixmap> mThumbnails;
+    QSet<ThumbnailKey> mPendingThumbnails;
+    int mThumbnailGeneration;
+    QThreadPool mThumbnailPool;
 };
 
 inline bool TilesetView::markAnimatedTiles() const
@@ -27,6 +27,7 @@
 #include "varianttomapconverter.h"
 
 #include <QDebug>
+#include <QHash>
 #include <QJsonArray>
 
 namespace Tiled {
@@ -46,14 +47,42 @@ public:
     TileStampData(const TileStampData &other);
     ~TileStampData();
 
+    void setSource(TileStampData *source, int transform);
+    void clearTransformed();
+
     QString name;
     QString fileName;
     QVector<TileStampVariation> variations;
     int quickStampIndex;
+
+    // The stamps transformed from this one, by transformation. Only stamps
+    // that were not transformed themselves keep their transformed stamps,
+    // to avoid growing chains of stamps when transforming repeatedly.
+    QHash<int, TileStamp> transformed;
+
+    // The stamp this one was transformed from, while it is alive, and the
+    // stamps that were transformed from this one
+    TileStampData *source;
+    int sourceTransform;
+    QVector<TileStampData*> derived;
+
+    // The pickers used for random painting, which are built on demand and
+    // shared by all tools using this stamp. The cell picker remembers the
+    // tilesets of the variations, since these get replaced by the similar
+    // tilesets of the map painted on.
+    RandomPicker<int> variationPicker;
+    RandomPicker<Cell> cellPicker;
+    QVector<SharedTileset> cellPickerTilesets;
+    bool variationPickerDirty;
+    bool cellPickerDirty;
 };
 
 TileStampData::TileStampData()
     : quickStampIndex(-1)
+    , source(nullptr)
+    , sourceTransform(-1)
+    , variationPickerDirty(true)
+    , cellPickerDirty(true)
 {}
 
 TileStampData::TileStampData(const TileStampData &other)
@@ -62,6 +91,10 @@ TileStampData::TileStampData(const TileStampData &other)
     , fileName()                        // not copied
     , variations(other.variations)
     , quickStampIndex(-1)
+    , source(nullptr)                   // not copied
+    , sourceTransform(-1)
+    , variationPickerDirty(true)
+    , cellPickerDirty(true)
 {
     TilesetManager *tilesetManager = TilesetManager::instance();
 
@@ -74,6 +107,11 @@ TileStampData::TileStampData(const TileStampData &other)
 
 TileStampData::~TileStampData()
 {
+    for (TileStampData *stamp : derived)
+        stamp->source = nullptr;
+    if (source)
+        source->derived.removeOne(this);
+
     TilesetManager *tilesetManager = TilesetManager::instance();
 
     // decrease reference to tilesets and delete maps
@@ -83,12 +121,44 @@ TileStampData::~TileStampData()
     }
 }
 
+/**
+ * Remembers that this stamp was created by applying \a transform to
+ * \a source.
+ */
+void TileStampData::setSource(TileStampData *source, int transform)
+{
+    this->source = source;
+    sourceTransform = transform;
+    source->derived.append(this);
+}
+
+/**
+ * Forgets about the stamps transformed from this one and the random pickers
+ * built for it. Needs to be called when this stamp changes.
+ */
+void TileStampData::clearTransformed()
+{
+    for (TileStampData *stamp : derived)
+        stamp->source = nullptr;
+
+    derived.clear();
+    transformed.clear();
+
+    variationPickerDirty = true;
+    cellPickerDirty = true;
+}
+
 
 TileStamp::TileStamp()
     : d(new TileStampData)
 {
 }
 
+TileStamp::TileStamp(TileStampData *data)
+    : d(data)
+{
+}
+
 TileStamp::TileStamp(Map *map)
     : d(new TileStampData)
 {
@@ -123,6 +193,7 @@ QString TileStamp::name() const
 
 void TileStamp::setName(const QString &name)
 {
+    d->clearTransformed();
     d->name = name;
 }
 
@@ -143,6 +214,7 @@ qreal TileStamp::probability(int index) const
 
 void TileStamp::setProbability(int index, qreal probability)
 {
+    d->clearTransformed();
     d->variations[index].probability = probability;
 }
 
@@ -173,6 +245,7 @@ void TileStamp::addVariation(Map *map, qreal probability)
     // increase tileset reference counts to keep watching them
     TilesetManager::instance()->addReferences(map->tilesets());
 
+    d->clearTransformed();
     d->variations.append(TileStampVariation(map, probability));
 }
 
@@ -182,6 +255,8 @@ void TileStamp::addVariation(Map *map, qreal probability)
  */
 Map *TileStamp::takeVariation(int index)
 {
+    d->clearTransformed();
+
 #if QT_VERSION >= 0x050200
     return d->variations.takeAt(index).map;
 #else
@@ -216,52 +291,136 @@ void TileStamp::setQuickStampIndex(int quickStampIndex)
     d->quickStampIndex = quickStampIndex;
 }
 
-TileStampVariation TileStamp::randomVariation() const
+/**
+ * Picks one of the variations of this stamp, taking into account their
+ * probabilities, using the given random \a generator.
+ */
+TileStampVariation TileStamp::randomVariation(RandomGenerator &generator) const
 {
     Q_ASSERT(!d->variations.isEmpty());
 
-    RandomPicker<const TileStampVariation *> randomPicker;
+    if (d->variationPickerDirty) {
+        d->variationPicker.clear();
+        for (int i = 0; i < d->variations.size(); ++i)
+            d->variationPicker.add(i, d->variations.at(i).probability);
+        d->variationPickerDirty = false;
+    }
+
+    // When none of the variations has a probability, use the first one
+    if (d->variationPicker.isEmpty())
+        return d->variations.first();
+
+    return d->variations.at(d->variationPicker.pick(generator));
+}
+
+/**
+ * Returns a picker for the non-empty cells of all variations of this stamp,
+ * taking into account the probabilities of their tiles, for painting random
+ * cells.
+ */
+const RandomPicker<Cell> &TileStamp::randomCellPicker() const
+{
+    QVector<SharedTileset> tilesets;
     for (const TileStampVariation &variation : d->variations)
-        randomPicker.add(&variation, variation.probability);
+        tilesets += variation.map->tilesets();
+
+    if (d->cellPickerDirty || d->cellPickerTilesets != tilesets) {
+        d->cellPicker.clear();
+        // Adding the cells in a fixed order makes seeded picks reproducible
+        for (const TileStampVariation &variation : d->variations) {
+            const TileLayer *tileLayer = variation.tileLayer();
+            for (int y = 0; y < tileLayer->height(); ++y) {
+                for (int x = 0; x < tileLayer->width(); ++x) {
+                    const Cell &cell = tileLayer->cellAt(x, y);
+                    if (!cell.isEmpty())
+                        d->cellPicker.add(cell, cell.tile->probability());
+                }
+            }
+        }
+        d->cellPickerTilesets = tilesets;
+        d->cellPickerDirty = false;
+    }
 
-    return randomPicker.pick()->map;
+    return d->cellPicker;
 }
 
 /**
- * Returns a new stamp where all variations have been flipped in the given
+ * Returns a stamp where all variations have been flipped in the given
  * \a direction.
  */
 TileStamp TileStamp::flipped(FlipDirection direction) const
 {
-    TileStamp flipped(*this);
-    flipped.d.detach();
-
-    for (const TileStampVariation &variation : flipped.variations()) {
-        TileLayer *layer = variation.tileLayer();
-        layer->flip(direction);
-    }
-
-    return flipped;
+    return transformed(direction == FlipHorizontally ? FlipHorizontal
+                                                     : FlipVertical);
 }
 
 /**
- * Returns a new stamp where all variations have been rotated in the given
+ * Returns a stamp where all variations have been rotated in the given
  * \a direction.
  */
 TileStamp TileStamp::rotated(RotateDirection direction) const
 {
-    TileStamp rotated(*this);
-    rotated.d.detach();
+    return transformed(direction == RotateLeft ? RotateLeftTransform
+                                               : RotateRightTransform);
+}
+
+/**
+ * Returns this stamp with the given \a transform applied to all variations.
+ *
+ * The transformed stamps are shared rather than copied again each time.
+ * Transforming a stamp back returns the stamp it was transformed from, and
+ * stamps that were not transformed keep their transformed versions.
+ */
+TileStamp TileStamp::transformed(Transform transform) const
+{
+    if (d->source && d->sourceTransform == inverse(transform))
+        return TileStamp(d->source);
+
+    auto it = d->transformed.constFind(transform);
+    if (it != d->transformed.constEnd())
+        return it.value();
 
-    for (const TileStampVariation &variation : rotated.variations()) {
+    TileStamp result(*this);
+    result.d.detach();
+
+    for (const TileStampVariation &variation : result.variations()) {
         TileLayer *layer = variation.tileLayer();
-        layer->rotate(direction);
 
-        variation.map->setWidth(layer->width());
-        variation.map->setHeight(layer->height());
+        switch (transform) {
+        case FlipHorizontal:
+            layer->flip(FlipHorizontally);
+            break;
+        case FlipVertical:
+            layer->flip(FlipVertically);
+            break;
+        case RotateLeftTransform:
+        case RotateRightTransform:
+            layer->rotate(transform == RotateLeftTransform ? RotateLeft
+                                                           : RotateRight);
+            variation.map->setWidth(layer->width());
+            variation.map->setHeight(layer->height());
+            break;
+        }
     }
 
-    return rotated;
+    result.d->setSource(d.data(), transform);
+
+    if (!d->source)
+        d->transformed.insert(transform, result);
+
+    return result;
+}
+
+TileStamp::Transform TileStamp::inverse(Transform transform)
+{
+    switch (transform) {
+    case RotateLeftTransform:
+        return RotateRightTransform;
+    case RotateRightTransform:
+        return RotateLeftTransform;
+    default:
+        return transform;
+    }
 }
 
 /**
@@ -287,6 +446,11 @@ QJsonObject TileStamp::toJson(const QDir &dir) const
     for (const TileStampVariation &variation : d->variations) {
         MapToVariantConverter converter;
         QVariant mapVariant = converter.toVariant(variation.map, dir);
+        if (!mapVariant.isValid()) {
+            qDebug() << "Failed to save map for stamp:" << converter.errorString();
+            continue;
+        }
+
         QJsonValue mapJson = QJsonValue::fromVariant(mapVariant);
 
         QJsonObject variationJson;
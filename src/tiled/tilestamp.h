@@ -31,8 +31,14 @@
 #include <QVector>
 
 namespace Tiled {
+
+class Cell;
+
 namespace Internal {
 
+class RandomGenerator;
+template<typename T> class RandomPicker;
+
 struct TileStampVariation
 {
     TileStampVariation()
@@ -90,7 +96,8 @@ public:
     int quickStampIndex() const;
     void setQuickStampIndex(int quickStampIndex);
 
-    TileStampVariation randomVariation() const;
+    TileStampVariation randomVariation(RandomGenerator &generator) const;
+    const RandomPicker<Cell> &randomCellPicker() const;
 
     TileStamp flipped(FlipDirection direction) const;
     TileStamp rotated(RotateDirection direction) const;
@@ -103,6 +110,18 @@ public:
                               const QDir &mapDir);
 
 private:
+    enum Transform {
+        FlipHorizontal,
+        FlipVertical,
+        RotateLeftTransform,
+        RotateRightTransform
+    };
+
+    explicit TileStamp(TileStampData *data);
+
+    TileStamp transformed(Transform transform) const;
+    static Transform inverse(Transform transform);
+
     QExplicitlySharedDataPointer<TileStampData> d;
 };
 
@@ -38,12 +38,101 @@
 #include <QDebug>
 #include <QDirIterator>
 #include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
 #include <QRegularExpression>
 #include <QSaveFile>
+#include <QThread>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
 
+namespace Tiled {
+namespace Internal {
+
+/**
+ * Reads and parses the stamp files in the stamps directory on a worker
+ * thread. The parsed files are taken by the TileStampManager, which creates
+ * the stamps on the main thread since this involves loading tilesets.
+ */
+class StampFileReader : public QThread
+{
+public:
+    struct StampFile {
+        QString fileName;
+        QJsonObject json;
+    };
+
+    explicit StampFileReader(const QString &stampsDirectory)
+        : mStampsDirectory(stampsDirectory)
+    {}
+
+    ~StampFileReader()
+    {
+        requestInterruption();
+        wait();
+    }
+
+    /**
+     * Returns up to \a maxCount of the stamp files that were parsed and not
+     * taken yet.
+     */
+    QVector<StampFile> takeStampFiles(int maxCount)
+    {
+        QMutexLocker locker(&mMutex);
+        const int count = qMin(maxCount, mStampFiles.size());
+        QVector<StampFile> stampFiles = mStampFiles.mid(0, count);
+        mStampFiles.remove(0, count);
+        return stampFiles;
+    }
+
+protected:
+    void run() override
+    {
+        QDirIterator iterator(mStampsDirectory,
+                              QStringList() << QLatin1String("*.stamp"),
+                              QDir::Files | QDir::Readable);
+        while (iterator.hasNext() && !isInterruptionRequested()) {
+            const QString &stampFileName = iterator.next();
+
+            QFile stampFile(stampFileName);
+            if (!stampFile.open(QIODevice::ReadOnly))
+                continue;
+
+            QByteArray data = stampFile.readAll();
+
+            QJsonDocument document = QJsonDocument::fromBinaryData(data);
+            if (document.isNull()) {
+                // document not valid binary data, maybe it's an JSON text file
+                QJsonParseError error;
+                document = QJsonDocument::fromJson(data, &error);
+                if (error.error != QJsonParseError::NoError) {
+                    qDebug() << "Failed to parse stamp file:" << qPrintable(error.errorString());
+                    continue;
+                }
+            }
+
+            StampFile parsed;
+            parsed.fileName = iterator.fileInfo().fileName();
+            parsed.json = document.object();
+
+            QMutexLocker locker(&mMutex);
+            mStampFiles.append(parsed);
+        }
+    }
+
+private:
+    const QString mStampsDirectory;
+    QMutex mMutex;
+    QVector<StampFile> mStampFiles;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+// The number of stamps created before returning to the event loop
+static const int StampLoadingBatchSize = 16;
+
 static QString stampFilePath(const QString &name)
 {
     const Preferences *prefs = Preferences::instance();
@@ -93,6 +182,9 @@ TileStampManager::TileStampManager(const ToolManager &toolManager,
     connect(mTileStampModel, &TileStampModel::stampRemoved,
             this, &TileStampManager::deleteStamp);
 
+    connect(&mLoadTimer, &QTimer::timeout,
+            this, &TileStampManager::addLoadedStamps);
+
     loadStamps();
 }
 
@@ -197,6 +289,8 @@ void TileStampManager::extendQuickStamp(int index)
 
 void TileStampManager::stampsDirectoryChanged()
 {
+    stopLoadingStamps();
+
     // erase current stamps
     mQuickStamps.fill(TileStamp());
     mStampsByName.clear();
@@ -228,40 +322,43 @@ void TileStampManager::setQuickStamp(int index, TileStamp stamp)
     mQuickStamps[index] = stamp;
 }
 
+/**
+ * Starts loading the stamps in the stamps directory. The files are read on
+ * a worker thread, while the stamps are added to the model in small batches
+ * from the event loop, so that startup isn't delayed by a large library.
+ */
 void TileStampManager::loadStamps()
 {
     const Preferences *prefs = Preferences::instance();
-    const QString stampsDirectory = prefs->stampsDirectory();
-    const QDir stampsDir(stampsDirectory);
 
-    QDirIterator iterator(stampsDirectory,
-                          QStringList() << QLatin1String("*.stamp"),
-                          QDir::Files | QDir::Readable);
-    while (iterator.hasNext()) {
-        const QString &stampFileName = iterator.next();
+    mStampFileReader.reset(new StampFileReader(prefs->stampsDirectory()));
+    mStampFileReader->start(QThread::LowPriority);
 
-        QFile stampFile(stampFileName);
-        if (!stampFile.open(QIODevice::ReadOnly))
-            continue;
+    mLoadTimer.start(0);
+}
 
-        QByteArray data = stampFile.readAll();
+void TileStampManager::stopLoadingStamps()
+{
+    mLoadTimer.stop();
+    mStampFileReader.reset();
+}
 
-        QJsonDocument document = QJsonDocument::fromBinaryData(data);
-        if (document.isNull()) {
-            // document not valid binary data, maybe it's an JSON text file
-            QJsonParseError error;
-            document = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qDebug() << "Failed to parse stamp file:" << qPrintable(error.errorString());
-                continue;
-            }
-        }
+void TileStampManager::addLoadedStamps()
+{
+    // Checked before taking the files, so no files are missed
+    const bool finished = mStampFileReader->isFinished();
+    const QVector<StampFileReader::StampFile> stampFiles =
+            mStampFileReader->takeStampFiles(StampLoadingBatchSize);
+
+    const Preferences *prefs = Preferences::instance();
+    const QDir stampsDir(prefs->stampsDirectory());
 
-        TileStamp stamp = TileStamp::fromJson(document.object(), stampsDir);
+    for (const StampFileReader::StampFile &stampFile : stampFiles) {
+        TileStamp stamp = TileStamp::fromJson(stampFile.json, stampsDir);
         if (stamp.isEmpty())
             continue;
 
-        stamp.setFileName(iterator.fileInfo().fileName());
+        stamp.setFileName(stampFile.fileName);
 
         mTileStampModel->addStamp(stamp);
 
@@ -269,6 +366,14 @@ void TileStampManager::loadStamps()
         if (index >= 0 && index < mQuickStamps.size())
             mQuickStamps[index] = stamp;
     }
+
+    if (finished && stampFiles.isEmpty()) {
+        stopLoadingStamps();
+        return;
+    }
+
+    // Wait a little while the reader hasn't parsed any new files
+    mLoadTimer.start(stampFiles.isEmpty() ? 20 : 0);
 }
 
 void TileStampManager::stampAdded(TileStamp stamp)
@@ -26,6 +26,8 @@
 
 #include <QMap>
 #include <QObject>
+#include <QScopedPointer>
+#include <QTimer>
 #include <QVector>
 
 namespace Tiled {
@@ -36,6 +38,7 @@ class TileLayer;
 namespace Internal {
 
 class MapDocument;
+class StampFileReader;
 class TileStamp;
 class TileStampModel;
 class ToolManager;
@@ -77,8 +80,10 @@ private:
     void setQuickStamp(int index, TileStamp stamp);
 
     void loadStamps();
+    void stopLoadingStamps();
 
 private slots:
+    void addLoadedStamps();
     void stampAdded(TileStamp stamp);
     void stampRenamed(TileStamp stamp);
     void saveStamp(const TileStamp &stamp);
@@ -89,6 +94,9 @@ private:
     QMap<QString, TileStamp> mStampsByName;
     TileStampModel *mTileStampModel;
 
+    QScopedPointer<StampFileReader> mStampFileReader;
+    QTimer mLoadTimer;
+
     const ToolManager &mToolManager;
 };
 
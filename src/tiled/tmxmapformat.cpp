@@ -21,6 +21,7 @@
 #include "tmxmapformat.h"
 
 #include "map.h"
+#include "mapcache.h"
 #include "mapreader.h"
 #include "mapwriter.h"
 #include "preferences.h"
@@ -28,6 +29,7 @@
 
 #include <QBuffer>
 #include <QDir>
+#include <QFileDevice>
 
 using namespace Tiled;
 using namespace Tiled::Internal;
@@ -58,11 +60,19 @@ protected:
 } // anonymous namespace
 
 
+TmxMapFormat::TmxMapFormat(QObject *parent)
+    : MapFormat(parent)
+    , mLayerDataCache(nullptr)
+{
+}
+
 Map *TmxMapFormat::read(const QString &fileName)
 {
     mError.clear();
 
     EditorMapReader reader;
+    reader.setLazyLoadingEnabled(true);
+    reader.setCacheEnabled(MapCache::sizeLimit() > 0);
     Map *map = reader.readMap(fileName);
     if (!map)
         mError = reader.errorString();
@@ -76,6 +86,7 @@ bool TmxMapFormat::write(const Map *map, const QString &fileName)
 
     MapWriter writer;
     writer.setDtdEnabled(prefs->dtdEnabled());
+    writer.setLayerDataCache(mLayerDataCache);
 
     bool result = writer.writeMap(map, fileName);
     if (!result)
@@ -86,6 +97,44 @@ bool TmxMapFormat::write(const Map *map, const QString &fileName)
     return result;
 }
 
+Map *TmxMapFormat::readFromDevice(QIODevice *device,
+                                  const QString &path,
+                                  const MapReadOptions &options)
+{
+    mError.clear();
+
+    EditorMapReader reader;
+    reader.setLazyLoadingEnabled(true);
+    reader.setReadOptions(options);
+    Map *map = reader.readMap(device, path);
+    if (!map)
+        mError = reader.errorString();
+
+    return map;
+}
+
+bool TmxMapFormat::writeToDevice(const Map *map,
+                                 QIODevice *device,
+                                 const QString &path,
+                                 const MapWriteOptions &options)
+{
+    Preferences *prefs = Preferences::instance();
+
+    MapWriter writer;
+    writer.setDtdEnabled(prefs->dtdEnabled());
+    writer.setLayerDataCache(mLayerDataCache);
+    writer.setWriteOptions(options);
+    writer.writeMap(map, device, path);
+
+    mError = writer.errorString();
+
+    QFileDevice *file = qobject_cast<QFileDevice*>(device);
+    if (mError.isEmpty() && file && file->error() != QFileDevice::NoError)
+        mError = file->errorString();
+
+    return mError.isEmpty();
+}
+
 QByteArray TmxMapFormat::toByteArray(const Map *map)
 {
     QBuffer buffer;
@@ -26,6 +26,7 @@
 
 namespace Tiled {
 
+class LayerDataCache;
 class Tileset;
 
 namespace Internal {
@@ -38,10 +39,31 @@ class TmxMapFormat : public MapFormat
     Q_OBJECT
 
 public:
+    explicit TmxMapFormat(QObject *parent = nullptr);
+
+    Capabilities capabilities() const override
+    { return ReadWrite | StreamRead | StreamWrite; }
+
     Map *read(const QString &fileName) override;
 
     bool write(const Map *map, const QString &fileName) override;
 
+    Map *readFromDevice(QIODevice *device,
+                        const QString &path,
+                        const MapReadOptions &options) override;
+
+    bool writeToDevice(const Map *map,
+                       QIODevice *device,
+                       const QString &path,
+                       const MapWriteOptions &options) override;
+
+    /**
+     * Sets the cache of encoded tile layer data used when writing a map.
+     * The cache is not owned by the format.
+     */
+    void setLayerDataCache(LayerDataCache *cache)
+    { mLayerDataCache = cache; }
+
     /**
      * Converts the given map to a utf8 byte array (in .tmx format). This is
      * for storing a map in the clipboard. References to other files (like
@@ -68,6 +90,7 @@ public:
 
 private:
     QString mError;
+    LayerDataCache *mLayerDataCache;
 };
 
 
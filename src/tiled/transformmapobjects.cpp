@@ -0,0 +1,107 @@
+/*
+ * transformmapobjects.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transformmapobjects.h"
+
+#include "mapdocument.h"
+#include "mapobject.h"
+#include "mapobjectmodel.h"
+
+#include <QCoreApplication>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+TransformMapObjects::TransformMapObjects(MapDocument *mapDocument,
+                                         const QList<MapObject*> &mapObjects,
+                                         const QVector<QPointF> &oldPositions,
+                                         const QVector<QSizeF> &oldSizes,
+                                         const QVector<qreal> &oldRotations,
+                                         const QVector<QPolygonF> &oldPolygons,
+                                         QUndoCommand *parent)
+    : QUndoCommand(parent)
+    , mMapDocument(mapDocument)
+    , mMapObjects(mapObjects)
+{
+    const int count = mapObjects.size();
+
+    Q_ASSERT(oldPositions.isEmpty() || oldPositions.size() == count);
+    Q_ASSERT(oldSizes.isEmpty() || oldSizes.size() == count);
+    Q_ASSERT(oldRotations.isEmpty() || oldRotations.size() == count);
+    Q_ASSERT(oldPolygons.isEmpty() || oldPolygons.size() == count);
+
+    mOldValues.positions = oldPositions;
+    mOldValues.sizes = oldSizes;
+    mOldValues.rotations = oldRotations;
+    mOldValues.polygons = oldPolygons;
+
+    if (!oldPositions.isEmpty()) {
+        mNewValues.positions.reserve(count);
+        for (const MapObject *mapObject : mapObjects)
+            mNewValues.positions.append(mapObject->position());
+    }
+    if (!oldSizes.isEmpty()) {
+        mNewValues.sizes.reserve(count);
+        for (const MapObject *mapObject : mapObjects)
+            mNewValues.sizes.append(mapObject->size());
+    }
+    if (!oldRotations.isEmpty()) {
+        mNewValues.rotations.reserve(count);
+        for (const MapObject *mapObject : mapObjects)
+            mNewValues.rotations.append(mapObject->rotation());
+    }
+    if (!oldPolygons.isEmpty()) {
+        mNewValues.polygons.reserve(count);
+        for (const MapObject *mapObject : mapObjects)
+            mNewValues.polygons.append(mapObject->polygon());
+    }
+
+    setText(QCoreApplication::translate("Undo Commands", "Transform Object(s)"));
+}
+
+void TransformMapObjects::undo()
+{
+    apply(mOldValues);
+}
+
+void TransformMapObjects::redo()
+{
+    apply(mNewValues);
+}
+
+void TransformMapObjects::apply(const Values &values)
+{
+    for (int i = 0; i < mMapObjects.size(); ++i) {
+        MapObject *mapObject = mMapObjects.at(i);
+
+        if (!values.positions.isEmpty())
+            mapObject->setPosition(values.positions.at(i));
+        if (!values.sizes.isEmpty())
+            mapObject->setSize(values.sizes.at(i));
+        if (!values.rotations.isEmpty())
+            mapObject->setRotation(values.rotations.at(i));
+
+        // Objects without a polygon keep having none
+        if (!values.polygons.isEmpty() && !values.polygons.at(i).isEmpty())
+            mapObject->setPolygon(values.polygons.at(i));
+    }
+
+    mMapDocument->mapObjectModel()->emitObjectsChanged(mMapObjects);
+}
@@ -0,0 +1,81 @@
+/*
+ * transformmapobjects.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSFORMMAPOBJECTS_H
+#define TRANSFORMMAPOBJECTS_H
+
+#include <QList>
+#include <QPointF>
+#include <QPolygonF>
+#include <QSizeF>
+#include <QUndoCommand>
+#include <QVector>
+
+namespace Tiled {
+
+class MapObject;
+
+namespace Internal {
+
+class MapDocument;
+
+/**
+ * Undo command that changes the position, size, rotation and polygon of any
+ * number of objects at once, as done when moving, rotating or resizing them.
+ *
+ * The old values are passed in, while the new values are taken from the
+ * objects when the command is created. An empty list of values means that
+ * property is not affected. The change is announced with a single
+ * objectsChanged signal.
+ */
+class TransformMapObjects : public QUndoCommand
+{
+public:
+    TransformMapObjects(MapDocument *mapDocument,
+                        const QList<MapObject*> &mapObjects,
+                        const QVector<QPointF> &oldPositions,
+                        const QVector<QSizeF> &oldSizes,
+                        const QVector<qreal> &oldRotations,
+                        const QVector<QPolygonF> &oldPolygons,
+                        QUndoCommand *parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    struct Values {
+        QVector<QPointF> positions;
+        QVector<QSizeF> sizes;
+        QVector<qreal> rotations;
+        QVector<QPolygonF> polygons;
+    };
+
+    void apply(const Values &values);
+
+    MapDocument *mMapDocument;
+    QList<MapObject*> mMapObjects;
+    Values mOldValues;
+    Values mNewValues;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // TRANSFORMMAPOBJECTS_H
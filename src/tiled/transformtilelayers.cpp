@@ -0,0 +1,245 @@
+/*
+ * transformtilelayers.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transformtilelayers.h"
+
+#include "map.h"
+#include "mapdocument.h"
+#include "tilelayer.h"
+
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <functional>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+class LayerTask : public QRunnable
+{
+public:
+    LayerTask(const std::function<void()> &function)
+        : mFunction(function)
+    {}
+
+    void run() override { mFunction(); }
+
+private:
+    std::function<void()> mFunction;
+};
+
+/**
+ * Calls \a function for each index up to \a count, in parallel. Returns once
+ * all calls have finished.
+ */
+void forEachInParallel(int count, const std::function<void(int)> &function)
+{
+    if (count == 1) {
+        function(0);
+        return;
+    }
+
+    QThreadPool threadPool;
+    for (int i = 0; i < count; ++i)
+        threadPool.start(new LayerTask([=] { function(i); }));
+    threadPool.waitForDone();
+}
+
+} // anonymous namespace
+
+TransformTileLayers::TransformTileLayers(MapDocument *mapDocument,
+                                         const QList<int> &layerIndexes,
+                                         const QString &text)
+    : QUndoCommand(text)
+    , mMapDocument(mapDocument)
+    , mLayerIndexes(layerIndexes)
+    , mLostCells(layerIndexes.size())
+{
+    const QVector<TileLayer*> layers = tileLayers();
+    for (int i = 0; i < layers.size(); ++i)
+        mLostCells[i].originalSize = layers.at(i)->size();
+}
+
+TransformTileLayers::~TransformTileLayers()
+{
+    for (const LostCells &lostCells : mLostCells)
+        delete lostCells.cells;
+}
+
+void TransformTileLayers::undo()
+{
+    const QVector<TileLayer*> layers = tileLayers();
+    LostCells *lostCells = mLostCells.data();
+
+    forEachInParallel(layers.size(), [&] (int i) {
+        TileLayer *layer = layers.at(i);
+        LostCells &lost = lostCells[i];
+
+        revert(layer, lost.originalSize);
+
+        lost.compressedCells.decompress(lost.cells);
+        layer->merge(lost.position, lost.cells);
+    });
+
+    emitChanged(layers);
+}
+
+void TransformTileLayers::redo()
+{
+    const QVector<TileLayer*> layers = tileLayers();
+    LostCells *lostCells = mLostCells.data();
+
+    // The cells of the layers are loaded on the main thread
+    for (TileLayer *layer : layers)
+        layer->load();
+
+    forEachInParallel(layers.size(), [&] (int i) {
+        TileLayer *layer = layers.at(i);
+        LostCells &lost = lostCells[i];
+
+        // The lost cells are the same each time the command is redone
+        if (!lost.cells) {
+            const QRect layerRect(QPoint(), layer->size());
+            const QRegion area = lostArea(layer) & layerRect;
+
+            lost.position = area.boundingRect().topLeft();
+            lost.cells = layer->copy(area);
+        }
+
+        transform(layer);
+    });
+
+    emitChanged(layers);
+}
+
+qint64 TransformTileLayers::memoryUsage() const
+{
+    qint64 usage = 0;
+    for (const LostCells &lostCells : mLostCells) {
+        if (lostCells.cells)
+            usage += Internal::memoryUsage(lostCells.cells);
+        usage += lostCells.compressedCells.memoryUsage();
+    }
+    return usage;
+}
+
+void TransformTileLayers::compress()
+{
+    for (LostCells &lostCells : mLostCells)
+        if (lostCells.cells)
+            lostCells.compressedCells.compress(lostCells.cells);
+}
+
+QVector<TileLayer*> TransformTileLayers::tileLayers() const
+{
+    const Map *map = mMapDocument->map();
+
+    QVector<TileLayer*> layers;
+    layers.reserve(mLayerIndexes.size());
+    for (int index : mLayerIndexes)
+        layers.append(map->layerAt(index)->asTileLayer());
+
+    return layers;
+}
+
+
+ResizeTileLayers::ResizeTileLayers(MapDocument *mapDocument,
+                                   const QList<int> &layerIndexes,
+                                   const QSize &size,
+                                   const QPoint &offset)
+    : TransformTileLayers(mapDocument, layerIndexes,
+                          QCoreApplication::translate("Undo Commands",
+                                                      "Resize Layers"))
+    , mSize(size)
+    , mOffset(offset)
+{
+}
+
+QRegion ResizeTileLayers::lostArea(const TileLayer *layer) const
+{
+    return QRegion(QRect(QPoint(), layer->size())).subtracted(QRect(-mOffset, mSize));
+}
+
+void ResizeTileLayers::transform(TileLayer *layer) const
+{
+    layer->resize(mSize, mOffset);
+}
+
+void ResizeTileLayers::revert(TileLayer *layer, const QSize &originalSize) const
+{
+    layer->resize(originalSize, -mOffset);
+}
+
+/**
+ * The size of the layers changed, which affects the scene as a whole.
+ */
+void ResizeTileLayers::emitChanged(const QVector<TileLayer *> &)
+{
+    mMapDocument->emitMapChanged();
+}
+
+
+OffsetTileLayers::OffsetTileLayers(MapDocument *mapDocument,
+                                   const QList<int> &layerIndexes,
+                                   const QPoint &offset,
+                                   const QRect &bounds,
+                                   bool wrapX,
+                                   bool wrapY)
+    : TransformTileLayers(mapDocument, layerIndexes,
+                          QCoreApplication::translate("Undo Commands",
+                                                      "Offset Layers"))
+    , mOffset(offset)
+    , mBounds(bounds)
+    , mWrapX(wrapX)
+    , mWrapY(wrapY)
+{
+}
+
+/**
+ * The tiles that are moved out of the bounds are lost, unless they wrap
+ * around.
+ */
+QRegion OffsetTileLayers::lostArea(const TileLayer *layer) const
+{
+    const QRect area = mBounds & QRect(QPoint(), layer->size());
+    const QPoint offset(mWrapX ? 0 : mOffset.x(),
+                        mWrapY ? 0 : mOffset.y());
+
+    return QRegion(area).subtracted(area.translated(-offset));
+}
+
+void OffsetTileLayers::transform(TileLayer *layer) const
+{
+    layer->offsetTiles(mOffset, mBounds, mWrapX, mWrapY);
+}
+
+void OffsetTileLayers::revert(TileLayer *layer, const QSize &) const
+{
+    layer->offsetTiles(-mOffset, mBounds, mWrapX, mWrapY);
+}
+
+void OffsetTileLayers::emitChanged(const QVector<TileLayer*> &layers)
+{
+    for (TileLayer *layer : layers)
+        mMapDocument->emitRegionChanged(mBounds.translated(layer->position()), layer);
+}
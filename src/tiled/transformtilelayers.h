@@ -0,0 +1,155 @@
+/*
+ * transformtilelayers.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSFORMTILELAYERS_H
+#define TRANSFORMTILELAYERS_H
+
+#include "undomemory.h"
+
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QRegion>
+#include <QSize>
+#include <QUndoCommand>
+#include <QVector>
+
+namespace Tiled {
+
+class TileLayer;
+
+namespace Internal {
+
+class MapDocument;
+
+/**
+ * Base class for undo commands that transform several tile layers at once.
+ *
+ * The layers are transformed in place and in parallel. Instead of keeping
+ * copies of the layers, only the cells lost by the transformation are
+ * stored. Undoing applies the inverse transformation and puts back these
+ * cells.
+ */
+class TransformTileLayers : public QUndoCommand, public UndoCommandMemory
+{
+public:
+    ~TransformTileLayers();
+
+    void undo() override;
+    void redo() override;
+
+    qint64 memoryUsage() const override;
+    void compress() override;
+
+protected:
+    TransformTileLayers(MapDocument *mapDocument,
+                        const QList<int> &layerIndexes,
+                        const QString &text);
+
+    /**
+     * Returns the area of \a layer, in layer coordinates, of which the cells
+     * are lost when the layer is transformed.
+     */
+    virtual QRegion lostArea(const TileLayer *layer) const = 0;
+
+    virtual void transform(TileLayer *layer) const = 0;
+
+    /**
+     * Applies the inverse transformation to \a layer, which had the given
+     * \a originalSize before it was transformed. The lost cells are put
+     * back afterwards.
+     */
+    virtual void revert(TileLayer *layer, const QSize &originalSize) const = 0;
+
+    virtual void emitChanged(const QVector<TileLayer*> &layers) = 0;
+
+    MapDocument *mMapDocument;
+
+private:
+    QVector<TileLayer*> tileLayers() const;
+
+    struct LostCells
+    {
+        LostCells() : cells(nullptr) {}
+
+        QSize originalSize;
+        QPoint position;
+        TileLayer *cells;
+        CompressedCells compressedCells;
+    };
+
+    QList<int> mLayerIndexes;
+    QVector<LostCells> mLostCells;
+};
+
+/**
+ * Undo command that resizes tile layers to \a size, shifting their tiles by
+ * \a offset.
+ */
+class ResizeTileLayers : public TransformTileLayers
+{
+public:
+    ResizeTileLayers(MapDocument *mapDocument,
+                     const QList<int> &layerIndexes,
+                     const QSize &size,
+                     const QPoint &offset);
+
+protected:
+    QRegion lostArea(const TileLayer *layer) const override;
+    void transform(TileLayer *layer) const override;
+    void revert(TileLayer *layer, const QSize &originalSize) const override;
+    void emitChanged(const QVector<TileLayer*> &layers) override;
+
+private:
+    QSize mSize;
+    QPoint mOffset;
+};
+
+/**
+ * Undo command that offsets the tiles of tile layers by \a offset, within
+ * \a bounds, optionally wrapping on the x or y axis.
+ */
+class OffsetTileLayers : public TransformTileLayers
+{
+public:
+    OffsetTileLayers(MapDocument *mapDocument,
+                     const QList<int> &layerIndexes,
+                     const QPoint &offset,
+                     const QRect &bounds,
+                     bool wrapX,
+                     bool wrapY);
+
+protected:
+    QRegion lostArea(const TileLayer *layer) const override;
+    void transform(TileLayer *layer) const override;
+    void revert(TileLayer *layer, const QSize &originalSize) const override;
+    void emitChanged(const QVector<TileLayer*> &layers) override;
+
+private:
+    QPoint mOffset;
+    QRect mBounds;
+    bool mWrapX;
+    bool mWrapY;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // TRANSFORMTILELAYERS_H
@@ -32,7 +32,8 @@ enum UndoCommands {
     Cmd_ChangeLayerOffset,
     Cmd_ChangeLayerOpacity,
     Cmd_ChangeTileTerrain,
-    Cmd_ChangeTilesetTileOffset
+    Cmd_ChangeTilesetTileOffset,
+    Cmd_ChangeSelectedArea
 };
 
 #endif // UNDOCOMMANDS_H
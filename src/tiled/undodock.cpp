@@ -21,7 +21,11 @@
 
 #include "undodock.h"
 
+#include "undomemory.h"
+
 #include <QEvent>
+#include <QLabel>
+#include <QUndoGroup>
 #include <QUndoView>
 #include <QVBoxLayout>
 
@@ -30,6 +34,7 @@ using namespace Tiled::Internal;
 
 UndoDock::UndoDock(QUndoGroup *undoGroup, QWidget *parent)
     : QDockWidget(parent)
+    , mUndoGroup(undoGroup)
 {
     setObjectName(QLatin1String("undoViewDock"));
 
@@ -38,13 +43,21 @@ UndoDock::UndoDock(QUndoGroup *undoGroup, QWidget *parent)
     mUndoView->setCleanIcon(cleanIcon);
     mUndoView->setUniformItemSizes(true);
 
+    mMemoryUsageLabel = new QLabel(this);
+
     QWidget *widget = new QWidget(this);
     QVBoxLayout *layout = new QVBoxLayout(widget);
     layout->setMargin(5);
     layout->addWidget(mUndoView);
+    layout->addWidget(mMemoryUsageLabel);
 
     setWidget(widget);
     retranslateUi();
+
+    connect(undoGroup, &QUndoGroup::indexChanged,
+            this, &UndoDock::updateMemoryUsage);
+    connect(undoGroup, &QUndoGroup::activeStackChanged,
+            this, &UndoDock::updateMemoryUsage);
 }
 
 void UndoDock::changeEvent(QEvent *e)
@@ -63,4 +76,15 @@ void UndoDock::retranslateUi()
 {
     setWindowTitle(tr("History"));
     mUndoView->setEmptyLabel(tr("<empty>"));
+    updateMemoryUsage();
+}
+
+void UndoDock::updateMemoryUsage()
+{
+    const QUndoStack *stack = mUndoGroup->activeStack();
+    const qint64 usage = stack ? undoStackMemoryUsage(stack) : 0;
+    const double megabytes = usage / (1024.0 * 1024.0);
+
+    mMemoryUsageLabel->setText(tr("Memory used: %1 MB")
+                               .arg(megabytes, 0, 'f', 1));
 }
@@ -24,6 +24,7 @@
 
 #include <QDockWidget>
 
+class QLabel;
 class QUndoGroup;
 class QUndoView;
 
@@ -46,7 +47,11 @@ protected:
 
 private:
     void retranslateUi();
+    void updateMemoryUsage();
+
+    QUndoGroup *mUndoGroup;
     QUndoView *mUndoView;
+    QLabel *mMemoryUsageLabel;
 };
 
 } // namespace Internal
@@ -0,0 +1,227 @@
+/*
+ * undomemory.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "undomemory.h"
+
+#include "tilelayer.h"
+
+#include <QUndoStack>
+
+#include <cstring>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+// Cells are stored as a tile pointer followed by a byte with the flags
+const int CellSize = sizeof(quintptr) + 1;
+const int ChunkRecordSize = 2 * sizeof(qint32) + CHUNK_SIZE * CHUNK_SIZE * CellSize;
+
+} // anonymous namespace
+
+/**
+ * Moves the cells of \a layer into this object as compressed data. The layer
+ * is left empty until decompress() is called.
+ */
+void CompressedCells::compress(TileLayer *layer)
+{
+    // Layers that haven't been loaded keep their data in encoded form
+    if (!mData.isEmpty() || !layer->isLoaded() || layer->isEmpty())
+        return;
+
+    const ChunkHash chunks = layer->chunks();
+
+    QByteArray data;
+    data.reserve(chunks.size() * ChunkRecordSize);
+
+    for (auto it = chunks.begin(), it_end = chunks.end(); it != it_end; ++it) {
+        const qint32 position[2] = { it.key().x(), it.key().y() };
+        data.append(reinterpret_cast<const char*>(position), sizeof(position));
+
+        for (const Cell &cell : it.value()) {
+            const quintptr tile = reinterpret_cast<quintptr>(cell.tile);
+            const char flags = char((cell.flippedHorizontally ? 1 : 0) |
+                                    (cell.flippedVertically ? 2 : 0) |
+                                    (cell.flippedAntiDiagonally ? 4 : 0));
+
+            data.append(reinterpret_cast<const char*>(&tile), sizeof(tile));
+            data.append(flags);
+        }
+    }
+
+    mData = qCompress(data);
+
+    // Clearing the cells releases the chunks of the layer
+    for (auto it = chunks.begin(), it_end = chunks.end(); it != it_end; ++it) {
+        const QPoint origin = it.key() * CHUNK_SIZE;
+        int index = 0;
+
+        for (const Cell &cell : it.value()) {
+            if (!cell.isEmpty())
+                layer->setCell(origin.x() + (index & CHUNK_MASK),
+                               origin.y() + (index >> CHUNK_BITS),
+                               Cell());
+            ++index;
+        }
+    }
+}
+
+/**
+ * Restores the cells previously compressed from \a layer.
+ */
+void CompressedCells::decompress(TileLayer *layer)
+{
+    if (mData.isEmpty())
+        return;
+
+    const QByteArray data = qUncompress(mData);
+    mData.clear();
+
+    const char *p = data.constData();
+    const char *end = p + data.size();
+
+    while (end - p >= ChunkRecordSize) {
+        qint32 position[2];
+        memcpy(position, p, sizeof(position));
+        p += sizeof(position);
+
+        const QPoint origin = QPoint(position[0], position[1]) * CHUNK_SIZE;
+
+        for (int index = 0; index < CHUNK_SIZE * CHUNK_SIZE; ++index) {
+            quintptr tile;
+            memcpy(&tile, p, sizeof(tile));
+            const char flags = p[sizeof(tile)];
+            p += CellSize;
+
+            if (!tile)
+                continue;
+
+            Cell cell(reinterpret_cast<Tile*>(tile));
+            cell.flippedHorizontally = flags & 1;
+            cell.flippedVertically = flags & 2;
+            cell.flippedAntiDiagonally = flags & 4;
+
+            layer->setCell(origin.x() + (index & CHUNK_MASK),
+                           origin.y() + (index >> CHUNK_BITS),
+                           cell);
+        }
+    }
+}
+
+/**
+ * Moves \a mask into this object as compressed data, stored as the rects of
+ * its region. The mask is left empty until decompress() is called.
+ */
+void CompressedMask::compress(TileMask &mask)
+{
+    if (!mData.isEmpty() || mask.isEmpty())
+        return;
+
+    const QRegion region = mask.toRegion();
+
+    QByteArray data;
+    data.reserve(region.rectCount() * 4 * sizeof(qint32));
+
+    for (const QRect &rect : region.rects()) {
+        const qint32 values[4] = { rect.x(), rect.y(), rect.width(), rect.height() };
+        data.append(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+
+    mData = qCompress(data);
+    mask.clear();
+}
+
+/**
+ * Restores the mask previously compressed into this object.
+ */
+void CompressedMask::decompress(TileMask &mask)
+{
+    if (mData.isEmpty())
+        return;
+
+    const QByteArray data = qUncompress(mData);
+    mData.clear();
+
+    const char *p = data.constData();
+    const char *end = p + data.size();
+
+    while (end - p >= int(4 * sizeof(qint32))) {
+        qint32 values[4];
+        memcpy(values, p, sizeof(values));
+        p += sizeof(values);
+
+        mask.addRect(QRect(values[0], values[1], values[2], values[3]));
+    }
+}
+
+/**
+ * Returns the approximate number of bytes used by the cells of \a layer.
+ */
+qint64 Tiled::Internal::memoryUsage(const TileLayer *layer)
+{
+    return layer ? layer->cellMemoryUsage() : 0;
+}
+
+/**
+ * Returns the memory used by the commands on \a undoStack, as far as they
+ * report it.
+ */
+qint64 Tiled::Internal::undoStackMemoryUsage(const QUndoStack *undoStack)
+{
+    qint64 usage = 0;
+
+    for (int i = 0; i < undoStack->count(); ++i) {
+        auto command = dynamic_cast<const UndoCommandMemory*>(undoStack->command(i));
+        if (command)
+            usage += command->memoryUsage();
+    }
+
+    return usage;
+}
+
+/**
+ * Compresses the commands on \a undoStack, starting with the oldest ones,
+ * until their memory usage is within \a limit bytes. A \a limit of 0 means
+ * there is no limit.
+ *
+ * The most recently executed command is left alone, since it may still be
+ * merged with the next command.
+ */
+void Tiled::Internal::enforceUndoMemoryLimit(QUndoStack *undoStack, qint64 limit)
+{
+    if (limit <= 0)
+        return;
+
+    qint64 usage = undoStackMemoryUsage(undoStack);
+
+    for (int i = 0; i < undoStack->count() && usage > limit; ++i) {
+        if (i == undoStack->index() - 1)
+            continue;
+
+        auto command = dynamic_cast<UndoCommandMemory*>(const_cast<QUndoCommand*>(undoStack->command(i)));
+        if (!command)
+            continue;
+
+        const qint64 before = command->memoryUsage();
+        command->compress();
+        usage += command->memoryUsage() - before;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * undomemory.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UNDOMEMORY_H
+#define UNDOMEMORY_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+class QUndoStack;
+
+namespace Tiled {
+
+class TileLayer;
+class TileMask;
+
+namespace Internal {
+
+/**
+ * Interface for undo commands that store potentially large amounts of data,
+ * like copies of tile layers. It allows the memory used by the undo stack to
+ * be reported and kept within a budget.
+ */
+class UndoCommandMemory
+{
+public:
+    virtual ~UndoCommandMemory() {}
+
+    /**
+     * Returns the approximate number of bytes used by the data of this
+     * command.
+     */
+    virtual qint64 memoryUsage() const = 0;
+
+    /**
+     * Compresses the data of this command. The command decompresses its data
+     * again when it is undone or redone.
+     */
+    virtual void compress() = 0;
+};
+
+/**
+ * Stores the cells of a tile layer owned by an undo command in compressed
+ * form, while the layer isn't part of the map.
+ */
+class CompressedCells
+{
+public:
+    bool isEmpty() const { return mData.isEmpty(); }
+    qint64 memoryUsage() const { return mData.size(); }
+
+    void compress(TileLayer *layer);
+    void decompress(TileLayer *layer);
+
+private:
+    QByteArray mData;
+};
+
+/**
+ * Stores a tile mask owned by an undo command in compressed form, while it
+ * isn't needed.
+ */
+class CompressedMask
+{
+public:
+    bool isEmpty() const { return mData.isEmpty(); }
+    qint64 memoryUsage() const { return mData.size(); }
+
+    void compress(TileMask &mask);
+    void decompress(TileMask &mask);
+
+private:
+    QByteArray mData;
+};
+
+qint64 memoryUsage(const TileLayer *layer);
+qint64 undoStackMemoryUsage(const QUndoStack *undoStack);
+
+void enforceUndoMemoryLimit(QUndoStack *undoStack, qint64 limit);
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // UNDOMEMORY_H
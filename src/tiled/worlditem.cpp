@@ -0,0 +1,178 @@
+/*
+ * worlditem.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "worlditem.h"
+
+#include "hexagonalrenderer.h"
+#include "imagelayer.h"
+#include "isometricrenderer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
+#include "tilelayer.h"
+#include "worldmanager.h"
+#include "worldstreamer.h"
+
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+static MapRenderer *createRenderer(Map *map)
+{
+    switch (map->orientation()) {
+    case Map::Isometric:
+        return new IsometricRenderer(map);
+    case Map::Staggered:
+        return new StaggeredRenderer(map);
+    case Map::Hexagonal:
+        return new HexagonalRenderer(map);
+    case Map::Orthogonal:
+    default:
+        return new OrthogonalRenderer(map);
+    }
+}
+
+WorldItem::WorldItem(const World *world, int mapIndex, QGraphicsItem *parent)
+    : QGraphicsObject(parent)
+    , mWorld(world)
+    , mMapIndex(mapIndex)
+    , mOrigin(world->maps.at(mapIndex).rect.topLeft())
+    , mStreamer(new WorldStreamer(world, this))
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptedMouseButtons(Qt::NoButton);
+
+    QRect bounds;
+    for (const World::MapEntry &entry : world->maps)
+        bounds |= entry.rect;
+    mBoundingRect = bounds.translated(-mOrigin);
+
+    connect(mStreamer, &WorldStreamer::mapLoaded, this, &WorldItem::mapLoaded);
+    connect(mStreamer, &WorldStreamer::mapUnloaded, this, &WorldItem::mapUnloaded);
+}
+
+WorldItem::~WorldItem()
+{
+    // The renderers refer to the maps owned by the streamer
+    mStreamer->disconnect(this);
+    qDeleteAll(mRenderers);
+    delete mStreamer;
+}
+
+QRectF WorldItem::boundingRect() const
+{
+    return mBoundingRect;
+}
+
+void WorldItem::paint(QPainter *painter,
+                      const QStyleOptionGraphicsItem *option,
+                      QWidget *)
+{
+    mStreamer->setVisibleRect(visibleWorldRect(), mMapIndex);
+
+    const QRectF &exposed = option->exposedRect;
+
+    for (auto it = mRenderers.constBegin(); it != mRenderers.constEnd(); ++it) {
+        const QRect mapRect = mWorld->maps.at(it.key()).rect.translated(-mOrigin);
+        if (!exposed.intersects(mapRect))
+            continue;
+
+        const QPoint offset = mapRect.topLeft();
+        const QRectF mapExposed = exposed.translated(-offset);
+
+        MapRenderer *renderer = it.value();
+        const Map *map = renderer->map();
+
+        painter->save();
+        painter->translate(offset);
+
+        for (Layer *layer : map->layers()) {
+            if (!layer->isVisible())
+                continue;
+
+            painter->setOpacity(layer->opacity());
+            painter->save();
+            painter->translate(layer->offset());
+
+            const QRectF layerExposed = mapExposed.translated(-layer->offset());
+
+            if (TileLayer *tileLayer = layer->asTileLayer()) {
+                renderer->drawTileLayer(painter, tileLayer, layerExposed);
+            } else if (ImageLayer *imageLayer = layer->asImageLayer()) {
+                renderer->drawImageLayer(painter, imageLayer, layerExposed);
+            } else if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+                QList<MapObject*> objects = renderer->objectsIntersecting(objectGroup,
+                                                                          layerExposed);
+                objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                             [] (MapObject *object) {
+                    return !object->isVisible();
+                }), objects.end());
+
+                const QVector<QColor> colors(objects.size(), objectGroup->color());
+                renderer->drawMapObjects(painter, objects, colors);
+            }
+
+            painter->restore();
+        }
+
+        painter->restore();
+    }
+}
+
+void WorldItem::mapLoaded(int index)
+{
+    Map *map = mStreamer->maps().value(index);
+    mRenderers.insert(index, createRenderer(map));
+
+    update(QRectF(mWorld->maps.at(index).rect.translated(-mOrigin)));
+}
+
+void WorldItem::mapUnloaded(int index)
+{
+    delete mRenderers.take(index);
+
+    update(QRectF(mWorld->maps.at(index).rect.translated(-mOrigin)));
+}
+
+/**
+ * Returns the area of the world that is visible in any of the views, in
+ * pixels.
+ */
+QRect WorldItem::visibleWorldRect() const
+{
+    QRectF rect;
+
+    if (const QGraphicsScene *scene = this->scene()) {
+        for (const QGraphicsView *view : scene->views()) {
+            const QRect viewportRect = view->viewport()->rect();
+            rect |= mapRectFromScene(view->mapToScene(viewportRect).boundingRect());
+        }
+    }
+
+    return rect.toAlignedRect().translated(mOrigin);
+}
@@ -0,0 +1,76 @@
+/*
+ * worlditem.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORLDITEM_H
+#define WORLDITEM_H
+
+#include <QGraphicsObject>
+#include <QHash>
+
+namespace Tiled {
+
+class MapRenderer;
+
+namespace Internal {
+
+class World;
+class WorldStreamer;
+
+/**
+ * A graphics item displaying the maps around the edited map, when it is
+ * part of a world. The maps are streamed in as they come near the view.
+ *
+ * The item is positioned so that the edited map ends up at its place in
+ * the world. The maps it displays can't be edited.
+ */
+class WorldItem : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    WorldItem(const World *world, int mapIndex, QGraphicsItem *parent = nullptr);
+    ~WorldItem();
+
+    // QGraphicsItem
+    QRectF boundingRect() const override;
+
+    void paint(QPainter *painter,
+               const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private slots:
+    void mapLoaded(int index);
+    void mapUnloaded(int index);
+
+private:
+    QRect visibleWorldRect() const;
+
+    const World *mWorld;
+    const int mMapIndex;
+    QPoint mOrigin;
+    QRectF mBoundingRect;
+    WorldStreamer *mStreamer;
+    QHash<int, MapRenderer*> mRenderers;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // WORLDITEM_H
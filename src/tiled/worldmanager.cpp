@@ -0,0 +1,164 @@
+/*
+ * worldmanager.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "worldmanager.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+WorldManager *WorldManager::mInstance;
+
+/**
+ * Returns the file name used for identifying a map, which is the same
+ * however the map was referred to.
+ */
+static QString canonicalFileName(const QString &fileName)
+{
+    const QString canonical = QFileInfo(fileName).canonicalFilePath();
+    return canonical.isEmpty() ? QDir::cleanPath(fileName) : canonical;
+}
+
+int World::mapIndex(const QString &fileName) const
+{
+    const QString canonical = canonicalFileName(fileName);
+    for (int i = 0; i < maps.size(); ++i)
+        if (maps.at(i).fileName == canonical)
+            return i;
+    return -1;
+}
+
+/**
+ * Returns the indexes of the maps that intersect the given \a rect.
+ */
+QVector<int> World::mapsInRect(const QRect &rect) const
+{
+    QVector<int> indexes;
+    for (int i = 0; i < maps.size(); ++i)
+        if (maps.at(i).rect.intersects(rect))
+            indexes.append(i);
+    return indexes;
+}
+
+World *World::load(const QString &fileName, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = QCoreApplication::translate("File Errors", "Could not open file for reading.");
+        return nullptr;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        if (error)
+            *error = parseError.errorString();
+        return nullptr;
+    }
+
+    const QJsonObject object = document.object();
+    if (object.value(QLatin1String("type")).toString() != QLatin1String("world")) {
+        if (error)
+            *error = QCoreApplication::translate("World", "This is not a world file.");
+        return nullptr;
+    }
+
+    const QDir dir = QFileInfo(fileName).dir();
+
+    World *world = new World;
+    world->fileName = canonicalFileName(fileName);
+
+    for (const QJsonValue value : object.value(QLatin1String("maps")).toArray()) {
+        const QJsonObject mapObject = value.toObject();
+
+        MapEntry entry;
+        entry.fileName = canonicalFileName(dir.absoluteFilePath(mapObject.value(QLatin1String("fileName")).toString()));
+        entry.rect = QRect(mapObject.value(QLatin1String("x")).toInt(),
+                           mapObject.value(QLatin1String("y")).toInt(),
+                           mapObject.value(QLatin1String("width")).toInt(),
+                           mapObject.value(QLatin1String("height")).toInt());
+
+        world->maps.append(entry);
+    }
+
+    return world;
+}
+
+
+WorldManager::WorldManager()
+{
+}
+
+WorldManager::~WorldManager()
+{
+    qDeleteAll(mWorlds);
+}
+
+WorldManager *WorldManager::instance()
+{
+    if (!mInstance)
+        mInstance = new WorldManager;
+
+    return mInstance;
+}
+
+void WorldManager::deleteInstance()
+{
+    delete mInstance;
+    mInstance = nullptr;
+}
+
+const World *WorldManager::loadWorld(const QString &fileName, QString *error)
+{
+    World *world = World::load(fileName, error);
+    if (!world)
+        return nullptr;
+
+    // Reloading a world replaces it
+
+    for (int i = 0; i < mWorlds.size(); ++i) {
+        if (mWorlds.at(i)->fileName == world->fileName) {
+            delete mWorlds.at(i);
+            mWorlds.remove(i);
+            break;
+        }
+    }
+
+    mWorlds.append(world);
+    emit worldsChanged();
+
+    return world;
+}
+
+const World *WorldManager::worldForMap(const QString &fileName) const
+{
+    for (const World *world : mWorlds)
+        if (world->mapIndex(fileName) != -1)
+            return world;
+    return nullptr;
+}
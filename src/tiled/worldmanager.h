@@ -0,0 +1,102 @@
+/*
+ * worldmanager.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORLDMANAGER_H
+#define WORLDMANAGER_H
+
+#include <QObject>
+#include <QRect>
+#include <QVector>
+
+namespace Tiled {
+namespace Internal {
+
+/**
+ * A world places a number of maps next to each other, so that an area that
+ * is too large for a single map can be split up. It is stored as a JSON
+ * file like:
+ *
+ *   { "type": "world",
+ *     "maps": [ { "fileName": "a.tmx", "x": 0, "y": 0,
+ *                 "width": 3200, "height": 3200 }, ... ] }
+ *
+ * The rectangles are in pixels, so that the maps can be placed without
+ * loading them. The file names are relative to the world file.
+ */
+class World
+{
+public:
+    struct MapEntry
+    {
+        QString fileName;
+        QRect rect;
+    };
+
+    QString fileName;
+    QVector<MapEntry> maps;
+
+    int mapIndex(const QString &fileName) const;
+    QVector<int> mapsInRect(const QRect &rect) const;
+
+    static World *load(const QString &fileName, QString *error = nullptr);
+};
+
+/**
+ * Keeps track of the loaded worlds, so that the maps which are part of a
+ * world can show the maps around them.
+ */
+class WorldManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static WorldManager *instance();
+    static void deleteInstance();
+
+    /**
+     * Loads the world stored in \a fileName, replacing it when it was
+     * already loaded. Returns null and sets \a error when loading failed.
+     */
+    const World *loadWorld(const QString &fileName, QString *error = nullptr);
+
+    const QVector<World*> &worlds() const { return mWorlds; }
+
+    /**
+     * Returns the world the map with the given \a fileName is part of, or
+     * null if it isn't part of any loaded world.
+     */
+    const World *worldForMap(const QString &fileName) const;
+
+signals:
+    void worldsChanged();
+
+private:
+    WorldManager();
+    ~WorldManager();
+
+    QVector<World*> mWorlds;
+
+    static WorldManager *mInstance;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // WORLDMANAGER_H
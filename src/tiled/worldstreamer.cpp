@@ -0,0 +1,109 @@
+/*
+ * worldstreamer.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "worldstreamer.h"
+
+#include "map.h"
+#include "maploadtask.h"
+#include "tilesetmanager.h"
+#include "worldmanager.h"
+
+#include <QScopedPointer>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+WorldStreamer::WorldStreamer(const World *world, QObject *parent)
+    : QObject(parent)
+    , mWorld(world)
+    , mExcludedIndex(-1)
+{
+}
+
+WorldStreamer::~WorldStreamer()
+{
+    mThreadPool.waitForDone();
+    qDeleteAll(mTasks);
+
+    const QList<int> indexes = mMaps.keys();
+    for (int index : indexes)
+        unload(index);
+}
+
+void WorldStreamer::setVisibleRect(const QRect &rect, int excludedIndex)
+{
+    const int marginX = rect.width() / 2;
+    const int marginY = rect.height() / 2;
+
+    mLoadRect = rect.adjusted(-marginX, -marginY, marginX, marginY);
+    mKeepRect = rect.adjusted(-rect.width(), -rect.height(),
+                              rect.width(), rect.height());
+    mExcludedIndex = excludedIndex;
+
+    const QList<int> indexes = mMaps.keys();
+    for (int index : indexes)
+        if (!isWanted(index))
+            unload(index);
+
+    for (int index : mWorld->mapsInRect(mLoadRect)) {
+        if (index == mExcludedIndex || mMaps.contains(index) ||
+                mTasks.contains(index) || mFailedIndexes.contains(index))
+            continue;
+
+        MapLoadTask *task = new MapLoadTask(this, index, mWorld->maps.at(index).fileName);
+        mTasks.insert(index, task);
+        mThreadPool.start(task);
+    }
+}
+
+void WorldStreamer::taskFinished(int index)
+{
+    QScopedPointer<MapLoadTask> task(mTasks.take(index));
+
+    // The view may have moved away while the map was being read
+    if (!isWanted(index))
+        return;
+
+    Map *map = task->takeMap();
+    if (!map) {
+        mFailedIndexes.insert(index);
+        return;
+    }
+
+    TilesetManager::instance()->addReferences(map->tilesets());
+    mMaps.insert(index, map);
+
+    emit mapLoaded(index);
+}
+
+bool WorldStreamer::isWanted(int index) const
+{
+    return index != mExcludedIndex &&
+            mWorld->maps.at(index).rect.intersects(mKeepRect);
+}
+
+void WorldStreamer::unload(int index)
+{
+    Map *map = mMaps.take(index);
+    TilesetManager::instance()->removeReferences(map->tilesets());
+    delete map;
+
+    emit mapUnloaded(index);
+}
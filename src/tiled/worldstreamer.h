@@ -0,0 +1,98 @@
+/*
+ * worldstreamer.h
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORLDSTREAMER_H
+#define WORLDSTREAMER_H
+
+#include <QHash>
+#include <QObject>
+#include <QRect>
+#include <QSet>
+#include <QThreadPool>
+
+namespace Tiled {
+
+class Map;
+
+namespace Internal {
+
+class MapLoadTask;
+class World;
+
+/**
+ * Keeps the maps of a world that are near the visible area loaded.
+ *
+ * Maps are read on worker threads once they come within half a view of the
+ * visible area, and unloaded again once they are more than a full view
+ * away from it. That way scrolling around doesn't load and unload the same
+ * maps all the time, while the memory used stays bounded by the size of
+ * the view.
+ *
+ * The tilesets of the loaded maps are shared with other maps through the
+ * TilesetManager.
+ */
+class WorldStreamer : public QObject
+{
+    Q_OBJECT
+
+public:
+    WorldStreamer(const World *world, QObject *parent = nullptr);
+    ~WorldStreamer();
+
+    const World *world() const { return mWorld; }
+
+    /**
+     * Sets the visible area of the world, in pixels. Maps that should not
+     * be loaded, like the one being edited, can be given by their
+     * \a excludedIndex.
+     */
+    void setVisibleRect(const QRect &rect, int excludedIndex = -1);
+
+    /**
+     * Returns the loaded maps, by their index in the world.
+     */
+    const QHash<int, Map*> &maps() const { return mMaps; }
+
+signals:
+    void mapLoaded(int index);
+    void mapUnloaded(int index);
+
+private slots:
+    void taskFinished(int index);
+
+private:
+    bool isWanted(int index) const;
+    void unload(int index);
+
+    const World *mWorld;
+    QRect mLoadRect;
+    QRect mKeepRect;
+    int mExcludedIndex;
+
+    QHash<int, Map*> mMaps;
+    QHash<int, MapLoadTask*> mTasks;
+    QSet<int> mFailedIndexes;       // not tried again
+    QThreadPool mThreadPool;
+};
+
+} // namespace Internal
+} // namespace Tiled
+
+#endif // WORLDSTREAMER_H
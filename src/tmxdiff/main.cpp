@@ -0,0 +1,229 @@
+/*
+ * main.cpp
+ * Copyright 2026, Tiled contributors
+ *
+ * This file is part of the TMX Diff tool.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "map.h"
+#include "mapdiff.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+
+#include <memory>
+
+using namespace Tiled;
+
+namespace {
+
+struct CommandLineOptions {
+    CommandLineOptions()
+        : showHelp(false)
+        , showVersion(false)
+        , merge(false)
+    {}
+
+    bool showHelp;
+    bool showVersion;
+    bool merge;
+    QStringList files;
+};
+
+} // anonymous namespace
+
+static void showHelp()
+{
+    // TODO: Make translatable
+    qWarning() <<
+            "Usage:\n"
+            "  tmxdiff [options] [old file] [new file]\n"
+            "  tmxdiff [options] [path] [old file] [old hex] [old mode] [new file] [new hex] [new mode]\n"
+            "  tmxdiff [options] --merge [base file] [our file] [their file] [path]\n"
+            "\n"
+            "Options:\n"
+            "  -h --help               : Display this help\n"
+            "  -v --version            : Display the version\n"
+            "     --merge              : Merge the changes made to both versions since the base\n"
+            "                            version into our file, as a git merge driver\n";
+}
+
+static void showVersion()
+{
+    qWarning() << "TMX Map Diff"
+            << qPrintable(QCoreApplication::applicationVersion());
+}
+
+static void parseCommandLineArguments(CommandLineOptions &options)
+{
+    const QStringList arguments = QCoreApplication::arguments();
+
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &arg = arguments.at(i);
+        if (arg == QLatin1String("--help") || arg == QLatin1String("-h")) {
+            options.showHelp = true;
+        } else if (arg == QLatin1String("--version")
+                || arg == QLatin1String("-v")) {
+            options.showVersion = true;
+        } else if (arg == QLatin1String("--merge")) {
+            options.merge = true;
+        } else if (arg.isEmpty()) {
+            options.showHelp = true;
+        } else if (arg.at(0) == QLatin1Char('-') && arg != QLatin1String("-")) {
+            qWarning() << "Unknown option" << arg;
+            options.showHelp = true;
+        } else {
+            options.files.append(arg);
+        }
+    }
+}
+
+/**
+ * Reads the map stored in \a fileName. References are resolved relative to
+ * \a path, since git passes the versions of a map as temporary files.
+ *
+ * An empty map is returned for /dev/null, which git passes for the missing
+ * side of added and removed files.
+ */
+static Map *readMap(const QString &fileName, const QString &path)
+{
+    if (fileName == QLatin1String("/dev/null"))
+        return new Map(Map::Orthogonal, 0, 0, 0, 0);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning().noquote() << "Error opening" << fileName << ":" << file.errorString();
+        return nullptr;
+    }
+
+    // Only the layer data is compared, so the images can stay unloaded
+    MapReader reader;
+    reader.setImageLoadingDeferred(true);
+
+    Map *map = reader.readMap(&file, QFileInfo(path).absolutePath());
+    if (!map)
+        qWarning().noquote() << "Error reading" << fileName << ":" << reader.errorString();
+
+    return map;
+}
+
+static int diff(const QString &path,
+                const QString &oldFile,
+                const QString &newFile)
+{
+    std::unique_ptr<Map> oldMap(readMap(oldFile, path));
+    std::unique_ptr<Map> newMap(readMap(newFile, path));
+    if (!oldMap || !newMap)
+        return 2;
+
+    const MapDiff mapDiff(oldMap.get(), newMap.get());
+    if (mapDiff.isEmpty())
+        return 0;
+
+    QTextStream out(stdout);
+    out << "diff " << path << endl
+        << mapDiff.toString() << endl;
+
+    return 0;
+}
+
+static int merge(const QString &baseFile,
+                 const QString &ourFile,
+                 const QString &theirFile,
+                 const QString &path)
+{
+    std::unique_ptr<Map> base(readMap(baseFile, path));
+    std::unique_ptr<Map> ours(readMap(ourFile, path));
+    std::unique_ptr<Map> theirs(readMap(theirFile, path));
+    if (!base || !ours || !theirs)
+        return 2;
+
+    QStringList conflicts;
+    std::unique_ptr<Map> result(MapDiff::merge(base.get(), ours.get(), theirs.get(),
+                                               &conflicts));
+    if (!result) {
+        for (const QString &conflict : conflicts)
+            qWarning().noquote() << path << ":" << conflict;
+        return 1;
+    }
+
+    // Git expects the result in place of our version
+    QSaveFile file(ourFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning().noquote() << "Error opening" << ourFile << ":" << file.errorString();
+        return 2;
+    }
+
+    MapWriter writer;
+    writer.writeMap(result.get(), &file, QFileInfo(path).absolutePath());
+
+    if (file.error() != QFileDevice::NoError || !file.commit()) {
+        qWarning().noquote() << "Error writing" << ourFile << ":" << file.errorString();
+        return 2;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    a.setOrganizationDomain(QLatin1String("mapeditor.org"));
+    a.setApplicationName(QLatin1String("TmxDiff"));
+    a.setApplicationVersion(QLatin1String("1.0"));
+
+    CommandLineOptions options;
+    parseCommandLineArguments(options);
+
+    if (options.showVersion) {
+        showVersion();
+        return 0;
+    }
+
+    const QStringList &files = options.files;
+
+    if (options.merge && files.size() == 4 && !options.showHelp)
+        return merge(files.at(0), files.at(1), files.at(2), files.at(3));
+
+    if (!options.merge && !options.showHelp) {
+        // Directly compared files
+        if (files.size() == 2)
+            return diff(files.at(1), files.at(0), files.at(1));
+
+        // Arguments passed by git to an external diff driver
+        if (files.size() == 7)
+            return diff(files.at(0), files.at(1), files.at(4));
+    }
+
+    showHelp();
+    return 0;
+}
@@ -42,6 +42,10 @@ struct CommandLineOptions {
         , tileSize(0)
         , useAntiAliasing(false)
         , ignoreVisibility(false)
+        , threadCount(1)
+        , pyramidTileSize(0)
+        , pyramidFormat(QLatin1String("png"))
+        , useOpenGL(false)
     {}
 
     bool showHelp;
@@ -52,6 +56,10 @@ struct CommandLineOptions {
     int tileSize;
     bool useAntiAliasing;
     bool ignoreVisibility;
+    int threadCount;
+    int pyramidTileSize;
+    QString pyramidFormat;
+    bool useOpenGL;
     QStringList layersToHide;
 };
 
@@ -63,6 +71,7 @@ static void showHelp()
     qWarning() <<
             "Usage:\n"
             "  tmxrasterizer [options] [input file] [output file]\n"
+            "  tmxrasterizer [options] --pyramid SIZE [input file] [output directory]\n"
             "\n"
             "Options:\n"
             "  -h --help               : Display this help\n"
@@ -74,7 +83,14 @@ static void showHelp()
             "     --ignore-visibility  : Ignore all layer visibility flags in the map file, and render all\n"
             "                            layers in the output (default is to omit invisible layers)\n"
             "     --hide-layer         : Specifies a layer to omit from the output image\n"
-            "                            Can be repeated to hide multiple layers\n";
+            "                            Can be repeated to hide multiple layers\n"
+            "     --threads COUNT      : The number of threads used for rendering (default: 1)\n"
+            "                            Use 0 to render with one thread per processor core\n"
+            "     --pyramid SIZE       : Write a zoom pyramid of tiles of SIZE pixels in z/x/y layout\n"
+            "                            to the output directory, instead of a single image\n"
+            "     --pyramid-format FMT : The image format of the pyramid tiles (default: png)\n"
+            "     --opengl             : Render with OpenGL on an offscreen surface when available\n"
+            "                            (falls back to software rendering otherwise)\n";
 }
 
 static void showVersion()
@@ -127,11 +143,44 @@ static void parseCommandLineArguments(CommandLineOptions &options)
             } else {
                 options.layersToHide.append(arguments.at(i));
             }
+        } else if (arg == QLatin1String("--threads")) {
+            i++;
+            if (i >= arguments.size()) {
+                options.showHelp = true;
+            } else {
+                bool threadCountIsInt;
+                options.threadCount = arguments.at(i).toInt(&threadCountIsInt);
+                if (!threadCountIsInt || options.threadCount < 0) {
+                    qWarning() << arguments.at(i) << ": the specified thread count is not a valid number.";
+                    options.showHelp = true;
+                }
+            }
+        } else if (arg == QLatin1String("--pyramid")) {
+            i++;
+            if (i >= arguments.size()) {
+                options.showHelp = true;
+            } else {
+                bool tileSizeIsInt;
+                options.pyramidTileSize = arguments.at(i).toInt(&tileSizeIsInt);
+                if (!tileSizeIsInt || options.pyramidTileSize <= 0) {
+                    qWarning() << arguments.at(i) << ": the specified pyramid tile size is not a positive integer.";
+                    options.showHelp = true;
+                }
+            }
+        } else if (arg == QLatin1String("--pyramid-format")) {
+            i++;
+            if (i >= arguments.size()) {
+                options.showHelp = true;
+            } else {
+                options.pyramidFormat = arguments.at(i).toLower();
+            }
         } else if (arg == QLatin1String("--anti-aliasing")
                 || arg == QLatin1String("-a")) {
             options.useAntiAliasing = true;
         } else if (arg == QLatin1String("--ignore-visibility")) {
             options.ignoreVisibility = true;
+        } else if (arg == QLatin1String("--opengl")) {
+            options.useOpenGL = true;
         } else if (arg.isEmpty()) {
             options.showHelp = true;
         } else if (arg.at(0) == QLatin1Char('-')) {
@@ -176,6 +225,10 @@ int main(int argc, char *argv[])
     w.setAntiAliasing(options.useAntiAliasing);
     w.setIgnoreVisibility(options.ignoreVisibility);
     w.setLayersToHide(options.layersToHide);
+    w.setThreadCount(options.threadCount);
+    w.setPyramidTileSize(options.pyramidTileSize);
+    w.setPyramidFormat(options.pyramidFormat);
+    w.setUseOpenGL(options.useOpenGL);
 
 
     if (options.tileSize > 0) {
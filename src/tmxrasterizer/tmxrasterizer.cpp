@@ -34,20 +34,259 @@
 #include "map.h"
 #include "mapreader.h"
 #include "objectgroup.h"
+#include "openglrasterizer.h"
 #include "orthogonalrenderer.h"
+#include "pngwriter.h"
 #include "staggeredrenderer.h"
 #include "tilelayer.h"
-
+#include "tileset.h"
 
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
 
 using namespace Tiled;
 
+namespace {
+
+// The maximum number of pixels rendered at once when streaming a PNG image
+const int MaxBandPixels = 16 * 1024 * 1024;
+
+MapRenderer *createRenderer(const Map *map)
+{
+    switch (map->orientation()) {
+    case Map::Isometric:
+        return new IsometricRenderer(map);
+    case Map::Staggered:
+        return new StaggeredRenderer(map);
+    case Map::Hexagonal:
+        return new HexagonalRenderer(map);
+    case Map::Orthogonal:
+    default:
+        return new OrthogonalRenderer(map);
+    }
+}
+
+/**
+ * Renders a horizontal band of the output image, using its own painter and
+ * map renderer.
+ */
+class BandRenderer : public QRunnable
+{
+public:
+    BandRenderer(const TmxRasterizer *rasterizer,
+                 const Map *map,
+                 QImage &image,
+                 int top, int height,
+                 const QTransform &transform,
+                 QPainter::RenderHints renderHints)
+        : mRasterizer(rasterizer)
+        , mMap(map)
+        // Shares the memory of the output image, so no compositing is needed
+        , mBand(image.scanLine(top), image.width(), height,
+                image.bytesPerLine(), image.format())
+        , mTop(top)
+        , mTransform(transform)
+        , mRenderHints(renderHints)
+    {}
+
+    void run() override
+    {
+        QPainter painter(&mBand);
+        painter.setRenderHints(mRenderHints);
+        painter.setTransform(mTransform * QTransform::fromTranslate(0, -mTop));
+
+        const QRectF bandRect(0, mTop, mBand.width(), mBand.height());
+        const QRectF exposed = mTransform.inverted().mapRect(bandRect);
+
+        mRasterizer->drawMap(painter, mMap, exposed);
+    }
+
+private:
+    const TmxRasterizer *mRasterizer;
+    const Map *mMap;
+    QImage mBand;
+    int mTop;
+    QTransform mTransform;
+    QPainter::RenderHints mRenderHints;
+};
+
+/**
+ * Writes rows of tiles to a directory in z/x/y layout. The rows of each zoom
+ * level are downsampled in pairs to create the next lower zoom level, down
+ * to level 0, which consists of a single tile.
+ *
+ * Only two rows of tiles need to be kept in memory per zoom level. Fully
+ * transparent tiles are not written.
+ */
+class PyramidWriter
+{
+public:
+    PyramidWriter(const QString &directory,
+                  const QString &format,
+                  int tileSize,
+                  const QSize &imageSize)
+        : mDirectory(directory)
+        , mFormat(format)
+        , mTileSize(tileSize)
+    {
+        int columns = qMax(1, (imageSize.width() + tileSize - 1) / tileSize);
+        int rows = qMax(1, (imageSize.height() + tileSize - 1) / tileSize);
+
+        QVector<QSize> levels;
+        levels.prepend(QSize(columns, rows));
+        while (columns > 1 || rows > 1) {
+            columns = (columns + 1) / 2;
+            rows = (rows + 1) / 2;
+            levels.prepend(QSize(columns, rows));
+        }
+
+        mLevels = levels;
+        mPendingRows.resize(levels.size());
+        mPendingRowIndexes.fill(-1, levels.size());
+    }
+
+    int maxZoom() const { return mLevels.size() - 1; }
+    int columnCount(int zoom) const { return mLevels.at(zoom).width(); }
+    int rowCount(int zoom) const { return mLevels.at(zoom).height(); }
+
+    /**
+     * Writes the tiles in the given \a band, which is one tile high, as
+     * \a row of the given \a zoom level.
+     */
+    bool addRow(int zoom, int row, const QImage &band)
+    {
+        if (!writeTiles(zoom, row, band))
+            return false;
+
+        if (zoom == 0)
+            return true;
+
+        if (row % 2 == 0) {
+            mPendingRows[zoom] = band;
+            mPendingRowIndexes[zoom] = row;
+            return true;
+        }
+
+        const QImage upper = mPendingRows.at(zoom);
+        mPendingRows[zoom] = QImage();
+        mPendingRowIndexes[zoom] = -1;
+
+        return downsample(zoom, row / 2, upper, band);
+    }
+
+    /**
+     * Downsamples any remaining unpaired rows.
+     */
+    bool finish()
+    {
+        for (int zoom = maxZoom(); zoom > 0; --zoom) {
+            const int row = mPendingRowIndexes.at(zoom);
+            if (row == -1)
+                continue;
+
+            const QImage upper = mPendingRows.at(zoom);
+            mPendingRows[zoom] = QImage();
+            mPendingRowIndexes[zoom] = -1;
+
+            if (!downsample(zoom, row / 2, upper, QImage()))
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    bool downsample(int zoom, int parentRow,
+                    const QImage &upper, const QImage &lower)
+    {
+        const int parentColumns = columnCount(zoom - 1);
+
+        QImage combined(parentColumns * 2 * mTileSize, mTileSize * 2,
+                        QImage::Format_ARGB32_Premultiplied);
+        combined.fill(Qt::transparent);
+
+        QPainter painter(&combined);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(0, 0, upper);
+        if (!lower.isNull())
+            painter.drawImage(0, mTileSize, lower);
+        painter.end();
+
+        const QImage band = combined.scaled(parentColumns * mTileSize, mTileSize,
+                                            Qt::IgnoreAspectRatio,
+                                            Qt::SmoothTransformation);
+
+        return addRow(zoom - 1, parentRow, band);
+    }
+
+    bool writeTiles(int zoom, int row, const QImage &band)
+    {
+        for (int column = 0; column < columnCount(zoom); ++column) {
+            const QImage tile = band.copy(column * mTileSize, 0,
+                                          mTileSize, mTileSize);
+            if (isTransparent(tile))
+                continue;
+
+            const QString path = QString(QLatin1String("%1/%2/%3"))
+                    .arg(mDirectory).arg(zoom).arg(column);
+
+            if (!QDir().mkpath(path)) {
+                qWarning().nospace() << "Error creating directory " << path;
+                return false;
+            }
+
+            const QString fileName = QString(QLatin1String("%1/%2.%3"))
+                    .arg(path).arg(row).arg(mFormat);
+
+            QImageWriter writer(fileName, mFormat.toLatin1());
+            if (!writer.write(tile)) {
+                qWarning().nospace() << "Error writing " << fileName << ": "
+                                     << qPrintable(writer.errorString());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static bool isTransparent(const QImage &image)
+    {
+        const QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+
+        for (int y = 0; y < argb.height(); ++y) {
+            const QRgb *line = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+            for (int x = 0; x < argb.width(); ++x)
+                if (qAlpha(line[x]) != 0)
+                    return false;
+        }
+
+        return true;
+    }
+
+    const QString mDirectory;
+    const QString mFormat;
+    const int mTileSize;
+    QVector<QSize> mLevels;
+    QVector<QImage> mPendingRows;
+    QVector<int> mPendingRowIndexes;
+};
+
+} // anonymous namespace
+
 TmxRasterizer::TmxRasterizer():
     mScale(1.0),
     mTileSize(0),
     mUseAntiAliasing(true),
-    mIgnoreVisibility(false)
+    mIgnoreVisibility(false),
+    mThreadCount(1),
+    mPyramidTileSize(0),
+    mPyramidFormat(QLatin1String("png"))
 {
 }
 
@@ -55,7 +294,25 @@ TmxRasterizer::~TmxRasterizer()
 {
 }
 
-bool TmxRasterizer::shouldDrawLayer(Layer *layer)
+void TmxRasterizer::setUseOpenGL(bool useOpenGL)
+{
+    mOpenGLRasterizer.reset();
+
+#ifndef QT_NO_OPENGL
+    if (useOpenGL) {
+        mOpenGLRasterizer.reset(new OpenGLRasterizer);
+        if (!mOpenGLRasterizer->isAvailable()) {
+            qWarning() << "OpenGL is not available, using software rendering";
+            mOpenGLRasterizer.reset();
+        }
+    }
+#else
+    if (useOpenGL)
+        qWarning() << "Compiled without OpenGL support, using software rendering";
+#endif
+}
+
+bool TmxRasterizer::shouldDrawLayer(const Layer *layer) const
 {
     if (layer->isObjectGroup())
         return false;
@@ -69,12 +326,191 @@ bool TmxRasterizer::shouldDrawLayer(Layer *layer)
     return layer->isVisible();
 }
 
+/**
+ * Draws the layers of the \a map using the given \a painter. The
+ * \a exposed rectangle, in map coordinates, limits the part of the tile
+ * layers that is drawn. When it is null, all tiles are drawn.
+ */
+void TmxRasterizer::drawMap(QPainter &painter,
+                            const Map *map,
+                            const QRectF &exposed) const
+{
+    MapRenderer *renderer = createRenderer(map);
+    renderer->setImages(mImages.data());
+
+    // Perform a similar rendering than found in exportasimagedialog.cpp
+    foreach (Layer *layer, map->layers()) {
+
+        if (!shouldDrawLayer(layer)) 
+            continue;
+
+        painter.setOpacity(layer->opacity());
+        painter.translate(layer->offset());
+
+        const TileLayer *tileLayer = dynamic_cast<const TileLayer*>(layer);
+        const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
+
+        const QRectF layerExposed = exposed.isNull()
+                ? exposed : exposed.translated(-layer->offset());
+
+        if (tileLayer) {
+            renderer->drawTileLayer(&painter, tileLayer, layerExposed);
+        } else if (imageLayer) {
+            renderer->drawImageLayer(&painter, imageLayer, layerExposed);
+        }
+
+        painter.translate(-layer->offset());
+    }
+
+    delete renderer;
+}
+
+/**
+ * Renders the rows of the output image starting at \a top into \a image,
+ * which has the width of the output image. The \a transform maps from map
+ * to output image coordinates.
+ */
+void TmxRasterizer::renderImage(const Map *map,
+                                QImage &image,
+                                int top,
+                                const QTransform &transform,
+                                QPainter::RenderHints renderHints) const
+{
+    const QTransform imageTransform = transform * QTransform::fromTranslate(0, -top);
+
+#ifndef QT_NO_OPENGL
+    if (mOpenGLRasterizer) {
+        const bool rendered = mOpenGLRasterizer->render(image, [&] (QPainter &painter, const QRect &rect) {
+            painter.setRenderHints(renderHints);
+            painter.setTransform(imageTransform, true);
+            drawMap(painter, map, imageTransform.inverted().mapRect(QRectF(rect)));
+        });
+
+        if (rendered)
+            return;
+
+        qWarning() << "Rendering with OpenGL failed, using software rendering";
+        mOpenGLRasterizer.reset();
+    }
+#endif
+
+    const int threadCount = qBound(1, effectiveThreadCount(), image.height());
+
+    if (threadCount == 1) {
+        BandRenderer(this, map, image, 0, image.height(),
+                     imageTransform, renderHints).run();
+        return;
+    }
+
+    // Use several bands per thread, since their cost varies
+    const int bandCount = qMin(threadCount * 4, image.height());
+    const int bandHeight = (image.height() + bandCount - 1) / bandCount;
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(threadCount);
+
+    for (int bandTop = 0; bandTop < image.height(); bandTop += bandHeight) {
+        const int height = qMin(bandHeight, image.height() - bandTop);
+        threadPool.start(new BandRenderer(this, map, image, bandTop, height,
+                                          imageTransform, renderHints));
+    }
+
+    threadPool.waitForDone();
+}
+
+int TmxRasterizer::effectiveThreadCount() const
+{
+    return mThreadCount > 0 ? mThreadCount : QThread::idealThreadCount();
+}
+
+/**
+ * Writes a zoom pyramid of the map to \a directory. Only the highest zoom
+ * level is rendered, one row of tiles at a time, and the lower zoom levels
+ * are downsampled from it.
+ */
+bool TmxRasterizer::renderPyramid(const Map *map,
+                                  const QString &directory,
+                                  const QSize &mapSize,
+                                  const QTransform &transform,
+                                  QPainter::RenderHints renderHints) const
+{
+    if (!QImageWriter::supportedImageFormats().contains(mPyramidFormat.toLatin1())) {
+        qWarning().nospace() << "Unsupported image format: "
+                             << qPrintable(mPyramidFormat);
+        return false;
+    }
+
+    PyramidWriter writer(directory, mPyramidFormat, mPyramidTileSize,
+                         mapSize);
+
+    const int tileSize = mPyramidTileSize;
+    const int columns = writer.columnCount(writer.maxZoom());
+    const int rows = writer.rowCount(writer.maxZoom());
+
+    for (int row = 0; row < rows; ++row) {
+        QImage band(columns * tileSize, tileSize, QImage::Format_ARGB32);
+        band.fill(Qt::transparent);
+
+        renderImage(map, band, row * tileSize, transform, renderHints);
+
+        if (!writer.addRow(writer.maxZoom(), row, band))
+            return false;
+    }
+
+    return writer.finish();
+}
+
+/**
+ * Writes the map as PNG image to \a fileName, rendering it in bands which
+ * are written out as they are completed. This way the memory used depends
+ * on the width of the image rather than on its area.
+ */
+bool TmxRasterizer::renderPng(const Map *map,
+                              const QString &fileName,
+                              const QSize &mapSize,
+                              const QTransform &transform,
+                              QPainter::RenderHints renderHints) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning().nospace() << "Error opening " << fileName << ": "
+                             << qPrintable(file.errorString());
+        return false;
+    }
+
+    PngWriter writer(&file);
+    bool ok = writer.begin(mapSize);
+
+    const int bandHeight = qBound(1, MaxBandPixels / qMax(1, mapSize.width()),
+                                  mapSize.height());
+
+    for (int top = 0; ok && top < mapSize.height(); top += bandHeight) {
+        QImage band(mapSize.width(), qMin(bandHeight, mapSize.height() - top),
+                    QImage::Format_ARGB32);
+        band.fill(Qt::transparent);
+
+        renderImage(map, band, top, transform, renderHints);
+        ok = writer.writeRows(band);
+    }
+
+    ok = ok && writer.finish() && file.commit();
+
+    if (!ok) {
+        qWarning().nospace() << "Error writing " << fileName << ": "
+                             << qPrintable(writer.errorString().isEmpty() ? file.errorString()
+                                                                          : writer.errorString());
+    }
+
+    return ok;
+}
+
 int TmxRasterizer::render(const QString &mapFileName,
-                          const QString &imageFileName)
+                          const QString &outputFileName)
 {
     Map *map;
-    MapRenderer *renderer;
     MapReader reader;
+    reader.setCacheEnabled(true);
+    reader.setTilesetCacheEnabled(true);
     map = reader.readMap(mapFileName);
     if (!map) {
         qWarning().nospace() << "Error while reading " << mapFileName << ":\n"
@@ -82,22 +518,6 @@ int TmxRasterizer::render(const QString &mapFileName,
         return 1;
     }
 
-    switch (map->orientation()) {
-    case Map::Isometric:
-        renderer = new IsometricRenderer(map);
-        break;
-    case Map::Staggered:
-        renderer = new StaggeredRenderer(map);
-        break;
-    case Map::Hexagonal:
-        renderer = new HexagonalRenderer(map);
-        break;
-    case Map::Orthogonal:
-    default:
-        renderer = new OrthogonalRenderer(map);
-        break;
-    }
-
     qreal xScale, yScale;
 
     if (mTileSize > 0) {
@@ -107,7 +527,9 @@ int TmxRasterizer::render(const QString &mapFileName,
         xScale = yScale = mScale;
     }
 
+    MapRenderer *renderer = createRenderer(map);
     QSize mapSize = renderer->mapSize();
+    delete renderer;
 
     QMargins margins = map->computeLayerOffsetMargins();
     mapSize.setWidth(mapSize.width() + margins.left() + margins.right());
@@ -116,46 +538,45 @@ int TmxRasterizer::render(const QString &mapFileName,
     mapSize.rwidth() *= xScale;
     mapSize.rheight() *= yScale;
 
-    QImage image(mapSize, QImage::Format_ARGB32);
-    image.fill(Qt::transparent);
-    QPainter painter(&image);
+    QTransform transform;
+    QPainter::RenderHints renderHints;
 
     if (xScale != qreal(1) || yScale != qreal(1)) {
         if (mUseAntiAliasing) {
-            painter.setRenderHints(QPainter::SmoothPixmapTransform |
-                                   QPainter::Antialiasing);
+            renderHints = QPainter::SmoothPixmapTransform |
+                    QPainter::Antialiasing;
         }
-        painter.setTransform(QTransform::fromScale(xScale, yScale));
+        transform.scale(xScale, yScale);
     }
 
-    painter.translate(margins.left(), margins.top());
+    transform.translate(margins.left(), margins.top());
 
-    // Perform a similar rendering than found in exportasimagedialog.cpp
-    foreach (Layer *layer, map->layers()) {
+    // Pixmaps can only be used on the main thread, so the rendering threads
+    // draw from copies of the images instead
+    if (effectiveThreadCount() > 1)
+        mImages.reset(new MapImages(map));
 
-        if (!shouldDrawLayer(layer)) 
-            continue;
+    int result = 0;
 
-        painter.setOpacity(layer->opacity());
-        painter.translate(layer->offset());
-
-        const TileLayer *tileLayer = dynamic_cast<const TileLayer*>(layer);
-        const ImageLayer *imageLayer = dynamic_cast<const ImageLayer*>(layer);
+    if (mPyramidTileSize > 0) {
+        if (!renderPyramid(map, outputFileName, mapSize, transform, renderHints))
+            result = 1;
+    } else if (QFileInfo(outputFileName).suffix().compare(QLatin1String("png"),
+                                                         Qt::CaseInsensitive) == 0) {
+        if (!renderPng(map, outputFileName, mapSize, transform, renderHints))
+            result = 1;
+    } else {
+        QImage image(mapSize, QImage::Format_ARGB32);
+        image.fill(Qt::transparent);
 
-        if (tileLayer) {
-            renderer->drawTileLayer(&painter, tileLayer);
-        } else if (imageLayer) {
-            renderer->drawImageLayer(&painter, imageLayer);
-        }
+        renderImage(map, image, 0, transform, renderHints);
 
-        painter.translate(-layer->offset());
+        // Save image
+        image.save(outputFileName);
     }
 
-    // Save image
-    image.save(imageFileName);
-
-    delete renderer;
+    mImages.reset();
     delete map;
 
-    return 0;
+    return result;
 }
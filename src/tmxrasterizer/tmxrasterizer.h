@@ -31,9 +31,18 @@
 
 #include "layer.h"
 
+#include <QPainter>
+#include <QRectF>
+#include <QScopedPointer>
 #include <QString>
 #include <QStringList>
 
+namespace Tiled {
+class Map;
+class MapImages;
+class OpenGLRasterizer;
+}
+
 using namespace Tiled;
 
 class TmxRasterizer
@@ -47,25 +56,73 @@ public:
     int tileSize() const { return mTileSize; }
     bool useAntiAliasing() const { return mUseAntiAliasing; }
     bool IgnoreVisibility() const { return mIgnoreVisibility; }
+    int threadCount() const { return mThreadCount; }
 
     void setScale(qreal scale) { mScale = scale; }
     void setTileSize(int tileSize) { mTileSize = tileSize; }
     void setAntiAliasing(bool useAntiAliasing) { mUseAntiAliasing = useAntiAliasing; }
     void setIgnoreVisibility(bool IgnoreVisibility) { mIgnoreVisibility = IgnoreVisibility; }
 
+    /**
+     * Sets the number of threads used for rendering. When more than one
+     * thread is used, the image is split into horizontal bands which are
+     * rendered in parallel. A value of 0 uses one thread per processor core.
+     */
+    void setThreadCount(int threadCount) { mThreadCount = threadCount; }
+
+    /**
+     * Sets the size of the tiles of the zoom pyramid. When larger than 0,
+     * render() writes a pyramid of tiles in z/x/y layout to the output
+     * directory instead of writing a single image.
+     */
+    void setPyramidTileSize(int tileSize) { mPyramidTileSize = tileSize; }
+    void setPyramidFormat(const QString &format) { mPyramidFormat = format; }
+
     void setLayersToHide(QStringList layersToHide) { mLayersToHide = layersToHide; }
 
-    int render(const QString &mapFileName, const QString &imageFileName);
+    /**
+     * Sets whether the map is rendered with OpenGL on an offscreen surface.
+     * Rendering falls back to software when OpenGL is not available.
+     */
+    void setUseOpenGL(bool useOpenGL);
+
+    int render(const QString &mapFileName, const QString &outputFileName);
+
+    void drawMap(QPainter &painter, const Map *map,
+                 const QRectF &exposed = QRectF()) const;
 
 private:
     qreal mScale;
     int mTileSize;
     bool mUseAntiAliasing;
     bool mIgnoreVisibility;
+    int mThreadCount;
+    int mPyramidTileSize;
+    QString mPyramidFormat;
     QStringList mLayersToHide;
+    mutable QScopedPointer<OpenGLRasterizer> mOpenGLRasterizer;
+    QScopedPointer<MapImages> mImages;
+
+    bool shouldDrawLayer(const Layer *layer) const;
+    int effectiveThreadCount() const;
+
+    void renderImage(const Map *map,
+                     QImage &image,
+                     int top,
+                     const QTransform &transform,
+                     QPainter::RenderHints renderHints) const;
 
-    bool shouldDrawLayer(Layer *layer);
+    bool renderPng(const Map *map,
+                   const QString &fileName,
+                   const QSize &mapSize,
+                   const QTransform &transform,
+                   QPainter::RenderHints renderHints) const;
 
+    bool renderPyramid(const Map *map,
+                       const QString &directory,
+                       const QSize &mapSize,
+                       const QTransform &transform,
+                       QPainter::RenderHints renderHints) const;
 };
 
 #endif // TMXRASTERIZER_H
@@ -37,60 +37,24 @@
 #include "orthogonalrenderer.h"
 #include "staggeredrenderer.h"
 #include "tilelayer.h"
+#include "tilelayerrendercache.h"
 #include "tileset.h"
 
 #include <QCoreApplication>
 #include <QDebug>
 #include <QGraphicsItem>
 #include <QGraphicsScene>
+#include <QHash>
+#include <QPair>
 #include <QStyleOptionGraphicsItem>
 
-using namespace Tiled;
-
-/**
- * Item that represents a map object.
- */
-class MapObjectItem : public QGraphicsItem
-{
-public:
-    MapObjectItem(MapObject *mapObject, MapRenderer *renderer,
-                  QGraphicsItem *parent = nullptr)
-        : QGraphicsItem(parent)
-        , mMapObject(mapObject)
-        , mRenderer(renderer)
-    {
-        const QPointF &position = mapObject->position();
-        const QPointF pixelPos = renderer->pixelToScreenCoords(position);
-
-        QRectF boundingRect = renderer->boundingRect(mapObject);
-        boundingRect.translate(-pixelPos);
-        mBoundingRect = boundingRect;
+#include <algorithm>
 
-        setPos(pixelPos);
-        setRotation(mapObject->rotation());
-    }
-
-    QRectF boundingRect() const override
-    {
-        return mBoundingRect;
-    }
-
-    void paint(QPainter *p, const QStyleOptionGraphicsItem *, QWidget *) override
-    {
-        const QColor &color = mMapObject->objectGroup()->color();
-        p->translate(-pos());
-        mRenderer->drawMapObject(p, mMapObject,
-                                 color.isValid() ? color : Qt::darkGray);
-    }
-
-private:
-    MapObject *mMapObject;
-    MapRenderer *mRenderer;
-    QRectF mBoundingRect;
-};
+using namespace Tiled;
 
 /**
- * Item that represents a tile layer.
+ * Item that represents a tile layer. The layer is drawn through a cache of
+ * rendered chunks, so that scrolling and repeated repaints are cheap.
  */
 class TileLayerItem : public QGraphicsItem
 {
@@ -112,16 +76,20 @@ public:
 
     void paint(QPainter *p, const QStyleOptionGraphicsItem *option, QWidget *) override
     {
-        mRenderer->drawTileLayer(p, mTileLayer, option->rect);
+        mRenderCache.draw(p, mRenderer, mTileLayer,
+                          option->exposedRect & boundingRect());
     }
 
 private:
     TileLayer *mTileLayer;
     MapRenderer *mRenderer;
+    TileLayerRenderCache mRenderCache;
 };
 
 /**
- * Item that represents an object group.
+ * Item that represents an object group. Rather than creating an item for
+ * each object, it paints the objects in the exposed area, which are looked
+ * up through the spatial index of the object group.
  */
 class ObjectGroupItem : public QGraphicsItem
 {
@@ -129,22 +97,61 @@ public:
     ObjectGroupItem(ObjectGroup *objectGroup, MapRenderer *renderer,
                     QGraphicsItem *parent = nullptr)
         : QGraphicsItem(parent)
+        , mObjectGroup(objectGroup)
+        , mRenderer(renderer)
     {
-        setFlag(QGraphicsItem::ItemHasNoContents);
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
         setPos(objectGroup->offset());
 
-        const ObjectGroup::DrawOrder drawOrder = objectGroup->drawOrder();
+        const QColor &color = objectGroup->color();
+        mColor = color.isValid() ? color : Qt::darkGray;
+
+        const bool topDown = objectGroup->drawOrder() == ObjectGroup::TopDownOrder;
 
-        // Create a child item for each object
-        foreach (MapObject *object, objectGroup->objects()) {
-            MapObjectItem *item = new MapObjectItem(object, renderer, this);
-            if (drawOrder == ObjectGroup::TopDownOrder)
-                item->setZValue(item->y());
+        // Remember the draw order of the objects and the area they cover
+        for (int i = 0; i < objectGroup->objectCount(); ++i) {
+            const MapObject *object = objectGroup->objectAt(i);
+            mDrawKeys.insert(object, qMakePair(topDown ? object->y() : qreal(0), i));
+            mBoundingRect |= objectBoundingRect(object);
         }
     }
 
-    QRectF boundingRect() const override { return QRectF(); }
-    void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override {}
+    QRectF boundingRect() const override { return mBoundingRect; }
+
+    void paint(QPainter *p, const QStyleOptionGraphicsItem *option, QWidget *) override
+    {
+        QList<MapObject*> objects = mRenderer->objectsIntersecting(mObjectGroup,
+                                                                   option->exposedRect);
+
+        std::sort(objects.begin(), objects.end(),
+                  [this] (const MapObject *a, const MapObject *b) {
+            return mDrawKeys.value(a) < mDrawKeys.value(b);
+        });
+
+        mRenderer->drawMapObjects(p, objects, QVector<QColor>(objects.size(), mColor));
+    }
+
+private:
+    QRectF objectBoundingRect(const MapObject *object) const
+    {
+        const QRectF bounds = mRenderer->boundingRect(object);
+        if (object->rotation() == 0)
+            return bounds;
+
+        const QPointF origin = mRenderer->pixelToScreenCoords(object->position());
+
+        QTransform transform;
+        transform.translate(origin.x(), origin.y());
+        transform.rotate(object->rotation());
+        transform.translate(-origin.x(), -origin.y());
+        return transform.mapRect(bounds);
+    }
+
+    ObjectGroup *mObjectGroup;
+    MapRenderer *mRenderer;
+    QColor mColor;
+    QRectF mBoundingRect;
+    QHash<const MapObject*, QPair<qreal, int>> mDrawKeys;
 };
 
 /**
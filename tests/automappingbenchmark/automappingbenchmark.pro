@@ -0,0 +1,31 @@
+include(../../src/libtiled/libtiled.pri)
+
+QT += testlib
+CONFIG += c++11
+TEMPLATE = app
+
+macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/Frameworks
+    TILED_EXECUTABLE = $$OUT_PWD/../../bin/Tiled.app/Contents/MacOS/Tiled
+} else:win32 {
+    LIBS += -L$$OUT_PWD/../../lib
+    TILED_EXECUTABLE = $$OUT_PWD/../../tiled.exe
+} else {
+    LIBS += -L$$OUT_PWD/../../lib
+    TILED_EXECUTABLE = $$OUT_PWD/../../bin/tiled
+}
+
+# The automapping engine is part of the Tiled executable, so it is
+# benchmarked through its --automap mode
+DEFINES += TILED_EXECUTABLE=\\\"$$TILED_EXECUTABLE\\\"
+
+!win32:!macx {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../../lib
+
+    # It is not possible to use ORIGIN in QMAKE_RPATHDIR, so a bit manually
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$$join(QMAKE_RPATHDIR, ":")\'
+    QMAKE_RPATHDIR =
+}
+
+# Input
+SOURCES += test_automappingbenchmark.cpp
@@ -0,0 +1,225 @@
+#include "map.h"
+#include "mapwriter.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
+using namespace Tiled;
+
+/**
+ * Benchmarks automapping by running the Tiled executable in its --automap
+ * mode, on the maps in tests/automapping and on generated maps of
+ * different sizes.
+ */
+class test_AutomappingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void fixture_data();
+    void fixture();
+
+    void syntheticMap_data();
+    void syntheticMap();
+
+private:
+    void writeRules(const QString &path);
+    void writeMap(const QString &fileName, int size);
+
+    QTemporaryDir mDir;
+    SharedTileset mTileset;
+};
+
+/**
+ * Runs automapping on the given map, which is saved in place. Returns the
+ * exit code, or -1 when the process crashed.
+ */
+static int autoMap(const QString &fileName)
+{
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    if (!environment.contains(QLatin1String("QT_QPA_PLATFORM")))
+        environment.insert(QLatin1String("QT_QPA_PLATFORM"), QLatin1String("offscreen"));
+
+    QProcess process;
+    process.setProcessEnvironment(environment);
+    process.start(QLatin1String(TILED_EXECUTABLE),
+                  QStringList() << QLatin1String("--automap") << fileName);
+
+    if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit)
+        return -1;
+
+    return process.exitCode();
+}
+
+void test_AutomappingBenchmark::initTestCase()
+{
+    if (!QFileInfo(QLatin1String(TILED_EXECUTABLE)).exists())
+        QSKIP("The Tiled executable has not been built");
+
+    QVERIFY(mDir.isValid());
+
+    // A tileset with four differently colored tiles
+    QImage image(128, 32, QImage::Format_ARGB32);
+    for (int i = 0; i < 4; ++i) {
+        const QRect tileRect(i * 32, 0, 32, 32);
+        for (int y = tileRect.top(); y <= tileRect.bottom(); ++y)
+            for (int x = tileRect.left(); x <= tileRect.right(); ++x)
+                image.setPixel(x, y, qRgb(i * 64, 255 - i * 64, 128));
+    }
+
+    const QString imagePath = mDir.path() + QLatin1String("/tiles.png");
+    QVERIFY(image.save(imagePath));
+
+    mTileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    QVERIFY(mTileset->loadFromImage(image, imagePath));
+
+    // Copy the fixtures, since automapping saves the maps in place
+    for (int i = 1; i <= 4; ++i) {
+        const QDir source(QString(QLatin1String("../automapping/%1")).arg(i));
+        const QString target = mDir.path() + QString(QLatin1String("/fixture%1")).arg(i);
+        QVERIFY(QDir().mkpath(target));
+
+        foreach (const QString &fileName, source.entryList(QDir::Files)) {
+            QVERIFY(QFile::copy(source.filePath(fileName),
+                                target + QLatin1Char('/') + fileName));
+        }
+    }
+
+    writeRules(mDir.path() + QLatin1String("/synthetic"));
+}
+
+void test_AutomappingBenchmark::fixture_data()
+{
+    QTest::addColumn<QString>("fileName");
+
+    for (int i = 1; i <= 4; ++i) {
+        const QString name = QString(QLatin1String("fixture%1")).arg(i);
+        QTest::newRow(qPrintable(name))
+                << mDir.path() + QString(QLatin1String("/%1/%2.tmx")).arg(name).arg(i);
+    }
+}
+
+void test_AutomappingBenchmark::fixture()
+{
+    QFETCH(QString, fileName);
+
+    // The fixtures are broken rule sets, so only their speed is of interest
+    int exitCode = 0;
+    QBENCHMARK {
+        exitCode = autoMap(fileName);
+    }
+    QVERIFY(exitCode != -1);
+}
+
+void test_AutomappingBenchmark::syntheticMap_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("256x256") << 256;
+    QTest::newRow("1024x1024") << 1024;
+    QTest::newRow("4096x4096") << 4096;
+}
+
+void test_AutomappingBenchmark::syntheticMap()
+{
+    QFETCH(int, size);
+
+    const QString fileName = mDir.path() +
+            QString(QLatin1String("/synthetic/map%1.tmx")).arg(size);
+    writeMap(fileName, size);
+
+    // The rules don't read their own output, so automapping the same map
+    // again takes the same amount of work
+    int exitCode = 0;
+    QBENCHMARK {
+        exitCode = autoMap(fileName);
+    }
+    QCOMPARE(exitCode, 0);
+}
+
+/**
+ * Writes a rules map with three rules to the given directory:
+ *
+ * - A 2x2 rule that is found through its input tiles
+ * - A 2x2 rule with two different input tiles
+ * - A 2x1 rule that only has inputnot conditions, so that it needs to be
+ *   tested at every position
+ */
+void test_AutomappingBenchmark::writeRules(const QString &path)
+{
+    QVERIFY(QDir().mkpath(path));
+
+    Map rules(Map::Orthogonal, 8, 2, 32, 32);
+    rules.addTileset(mTileset);
+
+    TileLayer *regions = new TileLayer(QLatin1String("regions"), 0, 0, 8, 2);
+    TileLayer *input = new TileLayer(QLatin1String("input_set"), 0, 0, 8, 2);
+    TileLayer *inputNot = new TileLayer(QLatin1String("inputnot_set"), 0, 0, 8, 2);
+    TileLayer *output = new TileLayer(QLatin1String("output_ground"), 0, 0, 8, 2);
+
+    const Cell region(mTileset->tileAt(0));
+    for (int x : { 0, 1, 3, 4 }) {
+        regions->setCell(x, 0, region);
+        regions->setCell(x, 1, region);
+    }
+    regions->setCell(6, 0, region);
+    regions->setCell(7, 0, region);
+
+    input->setCell(0, 0, Cell(mTileset->tileAt(1)));
+    input->setCell(1, 0, Cell(mTileset->tileAt(1)));
+    output->setCell(0, 1, Cell(mTileset->tileAt(2)));
+    output->setCell(1, 1, Cell(mTileset->tileAt(2)));
+
+    input->setCell(3, 0, Cell(mTileset->tileAt(2)));
+    input->setCell(4, 1, Cell(mTileset->tileAt(1)));
+    output->setCell(4, 0, Cell(mTileset->tileAt(3)));
+
+    inputNot->setCell(6, 0, Cell(mTileset->tileAt(0)));
+    inputNot->setCell(7, 0, Cell(mTileset->tileAt(0)));
+    output->setCell(6, 0, Cell(mTileset->tileAt(3)));
+    output->setCell(7, 0, Cell(mTileset->tileAt(3)));
+
+    rules.addLayer(regions);
+    rules.addLayer(input);
+    rules.addLayer(inputNot);
+    rules.addLayer(output);
+
+    MapWriter writer;
+    QVERIFY(writer.writeMap(&rules, path + QLatin1String("/rules.tmx")));
+
+    QFile rulesFile(path + QLatin1String("/rules.txt"));
+    QVERIFY(rulesFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    rulesFile.write("rules.tmx\n");
+}
+
+/**
+ * Writes a map of the given size, filled with a deterministic pattern of
+ * the four tiles.
+ */
+void test_AutomappingBenchmark::writeMap(const QString &fileName, int size)
+{
+    Map map(Map::Orthogonal, size, size, 32, 32);
+    map.addTileset(mTileset);
+
+    TileLayer *layer = new TileLayer(QLatin1String("set"), 0, 0, size, size);
+
+    quint32 random = 1;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            random = random * 1103515245 + 12345;
+            layer->setCell(x, y, Cell(mTileset->tileAt((random >> 16) & 3)));
+        }
+    }
+
+    map.addLayer(layer);
+
+    MapWriter writer;
+    QVERIFY(writer.writeMap(&map, fileName));
+}
+
+QTEST_MAIN(test_AutomappingBenchmark)
+#include "test_automappingbenchmark.moc"
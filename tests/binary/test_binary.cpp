@@ -0,0 +1,450 @@
+#include "compression.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapdiff.h"
+#include "mapformat.h"
+#include "mapobject.h"
+#include "mapwriter.h"
+#include "objectgroup.h"
+#include "plugin.h"
+#include "pluginmanager.h"
+#include "terrain.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+#include <QPluginLoader>
+#include <QTemporaryDir>
+#include <QtEndian>
+
+#include <memory>
+
+using namespace Tiled;
+
+/**
+ * Tests the binary map format by writing maps with all supported layer
+ * types, embedded and external tilesets and custom properties and reading
+ * them back, and by reading truncated and corrupted files.
+ */
+class test_Binary : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void roundTrip_data();
+    void roundTrip();
+
+    void truncated_data();
+    void truncated();
+
+    void corrupt_data();
+    void corrupt();
+
+    void corruptBytes();
+
+private:
+    Map *createMap(Map::LayerDataFormat format) const;
+    QByteArray writeMap(Map::LayerDataFormat format);
+    Map *readMap(const QByteArray &contents);
+
+    QTemporaryDir mDir;
+    QString mImagePath;
+    SharedTileset mExternalTileset;
+    MapFormat *mFormat;
+};
+
+// The layout of the file header and the chunk directory
+static const int HeaderSize = 16;
+static const int ChunkEntrySize = 32;
+
+/**
+ * Returns the position of the entry with the given four character type in
+ * the chunk directory, or -1 when there is no such chunk.
+ */
+static int chunkEntry(const QByteArray &contents, const char *type)
+{
+    const uchar *data = reinterpret_cast<const uchar*>(contents.constData());
+    const quint32 count = qFromLittleEndian<quint32>(data + 8);
+
+    for (quint32 i = 0; i < count; ++i) {
+        const int entry = HeaderSize + int(i) * ChunkEntrySize;
+        if (contents.mid(entry, 4) == type)
+            return entry;
+    }
+    return -1;
+}
+
+static quint64 chunkOffset(const QByteArray &contents, int entry)
+{
+    const uchar *data = reinterpret_cast<const uchar*>(contents.constData());
+    return qFromLittleEndian<quint64>(data + entry + 8);
+}
+
+void test_Binary::initTestCase()
+{
+    mFormat = nullptr;
+
+    QVERIFY(mDir.isValid());
+
+    // A tileset image of 4x2 tiles
+    QImage image(128, 64, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgb(x * 2, y * 4, (x / 32) * 64));
+
+    mImagePath = mDir.path() + QLatin1String("/tiles.png");
+    QVERIFY(image.save(mImagePath));
+
+    mExternalTileset = Tileset::create(QLatin1String("external"), 32, 32);
+    QVERIFY(mExternalTileset->loadFromImage(image, mImagePath));
+    mExternalTileset->tileAt(5)->setProperty(QLatin1String("kind"), QLatin1String("wall"));
+
+    const QString tilesetPath = mDir.path() + QLatin1String("/external.tsx");
+    QVERIFY(MapWriter().writeTileset(*mExternalTileset, tilesetPath));
+    mExternalTileset->setFileName(tilesetPath);
+
+    // Load only the binary plugin, which registers the binary map format
+    PluginManager::instance();
+
+    const QDir pluginDir(QLatin1String(TILED_PLUGINS_PATH));
+    foreach (const QString &fileName, pluginDir.entryList(QDir::Files)) {
+        const QString filePath = pluginDir.filePath(fileName);
+        if (!fileName.contains(QLatin1String("binary")) || !QLibrary::isLibrary(filePath))
+            continue;
+
+        QPluginLoader loader(filePath);
+        if (Plugin *plugin = qobject_cast<Plugin*>(loader.instance()))
+            plugin->initialize();
+    }
+
+    foreach (MapFormat *format, PluginManager::objects<MapFormat>()) {
+        if (format->nameFilter().contains(QLatin1String("*.tmb"))) {
+            mFormat = format;
+            break;
+        }
+    }
+
+    QVERIFY2(mFormat, "The binary plugin has not been built");
+}
+
+/**
+ * Creates a map with an embedded tileset, an image collection tileset and
+ * an external tileset, a visible and a hidden tile layer, an object layer
+ * and an image layer, most of them carrying custom properties.
+ */
+Map *test_Binary::createMap(Map::LayerDataFormat format) const
+{
+    Map *map = new Map(Map::Orthogonal, 16, 12, 32, 32);
+    map->setLayerDataFormat(format);
+    map->setBackgroundColor(QColor(10, 20, 30));
+    map->setProperty(QLatin1String("author"), QLatin1String("test"));
+    map->setProperty(QLatin1String("level"), QLatin1String("3"));
+
+    SharedTileset tiles = Tileset::create(QLatin1String("tiles"), 32, 32);
+    tiles->loadFromImage(QImage(mImagePath), mImagePath);
+    tiles->setProperty(QLatin1String("biome"), QLatin1String("forest"));
+    tiles->addTerrain(QLatin1String("grass"), 0);
+    tiles->tileAt(1)->setProperty(QLatin1String("solid"), QLatin1String("true"));
+    tiles->tileAt(2)->setTerrain(0x00000000);
+    tiles->tileAt(2)->setProbability(0.5f);
+
+    QVector<Frame> frames;
+    for (int i = 0; i < 2; ++i) {
+        Frame frame;
+        frame.tileId = i;
+        frame.duration = 100 * (i + 1);
+        frames.append(frame);
+    }
+    tiles->tileAt(3)->setFrames(frames);
+
+    SharedTileset collection = Tileset::create(QLatin1String("collection"), 64, 64);
+    for (int i = 0; i < 3; ++i) {
+        Tile *tile = collection->addTile(QPixmap(mImagePath), mImagePath);
+        tile->setProperty(QLatin1String("index"), QString::number(i));
+    }
+
+    map->addTileset(tiles);
+    map->addTileset(collection);
+    map->addTileset(mExternalTileset);
+
+    TileLayer *ground = new TileLayer(QLatin1String("Ground"), 0, 0, 16, 12);
+    for (int y = 0; y < 12; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            const int index = x + y * 16;
+            const Tileset *tileset = index % 3 ? tiles.data() : mExternalTileset.data();
+
+            Cell cell(tileset->tileAt(index % 8));
+            cell.flippedHorizontally = index % 5 == 0;
+            cell.flippedVertically = index % 7 == 0;
+            cell.flippedAntiDiagonally = index % 11 == 0;
+            ground->setCell(x, y, cell);
+        }
+    }
+    ground->setProperty(QLatin1String("collides"), QLatin1String("false"));
+    map->addLayer(ground);
+
+    ObjectGroup *objectGroup = new ObjectGroup(QLatin1String("Objects"), 0, 0, 16, 12);
+    objectGroup->setColor(QColor(255, 0, 0));
+    objectGroup->setProperty(QLatin1String("spawn"), QLatin1String("yes"));
+
+    MapObject *rectangle = new MapObject(QLatin1String("door"), QLatin1String("Door"),
+                                         QPointF(32, 64), QSizeF(32, 16));
+    rectangle->setProperty(QLatin1String("target"), QLatin1String("room2"));
+    rectangle->setRotation(45);
+    objectGroup->addObject(rectangle);
+
+    MapObject *polygon = new MapObject(QLatin1String("area"), QString(),
+                                       QPointF(100, 100), QSizeF());
+    polygon->setShape(MapObject::Polygon);
+    polygon->setPolygon(QPolygonF() << QPointF(0, 0) << QPointF(50, 10)
+                                    << QPointF(20, 40));
+    objectGroup->addObject(polygon);
+
+    MapObject *ellipse = new MapObject(QLatin1String("pond"), QString(),
+                                       QPointF(200, 50), QSizeF(40, 20));
+    ellipse->setShape(MapObject::Ellipse);
+    ellipse->setVisible(false);
+    objectGroup->addObject(ellipse);
+
+    MapObject *tileObject = new MapObject(QLatin1String("chest"), QString(),
+                                          QPointF(64, 256), QSizeF(64, 64));
+    Cell chestCell(collection->tileAt(1));
+    chestCell.flippedHorizontally = true;
+    tileObject->setCell(chestCell);
+    objectGroup->addObject(tileObject);
+
+    for (int i = 0; i < objectGroup->objectCount(); ++i)
+        objectGroup->objectAt(i)->setId(i + 1);
+    map->setNextObjectId(objectGroup->objectCount() + 1);
+
+    map->addLayer(objectGroup);
+
+    ImageLayer *imageLayer = new ImageLayer(QLatin1String("Background"), 0, 0, 16, 12);
+    imageLayer->loadFromImage(mImagePath);
+    imageLayer->setTransparentColor(QColor(255, 0, 255));
+    imageLayer->setOffset(QPointF(8, -4));
+    imageLayer->setOpacity(0.75);
+    map->addLayer(imageLayer);
+
+    // Hidden layers are read lazily
+    TileLayer *hidden = new TileLayer(QLatin1String("Hidden"), 0, 0, 16, 12);
+    for (int i = 0; i < 12; ++i)
+        hidden->setCell(i, i, Cell(tiles->tileAt(i % 8)));
+    hidden->setVisible(false);
+    hidden->setOpacity(0.5);
+    map->addLayer(hidden);
+
+    return map;
+}
+
+/**
+ * Writes the map created by createMap() to a file and returns its contents.
+ */
+QByteArray test_Binary::writeMap(Map::LayerDataFormat format)
+{
+    std::unique_ptr<Map> map(createMap(format));
+    const QString fileName = mDir.path() + QLatin1String("/map.tmb");
+    if (!mFormat->write(map.get(), fileName))
+        return QByteArray();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+/**
+ * Reads a map from the given file contents, which are written next to the
+ * tileset files so that relative references resolve.
+ */
+Map *test_Binary::readMap(const QByteArray &contents)
+{
+    const QString fileName = mDir.path() + QLatin1String("/input.tmb");
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return nullptr;
+    file.write(contents);
+    file.close();
+
+    return mFormat->read(fileName);
+}
+
+void test_Binary::roundTrip_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("xml") << int(Map::XML);
+    QTest::newRow("csv") << int(Map::CSV);
+    QTest::newRow("base64") << int(Map::Base64);
+    QTest::newRow("base64-gzip") << int(Map::Base64Gzip);
+    QTest::newRow("base64-zlib") << int(Map::Base64Zlib);
+    QTest::newRow("base64-zstd") << int(Map::Base64Zstandard);
+    QTest::newRow("base64-lz4") << int(Map::Base64Lz4);
+}
+
+void test_Binary::roundTrip()
+{
+    QFETCH(int, format);
+
+    if (format == Map::Base64Zstandard && !compressionSupported(Zstandard))
+        QSKIP("Zstandard compression is not supported");
+    if (format == Map::Base64Lz4 && !compressionSupported(Lz4))
+        QSKIP("LZ4 compression is not supported");
+
+    std::unique_ptr<Map> map(createMap(Map::LayerDataFormat(format)));
+    const QString fileName = mDir.path() + QLatin1String("/map.tmb");
+    QVERIFY2(mFormat->write(map.get(), fileName), qPrintable(mFormat->errorString()));
+    QVERIFY(mFormat->supportsFile(fileName));
+
+    std::unique_ptr<Map> readMap(mFormat->read(fileName));
+    QVERIFY2(readMap, qPrintable(mFormat->errorString()));
+
+    const MapDiff diff(map.get(), readMap.get());
+    QVERIFY2(diff.isEmpty(), qPrintable(diff.toString()));
+
+    // Details not covered by the diff
+    QCOMPARE(readMap->layerDataFormat(), map->layerDataFormat());
+    QCOMPARE(readMap->backgroundColor(), map->backgroundColor());
+    QCOMPARE(readMap->tilesetCount(), 3);
+
+    const SharedTileset tiles = readMap->tilesets().at(0);
+    QCOMPARE(tiles->terrainCount(), 1);
+    QCOMPARE(tiles->terrain(0)->name(), QLatin1String("grass"));
+    QCOMPARE(tiles->tileAt(1)->property(QLatin1String("solid")), QLatin1String("true"));
+    QCOMPARE(tiles->tileAt(3)->frames().size(), 2);
+
+    const SharedTileset external = readMap->tilesets().at(2);
+    QVERIFY(external->isExternal());
+    QCOMPARE(external->fileName(), mExternalTileset->fileName());
+    QCOMPARE(external->tileAt(5)->property(QLatin1String("kind")), QLatin1String("wall"));
+
+    QCOMPARE(readMap->layerCount(), 4);
+    QVERIFY(readMap->layerAt(1)->isObjectGroup());
+    QVERIFY(readMap->layerAt(2)->isImageLayer());
+
+    const ImageLayer *imageLayer = readMap->layerAt(2)->asImageLayer();
+    QCOMPARE(imageLayer->transparentColor(), QColor(255, 0, 255));
+    QCOMPARE(imageLayer->image().size(), QSize(128, 64));
+
+    const TileLayer *hidden = readMap->layerAt(3)->asTileLayer();
+    QVERIFY(!hidden->isVisible());
+    QCOMPARE(hidden->cellAt(5, 5).tile, tiles->tileAt(5));
+}
+
+void test_Binary::truncated_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<int>("divisor");
+    QTest::addColumn<int>("size");
+
+    // Sizes are either a fixed number of bytes, or a part of the file
+    QTest::newRow("empty") << int(Map::XML) << 0 << 0;
+    QTest::newRow("magic") << int(Map::XML) << 0 << 4;
+    QTest::newRow("header") << int(Map::XML) << 0 << HeaderSize;
+    QTest::newRow("directory") << int(Map::XML) << 0 << HeaderSize + ChunkEntrySize + 8;
+    QTest::newRow("half") << int(Map::XML) << 2 << 0;
+    QTest::newRow("last-byte") << int(Map::XML) << 1 << -1;
+    QTest::newRow("half-compressed") << int(Map::Base64Zlib) << 2 << 0;
+    QTest::newRow("last-byte-compressed") << int(Map::Base64Zlib) << 1 << -1;
+}
+
+void test_Binary::truncated()
+{
+    QFETCH(int, format);
+    QFETCH(int, divisor);
+    QFETCH(int, size);
+
+    const QByteArray contents = writeMap(Map::LayerDataFormat(format));
+    QVERIFY(!contents.isEmpty());
+
+    if (divisor)
+        size += contents.size() / divisor;
+
+    std::unique_ptr<Map> map(readMap(contents.left(size)));
+    QVERIFY(!map);
+    QVERIFY(!mFormat->errorString().isEmpty());
+}
+
+void test_Binary::corrupt_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QString>("chunk");
+    QTest::addColumn<int>("position");
+    QTest::addColumn<QByteArray>("bytes");
+    QTest::addColumn<QString>("error");
+
+    // Positions are relative to the start of the given chunk, or to the
+    // start of the file when no chunk is given
+    QTest::newRow("magic")
+            << int(Map::XML) << QString() << 0 << QByteArray("TMXF")
+            << QString(QLatin1String("Not a Tiled binary map file."));
+    QTest::newRow("version")
+            << int(Map::XML) << QString() << 4 << QByteArray("\x02\0\0\0", 4)
+            << QString(QLatin1String("Unsupported file version: 2"));
+    QTest::newRow("chunk-count")
+            << int(Map::XML) << QString() << 8 << QByteArray("\xff\xff\xff\x0f", 4)
+            << QString(QLatin1String("Corrupt chunk directory."));
+    QTest::newRow("no-chunks")
+            << int(Map::XML) << QString() << 8 << QByteArray("\0\0\0\0", 4)
+            << QString(QLatin1String("Corrupt chunk directory."));
+    QTest::newRow("chunk-size")
+            << int(Map::XML) << QString() << HeaderSize + 16 << QByteArray("\xff\xff\xff\xff\0\0\0\0", 8)
+            << QString(QLatin1String("Corrupt chunk directory."));
+    QTest::newRow("compression")
+            << int(Map::Base64Zlib) << QString(QLatin1String("CELL")) << 0 << QByteArray(16, '\x55')
+            << QString(QLatin1String("Corrupt or unsupported compressed chunk"));
+    QTest::newRow("cells")
+            << int(Map::XML) << QString(QLatin1String("CELL")) << 0 << QByteArray("\xf0\xff\xff\x0f", 4)
+            << QString(QLatin1String("Invalid tile"));
+}
+
+void test_Binary::corrupt()
+{
+    QFETCH(int, format);
+    QFETCH(QString, chunk);
+    QFETCH(int, position);
+    QFETCH(QByteArray, bytes);
+    QFETCH(QString, error);
+
+    QByteArray contents = writeMap(Map::LayerDataFormat(format));
+    QVERIFY(!contents.isEmpty());
+
+    if (!chunk.isEmpty()) {
+        const int entry = chunkEntry(contents, qPrintable(chunk));
+        QVERIFY(entry != -1);
+        position += int(chunkOffset(contents, entry));
+    }
+
+    contents.replace(position, bytes.size(), bytes);
+
+    std::unique_ptr<Map> map(readMap(contents));
+    QVERIFY(!map);
+    QVERIFY2(mFormat->errorString().startsWith(error),
+             qPrintable(mFormat->errorString()));
+}
+
+/**
+ * Flips every byte of a file in turn. Reading has to either succeed or fail
+ * with an error, without crashing. Running this under a memory checker also
+ * catches reads beyond the end of the file.
+ */
+void test_Binary::corruptBytes()
+{
+    const QByteArray contents = writeMap(Map::XML);
+    QVERIFY(!contents.isEmpty());
+
+    for (int i = 0; i < contents.size(); ++i) {
+        QByteArray corrupted = contents;
+        corrupted[i] = char(corrupted.at(i) ^ 0xff);
+
+        std::unique_ptr<Map> map(readMap(corrupted));
+        if (!map)
+            QVERIFY2(!mFormat->errorString().isEmpty(), qPrintable(QString::number(i)));
+    }
+}
+
+QTEST_MAIN(test_Binary)
+#include "test_binary.moc"
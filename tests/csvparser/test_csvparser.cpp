@@ -0,0 +1,168 @@
+#include "csvparser.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+typedef QVector<QPair<unsigned, bool>> Values;
+
+Q_DECLARE_METATYPE(Values)
+
+class test_CsvParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+    void base_data();
+    void base();
+    void matchesToUInt_data();
+    void matchesToUInt();
+};
+
+template<typename Char>
+static Values parse(const Char *begin, const Char *end, int base = 10)
+{
+    CsvParser<Char> parser(begin, end, base);
+    Values values;
+    unsigned value;
+    bool ok;
+
+    while (parser.next(value, ok))
+        values.append(qMakePair(value, ok));
+
+    return values;
+}
+
+static Values parse(const QString &text, int base = 10)
+{
+    return parse(text.constData(), text.constData() + text.size(), base);
+}
+
+static Values parse(const QByteArray &text, int base = 10)
+{
+    return parse(text.constData(), text.constData() + text.size(), base);
+}
+
+void test_CsvParser::parse_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<Values>("values");
+
+    const QPair<unsigned, bool> invalid(0, false);
+
+    QTest::newRow("empty") << QString() << Values();
+    QTest::newRow("single") << QString::fromLatin1("42")
+                            << (Values() << qMakePair(42u, true));
+    QTest::newRow("several") << QString::fromLatin1("1,0,3")
+                             << (Values() << qMakePair(1u, true)
+                                          << qMakePair(0u, true)
+                                          << qMakePair(3u, true));
+    QTest::newRow("whitespace") << QString::fromLatin1("\n  7 ,\t8\r\n,9  \n")
+                                << (Values() << qMakePair(7u, true)
+                                             << qMakePair(8u, true)
+                                             << qMakePair(9u, true));
+    QTest::newRow("only whitespace") << QString::fromLatin1("  \n ")
+                                     << (Values() << invalid);
+    QTest::newRow("trailing comma") << QString::fromLatin1("1,2,")
+                                    << (Values() << qMakePair(1u, true)
+                                                 << qMakePair(2u, true)
+                                                 << invalid);
+    QTest::newRow("empty values") << QString::fromLatin1(",,5")
+                                  << (Values() << invalid << invalid
+                                               << qMakePair(5u, true));
+    QTest::newRow("largest") << QString::fromLatin1("4294967295")
+                             << (Values() << qMakePair(4294967295u, true));
+    QTest::newRow("too large") << QString::fromLatin1("4294967296,1")
+                               << (Values() << invalid << qMakePair(1u, true));
+    QTest::newRow("way too large") << QString::fromLatin1("123456789012345678901234,2")
+                                   << (Values() << invalid << qMakePair(2u, true));
+    QTest::newRow("flags") << QString::fromLatin1("2147483649,3221225473")
+                           << (Values() << qMakePair(2147483649u, true)
+                                        << qMakePair(3221225473u, true));
+    QTest::newRow("negative") << QString::fromLatin1("-1,3")
+                              << (Values() << invalid << qMakePair(3u, true));
+    QTest::newRow("space within") << QString::fromLatin1("1 2,3")
+                                  << (Values() << invalid << qMakePair(3u, true));
+    QTest::newRow("garbage after") << QString::fromLatin1("12abc,4")
+                                   << (Values() << invalid << qMakePair(4u, true));
+    QTest::newRow("non-latin") << (QString::fromLatin1("5") + QChar(0x0663) + QLatin1String(",6"))
+                               << (Values() << invalid << qMakePair(6u, true));
+}
+
+void test_CsvParser::parse()
+{
+    QFETCH(QString, text);
+    QFETCH(Values, values);
+
+    QCOMPARE(::parse(text), values);
+
+    // The 8-bit parser gives the same results for Latin-1 text
+    bool latin1 = true;
+    for (const QChar c : text)
+        latin1 &= c.unicode() < 0x80;
+    if (latin1)
+        QCOMPARE(::parse(text.toLatin1()), values);
+}
+
+void test_CsvParser::base_data()
+{
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<int>("base");
+    QTest::addColumn<Values>("values");
+
+    QTest::newRow("hex") << QByteArray("ff,10,A0") << 16
+                         << (Values() << qMakePair(255u, true)
+                                      << qMakePair(16u, true)
+                                      << qMakePair(160u, true));
+    QTest::newRow("hex largest") << QByteArray("ffffffff") << 16
+                                 << (Values() << qMakePair(0xFFFFFFFFu, true));
+    QTest::newRow("hex too large") << QByteArray("100000000") << 16
+                                   << (Values() << qMakePair(0u, false));
+    QTest::newRow("hex in decimal") << QByteArray("ff,9") << 10
+                                    << (Values() << qMakePair(0u, false)
+                                                 << qMakePair(9u, true));
+    QTest::newRow("octal") << QByteArray("17,8") << 8
+                           << (Values() << qMakePair(15u, true)
+                                        << qMakePair(0u, false));
+}
+
+void test_CsvParser::base()
+{
+    QFETCH(QByteArray, text);
+    QFETCH(int, base);
+    QFETCH(Values, values);
+
+    QCOMPARE(::parse(text, base), values);
+}
+
+void test_CsvParser::matchesToUInt_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("numbers") << QString::fromLatin1("0,1,22,333,4444,55555");
+    QTest::newRow("layer data") << QString::fromLatin1("\n1,2,3,\n4,5,6,\n7,8,9\n");
+    QTest::newRow("mixed") << QString::fromLatin1(" 3 , x,,4294967295, 4294967296 ,7 7,");
+}
+
+/**
+ * The parser replaced splitting the text and converting each value with
+ * QString::toUInt(), which should give the same results.
+ */
+void test_CsvParser::matchesToUInt()
+{
+    QFETCH(QString, text);
+
+    Values expected;
+    for (const QString &part : text.split(QLatin1Char(','))) {
+        bool ok;
+        const unsigned value = part.toUInt(&ok);
+        expected.append(qMakePair(value, ok));
+    }
+
+    QCOMPARE(::parse(text), expected);
+}
+
+QTEST_MAIN(test_CsvParser)
+#include "test_csvparser.moc"
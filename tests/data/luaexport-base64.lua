@@ -0,0 +1,84 @@
+return {
+  version = "1.1",
+  luaversion = "5.1",
+  tiledversion = "1.0.0",
+  orientation = "orthogonal",
+  renderorder = "right-down",
+  width = 4,
+  height = 3,
+  tilewidth = 32,
+  tileheight = 32,
+  nextobjectid = 2,
+  properties = {},
+  tilesets = {
+    {
+      name = "Desert",
+      firstgid = 1,
+      tilewidth = 32,
+      tileheight = 32,
+      spacing = 1,
+      margin = 1,
+      image = "../../examples/tmw_desert_spacing.png",
+      imagewidth = 265,
+      imageheight = 199,
+      tileoffset = {
+        x = 0,
+        y = 0
+      },
+      properties = {},
+      terrains = {},
+      tilecount = 48,
+      tiles = {}
+    }
+  },
+  layers = {
+    {
+      type = "tilelayer",
+      name = "Ground",
+      x = 0,
+      y = 0,
+      width = 4,
+      height = 3,
+      visible = true,
+      opacity = 1,
+      properties = {},
+      encoding = "base64",
+      data = "AQAAAAIAAAADAAAABAAAAAkAAAAKAAAACwAAAAwAAAARAAAAEgAAABMAAAAUAAAA"
+    },
+    {
+      type = "tilelayer",
+      name = "Decoration",
+      x = 0,
+      y = 0,
+      width = 4,
+      height = 3,
+      visible = true,
+      opacity = 0.5,
+      properties = {},
+      encoding = "base64",
+      data = "AAAAAAAAAAAfAAAAAAAAAAAAAAAeAACAAAAAAAAAAAAAAAAAAAAAAAAAAAAoAABA"
+    },
+    {
+      type = "objectgroup",
+      name = "Objects",
+      visible = true,
+      opacity = 1,
+      properties = {},
+      objects = {
+        {
+          id = 1,
+          name = "Start",
+          type = "",
+          shape = "rectangle",
+          x = 32,
+          y = 64,
+          width = 32,
+          height = 32,
+          rotation = 0,
+          visible = true,
+          properties = {}
+        }
+      }
+    }
+  }
+}
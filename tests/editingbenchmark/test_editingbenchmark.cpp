@@ -0,0 +1,417 @@
+#include "map.h"
+#include "mapwriter.h"
+#include "randompicker.h"
+#include "terrain.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
+#include <memory>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+/**
+ * Benchmarks the primitives used while editing tile layers, on layers of
+ * realistic sizes.
+ *
+ * The flood fill and the merging of paint commands live in the Tiled
+ * executable, so they are measured by running its --benchmark mode, which
+ * reports the time taken by each of its steps.
+ */
+class test_EditingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void region_data();
+    void region();
+
+    void mask_data();
+    void mask();
+
+    void merge_data();
+    void merge();
+
+    void copy_data();
+    void copy();
+
+    void rotate_data();
+    void rotate();
+
+    void flip_data();
+    void flip();
+
+    void resize_data();
+    void resize();
+
+    void offsetTiles_data();
+    void offsetTiles();
+
+    void randomPick_data();
+    void randomPick();
+
+    void terrainDistances_data();
+    void terrainDistances();
+
+    void floodFill_data();
+    void floodFill();
+
+    void paintStroke_data();
+    void paintStroke();
+
+private:
+    TileLayer *createLayer(int size) const;
+    qint64 runBenchmarkStep(int size, const char *step);
+
+    QTemporaryDir mDir;
+    QString mImagePath;
+    SharedTileset mTileset;
+};
+
+static void addSizeRows()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("256x256") << 256;
+    QTest::newRow("1024x1024") << 1024;
+    QTest::newRow("4096x4096") << 4096;
+}
+
+void test_EditingBenchmark::initTestCase()
+{
+    QVERIFY(mDir.isValid());
+
+    // A tileset of 16x16 differently colored tiles
+    QImage image(512, 512, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgb((x / 32) * 16, (y / 32) * 16, 128));
+
+    mImagePath = mDir.path() + QLatin1String("/tiles.png");
+    QVERIFY(image.save(mImagePath));
+
+    mTileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    QVERIFY(mTileset->loadFromImage(image, mImagePath));
+}
+
+void test_EditingBenchmark::region_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::region()
+{
+    QFETCH(int, size);
+
+    std::unique_ptr<TileLayer> layer(createLayer(size));
+
+    QBENCHMARK {
+        const QRegion region = layer->region();
+        QVERIFY(!region.isEmpty());
+    }
+}
+
+void test_EditingBenchmark::mask_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::mask()
+{
+    QFETCH(int, size);
+
+    std::unique_ptr<TileLayer> layer(createLayer(size));
+
+    QBENCHMARK {
+        const TileMask mask = layer->mask();
+        QVERIFY(!mask.isEmpty());
+    }
+}
+
+void test_EditingBenchmark::merge_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::merge()
+{
+    QFETCH(int, size);
+
+    std::unique_ptr<TileLayer> layer(createLayer(size));
+    std::unique_ptr<TileLayer> other(createLayer(size / 2));
+
+    QBENCHMARK {
+        layer->merge(QPoint(size / 4, size / 4), other.get());
+    }
+}
+
+void test_EditingBenchmark::copy_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::copy()
+{
+    QFETCH(int, size);
+
+    std::unique_ptr<TileLayer> layer(createLayer(size));
+
+    // A region that doesn't line up with the chunks, like a selection
+    QRegion region(1, 1, size / 2, size / 2);
+    region += QRect(size / 3, size / 3, size / 2, size / 3);
+
+    QBENCHMARK {
+        std::unique_ptr<TileLayer> copy(layer->copy(region));
+        QVERIFY(copy);
+    }
+}
+
+void test_EditingBenchmark::rotate_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::rotate()
+{
+    QFETCH(int, size);
+
+    std::unique_ptr<TileLayer> layer(createLayer(size));
+
+    QBENCHMARK {
+        layer->rotate(RotateRight);
+    }
+}
+
+void test_EditingBenchmark::flip_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::flip()
+{
+    QFETCH(int, size);
+
+    std::unique_ptr<TileLayer> layer(createLayer(size));
+
+    QBENCHMARK {
+        layer->flip(FlipHorizontally);
+        layer->flip(FlipVertically);
+    }
+}
+
+void test_EditingBenchmark::resize_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::resize()
+{
+    QFETCH(int, size);
+
+    std::unique_ptr<TileLayer> layer(createLayer(size));
+
+    // Growing and shrinking again, so that each iteration does the same work
+    QBENCHMARK {
+        layer->resize(QSize(size + 10, size + 10), QPoint(5, 5));
+        layer->resize(QSize(size, size), QPoint(-5, -5));
+    }
+}
+
+void test_EditingBenchmark::offsetTiles_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::offsetTiles()
+{
+    QFETCH(int, size);
+
+    std::unique_ptr<TileLayer> layer(createLayer(size));
+    const QRect bounds(0, 0, size, size);
+
+    QBENCHMARK {
+        layer->offsetTiles(QPoint(3, 7), bounds, true, true);
+    }
+}
+
+void test_EditingBenchmark::randomPick_data()
+{
+    QTest::addColumn<int>("valueCount");
+
+    QTest::newRow("4") << 4;
+    QTest::newRow("256") << 256;
+    QTest::newRow("65536") << 65536;
+}
+
+void test_EditingBenchmark::randomPick()
+{
+    QFETCH(int, valueCount);
+
+    RandomPicker<int> picker;
+    picker.setSeed(1);
+    for (int i = 0; i < valueCount; ++i)
+        picker.add(i, 1 + i % 7);
+
+    // Enough picks to fill a 1024x1024 area with random tiles
+    int sum = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 1024 * 1024; ++i)
+            sum += picker.pick();
+    }
+    QVERIFY(sum >= 0);
+}
+
+void test_EditingBenchmark::terrainDistances_data()
+{
+    QTest::addColumn<int>("terrainCount");
+
+    QTest::newRow("4") << 4;
+    QTest::newRow("16") << 16;
+    QTest::newRow("64") << 64;
+}
+
+void test_EditingBenchmark::terrainDistances()
+{
+    QFETCH(int, terrainCount);
+
+    SharedTileset tileset = Tileset::create(QLatin1String("terrains"), 32, 32);
+    QVERIFY(tileset->loadFromImage(QImage(mImagePath), mImagePath));
+
+    for (int i = 0; i < terrainCount; ++i)
+        tileset->addTerrain(QString::number(i), i);
+
+    // Each tile connects two terrains, which forms a chain of transitions
+    for (int i = 0; i < tileset->tileCount(); ++i) {
+        const int terrain0 = i % terrainCount;
+        const int terrain1 = (terrain0 + 1 + (i / terrainCount) % 2) % terrainCount;
+
+        Tile *tile = tileset->tileAt(i);
+        tile->setCornerTerrainId(0, terrain0);
+        tile->setCornerTerrainId(1, terrain0);
+        tile->setCornerTerrainId(2, terrain1);
+        tile->setCornerTerrainId(3, terrain1);
+    }
+
+    QBENCHMARK {
+        tileset->markTerrainDistancesDirty();
+        QVERIFY(tileset->terrainTransitionPenalty(0, terrainCount - 1) >= 0);
+    }
+}
+
+void test_EditingBenchmark::floodFill_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::floodFill()
+{
+    QFETCH(int, size);
+
+    const qint64 ms = runBenchmarkStep(size, "flood fill");
+    QVERIFY(ms >= 0);
+
+    QTest::setBenchmarkResult(ms, QTest::WalltimeMilliseconds);
+}
+
+void test_EditingBenchmark::paintStroke_data()
+{
+    addSizeRows();
+}
+
+void test_EditingBenchmark::paintStroke()
+{
+    QFETCH(int, size);
+
+    // A stroke of 1000 stamps, each merged into the first paint command
+    const qint64 ms = runBenchmarkStep(size, "stamp paint");
+    QVERIFY(ms >= 0);
+
+    QTest::setBenchmarkResult(ms, QTest::WalltimeMilliseconds);
+}
+
+/**
+ * Creates a tile layer of the given size, with rectangular areas of
+ * different tiles, like a hand-made map. Every other area is left empty,
+ * so that the layer has holes.
+ */
+TileLayer *test_EditingBenchmark::createLayer(int size) const
+{
+    TileLayer *layer = new TileLayer(QLatin1String("layer"), 0, 0, size, size);
+    TileLayer::BulkEdit bulkEdit(layer);
+
+    quint32 random = 1;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            const int area = (x / 13) + (y / 9) * 7;
+            if (area % 5 == 0)
+                continue;
+
+            random = random * 1103515245 + 12345;
+            const int variation = (random >> 16) & 3;
+            layer->setCell(x, y, Cell(mTileset->tileAt((area * 4 + variation) % mTileset->tileCount())));
+        }
+    }
+
+    return layer;
+}
+
+/**
+ * Writes a map of the given size and runs the Tiled executable in its
+ * --benchmark mode on it. Returns the time reported for the given \a step,
+ * or -1 when it was not reported.
+ */
+qint64 test_EditingBenchmark::runBenchmarkStep(int size, const char *step)
+{
+    if (!QFileInfo(QLatin1String(TILED_EXECUTABLE)).exists())
+        QSKIP("The Tiled executable has not been built");
+
+    const QString fileName = mDir.path() +
+            QString(QLatin1String("/map%1.tmx")).arg(size);
+
+    if (!QFileInfo(fileName).exists()) {
+        Map map(Map::Orthogonal, size, size, 32, 32);
+        map.addTileset(mTileset);
+        map.addLayer(createLayer(size));
+
+        MapWriter writer;
+        if (!writer.writeMap(&map, fileName))
+            return -1;
+    }
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    if (!environment.contains(QLatin1String("QT_QPA_PLATFORM")))
+        environment.insert(QLatin1String("QT_QPA_PLATFORM"), QLatin1String("offscreen"));
+
+    QProcess process;
+    process.setProcessEnvironment(environment);
+    process.start(QLatin1String(TILED_EXECUTABLE),
+                  QStringList() << QLatin1String("--benchmark") << fileName);
+
+    if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit)
+        return -1;
+
+    // Each line has the file name, the step and the time in ms
+    const QStringList lines = QString::fromLocal8Bit(process.readAllStandardError())
+            .split(QLatin1Char('\n'));
+
+    for (const QString &line : lines) {
+        const QStringList columns = line.trimmed().split(QLatin1Char('\t'));
+        if (columns.size() != 3 || columns.at(1) != QLatin1String(step))
+            continue;
+
+        bool ok;
+        const qint64 ms = columns.at(2).section(QLatin1Char(' '), 0, 0).toLongLong(&ok);
+        return ok ? ms : -1;
+    }
+
+    return -1;
+}
+
+QTEST_MAIN(test_EditingBenchmark)
+#include "test_editingbenchmark.moc"
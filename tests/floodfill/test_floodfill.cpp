@@ -0,0 +1,216 @@
+#include "floodfill.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+using namespace Tiled::Internal;
+
+namespace {
+
+/**
+ * A grid of characters placed at \a topLeft, where the fill matches the
+ * positions with the same character as the fill origin.
+ */
+class Grid
+{
+public:
+    Grid(const QStringList &rows, const QPoint &topLeft = QPoint())
+        : mRows(rows)
+        , mTopLeft(topLeft)
+    {}
+
+    QRect bounds() const
+    { return QRect(mTopLeft, QSize(mRows.first().size(), mRows.size())); }
+
+    QChar at(int x, int y) const
+    { return mRows.at(y - mTopLeft.y()).at(x - mTopLeft.x()); }
+
+    /**
+     * Returns the positions marked with \a c.
+     */
+    QRegion region(QChar c) const
+    {
+        QRegion region;
+        for (int y = 0; y < mRows.size(); ++y)
+            for (int x = 0; x < mRows.at(y).size(); ++x)
+                if (mRows.at(y).at(x) == c)
+                    region += QRect(mTopLeft.x() + x, mTopLeft.y() + y, 1, 1);
+        return region;
+    }
+
+    TileMask fill(const QPoint &origin) const
+    {
+        const QChar match = at(origin.x(), origin.y());
+        return floodFill(bounds(), origin, [&] (int x, int y) {
+            return at(x, y) == match;
+        });
+    }
+
+private:
+    QStringList mRows;
+    QPoint mTopLeft;
+};
+
+} // anonymous namespace
+
+class test_FloodFill : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void openArea();
+    void walls();
+    void diagonals();
+    void spiral();
+    void comb();
+    void negativeCoordinates();
+    void canceled();
+    void tileLayer();
+};
+
+void test_FloodFill::openArea()
+{
+    const QRect bounds(0, 0, 40, 33);
+    const TileMask mask = floodFill(bounds, QPoint(17, 20),
+                                    [] (int, int) { return true; });
+    QCOMPARE(mask.toRegion(), QRegion(bounds));
+
+    // A single position
+    const TileMask single = floodFill(QRect(5, 5, 1, 1), QPoint(5, 5),
+                                      [] (int, int) { return true; });
+    QCOMPARE(single.toRegion(), QRegion(5, 5, 1, 1));
+}
+
+void test_FloodFill::walls()
+{
+    const Grid grid({
+        QLatin1String("aa#bbb"),
+        QLatin1String("aa#bbb"),
+        QLatin1String("###bbb"),
+        QLatin1String("cccc#b"),
+    });
+
+    QCOMPARE(grid.fill(QPoint(0, 0)).toRegion(), grid.region(QLatin1Char('a')));
+    QCOMPARE(grid.fill(QPoint(5, 3)).toRegion(), grid.region(QLatin1Char('b')));
+    QCOMPARE(grid.fill(QPoint(3, 3)).toRegion(), grid.region(QLatin1Char('c')));
+
+    // The walls are connected through the corner
+    QCOMPARE(grid.fill(QPoint(2, 2)).toRegion(), QRegion(2, 0, 1, 3) +
+                                                 QRegion(0, 2, 2, 1));
+}
+
+void test_FloodFill::diagonals()
+{
+    const Grid grid({
+        QLatin1String("x.x"),
+        QLatin1String(".x."),
+        QLatin1String("x.x"),
+    });
+
+    // Only horizontally and vertically adjacent positions are connected
+    QCOMPARE(grid.fill(QPoint(1, 1)).toRegion(), QRegion(1, 1, 1, 1));
+    QCOMPARE(grid.fill(QPoint(0, 0)).toRegion(), QRegion(0, 0, 1, 1));
+    QCOMPARE(grid.fill(QPoint(1, 0)).toRegion(), QRegion(1, 0, 1, 1));
+}
+
+void test_FloodFill::spiral()
+{
+    // Filling has to go up and down again several times
+    const Grid grid({
+        QLatin1String("........."),
+        QLatin1String(".#######."),
+        QLatin1String(".#.....#."),
+        QLatin1String(".#.###.#."),
+        QLatin1String(".#.#.#.#."),
+        QLatin1String(".#.#...#."),
+        QLatin1String(".#.#####."),
+        QLatin1String(".#......."),
+        QLatin1String(".########"),
+    });
+
+    const QRegion open = grid.region(QLatin1Char('.'));
+    QCOMPARE(grid.fill(QPoint(4, 4)).toRegion(), open);
+    QCOMPARE(grid.fill(QPoint(0, 8)).toRegion(), open);
+}
+
+void test_FloodFill::comb()
+{
+    // Several separate runs above and below the same span
+    const Grid grid({
+        QLatin1String("a#a#a#a"),
+        QLatin1String("a#a#a#a"),
+        QLatin1String("aaaaaaa"),
+        QLatin1String("#a#a#a#"),
+    });
+
+    QCOMPARE(grid.fill(QPoint(0, 0)).toRegion(), grid.region(QLatin1Char('a')));
+    QCOMPARE(grid.fill(QPoint(1, 0)).toRegion(), QRegion(1, 0, 1, 2));
+}
+
+void test_FloodFill::negativeCoordinates()
+{
+    // Bounds crossing the origin and the borders of the mask blocks
+    const QStringList rows {
+        QLatin1String("....#..............."),
+        QLatin1String("....#..............."),
+        QLatin1String("....#####..........."),
+        QLatin1String("...................."),
+    };
+    const Grid grid(rows, QPoint(-17, -2));
+
+    QCOMPARE(grid.fill(QPoint(-17, -2)).toRegion(),
+             grid.region(QLatin1Char('.')));
+    QCOMPARE(grid.fill(QPoint(-16, 1)).toRegion(),
+             grid.region(QLatin1Char('.')));
+    QCOMPARE(grid.fill(QPoint(-13, -1)).toRegion(),
+             grid.region(QLatin1Char('#')));
+}
+
+void test_FloodFill::canceled()
+{
+    QAtomicInt canceled(1);
+    const TileMask mask = floodFill(QRect(0, 0, 10, 10), QPoint(0, 0),
+                                    [] (int, int) { return true; },
+                                    &canceled);
+    QVERIFY(mask.isEmpty());
+}
+
+void test_FloodFill::tileLayer()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    tileset->addTile(QPixmap(32, 32));
+
+    // A layer at an offset, with a wall crossing a chunk border
+    TileLayer layer(QString(), 3, 2, 40, 20);
+    const Cell wall(tileset->tileAt(0));
+    for (int y = 0; y < 19; ++y)
+        layer.setCell(16, y, wall);
+
+    // A flipped tile doesn't match the unflipped one
+    Cell flipped = wall;
+    flipped.flippedHorizontally = true;
+    layer.setCell(16, 5, flipped);
+
+    const int layerX = layer.x();
+    const int layerY = layer.y();
+    const QRect bounds(layer.position(), layer.size());
+
+    auto fillFrom = [&] (const QPoint &origin) {
+        const Cell matchCell = layer.cellAt(origin - layer.position());
+        return floodFill(bounds, origin, [&] (int x, int y) {
+            return layer.cellAt(x - layerX, y - layerY) == matchCell;
+        });
+    };
+
+    // The empty area is connected below the wall
+    QCOMPARE(fillFrom(QPoint(3, 2)).toRegion(),
+             QRegion(bounds) - QRegion(19, 2, 1, 19));
+    QCOMPARE(fillFrom(QPoint(19, 2)).toRegion(), QRegion(19, 2, 1, 5));
+    QCOMPARE(fillFrom(QPoint(19, 20)).toRegion(), QRegion(19, 8, 1, 13));
+    QCOMPARE(fillFrom(QPoint(19, 7)).toRegion(), QRegion(19, 7, 1, 1));
+}
+
+QTEST_MAIN(test_FloodFill)
+#include "test_floodfill.moc"
@@ -0,0 +1,410 @@
+#include "gidmapper.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtEndian>
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+static const unsigned FlippedHorizontallyFlag   = 0x80000000;
+static const unsigned FlippedVerticallyFlag     = 0x40000000;
+static const unsigned FlippedAntiDiagonallyFlag = 0x20000000;
+
+class test_GidMapper : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void emptyMapper();
+    void gidToCell();
+    void cellToGid();
+    void lazyTable();
+    void largeGids();
+    void tilesetWidth();
+    void layerData_data();
+    void layerData();
+    void layerDataWhitespace();
+    void corruptLayerData_data();
+    void corruptLayerData();
+    void invalidTile();
+
+private:
+    SharedTileset createTileset(int tileCount) const;
+    void fillLayer(TileLayer &layer) const;
+
+    SharedTileset mFirst;
+    SharedTileset mSecond;
+};
+
+SharedTileset test_GidMapper::createTileset(int tileCount) const
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    for (int i = 0; i < tileCount; ++i)
+        tileset->addTile(QPixmap(32, 32));
+    return tileset;
+}
+
+/**
+ * Fills the \a layer with cells from both tilesets, with all combinations
+ * of flags and some empty cells.
+ */
+void test_GidMapper::fillLayer(TileLayer &layer) const
+{
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            const int n = x * 3 + y * 11;
+            if (n % 7 == 0)
+                continue;
+
+            const SharedTileset &tileset = (n & 1) ? mFirst : mSecond;
+            Cell cell(tileset->tileAt(n % tileset->tileCount()));
+            cell.flippedHorizontally = (n & 2) != 0;
+            cell.flippedVertically = (n & 4) != 0;
+            cell.flippedAntiDiagonally = (n & 8) != 0;
+            layer.setCell(x, y, cell);
+        }
+    }
+}
+
+static bool sameCells(const TileLayer &a, const TileLayer &b)
+{
+    for (int y = 0; y < a.height(); ++y)
+        for (int x = 0; x < a.width(); ++x)
+            if (!(a.cellAt(x, y) == b.cellAt(x, y)))
+                return false;
+
+    return true;
+}
+
+void test_GidMapper::initTestCase()
+{
+    mFirst = createTileset(10);
+    mSecond = createTileset(5);
+}
+
+void test_GidMapper::emptyMapper()
+{
+    GidMapper gidMapper;
+    QVERIFY(gidMapper.isEmpty());
+
+    bool ok;
+    QVERIFY(gidMapper.gidToCell(0, ok).isEmpty());
+    QVERIFY(ok);
+
+    gidMapper.gidToCell(1, ok);
+    QVERIFY(!ok);
+
+    QCOMPARE(gidMapper.cellToGid(Cell(mFirst->tileAt(0))), 0u);
+}
+
+void test_GidMapper::gidToCell()
+{
+    GidMapper gidMapper;
+    gidMapper.insert(5, mFirst.data());
+    gidMapper.insert(15, mSecond.data());
+
+    bool ok;
+
+    // Before the first tileset
+    gidMapper.gidToCell(3, ok);
+    QVERIFY(!ok);
+
+    Cell cell = gidMapper.gidToCell(5, ok);
+    QVERIFY(ok);
+    QCOMPARE(cell.tile, mFirst->tileAt(0));
+
+    cell = gidMapper.gidToCell(14, ok);
+    QCOMPARE(cell.tile, mFirst->tileAt(9));
+
+    cell = gidMapper.gidToCell(15 | FlippedHorizontallyFlag | FlippedAntiDiagonallyFlag, ok);
+    QVERIFY(ok);
+    QCOMPARE(cell.tile, mSecond->tileAt(0));
+    QVERIFY(cell.flippedHorizontally);
+    QVERIFY(!cell.flippedVertically);
+    QVERIFY(cell.flippedAntiDiagonally);
+
+    // Past the end of the last tileset
+    cell = gidMapper.gidToCell(20, ok);
+    QVERIFY(ok);
+    QVERIFY(cell.isEmpty());
+
+    // The flags alone make an empty cell
+    cell = gidMapper.gidToCell(FlippedVerticallyFlag, ok);
+    QVERIFY(ok);
+    QVERIFY(!cell.tile);
+}
+
+void test_GidMapper::cellToGid()
+{
+    const QVector<SharedTileset> tilesets { mFirst, mSecond };
+    const GidMapper gidMapper(tilesets);
+
+    Cell cell(mSecond->tileAt(3));
+    cell.flippedVertically = true;
+    QCOMPARE(gidMapper.cellToGid(cell), (11u + 3u) | FlippedVerticallyFlag);
+
+    // Round trip for every tile with every combination of flags
+    for (unsigned gid = 1; gid <= 15; ++gid) {
+        for (unsigned flags = 0; flags < 8; ++flags) {
+            const unsigned flagged = gid | (flags << 29);
+
+            bool ok;
+            const Cell c = gidMapper.gidToCell(flagged, ok);
+            QVERIFY(ok);
+            QCOMPARE(gidMapper.cellToGid(c), flagged);
+        }
+    }
+
+    QCOMPARE(gidMapper.cellToGid(Cell()), 0u);
+
+    // Unknown tilesets map to 0
+    const SharedTileset unknown = createTileset(1);
+    QCOMPARE(gidMapper.cellToGid(Cell(unknown->tileAt(0))), 0u);
+
+    // A tileset inserted twice uses its lowest first gid
+    GidMapper twice;
+    twice.insert(50, mFirst.data());
+    twice.insert(20, mFirst.data());
+    QCOMPARE(twice.cellToGid(Cell(mFirst->tileAt(1))), 21u);
+}
+
+void test_GidMapper::lazyTable()
+{
+    GidMapper gidMapper;
+
+    // Inserted out of order, and looked up in between inserts
+    gidMapper.insert(30, mSecond.data());
+
+    bool ok;
+    QCOMPARE(gidMapper.gidToCell(31, ok).tile, mSecond->tileAt(1));
+
+    gidMapper.insert(1, mFirst.data());
+    QCOMPARE(gidMapper.gidToCell(3, ok).tile, mFirst->tileAt(2));
+    QVERIFY(ok);
+
+    // Gids between the tilesets belong to the first one, past its end
+    QVERIFY(gidMapper.gidToCell(20, ok).isEmpty());
+    QVERIFY(ok);
+
+    // Replacing the tileset at a first gid
+    gidMapper.insert(1, mSecond.data());
+    QCOMPARE(gidMapper.gidToCell(3, ok).tile, mSecond->tileAt(2));
+
+    // Copies made before the table was built share a table that works
+    GidMapper fresh;
+    fresh.insert(1, mFirst.data());
+    fresh.insert(11, mSecond.data());
+    const GidMapper copy = fresh;
+    QCOMPARE(copy.gidToCell(12, ok).tile, mSecond->tileAt(1));
+    QCOMPARE(fresh.gidToCell(2, ok).tile, mFirst->tileAt(1));
+
+    // Cleared mappers can be reused
+    fresh.clear();
+    QVERIFY(fresh.isEmpty());
+    fresh.gidToCell(2, ok);
+    QVERIFY(!ok);
+    fresh.insert(100, mSecond.data());
+    QCOMPARE(fresh.gidToCell(104, ok).tile, mSecond->tileAt(4));
+}
+
+void test_GidMapper::largeGids()
+{
+    // Gids beyond the size of the lookup table are found with a search
+    GidMapper gidMapper;
+    gidMapper.insert(1, mFirst.data());
+    gidMapper.insert(3000000, mSecond.data());
+
+    bool ok;
+    QCOMPARE(gidMapper.gidToCell(3000002, ok).tile, mSecond->tileAt(2));
+    QVERIFY(ok);
+    QCOMPARE(gidMapper.gidToCell(10, ok).tile, mFirst->tileAt(9));
+    QVERIFY(gidMapper.gidToCell(2000000, ok).isEmpty());
+    QVERIFY(ok);
+    QCOMPARE(gidMapper.cellToGid(Cell(mSecond->tileAt(4))), 3000004u);
+}
+
+void test_GidMapper::tilesetWidth()
+{
+    // A tileset image with 2 columns, which had 3 columns when saved
+    QImage image(64, 96, QImage::Format_ARGB32);
+    image.fill(Qt::white);
+    SharedTileset tileset = Tileset::create(QLatin1String("image"), 32, 32);
+    QVERIFY(tileset->loadFromImage(image, QLatin1String("image.png")));
+    QCOMPARE(tileset->columnCount(), 2);
+
+    bool ok;
+
+    GidMapper gidMapper;
+    gidMapper.insert(1, tileset.data());
+    gidMapper.setTilesetWidth(tileset.data(), 96);
+
+    // Tile 4 was on the second row, in the second column
+    QCOMPARE(gidMapper.gidToCell(1 + 4, ok).tile, tileset->tileAt(3));
+    QCOMPARE(gidMapper.gidToCell(1 + 3, ok).tile, tileset->tileAt(2));
+    QCOMPARE(gidMapper.gidToCell(1 + 1, ok).tile, tileset->tileAt(1));
+
+    // The width can also be set before the tileset is inserted
+    GidMapper early;
+    early.setTilesetWidth(tileset.data(), 96);
+    early.insert(1, tileset.data());
+    QCOMPARE(early.gidToCell(1 + 4, ok).tile, tileset->tileAt(3));
+
+    // An unchanged width leaves the tile ids alone
+    GidMapper same;
+    same.insert(1, tileset.data());
+    same.setTilesetWidth(tileset.data(), 64);
+    QCOMPARE(same.gidToCell(1 + 4, ok).tile, tileset->tileAt(4));
+}
+
+void test_GidMapper::layerData_data()
+{
+    QTest::addColumn<Map::LayerDataFormat>("format");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("filled");
+
+    const QList<QPair<const char*, Map::LayerDataFormat>> formats {
+        { "base64", Map::Base64 },
+        { "zlib", Map::Base64Zlib },
+        { "gzip", Map::Base64Gzip },
+        { "zstd", Map::Base64Zstandard },
+        { "lz4", Map::Base64Lz4 },
+    };
+
+    for (const auto &format : formats) {
+        if (format.second == Map::Base64Zstandard && !compressionSupported(Zstandard))
+            continue;
+        if (format.second == Map::Base64Lz4 && !compressionSupported(Lz4))
+            continue;
+
+        const QByteArray name(format.first);
+
+        // Small layers fit in one block, large ones span several blocks
+        QTest::newRow((name + " small").constData()) << format.second << QSize(3, 2) << true;
+        QTest::newRow((name + " single row").constData()) << format.second << QSize(1000, 1) << true;
+        QTest::newRow((name + " large").constData()) << format.second << QSize(150, 97) << true;
+        QTest::newRow((name + " empty").constData()) << format.second << QSize(40, 20) << false;
+    }
+}
+
+void test_GidMapper::layerData()
+{
+    QFETCH(Map::LayerDataFormat, format);
+    QFETCH(QSize, size);
+    QFETCH(bool, filled);
+
+    const GidMapper gidMapper(QVector<SharedTileset> { mFirst, mSecond });
+
+    TileLayer layer(QString(), 0, 0, size.width(), size.height());
+    if (filled)
+        fillLayer(layer);
+
+    bool ok = false;
+    const QByteArray data = gidMapper.encodeLayerData(layer, format, &ok);
+    QVERIFY(ok);
+    QVERIFY(!data.isEmpty());
+
+    const int cellCount = size.width() * size.height();
+    QVERIFY(GidMapper::isLayerDataComplete(data, format, cellCount));
+    QVERIFY(!GidMapper::isLayerDataComplete(data, format, cellCount + 1));
+
+    TileLayer decoded(QString(), 0, 0, size.width(), size.height());
+    QCOMPARE(gidMapper.decodeLayerData(decoded, data, format), GidMapper::NoError);
+    QVERIFY(sameCells(layer, decoded));
+    QCOMPARE(decoded.isEmpty(), !filled);
+
+    // The streaming encoder produces the same data
+    QByteArray streamed;
+    QVERIFY(gidMapper.encodeLayerData(layer, format, [&] (const char *bytes, int length) {
+        streamed.append(bytes, length);
+    }));
+    QCOMPARE(streamed, data);
+}
+
+void test_GidMapper::layerDataWhitespace()
+{
+    const GidMapper gidMapper(QVector<SharedTileset> { mFirst, mSecond });
+
+    TileLayer layer(QString(), 0, 0, 120, 80);
+    fillLayer(layer);
+
+    const QByteArray data = gidMapper.encodeLayerData(layer, Map::Base64Zlib);
+
+    // Whitespace, like the indentation written to TMX files, is skipped
+    QByteArray wrapped("\n   ");
+    for (int i = 0; i < data.size(); i += 37)
+        wrapped += data.mid(i, 37) + "\n   ";
+
+    TileLayer decoded(QString(), 0, 0, 120, 80);
+    QCOMPARE(gidMapper.decodeLayerData(decoded, wrapped, Map::Base64Zlib),
+             GidMapper::NoError);
+    QVERIFY(sameCells(layer, decoded));
+}
+
+void test_GidMapper::corruptLayerData_data()
+{
+    QTest::addColumn<Map::LayerDataFormat>("format");
+    QTest::addColumn<int>("cellCount");
+
+    // Data encoded for 6 cells, decoded for other sizes
+    QTest::newRow("base64 too short") << Map::Base64 << 7;
+    QTest::newRow("base64 too long") << Map::Base64 << 5;
+    QTest::newRow("zlib too short") << Map::Base64Zlib << 7;
+    QTest::newRow("zlib too long") << Map::Base64Zlib << 5;
+    QTest::newRow("gzip too long") << Map::Base64Gzip << 1;
+}
+
+void test_GidMapper::corruptLayerData()
+{
+    QFETCH(Map::LayerDataFormat, format);
+    QFETCH(int, cellCount);
+
+    const GidMapper gidMapper(QVector<SharedTileset> { mFirst, mSecond });
+
+    TileLayer layer(QString(), 0, 0, 3, 2);
+    fillLayer(layer);
+    const QByteArray data = gidMapper.encodeLayerData(layer, format);
+
+    TileLayer decoded(QString(), 0, 0, cellCount, 1);
+    QCOMPARE(gidMapper.decodeLayerData(decoded, data, format),
+             GidMapper::CorruptLayerData);
+    QVERIFY(!GidMapper::isLayerDataComplete(data, format, cellCount));
+
+    // Data that doesn't decompress
+    if (format != Map::Base64) {
+        const QByteArray garbage = QByteArray("not compressed at all").toBase64();
+        QCOMPARE(gidMapper.decodeLayerData(decoded, garbage, format),
+                 GidMapper::CorruptLayerData);
+        QVERIFY(!GidMapper::isLayerDataComplete(garbage, format, cellCount));
+    }
+}
+
+void test_GidMapper::invalidTile()
+{
+    GidMapper gidMapper;
+    gidMapper.insert(10, mFirst.data());
+
+    QByteArray gids(8, '\0');
+    qToLittleEndian<quint32>(10, reinterpret_cast<uchar*>(gids.data()));
+    qToLittleEndian<quint32>(3, reinterpret_cast<uchar*>(gids.data() + 4));
+    const QByteArray data = gids.toBase64();
+
+    // The size is right, so the data looks complete
+    QVERIFY(GidMapper::isLayerDataComplete(data, Map::Base64, 2));
+
+    TileLayer layer(QString(), 0, 0, 2, 1);
+    QCOMPARE(gidMapper.decodeLayerData(layer, data, Map::Base64),
+             GidMapper::InvalidTile);
+    QCOMPARE(gidMapper.invalidTile(), 3u);
+    QCOMPARE(layer.cellAt(0, 0).tile, mFirst->tileAt(0));
+
+    TileLayer noTilesets(QString(), 0, 0, 2, 1);
+    QCOMPARE(GidMapper().decodeLayerData(noTilesets, data, Map::Base64),
+             GidMapper::TileButNoTilesets);
+}
+
+QTEST_MAIN(test_GidMapper)
+#include "test_gidmapper.moc"
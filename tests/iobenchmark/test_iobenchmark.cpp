@@ -0,0 +1,363 @@
+#include "compression.h"
+#include "gidmapper.h"
+#include "map.h"
+#include "mapformat.h"
+#include "mapobject.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "objectgroup.h"
+#include "plugin.h"
+#include "pluginmanager.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QPluginLoader>
+#include <QTemporaryDir>
+
+#include <memory>
+
+using namespace Tiled;
+
+/**
+ * Benchmarks reading and writing maps in the TMX and JSON formats, as well
+ * as encoding and decoding of layer data, on generated maps of different
+ * sizes, layer counts and layer data formats.
+ *
+ * The usual QtTest options can be used for machine-readable output, for
+ * example "-o results.csv,csv" or "-o results.xml,xml".
+ */
+class test_IoBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void readMap_data();
+    void readMap();
+
+    void writeMap_data();
+    void writeMap();
+
+    void encodeLayerData_data();
+    void encodeLayerData();
+
+    void decodeLayerData_data();
+    void decodeLayerData();
+
+    void jsonRoundTrip_data();
+    void jsonRoundTrip();
+
+private:
+    Map *createMap(int size, int layerCount,
+                   Map::LayerDataFormat format) const;
+
+    QTemporaryDir mDir;
+    QVector<SharedTileset> mTilesets;
+    MapFormat *mJsonFormat;
+};
+
+static const struct {
+    Map::LayerDataFormat format;
+    const char *name;
+} layerDataFormats[] = {
+    { Map::XML,             "xml" },
+    { Map::Base64,          "base64" },
+    { Map::Base64Gzip,      "base64-gzip" },
+    { Map::Base64Zlib,      "base64-zlib" },
+    { Map::CSV,             "csv" },
+    { Map::Base64Zstandard, "base64-zstd" },
+    { Map::Base64Lz4,       "base64-lz4" },
+};
+
+static const struct {
+    int size;
+    int layerCount;
+} mapShapes[] = {
+    { 64, 1 },
+    { 64, 20 },
+    { 64, 200 },
+    { 256, 1 },
+    { 256, 20 },
+    { 256, 200 },
+    { 1024, 1 },
+    { 4096, 1 },
+    { 8192, 1 },
+};
+
+static bool isSupported(Map::LayerDataFormat format)
+{
+    switch (format) {
+    case Map::Base64Zstandard:
+        return compressionSupported(Zstandard);
+    case Map::Base64Lz4:
+        return compressionSupported(Lz4);
+    default:
+        return true;
+    }
+}
+
+static bool isTextFormat(Map::LayerDataFormat format)
+{
+    return format == Map::XML || format == Map::CSV;
+}
+
+/**
+ * Adds a row for each supported layer data format and map shape. The text
+ * formats are left out for the largest maps, which would take gigabytes,
+ * and entirely when \a textFormats is false.
+ */
+static void addMapRows(bool textFormats)
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("layerCount");
+    QTest::addColumn<int>("format");
+
+    for (const auto &format : layerDataFormats) {
+        if (!isSupported(format.format))
+            continue;
+        if (isTextFormat(format.format) && !textFormats)
+            continue;
+
+        for (const auto &shape : mapShapes) {
+            if (isTextFormat(format.format) && shape.size > 1024)
+                continue;
+
+            const QString name = QString(QLatin1String("%1x%1/%2/%3"))
+                    .arg(shape.size)
+                    .arg(shape.layerCount)
+                    .arg(QLatin1String(format.name));
+
+            QTest::newRow(qPrintable(name))
+                    << shape.size << shape.layerCount << int(format.format);
+        }
+    }
+}
+
+void test_IoBenchmark::initTestCase()
+{
+    mJsonFormat = nullptr;
+
+    QVERIFY(mDir.isValid());
+
+    // A tileset image of 8x8 tiles, shared by all tilesets
+    QImage image(256, 256, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgb(x, y, (x / 32) * 32));
+
+    const QString imagePath = mDir.path() + QLatin1String("/tiles.png");
+    QVERIFY(image.save(imagePath));
+
+    for (int i = 0; i < 16; ++i) {
+        SharedTileset tileset = Tileset::create(QString(QLatin1String("tiles%1")).arg(i), 32, 32);
+        QVERIFY(tileset->loadFromImage(image, imagePath));
+        mTilesets.append(tileset);
+    }
+
+    // Load only the JSON plugin, which registers the JSON map format
+    PluginManager::instance();
+
+    const QDir pluginDir(QLatin1String(TILED_PLUGINS_PATH));
+    foreach (const QString &fileName, pluginDir.entryList(QDir::Files)) {
+        const QString filePath = pluginDir.filePath(fileName);
+        if (!fileName.contains(QLatin1String("json")) || !QLibrary::isLibrary(filePath))
+            continue;
+
+        QPluginLoader loader(filePath);
+        if (Plugin *plugin = qobject_cast<Plugin*>(loader.instance()))
+            plugin->initialize();
+    }
+
+    foreach (MapFormat *format, PluginManager::objects<MapFormat>()) {
+        if (format->supportsFile(QLatin1String("map.json"))) {
+            mJsonFormat = format;
+            break;
+        }
+    }
+}
+
+void test_IoBenchmark::readMap_data()
+{
+    addMapRows(true);
+}
+
+void test_IoBenchmark::readMap()
+{
+    QFETCH(int, size);
+    QFETCH(int, layerCount);
+    QFETCH(int, format);
+
+    QByteArray data;
+    {
+        std::unique_ptr<Map> map(createMap(size, layerCount, Map::LayerDataFormat(format)));
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        MapWriter().writeMap(map.get(), &buffer, mDir.path());
+    }
+
+    QBENCHMARK {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        MapReader reader;
+        std::unique_ptr<Map> map(reader.readMap(&buffer, mDir.path()));
+        QVERIFY(map);
+    }
+}
+
+void test_IoBenchmark::writeMap_data()
+{
+    addMapRows(true);
+}
+
+void test_IoBenchmark::writeMap()
+{
+    QFETCH(int, size);
+    QFETCH(int, layerCount);
+    QFETCH(int, format);
+
+    std::unique_ptr<Map> map(createMap(size, layerCount, Map::LayerDataFormat(format)));
+    MapWriter writer;
+
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        writer.writeMap(map.get(), &buffer, mDir.path());
+        QVERIFY(buffer.size() > 0);
+    }
+}
+
+void test_IoBenchmark::encodeLayerData_data()
+{
+    addMapRows(false);
+}
+
+void test_IoBenchmark::encodeLayerData()
+{
+    QFETCH(int, size);
+    QFETCH(int, layerCount);
+    QFETCH(int, format);
+
+    std::unique_ptr<Map> map(createMap(size, layerCount, Map::LayerDataFormat(format)));
+    const GidMapper gidMapper(map->tilesets());
+
+    QBENCHMARK {
+        for (const TileLayer *layer : map->tileLayers()) {
+            const QByteArray data = gidMapper.encodeLayerData(*layer,
+                                                              Map::LayerDataFormat(format));
+            QVERIFY(!data.isEmpty());
+        }
+    }
+}
+
+void test_IoBenchmark::decodeLayerData_data()
+{
+    addMapRows(false);
+}
+
+void test_IoBenchmark::decodeLayerData()
+{
+    QFETCH(int, size);
+    QFETCH(int, layerCount);
+    QFETCH(int, format);
+
+    std::unique_ptr<Map> map(createMap(size, layerCount, Map::LayerDataFormat(format)));
+    const GidMapper gidMapper(map->tilesets());
+
+    QVector<QByteArray> layerData;
+    for (const TileLayer *layer : map->tileLayers())
+        layerData.append(gidMapper.encodeLayerData(*layer,
+                                                   Map::LayerDataFormat(format)));
+
+    QBENCHMARK {
+        for (const QByteArray &data : layerData) {
+            TileLayer layer(QString(), 0, 0, size, size);
+            QCOMPARE(gidMapper.decodeLayerData(layer, data, Map::LayerDataFormat(format)),
+                     GidMapper::NoError);
+        }
+    }
+}
+
+void test_IoBenchmark::jsonRoundTrip_data()
+{
+    addMapRows(true);
+}
+
+void test_IoBenchmark::jsonRoundTrip()
+{
+    if (!mJsonFormat)
+        QSKIP("The JSON plugin has not been built");
+
+    QFETCH(int, size);
+    QFETCH(int, layerCount);
+    QFETCH(int, format);
+
+    std::unique_ptr<Map> map(createMap(size, layerCount, Map::LayerDataFormat(format)));
+    const QString fileName = mDir.path() + QLatin1String("/map.json");
+
+    QBENCHMARK {
+        QVERIFY(mJsonFormat->write(map.get(), fileName));
+        std::unique_ptr<Map> readMap(mJsonFormat->read(fileName));
+        QVERIFY(readMap);
+    }
+}
+
+/**
+ * Creates a map of the given size with the given number of tile layers and
+ * an object layer. The first tile layer is filled, while the others only
+ * have a tile in a quarter of their cells. The tiles are picked from all
+ * tilesets with a deterministic pattern.
+ */
+Map *test_IoBenchmark::createMap(int size, int layerCount,
+                                 Map::LayerDataFormat format) const
+{
+    Map *map = new Map(Map::Orthogonal, size, size, 32, 32);
+    map->setLayerDataFormat(format);
+    for (const SharedTileset &tileset : mTilesets)
+        map->addTileset(tileset);
+
+    quint32 random = 1;
+    auto next = [&random] () {
+        random = random * 1103515245 + 12345;
+        return random >> 16;
+    };
+
+    for (int i = 0; i < layerCount; ++i) {
+        TileLayer *layer = new TileLayer(QString(QLatin1String("layer%1")).arg(i),
+                                         0, 0, size, size);
+        {
+            TileLayer::BulkEdit bulkEdit(layer);
+
+            for (int y = 0; y < size; ++y) {
+                for (int x = 0; x < size; ++x) {
+                    const quint32 value = next();
+                    if (i > 0 && (value & 3) != 0)
+                        continue;
+
+                    const Tileset *tileset = mTilesets.at((value >> 2) % mTilesets.size()).data();
+                    layer->setCell(x, y, Cell(tileset->tileAt((value >> 6) % tileset->tileCount())));
+                }
+            }
+        }
+        map->addLayer(layer);
+    }
+
+    ObjectGroup *objectGroup = new ObjectGroup(QLatin1String("objects"), 0, 0, size, size);
+    for (int i = 0; i < size * 4; ++i) {
+        const QPointF pos(next() % (size * 32), next() % (size * 32));
+        MapObject *object = new MapObject(QString(QLatin1String("object%1")).arg(i),
+                                          QLatin1String("spawn"),
+                                          pos, QSizeF(32, 32));
+        object->setProperty(QLatin1String("group"), QString::number(i % 8));
+        objectGroup->addObject(object);
+    }
+    map->addLayer(objectGroup);
+
+    return map;
+}
+
+QTEST_MAIN(test_IoBenchmark)
+#include "test_iobenchmark.moc"
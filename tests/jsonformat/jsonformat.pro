@@ -0,0 +1,29 @@
+include(../../src/libtiled/libtiled.pri)
+
+QT += testlib
+CONFIG += c++11
+TEMPLATE = app
+
+macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/Frameworks
+} else {
+    LIBS += -L$$OUT_PWD/../../lib
+}
+
+!win32:!macx {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../../lib
+
+    # It is not possible to use ORIGIN in QMAKE_RPATHDIR, so a bit manually
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$$join(QMAKE_RPATHDIR, ":")\'
+    QMAKE_RPATHDIR =
+}
+
+# The map reader and writer of the JSON plugin are compiled in, so that they
+# can be compared to JsonReader, JsonWriter and the variant converters
+INCLUDEPATH += ../../src/plugins/json
+
+# Input
+SOURCES += test_jsonformat.cpp \
+    ../../src/plugins/json/jsonmapreader.cpp \
+    ../../src/plugins/json/jsonmapwriter.cpp \
+    ../../src/plugins/json/qjsonparser/json.cpp
@@ -0,0 +1,188 @@
+#include "jsonmapreader.h"
+#include "jsonmapwriter.h"
+#include "map.h"
+#include "mapreader.h"
+#include "maptovariantconverter.h"
+#include "varianttomapconverter.h"
+
+#include "qjsonparser/json.h"
+
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QFileInfo>
+
+using namespace Tiled;
+using namespace Json;
+
+/**
+ * Tests the JSON map format by comparing the output of JsonMapWriter with
+ * that of MapToVariantConverter and JsonWriter, which were used to write
+ * JSON maps before, for the stored example maps. Likewise, the maps read by
+ * JsonMapReader are compared with the ones read through JsonReader.
+ */
+class test_JsonFormat : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeMap_data();
+    void writeMap();
+
+    void readMap_data();
+    void readMap();
+
+private:
+    void addMapRows();
+};
+
+static Map *readStoredMap(const QString &fileName)
+{
+    MapReader reader;
+    return reader.readMap(fileName);
+}
+
+static QDir mapDir(const QString &fileName)
+{
+    return QDir(QFileInfo(fileName).absolutePath());
+}
+
+/**
+ * Writes the map the way the JSON plugin used to, by converting it to a
+ * QVariant and writing it with an auto-formatting JsonWriter.
+ */
+static QByteArray writeWithVariant(const Map *map, const QDir &dir)
+{
+    MapToVariantConverter converter;
+    JsonWriter writer;
+    writer.setAutoFormatting(true);
+
+    if (!writer.stringify(converter.toVariant(map, dir)))
+        return QByteArray();
+
+    return writer.result().toUtf8();
+}
+
+static QByteArray writeWithMapWriter(const Map *map, const QDir &dir)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    JsonMapWriter writer(&buffer);
+    writer.writeMap(map, dir);
+    writer.flush();
+
+    if (!writer.errorString().isEmpty())
+        return QByteArray();
+
+    return buffer.data();
+}
+
+/**
+ * Reads the map the way the JSON plugin used to, by parsing it with
+ * JsonReader and converting the resulting QVariant.
+ */
+static Map *readWithJsonReader(const QByteArray &contents, const QDir &dir)
+{
+    JsonReader reader;
+    if (!reader.parse(contents))
+        return nullptr;
+
+    VariantToMapConverter converter;
+    return converter.toMap(reader.result(), dir);
+}
+
+static Map *readWithMapReader(const QByteArray &contents, const QDir &dir)
+{
+    JsonMapReader reader;
+    if (!reader.parse(contents.constData(),
+                      contents.constData() + contents.size()))
+        return nullptr;
+
+    VariantToMapConverter converter;
+    return converter.toMap(reader.result(), dir);
+}
+
+void test_JsonFormat::addMapRows()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<Map::LayerDataFormat>("format");
+
+    const char *fileNames[] = {
+        "../../examples/desert.tmx",
+        "../../examples/hexagonal-mini.tmx",
+        "../../examples/isometric_grass_and_water.tmx",
+        "../../examples/perspective_walls.tmx",
+        "../../examples/sewers.tmx",
+        "../data/mapobject.tmx",
+    };
+
+    const struct {
+        const char *name;
+        Map::LayerDataFormat format;
+    } formats[] = {
+        { "csv", Map::CSV },
+        { "base64", Map::Base64 },
+        { "zlib", Map::Base64Zlib },
+    };
+
+    for (const char *fileName : fileNames) {
+        for (const auto &format : formats) {
+            const QString name = QFileInfo(QLatin1String(fileName)).baseName();
+            QTest::newRow(qPrintable(name + QLatin1Char('-') + QLatin1String(format.name)))
+                    << QString::fromLatin1(fileName) << format.format;
+        }
+    }
+}
+
+void test_JsonFormat::writeMap_data()
+{
+    addMapRows();
+}
+
+void test_JsonFormat::writeMap()
+{
+    QFETCH(QString, fileName);
+    QFETCH(Map::LayerDataFormat, format);
+
+    QScopedPointer<Map> map(readStoredMap(fileName));
+    QVERIFY(map);
+    map->setLayerDataFormat(format);
+
+    const QDir dir = mapDir(fileName);
+    const QByteArray expected = writeWithVariant(map.data(), dir);
+    QVERIFY(!expected.isEmpty());
+
+    QCOMPARE(writeWithMapWriter(map.data(), dir), expected);
+}
+
+void test_JsonFormat::readMap_data()
+{
+    addMapRows();
+}
+
+void test_JsonFormat::readMap()
+{
+    QFETCH(QString, fileName);
+    QFETCH(Map::LayerDataFormat, format);
+
+    QScopedPointer<Map> map(readStoredMap(fileName));
+    QVERIFY(map);
+    map->setLayerDataFormat(format);
+
+    const QDir dir = mapDir(fileName);
+    const QByteArray contents = writeWithVariant(map.data(), dir);
+    QVERIFY(!contents.isEmpty());
+
+    QScopedPointer<Map> expected(readWithJsonReader(contents, dir));
+    QVERIFY(expected);
+
+    QScopedPointer<Map> actual(readWithMapReader(contents, dir));
+    QVERIFY(actual);
+
+    QCOMPARE(actual->layerDataFormat(), expected->layerDataFormat());
+    QCOMPARE(writeWithVariant(actual.data(), dir),
+             writeWithVariant(expected.data(), dir));
+}
+
+QTEST_MAIN(test_JsonFormat)
+#include "test_jsonformat.moc"
@@ -0,0 +1,30 @@
+include(../../src/libtiled/libtiled.pri)
+
+QT += testlib
+CONFIG += c++11
+TEMPLATE = app
+
+macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/Frameworks
+    TILED_PLUGINS_PATH = $$OUT_PWD/../../bin/Tiled.app/Contents/PlugIns
+} else:win32 {
+    LIBS += -L$$OUT_PWD/../../lib
+    TILED_PLUGINS_PATH = $$OUT_PWD/../../plugins/tiled
+} else {
+    LIBS += -L$$OUT_PWD/../../lib
+    TILED_PLUGINS_PATH = $$OUT_PWD/../../lib/tiled/plugins
+}
+
+# The Lua format is a plugin, which is loaded from the build directory
+DEFINES += TILED_PLUGINS_PATH=\\\"$$TILED_PLUGINS_PATH\\\"
+
+!win32:!macx {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../../lib
+
+    # It is not possible to use ORIGIN in QMAKE_RPATHDIR, so a bit manually
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$$join(QMAKE_RPATHDIR, ":")\'
+    QMAKE_RPATHDIR =
+}
+
+# Input
+SOURCES += test_luaformat.cpp
@@ -0,0 +1,95 @@
+#include "map.h"
+#include "mapformat.h"
+#include "mapreader.h"
+#include "pluginmanager.h"
+
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QPluginLoader>
+
+using namespace Tiled;
+
+/**
+ * Tests the Lua export against stored output, which was written by the Lua
+ * plugin before LuaTableWriter buffered its output and wrote the tile data
+ * a row at a time.
+ */
+class test_LuaFormat : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void writeStoredMap_data();
+    void writeStoredMap();
+
+private:
+    MapFormat *mFormat;
+};
+
+void test_LuaFormat::initTestCase()
+{
+    mFormat = nullptr;
+
+    // The version is part of the output
+    QCoreApplication::setApplicationVersion(QLatin1String("1.0.0"));
+
+    PluginManager::instance();
+
+    const QDir pluginDir(QLatin1String(TILED_PLUGINS_PATH));
+    foreach (const QString &fileName, pluginDir.entryList(QDir::Files)) {
+        const QString filePath = pluginDir.filePath(fileName);
+        if (!fileName.contains(QLatin1String("lua")) || !QLibrary::isLibrary(filePath))
+            continue;
+
+        QPluginLoader loader(filePath);
+        if (MapFormat *format = qobject_cast<MapFormat*>(loader.instance())) {
+            mFormat = format;
+            break;
+        }
+    }
+
+    QVERIFY2(mFormat, "The Lua plugin has not been built");
+}
+
+void test_LuaFormat::writeStoredMap_data()
+{
+    QTest::addColumn<Map::LayerDataFormat>("format");
+    QTest::addColumn<QString>("expectedFileName");
+
+    QTest::newRow("lua") << Map::CSV
+                         << QString::fromLatin1("../data/luaexport.lua");
+    QTest::newRow("base64") << Map::Base64
+                            << QString::fromLatin1("../data/luaexport-base64.lua");
+}
+
+void test_LuaFormat::writeStoredMap()
+{
+    QFETCH(Map::LayerDataFormat, format);
+    QFETCH(QString, expectedFileName);
+
+    QFile file(expectedFileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray expected = file.readAll();
+
+    const QFileInfo mapFile(QLatin1String("../data/luaexport.tmx"));
+
+    MapReader reader;
+    QScopedPointer<Map> map(reader.readMap(mapFile.absoluteFilePath()));
+    QVERIFY2(map, qPrintable(reader.errorString()));
+    map->setLayerDataFormat(format);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    QVERIFY2(mFormat->writeToDevice(map.data(), &buffer,
+                                    mapFile.absolutePath(),
+                                    MapWriteOptions()),
+             qPrintable(mFormat->errorString()));
+
+    QCOMPARE(buffer.data(), expected);
+}
+
+QTEST_MAIN(test_LuaFormat)
+#include "test_luaformat.moc"
@@ -0,0 +1,198 @@
+#include "map.h"
+#include "mapcache.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_MapCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void roundTrip();
+    void staleCache();
+    void changedTilesets();
+    void sizeLimit();
+
+private:
+    Map *createMap() const;
+    void writeMapFile(const QString &fileName, const QByteArray &contents) const;
+
+    QTemporaryDir mDir;
+    SharedTileset mTileset;
+};
+
+void test_MapCache::initTestCase()
+{
+    // Keeps the cache files out of the cache of the user
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY(mDir.isValid());
+
+    mTileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    for (int i = 0; i < 4; ++i)
+        mTileset->addTile(QPixmap(32, 32));
+}
+
+void test_MapCache::init()
+{
+    MapCache::setSizeLimit(512);
+}
+
+void test_MapCache::cleanup()
+{
+    QDir(QFileInfo(MapCache::cacheFileName(mDir.path())).absolutePath()).removeRecursively();
+}
+
+/**
+ * Returns a map with a single tile layer, which is large enough to be
+ * cached.
+ */
+Map *test_MapCache::createMap() const
+{
+    Map *map = new Map(Map::Orthogonal, 256, 256, 32, 32);
+    map->addTileset(mTileset);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("Ground"), 0, 0, 256, 256);
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < 256; ++x) {
+            if ((x + y) % 5 == 0)
+                continue;
+
+            Cell cell(mTileset->tileAt((x + y) % 4));
+            cell.flippedHorizontally = x % 3 == 0;
+            tileLayer->setCell(x, y, cell);
+        }
+    }
+    map->addLayer(tileLayer);
+
+    return map;
+}
+
+void test_MapCache::writeMapFile(const QString &fileName,
+                                 const QByteArray &contents) const
+{
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write(contents);
+}
+
+void test_MapCache::roundTrip()
+{
+    const QString fileName = mDir.filePath(QLatin1String("roundtrip.tmx"));
+    writeMapFile(fileName, "map");
+
+    QScopedPointer<Map> map(createMap());
+
+    MapCache cache(fileName);
+    QVERIFY(!cache.open());
+    QVERIFY(cache.write(map.data()));
+
+    MapCache written(fileName);
+    QVERIFY(written.open());
+    QVERIFY(written.matchesTilesets(map->tilesets()));
+    QVERIFY(!written.tileLayerData(0, 128, 256));
+    QVERIFY(!written.tileLayerData(1, 256, 256));
+
+    const uchar *data = written.tileLayerData(0, 256, 256);
+    QVERIFY(data);
+
+    const TileLayer *tileLayer = map->layerAt(0)->asTileLayer();
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < 256; ++x, data += 4) {
+            const Cell &cell = tileLayer->cellAt(x, y);
+            const unsigned gid = qFromLittleEndian<quint32>(data);
+
+            // The flags are stored in the most significant bits
+            QCOMPARE(gid & 0x0fffffff, cell.isEmpty() ? 0u : unsigned(cell.tile->id() + 1));
+            QCOMPARE(bool(gid & 0x80000000), cell.flippedHorizontally);
+        }
+    }
+}
+
+void test_MapCache::staleCache()
+{
+    const QString fileName = mDir.filePath(QLatin1String("stale.tmx"));
+    writeMapFile(fileName, "map");
+
+    QScopedPointer<Map> map(createMap());
+    QVERIFY(MapCache(fileName).write(map.data()));
+    QVERIFY(MapCache(fileName).open());
+
+    // Changing the map file invalidates the cache
+    writeMapFile(fileName, "changed map");
+    QVERIFY(!MapCache(fileName).open());
+
+    // A cache that isn't a cache is rejected rather than read
+    writeMapFile(MapCache::cacheFileName(fileName), "garbage");
+    QVERIFY(!MapCache(fileName).open());
+}
+
+void test_MapCache::changedTilesets()
+{
+    const QString fileName = mDir.filePath(QLatin1String("tilesets.tmx"));
+    writeMapFile(fileName, "map");
+
+    QScopedPointer<Map> map(createMap());
+    QVERIFY(MapCache(fileName).write(map.data()));
+
+    MapCache cache(fileName);
+    QVERIFY(cache.open());
+
+    // The gids refer to other tiles once a tileset changed
+    SharedTileset changed = Tileset::create(QLatin1String("tiles"), 32, 32);
+    for (int i = 0; i < 5; ++i)
+        changed->addTile(QPixmap(32, 32));
+
+    QVERIFY(!cache.matchesTilesets(QVector<SharedTileset>() << changed));
+    QVERIFY(!cache.matchesTilesets(QVector<SharedTileset>() << mTileset << mTileset));
+}
+
+void test_MapCache::sizeLimit()
+{
+    QScopedPointer<Map> map(createMap());
+
+    // Each cache takes a little over 256 KB
+    MapCache::setSizeLimit(1);
+
+    QStringList cacheFiles;
+    for (int i = 0; i < 6; ++i) {
+        const QString fileName = mDir.filePath(QString(QLatin1String("map%1.tmx")).arg(i));
+        writeMapFile(fileName, "map");
+        QVERIFY(MapCache(fileName).write(map.data()));
+        cacheFiles.append(MapCache::cacheFileName(fileName));
+    }
+
+    qint64 size = 0;
+    int remaining = 0;
+    for (const QString &cacheFile : cacheFiles) {
+        const QFileInfo fileInfo(cacheFile);
+        if (fileInfo.exists()) {
+            size += fileInfo.size();
+            ++remaining;
+        }
+    }
+
+    // The headers make the fourth cache go just over the limit
+    QVERIFY(size <= 1024 * 1024);
+    QCOMPARE(remaining, 3);
+
+    // Without any space, caches are removed right after writing them
+    MapCache::setSizeLimit(0);
+
+    const QString fileName = mDir.filePath(QLatin1String("nospace.tmx"));
+    writeMapFile(fileName, "map");
+    QVERIFY(MapCache(fileName).write(map.data()));
+    QVERIFY(!MapCache(fileName).open());
+}
+
+QTEST_MAIN(test_MapCache)
+#include "test_mapcache.moc"
@@ -0,0 +1,235 @@
+#include "map.h"
+#include "mapdiff.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_MapDiff : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void unchanged();
+    void changedCells();
+    void movedLayer();
+    void changedObjects();
+    void addedAndRemovedLayers();
+    void mergeCells();
+    void mergeConflictingCells();
+    void mergeObjects();
+
+private:
+    Map *createMap() const;
+
+    SharedTileset mTileset;
+};
+
+void test_MapDiff::initTestCase()
+{
+    mTileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    for (int i = 0; i < 4; ++i)
+        mTileset->addTile(QPixmap(32, 32));
+}
+
+/**
+ * Creates a map with a tile layer and an object layer. Each call returns
+ * an independent map with the same contents, like two versions of a file.
+ */
+Map *test_MapDiff::createMap() const
+{
+    Map *map = new Map(Map::Orthogonal, 100, 100, 32, 32);
+    map->addTileset(mTileset);
+
+    TileLayer *tileLayer = new TileLayer(QLatin1String("Ground"), 0, 0, 100, 100);
+    for (int y = 0; y < 100; ++y)
+        for (int x = 0; x < 100; ++x)
+            tileLayer->setCell(x, y, Cell(mTileset->tileAt((x + y) % 4)));
+    map->addLayer(tileLayer);
+
+    ObjectGroup *objectGroup = new ObjectGroup(QLatin1String("Objects"), 0, 0, 100, 100);
+    for (int i = 1; i <= 3; ++i) {
+        MapObject *object = new MapObject(QString::number(i), QString(),
+                                          QPointF(i * 10, i * 10), QSizeF(8, 8));
+        object->setId(i);
+        objectGroup->addObject(object);
+    }
+    map->addLayer(objectGroup);
+    map->setNextObjectId(4);
+
+    return map;
+}
+
+void test_MapDiff::unchanged()
+{
+    QScopedPointer<Map> before(createMap());
+    QScopedPointer<Map> after(createMap());
+
+    const MapDiff diff(before.data(), after.data());
+    QVERIFY(diff.isEmpty());
+    QCOMPARE(diff.layers().size(), 2);
+    QVERIFY(diff.toString().isEmpty());
+}
+
+void test_MapDiff::changedCells()
+{
+    QScopedPointer<Map> before(createMap());
+    QScopedPointer<Map> after(createMap());
+
+    TileLayer *layer = after->layerAt(0)->asTileLayer();
+    layer->setCell(5, 5, Cell());
+    layer->setCell(90, 70, Cell(mTileset->tileAt(3)));
+
+    const MapDiff diff(before.data(), after.data());
+    QVERIFY(!diff.isEmpty());
+
+    const MapDiff::LayerDiff &layerDiff = diff.layers().at(0);
+    QCOMPARE(layerDiff.change, MapDiff::Modified);
+    QVERIFY(!layerDiff.attributesChanged);
+    QVERIFY(layerDiff.cells.contains(5, 5));
+    QVERIFY(layerDiff.cells.contains(90, 70));
+    QCOMPARE(layerDiff.cells.boundingRect(), QRect(5, 5, 86, 66));
+    QCOMPARE(diff.layers().at(1).change, MapDiff::Unchanged);
+}
+
+void test_MapDiff::movedLayer()
+{
+    QScopedPointer<Map> before(createMap());
+    QScopedPointer<Map> after(createMap());
+
+    // Moving by a distance that is not a multiple of the chunk size requires
+    // comparing the cells one by one
+    TileLayer *layer = after->layerAt(0)->asTileLayer();
+    layer->setPosition(QPoint(1, 0));
+    layer->resize(QSize(99, 100), QPoint(-1, 0));
+
+    const MapDiff diff(before.data(), after.data());
+    const MapDiff::LayerDiff &layerDiff = diff.layers().at(0);
+
+    QCOMPARE(layerDiff.change, MapDiff::Modified);
+    QVERIFY(layerDiff.attributesChanged);
+    QVERIFY(layerDiff.cells.contains(0, 0));
+    QVERIFY(!layerDiff.cells.contains(1, 0));
+}
+
+void test_MapDiff::changedObjects()
+{
+    QScopedPointer<Map> before(createMap());
+    QScopedPointer<Map> after(createMap());
+
+    ObjectGroup *objectGroup = after->layerAt(1)->asObjectGroup();
+    objectGroup->objectAt(0)->setName(QLatin1String("Renamed"));
+    delete objectGroup->objects().at(1);
+    objectGroup->removeObjectAt(1);
+
+    MapObject *object = new MapObject;
+    object->setId(4);
+    objectGroup->addObject(object);
+
+    const MapDiff diff(before.data(), after.data());
+    const MapDiff::LayerDiff &layerDiff = diff.layers().at(1);
+
+    QCOMPARE(layerDiff.change, MapDiff::Modified);
+    QCOMPARE(layerDiff.changedObjects, QList<int>() << 1);
+    QCOMPARE(layerDiff.removedObjects, QList<int>() << 2);
+    QCOMPARE(layerDiff.addedObjects, QList<int>() << 4);
+}
+
+void test_MapDiff::addedAndRemovedLayers()
+{
+    QScopedPointer<Map> before(createMap());
+    QScopedPointer<Map> after(createMap());
+
+    delete after->takeLayerAt(0);
+    after->addLayer(new TileLayer(QLatin1String("Top"), 0, 0, 100, 100));
+
+    const MapDiff diff(before.data(), after.data());
+    QCOMPARE(diff.layers().size(), 3);
+    QCOMPARE(diff.layers().at(0).change, MapDiff::Removed);
+    QCOMPARE(diff.layers().at(0).name, QLatin1String("Ground"));
+    QCOMPARE(diff.layers().at(1).change, MapDiff::Unchanged);
+    QCOMPARE(diff.layers().at(2).change, MapDiff::Added);
+}
+
+void test_MapDiff::mergeCells()
+{
+    QScopedPointer<Map> base(createMap());
+    QScopedPointer<Map> ours(createMap());
+    QScopedPointer<Map> theirs(createMap());
+
+    ours->layerAt(0)->asTileLayer()->setCell(1, 1, Cell());
+    theirs->layerAt(0)->asTileLayer()->setCell(80, 80, Cell());
+    theirs->setProperty(QLatin1String("name"), QLatin1String("value"));
+
+    QStringList conflicts;
+    QScopedPointer<Map> result(MapDiff::merge(base.data(), ours.data(), theirs.data(),
+                                              &conflicts));
+    QVERIFY(result);
+    QVERIFY(conflicts.isEmpty());
+
+    const TileLayer *layer = result->layerAt(0)->asTileLayer();
+    QVERIFY(layer->cellAt(1, 1).isEmpty());
+    QVERIFY(layer->cellAt(80, 80).isEmpty());
+    QVERIFY(!layer->cellAt(2, 2).isEmpty());
+    QCOMPARE(result->property(QLatin1String("name")), QLatin1String("value"));
+}
+
+void test_MapDiff::mergeConflictingCells()
+{
+    QScopedPointer<Map> base(createMap());
+    QScopedPointer<Map> ours(createMap());
+    QScopedPointer<Map> theirs(createMap());
+
+    ours->layerAt(0)->asTileLayer()->setCell(1, 1, Cell());
+    theirs->layerAt(0)->asTileLayer()->setCell(1, 1, Cell(mTileset->tileAt(3)));
+
+    QStringList conflicts;
+    QScopedPointer<Map> result(MapDiff::merge(base.data(), ours.data(), theirs.data(),
+                                              &conflicts));
+    QVERIFY(!result);
+    QCOMPARE(conflicts.size(), 1);
+}
+
+void test_MapDiff::mergeObjects()
+{
+    QScopedPointer<Map> base(createMap());
+    QScopedPointer<Map> ours(createMap());
+    QScopedPointer<Map> theirs(createMap());
+
+    // Both sides add an object, which got the same ID on each side
+    MapObject *ourObject = new MapObject(QLatin1String("Ours"), QString(),
+                                         QPointF(), QSizeF());
+    ourObject->setId(4);
+    ours->layerAt(1)->asObjectGroup()->addObject(ourObject);
+    ours->setNextObjectId(5);
+
+    MapObject *theirObject = new MapObject(QLatin1String("Theirs"), QString(),
+                                           QPointF(), QSizeF());
+    theirObject->setId(4);
+    theirs->layerAt(1)->asObjectGroup()->addObject(theirObject);
+    theirs->layerAt(1)->asObjectGroup()->objectAt(0)->setName(QLatin1String("Renamed"));
+    theirs->setNextObjectId(5);
+
+    QStringList conflicts;
+    QScopedPointer<Map> result(MapDiff::merge(base.data(), ours.data(), theirs.data(),
+                                              &conflicts));
+    QVERIFY(result);
+
+    const QList<MapObject*> &objects = result->layerAt(1)->asObjectGroup()->objects();
+    QCOMPARE(objects.size(), 5);
+    QCOMPARE(objects.at(0)->name(), QLatin1String("Renamed"));
+    QCOMPARE(objects.at(3)->id(), 4);
+    QCOMPARE(objects.at(4)->name(), QLatin1String("Theirs"));
+    QCOMPARE(objects.at(4)->id(), 5);
+    QCOMPARE(result->nextObjectId(), 6);
+}
+
+QTEST_MAIN(test_MapDiff)
+#include "test_mapdiff.moc"
@@ -2,6 +2,7 @@
 #include "mapobject.h"
 #include "objectgroup.h"
 #include "tilelayer.h"
+#include "tileset.h"
 #include "mapreader.h"
 
 #include <QtTest/QtTest>
@@ -14,6 +15,12 @@ class test_MapReader : public QObject
 
 private slots:
     void loadMap();
+    void loadLayerSubset();
+    void cancelLoading();
+    void deferImageLoading();
+    void lazyLoadHiddenLayer_data();
+    void lazyLoadHiddenLayer();
+    void readPolygon();
 };
 
 void test_MapReader::loadMap()
@@ -53,5 +60,138 @@ void test_MapReader::loadMap()
     QCOMPARE(mapObject->height(), qreal(64));
 }
 
+void test_MapReader::loadLayerSubset()
+{
+    MapReadOptions options;
+    options.layerNames.append(QLatin1String("Objects"));
+
+    MapReader reader;
+    reader.setReadOptions(options);
+    QScopedPointer<Map> map(reader.readMap("../data/mapobject.tmx"));
+
+    QVERIFY(map);
+    QCOMPARE(map->layerCount(), 1);
+    QCOMPARE(map->layerAt(0)->name(), QLatin1String("Objects"));
+}
+
+void test_MapReader::cancelLoading()
+{
+    MapReadOptions options;
+    options.progress = [] (qint64, qint64) { return false; };
+
+    MapReader reader;
+    reader.setReadOptions(options);
+    QScopedPointer<Map> map(reader.readMap("../data/mapobject.tmx"));
+
+    QVERIFY(!map);
+}
+
+void test_MapReader::deferImageLoading()
+{
+    MapReader reader;
+    reader.setImageLoadingDeferred(true);
+    QScopedPointer<Map> map(reader.readMap("../../examples/sewers.tmx"));
+
+    QVERIFY(map);
+    QCOMPARE(map->tilesetCount(), 1);
+
+    const SharedTileset tileset = map->tilesetAt(0);
+    QVERIFY(!tileset->isImageLoaded());
+    QCOMPARE(tileset->imageWidth(), 192);
+    QCOMPARE(tileset->imageHeight(), 217);
+    QVERIFY(tileset->tileCount() > 0);
+
+    // The image is loaded when it is first used
+    QVERIFY(!tileset->image().isNull());
+    QVERIFY(tileset->isImageLoaded());
+}
+
+void test_MapReader::lazyLoadHiddenLayer_data()
+{
+    QTest::addColumn<QByteArray>("layerData");
+    QTest::addColumn<bool>("readable");
+    QTest::addColumn<QString>("warning");
+
+    QTest::newRow("valid") << QByteArray("AQAAAAIAAAA=") << true << QString();
+    QTest::newRow("truncated") << QByteArray("AQAAAA==") << false << QString();
+    QTest::newRow("invalid tile") << QByteArray("AQAAAGMAAAA=") << true
+                                  << QString::fromLatin1("Failed to load the cells of layer 'Hidden': Invalid tile: 99");
+}
+
+void test_MapReader::lazyLoadHiddenLayer()
+{
+    QFETCH(QByteArray, layerData);
+    QFETCH(bool, readable);
+    QFETCH(QString, warning);
+
+    QByteArray tmx(
+        "<map version=\"1.0\" orientation=\"orthogonal\" width=\"2\" height=\"1\""
+        " tilewidth=\"32\" tileheight=\"32\">"
+        " <tileset firstgid=\"1\" name=\"Tiles\" tilewidth=\"32\" tileheight=\"32\">"
+        "  <tile id=\"0\"/>"
+        "  <tile id=\"1\"/>"
+        " </tileset>"
+        " <layer name=\"Hidden\" width=\"2\" height=\"1\" visible=\"0\">"
+        "  <data encoding=\"base64\">" + layerData + "</data>"
+        " </layer>"
+        "</map>");
+    QBuffer buffer(&tmx);
+    buffer.open(QIODevice::ReadOnly);
+
+    MapReader reader;
+    reader.setLazyLoadingEnabled(true);
+    QScopedPointer<Map> map(reader.readMap(&buffer, QString()));
+
+    // Data of the wrong size fails the read without decoding the cells
+    QCOMPARE(!map.isNull(), readable);
+    if (!map)
+        return;
+
+    TileLayer *tileLayer = dynamic_cast<TileLayer*>(map->layerAt(0));
+    QVERIFY(tileLayer);
+    QVERIFY(!tileLayer->isLoaded());
+
+    // Invalid tiles are reported once the cells are loaded
+    if (!warning.isEmpty())
+        QTest::ignoreMessage(QtWarningMsg, qPrintable(warning));
+
+    const Tileset *tileset = map->tilesetAt(0).data();
+    QVERIFY(tileLayer->cellAt(0, 0).tile == tileset->tileAt(0));
+    QVERIFY(tileLayer->isLoaded());
+
+    if (warning.isEmpty())
+        QVERIFY(tileLayer->cellAt(1, 0).tile == tileset->tileAt(1));
+    else
+        QVERIFY(tileLayer->cellAt(1, 0).isEmpty());
+}
+
+void test_MapReader::readPolygon()
+{
+    QByteArray tmx(
+        "<map version=\"1.0\" orientation=\"orthogonal\" width=\"1\" height=\"1\""
+        " tilewidth=\"32\" tileheight=\"32\">"
+        " <objectgroup name=\"Objects\">"
+        "  <object id=\"1\" x=\"0\" y=\"0\">"
+        "   <polygon points=\"0,0  10.5,-2 3,4 \"/>"
+        "  </object>"
+        " </objectgroup>"
+        "</map>");
+    QBuffer buffer(&tmx);
+    buffer.open(QIODevice::ReadOnly);
+
+    MapReader reader;
+    QScopedPointer<Map> map(reader.readMap(&buffer, QString()));
+
+    QVERIFY(map);
+    ObjectGroup *objectGroup = dynamic_cast<ObjectGroup*>(map->layerAt(0));
+    QVERIFY(objectGroup);
+
+    const MapObject *mapObject = objectGroup->objects().at(0);
+    QCOMPARE(mapObject->shape(), MapObject::Polygon);
+    QCOMPARE(mapObject->polygon(), QPolygonF() << QPointF(0, 0)
+                                                << QPointF(10.5, -2)
+                                                << QPointF(3, 4));
+}
+
 QTEST_MAIN(test_MapReader)
 #include "test_mapreader.moc"
@@ -0,0 +1,64 @@
+#include "map.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QFileInfo>
+
+using namespace Tiled;
+
+/**
+ * Tests the TMX writer against stored maps, which contain the output that
+ * MapWriter produced before it buffered its output and wrote the tile data
+ * itself. Reading and writing these maps again should reproduce them
+ * exactly.
+ */
+class test_MapWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeStoredMap_data();
+    void writeStoredMap();
+};
+
+void test_MapWriter::writeStoredMap_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<Map::LayerDataFormat>("format");
+
+    QTest::newRow("xml") << QString::fromLatin1("../data/layerdata-xml.tmx")
+                         << Map::XML;
+    QTest::newRow("csv") << QString::fromLatin1("../data/layerdata-csv.tmx")
+                         << Map::CSV;
+    QTest::newRow("base64") << QString::fromLatin1("../data/layerdata-base64.tmx")
+                            << Map::Base64;
+}
+
+void test_MapWriter::writeStoredMap()
+{
+    QFETCH(QString, fileName);
+    QFETCH(Map::LayerDataFormat, format);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray expected = file.readAll();
+
+    MapReader reader;
+    QScopedPointer<Map> map(reader.readMap(fileName));
+    QVERIFY2(map, qPrintable(reader.errorString()));
+    QCOMPARE(map->layerDataFormat(), format);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    MapWriter writer;
+    writer.writeMap(map.data(), &buffer, QFileInfo(fileName).absolutePath());
+    QVERIFY(writer.errorString().isEmpty());
+
+    QCOMPARE(buffer.data(), expected);
+}
+
+QTEST_MAIN(test_MapWriter)
+#include "test_mapwriter.moc"
@@ -0,0 +1,450 @@
+#include "hexagonalrenderer.h"
+#include "isometricrenderer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <QPaintEngine>
+
+#ifndef QT_NO_OPENGL
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QOpenGLPaintDevice>
+#endif
+
+#include <functional>
+
+using namespace Tiled;
+
+namespace {
+
+/**
+ * A paint engine that only counts the draw calls it receives.
+ */
+class CountingPaintEngine : public QPaintEngine
+{
+public:
+    CountingPaintEngine()
+        : QPaintEngine(AllFeatures)
+        , mDrawCalls(0)
+    {}
+
+    int drawCalls() const { return mDrawCalls; }
+
+    bool begin(QPaintDevice *) override { return true; }
+    bool end() override { return true; }
+    void updateState(const QPaintEngineState &) override {}
+    Type type() const override { return User; }
+
+    void drawRects(const QRect *, int) override { ++mDrawCalls; }
+    void drawRects(const QRectF *, int) override { ++mDrawCalls; }
+    void drawLines(const QLine *, int) override { ++mDrawCalls; }
+    void drawLines(const QLineF *, int) override { ++mDrawCalls; }
+    void drawEllipse(const QRectF &) override { ++mDrawCalls; }
+    void drawEllipse(const QRect &) override { ++mDrawCalls; }
+    void drawPath(const QPainterPath &) override { ++mDrawCalls; }
+    void drawPoints(const QPointF *, int) override { ++mDrawCalls; }
+    void drawPoints(const QPoint *, int) override { ++mDrawCalls; }
+    void drawPolygon(const QPointF *, int, PolygonDrawMode) override { ++mDrawCalls; }
+    void drawPolygon(const QPoint *, int, PolygonDrawMode) override { ++mDrawCalls; }
+    void drawPixmap(const QRectF &, const QPixmap &, const QRectF &) override { ++mDrawCalls; }
+    void drawTextItem(const QPointF &, const QTextItem &) override { ++mDrawCalls; }
+    void drawTiledPixmap(const QRectF &, const QPixmap &, const QPointF &) override { ++mDrawCalls; }
+    void drawImage(const QRectF &, const QImage &, const QRectF &,
+                   Qt::ImageConversionFlags) override { ++mDrawCalls; }
+
+private:
+    int mDrawCalls;
+};
+
+class CountingPaintDevice : public QPaintDevice
+{
+public:
+    explicit CountingPaintDevice(const QSize &size)
+        : mSize(size)
+    {}
+
+    QPaintEngine *paintEngine() const override { return &mEngine; }
+
+    int drawCalls() const { return mEngine.drawCalls(); }
+
+protected:
+    int metric(PaintDeviceMetric metric) const override
+    {
+        switch (metric) {
+        case PdmWidth:          return mSize.width();
+        case PdmHeight:         return mSize.height();
+        case PdmWidthMM:        return mSize.width() * 254 / 960;
+        case PdmHeightMM:       return mSize.height() * 254 / 960;
+        case PdmNumColors:      return INT_MAX;
+        case PdmDepth:          return 32;
+        case PdmDpiX:
+        case PdmDpiY:
+        case PdmPhysicalDpiX:
+        case PdmPhysicalDpiY:   return 96;
+        case PdmDevicePixelRatio: return 1;
+        default:                return QPaintDevice::metric(metric);
+        }
+    }
+
+private:
+    QSize mSize;
+    mutable CountingPaintEngine mEngine;
+};
+
+enum Device {
+    Raster,
+    OpenGL,
+    DrawCalls
+};
+
+static const struct {
+    Map::Orientation orientation;
+    const char *name;
+} orientations[] = {
+    { Map::Orthogonal,  "orthogonal" },
+    { Map::Isometric,   "isometric" },
+    { Map::Staggered,   "staggered" },
+    { Map::Hexagonal,   "hexagonal" },
+};
+
+/**
+ * Draws frames for at least half a second and returns the number of frames
+ * drawn per second.
+ */
+static qreal framesPerSecond(const std::function<void()> &drawFrame)
+{
+    QElapsedTimer timer;
+    int frames = 0;
+
+    timer.start();
+    do {
+        drawFrame();
+        ++frames;
+    } while (timer.elapsed() < 500);
+
+    return frames * qreal(1000000000) / timer.nsecsElapsed();
+}
+
+} // anonymous namespace
+
+typedef std::function<void (QPainter *painter,
+                            const Map *map,
+                            const MapRenderer *renderer,
+                            const QRectF &exposed)> DrawFunction;
+
+/**
+ * Benchmarks drawing tile layers, the grid and map objects with each of the
+ * renderers, at several zoom levels and viewport sizes.
+ *
+ * Each case is drawn on a raster image and on an OpenGL frame buffer, for
+ * which the result is in frames per second, and on a paint device that
+ * only counts the draw calls it receives.
+ */
+class test_RendererBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void drawTileLayer_data();
+    void drawTileLayer();
+
+    void drawGrid_data();
+    void drawGrid();
+
+    void drawMapObject_data();
+    void drawMapObject();
+
+private:
+    void addRows();
+    void run(const DrawFunction &draw);
+
+    QVector<Map*> mMaps;
+    QVector<MapRenderer*> mRenderers;
+
+#ifndef QT_NO_OPENGL
+    QOffscreenSurface mSurface;
+    QOpenGLContext mContext;
+#endif
+    bool mOpenGLAvailable;
+};
+
+/**
+ * Creates a 256x256 map with the given \a orientation. It has a filled tile
+ * layer, a sparse tile layer with some flipped tiles and an object layer
+ * with objects of all shapes.
+ */
+static Map *createMap(Map::Orientation orientation)
+{
+    const bool diamond = orientation == Map::Isometric || orientation == Map::Staggered;
+    const int tileWidth = diamond ? 64 : 32;
+    const int tileHeight = 32;
+    const int size = 256;
+
+    Map *map = new Map(orientation, size, size, tileWidth, tileHeight);
+    if (orientation == Map::Hexagonal) {
+        map->setHexSideLength(16);
+        map->setStaggerAxis(Map::StaggerY);
+    }
+
+    // A tileset of 8x8 differently colored tiles
+    QImage image(tileWidth * 8, tileHeight * 8, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgb(x * 255 / image.width(), y * 255 / image.height(), 128));
+
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), tileWidth, tileHeight);
+    tileset->loadFromImage(image, QLatin1String("tiles.png"));
+    map->addTileset(tileset);
+
+    quint32 random = 1;
+    auto next = [&random] () {
+        random = random * 1103515245 + 12345;
+        return random >> 16;
+    };
+
+    TileLayer *ground = new TileLayer(QLatin1String("ground"), 0, 0, size, size);
+    TileLayer *decoration = new TileLayer(QLatin1String("decoration"), 0, 0, size, size);
+    {
+        TileLayer::BulkEdit groundEdit(ground);
+        TileLayer::BulkEdit decorationEdit(decoration);
+
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const quint32 value = next();
+                ground->setCell(x, y, Cell(tileset->tileAt(value % tileset->tileCount())));
+
+                if ((value >> 6) % 8 == 0) {
+                    Cell cell(tileset->tileAt((value >> 9) % tileset->tileCount()));
+                    cell.flippedHorizontally = (value & (1 << 12)) != 0;
+                    decoration->setCell(x, y, cell);
+                }
+            }
+        }
+    }
+    map->addLayer(ground);
+    map->addLayer(decoration);
+
+    const int pixelSize = size * tileHeight;
+    ObjectGroup *objectGroup = new ObjectGroup(QLatin1String("objects"), 0, 0, size, size);
+    for (int i = 0; i < 4096; ++i) {
+        const QPointF pos(next() % pixelSize, next() % pixelSize);
+        MapObject *object = new MapObject(QString(), QString(), pos, QSizeF(48, 32));
+
+        switch (i % 5) {
+        case 0:
+            break;
+        case 1:
+            object->setShape(MapObject::Ellipse);
+            break;
+        case 2:
+        case 3:
+            object->setShape(i % 5 == 2 ? MapObject::Polygon : MapObject::Polyline);
+            object->setPolygon(QPolygonF() << QPointF(0, 0) << QPointF(48, 8)
+                                           << QPointF(32, 40) << QPointF(-8, 24));
+            break;
+        case 4:
+            object->setCell(Cell(tileset->tileAt(i % tileset->tileCount())));
+            object->setSize(tileWidth, tileHeight);
+            break;
+        }
+
+        objectGroup->addObject(object);
+    }
+    map->addLayer(objectGroup);
+
+    return map;
+}
+
+static MapRenderer *createRenderer(const Map *map)
+{
+    switch (map->orientation()) {
+    case Map::Isometric:
+        return new IsometricRenderer(map);
+    case Map::Staggered:
+        return new StaggeredRenderer(map);
+    case Map::Hexagonal:
+        return new HexagonalRenderer(map);
+    default:
+        return new OrthogonalRenderer(map);
+    }
+}
+
+void test_RendererBenchmark::initTestCase()
+{
+    for (const auto &orientation : orientations) {
+        Map *map = createMap(orientation.orientation);
+        mMaps.append(map);
+        mRenderers.append(createRenderer(map));
+    }
+
+    mOpenGLAvailable = false;
+
+#ifndef QT_NO_OPENGL
+    mSurface.create();
+    mOpenGLAvailable = mSurface.isValid() && mContext.create();
+#endif
+}
+
+void test_RendererBenchmark::cleanupTestCase()
+{
+    qDeleteAll(mRenderers);
+    qDeleteAll(mMaps);
+}
+
+void test_RendererBenchmark::addRows()
+{
+    QTest::addColumn<int>("orientation");
+    QTest::addColumn<qreal>("zoom");
+    QTest::addColumn<QSize>("viewport");
+    QTest::addColumn<int>("device");
+
+    static const qreal zooms[] = { 0.25, 1, 4 };
+    static const QSize viewports[] = { QSize(640, 480), QSize(1920, 1080) };
+    static const char * const devices[] = { "raster", "opengl", "drawcalls" };
+
+    for (int o = 0; o < int(sizeof(orientations) / sizeof(orientations[0])); ++o) {
+        for (qreal zoom : zooms) {
+            for (const QSize &viewport : viewports) {
+                for (int device = Raster; device <= DrawCalls; ++device) {
+                    const QString name = QString(QLatin1String("%1/%2x/%3x%4/%5"))
+                            .arg(QLatin1String(orientations[o].name))
+                            .arg(zoom)
+                            .arg(viewport.width())
+                            .arg(viewport.height())
+                            .arg(QLatin1String(devices[device]));
+
+                    QTest::newRow(qPrintable(name)) << o << zoom << viewport << device;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Draws the part of the map around its center that fits the viewport at
+ * the zoom level of the current row, on the device of the current row.
+ */
+void test_RendererBenchmark::run(const DrawFunction &draw)
+{
+    QFETCH(int, orientation);
+    QFETCH(qreal, zoom);
+    QFETCH(QSize, viewport);
+    QFETCH(int, device);
+
+    const Map *map = mMaps.at(orientation);
+    const MapRenderer *renderer = mRenderers.at(orientation);
+
+    QRectF exposed(QPointF(), QSizeF(viewport) / zoom);
+    exposed.moveCenter(QRectF(QPointF(), renderer->mapSize()).center());
+
+    auto paint = [&] (QPaintDevice *paintDevice) {
+        QPainter painter(paintDevice);
+        painter.scale(zoom, zoom);
+        painter.translate(-exposed.topLeft());
+        draw(&painter, map, renderer, exposed);
+    };
+
+    switch (device) {
+    case Raster: {
+        QImage image(viewport, QImage::Format_ARGB32_Premultiplied);
+        const qreal fps = framesPerSecond([&] {
+            image.fill(Qt::transparent);
+            paint(&image);
+        });
+        QTest::setBenchmarkResult(fps, QTest::FramesPerSecond);
+        break;
+    }
+    case OpenGL: {
+#ifndef QT_NO_OPENGL
+        if (!mOpenGLAvailable)
+            QSKIP("OpenGL is not available");
+
+        QVERIFY(mContext.makeCurrent(&mSurface));
+        {
+            QOpenGLFramebufferObject frameBuffer(viewport, QOpenGLFramebufferObject::CombinedDepthStencil);
+            QVERIFY(frameBuffer.bind());
+
+            QOpenGLPaintDevice paintDevice(viewport);
+            QOpenGLFunctions *functions = mContext.functions();
+
+            const qreal fps = framesPerSecond([&] {
+                functions->glClear(GL_COLOR_BUFFER_BIT);
+                paint(&paintDevice);
+                functions->glFinish();
+            });
+            QTest::setBenchmarkResult(fps, QTest::FramesPerSecond);
+
+            frameBuffer.release();
+        }
+        mContext.doneCurrent();
+#else
+        QSKIP("Qt was built without OpenGL");
+#endif
+        break;
+    }
+    case DrawCalls: {
+        CountingPaintDevice paintDevice(viewport);
+        paint(&paintDevice);
+        QTest::setBenchmarkResult(paintDevice.drawCalls(), QTest::Events);
+        break;
+    }
+    }
+}
+
+void test_RendererBenchmark::drawTileLayer_data()
+{
+    addRows();
+}
+
+void test_RendererBenchmark::drawTileLayer()
+{
+    run([] (QPainter *painter, const Map *map, const MapRenderer *renderer, const QRectF &exposed) {
+        for (const TileLayer *layer : map->tileLayers())
+            renderer->drawTileLayer(painter, layer, exposed);
+    });
+}
+
+void test_RendererBenchmark::drawGrid_data()
+{
+    addRows();
+}
+
+void test_RendererBenchmark::drawGrid()
+{
+    run([] (QPainter *painter, const Map *, const MapRenderer *renderer, const QRectF &exposed) {
+        renderer->drawGrid(painter, exposed);
+    });
+}
+
+void test_RendererBenchmark::drawMapObject_data()
+{
+    addRows();
+}
+
+void test_RendererBenchmark::drawMapObject()
+{
+    run([] (QPainter *painter, const Map *map, const MapRenderer *renderer, const QRectF &exposed) {
+        for (const ObjectGroup *objectGroup : map->objectGroups()) {
+            const QColor color = objectGroup->color().isValid() ? objectGroup->color()
+                                                                : QColor(Qt::gray);
+
+            for (const MapObject *object : renderer->objectsIntersecting(objectGroup, exposed))
+                renderer->drawMapObject(painter, object, color);
+        }
+    });
+}
+
+QTEST_MAIN(test_RendererBenchmark)
+#include "test_rendererbenchmark.moc"
@@ -1,4 +1,25 @@
 TEMPLATE=subdirs
 SUBDIRS = \
+    binary \
+    csvparser \
+    floodfill \
+    gidmapper \
+    jsonformat \
+    luaformat \
+    mapdiff \
+    mapcache \
     mapreader \
-    staggeredrenderer
+    mapwriter \
+    staggeredrenderer \
+    tilelayer \
+    tilemask
+
+# The benchmarks take a while to run, so they are only built when asked for
+# with "qmake CONFIG+=benchmarks"
+benchmarks {
+    SUBDIRS += \
+        automappingbenchmark \
+        editingbenchmark \
+        iobenchmark \
+        rendererbenchmark
+}
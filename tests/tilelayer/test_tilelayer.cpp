@@ -0,0 +1,632 @@
+#include "map.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tileset.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TileLayer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void emptyLayer();
+    void setCell();
+    void erase();
+    void region();
+    void resize();
+    void offsetTiles();
+    void rotate();
+    void flip_data();
+    void flip();
+    void rotateCells_data();
+    void rotateCells();
+    void offsetTilesWrapped_data();
+    void offsetTilesWrapped();
+    void infiniteLayer();
+    void transformInfinite();
+    void changesSince();
+    void cellMask();
+    void packedCells();
+    void unpackedCells();
+    void compressPackedChunks();
+    void packedDiffMask();
+
+private:
+    void fillPattern(TileLayer &layer) const;
+
+    SharedTileset mTileset;
+    SharedTileset mImageTileset;
+};
+
+void test_TileLayer::initTestCase()
+{
+    mTileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    for (int i = 0; i < 4; ++i)
+        mTileset->addTile(QPixmap(32, 32));
+
+    QImage image(64, 64, QImage::Format_ARGB32);
+    image.fill(Qt::white);
+    mImageTileset = Tileset::create(QLatin1String("image"), 32, 32);
+    QVERIFY(mImageTileset->loadFromImage(image, QLatin1String("image.png")));
+    QCOMPARE(mImageTileset->tileCount(), 4);
+}
+
+/**
+ * Fills the \a layer with a pattern of cells from both tilesets and with
+ * all combinations of flags, leaving some cells empty.
+ */
+void test_TileLayer::fillPattern(TileLayer &layer) const
+{
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            const int n = (x * 7 + y * 13) % 19;
+            if (n % 5 == 0)
+                continue;
+
+            const SharedTileset &tileset = (n & 1) ? mImageTileset : mTileset;
+            Cell cell(tileset->tileAt(n % 4));
+            cell.flippedHorizontally = (n & 2) != 0;
+            cell.flippedVertically = (n & 4) != 0;
+            cell.flippedAntiDiagonally = (n & 8) != 0;
+            layer.setCell(x, y, cell);
+        }
+    }
+}
+
+static bool sameCells(const TileLayer &a, const TileLayer &b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (int y = 0; y < a.height(); ++y)
+        for (int x = 0; x < a.width(); ++x)
+            if (!(a.cellAt(x, y) == b.cellAt(x, y)))
+                return false;
+
+    return true;
+}
+
+void test_TileLayer::emptyLayer()
+{
+    TileLayer layer(QString(), 0, 0, 4096, 4096);
+
+    QVERIFY(layer.isEmpty());
+    QVERIFY(layer.chunks().isEmpty());
+    QVERIFY(layer.cellAt(4000, 4000).isEmpty());
+    QVERIFY(layer.region().isEmpty());
+
+    // Setting empty cells should not allocate any chunks
+    layer.setCell(100, 100, Cell());
+    QVERIFY(layer.chunks().isEmpty());
+}
+
+void test_TileLayer::setCell()
+{
+    TileLayer layer(QString(), 0, 0, 100, 100);
+    Cell cell(mTileset->tileAt(1));
+
+    layer.setCell(50, 60, cell);
+
+    QCOMPARE(layer.chunks().size(), 1);
+    QVERIFY(layer.cellAt(50, 60) == cell);
+    QVERIFY(layer.cellAt(51, 60).isEmpty());
+    QVERIFY(!layer.isEmpty());
+    QVERIFY(layer.referencesTileset(mTileset.data()));
+
+    // Erasing the last cell of a chunk should release the chunk
+    layer.setCell(50, 60, Cell());
+    QVERIFY(layer.chunks().isEmpty());
+    QVERIFY(layer.isEmpty());
+}
+
+void test_TileLayer::erase()
+{
+    TileLayer layer(QString(), 0, 0, 100, 100);
+    Cell cell(mTileset->tileAt(1));
+
+    for (int x = 10; x < 40; ++x)
+        layer.setCell(x, 5, cell);
+    layer.setCell(80, 80, cell);
+
+    // Areas outside of the layer and without chunks are skipped
+    layer.erase(QRegion(-10, 0, 30, 10) + QRegion(50, 50, 100, 10));
+    QCOMPARE(layer.region(), QRegion(20, 5, 20, 1) + QRegion(80, 80, 1, 1));
+
+    // Erasing the remaining cells of a chunk should release the chunk
+    layer.erase(QRegion(16, 0, 40, 10));
+    QCOMPARE(layer.chunks().size(), 1);
+    QVERIFY(layer.referencesTileset(mTileset.data()));
+
+    layer.erase(QRegion(0, 0, 100, 100));
+    QVERIFY(layer.chunks().isEmpty());
+    QVERIFY(!layer.referencesTileset(mTileset.data()));
+}
+
+void test_TileLayer::region()
+{
+    TileLayer layer(QString(), 5, 5, 40, 40);
+    Cell cell(mTileset->tileAt(0));
+
+    // A run crossing a chunk boundary
+    for (int x = 10; x < 20; ++x)
+        layer.setCell(x, 3, cell);
+
+    QCOMPARE(layer.region(), QRegion(15, 8, 10, 1));
+
+    // A cell in a chunk that isn't adjacent to the others
+    layer.setCell(35, 3, cell);
+    QCOMPARE(layer.region(), QRegion(15, 8, 10, 1) + QRegion(40, 8, 1, 1));
+    layer.setCell(35, 3, Cell());
+
+    const QRegion empty = layer.region([] (const Cell &c) { return c.isEmpty(); });
+    QCOMPARE(empty, QRegion(5, 5, 40, 40) - QRegion(15, 8, 10, 1));
+}
+
+void test_TileLayer::resize()
+{
+    TileLayer layer(QString(), 0, 0, 40, 40);
+    Cell cell(mTileset->tileAt(2));
+    layer.setCell(1, 1, cell);
+    layer.setCell(35, 35, cell);
+
+    // Chunk-aligned offset
+    layer.resize(QSize(40, 40), QPoint(16, 0));
+    QVERIFY(layer.cellAt(17, 1) == cell);
+    QVERIFY(layer.cellAt(1, 1).isEmpty());
+    QCOMPARE(layer.region(), QRegion(17, 1, 1, 1));
+
+    // Unaligned offset
+    layer.resize(QSize(20, 20), QPoint(-3, -1));
+    QVERIFY(layer.cellAt(14, 0) == cell);
+    QCOMPARE(layer.region(), QRegion(14, 0, 1, 1));
+}
+
+void test_TileLayer::offsetTiles()
+{
+    TileLayer layer(QString(), 0, 0, 10, 10);
+    Cell cell(mTileset->tileAt(3));
+    layer.setCell(9, 0, cell);
+
+    layer.offsetTiles(QPoint(2, 0), QRect(0, 0, 10, 10), true, false);
+    QVERIFY(layer.cellAt(1, 0) == cell);
+    QCOMPARE(layer.region(), QRegion(1, 0, 1, 1));
+
+    layer.offsetTiles(QPoint(0, -1), QRect(0, 0, 10, 10), false, false);
+    QVERIFY(layer.isEmpty());
+}
+
+void test_TileLayer::rotate()
+{
+    TileLayer layer(QString(), 0, 0, 30, 20);
+    Cell cell(mTileset->tileAt(0));
+    layer.setCell(0, 0, cell);
+
+    layer.rotate(RotateRight);
+    QCOMPARE(layer.width(), 20);
+    QCOMPARE(layer.height(), 30);
+    QCOMPARE(layer.region(), QRegion(19, 0, 1, 1));
+    QVERIFY(layer.cellAt(19, 0).flippedAntiDiagonally);
+}
+
+void test_TileLayer::flip_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("single chunk") << QSize(5, 3);
+    QTest::newRow("chunk aligned") << QSize(32, 16);
+    QTest::newRow("wide") << QSize(45, 7);
+    QTest::newRow("tall") << QSize(3, 37);
+}
+
+void test_TileLayer::flip()
+{
+    QFETCH(QSize, size);
+
+    TileLayer layer(QString(), 0, 0, size.width(), size.height());
+    fillPattern(layer);
+
+    TileLayer horizontal(QString(), 0, 0, size.width(), size.height());
+    horizontal.setCells(0, 0, &layer);
+    horizontal.flip(FlipHorizontally);
+
+    TileLayer vertical(QString(), 0, 0, size.width(), size.height());
+    vertical.setCells(0, 0, &layer);
+    vertical.flip(FlipVertically);
+
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            Cell expected = layer.cellAt(layer.width() - 1 - x, y);
+            if (!expected.isEmpty())
+                expected.flippedHorizontally = !expected.flippedHorizontally;
+            QVERIFY(horizontal.cellAt(x, y) == expected);
+
+            expected = layer.cellAt(x, layer.height() - 1 - y);
+            if (!expected.isEmpty())
+                expected.flippedVertically = !expected.flippedVertically;
+            QVERIFY(vertical.cellAt(x, y) == expected);
+        }
+    }
+
+    // Flipping twice gives back the original cells
+    horizontal.flip(FlipHorizontally);
+    vertical.flip(FlipVertically);
+    QVERIFY(sameCells(horizontal, layer));
+    QVERIFY(sameCells(vertical, layer));
+}
+
+void test_TileLayer::rotateCells_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("single chunk") << QSize(5, 3);
+    QTest::newRow("square") << QSize(16, 16);
+    QTest::newRow("wide") << QSize(45, 7);
+    QTest::newRow("tall") << QSize(3, 37);
+}
+
+void test_TileLayer::rotateCells()
+{
+    QFETCH(QSize, size);
+
+    TileLayer layer(QString(), 0, 0, size.width(), size.height());
+    fillPattern(layer);
+
+    TileLayer right(QString(), 0, 0, size.width(), size.height());
+    right.setCells(0, 0, &layer);
+    right.rotate(RotateRight);
+    QCOMPARE(right.size(), size.transposed());
+
+    TileLayer left(QString(), 0, 0, size.width(), size.height());
+    left.setCells(0, 0, &layer);
+    left.rotate(RotateLeft);
+    QCOMPARE(left.size(), size.transposed());
+
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            const Cell &cell = layer.cellAt(x, y);
+            QCOMPARE(right.cellAt(layer.height() - 1 - y, x).tile, cell.tile);
+            QCOMPARE(left.cellAt(y, layer.width() - 1 - x).tile, cell.tile);
+        }
+    }
+
+    // Rotating by 180 degrees is the same as flipping both ways
+    TileLayer flipped(QString(), 0, 0, size.width(), size.height());
+    flipped.setCells(0, 0, &layer);
+    flipped.flip(FlipHorizontally);
+    flipped.flip(FlipVertically);
+
+    right.rotate(RotateRight);
+    QVERIFY(sameCells(right, flipped));
+
+    // Rotating back gives back the original cells, including their flags
+    right.rotate(RotateLeft);
+    right.rotate(RotateLeft);
+    QVERIFY(sameCells(right, layer));
+
+    left.rotate(RotateRight);
+    QVERIFY(sameCells(left, layer));
+}
+
+void test_TileLayer::offsetTilesWrapped_data()
+{
+    QTest::addColumn<QRect>("bounds");
+    QTest::addColumn<QPoint>("offset");
+    QTest::addColumn<bool>("wrapX");
+    QTest::addColumn<bool>("wrapY");
+
+    QTest::newRow("everything") << QRect(0, 0, 45, 37) << QPoint(3, -2) << true << true;
+    QTest::newRow("no wrap") << QRect(0, 0, 45, 37) << QPoint(-20, 17) << false << false;
+    QTest::newRow("across chunks") << QRect(10, 5, 20, 30) << QPoint(7, 9) << true << false;
+    QTest::newRow("wrap y only") << QRect(10, 5, 20, 30) << QPoint(-3, -31) << false << true;
+    QTest::newRow("more than size") << QRect(15, 15, 3, 3) << QPoint(-10, 8) << true << true;
+    QTest::newRow("chunk aligned") << QRect(16, 0, 16, 32) << QPoint(16, 16) << true << true;
+}
+
+void test_TileLayer::offsetTilesWrapped()
+{
+    QFETCH(QRect, bounds);
+    QFETCH(QPoint, offset);
+    QFETCH(bool, wrapX);
+    QFETCH(bool, wrapY);
+
+    TileLayer layer(QString(), 0, 0, 45, 37);
+    fillPattern(layer);
+
+    TileLayer moved(QString(), 0, 0, 45, 37);
+    moved.setCells(0, 0, &layer);
+    moved.offsetTiles(offset, bounds, wrapX, wrapY);
+
+    // Compare with pulling each cell from its old position
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            if (!bounds.contains(x, y)) {
+                QVERIFY(moved.cellAt(x, y) == layer.cellAt(x, y));
+                continue;
+            }
+
+            int oldX = x - offset.x();
+            int oldY = y - offset.y();
+
+            if (wrapX) {
+                while (oldX < bounds.left())
+                    oldX += bounds.width();
+                while (oldX > bounds.right())
+                    oldX -= bounds.width();
+            }
+            if (wrapY) {
+                while (oldY < bounds.top())
+                    oldY += bounds.height();
+                while (oldY > bounds.bottom())
+                    oldY -= bounds.height();
+            }
+
+            const Cell expected = bounds.contains(oldX, oldY) ? layer.cellAt(oldX, oldY)
+                                                              : Cell();
+            QVERIFY(moved.cellAt(x, y) == expected);
+        }
+    }
+}
+
+void test_TileLayer::infiniteLayer()
+{
+    // Layers without an infinite map are limited to their size
+    TileLayer finite(QString(), 0, 0, 10, 8);
+    QVERIFY(!finite.isInfinite());
+    QCOMPARE(finite.cellArea(), QRect(0, 0, 10, 8));
+    QCOMPARE(finite.cellBounds(), QRect(0, 0, 10, 8));
+
+    Map map(Map::Orthogonal, 10, 8, 32, 32);
+    map.setInfinite(true);
+
+    TileLayer *layer = new TileLayer(QString(), 0, 0, 10, 8);
+    map.addLayer(layer);
+
+    QVERIFY(layer->isInfinite());
+    QVERIFY(layer->cellArea().contains(QRect(-100000, -100000, 200000, 200000)));
+    QCOMPARE(layer->cellBounds(), QRect(0, 0, 10, 8));
+
+    const Cell cell(mImageTileset->tileAt(2));
+    layer->setCell(-1, -1, cell);
+    layer->setCell(-17, 40, cell);
+    layer->setCell(100, -100, cell);
+
+    QVERIFY(layer->cellAt(-1, -1) == cell);
+    QVERIFY(layer->cellAt(-17, 40) == cell);
+    QVERIFY(layer->cellAt(-2, -1).isEmpty());
+    QVERIFY(layer->cellAt(-5000, 5000).isEmpty());
+    QCOMPARE(layer->region(), QRegion(-1, -1, 1, 1) + QRegion(-17, 40, 1, 1) +
+                              QRegion(100, -100, 1, 1));
+
+    // The bounds cover the layer size and all of the chunks
+    QCOMPARE(layer->cellBounds(), QRect(QPoint(-32, -112), QPoint(111, 47)));
+
+    // Chunks are ordered by rows, from top to bottom
+    const QVector<QRect> chunkRects {
+        QRect(96, -112, 16, 16),
+        QRect(-16, -16, 16, 16),
+        QRect(-32, 32, 16, 16),
+    };
+    QCOMPARE(layer->chunkRects(), chunkRects);
+
+    // Copying at negative coordinates, sharing the chunk that lines up
+    QScopedPointer<TileLayer> copy(layer->copy(QRegion(-16, -16, 32, 32)));
+    QCOMPARE(copy->size(), QSize(32, 32));
+    QCOMPARE(copy->region(), QRegion(15, 15, 1, 1));
+
+    QScopedPointer<TileLayer> unaligned(layer->copy(QRegion(-20, 35, 6, 6)));
+    QCOMPARE(unaligned->region(), QRegion(3, 5, 1, 1));
+
+    // Resizing keeps the cells outside of the new size
+    layer->resize(QSize(5, 5), QPoint(3, -2));
+    QCOMPARE(layer->region(), QRegion(2, -3, 1, 1) + QRegion(-14, 38, 1, 1) +
+                              QRegion(103, -102, 1, 1));
+    QVERIFY(layer->referencesTileset(mImageTileset.data()));
+
+    // Erasing the cells releases their chunks, shrinking the bounds again
+    layer->erase(QRegion(-50, -150, 200, 200));
+    QVERIFY(layer->isEmpty());
+    QVERIFY(layer->chunks().isEmpty());
+    QCOMPARE(layer->cellBounds(), QRect(0, 0, 5, 5));
+}
+
+void test_TileLayer::transformInfinite()
+{
+    Map map(Map::Orthogonal, 10, 10, 32, 32);
+    map.setInfinite(true);
+
+    TileLayer *layer = new TileLayer(QString(), 0, 0, 10, 10);
+    map.addLayer(layer);
+
+    // Cells outside of the layer size, on both sides of the origin
+    const Cell cell(mImageTileset->tileAt(1));
+    layer->setCell(-20, -3, cell);
+    layer->setCell(25, 4, cell);
+    QCOMPARE(layer->cellBounds(), QRect(QPoint(-32, -16), QPoint(31, 15)));
+
+    // Cells outside of the layer size are kept, flipped along with the layer
+    layer->flip(FlipHorizontally);
+    QCOMPARE(layer->region(), QRegion(29, -3, 1, 1) + QRegion(-16, 4, 1, 1));
+    QVERIFY(layer->cellAt(29, -3).flippedHorizontally);
+
+    layer->flip(FlipVertically);
+    QCOMPARE(layer->region(), QRegion(29, 12, 1, 1) + QRegion(-16, 5, 1, 1));
+
+    layer->rotate(RotateRight);
+    QCOMPARE(layer->region(), QRegion(-3, 29, 1, 1) + QRegion(4, -16, 1, 1));
+
+    layer->rotate(RotateLeft);
+    QCOMPARE(layer->region(), QRegion(29, 12, 1, 1) + QRegion(-16, 5, 1, 1));
+    QVERIFY(layer->cellAt(29, 12).flippedHorizontally);
+    QVERIFY(layer->cellAt(29, 12).flippedVertically);
+    QVERIFY(!layer->cellAt(29, 12).flippedAntiDiagonally);
+}
+
+void test_TileLayer::changesSince()
+{
+    TileLayer layer(QString(), 0, 0, 40, 40);
+    Cell cell(mTileset->tileAt(1));
+
+    const unsigned start = layer.changeGeneration();
+    layer.setCell(20, 3, cell);
+    QCOMPARE(layer.changesSince(start).toRegion(), QRegion(16, 0, 16, 16));
+
+    // Setting a cell to the same value is not a change
+    const unsigned afterSet = layer.changeGeneration();
+    layer.setCell(20, 3, cell);
+    QCOMPARE(layer.changeGeneration(), afterSet);
+    QVERIFY(layer.changesSince(afterSet).isEmpty());
+
+    // Chunks that were released are still reported, clipped to the layer
+    layer.setCell(38, 38, cell);
+    layer.setCell(38, 38, Cell());
+    QCOMPARE(layer.changesSince(afterSet).toRegion(), QRegion(32, 32, 8, 8));
+    QCOMPARE(layer.changesSince(start).toRegion(),
+             QRegion(16, 0, 16, 16) + QRegion(32, 32, 8, 8));
+
+    const unsigned beforeRotate = layer.changeGeneration();
+    layer.rotate(RotateLeft);
+    QCOMPARE(layer.changesSince(beforeRotate).toRegion(), QRegion(0, 0, 40, 40));
+}
+
+void test_TileLayer::cellMask()
+{
+    TileLayer layer(QString(), 2, 2, 40, 40);
+    Cell cell(mTileset->tileAt(1));
+    Cell flipped = cell;
+    flipped.flippedHorizontally = true;
+
+    layer.setCell(3, 3, cell);
+    layer.setCell(4, 3, flipped);
+    layer.setCell(20, 30, cell);
+    QCOMPARE(layer.cellMask(cell).toRegion(),
+             QRegion(5, 5, 1, 1) + QRegion(22, 32, 1, 1));
+    QCOMPARE(layer.chunksWithTile(cell.tile).size(), 2);
+
+    // Changes made after the index was built are tracked
+    layer.setCell(20, 30, Cell());
+    layer.setCell(35, 5, cell);
+    QCOMPARE(layer.cellMask(cell).toRegion(),
+             QRegion(5, 5, 1, 1) + QRegion(37, 7, 1, 1));
+    QCOMPARE(layer.cellMask(flipped).toRegion(), QRegion(6, 5, 1, 1));
+
+    layer.removeReferencesToTileset(mTileset.data());
+    QVERIFY(layer.isEmpty());
+    QVERIFY(layer.chunksWithTile(cell.tile).isEmpty());
+    QVERIFY(!layer.referencesTileset(mTileset.data()));
+}
+
+void test_TileLayer::packedCells()
+{
+    TileLayer layer(QString(), 0, 0, 40, 40);
+    Cell cell(mImageTileset->tileAt(3));
+    cell.flippedVertically = true;
+    cell.flippedAntiDiagonally = true;
+
+    layer.setCell(17, 2, cell);
+    layer.setCell(18, 2, Cell(mImageTileset->tileAt(0)));
+
+    const Chunk &chunk = layer.chunks().value(QPoint(1, 0));
+    QVERIFY(chunk.isPacked());
+    QCOMPARE(chunk.cellCount(), 2);
+    QVERIFY(layer.cellAt(17, 2) == cell);
+    QVERIFY(layer.cellAt(18, 2) == Cell(mImageTileset->tileAt(0)));
+    QVERIFY(layer.cellAt(19, 2).isEmpty());
+
+    int count = 0;
+    for (const Cell &c : layer)
+        if (!c.isEmpty())
+            ++count;
+    QCOMPARE(count, 2);
+
+    // Packed cells take a fraction of the memory of full cells
+    TileLayer unpacked(QString(), 0, 0, 40, 40);
+    unpacked.setCell(17, 2, Cell(mTileset->tileAt(3)));
+    QVERIFY(!unpacked.chunks().value(QPoint(1, 0)).isPacked());
+    QVERIFY(layer.cellMemoryUsage() < unpacked.cellMemoryUsage());
+
+    layer.setCell(17, 2, Cell());
+    layer.setCell(18, 2, Cell());
+    QVERIFY(layer.chunks().isEmpty());
+}
+
+void test_TileLayer::unpackedCells()
+{
+    TileLayer layer(QString(), 0, 0, 40, 40);
+    Cell packed(mImageTileset->tileAt(1));
+    packed.flippedHorizontally = true;
+    Cell collection(mTileset->tileAt(2));
+
+    layer.setCell(3, 3, packed);
+    QVERIFY(layer.chunks().value(QPoint(0, 0)).isPacked());
+
+    // Tiles of image collections are not packed, the chunk falls back to
+    // full cells while keeping the cells it already had
+    layer.setCell(4, 3, collection);
+    QVERIFY(!layer.chunks().value(QPoint(0, 0)).isPacked());
+    QVERIFY(layer.cellAt(3, 3) == packed);
+    QVERIFY(layer.cellAt(4, 3) == collection);
+
+    // So do empty cells with flags, which can't be told apart from no cell
+    Cell flippedEmpty;
+    flippedEmpty.flippedVertically = true;
+    layer.setCell(20, 3, packed);
+    layer.setCell(21, 3, flippedEmpty);
+    QVERIFY(!layer.chunks().value(QPoint(1, 0)).isPacked());
+    QVERIFY(layer.cellAt(21, 3) == flippedEmpty);
+    QVERIFY(layer.cellAt(20, 3) == packed);
+}
+
+void test_TileLayer::compressPackedChunks()
+{
+    TileLayer layer(QString(), 0, 0, 40, 40);
+    Cell packed(mImageTileset->tileAt(2));
+    packed.flippedHorizontally = true;
+    Cell collection(mTileset->tileAt(1));
+
+    layer.setCell(1, 1, packed);
+    layer.setCell(33, 20, packed);
+    layer.setCell(34, 20, collection);
+
+    const unsigned generation = layer.changeGeneration();
+    const auto compressed = TileLayer::compressChunks(layer.chunks());
+    QCOMPARE(compressed.size(), 2);
+    QVERIFY(layer.setCompressedChunks(compressed, generation));
+    QVERIFY(layer.isCompressed());
+
+    QVERIFY(layer.cellAt(1, 1) == packed);
+    QVERIFY(layer.cellAt(33, 20) == packed);
+    QVERIFY(layer.cellAt(34, 20) == collection);
+    QVERIFY(!layer.isCompressed());
+    QVERIFY(layer.chunks().value(QPoint(0, 0)).isPacked());
+    QVERIFY(!layer.chunks().value(QPoint(2, 1)).isPacked());
+    QCOMPARE(layer.region(), QRegion(1, 1, 1, 1) + QRegion(33, 20, 2, 1));
+}
+
+void test_TileLayer::packedDiffMask()
+{
+    TileLayer layer(QString(), 0, 0, 40, 40);
+    Cell cell(mImageTileset->tileAt(0));
+    for (int x = 0; x < 40; ++x)
+        layer.setCell(x, 5, cell);
+
+    TileLayer other(QString(), 0, 0, 40, 40);
+    other.setCells(0, 0, &layer);
+    QVERIFY(other.computeDiffMask(&layer).isEmpty());
+
+    Cell flipped = cell;
+    flipped.flippedHorizontally = true;
+    other.setCell(3, 5, flipped);
+    other.setCell(20, 5, Cell(mImageTileset->tileAt(1)));
+    other.setCell(36, 6, cell);
+
+    QCOMPARE(other.computeDiffMask(&layer).toRegion(),
+             QRegion(3, 5, 1, 1) + QRegion(20, 5, 1, 1) + QRegion(36, 6, 1, 1));
+}
+
+QTEST_MAIN(test_TileLayer)
+#include "test_tilelayer.moc"
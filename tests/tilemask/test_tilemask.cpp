@@ -0,0 +1,248 @@
+#include "tilemask.h"
+
+#include <QtTest/QtTest>
+
+using namespace Tiled;
+
+class test_TileMask : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void emptyMask();
+    void setCell();
+    void setSpan();
+    void boundingRect();
+    void intersects();
+    void operators_data();
+    void operators();
+    void translated_data();
+    void translated();
+    void toRegion();
+    void selectionChanges();
+};
+
+/**
+ * Returns a fragmented region, with holes and rectangles that cross block
+ * borders on both sides of the origin.
+ */
+static QRegion checkerRegion(const QPoint &offset)
+{
+    QRegion region;
+    for (int y = -20; y < 20; y += 3)
+        for (int x = -20 + (y & 1); x < 20; x += 5)
+            region += QRect(offset.x() + x, offset.y() + y, 3, 2);
+    return region;
+}
+
+void test_TileMask::emptyMask()
+{
+    TileMask mask;
+    QVERIFY(mask.isEmpty());
+    QVERIFY(mask.toRegion().isEmpty());
+    QVERIFY(mask.boundingRect().isNull());
+    QVERIFY(!mask.contains(0, 0));
+    QVERIFY(!mask.intersects(QRect(-100, -100, 200, 200)));
+    QCOMPARE(mask.memoryUsage(), qint64(0));
+
+    QVERIFY(TileMask(QRect()).isEmpty());
+    QVERIFY(TileMask(QRegion()).isEmpty());
+    QVERIFY(mask == TileMask(QRegion()));
+    QVERIFY(mask.translated(QPoint(3, -7)).isEmpty());
+}
+
+void test_TileMask::setCell()
+{
+    TileMask mask;
+
+    // Positions on both sides of block borders, including negative ones
+    const QVector<QPoint> positions {
+        QPoint(0, 0), QPoint(15, 15), QPoint(16, 16),
+        QPoint(-1, -1), QPoint(-16, 0), QPoint(-17, 31)
+    };
+
+    for (const QPoint &pos : positions)
+        mask.setCell(pos.x(), pos.y());
+
+    for (const QPoint &pos : positions)
+        QVERIFY(mask.contains(pos));
+
+    QVERIFY(!mask.contains(-15, 0));
+    QVERIFY(!mask.contains(-17, 30));
+    QVERIFY(!mask.contains(16, 15));
+    QVERIFY(!mask.contains(-2, -1));
+
+    // Clearing the last position of a block releases the block
+    for (const QPoint &pos : positions)
+        mask.setCell(pos.x(), pos.y(), false);
+    QVERIFY(mask.isEmpty());
+    QVERIFY(mask == TileMask());
+}
+
+void test_TileMask::setSpan()
+{
+    TileMask mask;
+    mask.setSpan(-20, -1, 50);
+    QCOMPARE(mask.toRegion(), QRegion(-20, -1, 50, 1));
+
+    // A full block row and a span ending exactly at a block border
+    mask.setSpan(-20, -1, 50, false);
+    QVERIFY(mask.isEmpty());
+    mask.setSpan(16, 2, 16);
+    mask.setSpan(-16, 2, 16);
+    QCOMPARE(mask.toRegion(), QRegion(-16, 2, 16, 1) + QRegion(16, 2, 16, 1));
+
+    mask.setSpan(-3, 2, 25, false);
+    QCOMPARE(mask.toRegion(), QRegion(-16, 2, 13, 1) + QRegion(22, 2, 10, 1));
+
+    // Empty spans change nothing
+    const TileMask before = mask;
+    mask.setSpan(5, 5, 0);
+    mask.setSpan(-16, 2, 0, false);
+    QVERIFY(mask == before);
+}
+
+void test_TileMask::boundingRect()
+{
+    TileMask mask(QRect(-33, 7, 2, 30));
+    mask.setCell(40, -2);
+    QCOMPARE(mask.boundingRect(), QRect(QPoint(-33, -2), QPoint(40, 36)));
+
+    const QRegion region = checkerRegion(QPoint(-5, 9));
+    QCOMPARE(TileMask(region).boundingRect(), region.boundingRect());
+}
+
+void test_TileMask::intersects()
+{
+    TileMask mask;
+    mask.setCell(-1, -1);
+    mask.setCell(16, 0);
+
+    QVERIFY(mask.intersects(QRect(-1, -1, 1, 1)));
+    QVERIFY(mask.intersects(QRect(-40, -40, 40, 40)));
+    QVERIFY(mask.intersects(QRect(0, 0, 17, 1)));
+    QVERIFY(!mask.intersects(QRect(0, 0, 16, 16)));
+    QVERIFY(!mask.intersects(QRect(-16, 0, 16, 16)));
+    QVERIFY(!mask.intersects(QRect()));
+}
+
+void test_TileMask::operators_data()
+{
+    QTest::addColumn<QRegion>("a");
+    QTest::addColumn<QRegion>("b");
+
+    QTest::newRow("empty") << QRegion() << QRegion();
+    QTest::newRow("empty left") << QRegion() << QRegion(-3, -3, 20, 20);
+    QTest::newRow("empty right") << QRegion(-3, -3, 20, 20) << QRegion();
+    QTest::newRow("disjoint") << QRegion(0, 0, 10, 10) << QRegion(-40, 30, 5, 5);
+    QTest::newRow("overlapping") << QRegion(-8, -8, 20, 20) << QRegion(0, 0, 30, 3);
+    QTest::newRow("equal") << checkerRegion(QPoint()) << checkerRegion(QPoint());
+    QTest::newRow("fragmented") << checkerRegion(QPoint()) << checkerRegion(QPoint(-2, 1));
+}
+
+void test_TileMask::operators()
+{
+    QFETCH(QRegion, a);
+    QFETCH(QRegion, b);
+
+    const TileMask maskA(a);
+    const TileMask maskB(b);
+
+    QCOMPARE((maskA + maskB).toRegion(), a | b);
+    QCOMPARE((maskA - maskB).toRegion(), a - b);
+    QCOMPARE((maskA & maskB).toRegion(), a & b);
+    QCOMPARE((maskA ^ maskB).toRegion(), a ^ b);
+
+    // Equal masks compare equal regardless of how they were built
+    QVERIFY((maskA + maskB) == TileMask(a | b));
+    QVERIFY((maskA - maskB) == TileMask(a - b));
+    QVERIFY((maskA & maskB) == TileMask(a & b));
+    QVERIFY((maskA ^ maskB) == TileMask(a ^ b));
+
+    QVERIFY(((maskA ^ maskB) ^ maskB) == maskA);
+    QVERIFY((maskA ^ maskA).isEmpty());
+    QCOMPARE(maskA == maskB, a == b);
+}
+
+void test_TileMask::translated_data()
+{
+    QTest::addColumn<QPoint>("offset");
+
+    QTest::newRow("none") << QPoint(0, 0);
+    QTest::newRow("block aligned") << QPoint(32, -16);
+    QTest::newRow("negative block aligned") << QPoint(-48, -32);
+    QTest::newRow("unaligned") << QPoint(5, 3);
+    QTest::newRow("negative unaligned") << QPoint(-1, -17);
+    QTest::newRow("mixed") << QPoint(16, -7);
+}
+
+void test_TileMask::translated()
+{
+    QFETCH(QPoint, offset);
+
+    const QRegion region = checkerRegion(QPoint());
+    const TileMask mask(region);
+    const TileMask moved = mask.translated(offset);
+
+    QCOMPARE(moved.toRegion(), region.translated(offset));
+    QVERIFY(moved.translated(-offset) == mask);
+}
+
+void test_TileMask::toRegion()
+{
+    // Identical rows are merged into bands, across block rows
+    const QRegion tall(-3, -20, 7, 50);
+    QCOMPARE(TileMask(tall).toRegion(), tall);
+    QCOMPARE(TileMask(tall).toRegion().rectCount(), 1);
+
+    // Runs continue into adjacent blocks, but not over gaps between blocks
+    TileMask mask;
+    mask.setSpan(10, 0, 12);
+    mask.setSpan(40, 0, 3);
+    QCOMPARE(mask.toRegion().rectCount(), 2);
+    QCOMPARE(mask.toRegion(), QRegion(10, 0, 12, 1) + QRegion(40, 0, 3, 1));
+
+    const QRegion region = checkerRegion(QPoint(3, -4));
+    QCOMPARE(TileMask(region).toRegion(), region);
+}
+
+/**
+ * Follows the way ChangeSelectedArea stores only the positions that change
+ * between two selections, which it toggles on undo and redo.
+ */
+void test_TileMask::selectionChanges()
+{
+    const QRegion first = QRegion(0, 0, 10, 10) + QRegion(20, -5, 3, 30);
+    const QRegion second = QRegion(5, 5, 20, 2) + QRegion(-17, -17, 1, 1);
+    const QRegion third = QRegion(0, 0, 40, 40) - QRegion(10, 10, 3, 3);
+
+    TileMask selection(first);
+
+    const TileMask firstChanges = TileMask(first) ^ TileMask(second);
+    selection ^= firstChanges;      // redo
+    QCOMPARE(selection.toRegion(), second);
+
+    const TileMask secondChanges = TileMask(second) ^ TileMask(third);
+    selection ^= secondChanges;     // redo
+    QCOMPARE(selection.toRegion(), third);
+
+    // Undoing gives back the exact earlier selections
+    selection ^= secondChanges;
+    QCOMPARE(selection.toRegion(), second);
+    selection ^= firstChanges;
+    QCOMPARE(selection.toRegion(), first);
+
+    // Merged changes undo both selection changes at once
+    const TileMask merged = firstChanges ^ secondChanges;
+    QVERIFY(merged == (TileMask(first) ^ TileMask(third)));
+    selection ^= merged;
+    QCOMPARE(selection.toRegion(), third);
+    selection ^= merged;
+    QCOMPARE(selection.toRegion(), first);
+
+    // Changing back to the same selection cancels out
+    QVERIFY((firstChanges ^ (TileMask(second) ^ TileMask(first))).isEmpty());
+}
+
+QTEST_MAIN(test_TileMask)
+#include "test_tilemask.moc"
@@ -3,6 +3,8 @@ isEmpty(PREFIX):PREFIX = /usr/local
 isEmpty(LIBDIR):LIBDIR = $${PREFIX}/lib
 isEmpty(RPATH):RPATH = yes
 isEmpty(INSTALL_HEADERS):INSTALL_HEADERS = no
+isEmpty(USE_ZSTD):USE_ZSTD = no
+isEmpty(USE_LZ4):USE_LZ4 = no
 
 macx {
     # Do a universal build when possible